@@ -0,0 +1,266 @@
+#ifndef __NCPP_ASYNC_HH
+#define __NCPP_ASYNC_HH
+
+// Awaitable input and rendering, for driving any number of Notcurses
+// instances from one event loop thread. This requires C++20 coroutines in the
+// including translation unit; notcurses++ itself is built as C++17, and
+// without coroutine support this header declares nothing.
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <vector>
+#include <poll.h>
+#include <notcurses/notcurses.h>
+
+#include "_helpers.hh"
+
+namespace ncpp::async
+{
+	// Whatever event loop is in use: asio, libuv, epoll, or the poll_reactor
+	// below. 'cb' must be invoked exactly once, from the loop's thread, with
+	// 'arg'. With asio, when_readable() might wrap the descriptor in a
+	// posix::stream_descriptor and async_wait(wait_read) upon it, and post()
+	// might be asio::post().
+	class reactor
+	{
+	public:
+		using callback = void (*) (void* arg);
+
+		virtual ~reactor () = default;
+
+		// call 'cb' once 'fd' is readable
+		virtual void when_readable (int fd, callback cb, void* arg) = 0;
+
+		// call 'cb' soon, after already-queued work
+		virtual void post (callback cb, void* arg) = 0;
+	};
+
+	// A minimal single-threaded reactor built on poll(2).
+	class poll_reactor final : public reactor
+	{
+	public:
+		void when_readable (int fd, callback cb, void* arg) override
+		{
+			waiters.push_back ({ fd, cb, arg });
+		}
+
+		void post (callback cb, void* arg) override
+		{
+			ready.push_back ({ -1, cb, arg });
+		}
+
+		bool idle () const noexcept
+		{
+			return waiters.empty () && ready.empty ();
+		}
+
+		// Run posted work, then wait up to 'timeout_ms' (-1 for forever, but
+		// never when work is pending) for descriptors, dispatching those which
+		// became readable. Returns the number of callbacks invoked, or -1 if
+		// poll() failed.
+		int run_once (int timeout_ms = -1)
+		{
+			int ran = run_posted ();
+			if (waiters.empty ()) {
+				return ran;
+			}
+			std::vector<pollfd> pfds;
+			pfds.reserve (waiters.size ());
+			for (const auto& w : waiters) {
+				pfds.push_back ({ w.fd, POLLIN, 0 });
+			}
+			if (poll (pfds.data (), pfds.size (), ran || !ready.empty () ? 0 : timeout_ms) < 0) {
+				return -1;
+			}
+			// callbacks may add waiters, so pull the ready ones out first
+			std::vector<entry> fired;
+			std::size_t keep = 0;
+			for (std::size_t i = 0 ; i < pfds.size () ; ++i) {
+				if (pfds[i].revents) {
+					fired.push_back (waiters[i]);
+				} else {
+					waiters[keep++] = waiters[i];
+				}
+			}
+			waiters.erase (waiters.begin () + static_cast<std::ptrdiff_t>(keep),
+			               waiters.begin () + static_cast<std::ptrdiff_t>(pfds.size ()));
+			for (const auto& f : fired) {
+				f.cb (f.arg);
+			}
+			return ran + static_cast<int>(fired.size ());
+		}
+
+		// run until nothing remains to be done
+		void run ()
+		{
+			while (!idle ()) {
+				if (run_once () < 0) {
+					break;
+				}
+			}
+		}
+
+	private:
+		struct entry
+		{
+			int fd;
+			callback cb;
+			void* arg;
+		};
+
+		int run_posted ()
+		{
+			int ran = 0;
+			// only what was queued on entry; new posts wait for the next pass
+			for (std::size_t count = ready.size () ; count ; --count) {
+				entry e = ready.front ();
+				ready.pop_front ();
+				e.cb (e.arg);
+				++ran;
+			}
+			return ran;
+		}
+
+		std::vector<entry> waiters;
+		std::deque<entry> ready;
+	};
+
+	// co_await next_input (nc, r) suspends until an input event is available,
+	// and yields its id (filling 'ni', if provided), or (uint32_t)-1 on error.
+	// The coroutine is resumed from the reactor's thread.
+	class input_awaitable
+	{
+	public:
+		input_awaitable (notcurses* _nc, reactor& _r, ncinput* _ni) noexcept
+			: nc (_nc), r (_r), ni (_ni)
+		{}
+
+		bool await_ready () noexcept
+		{
+			id = notcurses_get_nblock (nc, ni);
+			return id != 0;
+		}
+
+		void await_suspend (std::coroutine_handle<> h) noexcept
+		{
+			waiter = h;
+			r.when_readable (notcurses_inputready_fd (nc), readable, this);
+		}
+
+		uint32_t await_resume () const noexcept
+		{
+			return id;
+		}
+
+	private:
+		// readiness can be spurious (e.g. a partial escape sequence), so
+		// resume only once an event is actually in hand
+		static void readable (void* arg) noexcept
+		{
+			auto self = static_cast<input_awaitable*>(arg);
+			self->id = notcurses_get_nblock (self->nc, self->ni);
+			if (self->id == 0) {
+				self->r.when_readable (notcurses_inputready_fd (self->nc), readable, self);
+				return;
+			}
+			self->waiter.resume ();
+		}
+
+		notcurses* nc;
+		reactor& r;
+		ncinput* ni;
+		uint32_t id = 0;
+		std::coroutine_handle<> waiter;
+	};
+
+	inline input_awaitable next_input (notcurses* nc, reactor& r, ncinput* ni = nullptr) noexcept
+	{
+		return input_awaitable (nc, r, ni);
+	}
+
+	// co_await render_async (pile, r) yields to the reactor, so that other
+	// work queued there runs first, then renders and rasterizes the pile of
+	// which 'n' is a part, yielding 0 on success or -1 on error. Rendering is
+	// done on the reactor thread; rasterization can block there on terminal
+	// output. Distinct piles may be rendered by distinct reactors.
+	class render_awaitable
+	{
+	public:
+		render_awaitable (ncplane* _n, reactor& _r) noexcept
+			: n (_n), r (_r)
+		{}
+
+		bool await_ready () const noexcept
+		{
+			return false;
+		}
+
+		void await_suspend (std::coroutine_handle<> h) noexcept
+		{
+			waiter = h;
+			r.post (run, this);
+		}
+
+		int await_resume () const noexcept
+		{
+			return ret;
+		}
+
+	private:
+		static void run (void* arg) noexcept
+		{
+			auto self = static_cast<render_awaitable*>(arg);
+			self->ret = ncpile_render (self->n) ? -1 : ncpile_rasterize (self->n) ? -1 : 0;
+			self->waiter.resume ();
+		}
+
+		ncplane* n;
+		reactor& r;
+		int ret = -1;
+		std::coroutine_handle<> waiter;
+	};
+
+	inline render_awaitable render_async (ncplane* n, reactor& r) noexcept
+	{
+		return render_awaitable (n, r);
+	}
+
+	// A fire-and-forget coroutine type, started immediately and freed upon
+	// completion. Event loops generally supply their own (e.g. asio's
+	// co_spawn()); this suffices for the poll_reactor. Exceptions escaping the
+	// coroutine terminate the program.
+	struct detached
+	{
+		struct promise_type
+		{
+			detached get_return_object () noexcept
+			{
+				return {};
+			}
+
+			std::suspend_never initial_suspend () noexcept
+			{
+				return {};
+			}
+
+			std::suspend_never final_suspend () noexcept
+			{
+				return {};
+			}
+
+			void return_void () noexcept
+			{}
+
+			void unhandled_exception () noexcept
+			{
+				std::terminate ();
+			}
+		};
+	};
+}
+
+#endif
+#endif
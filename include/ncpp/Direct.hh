@@ -150,6 +150,11 @@ namespace ncpp
 			get_cursor_yx (&y, &x);
 		}
 
+		bool resync_cursor () const NOEXCEPT_MAYBE
+		{
+			return error_guard (ncdirect_cursor_resync (direct), -1);
+		}
+
 		int render_image (const char* file, NCAlign align, ncblitter_e blitter, ncscale_e scale) const noexcept
 		{
 			return ncdirect_render_image (direct, file, static_cast<ncalign_e>(align), blitter, scale);
@@ -207,6 +212,16 @@ namespace ncpp
 			return error_guard (ncdirect_flush (direct), -1);
 		}
 
+		bool begin_batch () const NOEXCEPT_MAYBE
+		{
+			return error_guard (ncdirect_begin_batch (direct), -1);
+		}
+
+		bool end_batch () const NOEXCEPT_MAYBE
+		{
+			return error_guard (ncdirect_end_batch (direct), -1);
+		}
+
 		char32_t get (ncinput *ni, bool blocking) const noexcept
 		{
 			if (blocking)
@@ -0,0 +1,564 @@
+#ifndef __NCPP_FAST_HH
+#define __NCPP_FAST_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+#include <utility>
+#include <notcurses/notcurses.h>
+
+#include "_helpers.hh"
+
+// A header-only layer over the C API for hot paths. Nothing here throws,
+// whether or not NCPP_EXCEPTIONS_PLEASE is defined: failures come back in a
+// result<T>, which the caller tests. Owners are move-only, and release their
+// object when destroyed. Everything is inline, so a call costs what the C
+// call does. As with the C API, planes and visuals must be destroyed before
+// the context which created them.
+namespace ncpp::fast
+{
+	// Either a value, or the (negative) error returned by the C call. A
+	// subset of C++23's std::expected, for C++17.
+	template<typename T>
+	class result
+	{
+	public:
+		constexpr result (T value) noexcept (std::is_nothrow_move_constructible_v<T>)
+			: val (std::move (value)), err (0)
+		{}
+
+		static constexpr result failure (int error = -1) noexcept
+		{
+			return result (failure_tag {}, error);
+		}
+
+		constexpr bool has_value () const noexcept
+		{
+			return err == 0;
+		}
+
+		constexpr explicit operator bool () const noexcept
+		{
+			return has_value ();
+		}
+
+		// only meaningful if has_value ()
+		constexpr T& value () & noexcept
+		{
+			return val;
+		}
+
+		constexpr const T& value () const& noexcept
+		{
+			return val;
+		}
+
+		constexpr T&& value () && noexcept
+		{
+			return std::move (val);
+		}
+
+		constexpr T value_or (T alternative) const& noexcept (std::is_nothrow_copy_constructible_v<T>)
+		{
+			return has_value () ? val : alternative;
+		}
+
+		constexpr int error () const noexcept
+		{
+			return err;
+		}
+
+	private:
+		struct failure_tag {};
+
+		constexpr result (failure_tag, int error) noexcept
+			: val (), err (error)
+		{}
+
+		T val;
+		int err;
+	};
+
+	template<>
+	class result<void>
+	{
+	public:
+		constexpr result () noexcept
+			: err (0)
+		{}
+
+		static constexpr result failure (int error = -1) noexcept
+		{
+			result r;
+			r.err = error;
+			return r;
+		}
+
+		constexpr bool has_value () const noexcept
+		{
+			return err == 0;
+		}
+
+		constexpr explicit operator bool () const noexcept
+		{
+			return has_value ();
+		}
+
+		constexpr int error () const noexcept
+		{
+			return err;
+		}
+
+	private:
+		int err;
+	};
+
+	// C calls returning negative on error, and a count otherwise
+	constexpr result<int> checked (int ret) noexcept
+	{
+		return NCPP_UNLIKELY (ret < 0) ? result<int>::failure (ret) : result<int> (ret);
+	}
+
+	// C writers returning the (non-positive) count of columns written before
+	// an error, so that nothing written at all (e.g. an out-of-range
+	// position) is also a failure
+	constexpr result<int> checked_put (int ret, const char* s) noexcept
+	{
+		return NCPP_UNLIKELY (ret < 0 || (ret == 0 && *s)) ? result<int>::failure (ret ? ret : -1) : result<int> (ret);
+	}
+
+	constexpr result<void> checked_void (int ret) noexcept
+	{
+		return NCPP_UNLIKELY (ret < 0) ? result<void>::failure (ret) : result<void> ();
+	}
+
+	// A contiguous run of T, ala C++20's std::span, for C++17.
+	template<typename T>
+	class span
+	{
+	public:
+		constexpr span () noexcept = default;
+
+		constexpr span (T* data, std::size_t size) noexcept
+			: ptr (data), len (size)
+		{}
+
+		template<std::size_t N>
+		constexpr span (T (&array)[N]) noexcept
+			: ptr (array), len (N)
+		{}
+
+		// any container with contiguous data () and size (), e.g. std::vector
+		template<typename C, typename = std::enable_if_t<
+			std::is_convertible_v<decltype (std::declval<C&> ().data ()), T*>>>
+		constexpr span (C& container) noexcept
+			: ptr (container.data ()), len (container.size ())
+		{}
+
+		constexpr T* data () const noexcept
+		{
+			return ptr;
+		}
+
+		constexpr std::size_t size () const noexcept
+		{
+			return len;
+		}
+
+		constexpr bool empty () const noexcept
+		{
+			return len == 0;
+		}
+
+		constexpr T& operator[] (std::size_t idx) const noexcept
+		{
+			return ptr[idx];
+		}
+
+		constexpr T* begin () const noexcept
+		{
+			return ptr;
+		}
+
+		constexpr T* end () const noexcept
+		{
+			return ptr + len;
+		}
+
+	private:
+		T* ptr = nullptr;
+		std::size_t len = 0;
+	};
+
+	// Operations common to owning and borrowed planes, inherited by each.
+	template<typename TDerived>
+	class plane_ops
+	{
+	public:
+		ncplane* get () const noexcept
+		{
+			return static_cast<const TDerived*>(this)->ptr;
+		}
+
+		explicit operator bool () const noexcept
+		{
+			return get () != nullptr;
+		}
+
+		unsigned dim_y () const noexcept
+		{
+			return ncplane_dim_y (get ());
+		}
+
+		unsigned dim_x () const noexcept
+		{
+			return ncplane_dim_x (get ());
+		}
+
+		void erase () const noexcept
+		{
+			ncplane_erase (get ());
+		}
+
+		void set_channels (uint64_t channels) const noexcept
+		{
+			ncplane_set_channels (get (), channels);
+		}
+
+		void set_styles (unsigned styles) const noexcept
+		{
+			ncplane_set_styles (get (), styles);
+		}
+
+		result<void> move_yx (int y, int x) const noexcept
+		{
+			return checked_void (ncplane_move_yx (get (), y, x));
+		}
+
+		result<void> cursor_move_yx (int y, int x) const noexcept
+		{
+			return checked_void (ncplane_cursor_move_yx (get (), y, x));
+		}
+
+		result<int> putstr_yx (int y, int x, const char* s) const noexcept
+		{
+			return checked_put (ncplane_putstr_yx (get (), y, x, s), s);
+		}
+
+		result<int> putstr (const char* s) const noexcept
+		{
+			return checked_put (ncplane_putstr (get (), s), s);
+		}
+
+		// 'cells' holds 'ylen' rows of 'xlen' cells, already associated with
+		// this plane. See ncplane_put_cells().
+		result<int> put_cells (int y, int x, unsigned ylen, unsigned xlen,
+		                       span<const nccell> cells) const noexcept
+		{
+			if (NCPP_UNLIKELY (cells.size () < static_cast<std::size_t>(ylen) * xlen))
+				return result<int>::failure ();
+			return checked (ncplane_put_cells (get (), y, x, ylen, xlen, cells.data (), 0));
+		}
+
+		// Set per-cell channels and/or styles (an empty span leaves that
+		// property alone), each 'ylen' rows of 'xlen'. See ncplane_paint().
+		result<int> paint (int y, int x, unsigned ylen, unsigned xlen,
+		                   span<const uint64_t> channels,
+		                   span<const uint16_t> styles = {}) const noexcept
+		{
+			const std::size_t cells = static_cast<std::size_t>(ylen) * xlen;
+			if (NCPP_UNLIKELY ((!channels.empty () && channels.size () < cells) ||
+			                   (!styles.empty () && styles.size () < cells)))
+				return result<int>::failure ();
+			return checked (ncplane_paint (get (), y, x, ylen, xlen,
+			                               channels.empty () ? nullptr : channels.data (),
+			                               styles.empty () ? nullptr : styles.data (), 0));
+		}
+
+		// Blit 'rows' rows of 'cols' RGBA pixels, lent rather than copied,
+		// according to 'vopts' (whose 'n' is replaced by this plane unless
+		// NCVISUAL_OPTION_CHILDPLANE is set). Returns the plane drawn upon.
+		result<ncplane*> blit_rgba (span<const uint32_t> rgba, unsigned rows, unsigned cols,
+		                            ncvisual_options vopts = {}) const noexcept
+		{
+			if (NCPP_UNLIKELY (rows == 0 || cols == 0 ||
+			                   rgba.size () < static_cast<std::size_t>(rows) * cols))
+				return result<ncplane*>::failure ();
+			ncvisual* ncv = ncvisual_from_rgba_borrowed (rgba.data (), static_cast<int>(rows),
+			                                             static_cast<int>(cols * 4),
+			                                             static_cast<int>(cols), nullptr, nullptr);
+			if (NCPP_UNLIKELY (ncv == nullptr))
+				return result<ncplane*>::failure ();
+			if (!(vopts.flags & NCVISUAL_OPTION_CHILDPLANE) || vopts.n == nullptr)
+				vopts.n = get ();
+			ncplane* n = ncvisual_blit (ncplane_notcurses (get ()), ncv, &vopts);
+			ncvisual_destroy (ncv);
+			if (NCPP_UNLIKELY (n == nullptr))
+				return result<ncplane*>::failure ();
+			return n;
+		}
+	};
+
+	// A plane owned by someone else (e.g. the standard plane).
+	class plane_view : public plane_ops<plane_view>
+	{
+		friend class plane_ops<plane_view>;
+
+	public:
+		constexpr plane_view () noexcept = default;
+
+		constexpr explicit plane_view (ncplane* n) noexcept
+			: ptr (n)
+		{}
+
+	private:
+		ncplane* ptr = nullptr;
+	};
+
+	// An owned plane, destroyed along with its owner.
+	class plane : public plane_ops<plane>
+	{
+		friend class plane_ops<plane>;
+
+	public:
+		constexpr plane () noexcept = default;
+
+		// take ownership of 'n'
+		constexpr explicit plane (ncplane* n) noexcept
+			: ptr (n)
+		{}
+
+		plane (const plane&) = delete;
+		plane& operator= (const plane&) = delete;
+
+		plane (plane&& other) noexcept
+			: ptr (std::exchange (other.ptr, nullptr))
+		{}
+
+		plane& operator= (plane&& other) noexcept
+		{
+			if (this != &other) {
+				reset ();
+				ptr = std::exchange (other.ptr, nullptr);
+			}
+			return *this;
+		}
+
+		~plane () noexcept
+		{
+			reset ();
+		}
+
+		static result<plane> create (ncplane* parent, const ncplane_options& nopts) noexcept
+		{
+			ncplane* n = ncplane_create (parent, &nopts);
+			if (NCPP_UNLIKELY (n == nullptr))
+				return result<plane>::failure ();
+			return plane (n);
+		}
+
+		// a new plane at the root of a new pile
+		static result<plane> create_pile (notcurses* nc, const ncplane_options& nopts) noexcept
+		{
+			ncplane* n = ncpile_create (nc, &nopts);
+			if (NCPP_UNLIKELY (n == nullptr))
+				return result<plane>::failure ();
+			return plane (n);
+		}
+
+		plane_view view () const noexcept
+		{
+			return plane_view (ptr);
+		}
+
+		// give up ownership without destroying the plane
+		ncplane* release () noexcept
+		{
+			return std::exchange (ptr, nullptr);
+		}
+
+		void reset () noexcept
+		{
+			if (ptr != nullptr)
+				ncplane_destroy (std::exchange (ptr, nullptr));
+		}
+
+		// render and rasterize the pile of which this plane is a part
+		result<void> render_pile () const noexcept
+		{
+			if (NCPP_UNLIKELY (ncpile_render (ptr) < 0))
+				return result<void>::failure ();
+			return checked_void (ncpile_rasterize (ptr));
+		}
+
+	private:
+		ncplane* ptr = nullptr;
+	};
+
+	// An owned ncvisual.
+	class visual
+	{
+	public:
+		constexpr visual () noexcept = default;
+
+		constexpr explicit visual (ncvisual* v) noexcept
+			: ptr (v)
+		{}
+
+		visual (const visual&) = delete;
+		visual& operator= (const visual&) = delete;
+
+		visual (visual&& other) noexcept
+			: ptr (std::exchange (other.ptr, nullptr))
+		{}
+
+		visual& operator= (visual&& other) noexcept
+		{
+			if (this != &other) {
+				reset ();
+				ptr = std::exchange (other.ptr, nullptr);
+			}
+			return *this;
+		}
+
+		~visual () noexcept
+		{
+			reset ();
+		}
+
+		static result<visual> from_file (const char* file) noexcept
+		{
+			ncvisual* v = ncvisual_from_file (file);
+			if (NCPP_UNLIKELY (v == nullptr))
+				return result<visual>::failure ();
+			return visual (v);
+		}
+
+		// 'rgba' must outlive the visual; see ncvisual_from_rgba_borrowed()
+		static result<visual> borrow_rgba (span<const uint32_t> rgba, unsigned rows, unsigned cols) noexcept
+		{
+			if (NCPP_UNLIKELY (rgba.size () < static_cast<std::size_t>(rows) * cols))
+				return result<visual>::failure ();
+			ncvisual* v = ncvisual_from_rgba_borrowed (rgba.data (), static_cast<int>(rows),
+			                                           static_cast<int>(cols * 4),
+			                                           static_cast<int>(cols), nullptr, nullptr);
+			if (NCPP_UNLIKELY (v == nullptr))
+				return result<visual>::failure ();
+			return visual (v);
+		}
+
+		ncvisual* get () const noexcept
+		{
+			return ptr;
+		}
+
+		explicit operator bool () const noexcept
+		{
+			return ptr != nullptr;
+		}
+
+		void reset () noexcept
+		{
+			if (ptr != nullptr)
+				ncvisual_destroy (std::exchange (ptr, nullptr));
+		}
+
+		result<ncplane*> blit (notcurses* nc, const ncvisual_options& vopts) const noexcept
+		{
+			ncplane* n = ncvisual_blit (nc, ptr, &vopts);
+			if (NCPP_UNLIKELY (n == nullptr))
+				return result<ncplane*>::failure ();
+			return n;
+		}
+
+		// 1 at end of file
+		result<int> decode () const noexcept
+		{
+			return checked (ncvisual_decode (ptr));
+		}
+
+	private:
+		ncvisual* ptr = nullptr;
+	};
+
+	// An owned Notcurses context, stopped when destroyed.
+	class context
+	{
+	public:
+		constexpr context () noexcept = default;
+
+		constexpr explicit context (notcurses* nc) noexcept
+			: ptr (nc)
+		{}
+
+		context (const context&) = delete;
+		context& operator= (const context&) = delete;
+
+		context (context&& other) noexcept
+			: ptr (std::exchange (other.ptr, nullptr))
+		{}
+
+		context& operator= (context&& other) noexcept
+		{
+			if (this != &other) {
+				stop ();
+				ptr = std::exchange (other.ptr, nullptr);
+			}
+			return *this;
+		}
+
+		~context () noexcept
+		{
+			stop ();
+		}
+
+		static result<context> init (const notcurses_options& opts, FILE* fp = nullptr) noexcept
+		{
+			notcurses* nc = notcurses_init (&opts, fp);
+			if (NCPP_UNLIKELY (nc == nullptr))
+				return result<context>::failure ();
+			return context (nc);
+		}
+
+		notcurses* get () const noexcept
+		{
+			return ptr;
+		}
+
+		explicit operator bool () const noexcept
+		{
+			return ptr != nullptr;
+		}
+
+		result<void> stop () noexcept
+		{
+			if (ptr == nullptr)
+				return {};
+			return checked_void (notcurses_stop (std::exchange (ptr, nullptr)));
+		}
+
+		plane_view stdplane () const noexcept
+		{
+			return plane_view (notcurses_stdplane (ptr));
+		}
+
+		result<void> render () const noexcept
+		{
+			return checked_void (notcurses_render (ptr));
+		}
+
+		// 0 on timeout; see notcurses_get()
+		result<uint32_t> get_input (const timespec* ts, ncinput* ni) const noexcept
+		{
+			uint32_t id = notcurses_get (ptr, ts, ni);
+			if (NCPP_UNLIKELY (id == static_cast<uint32_t>(-1)))
+				return result<uint32_t>::failure ();
+			return id;
+		}
+
+	private:
+		notcurses* ptr = nullptr;
+	};
+}
+#endif
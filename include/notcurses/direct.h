@@ -49,6 +49,13 @@ extern "C" {
 // all diagnostics, a superset of NCDIRECT_OPTION_VERBOSE (which this implies).
 #define NCDIRECT_OPTION_VERY_VERBOSE        0x0020ull
 
+// Track the cursor location across our own output, rather than asking the
+// terminal for it (a full round trip) in ncdirect_cursor_yx() and single-axis
+// ncdirect_cursor_move_yx(). Any output not made through this ncdirect
+// (printf(3) to the same terminal, user echo, etc.) desynchronizes the
+// tracked location; call ncdirect_cursor_resync() following such output.
+#define NCDIRECT_OPTION_SHADOW_CURSOR       0x0040ull
+
 // Initialize a direct-mode Notcurses context on the connected terminal at 'fp'.
 // 'fp' must be a tty. You'll usually want stdout. Direct mode supports a
 // limited subset of Notcurses routines which directly affect 'fp', and neither
@@ -106,10 +113,22 @@ API int ncdirect_printf_aligned(struct ncdirect* n, int y, ncalign_e align,
                                 const char* fmt, ...)
   __attribute__ ((nonnull (1, 4))) __attribute__ ((format (printf, 4, 5)));
 
-// Force a flush. Returns 0 on success, -1 on failure.
+// Force a flush. Returns 0 on success, -1 on failure. While batching, this
+// writes out everything gathered since the last flush, in a single write.
 API int ncdirect_flush(const struct ncdirect* nc)
   __attribute__ ((nonnull (1)));
 
+// Gather all further output in memory, rather than writing it as it's
+// produced, until ncdirect_end_batch(). Each ncdirect_flush() writes out the
+// batch at once. Calls which query the terminal (e.g. ncdirect_cursor_yx())
+// flush the batch first. No-op if already batching.
+API int ncdirect_begin_batch(struct ncdirect* nc)
+  __attribute__ ((nonnull (1)));
+
+// Flush the batch, and return to writing output as it's produced.
+API int ncdirect_end_batch(struct ncdirect* nc)
+  __attribute__ ((nonnull (1)));
+
 static inline int
 ncdirect_set_bg_rgb8(struct ncdirect* nc, unsigned r, unsigned g, unsigned b){
   if(r > 255 || g > 255 || b > 255){
@@ -174,6 +193,12 @@ API int ncdirect_cursor_down(struct ncdirect* nc, int num)
 API int ncdirect_cursor_yx(struct ncdirect* n, unsigned* y, unsigned* x)
   __attribute__ ((nonnull (1)));
 
+// Discard the tracked cursor location (see NCDIRECT_OPTION_SHADOW_CURSOR),
+// and ask the terminal where the cursor is. Returns -1 if the terminal
+// can't report the cursor.
+API int ncdirect_cursor_resync(struct ncdirect* n)
+  __attribute__ ((nonnull (1)));
+
 // Push or pop the cursor location to the terminal's stack. The depth of this
 // stack, and indeed its existence, is terminal-dependent.
 API int ncdirect_cursor_push(struct ncdirect* n)
@@ -285,6 +310,8 @@ typedef struct ncvisual ncdirectf;
 // be arbitrarily many rows -- the output will scroll -- but will only occupy
 // the column of the cursor, and those to the right. The render/raster process
 // can be split by using ncdirect_render_frame() and ncdirect_raster_frame().
+// Cell blitters are scaled, blitted and written a band of rows at a time, so
+// output begins before the entire image has been processed.
 API int ncdirect_render_image(struct ncdirect* n, const char* filename,
                               ncalign_e align, ncblitter_e blitter,
                               ncscale_e scale)
@@ -175,9 +175,15 @@ extern "C" {
 #define NCKEY_BUTTON10  preterunicode(210)
 #define NCKEY_BUTTON11  preterunicode(211)
 
+// a complete bracketed paste (see notcurses_paste_enable())
+#define NCKEY_PASTE     preterunicode(300)
+
 // we received SIGCONT
 #define NCKEY_SIGNAL    preterunicode(400)
 
+// one or more timers expired (see notcurses_timer_add())
+#define NCKEY_TIMER     preterunicode(410)
+
 // indicates that we have reached the end of input. any further calls
 // will continute to return this immediately.
 #define NCKEY_EOF       preterunicode(500)
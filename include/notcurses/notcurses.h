@@ -58,6 +58,10 @@ struct ncreel;    // hierarchical block-based data browser
 struct nctab;     // grouped item within an nctabbed
 struct nctabbed;  // widget with one tab visible at a time
 struct ncdirect;  // direct mode context
+struct nclayout;  // retained text, wrapped to a width on demand
+struct ncrasterizer; // private raster state, for writing a pile elsewhere
+struct ncprepared; // an encoded visual, awaiting attachment to a plane
+struct ncmirror;  // copies a pile's terminal output to another terminal
 
 // we never blit full blocks, but instead spaces (more efficient) with the
 // background set to the desired foreground. these need be kept in the same
@@ -610,6 +614,21 @@ API int notcurses_ucs32_to_utf8(const uint32_t* ucs32, unsigned ucs32count,
                                 unsigned char* resultbuf, size_t buflen)
   __attribute__ ((nonnull (1, 3)));
 
+// Returns the number of columns Notcurses considers the Unicode codepoint
+// 'cp' to occupy: 0 for combining and other zero-width codepoints, 2 for
+// East Asian Wide and Fullwidth codepoints (including emoji with default
+// emoji presentation), -1 for control characters, and 1 otherwise. This
+// comes from a built-in Unicode 15.0 table rather than wcwidth(), unless
+// replaced using notcurses_set_width_fxn().
+API int notcurses_ucs32_width(uint32_t cp);
+
+// Replace the built-in width table with 'fxn' (restoring the table if 'fxn'
+// is NULL), e.g. to match a terminal known to disagree with it. 'fxn' must
+// follow the conventions of notcurses_ucs32_width(). This applies to the
+// entire process, and ought be done before any Notcurses contexts are
+// created, lest existing output be measured differently from new output.
+API void notcurses_set_width_fxn(int (*fxn)(uint32_t cp));
+
 // An nccell corresponds to a single character cell on some plane, which can be
 // occupied by a single grapheme cluster (some root spacing glyph, along with
 // possible combining characters, which might span multiple columns). At any
@@ -1033,6 +1052,48 @@ typedef enum {
 // equivalent to calling ncplane_set_scrolling(notcurses_stdplane(nc), true).
 #define NCOPTION_SCROLLING           0x0200ull
 
+// Paint large piles using a pool of worker threads, each solving a band of
+// rows. The number of threads is derived from the number of online
+// processors, and can be overridden with NOTCURSES_RENDER_THREADS. This is
+// only a win for big piles with many planes; small renders are always painted
+// on the calling thread.
+#define NCOPTION_THREADED_RENDER     0x0400ull
+
+// Collapse runs of mouse motion (and drag) reports sharing the same button,
+// modifiers, and event type into a single event bearing the final position,
+// and collapse queued resize events. The ncinput's 'coalesced' field counts
+// the events folded in. Useful when only the latest position matters.
+#define NCOPTION_COALESCE_MOTION     0x0800ull
+
+// Return from notcurses_init() without waiting for the terminal to answer
+// our capability queries. The answers are applied upon the first render or
+// visual blit (or notcurses_stop()); until then, capabilities reflect only
+// terminfo. Ignored unless NCOPTION_SUPPRESS_BANNERS is provided, or if
+// NCOPTION_PRESERVE_CURSOR is provided.
+#define NCOPTION_ASYNC_INIT          0x1000ull
+
+// Without RGB support, but with a palette of at least 256 colors which can
+// be reprogrammed, RGB colors are normally quantized onto the fixed xterm
+// cube. With this option, palette entries 16 through 255 are instead
+// programmed with the RGB colors in use (nearest matches are used once they
+// are exhausted), and the original palette is restored upon exit. Those
+// entries ought not be otherwise modified while this is in use.
+#define NCOPTION_ADAPTIVE_PALETTE    0x2000ull
+
+// Adapt output to a slow link (e.g. a remote session), as measured by the
+// time taken by our writes. While measured throughput is low, RGB colors
+// imperceptibly close to those already set are not emitted, and bitmaps are
+// blitted as cells unless NCVISUAL_OPTION_NODEGRADE is used.
+#define NCOPTION_ADAPTIVE_BANDWIDTH  0x4000ull
+
+// Don't format messages at NCLOGLEVEL_INFO and above as they're logged.
+// Instead, their arguments are copied into a ring per logging thread, and
+// formatted only when written out by notcurses_log_dump() (or, for any
+// remaining, upon notcurses_stop()). The oldest messages are overwritten
+// once a ring fills. Warnings and worse are still written immediately.
+// This makes NCLOGLEVEL_DEBUG cheap enough to leave on.
+#define NCOPTION_LOG_RING            0x8000ull
+
 // "CLI mode" is just setting these four options.
 #define NCOPTION_CLI_MODE (NCOPTION_NO_ALTERNATE_SCREEN \
                            |NCOPTION_NO_CLEAR_BITMAPS \
@@ -1121,6 +1182,14 @@ API struct ncplane* ncpile_top(struct ncplane* n)
 API struct ncplane* ncpile_bottom(struct ncplane* n)
   __attribute__ ((nonnull (1)));
 
+// Return the topmost plane of the pile containing 'n' which covers the
+// absolute coordinate 'y'/'x' (as reported for mouse events), or NULL if no
+// plane does. Planes are found through a spatial index which is rebuilt
+// after planes are created, destroyed, moved, resized, or restacked, so a
+// burst of lookups between such changes costs little even for many planes.
+API struct ncplane* ncpile_plane_at(struct ncplane* n, int y, int x)
+  __attribute__ ((nonnull (1)));
+
 // Return the topmost plane of the standard pile.
 static inline struct ncplane*
 notcurses_top(struct notcurses* n){
@@ -1138,12 +1207,76 @@ notcurses_bottom(struct notcurses* n){
 API int ncpile_render(struct ncplane* n)
   __attribute__ ((nonnull (1)));
 
+// Renders only the 'leny'x'lenx' region at 'y'/'x' of the pile of which 'n' is
+// a part (a length of 0 extends to the pile's edge), leaving the rest of the
+// last render as it was. Follow it with ncpile_rasterize() as usual, which
+// will then only visit the region. Changes outside the region are picked up
+// by the next ncpile_render(). Whenever the last render can't be patched
+// (the pile hasn't been rendered and rasterized since its geometry changed,
+// another pile was rasterized, or it contains bitmaps), this is equivalent to
+// ncpile_render().
+API int ncpile_render_region(struct ncplane* n, unsigned y, unsigned x,
+                             unsigned leny, unsigned lenx)
+  __attribute__ ((nonnull (1)));
+
 // Make the physical screen match the last rendered frame from the pile of
 // which 'n' is a part. This is a blocking call. Don't call this before the
 // pile has been rendered (doing so will likely result in a blank screen).
 API int ncpile_rasterize(struct ncplane* n)
   __attribute__ ((nonnull (1)));
 
+// Renders and rasterizes the pile of which 'n' is a part, but rather than
+// writing the frame out itself, hands it to a library-owned writer thread
+// (spun up upon first use), and returns without blocking on the terminal. The
+// pile may be modified as soon as this returns. If the writer falls behind,
+// successive frames are coalesced into a single write. The failure of an
+// earlier asynchronous write is reported by the next call (or by
+// ncpile_rasterize() or notcurses_write_drain()); notcurses_refresh() ought
+// then be called. Falls back to a blocking write if no thread can be created.
+API int ncpile_render_async(struct ncplane* n)
+  __attribute__ ((nonnull (1)));
+
+// Get a file descriptor which is readable whenever the writer thread has
+// written out everything submitted via ncpile_render_async(). It needn't be
+// read; it becomes unreadable upon the next submission. Returns -1 if the
+// writer couldn't be started (or on Windows).
+API int notcurses_writedone_fd(struct notcurses* nc)
+  __attribute__ ((nonnull (1)));
+
+// Block until everything submitted via ncpile_render_async() has been
+// written, and then write out any frame deferred under a frame budget (see
+// notcurses_set_frame_budget()). Returns -1 if any such write failed.
+API int notcurses_write_drain(struct notcurses* nc)
+  __attribute__ ((nonnull (1)));
+
+// Bound output latency to roughly 'ns' nanoseconds (0, the default, disables
+// the bound). While the terminal is estimated to be further behind than this,
+// rasterization is skipped; the solved frame is retained, and the next
+// rasterization emits all damage since the last frame actually written. For
+// ncpile_render_async(), the estimate is the writer's backlog at its recent
+// throughput. For blocking rasterization, a write which took longer than the
+// budget causes frames for as long again to be skipped. Piles containing
+// bitmaps are never skipped. Call notcurses_write_drain() to force out a
+// skipped frame (i.e. before going idle).
+API int notcurses_set_frame_budget(struct notcurses* nc, uint64_t ns)
+  __attribute__ ((nonnull (1)));
+
+// Treat an RGB color within 'deltae' (CIELAB delta E 1976) of the color last
+// set as matching it, and don't emit it. Gradients and video are full of
+// such near-identical colors; ~2.3 is the just-noticeable difference. 0, the
+// default, requires an exact match. Values outside [0, 100] are an error.
+API int notcurses_set_color_tolerance(struct notcurses* nc, float deltae)
+  __attribute__ ((nonnull (1)));
+
+// Debounce terminal resizes: rather than acting on each SIGWINCH, wait until
+// 'ns' nanoseconds have passed without another, and only then deliver a
+// single NCKEY_RESIZE and adopt the final geometry. Until then, rendering
+// continues at the old geometry. 0, the default, disables debouncing. A
+// window being dragged otherwise results in a relayout and full redraw for
+// every intermediate size. Fails if there is no input layer.
+API int notcurses_set_resize_debounce(struct notcurses* nc, uint64_t ns)
+  __attribute__ ((nonnull (1)));
+
 // Renders and rasterizes the standard pile in one shot. Blocking call.
 static inline int
 notcurses_render(struct notcurses* nc){
@@ -1166,6 +1299,174 @@ API int ncpile_render_to_buffer(struct ncplane* p, char** buf, size_t* buflen)
 API int ncpile_render_to_file(struct ncplane* p, FILE* fp)
   __attribute__ ((nonnull (1, 2)));
 
+// Capture the last render of the pile of which 'n' is a part as a compact
+// binary snapshot of its cells, written to a buffer which must be freed by
+// the caller. Nothing is rasterized. If 'delta' is true, only cells changed
+// since the pile's last capture are included (the first capture, and any
+// following a geometry change, are always complete; check the flags). All
+// integers are little-endian. The 20-byte header is "NCAP", u8 version (1),
+// u8 flags (0x1: delta), u16 reserved, u32 rows, u32 cols, and u32 count of
+// records. Each record is: u32 index (y * cols + x, deltas only), u64
+// channels, u16 stylemask, u8 width, u16 EGC length, and the EGC's bytes.
+// The right columns of wide glyphs have width 0 and no EGC. Piles of more
+// than 16384 rows or columns (or 4Mi cells), or holding EGCs of more than
+// 1024 bytes, can't be captured.
+API int ncpile_capture(struct ncplane* n, bool delta, char** buf, size_t* buflen)
+  __attribute__ ((nonnull (1, 3, 4)));
+
+// Write the capture of 'len' bytes at 'buf' (see ncpile_capture()) to 'n'. A
+// complete capture resizes 'n' to its geometry, and replaces its contents. A
+// delta is only applied if 'n' has the geometry of the capture. Cells
+// without a glyph are written as spaces. Captures exceeding the limits of
+// ncpile_capture(), or whose header disagrees with their length, are
+// rejected before 'n' is resized.
+API int ncplane_apply_capture(struct ncplane* n, const char* buf, size_t len)
+  __attribute__ ((nonnull (1, 2)));
+
+// Message types of the notcurses-remote(1) protocol. Each message is a u32
+// length (of everything following it), a u8 type, and a body.
+#define NCREMOTE_MSG_FRAME 1 // server: i32 cursor y, i32 cursor x, capture
+#define NCREMOTE_MSG_INPUT 2 // client: u32 id, u32 modifiers, u8 evtype, UTF-8
+
+// Capture the pile of which 'n' is a part, as ncpile_capture() would, and
+// wrap it in a notcurses-remote(1) frame message with the cursor at 'cury',
+// 'curx' (-1 for a hidden cursor). The message, ready to be written to the
+// client(s), must be freed by the caller.
+API int ncpile_remote_frame(struct ncplane* n, bool delta, int cury, int curx,
+                            char** buf, size_t* buflen)
+  __attribute__ ((nonnull (1, 5, 6)));
+
+// Don't compress recorded frames.
+#define NCRECORDER_OPTION_NOCOMPRESS 0x0001ull
+
+struct ncrecorder;
+struct ncplayback;
+
+typedef struct ncrecorder_options {
+  // Frames between keyframes (complete captures); 0 selects the default of
+  // 120. Playback can only begin at a keyframe.
+  unsigned keyframe_interval;
+  uint64_t flags; // bitfield of NCRECORDER_OPTION_*
+} ncrecorder_options;
+
+// Record the pile of which 'n' is a part to 'path' (which is truncated). Each
+// call to ncrecorder_frame() captures the last render (see ncpile_capture(),
+// whose delta state the recorder shares; don't take other captures of the
+// pile while recording) and timestamps it. Frames are compressed and written
+// out by a background thread. The keyframe index is written by
+// ncrecorder_destroy().
+API ALLOC struct ncrecorder* ncrecorder_create(struct ncplane* n, const char* path,
+                                               const ncrecorder_options* opts)
+  __attribute__ ((nonnull (1, 2)));
+
+// Capture a frame. Call this following ncpile_render() (or notcurses_render()).
+API int ncrecorder_frame(struct ncrecorder* r)
+  __attribute__ ((nonnull (1)));
+
+// Flush all frames, write the index, and close the recording. Returns -1 if
+// any frame failed to be written.
+API int ncrecorder_destroy(struct ncrecorder* r);
+
+// Open a recording for playback. Returns NULL if 'path' isn't a recording.
+API ALLOC struct ncplayback* ncplayback_open(const char* path)
+  __attribute__ ((nonnull (1)));
+
+// Position playback at the last keyframe at or before 'ns' nanoseconds into
+// the recording (or the first keyframe, if none precede it).
+API int ncplayback_seek(struct ncplayback* pb, uint64_t ns)
+  __attribute__ ((nonnull (1)));
+
+// Apply the next frame to 'n', writing its timestamp to 'ns' if it is not
+// NULL. Keyframes resize 'n' to the recorded geometry. Returns 1 at the end
+// of the recording, and -1 on error.
+API int ncplayback_next(struct ncplayback* pb, struct ncplane* n, uint64_t* ns)
+  __attribute__ ((nonnull (1, 2)));
+
+API void ncplayback_close(struct ncplayback* pb);
+
+// An ncrasterizer carries its own copy of the raster state (the last frame
+// written, the cursor location, and the colors and styles believed active),
+// allowing a pile to be rasterized to some output other than the terminal,
+// concurrently with the terminal's own rasterization and with that of other
+// ncrasterizers. One process can thus drive many remote terminals (e.g. SSH
+// sessions) from a single context, each with its own pile and ncrasterizer.
+// Input from such terminals is not handled by Notcurses.
+#define NCRASTERIZER_OPTION_RGB 0x0001ull // assert 24-bit color support
+
+typedef struct ncrasterizer_options {
+  // if not NULL, the output is described by this terminfo(5) entry, rather
+  // than by the terminal. descriptions are shared among ncrasterizers. no
+  // queries are sent, so only terminfo is consulted (and COLORTERM can't be;
+  // see NCRASTERIZER_OPTION_RGB).
+  const char* termtype;
+  // if nonzero, the bound pile is sized to this geometry (both must be
+  // provided), rather than following the terminal. see ncrasterizer_resize().
+  unsigned rows, cols;
+  uint64_t flags;  // bitfield of NCRASTERIZER_OPTION_*
+} ncrasterizer_options;
+
+// Create an ncrasterizer, and bind it to the pile of which 'n' is a part. The
+// standard pile cannot be bound, nor can a pile be bound to two ncrasterizers.
+// Until the ncrasterizer is destroyed, its pile cannot be rasterized with
+// ncpile_rasterize(). The pile is rendered as usual with ncpile_render().
+// Piles containing bitmaps are not supported. 'opts' may be NULL. The
+// ncrasterizer must be destroyed before the context is stopped.
+API ALLOC struct ncrasterizer* ncrasterizer_create(struct ncplane* n,
+                                         const ncrasterizer_options* opts)
+  __attribute__ ((nonnull (1)));
+
+// Rasterize the last rendered frame of the bound pile, relative to the last
+// frame this ncrasterizer produced (the first frame, and any following a
+// change of geometry, are drawn in their entirety). The returned buffer must
+// be freed by the caller.
+API int ncrasterizer_rasterize(struct ncrasterizer* r, char** buf, size_t* buflen)
+  __attribute__ ((nonnull (1, 2, 3)));
+
+// As ncrasterizer_rasterize(), but write the frame to 'fd'. Blocking call.
+API int ncrasterizer_write(struct ncrasterizer* r, int fd)
+  __attribute__ ((nonnull (1)));
+
+// Change the geometry to which the bound pile is sized, as of its next
+// render. Zero for both follows the terminal. Don't call this while the pile
+// is being rendered.
+API int ncrasterizer_resize(struct ncrasterizer* r, unsigned rows, unsigned cols)
+  __attribute__ ((nonnull (1)));
+
+API void ncrasterizer_destroy(struct ncrasterizer* r);
+
+// An ncmirror copies the terminal output of a pile to some other terminal
+// (e.g. that of an observer), with its own terminal description and raster
+// state, as an ncrasterizer does. The pile is still rendered only once. Each
+// time it's rasterized to the terminal, the frame is handed to the mirror's
+// own thread, which writes whatever differs from the last frame it wrote. A
+// mirror which falls behind skips frames rather than delaying the terminal
+// or other mirrors. Bitmaps are not mirrored. The mirrored output ought be
+// at least as large as the terminal.
+#define NCMIRROR_OPTION_RGB 0x0001ull // assert 24-bit color support
+
+typedef struct ncmirror_options {
+  // as with ncrasterizer_options. if NULL, the terminal's own description
+  // is used.
+  const char* termtype;
+  uint64_t flags;  // bitfield of NCMIRROR_OPTION_*
+} ncmirror_options;
+
+// Mirror the pile of which 'n' is a part to 'fd', which must remain open
+// until the ncmirror is destroyed. Any number of ncmirrors can be attached
+// to a pile. 'opts' may be NULL. The ncmirror must be destroyed before the
+// context is stopped.
+API ALLOC struct ncmirror* ncmirror_create(struct ncplane* n, int fd,
+                                           const ncmirror_options* opts)
+  __attribute__ ((nonnull (1)));
+
+// Block until the mirror has written (or skipped) every frame handed to it.
+// Returns -1 if a write has failed since the last call.
+API int ncmirror_drain(struct ncmirror* m)
+  __attribute__ ((nonnull (1)));
+
+// Destroy the ncmirror, once it has written any frame handed to it.
+API void ncmirror_destroy(struct ncmirror* m);
+
 // Destroy all ncplanes other than the stdplane.
 API void notcurses_drop_planes(struct notcurses* nc)
   __attribute__ ((nonnull (1)));
@@ -1223,6 +1524,13 @@ typedef struct ncinput {
                      // utf32 representation, taking modifier 
                      // keys into account. This can be multiple
                      // codepoints. Array is zero-terminated.
+  unsigned coalesced;// number of further events folded into this one (see
+                     // NCOPTION_COALESCE_MOTION), usually 0
+  char* paste;       // NCKEY_PASTE: heap-allocated, NUL-terminated UTF-8
+                     // payload, owned (and to be free()d) by the caller
+  size_t pastelen;   // NCKEY_PASTE: length of 'paste', less the NUL
+  uint64_t recvns;   // CLOCK_MONOTONIC ns at which the input was read, or 0
+                     // for events not read from the terminal (e.g. timers)
 } ncinput;
 
 static inline bool
@@ -1310,6 +1618,14 @@ API int notcurses_getvec(struct notcurses* n, const struct timespec* ts,
                          ncinput* ni, int vcount)
   __attribute__ ((nonnull (1, 3)));
 
+// Acquire up to 'vcount' ncinputs at the vector 'ni', blocking (subject to
+// 'ts', as with notcurses_get()) only until the first is available. Whatever
+// else is already queued, up to 'vcount', is taken in the same call, but we
+// never wait for more. Returns the number read, 0 on timeout, or -1 on error.
+API int notcurses_get_batch(struct notcurses* n, const struct timespec* ts,
+                            ncinput* ni, int vcount)
+  __attribute__ ((nonnull (1, 3)));
+
 // Get a file descriptor suitable for input event poll()ing. When this
 // descriptor becomes available, you can call notcurses_get_nblock(),
 // and input ought be ready. This file descriptor is *not* necessarily
@@ -1356,6 +1672,37 @@ notcurses_mice_disable(struct notcurses* n){
   return notcurses_mice_enable(n, NCMICE_NO_EVENTS);
 }
 
+// Enable or disable bracketed paste mode. While enabled, each paste is
+// delivered as a single NCKEY_PASTE event, rather than an event per
+// character. Its 'paste' field holds the entire payload, which the caller
+// must free(). Returns -1 if there is no terminal to configure.
+API int notcurses_paste_enable(struct notcurses* n, bool enable)
+  __attribute__ ((nonnull (1)));
+
+// Called for an expired timer, from within the notcurses_get() family, in
+// the thread which took the NCKEY_TIMER event (and thus free to modify
+// planes). 'missed' counts any further expirations folded into this one
+// (a periodic timer which has fallen behind is called once, not once per
+// period). Return non-zero to cancel the timer. The callback must not
+// itself call into the notcurses_get() family.
+typedef int (*nctimercb)(struct notcurses* nc, void* curry, unsigned missed);
+
+// Register a timer which first expires 'delayns' from now, and then every
+// 'periodns' (0 for a one-shot timer). Timers expiring within the same
+// millisecond are delivered together: their callbacks are run, and a single
+// NCKEY_TIMER event is returned (making notcurses_inputready_fd() readable
+// in the meantime), so there's no need for a ticker thread. If 'delayns' is
+// 0 and 'periodns' is not, the first expiry is instead aligned to a multiple
+// of 'periodns', so that animations sharing a frame rate share wakeups.
+// Returns a positive timer id, or -1 on error.
+API int notcurses_timer_add(struct notcurses* nc, uint64_t delayns,
+                            uint64_t periodns, nctimercb cb, void* curry)
+  __attribute__ ((nonnull (1, 4)));
+
+// Cancel timer 'id', discarding any expirations not yet delivered.
+API int notcurses_timer_del(struct notcurses* nc, int id)
+  __attribute__ ((nonnull (1)));
+
 // Disable signals originating from the terminal's line discipline, i.e.
 // SIGINT (^C), SIGQUIT (^\), and SIGTSTP (^Z). They are enabled by default.
 API int notcurses_linesigs_disable(struct notcurses* n)
@@ -1487,6 +1834,15 @@ API ALLOC struct ncplane* ncplane_create(struct ncplane* n, const ncplane_option
 API ALLOC struct ncplane* ncpile_create(struct notcurses* nc, const ncplane_options* nopts)
   __attribute__ ((nonnull (1, 2)));
 
+// Share EGCs too large for an nccell among all planes of the pile containing
+// 'n'. Each distinct such EGC subsequently written to any of these planes is
+// stored once, in a refcounted pile-wide table, rather than in each plane.
+// Worthwhile when the same multi-codepoint glyphs (flags, ZWJ sequences) are
+// repeated many times. Glyphs already written are unaffected, and interning
+// cannot be disabled for a pile. Planes leaving the pile take their own copies.
+API int ncpile_intern_egcs(struct ncplane* n)
+  __attribute__ ((nonnull (1)));
+
 // Utility resize callbacks. When a parent plane is resized, it invokes each
 // child's resize callback. Any logic can be run in a resize callback, but
 // these are some generically useful ones.
@@ -1577,6 +1933,18 @@ API bool ncplane_set_autogrow(struct ncplane* n, unsigned growp)
 API bool ncplane_autogrow_p(const struct ncplane* n)
   __attribute__ ((nonnull (1)));
 
+// Mark 'n' and all planes bound to it (recursively) as a cached layer. The
+// family is composited once, and the result reused by each render until any
+// of its planes is written, moved, resized, restacked, or bound or unbound.
+// Worthwhile for large, static families. The layer is painted as a unit at
+// the z-position of its topmost plane; other planes stacked among its planes
+// are painted below it. Returns true if 'n' previously rooted a cached layer.
+API bool ncplane_set_layercache(struct ncplane* n, unsigned cached)
+  __attribute__ ((nonnull (1)));
+
+API bool ncplane_layercache_p(const struct ncplane* n)
+  __attribute__ ((nonnull (1)));
+
 // Palette API. Some terminals only support 256 colors, but allow the full
 // palette to be specified with arbitrary RGB colors. In all cases, it's more
 // performant to use indexed colors, since it's much less data to write to the
@@ -1687,6 +2055,11 @@ typedef enum {
   // original image (which we now deflate, since we needn't unpack it later).
   // the only data we need keep is the auxvecs.
   NCPIXEL_KITTY_SELFREF,
+  NCPIXEL_LINUXDRM,        // linux console, DRM/KMS overlay plane
+  // with 0.28.0, an image can be given a virtual placement, and shown by
+  // writing U+10EEEE placeholder glyphs into cells. the graphic then lives
+  // in the text: overlapping it or moving it is only ever a cell update.
+  NCPIXEL_KITTY_PLACEHOLDER,
 } ncpixelimpl_e;
 
 // Can we blit pixel-accurate bitmaps?
@@ -1812,6 +2185,37 @@ typedef struct ncstats {
   // current state -- these can decrease
   uint64_t fbbytes;          // total bytes devoted to all active framebuffers
   unsigned planes;           // number of planes currently in existence
+
+  // band-parallel painting (see NCOPTION_THREADED_RENDER)
+  unsigned render_threads;   // threads participating in paint, usually 1
+  uint64_t render_band_ns;   // ns spent painting bands, summed over threads
+  int64_t render_band_max_ns;// max ns spent painting a single band
+
+  // latency-bounded output (see notcurses_set_frame_budget())
+  uint64_t deferred_rasters; // rasterizations skipped, terminal being behind
+
+  // EGC storage (see ncplane_compact_pool())
+  uint64_t pool_compactions; // EGC pool compactions
+  uint64_t pool_reclaimed;   // bytes recovered by EGC pool compaction
+  uint64_t pool_fragmented;  // bytes currently wasted in EGC pools
+
+  // bitmap glyph buffers, recycled across sprixels
+  uint64_t fbuf_pool_hits;   // glyph buffers reused from the pool
+  uint64_t fbuf_pool_misses; // glyph buffers freshly mapped
+  uint64_t fbuf_pool_bytes;  // bytes currently retained by the pool
+
+  // streaming (see ncvisual_stream() and NCVISUAL_OPTION_PIPELINE)
+  uint64_t stream_frames_dropped; // late frames discarded without a blit
+  unsigned stream_queue_depth;    // frames decoded ahead of presentation
+  uint64_t stream_frames_held;    // slots for which a frame stayed up late
+  int64_t stream_av_skew_ns;      // last frame's arrival less its schedule
+  uint64_t stream_present_ns;     // predicted cost of presenting a frame
+
+  // low-bandwidth output (see NCOPTION_ADAPTIVE_BANDWIDTH and
+  // notcurses_set_color_tolerance())
+  uint64_t lowbw_frames;     // frames rasterized for a slow link
+  uint64_t approx_elisions;  // colors elided within a tolerance
+  uint64_t degraded_blits;   // bitmaps blitted as cells for a slow link
 } ncstats;
 
 // Allocate an ncstats object. Use this rather than allocating your own, since
@@ -1829,6 +2233,89 @@ API void notcurses_stats(struct notcurses* nc, ncstats* stats)
 API void notcurses_stats_reset(struct notcurses* nc, ncstats* stats)
   __attribute__ ((nonnull (1)));
 
+// Latencies recorded in log-linear histograms, alongside the ncstats totals.
+typedef enum {
+  NCSTATS_HIST_RENDER,       // rendering a frame (render_ns)
+  NCSTATS_HIST_RASTER,       // rasterizing a frame (raster_ns)
+  NCSTATS_HIST_WRITEOUT,     // writing a frame to the terminal (writeout_ns)
+  NCSTATS_HIST_INPUT2PHOTON, // input arriving until the next frame is written
+  NCSTATS_HIST_INPUT,        // input being read until its event is queued
+  NCSTATS_HIST_INPUTWAIT,    // input being read until its event is taken
+  NCSTATS_HIST_COUNT
+} ncstats_hist_e;
+
+// Each power of two of nanoseconds is split into 16 linear buckets, so a
+// sample is known to within 1/16 of its value. Samples of 2^43ns (about 2.4
+// hours) and beyond all land in the last bucket.
+#define NCHISTOGRAM_BUCKETS 640
+
+typedef struct nchistogram {
+  uint64_t count;                        // samples recorded
+  uint64_t buckets[NCHISTOGRAM_BUCKETS]; // samples per bucket
+} nchistogram;
+
+// Copy the histogram 'which' into '*h'. Like the ncstats totals, histograms
+// are zeroed by notcurses_stats_reset(). Returns -1 for an invalid 'which'.
+API int notcurses_stats_histogram(struct notcurses* nc, ncstats_hist_e which,
+                                  nchistogram* h)
+  __attribute__ ((nonnull (1, 3)));
+
+// The smallest nanosecond value in bucket 'idx' of an nchistogram.
+API uint64_t nchistogram_bucket_ns(unsigned idx);
+
+// The 'pct'th percentile (0..100) of 'h', in nanoseconds: the largest value
+// of the bucket holding that sample. Returns 0 for an empty histogram.
+API uint64_t nchistogram_percentile(const nchistogram* h, double pct)
+  __attribute__ ((nonnull (1)));
+
+// Bytes currently devoted to each of the principal consumers of memory.
+typedef struct ncmemreport {
+  uint64_t fbbytes;       // plane framebuffers, as allocated
+  uint64_t poolbytes;     // plane EGC pools
+  uint64_t historybytes;  // scrollback history and sparse canvas tiles
+  uint64_t tambytes;      // bitmap transparency matrices, with aux vectors
+  uint64_t glyphbytes;    // encoded bitmaps and their per-protocol state
+  uint64_t sixelmapbytes; // sixel band maps, palettes, and retained frames
+  uint64_t renderbytes;   // per-pile render state (crender vectors etc.)
+  uint64_t framebytes;    // last rasterized frame and captures, with EGCs
+  uint64_t rasterbytes;   // raster output buffer
+  uint64_t cachebytes;    // recycled glyph buffers, aux vectors, and planes
+  uint64_t totalbytes;    // sum of all the above
+} ncmemreport;
+
+// Total up the memory currently held by |nc|, by category. This walks every
+// pile, plane, and bitmap, so it is best not called every frame. ncvisuals
+// belong to the caller, and are not included (see ncvisual_memory()).
+API void notcurses_memory_report(struct notcurses* nc, ncmemreport* report)
+  __attribute__ ((nonnull (1, 2)));
+
+// Fill in |report| with the memory held by |n| and its bitmap, if any (the
+// context-wide categories renderbytes through cachebytes are zero). A
+// framebuffer and EGC pool shared by ncplane_dup() copies is divided evenly
+// among them.
+API void ncplane_memory_report(const struct ncplane* n, ncmemreport* report)
+  __attribute__ ((nonnull (1, 2)));
+
+// Write any messages deferred by NCOPTION_LOG_RING to |fp|, oldest first,
+// prefixed with their CLOCK_MONOTONIC time and thread id. They're then
+// discarded. Messages being logged concurrently might be skipped.
+API int notcurses_log_dump(struct notcurses* nc, FILE* fp)
+  __attribute__ ((nonnull (1, 2)));
+
+// Enable or disable render profiling. While enabled, each phase of rendering
+// and rasterization is timed, and time spent painting planes and drawing
+// their sprixels is charged to the planes (aggregated by ncplane_name()).
+// Changing the state discards anything gathered. Profiling paints serially,
+// even with NCOPTION_THREADED_RENDER, so that costs can be attributed.
+API int notcurses_profile(struct notcurses* nc, bool enable)
+  __attribute__ ((nonnull (1)));
+
+// Write the phase timings and per-plane costs gathered since profiling was
+// enabled to 'fp', most expensive planes first. Fails if profiling is not
+// enabled. Don't call this while rendering.
+API int notcurses_profile_dump(struct notcurses* nc, FILE* fp)
+  __attribute__ ((nonnull (1, 2)));
+
 // Resize the specified ncplane. The four parameters 'keepy', 'keepx',
 // 'keepleny', and 'keeplenx' define a subset of the ncplane to keep,
 // unchanged. This may be a region of size 0, though none of these four
@@ -1859,11 +2346,33 @@ ncplane_resize_simple(struct ncplane* n, unsigned ylen, unsigned xlen){
   return ncplane_resize(n, 0, 0, keepleny, keeplenx, 0, 0, ylen, xlen);
 }
 
+// Rewrite the plane's EGC storage (the backing store for glyphs too large to
+// live within an nccell) so that it holds only those EGCs still in use, packed
+// densely. This happens automatically when a badly fragmented plane is
+// resized. Returns the number of bytes reclaimed, or -1 on error (in which
+// case the plane is unchanged).
+API int ncplane_compact_pool(struct ncplane* n)
+  __attribute__ ((nonnull (1)));
+
 // Destroy the specified ncplane. None of its contents will be visible after
 // the next call to notcurses_render(). It is an error to attempt to destroy
 // the standard plane.
 API int ncplane_destroy(struct ncplane* n);
 
+// Don't free the destroyed planes' memory immediately, but only once the next
+// frame has been written (by notcurses_render() or ncpile_rasterize()).
+#define NCPLANE_DESTROY_DEFERRED 0x0001ull
+
+// Destroy the specified ncplane, along with every plane bound to it (directly
+// or indirectly), as a single operation. This is much faster than destroying
+// them individually, as no plane need ever be reparented. With
+// NCPLANE_DESTROY_DEFERRED, the planes are gone upon return (and their
+// widgets destroyed), but the release of their memory is put off until after
+// the next frame has been written, getting it out of the way of an
+// interactive response. It is an error to attempt to destroy the standard
+// plane.
+API int ncplane_destroy_family(struct ncplane* n, uint64_t flags);
+
 // Set the ncplane's base nccell to 'c'. The base cell is used for purposes of
 // rendering anywhere that the ncplane's gcluster is 0. Note that the base cell
 // is not affected by ncplane_erase(). 'c' must not be a secondary cell from a
@@ -1902,6 +2411,23 @@ ncplane_move_rel(struct ncplane* n, int y, int x){
   return ncplane_move_yx(n, oy + y, ox + x);
 }
 
+// Open a transaction on the pile containing 'n', for relayouts touching many
+// planes. Until the matching ncpile_commit(), ncplane_move_yx() only records
+// each plane's new origin (reflected by ncplane_yx(), but not by
+// ncplane_abs_yx() or rendering), and the resize callbacks of planes whose
+// parents are resized are deferred. At commit, bound planes are moved along
+// with their parents in one pass, and each pending resize callback is invoked
+// once, however many times the parent was resized. Transactions nest; only
+// the outermost commit applies them. Z-axis moves take effect immediately.
+API int ncpile_begin_update(struct ncplane* n)
+  __attribute__ ((nonnull (1)));
+
+// Close the transaction opened by ncpile_begin_update(). Returns -1 if no
+// transaction was open, and otherwise the bitwise OR of the return values
+// of any resize callbacks invoked.
+API int ncpile_commit(struct ncplane* n)
+  __attribute__ ((nonnull (1)));
+
 // Get the origin of plane 'n' relative to its pile. Either or both of 'x' and
 // 'y' may be NULL.
 API void ncplane_abs_yx(const struct ncplane* n, int* RESTRICT y, int* RESTRICT x)
@@ -1998,6 +2524,71 @@ API int ncplane_scrollup(struct ncplane* n, int r)
 API int ncplane_scrollup_child(struct ncplane* n, const struct ncplane* child)
   __attribute__ ((nonnull (1, 2)));
 
+// Retain up to |maxlines| rows scrolled up and out of |n| as history, evicting
+// the oldest once the cap is reached. A |maxlines| of 0 discards any history
+// and stops retention. History is discarded when |n|'s width changes, or when
+// it is resized keeping nothing. Output functions and ncplane_contents() et
+// al. always address the live plane; history is only ever displayed.
+API int ncplane_set_scrollback(struct ncplane* n, unsigned maxlines)
+  __attribute__ ((nonnull (1)));
+
+// Return the number of rows of history retained by |n|.
+API unsigned ncplane_scrollback_lines(const struct ncplane* n)
+  __attribute__ ((nonnull (1)));
+
+// Display |n| as if scrolled back |offset| rows into its history, so that the
+// |offset| most recent rows of history fill its top, followed by the live
+// plane. Output continues to go to the live plane; while scrolled back, the
+// view remains fixed on the same rows of history. 0 returns to the live
+// plane. |offset| is clamped to the history retained; the offset in effect
+// is returned.
+API int ncplane_scrollback_view(struct ncplane* n, unsigned offset)
+  __attribute__ ((nonnull (1)));
+
+// Make |n| a window onto a sparse |rows|x|cols| canvas, which must be at
+// least as large as |n|. The canvas is stored as tiles, allocated only where
+// something has been written, so memory scales with content rather than with
+// the canvas's area. |n| initially views the canvas's origin, and keeps its
+// current contents there. Cells move into |n| as they're panned into view,
+// and back into the canvas as they're panned out of it, so rendering costs
+// only what's in view. Output functions and ncplane_erase() address |n| (and
+// thus the view); use ncplane_canvas_putc_yx() to write anywhere on the
+// canvas. A canvas can be grown, but not shrunk; growing |n| beyond it grows
+// it. Rows and cols of 0 discard the canvas, leaving |n| with the contents
+// in view. A plane keeping scrollback history can't have a canvas.
+API int ncplane_set_canvas(struct ncplane* n, unsigned rows, unsigned cols)
+  __attribute__ ((nonnull (1)));
+
+// Get the geometry of |n|'s canvas. Returns -1 if |n| has no canvas.
+API int ncplane_canvas_dim_yx(const struct ncplane* n, unsigned* RESTRICT rows,
+                              unsigned* RESTRICT cols)
+  __attribute__ ((nonnull (1)));
+
+// Get the canvas coordinate at which |n|'s view begins. Returns -1 if |n|
+// has no canvas.
+API int ncplane_canvas_origin(const struct ncplane* n, unsigned* RESTRICT y,
+                              unsigned* RESTRICT x)
+  __attribute__ ((nonnull (1)));
+
+// Move |n|'s view such that it begins at canvas coordinate |y|/|x|, clamped
+// such that the view remains within the canvas.
+API int ncplane_canvas_pan(struct ncplane* n, unsigned y, unsigned x)
+  __attribute__ ((nonnull (1)));
+
+// Write |c| (which must have been loaded against |n|) to canvas coordinate
+// |y|/|x|, whether in view or not. The cursor is unaffected. Returns the
+// number of columns written, or -1 on error.
+API int ncplane_canvas_putc_yx(struct ncplane* n, unsigned y, unsigned x,
+                               const nccell* c)
+  __attribute__ ((nonnull (1, 4)));
+
+// Retrieve the EGC (and, optionally, its styling and channels) at canvas
+// coordinate |y|/|x|, whether in view or not, as ncplane_at_yx() would. The
+// result must be free()d.
+API char* ncplane_canvas_at_yx(const struct ncplane* n, unsigned y, unsigned x,
+                               uint16_t* stylemask, uint64_t* channels)
+  __attribute__ ((nonnull (1)));
+
 // Rotate the plane π/2 radians clockwise or counterclockwise. This cannot
 // be performed on arbitrary planes, because glyphs cannot be arbitrarily
 // rotated. The glyphs which can be rotated are limited: line-drawing
@@ -2051,6 +2642,20 @@ API char* ncplane_contents(struct ncplane* n, int begy, int begx,
                            unsigned leny, unsigned lenx)
   __attribute__ ((nonnull (1)));
 
+// Called by ncplane_contents_stream() with the EGCs of each row of the region,
+// concatenated as ncplane_contents() would, and not NUL-terminated. 'y' is
+// the row within the plane. 'row' is only valid for the duration of the call.
+// Return non-zero to stop the stream.
+typedef int (*nccontentscb)(const char* row, size_t len, unsigned y, void* curry);
+
+// Stream the EGCs of the selected region (specified as for ncplane_contents())
+// to 'cb', one row at a time, without building them into a single string.
+// Returns -1 on error, the first non-zero return of 'cb', or 0.
+API int ncplane_contents_stream(const struct ncplane* n, int begy, int begx,
+                                unsigned leny, unsigned lenx,
+                                nccontentscb cb, void* curry)
+  __attribute__ ((nonnull (1, 6)));
+
 // Manipulate the opaque user pointer associated with this plane.
 // ncplane_set_userptr() returns the previous userptr after replacing
 // it with 'opaque'. the others simply return the userptr.
@@ -2167,6 +2772,18 @@ ncplane_putc(struct ncplane* n, const nccell* c){
   return ncplane_putc_yx(n, -1, -1, c);
 }
 
+// Write the 'ylen'x'xlen' block of cells 'cells' to 'n', with its origin at
+// 'y', 'x' (-1 means the cursor's row or column). Successive rows of 'cells'
+// are 'stride' cells apart (pass 0 for 'xlen'). A glyph of N columns consumes
+// N cells of its row, the last N - 1 of which are ignored; it must not cross
+// the block's right edge. As with ncplane_putc(), the cells must already be
+// associated with 'n', and each carries its own styling. The block must lie
+// entirely within the plane. Nothing is written unless every cell is valid.
+// The cursor is not moved. Returns the number of cells written, or -1 on error.
+API int ncplane_put_cells(struct ncplane* n, int y, int x, unsigned ylen,
+                          unsigned xlen, const nccell* cells, size_t stride)
+  __attribute__ ((nonnull (1, 6)));
+
 // Replace the cell at the specified coordinates with the provided 7-bit char
 // 'c'. Advance the cursor by 1. On success, returns the number of columns the
 // cursor was advanced. On failure, returns -1. This works whether the
@@ -2257,6 +2874,15 @@ ncplane_putwegc_yx(struct ncplane* n, int y, int x, const wchar_t* gclust,
 API int ncplane_putwegc_stained(struct ncplane* n, const wchar_t* gclust, size_t* sbytes)
   __attribute__ ((nonnull (1, 2)));
 
+// Write a series of EGCs to the current location, using the current style.
+// They will be interpreted as a series of columns (according to the definition
+// of ncplane_putc()). Advances the cursor by some positive number of columns
+// (though not beyond the end of the plane); this number is returned on success.
+// On error, a non-positive number is returned, indicating the number of columns
+// which were written before the error. No more than 's' bytes will be written.
+API int ncplane_putnstr_yx(struct ncplane* n, int y, int x, size_t s, const char* gclusters)
+  __attribute__ ((nonnull (1, 5)));
+
 // Write a series of EGCs to the current location, using the current style.
 // They will be interpreted as a series of columns (according to the definition
 // of ncplane_putc()). Advances the cursor by some positive number of columns
@@ -2265,25 +2891,7 @@ API int ncplane_putwegc_stained(struct ncplane* n, const wchar_t* gclust, size_t
 // which were written before the error.
 static inline int
 ncplane_putstr_yx(struct ncplane* n, int y, int x, const char* gclusters){
-  int ret = 0;
-  while(*gclusters){
-    size_t wcs;
-    int cols = ncplane_putegc_yx(n, y, x, gclusters, &wcs);
-//fprintf(stderr, "wrote %.*s %d cols %zu bytes\n", (int)wcs, gclusters, cols, wcs);
-    if(cols < 0){
-      return -ret;
-    }
-    if(wcs == 0){
-      break;
-    }
-    // after the first iteration, just let the cursor code control where we
-    // print, so that scrolling is taken into account
-    y = -1;
-    x = -1;
-    gclusters += wcs;
-    ret += cols;
-  }
-  return ret;
+  return ncplane_putnstr_yx(n, y, x, strlen(gclusters), gclusters);
 }
 
 static inline int
@@ -2326,36 +2934,6 @@ ncplane_putstr_stained(struct ncplane* n, const char* gclusters){
 API int ncplane_putnstr_aligned(struct ncplane* n, int y, ncalign_e align, size_t s, const char* str)
   __attribute__ ((nonnull (1, 5)));
 
-// Write a series of EGCs to the current location, using the current style.
-// They will be interpreted as a series of columns (according to the definition
-// of ncplane_putc()). Advances the cursor by some positive number of columns
-// (though not beyond the end of the plane); this number is returned on success.
-// On error, a non-positive number is returned, indicating the number of columns
-// which were written before the error. No more than 's' bytes will be written.
-static inline int
-ncplane_putnstr_yx(struct ncplane* n, int y, int x, size_t s, const char* gclusters){
-  int ret = 0;
-  size_t offset = 0;
-//fprintf(stderr, "PUT %zu at %d/%d [%.*s]\n", s, y, x, (int)s, gclusters);
-  while(offset < s && gclusters[offset]){
-    size_t wcs;
-    int cols = ncplane_putegc_yx(n, y, x, gclusters + offset, &wcs);
-    if(cols < 0){
-      return -ret;
-    }
-    if(wcs == 0){
-      break;
-    }
-    // after the first iteration, just let the cursor code control where we
-    // print, so that scrolling is taken into account
-    y = -1;
-    x = -1;
-    offset += wcs;
-    ret += cols;
-  }
-  return ret;
-}
-
 static inline int
 ncplane_putnstr(struct ncplane* n, size_t s, const char* gclustarr){
   return ncplane_putnstr_yx(n, -1, -1, s, gclustarr);
@@ -2568,6 +3146,38 @@ API int ncplane_puttext(struct ncplane* n, int y, ncalign_e align,
                         const char* text, size_t* bytes)
   __attribute__ ((nonnull (1, 4)));
 
+// ncplane_puttext() must measure and break its text anew with each call. For
+// text which is redrawn repeatedly (a scrolling log, a resizable pane), an
+// nclayout retains the text along with its break opportunities and wrapped
+// lines. The lines are only recomputed when the width changes, and appended
+// text only disturbs the paragraph it continues. As with ncplane_puttext(),
+// lines are broken at whitespace where possible, the whitespace at a break is
+// dropped, and words too wide for a line are split. Tabs advance to the next
+// multiple of 8 columns. 'text' (which may be NULL) is copied; NULL is
+// returned if it is not valid UTF-8.
+API ALLOC struct nclayout* nclayout_create(const char* text);
+
+// Append 'text' to the layout. Returns -1 (leaving the layout unchanged) if
+// it is not valid UTF-8, or on allocation failure.
+API int nclayout_append(struct nclayout* l, const char* text)
+  __attribute__ ((nonnull (1, 2)));
+
+// Return the number of rows the layout requires when wrapped to 'cols'
+// columns, or -1 if 'cols' is 0.
+API int nclayout_rows(struct nclayout* l, unsigned cols)
+  __attribute__ ((nonnull (1)));
+
+// Draw the layout's lines to 'n', wrapped to its width, beginning with line
+// 'firstrow' on plane row 'y' and continuing through the bottom of the plane.
+// Each row drawn upon is first erased (rows past the end of the text are left
+// blank). Each line is aligned according to 'align'. Returns the number of
+// text lines drawn.
+API int nclayout_render(struct nclayout* l, struct ncplane* n, int y,
+                        unsigned firstrow, ncalign_e align)
+  __attribute__ ((nonnull (1, 2)));
+
+API void nclayout_destroy(struct nclayout* l);
+
 // Draw horizontal or vertical lines using the specified cell, starting at the
 // current cursor position. The cursor will end at the cell following the last
 // cell output (even, perhaps counter-intuitively, when drawing vertical
@@ -2652,6 +3262,29 @@ ncplane_perimeter(struct ncplane* n, const nccell* ul, const nccell* ur,
   return ncplane_box_sized(n, ul, ur, ll, lr, hline, vline, dimy, dimx, ctlword);
 }
 
+// A box style resolved once for repeated drawing: the six glyphs of
+// 'gclusters' (ordered as for nccells_load_box()), each of which must be a
+// single column wide and no more than four bytes of UTF-8, stored directly
+// within their cells together with 'styles' and 'channels'. Widgets which
+// redraw the same borders every frame ought keep one of these around rather
+// than loading and releasing six nccells each time. Returns NULL on error.
+API ALLOC struct ncboxstyle* ncboxstyle_create(const char* gclusters,
+                                               uint16_t styles, uint64_t channels)
+  __attribute__ ((nonnull (1)));
+
+API void ncboxstyle_destroy(struct ncboxstyle* bs);
+
+// Draw a 'ylen'x'xlen' box using 'bs', with its upper-left corner at 'y'/'x'
+// (-1 for the cursor's position in that dimension). 'ctlword' is interpreted
+// as it is by ncplane_box(). Unless gradients are requested, only the cells of
+// the perimeter are touched, each edge being written as a single span, and
+// the cursor is not moved. The minimum box size is 2x2, and it cannot be
+// drawn off-plane.
+API int ncplane_box_styled(struct ncplane* n, const struct ncboxstyle* bs,
+                           int y, int x, unsigned ylen, unsigned xlen,
+                           unsigned ctlword)
+  __attribute__ ((nonnull (1, 2)));
+
 // Starting at the specified coordinate, if its glyph is different from that of
 // 'c', 'c' is copied into it, and the original glyph is considered the fill
 // target. We do the same to all cardinally-connected cells having this same
@@ -2717,6 +3350,18 @@ API int ncplane_stain(struct ncplane* n, int y, int x, unsigned ylen,
                       uint64_t ll, uint64_t lr)
   __attribute__ ((nonnull (1)));
 
+// Set the channels and/or stylemasks of the 'ylen'x'xlen' region having its
+// upper left corner at 'y', 'x' (-1 for the cursor's position in that
+// dimension) from the arrays 'channels' and 'styles', either of which may be
+// NULL to leave that property unchanged. Successive rows of each array are
+// 'stride' elements apart (0 for 'xlen'). Glyphs are unaffected. Unlike
+// ncplane_format() and ncplane_stain(), lengths of 0 are an error. Returns
+// the number of cells set, or -1 on failure.
+API int ncplane_paint(struct ncplane* n, int y, int x, unsigned ylen,
+                      unsigned xlen, const uint64_t* channels,
+                      const uint16_t* styles, size_t stride)
+  __attribute__ ((nonnull (1)));
+
 // Merge the entirety of 'src' down onto the ncplane 'dst'. If 'src' does not
 // intersect with 'dst', 'dst' will not be changed, but it is not an error.
 API int ncplane_mergedown_simple(struct ncplane* RESTRICT src,
@@ -2896,6 +3541,98 @@ nccell_bg_palindex_p(const nccell* cl){
   return ncchannels_bg_palindex_p(cl->channels);
 }
 
+// Bulk variants of the channel and cell helpers, operating on arrays, so that
+// language bindings can process entire rows with a single (FFI) call.
+
+// Set the foreground of each of the 'count' cells of 'c' from the
+// corresponding assembled 24-bit RGB value of 'rgb'. If any value is over
+// 0xffffff, nothing is changed, and -1 is returned.
+static inline int
+nccells_set_fg_rgb(nccell* c, const uint32_t* rgb, size_t count){
+  for(size_t i = 0 ; i < count ; ++i){
+    if(rgb[i] > 0xffffffu){
+      return -1;
+    }
+  }
+  for(size_t i = 0 ; i < count ; ++i){
+    nccell_set_fg_rgb(&c[i], rgb[i]);
+  }
+  return 0;
+}
+
+// Same, but for the backgrounds.
+static inline int
+nccells_set_bg_rgb(nccell* c, const uint32_t* rgb, size_t count){
+  for(size_t i = 0 ; i < count ; ++i){
+    if(rgb[i] > 0xffffffu){
+      return -1;
+    }
+  }
+  for(size_t i = 0 ; i < count ; ++i){
+    nccell_set_bg_rgb(&c[i], rgb[i]);
+  }
+  return 0;
+}
+
+// Copy the channels of each of the 'count' cells of 'c' into 'channels'.
+static inline void
+nccells_channels(const nccell* c, uint64_t* channels, size_t count){
+  for(size_t i = 0 ; i < count ; ++i){
+    channels[i] = c[i].channels;
+  }
+}
+
+// Set the channels of each of the 'count' cells of 'c' from 'channels'.
+static inline void
+nccells_set_channels(nccell* c, const uint64_t* channels, size_t count){
+  for(size_t i = 0 ; i < count ; ++i){
+    c[i].channels = channels[i];
+  }
+}
+
+// Combine 'count' foreground and background channels into channel pairs,
+// as ncchannels_combine() does.
+static inline void
+ncchannels_pack(uint64_t* channels, const uint32_t* fchans,
+                const uint32_t* bchans, size_t count){
+  for(size_t i = 0 ; i < count ; ++i){
+    channels[i] = ncchannels_combine(fchans[i], bchans[i]);
+  }
+}
+
+// Split 'count' channel pairs into their foreground and background channels.
+// Either of 'fchans' and 'bchans' may be NULL.
+static inline void
+ncchannels_unpack(const uint64_t* channels, uint32_t* fchans,
+                  uint32_t* bchans, size_t count){
+  for(size_t i = 0 ; i < count ; ++i){
+    if(fchans){
+      fchans[i] = ncchannels_fchannel(channels[i]);
+    }
+    if(bchans){
+      bchans[i] = ncchannels_bchannel(channels[i]);
+    }
+  }
+}
+
+// Load successive EGCs of the UTF-8 string 'egcs' into successive cells of
+// 'c', as nccell_load() does, until either 'count' cells have been loaded or
+// 'egcs' is exhausted. Returns the number of cells loaded, or -1 on error
+// (the cells loaded before the error remain loaded).
+static inline int
+nccells_load(struct ncplane* n, nccell* c, size_t count, const char* egcs){
+  size_t i = 0;
+  while(i < count && *egcs){
+    int bytes = nccell_load(n, &c[i], egcs);
+    if(bytes <= 0){
+      return -1;
+    }
+    egcs += bytes;
+    ++i;
+  }
+  return (int)i;
+}
+
 // Extract the background alpha and coloring bits from a 64-bit channel
 // pair as a single 32-bit value.
 static inline uint32_t
@@ -3069,6 +3806,54 @@ API int ncplane_pulse(struct ncplane* n, const struct timespec* ts, fadecb fader
 // Release the resources associated with 'nctx'.
 API void ncfadectx_free(struct ncfadectx* nctx);
 
+// Rather than each running its own loop of renders and sleeps, effects can
+// be handed to the animation engine. Every registered effect is advanced
+// once per frame, after which the standard pile is rendered once for all of
+// them. Frames are driven by a timer (see notcurses_timer_add()), and thus
+// only happen while some thread waits in the notcurses_get() family. Effects
+// are computed from the time elapsed since they began, so when the engine
+// falls behind, intermediate frames are simply skipped; the work done per
+// frame is bounded no matter how many effects are active. Effects on planes
+// outside the standard pile are advanced, but their piles must be rendered
+// by the caller.
+typedef enum {
+  NCANIM_FADEIN,  // fade in from black to the plane's current colors
+  NCANIM_FADEOUT, // fade the plane's current colors out to black
+  NCANIM_PULSE,   // fade in and out until cancelled; duration is a half-period
+  NCANIM_MOVE,    // move the plane to 'y', 'x' (relative to its parent)
+  NCANIM_RESIZE,  // resize the plane to 'rows' x 'cols' (as ncplane_resize_simple())
+  NCANIM_TWEEN,   // interpolate the base cell's channels to 'channels'
+} ncanim_e;
+
+typedef struct ncanim_options {
+  uint64_t durationns;  // length of the effect
+  int y, x;             // NCANIM_MOVE: destination
+  unsigned rows, cols;  // NCANIM_RESIZE: final geometry
+  uint64_t channels;    // NCANIM_TWEEN: final channels
+  // called from the frame in which the effect completes. the plane may be
+  // destroyed, or further effects registered, from within the callback.
+  void (*donecb)(struct ncplane* n, void* curry);
+  void* curry;
+  uint64_t flags;       // reserved, must be 0
+} ncanim_options;
+
+// Register an effect of type 'type' on 'n', beginning now. It replaces any
+// effect of the same type already registered on 'n' (whose callback is not
+// invoked). The fades require the same terminal support as ncplane_fadeout(),
+// and snapshot the plane's colors as they are at registration.
+API int ncplane_animate(struct ncplane* n, ncanim_e type, const ncanim_options* opts)
+  __attribute__ ((nonnull (1, 3)));
+
+// Cancel any effects registered on 'n', leaving it as the last frame left
+// it. Returns the number of effects cancelled. Effects are cancelled
+// implicitly when their plane is destroyed.
+API int ncplane_animate_cancel(struct ncplane* n)
+  __attribute__ ((nonnull (1)));
+
+// Set the animation engine's frame rate (60 by default).
+API int notcurses_set_animation_fps(struct notcurses* nc, unsigned fps)
+  __attribute__ ((nonnull (1)));
+
 // load up six cells with the EGCs necessary to draw a box. returns 0 on
 // success, -1 on error. on error, any cells this function might
 // have loaded before the error are nccell_release()d. There must be at least
@@ -3260,6 +4045,64 @@ ncplane_double_box_sized(struct ncplane* n, uint16_t styles, uint64_t channels,
 API ALLOC struct ncvisual* ncvisual_from_file(const char* file)
   __attribute__ ((nonnull (1)));
 
+// Like ncvisual_from_file(), but the decoder may reduce the image (e.g. JPEG
+// DCT scaling by 1/2, 1/4, or 1/8) so long as it remains at least 'minpixy'
+// pixels tall and 'minpixx' pixels wide. 0 places no bound on a dimension.
+// Useful when only a small rendering (e.g. a thumbnail) is wanted.
+API ALLOC struct ncvisual* ncvisual_from_file_sized(const char* file,
+                                                    unsigned minpixy,
+                                                    unsigned minpixx)
+  __attribute__ ((nonnull (1)));
+
+struct ncvisual_batch;
+
+// Invoked from a loader thread as each file of a batch completes. 'idx' is
+// the file's index within the array passed to ncvisual_from_files_async().
+// 'ncv' is NULL if the file couldn't be loaded; otherwise, it now belongs to
+// the callee. Several loaders might invoke the callback concurrently.
+typedef void (*ncvisual_batchcb)(unsigned idx, struct ncvisual* ncv, void* curry);
+
+typedef struct ncvisual_batch_options {
+  // if non-zero, each visual is shrunk (preserving its aspect ratio) to fit
+  // within 'pixy' rows and 'pixx' columns of pixels, and the decoder may
+  // reduce it while loading (see ncvisual_from_file_sized()).
+  unsigned pixy, pixx;
+  unsigned threads;    // loader threads; 0 for one per processor
+  // if NULL, results are instead queued for ncvisual_batch_next().
+  ncvisual_batchcb cb;
+  void* curry;         // passed to 'cb'
+  uint64_t flags;      // none yet defined; must be 0
+} ncvisual_batch_options;
+
+// Load each of the 'count' files named by 'files' (which are copied) on a
+// pool of library threads, returning immediately. Results are delivered in
+// order of completion, via 'opts->cb' or ncvisual_batch_next(). 'opts' may
+// be NULL. Returns NULL on error.
+API ALLOC struct ncvisual_batch* ncvisual_from_files_async(const char* const* files,
+                                                          unsigned count,
+                                                          const struct ncvisual_batch_options* opts)
+  __attribute__ ((nonnull (1)));
+
+// Retrieve the next queued result, writing the file's index to '*idx' and
+// its ncvisual (or NULL, if it couldn't be loaded) to '*ncv', which is now
+// owned by the caller. If nothing is queued, block if 'blocking' is true, or
+// otherwise return 0. Returns 1 when a result was written, and -1 once every
+// file has been delivered. With a callback, nothing is ever queued, and this
+// (blocking) simply waits for the batch to complete.
+API int ncvisual_batch_next(struct ncvisual_batch* b, unsigned* idx,
+                            struct ncvisual** ncv, bool blocking)
+  __attribute__ ((nonnull (1)));
+
+// A file descriptor suitable for poll(), readable while results are queued
+// and once the batch is complete. Not available on Windows, where -1 is
+// returned. It is owned by the batch, and mustn't be read or closed.
+API int ncvisual_batch_fd(const struct ncvisual_batch* b)
+  __attribute__ ((nonnull (1)));
+
+// Stop loading. Files already being loaded are finished (and delivered to
+// any callback) before returning; any queued results are destroyed.
+API void ncvisual_batch_destroy(struct ncvisual_batch* b);
+
 // Prepare an ncvisual, and its underlying plane, based off RGBA content in
 // memory at 'rgba'. 'rgba' is laid out as 'rows' lines, each of which is
 // 'rowstride' bytes in length. Each line has 'cols' 32-bit 8bpc RGBA pixels
@@ -3270,6 +4113,25 @@ API ALLOC struct ncvisual* ncvisual_from_rgba(const void* rgba, int rows,
                                               int rowstride, int cols)
   __attribute__ ((nonnull (1)));
 
+// Called once an ncvisual is done with memory lent to it by
+// ncvisual_from_rgba_borrowed(), with the 'data' and 'curry' supplied there.
+typedef void (*ncvisual_releasecb)(void* data, void* curry);
+
+// ncvisual_from_rgba(), but 'rgba' is used in place rather than copied. It
+// must remain valid until 'release' (which may be NULL) is called, which
+// happens when the ncvisual is destroyed, or no longer refers to it (e.g. an
+// ncvisual_resize() or ncvisual_rotate()). The pixels may be changed between
+// blits, but not during one. Notcurses never writes to them; functions which
+// modify the visual's pixels take a private copy first. 'rowstride' must be a
+// multiple of 4, and at least 'cols' * 4. If the multimedia engine requires
+// some other row alignment, the pixels are copied, and 'release' is called
+// before returning. On failure, 'release' is not called.
+API ALLOC struct ncvisual* ncvisual_from_rgba_borrowed(const void* rgba, int rows,
+                                                       int rowstride, int cols,
+                                                       ncvisual_releasecb release,
+                                                       void* curry)
+  __attribute__ ((nonnull (1)));
+
 // ncvisual_from_rgba(), but the pixels are 3-byte RGB. A is filled in
 // throughout using 'alpha'.
 API ALLOC struct ncvisual* ncvisual_from_rgb_packed(const void* rgba, int rows,
@@ -3291,6 +4153,15 @@ API ALLOC struct ncvisual* ncvisual_from_bgra(const void* bgra, int rows,
                                               int rowstride, int cols)
   __attribute__ ((nonnull (1)));
 
+// ncvisual_from_bgra(), but ownership of 'bgra' (which must have been
+// allocated with malloc(), and which is not copied) passes to the ncvisual
+// on success. The pixels are converted to RGBA in place. On failure, 'bgra'
+// remains untouched, and belongs to the caller. Useful for e.g. streaming
+// captured frames without a copy apiece.
+API ALLOC struct ncvisual* ncvisual_from_bgra_owned(void* bgra, int rows,
+                                                    int rowstride, int cols)
+  __attribute__ ((nonnull (1)));
+
 // ncvisual_from_rgba(), but 'data' is 'pstride'-byte palette-indexed pixels,
 // arranged in 'rows' lines of 'rowstride' bytes each, composed of 'cols'
 // pixels. 'palette' is an array of at least 'palsize' ncchannels.
@@ -3323,6 +4194,13 @@ API ALLOC struct ncvisual* ncvisual_from_sixel(const char* s, unsigned leny, uns
 #define NCVISUAL_OPTION_ADDALPHA      0x0010ull // transcolor is in effect
 #define NCVISUAL_OPTION_CHILDPLANE    0x0020ull // interpret n as parent
 #define NCVISUAL_OPTION_NOINTERPOLATE 0x0040ull // non-interpolative scaling
+#define NCVISUAL_OPTION_QUANTFAST     0x0080ull // quicker, coarser quantization
+#define NCVISUAL_OPTION_PIPELINE      0x0100ull // decode ahead in ncvisual_stream()
+#define NCVISUAL_OPTION_SCALEFAST     0x0200ull // fast bilinear scaling
+#define NCVISUAL_OPTION_SCALEAREA     0x0400ull // area-averaging scaling
+#define NCVISUAL_OPTION_SCALEFINE     0x0800ull // Lanczos scaling
+#define NCVISUAL_OPTION_ADAPTIVE      0x1000ull // drop NCBLIT_PIXEL when too slow
+#define NCVISUAL_OPTION_TILED         0x2000ull // split bitmap into sprixel tiles
 
 struct ncvisual_options {
   // if no ncplane is provided, one will be created using the exact size
@@ -3401,6 +4279,11 @@ API int ncvisual_geom(const struct notcurses* nc, const struct ncvisual* n,
 // can be neither decoded nor rendered any further.
 API void ncvisual_destroy(struct ncvisual* ncv);
 
+// Bytes of pixel data held by |ncv| (whether owned, borrowed, or belonging
+// to a decoder), including any buffer kept for rotation.
+API uint64_t ncvisual_memory(const struct ncvisual* ncv)
+  __attribute__ ((nonnull (1)));
+
 // extract the next frame from an ncvisual. returns 1 on end of file, 0 on
 // success, and -1 on failure.
 API int ncvisual_decode(struct ncvisual* nc)
@@ -3413,11 +4296,48 @@ API int ncvisual_decode(struct ncvisual* nc)
 API int ncvisual_decode_loop(struct ncvisual* nc)
   __attribute__ ((nonnull (1)));
 
-// Rotate the visual 'rads' radians. Only M_PI/2 and -M_PI/2 are supported at
-// the moment, but this might change in the future.
+// Keep the frames of a looping ncvisual in memory, up to 'maxbytes', so that
+// ncvisual_decode_loop() can replay them rather than decoding them again.
+// Recording begins with the next complete pass (immediately, if the first
+// frame is current); once it completes, frames are replayed along with their
+// scaling for the last geometry at which each was blitted. If a pass doesn't
+// fit, decoding continues as usual. A 'maxbytes' of 0 releases the cache.
+// Only supported by file-backed visuals of the FFmpeg engine.
+API int ncvisual_set_loopcache(struct ncvisual* ncv, size_t maxbytes)
+  __attribute__ ((nonnull (1)));
+
+#define NCVISUAL_SEEK_KEYFRAME 0x0001ull
+
+// Decode the frame shown 'ns' nanoseconds into a file-backed ncvisual's
+// video, so that a subsequent ncvisual_blit() renders it, and decoding
+// continues from it. With NCVISUAL_SEEK_KEYFRAME, the last keyframe at or
+// before 'ns' is decoded instead, which is cheaper. Keyframes are indexed
+// upon the first seek, and thereafter recently-decoded frames are kept, so
+// that small seeks in either direction (i.e. scrubbing) are served from
+// memory, or by decoding onwards, rather than from the previous keyframe.
+// Seeking beyond the end leaves the last frame. Only supported by the
+// FFmpeg engine.
+API int ncvisual_seek(struct ncvisual* ncv, uint64_t ns, uint64_t flags)
+  __attribute__ ((nonnull (1)));
+
+// Get the presentation time of the frame most recently decoded (or sought)
+// into 'ncv', in nanoseconds from the beginning of its video. Returns -1 if
+// it isn't known.
+API int ncvisual_position(const struct ncvisual* ncv, uint64_t* ns)
+  __attribute__ ((nonnull (1, 2)));
+
+// Rotate the visual 'rads' radians about the center of its non-transparent
+// pixels, resizing it to fit them. Each pixel takes the nearest source pixel,
+// so no new colors are introduced. Multiples of M_PI/2 are exact.
 API int ncvisual_rotate(struct ncvisual* n, double rads)
   __attribute__ ((nonnull (1)));
 
+// Rotate the visual ala ncvisual_rotate(), but interpolate (bilinearly) among
+// the nearest four source pixels, smoothing edges at arbitrary angles.
+// Multiples of M_PI/2 are exact, and not interpolated.
+API int ncvisual_rotate_bilinear(struct ncvisual* n, double rads)
+  __attribute__ ((nonnull (1)));
+
 // Scale the visual to 'rows' X 'columns' pixels, using the best scheme
 // available. This is a lossy transformation, unless the size is unchanged.
 API int ncvisual_resize(struct ncvisual* n, int rows, int cols)
@@ -3457,6 +4377,29 @@ API struct ncplane* ncvisual_blit(struct notcurses* nc, struct ncvisual* ncv,
                                   const struct ncvisual_options* vopts)
   __attribute__ ((nonnull (2)));
 
+// Perform all the scaling and encoding of ncvisual_blit() without touching
+// any existing pile, so that it can be done on any thread. vopts->n must be
+// NULL; vopts->y and vopts->x (and NCVISUAL_OPTION_HORALIGNED and
+// NCVISUAL_OPTION_VERALIGNED) are applied relative to the plane to which the
+// result is attached. The result is owned by the caller, and must be either
+// attached or destroyed before notcurses_stop(). 'ncv' must not be modified
+// or blitted elsewhere while it is being prepared.
+API ALLOC struct ncprepared* ncvisual_prepare(struct notcurses* nc,
+                                              struct ncvisual* ncv,
+                                              const struct ncvisual_options* vopts)
+  __attribute__ ((nonnull (1, 2)));
+
+// Install a prepared blit as a new child of 'n', which must be called from
+// the thread rendering n's pile. No scaling or encoding is performed. On
+// success, 'prep' is consumed, and the new plane is returned. On failure,
+// NULL is returned, and 'prep' remains owned by the caller.
+API struct ncplane* ncplane_attach_prepared(struct ncplane* n,
+                                            struct ncprepared* prep)
+  __attribute__ ((nonnull (1, 2)));
+
+// Destroy a prepared blit which was never attached.
+API void ncprepared_destroy(struct ncprepared* prep);
+
 // Create a new plane as prescribed in opts, either as a child of 'vopts->n',
 // or the root of a new pile if 'vopts->n' is NULL (or 'vopts' itself is NULL).
 // Blit 'ncv' to the created plane according to 'vopts'. If 'vopts->n' is
@@ -3497,6 +4440,64 @@ API ALLOC struct ncplane* ncvisual_subtitle_plane(struct ncplane* parent,
                                                   const struct ncvisual* ncv)
   __attribute__ ((nonnull (1, 2)));
 
+// Keep '*subp' (which the caller owns, and which ought initially be NULL)
+// showing the subtitle current for 'ncv', as a child of 'parent'. The plane
+// is only rewritten when a new subtitle has been decoded (or 'parent' has
+// changed size), and is reused rather than recreated where possible. If no
+// subtitle ought be displayed, '*subp' is destroyed and set to NULL.
+API int ncvisual_subtitle_update(struct ncplane* parent, const struct ncvisual* ncv,
+                                 struct ncplane** subp)
+  __attribute__ ((nonnull (1, 2, 3)));
+
+struct nctiled;
+
+// A source of images too large to decode whole: a pyramid of 'levels'
+// resolutions (level 0 is full size, and each subsequent level is smaller),
+// each cut into tiles of 'tilepxy' X 'tilepxx' pixels. level_geom() writes
+// the pixel geometry of a level. load_tile() writes the RGBA pixels of one
+// tile into 'rgba', which has room for a full tile (rows of 'tilepxx'
+// pixels); tiles at the right and bottom edges need only fill the part lying
+// within the level. Both return 0 on success and -1 on failure. release(), if
+// not NULL, is called with 'curry' when the source is destroyed.
+typedef struct nctiled_source {
+  unsigned levels;
+  unsigned tilepxy, tilepxx;
+  int (*level_geom)(void* curry, unsigned level, unsigned* pxy, unsigned* pxx);
+  int (*load_tile)(void* curry, unsigned level, unsigned tiley, unsigned tilex,
+                   uint32_t* rgba);
+  void (*release)(void* curry);
+  void* curry;
+} nctiled_source;
+
+// Wrap a tiled source for region-of-interest blitting. Decoded tiles are kept
+// in a cache of at most 'cachebytes' bytes (0 for a default of 64MiB), least
+// recently used tiles being evicted first. On failure, 'src->release' is not
+// called.
+API ALLOC struct nctiled* nctiled_create(const nctiled_source* src,
+                                         size_t cachebytes)
+  __attribute__ ((nonnull (1)));
+
+// Open a (possibly tiled and MIP-mapped) image file as an nctiled. This
+// requires a multimedia engine which can read files piecewise (currently only
+// OpenImageIO). Files without MIP levels offer only their full resolution.
+API ALLOC struct nctiled* nctiled_from_file(const char* file, size_t cachebytes)
+  __attribute__ ((nonnull (1)));
+
+// Get the full-resolution pixel geometry of 'tiled'.
+API int nctiled_geom(const struct nctiled* tiled, unsigned* pxy, unsigned* pxx)
+  __attribute__ ((nonnull (1)));
+
+// Blit a region of 'tiled' ala ncvisual_blit(). vopts->begy, begx, leny, and
+// lenx select the region in full-resolution pixels (a zero length extends
+// to the edge). Only tiles intersecting the region are loaded, taken from the
+// smallest level which still supplies every rendered pixel.
+API struct ncplane* nctiled_blit(struct notcurses* nc, struct nctiled* tiled,
+                                 const struct ncvisual_options* vopts)
+  __attribute__ ((nonnull (1, 2)));
+
+// Destroy 'tiled', its tile cache, and its source.
+API void nctiled_destroy(struct nctiled* tiled);
+
 // Get the default *media* (not plot) blitter for this environment when using
 // the specified scaling method. Currently, this means:
 //  - if lacking UTF-8, NCBLIT_1x1
@@ -3677,6 +4678,11 @@ ncpixel_set_rgb8(uint32_t* pixel, unsigned r, unsigned g, unsigned b){
 // first, and vice versa)? only meaningful when infinitescroll is true. if
 // infinitescroll is false, this must be false.
 #define NCREEL_OPTION_CIRCULAR       0x0002ull
+// tablets leaving the screen keep their planes (and their contents), which
+// are handed back to the tablet's callback when it's next drawn. otherwise,
+// planes of tablets which have left the screen are recycled for whichever
+// tablets are drawn next, and handed to the callback empty.
+#define NCREEL_OPTION_RETAINPLANES   0x0004ull
 
 typedef struct ncreel_options {
   // Notcurses can draw a border around the ncreel, and also around the
@@ -3865,7 +4871,59 @@ API int notcurses_cursor_disable(struct notcurses* nc)
 API int notcurses_cursor_yx(const struct notcurses* nc, int* y, int* x)
   __attribute__ ((nonnull (1)));
 
-// Convert the plane's content to greyscale.
+// Recolorings applied by ncplane_transform_channels().
+typedef enum {
+  NCXFORM_MATRIX, // RGB through a 3x4 color matrix
+  NCXFORM_LUT,    // each RGB component through a 256-entry table
+  NCXFORM_ALPHA,  // replace the alpha
+} ncxform_e;
+
+#define NCXFORM_FG 0x0001u // transform foreground channels
+#define NCXFORM_BG 0x0002u // transform background channels
+
+typedef struct ncxform {
+  ncxform_e op;
+  unsigned channels; // bitfield of NCXFORM_FG and NCXFORM_BG (0 for both)
+  union {
+    // row 0 produces red, row 1 green, and row 2 blue, each as the sum of
+    // the first three columns times the original r, g, and b, plus the
+    // fourth column. components and offsets are on a scale of 0..255, and
+    // results are clamped to it. coefficients must lie within [-64, 64],
+    // and offsets within [-1024, 1024].
+    float matrix[3][4];
+    struct {
+      unsigned char r[256], g[256], b[256];
+    } lut;
+    unsigned alpha; // NCALPHA_* (NCALPHA_HIGHCONTRAST only for foregrounds)
+  } u;
+} ncxform;
+
+// Apply 'op' to the channels of each cell of the 'ylen'x'xlen' region having
+// its upper left corner at 'y', 'x' (-1 for the cursor's position in that
+// dimension; 0 lengths extend to the right and bottom of the plane). Default
+// and palette-indexed colors are left alone by NCXFORM_MATRIX and NCXFORM_LUT.
+// Glyphs and styles are unaffected. Returns the number of cells transformed,
+// or -1 on failure.
+API int ncplane_transform_channels(struct ncplane* n, int y, int x,
+                                   unsigned ylen, unsigned xlen,
+                                   const ncxform* op)
+  __attribute__ ((nonnull (1, 6)));
+
+// Prepare 'op' to convert foreground and background RGB to greyscale.
+__attribute__ ((nonnull (1))) static inline void
+ncxform_greyscale(ncxform* op){
+  memset(op, 0, sizeof(*op));
+  op->op = NCXFORM_MATRIX;
+  for(int c = 0 ; c < 3 ; ++c){
+    // Rec. 601 luma
+    op->u.matrix[c][0] = 0.299f;
+    op->u.matrix[c][1] = 0.587f;
+    op->u.matrix[c][2] = 0.114f;
+  }
+}
+
+// Convert the plane's RGB content to greyscale. Equivalent to
+// ncplane_transform_channels() over the entire plane with ncxform_greyscale().
 API void ncplane_greyscale(struct ncplane* n)
   __attribute__ ((nonnull (1)));
 
@@ -3913,6 +4971,34 @@ typedef struct ncselector_options {
 API ALLOC struct ncselector* ncselector_create(struct ncplane* n, const ncselector_options* opts)
   __attribute__ ((nonnull (1)));
 
+// Rather than copying in a list of items, an ncselector can fetch them as
+// they're displayed from an ncselector_source, so that lists of millions of
+// items cost only what's onscreen. 'count' returns the number of items, and
+// 'item' fills in item 'idx' (0 <= idx < count), returning non-zero on
+// failure. Strings returned by 'item' need remain valid only until the next
+// call into the source. Items ought be sorted in strcmp() order of their
+// options if ncselector_filter() is to be used. When 'count' changes, the
+// selector picks up the new items on its next redraw.
+typedef struct ncselector_source {
+  unsigned (*count)(void* curry);
+  int (*item)(void* curry, unsigned idx, struct ncselector_item* item);
+  void* curry;
+} ncselector_source;
+
+// Create an ncselector drawing its items from 'src'. 'opts->items' must be
+// NULL. ncselector_additem() and ncselector_delitem() fail on such a selector.
+API ALLOC struct ncselector* ncselector_create_source(struct ncplane* n,
+                                                     const ncselector_options* opts,
+                                                     const ncselector_source* src)
+  __attribute__ ((nonnull (1, 3)));
+
+// Offer only those items whose options begin with 'prefix', which is found
+// with a binary search over the (sorted) items. Extending the prefix searches
+// only the items which passed the last one. A NULL or empty 'prefix' offers
+// all items again. The selection returns to the first item offered.
+API int ncselector_filter(struct ncselector* n, const char* prefix)
+  __attribute__ ((nonnull (1)));
+
 // Dynamically add or delete items. It is usually sufficient to supply a static
 // list of items via ncselector_options->items.
 API int ncselector_additem(struct ncselector* n, const struct ncselector_item* item);
@@ -3992,6 +5078,28 @@ typedef struct ncmultiselector_options {
 API ALLOC struct ncmultiselector* ncmultiselector_create(struct ncplane* n, const ncmultiselector_options* opts)
   __attribute__ ((nonnull (1)));
 
+// As ncselector_source, but the source also owns each item's selection
+// status, reporting it in 'item', and is told of toggles via 'select' (which
+// may be NULL, making the items read-only).
+typedef struct ncmselector_source {
+  unsigned (*count)(void* curry);
+  int (*item)(void* curry, unsigned idx, struct ncmselector_item* item);
+  void (*select)(void* curry, unsigned idx, bool selected);
+  void* curry;
+} ncmselector_source;
+
+// Create an ncmultiselector drawing its items from 'src'. 'opts->items' must
+// be NULL.
+API ALLOC struct ncmultiselector* ncmultiselector_create_source(struct ncplane* n,
+                                                               const ncmultiselector_options* opts,
+                                                               const ncmselector_source* src)
+  __attribute__ ((nonnull (1, 3)));
+
+// Offer only those items whose options begin with 'prefix'. See
+// ncselector_filter().
+API int ncmultiselector_filter(struct ncmultiselector* n, const char* prefix)
+  __attribute__ ((nonnull (1)));
+
 // Return selected vector. An array of bools must be provided, along with its
 // length. If that length doesn't match the itemcount, it is an error.
 API int ncmultiselector_selected(struct ncmultiselector* n, bool* selected, unsigned count);
@@ -4039,6 +5147,26 @@ typedef struct nctree_options {
 API ALLOC struct nctree* nctree_create(struct ncplane* n, const nctree_options* opts)
   __attribute__ ((nonnull (1, 2)));
 
+// Rather than copying in a hierarchy of nctree_items, an nctree can fetch its
+// items from an nctree_source. 'subcount' returns the number of children of
+// the item having curry 'item' (NULL for the top level), and 'sub' returns the
+// (non-NULL) curry of its child 'idx'. The top level is fetched at creation.
+// Other items start out collapsed; their children are fetched when they're
+// expanded, and released when they're collapsed.
+typedef struct nctree_source {
+  unsigned (*subcount)(void* opaque, void* item);
+  void* (*sub)(void* opaque, void* item, unsigned idx);
+  void* opaque;
+} nctree_source;
+
+// Create an nctree drawing its items from 'src'. 'opts->items' must be NULL,
+// and 'opts->count' must be 0. nctree_add() and nctree_del() fail on such a
+// tree.
+API ALLOC struct nctree* nctree_create_source(struct ncplane* n,
+                                             const nctree_options* opts,
+                                             const nctree_source* src)
+  __attribute__ ((nonnull (1, 2, 3)));
+
 // Returns the ncplane on which this nctree lives.
 API struct ncplane* nctree_plane(struct nctree* n)
   __attribute__ ((nonnull (1)));
@@ -4055,6 +5183,7 @@ API int nctree_redraw(struct nctree* n)
 //  * a mouse click on an item (focuses item)
 //  * a mouse scrollwheel event (srolls tree)
 //  * up, down, pgup, or pgdown (navigates among items)
+//  * right or '+' (expands the focused item), left or '-' (collapses it)
 API bool nctree_offer_input(struct nctree* n, const ncinput* ni)
   __attribute__ ((nonnull (1, 2)));
 
@@ -4086,6 +5215,12 @@ API int nctree_add(struct nctree* n, const unsigned* spec, const struct nctree_i
 API int nctree_del(struct nctree* n, const unsigned* spec)
   __attribute__ ((nonnull (1, 2)));
 
+// Expand (if |expand| is true) or collapse the focused item. The subitems of
+// a collapsed item are skipped over by navigation, and not drawn. Returns -1
+// if there is no focused item, or if its children couldn't be fetched.
+API int nctree_expand(struct nctree* n, bool expand)
+  __attribute__ ((nonnull (1)));
+
 // Destroy the nctree.
 API void nctree_destroy(struct nctree* n);
 
@@ -4457,6 +5592,11 @@ API int nctabbed_set_separator(struct nctabbed* nt, const char* separator)
 // The 20 levels at first is a special case. When the domain is only 1 unit,
 // and autoscaling is in play, assign 50%.
 //
+// Spans are used only with one of the NCPLOT_OPTION_DECIMATE_* flags, which
+// also select what is plotted for each span. Otherwise, a rangex too large
+// for the plane is cut down to the most recent values which fit. At most one
+// NCPLOT_OPTION_DECIMATE_* flag may be supplied.
+//
 // This options structure works for both the ncuplot (uint64_t) and ncdplot
 // (double) types.
 #define NCPLOT_OPTION_LABELTICKSD   0x0001u // show labels for dependent axis
@@ -4465,6 +5605,9 @@ API int nctabbed_set_separator(struct nctabbed* nt, const char* separator)
 #define NCPLOT_OPTION_NODEGRADE     0x0008u // fail rather than degrade blitter
 #define NCPLOT_OPTION_DETECTMAXONLY 0x0010u // use domain detection only for max
 #define NCPLOT_OPTION_PRINTSAMPLE   0x0020u // print the most recent sample
+#define NCPLOT_OPTION_DECIMATE_MEAN 0x0040u // decimate, plotting the mean
+#define NCPLOT_OPTION_DECIMATE_MIN  0x0080u // decimate, plotting the minimum
+#define NCPLOT_OPTION_DECIMATE_MAX  0x0100u // decimate, plotting the maximum
 
 typedef struct ncplot_options {
   // channels for the maximum and minimum levels. linear or exponential
@@ -4517,6 +5660,29 @@ API int ncuplot_set_sample(struct ncuplot* n, uint64_t x, uint64_t y)
 API int ncdplot_set_sample(struct ncdplot* n, uint64_t x, double y)
   __attribute__ ((nonnull (1)));
 
+// Stage an addition to, or replacement of, the value corresponding to this x
+// from any thread, without taking a lock. Staged samples are folded into the
+// plot by its next redraw, whether due to ncuplot_flush() or one of the
+// functions above (which, along with the rest of the plot's API, must not be
+// called concurrently). Samples staged for the same x accumulate; the last
+// staged replacement wins. Returns -1 if x is at least a full window behind
+// another x staged since the last redraw, in which case it would be lost.
+API int ncuplot_stage_add(struct ncuplot* n, uint64_t x, uint64_t y)
+  __attribute__ ((nonnull (1)));
+API int ncdplot_stage_add(struct ncdplot* n, uint64_t x, double y)
+  __attribute__ ((nonnull (1)));
+API int ncuplot_stage_set(struct ncuplot* n, uint64_t x, uint64_t y)
+  __attribute__ ((nonnull (1)));
+API int ncdplot_stage_set(struct ncdplot* n, uint64_t x, double y)
+  __attribute__ ((nonnull (1)));
+
+// Fold any staged samples into the plot, and redraw it. notcurses_render()
+// is not called.
+API int ncuplot_flush(struct ncuplot* n)
+  __attribute__ ((nonnull (1)));
+API int ncdplot_flush(struct ncdplot* n)
+  __attribute__ ((nonnull (1)));
+
 API int ncuplot_sample(const struct ncuplot* n, uint64_t x, uint64_t* y)
   __attribute__ ((nonnull (1)));
 API int ncdplot_sample(const struct ncdplot* n, uint64_t x, double* y)
@@ -4529,14 +5695,27 @@ typedef int(*ncfdplane_callback)(struct ncfdplane* n, const void* buf, size_t s,
 typedef int(*ncfdplane_done_cb)(struct ncfdplane* n, int fderrno, void* curry);
 
 // read from an fd until EOF (or beyond, if follow is set), invoking the user's
-// callback each time. runs in its own context. on EOF or error, the finalizer
-// callback will be invoked, and the user ought destroy the ncfdplane. the
+// callback each time. every ncfdplane and ncsubproc of a notcurses context is
+// serviced by a single library thread (using epoll where available), in
+// which all callbacks run; a slow callback delays its fellows. on EOF or
+// error, the finalizer callback will be invoked, and the user ought destroy
+// the ncfdplane. EOF on a pipe or socket is final, even with follow. the
 // data is *not* guaranteed to be nul-terminated, and may contain arbitrary
-// zeroes.
+// zeroes. data is read into a buffer which starts at BUFSIZ bytes, doubling
+// whenever a read fills it, up to 'bufsize' (64KiB if 0); no callback sees
+// more than that. with 'coalesce_ms', data accumulates for up to that many
+// milliseconds before delivery, so that a chatty fd results in (at most) one
+// callback per period, rather than one per write(). with
+// NCFDPLANE_OPTION_MAPFILE, a regular file is mmap()ed, and its contents
+// delivered directly from the mapping without copying.
+#define NCFDPLANE_OPTION_MAPFILE 0x0001ull
+
 typedef struct ncfdplane_options {
   void* curry;    // parameter provided to callbacks
   bool follow;    // keep reading after hitting end? (think tail -f)
-  uint64_t flags; // bitfield over NCOPTION_FDPLANE_*
+  uint64_t flags; // bitfield over NCFDPLANE_OPTION_*
+  size_t bufsize; // largest chunk delivered to the callback (0 for default)
+  unsigned coalesce_ms; // hold data up to this long to batch callbacks
 } ncfdplane_options;
 
 // Create an ncfdplane around the fd 'fd'. Consider this function to take
@@ -4554,6 +5733,8 @@ typedef struct ncsubproc_options {
   void* curry;
   uint64_t restart_period; // restart this many seconds after an exit (watch)
   uint64_t flags;          // bitfield over NCOPTION_SUBPROC_*
+  size_t bufsize;          // as in ncfdplane_options
+  unsigned coalesce_ms;    // as in ncfdplane_options
 } ncsubproc_options;
 
 // see exec(2). p-types use $PATH. e-type passes environment vars.
@@ -4587,6 +5768,19 @@ API int ncplane_qrcode(struct ncplane* n, unsigned* ymax, unsigned* xmax,
                        const void* data, size_t len)
   __attribute__ ((nonnull (1, 4)));
 
+// Encode 'len' bytes of 'data' as a QR code of the smallest version (no
+// larger than 'maxversion', itself no larger than 40) which can hold them,
+// returning an ncvisual having one pixel per module: 'rgb' for dark modules,
+// and black for light ones. The version is written to '*version' if it is
+// non-NULL. The result can be blitted any number of times, to any plane,
+// using any blitter (including NCBLIT_PIXEL), without encoding again.
+// Blitters other than NCBLIT_2x1 and NCBLIT_PIXEL distort the aspect ratio
+// unless scaled. Returns NULL if the data don't fit, or on error.
+API ALLOC struct ncvisual* ncvisual_from_qrcode(const void* data, size_t len,
+                                                unsigned maxversion, uint32_t rgb,
+                                                unsigned* version)
+  __attribute__ ((nonnull (1)));
+
 // Enable horizontal scrolling. Virtual lines can then grow arbitrarily long.
 #define NCREADER_OPTION_HORSCROLL 0x0001ull
 // Enable vertical scrolling. You can then use arbitrarily many virtual lines.
@@ -4633,8 +5827,9 @@ API int ncreader_move_up(struct ncreader* n)
 API int ncreader_move_down(struct ncreader* n)
   __attribute__ ((nonnull (1)));
 
-// Destructively write the provided EGC to the current cursor location. Move
-// the cursor as necessary, scrolling if applicable.
+// Insert the provided EGC at the current cursor location, moving the cursor
+// past it and scrolling if applicable. A lone newline breaks the line. Fails
+// if the text would outgrow the plane in a direction without scrolling.
 API int ncreader_write_egc(struct ncreader* n, const char* egc)
   __attribute__ ((nonnull (1, 2)));
 
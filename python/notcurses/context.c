@@ -46,7 +46,7 @@ Notcurses_dealloc(NotcursesObject *self)
 {
     if (NULL != self->notcurses_ptr)
     {
-        notcurses_stop(self->notcurses_ptr);
+        WITHOUT_GIL(notcurses_stop(self->notcurses_ptr));
     }
 
     Py_TYPE(self)->tp_free(self);
@@ -133,7 +133,7 @@ Notcurses_new(PyTypeObject *subtype, PyObject *args, PyObject *kwds)
         }
     }
 
-    struct notcurses *new_notcurses = CHECK_NOTCURSES_PTR(notcurses_init(&options, main_tty_fp));
+    struct notcurses *new_notcurses = CHECK_NOTCURSES_PTR(WITHOUT_GIL(notcurses_init(&options, main_tty_fp)));
 
     NotcursesObject *new_context = (NotcursesObject *)GNU_PY_CHECK(subtype->tp_alloc(subtype, 0));
 
@@ -154,7 +154,7 @@ Notcurses_drop_planes(NotcursesObject *self, PyObject *Py_UNUSED(args))
 static PyObject *
 Notcurses_render(NotcursesObject *self, PyObject *Py_UNUSED(args))
 {
-    CHECK_NOTCURSES(notcurses_render(self->notcurses_ptr));
+    CHECK_NOTCURSES(WITHOUT_GIL(notcurses_render(self->notcurses_ptr)));
     Py_RETURN_NONE;
 }
 
@@ -252,7 +252,7 @@ Notcurses_get(NotcursesObject *self, PyObject *args, PyObject *kw)
     }
 
     struct ncinput ni;
-    uint32_t const id = notcurses_get(self->notcurses_ptr, ts, &ni);
+    uint32_t const id = WITHOUT_GIL(notcurses_get(self->notcurses_ptr, ts, &ni));
     return build_NcInput(id, &ni);
 }
 
@@ -268,7 +268,7 @@ static PyObject *
 Notcurses_get_blocking(NotcursesObject *self, PyObject *Py_UNUSED(args))
 {
     struct ncinput ni;
-    uint32_t const id = notcurses_get_blocking(self->notcurses_ptr, &ni);
+    uint32_t const id = WITHOUT_GIL(notcurses_get_blocking(self->notcurses_ptr, &ni));
     return build_NcInput(id, &ni);
 }
 
@@ -304,7 +304,7 @@ static PyObject *
 Notcurses_refresh(NotcursesObject *self, PyObject *Py_UNUSED(args))
 {
     unsigned rows = 0, columns = 0;
-    CHECK_NOTCURSES(notcurses_refresh(self->notcurses_ptr, &rows, &columns));
+    CHECK_NOTCURSES(WITHOUT_GIL(notcurses_refresh(self->notcurses_ptr, &rows, &columns)));
 
     return Py_BuildValue("II", rows, columns);
 }
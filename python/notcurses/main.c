@@ -90,6 +90,20 @@ PyInit_notcurses(void)
     GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCALPHA_BLEND));
     GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCALPHA_OPAQUE));
 
+    // blitters, scaling modes, and visual options for NcPlane.blit_rgba()
+    GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCBLIT_DEFAULT));
+    GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCBLIT_1x1));
+    GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCBLIT_2x1));
+    GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCBLIT_2x2));
+    GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCBLIT_3x2));
+    GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCBLIT_BRAILLE));
+    GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCBLIT_PIXEL));
+    GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCSCALE_NONE));
+    GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCSCALE_SCALE));
+    GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCSCALE_STRETCH));
+    GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCVISUAL_OPTION_BLEND));
+    GNU_PY_CHECK_INT(PyModule_AddIntMacro(py_module, NCVISUAL_OPTION_CHILDPLANE));
+
     // FIXME: Better, attributes of an object such as an enum.
     GNU_PY_CHECK_INT(PyModule_AddStringMacro(py_module, NCBOXASCII));
     GNU_PY_CHECK_INT(PyModule_AddStringMacro(py_module, NCBOXDOUBLE));
@@ -212,6 +212,18 @@ static inline void PyObject_cleanup(PyObject **object)
         return_value;                          \
     })
 
+// Evaluate a Notcurses call with the GIL released, so that other Python
+// threads run while it blocks (on input or the terminal) or works (rendering,
+// text layout). The call must not touch any Python object.
+#define WITHOUT_GIL(notcurses_func)                   \
+    ({                                                \
+        __typeof__(notcurses_func) nogil_return_value; \
+        Py_BEGIN_ALLOW_THREADS                        \
+        nogil_return_value = notcurses_func;          \
+        Py_END_ALLOW_THREADS                          \
+        nogil_return_value;                           \
+    })
+
 #define CHECK_NOTCURSES(notcurses_func)                                                    \
     ({                                                                                     \
         int return_value = notcurses_func;                                                 \
@@ -15,7 +15,7 @@
 # limitations under the License.
 from __future__ import annotations
 
-from typing import Optional, Tuple
+from typing import Any, Optional, Sequence, Tuple
 
 # Stub file for typing and docs
 
@@ -1336,3 +1336,45 @@ class NcPlane:
         If render() has not yet been called, nothing will be written.
         """
         raise NotImplementedError('Stub')
+
+    def put_cells(self, y: int, x: int, chars: Any,
+                  channels: Any = None, styles: Any = None) -> int:
+        """Write a block of cells from 2-dimensional buffers.
+
+        chars holds 32-bit codepoints (0 for an empty cell), e.g. a numpy
+        array of uint32 or of dtype 'U1'. channels (64-bit) and styles
+        (16-bit) must have the same shape if provided; otherwise the plane's
+        current channels and styles are used. A wide glyph consumes the
+        following cells of its row.
+
+        Returns the number of cells written.
+        """
+        raise NotImplementedError('Stub')
+
+    def paint(self, y: int, x: int,
+              channels: Any = None, styles: Any = None) -> int:
+        """Set the channels (64-bit) and/or styles (16-bit) of a block of
+        cells from 2-dimensional buffers, leaving glyphs unchanged.
+
+        Returns the number of cells set.
+        """
+        raise NotImplementedError('Stub')
+
+    def put_lines(self, y: int, x: int, lines: Sequence[str], /) -> int:
+        """Write each string on successive rows, starting at y, x.
+
+        Returns the total number of columns written.
+        """
+        raise NotImplementedError('Stub')
+
+    def blit_rgba(self, rgba: Any, y: int = 0, x: int = 0,
+                  blitter: int = 0, scaling: int = 0,
+                  flags: int = 0) -> Optional[NcPlane]:
+        """Blit RGBA pixels to the plane without copying them.
+
+        rgba is any buffer of shape (rows, cols, 4) bytes or (rows, cols)
+        32-bit words, e.g. a numpy array. Rows may be padded.
+
+        Returns the new plane if NCVISUAL_OPTION_CHILDPLANE is in flags.
+        """
+        raise NotImplementedError('Stub')
@@ -779,11 +779,279 @@ NcPlane_puttext(NcPlaneObject *self, PyObject *args)
                                        &y, &align_int,
                                        &text));
 
-    CHECK_NOTCURSES(ncplane_puttext(self->ncplane_ptr, y, (ncalign_e)align_int, text, &bytes_written));
+    CHECK_NOTCURSES(WITHOUT_GIL(ncplane_puttext(self->ncplane_ptr, y, (ncalign_e)align_int, text, &bytes_written)));
 
     return Py_BuildValue("n", (Py_ssize_t)bytes_written);
 }
 
+// Get a C-contiguous 2-dimensional buffer of integers 'itemsize' bytes wide
+// (numpy arrays, memoryviews, array.array reshaped via memoryview.cast()).
+static int
+get_grid_buffer(PyObject *obj, Py_buffer *view, Py_ssize_t itemsize, const char *name)
+{
+    if (0 != PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT))
+    {
+        return -1;
+    }
+    const char *format = NULL == view->format ? "B" : view->format;
+    const char kind = format[strlen(format) - 1];
+    if (2 != view->ndim || itemsize != view->itemsize || NULL == strchr("bBhHiIlLqQw", kind))
+    {
+        PyErr_Format(PyExc_ValueError, "%s must be a 2-dimensional array of %zd-byte integers", name, itemsize);
+        PyBuffer_Release(view);
+        return -1;
+    }
+    return 0;
+}
+
+static bool
+same_grid_shape(const Py_buffer *a, const Py_buffer *b)
+{
+    if (a->shape[0] != b->shape[0] || a->shape[1] != b->shape[1])
+    {
+        PyErr_SetString(PyExc_ValueError, "arrays must have the same shape");
+        return false;
+    }
+    return true;
+}
+
+static PyObject *
+NcPlane_put_cells(NcPlaneObject *self, PyObject *args, PyObject *kwds)
+{
+    int y = 0, x = 0;
+    PyObject *chars_obj = NULL, *channels_obj = Py_None, *styles_obj = Py_None;
+
+    char *keywords[] = {"y", "x", "chars", "channels", "styles", NULL};
+
+    GNU_PY_CHECK_BOOL(PyArg_ParseTupleAndKeywords(args, kwds, "iiO|OO", keywords,
+                                                  &y, &x, &chars_obj,
+                                                  &channels_obj, &styles_obj));
+
+    Py_buffer chars = {0}, channels = {0}, styles = {0};
+    PyObject *result = NULL;
+    nccell *cells = NULL;
+    size_t count = 0;
+    if (get_grid_buffer(chars_obj, &chars, 4, "chars"))
+    {
+        return NULL;
+    }
+    if (Py_None != channels_obj && (get_grid_buffer(channels_obj, &channels, 8, "channels") || !same_grid_shape(&chars, &channels)))
+    {
+        goto done;
+    }
+    if (Py_None != styles_obj && (get_grid_buffer(styles_obj, &styles, 2, "styles") || !same_grid_shape(&chars, &styles)))
+    {
+        goto done;
+    }
+    const size_t rows = (size_t)chars.shape[0];
+    const size_t cols = (size_t)chars.shape[1];
+    if (0 == rows || 0 == cols)
+    {
+        PyErr_SetString(PyExc_ValueError, "empty region");
+        goto done;
+    }
+    if (NULL == (cells = calloc(rows * cols, sizeof(*cells))))
+    {
+        PyErr_NoMemory();
+        goto done;
+    }
+    struct ncplane *n = self->ncplane_ptr;
+    const uint32_t *ucs = chars.buf;
+    const uint64_t defchannels = ncplane_channels(n);
+    const uint16_t defstyles = ncplane_styles(n);
+    for (count = 0; count < rows * cols; ++count)
+    {
+        nccell *c = &cells[count];
+        if (ucs[count] && nccell_load_ucs32(n, c, ucs[count]) < 0)
+        {
+            PyErr_Format(PyExc_ValueError, "invalid codepoint U+%04X", (unsigned)ucs[count]);
+            goto done;
+        }
+        c->channels = NULL != channels.buf ? ((const uint64_t *)channels.buf)[count] : defchannels;
+        c->stylemask = NULL != styles.buf ? ((const uint16_t *)styles.buf)[count] : defstyles;
+    }
+    int written = WITHOUT_GIL(ncplane_put_cells(n, y, x, (unsigned)rows, (unsigned)cols, cells, 0));
+    if (written < 0)
+    {
+        PyErr_Format(PyExc_RuntimeError, "Notcurses returned error %i", written);
+        goto done;
+    }
+    result = PyLong_FromLong(written);
+
+done:
+    for (size_t i = 0; i < count; ++i)
+    {
+        nccell_release(self->ncplane_ptr, &cells[i]);
+    }
+    free(cells);
+    if (NULL != styles.obj)
+    {
+        PyBuffer_Release(&styles);
+    }
+    if (NULL != channels.obj)
+    {
+        PyBuffer_Release(&channels);
+    }
+    PyBuffer_Release(&chars);
+    return result;
+}
+
+static PyObject *
+NcPlane_paint(NcPlaneObject *self, PyObject *args, PyObject *kwds)
+{
+    int y = 0, x = 0;
+    PyObject *channels_obj = Py_None, *styles_obj = Py_None;
+
+    char *keywords[] = {"y", "x", "channels", "styles", NULL};
+
+    GNU_PY_CHECK_BOOL(PyArg_ParseTupleAndKeywords(args, kwds, "ii|OO", keywords,
+                                                  &y, &x, &channels_obj, &styles_obj));
+
+    Py_buffer channels = {0}, styles = {0};
+    PyObject *result = NULL;
+    const Py_buffer *shape = NULL;
+    if (Py_None != channels_obj)
+    {
+        if (get_grid_buffer(channels_obj, &channels, 8, "channels"))
+        {
+            return NULL;
+        }
+        shape = &channels;
+    }
+    if (Py_None != styles_obj)
+    {
+        if (get_grid_buffer(styles_obj, &styles, 2, "styles"))
+        {
+            goto done;
+        }
+        if (NULL != shape && !same_grid_shape(shape, &styles))
+        {
+            goto done;
+        }
+        shape = &styles;
+    }
+    if (NULL == shape)
+    {
+        PyErr_SetString(PyExc_ValueError, "need channels and/or styles");
+        goto done;
+    }
+    int painted = ncplane_paint(self->ncplane_ptr, y, x,
+                                (unsigned)shape->shape[0], (unsigned)shape->shape[1],
+                                channels.buf, styles.buf, 0);
+    if (painted < 0)
+    {
+        PyErr_Format(PyExc_RuntimeError, "Notcurses returned error %i", painted);
+        goto done;
+    }
+    result = PyLong_FromLong(painted);
+
+done:
+    if (NULL != styles.obj)
+    {
+        PyBuffer_Release(&styles);
+    }
+    if (NULL != channels.obj)
+    {
+        PyBuffer_Release(&channels);
+    }
+    return result;
+}
+
+static PyObject *
+NcPlane_put_lines(NcPlaneObject *self, PyObject *args)
+{
+    int y = 0, x = 0;
+    PyObject *lines_obj = NULL;
+
+    GNU_PY_CHECK_BOOL(PyArg_ParseTuple(args, "iiO", &y, &x, &lines_obj));
+
+    PyObject *lines CLEANUP_PY_OBJ = GNU_PY_CHECK(PySequence_Fast(lines_obj, "lines must be a sequence of str"));
+    const Py_ssize_t count = PySequence_Fast_GET_SIZE(lines);
+    PyObject **items = PySequence_Fast_ITEMS(lines);
+    long total = 0;
+    for (Py_ssize_t i = 0; i < count; ++i)
+    {
+        const char *utf8 = PyUnicode_AsUTF8(items[i]);
+        if (NULL == utf8)
+        {
+            return NULL;
+        }
+        total += CHECK_NOTCURSES(ncplane_putstr_yx(self->ncplane_ptr, y + (int)i, x, utf8));
+    }
+    return PyLong_FromLong(total);
+}
+
+static PyObject *
+NcPlane_blit_rgba(NcPlaneObject *self, PyObject *args, PyObject *kwds)
+{
+    PyObject *rgba_obj = NULL;
+    int y = 0, x = 0, blitter = NCBLIT_DEFAULT, scaling = NCSCALE_NONE;
+    unsigned long long flags = 0;
+
+    char *keywords[] = {"rgba", "y", "x", "blitter", "scaling", "flags", NULL};
+
+    GNU_PY_CHECK_BOOL(PyArg_ParseTupleAndKeywords(args, kwds, "O|iiiiK", keywords,
+                                                  &rgba_obj, &y, &x,
+                                                  &blitter, &scaling, &flags));
+
+    // rows of RGBA pixels: either (rows, cols, 4) bytes or (rows, cols) 32-bit
+    // words, with pixels packed within a row, but rows possibly padded.
+    Py_buffer rgba;
+    if (0 != PyObject_GetBuffer(rgba_obj, &rgba, PyBUF_RECORDS_RO))
+    {
+        return NULL;
+    }
+    bool valid = false;
+    if (3 == rgba.ndim)
+    {
+        valid = 1 == rgba.itemsize && 4 == rgba.shape[2] && 1 == rgba.strides[2] && 4 == rgba.strides[1];
+    }
+    else if (2 == rgba.ndim)
+    {
+        valid = 4 == rgba.itemsize && 4 == rgba.strides[1];
+    }
+    if (!valid || rgba.shape[0] <= 0 || rgba.shape[1] <= 0 || rgba.shape[0] > INT_MAX ||
+        rgba.strides[0] % 4 || rgba.strides[0] < rgba.shape[1] * 4 || rgba.strides[0] > INT_MAX)
+    {
+        PyBuffer_Release(&rgba);
+        PyErr_SetString(PyExc_ValueError, "rgba must be (rows, cols, 4) bytes or (rows, cols) 32-bit pixels, packed within rows");
+        return NULL;
+    }
+    // the pixels are lent to the visual, not copied, and we hold the buffer
+    // until it's destroyed
+    struct ncvisual *ncv = ncvisual_from_rgba_borrowed(rgba.buf, (int)rgba.shape[0], (int)rgba.strides[0],
+                                                       (int)rgba.shape[1], NULL, NULL);
+    if (NULL == ncv)
+    {
+        PyBuffer_Release(&rgba);
+        PyErr_SetString(PyExc_RuntimeError, "Notcurses returned null ptr");
+        return NULL;
+    }
+    struct ncvisual_options vopts = {
+        .n = self->ncplane_ptr,
+        .y = y,
+        .x = x,
+        .blitter = (ncblitter_e)blitter,
+        .scaling = (ncscale_e)scaling,
+        .flags = (uint64_t)flags,
+    };
+    struct ncplane *n = WITHOUT_GIL(ncvisual_blit(ncplane_notcurses(self->ncplane_ptr), ncv, &vopts));
+    ncvisual_destroy(ncv);
+    PyBuffer_Release(&rgba);
+    if (NULL == n)
+    {
+        PyErr_SetString(PyExc_RuntimeError, "Notcurses returned null ptr");
+        return NULL;
+    }
+    if (n == self->ncplane_ptr)
+    {
+        Py_RETURN_NONE;
+    }
+    PyObject *new_object = GNU_PY_CHECK(NcPlane_Type.tp_alloc((PyTypeObject *)&NcPlane_Type, 0));
+    ((NcPlaneObject *)new_object)->ncplane_ptr = n;
+    return new_object;
+}
+
 static PyObject *
 NcPlane_box(NcPlaneObject *Py_UNUSED(self), PyObject *Py_UNUSED(args), PyObject *Py_UNUSED(kwds))
 {
@@ -1594,14 +1862,14 @@ NcPlane_pile_bottom(NcPlaneObject *self, PyObject *Py_UNUSED(args))
 static PyObject *
 NcPlane_pile_render(NcPlaneObject *self, PyObject *Py_UNUSED(args))
 {
-    ncpile_render(self->ncplane_ptr);
+    WITHOUT_GIL(ncpile_render(self->ncplane_ptr));
     Py_RETURN_NONE;
 }
 
 static PyObject *
 NcPlane_pile_rasterize(NcPlaneObject *self, PyObject *Py_UNUSED(args))
 {
-    ncpile_rasterize(self->ncplane_ptr);
+    WITHOUT_GIL(ncpile_rasterize(self->ncplane_ptr));
     Py_RETURN_NONE;
 }
 
@@ -1619,7 +1887,7 @@ NcPlane_pile_render_to_buffer(NcPlaneObject *self, PyObject *Py_UNUSED(args))
     char *buffer __attribute__((cleanup(cleanup_char_buffer))) = NULL;
     size_t buffer_len = 0;
 
-    CHECK_NOTCURSES(ncpile_render_to_buffer(self->ncplane_ptr, &buffer, &buffer_len));
+    CHECK_NOTCURSES(WITHOUT_GIL(ncpile_render_to_buffer(self->ncplane_ptr, &buffer, &buffer_len)));
 
     return PyBytes_FromStringAndSize(buffer, (Py_ssize_t)buffer_len);
 }
@@ -1645,7 +1913,7 @@ NcPlane_pile_render_to_file(NcPlaneObject *self, PyObject *args)
         return PyErr_SetFromErrno(PyExc_RuntimeError);
     }
 
-    CHECK_NOTCURSES(ncpile_render_to_file(self->ncplane_ptr, new_render_file));
+    CHECK_NOTCURSES(WITHOUT_GIL(ncpile_render_to_file(self->ncplane_ptr, new_render_file)));
 
     Py_RETURN_NONE;
 }
@@ -1851,6 +2119,11 @@ static PyMethodDef NcPlane_methods[] = {
 
     {"scrollup", (PyCFunction)NcPlane_scrollup, METH_VARARGS, "Effect scroll events on the plane."},
 
+    {"put_cells", (void *)NcPlane_put_cells, METH_VARARGS | METH_KEYWORDS, PyDoc_STR("Write a block of cells at 'y', 'x' from 2-dimensional buffers (e.g. numpy arrays): 'chars' of 32-bit codepoints (0 for an empty cell), and optionally 'channels' (64-bit) and 'styles' (16-bit) of the same shape, else the plane's current ones. Returns the number of cells written.")},
+    {"paint", (void *)NcPlane_paint, METH_VARARGS | METH_KEYWORDS, PyDoc_STR("Set the channels (64-bit) and/or styles (16-bit) of a block of cells at 'y', 'x' from 2-dimensional buffers (e.g. numpy arrays), leaving glyphs unchanged. Returns the number of cells set.")},
+    {"put_lines", (PyCFunction)NcPlane_put_lines, METH_VARARGS, PyDoc_STR("Write each string of a sequence on successive rows, starting at 'y', 'x'. Returns the total number of columns written.")},
+    {"blit_rgba", (void *)NcPlane_blit_rgba, METH_VARARGS | METH_KEYWORDS, PyDoc_STR("Blit RGBA pixels, (rows, cols, 4) bytes or (rows, cols) 32-bit words from any buffer (e.g. a numpy array), to the plane without copying them. Returns the new plane when NCVISUAL_OPTION_CHILDPLANE is among 'flags', else None.")},
+
     //  {"", (PyCFunction) NULL, METH_VARARGS, PyDoc_STR("")},
     {NULL, NULL, 0, NULL},
 };
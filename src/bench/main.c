@@ -0,0 +1,415 @@
+#include <time.h>
+#include <errno.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <notcurses/notcurses.h>
+
+// notcurses-bench runs a fixed set of microbenchmarks against Notcurses,
+// rendering to /dev/null (or, with -t, the controlling terminal), and writes
+// per-iteration latency percentiles to stdout as JSON.
+
+#define DEFAULT_ITERATIONS 200
+
+typedef struct benchresult {
+  const char* name;
+  uint64_t* samples;   // one per iteration, ns
+  unsigned count;
+  const char* skipped; // reason, if the benchmark couldn't run
+} benchresult;
+
+static uint64_t
+ns_now(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int
+u64cmp(const void* va, const void* vb){
+  const uint64_t a = *(const uint64_t*)va;
+  const uint64_t b = *(const uint64_t*)vb;
+  return a < b ? -1 : a > b;
+}
+
+// nearest-rank percentile of the sorted |samples|
+static uint64_t
+percentile(const uint64_t* samples, unsigned count, unsigned pct){
+  unsigned rank = (count * pct + 99) / 100;
+  if(rank == 0){
+    rank = 1;
+  }
+  return samples[rank - 1];
+}
+
+static uint32_t*
+synth_rgba(unsigned dimy, unsigned dimx){
+  uint32_t* rgba = malloc(sizeof(*rgba) * dimy * dimx);
+  if(rgba){
+    for(unsigned y = 0 ; y < dimy ; ++y){
+      for(unsigned x = 0 ; x < dimx ; ++x){
+        uint32_t px = 0xff000000ul;
+        ncpixel_set_r(&px, (x * 7 + y) % 256);
+        ncpixel_set_g(&px, (y * 3) % 256);
+        ncpixel_set_b(&px, (x ^ y) % 256);
+        rgba[y * dimx + x] = px;
+      }
+    }
+  }
+  return rgba;
+}
+
+// create and destroy a handful of small planes, rendering each time
+static int
+bench_plane_churn(struct notcurses* nc, unsigned i){
+  struct ncplane* std = notcurses_stdplane(nc);
+  struct ncplane* planes[16];
+  for(unsigned p = 0 ; p < sizeof(planes) / sizeof(*planes) ; ++p){
+    struct ncplane_options nopts = {
+      .y = (i + p) % ncplane_dim_y(std),
+      .x = (i * 3 + p * 5) % ncplane_dim_x(std),
+      .rows = 4,
+      .cols = 12,
+    };
+    if((planes[p] = ncplane_create(std, &nopts)) == NULL){
+      return -1;
+    }
+    ncplane_set_base(planes[p], "+", 0, NCCHANNELS_INITIALIZER(0xff, 0, 0, 0, 0, 0xff));
+  }
+  int r = notcurses_render(nc);
+  for(unsigned p = 0 ; p < sizeof(planes) / sizeof(*planes) ; ++p){
+    ncplane_destroy(planes[p]);
+  }
+  return r;
+}
+
+// fill the standard plane with text, varying its colors
+static int
+bench_text_fill(struct notcurses* nc, unsigned i){
+  unsigned dimy, dimx;
+  struct ncplane* std = notcurses_stddim_yx(nc, &dimy, &dimx);
+  ncplane_set_fg_rgb8(std, i % 256, 0x80, 0xff - i % 256);
+  for(unsigned y = 0 ; y < dimy ; ++y){
+    ncplane_cursor_move_yx(std, y, 0);
+    for(unsigned x = 0 ; x < dimx ; ++x){
+      ncplane_putchar(std, 'a' + (x + y + i) % 26);
+    }
+  }
+  return notcurses_render(nc);
+}
+
+static int
+bench_gradient_fill(struct notcurses* nc, unsigned i){
+  struct ncplane* std = notcurses_stdplane(nc);
+  const uint32_t shift = (i % 64) << 2;
+  if(ncplane_gradient2x1(std, 0, 0, 0, 0, 0xff0000 + shift, 0x00ff00 + shift,
+                         0x0000ff + shift, 0xffffff - shift) <= 0){
+    return -1;
+  }
+  return notcurses_render(nc);
+}
+
+// add a screenful of lines to a scrolling plane
+static int
+bench_scrolling(struct notcurses* nc, unsigned i){
+  struct ncplane* std = notcurses_stdplane(nc);
+  ncplane_set_scrolling(std, true);
+  for(unsigned l = 0 ; l < 8 ; ++l){
+    ncplane_printf(std, "line %u.%u of some scrolling output\n", i, l);
+  }
+  int r = notcurses_render(nc);
+  ncplane_set_scrolling(std, false);
+  return r;
+}
+
+typedef struct blitbench {
+  const char* name;
+  ncblitter_e blitter;
+} blitbench;
+
+static const blitbench blitbenches[] = {
+  { "blit_1x1", NCBLIT_1x1, },
+  { "blit_2x1", NCBLIT_2x1, },
+  { "blit_2x2", NCBLIT_2x2, },
+  { "blit_3x2", NCBLIT_3x2, },
+  { "blit_braille", NCBLIT_BRAILLE, },
+  { "blit_4x1", NCBLIT_4x1, },
+  { "blit_8x1", NCBLIT_8x1, },
+  { "blit_pixel", NCBLIT_PIXEL, },
+};
+
+// blit a synthetic, screen-sized image to a fresh child plane, and render
+static int
+bench_blit(struct notcurses* nc, struct ncvisual* ncv, ncblitter_e blitter){
+  struct ncvisual_options vopts = {
+    .n = notcurses_stdplane(nc),
+    .blitter = blitter,
+    .scaling = NCSCALE_STRETCH,
+    .flags = NCVISUAL_OPTION_CHILDPLANE | NCVISUAL_OPTION_NODEGRADE,
+  };
+  struct ncplane* n = ncvisual_blit(nc, ncv, &vopts);
+  if(n == NULL){
+    return -1;
+  }
+  int r = notcurses_render(nc);
+  ncplane_destroy(n);
+  return r;
+}
+
+// the sequence fed to the input benchmark: plain ASCII, multibyte UTF-8,
+// cursor keys, SGR mouse reports, and kitty keyboard protocol reports. it
+// ends with a tilde, which appears nowhere else, to mark the end of a batch.
+static const char inputseq[] =
+  "hello"
+  "\xc3\xa9\xe2\x82\xac"
+  "\x1b[A\x1b[B\x1b[1;5C"
+  "\x1b[<0;10;5M\x1b[<0;10;5m"
+  "\x1b[97;5u"
+  "~";
+
+typedef struct inputfeed {
+  int fd;
+  unsigned reps;
+} inputfeed;
+
+static void*
+input_feeder(void* v){
+  inputfeed* feed = v;
+  for(unsigned r = 0 ; r < feed->reps ; ++r){
+    size_t off = 0;
+    while(off < sizeof(inputseq) - 1){
+      ssize_t w = write(feed->fd, inputseq + off, sizeof(inputseq) - 1 - off);
+      if(w < 0){
+        if(errno == EINTR){
+          continue;
+        }
+        close(feed->fd);
+        return NULL;
+      }
+      off += w;
+    }
+  }
+  close(feed->fd);
+  return NULL;
+}
+
+// each sample is the time taken to decode one batch of events (a single
+// inputseq), fed through stdin by another thread.
+static benchresult
+bench_input(struct notcurses* nc, int feedfd, unsigned iterations){
+  benchresult br = { .name = "input_parse", };
+  if(feedfd < 0){
+    br.skipped = "couldn't redirect stdin";
+    return br;
+  }
+  if((br.samples = malloc(sizeof(*br.samples) * iterations)) == NULL){
+    br.skipped = "out of memory";
+    close(feedfd);
+    return br;
+  }
+  inputfeed feed = { .fd = feedfd, .reps = iterations, };
+  pthread_t tid;
+  if(pthread_create(&tid, NULL, input_feeder, &feed)){
+    br.skipped = "couldn't spawn feeder";
+    close(feedfd);
+    return br;
+  }
+  ncinput ni;
+  uint64_t t0 = ns_now();
+  uint32_t id;
+  while(br.count < iterations){
+    id = notcurses_get_blocking(nc, &ni);
+    if(id == (uint32_t)-1 || id == NCKEY_EOF){
+      break;
+    }
+    if(id == '~'){
+      uint64_t t1 = ns_now();
+      br.samples[br.count++] = t1 - t0;
+      t0 = t1;
+    }
+  }
+  if(br.count < iterations){ // the feeder might be stuck on a full pipe
+    pthread_cancel(tid);
+  }
+  pthread_join(tid, NULL);
+  if(br.count == 0){
+    br.skipped = "no input was decoded";
+  }
+  return br;
+}
+
+typedef int (*benchfxn)(struct notcurses* nc, unsigned iteration);
+
+static benchresult
+bench_run(struct notcurses* nc, const char* name, benchfxn fxn, unsigned iterations){
+  benchresult br = { .name = name, };
+  if((br.samples = malloc(sizeof(*br.samples) * iterations)) == NULL){
+    br.skipped = "out of memory";
+    return br;
+  }
+  for(unsigned i = 0 ; i < iterations ; ++i){
+    uint64_t t0 = ns_now();
+    if(fxn(nc, i)){
+      br.skipped = "benchmark failed";
+      break;
+    }
+    br.samples[br.count++] = ns_now() - t0;
+  }
+  ncplane_erase(notcurses_stdplane(nc));
+  return br;
+}
+
+static benchresult
+bench_run_blit(struct notcurses* nc, const blitbench* bb, struct ncvisual* ncv,
+               unsigned iterations){
+  benchresult br = { .name = bb->name, };
+  if(ncv == NULL){
+    br.skipped = "couldn't create visual";
+    return br;
+  }
+  if(bb->blitter == NCBLIT_PIXEL && notcurses_check_pixel_support(nc) == NCPIXEL_NONE){
+    br.skipped = "no bitmap graphics support";
+    return br;
+  }
+  if((br.samples = malloc(sizeof(*br.samples) * iterations)) == NULL){
+    br.skipped = "out of memory";
+    return br;
+  }
+  for(unsigned i = 0 ; i < iterations ; ++i){
+    uint64_t t0 = ns_now();
+    if(bench_blit(nc, ncv, bb->blitter)){
+      br.skipped = "blitter unavailable";
+      break;
+    }
+    br.samples[br.count++] = ns_now() - t0;
+  }
+  return br;
+}
+
+static void
+emit_json(FILE* fp, benchresult* results, unsigned count, unsigned iterations,
+          unsigned dimy, unsigned dimx, int pixel){
+  fprintf(fp, "{\n  \"notcurses\": \"%s\",\n", notcurses_version());
+  fprintf(fp, "  \"iterations\": %u,\n  \"rows\": %u,\n  \"cols\": %u,\n",
+          iterations, dimy, dimx);
+  fprintf(fp, "  \"pixel\": \"%s\",\n  \"benchmarks\": [\n",
+          pixel == NCPIXEL_NONE ? "none" :
+          pixel == NCPIXEL_SIXEL ? "sixel" :
+          pixel == NCPIXEL_LINUXFB ? "linuxfb" :
+          pixel == NCPIXEL_LINUXDRM ? "linuxdrm" : "kitty");
+  for(unsigned r = 0 ; r < count ; ++r){
+    benchresult* br = &results[r];
+    fprintf(fp, "    { \"name\": \"%s\", ", br->name);
+    if(br->skipped && br->count == 0){
+      fprintf(fp, "\"skipped\": \"%s\" }", br->skipped);
+    }else{
+      uint64_t sum = 0;
+      for(unsigned s = 0 ; s < br->count ; ++s){
+        sum += br->samples[s];
+      }
+      qsort(br->samples, br->count, sizeof(*br->samples), u64cmp);
+      fprintf(fp, "\"samples\": %u, \"mean_ns\": %llu, \"p50_ns\": %llu, "
+              "\"p99_ns\": %llu, \"max_ns\": %llu", br->count,
+              (unsigned long long)(sum / br->count),
+              (unsigned long long)percentile(br->samples, br->count, 50),
+              (unsigned long long)percentile(br->samples, br->count, 99),
+              (unsigned long long)br->samples[br->count - 1]);
+      if(br->skipped){
+        fprintf(fp, ", \"error\": \"%s\"", br->skipped);
+      }
+      fprintf(fp, " }");
+    }
+    fprintf(fp, "%s\n", r + 1 < count ? "," : "");
+  }
+  fprintf(fp, "  ]\n}\n");
+}
+
+static void
+usage(const char* argv0, FILE* fp){
+  fprintf(fp, "usage: %s [ -h ] [ -t ] [ -i iterations ]\n", argv0);
+  fprintf(fp, " -t: render to the terminal rather than /dev/null\n");
+  fprintf(fp, " -i: iterations per benchmark (default %d)\n", DEFAULT_ITERATIONS);
+  exit(fp == stdout ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+int main(int argc, char** argv){
+  unsigned iterations = DEFAULT_ITERATIONS;
+  bool useterm = false;
+  int c;
+  while((c = getopt(argc, argv, "hti:")) != -1){
+    switch(c){
+      case 'h': usage(argv[0], stdout); break;
+      case 't': useterm = true; break;
+      case 'i':{
+        char* end;
+        unsigned long l = strtoul(optarg, &end, 10);
+        if(!*optarg || *end || l == 0 || l > 1000000){
+          usage(argv[0], stderr);
+        }
+        iterations = l;
+        break;
+      }default: usage(argv[0], stderr); break;
+    }
+  }
+  if(optind < argc){
+    usage(argv[0], stderr);
+  }
+  FILE* out = fopen(useterm ? "/dev/tty" : "/dev/null", "w");
+  if(out == NULL){
+    fprintf(stderr, "couldn't open output (%s)\n", strerror(errno));
+    return EXIT_FAILURE;
+  }
+  // input is decoded from stdin, so replace it with a pipe we can feed
+  int feedfd = -1;
+  int fds[2];
+  if(pipe(fds) == 0){
+    if(dup2(fds[0], STDIN_FILENO) >= 0){
+      feedfd = fds[1];
+    }else{
+      close(fds[1]);
+    }
+    close(fds[0]);
+  }
+  struct notcurses_options opts = {
+    .flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_ALTERNATE_SCREEN
+             | NCOPTION_NO_CLEAR_BITMAPS | NCOPTION_NO_QUIT_SIGHANDLERS,
+  };
+  struct notcurses* nc = notcurses_init(&opts, out);
+  if(nc == NULL){
+    fclose(out);
+    return EXIT_FAILURE;
+  }
+  unsigned dimy, dimx;
+  notcurses_stddim_yx(nc, &dimy, &dimx);
+  const int pixel = notcurses_check_pixel_support(nc);
+  benchresult results[5 + sizeof(blitbenches) / sizeof(*blitbenches)];
+  unsigned rcount = 0;
+  results[rcount++] = bench_run(nc, "plane_churn", bench_plane_churn, iterations);
+  results[rcount++] = bench_run(nc, "text_fill", bench_text_fill, iterations);
+  results[rcount++] = bench_run(nc, "gradient_fill", bench_gradient_fill, iterations);
+  results[rcount++] = bench_run(nc, "scrolling", bench_scrolling, iterations);
+  unsigned pxy, pxx;
+  ncplane_pixel_geom(notcurses_stdplane(nc), &pxy, &pxx, NULL, NULL, NULL, NULL);
+  if(pxy == 0 || pxx == 0){ // no pixel geometry without a terminal
+    pxy = dimy * 20;
+    pxx = dimx * 10;
+  }
+  uint32_t* rgba = synth_rgba(pxy, pxx);
+  struct ncvisual* ncv = rgba ? ncvisual_from_rgba(rgba, pxy, pxx * 4, pxx) : NULL;
+  free(rgba);
+  for(unsigned b = 0 ; b < sizeof(blitbenches) / sizeof(*blitbenches) ; ++b){
+    results[rcount++] = bench_run_blit(nc, &blitbenches[b], ncv, iterations);
+  }
+  ncvisual_destroy(ncv);
+  results[rcount++] = bench_input(nc, feedfd, iterations);
+  int ret = notcurses_stop(nc) ? EXIT_FAILURE : EXIT_SUCCESS;
+  fclose(out);
+  emit_json(stdout, results, rcount, iterations, dimy, dimx, pixel);
+  for(unsigned r = 0 ; r < rcount ; ++r){
+    free(results[r].samples);
+  }
+  return ret;
+}
@@ -270,7 +270,9 @@ int box_demo(struct notcurses* nc, uint64_t startns){
       ++x;
     }
     DEMO_RENDER(nc);
-    nanosleep(&iterdelay, NULL);
+    if(!benchframes){
+      nanosleep(&iterdelay, NULL);
+    }
   }
   for(unsigned s = 0 ; s < sizeof(ships) / sizeof(*ships) ; ++s){
     ncplane_destroy(ships[s].n);
@@ -54,6 +54,52 @@ struct timespec demodelay = {
   .tv_nsec = 0,
 };
 
+unsigned benchframes;
+static unsigned benchwarmup = 10; // unmeasured frames preceding benchframes
+// every demo starts from the same PRNG state, whatever ran before it
+static const unsigned BENCH_SEED = 1;
+
+// benchmark state for the demo being run
+static demoresult* benchresult;
+static unsigned benchseen;    // frames rendered so far, including warmup
+static uint64_t benchstartns; // when the warmup ended
+static ncstats benchprev;     // stats as of the previous frame
+
+static inline unsigned
+hist_bucket(uint64_t ns){
+  unsigned b = 0;
+  while(ns >>= 1u){
+    ++b;
+  }
+  return b < DEMO_HISTBUCKETS ? b : DEMO_HISTBUCKETS - 1;
+}
+
+int bench_frame(struct notcurses* nc){
+  if(!benchframes || !benchresult){
+    return 0;
+  }
+  if(benchseen >= benchwarmup + benchframes){
+    return 1; // the demo ignored our earlier cutoff
+  }
+  if(++benchseen <= benchwarmup){
+    // measure from here. stats are taken from the end of the previous demo,
+    // so drop those of the warmup.
+    if(benchseen == benchwarmup){
+      notcurses_stats_reset(nc, NULL);
+      memset(&benchprev, 0, sizeof(benchprev));
+      benchstartns = clock_getns(CLOCK_MONOTONIC);
+    }
+    return 0;
+  }
+  ncstats cur;
+  notcurses_stats(nc, &cur);
+  ++benchresult->renderhist[hist_bucket(cur.render_ns - benchprev.render_ns)];
+  ++benchresult->rasterhist[hist_bucket(cur.raster_ns - benchprev.raster_ns)];
+  ++benchresult->writehist[hist_bucket(cur.writeout_ns - benchprev.writeout_ns)];
+  benchprev = cur;
+  return benchseen == benchwarmup + benchframes;
+}
+
 // the "jungle" demo has non-free material embedded into it, and is thus
 // entirely absent (can't just be disabled). supply a stub here.
 #ifdef DFSG_BUILD
@@ -135,7 +181,8 @@ usage(const char* exe, int status){
   ncplane_set_fg_rgb8(n, 0x80, 0xff, 0x80);
   ncplane_printf(n, "%s ", exe);
   const char* options[] = { "-hVkc", "-m margins", "-p path", "-l loglevel",
-                            "-d mult", "-J jsonfile", "demospec",
+                            "-d mult", "-J jsonfile", "-b frames",
+                            "-w frames", "demospec",
                             NULL };
   for(const char** op = options ; *op ; ++op){
     usage_option(n, *op);
@@ -149,6 +196,8 @@ usage(const char* exe, int status){
     "-d", "delay multiplier (non-negative float)",
     "-J", "emit JSON summary to file",
     "-c", "constant PRNG seed, useful for benchmarking",
+    "-b", "benchmark this many frames per demo, without sleeps",
+    "-w", "warmup frames per demo when benchmarking (default 10)",
     "-m", "margin, or 4 comma-separated margins",
     NULL
   };
@@ -222,11 +271,27 @@ ext_demos(struct notcurses* nc, const char* spec){
     uint64_t stdc = NCCHANNELS_INITIALIZER(0, 0, 0, 0, 0, 0);
     ncplane_set_base(n, "", 0, stdc);
 
+    if(benchframes){
+      srand(BENCH_SEED);
+      benchresult = &results[i];
+      benchseen = 0;
+      benchstartns = prevns;
+      memset(&benchprev, 0, sizeof(benchprev));
+    }
     hud_schedule(demos[idx].name, prevns);
     ret = demos[idx].fxn(nc, prevns);
     notcurses_stats_reset(nc, &results[i].stats);
     uint64_t nowns = clock_getns(CLOCK_MONOTONIC);
-    results[i].timens = nowns - prevns;
+    if(benchframes){
+      // running out of frames is how a benchmarked demo ought end
+      if(ret > 0 && benchseen >= benchwarmup + benchframes && !interrupted){
+        ret = 0;
+      }
+      results[i].timens = nowns - benchstartns;
+      benchresult = NULL;
+    }else{
+      results[i].timens = nowns - prevns;
+    }
     prevns = nowns;
     results[i].result = ret;
     hud_completion_notify(&results[i]);
@@ -251,7 +316,7 @@ handle_opts(int argc, char** argv, notcurses_options* opts, FILE** json_output){
     { .name = NULL, .has_arg = 0, .flag = NULL, .val = 0, },
   };
   int lidx;
-  while((c = getopt_long(argc, argv, "VhckJ:l:d:p:m:", longopts, &lidx)) != EOF){
+  while((c = getopt_long(argc, argv, "VhckJ:l:d:p:m:b:w:", longopts, &lidx)) != EOF){
     switch(c){
       case 'h':
         usage(*argv, EXIT_SUCCESS);
@@ -293,6 +358,19 @@ handle_opts(int argc, char** argv, notcurses_options* opts, FILE** json_output){
       case 'c':
         constant_seed = true;
         break;
+      case 'b':
+        if(sscanf(optarg, "%u", &benchframes) != 1 || benchframes == 0){
+          fprintf(stderr, "Invalid benchmark frame count: %s\n", optarg);
+          usage(*argv, EXIT_FAILURE);
+        }
+        constant_seed = true;
+        break;
+      case 'w':
+        if(sscanf(optarg, "%u", &benchwarmup) != 1){
+          fprintf(stderr, "Invalid warmup frame count: %s\n", optarg);
+          usage(*argv, EXIT_FAILURE);
+        }
+        break;
       case 'k':
         opts->flags |= NCOPTION_NO_ALTERNATE_SCREEN;
         break;
@@ -370,18 +448,45 @@ table_printf(struct ncplane* n, const char* delim, const char* fmt, ...){
   return r;
 }
 
+// a histogram as an object mapping each nonempty bucket's lower bound in ns
+// to its frame count.
+static int
+hist_json(FILE* f, const char* name, const uint64_t* hist){
+  int ret = (fprintf(f, ",\"%s\":{", name) < 0);
+  const char* sep = "";
+  for(unsigned b = 0 ; b < DEMO_HISTBUCKETS ; ++b){
+    if(hist[b]){
+      ret |= (fprintf(f, "%s\"%"PRIu64"\":\"%"PRIu64"\"", sep, (uint64_t)1 << b, hist[b]) < 0);
+      sep = ",";
+    }
+  }
+  ret |= (fprintf(f, "}") < 0);
+  return ret;
+}
+
 static int
 summary_json(FILE* f, const char* spec, int rows, int cols){
   int ret = 0;
-  ret |= (fprintf(f, "{\"notcurses-demo\":{\"spec\":\"%s\",\"TERM\":\"%s\",\"rows\":\"%d\",\"cols\":\"%d\",\"runs\":{",
+  ret |= (fprintf(f, "{\"notcurses-demo\":{\"spec\":\"%s\",\"TERM\":\"%s\",\"rows\":\"%d\",\"cols\":\"%d\",",
                   spec, getenv("TERM"), rows, cols) < 0);
+  if(benchframes){
+    ret |= (fprintf(f, "\"bench\":{\"frames\":\"%u\",\"warmup\":\"%u\",\"seed\":\"%u\"},",
+                    benchframes, benchwarmup, BENCH_SEED) < 0);
+  }
+  ret |= (fprintf(f, "\"runs\":{") < 0);
   for(size_t i = 0 ; i < strlen(spec) ; ++i){
     if(results[i].result || !results[i].stats.renders){
       continue;
     }
-    ret |= (fprintf(f, "\"%s\":{\"bytes\":\"%"PRIu64"\",\"frames\":\"%"PRIu64"\",\"ns\":\"%"PRIu64"\"}%s",
+    ret |= (fprintf(f, "\"%s\":{\"bytes\":\"%"PRIu64"\",\"frames\":\"%"PRIu64"\",\"ns\":\"%"PRIu64"\"",
                     demos[results[i].selector - 'a'].name, results[i].stats.raster_bytes,
-                    results[i].stats.renders, results[i].timens, i < strlen(spec) - 1 ? "," : "") < 0);
+                    results[i].stats.renders, results[i].timens) < 0);
+    if(benchframes){
+      ret |= hist_json(f, "render", results[i].renderhist);
+      ret |= hist_json(f, "raster", results[i].rasterhist);
+      ret |= hist_json(f, "write", results[i].writehist);
+    }
+    ret |= (fprintf(f, "}%s", i < strlen(spec) - 1 ? "," : "") < 0);
   }
   ret |= (fprintf(f, "}}}\n") < 0);
   return ret;
@@ -19,6 +19,12 @@ extern "C" {
 extern struct timespec demodelay;
 extern float delaymultiplier; // scales demodelay (applied internally)
 
+// configured via command line option -- frames measured per demo when
+// benchmarking (-b), otherwise 0. while benchmarking, the PRNG is reseeded
+// before each demo, demo_nanosleep() and friends return immediately, and
+// demo_render() aborts the demo once its frames are used up.
+extern unsigned benchframes;
+
 // checked in demo_render() and between demos
 extern atomic_bool interrupted;
 
@@ -183,13 +189,26 @@ int hud_grab(int y, int x);
 // release the hud
 int hud_release(void);
 
+// per-frame histograms have power-of-two buckets: bucket i counts frames
+// taking [2^i, 2^(i + 1)) ns (bucket 0 also gets 0ns; the last, the rest).
+#define DEMO_HISTBUCKETS 40
+
 typedef struct demoresult {
   char selector;
   struct ncstats stats;
   uint64_t timens;
   int result; // positive == aborted, negative == failed
+  // only filled in when benchmarking
+  uint64_t renderhist[DEMO_HISTBUCKETS];
+  uint64_t rasterhist[DEMO_HISTBUCKETS];
+  uint64_t writehist[DEMO_HISTBUCKETS];
 } demoresult;
 
+// called by demo_render() following each successful frame. when
+// benchmarking, records the frame, and returns non-zero once the demo has
+// used up its frames. otherwise, returns 0.
+int bench_frame(struct notcurses* nc);
+
 // let the HUD know that a demo has completed, reporting the stats
 int hud_completion_notify(const demoresult* result);
 
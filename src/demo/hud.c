@@ -543,6 +543,9 @@ demo_nanosleep_abstime_ns(struct notcurses* nc, uint64_t deadline){
   struct timespec fsleep;
   struct timespec now;
 
+  if(benchframes){ // benchmarks measure frames, not sleeps
+    return 0;
+  }
   clock_gettime(CLOCK_MONOTONIC, &now);
   while(deadline > timespec_to_ns(&now)){
     fsleep.tv_sec = 0;
@@ -644,7 +647,7 @@ int demo_render(struct notcurses* nc){
   if(id == 'q'){
     return 1;
   }
-  return 0;
+  return bench_frame(nc) ? 1 : 0;
 }
 
 int fpsgraph_init(struct notcurses* nc){
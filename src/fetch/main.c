@@ -533,7 +533,7 @@ newline_past(struct ncplane* std, struct ncplane* p){
   return 0;
 }
 
-static int
+static struct ncplane*
 infoplane_notcurses(struct notcurses* nc, const fetched_info* fi,
                     int planeheight, int nextline){
   const int planewidth = 72;
@@ -550,7 +550,7 @@ infoplane_notcurses(struct notcurses* nc, const fetched_info* fi,
   };
   struct ncplane* infop = ncplane_create(std, &nopts);
   if(infop == NULL){
-    return -1;
+    return NULL;
   }
   ncplane_set_fg_rgb8(infop, 0xd0, 0xd0, 0xd0);
   ncplane_set_styles(infop, NCSTYLE_UNDERLINE);
@@ -603,7 +603,7 @@ infoplane_notcurses(struct notcurses* nc, const fetched_info* fi,
   nccell ll = NCCELL_TRIVIAL_INITIALIZER, lr = NCCELL_TRIVIAL_INITIALIZER;
   nccell hl = NCCELL_TRIVIAL_INITIALIZER, vl = NCCELL_TRIVIAL_INITIALIZER;
   if(nccells_rounded_box(infop, 0, 0, &ul, &ur, &ll, &lr, &hl, &vl)){
-    return -1;
+    return NULL;
   }
   nccell_set_fg_rgb8(&ul, 0x90, 0x90, 0x90);
   nccell_set_fg_rgb8(&ur, 0x90, 0x90, 0x90);
@@ -611,7 +611,7 @@ infoplane_notcurses(struct notcurses* nc, const fetched_info* fi,
   nccell_set_fg_rgb8(&lr, 0, 0, 0);
   unsigned ctrlword = NCBOXGRAD_BOTTOM | NCBOXGRAD_LEFT | NCBOXGRAD_RIGHT;
   if(ncplane_perimeter(infop, &ul, &ur, &ll, &lr, &hl, &vl, ctrlword)){
-    return -1;
+    return NULL;
   }
   ncplane_home(infop);
   uint64_t channels = 0;
@@ -625,7 +625,7 @@ infoplane_notcurses(struct notcurses* nc, const fetched_info* fi,
   ncplane_set_styles(infop, NCSTYLE_BOLD);
   if(ncplane_printf_aligned(infop, 0, NCALIGN_CENTER, "[ %s@%s ]",
                             fi->username, fi->hostname) < 0){
-    return -1;
+    return NULL;
   }
   ncchannels_set_fg_rgb8(&channels, 0, 0, 0);
   ncchannels_set_bg_rgb8(&channels, 0x50, 0x50, 0x50);
@@ -638,24 +638,25 @@ infoplane_notcurses(struct notcurses* nc, const fetched_info* fi,
   }
   newline_past(std, infop);
   if(notcurses_render(nc)){
-    return -1;
+    return NULL;
   }
-  return 0;
+  return infop;
 }
 
-static int
+static struct ncplane*
 infoplane(struct notcurses* nc, const fetched_info* fi, int nextline){
   const int planeheight = 7;
-  int r = infoplane_notcurses(nc, fi, planeheight, nextline);
-  return r;
+  return infoplane_notcurses(nc, fi, planeheight, nextline);
 }
 
+// the probes run concurrently with one another, and with drawing the
+// palette. each writes only its own fields of the fetched_info.
 struct marshal {
-  int nextline; // line following display plane, where info plane ought be placed
-  struct notcurses* nc;
-  const distro_info* dinfo;
-  const char* logo; // read from /etc/os-release (or builtin), may be NULL
-  const char* neologo; // fallback from neofetch, text with color sub templates
+  fetched_info* fi;
+  ncneo_kernel_e kern;       // detected before the probes are launched
+  const char* logo;          // bitmap logo to decode, if any
+  unsigned minpixy, minpixx; // the logo may be reduced to these when decoded
+  struct ncvisual* ncv;      // decoded bitmap logo, or NULL
 };
 
 // present a neofetch-style logo. we want to substitute colors for ${cN} inline
@@ -711,117 +712,173 @@ neologo_present(struct notcurses* nc, const char* nlogo){
   return 0;
 }
 
+// kernel and distribution, which determine the logo
 static void*
-display_thread(void* vmarshal){
+distro_thread(void* vmarshal){
   struct marshal* m = vmarshal;
-  drawpalette(m->nc);
-  notcurses_render(m->nc);
-  ncplane_set_bg_default(notcurses_stdplane(m->nc));
-  ncplane_set_fg_default(notcurses_stdplane(m->nc));
-  // we've just rendered, so any necessary scrolling has been performed. draw
-  // our image wherever the palette ended, and then scroll as necessary to
-  // make that new plane visible.
-  if(notcurses_canopen_images(m->nc)){
-    struct ncvisual* ncv = NULL;
-    if(m->logo){
-      ncv = ncvisual_from_file(m->logo);
-    }else if(m->dinfo && m->dinfo->logofile){
-      ncv = ncvisual_from_file(m->dinfo->logofile);
-    }
-    if(ncv){
-      unsigned y;
-      ncplane_cursor_yx(notcurses_stdplane_const(m->nc), &y, NULL);
-      bool pixeling = false;
-      if(notcurses_check_pixel_support(m->nc) >= 1){
-        pixeling = true;
-      }
-      struct ncvisual_options vopts = {
-        .n = notcurses_stdplane(m->nc),
-        .y = y,
-        .x = NCALIGN_CENTER,
-        .blitter = pixeling ? NCBLIT_PIXEL : NCBLIT_3x2,
-        .scaling = pixeling ? NCSCALE_NONE : NCSCALE_SCALE_HIRES,
-        .flags = NCVISUAL_OPTION_HORALIGNED | NCVISUAL_OPTION_CHILDPLANE,
-      };
-      struct ncplane* iplane = ncvisual_blit(m->nc, ncv, &vopts);
-      ncvisual_destroy(ncv);
-      if(iplane){
-        ncplane_scrollup_child(notcurses_stdplane(m->nc), iplane);
-        newline_past(notcurses_stdplane(m->nc), iplane);
-        notcurses_render(m->nc);
-        m->nextline = ncplane_y(iplane) + ncplane_dim_y(iplane);
-        return NULL;
-      }
-    }
-  }
-  if(m->neologo){
-    if(neologo_present(m->nc, m->neologo) == 0){
-      unsigned nl;
-      ncplane_cursor_yx(notcurses_stdplane(m->nc), &nl, NULL);
-      m->nextline = nl;
-      return NULL;
-    }
-  }
-  unsigned nl;
-  ncplane_cursor_yx(notcurses_stdplane(m->nc), &nl, NULL);
-  m->nextline = nl;
-  return NULL;
-}
-
-static int
-ncneofetch(struct notcurses* nc){
-  fetched_info fi = {0};
-  ncneo_kernel_e kern = get_kernel(&fi);
-  switch(kern){
+  fetched_info* fi = m->fi;
+  switch(m->kern){
     case NCNEO_LINUX:
-      fi.distro = linux_ncneofetch(&fi);
+      fi->distro = linux_ncneofetch(fi);
       break;
     case NCNEO_FREEBSD:
-      fi.distro = freebsd_ncneofetch(&fi);
+      fi->distro = freebsd_ncneofetch(fi);
       break;
     case NCNEO_DRAGONFLY:
-      fi.distro = dragonfly_ncneofetch(&fi);
+      fi->distro = dragonfly_ncneofetch(fi);
       break;
     case NCNEO_XNU:
-      fi.distro = xnu_ncneofetch(&fi);
+      fi->distro = xnu_ncneofetch(fi);
       break;
     case NCNEO_WINDOWS:
-      fi.distro = windows_ncneofetch(&fi);
+      fi->distro = windows_ncneofetch(fi);
       break;
     case NCNEO_UNKNOWN:
       break;
   }
-  // go ahead and spin the image load + render into its own thread while the
-  // rest of the fetching continues. cuts total runtime.
-  struct marshal display_marshal = {
-    .nc = nc,
-    .dinfo = fi.distro,
-    .logo = fi.logo,
-    .neologo = fi.neologo,
-    .nextline = -1,
+  return NULL;
+}
+
+static void*
+cpu_thread(void* vmarshal){
+  struct marshal* m = vmarshal;
+  if(m->kern == NCNEO_LINUX){
+    fetch_cpu_info(m->fi);
+  }else if(m->kern == NCNEO_WINDOWS){
+    fetch_windows_cpuinfo(m->fi);
+  }else{
+    fetch_bsd_cpuinfo(m->fi);
+  }
+  return NULL;
+}
+
+// the bitmap logo, if we have one we can read. it's checked up front so that
+// a missing file falls back to the neofetch logo before the info plane.
+static const char*
+logo_file(const fetched_info* fi){
+  if(fi->logo){
+    return fi->logo;
+  }
+  if(fi->distro && fi->distro->logofile && access(fi->distro->logofile, R_OK) == 0){
+    return fi->distro->logofile;
+  }
+  return NULL;
+}
+
+static bool
+logo_pixeling(struct notcurses* nc){
+  return notcurses_check_pixel_support(nc) >= 1;
+}
+
+// decode only, reducing the image to no less than we'll draw. blitting (and
+// everything else touching the notcurses context) stays on the main thread.
+static void*
+logo_thread(void* vmarshal){
+  struct marshal* m = vmarshal;
+  m->ncv = ncvisual_from_file_sized(m->logo, m->minpixy, m->minpixx);
+  return NULL;
+}
+
+// the most pixels the logo can use: the whole screen when drawn as a bitmap
+// (it isn't scaled), or the 3x2 blitter's share of each cell otherwise.
+static void
+logo_geom(struct notcurses* nc, unsigned* minpixy, unsigned* minpixx){
+  const struct ncplane* std = notcurses_stdplane_const(nc);
+  if(logo_pixeling(nc)){
+    ncplane_pixel_geom(std, minpixy, minpixx, NULL, NULL, NULL, NULL);
+  }else{
+    ncplane_dim_yx(std, minpixy, minpixx);
+    *minpixy *= 3;
+    *minpixx *= 2;
+  }
+}
+
+// blit the decoded logo where the info plane sits, and move the info plane
+// down below it, scrolling as necessary to make it visible.
+static int
+logo_insert(struct notcurses* nc, struct ncvisual* ncv, struct ncplane* infop){
+  struct ncplane* std = notcurses_stdplane(nc);
+  const bool pixeling = logo_pixeling(nc);
+  struct ncvisual_options vopts = {
+    .n = std,
+    .y = ncplane_y(infop),
+    .x = NCALIGN_CENTER,
+    .blitter = pixeling ? NCBLIT_PIXEL : NCBLIT_3x2,
+    .scaling = pixeling ? NCSCALE_NONE : NCSCALE_SCALE_HIRES,
+    .flags = NCVISUAL_OPTION_HORALIGNED | NCVISUAL_OPTION_CHILDPLANE,
+  };
+  struct ncplane* iplane = ncvisual_blit(nc, ncv, &vopts);
+  if(iplane == NULL){
+    return -1;
+  }
+  if(ncplane_move_yx(infop, ncplane_y(iplane) + ncplane_dim_y(iplane), ncplane_x(infop))){
+    return -1;
+  }
+  ncplane_scrollup_child(std, infop);
+  newline_past(std, infop);
+  return notcurses_render(nc);
+}
+
+static int
+ncneofetch(struct notcurses* nc){
+  fetched_info fi = {0};
+  struct marshal m = {
+    .fi = &fi,
+    .kern = get_kernel(&fi),
   };
-  pthread_t tid;
-  const bool launched = !pthread_create(&tid, NULL, display_thread, &display_marshal);
+  // run the probes in their own threads while we draw the palette, falling
+  // back to running them here if they can't be launched.
+  pthread_t distrotid, cputid, logotid;
+  const bool distrolaunched = !pthread_create(&distrotid, NULL, distro_thread, &m);
+  const bool cpulaunched = !pthread_create(&cputid, NULL, cpu_thread, &m);
   fi.hostname = notcurses_hostname();
   fi.username = notcurses_accountname();
   fetch_env_vars(nc, &fi);
-  if(kern == NCNEO_LINUX){
-    fetch_cpu_info(&fi);
-  }else if(kern == NCNEO_WINDOWS){
-    fetch_windows_cpuinfo(&fi);
+  struct ncplane* std = notcurses_stdplane(nc);
+  drawpalette(nc);
+  notcurses_render(nc);
+  ncplane_set_bg_default(std);
+  ncplane_set_fg_default(std);
+  if(distrolaunched){
+    pthread_join(distrotid, NULL);
   }else{
-    fetch_bsd_cpuinfo(&fi);
+    distro_thread(&m);
+  }
+  // decoding a bitmap logo is the slowest part of the whole affair. rather
+  // than wait on it, we show the info plane, and slip the logo in above it
+  // once it's ready.
+  bool logolaunched = false;
+  if(notcurses_canopen_images(nc) && (m.logo = logo_file(&fi))){
+    logo_geom(nc, &m.minpixy, &m.minpixx);
+    if(!(logolaunched = !pthread_create(&logotid, NULL, logo_thread, &m))){
+      logo_thread(&m);
+    }
+  }else if(fi.neologo){
+    neologo_present(nc, fi.neologo);
   }
-  if(launched){
-    pthread_join(tid, NULL);
+  if(cpulaunched){
+    pthread_join(cputid, NULL);
+  }else{
+    cpu_thread(&m);
   }
-  assert(display_marshal.nextline >= 0);
-  if(infoplane(nc, &fi, display_marshal.nextline)){
-    free_fetched_info(&fi);
-    return -1;
+  unsigned nextline;
+  ncplane_cursor_yx(std, &nextline, NULL);
+  struct ncplane* infop = infoplane(nc, &fi, nextline);
+  if(logolaunched){
+    pthread_join(logotid, NULL);
   }
+  int ret = 0;
+  if(infop == NULL){
+    ret = -1;
+  }else if(m.ncv){
+    ret = logo_insert(nc, m.ncv, infop);
+  }
+  ncvisual_destroy(m.ncv);
   free_fetched_info(&fi);
-  return notcurses_stop(nc);
+  if(notcurses_stop(nc) || ret){
+    return -1;
+  }
+  return 0;
 }
 
 static void
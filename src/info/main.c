@@ -276,7 +276,7 @@ unicodedumper(struct notcurses* nc, struct ncplane* n, const char* indent){
     ncplane_printf(n, "%s%ls⎧", indent, NCQUADBLOCKS);
     // 🯰🯱🯲🯳🯴🯵🯶🯷🯸🯹 (on Windows, these will be encoded as UTF-16 surrogate
     // pairs due to a 16-bit wchar_t.
-    sex_viz(n, NCSEXBLOCKS, L'⎫', L"♠♥" NCSEGDIGITS L"\u2157\u2158\u2159\u215a\u215b");
+    sex_viz(n, &NCSEXBLOCKS[1], L'⎫', L"♠♥" NCSEGDIGITS L"\u2157\u2158\u2159\u215a\u215b");
     vertviz(n, L'⎧', NCEIGHTHSR[0], NCEIGHTHSL[0], L'⎫', L"┌╥─╥─╥┐🭩⎛⎞");
     ncplane_printf(n, "%s╲╿╱ ◨◧ ◪◩ ◖◗ ⫷⫸ ⎩", indent);
     sex_viz(n, &NCSEXBLOCKS[32], L'⎭', L"♦♣\u00bc\u00bd\u00be\u2150\u2151\u2152\u2153\u2154\u2155\u2156\u215c\u215d\u215e\u215f\u2189");
@@ -411,6 +411,9 @@ tinfo_debug_bitmaps(struct ncplane* n, const tinfo* ti, const char* indent){
     case NCPIXEL_LINUXFB:
       ncplane_printf(n, "%sframebuffer graphics supported", indent);
       break;
+    case NCPIXEL_LINUXDRM:
+      ncplane_printf(n, "%sDRM overlay graphics supported", indent);
+      break;
     case NCPIXEL_ITERM2:
       ncplane_printf(n, "%siTerm2 graphics supported", indent);
       break;
@@ -423,6 +426,14 @@ tinfo_debug_bitmaps(struct ncplane* n, const tinfo* ti, const char* indent){
     case NCPIXEL_KITTY_SELFREF:
       ncplane_printf(n, "%s2nd gen rgba pixel animation support", indent);
       break;
+    case NCPIXEL_KITTY_PLACEHOLDER:
+      ncplane_printf(n, "%srgba pixel placeholder support", indent);
+      break;
+  }
+  if(blit == NCPIXEL_KITTY_ANIMATED || blit == NCPIXEL_KITTY_SELFREF ||
+     blit == NCPIXEL_KITTY_PLACEHOLDER){
+    ncplane_printf(n, " (%s)", ti->kittytransport == KITTY_TRANSPORT_SHM ? "shm" :
+                   ti->kittytransport == KITTY_TRANSPORT_FILE ? "file" : "direct");
   }
   finish_line(n);
 }
@@ -441,6 +452,8 @@ tinfo_debug_caps(struct ncplane* n, const tinfo* ti, const char* indent){
   tinfo_debug_cap(n, "bgop", get_escape(ti, ESCAPE_BGOP));
   tinfo_debug_cap(n, "bce", ti->bce);
   tinfo_debug_cap(n, "rect", get_escape(ti, ESCAPE_DECERA));
+  tinfo_debug_cap(n, "rep", get_escape(ti, ESCAPE_REP));
+  tinfo_debug_cap(n, "ech", get_escape(ti, ESCAPE_ECH));
   finish_line(n);
 }
 
@@ -472,6 +485,80 @@ tinfo_debug_styles(const notcurses* nc, struct ncplane* n, const char* indent){
   finish_line(n);
 }
 
+// milliseconds from milestone |a| to milestone |b|, or 0 if either was missed
+static double
+startup_ms(const tinfo* ti, startup_milestone_e a, startup_milestone_e b){
+  if(ti->startupns[a] == 0 || ti->startupns[b] == 0 ||
+     ti->startupns[b] < ti->startupns[a]){
+    return 0;
+  }
+  return (ti->startupns[b] - ti->startupns[a]) / 1000000.0;
+}
+
+// print |s|, first moving to a new (indented) line if it won't fit in 80
+static void
+startup_token(struct ncplane* n, const char* s, const char* indent){
+  unsigned x;
+  ncplane_cursor_yx(n, NULL, &x);
+  if(x + strlen(s) > 79){
+    finish_line(n);
+    ncplane_printf(n, "%s ", indent);
+  }
+  ncplane_putstr(n, s);
+}
+
+// break down where notcurses_init() spent its time, and when each kind of
+// reply to our initial queries arrived, relative to the queries being sent.
+static void
+tinfo_debug_startup(struct ncplane* n, const tinfo* ti, const char* indent,
+                    uint64_t initns){
+  ncplane_set_styles(n, NCSTYLE_BOLD);
+  ncplane_printf(n, "%sstartup:", indent);
+  ncplane_set_styles(n, NCSTYLE_NONE);
+  ncplane_printf(n, " %.2fms in notcurses_init(), %.2fms interrogating",
+                 initns / 1000000.0, startup_ms(ti, STARTUP_BEGIN, STARTUP_DONE));
+  finish_line(n);
+  const struct {
+    const char* name;
+    startup_milestone_e from, to;
+  } phases[] = {
+    { "queries", STARTUP_BEGIN, STARTUP_QUERIES, },
+    { "terminfo", ti->startupns[STARTUP_QUERIES] ? STARTUP_QUERIES : STARTUP_BEGIN, STARTUP_TERMINFO, },
+    { "input", STARTUP_TERMINFO, STARTUP_INPUT, },
+    { "lookups", STARTUP_INPUT, STARTUP_LOOKUPS, },
+    { "other", STARTUP_LOOKUPS, STARTUP_AWAIT, },
+    { "replies", STARTUP_AWAIT, STARTUP_REPLIES, },
+    { "font", STARTUP_FONTBEGIN, STARTUP_FONTEND, },
+    { "heuristics", STARTUP_REPLIES, STARTUP_DONE, },
+  };
+  ncplane_printf(n, "%s", indent);
+  for(size_t i = 0 ; i < sizeof(phases) / sizeof(*phases) ; ++i){
+    char buf[64];
+    snprintf(buf, sizeof(buf), " %s %.2fms", phases[i].name,
+             startup_ms(ti, phases[i].from, phases[i].to));
+    startup_token(n, buf, indent);
+  }
+  finish_line(n);
+  ncplane_printf(n, "%sreplies (ms after queries):", indent);
+  if(ti->replycount == 0){
+    startup_token(n, " none (termcache, or no terminal)", indent);
+  }
+  const uint64_t sentns = ti->startupns[STARTUP_QUERIES];
+  for(unsigned i = 0 ; i < ti->replycount ; ++i){
+    const replytime* r = &ti->replies[i];
+    const double first = r->firstns >= sentns ? (r->firstns - sentns) / 1000000.0 : 0;
+    const double last = r->lastns >= sentns ? (r->lastns - sentns) / 1000000.0 : 0;
+    char buf[80];
+    if(r->count > 1){
+      snprintf(buf, sizeof(buf), " %s %.2f-%.2f(%u)", r->what, first, last, r->count);
+    }else{
+      snprintf(buf, sizeof(buf), " %s %.2f", r->what, first);
+    }
+    startup_token(n, buf, indent);
+  }
+  finish_line(n);
+}
+
 static int
 usage(const char* base, FILE* fp, int ret){
   fprintf(fp, "usage: %s [ -v ]\n", base);
@@ -496,10 +583,13 @@ int main(int argc, const char** argv){
     }
     nopts.loglevel = NCLOGLEVEL_TRACE;
   }
+  struct timespec initstart, initend;
+  clock_gettime(CLOCK_MONOTONIC, &initstart);
   struct notcurses* nc = notcurses_init(&nopts, NULL);
   if(nc == NULL){
     return EXIT_FAILURE;
   }
+  clock_gettime(CLOCK_MONOTONIC, &initend);
   // so that we know whether we're talking to gpm
   notcurses_mice_enable(nc, NCMICE_ALL_EVENTS);
   const char indent[] = "";
@@ -519,6 +609,8 @@ int main(int argc, const char** argv){
   tinfo_debug_caps(stdn, &nc->tcache, indent);
   tinfo_debug_styles(nc, stdn, indent);
   tinfo_debug_bitmaps(stdn, &nc->tcache, indent);
+  tinfo_debug_startup(stdn, &nc->tcache, indent,
+                      timespec_to_ns(&initend) - timespec_to_ns(&initstart));
   unicodedumper(nc, stdn, indent);
   char* path = notcurses_data_path(NULL, "notcurses.png");
   if(path){
@@ -1,5 +1,6 @@
 #include <deque>
 #include <cerrno>
+#include <cinttypes>
 #include <atomic>
 #include <chrono>
 #include <memory>
@@ -7,8 +8,15 @@
 #include <cstring>
 #include <cstdlib>
 #include <clocale>
+#include <fstream>
+#include <random>
+#include <vector>
 #include <getopt.h>
 #include <iostream>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 #include <ncpp/Plane.hh>
 #include <ncpp/NotCurses.hh>
 
@@ -161,6 +169,8 @@ const char* nckeystr(char32_t spkey){
     case NCKEY_RMETA: return "right meta";
     case NCKEY_L3SHIFT: return "level 3 shift";
     case NCKEY_L5SHIFT: return "level 5 shift";
+    case NCKEY_PASTE: return "bracketed paste";
+    case NCKEY_TIMER: return "timer";
     case NCKEY_MOTION: return "mouse (no buttons pressed)";
     case NCKEY_BUTTON1: return "mouse (button 1)";
     case NCKEY_BUTTON2: return "mouse (button 2)";
@@ -409,9 +419,134 @@ int input_demo(ncpp::NotCurses* nc) {
   return 0;
 }
 
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+static inline size_t
+heap_in_use(){
+  return mallinfo2().uordblks;
+}
+#else
+static inline size_t
+heap_in_use(){
+  return 0;
+}
+#endif
+
+// feed the capture into the pipe serving as our stdin, in chunks of 'chunk'
+// bytes, or of random sizes up to 'chunk' if 'seed' is non-zero. closing the
+// pipe delivers NCKEY_EOF once everything has been processed.
+static void
+replay_feed(const std::vector<unsigned char>* cap, int fd, size_t chunk, unsigned seed){
+  std::minstd_rand rng(seed);
+  size_t off = 0;
+  while(off < cap->size()){
+    size_t len = seed ? rng() % chunk + 1 : chunk;
+    if(len > cap->size() - off){
+      len = cap->size() - off;
+    }
+    ssize_t w = write(fd, cap->data() + off, len);
+    if(w < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      std::cerr << "error writing to input pipe (" << strerror(errno) << ")\n";
+      break;
+    }
+    off += w;
+  }
+  close(fd);
+}
+
+// push a captured byte stream through the input layer as quickly as it can
+// take it, optionally dumping each event to stderr, and report throughput,
+// heap growth, and the read-to-queue latency of events.
+static int
+replay(const char* path, notcurses_options* nopts, bool nomice,
+       size_t chunk, unsigned seed, bool dump){
+  std::vector<unsigned char> cap;
+  {
+    std::ifstream in;
+    std::istream* is = &std::cin;
+    if(strcmp(path, "-")){
+      in.open(path, std::ios::binary);
+      if(!in){
+        std::cerr << "couldn't open " << path << "\n";
+        return -1;
+      }
+      is = &in;
+    }
+    cap.assign(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>());
+  }
+  int fds[2];
+  if(pipe(fds)){
+    std::cerr << "couldn't create pipe (" << strerror(errno) << ")\n";
+    return -1;
+  }
+  if(dup2(fds[0], STDIN_FILENO) < 0){
+    std::cerr << "couldn't replace stdin (" << strerror(errno) << ")\n";
+    return -1;
+  }
+  close(fds[0]);
+  nopts->flags |= NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_ALTERNATE_SCREEN;
+  NotCurses nc(*nopts);
+  if(!nomice){
+    nc.mouse_enable(NCMICE_ALL_EVENTS);
+  }
+  notcurses_paste_enable(nc, true);
+  notcurses_stats_reset(nc, nullptr);
+  const size_t heap0 = heap_in_use();
+  const uint64_t t0 = timenow_to_ns();
+  std::thread feeder(replay_feed, &cap, fds[1], chunk, seed);
+  uint64_t events = 0, mice = 0, pastes = 0;
+  ncinput ni;
+  uint32_t r;
+  while((r = notcurses_get_blocking(nc, &ni)) != (uint32_t)-1){
+    if(r == NCKEY_EOF){
+      break;
+    }
+    ++events;
+    if(NCKey::IsMouse(r)){
+      ++mice;
+    }else if(r == NCKEY_PASTE){
+      ++pastes;
+    }
+    if(dump){
+      fprintf(stderr, "%08x %02x %c %d %d %u", r, ni.modifiers, evtype_to_char(&ni),
+             ni.y, ni.x, ni.coalesced);
+      if(r == NCKEY_PASTE){
+        fprintf(stderr, " %zu", ni.pastelen);
+      }else if(ni.utf8[0]){
+        fprintf(stderr, " %s", ni.utf8);
+      }
+      fputc('\n', stderr);
+    }
+    free(ni.paste);
+  }
+  const uint64_t elapsed = timenow_to_ns() - t0;
+  const size_t heap1 = heap_in_use();
+  feeder.join();
+  ncstats stats;
+  notcurses_stats(nc, &stats);
+  nchistogram h;
+  notcurses_stats_histogram(nc, NCSTATS_HIST_INPUT, &h);
+  if(!nc.stop()){
+    return -1;
+  }
+  const double secs = elapsed / static_cast<double>(NANOSECS_IN_SEC);
+  printf("%zu bytes, %" PRIu64 " events (%" PRIu64 " mouse, %" PRIu64
+          " paste) in %.3fs: %.0f events/s, %.2f MiB/s\n",
+          cap.size(), events, mice, pastes, secs,
+          secs > 0 ? events / secs : 0, secs > 0 ? cap.size() / secs / 1048576 : 0);
+  printf("read-to-queue latency: %" PRIu64 "ns p50, %" PRIu64 "ns p99, %"
+          PRIu64 "ns max\n", nchistogram_percentile(&h, 50),
+          nchistogram_percentile(&h, 99), nchistogram_percentile(&h, 100));
+  printf("%" PRIu64 " input errors, heap grew %zd bytes\n",
+          stats.input_errors, static_cast<ssize_t>(heap1 - heap0));
+  return r == (uint32_t)-1 ? -1 : 0;
+}
+
 static void
 usage(const char* arg0, FILE* fp){
-  fprintf(fp, "usage: %s [ -v ] [ -m ]\n", arg0);
+  fprintf(fp, "usage: %s [ -v ] [ -m ] [ -r capture [ -c chunk ] [ -s seed ] [ -d ] ]\n", arg0);
   if(fp == stderr){
     exit(EXIT_FAILURE);
   }
@@ -429,12 +564,33 @@ int main(int argc, char** argv){
   nopts.margin_b = 2;
   nopts.loglevel = NCLOGLEVEL_ERROR;
   bool nomice = false;
+  const char* capture = nullptr;
+  size_t chunk = BUFSIZ;
+  unsigned seed = 0;
+  bool dump = false;
   int opt;
-  while((opt = getopt(argc, argv, "vm")) != -1){
+  while((opt = getopt(argc, argv, "vmr:c:s:d")) != -1){
     switch(opt){
       case 'm':
         nomice = true;
         break;
+      case 'r':
+        capture = optarg;
+        break;
+      case 'c':{
+        char* eol;
+        unsigned long c = strtoul(optarg, &eol, 0);
+        if(c == 0 || *eol){
+          usage(argv[0], stderr);
+        }
+        chunk = c;
+        break;
+      }case 's':
+        seed = strtoul(optarg, nullptr, 0);
+        break;
+      case 'd':
+        dump = true;
+        break;
       case 'v':
         nopts.loglevel = NCLOGLEVEL_TRACE;
         break;
@@ -447,6 +603,9 @@ int main(int argc, char** argv){
     usage(argv[0], stderr);
   }
   nopts.flags = NCOPTION_INHIBIT_SETLOCALE;
+  if(capture){
+    return replay(capture, &nopts, nomice, chunk, seed, dump) ? EXIT_FAILURE : EXIT_SUCCESS;
+  }
   NotCurses nc(nopts);
   if(!nomice){
     nc.mouse_enable(NCMICE_ALL_EVENTS);
@@ -0,0 +1,433 @@
+#include <time.h>
+#include <pthread.h>
+#include "internal.h"
+
+// effects registered with ncplane_animate(). a single periodic timer (see
+// notcurses_timer_add()) advances all of them, and then renders the standard
+// pile once. each effect's progress is computed from the time since it
+// began, so frames which come late (or not at all) don't slow it down.
+
+// progress is 16.16 fixed point, 65536 being complete
+#define ANIM_ONE 65536u
+
+typedef struct ncanimfx {
+  ncplane* n;
+  ncanim_e type;
+  uint64_t startns;
+  uint64_t durationns;
+  struct ncfadectx* fade;   // NCANIM_FADE{IN,OUT} and NCANIM_PULSE
+  int y0, x0, y1, x1;       // NCANIM_MOVE
+  unsigned rows0, cols0;    // NCANIM_RESIZE
+  unsigned rows1, cols1;
+  uint64_t chan0, chan1;    // NCANIM_TWEEN
+  void (*donecb)(ncplane*, void*);
+  void* curry;
+} ncanimfx;
+
+// a completed effect whose callback has yet to be invoked
+typedef struct ncanimdone {
+  ncplane* n;
+  void (*donecb)(ncplane*, void*);
+  void* curry;
+} ncanimdone;
+
+typedef struct ncanimator {
+  pthread_mutex_t lock;
+  ncanimfx* fx;
+  unsigned fxcount, fxsize;
+  ncanimdone* done;
+  unsigned donecount, donesize;
+  uint64_t periodns;        // time between frames
+  int timerid;              // frame timer, or 0 while there are no effects
+} ncanimator;
+
+#define ANIM_DEFAULT_FPS 60
+
+static inline uint64_t
+anim_now(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return timespec_to_ns(&ts);
+}
+
+// the fades all work from a snapshot of the plane, so they replace one
+// another, rather than only their own type.
+static inline bool
+anim_isfade(ncanim_e type){
+  return type == NCANIM_FADEIN || type == NCANIM_FADEOUT || type == NCANIM_PULSE;
+}
+
+static inline bool
+anim_conflicts(ncanim_e a, ncanim_e b){
+  return a == b || (anim_isfade(a) && anim_isfade(b));
+}
+
+// the animator is created along with the first effect (or the first call
+// to notcurses_set_animation_fps()), and lives until notcurses_stop().
+static ncanimator*
+notcurses_animator(notcurses* nc){
+  pthread_mutex_lock(&nc->pilelock);
+  if(nc->animator == NULL){
+    ncanimator* a = malloc(sizeof(*a));
+    if(a){
+      memset(a, 0, sizeof(*a));
+      if(pthread_mutex_init(&a->lock, NULL)){
+        free(a);
+        a = NULL;
+      }else{
+        a->periodns = NANOSECS_IN_SEC / ANIM_DEFAULT_FPS;
+      }
+    }
+    nc->animator = a;
+  }
+  ncanimator* a = nc->animator;
+  pthread_mutex_unlock(&nc->pilelock);
+  return a;
+}
+
+// |a| + (|b| - |a|) * |p|, |p| being 16.16 in [0, 1]
+static inline int64_t
+anim_lerp(int64_t a, int64_t b, uint32_t p){
+  return a + (b - a) * (int64_t)p / (int64_t)ANIM_ONE;
+}
+
+// interpolate a single channel. RGB components are only meaningful between
+// two RGB channels; otherwise we switch to the target upon completion.
+static uint32_t
+anim_tween_channel(uint32_t c0, uint32_t c1, uint32_t p){
+  if(p >= ANIM_ONE){
+    return c1;
+  }
+  if(ncchannel_default_p(c0) || ncchannel_palindex_p(c0) ||
+     ncchannel_default_p(c1) || ncchannel_palindex_p(c1)){
+    return c0;
+  }
+  unsigned r0, g0, b0, r1, g1, b1;
+  ncchannel_rgb8(c0, &r0, &g0, &b0);
+  ncchannel_rgb8(c1, &r1, &g1, &b1);
+  uint32_t c = c1;
+  ncchannel_set_rgb8(&c, anim_lerp(r0, r1, p), anim_lerp(g0, g1, p),
+                     anim_lerp(b0, b1, p));
+  return c;
+}
+
+// progress of |fx| at |nowns|. for a pulse, this is a triangle wave with
+// a half-period of the duration; everything else completes.
+static uint32_t
+anim_progress(const ncanimfx* fx, uint64_t nowns, bool* done){
+  uint64_t elapsed = nowns > fx->startns ? nowns - fx->startns : 0;
+  if(fx->type == NCANIM_PULSE){
+    *done = false;
+    elapsed %= fx->durationns * 2;
+    if(elapsed > fx->durationns){
+      elapsed = fx->durationns * 2 - elapsed;
+    }
+  }else if(elapsed >= fx->durationns){
+    *done = true;
+    return ANIM_ONE;
+  }else{
+    *done = false;
+  }
+  return (uint32_t)((double)elapsed / fx->durationns * ANIM_ONE);
+}
+
+static int
+anim_apply(ncanimfx* fx, uint32_t p){
+  ncplane* n = fx->n;
+  switch(fx->type){
+    case NCANIM_FADEIN:
+      return ncfadectx_apply(n, fx->fade, p);
+    case NCANIM_FADEOUT:
+      return ncfadectx_apply(n, fx->fade, ANIM_ONE - p);
+    case NCANIM_PULSE: // starts from the plane's own colors
+      return ncfadectx_apply(n, fx->fade, ANIM_ONE - p);
+    case NCANIM_MOVE:
+      return ncplane_move_yx(n, anim_lerp(fx->y0, fx->y1, p),
+                             anim_lerp(fx->x0, fx->x1, p));
+    case NCANIM_RESIZE:{
+      unsigned rows = anim_lerp(fx->rows0, fx->rows1, p);
+      unsigned cols = anim_lerp(fx->cols0, fx->cols1, p);
+      return ncplane_resize_simple(n, rows ? rows : 1, cols ? cols : 1);
+    }case NCANIM_TWEEN:{
+      uint32_t fchan = anim_tween_channel(ncchannels_fchannel(fx->chan0),
+                                          ncchannels_fchannel(fx->chan1), p);
+      uint32_t bchan = anim_tween_channel(ncchannels_bchannel(fx->chan0),
+                                          ncchannels_bchannel(fx->chan1), p);
+      uint64_t channels = ncchannels_combine(fchan, bchan);
+      if(n->basecell.channels != channels){
+        n->basecell.channels = channels;
+        ncplane_damage(n);
+      }
+      return 0;
+    }
+  }
+  return -1;
+}
+
+static void
+anim_remove(ncanimator* a, unsigned idx){
+  ncfadectx_free(a->fx[idx].fade);
+  a->fx[idx] = a->fx[--a->fxcount];
+}
+
+static int
+anim_queue_done(ncanimator* a, const ncanimfx* fx){
+  if(a->donecount == a->donesize){
+    unsigned nsize = a->donesize ? a->donesize * 2 : 8;
+    ncanimdone* tmp = realloc(a->done, sizeof(*tmp) * nsize);
+    if(tmp == NULL){
+      return -1;
+    }
+    a->done = tmp;
+    a->donesize = nsize;
+  }
+  ncanimdone* d = &a->done[a->donecount++];
+  d->n = fx->n;
+  d->donecb = fx->donecb;
+  d->curry = fx->curry;
+  return 0;
+}
+
+// the frame timer. |missed| frames are simply skipped.
+static int
+anim_tick(notcurses* nc, void* curry, unsigned missed){
+  ncanimator* a = curry;
+  (void)missed;
+  pthread_mutex_lock(&a->lock);
+  const uint64_t nowns = anim_now();
+  unsigned i = 0;
+  while(i < a->fxcount){
+    ncanimfx* fx = &a->fx[i];
+    bool done;
+    uint32_t p = anim_progress(fx, nowns, &done);
+    if(anim_apply(fx, p)){
+      logerror("couldn't advance effect %d on %p", fx->type, fx->n);
+      done = true;
+    }
+    if(done){
+      if(fx->donecb && anim_queue_done(a, fx)){
+        logerror("couldn't queue completion of %p", fx->n);
+      }
+      anim_remove(a, i);
+    }else{
+      ++i;
+    }
+  }
+  // a callback might destroy a plane whose own callback is pending, so
+  // take them one at a time (see ncanimator_forget()).
+  while(a->donecount){
+    ncanimdone d = a->done[--a->donecount];
+    pthread_mutex_unlock(&a->lock);
+    d.donecb(d.n, d.curry);
+    pthread_mutex_lock(&a->lock);
+  }
+  pthread_mutex_unlock(&a->lock);
+  if(notcurses_render(nc)){
+    logerror("couldn't render animation frame");
+  }
+  int ret = 0;
+  pthread_mutex_lock(&a->lock);
+  if(a->fxcount == 0){
+    a->timerid = 0;
+    ret = 1; // cancel the timer until there's something to animate
+  }
+  pthread_mutex_unlock(&a->lock);
+  return ret;
+}
+
+// call with the animator's lock held
+static int
+anim_arm(notcurses* nc, ncanimator* a){
+  if(a->timerid == 0){
+    int id = notcurses_timer_add(nc, 0, a->periodns, anim_tick, a);
+    if(id < 0){
+      return -1;
+    }
+    a->timerid = id;
+  }
+  return 0;
+}
+
+static int
+anim_setup(ncplane* n, ncanimfx* fx, ncanim_e type, const ncanim_options* opts){
+  memset(fx, 0, sizeof(*fx));
+  fx->n = n;
+  fx->type = type;
+  fx->durationns = opts->durationns;
+  fx->donecb = opts->donecb;
+  fx->curry = opts->curry;
+  switch(type){
+    case NCANIM_PULSE:
+      if(opts->durationns == 0){
+        logerror("a pulse requires a duration");
+        return -1;
+      } // fallthrough
+    case NCANIM_FADEIN:
+    case NCANIM_FADEOUT:
+      if((fx->fade = ncfadectx_setup(n)) == NULL){
+        logerror("couldn't set up fade on %p", n);
+        return -1;
+      }
+      break;
+    case NCANIM_MOVE:
+    case NCANIM_RESIZE:
+      if(n == notcurses_stdplane(ncplane_notcurses(n))){
+        logerror("can't move or resize the standard plane");
+        return -1;
+      }
+      if(type == NCANIM_MOVE){
+        ncplane_yx(n, &fx->y0, &fx->x0);
+        fx->y1 = opts->y;
+        fx->x1 = opts->x;
+      }else{
+        if(opts->rows == 0 || opts->cols == 0){
+          logerror("invalid geometry %ux%u", opts->rows, opts->cols);
+          return -1;
+        }
+        ncplane_dim_yx(n, &fx->rows0, &fx->cols0);
+        fx->rows1 = opts->rows;
+        fx->cols1 = opts->cols;
+      }
+      break;
+    case NCANIM_TWEEN:
+      fx->chan0 = n->basecell.channels;
+      fx->chan1 = opts->channels;
+      break;
+    default:
+      logerror("unknown effect %d", type);
+      return -1;
+  }
+  fx->startns = anim_now();
+  return 0;
+}
+
+int ncplane_animate(ncplane* n, ncanim_e type, const ncanim_options* opts){
+  if(opts->flags){
+    logwarn("provided unsupported flags %016" PRIx64, opts->flags);
+  }
+  notcurses* nc = ncplane_notcurses(n);
+  ncanimator* a = notcurses_animator(nc);
+  if(a == NULL){
+    return -1;
+  }
+  pthread_mutex_lock(&a->lock);
+  // an effect which is replaced must not be snapshotted partway through
+  for(unsigned i = 0 ; i < a->fxcount ; ++i){
+    if(a->fx[i].n == n && anim_conflicts(a->fx[i].type, type)){
+      if(a->fx[i].fade){
+        ncfadectx_apply(n, a->fx[i].fade, ANIM_ONE);
+      }
+      anim_remove(a, i);
+      break;
+    }
+  }
+  ncanimfx fx;
+  if(anim_setup(n, &fx, type, opts)){
+    pthread_mutex_unlock(&a->lock);
+    return -1;
+  }
+  if(a->fxcount == a->fxsize){
+    unsigned nsize = a->fxsize ? a->fxsize * 2 : 8;
+    ncanimfx* tmp = realloc(a->fx, sizeof(*tmp) * nsize);
+    if(tmp == NULL){
+      ncfadectx_free(fx.fade);
+      pthread_mutex_unlock(&a->lock);
+      return -1;
+    }
+    a->fx = tmp;
+    a->fxsize = nsize;
+  }
+  if(anim_arm(nc, a)){
+    ncfadectx_free(fx.fade);
+    pthread_mutex_unlock(&a->lock);
+    return -1;
+  }
+  // don't show the plane at full brightness before the first frame
+  if(type == NCANIM_FADEIN){
+    ncfadectx_apply(n, fx.fade, 0);
+  }
+  a->fx[a->fxcount++] = fx;
+  pthread_mutex_unlock(&a->lock);
+  return 0;
+}
+
+int ncplane_animate_cancel(ncplane* n){
+  ncanimator* a = ncplane_notcurses(n)->animator;
+  if(a == NULL){
+    return 0;
+  }
+  int cancelled = 0;
+  pthread_mutex_lock(&a->lock);
+  unsigned i = 0;
+  while(i < a->fxcount){
+    if(a->fx[i].n == n){
+      anim_remove(a, i);
+      ++cancelled;
+    }else{
+      ++i;
+    }
+  }
+  pthread_mutex_unlock(&a->lock);
+  return cancelled;
+}
+
+int notcurses_set_animation_fps(notcurses* nc, unsigned fps){
+  if(fps == 0){
+    logerror("invalid frame rate %u", fps);
+    return -1;
+  }
+  ncanimator* a = notcurses_animator(nc);
+  if(a == NULL){
+    return -1;
+  }
+  int ret = 0;
+  pthread_mutex_lock(&a->lock);
+  a->periodns = NANOSECS_IN_SEC / fps;
+  if(a->periodns == 0){
+    a->periodns = 1;
+  }
+  if(a->timerid){
+    notcurses_timer_del(nc, a->timerid);
+    a->timerid = 0;
+    ret = anim_arm(nc, a);
+  }
+  pthread_mutex_unlock(&a->lock);
+  return ret;
+}
+
+void ncanimator_forget(ncanimator* a, const ncplane* n){
+  pthread_mutex_lock(&a->lock);
+  unsigned i = 0;
+  while(i < a->fxcount){
+    if(a->fx[i].n == n){
+      anim_remove(a, i);
+    }else{
+      ++i;
+    }
+  }
+  i = 0;
+  while(i < a->donecount){
+    if(a->done[i].n == n){
+      a->done[i] = a->done[--a->donecount];
+    }else{
+      ++i;
+    }
+  }
+  pthread_mutex_unlock(&a->lock);
+}
+
+void ncanimator_destroy(notcurses* nc, ncanimator* a){
+  if(a == NULL){
+    return;
+  }
+  if(a->timerid){
+    notcurses_timer_del(nc, a->timerid);
+  }
+  while(a->fxcount){
+    anim_remove(a, a->fxcount - 1);
+  }
+  free(a->fx);
+  free(a->done);
+  pthread_mutex_destroy(&a->lock);
+  free(a);
+}
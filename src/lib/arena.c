@@ -0,0 +1,179 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "internal.h"
+
+#define ARENA_ALIGN 64
+#define ARENA_MINCHUNK (64ul << 10)
+// beyond this many bytes, chunks are freed once the arena is emptied
+#define ARENA_RETAIN (64ul << 20)
+
+typedef struct arenachunk {
+  struct arenachunk* prev; // older chunk
+  struct arenachunk* next; // newer chunk, retained for reuse
+  char* base;              // ARENA_ALIGN-aligned payload
+  size_t size;             // bytes of payload
+  size_t used;
+} arenachunk;
+
+typedef struct arena {
+  arenachunk* first;
+  arenachunk* cur;         // chunk being allocated from
+  size_t retained;         // payload bytes across all chunks
+} arena;
+
+static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+static pthread_key_t arena_key;
+static __thread arena* myarena;
+
+static void
+free_chunks(arenachunk* c){
+  while(c){
+    arenachunk* next = c->next;
+    free(c);
+    c = next;
+  }
+}
+
+static void
+arena_destroy(void* va){
+  arena* a = va;
+  free_chunks(a->first);
+  free(a);
+}
+
+static void
+arena_key_create(void){
+  if(pthread_key_create(&arena_key, arena_destroy)){
+    logerror("couldn't create arena key");
+  }
+}
+
+static arena*
+get_arena(void){
+  if(myarena == NULL){
+    arena* a = calloc(1, sizeof(*a));
+    if(a == NULL){
+      return NULL;
+    }
+    pthread_once(&arena_once, arena_key_create);
+    pthread_setspecific(arena_key, a);
+    myarena = a;
+  }
+  return myarena;
+}
+
+static arenachunk*
+chunk_create(size_t size){
+  arenachunk* c = malloc(sizeof(*c) + size + ARENA_ALIGN);
+  if(c == NULL){
+    return NULL;
+  }
+  const uintptr_t p = (uintptr_t)(c + 1);
+  c->base = (char*)((p + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1));
+  c->size = size;
+  c->used = 0;
+  c->prev = c->next = NULL;
+  return c;
+}
+
+static inline size_t
+arena_round(size_t len){
+  return (len + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+arenamark arena_mark(void){
+  arenamark m = { NULL, 0 };
+  arena* a = myarena;
+  // an empty arena is marked as such, so its release can trim it
+  if(a && a->cur && (a->cur != a->first || a->cur->used)){
+    m.chunk = a->cur;
+    m.used = a->cur->used;
+  }
+  return m;
+}
+
+void arena_release(arenamark m){
+  arena* a = myarena;
+  if(a == NULL || a->first == NULL){
+    return;
+  }
+  if(m.chunk){
+    a->cur = m.chunk;
+    a->cur->used = m.used;
+    return;
+  }
+  a->cur = a->first;
+  a->cur->used = 0;
+  // the arena is empty. if some outsized frame swelled it, give back all but
+  // the first chunk.
+  if(a->retained > ARENA_RETAIN){
+    free_chunks(a->first->next);
+    a->first->next = NULL;
+    a->retained = a->first->size;
+  }
+}
+
+void* arena_alloc(size_t len){
+  arena* a = get_arena();
+  if(a == NULL){
+    return NULL;
+  }
+  len = arena_round(len ? len : 1);
+  arenachunk* c = a->cur;
+  if(c && c->size - c->used >= len){
+    void* ret = c->base + c->used;
+    c->used += len;
+    return ret;
+  }
+  // move to the next retained chunk if it's large enough. otherwise, drop
+  // the retained chunks, and make one which is.
+  arenachunk* next = c ? c->next : a->first;
+  if(next == NULL || next->size < len){
+    size_t size = c ? c->size * 2 : ARENA_MINCHUNK;
+    if(size < len){
+      size = len;
+    }
+    arenachunk* n = chunk_create(size);
+    if(n == NULL){
+      return NULL;
+    }
+    for(arenachunk* d = next ; d ; d = d->next){
+      a->retained -= d->size;
+    }
+    free_chunks(next);
+    n->prev = c;
+    if(c){
+      c->next = n;
+    }else{
+      a->first = n;
+    }
+    a->retained += size;
+    next = n;
+  }
+  next->used = len;
+  a->cur = next;
+  return next->base;
+}
+
+void* arena_grow(void* p, size_t oldlen, size_t newlen){
+  if(p == NULL){
+    return arena_alloc(newlen);
+  }
+  arenachunk* c = myarena ? myarena->cur : NULL;
+  const size_t oldr = arena_round(oldlen);
+  const size_t newr = arena_round(newlen);
+  if(c && (char*)p + oldr == c->base + c->used){
+    const size_t off = (char*)p - c->base;
+    if(c->size - off >= newr){
+      c->used = off + newr;
+      return p;
+    }
+  }
+  void* ret = arena_alloc(newlen);
+  if(ret){
+    memcpy(ret, p, oldlen < newlen ? oldlen : newlen);
+  }
+  return ret;
+}
@@ -0,0 +1,45 @@
+#ifndef NOTCURSES_ARENA
+#define NOTCURSES_ARENA
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+// per-thread scratch memory for the temporaries of a blit or fill (pixel
+// conversions, quantization tables, fill stacks). allocation bumps through
+// chunks which are retained between uses, so steady-state frames neither
+// call malloc() nor fault in fresh pages. memory is reclaimed in LIFO order:
+// take a mark, allocate, and release back to the mark before returning.
+// nested users needn't know of one another, so long as each releases what
+// it took. memory must not be handed to another thread which outlives the
+// release. allocations are aligned to 64 bytes.
+
+struct arenachunk;
+
+typedef struct arenamark {
+  struct arenachunk* chunk; // NULL for the start of the arena
+  size_t used;
+} arenamark;
+
+arenamark arena_mark(void);
+
+// release everything allocated since |m| was taken.
+void arena_release(arenamark m);
+
+// returns NULL on allocation failure.
+void* arena_alloc(size_t len);
+
+// grow |p|, an allocation of |oldlen| bytes, to |newlen| bytes. this happens
+// in place if |p| was the most recent allocation and there's room; otherwise
+// the contents are copied to a new allocation (the old one is reclaimed by
+// the enclosing release). |p| may be NULL. returns NULL on failure, leaving
+// |p| intact.
+void* arena_grow(void* p, size_t oldlen, size_t newlen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -32,6 +32,14 @@ typedef struct esctrie {
   unsigned kleene; // idx of kleene match
 } esctrie;
 
+// what happens upon entering a state of the compiled automaton
+enum {
+  STATE_TRANSIT,   // keep walking (this includes numerics)
+  STATE_STRING,    // we're now within an ST-terminated string
+  STATE_ACCEPT,    // emit the node's ncinput
+  STATE_FUNCTION,  // invoke the node's function
+};
+
 // get node corresponding to 1-biased index
 static inline esctrie*
 esctrie_from_idx(const automaton* a, unsigned idx){
@@ -78,7 +86,17 @@ create_esctrie_node(automaton* a, int special){
   return esctrie_idx(a, e);
 }
 
+static void
+automaton_decompile(automaton* a){
+  free(a->trans);
+  a->trans = NULL;
+  free(a->kinds);
+  a->kinds = NULL;
+  a->nclasses = 0;
+}
+
 void input_free_esctrie(automaton* a){
+  automaton_decompile(a);
   a->escapes = 0;
   a->poolsize = 0;
   for(unsigned i = 0 ; i < a->poolused ; ++i){
@@ -412,6 +430,7 @@ link_numeric(automaton* a, const char* prefix, int pfxlen,
 
 static esctrie*
 insert_path(automaton* a, const char* seq){
+  automaton_decompile(a);
   if(a->escapes == 0){
     if((a->escapes = create_esctrie_node(a, 0)) == 0){
       return NULL;
@@ -539,6 +558,161 @@ int inputctx_add_input_escape(automaton* a, const char* esc, uint32_t special,
   return 0;
 }
 
+// the transition from |e| on byte |b|, as the compiled automaton sees it. a
+// string is only left via BEL or ESC; anything else remains within it.
+static unsigned
+compiled_transition(const automaton* a, const esctrie* e, unsigned b){
+  if(e->trie == NULL){
+    return 0;
+  }
+  if(e->ntype == NODE_STRING){
+    if((b == 0x1b || b == 0x07) && e->trie[b]){
+      return e->trie[b];
+    }
+    return esctrie_idx(a, e);
+  }
+  return e->trie[b];
+}
+
+// do bytes |b1| and |b2| effect the same transition from every state?
+static bool
+equivalent_bytes(const automaton* a, unsigned b1, unsigned b2){
+  for(unsigned i = 0 ; i < a->poolused ; ++i){
+    const esctrie* e = &a->nodepool[i];
+    if(compiled_transition(a, e, b1) != compiled_transition(a, e, b2)){
+      return false;
+    }
+  }
+  return true;
+}
+
+// flatten the trie into a->trans. states retain their 1-biased node indices,
+// so row 0 is the NULL state, and accepting states can still find their
+// esctrie. bytes effecting identical transitions from every state share a
+// class (all the digits, say, or most printables), which keeps the table
+// small enough to stay in cache.
+int automaton_compile(automaton* a){
+  automaton_decompile(a);
+  if(a->escapes == 0){
+    return -1;
+  }
+  // hash each byte's column of transitions, so that we only need fully
+  // compare columns which are likely to be equal.
+  uint64_t hashes[0x80];
+  for(unsigned b = 0 ; b < 0x80 ; ++b){
+    uint64_t h = 0xcbf29ce484222325ull;
+    for(unsigned i = 0 ; i < a->poolused ; ++i){
+      h = (h ^ compiled_transition(a, &a->nodepool[i], b)) * 0x100000001b3ull;
+    }
+    hashes[b] = h;
+  }
+  unsigned char reps[0x80]; // representative byte of each class
+  unsigned nclasses = 0;
+  for(unsigned b = 0 ; b < 0x80 ; ++b){
+    unsigned c;
+    for(c = 0 ; c < nclasses ; ++c){
+      if(hashes[reps[c]] == hashes[b] && equivalent_bytes(a, reps[c], b)){
+        break;
+      }
+    }
+    if(c == nclasses){
+      reps[nclasses++] = b;
+    }
+    a->classes[b] = c;
+  }
+  const size_t states = a->poolused + 1;
+  a->trans = malloc(sizeof(*a->trans) * states * nclasses);
+  a->kinds = malloc(sizeof(*a->kinds) * states);
+  if(a->trans == NULL || a->kinds == NULL){
+    logwarn("couldn't allocate %zu-state transition table", states);
+    automaton_decompile(a);
+    return -1;
+  }
+  memset(a->trans, 0, sizeof(*a->trans) * nclasses);
+  a->kinds[0] = STATE_TRANSIT;
+  for(unsigned i = 0 ; i < a->poolused ; ++i){
+    const esctrie* e = &a->nodepool[i];
+    unsigned* row = a->trans + (i + 1) * nclasses;
+    for(unsigned c = 0 ; c < nclasses ; ++c){
+      row[c] = compiled_transition(a, e, reps[c]);
+    }
+    switch(e->ntype){
+      case NODE_SPECIAL:
+        a->kinds[i + 1] = e->ni.id ? STATE_ACCEPT : STATE_TRANSIT;
+        break;
+      case NODE_NUMERIC:
+        a->kinds[i + 1] = STATE_TRANSIT;
+        break;
+      case NODE_STRING:
+        a->kinds[i + 1] = STATE_STRING;
+        break;
+      case NODE_FUNCTION:
+        a->kinds[i + 1] = STATE_FUNCTION;
+        break;
+    }
+  }
+  a->nclasses = nclasses;
+  loginfo("compiled %zu states over %u byte classes (%zuB)", states - 1,
+          nclasses, sizeof(*a->trans) * states * nclasses);
+  return 0;
+}
+
+// walk_automaton() using the transition table. behavior is identical to
+// walking the trie, but only accepting states touch their esctrie.
+static int
+walk_compiled(automaton* a, struct inputctx* ictx, unsigned candidate,
+              ncinput* ni){
+  if(candidate == 0x1b && !a->instring){
+    a->state = a->escapes;
+    return 0;
+  }
+  const unsigned cur = a->state;
+  const unsigned next = a->trans[cur * a->nclasses + a->classes[candidate]];
+  if(a->kinds[cur] == STATE_STRING){
+    if(next == cur){
+      return 0;
+    }
+    a->state = next;
+    a->instring = 0;
+    if(a->kinds[next] == STATE_FUNCTION){ // for the 0x07s of the world
+      const esctrie* e = esctrie_from_idx(a, next);
+      if(e->fxn == NULL){
+        return 2;
+      }
+      return e->fxn(ictx);
+    }
+    return 0;
+  }
+  if((a->state = next) == 0){
+    if(cur == a->escapes){
+      memset(ni, 0, sizeof(*ni));
+      ni->id = candidate;
+      ni->alt = true;
+      return 1;
+    }
+    loginfo("unexpected transition on %u[%u]", cur, candidate);
+    return -1;
+  }
+  const esctrie* e;
+  switch(a->kinds[next]){
+    case STATE_TRANSIT:
+      break;
+    case STATE_STRING:
+      a->instring = 1;
+      break;
+    case STATE_ACCEPT:
+      memcpy(ni, &esctrie_from_idx(a, next)->ni, sizeof(*ni));
+      return 1;
+    case STATE_FUNCTION:
+      e = esctrie_from_idx(a, next);
+      if(e->fxn == NULL){
+        return 2;
+      }
+      return e->fxn(ictx);
+  }
+  return 0;
+}
+
 // returns -1 for non-match, 0 for match, 1 for acceptance. if we are in the
 // middle of a sequence, and receive an escape, *do not call this*, but
 // instead call reset_automaton() after replaying the used characters to the
@@ -549,6 +723,9 @@ int walk_automaton(automaton* a, struct inputctx* ictx, unsigned candidate,
     logerror("eight-bit char %u in control sequence", candidate);
     return -1;
   }
+  if(a->trans){
+    return walk_compiled(a, ictx, candidate, ni);
+  }
   esctrie* e = esctrie_from_idx(a, a->state);
   // we ought not have been called for an escape with any state!
   if(candidate == 0x1b && !a->instring){
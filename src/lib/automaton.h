@@ -28,6 +28,14 @@ typedef struct automaton {
   unsigned poolsize;
   unsigned poolused;
   struct esctrie* nodepool;
+  // once every path has been added, automaton_compile() flattens the trie
+  // into a dense transition table over classes of equivalent bytes, so that
+  // each step is a single lookup. NULL until compiled; any later insertion
+  // discards the table, and we fall back to walking the trie.
+  unsigned char classes[0x80]; // byte -> equivalence class
+  unsigned nclasses;
+  unsigned* trans;             // (poolused + 1) rows of nclasses states
+  unsigned char* kinds;        // what happens upon entering each state
 } automaton;
 
 // wipe out all storage internal to |a| (but not |a| itself).
@@ -39,6 +47,11 @@ int inputctx_add_input_escape(automaton* a, const char* esc,
 int inputctx_add_cflow(automaton* a, const char* csi, triefunc fxn)
   __attribute__ ((nonnull (1, 2)));
 
+// build the transition table. failure is not fatal; walk_automaton() will
+// continue to use the trie.
+int automaton_compile(automaton* a)
+  __attribute__ ((nonnull (1)));
+
 int walk_automaton(automaton* a, struct inputctx* ictx, unsigned candidate,
                    struct ncinput* ni)
   __attribute__ ((nonnull (1, 2, 4)));
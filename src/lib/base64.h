@@ -126,6 +126,94 @@ base64final(const unsigned char* src, char* b64, size_t b){
   }
 }
 
+// encoding a run of bytes needn't be done three at a time. we gather eight
+// triples into 32-bit lanes arranged such that each lane's four sextets can
+// be pulled out with shifts and masks, and then translate all 32 sextets to
+// ASCII with compares. this is plain GNU C vector arithmetic; the byte gather
+// becomes PSHUFB (SSSE3, selected at load time along with an AVX2 clone
+// where the toolchain supports it) or TBL on NEON. output is identical to
+// base64x3().
+#if (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9)) && \
+    defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define BASE64_LANES
+typedef uint8_t b64lanes __attribute__ ((vector_size (32)));
+typedef uint32_t b64lanes32 __attribute__ ((vector_size (32)));
+
+#if defined(__x86_64__) && defined(__GLIBC__) && !defined(__clang__)
+#define BASE64_CLONES __attribute__ ((target_clones ("avx2", "ssse3", "default")))
+#else
+#define BASE64_CLONES
+#endif
+
+// triple t (bytes b0, b1, b2) becomes the lane b1 | b0 << 8 | b2 << 16 | b1 << 24
+#define B64GATHER 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, \
+  13, 12, 14, 13, 16, 15, 17, 16, 19, 18, 20, 19, 22, 21, 23, 22
+#ifdef __clang__
+#define B64SHUFFLE(v) __builtin_shufflevector((v), (v), B64GATHER)
+#else
+#define B64SHUFFLE(v) __builtin_shuffle((v), (b64lanes){ B64GATHER })
+#endif
+
+// encode the 24 bytes in the low lanes of |v| as 32 characters, in place.
+// always inlined, so that it's compiled for each clone of base64_lanes().
+__attribute__ ((always_inline)) static inline void
+base64_lanes24(b64lanes* v){
+  b64lanes32 t = (b64lanes32)B64SHUFFLE(*v);
+  t = ((t >> 10u) & 0x3fu) | ((t << 4u) & 0x3f00u) |
+      ((t >> 6u) & 0x3f0000u) | ((t << 8u) & 0x3f000000u);
+  b64lanes sext = (b64lanes)t;
+  // 'A' for 0..25, 'a' - 26 for 26..51, '0' - 52 for 52..61, then '+', '/'
+  b64lanes off = (b64lanes)(sext >= 26) & 6;
+  off += (b64lanes)(sext >= 52) & (uint8_t)-75;
+  off += (b64lanes)(sext >= 62) & (uint8_t)-15;
+  off += (b64lanes)(sext >= 63) & 3;
+  *v = sext + off + 'A';
+}
+
+// encode as many whole groups of 24 bytes from |src| as fit in |len|,
+// returning the number of bytes consumed (4 / 3 as many are written).
+BASE64_CLONES static inline size_t
+base64_lanes(const unsigned char* src, size_t len, char* dst){
+  size_t i = 0;
+  b64lanes in;
+  // we load a full vector where we can, even though we only use 24 bytes of
+  // it, as building one up from a partial load is much slower.
+  while(len - i >= sizeof(in)){
+    memcpy(&in, src + i, sizeof(in));
+    base64_lanes24(&in);
+    memcpy(dst, &in, sizeof(in));
+    dst += sizeof(in);
+    i += 24;
+  }
+  if(len - i >= 24){
+    memset(&in, 0, sizeof(in));
+    memcpy(&in, src + i, 24);
+    base64_lanes24(&in);
+    memcpy(dst, &in, sizeof(in));
+    i += 24;
+  }
+  return i;
+}
+#undef B64SHUFFLE
+#undef B64GATHER
+#endif
+
+// encode |len| bytes (a multiple of 3) from |src| as 4 * |len| / 3 base64
+// characters at |dst|, which is not NUL-terminated.
+static inline void
+base64_encode(const unsigned char* src, size_t len, char* dst){
+  size_t i = 0;
+#ifdef BASE64_LANES
+  i = base64_lanes(src, len, dst);
+  dst += i / 3 * 4;
+#endif
+  while(i < len){
+    base64x3(src + i, dst);
+    dst += 4;
+    i += 3;
+  }
+}
+
 #ifdef __cplusplus
 }
 #endif
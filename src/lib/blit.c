@@ -5,6 +5,69 @@
 static const uint32_t zeroes32;
 static const unsigned char zeroes[] = "\x00\x00\x00\x00";
 
+// the cell blitters' glyphs, packed as they're stored inline in a cell's
+// gcluster (every one is at most four bytes of UTF-8), and indexed by the
+// bitmask of foreground pixels (see 'egcs' of the blitsets, whose order these
+// follow). braille is instead indexed by Unicode dot order. they're built once,
+// when a blitset is first looked up, so blitting a cell needn't touch any
+// strings or the egcpool.
+static uint32_t halfglyphs[4];
+static uint32_t quadglyphs[16];
+static uint32_t sexglyphs[64];
+static uint32_t brailleglyphs[256];
+static pthread_once_t blitglyph_once = PTHREAD_ONCE_INIT;
+
+// the packed UTF-8 encoding of |wc|
+static uint32_t
+blitglyph_pack(uint32_t wc){
+  unsigned char u[4] = { 0, 0, 0, 0 };
+  if(wc < 0x80){
+    u[0] = wc;
+  }else if(wc < 0x800){
+    u[0] = 0xc0 | (wc >> 6);
+    u[1] = 0x80 | (wc & 0x3f);
+  }else if(wc < 0x10000){
+    u[0] = 0xe0 | (wc >> 12);
+    u[1] = 0x80 | ((wc >> 6) & 0x3f);
+    u[2] = 0x80 | (wc & 0x3f);
+  }else{
+    u[0] = 0xf0 | (wc >> 18);
+    u[1] = 0x80 | ((wc >> 12) & 0x3f);
+    u[2] = 0x80 | ((wc >> 6) & 0x3f);
+    u[3] = 0x80 | (wc & 0x3f);
+  }
+  uint32_t g;
+  memcpy(&g, u, sizeof(g));
+  return g;
+}
+
+static void
+blitglyph_fill(uint32_t* glyphs, const wchar_t* egcs, unsigned count){
+  for(unsigned i = 0 ; i < count ; ++i){
+    assert(egcs[i]);
+    glyphs[i] = blitglyph_pack(egcs[i]);
+  }
+}
+
+static void
+blitglyph_build(void){
+  blitglyph_fill(halfglyphs, NCHALFBLOCKS, sizeof(halfglyphs) / sizeof(*halfglyphs));
+  blitglyph_fill(quadglyphs, NCQUADBLOCKS, sizeof(quadglyphs) / sizeof(*quadglyphs));
+  blitglyph_fill(sexglyphs, NCSEXBLOCKS, sizeof(sexglyphs) / sizeof(*sexglyphs));
+  for(unsigned i = 0 ; i < sizeof(brailleglyphs) / sizeof(*brailleglyphs) ; ++i){
+    brailleglyphs[i] = blitglyph_pack(0x2800 + i);
+  }
+}
+
+// write the single-column glyph |g| (from the tables above) to |c|, releasing
+// whatever EGC it previously held.
+static inline void
+cell_blit_glyph(ncplane* nc, nccell* c, uint32_t g){
+  pool_release(&nc->pool, c);
+  c->gcluster = g;
+  c->width = 1;
+}
+
 // linearly interpolate a 24-bit RGB value along each 8-bit channel
 static inline uint32_t
 lerp(uint32_t c0, uint32_t c1, unsigned nointerpolate){
@@ -99,9 +162,7 @@ tria_blit_ascii(ncplane* nc, int linesize, const void* data,
         nccell_set_fg_rgb8(c, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2]);
         nccell_set_bg_rgb8(c, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2]);
         cell_set_blitquadrants(c, 1, 1, 1, 1);
-        if(pool_blit_direct(&nc->pool, c, " ", 1, 1) <= 0){
-          return -1;
-        }
+        cell_blit_glyph(nc, c, halfglyphs[0]);
         ++total;
       }
     }
@@ -150,17 +211,12 @@ tria_blit(ncplane* nc, int linesize, const void* data, int leny, int lenx,
           nccell_set_fg_alpha(c, NCALPHA_TRANSPARENT);
           nccell_release(nc, c);
         }else if(rgba_trans_q(rgbbase_up, transcolor)){ // down has the color
-          if(pool_blit_direct(&nc->pool, c, "\u2584", strlen("\u2584"), 1) <= 0){
-            return -1;
-          }
+          cell_blit_glyph(nc, c, halfglyphs[2]);
           nccell_set_fg_rgb8(c, rgbbase_down[0], rgbbase_down[1], rgbbase_down[2]);
           cell_set_blitquadrants(c, 0, 0, 1, 1);
           ++total;
         }else{ // up has the color
-          // upper half block
-          if(pool_blit_direct(&nc->pool, c, "\u2580", strlen("\u2580"), 1) <= 0){
-            return -1;
-          }
+          cell_blit_glyph(nc, c, halfglyphs[1]); // upper half block
           nccell_set_fg_rgb8(c, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2]);
           cell_set_blitquadrants(c, 1, 1, 0, 0);
           ++total;
@@ -170,16 +226,12 @@ tria_blit(ncplane* nc, int linesize, const void* data, int leny, int lenx,
           nccell_set_fg_rgb8(c, rgbbase_down[0], rgbbase_down[1], rgbbase_down[2]);
           nccell_set_bg_rgb8(c, rgbbase_down[0], rgbbase_down[1], rgbbase_down[2]);
           cell_set_blitquadrants(c, 0, 0, 0, 0);
-          if(pool_blit_direct(&nc->pool, c, " ", 1, 1) <= 0){
-            return -1;
-          }
+          cell_blit_glyph(nc, c, halfglyphs[0]);
         }else{
           nccell_set_fg_rgb8(c, rgbbase_up[0], rgbbase_up[1], rgbbase_up[2]);
           nccell_set_bg_rgb8(c, rgbbase_down[0], rgbbase_down[1], rgbbase_down[2]);
           cell_set_blitquadrants(c, 1, 1, 1, 1);
-          if(pool_blit_direct(&nc->pool, c, "\u2580", strlen("\u2580"), 1) <= 0){
-            return -1;
-          }
+          cell_blit_glyph(nc, c, halfglyphs[1]);
         }
         ++total;
       }
@@ -195,16 +247,16 @@ tria_blit(ncplane* nc, int linesize, const void* data, int leny, int lenx,
 static const struct qdriver {
   int pair[2];      // indices of contributing pair
   int others[2];    // indices of excluded pair
-  const char* egc;  // EGC corresponding to contributing pair
-  const char* oth0egc; // EGC upon absorbing others[0]
-  const char* oth1egc; // EGC upon absorbing others[1]
+  // glyphs (indices into quadglyphs[]) corresponding to the contributing pair
+  // ("egc"), and upon absorbing others[0] ("oth0egc") or others[1] ("oth1egc")
+  unsigned egc, oth0egc, oth1egc;
 } quadrant_drivers[6] = {
-  { .pair = { 0, 1 }, .others = { 2, 3 }, .egc = "▀", .oth0egc = "▛", .oth1egc = "▜", },
-  { .pair = { 0, 2 }, .others = { 1, 3 }, .egc = "▌", .oth0egc = "▛", .oth1egc = "▙", },
-  { .pair = { 0, 3 }, .others = { 1, 2 }, .egc = "▚", .oth0egc = "▜", .oth1egc = "▙", },
-  { .pair = { 1, 2 }, .others = { 0, 3 }, .egc = "▞", .oth0egc = "▛", .oth1egc = "▟", },
-  { .pair = { 1, 3 }, .others = { 0, 2 }, .egc = "▐", .oth0egc = "▜", .oth1egc = "▟", },
-  { .pair = { 2, 3 }, .others = { 0, 1 }, .egc = "▄", .oth0egc = "▙", .oth1egc = "▟", },
+  { .pair = { 0, 1 }, .others = { 2, 3 }, .egc = 3, .oth0egc = 7, .oth1egc = 11, },   // ▀ ▛ ▜
+  { .pair = { 0, 2 }, .others = { 1, 3 }, .egc = 5, .oth0egc = 7, .oth1egc = 13, },   // ▌ ▛ ▙
+  { .pair = { 0, 3 }, .others = { 1, 2 }, .egc = 9, .oth0egc = 11, .oth1egc = 13, },  // ▚ ▜ ▙
+  { .pair = { 1, 2 }, .others = { 0, 3 }, .egc = 6, .oth0egc = 7, .oth1egc = 14, },   // ▞ ▛ ▟
+  { .pair = { 1, 3 }, .others = { 0, 2 }, .egc = 10, .oth0egc = 11, .oth1egc = 14, }, // ▐ ▜ ▟
+  { .pair = { 2, 3 }, .others = { 0, 1 }, .egc = 12, .oth0egc = 13, .oth1egc = 14, }, // ▄ ▙ ▟
 };
 
 // get the six distances between four colors. diffs must be an array of
@@ -227,9 +279,9 @@ rgb_4diff(uint32_t* diffs, uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br){
   }
 }
 
-// solve for the EGC and two colors to best represent four colors at top
-// left, top right, bot left, bot right
-static inline const char*
+// solve for the glyph (index into quadglyphs[]) and two colors to best
+// represent four colors at top left, top right, bot left, bot right
+static inline unsigned
 quadrant_solver(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br,
                 uint32_t* fore, uint32_t* back, unsigned nointerpolate){
   const uint32_t colors[4] = { tl, tr, bl, br };
@@ -253,7 +305,7 @@ quadrant_solver(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br,
   }
   if(allzerodiffs){
     *fore = *back = tl;
-    return " ";
+    return 0; // space
   }
   // at this point, 0 <= mindiffidx <= 5. foreground color will be the
   // lerp of this nearest pair. we then check the other two. if they are
@@ -266,7 +318,7 @@ quadrant_solver(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br,
   *fore = lerp(colors[qd->pair[0]], colors[qd->pair[1]], nointerpolate);
   *back = lerp(colors[qd->others[0]], colors[qd->others[1]], nointerpolate);
 //fprintf(stderr, "mindiff: %u[%zu] fore: %08x back: %08x %d+%d/%d+%d\n", mindiff, mindiffidx, *fore, *back, qd->pair[0], qd->pair[1], qd->others[0], qd->others[1]);
-  const char* egc = qd->egc;
+  unsigned egc = qd->egc;
   // break down the excluded pair and lerp
   unsigned r0, r1, r2, g0, g1, g2, b0, b1, b2;
   unsigned roth, goth, both, rlerp, glerp, blerp;
@@ -319,15 +371,16 @@ quadrant_solver(uint32_t tl, uint32_t tr, uint32_t bl, uint32_t br,
   return egc;
 }
 
-// quadrant check for transparency. returns an EGC if we found transparent
-// quads and have solved for colors (this EGC ought then be loaded into the
-// cell). returns NULL otherwise. transparency trumps everything else in terms
+// quadrant check for transparency. returns a glyph (index into quadglyphs[],
+// or 0 if the cell is entirely transparent) if we found transparent quads and
+// have solved for colors (this glyph ought then be loaded into the cell).
+// returns -1 otherwise. transparency trumps everything else in terms
 // of priority -- if even one quadrant is transparent, we will have a
 // transparent background, and lerp the rest together for foreground. we thus
 // have a 16-way conditional tree in which each EGC must show up exactly once.
 // FIXME we ought be able to just build up a bitstring and use it as an index!
 // FIXME pass in rgbas as array of uint32_t ala sexblitter
-static inline const char*
+static inline int
 qtrans_check(nccell* c, unsigned blendcolors,
              const unsigned char* rgbbase_tl, const unsigned char* rgbbase_tr,
              const unsigned char* rgbbase_bl, const unsigned char* rgbbase_br,
@@ -337,7 +390,7 @@ qtrans_check(nccell* c, unsigned blendcolors,
   ncchannel_set_rgb8(&tr, rgbbase_tr[0], rgbbase_tr[1], rgbbase_tr[2]);
   ncchannel_set_rgb8(&bl, rgbbase_bl[0], rgbbase_bl[1], rgbbase_bl[2]);
   ncchannel_set_rgb8(&br, rgbbase_br[0], rgbbase_br[1], rgbbase_br[2]);
-  const char* egc = NULL;
+  int egc = -1;
   if(rgba_trans_q(rgbbase_tl, transcolor)){
     // top left is transparent
     if(rgba_trans_q(rgbbase_tr, transcolor)){
@@ -345,24 +398,24 @@ qtrans_check(nccell* c, unsigned blendcolors,
       if(rgba_trans_q(rgbbase_bl, transcolor)){
         // top and left are transparent
         if(rgba_trans_q(rgbbase_br, transcolor)){
-          // entirety is transparent, load with nul (but not NULL)
+          // entirety is transparent
           nccell_set_fg_default(c);
           cell_set_blitquadrants(c, 0, 0, 0, 0);
-          egc = "";
+          egc = 0;
         }else{
           nccell_set_fg_rgb8(c, rgbbase_br[0], rgbbase_br[1], rgbbase_br[2]);
           cell_set_blitquadrants(c, 0, 0, 0, 1);
-          egc = "▗";
+          egc = 8; // ▗
         }
       }else{
         if(rgba_trans_q(rgbbase_br, transcolor)){
           nccell_set_fg_rgb8(c, rgbbase_bl[0], rgbbase_bl[1], rgbbase_bl[2]);
           cell_set_blitquadrants(c, 0, 0, 1, 0);
-          egc = "▖";
+          egc = 4; // ▖
         }else{
           cell_set_fchannel(c, lerp(bl, br, nointerpolate));
           cell_set_blitquadrants(c, 0, 0, 1, 1);
-          egc = "▄";
+          egc = 12; // ▄
         }
       }
     }else{ // top right is foreground, top left is transparent
@@ -370,20 +423,20 @@ qtrans_check(nccell* c, unsigned blendcolors,
         if(rgba_trans_q(rgbbase_br, transcolor)){ // entire bottom is transparent
           nccell_set_fg_rgb8(c, rgbbase_tr[0], rgbbase_tr[1], rgbbase_tr[2]);
           cell_set_blitquadrants(c, 0, 1, 0, 0);
-          egc = "▝";
+          egc = 2; // ▝
         }else{
           cell_set_fchannel(c, lerp(tr, br, nointerpolate));
           cell_set_blitquadrants(c, 0, 1, 0, 1);
-          egc = "▐";
+          egc = 10; // ▐
         }
       }else if(rgba_trans_q(rgbbase_br, transcolor)){ // only br is transparent
         cell_set_fchannel(c, lerp(tr, bl, nointerpolate));
         cell_set_blitquadrants(c, 0, 1, 1, 0);
-        egc = "▞";
+        egc = 6; // ▞
       }else{
         cell_set_fchannel(c, trilerp(tr, bl, br, nointerpolate));
         cell_set_blitquadrants(c, 0, 1, 1, 1);
-        egc = "▟";
+        egc = 14; // ▟
       }
     }
   }else{ // topleft is foreground for all here
@@ -392,42 +445,42 @@ qtrans_check(nccell* c, unsigned blendcolors,
         if(rgba_trans_q(rgbbase_br, transcolor)){
           nccell_set_fg_rgb8(c, rgbbase_tl[0], rgbbase_tl[1], rgbbase_tl[2]);
           cell_set_blitquadrants(c, 1, 0, 0, 0);
-          egc = "▘";
+          egc = 1; // ▘
         }else{
           cell_set_fchannel(c, lerp(tl, br, nointerpolate));
           cell_set_blitquadrants(c, 1, 0, 0, 1);
-          egc = "▚";
+          egc = 9; // ▚
         }
       }else if(rgba_trans_q(rgbbase_br, transcolor)){
         cell_set_fchannel(c, lerp(tl, bl, nointerpolate));
         cell_set_blitquadrants(c, 1, 0, 1, 0);
-        egc = "▌";
+        egc = 5; // ▌
       }else{
         cell_set_fchannel(c, trilerp(tl, bl, br, nointerpolate));
         cell_set_blitquadrants(c, 1, 0, 1, 1);
-        egc = "▙";
+        egc = 13; // ▙
       }
     }else if(rgba_trans_q(rgbbase_bl, transcolor)){
       if(rgba_trans_q(rgbbase_br, transcolor)){ // entire bottom is transparent
         cell_set_fchannel(c, lerp(tl, tr, nointerpolate));
         cell_set_blitquadrants(c, 1, 1, 0, 0);
-        egc = "▀";
+        egc = 3; // ▀
       }else{ // only bl is transparent
         cell_set_fchannel(c, trilerp(tl, tr, br, nointerpolate));
         cell_set_blitquadrants(c, 1, 1, 0, 1);
-        egc = "▜";
+        egc = 11; // ▜
       }
     }else if(rgba_trans_q(rgbbase_br, transcolor)){ // only br is transparent
       cell_set_fchannel(c, trilerp(tl, tr, bl, nointerpolate));
       cell_set_blitquadrants(c, 1, 1, 1, 0);
-      egc = "▛";
+      egc = 7; // ▛
     }else{
-      return NULL; // no transparency
+      return -1; // no transparency
     }
   }
-  assert(egc);
+  assert(egc >= 0);
   nccell_set_bg_alpha(c, NCALPHA_TRANSPARENT);
-  if(*egc == '\0'){
+  if(egc == 0){
     nccell_set_fg_alpha(c, NCALPHA_TRANSPARENT);
   }else if(blendcolors){
     nccell_set_fg_alpha(c, NCALPHA_BLEND);
@@ -473,10 +526,10 @@ quadrant_blit(ncplane* nc, int linesize, const void* data, int leny, int lenx,
       nccell* c = ncplane_cell_ref_yx(nc, y, x);
       c->channels = 0;
       c->stylemask = 0;
-      const char* egc = qtrans_check(c, blendcolors, rgbbase_tl, rgbbase_tr,
-                                     rgbbase_bl, rgbbase_br, bargs->transcolor,
-                                     nointerpolate);
-      if(egc == NULL){
+      int egc = qtrans_check(c, blendcolors, rgbbase_tl, rgbbase_tr,
+                             rgbbase_bl, rgbbase_br, bargs->transcolor,
+                             nointerpolate);
+      if(egc < 0){
         uint32_t tl = 0, tr = 0, bl = 0, br = 0;
         ncchannel_set_rgb8(&tl, rgbbase_tl[0], rgbbase_tl[1], rgbbase_tl[2]);
         ncchannel_set_rgb8(&tr, rgbbase_tr[0], rgbbase_tr[1], rgbbase_tr[2]);
@@ -485,7 +538,6 @@ quadrant_blit(ncplane* nc, int linesize, const void* data, int leny, int lenx,
         uint32_t bg, fg;
 //fprintf(stderr, "qtrans check: %d/%d\n%08x %08x\n%08x %08x\n", y, x, *(const uint32_t*)rgbbase_tl, *(const uint32_t*)rgbbase_tr, *(const uint32_t*)rgbbase_bl, *(const uint32_t*)rgbbase_br);
         egc = quadrant_solver(tl, tr, bl, br, &fg, &bg, nointerpolate);
-        assert(egc);
 //fprintf(stderr, "%d/%d %08x/%08x\n", y, x, fg, bg);
         cell_set_fchannel(c, fg);
         cell_set_bchannel(c, bg);
@@ -494,11 +546,10 @@ quadrant_blit(ncplane* nc, int linesize, const void* data, int leny, int lenx,
           nccell_set_fg_alpha(c, NCALPHA_BLEND);
         }
         cell_set_blitquadrants(c, 1, 1, 1, 1);
-      }
-      if(*egc){
-        if(pool_blit_direct(&nc->pool, c, egc, strlen(egc), 1) <= 0){
-          return -1;
-        }
+        cell_blit_glyph(nc, c, quadglyphs[egc]);
+        ++total;
+      }else if(egc){
+        cell_blit_glyph(nc, c, quadglyphs[egc]);
         ++total;
       }else{
         nccell_release(nc, c);
@@ -508,38 +559,143 @@ quadrant_blit(ncplane* nc, int linesize, const void* data, int leny, int lenx,
   return total;
 }
 
+// the 32 2-partitions of a 3x2 sample considered by sex_solver(). the bits
+// represent sextants, and indices correspond to sex[] therein.
+#define SEXPARTITIONS \
+  0, /* 1 way to arrange 0 */ \
+  1, 2, 4, 8, 16, 32, /* 6 ways to arrange 1 */ \
+  3, 5, 9, 17, 33, 6, 10, 18, 34, 12, 20, 36, 24, 40, 48, /* 15 ways for 2 */ \
+  /* 16 ways to arrange 3, *but* six of them are inverses, so 10 */ \
+  7, 11, 19, 35, 13, 21, 37, 25, 41, 14 /* 10 + 15 + 6 + 1 == 32 */
+
+// when interpolating, every partition can be evaluated independently, so we
+// solve them all at once, one partition per lane. this is plain GNU C vector
+// arithmetic; the compiler lowers it to whatever SIMD the target offers
+// (SSE2/NEON baseline, plus an AVX2 clone selected at load time where the
+// toolchain supports it). the results are bit-identical to the scalar loop
+// in sex_solver(), which remains for NOINTERPOLATE and other compilers.
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9)
+#define SEX_SOLVER_LANES
+// we work through the partitions sixteen at a time. sixteen 16-bit lanes fill
+// an AVX2 register (or two SSE2/NEON registers); wider types are split up
+// badly by the compiler.
+#define SEXLANES 16
+typedef int16_t sexlanes __attribute__ ((vector_size (SEXLANES * sizeof(int16_t))));
+typedef uint32_t sexlanes32 __attribute__ ((vector_size (SEXLANES * sizeof(uint32_t))));
+
+#if defined(__x86_64__) && defined(__GLIBC__) && !defined(__clang__)
+#define SEX_SOLVER_CLONES __attribute__ ((target_clones ("avx2", "default")))
+#else
+#define SEX_SOLVER_CLONES
+#endif
+
+// returns the index of the best partition, writing its lerps to |channels|.
+SEX_SOLVER_CLONES static int
+sex_solver_lanes(const uint32_t rgbas[6], uint64_t* channels){
+  static const int16_t partitions[32] = { SEXPARTITIONS };
+  // generalerp() computes (sum + count - 1) / count. partitions are sorted by
+  // population, so counts are known per lane. sums never exceed 6 * 255 + 5,
+  // over which multiplying by ceil(65536 / count) and shifting down by 16 is
+  // exact. lane 0 has no members, and is thus lerped to 0, as in generalerp().
+#define SEXCOUNTS(a, b, c, d) a, b, b, b, b, b, b, \
+  c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, \
+  d, d, d, d, d, d, d, d, d, d
+  static const uint32_t inbias[32] = { SEXCOUNTS(0, 0, 1, 2) };
+  static const uint32_t inrecip[32] = { SEXCOUNTS(0, 65536, 32768, 21846) };
+  static const uint32_t outbias[32] = { SEXCOUNTS(5, 4, 3, 2) };
+  static const uint32_t outrecip[32] = { SEXCOUNTS(10923, 13108, 16384, 21846) };
+#undef SEXCOUNTS
+  int16_t comps[6][3];
+  for(unsigned mask = 0 ; mask < 6 ; ++mask){
+    comps[mask][0] = ncpixel_r(rgbas[mask]);
+    comps[mask][1] = ncpixel_g(rgbas[mask]);
+    comps[mask][2] = ncpixel_b(rgbas[mask]);
+  }
+  int16_t totaldiffs[32];
+  int16_t lerps0[3][32], lerps1[3][32];
+  for(unsigned base = 0 ; base < 32 ; base += SEXLANES){
+    sexlanes parts;
+    sexlanes32 inb, inr, outb, outr;
+    memcpy(&parts, partitions + base, sizeof(parts));
+    memcpy(&inb, inbias + base, sizeof(inb));
+    memcpy(&inr, inrecip + base, sizeof(inr));
+    memcpy(&outb, outbias + base, sizeof(outb));
+    memcpy(&outr, outrecip + base, sizeof(outr));
+    sexlanes in[6]; // all ones in lanes where sextant is within the partition
+    for(unsigned mask = 0 ; mask < 6 ; ++mask){
+      in[mask] = -((parts >> mask) & 1);
+    }
+    sexlanes l0[3], l1[3];
+    for(unsigned c = 0 ; c < 3 ; ++c){
+      sexlanes sum0 = { 0 };
+      int16_t total = 0;
+      for(unsigned mask = 0 ; mask < 6 ; ++mask){
+        sum0 += in[mask] & comps[mask][c];
+        total += comps[mask][c];
+      }
+      sexlanes sum1 = total - sum0;
+      sexlanes32 w0 = __builtin_convertvector(sum0, sexlanes32);
+      sexlanes32 w1 = __builtin_convertvector(sum1, sexlanes32);
+      l0[c] = __builtin_convertvector(((w0 + inb) * inr) >> 16, sexlanes);
+      l1[c] = __builtin_convertvector(((w1 + outb) * outr) >> 16, sexlanes);
+      memcpy(lerps0[c] + base, &l0[c], sizeof(l0[c]));
+      memcpy(lerps1[c] + base, &l1[c], sizeof(l1[c]));
+    }
+    sexlanes totaldiff = { 0 };
+    for(unsigned mask = 0 ; mask < 6 ; ++mask){
+      for(unsigned c = 0 ; c < 3 ; ++c){
+        sexlanes d = ((in[mask] & l0[c]) | (~in[mask] & l1[c])) - comps[mask][c];
+        sexlanes sign = d >> 15;
+        totaldiff += (d ^ sign) - sign;
+      }
+    }
+    memcpy(totaldiffs + base, &totaldiff, sizeof(totaldiff));
+  }
+  // the scalar solver takes the first partition achieving the minimum
+  int best = 0;
+  for(int l = 1 ; l < 32 ; ++l){
+    if(totaldiffs[l] < totaldiffs[best]){
+      best = l;
+    }
+  }
+  uint32_t f = 0;
+  if(best){
+    f = NCCHANNEL_INITIALIZER(lerps0[0][best], lerps0[1][best], lerps0[2][best]);
+  }
+  uint32_t b = NCCHANNEL_INITIALIZER(lerps1[0][best], lerps1[1][best], lerps1[2][best]);
+  ncchannels_set_fchannel(channels, f);
+  ncchannels_set_bchannel(channels, b);
+  return best;
+}
+#endif
+
 // Solve for the cell rendered by this 3x2 sample. None of the input pixels may
 // be transparent (that ought already have been handled). We use exhaustive
 // search, which might be quite computationally intensive for the worst case
 // (all six pixels are different colors). We want to solve for the 2-partition
 // of pixels that minimizes total source distance from the resulting lerps.
-static const char*
+// returns the glyph (index into sexglyphs[]).
+static unsigned
 sex_solver(const uint32_t rgbas[6], uint64_t* channels, unsigned blendcolors,
            unsigned nointerpolate){
   // each element within the set of 64 has an inverse element within the set,
   // for which we would calculate the same total differences, so just handle
   // the first 32. the partition[] bit masks represent combinations of
-  // sextants, and their indices correspond to sex[].
-  static const char* sex[32] = {
-    " ", "🬀", "🬁", "🬃", "🬇", "🬏", "🬞", "🬂", // 0..7
-    "🬄", "🬈", "🬐", "🬟", "🬅", "🬉", "🬑", "🬠", // 8..15
-    "🬋", "🬓", "🬢", "🬖", "🬦", "🬭", "🬆", "🬊", // 16..23
-    "🬒", "🬡", "🬌", "▌", "🬣", "🬗", "🬧", "🬍", // 24..31
-  };
-  static const unsigned partitions[32] = {
-    0, // 1 way to arrange 0
-    1, 2, 4, 8, 16, 32, // 6 ways to arrange 1
-    3, 5, 9, 17, 33, 6, 10, 18, 34, 12, 20, 36, 24, 40, 48, // 15 ways for 2
-    //  16 ways to arrange 3, *but* six of them are inverses, so 10
-    7, 11, 19, 35, 13, 21, 37, 25, 41, 14 //  10 + 15 + 6 + 1 == 32
-  };
+  // sextants, and are themselves indices into sexglyphs[].
+  static const unsigned partitions[32] = { SEXPARTITIONS };
+  int best = -1;
+#ifdef SEX_SOLVER_LANES
+  if(!nointerpolate){
+    best = sex_solver_lanes(rgbas, channels);
+  }
+#endif
   // we loop over the bitstrings, dividing the pixels into two sets, and then
   // taking a general lerp over each set. we then compute the sum of absolute
   // differences, and see if it's the new minimum.
-  int best = -1;
   uint32_t mindiff = UINT_MAX;
+  const bool solved = best >= 0;
 //fprintf(stderr, "%06x %06x\n%06x %06x\n%06x %06x\n", rgbas[0], rgbas[1], rgbas[2], rgbas[3], rgbas[4], rgbas[5]);
-  for(size_t glyph = 0 ; glyph < sizeof(partitions) / sizeof(*partitions) ; ++glyph){
+  for(size_t glyph = 0 ; !solved && glyph < sizeof(partitions) / sizeof(*partitions) ; ++glyph){
     unsigned rsum0 = 0, rsum1 = 0;
     unsigned gsum0 = 0, gsum1 = 0;
     unsigned bsum0 = 0, bsum1 = 0;
@@ -595,26 +751,18 @@ sex_solver(const uint32_t rgbas[6], uint64_t* channels, unsigned blendcolors,
     ncchannels_set_fg_alpha(channels, NCALPHA_BLEND);
     ncchannels_set_bg_alpha(channels, NCALPHA_BLEND);
   }
-  return sex[best];
+  return partitions[best];
 }
 
-static const char*
+// returns the glyph (index into sexglyphs[], 0 if the cell is entirely
+// transparent) if any pixels were transparent, or -1 otherwise.
+static int
 sex_trans_check(nccell* c, const uint32_t rgbas[6], unsigned blendcolors,
                 uint32_t transcolor, unsigned nointerpolate){
   // bit is *set* where sextant *is not*
   // 32: bottom right 16: bottom left
   //  8: middle right  4: middle left
   //  2: upper right   1: upper left
-  static const char* sex[64] = {
-    "█", "🬻", "🬺", "🬹", "🬸", "🬷", "🬶", "🬵",
-    "🬴", "🬳", "🬲", "🬱", "🬰", "🬯", "🬮", "🬭",
-    "🬬", "🬫", "🬪", "🬩", "🬨", "▐", "🬧", "🬦",
-    "🬥", "🬤", "🬣", "🬢", "🬡", "🬠", "🬟", "🬞",
-    "🬝", "🬜", "🬛", "🬚", "🬙", "🬘", "🬗", "🬖",
-    "🬕", "🬔", "▌", "🬓", "🬒", "🬑", "🬐", "🬏",
-    "🬎", "🬍", "🬌", "🬋", "🬊", "🬉", "🬈", "🬇",
-    "🬆", "🬅", "🬄", "🬃", "🬂", "🬁", "🬀", " ",
-  };
   unsigned transstring = 0;
   unsigned r = 0, g = 0, b = 0;
   unsigned div = 0;
@@ -629,17 +777,15 @@ sex_trans_check(nccell* c, const uint32_t rgbas[6], unsigned blendcolors,
     }
   }
   if(transstring == 0){ // there was no transparency
-    return NULL;
+    return -1;
   }
   nccell_set_bg_alpha(c, NCALPHA_TRANSPARENT);
   // there were some transparent pixels. since they get priority, the foreground
   // is just a general lerp across non-transparent pixels.
-  const char* egc = sex[transstring];
-  nccell_set_bg_alpha(c, NCALPHA_TRANSPARENT);
-//fprintf(stderr, "transtring: %u egc: %s\n", transtring, egc);
-  if(*egc == ' '){ // entirely transparent
+  const int egc = transstring ^ 63u;
+//fprintf(stderr, "transtring: %u egc: %d\n", transtring, egc);
+  if(egc == 0){ // entirely transparent
     nccell_set_fg_alpha(c, NCALPHA_TRANSPARENT);
-    return "";
   }else{ // partially transparent, thus div >= 1
 //fprintf(stderr, "div: %u r: %u g: %u b: %u\n", div, r, g, b);
     cell_set_fchannel(c, generalerp(r, g, b, div));
@@ -692,16 +838,14 @@ sextant_blit(ncplane* nc, int linesize, const void* data, int leny, int lenx,
       nccell* c = ncplane_cell_ref_yx(nc, y, x);
       c->channels = 0;
       c->stylemask = 0;
-      const char* egc = sex_trans_check(c, rgbas, blendcolors, bargs->transcolor, nointerpolate);
-      if(egc == NULL){ // no transparency; run a full solver
+      int egc = sex_trans_check(c, rgbas, blendcolors, bargs->transcolor, nointerpolate);
+      if(egc < 0){ // no transparency; run a full solver
         egc = sex_solver(rgbas, &c->channels, blendcolors, nointerpolate);
         cell_set_blitquadrants(c, 1, 1, 1, 1);
-      }
-//fprintf(stderr, "sex EGC: %s channels: %016lx\n", egc, c->channels);
-      if(*egc){
-        if(pool_blit_direct(&nc->pool, c, egc, strlen(egc), 1) <= 0){
-          return -1;
-        }
+        cell_blit_glyph(nc, c, sexglyphs[egc]);
+        ++total;
+      }else if(egc){
+        cell_blit_glyph(nc, c, sexglyphs[egc]);
         ++total;
       }else{
         nccell_release(nc, c);
@@ -832,14 +976,7 @@ braille_blit(ncplane* nc, int linesize, const void* data, int leny, int lenx,
         if(blends){
           nccell_set_fg_rgb8(c, r / blends, g / blends, b / blends);
         }
-        // UTF-8 encodings of the Braille Patterns are always 0xe2 0xaX 0xCC,
-        // where 0 <= X <= 3 and 0x80 <= CC <= 0xbf (4 groups of 64).
-        char egc[4] = { 0xe2, 0xa0, 0x80, 0x00 };
-        egc[2] += egcidx % 64;
-        egc[1] += egcidx / 64;
-        if(pool_blit_direct(&nc->pool, c, egc, strlen(egc), 1) <= 0){
-          return -1;
-        }
+        cell_blit_glyph(nc, c, brailleglyphs[egcidx]);
       }
       ++total;
     }
@@ -893,8 +1030,60 @@ void set_pixel_blitter(ncblitter blitfxn){
   b->blit = blitfxn;
 }
 
+// slots in each blitset's EGC->mask table; a power of two more than twice
+// the largest 'egcs' (braille's 256).
+#define EGCMASK_SLOTS 512
+
+typedef struct egcmask {
+  uint32_t wc;
+  int mask;  // index into 'egcs', or -1 for an empty slot
+} egcmask;
+
+static egcmask egcmasks[sizeof(notcurses_blitters) / sizeof(*notcurses_blitters)][EGCMASK_SLOTS];
+static pthread_once_t egcmask_once = PTHREAD_ONCE_INIT;
+
+static inline unsigned
+egcmask_hash(uint32_t wc){
+  return (wc * 2654435761u) & (EGCMASK_SLOTS - 1);
+}
+
+// open-addressed tables keyed by codepoint. where a glyph appears more than
+// once in 'egcs', the last index wins.
+static void
+egcmask_build(void){
+  for(size_t b = 0 ; b < sizeof(egcmasks) / sizeof(*egcmasks) ; ++b){
+    egcmask* slots = egcmasks[b];
+    for(unsigned i = 0 ; i < EGCMASK_SLOTS ; ++i){
+      slots[i].mask = -1;
+    }
+    const wchar_t* egcs = notcurses_blitters[b].egcs;
+    for(int j = 0 ; egcs && egcs[j] ; ++j){
+      unsigned h = egcmask_hash(egcs[j]);
+      while(slots[h].mask >= 0 && slots[h].wc != (uint32_t)egcs[j]){
+        h = (h + 1) & (EGCMASK_SLOTS - 1);
+      }
+      slots[h].wc = egcs[j];
+      slots[h].mask = j;
+    }
+  }
+}
+
+int blitset_egc_mask(const struct blitset* bset, uint32_t wc){
+  pthread_once(&egcmask_once, egcmask_build);
+  const egcmask* slots = egcmasks[bset - notcurses_blitters];
+  for(unsigned h = egcmask_hash(wc) ; slots[h].mask >= 0 ; h = (h + 1) & (EGCMASK_SLOTS - 1)){
+    if(slots[h].wc == wc){
+      return slots[h].mask;
+    }
+  }
+  return -1;
+}
+
+#undef EGCMASK_SLOTS
+
 const struct blitset* lookup_blitset(const tinfo* tcache, ncblitter_e setid,
                                      bool may_degrade){
+  pthread_once(&blitglyph_once, blitglyph_build);
   if(setid == NCBLIT_DEFAULT){ // ought have resolved NCBLIT_DEFAULT before now
     return NULL;
   }
@@ -1004,12 +1193,13 @@ int ncblit_bgrx(const void* data, int linesize, const struct ncvisual_options* v
     logerror("prohibited null plane");
     return -1;
   }
+  const arenamark mark = arena_mark();
   void* rdata = bgra_to_rgba(data, vopts->leny, &linesize, vopts->lenx, 0xff);
   if(rdata == NULL){
     return -1;
   }
   int r = ncblit_rgba(rdata, linesize, vopts);
-  free(rdata);
+  arena_release(mark);
   return r;
 }
 
@@ -1018,12 +1208,13 @@ int ncblit_rgb_loose(const void* data, int linesize,
   if(vopts->leny <= 0 || vopts->lenx <= 0){
     return -1;
   }
+  const arenamark mark = arena_mark();
   void* rdata = rgb_loose_to_rgba(data, vopts->leny, &linesize, vopts->lenx, alpha);
   if(rdata == NULL){
     return -1;
   }
   int r = ncblit_rgba(rdata, linesize, vopts);
-  free(rdata);
+  arena_release(mark);
   return r;
 }
 
@@ -1032,12 +1223,13 @@ int ncblit_rgb_packed(const void* data, int linesize,
   if(vopts->leny <= 0 || vopts->lenx <= 0){
     return -1;
   }
+  const arenamark mark = arena_mark();
   void* rdata = rgb_packed_to_rgba(data, vopts->leny, &linesize, vopts->lenx, alpha);
   if(rdata == NULL){
     return -1;
   }
   int r = ncblit_rgba(rdata, linesize, vopts);
-  free(rdata);
+  arena_release(mark);
   return r;
 }
 
@@ -0,0 +1,473 @@
+#include "internal.h"
+
+// a plane can serve as a window onto a sparse canvas much larger than itself
+// (see ncplane_set_canvas()). the canvas is a grid of CANVAS_TILE-square
+// tiles, each allocated only once something is stored in it. the window is
+// the plane's own framebuffer: cells move out of their tiles as they come into
+// view, and back into them as they leave it, so each cell lives in exactly
+// one place, and rendering never looks at the tiles. the tile cells beneath
+// the view are thus always zero, and a tile left empty by moving its cells
+// into view is freed. as with history, stored cells keep their EGCs in the
+// plane's pool (or its pile's intern table).
+#define CANVAS_TILE 64
+
+typedef struct nccanvas {
+  nccell** tiles;        // trows x tcols, NULL where nothing is stored
+  unsigned rows, cols;   // geometry in cells
+  unsigned trows, tcols; // geometry in tiles
+  unsigned y, x;         // canvas coordinate of the view's origin
+} nccanvas;
+
+static inline bool
+canvas_cell_empty_p(const nccell* c){
+  return !c->gcluster && !c->width && !c->stylemask && !c->channels;
+}
+
+static inline unsigned
+canvas_tileoff(unsigned y, unsigned x){
+  return (y % CANVAS_TILE) * CANVAS_TILE + x % CANVAS_TILE;
+}
+
+static inline bool
+canvas_inview_p(const ncplane* n, unsigned y, unsigned x){
+  const nccanvas* cv = n->canvas;
+  return y - cv->y < n->leny && x - cv->x < n->lenx;
+}
+
+// the cell at canvas coordinate |y|/|x|, wherever it currently lives. a
+// missing tile is created if |alloc| is set; otherwise (or on allocation
+// failure), NULL is returned.
+static nccell*
+canvas_cellref(const ncplane* n, unsigned y, unsigned x, bool alloc){
+  const nccanvas* cv = n->canvas;
+  if(canvas_inview_p(n, y, x)){
+    return &n->fb[nfbcellidx(n, y - cv->y, x - cv->x)];
+  }
+  nccell** t = &cv->tiles[(y / CANVAS_TILE) * cv->tcols + x / CANVAS_TILE];
+  if(*t == NULL){
+    if(!alloc){
+      return NULL;
+    }
+    if((*t = calloc(CANVAS_TILE * CANVAS_TILE, sizeof(**t))) == NULL){
+      logerror("couldn't allocate canvas tile");
+      return NULL;
+    }
+  }
+  return *t + canvas_tileoff(y, x);
+}
+
+// the cells [*lo, *hi) of tile |t| along one axis which are within the view
+// [vlo, vlo + vlen).
+static inline void
+canvas_tilespan(unsigned t, unsigned vlo, unsigned vlen, unsigned* lo, unsigned* hi){
+  *lo = t * CANVAS_TILE;
+  *hi = *lo + CANVAS_TILE;
+  if(*lo < vlo){
+    *lo = vlo;
+  }
+  if(*hi > vlo + vlen){
+    *hi = vlo + vlen;
+  }
+}
+
+// create any missing tile which must receive a cell from the view, should
+// the view be stowed. on failure, nothing has been stowed; any tiles created
+// are freed as the view is next loaded.
+int canvas_reserve(ncplane* n){
+  nccanvas* cv = n->canvas;
+  for(unsigned ty = cv->y / CANVAS_TILE ; ty <= (cv->y + n->leny - 1) / CANVAS_TILE ; ++ty){
+    unsigned ylo, yhi;
+    canvas_tilespan(ty, cv->y, n->leny, &ylo, &yhi);
+    for(unsigned tx = cv->x / CANVAS_TILE ; tx <= (cv->x + n->lenx - 1) / CANVAS_TILE ; ++tx){
+      nccell** t = &cv->tiles[ty * cv->tcols + tx];
+      if(*t){
+        continue;
+      }
+      unsigned xlo, xhi;
+      canvas_tilespan(tx, cv->x, n->lenx, &xlo, &xhi);
+      bool used = false;
+      for(unsigned y = ylo ; y < yhi && !used ; ++y){
+        const nccell* row = &n->fb[nfbcellidx(n, y - cv->y, 0)];
+        for(unsigned x = xlo ; x < xhi ; ++x){
+          if(!canvas_cell_empty_p(&row[x - cv->x])){
+            used = true;
+            break;
+          }
+        }
+      }
+      if(used){
+        if((*t = calloc(CANVAS_TILE * CANVAS_TILE, sizeof(**t))) == NULL){
+          logerror("couldn't allocate canvas tile");
+          return -1;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+// move the view's cells into their tiles, zeroing the framebuffer. the
+// tiles must have been reserved with canvas_reserve().
+void canvas_stow(ncplane* n){
+  nccanvas* cv = n->canvas;
+  for(unsigned y = 0 ; y < n->leny ; ++y){
+    nccell* row = &n->fb[nfbcellidx(n, y, 0)];
+    const unsigned cy = cv->y + y;
+    for(unsigned x = 0 ; x < n->lenx ; ++x){
+      if(!canvas_cell_empty_p(&row[x])){
+        const unsigned cx = cv->x + x;
+        nccell* t = cv->tiles[(cy / CANVAS_TILE) * cv->tcols + cx / CANVAS_TILE];
+        t[canvas_tileoff(cy, cx)] = row[x];
+      }
+    }
+    memset(row, 0, sizeof(*row) * n->lenx);
+  }
+}
+
+static bool
+canvas_tile_empty_p(const nccell* t){
+  for(unsigned i = 0 ; i < CANVAS_TILE * CANVAS_TILE ; ++i){
+    if(!canvas_cell_empty_p(&t[i])){
+      return false;
+    }
+  }
+  return true;
+}
+
+// move the view at |y|/|x| (clamped to the canvas) out of its tiles and into
+// the framebuffer, which must be zero (i.e. having been stowed). frees any
+// tile thus emptied.
+void canvas_load(ncplane* n, int y, int x){
+  nccanvas* cv = n->canvas;
+  if(y > (int)(cv->rows - n->leny)){
+    y = cv->rows - n->leny;
+  }
+  if(x > (int)(cv->cols - n->lenx)){
+    x = cv->cols - n->lenx;
+  }
+  cv->y = y < 0 ? 0 : y;
+  cv->x = x < 0 ? 0 : x;
+  for(unsigned ty = cv->y / CANVAS_TILE ; ty <= (cv->y + n->leny - 1) / CANVAS_TILE ; ++ty){
+    unsigned ylo, yhi;
+    canvas_tilespan(ty, cv->y, n->leny, &ylo, &yhi);
+    for(unsigned tx = cv->x / CANVAS_TILE ; tx <= (cv->x + n->lenx - 1) / CANVAS_TILE ; ++tx){
+      nccell** t = &cv->tiles[ty * cv->tcols + tx];
+      if(*t == NULL){
+        continue;
+      }
+      unsigned xlo, xhi;
+      canvas_tilespan(tx, cv->x, n->lenx, &xlo, &xhi);
+      for(unsigned cy = ylo ; cy < yhi ; ++cy){
+        nccell* src = *t + canvas_tileoff(cy, xlo);
+        memcpy(&n->fb[nfbcellidx(n, cy - cv->y, xlo - cv->x)], src,
+               sizeof(*src) * (xhi - xlo));
+        memset(src, 0, sizeof(*src) * (xhi - xlo));
+      }
+      if(canvas_tile_empty_p(*t)){
+        free(*t);
+        *t = NULL;
+      }
+    }
+  }
+  ncplane_damage(n);
+}
+
+// grow the canvas as necessary to hold at least |rows| x |cols| cells. the
+// canvas never shrinks.
+int canvas_fit(ncplane* n, unsigned rows, unsigned cols){
+  nccanvas* cv = n->canvas;
+  if(rows <= cv->rows && cols <= cv->cols){
+    return 0;
+  }
+  if(rows < cv->rows){
+    rows = cv->rows;
+  }
+  if(cols < cv->cols){
+    cols = cv->cols;
+  }
+  const unsigned trows = (rows + CANVAS_TILE - 1) / CANVAS_TILE;
+  const unsigned tcols = (cols + CANVAS_TILE - 1) / CANVAS_TILE;
+  if(trows != cv->trows || tcols != cv->tcols){
+    nccell** tiles = calloc((size_t)trows * tcols, sizeof(*tiles));
+    if(tiles == NULL){
+      logerror("couldn't allocate %ux%u canvas tiles", trows, tcols);
+      return -1;
+    }
+    for(unsigned ty = 0 ; ty < cv->trows ; ++ty){
+      memcpy(&tiles[ty * tcols], &cv->tiles[ty * cv->tcols],
+             sizeof(*tiles) * cv->tcols);
+    }
+    free(cv->tiles);
+    cv->tiles = tiles;
+    cv->trows = trows;
+    cv->tcols = tcols;
+  }
+  cv->rows = rows;
+  cv->cols = cols;
+  return 0;
+}
+
+void canvas_free(ncplane* n){
+  nccanvas* cv = n->canvas;
+  if(cv == NULL){
+    return;
+  }
+  for(unsigned i = 0 ; i < cv->trows * cv->tcols ; ++i){
+    nccell* t = cv->tiles[i];
+    if(t){
+      for(unsigned c = 0 ; c < CANVAS_TILE * CANVAS_TILE ; ++c){
+        nccell_release(n, &t[c]);
+      }
+      free(t);
+    }
+  }
+  free(cv->tiles);
+  free(cv);
+  n->canvas = NULL;
+}
+
+size_t canvas_bytes(const ncplane* n){
+  const nccanvas* cv = n->canvas;
+  if(cv == NULL){
+    return 0;
+  }
+  size_t ret = sizeof(*cv) + sizeof(*cv->tiles) * cv->trows * cv->tcols;
+  for(unsigned i = 0 ; i < cv->trows * cv->tcols ; ++i){
+    if(cv->tiles[i]){
+      ret += sizeof(**cv->tiles) * CANVAS_TILE * CANVAS_TILE;
+    }
+  }
+  return ret;
+}
+
+unsigned canvas_maxspans(const ncplane* n){
+  return n->canvas ? n->canvas->trows * n->canvas->tcols : 0;
+}
+
+unsigned canvas_spans(const ncplane* n, cellspan* spans){
+  const nccanvas* cv = n->canvas;
+  unsigned nspans = 0;
+  for(unsigned i = 0 ; cv && i < cv->trows * cv->tcols ; ++i){
+    if(cv->tiles[i]){
+      spans[nspans].cells = cv->tiles[i];
+      spans[nspans].count = CANVAS_TILE * CANVAS_TILE;
+      ++nspans;
+    }
+  }
+  return nspans;
+}
+
+int ncplane_set_canvas(ncplane* n, unsigned rows, unsigned cols){
+  if(rows == 0 && cols == 0){
+    canvas_free(n);
+    return 0;
+  }
+  if(n->sprite){
+    logerror("won't back a sprixel with a canvas");
+    return -1;
+  }
+  if(n->history){
+    logerror("won't back a plane keeping history with a canvas");
+    return -1;
+  }
+  if(rows < n->leny || cols < n->lenx){
+    logerror("canvas %ux%u can't hold %ux%u plane", rows, cols, n->leny, n->lenx);
+    return -1;
+  }
+  if(n->canvas){
+    if(rows < n->canvas->rows || cols < n->canvas->cols){
+      logerror("won't shrink %ux%u canvas to %ux%u", n->canvas->rows,
+               n->canvas->cols, rows, cols);
+      return -1;
+    }
+    return canvas_fit(n, rows, cols);
+  }
+  nccanvas* cv = malloc(sizeof(*cv));
+  if(cv == NULL){
+    return -1;
+  }
+  cv->rows = cv->cols = 0;
+  cv->trows = cv->tcols = 0;
+  cv->y = cv->x = 0;
+  cv->tiles = NULL;
+  n->canvas = cv;
+  if(canvas_fit(n, rows, cols)){
+    free(cv);
+    n->canvas = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+int ncplane_canvas_dim_yx(const ncplane* n, unsigned* rows, unsigned* cols){
+  const nccanvas* cv = n->canvas;
+  if(cv == NULL){
+    return -1;
+  }
+  if(rows){
+    *rows = cv->rows;
+  }
+  if(cols){
+    *cols = cv->cols;
+  }
+  return 0;
+}
+
+int ncplane_canvas_origin(const ncplane* n, unsigned* y, unsigned* x){
+  const nccanvas* cv = n->canvas;
+  if(cv == NULL){
+    return -1;
+  }
+  if(y){
+    *y = cv->y;
+  }
+  if(x){
+    *x = cv->x;
+  }
+  return 0;
+}
+
+int ncplane_canvas_pan(ncplane* n, unsigned y, unsigned x){
+  nccanvas* cv = n->canvas;
+  if(cv == NULL){
+    logerror("plane has no canvas");
+    return -1;
+  }
+  if(y > cv->rows - n->leny){
+    y = cv->rows - n->leny;
+  }
+  if(x > cv->cols - n->lenx){
+    x = cv->cols - n->lenx;
+  }
+  if(y == cv->y && x == cv->x){
+    return 0;
+  }
+  if(ncplane_own(n)){
+    return -1;
+  }
+  if(canvas_reserve(n)){
+    return -1;
+  }
+  canvas_stow(n);
+  canvas_load(n, y, x);
+  return 0;
+}
+
+// clear the entire glyph occupying canvas cell |y|/|x|, which might be the
+// right side of a wide glyph.
+static void
+canvas_obliterate(ncplane* n, unsigned y, unsigned x){
+  nccell* c;
+  unsigned lead = x;
+  while(lead && (c = canvas_cellref(n, y, lead, false)) && nccell_wide_right_p(c)){
+    --lead;
+  }
+  // orphaned right halves have no lead to clear
+  c = canvas_cellref(n, y, lead, false);
+  if(lead < x && (c == NULL || !nccell_wide_left_p(c))){
+    ++lead;
+  }
+  for(unsigned i = lead ; i < n->canvas->cols ; ++i){
+    if((c = canvas_cellref(n, y, i, false)) == NULL){
+      break;
+    }
+    if(i > lead && !nccell_wide_right_p(c)){
+      break;
+    }
+    nccell_release(n, c);
+    nccell_init(c);
+  }
+}
+
+int ncplane_canvas_putc_yx(ncplane* n, unsigned y, unsigned x, const nccell* c){
+  nccanvas* cv = n->canvas;
+  if(cv == NULL){
+    logerror("plane has no canvas");
+    return -1;
+  }
+  const unsigned cols = nccell_cols(c);
+  if(y >= cv->rows || x >= cv->cols || cols > cv->cols - x){
+    logerror("can't place %u-column glyph at %u/%u of %ux%u canvas",
+             cols, y, x, cv->rows, cv->cols);
+    return -1;
+  }
+  // |c| comes from |n|, and loading it into |n| could move the pool
+  char* egc = nccell_strdup(n, c);
+  if(egc == NULL){
+    logerror("couldn't duplicate cell");
+    return -1;
+  }
+  const int bytes = strlen(egc);
+  if(is_control_egc((const unsigned char*)egc, bytes)){
+    logerror("rejecting %dB control character", bytes);
+    free(egc);
+    return -1;
+  }
+  if(ncplane_own(n)){
+    free(egc);
+    return -1;
+  }
+  // create any tiles we'll need up front, so that we needn't unwind
+  for(unsigned i = 0 ; i < cols ; ++i){
+    if(canvas_cellref(n, y, x + i, true) == NULL){
+      free(egc);
+      return -1;
+    }
+  }
+  for(unsigned i = 0 ; i < cols ; ++i){
+    canvas_obliterate(n, y, x + i);
+  }
+  nccell* targ = canvas_cellref(n, y, x, false);
+  const uint16_t stylemask = c->stylemask;
+  const uint64_t channels = c->channels;
+  if(cell_load_direct(n, targ, egc, bytes, cols) < 0){
+    free(egc);
+    return -1;
+  }
+  free(egc);
+  targ->stylemask = stylemask;
+  targ->channels = channels;
+  for(unsigned i = 1 ; i < cols ; ++i){
+    nccell* candidate = canvas_cellref(n, y, x + i, false);
+    candidate->channels = targ->channels;
+    candidate->stylemask = targ->stylemask;
+    candidate->width = targ->width;
+  }
+  if(y - cv->y < n->leny){
+    ncplane_damage_rows(n, y - cv->y, 1);
+  }
+  return cols;
+}
+
+char* ncplane_canvas_at_yx(const ncplane* n, unsigned y, unsigned x,
+                           uint16_t* stylemask, uint64_t* channels){
+  const nccanvas* cv = n->canvas;
+  if(cv == NULL){
+    logerror("plane has no canvas");
+    return NULL;
+  }
+  if(y >= cv->rows || x >= cv->cols){
+    logerror("invalid coordinates: %u/%u", y, x);
+    return NULL;
+  }
+  if(canvas_inview_p(n, y, x)){
+    return ncplane_at_yx(n, y - cv->y, x - cv->x, stylemask, channels);
+  }
+  nccell blank = NCCELL_TRIVIAL_INITIALIZER;
+  const nccell* c = canvas_cellref(n, y, x, false);
+  if(c == NULL){
+    c = &blank;
+  }else if(nccell_wide_right_p(c) && x){
+    return ncplane_canvas_at_yx(n, y, x - 1, stylemask, channels);
+  }
+  char* ret = nccell_extract(n, c, stylemask, channels);
+  if(ret && strcmp(ret, "") == 0){
+    free(ret);
+    if( (ret = nccell_strdup(n, &n->basecell)) ){
+      if(stylemask){
+        *stylemask = n->basecell.stylemask;
+      }
+    }
+  }
+  return ret;
+}
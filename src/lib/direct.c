@@ -11,6 +11,145 @@
 #include "internal.h"
 #include "unixsig.h"
 
+// between ncdirect_begin_batch() and ncdirect_end_batch(), output gathers in
+// n->batch, and goes out in a single write upon ncdirect_flush(). otherwise,
+// it is written to ttyfp as it's produced. these helpers go to the right
+// place, returning a negative number on error.
+static inline int
+ncdirect_putn(ncdirect* n, const char* s, size_t len){
+  if(n->batch){
+    return fbuf_putn(n->batch, s, len) < 0 ? -1 : 0;
+  }
+  return fwrite(s, 1, len, n->ttyfp) == len ? 0 : -1;
+}
+
+static inline int
+ncdirect_puts(ncdirect* n, const char* s){
+  if(n->batch){
+    return fbuf_puts(n->batch, s);
+  }
+  return ncfputs(s, n->ttyfp);
+}
+
+static inline int
+ncdirect_putwc(ncdirect* n, wchar_t w){
+  if(n->batch){
+    return fbuf_printf(n->batch, "%lc", w);
+  }
+  return fprintf(n->ttyfp, "%lc", w);
+}
+
+// flush is ignored while batching
+static inline int
+ncdirect_emit(ncdirect* n, const char* esc, bool flush){
+  if(n->batch){
+    return fbuf_emit(n->batch, esc);
+  }
+  return term_emit(esc, n->ttyfp, flush);
+}
+
+// append |f| to the batch, or write it out. |f| is freed either way.
+static int
+ncdirect_finalize(ncdirect* n, fbuf* f){
+  if(n->batch){
+    int ret = 0;
+    if(f->used && fbuf_putn(n->batch, f->buf, f->used) < 0){
+      ret = -1;
+    }
+    fbuf_free(f);
+    return ret;
+  }
+  return fbuf_finalize(f, n->ttyfp);
+}
+
+// with NCDIRECT_OPTION_SHADOW_CURSOR, we track the cursor across our own
+// output, and only ask the terminal where it is (a full round trip) once
+// we've lost track of it. anything we can't account for (wrapping, control
+// characters, a failed write) invalidates the shadow.
+static inline void
+shadow_invalidate(ncdirect* n){
+  n->shadowvalid = false;
+}
+
+static void
+shadow_set(ncdirect* n, unsigned y, unsigned x){
+  if(!(n->flags & NCDIRECT_OPTION_SHADOW_CURSOR)){
+    return;
+  }
+  if(n->tcache.dimy == 0 || n->tcache.dimx == 0){
+    shadow_invalidate(n);
+    return;
+  }
+  n->shadowy = y < n->tcache.dimy ? y : n->tcache.dimy - 1;
+  n->shadowx = x < n->tcache.dimx ? x : n->tcache.dimx - 1;
+  n->shadowvalid = true;
+}
+
+// move the shadow, stopping at the margins as the cursor movement escapes
+// do. moving down from the last row scrolls, leaving us on the last row.
+static void
+shadow_move(ncdirect* n, int dy, int dx){
+  if(!n->shadowvalid){
+    return;
+  }
+  long y = (long)n->shadowy + dy;
+  long x = (long)n->shadowx + dx;
+  if(y < 0){
+    y = 0;
+  }else if(y >= n->tcache.dimy){
+    y = n->tcache.dimy - 1;
+  }
+  if(x < 0){
+    x = 0;
+  }else if(x >= n->tcache.dimx){
+    x = n->tcache.dimx - 1;
+  }
+  n->shadowy = y;
+  n->shadowx = x;
+}
+
+// |cols| columns of glyphs were written at the shadow. reaching the last
+// column leaves a wrap pending, which terminals resolve differently.
+static void
+shadow_advance(ncdirect* n, int cols){
+  if(!n->shadowvalid){
+    return;
+  }
+  if(cols < 0 || n->shadowx + cols >= n->tcache.dimx){
+    shadow_invalidate(n);
+    return;
+  }
+  n->shadowx += cols;
+}
+
+// |len| bytes of text were written at the shadow. the tty translates a
+// newline into a carriage return and line feed.
+static void
+shadow_text(ncdirect* n, const char* s, size_t len){
+  size_t off = 0;
+  while(n->shadowvalid && off < len){
+    const unsigned char c = s[off];
+    if(c == '\n' || c == '\r'){
+      n->shadowx = 0;
+      if(c == '\n'){
+        shadow_move(n, 1, 0);
+      }
+      ++off;
+    }else if(c < 0x20 || c == 0x7f){
+      shadow_invalidate(n);
+    }else{
+      int cols;
+      int bytes = utf8_egc_len(s + off, &cols);
+      if(bytes <= 0){
+        shadow_invalidate(n);
+      }else{
+        shadow_advance(n, cols);
+        off += bytes;
+      }
+    }
+  }
+}
+
 // conform to the foreground and background channels of 'channels'
 static int
 activate_channels(ncdirect* nc, uint64_t channels){
@@ -43,7 +182,13 @@ int ncdirect_putstr(ncdirect* nc, uint64_t channels, const char* utf8){
   if(activate_channels(nc, channels)){
     return -1;
   }
-  return ncfputs(utf8, nc->ttyfp);
+  int ret = ncdirect_puts(nc, utf8);
+  if(ret < 0){
+    shadow_invalidate(nc);
+    return ret;
+  }
+  shadow_text(nc, utf8, strlen(utf8));
+  return ret;
 }
 
 int ncdirect_putegc(ncdirect* nc, uint64_t channels, const char* utf8,
@@ -59,9 +204,11 @@ int ncdirect_putegc(ncdirect* nc, uint64_t channels, const char* utf8,
   if(activate_channels(nc, channels)){
     return -1;
   }
-  if(fprintf(nc->ttyfp, "%.*s", bytes, utf8) < 0){
+  if(ncdirect_putn(nc, utf8, bytes) < 0){
+    shadow_invalidate(nc);
     return -1;
   }
+  shadow_text(nc, utf8, bytes);
   return cols;
 }
 
@@ -75,7 +222,12 @@ int ncdirect_cursor_up(ncdirect* nc, int num){
   }
   const char* cuu = get_escape(&nc->tcache, ESCAPE_CUU);
   if(cuu){
-    return term_emit(tiparm(cuu, num), nc->ttyfp, false);
+    if(ncdirect_emit(nc, tiparm(cuu, num), false)){
+      shadow_invalidate(nc);
+      return -1;
+    }
+    shadow_move(nc, -num, 0);
+    return 0;
   }
   return -1;
 }
@@ -90,7 +242,12 @@ int ncdirect_cursor_left(ncdirect* nc, int num){
   }
   const char* cub = get_escape(&nc->tcache, ESCAPE_CUB);
   if(cub){
-    return term_emit(tiparm(cub, num), nc->ttyfp, false);
+    if(ncdirect_emit(nc, tiparm(cub, num), false)){
+      shadow_invalidate(nc);
+      return -1;
+    }
+    shadow_move(nc, 0, -num);
+    return 0;
   }
   return -1;
 }
@@ -105,7 +262,12 @@ int ncdirect_cursor_right(ncdirect* nc, int num){
   }
   const char* cuf = get_escape(&nc->tcache, ESCAPE_CUF);
   if(cuf){
-    return term_emit(tiparm(cuf, num), nc->ttyfp, false);
+    if(ncdirect_emit(nc, tiparm(cuf, num), false)){
+      shadow_invalidate(nc);
+      return -1;
+    }
+    shadow_move(nc, 0, num);
+    return 0;
   }
   return -1; // FIXME fall back to cuf1?
 }
@@ -124,10 +286,12 @@ int ncdirect_cursor_down(ncdirect* nc, int num){
   }
   int ret = 0;
   while(num--){
-    if(ncfputc('\v', nc->ttyfp) == EOF){
+    if(ncdirect_putn(nc, "\v", 1) < 0){
+      shadow_invalidate(nc);
       ret = -1;
       break;
     }
+    shadow_move(nc, 1, 0);
   }
   return ret;
 }
@@ -140,7 +304,12 @@ ncdirect_cursor_down_f(ncdirect* nc, int num, fbuf* f){
 int ncdirect_clear(ncdirect* nc){
   const char* clearscr = get_escape(&nc->tcache, ESCAPE_CLEAR);
   if(clearscr){
-    return term_emit(clearscr, nc->ttyfp, true);
+    if(ncdirect_emit(nc, clearscr, true)){
+      shadow_invalidate(nc);
+      return -1;
+    }
+    shadow_set(nc, 0, 0);
+    return 0;
   }
   return -1;
 }
@@ -149,7 +318,12 @@ unsigned ncdirect_dim_x(ncdirect* nc){
   unsigned x;
   if(nc->tcache.ttyfd >= 0){
     unsigned cgeo, pgeo; // don't care about either
+    const unsigned oldy = nc->tcache.dimy;
+    const unsigned oldx = nc->tcache.dimx;
     if(update_term_dimensions(NULL, &x, &nc->tcache, 0, &cgeo, &pgeo) == 0){
+      if(oldy != nc->tcache.dimy || oldx != nc->tcache.dimx){
+        shadow_invalidate(nc);
+      }
       return x;
     }
   }else{
@@ -162,7 +336,12 @@ unsigned ncdirect_dim_y(ncdirect* nc){
   unsigned y;
   if(nc->tcache.ttyfd >= 0){
     unsigned cgeo, pgeo; // don't care about either
+    const unsigned oldy = nc->tcache.dimy;
+    const unsigned oldx = nc->tcache.dimx;
     if(update_term_dimensions(&y, NULL, &nc->tcache, 0, &cgeo, &pgeo) == 0){
+      if(oldy != nc->tcache.dimy || oldx != nc->tcache.dimx){
+        shadow_invalidate(nc);
+      }
       return y;
     }
   }else{
@@ -174,7 +353,7 @@ unsigned ncdirect_dim_y(ncdirect* nc){
 int ncdirect_cursor_enable(ncdirect* nc){
   const char* cnorm = get_escape(&nc->tcache, ESCAPE_CNORM);
   if(cnorm){
-    return term_emit(cnorm, nc->ttyfp, true);
+    return ncdirect_emit(nc, cnorm, true);
   }
   return -1;
 }
@@ -182,7 +361,7 @@ int ncdirect_cursor_enable(ncdirect* nc){
 int ncdirect_cursor_disable(ncdirect* nc){
   const char* cinvis = get_escape(&nc->tcache, ESCAPE_CIVIS);
   if(cinvis){
-    return term_emit(cinvis, nc->ttyfp, true);
+    return ncdirect_emit(nc, cinvis, true);
   }
   return -1;
 }
@@ -202,9 +381,16 @@ cursor_yx_get(ncdirect* n, const char* u7, unsigned* y, unsigned* x){
   }
   if(get_cursor_location(ictx, u7, y, x)){
     logerror("couldn't get cursor position");
+    shadow_invalidate(n);
     return -1;
   }
   loginfo("cursor at y=%u x=%u\n", *y, *x);
+  if(n->flags & NCDIRECT_OPTION_SHADOW_CURSOR){
+    unsigned cgeo, pgeo; // don't care about either
+    if(update_term_dimensions(NULL, NULL, &n->tcache, 0, &cgeo, &pgeo) == 0){
+      shadow_set(n, *y, *x);
+    }
+  }
   return 0;
 }
 
@@ -219,7 +405,16 @@ int ncdirect_cursor_move_yx(ncdirect* n, int y, int x){
   const char* u7 = get_escape(&n->tcache, ESCAPE_U7);
   if(y == -1){ // keep row the same, horizontal move only
     if(hpa){
-      return term_emit(tiparm(hpa, x), n->ttyfp, false);
+      if(ncdirect_emit(n, tiparm(hpa, x), false)){
+        shadow_invalidate(n);
+        return -1;
+      }
+      if(n->shadowvalid){
+        shadow_set(n, n->shadowy, x);
+      }
+      return 0;
+    }else if(n->shadowvalid){
+      y = n->shadowy;
     }else if(n->tcache.ttyfd >= 0 && u7){
       unsigned yprime;
       if(cursor_yx_get(n, u7, &yprime, NULL)){
@@ -230,8 +425,17 @@ int ncdirect_cursor_move_yx(ncdirect* n, int y, int x){
       y = 0;
     }
   }else if(x == -1){ // keep column the same, vertical move only
-    if(!vpa){
-      return term_emit(tiparm(vpa, y), n->ttyfp, false);
+    if(vpa){
+      if(ncdirect_emit(n, tiparm(vpa, y), false)){
+        shadow_invalidate(n);
+        return -1;
+      }
+      if(n->shadowvalid){
+        shadow_set(n, y, n->shadowx);
+      }
+      return 0;
+    }else if(n->shadowvalid){
+      x = n->shadowx;
     }else if(n->tcache.ttyfd >= 0 && u7){
       unsigned xprime;
       if(cursor_yx_get(n, u7, NULL, &xprime)){
@@ -244,13 +448,18 @@ int ncdirect_cursor_move_yx(ncdirect* n, int y, int x){
   }
   const char* cup = get_escape(&n->tcache, ESCAPE_CUP);
   if(cup){
-    return term_emit(tiparm(cup, y, x), n->ttyfp, false);
+    if(ncdirect_emit(n, tiparm(cup, y, x), false) == 0){
+      shadow_set(n, y, x);
+      return 0;
+    }
   }else if(vpa && hpa){
-    if(term_emit(tiparm(hpa, x), n->ttyfp, false) == 0 &&
-       term_emit(tiparm(vpa, y), n->ttyfp, false) == 0){
+    if(ncdirect_emit(n, tiparm(hpa, x), false) == 0 &&
+       ncdirect_emit(n, tiparm(vpa, y), false) == 0){
+      shadow_set(n, y, x);
       return 0;
     }
   }
+  shadow_invalidate(n);
   return -1; // we will not be moving the cursor today
 }
 
@@ -377,6 +586,15 @@ int ncdirect_cursor_yx(ncdirect* n, unsigned* y, unsigned* x){
   if(n->tcache.ttyfd < 0){
     return -1;
   }
+  if(n->shadowvalid){
+    if(y){
+      *y = n->shadowy;
+    }
+    if(x){
+      *x = n->shadowx;
+    }
+    return 0;
+  }
   const char* u7 = get_escape(&n->tcache, ESCAPE_U7);
   if(u7 == NULL){
     fprintf(stderr, "Terminal doesn't support cursor reporting\n");
@@ -392,10 +610,29 @@ int ncdirect_cursor_yx(ncdirect* n, unsigned* y, unsigned* x){
   return cursor_yx_get(n, u7, y, x);
 }
 
+int ncdirect_cursor_resync(ncdirect* n){
+  shadow_invalidate(n);
+  if(n->tcache.ttyfd < 0){
+    return -1;
+  }
+  const char* u7 = get_escape(&n->tcache, ESCAPE_U7);
+  if(u7 == NULL){
+    logerror("terminal doesn't support cursor reporting\n");
+    return -1;
+  }
+  return cursor_yx_get(n, u7, NULL, NULL);
+}
+
 int ncdirect_cursor_push(ncdirect* n){
   const char* sc = get_escape(&n->tcache, ESCAPE_SC);
   if(sc){
-    return term_emit(sc, n->ttyfp, false);
+    if(ncdirect_emit(n, sc, false)){
+      return -1;
+    }
+    n->pushedvalid = n->shadowvalid;
+    n->pushedy = n->shadowy;
+    n->pushedx = n->shadowx;
+    return 0;
   }
   return -1;
 }
@@ -403,7 +640,16 @@ int ncdirect_cursor_push(ncdirect* n){
 int ncdirect_cursor_pop(ncdirect* n){
   const char* rc = get_escape(&n->tcache, ESCAPE_RC);
   if(rc){
-    return term_emit(rc, n->ttyfp, false);
+    if(ncdirect_emit(n, rc, false)){
+      shadow_invalidate(n);
+      return -1;
+    }
+    if(n->pushedvalid){
+      shadow_set(n, n->pushedy, n->pushedx);
+    }else{
+      shadow_invalidate(n);
+    }
+    return 0;
   }
   return -1;
 }
@@ -513,8 +759,11 @@ ncdirect_set_fg_default_f(ncdirect* nc, fbuf* f){
   return 0;
 }
 
+// 'ybase' is the row of the image at which 'np' begins, when it is one band of
+// a larger image.
 static int
-ncdirect_dump_cellplane(ncdirect* n, const ncplane* np, fbuf* f, int xoff){
+ncdirect_dump_cellplane(ncdirect* n, const ncplane* np, fbuf* f, int xoff,
+                        unsigned ybase){
   unsigned dimy, dimx;
   ncplane_dim_yx(np, &dimy, &dimx);
   const unsigned toty = ncdirect_dim_y(n);
@@ -523,6 +772,11 @@ ncdirect_dump_cellplane(ncdirect* n, const ncplane* np, fbuf* f, int xoff){
   const bool bgdefault = ncdirect_bg_default_p(n);
   const uint32_t fgrgb = ncchannels_fg_rgb(n->channels);
   const uint32_t bgrgb = ncchannels_bg_rgb(n->channels);
+  // the first row starts wherever we are, the remainder at xoff
+  if(n->shadowvalid && (n->shadowx + dimx >= n->tcache.dimx ||
+                        xoff + dimx >= n->tcache.dimx)){
+    shadow_invalidate(n);
+  }
   for(unsigned y = 0 ; y < dimy ; ++y){
     for(unsigned x = 0 ; x < dimx ; ++x){
       uint16_t stylemask;
@@ -558,10 +812,15 @@ ncdirect_dump_cellplane(ncdirect* n, const ncplane* np, fbuf* f, int xoff){
     if(fbuf_printf(f, "\n%*.*s", xoff, xoff, "") < 0){
       return -1;
     }
-    if(y == toty){
+    if(n->shadowvalid){
+      n->shadowx = xoff;
+      shadow_move(n, 1, 0);
+    }
+    if(ybase + y == toty){
       if(ncdirect_cursor_down_f(n, 1, f)){
         return -1;
       }
+      shadow_move(n, 1, 0);
     }
   }
   // restore the previous colors
@@ -603,6 +862,9 @@ ncdirect_dump_plane(ncdirect* n, const ncplane* np, int xoff){
       if(n->tcache.pixel_draw_late(&n->tcache, np->sprite, y, xoff) < 0){
         return -1;
       }
+      if(n->tcache.pixel_flush && n->tcache.pixel_flush(&n->tcache) < 0){
+        return -1;
+      }
     }
     int targy = y + ncplane_dim_y(np);
     const int toty = ncdirect_dim_y(n);
@@ -613,11 +875,11 @@ ncdirect_dump_plane(ncdirect* n, const ncplane* np, int xoff){
       return -1;
     }
   }else{
-    if(ncdirect_dump_cellplane(n, np, &f, xoff)){
+    if(ncdirect_dump_cellplane(n, np, &f, xoff, 0)){
       fbuf_free(&f);
       return -1;
     }
-    if(fbuf_finalize(&f, n->ttyfp)){
+    if(ncdirect_finalize(n, &f)){
       return -1;
     }
   }
@@ -628,24 +890,27 @@ int ncdirect_raster_frame(ncdirect* n, ncdirectv* ncdv, ncalign_e align){
   int lenx = ncplane_dim_x(ncdv);
   int xoff = ncdirect_align(n, align, lenx);
   int r = ncdirect_dump_plane(n, ncdv, xoff);
+  if(r){
+    shadow_invalidate(n);
+  }
   free_plane(ncdv);
   return r;
 }
 
-static ncdirectv*
-ncdirect_render_visual(ncdirect* n, ncvisual* ncv,
-                       const struct ncvisual_options* vopts){
-  struct ncvisual_options defvopts = {0};
-  if(!vopts){
-    vopts = &defvopts;
-  }
+// work out the blitter, the scaled pixel geometry, and the size of the plane
+// needed to render 'ncv' according to 'vopts'.
+static int
+ncdirect_visual_layout(ncdirect* n, const ncvisual* ncv,
+                       const struct ncvisual_options* vopts,
+                       const struct blitset** rbset, unsigned* rdisprows,
+                       unsigned* rdispcols, ncplane_options* nopts){
 //fprintf(stderr, "OUR DATA: %p rows/cols: %d/%d outsize: %d/%d %d/%d\n", ncv->data, ncv->pixy, ncv->pixx, dimy, dimx, ymax, xmax);
 //fprintf(stderr, "render %d/%d to scaling: %d\n", ncv->pixy, ncv->pixx, vopts->scaling);
   const struct blitset* bset = rgba_blitter_low(&n->tcache, vopts->scaling,
                                                 !(vopts->flags & NCVISUAL_OPTION_NODEGRADE),
                                                 vopts->blitter);
   if(!bset){
-    return NULL;
+    return -1;
   }
   unsigned ymax = vopts->leny / bset->height;
   unsigned xmax = vopts->lenx / bset->width;
@@ -686,25 +951,38 @@ ncdirect_render_visual(ncdirect* n, ncvisual* ncv,
   }
 //fprintf(stderr, "max: %d/%d out: %d/%d\n", ymax, xmax, outy, dispcols);
 //fprintf(stderr, "render: %d/%d stride %u %p\n", ncv->pixy, ncv->pixx, ncv->rowstride, ncv->data);
-  ncplane_options nopts = {
-    .y = 0,
-    .x = 0,
-    .rows = outy / encoding_y_scale(&n->tcache, bset),
-    .cols = dispcols / encoding_x_scale(&n->tcache, bset),
-    .userptr = NULL,
-    .name = "fake",
-    .resizecb = NULL,
-    .flags = 0,
-  };
+  memset(nopts, 0, sizeof(*nopts));
+  nopts->rows = outy / encoding_y_scale(&n->tcache, bset);
+  nopts->cols = dispcols / encoding_x_scale(&n->tcache, bset);
+  nopts->name = "fake";
   if(bset->geom == NCBLIT_PIXEL){
-    nopts.rows = outy / n->tcache.cellpxy + !!(outy % n->tcache.cellpxy);
-    nopts.cols = dispcols / n->tcache.cellpxx + !!(dispcols % n->tcache.cellpxx);
+    nopts->rows = outy / n->tcache.cellpxy + !!(outy % n->tcache.cellpxy);
+    nopts->cols = dispcols / n->tcache.cellpxx + !!(dispcols % n->tcache.cellpxx);
+  }
+  if(ymax && nopts->rows > ymax){
+    nopts->rows = ymax;
   }
-  if(ymax && nopts.rows > ymax){
-    nopts.rows = ymax;
+  if(xmax && nopts->cols > xmax){
+    nopts->cols = xmax;
   }
-  if(xmax && nopts.cols > xmax){
-    nopts.cols = xmax;
+  *rbset = bset;
+  *rdisprows = disprows;
+  *rdispcols = dispcols;
+  return 0;
+}
+
+static ncdirectv*
+ncdirect_render_visual(ncdirect* n, ncvisual* ncv,
+                       const struct ncvisual_options* vopts){
+  struct ncvisual_options defvopts = {0};
+  if(!vopts){
+    vopts = &defvopts;
+  }
+  const struct blitset* bset;
+  unsigned disprows, dispcols;
+  ncplane_options nopts;
+  if(ncdirect_visual_layout(n, ncv, vopts, &bset, &disprows, &dispcols, &nopts)){
+    return NULL;
   }
   struct ncplane* ncdv = ncplane_new_internal(NULL, NULL, &nopts);
   if(!ncdv){
@@ -736,6 +1014,105 @@ ncdirect_render_visual(ncdirect* n, ncvisual* ncv,
   return ncdv;
 }
 
+// cell rows blitted and written at a time by ncdirect_stream_visual()
+#define DIRECT_BAND_ROWS 32
+
+// render 'ncv' using a cell blitter, DIRECT_BAND_ROWS rows at a time, writing
+// out each band as soon as it has been blitted. only a band's worth of scaled
+// pixels and cells is ever held. the geometry is that which
+// ncdirect_render_visual() would use; the rendered size is written to 'rrows'
+// and 'rcols'. bitmaps must be emitted whole, and can't be streamed.
+static int
+ncdirect_stream_visual(ncdirect* n, const ncvisual* ncv,
+                       const struct ncvisual_options* vopts, ncalign_e align,
+                       unsigned* rrows, unsigned* rcols){
+  const struct blitset* bset;
+  unsigned disprows, dispcols;
+  ncplane_options nopts;
+  if(ncdirect_visual_layout(n, ncv, vopts, &bset, &disprows, &dispcols, &nopts)){
+    return -1;
+  }
+  if(bset->geom == NCBLIT_PIXEL){
+    logerror("can't stream bitmap graphics");
+    return -1;
+  }
+  const unsigned yscale = encoding_y_scale(&n->tcache, bset);
+  const unsigned totrows = nopts.rows;
+  if(nopts.rows > DIRECT_BAND_ROWS){
+    nopts.rows = DIRECT_BAND_ROWS;
+  }
+  ncplane* band = ncplane_new_internal(NULL, NULL, &nopts);
+  if(band == NULL){
+    return -1;
+  }
+  blitterargs bargs = {0};
+  bargs.flags = vopts->flags;
+  if(vopts->flags & NCVISUAL_OPTION_ADDALPHA){
+    bargs.transcolor = vopts->transcolor | 0x1000000ull;
+  }
+  int xoff = ncdirect_align(n, align, nopts.cols);
+  if(xoff){
+    if(ncdirect_cursor_move_yx(n, -1, xoff)){
+      free_plane(band);
+      return -1;
+    }
+  }
+  int ret = 0;
+  for(unsigned r0 = 0 ; r0 < totrows ; r0 += DIRECT_BAND_ROWS){
+    unsigned r1 = r0 + DIRECT_BAND_ROWS;
+    if(r1 > totrows){
+      r1 = totrows;
+    }
+    unsigned py0 = r0 * yscale;
+    unsigned py1 = r1 * yscale;
+    if(py1 > disprows){
+      py1 = disprows;
+    }
+    if(py0 >= py1){
+      break;
+    }
+    // the last band is usually short; it gets a plane of its own height
+    if(r1 - r0 != ncplane_dim_y(band)){
+      free_plane(band);
+      nopts.rows = r1 - r0;
+      if((band = ncplane_new_internal(NULL, NULL, &nopts)) == NULL){
+        return -1;
+      }
+    }else{
+      ncplane_erase(band);
+    }
+    if(ncvisual_blit_rows(ncv, disprows, dispcols, py0, py1, band, bset, &bargs)){
+      ret = -1;
+      break;
+    }
+    fbuf f;
+    if(fbuf_init(&f)){
+      ret = -1;
+      break;
+    }
+    if(ncdirect_dump_cellplane(n, band, &f, xoff, r0)){
+      fbuf_free(&f);
+      ret = -1;
+      break;
+    }
+    if(ncdirect_finalize(n, &f)){
+      ret = -1;
+      break;
+    }
+  }
+  if(rrows){
+    *rrows = totrows;
+  }
+  if(rcols){
+    *rcols = nopts.cols;
+  }
+  if(ret){
+    shadow_invalidate(n);
+  }
+  free_plane(band);
+  return ret;
+}
+
 ncdirectv* ncdirect_render_frame(ncdirect* n, const char* file,
                                  ncblitter_e blitfxn, ncscale_e scale,
                                  int ymax, int xmax){
@@ -771,6 +1148,24 @@ ncdirectv* ncdirect_render_frame(ncdirect* n, const char* file,
 
 int ncdirect_render_image(ncdirect* n, const char* file, ncalign_e align,
                           ncblitter_e blitfxn, ncscale_e scale){
+  const struct blitset* bset = rgba_blitter_low(&n->tcache, scale, true, blitfxn);
+  if(!bset){
+    return -1;
+  }
+  if(bset->geom != NCBLIT_PIXEL){
+    ncdirectf* ncv = ncdirectf_from_file(n, file);
+    if(ncv == NULL){
+      return -1;
+    }
+    struct ncvisual_options vopts = {
+      .blitter = bset->geom,
+      .flags = NCVISUAL_OPTION_NODEGRADE,
+      .scaling = scale,
+    };
+    int r = ncdirect_stream_visual(n, ncv, &vopts, align, NULL, NULL);
+    ncvisual_destroy(ncv);
+    return r;
+  }
   ncdirectv* faken = ncdirect_render_frame(n, file, blitfxn, scale, 0, 0);
   if(!faken){
     return -1;
@@ -778,6 +1173,30 @@ int ncdirect_render_image(ncdirect* n, const char* file, ncalign_e align,
   return ncdirect_raster_frame(n, faken, align);
 }
 
+static int
+ncdirect_set_fg_palindex_f(ncdirect* nc, int pidx, fbuf* f){
+  const char* setaf = get_escape(&nc->tcache, ESCAPE_SETAF);
+  if(!setaf){
+    return -1;
+  }
+  if(ncchannels_set_fg_palindex(&nc->channels, pidx) < 0){
+    return -1;
+  }
+  return fbuf_emit(f, tiparm(setaf, pidx));
+}
+
+static int
+ncdirect_set_bg_palindex_f(ncdirect* nc, int pidx, fbuf* f){
+  const char* setab = get_escape(&nc->tcache, ESCAPE_SETAB);
+  if(!setab){
+    return -1;
+  }
+  if(ncchannels_set_bg_palindex(&nc->channels, pidx) < 0){
+    return -1;
+  }
+  return fbuf_emit(f, tiparm(setab, pidx));
+}
+
 int ncdirect_set_fg_palindex(ncdirect* nc, int pidx){
   const char* setaf = get_escape(&nc->tcache, ESCAPE_SETAF);
   if(!setaf){
@@ -786,7 +1205,7 @@ int ncdirect_set_fg_palindex(ncdirect* nc, int pidx){
   if(ncchannels_set_fg_palindex(&nc->channels, pidx) < 0){
     return -1;
   }
-  return term_emit(tiparm(setaf, pidx), nc->ttyfp, false);
+  return ncdirect_emit(nc, tiparm(setaf, pidx), false);
 }
 
 int ncdirect_set_bg_palindex(ncdirect* nc, int pidx){
@@ -797,7 +1216,7 @@ int ncdirect_set_bg_palindex(ncdirect* nc, int pidx){
   if(ncchannels_set_bg_palindex(&nc->channels, pidx) < 0){
     return -1;
   }
-  return term_emit(tiparm(setab, pidx), nc->ttyfp, false);
+  return ncdirect_emit(nc, tiparm(setab, pidx), false);
 }
 
 int ncdirect_vprintf_aligned(ncdirect* n, int y, ncalign_e align, const char* fmt, va_list ap){
@@ -815,11 +1234,15 @@ int ncdirect_vprintf_aligned(ncdirect* n, int y, ncalign_e align, const char* fm
     free(r);
     return -1;
   }
-  int ret = puts(r);
-  free(r);
-  if(ret == EOF){
+  int ret = ncdirect_puts(n, r);
+  if(ret < 0 || ncdirect_putn(n, "\n", 1) < 0){
+    shadow_invalidate(n);
+    free(r);
     return -1;
   }
+  shadow_text(n, r, strlen(r));
+  shadow_text(n, "\n", 1);
+  free(r);
   return ret;
 }
 
@@ -869,7 +1292,7 @@ ncdirect* ncdirect_core_init(const char* termtype, FILE* outfp, uint64_t flags){
   if(outfp == NULL){
     outfp = stdout;
   }
-  if(flags > (NCDIRECT_OPTION_DRAIN_INPUT << 1)){ // allow them through with warning
+  if(flags >= (NCDIRECT_OPTION_SHADOW_CURSOR << 1u)){ // allow them through with warning
     logwarn("Passed unsupported flags 0x%016" PRIx64 "\n", flags);
   }
   if(termtype){
@@ -917,7 +1340,7 @@ ncdirect* ncdirect_core_init(const char* termtype, FILE* outfp, uint64_t flags){
   if(interrogate_terminfo(&ret->tcache, ret->ttyfp, utf8, 1,
                           flags & NCDIRECT_OPTION_INHIBIT_CBREAK,
                           0, &cursor_y, &cursor_x, &ret->stats, 0, 0, 0, 0,
-                          flags & NCDIRECT_OPTION_DRAIN_INPUT)){
+                          flags & NCDIRECT_OPTION_DRAIN_INPUT, 0)){
     goto err;
   }
   if(cursor_y >= 0){
@@ -935,7 +1358,11 @@ ncdirect* ncdirect_core_init(const char* termtype, FILE* outfp, uint64_t flags){
   }
   unsigned cgeo, pgeo; // both are don't-cares
   update_term_dimensions(NULL, NULL, &ret->tcache, 0, &cgeo, &pgeo);
+  if(cursor_y >= 0){
+    shadow_set(ret, cursor_y, cursor_x);
+  }
   ncdirect_set_styles(ret, 0);
+  nctrace_init();
   return ret;
 
 err:
@@ -951,11 +1378,13 @@ err:
 int ncdirect_stop(ncdirect* nc){
   int ret = 0;
   if(nc){
+    ret |= ncdirect_end_batch(nc);
     ret |= ncdirect_stop_minimal(nc);
     free_terminfo_cache(&nc->tcache);
     if(nc->tcache.ttyfd >= 0){
       ret |= close(nc->tcache.ttyfd);
     }
+    ret |= nctrace_fini();
     pthread_mutex_destroy(&nc->stats.lock);
     free(nc);
   }
@@ -974,7 +1403,8 @@ int ncdirect_stop(ncdirect* nc){
 // we've changed line, assume the prompt has scrolled up, and account for
 // that. we return to the prompt, clear any affected lines, and reprint what
 // we have.
-char* ncdirect_readline(ncdirect* n, const char* prompt){
+static char*
+ncdirect_readline_inner(ncdirect* n, const char* prompt){
   const char* u7 = get_escape(&n->tcache, ESCAPE_U7);
   if(!u7){ // we probably *can*, but it would be a pita; screw it
     logerror("can't readline without u7");
@@ -1096,7 +1526,7 @@ char* ncdirect_readline(ncdirect* n, const char* prompt){
       if(ncdirect_cursor_move_yx(n, i, i > tline ? 0 : xstart)){
         break;
       }
-      if(term_emit(el, n->ttyfp, false)){
+      if(ncdirect_emit(n, el, false)){
         break;
       }
     }
@@ -1119,6 +1549,23 @@ char* ncdirect_readline(ncdirect* n, const char* prompt){
   return NULL;
 }
 
+// readline interleaves its output with cursor location queries, so any batch
+// is written out, and suspended for the duration.
+char* ncdirect_readline(ncdirect* n, const char* prompt){
+  fbuf* batch = n->batch;
+  if(batch){
+    if(ncdirect_flush(n)){
+      return NULL;
+    }
+    n->batch = NULL;
+  }
+  char* ret = ncdirect_readline_inner(n, prompt);
+  // we don't know what the user typed, nor how the tty echoed it
+  shadow_invalidate(n);
+  n->batch = batch;
+  return ret;
+}
+
 static inline int
 ncdirect_style_emit(ncdirect* n, unsigned stylebits, fbuf* f){
   unsigned normalized = 0;
@@ -1127,27 +1574,27 @@ ncdirect_style_emit(ncdirect* n, unsigned stylebits, fbuf* f){
   if(normalized){
     // emitting an sgr resets colors. if we want to be default, that's no
     // problem, and our channels remain correct. otherwise, clear our
-    // channel, and set them back up.
+    // channel, and set them back up. the colors go into |f| behind the sgr.
     if(!ncdirect_fg_default_p(n)){
       if(!ncdirect_fg_palindex_p(n)){
         uint32_t fg = ncchannels_fg_rgb(n->channels);
         ncchannels_set_fg_default(&n->channels);
-        r |= ncdirect_set_fg_rgb(n, fg);
+        r |= ncdirect_set_fg_rgb_f(n, fg, f);
       }else{ // palette-indexed
         uint32_t fg = ncchannels_fg_palindex(n->channels);
         ncchannels_set_fg_default(&n->channels);
-        r |= ncdirect_set_fg_palindex(n, fg);
+        r |= ncdirect_set_fg_palindex_f(n, fg, f);
       }
     }
     if(!ncdirect_bg_default_p(n)){
       if(!ncdirect_bg_palindex_p(n)){
         uint32_t bg = ncchannels_bg_rgb(n->channels);
         ncchannels_set_bg_default(&n->channels);
-        r |= ncdirect_set_bg_rgb(n, bg);
+        r |= ncdirect_set_bg_rgb_f(n, bg, f);
       }else{ // palette-indexed
         uint32_t bg = ncchannels_bg_palindex(n->channels);
         ncchannels_set_bg_default(&n->channels);
-        r |= ncdirect_set_bg_palindex(n, bg);
+        r |= ncdirect_set_bg_palindex_f(n, bg, f);
       }
     }
   }
@@ -1159,6 +1606,9 @@ int ncdirect_on_styles(ncdirect* n, unsigned stylebits){
     return -1;
   }
   uint32_t stylemask = n->stylemask | stylebits;
+  if(n->batch){
+    return ncdirect_style_emit(n, stylemask, n->batch);
+  }
   fbuf f = {0};
   if(fbuf_init_small(&f)){
     return -1;
@@ -1180,6 +1630,9 @@ uint16_t ncdirect_styles(const ncdirect* n){
 // turn off any specified stylebits
 int ncdirect_off_styles(ncdirect* n, unsigned stylebits){
   uint32_t stylemask = n->stylemask & ~stylebits;
+  if(n->batch){
+    return ncdirect_style_emit(n, stylemask, n->batch);
+  }
   fbuf f = {0};
   if(fbuf_init_small(&f)){
     return -1;
@@ -1200,6 +1653,9 @@ int ncdirect_set_styles(ncdirect* n, unsigned stylebits){
     return -1;
   }
   uint32_t stylemask = stylebits;
+  if(n->batch){
+    return ncdirect_style_emit(n, stylemask, n->batch);
+  }
   fbuf f = {0};
   if(fbuf_init_small(&f)){
     return -1;
@@ -1224,11 +1680,11 @@ int ncdirect_set_fg_default(ncdirect* nc){
   }
   const char* esc;
   if((esc = get_escape(&nc->tcache, ESCAPE_FGOP)) != NULL){
-    if(term_emit(esc, nc->ttyfp, false)){
+    if(ncdirect_emit(nc, esc, false)){
       return -1;
     }
   }else if((esc = get_escape(&nc->tcache, ESCAPE_OP)) != NULL){
-    if(term_emit(esc, nc->ttyfp, false)){
+    if(ncdirect_emit(nc, esc, false)){
       return -1;
     }
     if(!ncdirect_bg_default_p(nc)){
@@ -1247,11 +1703,11 @@ int ncdirect_set_bg_default(ncdirect* nc){
   }
   const char* esc;
   if((esc = get_escape(&nc->tcache, ESCAPE_BGOP)) != NULL){
-    if(term_emit(esc, nc->ttyfp, false)){
+    if(ncdirect_emit(nc, esc, false)){
       return -1;
     }
   }else if((esc = get_escape(&nc->tcache, ESCAPE_OP)) != NULL){
-    if(term_emit(esc, nc->ttyfp, false)){
+    if(ncdirect_emit(nc, esc, false)){
       return -1;
     }
     if(!ncdirect_fg_default_p(nc)){
@@ -1314,10 +1770,12 @@ int ncdirect_hline_interp(ncdirect* n, const char* egc, unsigned len,
     if(!bgdef){
       ncdirect_set_bg_rgb8(n, br, bg, bb);
     }
-    if(fprintf(n->ttyfp, "%s", egc) < 0){
+    if(ncdirect_puts(n, egc) < 0){
       logerror("error emitting egc [%s]\n", egc);
+      shadow_invalidate(n);
       return -1;
     }
+    shadow_text(n, egc, strlen(egc));
   }
   return ret;
 }
@@ -1397,15 +1855,16 @@ int ncdirect_box(ncdirect* n, uint64_t ul, uint64_t ur,
   char vl[MB_LEN_MAX + 1];
   unsigned edges;
   edges = !(ctlword & NCBOXMASK_TOP) + !(ctlword & NCBOXMASK_LEFT);
-  // FIXME rewrite all fprintfs as ncdirect_putstr()!
   if(edges >= box_corner_needs(ctlword)){
     if(activate_channels(n, ul)){
       return -1;
     }
-    if(fprintf(n->ttyfp, "%lc", wchars[0]) < 0){
+    if(ncdirect_putwc(n, wchars[0]) < 0){
       logerror("error emitting %lc\n", wchars[0]);
+      shadow_invalidate(n);
       return -1;
     }
+    shadow_advance(n, wcwidth(wchars[0]));
   }else{
     ncdirect_cursor_right(n, 1);
   }
@@ -1436,9 +1895,11 @@ int ncdirect_box(ncdirect* n, uint64_t ul, uint64_t ur,
     if(activate_channels(n, ur)){
       return -1;
     }
-    if(fprintf(n->ttyfp, "%lc", wchars[1]) < 0){
+    if(ncdirect_putwc(n, wchars[1]) < 0){
+      shadow_invalidate(n);
       return -1;
     }
+    shadow_advance(n, wcwidth(wchars[1]));
     ncdirect_cursor_left(n, xlen);
   }else{
     ncdirect_cursor_left(n, xlen - 1);
@@ -1471,9 +1932,11 @@ int ncdirect_box(ncdirect* n, uint64_t ul, uint64_t ur,
     if(activate_channels(n, ll)){
       return -1;
     }
-    if(fprintf(n->ttyfp, "%lc", wchars[2]) < 0){
+    if(ncdirect_putwc(n, wchars[2]) < 0){
+      shadow_invalidate(n);
       return -1;
     }
+    shadow_advance(n, wcwidth(wchars[2]));
   }else{
     ncdirect_cursor_right(n, 1);
   }
@@ -1491,9 +1954,11 @@ int ncdirect_box(ncdirect* n, uint64_t ul, uint64_t ur,
     if(activate_channels(n, lr)){
       return -1;
     }
-    if(fprintf(n->ttyfp, "%lc", wchars[3]) < 0){
+    if(ncdirect_putwc(n, wchars[3]) < 0){
+      shadow_invalidate(n);
       return -1;
     }
+    shadow_advance(n, wcwidth(wchars[3]));
   }
   return 0;
 }
@@ -1516,9 +1981,39 @@ bool ncdirect_canutf8(const ncdirect* n){
 }
 
 int ncdirect_flush(const ncdirect* nc){
+  if(nc->batch && fbuf_flush(nc->batch, nc->ttyfp)){
+    return -1;
+  }
   return ncflush(nc->ttyfp);
 }
 
+int ncdirect_begin_batch(ncdirect* n){
+  if(n->batch){
+    return 0;
+  }
+  fbuf* f = malloc(sizeof(*f));
+  if(f == NULL){
+    return -1;
+  }
+  if(fbuf_init(f)){
+    free(f);
+    return -1;
+  }
+  n->batch = f;
+  return 0;
+}
+
+int ncdirect_end_batch(ncdirect* n){
+  if(n->batch == NULL){
+    return 0;
+  }
+  int ret = ncdirect_flush(n);
+  fbuf_free(n->batch);
+  free(n->batch);
+  n->batch = NULL;
+  return ret;
+}
+
 int ncdirect_check_pixel_support(const ncdirect* n){
   if(n->tcache.pixel_draw || n->tcache.pixel_draw_late){
     return 1;
@@ -1532,6 +2027,12 @@ int ncdirect_stream(ncdirect* n, const char* filename, ncstreamcb streamer,
   if(ncv == NULL){
     return -1;
   }
+  // frames blitted to cells are streamed out in bands, rather than built up
+  // in a plane of their own.
+  const struct blitset* bset = rgba_blitter_low(&n->tcache, vopts->scaling,
+                                                !(vopts->flags & NCVISUAL_OPTION_NODEGRADE),
+                                                vopts->blitter);
+  const bool cellblit = bset && bset->geom != NCBLIT_PIXEL;
   // starting position *after displaying one frame* so as to effect any
   // necessary scrolling.
   unsigned y = 0, x = 0;
@@ -1548,16 +2049,22 @@ int ncdirect_stream(ncdirect* n, const char* filename, ncstreamcb streamer,
     if(x > 0){
       ncdirect_cursor_left(n, x);
     }
-    ncdirectv* v = ncdirect_render_visual(n, ncv, vopts);
-    if(v == NULL){
-      ncvisual_destroy(ncv);
-      return -1;
-    }
-    ncplane_dim_yx(v, &y, &x);
-    if(v->sprite){
-      thisid = v->sprite->id;
-    }
-    if(ncdirect_raster_frame(n, v, (vopts->flags & NCVISUAL_OPTION_HORALIGNED) ? vopts->x : 0)){
+    const ncalign_e align = (vopts->flags & NCVISUAL_OPTION_HORALIGNED) ? vopts->x : 0;
+    if(!cellblit){
+      ncdirectv* v = ncdirect_render_visual(n, ncv, vopts);
+      if(v == NULL){
+        ncvisual_destroy(ncv);
+        return -1;
+      }
+      ncplane_dim_yx(v, &y, &x);
+      if(v->sprite){
+        thisid = v->sprite->id;
+      }
+      if(ncdirect_raster_frame(n, v, align)){
+        ncvisual_destroy(ncv);
+        return -1;
+      }
+    }else if(ncdirect_stream_visual(n, ncv, vopts, align, &y, &x)){
       ncvisual_destroy(ncv);
       return -1;
     }
@@ -1570,7 +2077,7 @@ int ncdirect_stream(ncdirect* n, const char* filename, ncstreamcb streamer,
           ncvisual_destroy(ncv);
           return -1;
         }
-        if(fbuf_finalize(&f, n->ttyfp) < 0){
+        if(ncdirect_finalize(n, &f) < 0){
           ncvisual_destroy(ncv);
           return -1;
         }
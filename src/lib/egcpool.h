@@ -15,6 +15,7 @@
 #include "notcurses/notcurses.h"
 #include "compat/compat.h"
 #include "logging.h"
+#include "width.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,14 +23,40 @@ extern "C" {
 
 // cells only provide storage for a single 7-bit character. if there's anything
 // more than that, it's spilled into the egcpool, and the cell is given an
-// offset. when a cell is released, the memory it owned is zeroed out, and
-// recognizable as use for another cell.
+// offset. when a cell is released, the memory it owned is zeroed out, and its
+// block is pushed onto the free list for its length. new EGCs are satisfied
+// from the free list of their exact length if possible, and otherwise written
+// at the high water mark. blocks which don't find reuse are recovered by
+// compaction (see ncplane_compact_pool()), which rewrites the pool densely.
+
+// EGCs of fewer than EGCPOOL_CLASSES bytes (including the NUL terminator) have
+// a free list to themselves, and only ever reuse blocks of exactly their own
+// length. longer ones share the overflow list (index 0), searched first-fit.
+#define EGCPOOL_CLASSES 32
+
+typedef struct egcblock {
+  int offset;         // where the released block starts
+  int len;            // its length, including the NUL terminator
+} egcblock;
+
+typedef struct egcfreelist {
+  egcblock* blocks;   // stack of released blocks
+  int count;          // blocks on the stack
+  int alloc;          // blocks allocated
+} egcfreelist;
+
+struct egcintern;
 
 typedef struct egcpool {
-  char* pool;         // ringbuffer of attached extension storage
+  char* pool;         // attached extension storage
   int poolsize;       // total number of bytes in pool
-  int poolused;       // bytes actively used, grow when this gets too large
-  int poolwrite;      // next place to *look for* a place to write
+  int poolused;       // bytes actively used by EGCs
+  int poolwrite;      // high water mark; nothing has been written beyond it
+  int poolfree;       // bytes in blocks on the free lists
+  unsigned generation;// bumped whenever extant offsets are invalidated
+  egcfreelist* freelists; // EGCPOOL_CLASSES lists, created on first release
+  struct egcintern* interns; // our pile's intern table, if it has one
+  int interned;       // references we hold against 'interns'
 } egcpool;
 
 #define POOL_MINIMUM_ALLOC BUFSIZ
@@ -40,13 +67,15 @@ egcpool_init(egcpool* p){
   memset(p, 0, sizeof(*p));
 }
 
+// ensure there are at least |len| bytes available beyond the high water mark.
+// the new space is not zeroed; nothing beyond poolwrite is ever read.
 static inline int
 egcpool_grow(egcpool* pool, size_t len){
   size_t newsize = pool->poolsize * 2;
   if(newsize < POOL_MINIMUM_ALLOC){
     newsize = POOL_MINIMUM_ALLOC;
   }
-  while(len > newsize - pool->poolsize){ // ensure we make enough space
+  while(len > newsize - pool->poolwrite){ // ensure we make enough space
     newsize *= 2;
   }
   if(newsize > POOL_MAXIMUM_BYTES){
@@ -58,11 +87,25 @@ egcpool_grow(egcpool* pool, size_t len){
     return -1;
   }
   pool->pool = tmp;
-  memset(pool->pool + pool->poolsize, 0, newsize - pool->poolsize);
   pool->poolsize = newsize;
   return 0;
 }
 
+// bytes below the high water mark not held by any EGC, whether waiting on a
+// free list or stranded (the remainder of a split block, or a block we
+// couldn't record) until the next compaction.
+static inline int
+egcpool_fragmentation(const egcpool* pool){
+  return pool->poolwrite - pool->poolused;
+}
+
+// is enough of the pool wasted that compaction ought pay for itself?
+static inline bool
+egcpool_compaction_justified(const egcpool* pool){
+  const int wasted = egcpool_fragmentation(pool);
+  return wasted >= POOL_MINIMUM_ALLOC && wasted * 2 > pool->poolwrite;
+}
+
 // get the expected length of the encoded codepoint from the first byte of a
 // utf-8 character. if the byte is illegal as a first byte, 1 is returned.
 // Table 3.1B, Legal UTF8 Byte Sequences, Corrigendum #1: UTF-8 Shortest Form.
@@ -84,24 +127,55 @@ utf8_codepoint_length(unsigned char c){
   }
 }
 
+// decode the UTF-8 codepoint at 's' into '*cp', returning its length in
+// bytes (0 for the NUL terminator), or -1 if it is invalid or truncated.
+static inline int
+utf8_decode(const char* s, uint32_t* cp){
+  const unsigned char* u = (const unsigned char*)s;
+  if(u[0] < 0x80){
+    *cp = u[0];
+    return u[0] ? 1 : 0;
+  }
+  int len;
+  uint32_t c, min;
+  if((u[0] & 0xe0u) == 0xc0u){
+    len = 2; c = u[0] & 0x1fu; min = 0x80;
+  }else if((u[0] & 0xf0u) == 0xe0u){
+    len = 3; c = u[0] & 0x0fu; min = 0x800;
+  }else if((u[0] & 0xf8u) == 0xf0u){
+    len = 4; c = u[0] & 0x07u; min = 0x10000;
+  }else{
+    return -1;
+  }
+  for(int i = 1 ; i < len ; ++i){
+    if((u[i] & 0xc0u) != 0x80u){ // catches a NUL, so we never read past it
+      return -1;
+    }
+    c = (c << 6u) | (u[i] & 0x3fu);
+  }
+  if(c < min || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff)){
+    return -1;
+  }
+  *cp = c;
+  return len;
+}
+
 // Eat an EGC from the UTF-8 string input, counting bytes and columns. We use
 // libunistring's uc_is_grapheme_break() to segment EGCs. Writes the number of
 // columns to '*colcount'. Returns the number of bytes consumed, not including
 // any NUL terminator. Neither the number of bytes nor columns is necessarily
 // equal to the number of decoded code points. Such are the ways of Unicode.
-// uc_is_grapheme_break() wants UTF-32, which is fine, because we need wchar_t
-// to use wcwidth() anyway FIXME except this doesn't work with 16-bit wchar_t!
+// We decode to UTF-32 ourselves (wchar_t is only 16 bits on Windows), and
+// take widths from our own table (see width.h) rather than wcwidth().
 static inline int
 utf8_egc_len(const char* gcluster, int* colcount){
   size_t ret = 0;
   *colcount = 0;
   int r;
-  mbstate_t mbt;
-  memset(&mbt, 0, sizeof(mbt));
-  wchar_t wc, prevw = 0;
+  uint32_t wc, prevw = 0;
   bool injoin = false;
   do{
-    r = mbrtowc(&wc, gcluster, MB_LEN_MAX, &mbt);
+    r = utf8_decode(gcluster, &wc);
     if(r < 0){
       // FIXME probably ought escape this somehow
       logerror("invalid UTF8: %s", gcluster);
@@ -114,11 +188,11 @@ utf8_egc_len(const char* gcluster, int* colcount){
     if(uc_is_property_variation_selector(wc)){ // ends EGC
       ret += r;
       break;
-    }else if(wc == L'\u200d' || injoin){ // ZWJ is iswcntrl, so check it first
+    }else if(wc == 0x200d || injoin){ // ZWJ is iswcntrl, so check it first
       injoin = true;
       cols = 0;
     }else{
-      cols = wcwidth(wc);
+      cols = ncwidth(wc);
       if(cols < 0){
         injoin = false;
         if(iswspace(wc)){ // newline or tab
@@ -145,18 +219,91 @@ utf8_egc_len(const char* gcluster, int* colcount){
   return ret;
 }
 
-// if we're inserting a EGC of |len| bytes, ought we proactively realloc?
-static inline bool
-egcpool_alloc_justified(const egcpool* pool, int len){
-  const int poolfree = pool->poolsize - pool->poolused;
-  // proactively get more space if we have less than 10% free. this doesn't
-  // guarantee that we'll have enough space to insert the string -- we could
-  // theoretically have every 10th byte free, and be unable to write even a
-  // two-byte egc -- so we might have to allocate after an expensive search :/.
-  if(poolfree >= len && poolfree * 10 > pool->poolsize){
-    return false;
-  }
-  return true;
+// record the released block of |len| bytes at |offset| for reuse. if we can't
+// get the memory to do so, the block is stranded until the next compaction.
+static inline int
+egcpool_push_free(egcpool* pool, int offset, int len){
+  if(pool->freelists == NULL){
+    pool->freelists = (egcfreelist*)calloc(EGCPOOL_CLASSES, sizeof(*pool->freelists));
+    if(pool->freelists == NULL){
+      return -1;
+    }
+  }
+  egcfreelist* fl = &pool->freelists[len < EGCPOOL_CLASSES ? len : 0];
+  if(fl->count == fl->alloc){
+    int nalloc = fl->alloc ? fl->alloc * 2 : 16;
+    egcblock* tmp = (egcblock*)realloc(fl->blocks, sizeof(*tmp) * nalloc);
+    if(tmp == NULL){
+      return -1;
+    }
+    fl->blocks = tmp;
+    fl->alloc = nalloc;
+  }
+  fl->blocks[fl->count].offset = offset;
+  fl->blocks[fl->count].len = len;
+  ++fl->count;
+  pool->poolfree += len;
+  return 0;
+}
+
+// take block |idx| from free list |fl|, using the first |len| bytes. anything
+// left over goes back onto the appropriate free list, so long as it could
+// hold some EGC; otherwise it's stranded.
+static inline int
+egcpool_take_free(egcpool* pool, egcfreelist* fl, int idx, int len){
+  egcblock b = fl->blocks[idx];
+  fl->blocks[idx] = fl->blocks[--fl->count];
+  pool->poolfree -= b.len;
+  if(b.len - len > 2){
+    egcpool_push_free(pool, b.offset + len, b.len - len);
+  }
+  return b.offset;
+}
+
+// find a released block of |len| bytes. only exact fits are considered for
+// classed lengths, making this O(1); the overflow list is searched first-fit.
+// returns -1 if there's no such block.
+static inline int
+egcpool_reuse(egcpool* pool, int len){
+  if(pool->poolfree < len){
+    return -1;
+  }
+  if(len < EGCPOOL_CLASSES){
+    egcfreelist* fl = &pool->freelists[len];
+    if(fl->count == 0){
+      return -1;
+    }
+    return egcpool_take_free(pool, fl, fl->count - 1, len);
+  }
+  egcfreelist* fl = &pool->freelists[0];
+  for(int i = 0 ; i < fl->count ; ++i){
+    if(fl->blocks[i].len >= len){
+      return egcpool_take_free(pool, fl, i, len);
+    }
+  }
+  return -1;
+}
+
+// the pool can't grow any further. carve |len| bytes from any released block
+// large enough to hold them, or return -1.
+static inline int
+egcpool_carve(egcpool* pool, int len){
+  if(pool->poolfree < len){
+    return -1;
+  }
+  for(int c = len + 1 ; c < EGCPOOL_CLASSES ; ++c){
+    egcfreelist* fl = &pool->freelists[c];
+    if(fl->count){
+      return egcpool_take_free(pool, fl, fl->count - 1, len);
+    }
+  }
+  egcfreelist* fl = &pool->freelists[0];
+  for(int i = 0 ; i < fl->count ; ++i){
+    if(fl->blocks[i].len >= len){
+      return egcpool_take_free(pool, fl, i, len);
+    }
+  }
+  return -1;
 }
 
 // stash away the provided UTF8, NUL-terminated grapheme cluster. the cluster
@@ -169,92 +316,75 @@ egcpool_stash(egcpool* pool, const char* egc, size_t ulen){
   if(len <= 2){ // should never be empty, nor a single byte + NUL
     return -1;
   }
-  // the first time through, we don't force a grow unless we expect ourselves
-  // to have too little space. once we've done a search, we do force the grow.
-  // we should thus never have more than two iterations of this loop.
-  bool searched = false;
-  // we might have to realloc our underlying pool. it is possible that this EGC
-  // is actually *in* that pool, in which case our pointer will be invalidated.
-  // to be safe, duplicate prior to a realloc, and free along all paths.
+  int off = egcpool_reuse(pool, len);
   char* duplicated = NULL;
-  do{
-    if(egcpool_alloc_justified(pool, len) || searched){
-      if(!duplicated){
-        // cast (and avoidance of strndup) to facilitate c++ inclusions
-        if((duplicated = (char *)malloc(ulen + 1)) == NULL){
-          return -1;
-        }
-        memcpy(duplicated, egc, ulen);
-        duplicated[ulen] = '\0';
-      }
-      if(egcpool_grow(pool, len) && searched){
-        free(duplicated);
+  if(off < 0){
+    if(pool->poolsize - pool->poolwrite < len){
+      // we must realloc our underlying pool. it is possible that this EGC is
+      // actually *in* that pool, in which case our pointer will be
+      // invalidated. to be safe, duplicate prior to the realloc.
+      // cast (and avoidance of strndup) to facilitate c++ inclusions
+      if((duplicated = (char*)malloc(len)) == NULL){
         return -1;
       }
+      memcpy(duplicated, egc, ulen);
+      duplicated[ulen] = '\0';
       egc = duplicated;
-    }
-    // we now look for a place to lay out this egc. we need |len| zeroes in a
-    // row. starting at pool->poolwrite, look for such a range of unused
-    // memory. if we find it, write it out, and update used count. if we come
-    // back to where we started, force a growth and try again.
-    int curpos = pool->poolwrite;
-//fprintf(stderr, "Stashing [%s] %d starting at %d\n", egc, len, curpos);
-    do{
-      if(curpos == pool->poolsize){
-        curpos = 0;
-      }
-      if(pool->pool[curpos]){ // can't write if there's stuff here
-        ++curpos;
-      }else if(curpos && pool->pool[curpos - 1]){ // don't kill someone's NUL
-        ++curpos;
-      }else if(pool->poolsize - curpos < len){ // can't wrap around
-        if(pool->poolwrite > curpos){
-          break;
-        }
-        curpos = 0; // can this skip pool->poolwrite?
-      }else{ // promising! let's see if there's enough space
-        int need = len;
-        size_t trial = curpos;
-        while(--need){
-          if(pool->pool[++trial]){ // alas, not enough space here
-            break;
-          }
-        }
-        if(need == 0){ // found a suitable space, copy it!
-          memcpy(pool->pool + curpos, egc, len - 1);
-          pool->pool[curpos + len - 1] = '\0';
-          pool->poolwrite = curpos + len;
-          pool->poolused += len;
+      if(egcpool_grow(pool, len)){
+        if((off = egcpool_carve(pool, len)) < 0){
           free(duplicated);
-//fprintf(stderr, "Stashing AT %d\n", curpos);
-          return curpos;
-        }
-        if(pool->poolwrite > curpos && pool->poolwrite - (len - need) < curpos){
-          break;
+          return -1;
         }
-        curpos += len - need;
       }
-    }while(curpos != pool->poolwrite);
-  }while( (searched = !searched) );
+    }
+    if(off < 0){
+      off = pool->poolwrite;
+      pool->poolwrite += len;
+    }
+  }
+  memcpy(pool->pool + off, egc, ulen);
+  pool->pool[off + ulen] = '\0';
+  pool->poolused += len;
   free(duplicated);
-  assert(false);
-  return -1; // should never get here
+  return off;
 }
 
-// remove the egc from the pool. start at offset, and zero out everything until
-// we find a zero (our own NUL terminator). remove that number of bytes from
-// the usedcount.
+// remove the egc from the pool, zeroing it out, and put its block on the free
+// list for its length.
 static inline void
 egcpool_release(egcpool* pool, int offset){
-  size_t freed = 1; // account for free(d) NUL terminator
-  while(pool->pool[offset]){
-    pool->pool[offset] = '\0';
-    ++freed;
-    ++offset;
-    assert(offset < pool->poolsize);
-  }
-  pool->poolused -= freed;
-  // FIXME ought we update pool->poolwrite?
+  assert(offset < pool->poolwrite);
+  const int len = strlen(pool->pool + offset) + 1; // account for NUL
+  memset(pool->pool + offset, 0, len);
+  pool->poolused -= len;
+  egcpool_push_free(pool, offset, len);
+}
+
+static inline void
+egcpool_free_lists(egcpool* pool){
+  if(pool->freelists){
+    for(int c = 0 ; c < EGCPOOL_CLASSES ; ++c){
+      free(pool->freelists[c].blocks);
+    }
+    free(pool->freelists);
+    pool->freelists = NULL;
+  }
+  pool->poolfree = 0;
+}
+
+// forget every EGC in |pool| at once, keeping its storage (and that of its
+// free lists) for reuse. only valid once no cell refers into the pool.
+static inline void
+egcpool_reset(egcpool* pool){
+  pool->poolwrite = 0;
+  pool->poolused = 0;
+  pool->poolfree = 0;
+  if(pool->freelists){
+    for(int c = 0 ; c < EGCPOOL_CLASSES ; ++c){
+      pool->freelists[c].count = 0;
+    }
+  }
+  ++pool->generation;
 }
 
 static inline void
@@ -264,19 +394,36 @@ egcpool_dump(egcpool* pool){
   pool->poolsize = 0;
   pool->poolwrite = 0;
   pool->poolused = 0;
+  egcpool_free_lists(pool);
+  ++pool->generation;
 }
 
-// get the offset into the egcpool for this cell's EGC. returns meaningless and
-// unsafe results if called on a simple cell.
+// get the offset into the egcpool (or index into the intern table) for this
+// cell's EGC. returns meaningless and unsafe results if called on a simple
+// cell.
 static inline uint32_t
 cell_egc_idx(const nccell* c){
   return (htole(c->gcluster) & 0x00fffffflu);
 }
 
+// Is the cell a spilled (more than 4 byte) UTF8 EGC in its plane's egcpool?
+static inline bool
+cell_pooled_p(const nccell* c){
+  return (htole(c->gcluster) & 0xff000000ul) == 0x01000000ul;
+}
+
+// Is the cell a spilled UTF8 EGC in its pile's intern table? neither 0x01 nor
+// 0x02 can be the fourth byte of a UTF-8 encoding, so these can't collide
+// with a simple EGC.
+static inline bool
+cell_interned_p(const nccell* c){
+  return (htole(c->gcluster) & 0xff000000ul) == 0x02000000ul;
+}
+
 // Is the cell a spilled (more than 4 byte) UTF8 EGC?
 static inline bool
 cell_extended_p(const nccell* c){
-  return (htole(c->gcluster) & 0xff000000ul) == 0x01000000ul;
+  return cell_pooled_p(c) || cell_interned_p(c);
 }
 
 // Is the cell simple (a UTF8-encoded EGC of four bytes or fewer)?
@@ -285,29 +432,232 @@ cell_simple_p(const nccell* c){
   return !cell_extended_p(c);
 }
 
+// a pile can opt into sharing a single refcounted copy of each spilled EGC
+// among all its planes (see ncpile_intern_egcs()). slots are never moved, so
+// their indices can live in cells just like egcpool offsets.
+typedef struct egcinterned {
+  char* egc;          // NUL-terminated cluster, NULL if the slot is free
+  uint32_t hash;
+  uint32_t refs;      // cells referencing this slot
+  int next;           // next slot in our hash chain (or the free list), or -1
+} egcinterned;
+
+typedef struct egcintern {
+  egcinterned* slots;
+  int slotcount;      // slots allocated
+  int used;           // slots holding an EGC
+  int freeslot;       // first free slot, or -1
+  int* buckets;       // heads of the hash chains, -1 if empty
+  int bucketcount;    // always a power of 2
+  uint64_t hits;      // acquisitions satisfied by an extant slot
+} egcintern;
+
+#define EGCINTERN_MINIMUM_BUCKETS 64
+#define EGCINTERN_MAXIMUM_SLOTS (1 << 24) // same limit as egcpool offsets
+
+// FNV-1a over the |len| bytes of |egc|
+static inline uint32_t
+egcintern_hash(const char* egc, size_t len){
+  uint32_t h = 2166136261u;
+  for(size_t i = 0 ; i < len ; ++i){
+    h = (h ^ (unsigned char)egc[i]) * 16777619u;
+  }
+  return h;
+}
+
+static inline egcintern*
+egcintern_create(void){
+  egcintern* t = (egcintern*)calloc(1, sizeof(*t));
+  if(t == NULL){
+    return NULL;
+  }
+  t->buckets = (int*)malloc(sizeof(*t->buckets) * EGCINTERN_MINIMUM_BUCKETS);
+  if(t->buckets == NULL){
+    free(t);
+    return NULL;
+  }
+  t->bucketcount = EGCINTERN_MINIMUM_BUCKETS;
+  for(int b = 0 ; b < t->bucketcount ; ++b){
+    t->buckets[b] = -1;
+  }
+  t->freeslot = -1;
+  return t;
+}
+
+static inline void
+egcintern_destroy(egcintern* t){
+  if(t){
+    for(int i = 0 ; i < t->slotcount ; ++i){
+      free(t->slots[i].egc);
+    }
+    free(t->slots);
+    free(t->buckets);
+    free(t);
+  }
+}
+
+// double the hash chains once we average more than one slot per chain
+static inline void
+egcintern_rehash(egcintern* t){
+  int nbuckets = t->bucketcount * 2;
+  int* tmp = (int*)malloc(sizeof(*tmp) * nbuckets);
+  if(tmp == NULL){
+    return; // we'll just have longer chains
+  }
+  for(int b = 0 ; b < nbuckets ; ++b){
+    tmp[b] = -1;
+  }
+  for(int i = 0 ; i < t->slotcount ; ++i){
+    egcinterned* e = &t->slots[i];
+    if(e->egc){
+      const int b = e->hash & (nbuckets - 1);
+      e->next = tmp[b];
+      tmp[b] = i;
+    }
+  }
+  free(t->buckets);
+  t->buckets = tmp;
+  t->bucketcount = nbuckets;
+}
+
+// get a reference to the slot holding the |ulen| bytes of |egc|, creating
+// it if necessary. returns the slot index, or -1 on error.
+__attribute__ ((nonnull (1, 2))) static inline int
+egcintern_acquire(egcintern* t, const char* egc, size_t ulen){
+  const uint32_t hash = egcintern_hash(egc, ulen);
+  for(int i = t->buckets[hash & (t->bucketcount - 1)] ; i >= 0 ; i = t->slots[i].next){
+    egcinterned* e = &t->slots[i];
+    if(e->hash == hash && strncmp(e->egc, egc, ulen) == 0 && e->egc[ulen] == '\0'){
+      ++e->refs;
+      ++t->hits;
+      return i;
+    }
+  }
+  char* dup = (char*)malloc(ulen + 1);
+  if(dup == NULL){
+    return -1;
+  }
+  memcpy(dup, egc, ulen);
+  dup[ulen] = '\0';
+  int i = t->freeslot;
+  if(i >= 0){
+    t->freeslot = t->slots[i].next;
+  }else{
+    if(t->slotcount == EGCINTERN_MAXIMUM_SLOTS){
+      free(dup);
+      return -1;
+    }
+    int nslots = t->slotcount ? t->slotcount * 2 : EGCINTERN_MINIMUM_BUCKETS;
+    if(nslots > EGCINTERN_MAXIMUM_SLOTS){
+      nslots = EGCINTERN_MAXIMUM_SLOTS;
+    }
+    egcinterned* tmp = (egcinterned*)realloc(t->slots, sizeof(*tmp) * nslots);
+    if(tmp == NULL){
+      free(dup);
+      return -1;
+    }
+    // chain the new slots (less the one we're taking) onto the free list
+    for(int s = nslots - 1 ; s > t->slotcount ; --s){
+      tmp[s].egc = NULL;
+      tmp[s].next = t->freeslot;
+      t->freeslot = s;
+    }
+    i = t->slotcount;
+    t->slots = tmp;
+    t->slotcount = nslots;
+  }
+  egcinterned* e = &t->slots[i];
+  e->egc = dup;
+  e->hash = hash;
+  e->refs = 1;
+  const int b = hash & (t->bucketcount - 1);
+  e->next = t->buckets[b];
+  t->buckets[b] = i;
+  if(++t->used > t->bucketcount){
+    egcintern_rehash(t);
+  }
+  return i;
+}
+
+// drop a reference to slot |idx|, freeing it with the last reference.
+static inline void
+egcintern_release(egcintern* t, int idx){
+  egcinterned* e = &t->slots[idx];
+  assert(e->egc && e->refs);
+  if(--e->refs){
+    return;
+  }
+  int* link = &t->buckets[e->hash & (t->bucketcount - 1)];
+  while(*link != idx){
+    link = &t->slots[*link].next;
+  }
+  *link = e->next;
+  free(e->egc);
+  e->egc = NULL;
+  e->next = t->freeslot;
+  t->freeslot = idx;
+  --t->used;
+}
+
 // only applies to complex cells, do not use on simple cells
 __attribute__ ((__returns_nonnull__)) static inline const char*
 egcpool_extended_gcluster(const egcpool* pool, const nccell* c) {
   assert(cell_extended_p(c));
   uint32_t idx = cell_egc_idx(c);
+  if(cell_interned_p(c)){
+    return pool->interns->slots[idx].egc;
+  }
   return pool->pool + idx;
 }
 
 // Duplicate the contents of EGCpool 'src' onto another, wiping out any prior
-// contents in 'dst'.
+// contents in 'dst'. the free lists are duplicated along with the storage, so
+// that 'dst' can reuse the same blocks.
 static inline int
 egcpool_dup(egcpool* dst, const egcpool* src){
+  egcfreelist* lists = NULL;
+  if(src->freelists){
+    lists = (egcfreelist*)calloc(EGCPOOL_CLASSES, sizeof(*lists));
+    if(lists == NULL){
+      return -1;
+    }
+    for(int c = 0 ; c < EGCPOOL_CLASSES ; ++c){
+      const egcfreelist* sfl = &src->freelists[c];
+      if(sfl->count){
+        lists[c].blocks = (egcblock*)malloc(sizeof(*sfl->blocks) * sfl->count);
+        if(lists[c].blocks == NULL){
+          while(c--){
+            free(lists[c].blocks);
+          }
+          free(lists);
+          return -1;
+        }
+        memcpy(lists[c].blocks, sfl->blocks, sizeof(*sfl->blocks) * sfl->count);
+        lists[c].count = lists[c].alloc = sfl->count;
+      }
+    }
+  }
   if(src->pool){
     char* tmp;
     if((tmp = (char*)realloc(dst->pool, src->poolsize)) == NULL){
+      if(lists){
+        for(int c = 0 ; c < EGCPOOL_CLASSES ; ++c){
+          free(lists[c].blocks);
+        }
+        free(lists);
+      }
       return -1;
     }
     dst->pool = tmp;
-    memcpy(dst->pool, src->pool, src->poolsize);
+    memcpy(dst->pool, src->pool, src->poolwrite);
   }
+  egcpool_free_lists(dst);
+  dst->freelists = lists;
   dst->poolsize = src->poolsize;
   dst->poolused = src->poolused;
   dst->poolwrite = src->poolwrite;
+  dst->poolfree = src->poolfree;
+  ++dst->generation;
   return 0;
 }
 
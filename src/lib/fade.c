@@ -11,12 +11,50 @@ typedef struct ncfadectx {
   uint64_t nanosecs_step;       // nanoseconds per iteration
   uint64_t startns;             // time fade started
   uint64_t* channels;           // all channels from the framebuffer
+  bool rgbfade;                 // are any channels faded directly?
+  // if the terminal can redefine its palette, palette-indexed channels are
+  // faded by scaling the palette, rather than being rewritten
+  bool palfade;                 // are any palette-indexed channels in use?
+  bool palused[NCPALETTESIZE];  // which palette entries are being faded
+  uint32_t palette[NCPALETTESIZE]; // palette entries at the fade's start
 } ncfadectx;
 
 int ncfadectx_iterations(const ncfadectx* nctx){
   return nctx->maxsteps;
 }
 
+// fold the RGB components of |chan| into the maxima |max|
+static inline void
+fade_maxima(unsigned max[3], uint32_t chan){
+  unsigned r, g, b;
+  ncchannel_rgb8(chan, &r, &g, &b);
+  if(r > max[0]){
+    max[0] = r;
+  }
+  if(g > max[1]){
+    max[1] = g;
+  }
+  if(b > max[2]){
+    max[2] = b;
+  }
+}
+
+// account for one channel of the snapshot, with |max| being the maxima of
+// the appropriate (fore- or background) components
+static void
+fade_account(ncfadectx* pp, unsigned max[3], uint32_t chan, bool canpal){
+  if(ncchannel_default_p(chan)){
+    return;
+  }
+  if(canpal && ncchannel_palindex_p(chan)){
+    pp->palused[ncchannel_palindex(chan)] = true;
+    pp->palfade = true;
+    return;
+  }
+  pp->rgbfade = true;
+  fade_maxima(max, chan);
+}
+
 // These arrays are too large to be safely placed on the stack. Get an atomic
 // snapshot of all channels on the plane. While copying the snapshot, determine
 // the maxima across each of the six components.
@@ -28,59 +66,40 @@ alloc_ncplane_palette(ncplane* n, ncfadectx* pp, const struct timespec* ts){
   if((pp->channels = malloc(sizeof(*pp->channels) * size)) == NULL){
     return -1;
   }
-  pp->maxr = pp->maxg = pp->maxb = 0;
-  pp->maxbr = pp->maxbg = pp->maxbb = 0;
-  unsigned r, g, b, br, bg, bb;
-  uint64_t channels;
+  notcurses* nc = ncplane_notcurses(n);
+  const bool canpal = notcurses_canchangecolor(nc);
+  pp->rgbfade = pp->palfade = false;
+  memset(pp->palused, 0, sizeof(pp->palused));
+  unsigned fmax[3] = { 0, 0, 0, };
+  unsigned bmax[3] = { 0, 0, 0, };
   unsigned y;
   for(y = 0 ; y < pp->rows ; ++y){
+    const nccell* row = &n->fb[nfbcellidx(n, y, 0)];
     for(unsigned x = 0 ; x < pp->cols ; ++x){
-      channels = n->fb[nfbcellidx(n, y, x)].channels;
+      const uint64_t channels = row[x].channels;
       pp->channels[y * pp->cols + x] = channels;
-      ncchannels_fg_rgb8(channels, &r, &g, &b);
-      if(r > pp->maxr){
-        pp->maxr = r;
-      }
-      if(g > pp->maxg){
-        pp->maxg = g;
-      }
-      if(b > pp->maxb){
-        pp->maxb = b;
-      }
-      ncchannels_bg_rgb8(channels, &br, &bg, &bb);
-      if(br > pp->maxbr){
-        pp->maxbr = br;
-      }
-      if(bg > pp->maxbg){
-        pp->maxbg = bg;
-      }
-      if(bb > pp->maxbb){
-        pp->maxbb = bb;
-      }
+      fade_account(pp, fmax, ncchannels_fchannel(channels), canpal);
+      fade_account(pp, bmax, ncchannels_bchannel(channels), canpal);
     }
   }
-  channels = n->basecell.channels;
+  const uint64_t channels = n->basecell.channels;
   pp->channels[y * pp->cols] = channels;
-  ncchannels_fg_rgb8(channels, &r, &g, &b);
-  if(r > pp->maxr){
-    pp->maxr = r;
-  }
-  if(g > pp->maxg){
-    pp->maxg = g;
-  }
-  if(b > pp->maxb){
-    pp->maxb = b;
-  }
-  ncchannels_bg_rgb8(channels, &br, &bg, &bb);
-  if(br > pp->maxbr){
-    pp->maxbr = br;
-  }
-  if(bg > pp->maxbg){
-    pp->maxbg = bg;
-  }
-  if(bb > pp->maxbb){
-    pp->maxbb = bb;
+  fade_account(pp, fmax, ncchannels_fchannel(channels), canpal);
+  fade_account(pp, bmax, ncchannels_bchannel(channels), canpal);
+  if(pp->palfade){
+    memcpy(pp->palette, nc->palette.chans, sizeof(pp->palette));
+    for(unsigned idx = 0 ; idx < NCPALETTESIZE ; ++idx){
+      if(pp->palused[idx]){
+        fade_maxima(fmax, pp->palette[idx]);
+      }
+    }
   }
+  pp->maxr = fmax[0];
+  pp->maxg = fmax[1];
+  pp->maxb = fmax[2];
+  pp->maxbr = bmax[0];
+  pp->maxbg = bmax[1];
+  pp->maxbb = bmax[2];
   int maxfsteps = pp->maxg > pp->maxr ? (pp->maxb > pp->maxg ? pp->maxb : pp->maxg) :
                   (pp->maxb > pp->maxr ? pp->maxb : pp->maxr);
   int maxbsteps = pp->maxbg > pp->maxbr ? (pp->maxbb > pp->maxbg ? pp->maxbb : pp->maxbg) :
@@ -106,34 +125,162 @@ alloc_ncplane_palette(ncplane* n, ncfadectx* pp, const struct timespec* ts){
   return 0;
 }
 
-int ncplane_fadein_iteration(ncplane* n, ncfadectx* nctx, int iter,
-                             fadecb fader, void* curry){
+// every component of every color in a fade iteration is scaled by the same
+// ratio |num| / |den|. rather than dividing six times per cell, we multiply
+// by a 16.16 fixed-point factor. components and steps are both at most 255,
+// so any fractional part of the true ratio is at least 1/255, while the
+// rounded-up factor errs by less than 255/65536: the results are exact.
+static uint32_t
+fade_factor(int num, int den){
+  if(num < 0){
+    num = 0;
+  }else if(num > den){
+    num = den;
+  }
+  return ((uint32_t)num * 65536u + den - 1) / den;
+}
+
+// the RGB of |chan|, scaled by |mult|
+static inline uint32_t
+fade_scale_channel(uint32_t chan, uint32_t mult){
+  const uint32_t r = ((((chan >> 16u) & 0xffu) * mult) >> 16u) << 16u;
+  const uint32_t g = ((((chan >> 8u) & 0xffu) * mult) >> 16u) << 8u;
+  const uint32_t b = ((chan & 0xffu) * mult) >> 16u;
+  return r | g | b;
+}
+
+static inline uint64_t
+fade_scale_channels(uint64_t channels, uint32_t mult){
+  return ((uint64_t)fade_scale_channel(channels >> 32u, mult) << 32u) |
+         fade_scale_channel(channels, mult);
+}
+
+// scale the RGB of |count| snapshotted channel pairs from |orig| into
+// |scaled|. every 32-bit channel is independent, so we work through eight at
+// a time with GNU C vector arithmetic where it's available (with an AVX2
+// clone selected at load time on x86-64 glibc).
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9)
+typedef uint32_t fadelanes __attribute__ ((vector_size (8 * sizeof(uint32_t))));
+
+#if defined(__x86_64__) && defined(__GLIBC__) && !defined(__clang__)
+#define FADE_CLONES __attribute__ ((target_clones ("avx2", "default")))
+#else
+#define FADE_CLONES
+#endif
+
+FADE_CLONES static void
+fade_scale_span(const uint64_t* orig, uint64_t* scaled, unsigned count,
+                uint32_t mult){
+  unsigned x = 0;
+  for( ; x + sizeof(fadelanes) / sizeof(*orig) <= count ; x += sizeof(fadelanes) / sizeof(*orig)){
+    fadelanes v;
+    memcpy(&v, orig + x, sizeof(v));
+    fadelanes r = (v >> 16u) & 0xffu;
+    fadelanes g = (v >> 8u) & 0xffu;
+    fadelanes b = v & 0xffu;
+    r = (r * mult) >> 16u;
+    g = (g * mult) >> 16u;
+    b = (b * mult) >> 16u;
+    v = (r << 16u) | (g << 8u) | b;
+    memcpy(scaled + x, &v, sizeof(v));
+  }
+  for( ; x < count ; ++x){
+    scaled[x] = fade_scale_channels(orig[x], mult);
+  }
+}
+#else
+static void
+fade_scale_span(const uint64_t* orig, uint64_t* scaled, unsigned count,
+                uint32_t mult){
+  for(unsigned x = 0 ; x < count ; ++x){
+    scaled[x] = fade_scale_channels(orig[x], mult);
+  }
+}
+#endif
+
+// return |cur| with the |scaled| RGB substituted into any non-default
+// channels, as ncchannels_set_[fb]g_rgb8() would, in 64-bit operations.
+// palette-indexed channels are left alone if we're fading the palette.
+static inline uint64_t
+fade_channels(const ncfadectx* nctx, uint64_t cur, uint64_t scaled){
+  // those setters retain only the alpha and not-default bits of the channel
+  // (the latter of which is already set in any channel we replace)
+  const uint32_t replaced = ~(uint32_t)(NC_BGDEFAULT_MASK | NC_BG_ALPHA_MASK);
+  uint64_t mask = 0;
+  if(!ncchannels_fg_default_p(cur)){
+    if(!nctx->palfade || !ncchannels_fg_palindex_p(cur)){
+      mask |= (uint64_t)replaced << 32u;
+    }
+  }
+  if(!ncchannels_bg_default_p(cur)){
+    if(!nctx->palfade || !ncchannels_bg_palindex_p(cur)){
+      mask |= replaced;
+    }
+  }
+  return (cur & ~mask) | (scaled & mask);
+}
+
+// cells of a row handled per call to fade_scale_span()
+#define FADE_SPAN 64
+
+// scale the plane's current cells from their snapshot in |nctx|.
+static int
+fade_plane(ncplane* n, const ncfadectx* nctx, uint32_t mult){
+  if(!nctx->rgbfade){ // entirely default and/or palette-indexed
+    return 0;
+  }
+  if(ncplane_own(n)){
+    return -1;
+  }
   // each time through, we need look each cell back up, due to the
   // possibility of a resize event :/
   unsigned dimy, dimx;
   ncplane_dim_yx(n, &dimy, &dimx);
-  unsigned y;
-  for(y = 0 ; y < nctx->rows && y < dimy ; ++y){
-    for(unsigned x = 0 ; x < nctx->cols && x < dimx; ++x){
-      unsigned r, g, b;
-      ncchannels_fg_rgb8(nctx->channels[nctx->cols * y + x], &r, &g, &b);
-      unsigned br, bg, bb;
-      ncchannels_bg_rgb8(nctx->channels[nctx->cols * y + x], &br, &bg, &bb);
-      nccell* c = &n->fb[dimx * y + x];
-      if(!nccell_fg_default_p(c)){
-        r = r * iter / nctx->maxsteps;
-        g = g * iter / nctx->maxsteps;
-        b = b * iter / nctx->maxsteps;
-        nccell_set_fg_rgb8(c, r, g, b);
+  ncplane_damage(n);
+  const unsigned cols = nctx->cols < dimx ? nctx->cols : dimx;
+  for(unsigned y = 0 ; y < nctx->rows && y < dimy ; ++y){
+    nccell* row = &n->fb[nfbcellidx(n, y, 0)];
+    const uint64_t* orig = &nctx->channels[nctx->cols * y];
+    for(unsigned x = 0 ; x < cols ; x += FADE_SPAN){
+      uint64_t scaled[FADE_SPAN];
+      const unsigned span = cols - x < FADE_SPAN ? cols - x : FADE_SPAN;
+      fade_scale_span(orig + x, scaled, span, mult);
+      for(unsigned s = 0 ; s < span ; ++s){
+        row[x + s].channels = fade_channels(nctx, row[x + s].channels, scaled[s]);
       }
-      if(!nccell_bg_default_p(c)){
-        br = br * iter / nctx->maxsteps;
-        bg = bg * iter / nctx->maxsteps;
-        bb = bb * iter / nctx->maxsteps;
-        nccell_set_bg_rgb8(c, br, bg, bb);
+    }
+  }
+  return 0;
+}
+
+// when fading the palette, rewrite each palette entry used by the plane from
+// its snapshot. the cells themselves are untouched, so the next render emits
+// only the changed palette entries (see update_palette()).
+static void
+fade_palette(ncplane* n, const ncfadectx* nctx, uint32_t mult){
+  if(!nctx->palfade){
+    return;
+  }
+  notcurses* nc = ncplane_notcurses(n);
+  for(unsigned idx = 0 ; idx < NCPALETTESIZE ; ++idx){
+    if(nctx->palused[idx]){
+      const uint32_t orig = nctx->palette[idx];
+      const uint32_t chan = (orig & ~NC_BG_RGB_MASK) | fade_scale_channel(orig, mult);
+      if(nc->palette.chans[idx] != chan){
+        nc->palette.chans[idx] = chan;
+        nc->palette_damage[idx] = true;
       }
     }
   }
+}
+
+int ncplane_fadein_iteration(ncplane* n, ncfadectx* nctx, int iter,
+                             fadecb fader, void* curry){
+  const uint32_t mult = fade_factor(iter, nctx->maxsteps);
+  if(fade_plane(n, nctx, mult)){
+    return -1;
+  }
+  fade_palette(n, nctx, mult);
   uint64_t nextwake = (iter + 1) * nctx->nanosecs_step + nctx->startns;
   struct timespec sleepspec;
   sleepspec.tv_sec = nextwake / NANOSECS_IN_SEC;
@@ -171,48 +318,26 @@ ncplane_fadein_internal(ncplane* n, fadecb fader, ncfadectx* pp, void* curry){
   return 0;
 }
 
+int ncfadectx_apply(ncplane* n, const ncfadectx* nctx, uint32_t mult){
+  if(mult > 65536u){
+    mult = 65536u;
+  }
+  if(fade_plane(n, nctx, mult)){
+    return -1;
+  }
+  fade_palette(n, nctx, mult);
+  // the base cell's snapshot follows those of the framebuffer
+  const uint64_t basechans = nctx->channels[nctx->cols * nctx->rows];
+  n->basecell.channels = fade_channels(nctx, n->basecell.channels,
+                                       fade_scale_channels(basechans, mult));
+  return 0;
+}
+
 int ncplane_fadeout_iteration(ncplane* n, ncfadectx* nctx, int iter,
                               fadecb fader, void* curry){
-  unsigned br, bg, bb;
-  unsigned r, g, b;
-  // each time through, we need look each cell back up, due to the
-  // possibility of a resize event :/
-  unsigned dimy, dimx;
-  ncplane_dim_yx(n, &dimy, &dimx);
-  unsigned y;
-  for(y = 0 ; y < nctx->rows && y < dimy ; ++y){
-    for(unsigned x = 0 ; x < nctx->cols && x < dimx; ++x){
-      nccell* c = &n->fb[dimx * y + x];
-      if(!nccell_fg_default_p(c)){
-        ncchannels_fg_rgb8(nctx->channels[nctx->cols * y + x], &r, &g, &b);
-        r = r * (nctx->maxsteps - iter) / nctx->maxsteps;
-        g = g * (nctx->maxsteps - iter) / nctx->maxsteps;
-        b = b * (nctx->maxsteps - iter) / nctx->maxsteps;
-        nccell_set_fg_rgb8(c, r, g, b);
-      }
-      if(!nccell_bg_default_p(c)){
-        ncchannels_bg_rgb8(nctx->channels[nctx->cols * y + x], &br, &bg, &bb);
-        br = br * (nctx->maxsteps - iter) / nctx->maxsteps;
-        bg = bg * (nctx->maxsteps - iter) / nctx->maxsteps;
-        bb = bb * (nctx->maxsteps - iter) / nctx->maxsteps;
-        nccell_set_bg_rgb8(c, br, bg, bb);
-      }
-    }
-  }
-  nccell* c = &n->basecell;
-  if(!nccell_fg_default_p(c)){
-    ncchannels_fg_rgb8(nctx->channels[nctx->cols * y], &r, &g, &b);
-    r = r * (nctx->maxsteps - iter) / nctx->maxsteps;
-    g = g * (nctx->maxsteps - iter) / nctx->maxsteps;
-    b = b * (nctx->maxsteps - iter) / nctx->maxsteps;
-    nccell_set_fg_rgb8(&n->basecell, r, g, b);
-  }
-  if(!nccell_bg_default_p(c)){
-    ncchannels_bg_rgb8(nctx->channels[nctx->cols * y], &br, &bg, &bb);
-    br = br * (nctx->maxsteps - iter) / nctx->maxsteps;
-    bg = bg * (nctx->maxsteps - iter) / nctx->maxsteps;
-    bb = bb * (nctx->maxsteps - iter) / nctx->maxsteps;
-    nccell_set_bg_rgb8(&n->basecell, br, bg, bb);
+  const uint32_t mult = fade_factor(nctx->maxsteps - iter, nctx->maxsteps);
+  if(ncfadectx_apply(n, nctx, mult)){
+    return -1;
   }
   uint64_t nextwake = (iter + 1) * nctx->nanosecs_step + nctx->startns;
   struct timespec sleepspec;
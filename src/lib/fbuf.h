@@ -11,6 +11,9 @@ extern "C" {
 #include <stdint.h>
 #include <unistd.h>
 #include <inttypes.h>
+#ifndef __MINGW32__
+#include <sys/uio.h>
+#endif
 #include "compat/compat.h"
 #include "logging.h"
 
@@ -81,6 +84,46 @@ fbuf_grow(fbuf* f, size_t n){
   return -1;
 }
 
+// large buffers begin (and grow by doubling) from 2MiB, the huge page size
+// on all of x86+PAE, ARMv7+LPAE, ARMv8, and x86-64.
+// FIXME use GetLargePageMinimum() and sysconf
+#define FBUF_LARGE_SIZE 0x200000lu
+
+#if defined(__linux__)
+// MAP_HUGETLB doesn't work with mremap(), but transparent huge pages do. we
+// map large buffers on a huge page boundary (overallocating by one huge page,
+// and trimming the excess from either end), and advise the kernel to back
+// them with huge pages, sparing us 511 of every 512 page faults and TLB
+// entries. they're not MAP_POPULATEd, lest small pages be faulted in before
+// the advice is taken.
+static inline char*
+fbuf_map_large(size_t size){
+#ifdef MAP_UNINITIALIZED
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_UNINITIALIZED;
+#else
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#endif
+  char* map = (char*)mmap(NULL, size + FBUF_LARGE_SIZE, PROT_READ | PROT_WRITE,
+                          flags, -1, 0);
+  if(map == MAP_FAILED){
+    return NULL;
+  }
+  const uintptr_t mask = FBUF_LARGE_SIZE - 1;
+  char* buf = (char*)(((uintptr_t)map + mask) & ~mask);
+  const size_t head = buf - map;
+  if(head){
+    munmap(map, head);
+  }
+  if(FBUF_LARGE_SIZE - head){
+    munmap(buf + size, FBUF_LARGE_SIZE - head);
+  }
+#ifdef MADV_HUGEPAGE
+  madvise(buf, size, MADV_HUGEPAGE); // purely advisory; failure is fine
+#endif
+  return buf;
+}
+#endif
+
 // prepare (a significant amount of) initial space for the fbuf.
 // pass 1 for |small| if it ought be...small.
 static inline int
@@ -88,28 +131,18 @@ fbuf_initgrow(fbuf* f, unsigned small){
   assert(NULL == f->buf);
   assert(0 == f->used);
   assert(0 == f->size);
-  // we start with 2MiB, the huge page size on all of x86+PAE,
-  // ARMv7+LPAE, ARMv8, and x86-64.
-  // FIXME use GetLargePageMinimum() and sysconf
-  size_t size = small ? (4096 > BUFSIZ ? 4096 : BUFSIZ) : 0x200000lu;
+  size_t size = small ? (4096 > BUFSIZ ? 4096 : BUFSIZ) : FBUF_LARGE_SIZE;
 #if defined(__linux__)
-  /*static bool hugepages_failed = false; // FIXME atomic
-  if(!hugepages_failed && !small){
-    // hugepages don't seem to work with mremap() =[
-    // mmap(2): hugetlb results in automatic stretch out to cover hugepage
-    f->buf = (char*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_HUGETLB |
+  if(small){
+    f->buf = (char*)mmap(NULL, size, PROT_READ | PROT_WRITE,
                          MAP_PRIVATE | MAP_ANONYMOUS | MAPFLAGS , -1, 0);
     if(f->buf == MAP_FAILED){
-      hugepages_failed = true;
       f->buf = NULL;
     }
+  }else{
+    f->buf = fbuf_map_large(size);
   }
-  if(f->buf == NULL){ // try again without MAP_HUGETLB */
-  f->buf = (char*)mmap(NULL, size, PROT_READ | PROT_WRITE,
-                        MAP_PRIVATE | MAP_ANONYMOUS | MAPFLAGS , -1, 0);
-  //}
-  if(f->buf == MAP_FAILED){
-    f->buf = NULL;
+  if(f->buf == NULL){
     return -1;
   }
 #else
@@ -186,30 +219,45 @@ fbuf_puts(fbuf* f, const char* s){
   return fbuf_putn(f, s, slen);
 }
 
+// write the decimal digits of |u| to |dst|, which must have room for 10.
+// returns the number of digits written. snprintf() sat atop our profiles
+// for the many small integers making up escapes, so we do it ourselves.
+static inline int
+fbuf_digits(char* dst, unsigned u){
+  char rev[10]; // UINT_MAX has 10 digits
+  int len = 0;
+  do{
+    rev[len++] = '0' + u % 10;
+    u /= 10;
+  }while(u);
+  for(int i = 0 ; i < len ; ++i){
+    dst[i] = rev[len - 1 - i];
+  }
+  return len;
+}
+
 static inline int
 fbuf_putint(fbuf* f, int n){
-  if(fbuf_grow(f, 20)){ // 64-bit int might require up to 20 digits
+  if(fbuf_grow(f, 11)){ // sign plus 10 digits
     return -1;
   }
-  uint64_t r = snprintf(f->buf + f->used, f->size - f->used, "%d", n);
-  if(r > f->size - f->used){
-    assert(r <= f->size - f->used);
-    return -1; // FIXME grow?
+  int r = 0;
+  unsigned u = n;
+  if(n < 0){
+    f->buf[f->used + r++] = '-';
+    u = -u;
   }
+  r += fbuf_digits(f->buf + f->used + r, u);
   f->used += r;
   return r;
 }
 
 static inline int
 fbuf_putuint(fbuf* f, int n){
-  if(fbuf_grow(f, 20)){ // 64-bit int might require up to 20 digits
+  if(fbuf_grow(f, 10)){
     return -1;
   }
-  uint64_t r = snprintf(f->buf + f->used, f->size - f->used, "%u", n);
-  if(r > f->size - f->used){
-    assert(r <= f->size - f->used);
-    return -1; // FIXME grow?
-  }
+  int r = fbuf_digits(f->buf + f->used, n);
   f->used += r;
   return r;
 }
@@ -265,6 +313,111 @@ fbuf_free(fbuf* f){
   }
 }
 
+// each sprixel owns a large fbuf for its glyph, and every blit (i.e. every
+// frame of an animation) builds a new one. rather than mapping and unmapping
+// a buffer each time, freed buffers can be returned to an fbufpool, which
+// retains a few of each size class (large buffers only ever double from
+// FBUF_LARGE_SIZE, so each class is a power of two), up to some total.
+#define FBUFPOOL_CLASSES 8             // FBUF_LARGE_SIZE through 128x that
+#define FBUFPOOL_DEPTH 4               // buffers retained per class
+#define FBUFPOOL_MAXBYTES 0x4000000lu  // 64MiB retained in all
+
+typedef struct fbufpool {
+  pthread_mutex_t lock;                // guards everything below
+  fbuf bufs[FBUFPOOL_CLASSES][FBUFPOOL_DEPTH];
+  unsigned counts[FBUFPOOL_CLASSES];   // valid bufs per class
+  uint64_t bytes;                      // total size of retained bufs
+  uint64_t hits;                       // gets satisfied from the pool
+  uint64_t misses;                     // gets requiring a fresh buffer
+} fbufpool;
+
+static inline int
+fbufpool_init(fbufpool* pool){
+  memset(pool, 0, sizeof(*pool));
+  if(pthread_mutex_init(&pool->lock, NULL)){
+    return -1;
+  }
+  return 0;
+}
+
+// release all retained buffers.
+static inline void
+fbufpool_destroy(fbufpool* pool){
+  for(unsigned c = 0 ; c < FBUFPOOL_CLASSES ; ++c){
+    for(unsigned i = 0 ; i < pool->counts[c] ; ++i){
+      fbuf_free(&pool->bufs[c][i]);
+    }
+    pool->counts[c] = 0;
+  }
+  pool->bytes = 0;
+  pthread_mutex_destroy(&pool->lock);
+}
+
+// the size class of a buffer of |size| bytes, or -1 if it oughtn't be pooled.
+static inline int
+fbufpool_class(uint64_t size){
+  int c = 0;
+  for(uint64_t s = FBUF_LARGE_SIZE ; c < FBUFPOOL_CLASSES ; s *= 2, ++c){
+    if(s == size){
+      return c;
+    }
+  }
+  return -1;
+}
+
+// prepare |f| with a large initial buffer of at least |hint| bytes, taking
+// the smallest suitable one from |pool| if possible. |pool| may be NULL, in
+// which case this is fbuf_init() (plus any necessary growth).
+static inline int
+fbufpool_get(fbufpool* pool, fbuf* f, size_t hint){
+  if(pool){
+    pthread_mutex_lock(&pool->lock);
+    for(unsigned c = 0 ; c < FBUFPOOL_CLASSES ; ++c){
+      if(pool->counts[c] && (FBUF_LARGE_SIZE << c) >= hint){
+        *f = pool->bufs[c][--pool->counts[c]];
+        pool->bytes -= f->size;
+        ++pool->hits;
+        pthread_mutex_unlock(&pool->lock);
+        return 0;
+      }
+    }
+    ++pool->misses;
+    pthread_mutex_unlock(&pool->lock);
+  }
+  if(fbuf_init(f)){
+    return -1;
+  }
+  if(fbuf_reserve(f, hint)){
+    fbuf_free(f);
+    return -1;
+  }
+  return 0;
+}
+
+// return the buffer of |f| to |pool|, or free it if the pool is full (or
+// NULL, or |f| is not of a pooled size). either way, |f| is left empty.
+static inline void
+fbufpool_put(fbufpool* pool, fbuf* f){
+  if(pool && f->buf){
+    const int c = fbufpool_class(f->size);
+    if(c >= 0){
+      pthread_mutex_lock(&pool->lock);
+      if(pool->counts[c] < FBUFPOOL_DEPTH &&
+         pool->bytes + f->size <= FBUFPOOL_MAXBYTES){
+        f->used = 0;
+        pool->bufs[c][pool->counts[c]++] = *f;
+        pool->bytes += f->size;
+        pthread_mutex_unlock(&pool->lock);
+        f->buf = NULL;
+        f->size = 0;
+        return;
+      }
+      pthread_mutex_unlock(&pool->lock);
+    }
+  }
+  fbuf_free(f);
+}
+
 // write(2) until we've written it all. uses poll(2) to avoid spinning on
 // EAGAIN, at the possible cost of some small latency.
 static inline int
@@ -296,6 +449,64 @@ blocking_write(int fd, const char* buf, size_t buflen){
   return 0;
 }
 
+#ifndef __MINGW32__
+// as blocking_write(), but gathering from |iovcnt| buffers with writev(2).
+// the entries of |iov| are advanced past whatever has been written. unless
+// |chunk| is 0, no single writev(2) is handed more than |chunk| bytes.
+static inline int
+blocking_writev_chunked(int fd, struct iovec* iov, int iovcnt, size_t chunk){
+  while(iovcnt){
+    // offer at most |chunk| bytes, trimming the last iovec offered
+    int cnt = iovcnt;
+    size_t offered = 0;
+    size_t trimmed = 0;
+    for(int i = 0 ; i < iovcnt ; ++i){
+      if(chunk && offered + iov[i].iov_len >= chunk){
+        trimmed = iov[i].iov_len - (chunk - offered);
+        iov[i].iov_len -= trimmed;
+        offered = chunk;
+        cnt = i + 1;
+        break;
+      }
+      offered += iov[i].iov_len;
+    }
+    ssize_t w = writev(fd, iov, cnt);
+    iov[cnt - 1].iov_len += trimmed;
+    if(w < 0){
+      if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != EBUSY){
+        logerror("Error writing out data on %d (%s)", fd, strerror(errno));
+        return -1;
+      }
+      w = 0;
+    }
+    const bool partial = (size_t)w < offered;
+    while(iovcnt && (size_t)w >= iov->iov_len){
+      w -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if(iovcnt){
+      iov->iov_base = (char*)iov->iov_base + w;
+      iov->iov_len -= w;
+      if(partial){
+        struct pollfd pfd = {
+          .fd = fd,
+          .events = POLLOUT,
+          .revents = 0,
+        };
+        poll(&pfd, 1, -1);
+      }
+    }
+  }
+  return 0;
+}
+
+static inline int
+blocking_writev(int fd, struct iovec* iov, int iovcnt){
+  return blocking_writev_chunked(fd, iov, iovcnt, 0);
+}
+#endif
+
 // attempt to write the contents of |f| to the FILE |fp|, if there are any
 // contents. reset the fbuf either way.
 static inline int
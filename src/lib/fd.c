@@ -6,15 +6,23 @@
 #ifdef USING_PIDFD
 #error "USING_PIDFD was already defined; it should not be."
 #endif
+#ifdef USING_EPOLL
+#error "USING_EPOLL was already defined; it should not be."
+#endif
 #ifdef __MINGW32__
 #include <winsock2.h>
 #else
 #include <spawn.h>
+#include <sys/mman.h>
 #endif
+#include <limits.h>
+#include <sys/stat.h>
 #if (defined(__linux__))
 #include <linux/wait.h>
 #include <asm/unistd.h>
 #include <linux/sched.h>
+#include <sys/epoll.h>
+#define USING_EPOLL
 #define NCPOLLEVENTS (POLLIN | POLLRDHUP)
 #if (defined(__NR_clone3) && defined(P_PIDFD) && defined(CLONE_CLEAR_SIGHAND))
 #define USING_PIDFD
@@ -23,96 +31,751 @@
 #define NCPOLLEVENTS (POLLIN)
 #endif
 
-// release the memory and fd, but don't join the thread (since we might be
-// getting called within the thread's context, on a callback).
+// default cap on the read buffer, which starts at BUFSIZ and doubles each
+// time a read fills it. 64KiB is the default pipe capacity on Linux.
+#define FDPLANE_DEFAULT_BUFMAX 65536
+
+// a followed fd which can't be waited upon (e.g. a regular file) is retried
+// this often once it hits EOF, and subprocesses without a pidfd are checked
+// for exit this often.
+#define FDREACTOR_FOLLOW_NS (50 * 1000000ull)
+#define FDREACTOR_WAITPID_NS (20 * 1000000ull)
+
+// at most this many reads are made of any one fd per wakeup, so that a
+// firehose can't starve its neighbors.
+#define FDREACTOR_BURST 16
+
+// every ncfdplane and ncsubproc of a notcurses context is serviced by a single
+// reactor thread, created along with the first of them, and all callbacks are
+// invoked there. on linux, it waits in epoll; elsewhere, it poll()s. the
+// registry can be extended from any thread, but entries are only ever
+// removed by the reactor, so those it's working with remain valid without
+// holding the lock. each ready fd is identified by a tag: its ncfdplane's
+// address, with the low bit set if it's the subprocess's pidfd.
+typedef struct fd_reactor {
+  pthread_mutex_t lock;   // guards the registry and destruction state
+  pthread_cond_t cond;    // signaled whenever destroyed ncfdplanes are reaped
+  pthread_t tid;
+  int wake[2];            // written to interrupt the wait (not on windows)
+  int epfd;               // epoll instance (linux only)
+  ncfdplane** fdps;       // registry
+  unsigned fdpcount, fdpalloc;
+  bool done;
+  // everything below is touched only by the reactor thread
+  ncfdplane** snap;       // copy of the registry for the current iteration
+  unsigned snapalloc;
+  uintptr_t* ready;       // tags of ready fds
+  unsigned readyalloc;
+#ifndef USING_EPOLL
+  struct pollfd* pfds;    // the wake pipe, followed by each watched fd
+  unsigned pfdalloc;
+#endif
+} fd_reactor;
+
+static inline ncfdplane*
+tag_fdplane(uintptr_t tag){
+  return (ncfdplane*)(tag & ~(uintptr_t)1u);
+}
+
+static void
+fd_reactor_wake(fd_reactor* r){
+#ifndef __MINGW32__
+  if(write(r->wake[1], "", 1) < 0 && errno != EAGAIN){
+    logwarn("couldn't wake fd reactor (%s)", strerror(errno));
+  }
+#else
+  (void)r;
+#endif
+}
+
+// has ncfdplane_destroy() been called on this ncfdplane?
+static bool
+fdplane_live(fd_reactor* r, const ncfdplane* fdp){
+  pthread_mutex_lock(&r->lock);
+  bool ret = !fdp->destroyed;
+  pthread_mutex_unlock(&r->lock);
+  return ret;
+}
+
+// release the memory and fd. the ncfdplane must no longer be registered.
 static int
 ncfdplane_destroy_inner(ncfdplane* n){
   int ret = close(n->fd);
+  free(n->buf);
   free(n);
   return ret;
 }
 
-// if pidfd is < 0, it won't be used in the poll()
+// start waiting on the fd (and pidfd, if we're a subprocess's reader). an fd
+// which can't be waited upon (a regular file, or anything epoll rejects) is
+// instead read on the reactor's schedule. called with the reactor locked.
 static void
-fdthread(ncfdplane* ncfp, int pidfd){
-  struct pollfd pfds[2];
-  memset(pfds, 0, sizeof(pfds));
-  char* buf = malloc(BUFSIZ + 1);
-  pfds[0].fd = ncfp->fd;
-  pfds[0].events = NCPOLLEVENTS;
-  const int fdcount = pidfd < 0 ? 1 : 2;
-  if(fdcount > 1){
-    pfds[1].fd = pidfd;
-    pfds[1].events = NCPOLLEVENTS;
-  }
-  ssize_t r = 0;
-#ifndef __MINGW32__
-  while(poll(pfds, fdcount, -1) >= 0 || errno == EINTR){
+fdplane_watch(fd_reactor* r, ncfdplane* fdp){
+  struct stat st;
+  fdp->pollable = !(fstat(fdp->fd, &st) == 0 && S_ISREG(st.st_mode));
+#ifdef USING_EPOLL
+  if(fdp->pollable){
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, };
+    ev.data.u64 = (uintptr_t)fdp;
+    if(epoll_ctl(r->epfd, EPOLL_CTL_ADD, fdp->fd, &ev)){
+      loginfo("can't epoll %d (%s), polling it", fdp->fd, strerror(errno));
+      fdp->pollable = false;
+    }
+  }
+  if(fdp->pidfd >= 0){
+    struct epoll_event ev = { .events = EPOLLIN, };
+    ev.data.u64 = (uintptr_t)fdp | 1u;
+    if(epoll_ctl(r->epfd, EPOLL_CTL_ADD, fdp->pidfd, &ev) == 0){
+      fdp->pidwatched = true;
+    }else{
+      logwarn("couldn't epoll pidfd %d (%s)", fdp->pidfd, strerror(errno));
+    }
+  }
 #else
-  while(WSAPoll(pfds, fdcount, -1) >= 0){
+  (void)r;
+  fdp->pidwatched = fdp->pidfd >= 0;
 #endif
-    if(pfds[0].revents){
-      while((r = read(ncfp->fd, buf, BUFSIZ)) >= 0){
-        if(r == 0){
-          break;
-        }
-        buf[r] = '\0';
-        if( (r = ncfp->cb(ncfp, buf, r, ncfp->curry)) ){
-          break;
-        }
-        if(ncfp->destroyed){
-          break;
+  fdp->watched = fdp->pollable;
+}
+
+static void
+fdplane_unwatch_fd(fd_reactor* r, ncfdplane* fdp){
+  if(fdp->watched){
+#ifdef USING_EPOLL
+    epoll_ctl(r->epfd, EPOLL_CTL_DEL, fdp->fd, NULL);
+#else
+    (void)r;
+#endif
+    fdp->watched = false;
+  }
+}
+
+static void
+fdplane_unwatch(fd_reactor* r, ncfdplane* fdp){
+  fdplane_unwatch_fd(r, fdp);
+  if(fdp->pidwatched){
+#ifdef USING_EPOLL
+    epoll_ctl(r->epfd, EPOLL_CTL_DEL, fdp->pidfd, NULL);
+#endif
+    fdp->pidwatched = false;
+  }
+}
+
+// stop servicing the ncfdplane, flushing any held data. the done callback is
+// invoked if requested (and we've not been destroyed).
+static void
+fdplane_finish(fd_reactor* r, ncfdplane* fdp, bool calldone, int fderrno){
+  fdplane_unwatch(r, fdp);
+  fdp->finished = true;
+  if(fdp->used && fdplane_live(r, fdp)){
+    fdp->buf[fdp->used] = '\0';
+    if(fdp->cb(fdp, fdp->buf, fdp->used, fdp->curry)){
+      calldone = false;
+    }
+  }
+  fdp->used = 0;
+  if(calldone && fdplane_live(r, fdp)){
+    fdp->donecb(fdp, fderrno, fdp->curry);
+  }
+}
+
+// deliver the accumulated bytes to the user callback. returns non-zero if
+// we ought stop reading: the callback returned non-zero (we're then finished,
+// and the done callback is invoked for a negative result), or destroyed us.
+static int
+fdplane_deliver(fd_reactor* r, ncfdplane* fdp){
+  fdp->buf[fdp->used] = '\0';
+  int ret = fdp->cb(fdp, fdp->buf, fdp->used, fdp->curry);
+  fdp->used = 0;
+  if(!fdplane_live(r, fdp)){
+    return -1;
+  }
+  if(ret){
+    fdplane_finish(r, fdp, ret < 0, ECANCELED);
+  }
+  return ret;
+}
+
+// double the read buffer, up to the configured maximum. returns false if it
+// can't be grown, whether due to the cap or a failed allocation.
+static bool
+fdplane_grow(ncfdplane* fdp){
+  if(fdp->alloc >= fdp->bufmax){
+    return false;
+  }
+  size_t nalloc = fdp->alloc * 2;
+  if(nalloc > fdp->bufmax){
+    nalloc = fdp->bufmax;
+  }
+  char* tmp = realloc(fdp->buf, nalloc + 1);
+  if(tmp == NULL){
+    return false;
+  }
+  fdp->buf = tmp;
+  fdp->alloc = nalloc;
+  return true;
+}
+
+#ifndef __MINGW32__
+// if the fd is a regular file, map whatever lies beyond its current offset,
+// and hand it to the callback straight from the mapping, in chunks of at most
+// bufmax bytes. the offset is then left where delivery stopped, so that any
+// further reading (including follow) picks up from there. returns non-zero
+// if we ought stop reading, as fdplane_deliver(). if the fd wasn't mappable,
+// we fall back to read().
+static int
+fdplane_mapped(fd_reactor* r, ncfdplane* fdp){
+  struct stat st;
+  if(fstat(fdp->fd, &st) || !S_ISREG(st.st_mode)){
+    return 0;
+  }
+  off_t off = lseek(fdp->fd, 0, SEEK_CUR);
+  if(off < 0 || off >= st.st_size){
+    return 0;
+  }
+  const size_t len = st.st_size;
+  char* map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fdp->fd, 0);
+  if(map == MAP_FAILED){
+    logwarn("couldn't map %zuB from %d (%s)", len, fdp->fd, strerror(errno));
+    return 0;
+  }
+  madvise(map, len, MADV_SEQUENTIAL);
+  int ret = 0;
+  while((size_t)off < len){
+    size_t chunk = len - off;
+    if(chunk > fdp->bufmax){
+      chunk = fdp->bufmax;
+    }
+    ret = fdp->cb(fdp, map + off, chunk, fdp->curry);
+    off += chunk;
+    if(!fdplane_live(r, fdp)){
+      ret = -1;
+      break;
+    }
+    if(ret){
+      fdplane_finish(r, fdp, ret < 0, ECANCELED);
+      break;
+    }
+  }
+  munmap(map, len);
+  if(ret == 0 || fdplane_live(r, fdp)){
+    lseek(fdp->fd, off, SEEK_SET);
+  }
+  return ret;
+}
+#endif
+
+// has our subprocess exited? reaps it if so, recording its status.
+static bool
+subproc_reap(ncsubproc* ncsp){
+  pthread_mutex_lock(&ncsp->lock);
+#ifndef __MINGW32__
+  if(!ncsp->waited){
+    if(waitpid(ncsp->pid, &ncsp->status, WNOHANG) == ncsp->pid){
+      ncsp->waited = true;
+    }
+  }
+#endif
+  bool ret = ncsp->waited;
+  pthread_mutex_unlock(&ncsp->lock);
+  return ret;
+}
+
+static bool fdplane_service(fd_reactor* r, ncfdplane* fdp, unsigned burst);
+
+// our subprocess has exited. read whatever it left in the pipe, then call
+// the done callback. with a pidfd, it gets 0 (as we reap only after the
+// fact); otherwise, the wait status.
+static void
+subproc_exited(fd_reactor* r, ncfdplane* fdp){
+  if(fdp->watched){
+    fdplane_service(r, fdp, UINT_MAX);
+    if(fdp->finished || !fdplane_live(r, fdp)){
+      return;
+    }
+  }
+  int status = 0;
+  subproc_reap(fdp->subproc);
+  if(fdp->pidfd < 0){
+    status = fdp->subproc->status;
+  }
+  fdplane_finish(r, fdp, true, status);
+}
+
+// the fd returned EOF. flush anything held. a followed fd which can't be
+// waited upon is retried later. a subprocess's pipe is forgotten, and we
+// await the subprocess's exit. otherwise, we're done.
+static void
+fdplane_eof(fd_reactor* r, ncfdplane* fdp){
+  if(fdp->used && fdplane_deliver(r, fdp)){
+    return;
+  }
+  if(!fdp->pollable && fdp->follow){
+    fdp->nextpoll = clock_getns(CLOCK_MONOTONIC) + FDREACTOR_FOLLOW_NS;
+  }else if(fdp->subproc){
+    fdplane_unwatch_fd(r, fdp);
+    fdp->eof = true;
+    if(fdp->pidfd < 0 && subproc_reap(fdp->subproc)){
+      subproc_exited(r, fdp);
+    }
+  }else{
+    fdplane_finish(r, fdp, true, 0);
+  }
+}
+
+// read up to |burst| times from the fd, delivering according to its buffering
+// policy, and handling EOF and errors. returns true if it might well still be
+// readable (we stopped due to |burst|).
+static bool
+fdplane_service(fd_reactor* r, ncfdplane* fdp, unsigned burst){
+  while(burst--){
+    ssize_t s = read(fdp->fd, fdp->buf + fdp->used, fdp->alloc - fdp->used);
+    if(s > 0){
+      if(fdp->used == 0){
+        fdp->deadline = clock_getns(CLOCK_MONOTONIC) + fdp->coalescens;
+      }
+      fdp->used += s;
+      if(fdp->used == fdp->alloc && fdplane_grow(fdp)){
+        continue;
+      }
+      if(fdp->used == fdp->alloc || clock_getns(CLOCK_MONOTONIC) >= fdp->deadline){
+        if(fdplane_deliver(r, fdp)){
+          return false;
         }
       }
-      // if we're not doing follow, break out on a zero-byte read
-      if(r == 0 && !ncfp->follow){
-        break;
+    }else if(s == 0){
+      fdplane_eof(r, fdp);
+      return false;
+    }else if(errno == EAGAIN || errno == EWOULDBLOCK){
+      return false;
+    }else if(errno != EINTR){
+      fdplane_finish(r, fdp, true, errno);
+      return false;
+    }
+  }
+  return true;
+}
+
+// drop destroyed ncfdplanes from the registry, waking any destroyers waiting
+// on them (they'll free the ncfdplane themselves). called with the lock held.
+static void
+fd_reactor_reap(fd_reactor* r){
+  bool reaped = false;
+  for(unsigned i = 0 ; i < r->fdpcount ; ){
+    ncfdplane* fdp = r->fdps[i];
+    if(!fdp->destroyed){
+      ++i;
+      continue;
+    }
+    fdplane_unwatch(r, fdp);
+    r->fdps[i] = r->fdps[--r->fdpcount];
+    if(fdp->waiter){
+      fdp->reaped = true;
+      reaped = true;
+    }else{
+      ncfdplane_destroy_inner(fdp);
+    }
+  }
+  if(reaped){
+    pthread_cond_broadcast(&r->cond);
+  }
+}
+
+// how long can we wait before some ncfdplane needs attention (ms, -1 for
+// forever)? also performs the initial delivery of mapped files.
+static int
+fd_reactor_timeout(fd_reactor* r, unsigned count){
+  uint64_t now = clock_getns(CLOCK_MONOTONIC);
+  uint64_t until = UINT64_MAX;
+  for(unsigned i = 0 ; i < count ; ++i){
+    ncfdplane* fdp = r->snap[i];
+    if(fdp->finished || !fdplane_live(r, fdp)){
+      continue;
+    }
+#ifndef __MINGW32__
+    if(!fdp->mapped){
+      fdp->mapped = true;
+      if(fdp->mapfile && (fdplane_mapped(r, fdp) || fdp->finished)){
+        continue;
+      }
+    }
+#endif
+    if(fdp->used && fdp->deadline < until){
+      until = fdp->deadline;
+    }
+    if(!fdp->pollable && !fdp->eof && fdp->nextpoll < until){
+      until = fdp->nextpoll;
+    }
+    if(fdp->subproc && fdp->pidfd < 0){
+      if(now + FDREACTOR_WAITPID_NS < until){
+        until = now + FDREACTOR_WAITPID_NS;
       }
     }
-    if(fdcount > 1 && pfds[1].revents){
-      r = 0;
-      break;
+  }
+#ifdef __MINGW32__
+  // without a wake pipe, we must notice new registrations on our own
+  if(now + FDREACTOR_WAITPID_NS < until){
+    until = now + FDREACTOR_WAITPID_NS;
+  }
+#endif
+  if(until == UINT64_MAX){
+    return -1;
+  }
+  if(until <= now){
+    return 0;
+  }
+  return (until - now + 999999) / 1000000;
+}
+
+// attend to anything whose time has come: unwaitable fds due to be read,
+// held data due for delivery, and subprocesses lacking a pidfd.
+static void
+fd_reactor_timers(fd_reactor* r, unsigned count){
+  uint64_t now = clock_getns(CLOCK_MONOTONIC);
+  for(unsigned i = 0 ; i < count ; ++i){
+    ncfdplane* fdp = r->snap[i];
+    if(fdp->finished || !fdplane_live(r, fdp)){
+      continue;
+    }
+    if(!fdp->pollable && !fdp->eof && fdp->nextpoll <= now){
+      fdp->nextpoll = 0;
+      fdplane_service(r, fdp, FDREACTOR_BURST);
+      if(fdp->finished || !fdplane_live(r, fdp)){
+        continue;
+      }
+    }
+    if(fdp->used && fdp->deadline <= now){
+      if(fdplane_deliver(r, fdp)){
+        continue;
+      }
+    }
+    if(fdp->subproc && fdp->pidfd < 0 && subproc_reap(fdp->subproc)){
+      subproc_exited(r, fdp);
+    }
+  }
+}
+
+static void
+fd_reactor_dispatch(fd_reactor* r, uintptr_t tag){
+  ncfdplane* fdp = tag_fdplane(tag);
+  if(fdp->finished || !fdplane_live(r, fdp)){
+    return;
+  }
+  if(tag & 1u){
+    if(fdp->pidwatched){
+      subproc_exited(r, fdp);
     }
+  }else if(fdp->watched){
+    fdplane_service(r, fdp, FDREACTOR_BURST);
   }
-  if(r <= 0 && !ncfp->destroyed){
-    ncfp->donecb(ncfp, r == 0 ? 0 : errno, ncfp->curry);
+}
+
+#ifndef __MINGW32__
+static void
+fd_reactor_drain_wake(fd_reactor* r){
+  char c[64];
+  while(read(r->wake[0], c, sizeof(c)) > 0){
+    ;
+  }
+}
+#endif
+
+// wait up to |timeout| ms for readiness, filling r->ready with the tags of
+// ready fds. returns the number of ready fds, or -1 on error.
+static int
+fd_reactor_wait(fd_reactor* r, unsigned count, int timeout){
+  unsigned maxready = count * 2 + 1;
+  if(maxready > r->readyalloc){
+    uintptr_t* tmp = realloc(r->ready, sizeof(*tmp) * maxready);
+    if(tmp == NULL){
+      return -1;
+    }
+    r->ready = tmp;
+    r->readyalloc = maxready;
+  }
+  int readycount = 0;
+#ifdef USING_EPOLL
+  struct epoll_event evs[64];
+  int maxevs = maxready < 64 ? (int)maxready : 64;
+  int e = epoll_wait(r->epfd, evs, maxevs, timeout);
+  if(e < 0){
+    return errno == EINTR ? 0 : -1;
+  }
+  for(int i = 0 ; i < e ; ++i){
+    if(evs[i].data.u64 == 0){
+      fd_reactor_drain_wake(r);
+    }else{
+      r->ready[readycount++] = evs[i].data.u64;
+    }
+  }
+#else
+  if(maxready > r->pfdalloc){
+    struct pollfd* tmp = realloc(r->pfds, sizeof(*tmp) * maxready);
+    if(tmp == NULL){
+      return -1;
+    }
+    r->pfds = tmp;
+    r->pfdalloc = maxready;
+  }
+  // r->ready[i] tags r->pfds[i + 1] until the poll completes
+  unsigned pcount = 0;
+#ifndef __MINGW32__
+  r->pfds[pcount].fd = r->wake[0];
+  r->pfds[pcount++].events = POLLIN;
+#endif
+  unsigned tcount = 0;
+  for(unsigned i = 0 ; i < count ; ++i){
+    ncfdplane* fdp = r->snap[i];
+    if(fdp->watched){
+      r->pfds[pcount].fd = fdp->fd;
+      r->pfds[pcount++].events = NCPOLLEVENTS;
+      r->ready[tcount++] = (uintptr_t)fdp;
+    }
+    if(fdp->pidwatched){
+      r->pfds[pcount].fd = fdp->pidfd;
+      r->pfds[pcount++].events = NCPOLLEVENTS;
+      r->ready[tcount++] = (uintptr_t)fdp | 1u;
+    }
+  }
+  for(unsigned i = 0 ; i < pcount ; ++i){
+    r->pfds[i].revents = 0;
+  }
+#ifndef __MINGW32__
+  int p = poll(r->pfds, pcount, timeout);
+  if(p < 0){
+    return errno == EINTR ? 0 : -1;
+  }
+  unsigned firstfd = 1;
+  if(r->pfds[0].revents){
+    fd_reactor_drain_wake(r);
   }
-  if(ncfp->destroyed){
-    ncfdplane_destroy_inner(ncfp);
+#else
+  int p = WSAPoll(r->pfds, pcount, timeout);
+  if(p < 0){
+    return -1;
+  }
+  unsigned firstfd = 0;
+#endif
+  for(unsigned i = firstfd ; i < pcount ; ++i){
+    if(r->pfds[i].revents){
+      r->ready[readycount++] = r->ready[i - firstfd];
+    }
   }
-  free(buf);
+#endif
+  return readycount;
 }
 
-static void *
-ncfdplane_thread(void* vncfp){
-  fdthread(vncfp, -1);
+static void*
+fd_reactor_thread(void* vr){
+  fd_reactor* r = vr;
+  nc_thread_setup("reactor");
+  for(;;){
+    pthread_mutex_lock(&r->lock);
+    fd_reactor_reap(r);
+    if(r->done){
+      pthread_mutex_unlock(&r->lock);
+      break;
+    }
+    unsigned count = r->fdpcount;
+    if(count > r->snapalloc){
+      ncfdplane** tmp = realloc(r->snap, sizeof(*tmp) * count);
+      if(tmp == NULL){
+        count = r->snapalloc;
+      }else{
+        r->snap = tmp;
+        r->snapalloc = count;
+      }
+    }
+    memcpy(r->snap, r->fdps, sizeof(*r->snap) * count);
+    pthread_mutex_unlock(&r->lock);
+    int timeout = fd_reactor_timeout(r, count);
+    int readycount = fd_reactor_wait(r, count, timeout);
+    if(readycount < 0){
+      logerror("error waiting on fds (%s)", strerror(errno));
+      readycount = 0;
+    }
+    for(int i = 0 ; i < readycount ; ++i){
+      fd_reactor_dispatch(r, r->ready[i]);
+    }
+    fd_reactor_timers(r, count);
+  }
   return NULL;
 }
 
+static fd_reactor*
+fd_reactor_create(void){
+  fd_reactor* r = malloc(sizeof(*r));
+  if(r == NULL){
+    return NULL;
+  }
+  memset(r, 0, sizeof(*r));
+  r->epfd = -1;
+  r->wake[0] = r->wake[1] = -1;
+#ifndef __MINGW32__
+#ifdef __linux__
+  if(pipe2(r->wake, O_CLOEXEC | O_NONBLOCK)){
+#else
+  if(pipe(r->wake)){
+#endif
+    free(r);
+    return NULL;
+  }
+#ifndef __linux__
+  set_fd_cloexec(r->wake[0], 1, NULL);
+  set_fd_cloexec(r->wake[1], 1, NULL);
+  set_fd_nonblocking(r->wake[0], 1, NULL);
+  set_fd_nonblocking(r->wake[1], 1, NULL);
+#endif
+#endif
+#ifdef USING_EPOLL
+  // the wake pipe is tagged 0, which no ncfdplane can be
+  struct epoll_event ev = { .events = EPOLLIN, };
+  ev.data.u64 = 0;
+  if((r->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0 ||
+     epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->wake[0], &ev)){
+    logerror("couldn't set up epoll (%s)", strerror(errno));
+    goto err;
+  }
+#endif
+  if(pthread_mutex_init(&r->lock, NULL)){
+    goto err;
+  }
+  if(pthread_cond_init(&r->cond, NULL)){
+    pthread_mutex_destroy(&r->lock);
+    goto err;
+  }
+  if(pthread_create(&r->tid, NULL, fd_reactor_thread, r)){
+    pthread_cond_destroy(&r->cond);
+    pthread_mutex_destroy(&r->lock);
+    goto err;
+  }
+  return r;
+
+err:
+  if(r->epfd >= 0){
+    close(r->epfd);
+  }
+#ifndef __MINGW32__
+  close(r->wake[0]);
+  close(r->wake[1]);
+#endif
+  free(r);
+  return NULL;
+}
+
+int fd_reactor_destroy(fd_reactor* r){
+  if(r == NULL){
+    return 0;
+  }
+  pthread_mutex_lock(&r->lock);
+  r->done = true;
+  pthread_mutex_unlock(&r->lock);
+  fd_reactor_wake(r);
+  int ret = pthread_join(r->tid, NULL);
+  // anything left was never destroyed by the user
+  for(unsigned i = 0 ; i < r->fdpcount ; ++i){
+    ncfdplane* fdp = r->fdps[i];
+    fdplane_unwatch(r, fdp);
+    if(fdp->waiter){
+      fdp->reaped = true;
+    }else{
+      ncfdplane_destroy_inner(fdp);
+    }
+  }
+  pthread_cond_broadcast(&r->cond);
+  if(r->epfd >= 0){
+    close(r->epfd);
+  }
+#ifndef __MINGW32__
+  close(r->wake[0]);
+  close(r->wake[1]);
+#endif
+#ifndef USING_EPOLL
+  free(r->pfds);
+#endif
+  free(r->fdps);
+  free(r->snap);
+  free(r->ready);
+  pthread_cond_destroy(&r->cond);
+  pthread_mutex_destroy(&r->lock);
+  free(r);
+  return ret;
+}
+
+// the reactor is created along with the first ncfdplane, and lives until
+// notcurses_stop().
+static fd_reactor*
+notcurses_fd_reactor(notcurses* nc){
+  pthread_mutex_lock(&nc->pilelock);
+  if(nc->fdreactor == NULL){
+    nc->fdreactor = fd_reactor_create();
+  }
+  fd_reactor* r = nc->fdreactor;
+  pthread_mutex_unlock(&nc->pilelock);
+  return r;
+}
+
+static int
+fd_reactor_add(fd_reactor* r, ncfdplane* fdp){
+  pthread_mutex_lock(&r->lock);
+  if(r->fdpcount == r->fdpalloc){
+    unsigned nalloc = r->fdpalloc ? r->fdpalloc * 2 : 8;
+    ncfdplane** tmp = realloc(r->fdps, sizeof(*tmp) * nalloc);
+    if(tmp == NULL){
+      pthread_mutex_unlock(&r->lock);
+      return -1;
+    }
+    r->fdps = tmp;
+    r->fdpalloc = nalloc;
+  }
+  fdplane_watch(r, fdp);
+  r->fdps[r->fdpcount++] = fdp;
+  pthread_mutex_unlock(&r->lock);
+  fd_reactor_wake(r);
+  return 0;
+}
+
+// the fd is made nonblocking, as it's serviced alongside others. if |subproc|
+// is not NULL, we're its pipe reader, and also watch |pidfd|.
 static ncfdplane*
 ncfdplane_create_internal(ncplane* n, const ncfdplane_options* opts, int fd,
                           ncfdplane_callback cbfxn, ncfdplane_done_cb donecbfxn,
-                          bool thread){
-  if(opts->flags > 0){
+                          ncsubproc* subproc, int pidfd){
+  if(opts->flags > NCFDPLANE_OPTION_MAPFILE){
     logwarn("provided unsupported flags %016" PRIx64, opts->flags);
   }
+  fd_reactor* r = notcurses_fd_reactor(ncplane_notcurses(n));
+  if(r == NULL){
+    return NULL;
+  }
   ncfdplane* ret = malloc(sizeof(*ret));
   if(ret == NULL){
     return ret;
   }
+  memset(ret, 0, sizeof(*ret));
+  ret->bufmax = opts->bufsize ? opts->bufsize : FDPLANE_DEFAULT_BUFMAX;
+  ret->alloc = BUFSIZ < ret->bufmax ? BUFSIZ : ret->bufmax;
+  if((ret->buf = malloc(ret->alloc + 1)) == NULL){
+    free(ret);
+    return NULL;
+  }
   ret->cb = cbfxn;
   ret->donecb = donecbfxn;
   ret->follow = opts->follow;
+  ret->mapfile = opts->flags & NCFDPLANE_OPTION_MAPFILE;
+  ret->coalescens = opts->coalesce_ms * 1000000ull;
   ret->ncp = n;
-  ret->destroyed = false;
+  ret->reactor = r;
+  ret->subproc = subproc;
+  ret->pidfd = pidfd;
   ncplane_set_scrolling(ret->ncp, true);
   ret->fd = fd;
   ret->curry = opts->curry;
-  if(thread){
-    if(pthread_create(&ret->tid, NULL, ncfdplane_thread, ret)){
-      free(ret);
-      return NULL;
-    }
+  set_fd_nonblocking(fd, 1, NULL);
+  if(fd_reactor_add(r, ret)){
+    free(ret->buf);
+    free(ret);
+    return NULL;
   }
   return ret;
 }
@@ -126,23 +789,34 @@ ncfdplane* ncfdplane_create(ncplane* n, const ncfdplane_options* opts, int fd,
   if(fd < 0 || !cbfxn || !donecbfxn){
     return NULL;
   }
-  return ncfdplane_create_internal(n, opts, fd, cbfxn, donecbfxn, true);
+  return ncfdplane_create_internal(n, opts, fd, cbfxn, donecbfxn, NULL, -1);
 }
 
 ncplane* ncfdplane_plane(ncfdplane* n){
   return n->ncp;
 }
 
+// from the reactor (i.e. within a callback), we just mark the ncfdplane, and
+// it's freed once the callback returns. otherwise, we wait for the reactor
+// to drop it, so that no callback is running (nor will run) once we return.
 int ncfdplane_destroy(ncfdplane* n){
   int ret = 0;
   if(n){
-    if(pthread_equal(pthread_self(), n->tid)){
-      n->destroyed = true; // ncfdplane_destroy_inner() is called on thread exit
-    }else{
-      void* vret = NULL;
-      ret |= cancel_and_join("fdplane", n->tid, &vret);
-      ret |= ncfdplane_destroy_inner(n);
+    fd_reactor* r = n->reactor;
+    pthread_mutex_lock(&r->lock);
+    n->destroyed = true;
+    if(pthread_equal(pthread_self(), r->tid)){
+      fdplane_unwatch(r, n);
+      pthread_mutex_unlock(&r->lock);
+      return 0;
     }
+    n->waiter = true;
+    fd_reactor_wake(r);
+    while(!n->reaped){
+      pthread_cond_wait(&r->cond, &r->lock);
+    }
+    pthread_mutex_unlock(&r->lock);
+    ret = ncfdplane_destroy_inner(n);
   }
   return ret;
 }
@@ -263,74 +937,18 @@ kill_and_wait_subproc(pid_t pid, int pidfd, int* status){
   return 0;
 }
 
-// need a poll on both main fd and pidfd
-static void *
-ncsubproc_thread(void* vncsp){
-  int* status = malloc(sizeof(*status));
-  if(status){
-    ncsubproc* ncsp = vncsp;
-    fdthread(ncsp->nfp, ncsp->pidfd);
-    if(kill_and_wait_subproc(ncsp->pid, ncsp->pidfd, status)){
-      *status = -1;
-    }
-    if(ncsp->nfp->destroyed){
-      ncfdplane_destroy_inner(ncsp->nfp);
-      free(ncsp);
-    }
-  }
-  return status;
-}
-
-// this is only used if we don't have a pidfd available for poll()ing. in that
-// case, we want to perform a blocking waitpid() on the pid, calling the
-// completion callback when it exits (since the process exit won't necessarily
-// wake up our poll()ing thread).
-static void *
-ncsubproc_waiter(void* vncsp){
-  ncsubproc* ncsp = vncsp;
-  int* status = malloc(sizeof(*status));
-  pid_t pid;
-  while((pid = waitpid(ncsp->pid, status, 0)) < 0 && errno == EINTR){
-    ;
-  }
-  if(pid != ncsp->pid){
-    free(status);
-    return NULL;
-  }
-  pthread_mutex_lock(&ncsp->lock);
-  ncsp->waited = true;
-  pthread_mutex_unlock(&ncsp->lock);
-  if(!ncsp->nfp->destroyed){
-    ncsp->nfp->donecb(ncsp->nfp, *status, ncsp->nfp->curry);
-  }
-  return status;
-}
-
+// the pipe's read end is serviced by the reactor, which also watches the
+// pidfd (if we have one), or otherwise periodically checks on the subprocess.
 static ncfdplane*
 ncsubproc_launch(ncplane* n, ncsubproc* ret, const ncsubproc_options* opts, int fd,
                  ncfdplane_callback cbfxn, ncfdplane_done_cb donecbfxn){
   ncfdplane_options popts = {
     .curry = opts->curry,
     .follow = true,
+    .bufsize = opts->bufsize,
+    .coalesce_ms = opts->coalesce_ms,
   };
-  ret->nfp = ncfdplane_create_internal(n, &popts, fd, cbfxn, donecbfxn, false);
-  if(ret->nfp == NULL){
-    return NULL;
-  }
-  if(pthread_create(&ret->nfp->tid, NULL, ncsubproc_thread, ret)){
-    ncfdplane_destroy_inner(ret->nfp);
-    ret->nfp = NULL;
-  }
-  if(ret->pidfd < 0){
-    // if we don't have a pidfd to throw into our poll(), we need spin up a
-    // thread to call waitpid() on our pid
-    if(pthread_create(&ret->waittid, NULL, ncsubproc_waiter, ret)){
-      // FIXME cancel and join thread
-      ncfdplane_destroy_inner(ret->nfp);
-      ret->nfp = NULL;
-    }
-  }
-  return ret->nfp;
+  return ncfdplane_create_internal(n, &popts, fd, cbfxn, donecbfxn, ret, ret->pidfd);
 }
 #endif
 
@@ -356,13 +974,23 @@ ncexecvpe(ncplane* n, const ncsubproc_options* opts, unsigned usepath,
     return NULL;
   }
   memset(ret, 0, sizeof(*ret));
+  if(pthread_mutex_init(&ret->lock, NULL)){
+    free(ret);
+    return NULL;
+  }
   ret->pid = launch_pipe_process(&fd, &ret->pidfd, usepath, bin, arg, env);
   if(ret->pid < 0){
+    pthread_mutex_destroy(&ret->lock);
     free(ret);
     return NULL;
   }
   if((ret->nfp = ncsubproc_launch(n, ret, opts, fd, cbfxn, donecbfxn)) == NULL){
     kill_and_wait_subproc(ret->pid, ret->pidfd, NULL);
+    if(ret->pidfd >= 0){
+      close(ret->pidfd);
+    }
+    close(fd);
+    pthread_mutex_destroy(&ret->lock);
     free(ret);
     return NULL;
   }
@@ -399,49 +1027,44 @@ ncsubproc* ncsubproc_createvpe(ncplane* n, const ncsubproc_options* opts,
   return ncexecvpe(n, opts, 1, bin, (char* const *)arg, (char* const*)env, cbfxn, donecbfxn);
 }
 
+// the reader is torn down first, so that the reactor is done with us. if the
+// subprocess is still running, it's sent SIGKILL, and reaped here. returns
+// the subprocess's wait status.
 int ncsubproc_destroy(ncsubproc* n){
   int ret = 0;
   if(n){
-    void* vret = NULL;
-//fprintf(stderr, "pid: %u pidfd: %d waittid: %u\n", n->pid, n->pidfd, n->waittid);
+    ncfdplane_destroy(n->nfp);
 #ifndef __MINGW32__
+    pthread_mutex_lock(&n->lock);
+    if(!n->waited){
+      int r = -1;
 #ifdef USING_PIDFD
-    if(n->pidfd >= 0){
-      loginfo("sending SIGKILL to pidfd %d", n->pidfd);
-      if(syscall(__NR_pidfd_send_signal, n->pidfd, SIGKILL, NULL, 0)){
+      if(n->pidfd >= 0){
+        loginfo("sending SIGKILL to pidfd %d", n->pidfd);
+        r = syscall(__NR_pidfd_send_signal, n->pidfd, SIGKILL, NULL, 0);
+      }
+#endif
+      if(r){
+        loginfo("sending SIGKILL to PID %d", n->pid);
         kill(n->pid, SIGKILL);
       }
+      pid_t pid;
+      while((pid = waitpid(n->pid, &n->status, 0)) < 0 && errno == EINTR){
+        ;
+      }
+      if(pid != n->pid){
+        n->status = -1;
+      }
+      n->waited = true;
     }
-#else
-    pthread_mutex_lock(&n->lock);
-    if(!n->waited){
-      loginfo("sending SIGKILL to PID %d", n->pid);
-      kill(n->pid, SIGKILL);
-    }
+    ret = n->status;
     pthread_mutex_unlock(&n->lock);
 #endif
-#endif
-    // the thread waits on the subprocess via pidfd (iff pidfd >= 0), and
-    // then exits. don't try to cancel the thread in that case; rely instead on
-    // killing the subprocess.
-    if(n->pidfd < 0){
-      pthread_cancel(n->nfp->tid);
-      // shouldn't need a cancellation of waittid thanks to SIGKILL
-      pthread_join(n->waittid, &vret);
-    }
-    if(vret == NULL){
-      pthread_join(n->nfp->tid, &vret);
-    }else{
-      pthread_join(n->nfp->tid, NULL);
+    if(n->pidfd >= 0){
+      close(n->pidfd);
     }
     pthread_mutex_destroy(&n->lock);
     free(n);
-    if(vret == NULL){
-      ret = -1;
-    }else if(vret != PTHREAD_CANCELED){
-      ret = *(int*)vret;
-      free(vret);
-    }
   }
   return ret;
 }
@@ -1,78 +1,297 @@
 #include "internal.h"
 
-void ncplane_greyscale(ncplane *n){
-  for(unsigned y = 0 ; y < n->leny ; ++y){
-    for(unsigned x = 0 ; x < n->lenx ; ++x){
-      nccell* c = &n->fb[nfbcellidx(n, y, x)];
-      unsigned r, g, b;
-      nccell_fg_rgb8(c, &r, &g, &b);
-      int gy = rgb_greyscale(r, g, b);
-      nccell_set_fg_rgb8(c, gy, gy, gy);
-      nccell_bg_rgb8(c, &r, &g, &b);
-      gy = rgb_greyscale(r, g, b);
-      nccell_set_bg_rgb8(c, gy, gy, gy);
+// color matrices are applied in fixed point, with XFORM_FRAC fractional bits.
+// with coefficients of magnitude at most 64 and offsets of at most 1024, the
+// accumulation of three components of at most 255 fits comfortably in 32 bits.
+#define XFORM_FRAC 12
+#define XFORM_MAXCOEFF 64
+#define XFORM_MAXOFFSET 1024
+// the largest accumulation which doesn't exceed 255 once shifted down
+#define XFORM_CLAMP ((256 << XFORM_FRAC) - 1)
+
+typedef struct xformmat {
+  int32_t m[3][4]; // the last column also carries the rounding term
+} xformmat;
+
+static int
+xformmat_init(xformmat* xm, const float matrix[3][4]){
+  for(int c = 0 ; c < 3 ; ++c){
+    for(int k = 0 ; k < 4 ; ++k){
+      const float lim = k == 3 ? XFORM_MAXOFFSET : XFORM_MAXCOEFF;
+      const float f = matrix[c][k];
+      if(!(f >= -lim && f <= lim)){ // also rejects NaN
+        logerror("invalid matrix entry %d/%d: %f", c, k, f);
+        return -1;
+      }
+      const float scaled = f * (1 << XFORM_FRAC);
+      xm->m[c][k] = (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
     }
+    xm->m[c][3] += 1 << (XFORM_FRAC - 1);
   }
+  return 0;
 }
 
-// if this is not polyfillable cell, we return 0. if it is, we attempt to fill
-// it, then recurse out. return -1 on error, or number of cells filled on
-// success. so a return of 0 means there's no work to be done here, and N means
-// we did some work here, filling everything we could reach. out-of-plane is 0.
-static int
-ncplane_polyfill_inner(ncplane* n, unsigned y, unsigned x, const nccell* c, const char* filltarg){
-  struct topolyfill* stack = NULL;
-  if(create_polyfill_op(y, x, &stack) == NULL){
+static inline uint32_t
+xform_matrix_channel(const xformmat* xm, uint32_t chan){
+  const int32_t r = (chan >> 16u) & 0xffu;
+  const int32_t g = (chan >> 8u) & 0xffu;
+  const int32_t b = chan & 0xffu;
+  uint32_t rgb = 0;
+  for(int c = 0 ; c < 3 ; ++c){
+    int32_t acc = xm->m[c][0] * r + xm->m[c][1] * g + xm->m[c][2] * b + xm->m[c][3];
+    if(acc < 0){
+      acc = 0;
+    }else if(acc > XFORM_CLAMP){
+      acc = XFORM_CLAMP;
+    }
+    rgb = (rgb << 8u) | (uint32_t)(acc >> XFORM_FRAC);
+  }
+  return rgb;
+}
+
+static inline uint64_t
+xform_matrix_channels(const xformmat* xm, uint64_t channels){
+  return ((uint64_t)xform_matrix_channel(xm, channels >> 32u) << 32u) |
+         xform_matrix_channel(xm, channels);
+}
+
+// run the RGB of |count| channel pairs from |in| through the matrix into
+// |out|. as in fade.c, every 32-bit channel is independent, so we work
+// through eight at a time with GNU C vector arithmetic where available. only
+// the RGB bits of the results are set; the caller merges them in.
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9)
+typedef int32_t xformlanes __attribute__ ((vector_size (8 * sizeof(int32_t))));
+
+#if defined(__x86_64__) && defined(__GLIBC__) && !defined(__clang__)
+#define XFORM_CLONES __attribute__ ((target_clones ("avx2", "default")))
+#else
+#define XFORM_CLONES
+#endif
+
+XFORM_CLONES static void
+xform_matrix_span(const xformmat* xm, const uint64_t* in, uint64_t* out,
+                  unsigned count){
+  unsigned x = 0;
+  for( ; x + sizeof(xformlanes) / sizeof(*in) <= count ; x += sizeof(xformlanes) / sizeof(*in)){
+    xformlanes v;
+    memcpy(&v, in + x, sizeof(v));
+    const xformlanes r = (v >> 16) & 0xff;
+    const xformlanes g = (v >> 8) & 0xff;
+    const xformlanes b = v & 0xff;
+    xformlanes rgb = {0};
+    for(int c = 0 ; c < 3 ; ++c){
+      xformlanes acc = r * xm->m[c][0] + g * xm->m[c][1] + b * xm->m[c][2] + xm->m[c][3];
+      acc &= ~(acc >> 31); // clamp negatives to 0
+      const xformlanes over = acc > XFORM_CLAMP;
+      acc = (acc & ~over) | (over & XFORM_CLAMP);
+      rgb = (rgb << 8) | (acc >> XFORM_FRAC);
+    }
+    memcpy(out + x, &rgb, sizeof(rgb));
+  }
+  for( ; x < count ; ++x){
+    out[x] = xform_matrix_channels(xm, in[x]);
+  }
+}
+#else
+static void
+xform_matrix_span(const xformmat* xm, const uint64_t* in, uint64_t* out,
+                  unsigned count){
+  for(unsigned x = 0 ; x < count ; ++x){
+    out[x] = xform_matrix_channels(xm, in[x]);
+  }
+}
+#endif
+
+// table lookups don't vectorize without gathers, so remain scalar
+static inline uint32_t
+xform_lut_channel(const ncxform* op, uint32_t chan){
+  return ((uint32_t)op->u.lut.r[(chan >> 16u) & 0xffu] << 16u) |
+         ((uint32_t)op->u.lut.g[(chan >> 8u) & 0xffu] << 8u) |
+         op->u.lut.b[chan & 0xffu];
+}
+
+// the bits of |channels| which an RGB transform of |sel| replaces: the RGB
+// of those selected channels which are neither default nor palette-indexed.
+static inline uint64_t
+xform_rgb_mask(uint64_t channels, uint64_t sel){
+  const uint64_t kind = NC_BGDEFAULT_MASK | NC_BG_PALETTE;
+  uint64_t mask = 0;
+  if((channels & (kind << 32u)) == (NC_BGDEFAULT_MASK << 32u)){
+    mask |= NC_BG_RGB_MASK << 32u;
+  }
+  if((channels & kind) == NC_BGDEFAULT_MASK){
+    mask |= NC_BG_RGB_MASK;
+  }
+  return mask & sel;
+}
+
+// cells of a row handled per call to xform_matrix_span()
+#define XFORM_SPAN 64
+
+int ncplane_transform_channels(ncplane* n, int y, int x, unsigned ylen,
+                               unsigned xlen, const ncxform* op){
+  const unsigned which = op->channels ? op->channels : NCXFORM_FG | NCXFORM_BG;
+  if(which & ~(NCXFORM_FG | NCXFORM_BG)){
+    logerror("invalid channel selection 0x%x", op->channels);
     return -1;
   }
-  int ret = 0;
-  struct topolyfill* s;
-  do{
-    s = stack;
-    stack = stack->next;
-    y = s->y;
-    x = s->x;
-    nccell* cur = &n->fb[nfbcellidx(n, y, x)];
-    const char* glust = nccell_extended_gcluster(n, cur);
-//fprintf(stderr, "checking %d/%d (%s) for [%s]\n", y, x, glust, filltarg);
-    if(strcmp(glust, filltarg) == 0){
-      ++ret;
-      if(nccell_duplicate(n, cur, c) < 0){
-        goto err;
+  // the whole of each selected 32-bit channel
+  const uint64_t sel = ((which & NCXFORM_FG) ? 0xffffffff00000000ull : 0) |
+                       ((which & NCXFORM_BG) ? 0x00000000ffffffffull : 0);
+  xformmat xm;
+  if(op->op == NCXFORM_MATRIX){
+    if(xformmat_init(&xm, op->u.matrix)){
+      return -1;
+    }
+  }else if(op->op == NCXFORM_ALPHA){
+    if(op->u.alpha & ~NC_BG_ALPHA_MASK){
+      logerror("invalid alpha 0x%08x", op->u.alpha);
+      return -1;
+    }
+    if(op->u.alpha == NCALPHA_HIGHCONTRAST && (which & NCXFORM_BG)){
+      logerror("highcontrast is not valid for backgrounds");
+      return -1;
+    }
+  }else if(op->op != NCXFORM_LUT){
+    logerror("invalid transform %d", op->op);
+    return -1;
+  }
+  unsigned ystart, xstart;
+  if(check_geometry_args(n, y, x, &ylen, &xlen, &ystart, &xstart)){
+    return -1;
+  }
+  if(ncplane_own(n)){
+    return -1;
+  }
+  ncplane_damage_rows(n, ystart, ylen);
+  const uint64_t alphamask = ((uint64_t)NC_BG_ALPHA_MASK << 32u | NC_BG_ALPHA_MASK) & sel;
+  const uint64_t alpha = ((uint64_t)op->u.alpha << 32u | op->u.alpha) & sel;
+  for(unsigned yy = ystart ; yy < ystart + ylen ; ++yy){
+    nccell* row = ncplane_cell_ref_yx(n, yy, xstart);
+    if(op->op == NCXFORM_ALPHA){
+      for(unsigned xx = 0 ; xx < xlen ; ++xx){
+        row[xx].channels = (row[xx].channels & ~alphamask) | alpha;
       }
-//fprintf(stderr, "blooming from %d/%d ret: %d\n", y, x, ret);
-      if(y){
-        if(create_polyfill_op(y - 1, x, &stack) == NULL){
-          goto err;
+    }else if(op->op == NCXFORM_LUT){
+      for(unsigned xx = 0 ; xx < xlen ; ++xx){
+        const uint64_t cur = row[xx].channels;
+        const uint64_t mask = xform_rgb_mask(cur, sel);
+        if(mask){
+          const uint64_t t = ((uint64_t)xform_lut_channel(op, cur >> 32u) << 32u) |
+                             xform_lut_channel(op, cur);
+          row[xx].channels = (cur & ~mask) | (t & mask);
         }
       }
-      if(y + 1 < n->leny){
-        if(create_polyfill_op(y + 1, x, &stack) == NULL){
-          goto err;
+    }else{
+      for(unsigned xx = 0 ; xx < xlen ; xx += XFORM_SPAN){
+        uint64_t chans[XFORM_SPAN];
+        const unsigned span = xlen - xx < XFORM_SPAN ? xlen - xx : XFORM_SPAN;
+        for(unsigned s = 0 ; s < span ; ++s){
+          chans[s] = row[xx + s].channels;
         }
-      }
-      if(x){
-        if(create_polyfill_op(y, x - 1, &stack) == NULL){
-          goto err;
+        xform_matrix_span(&xm, chans, chans, span);
+        for(unsigned s = 0 ; s < span ; ++s){
+          const uint64_t cur = row[xx + s].channels;
+          const uint64_t mask = xform_rgb_mask(cur, sel);
+          row[xx + s].channels = (cur & ~mask) | (chans[s] & mask);
         }
       }
-      if(x + 1 < n->lenx){
-        if(create_polyfill_op(y, x + 1, &stack) == NULL){
-          goto err;
+    }
+  }
+  return ylen * xlen;
+}
+
+void ncplane_greyscale(ncplane *n){
+  ncxform op;
+  ncxform_greyscale(&op);
+  ncplane_transform_channels(n, 0, 0, 0, 0, &op);
+}
+
+// does |cur| hold the EGC we're replacing, that of |targ| (|targegc|)? EGCs
+// of four bytes or fewer live directly in the gcluster, so for such a target,
+// comparing gclusters suffices. only a spilled target requires strcmp(), and
+// then only against other spilled EGCs. we can't compare pool offsets, since
+// the target's storage is released once its own cell has been filled.
+static inline bool
+polyfill_target_p(const ncplane* n, const nccell* cur, const nccell* targ,
+                  const char* targegc){
+  if(cell_simple_p(targ)){
+    return cur->gcluster == targ->gcluster;
+  }
+  return cell_extended_p(cur) && strcmp(nccell_extended_gcluster(n, cur), targegc) == 0;
+}
+
+// push a seed for each run of targets in row |y| between |xl| and |xr|
+// (inclusive), i.e. those adjacent to a span we just filled.
+static int
+polyfill_seed_row(const ncplane* n, polyfill_stack* ps, unsigned y,
+                  unsigned xl, unsigned xr, const nccell* targ,
+                  const char* targegc){
+  const nccell* row = &n->fb[nfbcellidx(n, y, 0)];
+  bool inrun = false;
+  for(unsigned x = xl ; x <= xr ; ++x){
+    if(polyfill_target_p(n, &row[x], targ, targegc)){
+      if(!inrun){
+        if(polyfill_push(ps, y, x)){
+          return -1;
         }
+        inrun = true;
+      }
+    }else{
+      inrun = false;
+    }
+  }
+  return 0;
+}
+
+// fill every target reachable from |y|/|x| with |c|. return -1 on error, or
+// the number of cells filled on success.
+static int
+ncplane_polyfill_inner(ncplane* n, unsigned y, unsigned x, const nccell* c,
+                       const nccell* targ, const char* targegc){
+  polyfill_stack ps;
+  polyfill_init(&ps);
+  if(polyfill_push(&ps, y, x)){
+    polyfill_free(&ps);
+    return -1;
+  }
+  int ret = 0;
+  while(ps.used){
+    const polyfill_seed s = ps.seeds[--ps.used];
+    nccell* row = &n->fb[nfbcellidx(n, s.y, 0)];
+    if(!polyfill_target_p(n, &row[s.x], targ, targegc)){
+      continue;
+    }
+    unsigned xl = s.x;
+    while(xl && polyfill_target_p(n, &row[xl - 1], targ, targegc)){
+      --xl;
+    }
+    unsigned xr = s.x;
+    while(xr + 1 < n->lenx && polyfill_target_p(n, &row[xr + 1], targ, targegc)){
+      ++xr;
+    }
+    for(unsigned xx = xl ; xx <= xr ; ++xx){
+      if(nccell_duplicate(n, &row[xx], c) < 0){
+        goto err;
+      }
+    }
+    ret += xr - xl + 1;
+    if(s.y){
+      if(polyfill_seed_row(n, &ps, s.y - 1, xl, xr, targ, targegc)){
+        goto err;
       }
     }
-    free(s);
-  }while(stack);
+    if(s.y + 1 < n->leny){
+      if(polyfill_seed_row(n, &ps, s.y + 1, xl, xr, targ, targegc)){
+        goto err;
+      }
+    }
+  }
+  polyfill_free(&ps);
   return ret;
 
 err:
-  free(s);
-  while(stack){
-    struct topolyfill* tmp = stack->next;
-    free(stack);
-    stack = tmp;
-  }
+  polyfill_free(&ps);
   return -1;
 }
 
@@ -98,6 +317,9 @@ int ncplane_polyfill_yx(ncplane* n, int ystart, int xstart, const nccell* c){
     logerror("invalid start: %u/%u (%u/%u)", y, x, n->leny, n->lenx);
     return -1;
   }
+  if(ncplane_own(n)){
+    return -1;
+  }
   const nccell* cur = &n->fb[nfbcellidx(n, y, x)];
   const char* targ = nccell_extended_gcluster(n, cur);
   const char* fillegc = nccell_extended_gcluster(n, c);
@@ -105,12 +327,14 @@ int ncplane_polyfill_yx(ncplane* n, int ystart, int xstart, const nccell* c){
   if(strcmp(fillegc, targ) == 0){
     return 0;
   }
+  ncplane_damage(n);
   int ret = -1;
-  // we need an external copy of this, since we'll be writing to it on
-  // the first call into ncplane_polyfill_inner()
+  // we need external copies of these, since we'll be writing to the cell
+  // upon the first fill within ncplane_polyfill_inner()
+  const nccell targcell = *cur;
   char* targcopy = strdup(targ);
   if(targcopy){
-    ret = ncplane_polyfill_inner(n, y, x, c, targcopy);
+    ret = ncplane_polyfill_inner(n, y, x, c, &targcell, targcopy);
     free(targcopy);
   }
   return ret;
@@ -159,20 +383,121 @@ bool check_gradient_args(uint64_t ul, uint64_t ur, uint64_t bl, uint64_t br){
   return false;
 }
 
-// calculate both channels of a gradient at a particular point, knowing that
-// we're using double halfblocks, into `c`->channels.
+// calc_gradient_component() is a ratio of sums linear in x, so rather than
+// evaluating it anew (with a division per component) at every cell, we walk
+// each row, holding every component as q + r / div and stepping it with only
+// additions. the results are identical. there are eight lanes: r, g, and b
+// of the foreground, then of the background, and two idle ones, so that the
+// fixed-width loops below are vectorized by the compiler.
+#define GRADLANES 8
+
+typedef struct gradwalk {
+  int32_t q[GRADLANES];      // integral part of each component
+  int32_t r[GRADLANES];      // remainder, in [0..div)
+  int32_t qstep[GRADLANES];  // per-column change, as floor(step / div)...
+  int32_t rstep[GRADLANES];  // ...and the remainder thereof, in [0..div)
+  int32_t div[GRADLANES];
+  uint64_t keep;             // bits of the channels we preserve
+  uint64_t set;              // non-RGB bits we set
+  uint64_t rgbmask;          // RGB bits we set
+} gradwalk;
+
+// prepare to walk the row of an |ylen|x|xlen| gradient having the foreground
+// at |fy| and the background at |by| (these differ only for 2x1 gradients).
+// |ul| through |lr| are the corners' foreground and background channels.
+static void
+gradwalk_init(gradwalk* gw, const uint32_t ul[2], const uint32_t ur[2],
+              const uint32_t ll[2], const uint32_t lr[2], unsigned fy,
+              unsigned by, unsigned ylen, unsigned xlen){
+  for(unsigned l = 0 ; l < GRADLANES ; ++l){
+    if(l >= 6){
+      gw->q[l] = gw->r[l] = gw->qstep[l] = gw->rstep[l] = 0;
+      gw->div[l] = 1;
+      continue;
+    }
+    const unsigned c = l / 3;
+    const unsigned shift = 16 - 8 * (l % 3);
+    const int32_t tl = (ul[c] >> shift) & 0xffu;
+    const int32_t tr = (ur[c] >> shift) & 0xffu;
+    const int32_t bl = (ll[c] >> shift) & 0xffu;
+    const int32_t br = (lr[c] >> shift) & 0xffu;
+    const int32_t y = c ? by : fy;
+    // reduce the row to its two ends, lerped vertically but not yet divided
+    int32_t left = tl, right = tr, vdiv = 1;
+    if(ylen > 1){
+      const int32_t avm = (ylen - 1) - y;
+      left = tl * avm + bl * y;
+      right = tr * avm + br * y;
+      vdiv = ylen - 1;
+    }
+    int32_t num = left, step = 0, div = vdiv;
+    if(xlen > 1){
+      div = vdiv * (int32_t)(xlen - 1);
+      num = left * (int32_t)(xlen - 1);
+      step = right - left;
+      if(ylen > 1){ // only the bilinear case rounds
+        num += div / 2;
+      }
+    }
+    gw->q[l] = num / div;
+    gw->r[l] = num % div;
+    gw->qstep[l] = step / div;
+    gw->rstep[l] = step % div;
+    if(gw->rstep[l] < 0){
+      gw->rstep[l] += div;
+      --gw->qstep[l];
+    }
+    gw->div[l] = div;
+  }
+  // fold ncchannels_set_[fb]channel() (or ncchannels_set_[fb]g_default())
+  // into a mask and a set of bits, so that every cell is a single store
+  gw->keep = gw->set = gw->rgbmask = 0;
+  for(unsigned c = 0 ; c < 2 ; ++c){
+    uint64_t keep, set, rgbmask = 0;
+    if(ncchannel_default_p(ul[c])){
+      keep = ~(uint64_t)(NC_BGDEFAULT_MASK | NC_BG_ALPHA_MASK);
+      set = 0;
+    }else{
+      keep = NC_NOBACKGROUND_MASK;
+      set = NC_BGDEFAULT_MASK | (ul[c] & NC_BG_ALPHA_MASK);
+      rgbmask = NC_BG_RGB_MASK;
+    }
+    const unsigned shift = c ? 0 : 32;
+    gw->keep |= (keep & 0xffffffffull) << shift;
+    gw->set |= set << shift;
+    gw->rgbmask |= rgbmask << shift;
+  }
+}
+
+// advance the walk by one column
 static inline void
-calc_highgradient(nccell* c, uint32_t ul, uint32_t ur, uint32_t ll,
-                  uint32_t lr, unsigned y, unsigned x,
-                  unsigned ylen, unsigned xlen){
-  if(!ncchannel_default_p(ul)){
-    cell_set_fchannel(c, calc_gradient_channel(ul, ur, ll, lr,
-                                               y * 2, x, ylen, xlen));
-    cell_set_bchannel(c, calc_gradient_channel(ul, ur, ll, lr,
-                                               y * 2 + 1, x, ylen, xlen));
-  }else{
-    nccell_set_fg_default(c);
-    nccell_set_bg_default(c);
+gradwalk_step(gradwalk* gw){
+  for(unsigned l = 0 ; l < GRADLANES ; ++l){
+    gw->q[l] += gw->qstep[l];
+    gw->r[l] += gw->rstep[l];
+    const int32_t carry = -(gw->r[l] >= gw->div[l]);
+    gw->r[l] -= gw->div[l] & carry;
+    gw->q[l] -= carry;
+  }
+}
+
+// write the walk's current colors into |channels|, ala calc_gradient_channels()
+static inline void
+gradwalk_channels(const gradwalk* gw, uint64_t* channels){
+  const uint64_t rgb = ((uint64_t)((gw->q[0] << 16u) | (gw->q[1] << 8u) | gw->q[2]) << 32u)
+                       | (uint32_t)((gw->q[3] << 16u) | (gw->q[4] << 8u) | gw->q[5]);
+  *channels = (*channels & gw->keep) | gw->set | (rgb & gw->rgbmask);
+}
+
+// split the corners of a gradient into their foreground and background
+// channels, for gradwalk_init().
+static inline void
+gradient_corners(uint32_t corners[4][2], uint64_t ul, uint64_t ur,
+                 uint64_t ll, uint64_t lr){
+  const uint64_t chans[4] = { ul, ur, ll, lr, };
+  for(unsigned i = 0 ; i < 4 ; ++i){
+    corners[i][0] = ncchannels_fchannel(chans[i]);
+    corners[i][1] = ncchannels_bchannel(chans[i]);
   }
 }
 
@@ -195,15 +520,28 @@ int ncplane_gradient2x1(ncplane* n, int y, int x, unsigned ylen, unsigned xlen,
       return -1;
     }
   }
+  if(ncplane_own(n)){
+    return -1;
+  }
+  ncplane_damage_rows(n, ystart, ylen);
+  // both halves of each cell are drawn from the same four corners
+  const uint32_t ulc[2] = { ul, ul, };
+  const uint32_t urc[2] = { ur, ur, };
+  const uint32_t llc[2] = { ll, ll, };
+  const uint32_t lrc[2] = { lr, lr, };
   int total = 0;
-  for(unsigned yy = ystart ; yy < ystart + ylen ; ++yy){
-    for(unsigned xx = xstart ; xx < xstart + xlen ; ++xx){
-      nccell* targc = ncplane_cell_ref_yx(n, yy, xx);
+  for(unsigned yy = 0 ; yy < ylen ; ++yy){
+    nccell* row = ncplane_cell_ref_yx(n, ystart + yy, xstart);
+    gradwalk gw;
+    gradwalk_init(&gw, ulc, urc, llc, lrc, yy * 2, yy * 2 + 1, ylen * 2, xlen);
+    for(unsigned xx = 0 ; xx < xlen ; ++xx){
+      nccell* targc = &row[xx];
       targc->channels = 0;
       if(pool_blit_direct(&n->pool, targc, "▀", strlen("▀"), 1) <= 0){
         return -1;
       }
-      calc_highgradient(targc, ul, ur, ll, lr, yy - ystart, xx - xstart, ylen * 2, xlen);
+      gradwalk_channels(&gw, &targc->channels);
+      gradwalk_step(&gw);
       ++total;
     }
   }
@@ -252,17 +590,30 @@ int ncplane_gradient(ncplane* n, int y, int x, unsigned ylen, unsigned xlen,
       return -1;
     }
   }
+  if(ncplane_own(n)){
+    return -1;
+  }
+  ncplane_damage_rows(n, ystart, ylen);
+  // measure the EGC once, rather than at every cell
+  int cols;
+  const int bytes = utf8_egc_len(egc, &cols);
+  uint32_t corners[4][2];
+  gradient_corners(corners, ul, ur, bl, br);
   int total = 0;
-  for(unsigned yy = ystart ; yy < ystart + ylen ; ++yy){
-    for(unsigned xx = xstart ; xx < xstart + xlen ; ++xx){
-      nccell* targc = ncplane_cell_ref_yx(n, yy, xx);
+  for(unsigned yy = 0 ; yy < ylen ; ++yy){
+    nccell* row = ncplane_cell_ref_yx(n, ystart + yy, xstart);
+    gradwalk gw;
+    gradwalk_init(&gw, corners[0], corners[1], corners[2], corners[3],
+                  yy, yy, ylen, xlen);
+    for(unsigned xx = 0 ; xx < xlen ; ++xx){
+      nccell* targc = &row[xx];
       targc->channels = 0;
-      if(nccell_load(n, targc, egc) < 0){
+      if(cell_load_direct(n, targc, egc, bytes, cols) < 0){
         return -1;
       }
       targc->stylemask = stylemask;
-      calc_gradient_channels(&targc->channels, ul, ur, bl, br,
-                             yy - ystart, xx - xstart, ylen, xlen);
+      gradwalk_channels(&gw, &targc->channels);
+      gradwalk_step(&gw);
       ++total;
     }
   }
@@ -279,14 +630,23 @@ int ncplane_stain(ncplane* n, int y, int x, unsigned ylen, unsigned xlen,
   if(check_geometry_args(n, y, x, &ylen, &xlen, &ystart, &xstart)){
     return -1;
   }
+  if(ncplane_own(n)){
+    return -1;
+  }
+  ncplane_damage_rows(n, ystart, ylen);
+  uint32_t corners[4][2];
+  gradient_corners(corners, tl, tr, bl, br);
   int total = 0;
-  for(unsigned yy = ystart ; yy < ystart + ylen ; ++yy){
-    for(unsigned xx = xstart ; xx < xstart + xlen ; ++xx){
-      nccell* targc = ncplane_cell_ref_yx(n, yy, xx);
-      if(targc->gcluster){
-        calc_gradient_channels(&targc->channels, tl, tr, bl, br,
-                               yy - ystart, xx - xstart, ylen, xlen);
+  for(unsigned yy = 0 ; yy < ylen ; ++yy){
+    nccell* row = ncplane_cell_ref_yx(n, ystart + yy, xstart);
+    gradwalk gw;
+    gradwalk_init(&gw, corners[0], corners[1], corners[2], corners[3],
+                  yy, yy, ylen, xlen);
+    for(unsigned xx = 0 ; xx < xlen ; ++xx){
+      if(row[xx].gcluster){
+        gradwalk_channels(&gw, &row[xx].channels);
       }
+      gradwalk_step(&gw);
       ++total;
     }
   }
@@ -299,6 +659,10 @@ int ncplane_format(ncplane* n, int y, int x, unsigned ylen,
   if(check_geometry_args(n, y, x, &ylen, &xlen, &ystart, &xstart)){
     return -1;
   }
+  if(ncplane_own(n)){
+    return -1;
+  }
+  ncplane_damage_rows(n, ystart, ylen);
   int total = 0;
   for(unsigned yy = ystart ; yy < ystart + ylen ; ++yy){
     for(unsigned xx = xstart ; xx < xstart + xlen ; ++xx){
@@ -310,6 +674,48 @@ int ncplane_format(ncplane* n, int y, int x, unsigned ylen,
   return total;
 }
 
+int ncplane_paint(ncplane* n, int y, int x, unsigned ylen, unsigned xlen,
+                  const uint64_t* channels, const uint16_t* styles,
+                  size_t stride){
+  if(ylen == 0 || xlen == 0){
+    logerror("invalid region geometry %ux%u", ylen, xlen);
+    return -1;
+  }
+  if(stride == 0){
+    stride = xlen;
+  }else if(stride < xlen){
+    logerror("stride %zu < %u cells", stride, xlen);
+    return -1;
+  }
+  unsigned ystart, xstart;
+  if(check_geometry_args(n, y, x, &ylen, &xlen, &ystart, &xstart)){
+    return -1;
+  }
+  if(channels == NULL && styles == NULL){
+    return ylen * xlen;
+  }
+  if(ncplane_own(n)){
+    return -1;
+  }
+  ncplane_damage_rows(n, ystart, ylen);
+  for(unsigned yy = 0 ; yy < ylen ; ++yy){
+    nccell* row = ncplane_cell_ref_yx(n, ystart + yy, xstart);
+    if(channels){
+      const uint64_t* src = channels + yy * stride;
+      for(unsigned xx = 0 ; xx < xlen ; ++xx){
+        row[xx].channels = src[xx] & ~NC_NOBACKGROUND_MASK;
+      }
+    }
+    if(styles){
+      const uint16_t* src = styles + yy * stride;
+      for(unsigned xx = 0 ; xx < xlen ; ++xx){
+        row[xx].stylemask = src[xx];
+      }
+    }
+  }
+  return ylen * xlen;
+}
+
 // if we're a half block, reverse the channels. if we're a space, set both to
 // the background. if we're a full block, set both to the foreground.
 static int
@@ -443,7 +849,8 @@ rotate_merge(ncplane* n, ncplane* newp){
   unsigned dimy, dimx;
   ncplane_dim_yx(newp, &dimy, &dimx);
   int ret = ncplane_resize(n, 0, 0, 0, 0, 0, 0, dimy, dimx);
-  if(ret == 0){
+  // a square plane isn't resized, and mightn't yet own its framebuffer
+  if(ret == 0 && (ret = ncplane_own(n)) == 0){
     for(unsigned y = 0 ; y < dimy ; ++y){
       for(unsigned x = 0 ; x < dimx ; ++x){
         const nccell* src = &newp->fb[fbcellidx(y, dimx, x)];
@@ -555,6 +962,61 @@ qrcode_cols(unsigned version){
   return QR_BASE_SIZE + (version * PER_QR_VERSION);
 }
 
+struct ncvisual* ncvisual_from_qrcode(const void* data, size_t len, unsigned maxversion,
+                               uint32_t rgb, unsigned* version){
+  const unsigned MAX_QR_VERSION = 40; // QR library only supports up to 40
+  if(len == 0){
+    logerror("won't encode an empty QR code");
+    return NULL;
+  }
+  if(maxversion < 1 || maxversion > MAX_QR_VERSION){
+    logerror("invalid QR code version %u", maxversion);
+    return NULL;
+  }
+  if(rgb & ~0xffffffu){
+    logerror("invalid rgb 0x%08x", rgb);
+    return NULL;
+  }
+  const size_t bsize = qrcodegen_BUFFER_LEN_FOR_VERSION(maxversion);
+  if(bsize < len){
+    return NULL;
+  }
+  uint8_t* src = malloc(bsize);
+  uint8_t* dst = malloc(bsize);
+  if(src == NULL || dst == NULL){
+    free(src);
+    free(dst);
+    return NULL;
+  }
+  memcpy(src, data, len);
+  struct ncvisual* ncv = NULL;
+  if(qrcodegen_encodeBinary(src, len, dst, qrcodegen_Ecc_HIGH, 1, maxversion,
+                            qrcodegen_Mask_AUTO, true)){
+    const int square = qrcodegen_getSize(dst);
+    uint32_t* rgba = malloc(square * square * sizeof(uint32_t));
+    if(rgba){
+      for(int y = 0 ; y < square ; ++y){
+        for(int x = 0 ; x < square ; ++x){
+          const bool pixel = qrcodegen_getModule(dst, x, y);
+          ncpixel_set_a(&rgba[y * square + x], 0xff);
+          ncpixel_set_rgb8(&rgba[y * square + x],
+                           pixel * ((rgb >> 16u) & 0xffu),
+                           pixel * ((rgb >> 8u) & 0xffu),
+                           pixel * (rgb & 0xffu));
+        }
+      }
+      ncv = ncvisual_from_rgba(rgba, square, square * sizeof(uint32_t), square);
+      free(rgba);
+      if(ncv && version){
+        *version = (square - QR_BASE_SIZE) / PER_QR_VERSION;
+      }
+    }
+  }
+  free(src);
+  free(dst);
+  return ncv;
+}
+
 int ncplane_qrcode(ncplane* n, unsigned* ymax, unsigned* xmax, const void* data, size_t len){
   const ncblitter_e blitfxn = NCBLIT_2x1;
   const int MAX_QR_VERSION = 40; // QR library only supports up to 40
@@ -583,68 +1045,50 @@ int ncplane_qrcode(ncplane* n, unsigned* ymax, unsigned* xmax, const void* data,
   if(roomforver > MAX_QR_VERSION){
     roomforver = MAX_QR_VERSION;
   }
-  const size_t bsize = qrcodegen_BUFFER_LEN_FOR_VERSION(roomforver);
-  if(bsize < len){
-    return -1;
-  }
-  uint8_t* src = malloc(bsize);
-  uint8_t* dst = malloc(bsize);
-  if(src == NULL || dst == NULL){
-    free(src);
-    free(dst);
+  if(roomforver < 1){
     return -1;
   }
-  unsigned r, g, b;
+  unsigned rgb;
   // FIXME default might not be all-white
   if(ncplane_fg_default_p(n)){
-    r = g = b = 0xff;
+    rgb = 0xffffff;
   }else{
-    ncplane_fg_rgb8(n, &r, &g, &b);
+    rgb = ncplane_fg_rgb(n);
   }
-  memcpy(src, data, len);
-  int ret = -1;
-  int yscale, xscale;
-  if(qrcodegen_encodeBinary(src, len, dst, qrcodegen_Ecc_HIGH, 1, roomforver, qrcodegen_Mask_AUTO, true)){
-    const int square = qrcodegen_getSize(dst);
-    uint32_t* rgba = malloc(square * square * sizeof(uint32_t));
-    if(rgba){
-      for(int y = starty ; y < starty + square ; ++y){
-        for(int x = startx ; x < startx + square ; ++x){
-          const bool pixel = qrcodegen_getModule(dst, x, y);
-          ncpixel_set_a(&rgba[y * square + x], 0xff);
-          ncpixel_set_rgb8(&rgba[y * square + x], r * pixel, g * pixel, b * pixel);
-        }
-      }
-      struct ncvisual* ncv = ncvisual_from_rgba(rgba, square, square * sizeof(uint32_t), square);
-      free(rgba);
-      if(ncv){
-        ret = square;
-        struct ncvisual_options vopts = {
-          .n = n,
-          .blitter = blitfxn,
-        };
-        if(ncvisual_blit(ncplane_notcurses(n), ncv, &vopts) == n){
-          ret = square;
-        }
-        ncvgeom geom;
-        ncvisual_geom(ncplane_notcurses(n), NULL, &vopts, &geom);
-        yscale = geom.scaley;
-        xscale = geom.scalex;
-      }
-      ncvisual_destroy(ncv);
-    }
+  unsigned ver;
+  struct ncvisual* ncv = ncvisual_from_qrcode(data, len, roomforver, rgb, &ver);
+  if(ncv == NULL){
+    return -1;
   }
-  free(src);
-  free(dst);
-  if(ret > 0){
-    ret = (ret - QR_BASE_SIZE) / PER_QR_VERSION;
-    *ymax = qrcode_rows(ret) / yscale;
-    *xmax = qrcode_cols(ret) / xscale;
-    return ret;
+  int ret = -1;
+  struct ncvisual_options vopts = {
+    .n = n,
+    .y = starty,
+    .x = startx,
+    .blitter = blitfxn,
+  };
+  if(ncvisual_blit(ncplane_notcurses(n), ncv, &vopts) == n){
+    ncvgeom geom;
+    ncvisual_geom(ncplane_notcurses(n), ncv, &vopts, &geom);
+    *ymax = qrcode_rows(ver) / geom.scaley;
+    *xmax = qrcode_cols(ver) / geom.scalex;
+    ret = ver;
   }
-  return -1;
+  ncvisual_destroy(ncv);
+  return ret;
 }
 #else
+struct ncvisual* ncvisual_from_qrcode(const void* data, size_t len, unsigned maxversion,
+                               uint32_t rgb, unsigned* version){
+  (void)data;
+  (void)len;
+  (void)maxversion;
+  (void)rgb;
+  (void)version;
+  logerror("notcurses was built without QR code support");
+  return NULL;
+}
+
 int ncplane_qrcode(ncplane* n, unsigned* ymax, unsigned* xmax, const void* data, size_t len){
   (void)n;
   (void)ymax;
@@ -6,38 +6,8 @@
 
 static Gpm_Connect gpmconn;    // gpm server handle
 
-static void*
-gpmwatcher(void* vti){
-  static char cmdbuf[20]; // max is '\x1b[<int;int;intM'
-  cmdbuf[0] = '\x1b';
-  cmdbuf[1] = '[';
-  cmdbuf[2] = '<';
-  tinfo* ti = vti;
-  Gpm_Event gev;
-  const int space = sizeof(cmdbuf) - 3;
-  while(true){
-    if(!Gpm_GetEvent(&gev)){
-      logerror("error reading from gpm daemon");
-      continue;
-    }
-    loginfo("got gpm event y=%hd x=%hd mod=%u butt=%u", gev.y, gev.x,
-            (unsigned)gev.modifiers, (unsigned)gev.buttons);
-    if(gev.y < 0 || gev.x < 0){
-      logwarn("negative input %hd %hd", gev.x, gev.y);
-      continue;
-    }
-    // gpm is 0-indexed, but we assume mice reports to be 1-indexed, as they
-    // are in the XTerm protocols. no need to account for margins here.
-    if(snprintf(cmdbuf + 3, space, "%hd;%hd;%hdM", 0, gev.x + 1, gev.y + 1) >= space){
-      logwarn("input overflowed %hd %hd", gev.x, gev.y);
-      continue;
-    }
-    ncinput_shovel(ti->ictx, cmdbuf, strlen(cmdbuf));
-  }
-  return NULL;
-}
-
 int gpm_connect(tinfo* ti){
+  (void)ti;
   gpm_zerobased = 1;
   // get all of _MOVE, _DRAG, _DOWN, and _UP
   gpmconn.eventMask = GPM_DRAG | GPM_DOWN | GPM_UP;
@@ -48,25 +18,77 @@ int gpm_connect(tinfo* ti){
     logerror("couldn't connect to gpm");
     return -1;
   }
-  if(pthread_create(&ti->gpmthread, NULL, gpmwatcher, ti)){
-    logerror("couldn't spawn gpm thread");
-    Gpm_Close();
-    memset(&gpmconn, 0, sizeof(gpmconn));
-    return -1;
-  }
   loginfo("connected to gpm on %d", gpm_fd);
   return gpm_fd;
 }
 
-int gpm_read(tinfo* ti, ncinput* ni){
+// gpm buttons are a bitmask; we report the lowest-numbered button present.
+static uint32_t
+gpm_button(const Gpm_Event* gev){
+  if(gev->wdy > 0){
+    return NCKEY_SCROLL_UP;
+  }else if(gev->wdy < 0){
+    return NCKEY_SCROLL_DOWN;
+  }
+  if(gev->buttons & GPM_B_LEFT){
+    return NCKEY_BUTTON1;
+  }else if(gev->buttons & GPM_B_MIDDLE){
+    return NCKEY_BUTTON2;
+  }else if(gev->buttons & GPM_B_RIGHT){
+    return NCKEY_BUTTON3;
+  }else if(gev->buttons & GPM_B_UP){
+    return NCKEY_SCROLL_UP;
+  }else if(gev->buttons & GPM_B_DOWN){
+    return NCKEY_SCROLL_DOWN;
+  }
+  return 0;
+}
+
+int gpm_read(tinfo* ti, ncinput* ni, bool* motion){
   (void)ti;
-  (void)ni;
-  return -1;
+  Gpm_Event gev;
+  if(Gpm_GetEvent(&gev) != 1){
+    logerror("error reading from gpm daemon");
+    return -1;
+  }
+  loginfo("got gpm event y=%hd x=%hd mod=%u butt=%u type=%d", gev.y, gev.x,
+          (unsigned)gev.modifiers, (unsigned)gev.buttons, gev.type);
+  if(gev.y < 0 || gev.x < 0){
+    logwarn("negative input %hd %hd", gev.x, gev.y);
+    return 0;
+  }
+  memset(ni, 0, sizeof(*ni));
+  // modifiers are the kernel's shift state (KG_SHIFT, KG_CTRL, KG_ALT)
+  ni->shift = gev.modifiers & (1u << 0u);
+  ni->ctrl = gev.modifiers & (1u << 2u);
+  ni->alt = gev.modifiers & (1u << 3u);
+  ni->modifiers = (ni->shift ? NCKEY_MOD_SHIFT : 0)
+                  | (ni->ctrl ? NCKEY_MOD_CTRL : 0)
+                  | (ni->alt ? NCKEY_MOD_ALT : 0);
+  ni->y = gev.y;
+  ni->x = gev.x;
+  ni->ypx = -1;
+  ni->xpx = -1;
+  const uint32_t button = gpm_button(&gev);
+  if(gev.wdy){ // wheel events can arrive as motion
+    ni->id = button;
+    ni->evtype = NCTYPE_PRESS;
+    *motion = false;
+  }else if((gev.type & GPM_MOVE) || button == 0){
+    // as with SGR reports, pure motion is a release of no button
+    ni->id = NCKEY_MOTION;
+    ni->evtype = NCTYPE_RELEASE;
+    *motion = true;
+  }else{
+    ni->id = button;
+    ni->evtype = (gev.type & GPM_UP) ? NCTYPE_RELEASE : NCTYPE_PRESS;
+    *motion = gev.type & GPM_DRAG;
+  }
+  return 1;
 }
 
 int gpm_close(tinfo* ti){
-  void* thrres;
-  cancel_and_join("gpm", ti->gpmthread, &thrres);
+  (void)ti;
   Gpm_Close();
   memset(&gpmconn, 0, sizeof(gpmconn));
   return 0;
@@ -81,9 +103,10 @@ int gpm_connect(tinfo* ti){
   return -1;
 }
 
-int gpm_read(tinfo* ti, ncinput* ni){
+int gpm_read(tinfo* ti, ncinput* ni, bool* motion){
   (void)ti;
   (void)ni;
+  (void)motion;
   return -1;
 }
 
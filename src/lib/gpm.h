@@ -7,6 +7,8 @@ extern "C" {
 
 // internal header, not installed
 
+#include <stdbool.h>
+
 struct tinfo;
 struct ncinput;
 
@@ -15,11 +17,15 @@ struct ncinput;
 // start it. We must have been built with -DUSE_GPM.
 
 // Returns the poll()able file descriptor associated with gpm, or -1 on failure.
+// There is no thread of its own; the input layer polls the descriptor.
 int gpm_connect(struct tinfo* ti);
 
-// Read from the gpm connection, which ought have been poll()ed. Translates
-// the libgpm input to an ncinput.
-int gpm_read(struct tinfo* ti, struct ncinput* ni);
+// Read one event from the gpm connection, which ought have been poll()ed.
+// Translates the libgpm input to an ncinput with 0-indexed coordinates
+// (margins not yet accounted for), setting |*motion| for motion and drags.
+// Returns 1 if |ni| was filled in, 0 if the event was discarded, or -1 on
+// error.
+int gpm_read(struct tinfo* ti, struct ncinput* ni, bool* motion);
 
 int gpm_close(struct tinfo* ti);
 
@@ -1,11 +1,17 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <stdatomic.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
 #include "automaton.h"
 #include "internal.h"
 #include "unixsig.h"
 #include "render.h"
+#include "timer.h"
 #include "in.h"
+#include "windows.h"
 
 // Notcurses takes over stdin, and if it is not connected to a terminal, also
 // tries to make a connection to the controlling terminal. If such a connection
@@ -26,12 +32,20 @@
 
 static sig_atomic_t cont_seen;
 static sig_atomic_t resize_seen;
+// while debouncing, the input thread requests the post-resize refresh only
+// once the geometry has settled
+static volatile sig_atomic_t resize_debouncing;
+// libgpm's connection is process-wide, and so is the lock serializing its
+// reads (on the input thread) against connection and disconnection.
+static pthread_mutex_t gpmlock = PTHREAD_MUTEX_INITIALIZER;
 
 // called for SIGWINCH and SIGCONT, and causes block_on_input to return
 void sigwinch_handler(int signo){
   if(signo == SIGWINCH){
     resize_seen = signo;
-    sigcont_seen_for_render = 1;
+    if(!resize_debouncing){
+      sigcont_seen_for_render = 1;
+    }
   }else if(signo == SIGCONT){
     cont_seen = signo;
     sigcont_seen_for_render = 1;
@@ -79,12 +93,19 @@ typedef struct inputctx {
   ncinput* inputs;    // processed input is dumped here
   int coutstanding;   // outstanding cursor location requests
   int csize, isize;   // total number of slots in csrs/inputs
-  int cvalid, ivalid; // population count of csrs/inputs
+  int cvalid;         // population count of csrs
   int cwrite, iwrite; // slot where we'll write the next csr/input;
                       //  we cannot write if valid == size
   int cread, iread;   // slot from which clients read the next csr/input;
                       //  they cannot read if valid == 0
-  pthread_mutex_t ilock; // lock for ncinput ringbuffer, also initial state
+  // the inputs ringbuffer has a single producer (the input thread) and a
+  // single consumer (the client, who may only enter the input stack from
+  // one thread at a time), so it needs no lock. iwrite belongs to the
+  // former, iread to the latter, and ivalid publishes slots between them.
+  atomic_int ivalid;     // population count of inputs
+  atomic_int iwaiters;   // clients asleep (or about to sleep) on icond
+  atomic_bool ireadied;  // have we readied the readiness fd for this input?
+  pthread_mutex_t ilock; // lock for sleeping on icond, also initial state
   pthread_cond_t icond;  // condvar for ncinput ringbuffer
   pthread_mutex_t clock; // lock for csrs ringbuffer
   pthread_cond_t ccond;  // condvar for csrs ringbuffer
@@ -97,10 +118,38 @@ typedef struct inputctx {
 
   unsigned linesigs;  // are line discipline signals active?
   unsigned drain;     // drain away bulk input?
+  unsigned coalesce;  // coalesce mouse motion and resize events?
+  bool heldmotion;    // is 'held' a motion report awaiting publication?
+  ncinput held;       // latest of a run of coalesced motion reports
+  atomic_uint resizes; // resizes represented by the queued NCKEY_RESIZE
+  uint64_t debouncens; // atomic; quiet period required after a SIGWINCH
+  uint64_t resizedeadline; // when a debounced resize settles, or 0
+  atomic_bool resizepending; // is a debounced resize yet to settle?
+  ncwheel wheel;       // timers registered with notcurses_timer_add()
+  atomic_uint timerfires; // expirations represented by the queued NCKEY_TIMER
+  bool inpaste;       // are we between CSI 200~ and CSI 201~?
+  char* pastebuf;     // accumulated paste payload, handed off whole
+  size_t pastelen, pastesize;
+  bool pastefailed;   // couldn't grow pastebuf; drop this paste
+  // bulk input read ahead of ibuf while a reply is awaited (see read_ahead()).
+  // bytes [backloghead, backloglen) are valid; they precede anything yet to
+  // be read from stdinfd, and are fed to ibuf in place of it.
+  unsigned char* backlog;
+  size_t backloghead, backloglen, backlogsize;
+  size_t backlogscan; // backlog before this offset has been scanned for replies
+  bool backlogpaste;  // is backlog[backlogscan] within a bracketed paste?
   ncsharedstats *stats; // stats shared with notcurses context
+  uint64_t readns;    // when we last read input
+  uint64_t spinns;    // poll without sleeping for this long after input
+  uint64_t burstns;   // when the input being processed was read, or 0
+  nchistogram latencies; // read-to-queue latencies, flushed to stats per burst
 
   ipipe ipipes[2];
+#ifdef __linux__
+  int readyfd;         // eventfd, poll()able while user input is present
+#else
   ipipe readypipes[2]; // pipes[0]: poll()able fd indicating the presence of user input
+#endif
   // initially, initdata is non-NULL and initdata_complete is NULL. once we
   // get DA1, initdata_complete is non-NULL (it is the same value as
   // initdata). once we complete reading the input payload that the DA1 arrived
@@ -112,18 +161,72 @@ typedef struct inputctx {
   bool failed;         // error initializing input automaton, abort
 } inputctx;
 
+// events produced while walking the automaton are charged the time since
+// their input was read. the input-to-photon clock is instead started once
+// the client takes the event (see take_inputs()).
 static inline void
 inc_input_events(inputctx* ictx){
-  pthread_mutex_lock(&ictx->stats->lock);
-  ++ictx->stats->s.input_events;
-  pthread_mutex_unlock(&ictx->stats->lock);
+  __atomic_fetch_add(&ictx->stats->input_events, 1, __ATOMIC_RELAXED);
+  if(ictx->burstns){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const uint64_t t = timespec_to_ns(&now);
+    nchistogram_record(&ictx->latencies, t > ictx->burstns ? t - ictx->burstns : 0);
+  }
+}
+
+static inline uint64_t
+monotonic_ns(void){
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return timespec_to_ns(&now);
+}
+
+// note the arrival of a reply to one of our initial queries, for the startup
+// latency breakdown of notcurses-info. |what| must be a static string.
+static void
+stamp_reply(inputctx* ictx, const char* what){
+  struct initial_responses* idata = ictx->initdata;
+  if(idata == NULL){
+    return;
+  }
+  const uint64_t now = monotonic_ns();
+  for(unsigned i = 0 ; i < idata->replycount ; ++i){
+    if(strcmp(idata->replies[i].what, what) == 0){
+      idata->replies[i].lastns = now;
+      ++idata->replies[i].count;
+      return;
+    }
+  }
+  if(idata->replycount < REPLYTIMES_MAX){
+    replytime* r = &idata->replies[idata->replycount++];
+    r->what = what;
+    r->firstns = now;
+    r->lastns = now;
+    r->count = 1;
+  }
+}
+
+// NOTCURSES_INPUT_SPIN, if set, is how many microseconds the input thread
+// busy-polls after reading input before it blocks (at most one second).
+static uint64_t
+input_spin_wanted(void){
+  const char* sp = getenv("NOTCURSES_INPUT_SPIN");
+  if(sp){
+    char* endl;
+    unsigned long us = strtoul(sp, &endl, 10);
+    if(*sp && !*endl && us <= 1000000){
+      loginfo("spinning %luus after input", us);
+      return us * 1000ull;
+    }
+    logwarn("ignoring invalid NOTCURSES_INPUT_SPIN: %s", sp);
+  }
+  return 0;
 }
 
 static inline void
 inc_input_errors(inputctx* ictx){
-  pthread_mutex_lock(&ictx->stats->lock);
-  ++ictx->stats->s.input_errors;
-  pthread_mutex_unlock(&ictx->stats->lock);
+  __atomic_fetch_add(&ictx->stats->input_errors, 1, __ATOMIC_RELAXED);
 }
 
 // load representations used by XTMODKEYS
@@ -476,6 +579,70 @@ mark_pipe_ready(ipipe pipes[static 2]){
   }
 }
 
+// make the readiness fd poll()able, unless it already is. called by the
+// input thread after publishing input, and by the client if it finds input
+// remaining after a drain.
+static void
+mark_input_ready(inputctx* ictx){
+#ifdef __linux__
+  if(!atomic_exchange(&ictx->ireadied, true)){
+    const uint64_t one = 1;
+    if(write(ictx->readyfd, &one, sizeof(one)) != sizeof(one)){
+      logwarn("error writing to eventfd (%d) (%s)", ictx->readyfd, strerror(errno));
+    }
+  }
+#elif !defined(__MINGW32__)
+  if(!atomic_exchange(&ictx->ireadied, true)){
+    mark_pipe_ready(ictx->readypipes);
+  }
+#else
+  mark_pipe_ready(ictx->readypipes);
+#endif
+}
+
+// the client has emptied the ringbuffer; clear the readiness fd. the fd is
+// drained *before* we disarm, so that a racing mark_input_ready() either
+// sees us armed (and we then rearm below, having seen its input), or writes
+// after our drain.
+static void
+drain_input_ready(inputctx* ictx){
+#ifndef __MINGW32__
+  logtrace("draining event readiness fd");
+#ifdef __linux__
+  uint64_t count;
+  if(read(ictx->readyfd, &count, sizeof(count)) < 0 && errno != EAGAIN){
+    logwarn("error reading eventfd (%d) (%s)", ictx->readyfd, strerror(errno));
+  }
+#else
+  char c[BUFSIZ];
+  while(read(ictx->readypipes[0], c, sizeof(c)) > 0){
+    ;
+  }
+#endif
+  atomic_store(&ictx->ireadied, false);
+  if(atomic_load(&ictx->ivalid)){
+    mark_input_ready(ictx);
+  }
+#else
+  // we ought be draining this, but it breaks everything, as we can't easily
+  // do nonblocking input from a pipe in windows, augh...
+  // Ne pleure pas, Alfred! J'ai besoin de tout mon courage pour mourir a vingt ans!
+  (void)ictx;
+#endif
+}
+
+// wake any client asleep in await_input(). the seq_cst ordering of ivalid
+// and iwaiters guarantees that either we see the waiter, or it sees our
+// input, so the common case (no sleeping client) never touches the lock.
+static void
+wake_input_waiters(inputctx* ictx){
+  if(atomic_load(&ictx->iwaiters)){
+    pthread_mutex_lock(&ictx->ilock);
+    pthread_cond_broadcast(&ictx->icond);
+    pthread_mutex_unlock(&ictx->ilock);
+  }
+}
+
 // shove the assembled input |tni| into the input queue (if there's room, and
 // we're not draining, and we haven't hit EOF). send any synthesized signal as
 // the last thing we do. if Ctrl or Shift are among the modifiers, we replace
@@ -484,8 +651,8 @@ mark_pipe_ready(ipipe pipes[static 2]){
 //
 // note that this w orks entirely off 'modifiers', not the obsolete
 // shift/alt/ctrl booleans, which it neither sets nor tests!
-static void
-load_ncinput(inputctx* ictx, ncinput *tni){
+static bool
+publish_ncinput(inputctx* ictx, ncinput *tni){
   int synth = 0;
   if(tni->modifiers & (NCKEY_MOD_CTRL | NCKEY_MOD_SHIFT | NCKEY_MOD_CAPSLOCK)){
     // when ctrl/shift are used with an ASCII (0..127) lowercase letter, always
@@ -517,18 +684,17 @@ load_ncinput(inputctx* ictx, ncinput *tni){
   inc_input_events(ictx);
   if(ictx->drain || ictx->stdineof){
     send_synth_signal(synth);
-    return;
+    return false;
   }
-  pthread_mutex_lock(&ictx->ilock);
-  if(ictx->ivalid == ictx->isize){
-    pthread_mutex_unlock(&ictx->ilock);
+  if(atomic_load_explicit(&ictx->ivalid, memory_order_acquire) == ictx->isize){
     logwarn("dropping input 0x%08x", tni->id);
     inc_input_errors(ictx);
     send_synth_signal(synth);
-    return;
+    return false;
   }
   ncinput* ni = ictx->inputs + ictx->iwrite;
   memcpy(ni, tni, sizeof(*tni));
+  ni->recvns = ictx->burstns;
   // perform final normalizations
   if(ni->id == 0x7f || ni->id == 0x8){
     ni->id = NCKEY_BACKSPACE;
@@ -543,17 +709,186 @@ load_ncinput(inputctx* ictx, ncinput *tni){
   if(++ictx->iwrite == ictx->isize){
     ictx->iwrite = 0;
   }
-  ++ictx->ivalid;
-  // FIXME we don't always need to write here; write if ictx->ivalid was 0, and
-  // also write *from the client context* if we empty the input buffer there..?
-  mark_pipe_ready(ictx->readypipes);
-  pthread_mutex_unlock(&ictx->ilock);
-  pthread_cond_broadcast(&ictx->icond);
+  atomic_fetch_add(&ictx->ivalid, 1); // publishes the slot to the client
+  mark_input_ready(ictx);
+  wake_input_waiters(ictx);
   send_synth_signal(synth);
+  return true;
+}
+
+// publish any motion report we've been holding back for coalescing.
+static void
+flush_held_motion(inputctx* ictx){
+  if(ictx->heldmotion){
+    ictx->heldmotion = false;
+    publish_ncinput(ictx, &ictx->held);
+  }
+}
+
+// everything except coalescable events goes through here. any held motion
+// report goes out first, so that ordering is preserved.
+static void
+load_ncinput(inputctx* ictx, ncinput *tni){
+  flush_held_motion(ictx);
+  publish_ncinput(ictx, tni);
+}
+
+// mouse events pass through here. when coalescing, motion reports (pure
+// motion and drags) are held back until we finish processing the current
+// batch of input. each successive report sharing the held one's button,
+// modifiers, and type replaces it, and bumps its 'coalesced' count.
+static void
+load_mouse_event(inputctx* ictx, ncinput* tni, bool motion){
+  if(!ictx->coalesce || !motion){
+    load_ncinput(ictx, tni);
+    return;
+  }
+  if(ictx->heldmotion){
+    if(ictx->held.id == tni->id && ictx->held.modifiers == tni->modifiers &&
+       ictx->held.evtype == tni->evtype){
+      tni->coalesced = ictx->held.coalesced + 1;
+      inc_input_events(ictx);
+      memcpy(&ictx->held, tni, sizeof(*tni));
+      return;
+    }
+    flush_held_motion(ictx);
+  }
+  memcpy(&ictx->held, tni, sizeof(*tni));
+  ictx->heldmotion = true;
 }
 
+// when coalescing, a resize is only queued if no other resize is waiting
+// to be read; otherwise, it is counted against the one already queued.
 static void
-pixelmouse_click(inputctx* ictx, ncinput* ni, long y, long x){
+load_resize(inputctx* ictx){
+  ncinput tni = {
+    .id = NCKEY_RESIZE,
+  };
+  if(!ictx->coalesce){
+    load_ncinput(ictx, &tni);
+    return;
+  }
+  if(atomic_fetch_add(&ictx->resizes, 1)){
+    inc_input_events(ictx);
+    return;
+  }
+  flush_held_motion(ictx);
+  if(!publish_ncinput(ictx, &tni)){
+    atomic_store(&ictx->resizes, 0);
+  }
+}
+
+// timer expirations are always coalesced: while an NCKEY_TIMER remains
+// unread, further expirations are counted against it.
+static void
+load_timer(inputctx* ictx, unsigned fires){
+  if(atomic_fetch_add(&ictx->timerfires, fires)){
+    return;
+  }
+  ncinput tni = {
+    .id = NCKEY_TIMER,
+  };
+  flush_held_motion(ictx);
+  if(!publish_ncinput(ictx, &tni)){
+    atomic_store(&ictx->timerfires, 0);
+  }
+}
+
+static const char PASTE_END[] = "\x1b[201~";
+
+// append |len| bytes to the paste in progress, always leaving room for a NUL.
+static void
+paste_append(inputctx* ictx, const unsigned char* buf, size_t len){
+  if(ictx->pastefailed){
+    return;
+  }
+  if(ictx->pastelen + len + 1 > ictx->pastesize){
+    size_t newsize = ictx->pastesize ? ictx->pastesize : BUFSIZ;
+    while(newsize < ictx->pastelen + len + 1){
+      newsize *= 2;
+    }
+    char* tmp = realloc(ictx->pastebuf, newsize);
+    if(tmp == NULL){
+      logerror("couldn't grow %zuB paste to %zuB", ictx->pastelen, newsize);
+      ictx->pastefailed = true;
+      return;
+    }
+    ictx->pastebuf = tmp;
+    ictx->pastesize = newsize;
+  }
+  memcpy(ictx->pastebuf + ictx->pastelen, buf, len);
+  ictx->pastelen += len;
+}
+
+// hand the completed paste off as a single event. the client now owns the
+// buffer; we'll get a new one for the next paste.
+static void
+load_paste(inputctx* ictx){
+  if(ictx->pastefailed){
+    logwarn("dropping %zuB paste", ictx->pastelen);
+    inc_input_errors(ictx);
+    return;
+  }
+  paste_append(ictx, (const unsigned char*)"", 1);
+  if(ictx->pastefailed){
+    inc_input_errors(ictx);
+    return;
+  }
+  // the payload is delivered as-is, but we note if it isn't UTF-8
+  const size_t valid = utf8_valid_prefix((const unsigned char*)ictx->pastebuf,
+                                         ictx->pastelen - 1);
+  if(valid != ictx->pastelen - 1){
+    logwarn("invalid UTF-8 at byte %zu of %zuB paste", valid, ictx->pastelen - 1);
+    inc_input_errors(ictx);
+  }
+  ncinput tni = {
+    .id = NCKEY_PASTE,
+    .paste = ictx->pastebuf,
+    .pastelen = ictx->pastelen - 1,
+  };
+  ictx->pastebuf = NULL;
+  ictx->pastelen = ictx->pastesize = 0;
+  flush_held_motion(ictx);
+  if(!publish_ncinput(ictx, &tni)){
+    free(tni.paste);
+  }
+}
+
+// we're within a bracketed paste, and |buf| is payload up through a CSI 201~.
+// returns the number of bytes consumed. a possible prefix of the terminator
+// at the end of |buf| is left unconsumed, to be completed by further input;
+// we return 0 if that's all we have.
+static int
+process_paste(inputctx* ictx, const unsigned char* buf, int buflen){
+  const int tlen = sizeof(PASTE_END) - 1;
+  const unsigned char* esc = buf;
+  int take = buflen;
+  bool done = false;
+  while( (esc = memchr(esc, '\x1b', buflen - (esc - buf))) ){
+    int left = buflen - (esc - buf);
+    if(left < tlen){ // might be the start of the terminator
+      if(memcmp(esc, PASTE_END, left) == 0){
+        take = esc - buf;
+        break;
+      }
+    }else if(memcmp(esc, PASTE_END, tlen) == 0){
+      take = esc - buf;
+      done = true;
+      break;
+    }
+    ++esc;
+  }
+  paste_append(ictx, buf, take);
+  if(!done){
+    return take;
+  }
+  ictx->inpaste = false;
+  load_paste(ictx);
+  return take + tlen;
+}
+
+static void
+pixelmouse_click(inputctx* ictx, ncinput* ni, long y, long x, bool motion){
   --x;
   --y;
   if(ictx->ti->cellpxy == 0 || ictx->ti->cellpxx == 0){
@@ -582,7 +917,7 @@ pixelmouse_click(inputctx* ictx, ncinput* ni, long y, long x){
   }
   ni->y = y;
   ni->x = x;
-  load_ncinput(ictx, ni);
+  load_mouse_event(ictx, ni, motion);
 }
 
 // ictx->numeric, ictx->p3, and ictx->p2 have the two parameters. we're using
@@ -606,6 +941,7 @@ mouse_click(inputctx* ictx, unsigned release, char follow){
   // select device groups: 64 is buttons 4--7, 128 is 8--11. a pure motion
   // report (no button) is 35 (32 + 3 (no button pressed)) with (oddly enough)
   // 'M' (i.e. release == true).
+  const bool motion = mods & 0x20;
   if(release){
     tni.evtype = NCTYPE_RELEASE;
   }else{
@@ -627,7 +963,7 @@ mouse_click(inputctx* ictx, unsigned release, char follow){
     if(ictx->ti->cellpxx == 0){
       logerror("pixelmouse but no pixel info");
     }
-    return pixelmouse_click(ictx, &tni, y, x);
+    return pixelmouse_click(ictx, &tni, y, x, motion);
   }
   x -= (1 + ictx->lmargin);
   y -= (1 + ictx->tmargin);
@@ -648,7 +984,7 @@ mouse_click(inputctx* ictx, unsigned release, char follow){
   tni.y = y;
   tni.ypx = -1;
   tni.xpx = -1;
-  load_ncinput(ictx, &tni);
+  load_mouse_event(ictx, &tni, motion);
 }
 
 static int
@@ -663,17 +999,66 @@ mouse_release_cb(inputctx* ictx){
   return 2;
 }
 
+#ifndef __MINGW32__
+// gpm events arrive already structured, so they go straight to the ring (or
+// the held motion report), without an escape encoding and parse. having seen
+// |fd| readable, drain whatever else is already waiting there, up to a limit.
+static void
+read_gpm_events(inputctx* ictx, int fd){
+  pthread_mutex_lock(&gpmlock);
+  for(int n = 0 ; n < 64 && ictx->ti->gpmfd == fd ; ++n){
+    if(n){
+      struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0, };
+      if(poll(&pfd, 1, 0) <= 0){
+        break;
+      }
+    }
+    ncinput tni;
+    bool motion;
+    int r = gpm_read(ictx->ti, &tni, &motion);
+    if(r < 0){
+      inc_input_errors(ictx);
+      break;
+    }else if(r == 0){
+      continue;
+    }
+    long x = tni.x - ictx->lmargin;
+    long y = tni.y - ictx->tmargin;
+    if(x < 0 || y < 0){ // click was in margins, drop it
+      logwarn("dropping click in margins %ld/%ld", y, x);
+      continue;
+    }
+    if((unsigned)x >= ictx->ti->dimx - (ictx->rmargin + ictx->lmargin)){
+      logwarn("dropping click in margins %ld/%ld", y, x);
+      continue;
+    }
+    if((unsigned)y >= ictx->ti->dimy - (ictx->bmargin + ictx->tmargin)){
+      logwarn("dropping click in margins %ld/%ld", y, x);
+      continue;
+    }
+    tni.x = x;
+    tni.y = y;
+    load_mouse_event(ictx, &tni, motion);
+  }
+  pthread_mutex_unlock(&gpmlock);
+}
+#endif
+
 static int
 cursor_location_cb(inputctx* ictx){
+  stamp_reply(ictx, "cursor");
   unsigned y = amata_next_numeric(&ictx->amata, "\x1b[", ';') - 1;
   unsigned x = amata_next_numeric(&ictx->amata, "", 'R') - 1;
   // the first one doesn't go onto the queue; consume it here
   pthread_mutex_lock(&ictx->clock);
   --ictx->coutstanding;
-  if(ictx->initdata){
+  if(ictx->initdata && ictx->initdata->cursory < 0){
     pthread_mutex_unlock(&ictx->clock);
     ictx->initdata->cursory = y;
     ictx->initdata->cursorx = x;
+    // with a termcache hit, get_cursor_location() can be called while this
+    // report is outstanding. wake it, so that it requests its own.
+    pthread_cond_broadcast(&ictx->ccond);
     return 2;
   }
   if(ictx->cvalid == ictx->csize){
@@ -697,6 +1082,7 @@ cursor_location_cb(inputctx* ictx){
 
 static int
 geom_cb(inputctx* ictx){
+  stamp_reply(ictx, "geometry");
   unsigned kind = amata_next_numeric(&ictx->amata, "\x1b[", ';');
   unsigned y = amata_next_numeric(&ictx->amata, "", ';');
   unsigned x = amata_next_numeric(&ictx->amata, "", 't');
@@ -945,6 +1331,18 @@ legacy_functional(uint32_t id){
   return id;
 }
 
+// CSI 200~ opens a bracketed paste. everything up through CSI 201~ is taken
+// verbatim by process_paste(), bypassing both the automaton and UTF-8 decode.
+static int
+paste_begin_cb(inputctx* ictx){
+  if(!ictx->inpaste){
+    ictx->inpaste = true;
+    ictx->pastelen = 0;
+    ictx->pastefailed = false;
+  }
+  return 2;
+}
+
 static int
 simple_cb_begin(inputctx* ictx){
   kitty_kbd(ictx, NCKEY_BEGIN, 0, 0);
@@ -1143,6 +1541,7 @@ kitty_cb_complex(inputctx* ictx){
 
 static int
 kitty_keyboard_cb(inputctx* ictx){
+  stamp_reply(ictx, "kbd");
   unsigned level = amata_next_numeric(&ictx->amata, "\x1b[?", 'u');
   if(ictx->initdata){
     ictx->initdata->kbdlevel = level;
@@ -1163,6 +1562,7 @@ xtmodkey_cb(inputctx* ictx){
 // the only xtsmgraphics reply with a single Pv arg is color registers
 static int
 xtsmgraphics_cregs_cb(inputctx* ictx){
+  stamp_reply(ictx, "cregs");
   unsigned pv = amata_next_numeric(&ictx->amata, "\x1b[?1;0;", 'S');
   if(ictx->initdata){
     ictx->initdata->color_registers = pv;
@@ -1174,6 +1574,7 @@ xtsmgraphics_cregs_cb(inputctx* ictx){
 // the only xtsmgraphics reply with a dual Pv arg we want is sixel geometry
 static int
 xtsmgraphics_sixel_cb(inputctx* ictx){
+  stamp_reply(ictx, "sixelgeom");
   unsigned width = amata_next_numeric(&ictx->amata, "\x1b[?2;0;", ';');
   unsigned height = amata_next_numeric(&ictx->amata, "", 'S');
   if(ictx->initdata){
@@ -1227,6 +1628,7 @@ scrub_sixel_responses(struct initial_responses* idata){
 // so, iff we've determined we're alacritty, don't scrub out Sixel details.
 static int
 da1_vt102_cb(inputctx* ictx){
+  stamp_reply(ictx, "DA1");
   loginfo("read primary device attributes");
   if(ictx->initdata){
     if(ictx->initdata->qterm != TERMINAL_ALACRITTY){
@@ -1239,6 +1641,7 @@ da1_vt102_cb(inputctx* ictx){
 
 static int
 da1_cb(inputctx* ictx){
+  stamp_reply(ictx, "DA1");
   loginfo("read primary device attributes");
   if(ictx->initdata){
     scrub_sixel_responses(ictx->initdata);
@@ -1249,6 +1652,7 @@ da1_cb(inputctx* ictx){
 
 static int
 da1_attrs_cb(inputctx* ictx){
+  stamp_reply(ictx, "DA1");
   loginfo("read primary device attributes");
   unsigned val = amata_next_numeric(&ictx->amata, "\x1b[?", ';');
   char* attrlist = amata_next_kleene(&ictx->amata, "", 'c');
@@ -1293,6 +1697,7 @@ da1_attrs_cb(inputctx* ictx){
 // of its DA2 reply. the version is the second parameter.
 static int
 da2_screen_cb(inputctx* ictx){
+  stamp_reply(ictx, "DA2");
   if(ictx->initdata == NULL){
     return 2;
   }
@@ -1321,6 +1726,7 @@ da2_screen_cb(inputctx* ictx){
 // version, and to ascertain the version of old, pre-XTVERSION XTerm.
 static int
 da2_cb(inputctx* ictx){
+  stamp_reply(ictx, "DA2");
   loginfo("read secondary device attributes");
   if(ictx->initdata == NULL){
     return 2;
@@ -1381,6 +1787,7 @@ da2_cb(inputctx* ictx){
 // weird form of Ternary Device Attributes used only by WezTerm
 static int
 wezterm_tda_cb(inputctx* ictx){
+  stamp_reply(ictx, "TDA");
   if(ictx->initdata){
     loginfo("read ternary device attributes");
   }
@@ -1389,15 +1796,29 @@ wezterm_tda_cb(inputctx* ictx){
 
 static int
 kittygraph_cb(inputctx* ictx){
+  stamp_reply(ictx, "kittygraph");
   loginfo("kitty graphics message");
   if(ictx->initdata){
     ictx->initdata->kitty_graphics = 1;
+  }else{
+    // following startup, the only replies we solicit are errors regarding
+    // payloads sent through shared memory or files (see kitty.c).
+    char* msg = amata_next_string(&ictx->amata, "\x1b_G");
+    if(msg){
+      const size_t mlen = strlen(msg);
+      if(mlen < 3 || strcmp(msg + mlen - 3, ";OK")){
+        logwarn("kitty graphics error: %s", msg);
+        kitty_transport_failed(ictx->ti);
+      }
+      free(msg);
+    }
   }
   return 2;
 }
 
 static int
 decrpm_pixelmice(inputctx* ictx){
+  stamp_reply(ictx, "pixelmice");
   unsigned ps = amata_next_numeric(&ictx->amata, "\x1b[?1016;", '$');
   loginfo("received decrpm 1016 %u", ps);
   if(ps == 2){
@@ -1410,6 +1831,7 @@ decrpm_pixelmice(inputctx* ictx){
 
 static int
 decrpm_asu_cb(inputctx* ictx){
+  stamp_reply(ictx, "appsync");
   unsigned ps = amata_next_numeric(&ictx->amata, "\x1b[?2026;", '$');
   loginfo("received decrpm 2026 %u", ps);
   if(ps == 2){
@@ -1443,6 +1865,7 @@ get_default_color(const char* str, uint32_t* color){
 
 static int
 bgdef_cb(inputctx* ictx){
+  stamp_reply(ictx, "bg");
   if(ictx->initdata){
     char* str = amata_next_string(&ictx->amata, "\x1b]11;rgb:");
     if(str == NULL){
@@ -1460,6 +1883,7 @@ bgdef_cb(inputctx* ictx){
 
 static int
 fgdef_cb(inputctx* ictx){
+  stamp_reply(ictx, "fg");
   if(ictx->initdata){
     char* str = amata_next_string(&ictx->amata, "\x1b]10;rgb:");
     if(str == NULL){
@@ -1477,6 +1901,7 @@ fgdef_cb(inputctx* ictx){
 
 static int
 palette_cb(inputctx* ictx){
+  stamp_reply(ictx, "palette");
   if(ictx->initdata){
     unsigned idx = amata_next_numeric(&ictx->amata, "\x1b]4;", ';');
     char* str = amata_next_string(&ictx->amata, "rgb:");
@@ -1520,6 +1945,7 @@ extract_xtversion(inputctx* ictx, const char* str, char suffix){
 
 static int
 xtversion_cb(inputctx* ictx){
+  stamp_reply(ictx, "XTVERSION");
   if(ictx->initdata == NULL){
     return 2;
   }
@@ -1680,6 +2106,7 @@ determinfo(char* old){
 // XTGETTCAP responses are delimited by semicolons
 static int
 tcap_cb(inputctx* ictx){
+  stamp_reply(ictx, "XTGETTCAP");
   char* str = amata_next_string(&ictx->amata, "\x1bP1+r");
   if(str == NULL){
     return 2;
@@ -1734,6 +2161,7 @@ tcap_cb(inputctx* ictx){
 
 static int
 tda_cb(inputctx* ictx){
+  stamp_reply(ictx, "TDA");
   char* str = amata_next_string(&ictx->amata, "\x1bP!|");
   if(str == NULL){
     logwarn("empty ternary device attribute");
@@ -1784,6 +2212,7 @@ build_cflow_automaton(inputctx* ictx){
     { "[\\N;\\N:\\N;\\N;\\N;\\N;\\Nu", kitty_cb_complex_atxt4, },
     { "[\\N;\\N;\\N~", xtmodkey_cb, },
     { "[\\N;\\N:\\N~", kitty_cb_functional, },
+    { "[200~", paste_begin_cb, },
     { "[1;\\NP", legacy_cb_f1, },
     { "[1;\\NQ", legacy_cb_f2, },
     { "[1;\\NS", legacy_cb_f4, },
@@ -1927,10 +2356,34 @@ getpipes(ipipe pipes[static 2]){
   return 0;
 }
 
+// the readiness fd is level-triggered: it is poll()able exactly while input
+// is available. on linux, an eventfd serves with a single descriptor.
+static int
+getreadyfd(inputctx* ictx){
+#ifdef __linux__
+  if((ictx->readyfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0){
+    logerror("couldn't get eventfd (%s)", strerror(errno));
+    return -1;
+  }
+  return 0;
+#else
+  return getpipes(ictx->readypipes);
+#endif
+}
+
+static void
+endreadyfd(inputctx* ictx){
+#ifdef __linux__
+  closepipe(ictx->readyfd);
+#else
+  endpipes(ictx->readypipes);
+#endif
+}
+
 static inline inputctx*
 create_inputctx(tinfo* ti, FILE* infp, int lmargin, int tmargin, int rmargin,
                 int bmargin, ncsharedstats* stats, unsigned drain,
-                int linesigs_enabled){
+                int linesigs_enabled, unsigned coalesce){
   bool sent_queries = (ti->ttyfd >= 0) ? true : false;
   inputctx* i = malloc(sizeof(*i));
   if(i){
@@ -1944,54 +2397,79 @@ create_inputctx(tinfo* ti, FILE* infp, int lmargin, int tmargin, int rmargin,
               if(pthread_condmonotonic_init(&i->ccond) == 0){
                 if((i->stdinfd = fileno(infp)) >= 0){
                   if( (i->initdata = malloc(sizeof(*i->initdata))) ){
-                    if(getpipes(i->readypipes) == 0){
+                    if(getreadyfd(i) == 0){
                       if(getpipes(i->ipipes) == 0){
-                        memset(&i->amata, 0, sizeof(i->amata));
-                        if(prep_special_keys(i) == 0){
-                          if(set_fd_nonblocking(i->stdinfd, 1, &ti->stdio_blocking_save) == 0){
-                            i->termfd = tty_check(i->stdinfd) ? -1 : get_tty_fd(infp);
-                            memset(i->initdata, 0, sizeof(*i->initdata));
-                            if(sent_queries){
-                              i->coutstanding = 1; // one in initial request set
-                              i->initdata->qterm = ti->qterm;
-                              i->initdata->cursory = -1;
-                              i->initdata->cursorx = -1;
-                              i->initdata->maxpaletteread = -1;
-                              i->initdata->kbdlevel = UINT_MAX;
-                            }else{
-                              free(i->initdata);
-                              i->initdata = NULL;
-                              i->coutstanding = 0;
-                            }
-                            i->kittykbd = 0;
-                            i->iread = i->iwrite = i->ivalid = 0;
-                            i->cread = i->cwrite = i->cvalid = 0;
-                            i->initdata_complete = NULL;
-                            i->stats = stats;
-                            i->ti = ti;
-                            i->stdineof = 0;
+                        if(ncwheel_init(&i->wheel) == 0){
+                          memset(&i->amata, 0, sizeof(i->amata));
+                          if(prep_special_keys(i) == 0){
+                            if(set_fd_nonblocking(i->stdinfd, 1, &ti->stdio_blocking_save) == 0){
+                              i->termfd = tty_check(i->stdinfd) ? -1 : get_tty_fd(infp);
+                              memset(i->initdata, 0, sizeof(*i->initdata));
+                              if(sent_queries){
+                                i->coutstanding = 1; // one in initial request set
+                                i->initdata->qterm = ti->qterm;
+                                i->initdata->cursory = -1;
+                                i->initdata->cursorx = -1;
+                                i->initdata->maxpaletteread = -1;
+                                i->initdata->kbdlevel = UINT_MAX;
+                              }else{
+                                free(i->initdata);
+                                i->initdata = NULL;
+                                i->coutstanding = 0;
+                              }
+                              i->kittykbd = 0;
+                              i->iread = i->iwrite = 0;
+                              atomic_init(&i->ivalid, 0);
+                              atomic_init(&i->iwaiters, 0);
+                              atomic_init(&i->ireadied, false);
+                              i->cread = i->cwrite = i->cvalid = 0;
+                              i->initdata_complete = NULL;
+                              i->stats = stats;
+                              i->readns = 0;
+                              i->spinns = input_spin_wanted();
+                              i->burstns = 0;
+                              i->debouncens = 0;
+                              i->resizedeadline = 0;
+                              atomic_init(&i->resizepending, false);
+                              memset(&i->latencies, 0, sizeof(i->latencies));
+                              i->ti = ti;
+                              i->stdineof = 0;
 #ifdef __MINGW32__
-                            i->stdinhandle = ti->inhandle;
+                              i->stdinhandle = ti->inhandle;
 #endif
-                            i->ibufvalid = 0;
-                            i->linesigs = linesigs_enabled;
-                            i->tbufvalid = 0;
-                            i->midescape = 0;
-                            i->lmargin = lmargin;
-                            i->tmargin = tmargin;
-                            i->rmargin = rmargin;
-                            i->bmargin = bmargin;
-                            i->drain = drain;
-                            i->failed = false;
-                            logdebug("input descriptors: %d/%d", i->stdinfd, i->termfd);
-                            return i;
+                              i->ibufvalid = 0;
+                              i->linesigs = linesigs_enabled;
+                              i->tbufvalid = 0;
+                              i->midescape = 0;
+                              i->lmargin = lmargin;
+                              i->tmargin = tmargin;
+                              i->rmargin = rmargin;
+                              i->bmargin = bmargin;
+                              i->drain = drain;
+                              i->coalesce = coalesce;
+                              i->heldmotion = false;
+                              i->inpaste = false;
+                              i->pastebuf = NULL;
+                              i->pastelen = i->pastesize = 0;
+                              i->pastefailed = false;
+                              i->backlog = NULL;
+                              i->backloghead = i->backloglen = i->backlogsize = 0;
+                              i->backlogscan = 0;
+                              i->backlogpaste = false;
+                              atomic_init(&i->resizes, 0);
+                              atomic_init(&i->timerfires, 0);
+                              i->failed = false;
+                              logdebug("input descriptors: %d/%d", i->stdinfd, i->termfd);
+                              return i;
+                            }
                           }
+                          input_free_esctrie(&i->amata);
+                          ncwheel_destroy(&i->wheel);
                         }
-                        input_free_esctrie(&i->amata);
                       }
                       endpipes(i->ipipes);
                     }
-                    endpipes(i->readypipes);
+                    endreadyfd(i);
                   }
                   free(i->initdata);
                 }
@@ -2032,8 +2510,18 @@ free_inputctx(inputctx* i){
       free(i->initdata_complete->version);
       free(i->initdata_complete);
     }
-    endpipes(i->readypipes);
+    endreadyfd(i);
     endpipes(i->ipipes);
+    ncwheel_destroy(&i->wheel);
+    // free any pastes which were never taken
+    for(int v = 0, r = i->iread ; v < atomic_load(&i->ivalid) ; ++v){
+      free(i->inputs[r].paste);
+      if(++r == i->isize){
+        r = 0;
+      }
+    }
+    free(i->pastebuf);
+    free(i->backlog);
     free(i->inputs);
     free(i->csrs);
     free(i);
@@ -2245,6 +2733,15 @@ static void
 process_escapes(inputctx* ictx, unsigned char* buf, int* bufused){
   int offset = 0;
   while(*bufused){
+    if(ictx->inpaste){
+      int consumed = process_paste(ictx, buf + offset, *bufused);
+      if(consumed == 0){
+        break;
+      }
+      *bufused -= consumed;
+      offset += consumed;
+      continue;
+    }
     int consumed = process_escape(ictx, buf + offset, *bufused);
     // negative |consumed| means either that we're not sure whether it's an
     // escape, or it definitely is not.
@@ -2303,16 +2800,14 @@ process_input(const unsigned char* buf, int buflen, ncinput* ni){
     logwarn("utf8 character (%dB) broken across read", cpointlen);
     return 0; // need read more data; we don't have the complete character
   }
-  wchar_t w;
-  mbstate_t mbstate = {0};
-//fprintf(stderr, "CANDIDATE: %d cpointlen: %zu cpoint: %d\n", candidate, cpointlen, cpoint[cpointlen]);
-  // FIXME how the hell does this work with 16-bit wchar_t?
-  size_t r = mbrtowc(&w, (const char*)buf, cpointlen, &mbstate);
-  if(r == (size_t)-1 || r == (size_t)-2){
+  // decode to UTF-32 ourselves, independent of the locale and of the size
+  // of wchar_t (16 bits on Windows)
+  uint32_t cp;
+  if(utf8_decode((const char*)buf, &cp) != cpointlen){
     logerror("invalid utf8 prefix (%dB) on input", cpointlen);
     return -1;
   }
-  ni->id = w;
+  ni->id = cp;
   return cpointlen;
 }
 
@@ -2338,15 +2833,22 @@ static void
 process_bulk(inputctx* ictx, unsigned char* buf, int* bufused){
   int offset = 0;
   while(*bufused){
-    bool noroom = false;
-    pthread_mutex_lock(&ictx->ilock);
-    if(ictx->ivalid == ictx->isize){
-      noroom = true;
-    }
-    pthread_mutex_unlock(&ictx->ilock);
-    if(noroom){
+    if(atomic_load_explicit(&ictx->ivalid, memory_order_acquire) == ictx->isize){
       break;
     }
+    // runs of ASCII needn't be decoded, and can't be broken across reads
+    int run = utf8_ascii_run(buf + offset, *bufused);
+    if(run){
+      while(run-- && atomic_load_explicit(&ictx->ivalid, memory_order_acquire) < ictx->isize){
+        ncinput ni = {
+          .id = buf[offset],
+        };
+        load_ncinput(ictx, &ni);
+        ++offset;
+        --*bufused;
+      }
+      continue;
+    }
     int consumed = process_ncinput(ictx, buf + offset, *bufused);
     if(consumed <= 0){
       break;
@@ -2370,6 +2872,15 @@ process_melange(inputctx* ictx, const unsigned char* buf, int* bufused){
   int offset = 0;
   int origlen = *bufused;
   while(*bufused){
+    if(ictx->inpaste){
+      int consumed = process_paste(ictx, buf + offset, *bufused);
+      if(consumed == 0){
+        break;
+      }
+      *bufused -= consumed;
+      offset += consumed;
+      continue;
+    }
     logdebug("input %d (%u)/%d [0x%02x] (%c)", offset, ictx->amata.used,
              *bufused, buf[offset], isprint(buf[offset]) ? buf[offset] : ' ');
     int consumed = 0;
@@ -2400,15 +2911,235 @@ process_melange(inputctx* ictx, const unsigned char* buf, int* bufused){
   handoff_initial_responses_late(ictx);
 }
 
+
+// a resize which was being debounced has gone unchallenged for the quiet
+// period. allow the new geometry to be adopted, and announce it.
+static void
+settle_resize(inputctx* ictx){
+  ictx->resizedeadline = 0;
+  atomic_store(&ictx->resizepending, false);
+  sigcont_seen_for_render = 1;
+  load_resize(ictx);
+}
+
+// the most bulk input we'll read ahead of ibuf while awaiting a reply
+#define BACKLOG_MAX (64ul * 1024 * 1024)
+
+static const char PASTE_BEGIN[] = "\x1b[200~";
+
+// are we waiting on the terminal to answer a query? after startup, only
+// cursor location reports are requested.
+static bool
+replies_awaited(inputctx* ictx){
+  if(ictx->initdata){
+    return true;
+  }
+  pthread_mutex_lock(&ictx->clock);
+  const bool ret = ictx->coutstanding > 0;
+  pthread_mutex_unlock(&ictx->clock);
+  return ret;
+}
+
+// when the terminal and stdin share a descriptor, a reply to one of our
+// queries can sit in the kernel's buffer behind megabytes of pasted input,
+// and walking all of that through the automaton first stalls whoever awaits
+// the reply. while a reply is awaited, we thus read everything available
+// into the backlog, pluck any replies out of it, and handle them first.
+static void
+read_ahead(inputctx* ictx){
+  for(;;){
+    if(ictx->backloglen == ictx->backlogsize){
+      if(ictx->backloghead){
+        ictx->backloglen -= ictx->backloghead;
+        ictx->backlogscan -= ictx->backloghead;
+        memmove(ictx->backlog, ictx->backlog + ictx->backloghead, ictx->backloglen);
+        ictx->backloghead = 0;
+      }else{
+        if(ictx->backlogsize >= BACKLOG_MAX){
+          return;
+        }
+        size_t newsize = ictx->backlogsize ? ictx->backlogsize * 2 : BUFSIZ * 8;
+        unsigned char* tmp = realloc(ictx->backlog, newsize);
+        if(tmp == NULL){
+          logwarn("couldn't grow %zuB backlog", ictx->backlogsize);
+          return;
+        }
+        ictx->backlog = tmp;
+        ictx->backlogsize = newsize;
+      }
+    }
+    ssize_t r = read(ictx->stdinfd, ictx->backlog + ictx->backloglen,
+                     ictx->backlogsize - ictx->backloglen);
+    // EOF and errors are left for read_input_nblock() to discover once
+    // the backlog has been drained; we mustn't drop what's buffered.
+    if(r <= 0){
+      return;
+    }
+    ictx->backloglen += r;
+    loginfo("read %" PRIdPTR "B ahead (%zuB backlogged)", r,
+            ictx->backloglen - ictx->backloghead);
+  }
+}
+
+// move as much of the backlog into ibuf as will fit.
+static void
+feed_backlog(inputctx* ictx){
+  size_t take = sizeof(ictx->ibuf) - ictx->ibufvalid;
+  if(take > ictx->backloglen - ictx->backloghead){
+    take = ictx->backloglen - ictx->backloghead;
+  }
+  memcpy(ictx->ibuf + ictx->ibufvalid, ictx->backlog + ictx->backloghead, take);
+  ictx->ibufvalid += take;
+  ictx->backloghead += take;
+  if(ictx->backloghead == ictx->backloglen){
+    ictx->backloghead = ictx->backloglen = 0;
+    ictx->backlogscan = 0;
+  }else if(ictx->backlogscan < ictx->backloghead){
+    ictx->backlogscan = ictx->backloghead;
+    ictx->backlogpaste = false; // recomputed by prioritize_replies()
+  }
+}
+
+// if |buf| (which begins with an Esc) is a reply to one of our queries, and
+// not a keypress or mouse report, return its length. return -1 if it might be
+// a reply we don't yet have in full, and 0 if it isn't one.
+static int
+reply_length(const unsigned char* buf, size_t len){
+  if(len < 3){
+    return -1;
+  }
+  if(buf[1] == 'P' || buf[1] == ']' || buf[1] == '_'){
+    // DCS, OSC, and APC strings are only ever replies
+    for(size_t i = 2 ; i < len && i < BUFSIZ ; ++i){
+      if(buf[i] == '\a' && buf[1] == ']'){
+        return i + 1;
+      }else if(buf[i] == '\x1b'){
+        if(i + 1 == len){
+          return -1;
+        }
+        return buf[i + 1] == '\\' ? (int)i + 2 : 0;
+      }
+    }
+    return len < BUFSIZ ? -1 : 0;
+  }else if(buf[1] != '['){
+    return 0;
+  }
+  // keys and mouse events never use a private marker save '<', while the
+  // only unmarked replies are cursor location and geometry reports.
+  size_t i = 2;
+  const bool marked = buf[i] == '?' || buf[i] == '>';
+  if(marked){
+    ++i;
+  }
+  unsigned params = 1;
+  while(i < len && (isdigit(buf[i]) || buf[i] == ';' || buf[i] == ':' || buf[i] == '$')){
+    if(buf[i] == ';'){
+      ++params;
+    }
+    if(++i > 64){
+      return 0;
+    }
+  }
+  if(i == len){
+    return -1;
+  }
+  if(buf[i] < 0x40 || buf[i] > 0x7e){
+    return 0;
+  }
+  if(marked || (buf[i] == 'R' && params == 2) || (buf[i] == 't' && params == 3)){
+    return i + 1;
+  }
+  return 0;
+}
+
+// run the complete reply |buf| through the automaton on its own, leaving any
+// match in progress undisturbed. returns the number of bytes consumed, or 0
+// if it wasn't recognized (in which case it stays where it was).
+static int
+dispatch_reply(inputctx* ictx, const unsigned char* buf, int len){
+  const int used = ictx->amata.used;
+  const int instring = ictx->amata.instring;
+  const unsigned state = ictx->amata.state;
+  const unsigned char* matchstart = ictx->amata.matchstart;
+  const unsigned midescape = ictx->midescape;
+  ictx->amata.used = 0;
+  ictx->amata.instring = 0;
+  int consumed = process_escape(ictx, buf, len);
+  ictx->amata.used = used;
+  ictx->amata.instring = instring;
+  ictx->amata.state = state;
+  ictx->amata.matchstart = matchstart;
+  ictx->midescape = midescape;
+  return consumed > 0 ? consumed : 0;
+}
+
+// handle any replies in the backlog now, removing them, rather than when
+// everything ahead of them has been walked. the payloads of bracketed pastes
+// are skipped. ibuf must have just been processed, so that ictx->inpaste
+// describes the head of the backlog.
+static void
+prioritize_replies(inputctx* ictx){
+  const size_t tlen = sizeof(PASTE_END) - 1;
+  if(ictx->backlogscan == ictx->backloghead){
+    ictx->backlogpaste = ictx->inpaste;
+  }
+  size_t off = ictx->backlogscan;
+  while(off < ictx->backloglen){
+    unsigned char* esc = memchr(ictx->backlog + off, '\x1b', ictx->backloglen - off);
+    if(esc == NULL){
+      off = ictx->backloglen;
+      break;
+    }
+    off = esc - ictx->backlog;
+    const size_t left = ictx->backloglen - off;
+    const char* delim = ictx->backlogpaste ? PASTE_END : PASTE_BEGIN;
+    if(memcmp(esc, delim, left < tlen ? left : tlen) == 0){
+      if(left < tlen){
+        break; // can't yet tell
+      }
+      ictx->backlogpaste = !ictx->backlogpaste;
+      off += tlen;
+      continue;
+    }
+    if(ictx->backlogpaste){
+      ++off;
+      continue;
+    }
+    int rlen = reply_length(esc, left);
+    if(rlen < 0){
+      break;
+    }else if(rlen == 0 || (rlen = dispatch_reply(ictx, esc, rlen)) == 0){
+      ++off;
+      continue;
+    }
+    logdebug("handled %dB reply ahead of %zuB", rlen, off - ictx->backloghead);
+    memmove(esc, esc + rlen, left - rlen);
+    ictx->backloglen -= rlen;
+  }
+  ictx->backlogscan = off;
+  handoff_initial_responses_late(ictx);
+}
+
 // walk the matching automaton from wherever we were.
 static void
 process_ibuf(inputctx* ictx){
   if(resize_seen){
-    ncinput tni = {
-      .id = NCKEY_RESIZE,
-    };
-    load_ncinput(ictx, &tni);
     resize_seen = 0;
+    const uint64_t debounce = __atomic_load_n(&ictx->debouncens, __ATOMIC_RELAXED);
+    if(debounce){
+      // each resize restarts the quiet period
+      atomic_store(&ictx->resizepending, true);
+      ictx->resizedeadline = monotonic_ns() + debounce;
+    }else{
+      load_resize(ictx);
+    }
+  }
+  if(ictx->resizedeadline && monotonic_ns() >= ictx->resizedeadline){
+    settle_resize(ictx);
+  }
+  const unsigned fires = ncwheel_expire(&ictx->wheel, monotonic_ns());
+  if(fires){
+    load_timer(ictx, fires);
   }
   if(cont_seen){
     ncinput tni = {
@@ -2417,6 +3148,11 @@ process_ibuf(inputctx* ictx){
     load_ncinput(ictx, &tni);
     cont_seen = 0;
   }
+  const uint64_t tstart = nctrace_begin();
+  const int burst = ictx->tbufvalid + ictx->ibufvalid;
+  if(burst){
+    ictx->burstns = ictx->readns ? ictx->readns : monotonic_ns();
+  }
   if(ictx->tbufvalid){
     // we could theoretically do this in parallel with process_bulk, but it
     // hardly seems worthwhile without breaking apart the fetches of input.
@@ -2436,12 +3172,57 @@ process_ibuf(inputctx* ictx){
           ictx->amata.matchstart = ictx->ibuf;
         }
       }
+      if(ictx->backloglen && replies_awaited(ictx)){
+        prioritize_replies(ictx);
+      }
+    }
+  }
+  // we're about to go back for more input; don't sit on a motion report
+  flush_held_motion(ictx);
+  ictx->burstns = 0;
+  if(ictx->latencies.count){
+    update_input_stats(ictx->stats, &ictx->latencies);
+  }
+  if(burst){
+    nctrace_end("walk_automaton", tstart, "bytes",
+                burst - ictx->tbufvalid - ictx->ibufvalid);
+  }
+}
+
+void inputlayer_set_resize_debounce(inputctx* ictx, uint64_t ns){
+  __atomic_store_n(&ictx->debouncens, ns, __ATOMIC_RELAXED);
+  resize_debouncing = ns != 0;
+}
+
+bool inputlayer_resize_pending(const inputctx* ictx){
+  return atomic_load(&ictx->resizepending);
+}
+
+int inputlayer_gpm(tinfo* ti, bool enable){
+  int ret = 0;
+  pthread_mutex_lock(&gpmlock);
+  if(enable && ti->gpmfd < 0){
+    int fd = gpm_connect(ti);
+    if(fd < 0){
+      ret = -1;
+    }else{
+      __atomic_store_n(&ti->gpmfd, fd, __ATOMIC_RELEASE);
     }
+  }else if(!enable && ti->gpmfd >= 0){
+    __atomic_store_n(&ti->gpmfd, -1, __ATOMIC_RELEASE);
+    ret = gpm_close(ti);
+  }
+  pthread_mutex_unlock(&gpmlock);
+  // the input thread must add or drop the descriptor from its poll set
+  if(ti->ictx){
+    mark_pipe_ready(ti->ictx->ipipes);
   }
+  return ret;
 }
 
 int ncinput_shovel(inputctx* ictx, const void* buf, int len){
   process_melange(ictx, buf, &len);
+  flush_held_motion(ictx);
   if(len){
     logwarn("dropping %d byte%s", len, len == 1 ? "" : "s");
     inc_input_errors(ictx);
@@ -2449,20 +3230,39 @@ int ncinput_shovel(inputctx* ictx, const void* buf, int len){
   return 0;
 }
 
-// here, we always block for an arbitrarily long time, or not at all,
-// doing the latter only when ictx->midescape is set. |rtfd| and/or |rifd|
-// are set high iff they are ready for reading, and otherwise cleared.
+// here, we block until the next deadline (the settling of a debounced resize,
+// or the earliest timer), or not at all, doing the latter only when
+// ictx->midescape is set. |rtfd| and/or |rifd|
+// are set high iff they are ready for reading, and otherwise cleared. |rgfd|
+// is set to the gpm descriptor if it is ready for reading, and otherwise -1.
 static int
-block_on_input(inputctx* ictx, unsigned* rtfd, unsigned* rifd){
+block_on_input(inputctx* ictx, unsigned* rtfd, unsigned* rifd, int* rgfd){
   logtrace("blocking on input availability");
   *rtfd = *rifd = 0;
+  *rgfd = -1;
   unsigned nonblock = ictx->midescape;
   if(nonblock){
     loginfo("nonblocking read to check for completion");
     ictx->midescape = 0;
   }
+  // the backlog feeds ibuf without stdin needing to become readable
+  if(ictx->backloglen){
+    nonblock = 1;
+  }
+  // a debounced resize wakes us when its quiet period expires
+  uint64_t waitns = nonblock ? 0 : UINT64_MAX;
+  if(!nonblock){
+    const uint64_t now = monotonic_ns();
+    if(ictx->resizedeadline){
+      waitns = ictx->resizedeadline > now ? ictx->resizedeadline - now : 0;
+    }
+    const uint64_t timerns = ncwheel_next(&ictx->wheel, now);
+    if(timerns < waitns){
+      waitns = timerns;
+    }
+  }
 #ifdef __MINGW32__
-  int timeoutms = nonblock ? 0 : -1;
+  int timeoutms = waitns == UINT64_MAX ? -1 : (int)((waitns + 999999) / 1000000);
   DWORD ncount = 0;
   HANDLE handles[2];
   if(!ictx->stdineof){
@@ -2488,7 +3288,7 @@ block_on_input(inputctx* ictx, unsigned* rtfd, unsigned* rifd){
 #ifdef POLLRDHUP
   inevents |= POLLRDHUP;
 #endif
-  struct pollfd pfds[2];
+  struct pollfd pfds[4];
   int pfdcount = 0;
   if(!ictx->stdineof){
     if(ictx->ibufvalid != sizeof(ictx->ibuf)){
@@ -2500,13 +3300,21 @@ block_on_input(inputctx* ictx, unsigned* rtfd, unsigned* rifd){
   }
   if(pfdcount == 0){
     loginfo("output queues full; blocking on ipipes");
-    pfds[pfdcount].fd = ictx->ipipes[0];
+  }
+  // ipipes also wake us when the gpm connection comes or goes
+  pfds[pfdcount].fd = ictx->ipipes[0];
+  pfds[pfdcount].events = inevents;
+  pfds[pfdcount].revents = 0;
+  ++pfdcount;
+  if(ictx->termfd >= 0){
+    pfds[pfdcount].fd = ictx->termfd;
     pfds[pfdcount].events = inevents;
     pfds[pfdcount].revents = 0;
     ++pfdcount;
   }
-  if(ictx->termfd >= 0){
-    pfds[pfdcount].fd = ictx->termfd;
+  const int gpmfd = __atomic_load_n(&ictx->ti->gpmfd, __ATOMIC_ACQUIRE);
+  if(gpmfd >= 0){
+    pfds[pfdcount].fd = gpmfd;
     pfds[pfdcount].events = inevents;
     pfds[pfdcount].revents = 0;
     ++pfdcount;
@@ -2521,21 +3329,48 @@ block_on_input(inputctx* ictx, unsigned* rtfd, unsigned* rifd){
   // on exit (in cancel_and_join()).
   sigdelset(&smask, SIGTHR);
 #endif
-  int events;
+  int events = 0;
+  // input tends to come in flurries. having recently read some, we poll
+  // without sleeping for a while (see NOTCURSES_INPUT_SPIN), so that the
+  // next keypress needn't wait on the scheduler to wake us.
+  if(ictx->spinns && !nonblock && ictx->readns){
+    const uint64_t spinstart = monotonic_ns();
+    uint64_t spinend = ictx->readns + ictx->spinns;
+    if(waitns != UINT64_MAX && spinstart + waitns < spinend){
+      spinend = spinstart + waitns;
+    }
+    uint64_t now = spinstart;
+    while(now < spinend && (events = poll(pfds, pfdcount, 0)) == 0){
+      now = monotonic_ns();
+    }
+    if(events < 0){
+      events = 0; // let the blocking poll sort it out
+    }
+    if(waitns != UINT64_MAX){
+      waitns = waitns > now - spinstart ? waitns - (now - spinstart) : 0;
+    }
+  }
+  if(events == 0){
 #if defined(__APPLE__) || defined(__MINGW32__)
-  int timeoutms = nonblock ? 0 : -1;
-  while((events = poll(pfds, pfdcount, timeoutms)) < 0){ // FIXME smask?
+    int timeoutms = waitns == UINT64_MAX ? -1 : (int)((waitns + 999999) / 1000000);
+    while((events = poll(pfds, pfdcount, timeoutms)) < 0){ // FIXME smask?
 #else
-  struct timespec ts = { .tv_sec = 0, .tv_nsec = 0, };
-  struct timespec* pts = nonblock ? &ts : NULL;
-  while((events = ppoll(pfds, pfdcount, pts, &smask)) < 0){
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = 0, };
+    struct timespec* pts = NULL;
+    if(waitns != UINT64_MAX){
+      ts.tv_sec = waitns / NANOSECS_IN_SEC;
+      ts.tv_nsec = waitns % NANOSECS_IN_SEC;
+      pts = &ts;
+    }
+    while((events = ppoll(pfds, pfdcount, pts, &smask)) < 0){
 #endif
-    if(errno == EINTR){
-      loginfo("interrupted by signal");
-      return resize_seen;
-    }else if(errno != EAGAIN && errno != EBUSY && errno != EWOULDBLOCK){
-      logerror("error polling (%s)", strerror(errno));
-      return -1;
+      if(errno == EINTR){
+        loginfo("interrupted by signal");
+        return resize_seen;
+      }else if(errno != EAGAIN && errno != EBUSY && errno != EWOULDBLOCK){
+        logerror("error polling (%s)", strerror(errno));
+        return -1;
+      }
     }
   }
   loginfo("poll returned %d", events);
@@ -2546,6 +3381,8 @@ block_on_input(inputctx* ictx, unsigned* rtfd, unsigned* rifd){
         *rifd = 1;
       }else if(pfds[pfdcount].fd == ictx->termfd){
         *rtfd = 1;
+      }else if(pfds[pfdcount].fd == gpmfd){
+        *rgfd = gpmfd;
       }else if(pfds[pfdcount].fd == ictx->ipipes[0]){
         char c;
         while(read(ictx->ipipes[0], &c, sizeof(c)) == 1){
@@ -2566,35 +3403,78 @@ block_on_input(inputctx* ictx, unsigned* rtfd, unsigned* rifd){
 static void
 read_inputs_nblock(inputctx* ictx){
   unsigned rtfd, rifd;
-  block_on_input(ictx, &rtfd, &rifd);
+  int rgfd;
+  block_on_input(ictx, &rtfd, &rifd, &rgfd);
+  // stamp input as it's read, so that its events can be timed from arrival
+  if(rtfd || rifd){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ictx->readns = timespec_to_ns(&now);
+  }
+#ifndef __MINGW32__
+  if(rgfd >= 0){
+    read_gpm_events(ictx, rgfd);
+  }
+#endif
   // first we read from the terminal, if that's a distinct source.
   if(rtfd){
     read_input_nblock(ictx->termfd, ictx->tbuf, sizeof(ictx->tbuf),
                       &ictx->tbufvalid, NULL);
   }
   // now read bulk, possibly with term escapes intermingled within (if there
-  // was not a distinct terminal source).
+  // was not a distinct terminal source). anything read ahead comes first.
+  if(ictx->backloglen){
+    feed_backlog(ictx);
+  }
   if(rifd){
     unsigned eof = ictx->stdineof;
-    read_input_nblock(ictx->stdinfd, ictx->ibuf, sizeof(ictx->ibuf),
-                      &ictx->ibufvalid, &ictx->stdineof);
+#ifdef __MINGW32__
+    bool resized = false;
+    int r = windows_read_input(ictx->ti, ictx->ibuf + ictx->ibufvalid,
+                               sizeof(ictx->ibuf) - ictx->ibufvalid, &resized);
+    if(r > 0){
+      ictx->ibufvalid += r;
+    }
+    if(resized){
+      resize_seen = 1;
+      if(!resize_debouncing){
+        sigcont_seen_for_render = 1;
+      }
+    }
+#else
+    if(ictx->backloglen == 0){
+      read_input_nblock(ictx->stdinfd, ictx->ibuf, sizeof(ictx->ibuf),
+                        &ictx->ibufvalid, &ictx->stdineof);
+    }
+#endif
     // did we switch from non-EOF state to EOF? if so, mark us ready
     if(!eof && ictx->stdineof){
-      // we hit EOF; write an event to the readiness fd
-      mark_pipe_ready(ictx->readypipes);
+      // we hit EOF; write an event to the readiness fd. the client checks
+      // stdineof under ilock, so take it to ensure the wakeup isn't lost.
+      mark_input_ready(ictx);
+      pthread_mutex_lock(&ictx->ilock);
       pthread_cond_broadcast(&ictx->icond);
+      pthread_mutex_unlock(&ictx->ilock);
     }
   }
+#ifndef __MINGW32__
+  if(!ictx_independent_p(ictx) && !ictx->stdineof && replies_awaited(ictx)){
+    read_ahead(ictx);
+  }
+#endif
 }
 
 static void*
 input_thread(void* vmarshall){
   setup_alt_sig_stack();
   inputctx* ictx = vmarshall;
+  nc_thread_setup("input");
   if(prep_all_keys(ictx) || build_cflow_automaton(ictx)){
     ictx->failed = true;
     handoff_initial_responses_early(ictx);
     handoff_initial_responses_late(ictx);
+  }else if(automaton_compile(&ictx->amata)){
+    logwarn("walking uncompiled input automaton");
   }
   for(;;){
     read_inputs_nblock(ictx);
@@ -2606,9 +3486,10 @@ input_thread(void* vmarshall){
 
 int init_inputlayer(tinfo* ti, FILE* infp, int lmargin, int tmargin,
                     int rmargin, int bmargin, ncsharedstats* stats,
-                    unsigned drain, int linesigs_enabled){
+                    unsigned drain, int linesigs_enabled, unsigned coalesce){
   inputctx* ictx = create_inputctx(ti, infp, lmargin, tmargin, rmargin,
-                                   bmargin, stats, drain, linesigs_enabled);
+                                   bmargin, stats, drain, linesigs_enabled,
+                                   coalesce);
   if(ictx == NULL){
     return -1;
   }
@@ -2639,7 +3520,9 @@ int stop_inputlayer(tinfo* ti){
 }
 
 int inputready_fd(const inputctx* ictx){
-#ifndef __MINGW32__
+#ifdef __linux__
+  return ictx->readyfd;
+#elif !defined(__MINGW32__)
   return ictx->readypipes[0];
 #else
   (void)ictx;
@@ -2648,83 +3531,118 @@ int inputready_fd(const inputctx* ictx){
 #endif
 }
 
-static inline uint32_t
-internal_get(inputctx* ictx, const struct timespec* ts, ncinput* ni){
-  uint32_t id;
+// wait until input is available, EOF has been seen on stdin, or we pass the
+// absolute deadline 'ts' (NULL blocks indefinitely). returns 1 if input is
+// available, 0 on timeout, NCKEY_EOF on EOF, or (uint32_t)-1 on error. if
+// input is already waiting, we never touch the lock.
+static uint32_t
+await_input(inputctx* ictx, const struct timespec* ts){
   if(ictx->drain){
     logerror("input is being drained");
-    if(ni){
-      memset(ni, 0, sizeof(*ni));
-      ni->id = (uint32_t)-1;
-    }
     return (uint32_t)-1;
   }
+  if(atomic_load_explicit(&ictx->ivalid, memory_order_acquire)){
+    return 1;
+  }
+  uint32_t ret = 1;
   pthread_mutex_lock(&ictx->ilock);
-  while(!ictx->ivalid){
+  atomic_fetch_add(&ictx->iwaiters, 1);
+  while(!atomic_load(&ictx->ivalid)){
     if(ictx->stdineof){
-      pthread_mutex_unlock(&ictx->ilock);
       logwarn("read eof on stdin");
-      if(ni){
-        memset(ni, 0, sizeof(*ni));
-        ni->id = NCKEY_EOF;
-      }
-      return NCKEY_EOF;
+      ret = NCKEY_EOF;
+      break;
     }
     if(ts == NULL){
       pthread_cond_wait(&ictx->icond, &ictx->ilock);
     }else{
       int r = pthread_cond_timedwait(&ictx->icond, &ictx->ilock, ts);
       if(r == ETIMEDOUT){
-        pthread_mutex_unlock(&ictx->ilock);
-        if(ni){
-          memset(ni, 0, sizeof(*ni));
-        }
-        return 0;
-      }else if(r < 0){
+        ret = 0;
+        break;
+      }else if(r){
         inc_input_errors(ictx);
-        if(ni){
-          memset(ni, 0, sizeof(*ni));
-          ni->id = (uint32_t)-1;
-        }
-        return (uint32_t)-1;
+        ret = (uint32_t)-1;
+        break;
       }
     }
   }
-  id = ictx->inputs[ictx->iread].id;
-  if(ni){
-    memcpy(ni, &ictx->inputs[ictx->iread], sizeof(*ni));
-    if(notcurses_ucs32_to_utf8(&ni->id, 1, (unsigned char*)ni->utf8, sizeof(ni->utf8)) < 0){
-      ni->utf8[0] = 0;
+  atomic_fetch_sub(&ictx->iwaiters, 1);
+  pthread_mutex_unlock(&ictx->ilock);
+  return ret;
+}
+
+// take up to 'count' available inputs from the ringbuffer, writing them to
+// 'ni' (which must have room for 'count' ncinputs). only the client calls
+// this, and it must already know at least one input to be available.
+// returns the number taken.
+static int
+take_inputs(inputctx* ictx, ncinput* ni, int count){
+  int avail = atomic_load_explicit(&ictx->ivalid, memory_order_acquire);
+  if(avail > count){
+    avail = count;
+  }
+  bool timers = false;
+  for(int i = 0 ; i < avail ; ++i){
+    memcpy(&ni[i], &ictx->inputs[ictx->iread], sizeof(*ni));
+    if(notcurses_ucs32_to_utf8(&ni[i].id, 1, (unsigned char*)ni[i].utf8, sizeof(ni[i].utf8)) < 0){
+      ni[i].utf8[0] = 0;
+    }
+    if(ni[i].eff_text[0] == 0){
+      ni[i].eff_text[0] = ni[i].id;
+    }
+    // a queued resize carries every resize seen since it was queued. we
+    // clear the count before returning it, so any later resize is queued.
+    if(ni[i].id == NCKEY_RESIZE && ictx->coalesce){
+      unsigned r = atomic_exchange(&ictx->resizes, 0);
+      ni[i].coalesced = r ? r - 1 : 0;
+    }else if(ni[i].id == NCKEY_TIMER){
+      unsigned r = atomic_exchange(&ictx->timerfires, 0);
+      ni[i].coalesced = r ? r - 1 : 0;
+      timers = true;
+    }
+    if(++ictx->iread == ictx->isize){
+      ictx->iread = 0;
     }
-    if (ni->eff_text[0]==0) ni->eff_text[0]=ni->id;
   }
-  if(++ictx->iread == ictx->isize){
-    ictx->iread = 0;
+  update_taken_input_stats(ictx->stats, ni, avail);
+  // release the slots back to the input thread
+  int was = atomic_fetch_sub(&ictx->ivalid, avail);
+  if(was == avail){
+    drain_input_ready(ictx);
   }
-  bool sendsignal = false;
-  if(ictx->ivalid-- == ictx->isize){
-    sendsignal = true;
-  }else{
-    logtrace("draining event readiness pipe %d", ictx->ivalid);
-#ifndef __MINGW32__
-    char c;
-    while(read(ictx->readypipes[0], &c, sizeof(c)) == 1){
-      // FIXME accelerate?
+  // if we were full, the input thread might be waiting on us for room
+  if(was == ictx->isize){
+    mark_pipe_ready(ictx->ipipes);
+  }
+  // run the callbacks of any expired timers before the caller sees the
+  // NCKEY_TIMER, so that a single render reflects all of them.
+  if(timers){
+    ncwheel_run(&ictx->wheel);
+  }
+  return avail;
+}
+
+static inline uint32_t
+internal_get(inputctx* ictx, const struct timespec* ts, ncinput* ni){
+  ncinput tni;
+  uint32_t r = await_input(ictx, ts);
+  if(r != 1){
+    if(ni){
+      memset(ni, 0, sizeof(*ni));
+      if(r){
+        ni->id = r;
+      }
     }
-#else
-    // we ought be draining this, but it breaks everything, as we can't easily
-    // do nonblocking input from a pipe in windows, augh...
-    // Ne pleure pas, Alfred! J'ai besoin de tout mon courage pour mourir a vingt ans!
-    /*while(ReadFile(ictx->readypipes[0], &c, sizeof(c), NULL, NULL)){
-      // FIXME accelerate?
-    }*/
-#endif
+    return r;
   }
-  pthread_mutex_unlock(&ictx->ilock);
-  if(sendsignal){
-    mark_pipe_ready(ictx->ipipes);
+  if(ni){
+    take_inputs(ictx, ni, 1);
+    return ni->id;
   }
-  return id;
+  take_inputs(ictx, &tni, 1);
+  free(tni.paste); // caller is uninterested in the payload
+  return tni.id;
 }
 
 // infp has already been set non-blocking
@@ -2733,23 +3651,68 @@ uint32_t notcurses_get(notcurses* nc, const struct timespec* absdl, ncinput* ni)
   return ret;
 }
 
-// FIXME better performance if we move this within the locked area
+int notcurses_get_batch(notcurses* n, const struct timespec* absdl,
+                        ncinput* ni, int vcount){
+  if(vcount <= 0){
+    return 0;
+  }
+  inputctx* ictx = n->tcache.ictx;
+  uint32_t r = await_input(ictx, absdl);
+  if(r == (uint32_t)-1){
+    return -1;
+  }else if(r == 0){
+    return 0;
+  }else if(r == NCKEY_EOF){
+    memset(ni, 0, sizeof(*ni));
+    ni->id = NCKEY_EOF;
+    return 1;
+  }
+  return take_inputs(ictx, ni, vcount);
+}
+
 int notcurses_getvec(notcurses* n, const struct timespec* absdl,
                      ncinput* ni, int vcount){
-  for(int v = 0 ; v < vcount ; ++v){
-    uint32_t u = notcurses_get(n, absdl, &ni[v]);
-    if(u == (uint32_t)-1){
+  int v = 0;
+  while(v < vcount){
+    int r = notcurses_get_batch(n, absdl, ni + v, vcount - v);
+    if(r < 0){
       if(v == 0){
         return -1;
       }
       return v;
-    }else if(u == 0){
+    }else if(r == 0){
       return v;
     }
+    v += r;
   }
   return vcount;
 }
 
+int notcurses_timer_add(notcurses* nc, uint64_t delayns, uint64_t periodns,
+                        nctimercb cb, void* curry){
+  inputctx* ictx = nc->tcache.ictx;
+  if(ictx == NULL){
+    logerror("timers require an input layer");
+    return -1;
+  }
+  int id = ncwheel_add(&ictx->wheel, monotonic_ns(), delayns, periodns,
+                       nc, cb, curry);
+  if(id > 0){
+    // the input thread must reconsider how long it sleeps
+    mark_pipe_ready(ictx->ipipes);
+  }
+  return id;
+}
+
+int notcurses_timer_del(notcurses* nc, int id){
+  inputctx* ictx = nc->tcache.ictx;
+  if(ictx == NULL){
+    logerror("timers require an input layer");
+    return -1;
+  }
+  return ncwheel_del(&ictx->wheel, id);
+}
+
 uint32_t ncdirect_get(ncdirect* n, const struct timespec* absdl, ncinput* ni){
   if(n->eof){
     logerror("already got EOF");
@@ -2762,6 +3725,17 @@ uint32_t ncdirect_get(ncdirect* n, const struct timespec* absdl, ncinput* ni){
   return r;
 }
 
+struct initial_responses* inputlayer_poll_responses(inputctx* ictx){
+  struct initial_responses* iresp = NULL;
+  pthread_mutex_lock(&ictx->ilock);
+  if(ictx->initdata == NULL && ictx->initdata_complete){
+    iresp = ictx->initdata_complete;
+    ictx->initdata_complete = NULL;
+  }
+  pthread_mutex_unlock(&ictx->ilock);
+  return iresp;
+}
+
 int get_cursor_location(inputctx* ictx, const char* u7, unsigned* y, unsigned* x){
   pthread_mutex_lock(&ictx->clock);
   while(ictx->cvalid == 0){
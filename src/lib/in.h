@@ -8,6 +8,8 @@ extern "C" {
 // internal header, not installed
 
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 struct tinfo;
 struct inputctx;
@@ -15,7 +17,7 @@ struct ncsharedstats;
 
 int init_inputlayer(struct tinfo* ti, FILE* infp, int lmargin, int tmargin,
                     int rmargin, int bmargin, struct ncsharedstats* stats,
-                    unsigned drain, int linesigs_enabled)
+                    unsigned drain, int linesigs_enabled, unsigned coalesce)
   __attribute__ ((nonnull (1, 2, 7)));
 
 int stop_inputlayer(struct tinfo* ti);
@@ -28,6 +30,20 @@ int inputready_fd(const struct inputctx* ictx)
 int ncinput_shovel(struct inputctx* ictx, const void* buf, int len)
   __attribute__ ((nonnull (1, 2)));
 
+// hold back NCKEY_RESIZE, and the adoption of new geometry, until 'ns' have
+// passed without another SIGWINCH. 0 disables debouncing.
+void inputlayer_set_resize_debounce(struct inputctx* ictx, uint64_t ns)
+  __attribute__ ((nonnull (1)));
+
+// is a debounced resize yet to settle?
+bool inputlayer_resize_pending(const struct inputctx* ictx)
+  __attribute__ ((nonnull (1)));
+
+// connect to or disconnect from gpm. the input thread polls the connection,
+// and loads its events directly as ncinputs.
+int inputlayer_gpm(struct tinfo* ti, bool enable)
+  __attribute__ ((nonnull (1)));
+
 typedef enum {
     TERMINAL_UNKNOWN,       // no useful information from queries; use termname
     // the very limited linux VGA/serial console, or possibly the (deprecated,
@@ -54,6 +70,17 @@ typedef enum {
     TERMINAL_KONSOLE,       // TDA: "~KDE" (7e4b4445)
 } queried_terminals_e;
 
+// when each kind of reply to our initial queries arrived, for the startup
+// latency breakdown of notcurses-info.
+#define REPLYTIMES_MAX 24
+
+typedef struct replytime {
+  const char* what;            // static name of the reply
+  uint64_t firstns;            // CLOCK_MONOTONIC of the first such reply
+  uint64_t lastns;             // ...and of the last (palette replies are many)
+  unsigned count;              // replies of this kind
+} replytime;
+
 // after spawning the input layer, send initial queries to the terminal. its
 // responses will be built up herein. it's dangerous to go alone! take this!
 struct initial_responses {
@@ -84,6 +111,8 @@ struct initial_responses {
   int maxpaletteread;          // maximum palette index read
   bool pixelmice;              // have we pixel-based mice events?
   char* hpa;                   // control sequence for hpa via XTGETTCAP
+  replytime replies[REPLYTIMES_MAX]; // in order of first arrival
+  unsigned replycount;         // valid entries of replies
 };
 
 // Blocking call. Waits until the input thread has processed all responses to
@@ -91,9 +120,31 @@ struct initial_responses {
 struct initial_responses* inputlayer_get_responses(struct inputctx* ictx)
   __attribute__ ((nonnull (1)));
 
+// Nonblocking. Returns the responses to our initial queries if the input
+// thread has processed all of them (and they've not been taken), else NULL.
+struct initial_responses* inputlayer_poll_responses(struct inputctx* ictx)
+  __attribute__ ((nonnull (1)));
+
 int get_cursor_location(struct inputctx* ictx, const char* u7, unsigned* y, unsigned* x)
   __attribute__ ((nonnull (1, 2)));
 
+// the on-disk cache of initial responses (termcache.c), used only when
+// NOTCURSES_TERMCACHE is set in the environment.
+bool termcache_enabled(void);
+
+struct initial_responses* termcache_load(unsigned rows, unsigned cols);
+
+int termcache_store(const struct initial_responses* ir)
+  __attribute__ ((nonnull (1)));
+
+struct initial_responses* termcache_copy(const struct initial_responses* ir)
+  __attribute__ ((nonnull (1)));
+
+// compares the real responses (if they've arrived) against the entry which
+// was used, replacing the entry if it was stale. frees |cached|.
+void termcache_verify(struct inputctx* ictx, struct initial_responses* cached)
+  __attribute__ ((nonnull (1, 2)));
+
 #ifdef __cplusplus
 }
 #endif
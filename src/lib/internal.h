@@ -47,15 +47,21 @@ extern "C" {
 #include "lib/egcpool.h"
 #include "lib/sprite.h"
 #include "lib/fbuf.h"
+#include "lib/trace.h"
+#include "lib/arena.h"
 #include "lib/gpm.h"
 
 struct sixelmap;
 struct ncvisual_details;
+struct nclayer;
 
 // Was this glyph drawn as part of an ncvisual? If so, we need to honor
 // blitter stacking rather than the standard trichannel solver.
 #define NC_BLITTERSTACK_MASK  NC_NOBACKGROUND_MASK
 
+// tabs are expanded with spaces through the next multiple of TABSTOP columns
+#define TABSTOP 8
+
 // we can't define multipart ncvisual here, because OIIO requires C++ syntax,
 // and we can't go throwing C++ syntax into this header. so it goes.
 
@@ -73,6 +79,14 @@ struct ncvisual_details;
 // The framebuffer 'fb' is a set of rows. For scrolling, we interpret it as a
 // circular buffer of rows. 'logrow' is the index of the row at the logical top
 // of the plane. It only changes from 0 if the plane is scrollable.
+//
+// ncplane_dup() doesn't copy the framebuffer or the EGCpool; the copy shares
+// both with the original, each holding a reference in 'fbshare'. Whichever
+// plane next writes to them first takes a private copy (see ncplane_own()).
+typedef struct fbshare {
+  unsigned refs;         // planes sharing the fb and pool, modified atomically
+} fbshare;
+
 typedef struct ncplane {
   nccell* fb;            // "framebuffer" of character cells
   int logrow;            // logical top row, starts at 0, add one for each scroll
@@ -84,7 +98,11 @@ typedef struct ncplane {
                          //  also used as left and top margin on resize by
                          //  ncplane_resize_marginalized()
   unsigned lenx, leny;   // size of the plane, [0..len{x,y}) is addressable
+  unsigned capy;         // rows allocated in fb, at least leny. rows beyond
+                         //  leny are zeroed. only autogrow planes exceed it.
   egcpool pool;          // attached storage pool for UTF-8 EGCs
+  fbshare* fbshare;      // non-NULL if fb and pool might be shared
+  unsigned fbcached;     // while in the plane cache, cells retained at fb
   uint64_t channels;     // works the same way as cells
 
   // a notcurses context is made up of piles, each rooted by one or more root
@@ -116,26 +134,83 @@ typedef struct ncplane {
   bool scrolling;        // is scrolling enabled? always disabled by default
   bool fixedbound;       // are we fixed relative to the parent's scrolling?
   bool autogrow;         // do we grow to accommodate output?
+  struct ncscrollback* history; // rows scrolled up and out, or NULL
+  struct nccanvas* canvas; // sparse canvas we're a window onto, or NULL
+  unsigned mods;         // bumped by each ncplane_damage_rows()
+  // work deferred by an open pile transaction (see ncpile_begin_update()).
+  // |txy|/|txx| is the origin requested by ncplane_move_yx(), relative to
+  // our parent (or the pile, for a root plane), valid if |txmoved| is set.
+  int txy, txx;
+  bool txmoved;          // a move awaits ncpile_commit()
+  bool txresize;         // our resize callback awaits ncpile_commit()
+  bool txlisted;         // we're on our pile's txplanes
+
+  // a plane marked with ncplane_set_layercache() roots a cached layer, its
+  // family composited once and reused until any member changes. |inlayer| is
+  // the layer which claimed us at our pile's last render (valid only during
+  // that render).
+  struct nclayer* layer;   // non-NULL iff we root a cached layer
+  struct nclayer* inlayer; // outermost cached layer containing us, or NULL
 
   // we need to track any widget to which we are bound, so that (1) we don't
   // end up bound to two widgets and (2) we can clean them up on shutdown
   // (assuming they weren't explicitly cleaned up by the client).
   void* widget;            // widget to which we are bound, can be NULL
   void(*wdestruct)(void*); // widget destructor, NULL iff widget is NULL
+
+  // costs charged to this plane while profiling (see notcurses_profile()).
+  // written only by the thread rendering our pile.
+  uint64_t prof_paint_ns;  // time spent painting this plane
+  uint64_t prof_paints;    // number of times it was painted
+  uint64_t prof_sprixel_ns;// time spent drawing its sprixel
+  uint64_t prof_sprixels;  // number of sprixel draws
 } ncplane;
 
 // current presentation state of the terminal. it is carried across render
 // instances. initialize everything to 0 on a terminal reset / startup.
+// a sprixel glyph written in place, rather than copied into the raster
+// buffer. it goes out immediately before byte |off| of the buffer.
+typedef struct rsplice {
+  size_t off;
+  const char* buf;
+  size_t len;
+} rsplice;
+
 typedef struct rasterstate {
   // we assemble the encoded (rasterized) output in an fbuf (a portable POSIX
   // memstream, basically), and keep it around between uses. this could be a
   // problem if it ever tremendously spiked, but that seems unlikely?
   fbuf f;         // buffer for preparing raster glyph/escape stream
 
+  // while splicing (only while rasterizing for an immediate, blocking write),
+  // large sprixel glyphs aren't copied into f, but instead referenced here,
+  // in order of their offsets. they're gathered up with writev(2).
+  rsplice* splices;
+  unsigned splicecount, splicealloc;
+  size_t splicebytes; // total bytes referenced by splices
+  bool splicing;
+
+  // moving average of the cost of our blocking frame writes, 0 until
+  // measured. it decides which frames get synchronized updates.
+  double nsperbyte;
+  // the same, but taken only over frames large enough to be limited by the
+  // link rather than the write(2) itself. with NCOPTION_ADAPTIVE_BANDWIDTH,
+  // it decides whether we're in the low-bandwidth profile (lowbw).
+  double bwnsperbyte;
+  bool lowbw;
+  // CIELAB of the current RGB fore- and background, for color tolerance.
+  // each is valid only while its key is its color | 0x1000000.
+  uint32_t fglabkey, bglabkey;
+  float fglab[3], bglab[3];
+
   // the current cursor position. this is independent of whether the cursor is
   // visible. it is the cell at which the next write will take place. this is
   // modified by: output, cursor moves, clearing the screen (during refresh).
   int y, x;
+  // have we written only glyphs of certain width (ASCII) since our last
+  // absolute horizontal move? if not, x might be wrong, and so we don't
+  // compound any error with relative horizontal moves.
+  bool xtrusted;
 
   const ncplane* lastsrcp; // last source plane (we emit hpa on plane changes)
 
@@ -162,6 +237,10 @@ typedef struct rasterstate {
   bool bgpalelidable;
   bool fgdefelidable;
   bool bgdefelidable;
+
+  // did the last pile we rasterized have any graphics? if so, and we switch
+  // to another pile, they need be hidden (see clean_sprixels()).
+  bool sprixelsplaced;
 } rasterstate;
 
 // Tablets are the toplevel entitites within an ncreel. Each corresponds to
@@ -169,12 +248,26 @@ typedef struct rasterstate {
 typedef struct nctablet {
   ncplane* p;                  // border plane, NULL when offscreen
   ncplane* cbp;                // data plane, NULL when offscreen
+  ncplane* parked;             // border plane kept while offscreen, or NULL
+  ncplane* parkedcb;           // data plane kept while offscreen, or NULL
   struct nctablet* next;
   struct nctablet* prev;
   tabletcb cbfxn;              // application callback to draw cbp
   void* curry;                 // application data provided to cbfxn
 } nctablet;
 
+// a recycled border plane, together with its data plane (if it had one)
+typedef struct ncreel_spare {
+  ncplane* p;
+  ncplane* cbp;
+} ncreel_spare;
+
+// a box style (see ncboxstyle_create()). every cell is simple and a single
+// column wide, so they can be copied into any plane without touching pools.
+typedef struct ncboxstyle {
+  nccell ul, ur, ll, lr, hl, vl;
+} ncboxstyle;
+
 typedef struct ncreel {
   ncplane* p;           // ncplane this ncreel occupies, under tablets
   // doubly-linked list, a circular one when infinity scrolling is in effect.
@@ -188,6 +281,14 @@ typedef struct ncreel {
   } direction;          // last direction of travel
   int tabletcount;      // could be derived, but we keep it o(1)
   ncreel_options ropts; // copied in ncreel_create()
+  // planes of tablets which have left the screen are kept here (or, with
+  // NCREEL_OPTION_RETAINPLANES, with their tablets), bound beneath a plane
+  // rooting a pile of its own, so that they're never rendered.
+  ncplane* sparepile;
+  ncreel_spare* spares;
+  unsigned sparecount, sparealloc;
+  // border styles, resolved once from ropts in ncreel_create()
+  ncboxstyle borderstyle, tabletstyle, focusedstyle;
 } ncreel;
 
 typedef struct ncfdplane {
@@ -196,27 +297,59 @@ typedef struct ncfdplane {
   void* curry;                // passed to the callbacks
   int fd;                     // we take ownership of the fd, and close it
   bool follow;                // keep trying to read past the end (event-based)
+  bool mapfile;               // deliver regular files straight from mmap()
+  size_t bufmax;              // read buffer grows no larger than this
+  uint64_t coalescens;        // hold data at most this long before delivery
   ncplane* ncp;               // bound ncplane
-  pthread_t tid;              // thread servicing this i/o
-  bool destroyed;             // set in ncfdplane_destroy() in our own context
+  struct fd_reactor* reactor; // shared thread servicing this i/o
+  struct ncsubproc* subproc;  // non-NULL if we're a subprocess's pipe
+  int pidfd;                  // subproc's pidfd (not ours to close), or -1
+  // everything below (save destroyed/waiter/reaped) is touched only by the
+  // reactor thread, once registered
+  char* buf;                  // read buffer of alloc + 1 bytes
+  size_t alloc, used;
+  uint64_t deadline;          // deliver buffered data by here (ns)
+  uint64_t nextpoll;          // read an unwaitable fd at this time (ns)
+  bool pollable;              // can we wait on the fd?
+  bool watched, pidwatched;   // are the fd/pidfd in the reactor's wait set?
+  bool mapped;                // has the (optional) mapped delivery been done?
+  bool eof;                   // subproc pipe hit EOF; awaiting its exit
+  bool finished;              // no further callbacks will be made
+  // guarded by the reactor's lock
+  bool destroyed;             // ncfdplane_destroy() has been called
+  bool waiter;                // destroyer is waiting for the reactor to reap
+  bool reaped;                // reactor has dropped us, on behalf of waiter
 } ncfdplane;
 
 typedef struct ncsubproc {
   ncfdplane* nfp;
   pid_t pid;                  // subprocess
   int pidfd;                  // for signalling/watching the subprocess
-  pthread_t waittid;          // wait()ing thread if pidfd is not available
-  pthread_mutex_t lock;       // guards waited
+  pthread_mutex_t lock;       // guards waited and status
   bool waited;                // we've wait()ed on it, don't kill/wait further
+  int status;                 // wait status, valid once waited
 } ncsubproc;
 
 typedef struct ncreader {
   ncplane* ncp;               // always owned by ncreader
   uint64_t tchannels;         // channels for input text
   uint32_t tattrs;            // attributes for input text
-  ncplane* textarea;          // grows as needed iff scrolling is enabled
-  int xproject;               // virtual x location of ncp origin on textarea
+  // the text is a gap buffer of UTF-8, lines separated by '\n'. the gap
+  // [gapbeg, gapend) always sits at the cursor, and its first byte is kept
+  // NUL, so the text on either side of the cursor is a proper string.
+  char* text;
+  size_t textend;             // offset of the terminating NUL
+  size_t gapbeg, gapend;
+  size_t linebeg;             // offset of the cursor's line
+  size_t topbeg;              // offset of the first line in the viewport
+  unsigned linecount;         // lines of text, at least 1
+  unsigned cury, curx;        // cursor's line and column within the text
+  unsigned yproject;          // first text line shown in the viewport
+  unsigned xproject;          // first text column shown in the viewport
+  size_t projbeg;             // offset of the EGC at xproject on cursor's line
+  unsigned projx;             // column of projbeg, UINT_MAX if stale
   bool horscroll;             // is there horizontal panning?
+  bool verscroll;             // is there vertical panning?
   bool no_cmd_keys;           // are shortcuts disabled?
   bool manage_cursor;         // enable and place a virtual cursor
 } ncreader;
@@ -226,6 +359,13 @@ typedef struct ncprogbar {
   double progress;          // on the range [0, 1]
   uint32_t ulchannel, urchannel, blchannel, brchannel;
   bool retrograde;
+  // what we last drew, so that an update need only touch the cells between
+  // the old and new frontiers. drawnchunks is -1 if the plane must be
+  // redrawn in full (nothing drawn yet, or a draw failed partway).
+  int drawnchunks, drawnidx;
+  unsigned drawny, drawnx;
+  unsigned drawnmods;     // plane's mods after our draw; any other write differs
+  bool drawnutf8;
 } ncprogbar;
 
 typedef struct nctab {
@@ -233,6 +373,7 @@ typedef struct nctab {
   tabcb cb;     // tab callback
   char* name;   // tab name
   int namecols; // tab name width in columns
+  int hdrx;     // column of our header as last drawn, -1 if it wasn't
   void* curry;  // user pointer
   struct nctab* prev;
   struct nctab* next;
@@ -242,11 +383,80 @@ typedef struct nctab {
 // access the stats object, so throw a lock on it. we don't want the lock in
 // the actual structure since (a) it's usually unnecessary and (b) it breaks
 // memset() and memcpy().
+// render phases timed while profiling (see notcurses_profile())
+typedef enum {
+  PROF_PAINT,         // solving planes into the crender vector
+  PROF_POSTPAINT,     // resolving crenders against the last frame
+  PROF_SPRIXEL_CLEAN, // sprixel phase 1: wiping moved/hidden bitmaps
+  PROF_CORE0,         // glyph phase 1
+  PROF_SPRIXEL_DRAW,  // sprixel phase 2: drawing bitmaps
+  PROF_CORE1,         // glyph phase 2
+  PROF_WRITE,         // writing the frame to the terminal
+  PROF_PHASES
+} profphase_e;
+
+// costs of planes which have been destroyed, aggregated by name
+typedef struct profplane {
+  char* name;
+  uint64_t paint_ns, paints;
+  uint64_t sprixel_ns, sprixels;
+} profplane;
+
+// guarded by the stats lock, save 'enabled', which is only read racily as a
+// hint by the render path.
+typedef struct ncprofile {
+  bool enabled;
+  uint64_t phase_ns[PROF_PHASES];
+  uint64_t phase_runs[PROF_PHASES];
+  profplane* retired;
+  unsigned retiredcount, retiredalloc;
+} ncprofile;
+
+// writers serialize on 'lock', and hold 'seq' odd for the duration of their
+// update (see stats_lock()), so that snapshots can be taken without the lock
+// (see stats_read()). the input thread doesn't take the lock at all; its
+// counts are kept apart, updated with atomic builtins, and folded into
+// snapshots. this header is also seen by C++, hence builtins over _Atomic.
 typedef struct ncsharedstats {
   pthread_mutex_t lock;
+  unsigned seq;            // seqlock sequence, odd while being written
   ncstats s;
+  nchistogram hists[NCSTATS_HIST_COUNT];
+  uint64_t input_events;   // atomic; folded into s.input_events
+  uint64_t input_errors;   // atomic; folded into s.input_errors
+  // arrival of the oldest input not yet followed by a written frame, or 0.
+  // atomic.
+  uint64_t input_pending_ns;
 } ncsharedstats;
 
+static inline void
+stats_lock(ncsharedstats* st){
+  pthread_mutex_lock(&st->lock);
+  __atomic_store_n(&st->seq, st->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void
+stats_unlock(ncsharedstats* st){
+  __atomic_store_n(&st->seq, st->seq + 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&st->lock);
+}
+
+// copy 'len' bytes from 'src', which lies within 'st', to 'dst' without
+// taking the lock, retrying should a writer intervene.
+static inline void
+stats_read(const ncsharedstats* st, void* dst, const void* src, size_t len){
+  unsigned s0, s1;
+  do{
+    while((s0 = __atomic_load_n(&st->seq, __ATOMIC_ACQUIRE)) & 1u){
+      ; // a writer is mid-update; they never hold it for long
+    }
+    memcpy(dst, src, len);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    s1 = __atomic_load_n(&st->seq, __ATOMIC_RELAXED);
+  }while(s0 != s1);
+}
+
 typedef struct ncdirect {
   ncpalette palette;         // 256-indexed palette can be used instead of/with RGB
   FILE* ttyfp;               // FILE* for output tty
@@ -256,16 +466,26 @@ typedef struct ncdirect {
   uint64_t flags;            // copied in ncdirect_init() from param
   ncsharedstats stats;       // stats! not as broadly used as in notcurses
   unsigned eof;              // have we seen EOF on stdin?
+  // between ncdirect_begin_batch() and ncdirect_end_batch(), output gathers
+  // here rather than going to ttyfp, and is written by ncdirect_flush().
+  fbuf* batch;
+  // with NCDIRECT_OPTION_SHADOW_CURSOR, the cursor location as tracked
+  // across our own output, valid until we lose track of it. the pushed
+  // shadow is restored by ncdirect_cursor_pop().
+  bool shadowvalid, pushedvalid;
+  unsigned shadowy, shadowx;
+  unsigned pushedy, pushedx;
 } ncdirect;
 
 // Extracellular state for a cell during the render process. There is one
-// crender per rendered cell, and they are initialized to all zeroes. Be
-// careful with order here; padding can easily enlarge this struct from 40
-// to 48 bytes.
+// crender per rendered cell, and they are initialized to all zeroes. Every
+// render streams through the whole vector, so keep it at 32 bytes (two per
+// cache line); be careful with order here, as padding can easily enlarge it.
+// Sprixels are few, so rather than a pointer, each crender carries only a
+// bit indicating that it's beneath one (see crender_sprixel()).
 struct crender {
   nccell c;         // solution cell
   const ncplane *p; // source of glyph for this cell
-  sprixel* sprixel; // bitmap encountered during traversal
   uint32_t hcfg;    // fg channel prior to HIGHCONTRAST (need full channel)
   struct {
     // If the glyph we render is from an ncvisual, and has a transparent or
@@ -290,11 +510,33 @@ struct crender {
     // and then reapply any foreground shading from above the highcontrast
     // declaration. save the foreground state when we go highcontrast.
     unsigned hcfgblends: 8; // number of foreground blends prior to HIGHCONTRAST
-    unsigned sprixeled: 1; // have we passed through a sprixel?
+    unsigned sprixeled: 1; // are we beneath a sprixel?
     unsigned p_beats_sprixel: 1; // did we solve for our glyph above the bitmap?
   } s;
 };
 
+// columns [beg, end) of some row contain every damaged cell of that row. the
+// span is empty if beg >= end.
+struct dmgspan {
+  unsigned beg, end;
+};
+
+// a uniform grid over a pile's visible area, each of whose cells lists the
+// planes intersecting it, topmost first. it is marked stale whenever a plane
+// of the pile is created, destroyed, moved, resized, restacked, or changes
+// piles, and rebuilt on the next lookup (see ncpile_plane_at()).
+#define PINDEX_CELL 16 // rows and columns covered by each grid cell
+
+typedef struct planeindex {
+  unsigned dimy, dimx;    // pile geometry when built
+  unsigned rows, cols;    // grid geometry
+  unsigned* offsets;      // rows * cols + 1 indices into planes
+  struct ncplane** planes;// each grid cell's planes, topmost first
+  unsigned offsetslen;    // elements allocated in offsets
+  unsigned planeslen;     // elements allocated in planes
+  bool stale;
+} planeindex;
+
 // a pile is a collection of planes which will be rendered together. piles are
 // completely distinct with regards to thread-safety; one can always operate
 // concurrently on distinct piles (save rasterizing, of course). material from
@@ -325,7 +567,76 @@ typedef struct ncpile {
   unsigned dimy, dimx;        // rows and cols at last render/creation
   unsigned cellpxx, cellpxy;  // cell-pixel geometry at last render/creation
   int scrolls;                // how many real lines need be scrolled at raster
+  // any other plane which scrolls is recorded in scrollplane, along with the
+  // rows it has scrolled since the last render (-1 if several planes have
+  // scrolled). if the render can turn them into a terminal scroll of the
+  // plane's rows alone, the region [rgntop, rgntop + rgnrows) of the
+  // lastframe is shifted up by rgnscrolls rows, for the raster to match.
+  ncplane* scrollplane;
+  int planescrolls;
+  unsigned rgntop, rgnrows;
+  int rgnscrolls;
   sprixel* sprixelcache;      // sorted list of sprixels, assembled during paint
+  // the sprixels of sprixelcache with work for the raster's later sprixel
+  // passes, in list order. collected by clean_sprixels(), which reserves
+  // room for every sprixel of the pile, and joined by any sprixel
+  // invalidated while rasterizing glyphs.
+  sprixel** sprixwork;
+  unsigned sprixworklen, sprixworkcap;
+  // the sprixels painted by the last render, topmost first. each crender
+  // with s.sprixeled set lies beneath the first of these covering it. a
+  // sprixel freed before the next render leaves a NULL entry.
+  sprixel** rsprixels;
+  unsigned rsprixelslen, rsprixelscap;
+  // per cell of crender, the index in rsprixels of the sprixel painted over
+  // it (RSPRIXIDX_UNKNOWN if that couldn't be recorded). only meaningful
+  // where s.sprixeled is set, and only allocated once the pile has sprixels.
+  uint16_t* rsprixidx;
+  size_t rsprixidxlen;
+  // cells of each row not yet fully solved (see paint()), valid for the
+  // rows being solved during a render.
+  unsigned* unsolved;
+  unsigned unsolvedlen;       // rows allocated in unsolved
+  // rows [dmgbeg, dmgend) have been touched by some plane since the last
+  // render, and must be solved anew. if dmgall is set, every row must be
+  // solved anew (geometry changes, new piles, etc.). columns [solvedbegx,
+  // solvedendx) of rows [solvedbeg, solvedend) were solved by the last
+  // render, and await postpaint. only ncpile_render_region() solves less
+  // than entire rows.
+  unsigned dmgbeg, dmgend;
+  unsigned solvedbeg, solvedend;
+  unsigned solvedbegx, solvedendx;
+  bool dmgall;
+  // scratch rvec into which ncpile_render_region() solves its region
+  struct crender* rgnrender;
+  size_t rgnrenderlen;
+  // one span per row, describing where postpaint found damage. only valid
+  // from postpaint through rasterization, and only if spansvalid is set
+  // (sprixels can damage cells after postpaint, so they invalidate it).
+  // only rows [spanbeg, spanend) were postpainted; all others are empty.
+  struct dmgspan* dmgspans;
+  unsigned dmgspanslen;       // rows available in dmgspans
+  unsigned spanbeg, spanend;
+  bool spansvalid;
+  egcintern* interns;         // shared EGCs, if ncpile_intern_egcs() was called
+  // set while the pile is bound to an ncrasterizer, which keeps its own
+  // lastframe. such a pile is never rasterized against the terminal.
+  struct ncrasterizer* rasterizer;
+  // ncmirrors copying our terminal output elsewhere, linked through their
+  // ->next. guarded by pilelock.
+  struct ncmirror* mirrors;
+  // the frame as of the last ncpile_capture(), against which deltas are
+  // computed. EGCs are kept in their own pool, as with the lastframe.
+  nccell* capframe;
+  egcpool cappool;
+  unsigned capdimy, capdimx;
+  planeindex pindex;          // spatial index for ncpile_plane_at()
+  // ncpile_begin_update() nesting depth. while non-zero, moves and resize
+  // callbacks are recorded on the planes listed in txplanes (entries can be
+  // NULL, should a plane have been destroyed), and applied at commit.
+  unsigned txdepth;
+  ncplane** txplanes;
+  unsigned txplaneslen, txplanescap;
 } ncpile;
 
 // the standard pile can be reached through ->stdplane.
@@ -346,6 +657,18 @@ typedef struct notcurses {
   // invalidate the new pile's, pursuant to their display.
   ncpile* last_pile;
   egcpool pool;   // egcpool for lastframe
+  fbufpool fbpool; // recycled sprixel glyph buffers, shared across piles
+  auxpool auxpool; // recycled sprixcell auxiliary vectors, likewise
+  // destroyed planes retained for reuse, linked through ->above. guarded
+  // by pilelock. see ncplane_cache_put().
+  ncplane* planecache;
+  unsigned planecached; // planes on planecache
+  // planes destroyed with NCPLANE_DESTROY_DEFERRED, awaiting ncplane_reap().
+  // linked through ->above, and guarded by pilelock.
+  ncplane* planegrave;
+  // planes rooting cached layers. piles are only checked for layers when
+  // this is non-zero. atomic, since piles are rendered concurrently.
+  unsigned layers;
 
   unsigned lfdimx; // dimensions of lastframe, unchanged by screen resize
   unsigned lfdimy; // lfdimx/lfdimy are 0 until first rasterization
@@ -355,6 +678,8 @@ typedef struct notcurses {
 
   ncsharedstats stats;   // some statistics across the lifetime of the context
   ncstats stashed_stats; // retain across a context reset, for closing banner
+  nchistogram stashed_hists[NCSTATS_HIST_COUNT];
+  ncprofile profile;     // per-phase and per-plane render costs
 
   FILE* ttyfp;    // FILE* for writing rasterized data
   tinfo tcache;   // terminfo cache
@@ -367,6 +692,26 @@ typedef struct notcurses {
   bool palette_damage[NCPALETTESIZE];
   bool touched_palette; // have we ever changed a palette entry?
   uint64_t flags;  // copied from notcurses_options
+  // band-parallel painting helpers, NULL unless NCOPTION_THREADED_RENDER
+  // was provided (and we found more than one processor).
+  struct render_engine* rengine;
+  // writes out frames from ncpile_render_async(), created upon first use
+  struct raster_writer* rwriter;
+  // services every ncfdplane and ncsubproc, created upon first use
+  struct fd_reactor* fdreactor;
+  // advances effects registered with ncplane_animate(), created upon first use
+  struct ncanimator* animator;
+  // a nonzero framebudget (ns) bounds output latency: rasterization is
+  // deferred while the terminal is estimated to be further behind than it
+  // (see notcurses_set_frame_budget()). throttleuntil is when a slow blocking
+  // write is deemed to have drained. deferredpile was solved, but its
+  // rasterization deferred; it's cleared if the pile is destroyed.
+  uint64_t framebudget;
+  uint64_t throttleuntil;
+  // the square of the CIELAB distance within which an RGB color is taken to
+  // match the one already set (see notcurses_set_color_tolerance()), or 0.
+  float colortol2;
+  ncpile* deferredpile;
 } notcurses;
 
 typedef struct blitterargs {
@@ -417,10 +762,149 @@ struct blitset {
 void reset_stats(ncstats* stats);
 void summarize_stats(notcurses* nc);
 
-void update_raster_stats(const struct timespec* time1, const struct timespec* time0, ncstats* stats);
-void update_render_stats(const struct timespec* time1, const struct timespec* time0, ncstats* stats);
+void update_raster_stats(const struct timespec* time1, const struct timespec* time0, ncsharedstats* stats);
+void update_render_stats(const struct timespec* time1, const struct timespec* time0, ncsharedstats* stats);
 void update_raster_bytes(ncstats* stats, int bytes);
-void update_write_stats(const struct timespec* time1, const struct timespec* time0, ncstats* stats, int bytes);
+void update_write_stats(const struct timespec* time1, const struct timespec* time0, ncsharedstats* stats, int bytes);
+void nchistogram_record(nchistogram* h, uint64_t ns);
+void update_input_stats(ncsharedstats* stats, nchistogram* latencies);
+void update_taken_input_stats(ncsharedstats* stats, const ncinput* ni, int count);
+
+void update_render_band_stats(ncstats* stats, uint64_t bandns, int64_t bandmaxns);
+
+// when profiling, the current monotonic time in ns; otherwise 0.
+static inline uint64_t
+prof_clock(const notcurses* nc){
+  if(!nc->profile.enabled){
+    return 0;
+  }
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return timespec_to_ns(&ts);
+}
+
+// charge the time since |*t| (taken with prof_clock()) to |phase|, and
+// restart the clock. does nothing if |*t| is 0 (profiling was off).
+void prof_phase(notcurses* nc, profphase_e phase, uint64_t* t);
+
+// fold the costs of |n|, about to be destroyed, into the profile.
+void prof_retire_plane(notcurses* nc, const ncplane* n);
+
+void prof_free(ncprofile* prof);
+
+// number of processors available to us, always at least 1
+unsigned host_cpu_count(void);
+
+// called at the top of each library thread. names the calling thread
+// "nc-|role|", and applies the scheduling policy and processor affinity in
+// NOTCURSES_|ROLE|_SCHED and NOTCURSES_|ROLE|_CPUS, or failing those,
+// NOTCURSES_THREAD_SCHED and NOTCURSES_THREAD_CPUS. problems are logged,
+// never fatal.
+void nc_thread_setup(const char* role);
+
+// we never spin up more than this many render threads, no matter how many
+// processors are online.
+#define RENDER_ENGINE_MAXTHREADS 64
+
+struct render_engine;
+
+// applied by the render engine to each of |bands| bands of a job
+typedef void (*renderband_fxn)(void* curry, unsigned band, unsigned bands);
+
+// spin up a render engine sized to the host (or NOTCURSES_RENDER_THREADS).
+// returns NULL if only a single thread would be used.
+struct render_engine* render_engine_create(void);
+void render_engine_destroy(struct render_engine* re);
+
+// total threads (including the caller) which participate in a job. safe to
+// call with NULL, which returns 1.
+unsigned render_engine_threads(const struct render_engine* re);
+
+// apply |fxn| to each of |bands| bands across the engine's workers and the
+// calling thread, returning once all bands are complete. the longest band is
+// folded into |*maxns|, and the total band time added to |*sumns|. returns -1
+// without doing any work if the engine is already in use; the caller ought
+// then do the work itself.
+int render_engine_run(struct render_engine* re, unsigned bands, renderband_fxn fxn,
+                      void* curry, int64_t* maxns, uint64_t* sumns);
+
+// emit the glyph |g| of some sprixel into |f|. if |f| is the rasterstate's
+// buffer and we're splicing, a large glyph is referenced rather than copied;
+// it must then remain unmodified until the frame has been written. returns 0
+// on success, -1 on failure.
+API int raster_putglyph(notcurses* nc, fbuf* f, const fbuf* g);
+
+struct raster_writer;
+
+// spin up a thread which writes submitted frames to |fd|. returns NULL if
+// the thread (or its notification pipe) couldn't be created.
+struct raster_writer* raster_writer_create(int fd);
+
+// write out anything still pending, and join the writer. returns -1 if any
+// write failed without having been reported.
+int raster_writer_destroy(struct raster_writer* rw);
+
+// hand the contents of |f|, less its first |offset| bytes, to the writer.
+// |f| is reset (its buffer might be traded for an empty one of the writer's).
+// if the writer has yet to claim its last submission, the two are coalesced
+// into a single write. returns -1 if the output couldn't be queued, or if an
+// earlier write failed (each failure is reported once).
+int raster_writer_submit(struct raster_writer* rw, fbuf* f, size_t offset);
+
+// block until everything submitted has been written. safe to call with NULL.
+// raster_writer_drain() additionally returns (and clears) any write failure.
+void raster_writer_wait(struct raster_writer* rw);
+int raster_writer_drain(struct raster_writer* rw);
+
+// estimated nanoseconds until everything submitted has been written, based
+// on the writer's recent throughput. safe to call with NULL, returning 0.
+uint64_t raster_writer_backlog_ns(struct raster_writer* rw);
+
+// the writer's moving average of write cost per byte, 0 until measured.
+double raster_writer_nsperbyte(struct raster_writer* rw);
+
+// the measured cost per byte of writing to the terminal, preferring the
+// writer's figure when rasterizing asynchronously. 0 until measured.
+double notcurses_link_nsperbyte(struct notcurses* nc);
+
+// fold a write of |bytes| bytes taking |ns| nanoseconds into the moving
+// average |avg|, weighting the newest sample at 1/8 so that we track a
+// changing link.
+static inline void
+nsperbyte_update(double* avg, uint64_t ns, size_t bytes){
+  if(bytes == 0){
+    return;
+  }
+  const double sample = ns / (double)bytes;
+  if(*avg == 0){
+    *avg = sample;
+  }else{
+    *avg += (sample - *avg) / 8;
+  }
+}
+
+// a descriptor which is readable whenever the writer is idle, or -1.
+int raster_writer_fd(const struct raster_writer* rw);
+
+struct fd_reactor;
+
+// stop the thread servicing ncfdplanes and ncsubprocs, and close any fds it
+// was still reading (their owners never destroyed them). safe with NULL.
+int fd_reactor_destroy(struct fd_reactor* r);
+
+struct ncanimator;
+
+// drop any effects on |n|, which is being destroyed.
+void ncanimator_forget(struct ncanimator* a, const ncplane* n);
+
+// cancel the engine's timer and free it, along with any remaining effects.
+// safe with NULL.
+void ncanimator_destroy(notcurses* nc, struct ncanimator* a);
+
+// apply a fade level of |mult| (16.16 fixed point; 65536 restores the
+// original colors) to |n| from its snapshot in |nctx|, including the base
+// cell.
+int ncfadectx_apply(ncplane* n, const struct ncfadectx* nctx, uint32_t mult);
 
 void sigwinch_handler(int signo);
 
@@ -429,6 +913,15 @@ void init_lang(void);
 int reset_term_attributes(const tinfo* ti, fbuf* f);
 int reset_term_palette(const tinfo* ti, fbuf* f, unsigned touchedpalette);
 
+// complete an NCOPTION_ASYNC_INIT startup by waiting on the terminal's
+// replies, if that hasn't yet been done. call before using capabilities.
+int finish_async_init(notcurses* nc);
+
+static inline int
+settle_async_init(notcurses* nc){
+  return nc->tcache.interrogating ? finish_async_init(nc) : 0;
+}
+
 // if there were missing elements we wanted from terminfo, bitch about them here
 void warn_terminfo(const notcurses* nc, const tinfo* ti);
 
@@ -444,6 +937,111 @@ ncplane_pile_const(const ncplane* n){
   return n->pile;
 }
 
+#define RSPRIXIDX_UNKNOWN UINT16_MAX
+
+// the sprixel beneath the crender |r| at |y|/|x| of |p|, if any: the topmost
+// sprixel painted over that cell by the last render of |p|. cells of the
+// pile's own crender vector are looked up in rsprixidx; we only scan
+// rsprixels for crenders elsewhere, cells beyond the index's reach, and
+// cells whose sprixel has since been freed (looking beneath it).
+static inline sprixel*
+crender_sprixel(const ncpile* p, const struct crender* r, int y, int x){
+  if(!r->s.sprixeled){
+    return NULL;
+  }
+  unsigned first = 0;
+  if(y >= 0 && x >= 0 && (unsigned)y < p->dimy && (unsigned)x < p->dimx){
+    const size_t idx = (size_t)y * p->dimx + x;
+    if(idx < p->rsprixidxlen && idx < p->crenderlen && r == &p->crender[idx]){
+      const unsigned i = p->rsprixidx[idx];
+      if(i < p->rsprixelslen){
+        if(p->rsprixels[i]){
+          return p->rsprixels[i];
+        }
+        first = i + 1;
+      }
+    }
+  }
+  for(unsigned i = first ; i < p->rsprixelslen ; ++i){
+    sprixel* s = p->rsprixels[i];
+    const ncplane* n = s ? s->n : NULL;
+    if(n && y >= n->absy && y < n->absy + (int)s->dimy &&
+       x >= n->absx && x < n->absx + (int)s->dimx){
+      return s;
+    }
+  }
+  return NULL;
+}
+
+int ncplane_unshare(ncplane* n);
+
+// anything writing to |n|'s framebuffer or EGCpool must first call this, in
+// case they're shared with an ncplane_dup() copy. returns -1 if a private
+// copy was needed but couldn't be made, in which case |n| is unchanged.
+static inline int
+ncplane_own(ncplane* n){
+  return n->fbshare ? ncplane_unshare(n) : 0;
+}
+
+// rows [y, y + rows) of |n| (relative to its origin) have changed, and must
+// be solved anew at the next render of its pile. the damage is recorded in
+// absolute rows, so it survives the plane moving before the next render.
+static inline void
+ncplane_damage_rows(ncplane* n, int y, unsigned rows){
+  ++n->mods; // even if offscreen; cached layers compare it
+  ncpile* p = ncplane_pile(n);
+  if(p == NULL){ // ncdirect's fake plane
+    return;
+  }
+  int beg = n->absy + y;
+  int end = beg + (int)rows;
+  if(beg < 0){
+    beg = 0;
+  }
+  if(end > (int)p->dimy){
+    end = p->dimy;
+  }
+  if(beg >= end){
+    return;
+  }
+  if(p->dmgbeg >= p->dmgend){
+    p->dmgbeg = beg;
+    p->dmgend = end;
+  }else{
+    if((unsigned)beg < p->dmgbeg){
+      p->dmgbeg = beg;
+    }
+    if((unsigned)end > p->dmgend){
+      p->dmgend = end;
+    }
+  }
+}
+
+// the entirety of |n| has changed (or moved along the z-axis).
+static inline void
+ncplane_damage(ncplane* n){
+  ncplane_damage_rows(n, 0, n->leny);
+}
+
+// resolve 'gclusters' into 'bs' (see ncboxstyle_create()).
+int ncboxstyle_init(ncboxstyle* bs, const char* gclusters, uint16_t styles,
+                    uint64_t channels);
+
+// write the simple, single-column 'c' to the 'len' cells of row 'y' of 'n'
+// starting at column 'x', all of which must lie within the plane.
+int ncplane_box_span(ncplane* n, unsigned y, unsigned x, unsigned len,
+                     const nccell* c);
+
+// damage |n| and all planes bound to it, recursively.
+void ncplane_damage_family(ncplane* n);
+
+// release the cached layer rooted at |n|, if any.
+void ncplane_layer_free(ncplane* n);
+
+// |n| is leaving its family; any cached layers containing it must be
+// composited anew, lest a new plane reuse its address.
+void ncplane_layer_invalidate(ncplane* n);
+
 static inline ncplane*
 ncplane_stdplane(ncplane* n){
   return notcurses_stdplane(ncplane_notcurses(n));
@@ -490,6 +1088,44 @@ logical_to_virtual(const ncplane* n, int y){
 
 int clear_and_home(notcurses* nc, tinfo* ti, fbuf* f);
 
+// forget the pile bound to |r|, which is being destroyed.
+void rasterizer_unbind(struct ncrasterizer* r);
+
+// detach the mirrors of |p|, which is being destroyed. call with pilelock.
+void mirrors_unbind(ncpile* p);
+
+// release the frame retained by ncpile_capture().
+void ncpile_capture_free(ncpile* p);
+
+// bounds on ncpile_capture() buffers. the writer refuses to exceed them, so
+// the reader (which might be fed from a socket) can reject anything beyond
+// them before allocating.
+#define NCCAPTURE_DIM_MAX 16384u      // rows or columns
+#define NCCAPTURE_CELLS_MAX (1u << 22u)
+#define NCCAPTURE_EGC_MAX 1024u       // bytes of UTF-8 in one EGC
+
+void planeindex_free(planeindex* pi);
+
+// queue |s| for |p|'s remaining raster passes, if there's room (there always
+// is while rasterizing). entries queued at other times are dropped by the
+// next clean_sprixels(), which finds the sprixel anew.
+static inline void
+ncpile_queue_sprixel(ncpile* p, sprixel* s){
+  if(p && !s->queued && p->sprixworklen < p->sprixworkcap){
+    p->sprixwork[p->sprixworklen++] = s;
+    s->queued = true;
+  }
+}
+
+// the plane geometries or z-order of |p| have changed, so its planeindex
+// must be rebuilt before its next use. ncdirect's planes have no pile.
+static inline void
+ncpile_index_stale(ncpile* p){
+  if(p){
+    p->pindex.stale = true;
+  }
+}
+
 static inline int
 nfbcellidx(const ncplane* n, int row, int col){
   return fbcellidx(logical_to_virtual(n, row), n->lenx, col);
@@ -692,13 +1328,16 @@ void sprixel_hide(sprixel* s);
 
 // dimy and dimx are cell geometry, not pixel.
 sprixel* sprixel_alloc(ncplane* n, int dimy, int dimx);
-sprixel* sprixel_recycle(ncplane* n);
+// |leny| and |lenx| are the pixel geometry of the frame about to be blitted.
+sprixel* sprixel_recycle(ncplane* n, const blitterargs* bargs, int leny, int lenx);
 int sprite_clear_all(const tinfo* t, fbuf* f);
 // these three all use absolute coordinates
 void sprixel_invalidate(sprixel* s, int y, int x);
 void sprixel_movefrom(sprixel* s, int y, int x);
 void sprixel_debug(const sprixel* s, FILE* out);
 void sixelmap_free(struct sixelmap *s);
+// bytes allocated to |s| (which may be NULL).
+size_t sixelmap_bytes(const struct sixelmap* s);
 
 // update any necessary cells underneath the sprixel pursuant to its removal.
 // for sixel, this *achieves* the removal, and is performed on every cell.
@@ -769,7 +1408,7 @@ static inline void
 cleanup_tam(tament* tam, int ydim, int xdim){
   for(int y = 0 ; y < ydim ; ++y){
     for(int x = 0 ; x < xdim ; ++x){
-      free(tam[y * xdim + x].auxvector);
+      auxvec_put(tam[y * xdim + x].auxvector);
       tam[y * xdim + x].auxvector = NULL;
     }
   }
@@ -784,6 +1423,22 @@ destroy_tam(ncplane* p){
   }
 }
 
+// prepare a clean TAM of |rows|x|cols| for |p|'s new sprixel geometry. the
+// old TAM is reused if it's large enough (it's sized to the plane).
+static inline tament*
+reset_tam(ncplane* p, int rows, int cols){
+  if(p->tam){
+    cleanup_tam(p->tam, p->leny, p->lenx);
+    if(p->leny * p->lenx >= (unsigned)(rows * cols)){
+      memset(p->tam, 0, sizeof(*p->tam) * rows * cols);
+      return p->tam;
+    }
+    free(p->tam);
+    p->tam = NULL;
+  }
+  return create_tam(rows, cols);
+}
+
 static inline int
 sprite_rebuild(const notcurses* nc, sprixel* s, int ycell, int xcell){
   logdebug("rebuilding %d %d/%d", s->id, ycell, xcell);
@@ -796,12 +1451,17 @@ sprite_rebuild(const notcurses* nc, sprixel* s, int ycell, int xcell){
   }else if(s->n->tam[idx].state == SPRIXCELL_ANNIHILATED){
     uint8_t* auxvec = (uint8_t*)s->n->tam[idx].auxvector;
     assert(auxvec);
+    const bool moved = s->invalidated == SPRIXEL_MOVED;
     // sets the new state itself
     ret = nc->tcache.pixel_rebuild(s, ycell, xcell, auxvec);
     if(ret > 0){
-      free(auxvec);
+      auxvec_put(auxvec);
       s->n->tam[idx].auxvector = NULL;
     }
+    if(moved && s->invalidated != SPRIXEL_MOVED){
+      s->invalidated = SPRIXEL_MOVED;
+      s->movedinvalid = true;
+    }
   }else{
     return 0;
   }
@@ -891,8 +1551,11 @@ sprixel_state(const sprixel* s, int y, int x){
 
 static inline void
 pool_release(egcpool* pool, nccell* c){
-  if(cell_extended_p(c)){
+  if(cell_pooled_p(c)){
     egcpool_release(pool, cell_egc_idx(c));
+  }else if(cell_interned_p(c)){
+    egcintern_release(pool->interns, cell_egc_idx(c));
+    --pool->interned;
   }
   c->gcluster = 0; // don't subject ourselves to double-release problems
   c->width = 0;    // don't subject ourselves to geometric ambiguities
@@ -904,9 +1567,44 @@ set_gcluster_egc(nccell* c, int eoffset){
   c->gcluster = htole(0x01000000ul) + htole(eoffset);
 }
 
+// set the nccell 'c' to reference slot 'idx' of the pile's intern table
+static inline void
+set_gcluster_interned(nccell* c, int idx){
+  c->gcluster = htole(0x02000000ul) + htole(idx);
+}
+
+// spill the |ulen| bytes of |egc| out of 'c', into |pool|'s intern table if
+// it has one (falling back to the pool itself should the table be full).
+static inline int
+pool_stash_cell(egcpool* pool, nccell* c, const char* egc, size_t ulen){
+  if(pool->interns){
+    int idx = egcintern_acquire(pool->interns, egc, ulen);
+    if(idx >= 0){
+      ++pool->interned;
+      set_gcluster_interned(c, idx);
+      return 0;
+    }
+  }
+  int eoffset = egcpool_stash(pool, egc, ulen);
+  if(eoffset < 0){
+    return -1;
+  }
+  set_gcluster_egc(c, eoffset);
+  return 0;
+}
+
 // Duplicate one nccell onto another, possibly crossing ncplanes.
 static inline int
 cell_duplicate_far(egcpool* tpool, nccell* targ, const ncplane* splane, const nccell* c){
+  // within a pile sharing an intern table, we need only take a reference.
+  // take it before releasing 'targ', which might hold the last one.
+  if(cell_interned_p(c) && tpool->interns && tpool->interns == splane->pool.interns){
+    ++tpool->interns->slots[cell_egc_idx(c)].refs;
+    ++tpool->interned;
+    pool_release(tpool, targ);
+    *targ = *c;
+    return 0;
+  }
   pool_release(tpool, targ);
   targ->stylemask = c->stylemask;
   targ->channels = c->channels;
@@ -916,13 +1614,7 @@ cell_duplicate_far(egcpool* tpool, nccell* targ, const ncplane* splane, const nc
     return 0;
   }
   const char* egc = nccell_extended_gcluster(splane, c);
-  size_t ulen = strlen(egc);
-  int eoffset = egcpool_stash(tpool, egc, ulen);
-  if(eoffset < 0){
-    return -1;
-  }
-  set_gcluster_egc(targ, eoffset);
-  return 0;
+  return pool_stash_cell(tpool, targ, egc, strlen(egc));
 }
 
 int ncplane_resize_internal(ncplane* n, int keepy, int keepx,
@@ -930,6 +1622,70 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx,
                             int yoff, int xoff,
                             unsigned ylen, unsigned xlen);
 
+// rewrite |pool| densely, containing only those EGCs referenced by the |count|
+// cells of |fb| (and |extra|, if not NULL), and point the cells at their new
+// offsets. returns the bytes reclaimed, or -1 (leaving everything unchanged).
+int egcpool_compact(notcurses* nc, egcpool* pool, nccell* fb, size_t count,
+                    nccell* extra);
+
+// a run of contiguous cells, for operations over several such runs.
+typedef struct cellspan {
+  nccell* cells;
+  size_t count;
+} cellspan;
+
+// egcpool_compact() over the cells of |nspans| spans.
+int egcpool_compact_spans(notcurses* nc, egcpool* pool, const cellspan* spans,
+                          unsigned nspans);
+
+// scrollback history (see scrollback.c). scrollback_push() appends a row of
+// lenx cells (or a blank row, if |row| is NULL) to |n|'s history, taking over
+// its EGCs; the caller must then zero the row rather than releasing it.
+// returns -1 if |n| keeps no history (or on allocation failure), in which
+// case the caller still owns the row.
+int scrollback_push(ncplane* n, const nccell* row);
+// release all history, and with it the history's EGCs.
+void scrollback_free(ncplane* n);
+unsigned scrollback_count(const ncplane* n);
+// is history currently scrolled into view?
+bool scrollback_viewing_p(const ncplane* n);
+// the |idx|th line of history, 0 being the oldest. idx < scrollback_count().
+nccell* scrollback_row(const ncplane* n, unsigned idx);
+// bytes allocated to the history (excluding EGCs in the pool).
+size_t scrollback_bytes(const ncplane* n);
+// describe the history with at most scrollback_maxspans() spans.
+unsigned scrollback_maxspans(const ncplane* n);
+unsigned scrollback_spans(const ncplane* n, cellspan* spans);
+// the row displayed at |y| when |n| has history (which might be scrolled
+// back into view).
+const nccell* scrollback_visible_row(const ncplane* n, unsigned y);
+
+// sparse canvas (see canvas.c). to move or resize the view, reserve tiles
+// for its cells with canvas_reserve() (the only step which can fail), stow
+// them with canvas_stow(), and then canvas_load() the view at its new origin
+// (clamped to the canvas) into the zeroed framebuffer. canvas_fit() grows
+// the canvas to hold at least the specified geometry.
+int canvas_reserve(ncplane* n);
+void canvas_stow(ncplane* n);
+void canvas_load(ncplane* n, int y, int x);
+int canvas_fit(ncplane* n, unsigned rows, unsigned cols);
+// release all stored cells, and with them their EGCs.
+void canvas_free(ncplane* n);
+// bytes allocated to the canvas (excluding EGCs in the pool).
+size_t canvas_bytes(const ncplane* n);
+// describe the stored cells with at most canvas_maxspans() spans.
+unsigned canvas_maxspans(const ncplane* n);
+unsigned canvas_spans(const ncplane* n, cellspan* spans);
+
+// the cells displayed in row |y| of |n|.
+static inline const nccell*
+ncplane_visible_row(const ncplane* n, unsigned y){
+  if(n->history){
+    return scrollback_visible_row(n, y);
+  }
+  return &n->fb[nfbcellidx(n, y, 0)];
+}
+
 int update_term_dimensions(unsigned* rows, unsigned* cols, tinfo* tcache, int margin_b,
                            unsigned* cgeo_changed, unsigned* pgeo_changed)
   __attribute__ ((nonnull (3, 5, 6)));
@@ -943,9 +1699,11 @@ memdup(const void* src, size_t len){
   return ret;
 }
 
-ALLOC void* bgra_to_rgba(const void* data, int rows, int* rowstride, int cols, int alpha);
-ALLOC void* rgb_loose_to_rgba(const void* data, int rows, int* rowstride, int cols, int alpha);
-ALLOC void* rgb_packed_to_rgba(const void* data, int rows, int* rowstride, int cols, int alpha);
+// these convert into tightly-packed RGBA allocated from the calling thread's
+// arena (see arena.h), and thus last until the caller's arena_release().
+void* bgra_to_rgba(const void* data, int rows, int* rowstride, int cols, int alpha);
+void* rgb_loose_to_rgba(const void* data, int rows, int* rowstride, int cols, int alpha);
+void* rgb_packed_to_rgba(const void* data, int rows, int* rowstride, int cols, int alpha);
 
 // find the "center" cell of two lengths. in the case of even rows/columns, we
 // place the center on the top/left. in such a case there will be one more
@@ -1072,6 +1830,18 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n, const ncplane_options*
 
 void free_plane(ncplane* p);
 
+// the length of the run of 7-bit ASCII at the start of the |len| bytes at
+// |s|, examined 32 bytes at a time.
+size_t utf8_ascii_run(const unsigned char* s, size_t len);
+
+// the length of the longest prefix of the |len| bytes at |s| made up of
+// complete, valid UTF-8 characters (rejecting overlong forms, surrogates,
+// and anything beyond U+10FFFF). ASCII runs are skipped via utf8_ascii_run().
+size_t utf8_valid_prefix(const unsigned char* s, size_t len);
+
+// reclaim the memory of planes destroyed with NCPLANE_DESTROY_DEFERRED.
+void ncplane_reap(notcurses* nc);
+
 // heap-allocated formatted output
 ALLOC char* ncplane_vprintf_prep(const char* format, va_list ap);
 
@@ -1081,6 +1851,12 @@ int ncvisual_blit_internal(const struct ncvisual* ncv, int rows, int cols,
                            ncplane* n, const struct blitset* bset,
                            const blitterargs* bargs);
 
+// ncvisual_blit_internal(), but only output rows [dbeg, dend) of the 'rows' x
+// 'cols' scaling are produced, and blitted as if they were the entire output.
+int ncvisual_blit_rows(const struct ncvisual* ncv, int rows, int cols,
+                       int dbeg, int dend, ncplane* n,
+                       const struct blitset* bset, const blitterargs* bargs);
+
 // if fd < 0, blocking_write() is going to emit an EBADF, so we don't
 // bother checking it here explicitly.
 static inline int
@@ -1097,78 +1873,148 @@ tty_emit(const char* seq, int fd){
 
 int set_fd_nonblocking(int fd, unsigned state, unsigned* oldstate);
 
+// tiparm() expands into a static buffer, and ncrasterizers can run
+// concurrently with one another and with the terminal's rasterization.
+// parameterized escapes on the raster path are thus expanded (and copied
+// out) under tiparm_lock. unused trailing parameters are ignored.
+extern pthread_mutex_t tiparm_lock;
+
 static inline int
-term_bg_palindex(const notcurses* nc, fbuf* f, unsigned pal){
-  const char* setab = get_escape(&nc->tcache, ESCAPE_SETAB);
-  if(setab){
-    return fbuf_emit(f, tiparm(setab, pal));
+fbuf_emit_parm(fbuf* f, const char* esc, int p1, int p2, int p3, int p4){
+  pthread_mutex_lock(&tiparm_lock);
+  int ret = fbuf_emit(f, tiparm(esc, p1, p2, p3, p4));
+  pthread_mutex_unlock(&tiparm_lock);
+  return ret;
+}
+
+// emit setaf ('bg' false) or setab ('bg' true) for palette index 'pal',
+// using the expansion cached in the tinfo if we have one.
+static inline int
+term_emit_palindex(const tinfo* ti, fbuf* f, bool bg, unsigned pal){
+  if(pal < ti->palesccount){
+    return fbuf_emit(f, ti->palescs + ti->paloffs[bg][pal]);
+  }
+  const char* esc = get_escape(ti, bg ? ESCAPE_SETAB : ESCAPE_SETAF);
+  if(esc){
+    return fbuf_emit_parm(f, esc, pal, 0, 0, 0);
   }
   return 0;
 }
 
+static inline int
+term_bg_palindex(const notcurses* nc, fbuf* f, unsigned pal){
+  return term_emit_palindex(&nc->tcache, f, true, pal);
+}
+
 static inline int
 term_fg_palindex(const notcurses* nc, fbuf* f, unsigned pal){
-  const char* setaf = get_escape(&nc->tcache, ESCAPE_SETAF);
-  if(setaf){
-    return fbuf_emit(f, tiparm(setaf, pal));
-  }
-  return 0;
+  return term_emit_palindex(&nc->tcache, f, false, pal);
 }
 
 // check the current and target style bitmasks against the specified 'stylebit'.
-// if they are different, and we have the necessary capability, write the
-// applicable terminfo entry to 'out'. returns -1 only on a true error.
-static int
-term_setstyle(fbuf* f, unsigned cur, unsigned targ, unsigned stylebit,
-              const char* ton, const char* toff){
-  int ret = 0;
+// if they are different, and we have the necessary capability, append the
+// applicable terminfo entry to 'escs'.
+static inline void
+term_setstyle(const char** escs, unsigned* count, unsigned cur, unsigned targ,
+              unsigned stylebit, const char* ton, const char* toff){
   unsigned curon = cur & stylebit;
   unsigned targon = targ & stylebit;
   if(curon != targon){
-    if(targon){
-      if(ton){
-        ret = fbuf_emit(f, ton);
-      }
-    }else{
-      if(toff){ // how did this happen? we can turn it on, but not off?
-        ret = fbuf_emit(f, toff);
+    // toff might be missing: we can turn it on, but not off?
+    const char* esc = targon ? ton : toff;
+    if(esc){
+      escs[(*count)++] = esc;
+    }
+  }
+}
+
+// if 'esc' is a lone SGR (CSI, then only digits, ';' and ':', then 'm'),
+// return its parameters, writing their length to 'plen'. otherwise NULL.
+static inline const char*
+sgr_params(const char* esc, size_t* plen){
+  if(esc[0] != '\x1b' || esc[1] != '['){
+    return NULL;
+  }
+  const char* params = esc + 2;
+  size_t n = 0;
+  while((params[n] >= '0' && params[n] <= '9') || params[n] == ';' || params[n] == ':'){
+    ++n;
+  }
+  if(n == 0 || params[n] != 'm' || params[n + 1]){
+    return NULL;
+  }
+  *plen = n;
+  return params;
+}
+
+// write the 'count' style escapes of 'escs'. those which are lone SGRs are
+// merged into a single SGR, so that e.g. leaving bold for italic costs one
+// sequence rather than two. anything else is emitted as it stands.
+static inline int
+term_emit_styles(fbuf* f, const char** escs, unsigned count){
+  if(count == 1){
+    return fbuf_emit(f, escs[0]);
+  }
+  char sgr[64] = "\x1b[";
+  size_t used = 2;
+  for(unsigned i = 0 ; i < count ; ++i){
+    size_t plen;
+    const char* params = sgr_params(escs[i], &plen);
+    if(params && used + plen + 2 < sizeof(sgr)){
+      if(used > 2){
+        sgr[used++] = ';';
       }
+      memcpy(sgr + used, params, plen);
+      used += plen;
+    }else if(fbuf_emit(f, escs[i])){
+      return -1;
     }
   }
-  if(ret < 0){
-    return -1;
+  if(used > 2){
+    sgr[used++] = 'm';
+    if(fbuf_putn(f, sgr, used) < 0){
+      return -1;
+    }
   }
   return 0;
 }
 
 // emit escapes such that the current style is equal to newstyle. if this
 // required an sgr0 (which resets colors), normalized will be non-zero upon
-// a successful return.
+// a successful return. each style is turned on or off individually, so
+// colors are left alone.
 static inline int
 coerce_styles(fbuf* f, const tinfo* ti, uint16_t* curstyle,
               uint16_t newstyle, unsigned* normalized){
   *normalized = 0; // we never currently use sgr0
-  int ret = 0;
-  ret |= term_setstyle(f, *curstyle, newstyle, NCSTYLE_BOLD,
-                       get_escape(ti, ESCAPE_BOLD), get_escape(ti, ESCAPE_NOBOLD));
-  ret |= term_setstyle(f, *curstyle, newstyle, NCSTYLE_ITALIC,
-                       get_escape(ti, ESCAPE_SITM), get_escape(ti, ESCAPE_RITM));
-  ret |= term_setstyle(f, *curstyle, newstyle, NCSTYLE_STRUCK,
-                       get_escape(ti, ESCAPE_SMXX), get_escape(ti, ESCAPE_RMXX));
+  if(*curstyle == newstyle){
+    return 0;
+  }
+  const char* escs[4];
+  unsigned count = 0;
+  term_setstyle(escs, &count, *curstyle, newstyle, NCSTYLE_BOLD,
+                get_escape(ti, ESCAPE_BOLD), get_escape(ti, ESCAPE_NOBOLD));
+  term_setstyle(escs, &count, *curstyle, newstyle, NCSTYLE_ITALIC,
+                get_escape(ti, ESCAPE_SITM), get_escape(ti, ESCAPE_RITM));
+  term_setstyle(escs, &count, *curstyle, newstyle, NCSTYLE_STRUCK,
+                get_escape(ti, ESCAPE_SMXX), get_escape(ti, ESCAPE_RMXX));
   // underline and undercurl are exclusive. if we set one, don't go unsetting
   // the other.
   if(newstyle & NCSTYLE_UNDERLINE){ // turn on underline, or do nothing
-    ret |= term_setstyle(f, *curstyle, newstyle, NCSTYLE_UNDERLINE,
-                         get_escape(ti, ESCAPE_SMUL), get_escape(ti, ESCAPE_RMUL));
+    term_setstyle(escs, &count, *curstyle, newstyle, NCSTYLE_UNDERLINE,
+                  get_escape(ti, ESCAPE_SMUL), get_escape(ti, ESCAPE_RMUL));
   }else if(newstyle & NCSTYLE_UNDERCURL){ // turn on undercurl, or do nothing
-    ret |= term_setstyle(f, *curstyle, newstyle, NCSTYLE_UNDERCURL,
-                         get_escape(ti, ESCAPE_SMULX), get_escape(ti, ESCAPE_SMULNOX));
+    term_setstyle(escs, &count, *curstyle, newstyle, NCSTYLE_UNDERCURL,
+                  get_escape(ti, ESCAPE_SMULX), get_escape(ti, ESCAPE_SMULNOX));
   }else{ // turn off any underlining
-    ret |= term_setstyle(f, *curstyle, newstyle, NCSTYLE_UNDERCURL | NCSTYLE_UNDERLINE,
-                         NULL, get_escape(ti, ESCAPE_RMUL));
+    term_setstyle(escs, &count, *curstyle, newstyle, NCSTYLE_UNDERCURL | NCSTYLE_UNDERLINE,
+                  NULL, get_escape(ti, ESCAPE_RMUL));
   }
   *curstyle = newstyle;
-  return ret;
+  if(count == 0){
+    return 0;
+  }
+  return term_emit_styles(f, escs, count);
 }
 
 // DEC private mode set (DECSET) parameters (and corresponding XTerm resources)
@@ -1190,50 +2036,208 @@ coerce_styles(fbuf* f, const tinfo* ti, uint16_t* curstyle,
 #define SET_ALTERNATE_SCREEN  "1047" // replaces 47 (conflict w/DECGRPM) (titeInhibit)
 #define SET_SAVE_CURSOR       "1048" // save cursor ala DECSC (titeInhibit)
 #define SET_SMCUP             "1049" // 1047+1048 (titeInhibit)
+#define SET_BRACKETED_PASTE   "2004" // wrap pastes in CSI 200~/201~
 // DECSET/DECRSTs can be chained with semicolons; can we generalize this? FIXME
 #define DECSET(p) "\x1b[?" p "h"
 #define DECRST(p) "\x1b[?" p "l"
 
 int mouse_setup(tinfo* ti, unsigned eventmask);
 
+static inline unsigned
+decimal_len(unsigned n){
+  unsigned len = 1;
+  while(n >= 10){
+    n /= 10;
+    ++len;
+  }
+  return len;
+}
+
+static inline escape_e
+move_escape(move_e m){
+  switch(m){
+    case MOVE_CUP: return ESCAPE_CUP;
+    case MOVE_HPA: return ESCAPE_HPA;
+    case MOVE_VPA: return ESCAPE_VPA;
+    case MOVE_CUF: return ESCAPE_CUF;
+    case MOVE_CUB: return ESCAPE_CUB;
+    case MOVE_CUD: return ESCAPE_CUD;
+    case MOVE_CUU: return ESCAPE_CUU;
+    default: break;
+  }
+  return ESCAPE_MAX;
+}
+
+// the bytes needed to emit |m| with parameter |p| (an absolute coordinate for
+// cup/hpa/vpa, otherwise a distance), or UINT_MAX if it's unavailable. only
+// cup takes a second parameter |p2|. movelen was measured with single-digit
+// parameters; each additional digit costs a byte.
+static inline unsigned
+move_cost(const tinfo* ti, move_e m, int p, int p2){
+  if(ti->movelen[m] == 0){
+    return UINT_MAX;
+  }
+  unsigned cost = ti->movelen[m];
+  if(m <= MOVE_VPA){
+    cost += decimal_len(p + 1) - 1;
+    if(m == MOVE_CUP){
+      cost += decimal_len(p2 + 1) - 1;
+    }
+  }else{
+    cost += decimal_len(p) - 1;
+  }
+  return cost;
+}
+
+// emit the movement |m| (see move_cost() for the parameters). the ANSI forms
+// are written directly; anything else goes through tiparm().
+static inline int
+term_move(fbuf* f, const tinfo* ti, move_e m, int p, int p2){
+  const char final = ti->movefinal[m];
+  if(final == 0){
+    const char* esc = get_escape(ti, move_escape(m));
+    return fbuf_emit_parm(f, esc, p, p2, 0, 0);
+  }
+  if(fbuf_grow(f, 24)){ // CSI, two parameters of up to 10 digits, ';', final
+    return -1;
+  }
+  const int bias = m <= MOVE_VPA; // the %i of the absolute moves
+  char* s = f->buf + f->used;
+  *s++ = '\x1b';
+  *s++ = '[';
+  s += fbuf_digits(s, p + bias);
+  if(m == MOVE_CUP){
+    *s++ = ';';
+    s += fbuf_digits(s, p2 + bias);
+  }
+  *s++ = final;
+  f->used = s - f->buf;
+  return 0;
+}
+
+// the cheapest way to a location: a vertical move followed by a horizontal
+// one, either of which might be MOVE_MAX (none). a cup is a vertical MOVE_CUP
+// to |vp|/|hp|, with no horizontal move.
+typedef struct moveplan {
+  move_e v, h;
+  int vp, hp;
+  unsigned cost;
+} moveplan;
+
+// weigh the moves from our current location to |y|/|x| against one another
+// using the lengths of the terminal's actual escapes. cup is always possible,
+// and is all we'll use if we don't know where we are. if |forceabs| is set,
+// the horizontal move must be absolute. relative horizontal moves are also
+// ruled out when we've just written the last column, since the cursor is
+// then not actually where we'd take it to be, and when we might be wrong
+// about where we are (see xtrusted).
+static inline void
+plan_move(const notcurses* nc, int y, int x, bool forceabs, moveplan* mp){
+  const tinfo* ti = &nc->tcache;
+  const int ry = nc->rstate.y;
+  const int rx = nc->rstate.x;
+  mp->v = MOVE_CUP;
+  mp->vp = y;
+  mp->h = MOVE_MAX;
+  mp->hp = x;
+  mp->cost = move_cost(ti, MOVE_CUP, y, x);
+  if(ry < 0 || rx < 0){
+    return;
+  }
+  // if we might be wrong about x, we reestablish it even when merely
+  // changing rows.
+  const bool habs = forceabs || !nc->rstate.xtrusted;
+  move_e h = MOVE_MAX;
+  int hp = 0;
+  unsigned hcost = 0;
+  if(rx != x || habs){
+    h = MOVE_HPA;
+    hp = x;
+    hcost = move_cost(ti, MOVE_HPA, x, 0);
+    if(!habs && (unsigned)rx < ti->dimx){
+      const move_e rel = x > rx ? MOVE_CUF : MOVE_CUB;
+      const int dist = x > rx ? x - rx : rx - x;
+      const unsigned rcost = move_cost(ti, rel, dist, 0);
+      if(rcost < hcost){
+        h = rel;
+        hp = dist;
+        hcost = rcost;
+      }
+    }
+    if(hcost == UINT_MAX){
+      return;
+    }
+  }
+  move_e v = MOVE_MAX;
+  int vp = 0;
+  unsigned vcost = 0;
+  if(ry != y){
+    v = MOVE_VPA;
+    vp = y;
+    vcost = move_cost(ti, MOVE_VPA, y, 0);
+    const move_e rel = y > ry ? MOVE_CUD : MOVE_CUU;
+    const int dist = y > ry ? y - ry : ry - y;
+    const unsigned rcost = move_cost(ti, rel, dist, 0);
+    if(rcost < vcost){
+      v = rel;
+      vp = dist;
+      vcost = rcost;
+    }
+    if(vcost == UINT_MAX){
+      return;
+    }
+  }
+  if(vcost + hcost < mp->cost){
+    mp->v = v;
+    mp->vp = vp;
+    mp->h = h;
+    mp->hp = hp;
+    mp->cost = vcost + hcost;
+  }
+}
+
+// if we're moving from one plane to another, and the terminal might disagree
+// with us regarding glyph widths, we use an absolute horizontal move no matter
+// what (possibly even when we think we're already in place).
+static inline bool
+move_forces_absolute(const notcurses* nc, const ncplane* srcp){
+  return nc->rstate.lastsrcp != srcp && nc->tcache.gratuitous_hpa;
+}
+
 // sync the drawing position to the specified location with as little overhead
-// as possible (with nothing, if already at the right location). we prefer
-// absolute horizontal moves (hpa) to relative ones, in the rare event that
-// our understanding of our horizontal location is faulty. if we're moving from
-// one plane to another, we emit an hpa no matter what.
-// FIXME fall back to synthesized moves in the absence of capabilities (i.e.
-// textronix lacks cup; fake it with horiz+vert moves)
-// if hardcursorpos is non-zero, we always perform a cup. this is done when we
-// don't know where the cursor currently is =].
+// as possible (with nothing, if already at the right location), weighing up
+// cup, hpa, vpa, and relative moves (see plan_move()).
 static inline int
 goto_location(notcurses* nc, fbuf* f, int y, int x, const ncplane* srcp){
-//fprintf(stderr, "going to %d/%d from %d/%d hard: %u\n", y, x, nc->rstate.y, nc->rstate.x, nc->rstate.hardcursorpos);
-  int ret = 0;
-  // if we don't have hpa, force a cup even if we're only 1 char away. the only
-  // TERM i know supporting cup sans hpa is vt100, and vt100 can suck it.
-  // you can't use cuf for backwards moves anyway; again, vt100 can suck it.
-  const char* hpa = get_escape(&nc->tcache, ESCAPE_HPA);
-  if(nc->rstate.y == y && hpa){ // only need move x
-    if(nc->rstate.x == x){
-      if(nc->rstate.lastsrcp == srcp || !nc->tcache.gratuitous_hpa){
-        return 0; // needn't move shit
-      }
-      ++nc->stats.s.hpa_gratuitous;
+//fprintf(stderr, "going to %d/%d from %d/%d\n", y, x, nc->rstate.y, nc->rstate.x);
+  const bool forceabs = move_forces_absolute(nc, srcp);
+  if(nc->rstate.y == y && nc->rstate.x == x){
+    if(!forceabs){
+      return 0; // needn't move shit
     }
-    if(fbuf_emit(f, tiparm(hpa, x))){
+    ++nc->stats.s.hpa_gratuitous;
+  }
+  moveplan mp;
+  plan_move(nc, y, x, forceabs, &mp);
+  if(mp.v == MOVE_CUP){
+    if(term_move(f, &nc->tcache, MOVE_CUP, mp.vp, mp.hp)){
       return -1;
     }
   }else{
-    // cup is required, no need to verify existence
-    const char* cup = get_escape(&nc->tcache, ESCAPE_CUP);
-    if(fbuf_emit(f, tiparm(cup, y, x))){
+    if(mp.v != MOVE_MAX && term_move(f, &nc->tcache, mp.v, mp.vp, 0)){
+      return -1;
+    }
+    if(mp.h != MOVE_MAX && term_move(f, &nc->tcache, mp.h, mp.hp, 0)){
       return -1;
     }
   }
+  if(mp.v == MOVE_CUP || mp.h == MOVE_HPA){
+    nc->rstate.xtrusted = true;
+  }
   nc->rstate.x = x;
   nc->rstate.y = y;
   nc->rstate.lastsrcp = srcp;
-  return ret;
+  return 0;
 }
 
 // how many edges need touch a corner for it to be printed?
@@ -1287,9 +2291,6 @@ cell_set_blitquadrants(nccell* c, unsigned tl, unsigned tr, unsigned bl, unsigne
   c->channels = ((c->channels & ~NC_BLITTERSTACK_MASK) | newval);
 }
 
-// Destroy a plane and all its bound descendants.
-int ncplane_destroy_family(ncplane *ncp);
-
 // Extract the 32-bit background channel from a cell.
 static inline uint32_t
 cell_bchannel(const nccell* cl){
@@ -1465,12 +2466,8 @@ pool_blit_direct(egcpool* pool, nccell* c, const char* gcluster, int bytes, int
   if(bytes <= 4){
     c->gcluster = 0;
     memcpy(&c->gcluster, gcluster, bytes);
-  }else{
-    int eoffset = egcpool_stash(pool, gcluster, bytes);
-    if(eoffset < 0){
-      return -1;
-    }
-    set_gcluster_egc(c, eoffset);
+  }else if(pool_stash_cell(pool, c, gcluster, bytes)){
+    return -1;
   }
   return bytes;
 }
@@ -1514,6 +2511,12 @@ iswordbreak(wchar_t wchar){
 static inline int
 cellcmp_and_dupfar(egcpool* dampool, nccell* damcell,
                    const ncplane* srcplane, const nccell* srccell){
+  // bitwise-identical inline cells are certainly equal. this is a single
+  // 16-byte comparison, and covers the overwhelmingly common case of an
+  // unchanged cell without chasing either egcpool.
+  if(cell_simple_p(srccell) && memcmp(damcell, srccell, sizeof(*srccell)) == 0){
+    return 0;
+  }
   if(damcell->stylemask == srccell->stylemask){
     if(damcell->channels == srccell->channels){
       const char* srcegc = nccell_extended_gcluster(srcplane, srccell);
@@ -1693,10 +2696,18 @@ int term_fg_rgb8(const tinfo* ti, fbuf* f, unsigned r, unsigned g, unsigned b);
 
 const struct blitset* lookup_blitset(const tinfo* tcache, ncblitter_e setid, bool may_degrade);
 
+// the bitmask (index into 'egcs') of the glyph 'wc' in 'bset', or -1 if it's
+// not one of the blitset's glyphs. hashed; safe to call from any thread.
+int blitset_egc_mask(const struct blitset* bset, uint32_t wc);
+
 static inline int
 rgba_blit_dispatch(ncplane* nc, const struct blitset* bset,
                    int linesize, const void* data,
                    int leny, int lenx, const blitterargs* bargs){
+  if(ncplane_own(nc)){
+    return -1;
+  }
+  ncplane_damage(nc);
   return bset->blit(nc, linesize, data, leny, lenx, bargs);
 }
 
@@ -1725,73 +2736,92 @@ rgba_blitter(const struct tinfo* tcache, const struct ncvisual_options* opts) {
   return rgba_blitter_low(tcache, scale, maydegrade, opts ? opts->blitter : NCBLIT_DEFAULT);
 }
 
-// naive resize of |bmap| from |srows|x|scols| -> |drows|x|dcols|, suitable for
-// pixel art. we either select at a constant interval (for shrinking) or duplicate
-// at a constant ratio (for inflation). in the absence of a multimedia engine, this
-// is the only kind of resizing we support.
+// resize |bmap| from |srows|x|scols| -> |drows|x|dcols|. by default this is a
+// naive resize suitable for pixel art: we either select at a constant interval
+// (for shrinking) or duplicate at a constant ratio (for inflation). if |area|
+// is set, each pixel instead averages its footprint in the source (weighted by
+// alpha), which makes for much better thumbnails; inflated dimensions are
+// still duplicated. in the absence of a multimedia engine, these are the only
+// kinds of resizing we support. only destination rows [|dbeg|, |dend|) are
+// produced, so the result has |dend| - |dbeg| rows; they are exactly those rows
+// of the full resize. if |re| is not NULL, bands of rows are resized across
+// its workers.
+API uint32_t* resize_bitmap_rows(const uint32_t* bmap, int srows, int scols,
+                                 size_t sstride, int drows, int dcols,
+                                 size_t dstride, int dbeg, int dend, bool area,
+                                 struct render_engine* re);
+
 static inline uint32_t*
 resize_bitmap(const uint32_t* bmap, int srows, int scols, size_t sstride,
-              int drows, int dcols, size_t dstride){
-  if(sstride < scols * sizeof(*bmap)){
-    return NULL;
-  }
-  if(dstride < dcols * sizeof(*bmap)){
-    return NULL;
-  }
+              int drows, int dcols, size_t dstride, struct render_engine* re){
   // FIXME if parameters match current setup, do nothing, and return bmap
-  size_t size = drows * dstride;
-  uint32_t* ret = (uint32_t*)malloc(size);
-  if(ret == NULL){
-    return NULL;
-  }
-  float xrat = (float)dcols / scols;
-  float yrat = (float)drows / srows;
-  int dy = 0;
-  for(int y = 0 ; y < srows ; ++y){
-    float ytarg = (y + 1) * yrat;
-    if(ytarg > drows){
-      ytarg = drows;
-    }
-    while(ytarg > dy){
-      int dx = 0;
-      for(int x = 0 ; x < scols ; ++x){
-        float xtarg = (x + 1) * xrat;
-        if(xtarg > dcols){
-          xtarg = dcols;
-        }
-        while(xtarg > dx){
-          ret[dy * dstride / sizeof(*ret) + dx] = bmap[y * sstride / sizeof(*ret) + x];
-          ++dx;
-        }
-      }
-      ++dy;
-    }
-  }
-  return ret;
+  return resize_bitmap_rows(bmap, srows, scols, sstride, drows, dcols, dstride,
+                            0, drows, false, re);
 }
 
-// a neighbor on which to polyfill. by the time we get to it, it might or
-// might not have been filled in. if so, discard immediately. otherwise,
-// check self, and if valid, push all neighbors.
-struct topolyfill {
-  int y, x;
-  struct topolyfill* next;
-};
+static inline uint32_t*
+resize_bitmap_area(const uint32_t* bmap, int srows, int scols, size_t sstride,
+                   int drows, int dcols, size_t dstride, struct render_engine* re){
+  return resize_bitmap_rows(bmap, srows, scols, sstride, drows, dcols, dstride,
+                            0, drows, true, re);
+}
+
+// the render engine of |n|'s context, if it has one, to which work on behalf
+// of |n| can be farmed out.
+static inline struct render_engine*
+ncplane_render_engine(const ncplane* n){
+  return ncplane_pile(n) ? ncplane_notcurses_const(n)->rengine : NULL;
+}
+
+// the polyfills (ncplane_polyfill_yx() and ncvisual_polyfill_yx()) are
+// scanline span fills. each seed names a cell from which to fill its row left
+// and right; once a span is filled, one seed is pushed for each run of
+// fillable cells directly above and below it. by the time we get to a seed,
+// it might have been filled from another; if so, it's discarded.
+typedef struct polyfill_seed {
+  unsigned y, x;
+} polyfill_seed;
+
+// the seeds live in the thread's arena, from the mark taken at init.
+typedef struct polyfill_stack {
+  polyfill_seed* seeds;
+  unsigned used;
+  unsigned size;
+  arenamark mark;
+} polyfill_stack;
 
-static inline struct topolyfill*
-create_polyfill_op(int y, int x, struct topolyfill** stck){
-  // cast for the benefit of c++ callers
-  struct topolyfill* n = (struct topolyfill*)malloc(sizeof(*n));
-  if(n){
-    n->y = y;
-    n->x = x;
-    n->next = *stck;
-    *stck = n;
+static inline void
+polyfill_init(polyfill_stack* ps){
+  ps->seeds = NULL;
+  ps->used = ps->size = 0;
+  ps->mark = arena_mark();
+}
+
+static inline void
+polyfill_free(polyfill_stack* ps){
+  arena_release(ps->mark);
+}
+
+static inline int
+polyfill_push(polyfill_stack* ps, unsigned y, unsigned x){
+  if(ps->used == ps->size){
+    unsigned size = ps->size ? ps->size * 2 : 64;
+    // cast for the benefit of c++ callers
+    polyfill_seed* tmp = (polyfill_seed*)arena_grow(ps->seeds, sizeof(*tmp) * ps->size,
+                                                    sizeof(*tmp) * size);
+    if(tmp == NULL){
+      return -1;
+    }
+    ps->seeds = tmp;
+    ps->size = size;
   }
-  return n;
+  ps->seeds[ps->used].y = y;
+  ps->seeds[ps->used].x = x;
+  ++ps->used;
+  return 0;
 }
 
-// implemented by a multimedia backend (ffmpeg or oiio), and installed
+// implemented by a multimedia backend (ffmpeg, oiio, or native), and installed
 // prior to calling notcurses_core_init() (by notcurses_init()).
 typedef struct ncvisual_implementation {
   int (*visual_init)(int loglevel);
@@ -1799,20 +2829,36 @@ typedef struct ncvisual_implementation {
   int (*visual_blit)(const struct ncvisual* ncv, unsigned rows, unsigned cols,
                      ncplane* n, const struct blitset* bset, const blitterargs* barg);
   struct ncvisual* (*visual_create)(void);
-  struct ncvisual* (*visual_from_file)(const char* fname);
+  // the decoder may reduce the image, so long as it's at least minpixy by
+  // minpixx. ncvisual_from_file() supplies UINT_MAX for each.
+  struct ncvisual* (*visual_from_file)(const char* fname, unsigned minpixy,
+                                       unsigned minpixx);
   // ncv constructors other than ncvisual_from_file() need to set up the
   // AVFrame* 'frame' according to their own data, which is assumed to
   // have been prepared already in 'ncv'.
   void (*visual_details_seed)(struct ncvisual* ncv);
   int (*visual_decode)(struct ncvisual* nc);
   int (*visual_decode_loop)(struct ncvisual* nc);
+  // keep the frames of the next complete pass of a looping visual, and
+  // replay them from memory (see ncvisual_set_loopcache()). may be NULL.
+  int (*visual_loopcache)(struct ncvisual* nc, size_t maxbytes);
+  // see ncvisual_seek() and ncvisual_position(). may be NULL.
+  int (*visual_seek)(struct ncvisual* nc, uint64_t ns, uint64_t flags);
+  int (*visual_position)(const struct ncvisual* nc, uint64_t* ns);
   int (*visual_stream)(notcurses* nc, struct ncvisual* ncv, float timescale,
                        ncstreamcb streamer, const struct ncvisual_options* vopts, void* curry);
   ncplane* (*visual_subtitle)(ncplane* parent, const struct ncvisual* ncv);
+  // see ncvisual_subtitle_update(). may be NULL, in which case the plane is
+  // replaced from visual_subtitle() each time.
+  int (*visual_subtitle_update)(ncplane* parent, const struct ncvisual* ncv,
+                                ncplane** subp);
   int rowalign; // rowstride base, can be 0 for no padding
   // do a persistent resize, changing the ncv itself
   int (*visual_resize)(struct ncvisual* ncv, unsigned rows, unsigned cols);
   void (*visual_destroy)(struct ncvisual* ncv);
+  // open a file for piecewise reading by nctiled_from_file(), filling in
+  // 'src'. may be NULL if the engine can't read tiles.
+  int (*visual_tiles_open)(const char* fname, nctiled_source* src);
   bool canopen_images;
   bool canopen_videos;
 } ncvisual_implementation;
@@ -1852,7 +2898,7 @@ emit_scrolls(const tinfo* ti, int count, fbuf* f){
   if(count > 1){
     const char* indn = get_escape(ti, ESCAPE_INDN);
     if(indn){
-      if(fbuf_emit(f, tiparm(indn, count)) < 0){
+      if(fbuf_emit_parm(f, indn, count, 0, 0, 0) < 0){
         return -1;
       }
       return 0;
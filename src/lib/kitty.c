@@ -1,3 +1,5 @@
+#include <fcntl.h>
+#include <sys/mman.h>
 #include "internal.h"
 #include "base64.h"
 #ifdef USE_DEFLATE
@@ -6,6 +8,19 @@
 #include <zlib.h>
 #endif
 
+// upper bound on threads (including the calling thread) deflating a payload
+#define KITTY_MAXTHREADS 16
+
+// payloads are split into chunks of this many bytes to be deflated in parallel
+#define KITTY_DEFLATE_CHUNK (256u * 1024)
+
+// ceiling on the number of payloads sent uncompressed following a poor result
+#define KITTY_BACKOFF_MAX 32
+
+// payloads transmitted through shared memory or files, whose names we hold on
+// to in case the terminal never reads (and deletes) them
+#define KITTY_TRANSPORT_SLOTS 64
+
 // Kitty has its own bitmap graphics protocol, rather superior to DEC Sixel.
 // A header is written with various directives, followed by a number of
 // chunks. Each chunk carries up to 4096B of base64-encoded pixels. Bitmaps
@@ -205,8 +220,8 @@ init_sprixel_animation(sprixel* s){
   if(s->animating){
     return 0;
   }
-  fbuf_free(&s->glyph);
-  if(fbuf_init(&s->glyph)){
+  fbufpool_put(s->fpool, &s->glyph);
+  if(fbufpool_get(s->fpool, &s->glyph, 0)){
     return -1;
   }
   s->animating = true;
@@ -214,78 +229,83 @@ init_sprixel_animation(sprixel* s){
 }
 
 #define RGBA_MAXLEN 768 // 768 base64-encoded pixels in 4096 bytes
-// restore an annihilated sprixcell by copying the alpha values from the
-// auxiliary vector back into the actual data. we then free the auxvector.
-int kitty_rebuild(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
-  const int totalpixels = s->pixy * s->pixx;
+
+// find pixel |p| of a static kitty sprixel within its glyph, using the chunk
+// offsets recorded by write_kitty_data(). returns the 16-byte triplet holding
+// the pixel, setting |*skip| to the pixel's index within it, and |*pleft| to
+// the number of pixels from the start of the triplet to the end of its chunk.
+static inline char*
+kitty_locate(const sprixel* s, int p, int totalpixels, int* skip, int* pleft){
+  const int chunk = p / RGBA_MAXLEN;
+  const int pixoffset = p - chunk * RGBA_MAXLEN;
+  int inchunk = totalpixels - chunk * RGBA_MAXLEN;
+  if(inchunk > RGBA_MAXLEN){
+    inchunk = RGBA_MAXLEN;
+  }
+  // every 3 input pixels is 12 bytes (96 bits), an even 16 base64 bytes
+  const int triples = pixoffset / 3;
+  *skip = pixoffset - triples * 3;
+  *pleft = inchunk - triples * 3;
+  return (char*)s->glyph.buf + s->chunkoffs[chunk] + triples * 16;
+}
+
+// the area of cell |ycell|/|xcell| actually covered by the graphic. if the
+// cell is on the right or bottom borders, it might only be partially filled.
+static inline void
+kitty_cell_extent(const sprixel* s, int ycell, int xcell, int* targy, int* targx){
   const int xpixels = ncplane_pile(s->n)->cellpxx;
   const int ypixels = ncplane_pile(s->n)->cellpxy;
-  int targx = xpixels;
+  *targx = xpixels;
   if((xcell + 1) * xpixels > s->pixx){
-    targx = s->pixx - xcell * xpixels;
+    *targx = s->pixx - xcell * xpixels;
   }
-  int targy = ypixels;
+  *targy = ypixels;
   if((ycell + 1) * ypixels > s->pixy){
-    targy = s->pixy - ycell * ypixels;
+    *targy = s->pixy - ycell * ypixels;
   }
-  char* c = (char*)s->glyph.buf + s->parse_start;
-  int nextpixel = (s->pixx * ycell * ypixels) + (xpixels * xcell);
-  int thisrow = targx;
-  int chunkedhandled = 0;
-  sprixcell_e state = SPRIXCELL_OPAQUE_KITTY;
+}
+
+static inline bool
+kitty_indexed_p(const sprixel* s){
+  const int totalpixels = s->pixy * s->pixx;
   const int chunks = totalpixels / RGBA_MAXLEN + !!(totalpixels % RGBA_MAXLEN);
+  if(s->chunkoffs == NULL || s->chunkcount != chunks){
+    logerror("no chunk index for sprixel %u", s->id);
+    return false;
+  }
+  return true;
+}
+
+// restore an annihilated sprixcell by copying the alpha values from the
+// auxiliary vector back into the actual data. we then free the auxvector.
+int kitty_rebuild(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
+  if(!kitty_indexed_p(s)){
+    return -1;
+  }
+  const int totalpixels = s->pixy * s->pixx;
+  const int xpixels = ncplane_pile(s->n)->cellpxx;
+  const int ypixels = ncplane_pile(s->n)->cellpxy;
+  int targy, targx;
+  kitty_cell_extent(s, ycell, xcell, &targy, &targx);
+  sprixcell_e state = SPRIXCELL_OPAQUE_KITTY;
   int auxvecidx = 0;
-  while(targy && chunkedhandled < chunks){ // need to null out |targy| rows of |targx| pixels, track with |thisrow|
-    int inchunk = totalpixels - chunkedhandled * RGBA_MAXLEN;
-    if(inchunk > RGBA_MAXLEN){
-      inchunk = RGBA_MAXLEN;
-    }
-    const int curpixel = chunkedhandled * RGBA_MAXLEN;
-    // a full chunk is 4096 + 2 + 7 (5005)
-    while(nextpixel - curpixel < RGBA_MAXLEN && thisrow){
-      // our next pixel is within this chunk. find the pixel offset of the
-      // first pixel (within the chunk).
-      int pixoffset = nextpixel - curpixel;
-      int triples = pixoffset / 3;
-      int tripbytes = triples * 16;
-      int tripskip = pixoffset - triples * 3;
-      // we start within a 16-byte chunk |tripbytes| into the chunk. determine
-      // the number of bits.
-//fprintf(stderr, "pixoffset: %d next: %d tripbytes: %d tripskip: %d thisrow: %d\n", pixoffset, nextpixel, tripbytes, tripskip, thisrow);
-      // the maximum number of pixels we can convert is the minimum of the
-      // pixels remaining in the target row, and the pixels left in the chunk.
-//fprintf(stderr, "inchunk: %d total: %d triples: %d\n", inchunk, totalpixels, triples);
-      int chomped = kitty_restore(c + tripbytes, tripskip, thisrow,
-                                  inchunk - triples * 3, auxvec + auxvecidx,
-                                  &state);
-      assert(chomped >= 0);
+  for(int y = 0 ; y < targy ; ++y){
+    int p = (ycell * ypixels + y) * s->pixx + xcell * xpixels;
+    int thisrow = targx;
+    while(thisrow){
+      int skip, pleft;
+      char* triplet = kitty_locate(s, p, totalpixels, &skip, &pleft);
+      int chomped = kitty_restore(triplet, skip, thisrow, pleft,
+                                  auxvec + auxvecidx, &state);
+      assert(chomped > 0);
       auxvecidx += chomped;
       thisrow -= chomped;
-//fprintf(stderr, "POSTCHIMP CHOMP: %d pixoffset: %d next: %d tripbytes: %d tripskip: %d thisrow: %d\n", chomped, pixoffset, nextpixel, tripbytes, tripskip, thisrow);
-      if(thisrow == 0){
-//fprintf(stderr, "CLEARED ROW, TARGY: %d\n", targy - 1);
-        if(--targy == 0){
-          s->n->tam[s->dimx * ycell + xcell].state = state;
-          s->invalidated = SPRIXEL_INVALIDATED;
-          return 1;
-        }
-        thisrow = targx;
-//fprintf(stderr, "BUMP IT: %d %d %d %d\n", nextpixel, s->pixx, targx, chomped);
-        nextpixel += s->pixx - targx + chomped;
-      }else{
-        nextpixel += chomped;
-      }
-    }
-    c += RGBA_MAXLEN * 4 * 4 / 3; // 4bpp * 4/3 for base64, 4096b per chunk
-    c += 8; // new chunk header
-    ++chunkedhandled;
-//fprintf(stderr, "LOOKING NOW AT %u [%s]\n", c - s->glyph, c);
-    while(*c != ';'){
-      ++c;
+      p += chomped;
     }
-    ++c;
   }
-  return -1;
+  s->n->tam[s->dimx * ycell + xcell].state = state;
+  s->invalidated = SPRIXEL_INVALIDATED;
+  return 1;
 }
 
 // does this auxvec correspond to a sprixcell which was nulled out during the
@@ -309,11 +329,11 @@ kitty_anim_auxvec_blitsource_p(const sprixel* s, const uint8_t* auxvec){
 // whether the null write originated in blitting or wiping, as that affects
 // our rebuild animation.
 static inline void*
-kitty_anim_auxvec(int dimy, int dimx, int posy, int posx,
+kitty_anim_auxvec(auxpool* pool, int dimy, int dimx, int posy, int posx,
                   int cellpxy, int cellpxx, const uint32_t* data,
                   int rowstride, uint8_t* existing, uint32_t transcolor){
   const size_t slen = 4 * cellpxy * cellpxx + 1;
-  uint32_t* a = existing ? existing : malloc(slen);
+  uint32_t* a = existing ? existing : auxvec_get(pool, slen);
   if(a){
     for(int y = posy ; y < posy + cellpxy && y < dimy ; ++y){
       int pixels = cellpxx;
@@ -339,9 +359,10 @@ kitty_anim_auxvec(int dimy, int dimx, int posy, int posx,
   return a;
 }
 
-uint8_t* kitty_trans_auxvec(const ncpile* p){
+uint8_t* kitty_trans_auxvec(const sprixel* s){
+  const ncpile* p = ncplane_pile_const(s->n);
   const size_t slen = p->cellpxy * p->cellpxx;
-  uint8_t* a = malloc(slen);
+  uint8_t* a = auxvec_get(s->apool, slen);
   if(a){
     memset(a, 0, slen);
   }
@@ -354,6 +375,7 @@ static int
 kitty_blit_wipe_selfref(sprixel* s, fbuf* f, int ycell, int xcell){
   const int cellpxx = ncplane_pile(s->n)->cellpxx;
   const int cellpxy = ncplane_pile(s->n)->cellpxy;
+  s->framesedited = true;
   if(fbuf_printf(f, "\x1b_Ga=f,x=%d,y=%d,s=%d,v=%d,i=%d,X=1,r=2,c=1,q=2;",
                  xcell * cellpxx, ycell * cellpxy, cellpxx, cellpxy, s->id) < 0){
     return -1;
@@ -424,13 +446,38 @@ int kitty_wipe_selfref(sprixel* s, int ycell, int xcell){
   return 1;
 }
 
-sprixel* kitty_recycle(ncplane* n){
+// a graphic replaced by one of the same geometry can keep its id, and take
+// the new frame as edits to its root frame (see kitty_blit_reframe()), so
+// long as we know what that root frame holds: neither wipes nor rebuilds can
+// have touched it, and no cell can currently be annihilated. otherwise, the
+// old graphic is hidden, and a new one begun, which (if the terminal can
+// animate) keeps its frame for next time.
+sprixel* kitty_recycle(ncplane* n, const blitterargs* bargs, int leny, int lenx){
   assert(n->sprite);
   sprixel* hides = n->sprite;
+  if(hides->frame && !hides->framesedited && hides->invalidated != SPRIXEL_HIDE &&
+     hides->pxoffy == bargs->u.pixel.pxoffy && hides->pxoffx == bargs->u.pixel.pxoffx &&
+     hides->pixy == leny + hides->pxoffy && hides->pixx == lenx + hides->pxoffx){
+    unsigned i;
+    for(i = 0 ; i < hides->dimy * hides->dimx ; ++i){
+      if(n->tam[i].state >= SPRIXCELL_ANNIHILATED){
+        break;
+      }
+    }
+    if(i == hides->dimy * hides->dimx){
+      return hides;
+    }
+  }
   int dimy = hides->dimy;
   int dimx = hides->dimx;
   sprixel_hide(hides);
-  return sprixel_alloc(n, dimy, dimx);
+  sprixel* s = sprixel_alloc(n, dimy, dimx);
+  const ncpixelimpl_e level = ncplane_notcurses_const(n)->tcache.pixel_implementation;
+  if(s && ((level >= NCPIXEL_KITTY_ANIMATED && level <= NCPIXEL_KITTY_SELFREF) ||
+            level == NCPIXEL_KITTY_PLACEHOLDER)){
+    s->keepframe = true;
+  }
+  return s;
 }
 
 // for pre-animation kitty (NCPIXEL_KITTY_STATIC), we need a byte per pixel,
@@ -438,7 +485,7 @@ sprixel* kitty_recycle(ncplane* n){
 static inline uint8_t*
 kitty_auxiliary_vector(const sprixel* s){
   int pixels = ncplane_pile(s->n)->cellpxy * ncplane_pile(s->n)->cellpxx;
-  uint8_t* ret = malloc(sizeof(*ret) * pixels);
+  uint8_t* ret = auxvec_get(s->apool, sizeof(*ret) * pixels);
   if(ret){
     memset(ret, 0, sizeof(*ret) * pixels);
   }
@@ -447,6 +494,9 @@ kitty_auxiliary_vector(const sprixel* s){
 
 int kitty_wipe(sprixel* s, int ycell, int xcell){
 //fprintf(stderr, "NEW WIPE %d %d/%d\n", s->id, ycell, xcell);
+  if(!kitty_indexed_p(s)){
+    return -1;
+  }
   uint8_t* auxvec = kitty_auxiliary_vector(s);
   if(auxvec == NULL){
     return -1;
@@ -454,81 +504,28 @@ int kitty_wipe(sprixel* s, int ycell, int xcell){
   const int totalpixels = s->pixy * s->pixx;
   const int xpixels = ncplane_pile(s->n)->cellpxx;
   const int ypixels = ncplane_pile(s->n)->cellpxy;
-  // if the cell is on the right or bottom borders, it might only be partially
-  // filled by actual graphic data, and we need to cap our target area.
-  int targx = xpixels;
-  if((xcell + 1) * xpixels > s->pixx){
-    targx = s->pixx - xcell * xpixels;
-  }
-  int targy = ypixels;
-  if((ycell + 1) * ypixels > s->pixy){
-    targy = s->pixy - ycell * ypixels;
-  }
-  char* c = (char*)s->glyph.buf + s->parse_start;
-//fprintf(stderr, "TARGET AREA: %d x %d @ %dx%d of %d/%d (%d/%d) len %zu\n", targy, targx, ycell, xcell, s->dimy, s->dimx, s->pixy, s->pixx, strlen(c));
-  // every pixel was 4 source bytes, 32 bits, 6.33 base64 bytes. every 3 input pixels is
-  // 12 bytes (96 bits), an even 16 base64 bytes. there is chunking to worry about. there
-  // are up to 768 pixels in a chunk.
-  int nextpixel = (s->pixx * ycell * ypixels) + (xpixels * xcell);
-  int thisrow = targx;
-  int chunkedhandled = 0;
-  const int chunks = totalpixels / RGBA_MAXLEN + !!(totalpixels % RGBA_MAXLEN);
+  int targy, targx;
+  kitty_cell_extent(s, ycell, xcell, &targy, &targx);
+  // null out |targy| rows of |targx| pixels. a row might cross a chunk
+  // boundary, and in any case spans several triplets.
   int auxvecidx = 0;
-  while(targy && chunkedhandled < chunks){ // need to null out |targy| rows of |targx| pixels, track with |thisrow|
-//fprintf(stderr, "PLUCKING FROM [%s]\n", c);
-    int inchunk = totalpixels - chunkedhandled * RGBA_MAXLEN;
-    if(inchunk > RGBA_MAXLEN){
-      inchunk = RGBA_MAXLEN;
-    }
-    const int curpixel = chunkedhandled * RGBA_MAXLEN;
-    // a full chunk is 4096 + 2 + 7 (5005)
-    while(nextpixel - curpixel < RGBA_MAXLEN && thisrow){
-      // our next pixel is within this chunk. find the pixel offset of the
-      // first pixel (within the chunk).
-      int pixoffset = nextpixel - curpixel;
-      int triples = pixoffset / 3;
-      int tripbytes = triples * 16;
-      // we start within a 16-byte chunk |tripbytes| into the chunk. determine
-      // the number of bits.
-      int tripskip = pixoffset - triples * 3;
-//fprintf(stderr, "pixoffset: %d next: %d tripbytes: %d tripskip: %d thisrow: %d\n", pixoffset, nextpixel, tripbytes, tripskip, thisrow);
-      // the maximum number of pixels we can convert is the minimum of the
-      // pixels remaining in the target row, and the pixels left in the chunk.
-//fprintf(stderr, "inchunk: %d total: %d triples: %d\n", inchunk, totalpixels, triples);
-//fprintf(stderr, "PRECHOMP:  [%.16s]\n", c + tripbytes);
-      int chomped = kitty_null(c + tripbytes, tripskip, thisrow,
-                               inchunk - triples * 3, auxvec + auxvecidx);
-//fprintf(stderr, "POSTCHOMP: [%.16s]\n", c + tripbytes);
-      assert(chomped >= 0);
+  for(int y = 0 ; y < targy ; ++y){
+    int p = (ycell * ypixels + y) * s->pixx + xcell * xpixels;
+    int thisrow = targx;
+    while(thisrow){
+      int skip, pleft;
+      char* triplet = kitty_locate(s, p, totalpixels, &skip, &pleft);
+      int chomped = kitty_null(triplet, skip, thisrow, pleft, auxvec + auxvecidx);
+      assert(chomped > 0);
       auxvecidx += chomped;
       assert(auxvecidx <= ypixels * xpixels);
       thisrow -= chomped;
-//fprintf(stderr, "POSTCHIMP CHOMP: %d pixoffset: %d next: %d tripbytes: %d tripskip: %d thisrow: %d\n", chomped, pixoffset, nextpixel, tripbytes, tripskip, thisrow);
-      if(thisrow == 0){
-//fprintf(stderr, "CLEARED ROW, TARGY: %d\n", targy - 1);
-        if(--targy == 0){
-          s->n->tam[s->dimx * ycell + xcell].auxvector = auxvec;
-          s->invalidated = SPRIXEL_INVALIDATED;
-          return 1;
-        }
-        thisrow = targx;
-//fprintf(stderr, "BUMP IT: %d %d %d %d\n", nextpixel, s->pixx, targx, chomped);
-        nextpixel += s->pixx - targx + chomped;
-      }else{
-        nextpixel += chomped;
-      }
-    }
-    c += RGBA_MAXLEN * 4 * 4 / 3; // 4bpp * 4/3 for base64, 4096b per chunk
-    c += 8; // new chunk header
-    ++chunkedhandled;
-//fprintf(stderr, "LOOKING NOW AT %u [%s]\n", c - s->glyph, c);
-    while(*c != ';'){
-      ++c;
+      p += chomped;
     }
-    ++c;
   }
-  free(auxvec);
-  return -1;
+  s->n->tam[s->dimx * ycell + xcell].auxvector = auxvec;
+  s->invalidated = SPRIXEL_INVALIDATED;
+  return 1;
 }
 
 int kitty_commit(fbuf* f, sprixel* s, unsigned noscroll){
@@ -547,130 +544,680 @@ int kitty_commit(fbuf* f, sprixel* s, unsigned noscroll){
   return 0;
 }
 
+// a virtual placement (U=1) of |c|x|r| cells, displayed wherever our cells
+// hold its placeholders. direct mode (which forces scrolling, see
+// sprite_commit()) has no cells of ours to carry them, and places for real.
+int kitty_commit_placeholder(fbuf* f, sprixel* s, unsigned noscroll){
+  if(!noscroll){
+    return kitty_commit(f, s, noscroll);
+  }
+  loginfo("committing Kitty placeholder graphic id %u", s->id);
+  if(fbuf_printf(f, "\e_Ga=p,U=1,i=%u,p=1,c=%u,r=%u,q=2\e\\", s->id,
+                 s->dimx, s->dimy) < 0){
+    return -1;
+  }
+  s->invalidated = SPRIXEL_QUIESCENT;
+  return 0;
+}
+
 // chunkify and write the collected buffer in the animated case. this might
 // or might not be compressed (depends on whether compression was useful).
+// the whole transmission is sized up front, and encoded directly into |f|.
 static int
 encode_and_chunkify(fbuf* f, const unsigned char* buf, size_t blen, unsigned compressed){
+  const size_t chunkraw = 4096 * 3 / 4;
+  const size_t chunks = blen > chunkraw ? (blen + chunkraw - 1) / chunkraw : 1;
+  // ",q=2" ",o=z" ",m=1" ";", the encoded payload, and for each chunk a
+  // continuation header (unused by the first) and ST.
+  const size_t total = 13 + (blen + 2) / 3 * 4 + chunks * 9;
+  if(fbuf_grow(f, total)){
+    return -1;
+  }
+  char* w = f->buf + f->used;
   // need to terminate the header, requiring semicolon
+  memcpy(w, ",q=2", 4);
+  w += 4;
   if(compressed){
-    if(fbuf_putn(f, ",o=z", 4) < 0){
+    memcpy(w, ",o=z", 4);
+    w += 4;
+  }
+  if(chunks > 1){
+    memcpy(w, ",m=1", 4);
+    w += 4;
+  }
+  *w++ = ';';
+  size_t i = 0;
+  for(size_t c = 0 ; c < chunks ; ++c){
+    if(c){
+      memcpy(w, c + 1 == chunks ? "\x1b_Gm=0;" : "\x1b_Gm=1;", 7);
+      w += 7;
+    }
+    const size_t len = blen - i > chunkraw ? chunkraw : blen - i;
+    // only the final chunk can have a partial triple
+    const size_t whole = len - len % 3;
+    base64_encode(buf + i, whole, w);
+    w += whole / 3 * 4;
+    if(len % 3){
+      base64final(buf + i + whole, w, len % 3);
+      w += 4;
+    }
+    i += len;
+    memcpy(w, "\x1b\\", 2);
+    w += 2;
+  }
+  f->used = w - f->buf;
+  return 0;
+}
+
+// payloads are compressed with a kitty_deflater: a compressor context plus
+// scratch space for its output. deflaters are checked out of the kitty_engine
+// for the duration of a single payload, and returned afterwards, so each
+// thread blitting concurrently ends up with its own, and none of them are
+// rebuilt per bitmap. they're reaped in kitty_cleanup().
+typedef struct kitty_deflater {
+  struct kitty_deflater* next; // on the engine's idle list
+#ifdef USE_DEFLATE
+  struct libdeflate_compressor* cmp;
+#else
+  z_stream zctx;        // raw deflate; we write the zlib framing ourselves
+  size_t* clens;        // per-chunk results of a kitty_djob, retained
+  uLong* adlers;
+  unsigned chunkalloc;  // entries allocated in clens and adlers
+#endif
+  unsigned char* cbuf;  // compressed output, retained across payloads
+  size_t cbufsize;
+} kitty_deflater;
+
+#ifndef USE_DEFLATE
+// zlib builds can split large payloads into chunks, compressed in parallel
+// by the engine's workers alongside the submitting thread, in the manner of
+// pigz: each chunk is primed with the 32KiB preceding it, and all but the
+// last end in a sync flush, so that their concatenation is one raw deflate
+// stream. libdeflate can only emit complete (final) streams, so libdeflate
+// builds always compress serially.
+typedef struct kitty_djob {
+  const unsigned char* in;
+  size_t inlen;
+  size_t chunksize;      // bytes of input per chunk (the last might be short)
+  unsigned char* out;    // chunk c is written at out + c * cbound
+  size_t cbound;         // room for each chunk's output
+  unsigned chunks;
+  unsigned claimed;      // chunks handed out so far
+  unsigned refcount;     // workers currently compressing a chunk
+  bool failed;
+  size_t* clens;         // compressed length of each chunk
+  uLong* adlers;         // adler-32 of each chunk's input
+} kitty_djob;
+#endif
+
+typedef struct kitty_engine {
+  pthread_mutex_t lock;  // guards everything below
+  kitty_deflater* idle;  // deflaters not currently checked out
+  // after a payload deflates poorly, the next |backoff| payloads are sent
+  // uncompressed, and each further poor result doubles the backoff.
+  unsigned backoff;
+  unsigned skip;         // payloads remaining to be sent uncompressed
+  uint64_t deflated;     // payloads which were worth deflating
+  uint64_t vain;         // payloads which deflated poorly
+  uint64_t skipped;      // payloads we didn't attempt to deflate
+  kittytransport_e transport;
+  // shared memory objects and files are named in a ring of slots. kitty
+  // deletes them once read; if one is yet around when its slot comes up
+  // again (say, its sprixel was destroyed without ever being drawn), we
+  // delete it ourselves.
+  struct {
+    char* name;
+    kittytransport_e transport;
+  } tslots[KITTY_TRANSPORT_SLOTS];
+  unsigned tnext;        // next slot to use
+  unsigned nonce;        // distinguishes our names from another context's
+#ifndef USE_DEFLATE
+  pthread_cond_t cond;
+  kitty_djob* job;       // the chunked job being worked, if any
+  pthread_t* tids;
+  unsigned workers;      // worker threads, not counting the caller
+  bool done;
+#endif
+} kitty_engine;
+
+static void
+deflater_free(kitty_deflater* d){
+  if(d){
+#ifdef USE_DEFLATE
+    libdeflate_free_compressor(d->cmp);
+#else
+    deflateEnd(&d->zctx);
+    free(d->clens);
+    free(d->adlers);
+#endif
+    free(d->cbuf);
+    free(d);
+  }
+}
+
+static kitty_deflater*
+deflater_create(void){
+  kitty_deflater* d = malloc(sizeof(*d));
+  if(d == NULL){
+    return NULL;
+  }
+  memset(d, 0, sizeof(*d));
+  // 2 has been shown to work pretty well for things that are actually going
+  // to compress; results per unit time fall off quickly after 2.
+#ifdef USE_DEFLATE
+  if((d->cmp = libdeflate_alloc_compressor(2)) == NULL){
+    logerror("couldn't get libdeflate context");
+    free(d);
+    return NULL;
+  }
+#else
+  if(deflateInit2(&d->zctx, 2, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK){
+    logerror("couldn't get zlib context");
+    free(d);
+    return NULL;
+  }
+#endif
+  return d;
+}
+
+// ensure |d| has at least |len| bytes of scratch
+static int
+deflater_reserve(kitty_deflater* d, size_t len){
+  if(d->cbufsize < len){
+    unsigned char* tmp = realloc(d->cbuf, len);
+    if(tmp == NULL){
+      logerror("couldn't allocate %" PRIuPTR "B", len);
       return -1;
     }
+    d->cbuf = tmp;
+    d->cbufsize = len;
   }
-  if(blen > 4096 * 3 / 4){
-    if(fbuf_putn(f, ",m=1", 4) < 0){
+  return 0;
+}
+
+#ifndef USE_DEFLATE
+// ensure |d| has room for the results of |chunks| chunks
+static int
+deflater_reserve_chunks(kitty_deflater* d, unsigned chunks){
+  if(d->chunkalloc < chunks){
+    size_t* clens = realloc(d->clens, sizeof(*clens) * chunks);
+    if(clens == NULL){
+      return -1;
+    }
+    d->clens = clens;
+    uLong* adlers = realloc(d->adlers, sizeof(*adlers) * chunks);
+    if(adlers == NULL){
       return -1;
     }
+    d->adlers = adlers;
+    d->chunkalloc = chunks;
   }
-  if(fbuf_putc(f, ';') < 0){
-    return -1;
+  return 0;
+}
+#endif
+
+// check out a deflater from |eng|, creating one if none are idle. without an
+// engine, the deflater lives only as long as the payload.
+static kitty_deflater*
+deflater_get(kitty_engine* eng){
+  if(eng){
+    pthread_mutex_lock(&eng->lock);
+    kitty_deflater* d = eng->idle;
+    if(d){
+      eng->idle = d->next;
+    }
+    pthread_mutex_unlock(&eng->lock);
+    if(d){
+      return d;
+    }
   }
-  bool first = true;
-  unsigned long i = 0;
-  char b64d[4];
-  while(blen - i > 4096 * 3 / 4){
-    if(!first){
-      if(fbuf_putn(f, "\x1b_Gm=1;", 7) < 0){
-        return -1;
-      }
+  return deflater_create();
+}
+
+static void
+deflater_put(kitty_engine* eng, kitty_deflater* d){
+  if(eng == NULL){
+    deflater_free(d);
+    return;
+  }
+  pthread_mutex_lock(&eng->lock);
+  d->next = eng->idle;
+  eng->idle = d;
+  pthread_mutex_unlock(&eng->lock);
+}
+
+// ought we not even try to deflate this payload?
+static bool
+deflate_skip_p(kitty_engine* eng){
+  bool ret = false;
+  if(eng){
+    pthread_mutex_lock(&eng->lock);
+    if(eng->skip){
+      --eng->skip;
+      ++eng->skipped;
+      ret = true;
     }
-    unsigned long max = i + 4096 * 3 / 4;
-    while(i < max){
-      base64x3(buf + i, b64d);
-      if(fbuf_putn(f, b64d, 4) < 0){
-        return -1;
-      }
-      i += 3;
+    pthread_mutex_unlock(&eng->lock);
+  }
+  return ret;
+}
+
+// record the result of deflating |blen| bytes to |clen| (0 if it didn't fit).
+// saving less than a sixteenth isn't worth the time spent compressing, nor
+// the decompression on the terminal's end.
+static void
+deflate_record(kitty_engine* eng, size_t blen, size_t clen){
+  if(eng == NULL){
+    return;
+  }
+  pthread_mutex_lock(&eng->lock);
+  if(clen == 0 || clen > blen - blen / 16){
+    ++eng->vain;
+    if(eng->backoff == 0){
+      eng->backoff = 1;
+    }else if(eng->backoff < KITTY_BACKOFF_MAX){
+      eng->backoff *= 2;
     }
-    first = false;
-    if(fbuf_putn(f, "\x1b\\", 2) < 0){
+    eng->skip = eng->backoff;
+  }else{
+    ++eng->deflated;
+    eng->backoff = 0;
+  }
+  pthread_mutex_unlock(&eng->lock);
+}
+
+#ifndef USE_DEFLATE
+// compress chunk |c| of |j| using |d|
+static int
+deflate_chunk(kitty_deflater* d, kitty_djob* j, unsigned c){
+  const size_t off = (size_t)c * j->chunksize;
+  size_t len = j->inlen - off;
+  if(len > j->chunksize){
+    len = j->chunksize;
+  }
+  if(deflateReset(&d->zctx) != Z_OK){
+    return -1;
+  }
+  if(off){
+    const size_t dlen = off < 32768 ? off : 32768;
+    if(deflateSetDictionary(&d->zctx, j->in + off - dlen, dlen) != Z_OK){
       return -1;
     }
   }
-  if(!first){
-    if(fbuf_putn(f, "\x1b_Gm=0;", 7) < 0){
-      return -1;
+  d->zctx.next_in = (Bytef*)j->in + off;
+  d->zctx.avail_in = len;
+  d->zctx.next_out = j->out + (size_t)c * j->cbound;
+  d->zctx.avail_out = j->cbound;
+  const bool last = c + 1 == j->chunks;
+  int z = deflate(&d->zctx, last ? Z_FINISH : Z_SYNC_FLUSH);
+  // a sync flush which exhausts the output space might yet have more to say
+  if(last ? z != Z_STREAM_END : (z != Z_OK || d->zctx.avail_out == 0)){
+    logerror("error %d deflating chunk %u/%u", z, c, j->chunks);
+    return -1;
+  }
+  j->clens[c] = j->cbound - d->zctx.avail_out;
+  j->adlers[c] = adler32(adler32(0, NULL, 0), j->in + off, len);
+  return 0;
+}
+
+// claim the next chunk of |j|, or return -1 if they've all been handed out.
+// call with the engine lock held if |j| has been published to the workers.
+static int
+claim_chunk(kitty_djob* j){
+  if(j->claimed == j->chunks || j->failed){
+    return -1;
+  }
+  return j->claimed++;
+}
+
+// a compression worker. help out with the current job, if there is one.
+static void*
+kitty_worker(void* v){
+  kitty_engine* eng = v;
+  nc_thread_setup("kitty");
+  // the submitting thread works every job it publishes, so an idle worker
+  // without a deflater merely makes no progress.
+  kitty_deflater* d = deflater_create();
+  pthread_mutex_lock(&eng->lock);
+  while(!eng->done){
+    kitty_djob* j = eng->job;
+    int c;
+    if(d == NULL || j == NULL || (c = claim_chunk(j)) < 0){
+      pthread_cond_wait(&eng->cond, &eng->lock);
+      continue;
+    }
+    ++j->refcount;
+    pthread_mutex_unlock(&eng->lock);
+    int r = deflate_chunk(d, j, c);
+    pthread_mutex_lock(&eng->lock);
+    if(r){
+      j->failed = true;
+    }
+    if(--j->refcount == 0){
+      pthread_cond_broadcast(&eng->cond);
     }
   }
-  while(i < blen){
-    if(blen - i < 3){
-      base64final(buf + i, b64d, blen - i);
-      if(fbuf_putn(f, b64d, 4) < 0){
-        return -1;
-      }
-      i += blen - i;
+  pthread_mutex_unlock(&eng->lock);
+  deflater_free(d);
+  return NULL;
+}
+
+// deflate |blen| bytes at |buf| into a zlib stream in |d|'s scratch. returns
+// the compressed length, 0 if it would be no smaller than |buf|, or -1 on
+// error. large payloads are split up among the engine's workers.
+static ssize_t
+zlib_compress(kitty_engine* eng, kitty_deflater* d, const void* buf, size_t blen){
+  kitty_djob j = {
+    .in = buf,
+    .inlen = blen,
+    .chunks = (blen + KITTY_DEFLATE_CHUNK - 1) / KITTY_DEFLATE_CHUNK,
+  };
+  bool parallel = eng && eng->workers && j.chunks > 1;
+  // a single chunk gets the whole payload (and is never sync flushed)
+  if(!parallel){
+    j.chunks = 1;
+  }
+  j.chunksize = j.chunks > 1 ? KITTY_DEFLATE_CHUNK : blen;
+  // 5 bytes for the empty stored block of a sync flush, and a bit of slop
+  j.cbound = deflateBound(&d->zctx, j.chunksize) + 8;
+  // two bytes of zlib header precede the chunks, and four of adler-32
+  // follow them once they've been compacted.
+  if(deflater_reserve(d, 2 + j.chunks * j.cbound + 4) ||
+     deflater_reserve_chunks(d, j.chunks)){
+    return -1;
+  }
+  size_t* clens = d->clens;
+  uLong* adlers = d->adlers;
+  j.clens = clens;
+  j.adlers = adlers;
+  j.out = d->cbuf + 2;
+  if(parallel){
+    pthread_mutex_lock(&eng->lock);
+    if(eng->job){ // someone else is using the workers; go it alone
+      parallel = false;
     }else{
-      base64x3(buf + i, b64d);
-      if(fbuf_putn(f, b64d, 4) < 0){
-        return -1;
+      eng->job = &j;
+    }
+    pthread_mutex_unlock(&eng->lock);
+    if(parallel){
+      pthread_cond_broadcast(&eng->cond);
+    }
+  }
+  for(;;){
+    int c;
+    if(parallel){
+      pthread_mutex_lock(&eng->lock);
+      c = claim_chunk(&j);
+      pthread_mutex_unlock(&eng->lock);
+    }else{
+      c = claim_chunk(&j);
+    }
+    if(c < 0){
+      break;
+    }
+    if(deflate_chunk(d, &j, c)){
+      if(parallel){
+        pthread_mutex_lock(&eng->lock);
+      }
+      j.failed = true;
+      if(parallel){
+        pthread_mutex_unlock(&eng->lock);
       }
-      i += 3;
     }
   }
-  if(fbuf_putn(f, "\x1b\\", 2) < 0){
+  if(parallel){
+    pthread_mutex_lock(&eng->lock);
+    while(j.refcount){
+      pthread_cond_wait(&eng->cond, &eng->lock);
+    }
+    eng->job = NULL;
+    pthread_mutex_unlock(&eng->lock);
+  }
+  if(j.failed){
     return -1;
   }
-  return 0;
+  // level 2 is FLEVEL 1 ("fast"); FCHECK makes the header a multiple of 31
+  d->cbuf[0] = 0x78;
+  d->cbuf[1] = 0x5e;
+  size_t clen = 2 + clens[0];
+  uLong adler = adlers[0];
+  for(unsigned c = 1 ; c < j.chunks ; ++c){
+    memmove(d->cbuf + clen, j.out + c * j.cbound, clens[c]);
+    clen += clens[c];
+    const size_t off = (size_t)c * j.chunksize;
+    const size_t len = blen - off > j.chunksize ? j.chunksize : blen - off;
+    adler = adler32_combine(adler, adlers[c], len);
+  }
+  d->cbuf[clen++] = adler >> 24u;
+  d->cbuf[clen++] = (adler >> 16u) & 0xff;
+  d->cbuf[clen++] = (adler >> 8u) & 0xff;
+  d->cbuf[clen++] = adler & 0xff;
+  if(clen >= blen){
+    return 0;
+  }
+  if(parallel){
+    loginfo("deflated %u chunks in parallel", j.chunks);
+  }
+  return clen;
 }
+#endif
 
 static int
-deflate_buf(void* buf, fbuf* f, int dimy, int dimx){
+deflate_buf(kitty_engine* eng, void* buf, fbuf* f, int dimy, int dimx){
   const size_t blen = dimx * dimy * 4;
-  void* cbuf = NULL;
-  size_t clen = 0;
-#ifdef USE_DEFLATE
-  // 2 has been shown to work pretty well for things that are actually going
-  // to compress; results per unit time fall off quickly after 2.
-  struct libdeflate_compressor* cmp = libdeflate_alloc_compressor(2);
-  if(cmp == NULL){
-    logerror("couldn't get libdeflate context");
+  if(deflate_skip_p(eng)){
+    logdebug("skipping deflate of %" PRIuPTR "B", blen);
+    return encode_and_chunkify(f, buf, blen, 0);
+  }
+  kitty_deflater* d = deflater_get(eng);
+  if(d == NULL){
     return -1;
   }
+  size_t clen = 0;
+#ifdef USE_DEFLATE
   // if this allocation fails, just skip compression, no need to bail
-  cbuf = malloc(blen);
-  if(cbuf){
-    clen = libdeflate_zlib_compress(cmp, buf, blen, cbuf, blen);
+  if(deflater_reserve(d, blen) == 0){
+    clen = libdeflate_zlib_compress(d->cmp, buf, blen, d->cbuf, blen);
   }
-  libdeflate_free_compressor(cmp);
 #else
-  z_stream zctx = {0};
-  int z = deflateInit(&zctx, 2);
-  if(z != Z_OK){
-    logerror("couldn't get zlib context");
-    return -1;
-  }
-  clen = deflateBound(&zctx, blen);
-  cbuf = malloc(clen);
-  if(cbuf == NULL){
-    logerror("couldn't allocate %" PRIuPTR "B", clen);
-    deflateEnd(&zctx);
+  ssize_t z = zlib_compress(eng, d, buf, blen);
+  if(z < 0){
+    deflater_put(eng, d);
     return -1;
   }
-  zctx.avail_out = clen;
-  zctx.next_out = cbuf;
-  zctx.next_in = buf;
-  zctx.avail_in = blen;
-  z = deflate(&zctx, Z_FINISH);
-  if(z != Z_STREAM_END){
-    logerror("error %d deflating %" PRIuPTR "B -> %" PRIuPTR "B", z, blen, clen);
-    deflateEnd(&zctx);
-    return -1;
-  }
-  deflateEnd(&zctx);
-  clen -= zctx.avail_out;
+  clen = z;
 #endif
+  deflate_record(eng, blen, clen);
   int ret;
   if(0 == clen){ // wasn't enough room; compressed data is larger than original
     loginfo("deflated in vain; using original %" PRIuPTR "B", blen);
     ret = encode_and_chunkify(f, buf, blen, 0);
   }else{
     loginfo("deflated %" PRIuPTR "B to %" PRIuPTR "B", blen, clen);
-    ret = encode_and_chunkify(f, cbuf, clen, 1);
+    ret = encode_and_chunkify(f, d->cbuf, clen, 1);
   }
-  free(cbuf);
+  deflater_put(eng, d);
   return ret;
 }
 
+#ifndef __MINGW32__
+// remove a payload the terminal might not have consumed. kitty deletes those
+// it reads, so ENOENT is the usual result.
+static void
+unlink_stashed(kittytransport_e transport, const char* name){
+  if(transport == KITTY_TRANSPORT_SHM){
+    shm_unlink(name);
+  }else{
+    unlink(name);
+  }
+}
+
+static void
+release_stashed(kittytransport_e transport, char* name){
+  if(name){
+    unlink_stashed(transport, name);
+    free(name);
+  }
+}
+
+// write |blen| bytes from |buf| to a new POSIX shared memory object named
+// |name|. returns a file descriptor on success, or -1.
+static int
+stash_shm(const char* name, const void* buf, size_t blen){
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if(fd < 0){
+    logerror("couldn't create shm %s (%s)", name, strerror(errno));
+    return -1;
+  }
+  void* map = MAP_FAILED;
+  if(ftruncate(fd, blen) == 0){
+    map = mmap(NULL, blen, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if(map == MAP_FAILED){
+    logerror("couldn't map %" PRIuPTR "B of shm %s (%s)", blen, name, strerror(errno));
+    close(fd);
+    shm_unlink(name);
+    return -1;
+  }
+  memcpy(map, buf, blen);
+  munmap(map, blen);
+  return fd;
+}
+
+// write |blen| bytes from |buf| to a new temporary file, whose path is
+// written into |name|. kitty insists on the path containing
+// "tty-graphics-protocol" before it'll delete the file. returns a file
+// descriptor on success, or -1.
+static int
+stash_file(char* name, size_t namelen, const void* buf, size_t blen){
+  const char* tmpdir = getenv("TMPDIR");
+  if(tmpdir == NULL || *tmpdir == '\0'){
+    tmpdir = "/tmp";
+  }
+  if((size_t)snprintf(name, namelen, "%s/tty-graphics-protocol-notcurses-XXXXXX",
+                      tmpdir) >= namelen){
+    logerror("temporary directory too long: %s", tmpdir);
+    return -1;
+  }
+  int fd = mkstemp(name);
+  if(fd < 0){
+    logerror("couldn't create %s (%s)", name, strerror(errno));
+    return -1;
+  }
+  if(blocking_write(fd, buf, blen)){
+    close(fd);
+    unlink(name);
+    return -1;
+  }
+  return fd;
+}
+
+// stash |blen| bytes from |buf| where the terminal can get at them, per the
+// engine's transport, returning the heap-allocated name. the name is also
+// retained in the engine, until its slot is reused.
+static char*
+stash_payload(kitty_engine* eng, kittytransport_e t, const void* buf, size_t blen){
+  pthread_mutex_lock(&eng->lock);
+  const unsigned slot = eng->tnext++ % KITTY_TRANSPORT_SLOTS;
+  char* stale = eng->tslots[slot].name;
+  kittytransport_e stalet = eng->tslots[slot].transport;
+  eng->tslots[slot].name = NULL;
+  pthread_mutex_unlock(&eng->lock);
+  release_stashed(stalet, stale);
+  char name[PATH_MAX];
+  int fd;
+  if(t == KITTY_TRANSPORT_SHM){
+    snprintf(name, sizeof(name), "/notcurses-%ld-%08x-%u",
+             (long)getpid(), eng->nonce, slot);
+    fd = stash_shm(name, buf, blen);
+  }else{
+    fd = stash_file(name, sizeof(name), buf, blen);
+  }
+  if(fd < 0){
+    return NULL;
+  }
+  close(fd);
+  char* ret = strdup(name);
+  char* kept = ret ? strdup(name) : NULL;
+  if(kept == NULL){
+    free(ret);
+    unlink_stashed(t, name);
+    return NULL;
+  }
+  pthread_mutex_lock(&eng->lock);
+  eng->tslots[slot].name = kept;
+  eng->tslots[slot].transport = t;
+  pthread_mutex_unlock(&eng->lock);
+  return ret;
+}
+#endif
+
+static kittytransport_e
+kitty_transport(kitty_engine* eng){
+  if(eng == NULL){
+    return KITTY_TRANSPORT_DIRECT;
+  }
+  pthread_mutex_lock(&eng->lock);
+  kittytransport_e ret = eng->transport;
+  pthread_mutex_unlock(&eng->lock);
+  return ret;
+}
+
+void kitty_transport_failed(tinfo* ti){
+  kitty_engine* eng = ti->kittyengine;
+  if(eng == NULL){
+    return;
+  }
+  pthread_mutex_lock(&eng->lock);
+  if(eng->transport != KITTY_TRANSPORT_DIRECT){
+    logwarn("terminal rejected a %s payload; transmitting directly",
+            eng->transport == KITTY_TRANSPORT_SHM ? "shm" : "file");
+    eng->transport = KITTY_TRANSPORT_DIRECT;
+  }
+  pthread_mutex_unlock(&eng->lock);
+}
+
+// finish the animated transmission header begun in write_kitty_data(), and
+// write the |dimy|x|dimx| RGBA payload at |buf|. if the terminal can read it
+// out of shared memory or a file, we needn't encode it at all, and we ask to
+// be told about errors (q=1), so that we can fall back to sending payloads
+// directly. otherwise, it's (possibly) deflated and encoded in the escape.
+static int
+write_payload(kitty_engine* eng, void* buf, fbuf* f, int dimy, int dimx){
+#ifndef __MINGW32__
+  const kittytransport_e t = kitty_transport(eng);
+  if(t != KITTY_TRANSPORT_DIRECT){
+    const size_t blen = dimx * dimy * 4;
+    char* name = stash_payload(eng, t, buf, blen);
+    if(name){
+      const size_t nlen = strlen(name);
+      int ret = 0;
+      if(fbuf_printf(f, ",q=1,t=%c,S=%" PRIuPTR ";",
+                     t == KITTY_TRANSPORT_SHM ? 's' : 't', blen) < 0 ||
+         fbuf_grow(f, (nlen + 2) / 3 * 4 + 2)){
+        ret = -1;
+      }else{
+        char* w = f->buf + f->used;
+        const size_t whole = nlen - nlen % 3;
+        base64_encode((const unsigned char*)name, whole, w);
+        w += whole / 3 * 4;
+        if(nlen % 3){
+          base64final((const unsigned char*)name + whole, w, nlen % 3);
+          w += 4;
+        }
+        memcpy(w, "\x1b\\", 2);
+        f->used = w + 2 - f->buf;
+      }
+      loginfo("stashed %" PRIuPTR "B at %s", blen, name);
+      free(name);
+      return ret;
+    }
+    logwarn("couldn't stash %" PRIuPTR "B payload, encoding it", blen);
+  }
+#endif
+  return deflate_buf(eng, buf, f, dimy, dimx);
+}
+
 // copy |encodeable| ([1..3]) pixels from |src| to the buffer |dst|, setting
 // alpha along the way according to |wipe|.
 static inline int
@@ -695,16 +1242,19 @@ add_to_buf(uint32_t *dst, const uint32_t* src, int encodeable, bool wipe[static
 }
 
 // writes to |*animated| based on normalized |level|. if we're not animated,
-// we won't be using compression.
+// we won't be using compression. the buffer comes from the arena unless it's
+// to be kept as the sprixel's frame (|keep|), in which case it's malloc()ed.
 static inline int
-prep_animation(ncpixelimpl_e level, uint32_t** buf, int leny, int lenx, unsigned* animated){
+prep_animation(ncpixelimpl_e level, bool keep, uint32_t** buf, int leny,
+               int lenx, unsigned* animated){
   if(level < NCPIXEL_KITTY_ANIMATED){
     *animated = false;
     *buf = NULL;
     return 0;
   }
   *animated = true;
-  if((*buf = malloc(lenx * leny * sizeof(uint32_t))) == NULL){
+  const size_t len = lenx * leny * sizeof(uint32_t);
+  if((*buf = keep ? malloc(len) : arena_alloc(len)) == NULL){
     return -1;
   }
   return 0;
@@ -740,8 +1290,8 @@ finalize_multiframe_selfref(sprixel* s, fbuf* f){
 // 16 base64-encoded bytes. 4096 / 16 == 256 3-pixel groups, or 768 pixels.
 // closes |fp| on all paths.
 static int
-write_kitty_data(fbuf* f, int linesize, int leny, int lenx, int cols,
-                 const uint32_t* data, const blitterargs* bargs,
+write_kitty_data(kitty_engine* eng, fbuf* f, int linesize, int leny, int lenx,
+                 int cols, const uint32_t* data, const blitterargs* bargs,
                  tament* tam, int* parse_start, ncpixelimpl_e level){
   if(linesize % sizeof(*data)){
     logerror("stride (%d) badly aligned", linesize);
@@ -752,7 +1302,10 @@ write_kitty_data(fbuf* f, int linesize, int leny, int lenx, int cols,
   // we'll be collecting the pixels, modified to reflect alpha nullification
   // due to preexisting wipes, into a temporary buffer for compression (iff
   // we're animated). pixels are 32 bits each.
-  if(prep_animation(level, &buf, leny, lenx, &animated)){
+  const bool keep = bargs->u.pixel.spx->keepframe;
+  const arenamark mark = arena_mark();
+  if(prep_animation(level, keep, &buf, leny, lenx, &animated)){
+    arena_release(mark);
     return -1;
   }
   unsigned bufidx = 0; // an index; the actual offset is bufidx * 4
@@ -775,6 +1328,17 @@ write_kitty_data(fbuf* f, int linesize, int leny, int lenx, int cols,
   // set high if we are (1) reloading a frame with (2) annihilated cells copied over
   // from the TAM and (3) we are NCPIXEL_KITTY_SELFREF. calls finalize_multiframe_selfref().
   bool selfref_annihilated = false;
+  // unanimated payloads are edited in place by wipes and rebuilds, which
+  // find their pixels through the offset of each chunk.
+  int chunkidx = 0;
+  if(!animated){
+    uint32_t* tmp = realloc(s->chunkoffs, sizeof(*tmp) * chunks);
+    if(tmp == NULL){
+      goto err;
+    }
+    s->chunkoffs = tmp;
+    s->chunkcount = chunks;
+  }
   while(chunks--){
     // q=2 has been able to go on chunks other than the last chunk since
     // 2021-03, but there's no harm in this small bit of backwards compat.
@@ -783,17 +1347,17 @@ write_kitty_data(fbuf* f, int linesize, int leny, int lenx, int cols,
       // alas. see https://github.com/dankamongmen/notcurses/issues/1910 =[.
       // parse_start isn't used in animation mode, so no worries about the
       // fact that this doesn't complete the header in that case.
-      *parse_start = fbuf_printf(f, "\e_Gf=32,s=%d,v=%d,i=%d,p=1,a=t,%s",
+      *parse_start = fbuf_printf(f, "\e_Gf=32,s=%d,v=%d,i=%d,p=1,a=t%s",
                                  lenx, leny, s->id,
-                                 animated ? "q=2" : chunks ? "m=1;" : "q=2;");
+                                 animated ? "" : chunks ? ",m=1;" : ",q=2;");
       if(*parse_start < 0){
         goto err;
       }
-      // so if we're animated, we've printed q=2, but no semicolon to close
-      // the control block, since we're not yet sure what m= to write. we've
-      // otherwise written q=2; if we're the only chunk, and m=1; otherwise.
-      // if we're *not* animated, we'll get q=2,m=0; below. otherwise, it's
-      // handled following deflate.
+      // so if we're animated, we've not closed the control block, since we're
+      // not yet sure how the payload will be transmitted (nor what q= and m=
+      // to write). we've otherwise written q=2; if we're the only chunk, and
+      // m=1; otherwise. if we're *not* animated, we'll get q=2,m=0; below.
+      // otherwise, it's handled by write_payload().
     }else{
       if(!animated){
         if(fbuf_printf(f, "\e_G%sm=%d;", chunks ? "" : "q=2,", chunks ? 1 : 0) < 0){
@@ -801,6 +1365,9 @@ write_kitty_data(fbuf* f, int linesize, int leny, int lenx, int cols,
         }
       }
     }
+    if(!animated){
+      s->chunkoffs[chunkidx++] = f->used;
+    }
     if((targetout += RGBA_MAXLEN) > total){
       targetout = total;
     }
@@ -831,7 +1398,7 @@ write_kitty_data(fbuf* f, int linesize, int leny, int lenx, int cols,
         if(x % cdimx == 0 && y % cdimy == 0){
           if(level == NCPIXEL_KITTY_ANIMATED){
             uint8_t* tmp;
-            tmp = kitty_anim_auxvec(leny, lenx, y, x, cdimy, cdimx,
+            tmp = kitty_anim_auxvec(s->apool, leny, lenx, y, x, cdimy, cdimx,
                                     data, linesize, tam[tyx].auxvector,
                                     transcolor);
             if(tmp == NULL){
@@ -841,7 +1408,7 @@ write_kitty_data(fbuf* f, int linesize, int leny, int lenx, int cols,
             tam[tyx].auxvector = tmp;
           }else if(level == NCPIXEL_KITTY_SELFREF){
             if(tam[tyx].auxvector == NULL){
-              tam[tyx].auxvector = malloc(sizeof(tam[tyx].state));
+              tam[tyx].auxvector = auxvec_get(s->apool, sizeof(tam[tyx].state));
               if(tam[tyx].auxvector == NULL){
                 logerror("got a NULL auxvec at %d", tyx);
                 goto err;
@@ -925,7 +1492,7 @@ write_kitty_data(fbuf* f, int linesize, int leny, int lenx, int cols,
   // we only deflate if we're using animation, since otherwise we need be able
   // to edit the encoded bitmap in-place for wipes/restores.
   if(animated){
-    if(deflate_buf(buf, f, leny, lenx)){
+    if(write_payload(eng, buf, f, leny, lenx)){
       goto err;
     }
     if(selfref_annihilated){
@@ -933,15 +1500,26 @@ write_kitty_data(fbuf* f, int linesize, int leny, int lenx, int cols,
         goto err;
       }
     }
+    if(s->keepframe){
+      free(s->frame);
+      s->frame = buf;
+      buf = NULL;
+    }
   }
   scrub_tam_boundaries(tam, leny, lenx, cdimy, cdimx);
-  free(buf);
+  if(keep){
+    free(buf);
+  }
+  arena_release(mark);
   return 0;
 
 err:
   logerror("failed blitting kitty graphics");
   cleanup_tam(tam, (leny + cdimy - 1) / cdimy, (lenx + cdimx - 1) / cdimx);
-  free(buf);
+  if(keep){
+    free(buf);
+  }
+  arena_release(mark);
   return -1;
 }
 
@@ -951,6 +1529,7 @@ int kitty_rebuild_selfref(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
   if(init_sprixel_animation(s)){
     return -1;
   }
+  s->framesedited = true;
   fbuf* f = &s->glyph;
   const int cellpxy = ncplane_pile(s->n)->cellpxy;
   const int cellpxx = ncplane_pile(s->n)->cellpxx;
@@ -974,6 +1553,7 @@ int kitty_rebuild_animation(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
   if(init_sprixel_animation(s)){
     return -1;
   }
+  s->framesedited = true;
   fbuf* f = &s->glyph;
   const int cellpxy = ncplane_pile(s->n)->cellpxy;
   const int cellpxx = ncplane_pile(s->n)->cellpxx;
@@ -1072,13 +1652,160 @@ int kitty_rebuild_animation(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
 }
 #undef RGBA_MAXLEN
 
+// send a frame replacing the one in |s->frame| as edits to the graphic's
+// root frame: for each row of cells, the bounding rectangle of the pixels
+// which changed (if any) is sent, with its x=/y= offset. the frame is first
+// prepared exactly as write_kitty_data() would prepare it, updating the TAM
+// (which kitty_recycle() guaranteed to be free of annihilations) as we go.
+// an unchanged frame emits nothing at all. returns -1 on error, 1 on success.
+static int
+kitty_blit_reframe(ncplane* n, int linesize, const uint32_t* data, int leny,
+                   int lenx, const blitterargs* bargs, ncpixelimpl_e level){
+  sprixel* s = bargs->u.pixel.spx;
+  tament* tam = n->tam;
+  const int cdimy = bargs->u.pixel.cellpxy;
+  const int cdimx = bargs->u.pixel.cellpxx;
+  const int cols = s->dimx;
+  const bool translucent = bargs->flags & NCVISUAL_OPTION_BLEND;
+  const uint32_t transcolor = bargs->transcolor;
+  if(linesize % sizeof(*data)){
+    logerror("stride (%d) badly aligned", linesize);
+    return -1;
+  }
+  uint32_t* frame = malloc(sizeof(*frame) * leny * lenx);
+  uint32_t* rect = malloc(sizeof(*rect) * cdimy * lenx);
+  if(frame == NULL || rect == NULL){
+    free(frame);
+    free(rect);
+    return -1;
+  }
+  for(int y = 0 ; y < leny ; ++y){
+    const uint32_t* line = data + (linesize / sizeof(*data)) * y;
+    for(int x = 0 ; x < lenx ; ++x){
+      uint32_t px = line[x];
+      if(translucent){
+        ncpixel_set_a(&px, ncpixel_a(px) / 2);
+      }
+      const int tyx = (y / cdimy) * cols + x / cdimx;
+      const bool origin = x % cdimx == 0 && y % cdimy == 0;
+      if(origin){
+        if(level == NCPIXEL_KITTY_ANIMATED){
+          uint8_t* tmp = kitty_anim_auxvec(s->apool, leny, lenx, y, x, cdimy, cdimx, data,
+                                           linesize, tam[tyx].auxvector, transcolor);
+          if(tmp == NULL){
+            goto err;
+          }
+          tam[tyx].auxvector = tmp;
+        }else if(level == NCPIXEL_KITTY_SELFREF){
+          if(tam[tyx].auxvector == NULL){
+            if((tam[tyx].auxvector = auxvec_get(s->apool, sizeof(tam[tyx].state))) == NULL){
+              goto err;
+            }
+          }
+          memcpy(tam[tyx].auxvector, &tam[tyx].state, sizeof(tam[tyx].state));
+        }
+      }
+      if(rgba_trans_p(px, transcolor)){
+        ncpixel_set_a(&px, 0);
+        if(origin){
+          tam[tyx].state = SPRIXCELL_TRANSPARENT;
+        }else if(tam[tyx].state == SPRIXCELL_OPAQUE_KITTY){
+          tam[tyx].state = SPRIXCELL_MIXED_KITTY;
+        }
+      }else{
+        if(origin){
+          tam[tyx].state = SPRIXCELL_OPAQUE_KITTY;
+        }else if(tam[tyx].state == SPRIXCELL_TRANSPARENT){
+          tam[tyx].state = SPRIXCELL_MIXED_KITTY;
+        }
+      }
+      frame[y * lenx + x] = px;
+    }
+  }
+  scrub_tam_boundaries(tam, leny, lenx, cdimy, cdimx);
+  kitty_engine* keng = ncplane_pile(n) ? ncplane_notcurses(n)->tcache.kittyengine : NULL;
+  int rects = 0;
+  for(int by = 0 ; by < leny ; by += cdimy){
+    const int bend = by + cdimy < leny ? by + cdimy : leny;
+    int y0 = -1, y1 = -1;
+    int x0 = lenx, x1 = -1;
+    for(int y = by ; y < bend ; ++y){
+      const uint32_t* was = s->frame + y * lenx;
+      const uint32_t* is = frame + y * lenx;
+      if(memcmp(was, is, sizeof(*is) * lenx) == 0){
+        continue;
+      }
+      if(y0 < 0){
+        y0 = y;
+      }
+      y1 = y;
+      int l = 0;
+      while(was[l] == is[l]){
+        ++l;
+      }
+      int r = lenx - 1;
+      while(was[r] == is[r]){
+        --r;
+      }
+      if(l < x0){
+        x0 = l;
+      }
+      if(r > x1){
+        x1 = r;
+      }
+    }
+    if(y0 < 0){
+      continue;
+    }
+    const int w = x1 - x0 + 1;
+    const int h = y1 - y0 + 1;
+    for(int y = 0 ; y < h ; ++y){
+      memcpy(rect + y * w, frame + (y0 + y) * lenx + x0, sizeof(*rect) * w);
+    }
+    if(rects++ == 0){
+      if(init_sprixel_animation(s)){
+        goto err;
+      }
+    }
+    // the payload is always encoded, rather than stashed: a frame can carry
+    // more rectangles than we have transport slots.
+    if(fbuf_printf(&s->glyph, "\e_Ga=f,r=1,X=1,i=%u,x=%d,y=%d,s=%d,v=%d",
+                   s->id, x0, y0, w, h) < 0){
+      goto err;
+    }
+    if(deflate_buf(keng, rect, &s->glyph, h, w)){
+      goto err;
+    }
+  }
+  free(rect);
+  free(s->frame);
+  s->frame = frame;
+  loginfo("reframed %u with %d rectangle%s", s->id, rects, rects == 1 ? "" : "s");
+  if(rects && (s->invalidated == SPRIXEL_QUIESCENT || s->invalidated == SPRIXEL_LOADED)){
+    s->invalidated = SPRIXEL_INVALIDATED;
+  }
+  return 1;
+
+err:
+  logerror("failed reframing kitty graphics");
+  free(frame);
+  free(rect);
+  return -1;
+}
+
 // Kitty graphics blitter. Kitty can take in up to 4KiB at a time of (optionally
 // deflate-compressed) 24bit RGB. Returns -1 on error, 1 on success.
-static inline int
-kitty_blit_core(ncplane* n, int linesize, const void* data, int leny, int lenx,
-                const blitterargs* bargs, ncpixelimpl_e level){
+static int
+kitty_blit_encode(ncplane* n, int linesize, const void* data, int leny, int lenx,
+                  const blitterargs* bargs, ncpixelimpl_e level){
   int cols = bargs->u.pixel.spx->dimx;
   sprixel* s = bargs->u.pixel.spx;
+  // kitty_recycle() only hands back a graphic which can take this frame as
+  // edits, and only graphics able to animate keep their frame.
+  if(s->frame && s->pixy == leny + bargs->u.pixel.pxoffy &&
+     s->pixx == lenx + bargs->u.pixel.pxoffx){
+    return kitty_blit_reframe(n, linesize, data, leny, lenx, bargs, level);
+  }
   if(init_sprixel_animation(s)){
     return -1;
   }
@@ -1086,7 +1813,8 @@ kitty_blit_core(ncplane* n, int linesize, const void* data, int leny, int lenx,
   fbuf* f = &s->glyph;
   int pxoffx = bargs->u.pixel.pxoffx;
   int pxoffy = bargs->u.pixel.pxoffy;
-  if(write_kitty_data(f, linesize, leny, lenx, cols, data,
+  kitty_engine* keng = ncplane_pile(n) ? ncplane_notcurses(n)->tcache.kittyengine : NULL;
+  if(write_kitty_data(keng, f, linesize, leny, lenx, cols, data,
                       bargs, n->tam, &parse_start, level)){
     goto error;
   }
@@ -1105,10 +1833,19 @@ kitty_blit_core(ncplane* n, int linesize, const void* data, int leny, int lenx,
 
 error:
   cleanup_tam(n->tam, bargs->u.pixel.spx->dimy, bargs->u.pixel.spx->dimx);
-  fbuf_free(&s->glyph);
+  fbufpool_put(s->fpool, &s->glyph);
   return -1;
 }
 
+static inline int
+kitty_blit_core(ncplane* n, int linesize, const void* data, int leny, int lenx,
+                const blitterargs* bargs, ncpixelimpl_e level){
+  const uint64_t tstart = nctrace_begin();
+  int r = kitty_blit_encode(n, linesize, data, leny, lenx, bargs, level);
+  nctrace_end("kitty_blit", tstart, "pixels", (int64_t)leny * lenx);
+  return r;
+}
+
 int kitty_blit(ncplane* n, int linesize, const void* data, int leny, int lenx,
                const blitterargs* bargs){
   return kitty_blit_core(n, linesize, data, leny, lenx, bargs,
@@ -1127,6 +1864,119 @@ int kitty_blit_selfref(ncplane* n, int linesize, const void* data,
                          NCPIXEL_KITTY_SELFREF);
 }
 
+// the combining marks kitty uses to encode the row and column of a Unicode
+// placeholder cell (see rowcolumn-diacritics.txt in kitty's source), in
+// order: the nth names row (or column) n. these are the class 230 marks of
+// Unicode 6.0 which neither decompose nor appear in decompositions.
+static const uint32_t kitty_diacritics[] = {
+  0x0305, 0x030D, 0x030E, 0x0310, 0x0312, 0x033D, 0x033E, 0x033F, 0x0346,
+  0x034A, 0x034B, 0x034C, 0x0350, 0x0351, 0x0352, 0x0357, 0x035B, 0x0363,
+  0x0364, 0x0365, 0x0366, 0x0367, 0x0368, 0x0369, 0x036A, 0x036B, 0x036C,
+  0x036D, 0x036E, 0x036F, 0x0483, 0x0484, 0x0485, 0x0486, 0x0487, 0x0592,
+  0x0593, 0x0594, 0x0595, 0x0597, 0x0598, 0x0599, 0x059C, 0x059D, 0x059E,
+  0x059F, 0x05A0, 0x05A1, 0x05A8, 0x05A9, 0x05AB, 0x05AC, 0x05AF, 0x05C4,
+  0x0610, 0x0611, 0x0612, 0x0613, 0x0614, 0x0615, 0x0616, 0x0617, 0x0657,
+  0x0658, 0x0659, 0x065A, 0x065B, 0x065D, 0x065E, 0x06D6, 0x06D7, 0x06D8,
+  0x06D9, 0x06DA, 0x06DB, 0x06DC, 0x06DF, 0x06E0, 0x06E1, 0x06E2, 0x06E4,
+  0x06E7, 0x06E8, 0x06EB, 0x06EC, 0x0730, 0x0732, 0x0733, 0x0735, 0x0736,
+  0x073A, 0x073D, 0x073F, 0x0740, 0x0741, 0x0743, 0x0745, 0x0747, 0x0749,
+  0x074A, 0x07EB, 0x07EC, 0x07ED, 0x07EE, 0x07EF, 0x07F0, 0x07F1, 0x07F3,
+  0x0816, 0x0817, 0x0818, 0x0819, 0x081B, 0x081C, 0x081D, 0x081E, 0x081F,
+  0x0820, 0x0821, 0x0822, 0x0823, 0x0825, 0x0826, 0x0827, 0x0829, 0x082A,
+  0x082B, 0x082C, 0x082D, 0x0951, 0x0953, 0x0954, 0x0F82, 0x0F83, 0x0F86,
+  0x0F87, 0x135D, 0x135E, 0x135F, 0x17DD, 0x193A, 0x1A17, 0x1A75, 0x1A76,
+  0x1A77, 0x1A78, 0x1A79, 0x1A7A, 0x1A7B, 0x1A7C, 0x1B6B, 0x1B6D, 0x1B6E,
+  0x1B6F, 0x1B70, 0x1B71, 0x1B72, 0x1B73, 0x1CD0, 0x1CD1, 0x1CD2, 0x1CDA,
+  0x1CDB, 0x1CE0, 0x1DC0, 0x1DC1, 0x1DC3, 0x1DC4, 0x1DC5, 0x1DC6, 0x1DC7,
+  0x1DC8, 0x1DC9, 0x1DCB, 0x1DCC, 0x1DD1, 0x1DD2, 0x1DD3, 0x1DD4, 0x1DD5,
+  0x1DD6, 0x1DD7, 0x1DD8, 0x1DD9, 0x1DDA, 0x1DDB, 0x1DDC, 0x1DDD, 0x1DDE,
+  0x1DDF, 0x1DE0, 0x1DE1, 0x1DE2, 0x1DE3, 0x1DE4, 0x1DE5, 0x1DE6, 0x1DFE,
+  0x20D0, 0x20D1, 0x20D4, 0x20D5, 0x20D6, 0x20D7, 0x20DB, 0x20DC, 0x20E1,
+  0x20E7, 0x20E9, 0x20F0, 0x2CEF, 0x2CF0, 0x2CF1, 0x2DE0, 0x2DE1, 0x2DE2,
+  0x2DE3, 0x2DE4, 0x2DE5, 0x2DE6, 0x2DE7, 0x2DE8, 0x2DE9, 0x2DEA, 0x2DEB,
+  0x2DEC, 0x2DED, 0x2DEE, 0x2DEF, 0x2DF0, 0x2DF1, 0x2DF2, 0x2DF3, 0x2DF4,
+  0x2DF5, 0x2DF6, 0x2DF7, 0x2DF8, 0x2DF9, 0x2DFA, 0x2DFB, 0x2DFC, 0x2DFD,
+  0x2DFE, 0x2DFF, 0xA66F, 0xA67C, 0xA67D, 0xA6F0, 0xA6F1, 0xA8E0, 0xA8E1,
+  0xA8E2, 0xA8E3, 0xA8E4, 0xA8E5, 0xA8E6, 0xA8E7, 0xA8E8, 0xA8E9, 0xA8EA,
+  0xA8EB, 0xA8EC, 0xA8ED, 0xA8EE, 0xA8EF, 0xA8F0, 0xA8F1, 0xAAB0, 0xAAB2,
+  0xAAB3, 0xAAB7, 0xAAB8, 0xAABE, 0xAABF, 0xAAC1, 0xFE20, 0xFE21, 0xFE22,
+  0xFE23, 0xFE24, 0xFE25, 0xFE26, 0x10A0F, 0x10A38, 0x1D185, 0x1D186, 0x1D187,
+  0x1D188, 0x1D189, 0x1D1AA, 0x1D1AB, 0x1D1AC, 0x1D1AD, 0x1D242, 0x1D243,
+  0x1D244
+};
+
+#define KITTY_DIACRITICS (sizeof(kitty_diacritics) / sizeof(*kitty_diacritics))
+
+// all our diacritics are BMP or SMP, and thus 2--4 bytes of UTF-8
+static inline int
+kitty_diacritic_utf8(unsigned idx, char* out){
+  const uint32_t cp = kitty_diacritics[idx];
+  if(cp < 0x800){
+    out[0] = 0xc0 | (cp >> 6);
+    out[1] = 0x80 | (cp & 0x3f);
+    return 2;
+  }else if(cp < 0x10000){
+    out[0] = 0xe0 | (cp >> 12);
+    out[1] = 0x80 | ((cp >> 6) & 0x3f);
+    out[2] = 0x80 | (cp & 0x3f);
+    return 3;
+  }
+  out[0] = 0xf0 | (cp >> 18);
+  out[1] = 0x80 | ((cp >> 12) & 0x3f);
+  out[2] = 0x80 | ((cp >> 6) & 0x3f);
+  out[3] = 0x80 | (cp & 0x3f);
+  return 4;
+}
+
+// write a placeholder glyph into each cell of |n| covered by the graphic: an
+// U+10EEEE carrying diacritics for its row and column, with the graphic's id
+// (always less than 2^24) as its RGB foreground. the terminal draws that part
+// of the graphic there. transparent cells are left empty (and transparent).
+static int
+kitty_placeholder_cells(ncplane* n, const sprixel* s){
+  if(s->dimy > KITTY_DIACRITICS || s->dimx > KITTY_DIACRITICS){
+    logerror("can't place %ux%u cells with placeholders", s->dimy, s->dimx);
+    return -1;
+  }
+  const unsigned dimy = s->dimy < n->leny ? s->dimy : n->leny;
+  const unsigned dimx = s->dimx < n->lenx ? s->dimx : n->lenx;
+  for(unsigned y = 0 ; y < dimy ; ++y){
+    char egc[12] = "\xf4\x8e\xbb\xae"; // U+10EEEE
+    const int rowlen = 4 + kitty_diacritic_utf8(y, egc + 4);
+    for(unsigned x = 0 ; x < dimx ; ++x){
+      nccell* c = ncplane_cell_ref_yx(n, y, x);
+      pool_release(&n->pool, c);
+      c->stylemask = 0;
+      c->channels = 0;
+      if(n->tam[y * s->dimx + x].state == SPRIXCELL_TRANSPARENT){
+        ncchannels_set_fg_alpha(&c->channels, NCALPHA_TRANSPARENT);
+        ncchannels_set_bg_alpha(&c->channels, NCALPHA_TRANSPARENT);
+        continue;
+      }
+      ncchannels_set_fg_rgb(&c->channels, s->id);
+      ncchannels_set_bg_alpha(&c->channels, NCALPHA_TRANSPARENT);
+      const int len = rowlen + kitty_diacritic_utf8(x, egc + rowlen);
+      if(pool_load_direct(&n->pool, c, egc, len, 1) < 0){
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+int kitty_blit_placeholder(ncplane* n, int linesize, const void* data,
+                           int leny, int lenx, const blitterargs* bargs){
+  int r = kitty_blit_core(n, linesize, data, leny, lenx, bargs,
+                          NCPIXEL_KITTY_ANIMATED);
+  if(r < 0){
+    return r;
+  }
+  if(kitty_placeholder_cells(n, bargs->u.pixel.spx)){
+    return -1;
+  }
+  return r;
+}
+
 int kitty_remove(int id, fbuf* f){
   loginfo("removing graphic %u", id);
   if(fbuf_printf(f, "\e_Ga=d,d=I,i=%d\e\\", id) < 0){
@@ -1143,7 +1993,7 @@ int kitty_scrub(const ncpile* p, sprixel* s){
       const int ridx = yy * p->dimx + xx;
       assert(0 <= ridx);
       struct crender *r = &p->crender[ridx];
-      if(!r->sprixel){
+      if(!r->s.sprixeled){
         if(s->n){
 //fprintf(stderr, "CHECKING %d/%d\n", yy - s->movedfromy, xx - s->movedfromx);
           sprixcell_e state = sprixel_state(s, yy - s->movedfromy + s->n->absy,
@@ -1166,11 +2016,17 @@ int kitty_scrub(const ncpile* p, sprixel* s){
   return 0;
 }
 
+// cells which held placeholders are damaged by the ordinary render diff
+int kitty_scrub_placeholder(const ncpile* p, sprixel* s){
+  (void)p;
+  (void)s;
+  return 0;
+}
+
 // returns the number of bytes written
 int kitty_draw(const tinfo* ti, const ncpile* p, sprixel* s, fbuf* f,
                int yoff, int xoff){
   (void)ti;
-  (void)p;
   bool animated = false;
   if(s->animating){ // active animation
     s->animating = false;
@@ -1179,12 +2035,17 @@ int kitty_draw(const tinfo* ti, const ncpile* p, sprixel* s, fbuf* f,
   int ret = s->glyph.used;
   logdebug("dumping %" PRIu64 "b for %u at %d %d", s->glyph.used, s->id, yoff, xoff);
   if(ret){
-    if(fbuf_putn(f, s->glyph.buf, s->glyph.used) < 0){
+    // an animation's glyph is freed below, so it can't be referenced in place
+    if(p && !animated){
+      if(raster_putglyph(p->nc, f, &s->glyph)){
+        ret = -1;
+      }
+    }else if(fbuf_putn(f, s->glyph.buf, s->glyph.used) < 0){
       ret = -1;
     }
   }
   if(animated){
-    fbuf_free(&s->glyph);
+    fbufpool_put(s->fpool, &s->glyph);
   }
   s->invalidated = SPRIXEL_LOADED;
   return ret;
@@ -1206,6 +2067,16 @@ int kitty_move(sprixel* s, fbuf* f, unsigned noscroll, int yoff, int xoff){
   return ret;
 }
 
+// the placeholders move along with the plane's cells
+int kitty_move_placeholder(sprixel* s, fbuf* f, unsigned noscroll, int yoff, int xoff){
+  (void)f;
+  (void)noscroll;
+  (void)yoff;
+  (void)xoff;
+  s->invalidated = SPRIXEL_QUIESCENT;
+  return 0;
+}
+
 // clears all kitty bitmaps
 int kitty_clear_all(fbuf* f){
 //fprintf(stderr, "KITTY UNIVERSAL ERASE\n");
@@ -1214,3 +2085,90 @@ int kitty_clear_all(fbuf* f){
   }
   return 0;
 }
+
+// deletes all placements, but (lowercase 'd=a') not the image data
+int kitty_hide_all(fbuf* f){
+  if(fbuf_putn(f, "\x1b_Ga=d,d=a,q=2\x1b\\", 16) < 0){
+    return -1;
+  }
+  return 0;
+}
+
+int kitty_init(tinfo* ti, int fd){
+  (void)fd;
+  if(ti->kittyengine){
+    return 0;
+  }
+  kitty_engine* keng = malloc(sizeof(*keng));
+  if(keng == NULL){
+    return -1;
+  }
+  memset(keng, 0, sizeof(*keng));
+  pthread_mutex_init(&keng->lock, NULL);
+  keng->transport = ti->kittytransport;
+  // the address distinguishes contexts within a process, and the time, our
+  // names from those of a dead process which happened to share our pid.
+  keng->nonce = (uintptr_t)keng ^ time(NULL);
+#ifndef USE_DEFLATE
+  pthread_cond_init(&keng->cond, NULL);
+  // only animated kitty deflates its payloads
+  unsigned workers_wanted = 0;
+  if(ti->pixel_implementation >= NCPIXEL_KITTY_ANIMATED){
+    unsigned cpus = host_cpu_count();
+    if(cpus > KITTY_MAXTHREADS){
+      cpus = KITTY_MAXTHREADS;
+    }
+    workers_wanted = cpus - 1;
+  }
+  if(workers_wanted){
+    if((keng->tids = malloc(sizeof(*keng->tids) * workers_wanted)) == NULL){
+      workers_wanted = 0;
+    }
+  }
+  for(unsigned w = 0 ; w < workers_wanted ; ++w){
+    if(pthread_create(&keng->tids[w], NULL, kitty_worker, keng)){
+      // we can limp along with whatever workers we got
+      logerror("couldn't spin up kitty worker %u/%u", w, workers_wanted);
+      break;
+    }
+    ++keng->workers;
+  }
+  loginfo("spun up %u kitty worker%s", keng->workers,
+          keng->workers == 1 ? "" : "s");
+#endif
+  ti->kittyengine = keng;
+  return 0;
+}
+
+void kitty_cleanup(tinfo* ti){
+  kitty_engine* keng = ti->kittyengine;
+  if(keng == NULL){
+    return;
+  }
+#ifndef USE_DEFLATE
+  pthread_mutex_lock(&keng->lock);
+  keng->done = true;
+  pthread_mutex_unlock(&keng->lock);
+  pthread_cond_broadcast(&keng->cond);
+  for(unsigned t = 0 ; t < keng->workers ; ++t){
+    pthread_join(keng->tids[t], NULL);
+  }
+  free(keng->tids);
+  pthread_cond_destroy(&keng->cond);
+#endif
+  loginfo("kitty deflate: %" PRIu64 " useful, %" PRIu64 " in vain, %" PRIu64 " skipped",
+          keng->deflated, keng->vain, keng->skipped);
+#ifndef __MINGW32__
+  for(unsigned t = 0 ; t < KITTY_TRANSPORT_SLOTS ; ++t){
+    release_stashed(keng->tslots[t].transport, keng->tslots[t].name);
+  }
+#endif
+  while(keng->idle){
+    kitty_deflater* d = keng->idle;
+    keng->idle = d->next;
+    deflater_free(d);
+  }
+  pthread_mutex_destroy(&keng->lock);
+  free(keng);
+  ti->kittyengine = NULL;
+}
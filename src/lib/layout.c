@@ -96,7 +96,7 @@ puttext_line(ncplane* n, ncalign_e align, const char* text, size_t* bytes){
       return cols;
     }
     b += consumed;
-    int width = wcwidth(w);
+    int width = ncwidth(w);
     if(width < 0){
       width = 0; // FIXME
     }
@@ -182,3 +182,354 @@ int ncplane_puttext(ncplane* n, int y, ncalign_e align, const char* text, size_t
   return totalcols;
 }
 
+
+// an nclayout retains text together with its segmentation, so that it can be
+// wrapped to any width (and rewrapped upon a change of width) without again
+// decoding or measuring a single EGC. the text is broken into segments:
+// runs of non-breaking EGCs (words), runs of breaking whitespace, tabs, and
+// line breaks. wrapping walks only the segments, producing lines (byte spans
+// of the text, with their widths). appended text is segmented on its own;
+// only the final paragraph (if it was unterminated) is revisited.
+typedef enum {
+  LAYOUT_WORD,
+  LAYOUT_SPACE,
+  LAYOUT_TAB,
+  LAYOUT_NEWLINE,
+} layoutseg_e;
+
+typedef struct layoutseg {
+  uint32_t off;      // byte offset of the segment within the text
+  uint32_t bytes;
+  uint32_t cols;     // 0 for tabs, which depend on their column
+  layoutseg_e type;
+} layoutseg;
+
+typedef struct layoutline {
+  uint32_t off;      // byte offset of the line within the text
+  uint32_t bytes;    // bytes of the line, less any trailing whitespace
+  uint32_t cols;     // columns of those bytes
+  uint32_t seg;      // index of the segment in which the line begins
+} layoutline;
+
+typedef struct nclayout {
+  char* text;
+  size_t textlen;    // not including the NUL terminator
+  size_t textsize;   // allocated bytes of text
+  layoutseg* segs;
+  size_t segcount, segsize;
+  size_t parastart;  // first segment of the final (unterminated) paragraph
+  layoutline* linev;   // "lines" is a curses macro
+  size_t linecount, linesize;
+  unsigned wrapcols; // width to which lines were wrapped, or 0
+} nclayout;
+
+static int
+layout_push_seg(nclayout* l, layoutseg_e type, size_t off, size_t bytes, int cols){
+  // coalesce runs of the same type, save for tabs and line breaks
+  if(l->segcount > l->parastart && (type == LAYOUT_WORD || type == LAYOUT_SPACE)){
+    layoutseg* prev = &l->segs[l->segcount - 1];
+    if(prev->type == type && prev->off + prev->bytes == off){
+      prev->bytes += bytes;
+      prev->cols += cols;
+      return 0;
+    }
+  }
+  if(l->segcount == l->segsize){
+    const size_t nsize = l->segsize ? l->segsize * 2 : 64;
+    layoutseg* tmp = realloc(l->segs, sizeof(*tmp) * nsize);
+    if(tmp == NULL){
+      return -1;
+    }
+    l->segs = tmp;
+    l->segsize = nsize;
+  }
+  layoutseg* seg = &l->segs[l->segcount++];
+  seg->off = off;
+  seg->bytes = bytes;
+  seg->cols = cols;
+  seg->type = type;
+  return 0;
+}
+
+// segment the text from byte |off| through its end, appending segments
+static int
+layout_segment(nclayout* l, size_t off){
+  while(off < l->textlen){
+    const char* egc = l->text + off;
+    mbstate_t mbstate = {0};
+    wchar_t w;
+    const size_t consumed = mbrtowc(&w, egc, MB_CUR_MAX, &mbstate);
+    if(consumed == (size_t)-2 || consumed == (size_t)-1){
+      logerror("invalid UTF-8 after %zu bytes", off);
+      return -1;
+    }
+    if(islinebreak(w)){
+      if(layout_push_seg(l, LAYOUT_NEWLINE, off, consumed, 0)){
+        return -1;
+      }
+      off += consumed;
+      l->parastart = l->segcount;
+      continue;
+    }
+    if(w == L'\t'){
+      if(layout_push_seg(l, LAYOUT_TAB, off, consumed, 0)){
+        return -1;
+      }
+      off += consumed;
+      continue;
+    }
+    int cols;
+    const int bytes = utf8_egc_len(egc, &cols);
+    if(bytes <= 0){
+      logerror("invalid EGC after %zu bytes", off);
+      return -1;
+    }
+    if(layout_push_seg(l, iswordbreak(w) ? LAYOUT_SPACE : LAYOUT_WORD, off, bytes, cols)){
+      return -1;
+    }
+    off += bytes;
+  }
+  return 0;
+}
+
+static layoutline*
+layout_push_line(nclayout* l, size_t seg, size_t off){
+  if(l->linecount == l->linesize){
+    const size_t nsize = l->linesize ? l->linesize * 2 : 64;
+    layoutline* tmp = realloc(l->linev, sizeof(*tmp) * nsize);
+    if(tmp == NULL){
+      return NULL;
+    }
+    l->linev = tmp;
+    l->linesize = nsize;
+  }
+  layoutline* line = &l->linev[l->linecount++];
+  line->off = off;
+  line->bytes = 0;
+  line->cols = 0;
+  line->seg = seg;
+  return line;
+}
+
+// break the word segment |seg| (wider than the lines) across as many lines as
+// it requires, starting on the empty line |cur|. returns the line holding the
+// word's remainder, or NULL on error.
+static layoutline*
+layout_split_word(nclayout* l, layoutline* cur, size_t segidx){
+  const layoutseg* seg = &l->segs[segidx];
+  size_t off = seg->off;
+  while(off < seg->off + seg->bytes){
+    int cols;
+    const int bytes = utf8_egc_len(l->text + off, &cols);
+    if(bytes <= 0){
+      return NULL;
+    }
+    if(cur->cols + cols > l->wrapcols && cur->cols){
+      if((cur = layout_push_line(l, segidx, off)) == NULL){
+        return NULL;
+      }
+    }
+    cur->bytes += bytes;
+    cur->cols += cols;
+    off += bytes;
+  }
+  return cur;
+}
+
+// wrap all segments starting with |segidx| (the first of a paragraph) into
+// lines of l->wrapcols columns, appending them. as with ncplane_puttext(),
+// lines are broken at whitespace where possible; the whitespace at which a
+// line is broken is dropped. words too wide for any line are split.
+static int
+layout_wrap(nclayout* l, size_t segidx){
+  layoutline* cur = NULL;
+  unsigned pending = 0; // columns of whitespace within cur, not yet committed
+  for( ; segidx < l->segcount ; ++segidx){
+    const layoutseg* seg = &l->segs[segidx];
+    if(cur == NULL){
+      if(seg->type == LAYOUT_SPACE || seg->type == LAYOUT_TAB){
+        if(segidx && l->segs[segidx - 1].type != LAYOUT_NEWLINE){
+          continue; // whitespace carried over from a wrap is dropped
+        }
+      }
+      if((cur = layout_push_line(l, segidx, seg->off)) == NULL){
+        return -1;
+      }
+      pending = 0;
+    }
+    if(seg->type == LAYOUT_NEWLINE){
+      cur = NULL;
+      continue;
+    }
+    unsigned cols = seg->cols;
+    if(seg->type == LAYOUT_TAB){
+      const unsigned at = cur->cols + pending;
+      cols = TABSTOP - (at % TABSTOP);
+    }
+    if(seg->type != LAYOUT_WORD){
+      if(cur->cols + pending + cols > l->wrapcols){
+        cur = NULL; // break here, dropping the whitespace
+      }else{
+        pending += cols;
+      }
+      continue;
+    }
+    if(cur->cols + pending + cols <= l->wrapcols){
+      cur->bytes = seg->off + seg->bytes - cur->off;
+      cur->cols += pending + cols;
+      pending = 0;
+      continue;
+    }
+    if(cur->cols == 0){ // drop any indentation which crowds out the word
+      cur->off = seg->off;
+      cur->seg = segidx;
+      pending = 0;
+    }else{ // doesn't fit, but might on a line of its own
+      if((cur = layout_push_line(l, segidx, seg->off)) == NULL){
+        return -1;
+      }
+      pending = 0;
+    }
+    if(cols <= l->wrapcols){
+      cur->bytes = seg->bytes;
+      cur->cols = cols;
+      continue;
+    }
+    if((cur = layout_split_word(l, cur, segidx)) == NULL){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// ensure the lines are wrapped to |cols| columns
+static int
+layout_rewrap(nclayout* l, unsigned cols){
+  if(cols == 0){
+    logerror("can't wrap to 0 columns");
+    return -1;
+  }
+  if(l->wrapcols == cols){
+    return 0;
+  }
+  l->linecount = 0;
+  l->wrapcols = cols;
+  if(layout_wrap(l, 0)){
+    l->wrapcols = 0;
+    return -1;
+  }
+  return 0;
+}
+
+nclayout* nclayout_create(const char* text){
+  nclayout* l = malloc(sizeof(*l));
+  if(l == NULL){
+    return NULL;
+  }
+  memset(l, 0, sizeof(*l));
+  if(text && nclayout_append(l, text)){
+    nclayout_destroy(l);
+    return NULL;
+  }
+  return l;
+}
+
+void nclayout_destroy(nclayout* l){
+  if(l){
+    free(l->linev);
+    free(l->segs);
+    free(l->text);
+    free(l);
+  }
+}
+
+int nclayout_append(nclayout* l, const char* text){
+  const size_t len = strlen(text);
+  if(len == 0){
+    return 0;
+  }
+  if(l->textlen + len >= UINT32_MAX){
+    logerror("layout can't exceed %" PRIu32 " bytes", UINT32_MAX);
+    return -1;
+  }
+  if(l->textlen + len + 1 > l->textsize){
+    size_t nsize = l->textsize ? l->textsize : 256;
+    while(nsize < l->textlen + len + 1){
+      nsize *= 2;
+    }
+    char* tmp = realloc(l->text, nsize);
+    if(tmp == NULL){
+      return -1;
+    }
+    l->text = tmp;
+    l->textsize = nsize;
+  }
+  memcpy(l->text + l->textlen, text, len + 1);
+  // the final paragraph (if unterminated) might be continued by the new text,
+  // and must be resegmented. its first segment begins at the paragraph start.
+  const size_t oldtextlen = l->textlen;
+  const size_t oldpara = l->parastart;
+  const size_t resumeoff = l->parastart < l->segcount ?
+                           l->segs[l->parastart].off : oldtextlen;
+  l->textlen += len;
+  l->segcount = l->parastart;
+  if(layout_segment(l, resumeoff)){
+    // leave the layout as it was, resegmenting the old final paragraph
+    l->textlen = oldtextlen;
+    l->text[oldtextlen] = '\0';
+    l->segcount = l->parastart = oldpara;
+    layout_segment(l, resumeoff);
+    return -1;
+  }
+  if(l->wrapcols){
+    // drop lines of the final paragraph, and rewrap from there
+    while(l->linecount && l->linev[l->linecount - 1].seg >= oldpara){
+      --l->linecount;
+    }
+    if(layout_wrap(l, oldpara)){
+      l->wrapcols = 0;
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int nclayout_rows(nclayout* l, unsigned cols){
+  if(layout_rewrap(l, cols)){
+    return -1;
+  }
+  return l->linecount;
+}
+
+int nclayout_render(nclayout* l, ncplane* n, int y, unsigned firstrow,
+                    ncalign_e align){
+  unsigned dimy, dimx;
+  ncplane_dim_yx(n, &dimy, &dimx);
+  if(y < 0 || (unsigned)y >= dimy){
+    logerror("invalid y: %d (%u rows)", y, dimy);
+    return -1;
+  }
+  if(layout_rewrap(l, dimx)){
+    return -1;
+  }
+  int drawn = 0;
+  for(unsigned row = y ; row < dimy ; ++row){
+    if(ncplane_erase_region(n, row, 0, 1, 0)){
+      return -1;
+    }
+    const size_t lidx = (size_t)firstrow + (row - y);
+    if(lidx >= l->linecount){
+      continue;
+    }
+    const layoutline* line = &l->linev[lidx];
+    if(line->bytes){
+      const int offset = align == NCALIGN_UNALIGNED ? 0 :
+                         notcurses_align(dimx, align, line->cols);
+      if(ncplane_putnstr_yx(n, row, offset, line->bytes, l->text + line->off) < 0){
+        return -1;
+      }
+    }
+    ++drawn;
+  }
+  return drawn;
+}
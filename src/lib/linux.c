@@ -6,7 +6,7 @@
 static inline uint8_t*
 fbcon_auxiliary_vector(const sprixel* s){
   int pixels = ncplane_pile(s->n)->cellpxy * ncplane_pile(s->n)->cellpxx;
-  uint8_t* ret = malloc(sizeof(*ret) * pixels);
+  uint8_t* ret = auxvec_get(s->apool, sizeof(*ret) * pixels);
   if(ret){
     memset(ret, 0, sizeof(*ret) * pixels);
   }
@@ -99,13 +99,15 @@ int fbcon_blit(struct ncplane* n, int linesize, const void* data,
     }
   }
   scrub_tam_boundaries(n->tam, leny, lenx, cdimy, cdimx);
+  free(s->fbdamage); // the entire glyph must be drawn
+  s->fbdamage = NULL;
   if(plane_blit_sixel(s, &s->glyph, leny, lenx, 0, n->tam, SPRIXEL_INVALIDATED) < 0){
     goto error;
   }
   return 1;
 
 error:
-  fbuf_free(&s->glyph);
+  fbufpool_put(s->fpool, &s->glyph);
   s->glyph.size = 0;
   return -1;
 }
@@ -121,6 +123,8 @@ int fbcon_scrub(const struct ncpile* p, sprixel* s){
 #include <linux/fb.h>
 #include <linux/kd.h>
 #include <sys/ioctl.h>
+#include <drm/drm.h>
+#include <drm/drm_fourcc.h>
 
 int fbcon_rebuild(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
   if(auxvec == NULL){
@@ -158,30 +162,404 @@ int fbcon_rebuild(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
   }
   s->n->tam[s->dimx * ycell + xcell].state = state;
   s->invalidated = SPRIXEL_INVALIDATED;
+  if(s->fbdamage){
+    s->fbdamage[s->dimx * ycell + xcell] = 1;
+  }
   return 1;
 }
 
+// fbcon_draw() doesn't write to the framebuffer directly. pixels are drawn
+// into a shadow of it in system memory, and the byte ranges written are
+// noted. once every sprixel has been drawn, fbcon_flush() copies the merged
+// ranges out in a single ascending pass (following the vertical retrace, if
+// the driver will tell us of it). device memory is thus written at most once
+// per pixel per raster, and never while we're still composing the frame.
+// with DRM, the shadow is instead the overlay plane's contents, and
+// drm_flush() copies the ranges to the back buffer before flipping.
+typedef struct fbspan {
+  size_t off;          // byte offset into the framebuffer
+  size_t len;          // bytes
+} fbspan;
+
+typedef struct fbshadow {
+  uint8_t* map;        // shadow framebuffer, maplen bytes
+  size_t maplen;
+  fbspan* spans;       // ranges written since the last flush
+  unsigned count;
+  unsigned alloc;
+  bool vsync;          // does the driver support FBIO_WAITFORVSYNC?
+  // we're an overlay plane (DRM) rather than the console's own framebuffer,
+  // so transparent pixels must be written (with zero alpha) and opaque ones
+  // written with full alpha.
+  bool overlay;
+} fbshadow;
+
+typedef struct drmbuf {
+  uint32_t handle;     // dumb buffer handle
+  uint32_t fb;         // framebuffer id
+  uint8_t* map;
+  size_t size;
+} drmbuf;
+
+typedef struct drmoverlay {
+  int fd;
+  uint32_t crtc;
+  uint32_t plane;
+  unsigned width, height;
+  drmbuf bufs[2];
+  unsigned front;      // index of the buffer being scanned out
+  // the spans copied into the front buffer at the last flip. the back buffer
+  // lacks them, and receives them along with the next flip's spans.
+  fbspan* prev;
+  unsigned prevcount;
+  unsigned prevalloc;
+} drmoverlay;
+
+int fbcon_init(tinfo* ti, int fd){
+  (void)fd;
+  if((ti->linux_fb_shadow = malloc(sizeof(*ti->linux_fb_shadow))) == NULL){
+    return -1;
+  }
+  memset(ti->linux_fb_shadow, 0, sizeof(*ti->linux_fb_shadow));
+  ti->linux_fb_shadow->vsync = true;
+  ti->linux_fb_shadow->overlay = ti->linux_drm != NULL;
+  return 0;
+}
+
+void fbcon_cleanup(tinfo* ti){
+  fbshadow* sh = ti->linux_fb_shadow;
+  if(sh){
+    free(sh->map);
+    free(sh->spans);
+    free(sh);
+    ti->linux_fb_shadow = NULL;
+  }
+}
+
+// get the shadow map, (re)creating it if the framebuffer was remapped. if
+// we can't, returns NULL, and we draw directly to the framebuffer.
+static uint8_t*
+fbcon_shadow_map(const tinfo* ti){
+  fbshadow* sh = ti->linux_fb_shadow;
+  if(sh == NULL){
+    return NULL;
+  }
+  if(sh->maplen != ti->linux_fb_len){
+    free(sh->map);
+    sh->maplen = 0;
+    sh->count = 0;
+    if((sh->map = malloc(ti->linux_fb_len)) == NULL){
+      return NULL;
+    }
+    sh->maplen = ti->linux_fb_len;
+  }
+  return sh->map;
+}
+
+// note that |len| bytes at |off| were written to the shadow. contiguous
+// writes (as when a row is entirely opaque) are merged as they arrive.
+static int
+fbcon_shadow_span(fbshadow* sh, size_t off, size_t len){
+  if(sh->count){
+    fbspan* last = &sh->spans[sh->count - 1];
+    if(last->off + last->len == off){
+      last->len += len;
+      return 0;
+    }
+  }
+  if(sh->count == sh->alloc){
+    unsigned nalloc = sh->alloc ? sh->alloc * 2 : 256;
+    fbspan* tmp = realloc(sh->spans, sizeof(*tmp) * nalloc);
+    if(tmp == NULL){
+      return -1;
+    }
+    sh->spans = tmp;
+    sh->alloc = nalloc;
+  }
+  sh->spans[sh->count].off = off;
+  sh->spans[sh->count].len = len;
+  ++sh->count;
+  return 0;
+}
+
+static int
+fbspan_cmp(const void* va, const void* vb){
+  const fbspan* a = va;
+  const fbspan* b = vb;
+  return a->off < b->off ? -1 : a->off > b->off;
+}
+
+// sort the spans, and merge those which overlap or abut. overlapping spans
+// hold the same (latest) bytes in the shadow, so the union of all spans can
+// be copied out in order.
+static void
+fbshadow_merge(fbshadow* sh){
+  if(sh->count < 2){
+    return;
+  }
+  qsort(sh->spans, sh->count, sizeof(*sh->spans), fbspan_cmp);
+  unsigned out = 0;
+  for(unsigned i = 1 ; i < sh->count ; ++i){
+    fbspan* cur = &sh->spans[out];
+    const fbspan* sp = &sh->spans[i];
+    if(sp->off <= cur->off + cur->len){
+      if(sp->off + sp->len > cur->off + cur->len){
+        cur->len = sp->off + sp->len - cur->off;
+      }
+    }else{
+      sh->spans[++out] = *sp;
+    }
+  }
+  sh->count = out + 1;
+}
+
+int fbcon_flush(const tinfo* ti){
+  fbshadow* sh = ti->linux_fb_shadow;
+  if(sh == NULL || sh->count == 0){
+    return 0;
+  }
+  if(sh->vsync){
+    __u32 crtc = 0;
+    if(ioctl(ti->linux_fb_fd, FBIO_WAITFORVSYNC, &crtc)){
+      loginfo("no vsync on %s (%s)", ti->linux_fb_dev, strerror(errno));
+      sh->vsync = false;
+    }
+  }
+  fbshadow_merge(sh);
+  for(unsigned i = 0 ; i < sh->count ; ++i){
+    const fbspan* sp = &sh->spans[i];
+    memcpy(ti->linux_fbuffer + sp->off, sh->map + sp->off, sp->len);
+  }
+  sh->count = 0;
+  return 0;
+}
+
+// clear (to zero alpha) the pixels of the overlay's shadow in the rectangle
+// |h|x|w| at |py|/|px|, clipped to the screen.
+static int
+fbcon_clear_rect(const tinfo* ti, int py, int px, int h, int w){
+  fbshadow* sh = ti->linux_fb_shadow;
+  if(sh == NULL || sh->map == NULL){
+    return 0;
+  }
+  if(px < 0){
+    w += px;
+    px = 0;
+  }
+  if(py < 0){
+    h += py;
+    py = 0;
+  }
+  if(px + w > (int)ti->pixx){
+    w = ti->pixx - px;
+  }
+  if(py + h > (int)ti->pixy){
+    h = ti->pixy - py;
+  }
+  for(int l = 0 ; l < h && w > 0 ; ++l){
+    const size_t off = (size_t)(py + l) * ti->linux_fb_stride
+                       + (size_t)px * ti->linux_fb_bpp;
+    memset(sh->map + off, 0, (size_t)w * ti->linux_fb_bpp);
+    if(fbcon_shadow_span(sh, off, (size_t)w * ti->linux_fb_bpp)){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// is the framebuffer laid out like our glyphs (32bpp BGRx)? if so, runs of
+// opaque pixels can be copied directly.
+static inline bool
+fbcon_native_p(const tinfo* ti){
+  return ti->linux_fb_bpp == 4 &&
+         ti->linux_fb_roff == 16 && ti->linux_fb_rlen == 8 &&
+         ti->linux_fb_goff == 8 && ti->linux_fb_glen == 8 &&
+         ti->linux_fb_boff == 0 && ti->linux_fb_blen == 8;
+}
+
+// pack a BGRA glyph pixel into the framebuffer's pixel format
+static inline uint32_t
+fbcon_pack(const tinfo* ti, const uint8_t* bgra){
+  return ((uint32_t)(bgra[2] >> (8 - ti->linux_fb_rlen)) << ti->linux_fb_roff) |
+         ((uint32_t)(bgra[1] >> (8 - ti->linux_fb_glen)) << ti->linux_fb_goff) |
+         ((uint32_t)(bgra[0] >> (8 - ti->linux_fb_blen)) << ti->linux_fb_boff);
+}
+
+// write the opaque pixels among the |len| BGRA pixels at |src| to |off|
+// within |base| (either the shadow or the framebuffer itself), leaving
+// the framebuffer untouched beneath transparent ones. returns the number of
+// bytes written, or -1 if we couldn't note a shadow span.
+static int
+fbcon_draw_span(const tinfo* ti, bool native, uint8_t* base, size_t off,
+                const uint8_t* src, int len){
+  const unsigned bpp = ti->linux_fb_bpp;
+  uint8_t* dst = base + off;
+  int wrote = 0;
+  if(ti->linux_fb_shadow && ti->linux_fb_shadow->overlay){
+    // DRM overlays are always ARGB8888, which our glyphs already are
+    for(int c = 0 ; c < len ; ++c){
+      if(src[c * 4 + 3] >= 192){
+        memcpy(dst + c * 4, src + c * 4, 3);
+        dst[c * 4 + 3] = 0xff;
+      }else{
+        memset(dst + c * 4, 0, 4);
+      }
+    }
+    if(fbcon_shadow_span(ti->linux_fb_shadow, off, (size_t)len * 4)){
+      return -1;
+    }
+    return len * 4;
+  }
+  int c = 0;
+  while(c < len){
+    while(c < len && src[c * 4 + 3] < 192){
+      ++c;
+    }
+    int run = c;
+    while(run < len && src[run * 4 + 3] >= 192){
+      ++run;
+    }
+    if(run == c){
+      break;
+    }
+    if(native){
+      memcpy(dst + c * 4, src + c * 4, (run - c) * 4);
+    }else{
+      for(int i = c ; i < run ; ++i){
+        const uint32_t pixel = fbcon_pack(ti, src + i * 4);
+        uint8_t* tl = dst + i * bpp;
+        if(bpp == 2){
+          const uint16_t p16 = pixel;
+          memcpy(tl, &p16, 2);
+        }else if(bpp == 3){
+          tl[0] = pixel;
+          tl[1] = pixel >> 8;
+          tl[2] = pixel >> 16;
+        }else{
+          memcpy(tl, &pixel, 4);
+        }
+      }
+    }
+    if(base != ti->linux_fbuffer){
+      if(fbcon_shadow_span(ti->linux_fb_shadow, off + c * bpp, (run - c) * bpp)){
+        return -1;
+      }
+    }
+    wrote += (run - c) * bpp;
+    c = run;
+  }
+  return wrote;
+}
+
+// draw pixel columns [|c0|, |c1|) of sprixel pixel rows [|l0|, |l1|) with
+// the sprixel's origin at framebuffer pixel |py|/|px|, clipped to the
+// framebuffer.
+static int
+fbcon_draw_rect(const tinfo* ti, const sprixel* s, bool native, uint8_t* base,
+                int py, int px, int l0, int l1, int c0, int c1){
+  if(px + c0 < 0){
+    c0 = -px;
+  }
+  if(px + c1 > (int)ti->pixx){
+    c1 = ti->pixx - px;
+  }
+  if(l1 > s->pixy){
+    l1 = s->pixy;
+  }
+  if(py + l1 > (int)ti->pixy){
+    l1 = ti->pixy - py;
+  }
+  if(c1 > s->pixx){
+    c1 = s->pixx;
+  }
+  int wrote = 0;
+  for(int l = l0 ; l < l1 ; ++l){
+    if(c0 >= c1){
+      break;
+    }
+    const size_t off = (size_t)(py + l) * ti->linux_fb_stride
+                       + (size_t)(px + c0) * ti->linux_fb_bpp;
+    const uint8_t* src = (const uint8_t*)s->glyph.buf + ((size_t)l * s->pixx + c0) * 4;
+    int r = fbcon_draw_span(ti, native, base, off, src, c1 - c0);
+    if(r < 0){
+      return -1;
+    }
+    wrote += r;
+  }
+  return wrote;
+}
+
+// only the cells marked in |s->fbdamage| need be copied, so long as we're
+// being drawn where we were last drawn, and the framebuffer hasn't since
+// scrolled. damaged cells are merged into horizontal spans within each row
+// of cells. if we have no damage map, everything is drawn.
 int fbcon_draw(const tinfo* ti, sprixel* s, int y, int x){
   logdebug("id %" PRIu32 " dest %d/%d", s->id, y, x);
-  int wrote = 0;
   const int cellpxy = ncplane_pile(s->n) ? ncplane_pile(s->n)->cellpxy : ti->cellpxy;
   const int cellpxx = ncplane_pile(s->n) ? ncplane_pile(s->n)->cellpxx : ti->cellpxx;
-  for(unsigned l = 0 ; l < (unsigned)s->pixy && l + y * cellpxy < ti->pixy ; ++l){
-    // FIXME pixel size isn't necessarily 4B, line isn't necessarily psize*pixx
-    size_t offset = ((l + y * cellpxy) * ti->pixx + x * cellpxx) * 4;
-    uint8_t* tl = ti->linux_fbuffer + offset;
-    const char* src = (char*)s->glyph.buf + (l * s->pixx * 4);
-    for(unsigned c = 0 ; c < (unsigned)s->pixx && c < ti->pixx ; ++c){
-      uint32_t pixel;
-      memcpy(&pixel, src, 4);
-      if(!rgba_trans_p(pixel, 0)){
-        memcpy(tl, &pixel, 4);
-        wrote += 4;
+  if(ti->linux_fb_bpp < 2 || ti->linux_fb_bpp > 4){
+    logerror("unsupported framebuffer depth %uB", ti->linux_fb_bpp);
+    return -1;
+  }
+  const bool native = fbcon_native_p(ti);
+  uint8_t* base = fbcon_shadow_map(ti);
+  if(base == NULL){
+    if((base = ti->linux_fbuffer) == MAP_FAILED){
+      return -1;
+    }
+  }
+  const int py = y * cellpxy;
+  const int px = x * cellpxx;
+  int wrote = 0;
+  // the console redraws beneath text of its own accord, but an overlay must
+  // clear where we were if we've moved (a scroll having moved us already)
+  if(ti->linux_fb_shadow && ti->linux_fb_shadow->overlay && s->fbdrawnh &&
+     (s->fbdrawny != y || s->fbdrawnx != x) && s->fbgen == ti->linux_fb_gen){
+    if(fbcon_clear_rect(ti, s->fbdrawny * cellpxy, s->fbdrawnx * cellpxx,
+                        s->fbdrawnh, s->fbdrawnw)){
+      return -1;
+    }
+  }
+  if(s->fbdamage == NULL || s->invalidated == SPRIXEL_UNSEEN ||
+     s->fbdrawny != y || s->fbdrawnx != x || s->fbgen != ti->linux_fb_gen){
+    if((wrote = fbcon_draw_rect(ti, s, native, base, py, px, 0, s->pixy, 0, s->pixx)) < 0){
+      return -1;
+    }
+    if(s->fbdamage == NULL){
+      s->fbdamage = malloc(sizeof(*s->fbdamage) * s->dimy * s->dimx);
+    }
+  }else{
+    for(unsigned ycell = 0 ; ycell < s->dimy ; ++ycell){
+      const unsigned char* drow = s->fbdamage + ycell * s->dimx;
+      unsigned xcell = 0;
+      while(xcell < s->dimx){
+        if(!drow[xcell]){
+          ++xcell;
+          continue;
+        }
+        const unsigned xstart = xcell;
+        while(xcell < s->dimx && drow[xcell]){
+          ++xcell;
+        }
+        int r = fbcon_draw_rect(ti, s, native, base, py, px,
+                                ycell * cellpxy, (ycell + 1) * cellpxy,
+                                xstart * cellpxx, xcell * cellpxx);
+        if(r < 0){
+          return -1;
+        }
+        wrote += r;
       }
-      src += 4;
-      tl += 4;
     }
   }
+  // if we couldn't get a damage map, we'll just draw everything next time
+  if(s->fbdamage){
+    memset(s->fbdamage, 0, sizeof(*s->fbdamage) * s->dimy * s->dimx);
+  }
+  s->fbdrawny = y;
+  s->fbdrawnx = x;
+  s->fbdrawnh = s->pixy;
+  s->fbdrawnw = s->pixx;
+  s->fbgen = ti->linux_fb_gen;
   return wrote;
 }
 
@@ -193,26 +571,37 @@ int fbcon_draw(const tinfo* ti, sprixel* s, int y, int x){
 // entire space; we always clear something (we might not always move anything).
 void fbcon_scroll(const struct ncpile* p, tinfo* ti, int rows){
   const int cellpxy = p->cellpxy;
-  const int cellpxx = p->cellpxx;
   if(cellpxy < 1){
     return;
   }
   logdebug("scrolling %d", rows);
-  const int rowbytes = cellpxx * p->dimx * 4;
+  ++ti->linux_fb_gen; // sprixels must redraw in their entirety
+  const size_t rowbytes = ti->linux_fb_stride;
   const int totalrows = cellpxy * p->dimy;
   int srows = rows * cellpxy; // number of pixel rows being scrolled
   if(srows > totalrows){
     srows = totalrows;
   }
-  // srows is the number of rows we're *losing*
-  uint8_t* targ = ti->linux_fbuffer;
-  uint8_t* src = ti->linux_fbuffer + srows * rowbytes;
-  unsigned tocopy = rowbytes * (totalrows - srows);
+  // srows is the number of rows we're *losing*. an overlay's contents live
+  // in its shadow, and the whole region must then be copied out.
+  fbshadow* sh = ti->linux_fb_shadow;
+  uint8_t* base = ti->linux_fbuffer;
+  if(sh && sh->overlay){
+    if((base = fbcon_shadow_map(ti)) == NULL){
+      return;
+    }
+  }
+  uint8_t* targ = base;
+  uint8_t* src = base + srows * rowbytes;
+  size_t tocopy = rowbytes * (totalrows - srows);
   if(tocopy){
     memmove(targ, src, tocopy);
   }
   targ += tocopy;
   memset(targ, 0, (totalrows * rowbytes) - tocopy);
+  if(sh && sh->overlay){
+    fbcon_shadow_span(sh, 0, totalrows * rowbytes);
+  }
 }
 
 // each row is a contiguous set of bits, starting at the msb
@@ -342,47 +731,87 @@ add_to_map(struct unimapdesc* map, wchar_t w, unsigned fidx){
   return 0;
 }
 
+// sets of line drawing characters, all of which we map to the glyph of
+// whichever member is already present
+static const struct simset {
+  const wchar_t* ws;
+} line_sets[] = {
+  {
+    .ws = L"/╱",
+  }, {
+    .ws = L"\\╲",
+  }, {
+    .ws = L"X╳☒",
+  }, {
+    .ws = L"O☐",
+  }, {
+    .ws = L"└┕┖┗╘╙╚╰",
+  }, {
+    .ws = L"┘┙┚┛╛╜╝╯",
+  }, {
+    .ws = L"┌┍┎┏╒╓╔╭",
+  }, {
+    .ws = L"┐┑┒┓╕╖╗╮",
+  }, {
+    .ws = L"─━┄┅┈┉╌╍═╼╾",
+  }, {
+    .ws = L"│┃┆┇┊┋╎╏║╽╿",
+  }, {
+    .ws = L"├┝┞┟┠┡┢┣╞╟╠",
+  }, {
+    .ws = L"┤┥┦┧┨┩┪┫╡╢╣",
+  }, {
+    .ws = L"┬┭┮┯┰┱┲┳╤╥╦",
+  }, {
+    .ws = L"┴┵┶┷┸┹┺┻╧╨╩",
+  }, {
+    .ws = L"┼┽┾┿╀╁╂╃╄╅╆╇╈╉╊╋╪╫╬",
+  },
+};
+
+// the block drawing characters we draw into the font, if they're missing
+static const wchar_t block_glyphs[] = L"▀▄▌▐▘▝▖▗▟▙▜▛▚▞▇▆▅▃▂▁";
+
+// a unipair's codepoint is a UCS2 value, so the BMP suffices
+#define UNIMAP_SEEN_WORDS (65536 / 64)
+
+static bool
+unimap_has_all(const uint64_t* seen, const wchar_t* ws){
+  for( ; *ws ; ++ws){
+    if(!(seen[*ws / 64] & (1ull << (*ws % 64)))){
+      return false;
+    }
+  }
+  return true;
+}
+
+// if the kernel's unicode map already covers everything we would add (most
+// likely because we programmed this console on an earlier run), there's no
+// need to read the font, nor to touch the console at all.
+static bool
+console_font_programmed(const struct unimapdesc* map){
+  uint64_t seen[UNIMAP_SEEN_WORDS] = {0};
+  for(unsigned idx = 0 ; idx < map->entry_ct ; ++idx){
+    const unsigned u = map->entries[idx].unicode;
+    seen[u / 64] |= 1ull << (u % 64);
+  }
+  if(!unimap_has_all(seen, block_glyphs)){
+    return false;
+  }
+  for(size_t sidx = 0 ; sidx < sizeof(line_sets) / sizeof(*line_sets) ; ++sidx){
+    if(!unimap_has_all(seen, line_sets[sidx].ws)){
+      return false;
+    }
+  }
+  return true;
+}
+
 static int
 program_line_drawing_chars(int fd, struct unimapdesc* map){
-  struct simset {
-    wchar_t* ws;
-  } sets[] = {
-    {
-      .ws = L"/╱",
-    }, {
-      .ws = L"\\╲",
-    }, {
-      .ws = L"X╳☒",
-    }, {
-      .ws = L"O☐",
-    }, {
-      .ws = L"└┕┖┗╘╙╚╰",
-    }, {
-      .ws = L"┘┙┚┛╛╜╝╯",
-    }, {
-      .ws = L"┌┍┎┏╒╓╔╭",
-    }, {
-      .ws = L"┐┑┒┓╕╖╗╮",
-    }, {
-      .ws = L"─━┄┅┈┉╌╍═╼╾",
-    }, {
-      .ws = L"│┃┆┇┊┋╎╏║╽╿",
-    }, {
-      .ws = L"├┝┞┟┠┡┢┣╞╟╠",
-    }, {
-      .ws = L"┤┥┦┧┨┩┪┫╡╢╣",
-    }, {
-      .ws = L"┬┭┮┯┰┱┲┳╤╥╦",
-    }, {
-      .ws = L"┴┵┶┷┸┹┺┻╧╨╩",
-    }, {
-      .ws = L"┼┽┾┿╀╁╂╃╄╅╆╇╈╉╊╋╪╫╬",
-    },
-  };
   int toadd = 0;
-  for(size_t sidx = 0 ; sidx < sizeof(sets) / sizeof(*sets) ; ++sidx){
+  for(size_t sidx = 0 ; sidx < sizeof(line_sets) / sizeof(*line_sets) ; ++sidx){
     int fontidx = -1;
-    struct simset* s = &sets[sidx];
+    const struct simset* s = &line_sets[sidx];
     size_t fsize = sizeof(bool) * wcslen(s->ws);
     bool* found = malloc(fsize);
     memset(found, 0, fsize);
@@ -489,10 +918,12 @@ program_block_drawing_chars(tinfo* ti, int fd, struct console_font_op* cfo,
     { .qbits = 2, .w = L'▂', .found = false, },
     { .qbits = 1, .w = L'▁', .found = false, },
   };
-  // first, take a pass to see which glyphs we already have
+  // first, take a pass to see which glyphs we already have. the map can hold
+  // more entries than the font has glyphs, and anything we added on an
+  // earlier run was appended, so check all of it.
   size_t numfound = 0;
   size_t halvesfound = 0;
-  for(unsigned i = 0 ; i < cfo->charcount ; ++i){
+  for(unsigned i = 0 ; i < map->entry_ct ; ++i){
     if(map->entries[i].unicode >= 0x2580 && map->entries[i].unicode <= 0x259f){
       for(size_t s = 0 ; s < sizeof(half) / sizeof(*half) ; ++s){
         if(map->entries[i].unicode == half[s].w){
@@ -650,6 +1081,19 @@ static int
 reprogram_linux_font(tinfo* ti, int fd, struct console_font_op* cfo,
                      struct unimapdesc* map, unsigned no_font_changes,
                      bool* halfblocks, bool* quadrants){
+  // the unimap is much smaller than the font, and tells us whether we
+  // need the font at all.
+  if(ioctl(fd, GIO_UNIMAP, map)){
+    logwarn("error reading Linux unimap (%s)", strerror(errno));
+    return -1;
+  }
+  loginfo("kernel unimap size: %u/%u", map->entry_ct, USHRT_MAX);
+  if(console_font_programmed(map)){
+    loginfo("kernel font already has our glyphs");
+    *halfblocks = true;
+    *quadrants = true;
+    return 0;
+  }
   if(ioctl(fd, KDFONTOP, cfo)){
     logwarn("error reading Linux kernelfont (%s)", strerror(errno));
     return -1;
@@ -660,11 +1104,6 @@ reprogram_linux_font(tinfo* ti, int fd, struct console_font_op* cfo,
     logwarn("warning: kernel returned excess charcount");
     return -1;
   }
-  if(ioctl(fd, GIO_UNIMAP, map)){
-    logwarn("error reading Linux unimap (%s)", strerror(errno));
-    return -1;
-  }
-  loginfo("kernel unimap size: %u/%u", map->entry_ct, USHRT_MAX);
   // for certain sets of characters, we're not going to draw them in, but we
   // do want to ensure they map to something plausible...this doesn't reset
   // the framebuffer, even if we do some reprogramming.
@@ -734,16 +1173,40 @@ int get_linux_fb_pixelgeom(tinfo* ti, unsigned* ypix, unsigned *xpix){
   if(xpix == NULL){
     xpix = &fakex;
   }
+  if(ti->linux_drm){ // the mode is fixed for our lifetime
+    *ypix = ti->linux_drm->height;
+    *xpix = ti->linux_drm->width;
+    return 0;
+  }
   struct fb_var_screeninfo fbi = {0};
   if(ioctl(ti->linux_fb_fd, FBIOGET_VSCREENINFO, &fbi)){
     logerror("no framebuffer info from %s %d (%s?)", ti->linux_fb_dev,
              ti->linux_fb_fd, strerror(errno));
     return -1;
   }
-  loginfo("linux %s geometry: %dx%d", ti->linux_fb_dev, fbi.yres, fbi.xres);
+  struct fb_fix_screeninfo ffi = {0};
+  if(ioctl(ti->linux_fb_fd, FBIOGET_FSCREENINFO, &ffi)){
+    logerror("no fixed framebuffer info from %s %d (%s?)", ti->linux_fb_dev,
+             ti->linux_fb_fd, strerror(errno));
+    return -1;
+  }
+  loginfo("linux %s geometry: %dx%d %ubpp stride %u", ti->linux_fb_dev,
+          fbi.yres, fbi.xres, fbi.bits_per_pixel, ffi.line_length);
+  if(fbi.bits_per_pixel != 16 && fbi.bits_per_pixel != 24 && fbi.bits_per_pixel != 32){
+    logerror("unsupported framebuffer depth %ubpp", fbi.bits_per_pixel);
+    return -1;
+  }
   *ypix = fbi.yres;
   *xpix = fbi.xres;
-  size_t len = *ypix * *xpix * fbi.bits_per_pixel / 8;
+  ti->linux_fb_bpp = fbi.bits_per_pixel / 8;
+  ti->linux_fb_stride = ffi.line_length ? ffi.line_length : *xpix * ti->linux_fb_bpp;
+  ti->linux_fb_roff = fbi.red.offset;
+  ti->linux_fb_rlen = fbi.red.length > 8 ? 8 : fbi.red.length;
+  ti->linux_fb_goff = fbi.green.offset;
+  ti->linux_fb_glen = fbi.green.length > 8 ? 8 : fbi.green.length;
+  ti->linux_fb_boff = fbi.blue.offset;
+  ti->linux_fb_blen = fbi.blue.length > 8 ? 8 : fbi.blue.length;
+  size_t len = ti->linux_fb_stride * *ypix;
   if(ti->linux_fb_len != len){
     if(ti->linux_fbuffer != MAP_FAILED){
       munmap(ti->linux_fbuffer, ti->linux_fb_len);
@@ -787,6 +1250,328 @@ bool is_linux_framebuffer(tinfo* ti){
   }
   return true;
 }
+
+// sprixels can instead be composed onto a DRM/KMS overlay plane above the
+// console, double-buffered with dumb buffers. each flip is a SETPLANE, which
+// the kernel completes at the vertical retrace. the console continues to own
+// the primary plane, and draws text there as it always has; our transparent
+// pixels let it through. this requires that we be DRM master (i.e. that no
+// display server is running), and that the driver expose an overlay plane
+// which can scan out ARGB8888 on the console's CRTC.
+//
+// VT switches aren't handled: we'd hold DRM master, and keep our overlay on
+// the display, across a switch to some other VT (including one wanting to
+// run a display server). the backend is thus only used when requested by
+// naming the DRM device in NOTCURSES_DRM.
+static void
+drm_free_buf(int fd, drmbuf* b){
+  if(b->map){
+    munmap(b->map, b->size);
+    b->map = NULL;
+  }
+  if(b->fb){
+    ioctl(fd, DRM_IOCTL_MODE_RMFB, &b->fb);
+    b->fb = 0;
+  }
+  if(b->handle){
+    struct drm_mode_destroy_dumb dd = { .handle = b->handle, };
+    ioctl(fd, DRM_IOCTL_MODE_DESTROY_DUMB, &dd);
+    b->handle = 0;
+  }
+}
+
+static int
+drm_alloc_buf(drmoverlay* d, drmbuf* b, uint32_t* pitch){
+  struct drm_mode_create_dumb cd = {
+    .height = d->height,
+    .width = d->width,
+    .bpp = 32,
+  };
+  if(ioctl(d->fd, DRM_IOCTL_MODE_CREATE_DUMB, &cd)){
+    logwarn("couldn't create %ux%u dumb buffer (%s)", d->width, d->height, strerror(errno));
+    return -1;
+  }
+  b->handle = cd.handle;
+  b->size = cd.size;
+  *pitch = cd.pitch;
+  struct drm_mode_fb_cmd2 fc = {
+    .width = d->width,
+    .height = d->height,
+    .pixel_format = DRM_FORMAT_ARGB8888,
+    .handles = { cd.handle, },
+    .pitches = { cd.pitch, },
+  };
+  if(ioctl(d->fd, DRM_IOCTL_MODE_ADDFB2, &fc)){
+    logwarn("couldn't add ARGB8888 framebuffer (%s)", strerror(errno));
+    drm_free_buf(d->fd, b);
+    return -1;
+  }
+  b->fb = fc.fb_id;
+  struct drm_mode_map_dumb md = { .handle = cd.handle, };
+  if(ioctl(d->fd, DRM_IOCTL_MODE_MAP_DUMB, &md)){
+    logwarn("couldn't prepare dumb buffer map (%s)", strerror(errno));
+    drm_free_buf(d->fd, b);
+    return -1;
+  }
+  b->map = mmap(NULL, b->size, PROT_READ|PROT_WRITE, MAP_SHARED, d->fd, md.offset);
+  if(b->map == MAP_FAILED){
+    logwarn("couldn't map %zuB dumb buffer (%s)", b->size, strerror(errno));
+    b->map = NULL;
+    drm_free_buf(d->fd, b);
+    return -1;
+  }
+  memset(b->map, 0, b->size);
+  return 0;
+}
+
+// scan out |b| on our overlay, covering the entire CRTC.
+static int
+drm_show(const drmoverlay* d, const drmbuf* b){
+  struct drm_mode_set_plane sp = {
+    .plane_id = d->plane,
+    .crtc_id = d->crtc,
+    .fb_id = b ? b->fb : 0,
+    .crtc_w = d->width,
+    .crtc_h = d->height,
+    .src_w = d->width << 16,
+    .src_h = d->height << 16,
+  };
+  if(ioctl(d->fd, DRM_IOCTL_MODE_SETPLANE, &sp)){
+    return -1;
+  }
+  return 0;
+}
+
+static void
+drm_destroy(drmoverlay* d){
+  if(d){
+    drm_show(d, NULL);
+    drm_free_buf(d->fd, &d->bufs[0]);
+    drm_free_buf(d->fd, &d->bufs[1]);
+    free(d->prev);
+    close(d->fd);
+    free(d);
+  }
+}
+
+// find the first CRTC which is scanning out (the console's), and its index.
+static int
+drm_find_crtc(int fd, uint32_t* crtc, unsigned* idx, unsigned* w, unsigned* h){
+  struct drm_mode_card_res res = {0};
+  if(ioctl(fd, DRM_IOCTL_MODE_GETRESOURCES, &res)){
+    return -1;
+  }
+  if(res.count_crtcs == 0){
+    return -1;
+  }
+  uint32_t* crtcs = malloc(sizeof(*crtcs) * res.count_crtcs);
+  if(crtcs == NULL){
+    return -1;
+  }
+  // only ask for the crtcs
+  const uint32_t count = res.count_crtcs;
+  memset(&res, 0, sizeof(res));
+  res.count_crtcs = count;
+  res.crtc_id_ptr = (uintptr_t)crtcs;
+  if(ioctl(fd, DRM_IOCTL_MODE_GETRESOURCES, &res)){
+    free(crtcs);
+    return -1;
+  }
+  int ret = -1;
+  for(unsigned i = 0 ; i < res.count_crtcs && i < count ; ++i){
+    struct drm_mode_crtc c = { .crtc_id = crtcs[i], };
+    if(ioctl(fd, DRM_IOCTL_MODE_GETCRTC, &c) == 0 && c.mode_valid && c.fb_id){
+      *crtc = c.crtc_id;
+      *idx = i;
+      *w = c.mode.hdisplay;
+      *h = c.mode.vdisplay;
+      ret = 0;
+      break;
+    }
+  }
+  free(crtcs);
+  return ret;
+}
+
+// find an overlay plane usable on the CRTC at |crtcidx| supporting ARGB8888.
+// without DRM_CLIENT_CAP_UNIVERSAL_PLANES, only overlays are listed.
+static int
+drm_find_plane(int fd, unsigned crtcidx, uint32_t* plane){
+  struct drm_mode_get_plane_res pres = {0};
+  if(ioctl(fd, DRM_IOCTL_MODE_GETPLANERESOURCES, &pres) || pres.count_planes == 0){
+    return -1;
+  }
+  const uint32_t count = pres.count_planes;
+  uint32_t* planes = malloc(sizeof(*planes) * count);
+  if(planes == NULL){
+    return -1;
+  }
+  pres.plane_id_ptr = (uintptr_t)planes;
+  if(ioctl(fd, DRM_IOCTL_MODE_GETPLANERESOURCES, &pres)){
+    free(planes);
+    return -1;
+  }
+  int ret = -1;
+  for(unsigned i = 0 ; i < pres.count_planes && i < count && ret ; ++i){
+    struct drm_mode_get_plane gp = { .plane_id = planes[i], };
+    if(ioctl(fd, DRM_IOCTL_MODE_GETPLANE, &gp)){
+      continue;
+    }
+    if(!(gp.possible_crtcs & (1u << crtcidx)) || gp.fb_id || gp.count_format_types == 0){
+      continue;
+    }
+    uint32_t* formats = malloc(sizeof(*formats) * gp.count_format_types);
+    if(formats == NULL){
+      break;
+    }
+    gp.format_type_ptr = (uintptr_t)formats;
+    if(ioctl(fd, DRM_IOCTL_MODE_GETPLANE, &gp) == 0){
+      for(unsigned f = 0 ; f < gp.count_format_types ; ++f){
+        if(formats[f] == DRM_FORMAT_ARGB8888){
+          *plane = gp.plane_id;
+          ret = 0;
+          break;
+        }
+      }
+    }
+    free(formats);
+  }
+  free(planes);
+  return ret;
+}
+
+bool is_linux_drm(tinfo* ti){
+  const char* dev = getenv("NOTCURSES_DRM");
+  if(dev == NULL || *dev == '\0'){
+    return false;
+  }
+  loginfo("checking for DRM at %s", dev);
+  int fd = open(dev, O_RDWR | O_CLOEXEC);
+  if(fd < 0){
+    logdebug("couldn't open DRM device %s", dev);
+    return false;
+  }
+  struct drm_get_cap cap = { .capability = DRM_CAP_DUMB_BUFFER, };
+  if(ioctl(fd, DRM_IOCTL_GET_CAP, &cap) || !cap.value){
+    logdebug("no dumb buffers on %s", dev);
+    close(fd);
+    return false;
+  }
+  drmoverlay* d = malloc(sizeof(*d));
+  if(d == NULL){
+    close(fd);
+    return false;
+  }
+  memset(d, 0, sizeof(*d));
+  d->fd = fd;
+  unsigned crtcidx;
+  if(drm_find_crtc(fd, &d->crtc, &crtcidx, &d->width, &d->height)){
+    logdebug("no active CRTC on %s", dev);
+    drm_destroy(d);
+    return false;
+  }
+  if(drm_find_plane(fd, crtcidx, &d->plane)){
+    logdebug("no usable overlay plane on %s", dev);
+    drm_destroy(d);
+    return false;
+  }
+  uint32_t pitch0, pitch1;
+  if(drm_alloc_buf(d, &d->bufs[0], &pitch0) || drm_alloc_buf(d, &d->bufs[1], &pitch1)){
+    drm_destroy(d);
+    return false;
+  }
+  if(pitch0 != pitch1){
+    logwarn("dumb buffer pitches differ (%u != %u)", pitch0, pitch1);
+    drm_destroy(d);
+    return false;
+  }
+  // this is the first operation requiring DRM master
+  if(drm_show(d, &d->bufs[0])){
+    loginfo("couldn't enable overlay %u (%s), not DRM master?", d->plane, strerror(errno));
+    drm_destroy(d);
+    return false;
+  }
+  loginfo("DRM overlay %u on crtc %u: %ux%u pitch %u", d->plane, d->crtc,
+          d->width, d->height, pitch0);
+  ti->linux_drm = d;
+  ti->pixy = d->height;
+  ti->pixx = d->width;
+  ti->linux_fb_bpp = 4;
+  ti->linux_fb_stride = pitch0;
+  ti->linux_fb_len = (size_t)pitch0 * d->height;
+  ti->linux_fb_roff = 16;
+  ti->linux_fb_goff = 8;
+  ti->linux_fb_boff = 0;
+  ti->linux_fb_rlen = ti->linux_fb_glen = ti->linux_fb_blen = 8;
+  return true;
+}
+
+int drm_flush(const tinfo* ti){
+  fbshadow* sh = ti->linux_fb_shadow;
+  drmoverlay* d = ti->linux_drm;
+  if(sh == NULL || sh->count == 0 || sh->map == NULL){
+    return 0;
+  }
+  fbshadow_merge(sh);
+  drmbuf* back = &d->bufs[!d->front];
+  for(unsigned i = 0 ; i < d->prevcount ; ++i){
+    const fbspan* sp = &d->prev[i];
+    memcpy(back->map + sp->off, sh->map + sp->off, sp->len);
+  }
+  for(unsigned i = 0 ; i < sh->count ; ++i){
+    const fbspan* sp = &sh->spans[i];
+    memcpy(back->map + sp->off, sh->map + sp->off, sp->len);
+  }
+  if(drm_show(d, back)){
+    logerror("couldn't flip overlay %u (%s)", d->plane, strerror(errno));
+    return -1;
+  }
+  d->front = !d->front;
+  // what we just copied is what the new back buffer lacks
+  fbspan* tmp = d->prev;
+  const unsigned tmpalloc = d->prevalloc;
+  d->prev = sh->spans;
+  d->prevcount = sh->count;
+  d->prevalloc = sh->alloc;
+  sh->spans = tmp;
+  sh->alloc = tmpalloc;
+  sh->count = 0;
+  return 0;
+}
+
+// text overwriting an overlay sprixel must clear it from the overlay, so
+// wiped cells are redrawn (with zero alpha).
+int drm_wipe(sprixel* s, int ycell, int xcell){
+  int r = fbcon_wipe(s, ycell, xcell);
+  if(r == 0){
+    if(s->fbdamage){
+      s->fbdamage[s->dimx * ycell + xcell] = 1;
+    }
+    if(s->invalidated == SPRIXEL_QUIESCENT){
+      s->invalidated = SPRIXEL_INVALIDATED;
+    }
+  }
+  return r;
+}
+
+// a hidden sprixel must be cleared from the overlay.
+int drm_scrub(const ncpile* p, sprixel* s){
+  const tinfo* ti = &p->nc->tcache;
+  if(s->fbdrawnh && s->fbgen == ti->linux_fb_gen){
+    if(fbcon_clear_rect(ti, s->fbdrawny * p->cellpxy, s->fbdrawnx * p->cellpxx,
+                        s->fbdrawnh, s->fbdrawnw)){
+      return -1;
+    }
+    s->fbdrawnh = 0;
+  }
+  return sixel_scrub(p, s);
+}
+
+void drm_cleanup(tinfo* ti){
+  fbcon_cleanup(ti);
+  drm_destroy(ti->linux_drm);
+  ti->linux_drm = NULL;
+}
 #else
 int fbcon_rebuild(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
   (void)s;
@@ -810,6 +1595,16 @@ void fbcon_scroll(const struct ncpile* p, tinfo* ti, int rows){
   (void)rows;
 }
 
+int fbcon_flush(const tinfo* ti){
+  (void)ti;
+  return 0;
+}
+
+bool is_linux_drm(tinfo* ti){
+  (void)ti;
+  return false;
+}
+
 int get_linux_fb_pixelgeom(tinfo* ti, unsigned* ypix, unsigned *xpix){
   (void)ti;
   (void)ypix;
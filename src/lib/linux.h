@@ -22,7 +22,9 @@ bool is_linux_console(int fd);
 // framebuffer. if ti has mapped the framebuffer, it will be copied and
 // unmapped before we reprogram. after reprogramming, it is remapped, and
 // the old contents are copied in, then freed. there will be an unavoidable
-// flicker while this happens.
+// flicker while this happens. if the unicode map shows that all our glyphs
+// are already present (e.g. from an earlier run), the font is neither read
+// nor written.
 int reprogram_console_font(struct tinfo* ti, unsigned no_font_changes,
                            bool* halfblocks, bool* quadrants);
 
@@ -30,8 +32,13 @@ int reprogram_console_font(struct tinfo* ti, unsigned no_font_changes,
 // a drawable framebuffer console. do not call if not a verified console!
 bool is_linux_framebuffer(struct tinfo* ti);
 
-// call only on an fd where is_linux_framebuffer() returned true. gets the
-// pixel geometry for the visual area.
+// if is_linux_console() returned true, call this to determine whether we can
+// draw to a DRM/KMS overlay plane above the console. this is preferred to
+// the framebuffer, when available (it requires that we be DRM master).
+bool is_linux_drm(struct tinfo* ti);
+
+// call only on an fd where is_linux_framebuffer() (or is_linux_drm())
+// returned true. gets the pixel geometry for the visual area.
 int get_linux_fb_pixelgeom(struct tinfo* ti, unsigned* ypix, unsigned *xpix);
 
 #ifdef __cplusplus
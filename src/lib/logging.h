@@ -19,6 +19,26 @@ nclog(const char* fmt, ...){
   va_end(va);
 }
 
+// with NCOPTION_LOG_RING, messages more verbose than warnings are copied
+// unformatted into per-thread rings (see logring.c), to be formatted only
+// when dumped. warnings and worse are always written immediately.
+extern bool nclogring_enabled;
+
+void nclog_defer(const char* func, int line, const char* fmt, ...)
+  __attribute__ ((format (printf, 3, 4)));
+
+// the ring is reference counted across contexts, and enabled iff the first
+// reference asks for it. the last reference writes out what's left to |fp|.
+void logring_init(bool enable);
+int logring_fini(FILE* fp);
+
+#define nclog_deferrable(fmt, ...) \
+  if(__atomic_load_n(&nclogring_enabled, __ATOMIC_RELAXED)){ \
+    nclog_defer(__func__, __LINE__, fmt, ##__VA_ARGS__); \
+  }else{ \
+    nclog("%s:%d:" fmt NL, __func__, __LINE__, ##__VA_ARGS__); \
+  }
+
 #define logpanic(fmt, ...) do{ \
   if(loglevel >= NCLOGLEVEL_PANIC){ \
     nclog("%s:%d:" fmt NL, __func__, __LINE__, ##__VA_ARGS__); } \
@@ -41,22 +61,22 @@ nclog(const char* fmt, ...){
 
 #define loginfo(fmt, ...) do{ \
   if(loglevel >= NCLOGLEVEL_INFO){ \
-    nclog("%s:%d:" fmt NL, __func__, __LINE__, ##__VA_ARGS__); } \
+    nclog_deferrable(fmt, ##__VA_ARGS__); } \
   } while(0);
 
 #define logverbose(fmt, ...) do{ \
   if(loglevel >= NCLOGLEVEL_VERBOSE){ \
-    nclog("%s:%d:" fmt NL, __func__, __LINE__, ##__VA_ARGS__); } \
+    nclog_deferrable(fmt, ##__VA_ARGS__); } \
   } while(0);
 
 #define logdebug(fmt, ...) do{ \
   if(loglevel >= NCLOGLEVEL_DEBUG){ \
-    nclog("%s:%d:" fmt NL, __func__, __LINE__, ##__VA_ARGS__); } \
+    nclog_deferrable(fmt, ##__VA_ARGS__); } \
   } while(0);
 
 #define logtrace(fmt, ...) do{ \
   if(loglevel >= NCLOGLEVEL_TRACE){ \
-    nclog("%s:%d:" fmt NL, __func__, __LINE__, ##__VA_ARGS__); } \
+    nclog_deferrable(fmt, ##__VA_ARGS__); } \
   } while(0);
 
 #ifdef __cplusplus
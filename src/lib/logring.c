@@ -0,0 +1,484 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stddef.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#include "internal.h"
+
+// with NCOPTION_LOG_RING, messages more verbose than warnings aren't written
+// as they're logged. instead, the format string, the call site, and the raw
+// arguments are copied into a ring belonging to the logging thread, and only
+// formatted once dumped (see notcurses_log_dump()). recording a message thus
+// costs a walk of its format string and a copy of its arguments, and takes no
+// locks. once a ring fills, its oldest messages are overwritten. as with
+// trace.c, rings are linked into a global list when created, and a ring
+// whose thread has exited is marked dead, to be freed at the last
+// notcurses_stop().
+//
+// each record carries a sequence number, zero while the record is being
+// written, so that a dump racing a logger can skip (rather than misprint) a
+// torn record. a message which can't be captured (too many arguments, or an
+// unknown conversion) is instead formatted into its record immediately.
+#define LOGRING_RECORDS 2048
+#define LOGRING_ARGS 8
+#define LOGRING_STRBYTES 120
+
+typedef enum {
+  LOGARG_INT,    // any integer, sign-extended or zero-extended into i
+  LOGARG_DOUBLE, // any floating point value
+  LOGARG_PTR,    // %p
+  LOGARG_STR,    // offset of a NUL-terminated copy within strs
+} logarg_e;
+
+typedef struct logrecord {
+  uint64_t seq;          // 0 while being written
+  uint64_t ts;           // CLOCK_MONOTONIC ns
+  const char* func;
+  const char* fmt;       // NULL if strs holds the formatted message
+  int line;
+  unsigned char nargs;
+  unsigned char types[LOGRING_ARGS]; // logarg_e of each argument
+  union {
+    int64_t i;
+    double d;
+    const void* p;
+    unsigned s;
+  } args[LOGRING_ARGS];
+  char strs[LOGRING_STRBYTES];
+} logrecord;
+
+typedef struct logring {
+  struct logring* next;
+  unsigned tid;
+  bool dead;
+  uint64_t seq;          // records ever written into this ring
+  uint64_t dumped;       // records up through this one have been dumped
+  logrecord rec[LOGRING_RECORDS];
+} logring;
+
+bool nclogring_enabled;
+
+static pthread_mutex_t logring_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t logring_once = PTHREAD_ONCE_INIT;
+static pthread_key_t logring_key;
+static logring* rings;
+static unsigned refs;
+static __thread logring* myring;
+
+static void
+logring_orphan(void* vring){
+  logring* r = vring;
+  pthread_mutex_lock(&logring_lock);
+    r->dead = true;
+  pthread_mutex_unlock(&logring_lock);
+}
+
+static void
+logring_key_create(void){
+  if(pthread_key_create(&logring_key, logring_orphan)){
+    fprintf(stderr, "couldn't create log ring key" NL);
+  }
+}
+
+static unsigned
+logring_tid(void){
+#ifdef __linux__
+  return syscall(SYS_gettid);
+#else
+  static unsigned nexttid = 1;
+  return __atomic_fetch_add(&nexttid, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+static logring*
+logring_get(void){
+  logring* r = myring;
+  if(r){
+    return r;
+  }
+  if((r = malloc(sizeof(*r))) == NULL){
+    return NULL;
+  }
+  r->tid = logring_tid();
+  r->dead = false;
+  r->seq = 0;
+  r->dumped = 0;
+  for(unsigned i = 0 ; i < LOGRING_RECORDS ; ++i){
+    r->rec[i].seq = 0;
+  }
+  pthread_once(&logring_once, logring_key_create);
+  pthread_setspecific(logring_key, r);
+  pthread_mutex_lock(&logring_lock);
+    r->next = rings;
+    rings = r;
+  pthread_mutex_unlock(&logring_lock);
+  myring = r;
+  return r;
+}
+
+// a single printf conversion specification, as found by logspec_parse().
+typedef struct logspec {
+  size_t len;       // bytes of the specification, including the '%'
+  int stars;        // '*' widths and precisions, each consuming an int
+  int prec;         // explicit precision, -1 for none, -2 for '*'
+  char conv;        // conversion character
+  char lenmod[3];   // length modifier, NUL-terminated
+} logspec;
+
+// parse the specification at |fmt| (which points just past a '%'). returns
+// -1 for anything we don't know how to capture.
+static int
+logspec_parse(const char* fmt, logspec* spec){
+  const char* c = fmt;
+  spec->stars = 0;
+  spec->prec = -1;
+  while(*c && strchr("-+ #0'", *c)){
+    ++c;
+  }
+  if(*c == '*'){
+    ++spec->stars;
+    ++c;
+  }
+  while(*c >= '0' && *c <= '9'){
+    ++c;
+  }
+  if(*c == '.'){
+    ++c;
+    if(*c == '*'){
+      ++spec->stars;
+      spec->prec = -2;
+      ++c;
+    }else{
+      spec->prec = 0;
+    }
+    while(*c >= '0' && *c <= '9'){
+      spec->prec = spec->prec * 10 + (*c - '0');
+      ++c;
+    }
+  }
+  size_t m = 0;
+  while(*c && strchr("hljztLq", *c) && m < sizeof(spec->lenmod) - 1){
+    spec->lenmod[m++] = *c++;
+  }
+  spec->lenmod[m] = '\0';
+  if(*c == '\0' || !strchr("diouxXcsfFeEgGaAp%", *c)){
+    return -1;
+  }
+  spec->conv = *c;
+  spec->len = c - fmt + 2;
+  return 0;
+}
+
+// pull the integer described by |spec| off of |va|.
+static int64_t
+logspec_int(const logspec* spec, va_list* va){
+  const bool sgn = spec->conv == 'd' || spec->conv == 'i';
+  const char* l = spec->lenmod;
+  if(strcmp(l, "l") == 0){
+    return sgn ? va_arg(*va, long) : (int64_t)va_arg(*va, unsigned long);
+  }else if(strcmp(l, "ll") == 0 || strcmp(l, "q") == 0){
+    return sgn ? va_arg(*va, long long) : (int64_t)va_arg(*va, unsigned long long);
+  }else if(strcmp(l, "j") == 0){
+    return sgn ? va_arg(*va, intmax_t) : (int64_t)va_arg(*va, uintmax_t);
+  }else if(strcmp(l, "z") == 0){
+    return sgn ? (int64_t)va_arg(*va, ssize_t) : (int64_t)va_arg(*va, size_t);
+  }else if(strcmp(l, "t") == 0){
+    return va_arg(*va, ptrdiff_t);
+  }
+  // hh, h, and no modifier all arrive promoted to int
+  return sgn ? va_arg(*va, int) : (int64_t)va_arg(*va, unsigned);
+}
+
+// capture |fmt|'s arguments into |rec|. returns -1 if they can't be.
+static int
+logrecord_capture(logrecord* rec, const char* fmt, va_list* va){
+  unsigned strused = 0;
+  rec->nargs = 0;
+  for(const char* c = fmt ; (c = strchr(c, '%')) ; ){
+    logspec spec;
+    if(logspec_parse(c + 1, &spec)){
+      return -1;
+    }
+    c += spec.len;
+    if(spec.conv == '%'){
+      continue;
+    }
+    if(rec->nargs + spec.stars + 1 > LOGRING_ARGS){
+      return -1;
+    }
+    for(int s = 0 ; s < spec.stars ; ++s){
+      rec->types[rec->nargs] = LOGARG_INT;
+      rec->args[rec->nargs++].i = va_arg(*va, int);
+    }
+    const unsigned a = rec->nargs++;
+    switch(spec.conv){
+      case 's': {
+        const char* s = va_arg(*va, const char*);
+        if(s == NULL){
+          s = "(null)";
+        }
+        // a precision might bound a string which isn't NUL-terminated
+        int prec = spec.prec;
+        if(prec == -2){
+          prec = rec->args[a - 1].i;
+        }
+        size_t len = prec >= 0 ? strnlen(s, prec) : strlen(s);
+        if(strused >= LOGRING_STRBYTES){
+          return -1;
+        }
+        if(len > LOGRING_STRBYTES - strused - 1){
+          len = LOGRING_STRBYTES - strused - 1;
+        }
+        memcpy(rec->strs + strused, s, len);
+        rec->strs[strused + len] = '\0';
+        rec->types[a] = LOGARG_STR;
+        rec->args[a].s = strused;
+        strused += len + 1;
+        break;
+      }
+      case 'p':
+        rec->types[a] = LOGARG_PTR;
+        rec->args[a].p = va_arg(*va, const void*);
+        break;
+      case 'f': case 'F': case 'e': case 'E':
+      case 'g': case 'G': case 'a': case 'A':
+        rec->types[a] = LOGARG_DOUBLE;
+        if(strcmp(spec.lenmod, "L") == 0){
+          rec->args[a].d = va_arg(*va, long double);
+        }else{
+          rec->args[a].d = va_arg(*va, double);
+        }
+        break;
+      default: // d i o u x X c
+        rec->types[a] = LOGARG_INT;
+        rec->args[a].i = logspec_int(&spec, va);
+        break;
+    }
+  }
+  return 0;
+}
+
+void nclog_defer(const char* func, int line, const char* fmt, ...){
+  logring* r = logring_get();
+  if(r == NULL){
+    return;
+  }
+  const uint64_t seq = r->seq + 1;
+  __atomic_store_n(&r->seq, seq, __ATOMIC_RELAXED);
+  logrecord* rec = &r->rec[seq % LOGRING_RECORDS];
+  __atomic_store_n(&rec->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  rec->ts = timespec_to_ns(&ts);
+  rec->func = func;
+  rec->line = line;
+  rec->fmt = fmt;
+  va_list va;
+  va_start(va, fmt);
+  if(logrecord_capture(rec, fmt, &va)){
+    va_end(va);
+    va_start(va, fmt);
+    vsnprintf(rec->strs, sizeof(rec->strs), fmt, va);
+    rec->fmt = NULL;
+  }
+  va_end(va);
+  __atomic_store_n(&rec->seq, seq, __ATOMIC_RELEASE);
+}
+
+// format the captured message |rec| to |fp|.
+static int
+logrecord_write(FILE* fp, const logrecord* rec, unsigned tid){
+  if(fprintf(fp, "%" PRIu64 ".%06u %u %s:%d:", rec->ts / NANOSECS_IN_SEC,
+             (unsigned)(rec->ts % NANOSECS_IN_SEC / 1000), tid,
+             rec->func, rec->line) < 0){
+    return -1;
+  }
+  if(rec->fmt == NULL){
+    return fprintf(fp, "%s" NL, rec->strs) < 0 ? -1 : 0;
+  }
+  unsigned a = 0;
+  const char* c = rec->fmt;
+  const char* pct;
+  while( (pct = strchr(c, '%')) ){
+    if(fwrite(c, 1, pct - c, fp) != (size_t)(pct - c)){
+      return -1;
+    }
+    logspec spec;
+    logspec_parse(pct + 1, &spec); // succeeded when captured
+    c = pct + spec.len;
+    if(spec.conv == '%'){
+      if(fputc('%', fp) == EOF){
+        return -1;
+      }
+      continue;
+    }
+    // rebuild the specification, dropping any length modifier in favor of
+    // the widest type of its class, into which the argument was captured.
+    char sfmt[32];
+    size_t slen = spec.len - 1 - strlen(spec.lenmod);
+    if(slen + 4 > sizeof(sfmt)){
+      return -1;
+    }
+    sfmt[0] = '%';
+    memcpy(sfmt + 1, pct + 1, slen - 1);
+    int stars[2] = { 0, 0 };
+    for(int s = 0 ; s < spec.stars ; ++s){
+      stars[s] = rec->args[a++].i;
+    }
+    const unsigned v = a++;
+    int r;
+    switch(rec->types[v]){
+      case LOGARG_STR:
+        sfmt[slen++] = 's';
+        sfmt[slen] = '\0';
+        r = spec.stars == 2 ? fprintf(fp, sfmt, stars[0], stars[1], rec->strs + rec->args[v].s) :
+            spec.stars == 1 ? fprintf(fp, sfmt, stars[0], rec->strs + rec->args[v].s) :
+            fprintf(fp, sfmt, rec->strs + rec->args[v].s);
+        break;
+      case LOGARG_PTR:
+        sfmt[slen++] = 'p';
+        sfmt[slen] = '\0';
+        r = spec.stars == 2 ? fprintf(fp, sfmt, stars[0], stars[1], rec->args[v].p) :
+            spec.stars == 1 ? fprintf(fp, sfmt, stars[0], rec->args[v].p) :
+            fprintf(fp, sfmt, rec->args[v].p);
+        break;
+      case LOGARG_DOUBLE:
+        sfmt[slen++] = spec.conv;
+        sfmt[slen] = '\0';
+        r = spec.stars == 2 ? fprintf(fp, sfmt, stars[0], stars[1], rec->args[v].d) :
+            spec.stars == 1 ? fprintf(fp, sfmt, stars[0], rec->args[v].d) :
+            fprintf(fp, sfmt, rec->args[v].d);
+        break;
+      default:
+        if(spec.conv == 'c'){
+          sfmt[slen++] = 'c';
+          sfmt[slen] = '\0';
+          r = spec.stars == 2 ? fprintf(fp, sfmt, stars[0], stars[1], (int)rec->args[v].i) :
+              spec.stars == 1 ? fprintf(fp, sfmt, stars[0], (int)rec->args[v].i) :
+              fprintf(fp, sfmt, (int)rec->args[v].i);
+        }else{
+          sfmt[slen++] = 'l';
+          sfmt[slen++] = 'l';
+          sfmt[slen++] = spec.conv;
+          sfmt[slen] = '\0';
+          r = spec.stars == 2 ? fprintf(fp, sfmt, stars[0], stars[1], (long long)rec->args[v].i) :
+              spec.stars == 1 ? fprintf(fp, sfmt, stars[0], (long long)rec->args[v].i) :
+              fprintf(fp, sfmt, (long long)rec->args[v].i);
+        }
+        break;
+    }
+    if(r < 0){
+      return -1;
+    }
+  }
+  if(fputs(c, fp) == EOF || fputs(NL, fp) == EOF){
+    return -1;
+  }
+  return 0;
+}
+
+typedef struct logentry {
+  logrecord rec;
+  unsigned tid;
+} logentry;
+
+static int
+logentry_cmp(const void* va, const void* vb){
+  const logentry* a = va;
+  const logentry* b = vb;
+  return a->rec.ts < b->rec.ts ? -1 : a->rec.ts > b->rec.ts;
+}
+
+// call with logring_lock held. copy out each ring's undumped records, skipping
+// any being rewritten as we look, and write them out oldest first.
+static int
+logring_dump_locked(FILE* fp){
+  size_t count = 0;
+  for(const logring* r = rings ; r ; r = r->next){
+    const uint64_t seq = __atomic_load_n(&r->seq, __ATOMIC_ACQUIRE);
+    const uint64_t pending = seq - r->dumped;
+    count += pending > LOGRING_RECORDS ? LOGRING_RECORDS : pending;
+  }
+  if(count == 0){
+    return 0;
+  }
+  logentry* entries = malloc(sizeof(*entries) * count);
+  if(entries == NULL){
+    return -1;
+  }
+  size_t used = 0;
+  for(logring* r = rings ; r ; r = r->next){
+    const uint64_t seq = __atomic_load_n(&r->seq, __ATOMIC_ACQUIRE);
+    uint64_t first = r->dumped + 1;
+    if(seq - r->dumped > LOGRING_RECORDS){
+      first = seq - LOGRING_RECORDS + 1;
+    }
+    for(uint64_t s = first ; s <= seq && used < count ; ++s){
+      const logrecord* rec = &r->rec[s % LOGRING_RECORDS];
+      if(__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != s){
+        continue;
+      }
+      memcpy(&entries[used].rec, rec, sizeof(*rec));
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if(__atomic_load_n(&rec->seq, __ATOMIC_RELAXED) != s){
+        continue;
+      }
+      entries[used++].tid = r->tid;
+    }
+    r->dumped = seq;
+  }
+  qsort(entries, used, sizeof(*entries), logentry_cmp);
+  int ret = 0;
+  for(size_t i = 0 ; i < used && ret == 0 ; ++i){
+    ret = logrecord_write(fp, &entries[i].rec, entries[i].tid);
+  }
+  free(entries);
+  return ret;
+}
+
+int notcurses_log_dump(notcurses* nc __attribute__ ((unused)), FILE* fp){
+  pthread_mutex_lock(&logring_lock);
+    int ret = logring_dump_locked(fp);
+  pthread_mutex_unlock(&logring_lock);
+  if(fflush(fp) == EOF){
+    ret = -1;
+  }
+  return ret;
+}
+
+void logring_init(bool enable){
+  pthread_mutex_lock(&logring_lock);
+    if(refs++ == 0 && enable){
+      __atomic_store_n(&nclogring_enabled, true, __ATOMIC_RELAXED);
+    }
+  pthread_mutex_unlock(&logring_lock);
+}
+
+int logring_fini(FILE* fp){
+  int ret = 0;
+  pthread_mutex_lock(&logring_lock);
+    if(refs == 0 || --refs){
+      pthread_mutex_unlock(&logring_lock);
+      return 0;
+    }
+    __atomic_store_n(&nclogring_enabled, false, __ATOMIC_RELAXED);
+    ret = logring_dump_locked(fp);
+    logring** pr = &rings;
+    logring* r;
+    while( (r = *pr) ){
+      if(r->dead){
+        *pr = r->next;
+        free(r);
+      }else{
+        pr = &r->next;
+      }
+    }
+  pthread_mutex_unlock(&logring_lock);
+  return ret;
+}
@@ -16,6 +16,7 @@ typedef struct ncmenu_int_section {
   ncmenu_int_item* items; // items, NULL iff itemcount == 0
   ncinput shortcut;       // shortcut, will be underlined if present in name
   int xoff;               // column offset from beginning of menu bar
+  int namecols;           // columns occupied by name
   int bodycols;           // column width of longest item
   int itemselected;       // current item selected, -1 for no selection
   int shortcut_offset;    // column offset within name of shortcut EGC
@@ -32,6 +33,7 @@ typedef struct ncmenu {
   uint64_t dissectchannels; // styling for disabled section headers
   uint64_t sectionchannels; // styling for sections
   uint64_t disablechannels; // styling for disabled entries
+  ncboxstyle boxstyle;      // unrolled section border, from headerchannels
   bool bottom;              // are we on the bottom (vs top)?
 } ncmenu;
 
@@ -54,7 +56,7 @@ mbstr_find_codepoint(const char* s, uint32_t cp, int* col){
     if(towlower(cp) == towlower(w)){
       return bytes;
     }
-    *col += wcwidth(w);
+    *col += ncwidth(w);
     bytes += r;
   }
   return -1;
@@ -212,6 +214,7 @@ dup_menu_sections(ncmenu* ncm, const ncmenu_options* opts, unsigned* totalwidth,
       if(cols < 0 || (ncm->sections[i].name = strdup(opts->sections[i].name)) == NULL){
         goto err;
       }
+      ncm->sections[i].namecols = cols;
       if(dup_menu_section(&ncm->sections[i], &opts->sections[i])){
         free(ncm->sections[i].name);
         goto err;
@@ -242,6 +245,7 @@ dup_menu_sections(ncmenu* ncm, const ncmenu_options* opts, unsigned* totalwidth,
       ncm->sections[i].items = NULL;
       ncm->sections[i].itemcount = 0;
       ncm->sections[i].xoff = -1;
+      ncm->sections[i].namecols = 0;
       ncm->sections[i].bodycols = 0;
       ncm->sections[i].itemselected = -1;
       ncm->sections[i].shortcut_offset = -1;
@@ -277,14 +281,14 @@ section_x(const ncmenu* ncm, int x){
       if(x < pos){
         break;
       }
-      if(x < pos + ncstrwidth(ncm->sections[i].name, NULL, NULL)){
+      if(x < pos + ncm->sections[i].namecols){
         return i;
       }
     }else{
       if(x < ncm->sections[i].xoff){
         break;
       }
-      if(x < ncm->sections[i].xoff + ncstrwidth(ncm->sections[i].name, NULL, NULL)){
+      if(x < ncm->sections[i].xoff + ncm->sections[i].namecols){
         return i;
       }
     }
@@ -345,7 +349,7 @@ write_header(ncmenu* ncm){
         }
         nccell_release(ncm->ncp, &cl);
       }
-      xoff += ncstrwidth(ncm->sections[i].name, NULL, NULL);
+      xoff += ncm->sections[i].namecols;
     }
   }
   while(xoff < dimx){
@@ -366,12 +370,14 @@ resize_menu(ncplane* n){
     return -1;
   }
   ncmenu* menu = ncplane_userptr(n);
+  if(write_header(menu)){
+    return -1;
+  }
   int unrolled = menu->unrolledsection;
   if(unrolled < 0){
-    return write_header(menu);
+    return 0;
   }
-  ncplane_erase(n); // "rolls up" section without resetting unrolledsection
-  return ncmenu_unroll(menu, unrolled);
+  return ncmenu_unroll(menu, unrolled); // redraws the section at its new place
 }
 
 ncmenu* ncmenu_create(ncplane* n, const ncmenu_options* opts){
@@ -425,7 +431,10 @@ ncmenu* ncmenu_create(ncplane* n, const ncmenu_options* opts){
           nccell_set_bg_alpha(&c, NCALPHA_TRANSPARENT);
           ncplane_set_base_cell(ret->ncp, &c);
           nccell_release(ret->ncp, &c);
-          if(write_header(ret) == 0){
+          const char* boxchars = notcurses_canutf8(ncplane_notcurses(n)) ?
+                                 NCBOXROUND : NCBOXASCII;
+          if(ncboxstyle_init(&ret->boxstyle, boxchars, 0, ret->headerchannels) == 0 &&
+             write_header(ret) == 0){
             return ret;
           }
         }
@@ -474,10 +483,7 @@ int ncmenu_unroll(ncmenu* n, int sectionidx){
     xpos = dimx - (width + 2);
   }
   int ypos = n->bottom ? dimy - height - 1 : 1;
-  if(ncplane_cursor_move_yx(n->ncp, ypos, xpos)){
-    return -1;
-  }
-  if(ncplane_rounded_box_sized(n->ncp, 0, n->headerchannels, height, width, 0)){
+  if(ncplane_box_styled(n->ncp, &n->boxstyle, ypos, xpos, height, width, 0)){
     return -1;
   }
   ncmenu_int_section* sec = &n->sections[sectionidx];
@@ -556,8 +562,10 @@ int ncmenu_rollup(ncmenu* n){
     return 0;
   }
   n->unrolledsection = -1;
-  ncplane_erase(n->ncp);
-  return write_header(n);
+  // the header is unaffected by unrolling, and needn't be redrawn. erase
+  // only the rows below (or, for a bottom menu, above) it.
+  const unsigned dimy = ncplane_dim_y(n->ncp);
+  return ncplane_erase_region(n->ncp, n->bottom ? 0 : 1, 0, dimy - 1, 0);
 }
 
 int ncmenu_nextsection(ncmenu* n){
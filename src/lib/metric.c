@@ -1,4 +1,3 @@
-#include <fenv.h>
 #include <string.h>
 #include <locale.h>
 #include <pthread.h>
@@ -6,42 +5,150 @@
 #include "notcurses/notcurses.h"
 #include "internal.h"
 
-static const wchar_t UTF8_SUBPREFIX[] = L"mµnpfazy"; // 10^24-1
-static const wchar_t ASCII_SUBPREFIX[] = L"munpfazy"; // 10^24-1
-static const wchar_t* SUBPREFIXES = ASCII_SUBPREFIX;
-static pthread_once_t utf8_detector = PTHREAD_ONCE_INIT;
+// these two must have the same number of elements
+static const char PREFIXES[] = "KMGTPEZY"; // 10^21-1 encompasses 2^64-1
+static const char* const UTF8_SUBPREFIXES[] = { // 10^24-1
+  "m", "µ", "n", "p", "f", "a", "z", "y",
+};
+static const char* const ASCII_SUBPREFIXES[] = { // 10^24-1
+  "m", "u", "n", "p", "f", "a", "z", "y",
+};
+static const char* const* SUBPREFIXES = ASCII_SUBPREFIXES;
+// the locale's decimal separator, as %f would have used it
+static char DECISEP[8] = ".";
+static pthread_once_t locale_detector = PTHREAD_ONCE_INIT;
 
-// sure hope we've called setlocale() by the time we hit this!
+// sure hope we've called setlocale() by the time we hit this! we don't
+// consult the locale again, so output never depends on (nor touches) any
+// state which might be changing beneath us.
 static void
-detect_utf8(void){
+detect_locale(void){
   const char* encoding = nl_langinfo(CODESET);
   if(encoding){
     if(strcmp(encoding, "UTF-8") == 0){
-      SUBPREFIXES = UTF8_SUBPREFIX;
+      SUBPREFIXES = UTF8_SUBPREFIXES;
     }
   }
+  const struct lconv* lc = localeconv();
+  if(lc && lc->decimal_point && *lc->decimal_point){
+    if(strlen(lc->decimal_point) < sizeof(DECISEP)){
+      strcpy(DECISEP, lc->decimal_point);
+    }
+  }
+}
+
+// write the decimal digits of |v| to |dst|, returning the number written.
+static size_t
+emit_digits(char* dst, uintmax_t v){
+  char rev[sizeof(v) * 3];
+  size_t n = 0;
+  do{
+    rev[n++] = '0' + v % 10;
+    v /= 10;
+  }while(v);
+  for(size_t i = 0 ; i < n ; ++i){
+    dst[i] = rev[n - 1 - i];
+  }
+  return n;
+}
+
+// the next decimal digit of |*rem| / |den| (where *rem < den), leaving the
+// new remainder in |*rem|. when 10 * *rem would overflow, it's instead
+// accumulated modulo den.
+static inline unsigned
+next_digit(uintmax_t* rem, uintmax_t den){
+  if(*rem <= UINTMAX_MAX / 10){
+    const uintmax_t t = *rem * 10;
+    *rem = t % den;
+    return t / den;
+  }
+  uintmax_t acc = 0;
+  unsigned d = 0;
+  for(int i = 0 ; i < 10 ; ++i){
+    if(acc >= den - *rem){
+      acc -= den - *rem;
+      ++d;
+    }else{
+      acc += *rem;
+    }
+  }
+  *rem = acc;
+  return d;
+}
+
+// |num| / |den| lies exactly halfway between hundredths |h| and h + 1. %.2f
+// rounded the nearest double instead, which usually lies to one side (and
+// otherwise went to even). we reproduce that by working out the rounding of
+// the double's 53-bit mantissa, a bit at a time.
+static bool
+tie_rounds_up(uintmax_t num, uintmax_t den, unsigned h){
+  uintmax_t q = num / den;
+  uintmax_t r = num % den;
+  bool lastbit = q & 1;
+  bool seenone = q;
+  int bits = 53;
+  while(q){
+    --bits;
+    q >>= 1;
+  }
+  while(bits > 0){
+    const bool bit = r >= den - r;
+    r = bit ? r - (den - r) : r + r;
+    seenone |= bit;
+    if(seenone){
+      lastbit = bit;
+      --bits;
+    }
+  }
+  // r / den is now whatever remains beyond the mantissa, in units of its ulp
+  if(r == 0){ // the double was exact
+    return h % 2;
+  }
+  if(r != den - r){
+    return r > den - r;
+  }
+  return lastbit;
+}
+
+// write |num| / |den| to two decimal places, rounded to nearest as %.2f
+// would have, returning the number of bytes written.
+static size_t
+emit_hundredths(char* dst, uintmax_t num, uintmax_t den){
+  uintmax_t q = num / den;
+  uintmax_t rem = num % den;
+  unsigned h = next_digit(&rem, den) * 10;
+  h += next_digit(&rem, den);
+  if(rem > den - rem || (rem && rem == den - rem && tie_rounds_up(num, den, h))){
+    if(++h == 100){
+      h = 0;
+      ++q;
+    }
+  }
+  size_t n = emit_digits(dst, q);
+  const size_t seplen = strlen(DECISEP);
+  memcpy(dst + n, DECISEP, seplen);
+  n += seplen;
+  dst[n++] = '0' + h / 10;
+  dst[n++] = '0' + h % 10;
+  return n;
 }
 
 const char* ncnmetric(uintmax_t val, size_t s, uintmax_t decimal,
                       char* buf, int omitdec, uintmax_t mult,
                       int uprefix){
-  // FIXME this is global to the process...ick :/
-  fesetround(FE_TONEAREST);
-  pthread_once(&utf8_detector, detect_utf8);
-  // these two must have the same number of elements
-  const wchar_t* subprefixes = SUBPREFIXES;
-  const wchar_t prefixes[] = L"KMGTPEZY"; // 10^21-1 encompasses 2^64-1
+  pthread_once(&locale_detector, detect_locale);
   if(decimal == 0 || mult == 0){
     return NULL;
   }
   if(decimal > UINTMAX_MAX / 10){
     return NULL;
   }
+  const size_t prefixcount = sizeof(PREFIXES) - 1;
   unsigned consumed = 0;
   uintmax_t dv = mult;
   if(decimal <= val || val == 0){
     // FIXME verify that input < 2^89, wish we had static_assert() :/
-    while((val / decimal) >= dv && consumed < sizeof(prefixes) / sizeof(*prefixes)){
+    while((val / decimal) >= dv && consumed < prefixcount){
       dv *= mult;
       ++consumed;
       if(UINTMAX_MAX / dv < mult){ // near overflow--can't scale dv again
@@ -49,15 +156,17 @@ const char* ncnmetric(uintmax_t val, size_t s, uintmax_t decimal,
       }
     }
   }else{
-    while(val < decimal && consumed < sizeof(prefixes) / sizeof(*prefixes)){
+    while(val < decimal && consumed < prefixcount){
       val *= mult;
       ++consumed;
-      if(UINTMAX_MAX / dv < mult){ // near overflow--can't scale dv again
+      if(UINTMAX_MAX / val < mult){ // near overflow--can't scale val again
         break;
       }
     }
   }
-  int sprintfed;
+  // digits, separator, two decimals, a (possibly two-byte) prefix, uprefix
+  char out[sizeof(uintmax_t) * 3 + sizeof(DECISEP) + 8];
+  size_t n;
   if(dv != mult){ // if consumed == 0, dv must equal mult
     if((val / decimal) / dv > 0){
       ++consumed;
@@ -65,54 +174,37 @@ const char* ncnmetric(uintmax_t val, size_t s, uintmax_t decimal,
       dv /= mult;
     }
     val /= decimal;
-    // Remainder is val % dv, but we want a percentage as scaled integer.
-    // Ideally we would multiply by 100 and divide the result by dv, for
-    // maximum accuracy (dv might not be a multiple of 10--it is not for
-    // 1,024). That can overflow with large 64-bit values, but we can first
-    // divide both sides by mult, and then scale by 100.
     if(omitdec && (val % dv) == 0){
-      sprintfed = snprintf(buf, s, "%" PRIu64 "%lc", (uint64_t)(val / dv),
-                          (wint_t)prefixes[consumed - 1]);
+      n = emit_digits(out, val / dv);
     }else{
-      sprintfed = snprintf(buf, s, "%.2f%lc", (double)val / dv,
-                          (wint_t)prefixes[consumed - 1]);
-    }
-    if(sprintfed < 0){
-      return NULL;
+      n = emit_hundredths(out, val, dv);
     }
-    if(uprefix){
-      if((size_t)sprintfed < s){
-        buf[sprintfed] = uprefix;
-        buf[++sprintfed] = '\0';
-      }
-    }
-    return buf;
-  }
-  // unscaled output, consumed == 0, dv == mult
-  // val / decimal < dv (or we ran out of prefixes)
-  if(omitdec && val % decimal == 0){
-    if(consumed){
-      sprintfed = snprintf(buf, s, "%" PRIu64 "%lc", (uint64_t)(val / decimal),
-                          (wint_t)subprefixes[consumed - 1]);
+    out[n++] = PREFIXES[consumed - 1];
+  }else{
+    // unscaled output, consumed == 0, dv == mult
+    // val / decimal < dv (or we ran out of prefixes)
+    if(omitdec && val % decimal == 0){
+      n = emit_digits(out, val / decimal);
     }else{
-      sprintfed = snprintf(buf, s, "%" PRIu64, (uint64_t)(val / decimal));
+      n = emit_hundredths(out, val, decimal);
     }
-  }else{
     if(consumed){
-      sprintfed = snprintf(buf, s, "%.2f%lc", (double)val / decimal,
-                          (wint_t)subprefixes[consumed - 1]);
-    }else{
-      sprintfed = snprintf(buf, s, "%.2f", (double)val / decimal);
+      const char* sub = SUBPREFIXES[consumed - 1];
+      const size_t sublen = strlen(sub);
+      memcpy(out + n, sub, sublen);
+      n += sublen;
     }
   }
-  if(sprintfed < 0){
-    return NULL;
+  if(uprefix && consumed){
+    out[n++] = uprefix;
   }
-  if(consumed && uprefix){
-    if((size_t)sprintfed < s){
-      buf[sprintfed] = uprefix;
-      buf[++sprintfed] = '\0';
+  // as snprintf() would, truncate to fit |s|
+  if(s){
+    if(n >= s){
+      n = s - 1;
     }
+    memcpy(buf, out, n);
+    buf[n] = '\0';
   }
   return buf;
 }
@@ -2,20 +2,8 @@
 
 int mouse_setup(tinfo* ti, unsigned eventmask){
   if(ti->qterm == TERMINAL_LINUX){
-    if(eventmask == 0){
-      if(ti->gpmfd < 0){
-        return 0;
-      }
-      ti->gpmfd = -1;
-      return gpm_close(ti);
-    }
-    if(ti->gpmfd < 0){
-      // FIXME pass in eventmask
-      if((ti->gpmfd = gpm_connect(ti)) < 0){
-        return -1;
-      }
-    }
-    return 0;
+    // FIXME pass in eventmask
+    return inputlayer_gpm(ti, eventmask != 0);
   }
   if(ti->ttyfd < 0){
     logerror("no tty, not emitting mouse control\n");
@@ -19,7 +19,6 @@
 #include "banner.h"
 
 #define ESC "\x1b"
-#define TABSTOP 8
 
 void notcurses_version_components(int* major, int* minor, int* patch, int* tweak){
   *major = NOTCURSES_VERNUM_MAJOR;
@@ -29,6 +28,7 @@ void notcurses_version_components(int* major, int* minor, int* patch, int* tweak
 }
 
 int notcurses_enter_alternate_screen(notcurses* nc){
+  raster_writer_wait(nc->rwriter);
   if(nc->tcache.ttyfd < 0){
     return -1;
   }
@@ -40,6 +40,7 @@ int notcurses_enter_alternate_screen(notcurses* nc){
 }
 
 int notcurses_leave_alternate_screen(notcurses* nc){
+  raster_writer_wait(nc->rwriter);
   if(nc->tcache.ttyfd < 0){
     return -1;
   }
@@ -143,6 +144,9 @@ notcurses_stop_minimal(void* vnc){
   }
   if(nc->tcache.ttyfd >= 0){
     ret |= notcurses_mice_disable(nc);
+    if(nc->tcache.bracketedpaste){
+      ret |= notcurses_paste_enable(nc, false);
+    }
     if(nc->tcache.tpreserved){
       ret |= tcsetattr(nc->tcache.ttyfd, TCSAFLUSH, nc->tcache.tpreserved);
     }
@@ -348,7 +352,7 @@ int update_term_dimensions(unsigned* rows, unsigned* cols, tinfo* tcache,
   unsigned cpixy;
   unsigned cpixx;
 #ifdef __linux__
-  if(tcache->linux_fb_fd >= 0){
+  if(tcache->linux_fb_fd >= 0 || tcache->linux_drm){
     get_linux_fb_pixelgeom(tcache, &tcache->pixy, &tcache->pixx);
     cpixy = tcache->pixy / *rows;
     cpixx = tcache->pixx / *cols;
@@ -453,49 +457,263 @@ free_sprixels(ncpile* n){
 static void
 ncpile_destroy(ncpile* pile){
   if(pile){
+    if(pile->nc->deferredpile == pile){
+      pile->nc->deferredpile = NULL;
+    }
+    if(pile->rasterizer){
+      rasterizer_unbind(pile->rasterizer);
+    }
+    mirrors_unbind(pile);
     pile->prev->next = pile->next;
     pile->next->prev = pile->prev;
     free_sprixels(pile);
+    if(pile->interns){
+      loginfo("interned %d EGCs (%" PRIu64 " shared acquisitions)",
+              pile->interns->used, pile->interns->hits);
+      egcintern_destroy(pile->interns);
+    }
     free(pile->crender);
+    free(pile->rgnrender);
+    free(pile->dmgspans);
+    free(pile->unsolved);
+    free(pile->sprixwork);
+    free(pile->rsprixels);
+    free(pile->rsprixidx);
+    ncpile_capture_free(pile);
+    planeindex_free(&pile->pindex);
+    free(pile->txplanes);
     free(pile);
   }
 }
 
-void free_plane(ncplane* p){
-  if(p){
-    // ncdirect fakes an ncplane with no ->pile
-    if(ncplane_pile(p)){
-      notcurses* nc = ncplane_notcurses(p);
-      pthread_mutex_lock(&nc->stats.lock);
-        --ncplane_notcurses(p)->stats.s.planes;
-        ncplane_notcurses(p)->stats.s.fbbytes -= sizeof(*p->fb) * p->leny * p->lenx;
-      pthread_mutex_unlock(&nc->stats.lock);
-      if(p->above == NULL && p->below == NULL){
-        pthread_mutex_lock(&nc->pilelock);
-          ncpile_destroy(ncplane_pile(p));
-        pthread_mutex_unlock(&nc->pilelock);
+// drop any references |n|'s framebuffer (and base cell, if |base| is set)
+// holds against its pile's intern table.
+static void
+ncplane_release_interned(ncplane* n, bool base){
+  if(base && cell_interned_p(&n->basecell)){
+    pool_release(&n->pool, &n->basecell);
+  }
+  const size_t cells = n->leny * n->lenx;
+  for(size_t i = 0 ; i < cells && n->pool.interned ; ++i){
+    if(cell_interned_p(&n->fb[i])){
+      if(n->fbshare){
+        // each sharer holds its own references, but the cells aren't ours
+        egcintern_release(n->pool.interns, cell_egc_idx(&n->fb[i]));
+        --n->pool.interned;
+      }else{
+        pool_release(&n->pool, &n->fb[i]);
       }
     }
-    if(p->widget){
-      void* w = p->widget;
-      void (*wdestruct)(void*) = p->wdestruct;
-      p->widget = NULL;
-      p->wdestruct = NULL;
-      logdebug("calling widget destructor %p(%p)", wdestruct, w);
-      wdestruct(w);
-      logdebug("got the widget");
+  }
+}
+
+// drop a reference to a shared framebuffer and EGCpool. returns true if it
+// was the last (or there was no sharing), and they ought be freed.
+static bool
+fbshare_drop(fbshare* share){
+  if(share == NULL){
+    return true;
+  }
+  if(__atomic_sub_fetch(&share->refs, 1, __ATOMIC_ACQ_REL)){
+    return false;
+  }
+  free(share);
+  return true;
+}
+
+int ncplane_unshare(ncplane* n){
+  fbshare* share = n->fbshare;
+  if(__atomic_load_n(&share->refs, __ATOMIC_ACQUIRE) == 1){
+    // everyone else has since gone their own way
+    n->fbshare = NULL;
+    free(share);
+    return 0;
+  }
+  const size_t fbsize = sizeof(*n->fb) * n->capy * n->lenx;
+  nccell* fb = malloc(fbsize);
+  if(fb == NULL){
+    logerror("couldn't copy %zuB shared framebuffer", fbsize);
+    return -1;
+  }
+  egcpool pool;
+  egcpool_init(&pool);
+  if(egcpool_dup(&pool, &n->pool)){
+    logerror("couldn't copy %dB shared egcpool", n->pool.poolsize);
+    free(fb);
+    return -1;
+  }
+  memcpy(fb, n->fb, fbsize);
+  // our references to interned EGCs were taken at ncplane_dup(), and come
+  // along with the cells.
+  pool.interns = n->pool.interns;
+  pool.interned = n->pool.interned;
+  nccell* sharedfb = n->fb;
+  egcpool sharedpool = n->pool;
+  n->fb = fb;
+  n->pool = pool;
+  n->fbshare = NULL;
+  if(fbshare_drop(share)){ // the others left while we were copying
+    free(sharedfb);
+    egcpool_dump(&sharedpool);
+  }
+  return 0;
+}
+
+// widgets create and destroy small planes in bulk (one per tree item, per
+// menu section, per tooltip). rather than being freed, up to
+// NCPLANE_CACHE_DEPTH destroyed planes are retained by their notcurses
+// context, along with their framebuffers when those are unshared and hold
+// no more than NCPLANE_CACHE_CELLS cells. a plane's framebuffer always holds
+// at least capy * lenx cells; a retained one is realloc()ed should the new
+// plane need more, so it remains an ordinary heap block.
+#define NCPLANE_CACHE_DEPTH 64
+#define NCPLANE_CACHE_CELLS 64
+
+// retain |p| (and, if p->fbcached is non-zero, its fb) for reuse. returns
+// -1 if the cache is full, in which case the caller must free them.
+static int
+ncplane_cache_put(notcurses* nc, ncplane* p){
+  int ret = -1;
+  pthread_mutex_lock(&nc->pilelock);
+  if(nc->planecached < NCPLANE_CACHE_DEPTH){
+    p->above = nc->planecache;
+    nc->planecache = p;
+    ++nc->planecached;
+    ret = 0;
+  }
+  pthread_mutex_unlock(&nc->pilelock);
+  return ret;
+}
+
+static ncplane*
+ncplane_cache_take(notcurses* nc){
+  pthread_mutex_lock(&nc->pilelock);
+  ncplane* p = nc->planecache;
+  if(p){
+    nc->planecache = p->above;
+    --nc->planecached;
+  }
+  pthread_mutex_unlock(&nc->pilelock);
+  return p;
+}
+
+// free all retained planes. only call once no other thread can be
+// creating or destroying planes.
+static void
+ncplane_cache_drain(notcurses* nc){
+  ncplane* p;
+  while( (p = nc->planecache) ){
+    nc->planecache = p->above;
+    if(p->fbcached){
+      free(p->fb);
     }
-    if(p->sprite){
-      sprixel_hide(p->sprite);
+    free(p);
+  }
+  nc->planecached = 0;
+}
+
+static void ncpile_tx_forget(ncpile* p, ncplane* n);
+
+// the first half of free_plane(): drop everything |p| holds which refers to
+// its pile, its notcurses context, or other planes, running its widget's
+// destructor. afterwards, only |p|'s own memory remains, to be released by
+// reclaim_plane(). returns |p|'s notcurses context, or NULL for ncdirect's
+// fake planes.
+static notcurses*
+retire_plane(ncplane* p){
+  // release our interned EGCs while our pile (and its table) still exists
+  scrollback_free(p);
+  canvas_free(p);
+  ncplane_release_interned(p, true);
+  // ncdirect fakes an ncplane with no ->pile
+  notcurses* nc = ncplane_pile(p) ? ncplane_notcurses(p) : NULL;
+  if(nc){
+    ncplane_layer_free(p);
+    prof_retire_plane(nc, p);
+    if(nc->animator){
+      ncanimator_forget(nc->animator, p);
+    }
+    stats_lock(&nc->stats);
+      --nc->stats.s.planes;
+      nc->stats.s.fbbytes -= sizeof(*p->fb) * p->capy * p->lenx;
+    stats_unlock(&nc->stats);
+    if(ncplane_pile(p)->scrollplane == p){
+      ncplane_pile(p)->scrollplane = NULL;
+      ncplane_pile(p)->planescrolls = 0;
+    }
+    if(p->txlisted){
+      ncpile_tx_forget(ncplane_pile(p), p);
+    }
+    if(p->above == NULL && p->below == NULL){
+      pthread_mutex_lock(&nc->pilelock);
+        ncpile_destroy(ncplane_pile(p));
+      pthread_mutex_unlock(&nc->pilelock);
     }
-    destroy_tam(p);
+  }
+  if(p->widget){
+    void* w = p->widget;
+    void (*wdestruct)(void*) = p->wdestruct;
+    p->widget = NULL;
+    p->wdestruct = NULL;
+    logdebug("calling widget destructor %p(%p)", wdestruct, w);
+    wdestruct(w);
+    logdebug("got the widget");
+  }
+  if(p->sprite){
+    sprixel_hide(p->sprite);
+  }
+  destroy_tam(p);
+  return nc;
+}
+
+// the second half of free_plane(): release (or retain for reuse) the memory
+// of a plane already passed through retire_plane().
+static void
+reclaim_plane(notcurses* nc, ncplane* p){
+  p->fbcached = 0;
+  if(fbshare_drop(p->fbshare)){
     egcpool_dump(&p->pool);
-    free(p->name);
-    free(p->fb);
+    if(nc && p->capy * p->lenx <= NCPLANE_CACHE_CELLS){
+      p->fbcached = p->capy * p->lenx;
+    }else{
+      free(p->fb);
+    }
+  }
+  free(p->name);
+  if(!nc || ncplane_cache_put(nc, p)){
+    if(p->fbcached){
+      free(p->fb);
+    }
     free(p);
   }
 }
 
+void free_plane(ncplane* p){
+  if(p){
+    reclaim_plane(retire_plane(p), p);
+  }
+}
+
+// reclaim the planes retired by ncplane_destroy_family() with
+// NCPLANE_DESTROY_DEFERRED. called once a frame has been written, and when
+// stopping.
+void ncplane_reap(notcurses* nc){
+  pthread_mutex_lock(&nc->pilelock);
+  ncplane* p = nc->planegrave;
+  nc->planegrave = NULL;
+  pthread_mutex_unlock(&nc->pilelock);
+  unsigned reaped = 0;
+  while(p){
+    ncplane* tmp = p->above;
+    reclaim_plane(nc, p);
+    ++reaped;
+    p = tmp;
+  }
+  if(reaped){
+    logdebug("reclaimed %u deferred planes", reaped);
+  }
+}
+
 // create a new ncpile. only call with pilelock held. the return value
 // was assigned to n->pile.
 __attribute__((malloc))
@@ -526,7 +744,40 @@ make_ncpile(notcurses* nc, ncplane* n){
     ret->crender = NULL;
     ret->crenderlen = 0;
     ret->sprixelcache = NULL;
+    ret->unsolved = NULL;
+    ret->sprixwork = NULL;
+    ret->sprixworklen = ret->sprixworkcap = 0;
+    ret->rsprixels = NULL;
+    ret->rsprixelslen = ret->rsprixelscap = 0;
+    ret->rsprixidx = NULL;
+    ret->rsprixidxlen = 0;
+    ret->unsolvedlen = 0;
     ret->scrolls = 0;
+    ret->scrollplane = NULL;
+    ret->planescrolls = 0;
+    ret->rgntop = ret->rgnrows = 0;
+    ret->rgnscrolls = 0;
+    ret->dmgbeg = ret->dmgend = 0;
+    ret->solvedbeg = ret->solvedend = 0;
+    ret->solvedbegx = ret->solvedendx = 0;
+    ret->rgnrender = NULL;
+    ret->rgnrenderlen = 0;
+    ret->spanbeg = ret->spanend = 0;
+    ret->dmgall = true;
+    ret->dmgspans = NULL;
+    ret->dmgspanslen = 0;
+    ret->spansvalid = false;
+    ret->interns = NULL;
+    ret->rasterizer = NULL;
+    ret->mirrors = NULL;
+    ret->capframe = NULL;
+    ret->txdepth = 0;
+    ret->txplanes = NULL;
+    ret->txplaneslen = ret->txplanescap = 0;
+    egcpool_init(&ret->cappool);
+    ret->capdimy = ret->capdimx = 0;
+    memset(&ret->pindex, 0, sizeof(ret->pindex));
+    ret->pindex.stale = true;
   }
   n->pile = ret;
   return ret;
@@ -566,15 +817,26 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
              nopts->rows, nopts->cols);
     return NULL;
   }
-  ncplane* p = malloc(sizeof(*p));
+  ncplane* p = nc ? ncplane_cache_take(nc) : NULL;
   if(p == NULL){
-    return NULL;
+    if((p = malloc(sizeof(*p))) == NULL){
+      return NULL;
+    }
+    p->fbcached = 0;
   }
   p->scrolling = nopts->flags & NCPLANE_OPTION_VSCROLL;
   p->fixedbound = nopts->flags & NCPLANE_OPTION_FIXED;
   p->autogrow = nopts->flags & NCPLANE_OPTION_AUTOGROW;
+  p->history = NULL;
+  p->canvas = NULL;
+  p->mods = 0;
+  p->txmoved = p->txresize = p->txlisted = false;
+  p->layer = NULL;
+  p->inlayer = NULL;
   p->widget = NULL;
   p->wdestruct = NULL;
+  p->prof_paint_ns = p->prof_paints = 0;
+  p->prof_sprixel_ns = p->prof_sprixels = 0;
   if(nopts->flags & NCPLANE_OPTION_MARGINALIZED){
     p->margin_b = nopts->margin_b;
     p->margin_r = nopts->margin_r;
@@ -595,13 +857,22 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
     p->lenx = nopts->cols;
   }
   size_t fbsize = sizeof(*p->fb) * (p->leny * p->lenx);
-  if((p->fb = malloc(fbsize)) == NULL){
-    logerror("error allocating cellmatrix (r=%d, c=%d)",
-             p->leny, p->lenx);
-    free(p);
-    return NULL;
+  if(p->fbcached < p->leny * p->lenx){
+    nccell* fb = realloc(p->fbcached ? p->fb : NULL, fbsize);
+    if(fb == NULL){
+      logerror("error allocating cellmatrix (r=%d, c=%d)",
+               p->leny, p->lenx);
+      if(p->fbcached){
+        free(p->fb);
+      }
+      free(p);
+      return NULL;
+    }
+    p->fb = fb;
   }
+  p->fbcached = 0;
   memset(p->fb, 0, fbsize);
+  p->capy = p->leny;
   p->x = p->y = 0;
   p->logrow = 0;
   p->sprite = NULL;
@@ -643,6 +914,7 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
   p->stylemask = 0;
   p->channels = 0;
   egcpool_init(&p->pool);
+  p->fbshare = NULL;
   nccell_init(&p->basecell);
   p->userptr = nopts->userptr;
   if(nc == NULL){ // fake ncplane backing ncdirect object
@@ -653,6 +925,7 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
     pthread_mutex_lock(&nc->pilelock);
       ncpile* pile = n ? ncplane_pile(n) : NULL;
       if( (p->pile = pile) ){ // existing pile
+        p->pool.interns = pile->interns;
         p->above = NULL;
         if( (p->below = pile->top) ){ // always happens save initial plane
           pile->top->above = p;
@@ -663,10 +936,12 @@ ncplane* ncplane_new_internal(notcurses* nc, ncplane* n,
       }else{ // new pile
         make_ncpile(nc, p);
       }
-      pthread_mutex_lock(&nc->stats.lock);
+      ncpile_index_stale(ncplane_pile(p));
+      ncplane_damage(p);
+      stats_lock(&nc->stats);
         nc->stats.s.fbbytes += fbsize;
         ++nc->stats.s.planes;
-      pthread_mutex_unlock(&nc->stats.lock);
+      stats_unlock(&nc->stats);
     pthread_mutex_unlock(&nc->pilelock);
   }
   loginfo("created new %dx%d plane \"%s\" @ %dx%d",
@@ -706,6 +981,22 @@ ncplane* ncpile_create(notcurses* nc, const struct ncplane_options* nopts){
   return ncplane_new_internal(nc, NULL, nopts);
 }
 
+int ncpile_intern_egcs(ncplane* n){
+  ncpile* pile = ncplane_pile(n);
+  if(pile->interns){
+    return 0;
+  }
+  if((pile->interns = egcintern_create()) == NULL){
+    return -1;
+  }
+  // existing cells stay where they are; only new EGCs are interned
+  for(ncplane* p = pile->top ; p ; p = p->below){
+    p->pool.interns = pile->interns;
+  }
+  loginfo("interning EGCs for pile %p", pile);
+  return 0;
+}
+
 void ncplane_home(ncplane* n){
   n->x = 0;
   n->y = 0;
@@ -766,17 +1057,38 @@ ncplane* ncplane_dup(const ncplane* n, void* opaque){
     .resizecb = ncplane_resizecb(n),
     .flags = 0,
   };
+  // the copy shares our framebuffer and EGCpool until one of us writes to
+  // them (see ncplane_own()), so that duplication is O(1). the share count
+  // isn't part of the plane's contents, so a const source may take it.
+  fbshare* share = n->fbshare;
+  if(share == NULL){
+    if((share = malloc(sizeof(*share))) == NULL){
+      return NULL;
+    }
+    share->refs = 1;
+  }
   ncplane* newn = ncplane_create(n->boundto, &nopts);
   if(newn == NULL){
+    if(share != n->fbshare){
+      free(share);
+    }
     return NULL;
   }
+  ((ncplane*)n)->fbshare = share;
+  __atomic_add_fetch(&share->refs, 1, __ATOMIC_RELAXED);
   // we don't duplicate sprites...though i'm unsure why not
-  size_t fbsize = sizeof(*n->fb) * dimx * dimy;
-  if(egcpool_dup(&newn->pool, &n->pool)){
-    ncplane_destroy(newn);
-    return NULL;
-  }
-  memmove(newn->fb, n->fb, fbsize);
+  free(newn->fb);
+  egcpool_dump(&newn->pool);
+  newn->fb = n->fb;
+  newn->pool = n->pool;
+  newn->pool.interned = 0; // we take our own references below
+  newn->fbshare = share;
+  notcurses* nc = ncplane_notcurses(newn);
+  stats_lock(&nc->stats);
+    nc->stats.s.fbbytes += sizeof(*n->fb) * (n->capy - newn->capy) * n->lenx;
+  stats_unlock(&nc->stats);
+  newn->capy = n->capy;
+  newn->logrow = n->logrow;
   // don't use ncplane_cursor_move_yx() here; the cursor could be in an
   // invalid location, which will be disallowed, failing out.
   newn->y = n->y;
@@ -786,22 +1098,153 @@ ncplane* ncplane_dup(const ncplane* n, void* opaque){
   newn->channels = ncplane_channels(n);
   // we dupd the egcpool, so just dup the goffset
   newn->basecell = n->basecell;
+  // we're in the same pile, and thus share any intern table. our copies of
+  // interned cells need their own references.
+  if(n->pool.interned){
+    const size_t cells = dimy * dimx;
+    for(size_t i = 0 ; i <= cells ; ++i){
+      const nccell* c = i < cells ? &newn->fb[i] : &newn->basecell;
+      if(cell_interned_p(c)){
+        ++newn->pool.interns->slots[cell_egc_idx(c)].refs;
+        ++newn->pool.interned;
+      }
+    }
+  }
   return newn;
 }
 
+// put |n| on its pile's list of planes with deferred work.
+static int
+ncpile_tx_list(ncpile* p, ncplane* n){
+  if(n->txlisted){
+    return 0;
+  }
+  if(p->txplaneslen == p->txplanescap){
+    unsigned ncap = p->txplanescap ? p->txplanescap * 2 : 16;
+    ncplane** tmp = realloc(p->txplanes, sizeof(*tmp) * ncap);
+    if(tmp == NULL){
+      return -1;
+    }
+    p->txplanes = tmp;
+    p->txplanescap = ncap;
+  }
+  p->txplanes[p->txplaneslen++] = n;
+  n->txlisted = true;
+  return 0;
+}
+
+static void
+ncpile_tx_forget(ncpile* p, ncplane* n){
+  for(unsigned i = 0 ; i < p->txplaneslen ; ++i){
+    if(p->txplanes[i] == n){
+      p->txplanes[i] = NULL;
+      break;
+    }
+  }
+  n->txlisted = false;
+}
+
 // call the resize callback for each bound child in turn. we only need to do
 // the first generation; if they resize, they'll invoke
 // ncplane_resize_internal(), leading to this function being called anew.
+// within a pile transaction, the callbacks are instead invoked at commit,
+// once apiece no matter how often their parents were resized.
 int resize_callbacks_children(ncplane* n){
   int ret = 0;
+  ncpile* p = ncplane_pile(n);
   for(struct ncplane* child = n->blist ; child ; child = child->bnext){
     if(child->resizecb){
+      if(p->txdepth && ncpile_tx_list(p, child) == 0){
+        child->txresize = true;
+        continue;
+      }
       ret |= child->resizecb(child);
     }
   }
   return ret;
 }
 
+// rows to allocate when |n| must grow beyond its capacity to |ylen| rows.
+// autogrow planes double their capacity. other planes growing by a little
+// (e.g. a pane being dragged larger a line at a time) get a quarter again,
+// so that a run of such growth needn't realloc() each time.
+static unsigned
+fb_capacity(const ncplane* n, unsigned ylen){
+  if(n->autogrow){
+    return n->capy * 2 > ylen ? n->capy * 2 : ylen;
+  }
+  if(ylen - n->leny <= n->leny / 8){
+    return ylen + ylen / 4;
+  }
+  return ylen;
+}
+
+// release any EGCs in the |count| cells at |c|.
+static inline void
+release_cells(ncplane* n, nccell* c, unsigned count){
+  for(unsigned i = 0 ; i < count ; ++i){
+    if(cell_extended_p(&c[i])){
+      pool_release(&n->pool, &c[i]);
+    }
+  }
+}
+
+// release the EGCs of any cells outside rows [keepy, keepy + keepleny) and
+// columns [keepx, keepx + keeplenx), which a resize is about to drop.
+static void
+release_dropped_cells(ncplane* n, unsigned keepy, unsigned keepx,
+                      unsigned keepleny, unsigned keeplenx){
+  for(unsigned y = 0 ; y < keepy ; ++y){
+    release_cells(n, n->fb + nfbcellidx(n, y, 0), n->lenx);
+  }
+  if(keeplenx < n->lenx){
+    for(unsigned y = keepy ; y < keepy + keepleny ; ++y){
+      nccell* row = n->fb + nfbcellidx(n, y, 0);
+      release_cells(n, row, keepx);
+      release_cells(n, row + keepx + keeplenx, n->lenx - keepx - keeplenx);
+    }
+  }
+  for(unsigned y = keepy + keepleny ; y < n->leny ; ++y){
+    release_cells(n, n->fb + nfbcellidx(n, y, 0), n->lenx);
+  }
+}
+
+// swap the |count| cells at |a| with those at |b|; they mustn't overlap.
+static void
+cells_swap(nccell* a, nccell* b, size_t count){
+  nccell tmp[64];
+  while(count){
+    const size_t chunk = count < sizeof(tmp) / sizeof(*tmp) ?
+                         count : sizeof(tmp) / sizeof(*tmp);
+    memcpy(tmp, a, sizeof(*a) * chunk);
+    memcpy(a, b, sizeof(*a) * chunk);
+    memcpy(b, tmp, sizeof(*a) * chunk);
+    a += chunk;
+    b += chunk;
+    count -= chunk;
+  }
+}
+
+// reverse the order of rows [beg, end) of |n|'s framebuffer.
+static void
+fb_reverse_rows(ncplane* n, unsigned beg, unsigned end){
+  while(end - beg > 1){
+    --end;
+    cells_swap(n->fb + (size_t)beg * n->lenx, n->fb + (size_t)end * n->lenx, n->lenx);
+    ++beg;
+  }
+}
+
+// rotate a scrolled framebuffer's rows back into logical order, so that
+// logrow is 0, without allocating. three reversals make a rotation.
+static void
+ncplane_unroll(ncplane* n){
+  fb_reverse_rows(n, 0, n->logrow);
+  fb_reverse_rows(n, n->logrow, n->leny);
+  fb_reverse_rows(n, 0, n->leny);
+  n->logrow = 0;
+}
+
 // can be used on stdplane, unlike ncplane_resize() which prohibits it.
 int ncplane_resize_internal(ncplane* n, int keepy, int keepx,
                             unsigned keepleny, unsigned keeplenx,
@@ -843,61 +1286,64 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx,
       rows == ylen && cols == xlen){
     return 0;
   }
+  if(ncplane_own(n)){
+    return -1;
+  }
   notcurses* nc = ncplane_notcurses(n);
+  // a canvas grows to hold the view, and must have room for the view's cells
+  // before we commit, since we stow them in it (and load them anew) below.
+  if(n->canvas){
+    if(canvas_fit(n, ylen, xlen) || canvas_reserve(n)){
+      return -1;
+    }
+  }
   if(n->sprite){
     sprixel_hide(n->sprite);
   }
-  // we're good to resize. we'll need alloc up a new framebuffer, and copy in
-  // those elements we're retaining, zeroing out the rest. alternatively, if
-  // we've shrunk, we will be filling the new structure.
-  int oldarea = rows * cols;
-  int keptarea = keepleny * keeplenx;
-  int newarea = ylen * xlen;
-  size_t fbsize = sizeof(nccell) * newarea;
-  nccell* fb;
-  // there are two cases worth optimizing:
+  // we're good to resize. we keep rows [keepy, keepy + keepleny) and columns
+  // [keepx, keepx + keeplenx). old row |srcdelta| + y becomes new row y, and
+  // the kept columns begin at new column |padx|.
   //
-  // * nothing is kept. we malloc() a new cellmatrix, dump the EGCpool in
-  //    toto, and zero out the matrix. no copies, one memset.
-  // * old and new x dimensions match, and we're keeping the full width.
-  //    we release any cells we're about to lose, realloc() the cellmatrix,
-  //    and zero out any new cells. so long as the realloc() doesn't move
-  //    us, there are no copies, one memset, one iteration (since this is
-  //    most often due to autogrowth by a single line, the likelihood that
-  //    we remain where we are is pretty high).
-  // * otherwise, we malloc() a new cellmatrix, zero out any new cells,
-  //    copy over any reused cells, and release any lost cells. one
-  //    gigantic iteration.
-  // we might realloc instead of mallocing, in which case we NULL out
-  // |preserved|. it must otherwise be free()d at the end.
-  nccell* preserved = n->fb;
-  if(cols == xlen && cols == keeplenx && keepleny && !keepy){
-    // we need release the cells that we're losing, lest we leak EGCpool
-    // memory. unfortunately, this means we mutate the plane on the error case.
-    // any solution would involve copying them out first. we only do this if
-    // we're keeping some, as we otherwise drop the EGCpool in toto.
-    if(n->leny > keepleny){
-      for(unsigned y = keepleny ; y < n->leny ; ++y){
-        for(unsigned x = 0 ; x < n->lenx ; ++x){
-          nccell_release(n, ncplane_cell_ref_yx(n, y, x));
-        }
-      }
-    }
-    if((fb = realloc(n->fb, fbsize)) == NULL){
+  // so long as no kept row moves down, and we don't widen, every kept row can
+  // be moved into place from first to last without overwriting any row yet to
+  // be moved. we then work in place: realloc() only if we need more cells
+  // than we've got (with some headroom, so that repeated small growth is
+  // amortized), unroll any scrolled rows, and memmove() the kept rows down.
+  // otherwise, we malloc() a new cellmatrix and memcpy() the kept rows in.
+  // if we're keeping nothing, we needn't move anything, and work in place.
+  const int oldarea = rows * cols;
+  const int keptarea = keepleny * keeplenx;
+  const int newarea = ylen * xlen;
+  const int srcdelta = keepy + yoff;
+  const unsigned padx = xoff < 0 ? -xoff : 0;
+  const size_t oldcells = (size_t)n->capy * cols; // cells allocated
+  const size_t oldused = (size_t)rows * cols;     // beyond which all are zero
+  const bool inplace = !keptarea || (xlen <= cols && srcdelta >= 0);
+  nccell* fb;
+  unsigned capy;
+  if(!inplace){
+    capy = ylen;
+    if((fb = malloc(sizeof(*fb) * newarea)) == NULL){
       return -1;
     }
-    preserved = NULL;
-  }else{
-    if((fb = malloc(fbsize)) == NULL){
+  }else if((size_t)newarea > oldcells){
+    capy = fb_capacity(n, ylen);
+    if((fb = realloc(n->fb, sizeof(*fb) * capy * xlen)) == NULL){
       return -1;
     }
+    // the new cells are our own business until we take the new geometry.
+    // rows beyond leny stay zeroed, so the plane remains consistent.
+    n->fb = fb;
+  }else{
+    capy = oldcells / xlen;
+    fb = n->fb;
   }
   if(n->tam){
     loginfo("tam realloc to %d entries", newarea);
     // FIXME first, free any disposed auxiliary vectors!
     tament* tmptam = realloc(n->tam, sizeof(*tmptam) * newarea);
     if(tmptam == NULL){
-      if(preserved){
+      if(!inplace){
         free(fb);
       }
       return -1;
@@ -914,70 +1360,110 @@ int ncplane_resize_internal(ncplane* n, int keepy, int keepx,
   if(n->x >= xlen){
     n->x = xlen - 1;
   }
-  pthread_mutex_lock(&nc->stats.lock);
-    ncplane_notcurses(n)->stats.s.fbbytes -= sizeof(*fb) * (rows * cols);
-    ncplane_notcurses(n)->stats.s.fbbytes += fbsize;
-  pthread_mutex_unlock(&nc->stats.lock);
-  const int oldabsy = n->absy;
+  ncplane_damage(n); // the area we're leaving
+  // history rows are only meaningful at our current width, and their EGCs
+  // can't survive the pool being dumped when we keep nothing.
+  if(n->history && (xlen != cols || keepleny == 0)){
+    scrollback_free(n);
+  }
   // go ahead and move. we can no longer fail at this point. but don't yet
-  // resize, because n->len[xy] are used in fbcellidx() in the loop below. we
-  // don't use ncplane_move_yx(), because we want to planebinding-invariant.
+  // resize, because n->len[xy] are used in fbcellidx() below. we don't use
+  // ncplane_move_yx(), because we want to planebinding-invariant.
+  int canvasy = 0, canvasx = 0;
+  if(n->canvas){
+    // the view's cells go back into the canvas, and what's kept is reloaded
+    // from there at the same spot onscreen.
+    unsigned oy, ox;
+    ncplane_canvas_origin(n, &oy, &ox);
+    canvasy = oy + keepy + yoff;
+    canvasx = ox + keepx + xoff;
+    canvas_stow(n);
+  }
   n->absy += keepy + yoff;
+  if(n->txmoved){ // a pending move is relative to where we were
+    n->txy += keepy + yoff;
+    n->txx += keepx + xoff;
+  }
   n->absx += keepx + xoff;
 //fprintf(stderr, "absx: %d keepx: %d xoff: %d\n", n->absx, keepx, xoff);
-  if(keptarea == 0){ // keep nothing, resize/move only.
+  if(keptarea == 0 && !n->canvas){
     // if we're keeping nothing, dump the old egcspool. otherwise, we go ahead
-    // and keep it. perhaps we ought compact it?
-    memset(fb, 0, sizeof(*fb) * newarea);
+    // and keep it, compacting it below if it's become badly fragmented.
+    ncplane_release_interned(n, false);
     egcpool_dump(&n->pool);
-  }else if(!preserved){
-    // the x dimensions are equal, and we're keeping across the width. only the
-    // y dimension changed. if we grew, we need zero out the new cells (if we
-    // shrunk, we already released the old cells prior to the realloc).
-    unsigned tozorch = (ylen - keepleny) * xlen * sizeof(*fb);
-    if(tozorch){
-      unsigned zorchoff = keepleny * xlen;
-      memset(fb + zorchoff, 0, tozorch);
-    }
   }else{
-    // we currently have maxy rows of maxx cells each. we will be keeping rows
-    // keepy..keepy + keepleny - 1 and columns keepx..keepx + keeplenx - 1.
-    // anything else is zerod out. itery is the row we're writing *to*, and we
-    // must write to each (and every cell in each).
-    for(unsigned itery = 0 ; itery < ylen ; ++itery){
-      int truey = itery + n->absy;
-      int sourceoffy = truey - oldabsy;
-//fprintf(stderr, "sourceoffy: %d keepy: %d ylen: %d\n", sourceoffy, keepy, ylen);
-      // if we have nothing copied to this line, zero it out in one go
-      if(sourceoffy < keepy || sourceoffy >= keepy + (int)keepleny){
-//fprintf(stderr, "writing 0s to line %d of %d\n", itery, ylen);
-        memset(fb + (itery * xlen), 0, sizeof(*fb) * xlen);
-      }else{
-        int copyoff = itery * xlen; // our target at any given time
-        // we do have something to copy, and zero, one, or two regions to zero out
-        unsigned copied = 0;
-        if(xoff < 0){
-          memset(fb + copyoff, 0, sizeof(*fb) * -xoff);
-          copyoff += -xoff;
-          copied += -xoff;
-        }
-        const int sourceidx = nfbcellidx(n, sourceoffy, keepx);
-//fprintf(stderr, "copying line %d (%d) to %d (%d)\n", sourceoffy, sourceidx, copyoff / xlen, copyoff);
-        memcpy(fb + copyoff, preserved + sourceidx, sizeof(*fb) * keeplenx);
-        copyoff += keeplenx;
-        copied += keeplenx;
-        unsigned perline = xlen - copied;
-        for(unsigned x = copyoff ; x < n->lenx ; ++x){
-          nccell_release(n, ncplane_cell_ref_yx(n, sourceoffy, x));
-        }
-        memset(fb + copyoff, 0, sizeof(*fb) * perline);
+    release_dropped_cells(n, keepy, keepx, keepleny, keeplenx);
+  }
+  const nccell* src = fb;
+  if(!inplace){
+    src = n->fb;
+  }else if(keptarea && n->logrow){
+    ncplane_unroll(n);
+  }
+  // kept rows which needn't move are left alone, as when autogrowing
+  unsigned firsty = 0;
+  if(inplace && keptarea && srcdelta == 0 && xlen == cols && keeplenx == cols){
+    firsty = keepleny;
+  }
+  for(unsigned itery = firsty ; itery < ylen ; ++itery){
+    nccell* dst = fb + (size_t)itery * xlen;
+    const int sourceoffy = itery + srcdelta;
+    // if we have nothing copied to this line, zero it out in one go
+    if(!keptarea || sourceoffy < keepy || sourceoffy >= keepy + (int)keepleny){
+      memset(dst, 0, sizeof(*fb) * xlen);
+      continue;
+    }
+    // the in-place source is in logical order, having been unrolled
+    const nccell* srow = inplace ? src + (size_t)sourceoffy * cols :
+                         src + nfbcellidx(n, sourceoffy, 0);
+    memmove(dst + padx, srow + keepx, sizeof(*fb) * keeplenx);
+    memset(dst, 0, sizeof(*fb) * padx);
+    memset(dst + padx + keeplenx, 0, sizeof(*fb) * (xlen - padx - keeplenx));
+  }
+  if(inplace){
+    // rows beyond ylen must be zero, so that we can later grow into them.
+    // anything beyond our old area already is.
+    size_t dirtyend = (size_t)capy * xlen;
+    if(oldused < dirtyend && (size_t)newarea <= oldcells){
+      dirtyend = oldused;
+    }
+    if(dirtyend > (size_t)newarea){
+      memset(fb + newarea, 0, sizeof(*fb) * (dirtyend - newarea));
+    }
+    // give back most of what we no longer need after a large shrink
+    if(!n->autogrow && (size_t)capy > (size_t)ylen * 4){
+      nccell* tmp = realloc(fb, sizeof(*fb) * newarea);
+      if(tmp){
+        fb = tmp;
+        capy = ylen;
       }
     }
+  }else{
+    free(n->fb);
   }
+  stats_lock(&nc->stats);
+    nc->stats.s.fbbytes -= sizeof(*fb) * oldcells;
+    nc->stats.s.fbbytes += sizeof(*fb) * capy * xlen;
+  stats_unlock(&nc->stats);
   n->fb = fb;
+  n->capy = capy;
+  n->logrow = 0; // we've rewritten the rows in order, if we moved them at all
   n->lenx = xlen;
   n->leny = ylen;
-  free(preserved);
+  if(n->canvas){
+    canvas_load(n, canvasy, canvasx);
+  }
+  ncpile_index_stale(ncplane_pile(n));
+  ncplane_damage(n); // the area we've taken on
+  if(egcpool_compaction_justified(&n->pool)){
+    // on failure, we simply carry on with the fragmented pool
+    ncplane_compact_pool(n);
+  }
+  // bound children move along with us, so if we only moved, they needn't
+  // hear about it.
+  if(rows == ylen && cols == xlen){
+    return 0;
+  }
   return resize_callbacks_children(n);
 }
 
@@ -993,20 +1479,92 @@ int ncplane_resize(ncplane* n, int keepy, int keepx,
                                  yoff, xoff, ylen, xlen);
 }
 
-int ncplane_destroy(ncplane* ncp){
-  if(ncp == NULL){
+int egcpool_compact(notcurses* nc, egcpool* pool, nccell* fb, size_t count,
+                    nccell* extra){
+  cellspan spans[2] = {
+    { .cells = fb, .count = count, },
+    { .cells = extra, .count = extra ? 1 : 0, },
+  };
+  return egcpool_compact_spans(nc, pool, spans, 2);
+}
+
+int egcpool_compact_spans(notcurses* nc, egcpool* pool, const cellspan* spans,
+                          unsigned nspans){
+  const int wasted = egcpool_fragmentation(pool);
+  if(wasted == 0){
     return 0;
   }
-  if(ncplane_notcurses(ncp)->stdplane == ncp){
-    logerror("won't destroy standard plane");
+  // size the new pool before touching any cell, so that we can't fail midway
+  size_t need = 0;
+  for(unsigned s = 0 ; s < nspans ; ++s){
+    for(size_t i = 0 ; i < spans[s].count ; ++i){
+      if(cell_pooled_p(&spans[s].cells[i])){
+        need += strlen(egcpool_extended_gcluster(pool, &spans[s].cells[i])) + 1;
+      }
+    }
+  }
+  egcpool fresh;
+  egcpool_init(&fresh);
+  if(need && egcpool_grow(&fresh, need)){
     return -1;
   }
-//notcurses_debug(ncplane_notcurses(ncp), stderr);
-  loginfo("destroying %dx%d plane \"%s\" @ %dx%d",
-          ncp->leny, ncp->lenx, ncp->name ? ncp->name : NULL, ncp->absy, ncp->absx);
-  int ret = 0;
-  // dissolve our binding from behind (->bprev is either NULL, or its
-  // predecessor on the bound list's ->bnext, or &ncp->boundto->blist)
+  for(unsigned s = 0 ; s < nspans ; ++s){
+    for(size_t i = 0 ; i < spans[s].count ; ++i){
+      nccell* c = &spans[s].cells[i];
+      if(cell_pooled_p(c)){
+        const char* egc = egcpool_extended_gcluster(pool, c);
+        const int len = strlen(egc) + 1;
+        memcpy(fresh.pool + fresh.poolwrite, egc, len);
+        set_gcluster_egc(c, fresh.poolwrite);
+        fresh.poolwrite += len;
+      }
+    }
+  }
+  fresh.poolused = fresh.poolwrite;
+  const int reclaimed = pool->poolwrite - fresh.poolwrite;
+  loginfo("compacted egcpool %d -> %d bytes (%d reclaimed)",
+          pool->poolsize, fresh.poolsize, reclaimed);
+  egcpool_dump(pool); // advances the generation
+  fresh.generation = pool->generation;
+  fresh.interns = pool->interns;
+  fresh.interned = pool->interned;
+  *pool = fresh;
+  stats_lock(&nc->stats);
+    ++nc->stats.s.pool_compactions;
+    nc->stats.s.pool_reclaimed += reclaimed;
+  stats_unlock(&nc->stats);
+  return reclaimed;
+}
+
+int ncplane_compact_pool(ncplane* n){
+  if(ncplane_own(n)){
+    return -1;
+  }
+  if(n->history == NULL && n->canvas == NULL){
+    return egcpool_compact(ncplane_notcurses(n), &n->pool, n->fb,
+                           n->leny * n->lenx, &n->basecell);
+  }
+  // our history's and canvas's EGCs live in our pool, and must come along
+  const unsigned maxspans = scrollback_maxspans(n) + canvas_maxspans(n) + 2;
+  cellspan* spans = malloc(sizeof(*spans) * maxspans);
+  if(spans == NULL){
+    return -1;
+  }
+  spans[0].cells = n->fb;
+  spans[0].count = n->leny * n->lenx;
+  spans[1].cells = &n->basecell;
+  spans[1].count = 1;
+  unsigned nspans = scrollback_spans(n, spans + 2) + 2;
+  nspans += canvas_spans(n, spans + nspans);
+  int ret = egcpool_compact_spans(ncplane_notcurses(n), &n->pool, spans, nspans);
+  free(spans);
+  return ret;
+}
+
+// dissolve |ncp|'s binding from behind (->bprev is either NULL, or its
+// predecessor on the bound list's ->bnext, or &ncp->boundto->blist)
+static void
+ncplane_unbind(ncplane* ncp){
   if(ncp->bprev){
     if( (*ncp->bprev = ncp->bnext) ){
       ncp->bnext->bprev = ncp->bprev;
@@ -1015,6 +1573,38 @@ int ncplane_destroy(ncplane* ncp){
     //assert(ncp->boundto->blist == ncp);
     ncp->bnext->bprev = NULL;
   }
+}
+
+// extract |ncp| from its pile's z-axis.
+static void
+ncplane_unstack(ncplane* ncp){
+  if(ncp->above){
+    ncp->above->below = ncp->below;
+  }else{
+    ncplane_pile(ncp)->top = ncp->below;
+  }
+  if(ncp->below){
+    ncp->below->above = ncp->above;
+  }else{
+    ncplane_pile(ncp)->bottom = ncp->above;
+  }
+}
+
+int ncplane_destroy(ncplane* ncp){
+  if(ncp == NULL){
+    return 0;
+  }
+  if(ncplane_notcurses(ncp)->stdplane == ncp){
+    logerror("won't destroy standard plane");
+    return -1;
+  }
+//notcurses_debug(ncplane_notcurses(ncp), stderr);
+  loginfo("destroying %dx%d plane \"%s\" @ %dx%d",
+          ncp->leny, ncp->lenx, ncp->name ? ncp->name : NULL, ncp->absy, ncp->absx);
+  ncplane_damage(ncp);
+  ncplane_layer_invalidate(ncp);
+  int ret = 0;
+  ncplane_unbind(ncp);
   // recursively reparent our children to the plane to which we are bound.
   // this will extract each one from the sibling list.
   struct ncplane* bound = ncp->blist;
@@ -1029,34 +1619,63 @@ int ncplane_destroy(ncplane* ncp){
   // extract ourselves from the z-axis. do this *after* reparenting, in case
   // reparenting shifts up the z-axis somehow (though i don't think it can,
   // at least not within a pile?).
-  if(ncp->above){
-    ncp->above->below = ncp->below;
-  }else{
-    ncplane_pile(ncp)->top = ncp->below;
-  }
-  if(ncp->below){
-    ncp->below->above = ncp->above;
-  }else{
-    ncplane_pile(ncp)->bottom = ncp->above;
-  }
+  ncplane_unstack(ncp);
+  ncpile_index_stale(ncplane_pile(ncp));
   free_plane(ncp);
   return ret;
 }
 
-int ncplane_destroy_family(ncplane *ncp){
+int ncplane_destroy_family(ncplane* ncp, uint64_t flags){
   if(ncp == NULL){
     return 0;
   }
-  if(ncplane_notcurses(ncp)->stdplane == ncp){
+  notcurses* nc = ncplane_notcurses(ncp);
+  if(nc->stdplane == ncp){
     logerror("won't destroy standard plane");
     return -1;
   }
-  int ret = 0;
-  while(ncp->blist){
-    ret |= ncplane_destroy_family(ncp->blist);
+  if(flags >= (NCPLANE_DESTROY_DEFERRED << 1u)){
+    logwarn("provided unsupported flags %016" PRIx64, flags);
   }
-  ret |= ncplane_destroy(ncp);
-  return ret;
+  loginfo("destroying family of %dx%d plane \"%s\" @ %dx%d",
+          ncp->leny, ncp->lenx, ncp->name ? ncp->name : NULL, ncp->absy, ncp->absx);
+  // the pile index is rebuilt wholesale on the next render, so it needn't
+  // be consulted (nor touched) once per plane. mark it now, while the pile
+  // is certain to exist.
+  ncpile_index_stale(ncplane_pile(ncp));
+  // layers rooted within the family go with it; those above must forget it
+  ncplane_layer_invalidate(ncp);
+  // destroy the family bottom-up, so that no plane ever needs reparenting.
+  // we always descend from ncp afresh rather than collecting the family
+  // beforehand, since a widget destructor might destroy planes of its own.
+  unsigned destroyed = 0;
+  ncplane* p = ncp;
+  for(;;){
+    while(p->blist){
+      p = p->blist;
+    }
+    ncplane* parent = p->boundto;
+    const bool last = (p == ncp);
+    ncplane_damage(p);
+    ncplane_unbind(p);
+    ncplane_unstack(p);
+    if(flags & NCPLANE_DESTROY_DEFERRED){
+      retire_plane(p);
+      pthread_mutex_lock(&nc->pilelock);
+        p->above = nc->planegrave;
+        nc->planegrave = p;
+      pthread_mutex_unlock(&nc->pilelock);
+    }else{
+      free_plane(p);
+    }
+    ++destroyed;
+    if(last){
+      break;
+    }
+    p = parent;
+  }
+  logdebug("destroyed %u planes", destroyed);
+  return 0;
 }
 
 // it's critical that we're using UTF-8 encoding if at all possible. since the
@@ -1157,7 +1776,7 @@ notcurses_early_init(const struct notcurses_options* opts, FILE* fp, unsigned* u
   }
   memset(ret, 0, sizeof(*ret));
   if(opts){
-    if(opts->flags >= (NCOPTION_SCROLLING << 1u)){
+    if(opts->flags >= (NCOPTION_ADAPTIVE_BANDWIDTH << 1u)){
       fprintf(stderr, "warning: unknown Notcurses options %016" PRIu64, opts->flags);
     }
     if(opts->termtype){
@@ -1233,9 +1852,26 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
     free(ret);
     return NULL;
   }
+  if(fbufpool_init(&ret->fbpool)){
+    fbuf_free(&ret->rstate.f);
+    pthread_mutex_destroy(&ret->pilelock);
+    pthread_mutex_destroy(&ret->stats.lock);
+    free(ret);
+    return NULL;
+  }
+  if(auxpool_init(&ret->auxpool)){
+    fbufpool_destroy(&ret->fbpool);
+    fbuf_free(&ret->rstate.f);
+    pthread_mutex_destroy(&ret->pilelock);
+    pthread_mutex_destroy(&ret->stats.lock);
+    free(ret);
+    return NULL;
+  }
   if(setup_signals(ret, (ret->flags & NCOPTION_NO_QUIT_SIGHANDLERS),
                    (ret->flags & NCOPTION_NO_WINCH_SIGHANDLER),
                    notcurses_stop_minimal)){
+    fbufpool_destroy(&ret->fbpool);
+    auxpool_destroy(&ret->auxpool);
     fbuf_free(&ret->rstate.f);
     pthread_mutex_destroy(&ret->pilelock);
     pthread_mutex_destroy(&ret->stats.lock);
@@ -1254,13 +1890,25 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
                   &ret->rstate.logendy : &fakecursory;
   int* cursorx = ret->flags & NCOPTION_PRESERVE_CURSOR ?
                   &ret->rstate.logendx : &fakecursorx;
-  if(interrogate_terminfo(&ret->tcache, ret->ttyfp, utf8,
-                          ret->flags & NCOPTION_NO_ALTERNATE_SCREEN, 0,
-                          ret->flags & NCOPTION_NO_FONT_CHANGES,
-                          cursory, cursorx, &ret->stats,
-                          ret->margin_l, ret->margin_t,
-                          ret->margin_r, ret->margin_b,
-                          ret->flags & NCOPTION_DRAIN_INPUT)){
+  // we can't return early if we need to wait on the cursor's location, or
+  // on the capabilities we'd report in the banner.
+  bool async = false;
+  if(ret->flags & NCOPTION_ASYNC_INIT){
+    if((ret->flags & NCOPTION_PRESERVE_CURSOR) ||
+       !(ret->flags & NCOPTION_SUPPRESS_BANNERS)){
+      logwarn("ignoring NCOPTION_ASYNC_INIT without NCOPTION_SUPPRESS_BANNERS, or with NCOPTION_PRESERVE_CURSOR");
+    }else{
+      async = true;
+    }
+  }
+  if(interrogate_terminfo_start(&ret->tcache, ret->ttyfp, utf8,
+                                ret->flags & NCOPTION_NO_ALTERNATE_SCREEN,
+                                &ret->stats, ret->margin_l, ret->margin_t,
+                                ret->margin_r, ret->margin_b,
+                                ret->flags & NCOPTION_DRAIN_INPUT,
+                                ret->flags & NCOPTION_COALESCE_MOTION)){
+    fbufpool_destroy(&ret->fbpool);
+    auxpool_destroy(&ret->auxpool);
     fbuf_free(&ret->rstate.f);
     pthread_mutex_destroy(&ret->pilelock);
     pthread_mutex_destroy(&ret->stats.lock);
@@ -1268,9 +1916,36 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
     free(ret);
     return NULL;
   }
-  if(ret->tcache.maxpaletteread > -1){
-    memcpy(ret->palette.chans, ret->tcache.originalpalette.chans,
-           sizeof(*ret->palette.chans) * (ret->tcache.maxpaletteread + 1));
+  // our queries are in flight. do what work we can without their replies
+  // while we wait on the terminal.
+  int visfailed = ncvisual_init(ret->loglevel);
+  if(ret->flags & NCOPTION_THREADED_RENDER){
+    // failure to create the engine is not fatal; we just paint serially
+    ret->rengine = render_engine_create();
+  }
+  ret->stats.s.render_threads = render_engine_threads(ret->rengine);
+  if(!async){
+    if(interrogate_terminfo_finish(&ret->tcache, 0,
+                                   ret->flags & NCOPTION_NO_FONT_CHANGES,
+                                   cursory, cursorx,
+                                   ret->flags & NCOPTION_DRAIN_INPUT)){
+      render_engine_destroy(ret->rengine);
+      fbufpool_destroy(&ret->fbpool);
+      auxpool_destroy(&ret->auxpool);
+      fbuf_free(&ret->rstate.f);
+      pthread_mutex_destroy(&ret->pilelock);
+      pthread_mutex_destroy(&ret->stats.lock);
+      drop_signals(ret);
+      free(ret);
+      return NULL;
+    }
+    if(ret->tcache.maxpaletteread > -1){
+      memcpy(ret->palette.chans, ret->tcache.originalpalette.chans,
+             sizeof(*ret->palette.chans) * (ret->tcache.maxpaletteread + 1));
+    }
+  }
+  if(visfailed){
+    goto err;
   }
   if((ret->flags & NCOPTION_PRESERVE_CURSOR) ||
       (!(ret->flags & NCOPTION_SUPPRESS_BANNERS))){
@@ -1296,9 +1971,6 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
   if(update_term_dimensions(&dimy, &dimx, &ret->tcache, ret->margin_b, &cgeo, &pgeo)){
     goto err;
   }
-  if(ncvisual_init(ret->loglevel)){
-    goto err;
-  }
   ret->stdplane = NULL;
   if((ret->stdplane = create_initial_ncplane(ret, dimy, dimx)) == NULL){
     logpanic("couldn't create the initial plane (bad margins?)");
@@ -1313,6 +1985,7 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
     free_plane(ret->stdplane);
     goto err;
   }
+  // with async init, we don't yet know whether we can push the palette
   const char* pushcolors = get_escape(&ret->tcache, ESCAPE_SAVECOLORS);
   if(pushcolors && fbuf_emit(&ret->rstate.f, pushcolors)){
     free_plane(ret->stdplane);
@@ -1349,7 +2022,7 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
   }
   // the sprite clear ought take place within the alternate screen, if it's
   // being used.
-  if(!(ret->flags & NCOPTION_NO_CLEAR_BITMAPS)){
+  if(!async && !(ret->flags & NCOPTION_NO_CLEAR_BITMAPS)){
     if(sprite_clear_all(&ret->tcache, &ret->rstate.f)){
       goto err;
     }
@@ -1359,11 +2032,17 @@ notcurses* notcurses_core_init(const notcurses_options* opts, FILE* outfp){
       goto err;
     }
   }
+  nctrace_init();
+  logring_init(ret->flags & NCOPTION_LOG_RING);
   return ret;
 
 err:
   logpanic("alas, you will not be going to space today.");
   notcurses_stop_minimal(ret);
+  render_engine_destroy(ret->rengine);
+  ncplane_cache_drain(ret);
+  fbufpool_destroy(&ret->fbpool);
+  auxpool_destroy(&ret->auxpool);
   fbuf_free(&ret->rstate.f);
   if(ret->tcache.ttyfd >= 0 && ret->tcache.tpreserved){
     (void)tcsetattr(ret->tcache.ttyfd, TCSAFLUSH, ret->tcache.tpreserved);
@@ -1377,6 +2056,48 @@ err:
   return NULL;
 }
 
+// with NCOPTION_ASYNC_INIT, notcurses_core_init() returns before the terminal
+// has answered our queries. the first thing to need those answers (a render,
+// a blit, or notcurses_stop()) waits on them here, and does whatever init
+// work depended upon them.
+int finish_async_init(notcurses* nc){
+  int ret = 0;
+  pthread_mutex_lock(&nc->pilelock);
+  if(nc->tcache.interrogating){
+    loginfo("awaiting initial terminal responses");
+    if(interrogate_terminfo_finish(&nc->tcache, 0,
+                                   nc->flags & NCOPTION_NO_FONT_CHANGES,
+                                   NULL, NULL, nc->flags & NCOPTION_DRAIN_INPUT)){
+      ret = -1;
+    }else{
+      if(nc->tcache.maxpaletteread > -1){
+        memcpy(nc->palette.chans, nc->tcache.originalpalette.chans,
+               sizeof(*nc->palette.chans) * (nc->tcache.maxpaletteread + 1));
+      }
+      fbuf f;
+      if(fbuf_init(&f)){
+        ret = -1;
+      }else{
+        const char* pushcolors = get_escape(&nc->tcache, ESCAPE_SAVECOLORS);
+        if(pushcolors && fbuf_emit(&f, pushcolors)){
+          ret = -1;
+        }
+        if(!(nc->flags & NCOPTION_NO_CLEAR_BITMAPS)){
+          if(sprite_clear_all(&nc->tcache, &f)){
+            ret = -1;
+          }
+        }
+        if(f.used && fbuf_flush(&f, nc->ttyfp) < 0){
+          ret = -1;
+        }
+        fbuf_free(&f);
+      }
+    }
+  }
+  pthread_mutex_unlock(&nc->pilelock);
+  return ret;
+}
+
 // updates *pile to point at (*pile)->next, frees all but standard pile/plane
 static void
 ncpile_drop(notcurses* nc, ncpile** pile){
@@ -1399,6 +2120,7 @@ ncpile_drop(notcurses* nc, ncpile** pile){
     ncplane_pile(nc->stdplane)->bottom = nc->stdplane;
     nc->stdplane->above = nc->stdplane->below = NULL;
     nc->stdplane->blist = NULL;
+    ncpile_index_stale(ncplane_pile(nc->stdplane));
   }
 }
 
@@ -1420,7 +2142,19 @@ int notcurses_stop(notcurses* nc){
 //notcurses_debug(nc, stderr);
   int ret = 0;
   if(nc){
+    // we need the replies to know what to restore (e.g. the keyboard level)
+    ret |= settle_async_init(nc);
+    // get any asynchronously-submitted frames out before restoring the terminal
+    ret |= raster_writer_destroy(nc->rwriter);
+    nc->rwriter = NULL;
+    // callbacks might still be drawing to planes
+    ret |= fd_reactor_destroy(nc->fdreactor);
+    nc->fdreactor = NULL;
+    // the animator's timer lives in the input layer
+    ncanimator_destroy(nc, nc->animator);
+    nc->animator = NULL;
     ret |= notcurses_stop_minimal(nc);
+    ncplane_reap(nc);
     // if we were not using the alternate screen, our cursor's wherever we last
     // wrote. move it to the furthest place to which it advanced.
     if(!get_escape(&nc->tcache, ESCAPE_SMCUP)){
@@ -1437,6 +2171,7 @@ int notcurses_stop(notcurses* nc){
     if(nc->tcache.ttyfd >= 0){
       ret |= close(nc->tcache.ttyfd);
     }
+    render_engine_destroy(nc->rengine);
     egcpool_dump(&nc->pool);
     free(nc->lastframe);
     free_terminfo_cache(&nc->tcache);
@@ -1448,9 +2183,17 @@ int notcurses_stop(notcurses* nc){
 #ifndef __MINGW32__
     del_curterm(cur_term);
 #endif
+    ret |= logring_fini(stderr);
+    ret |= nctrace_fini();
     ret |= pthread_mutex_destroy(&nc->stats.lock);
+    ncplane_cache_drain(nc);
     ret |= pthread_mutex_destroy(&nc->pilelock);
+    // every sprixel is gone, and with it every reference to the pools
+    fbufpool_destroy(&nc->fbpool);
+    auxpool_destroy(&nc->auxpool);
     fbuf_free(&nc->rstate.f);
+    free(nc->rstate.splices);
+    prof_free(&nc->profile);
     free(nc);
   }
   return ret;
@@ -1528,10 +2271,18 @@ int ncplane_set_base_cell(ncplane* ncp, const nccell* c){
   if(nccell_wide_right_p(c)){
     return -1;
   }
+  if(ncplane_own(ncp)){
+    return -1;
+  }
+  ncplane_damage(ncp);
   return nccell_duplicate(ncp, &ncp->basecell, c);
 }
 
 int ncplane_set_base(ncplane* ncp, const char* egc, uint16_t stylemask, uint64_t channels){
+  if(ncplane_own(ncp)){
+    return -1;
+  }
+  ncplane_damage(ncp);
   return nccell_prime(ncp, &ncp->basecell, egc, stylemask, channels);
 }
 
@@ -1552,6 +2303,8 @@ int ncplane_move_above(ncplane* restrict n, ncplane* restrict above){
     return -1;
   }
   ncpile* p = ncplane_pile(n);
+  ncpile_index_stale(p);
+  ncplane_damage(n);
   if(above == NULL){
     if(n->below){
       if( (n->below->above = n->above) ){
@@ -1599,6 +2352,8 @@ int ncplane_move_below(ncplane* restrict n, ncplane* restrict below){
     return -1;
   }
   ncpile* p = ncplane_pile(n);
+  ncpile_index_stale(p);
+  ncplane_damage(n);
   if(below == NULL){
     if(n->above){
       if( (n->above->below = n->below) ){
@@ -1722,6 +2477,30 @@ nccell_obliterate(ncplane* n, nccell* c){
   nccell_init(c);
 }
 
+// |n| is scrolling |r| rows of material up and out. the standard plane's
+// scrolls always become physical scrolls at rasterization. other planes'
+// might become physical scrolls of their rows alone, if only one plane has
+// scrolled (see plan_region_scroll()).
+static void
+note_scrolls(ncplane* n, unsigned r){
+  ncpile* p = ncplane_pile(n);
+  if(n == notcurses_stdplane(ncplane_notcurses(n))){
+    p->scrolls += r;
+  }else if(p->planescrolls >= 0){
+    // while history is in view, what's displayed doesn't move with output
+    if(scrollback_viewing_p(n)){
+      p->scrollplane = NULL;
+      p->planescrolls = -1;
+    }else if(p->scrollplane == NULL || p->scrollplane == n){
+      p->scrollplane = n;
+      p->planescrolls += r;
+    }else{
+      p->scrollplane = NULL;
+      p->planescrolls = -1;
+    }
+  }
+}
+
 // increment y by 1 and rotate the framebuffer up one line. x moves to 0. any
 // non-fixed bound planes move up 1 line if they intersect the plane.
 void scroll_down(ncplane* n){
@@ -1736,14 +2515,18 @@ void scroll_down(ncplane* n){
     }
     // we'll actually be scrolling material up and out, and making a new line.
     // if this is the standard plane, that means a "physical" scroll event is
-    // called for.
-    if(n == notcurses_stdplane(ncplane_notcurses(n))){
-      ncplane_pile(n)->scrolls++;
+    // called for (and possibly for other planes; see note_scrolls()).
+    if(ncplane_own(n)){
+      return; // the failure has been logged; leave the plane as it was
     }
+    note_scrolls(n, 1);
     n->logrow = (n->logrow + 1) % n->leny;
+    ncplane_damage(n);
     nccell* row = n->fb + nfbcellidx(n, n->y, 0);
-    for(unsigned clearx = 0 ; clearx < n->lenx ; ++clearx){
-      nccell_release(n, &row[clearx]);
+    if(scrollback_push(n, row)){
+      for(unsigned clearx = 0 ; clearx < n->lenx ; ++clearx){
+        nccell_release(n, &row[clearx]);
+      }
     }
     memset(row, 0, sizeof(*row) * n->lenx);
     for(struct ncplane* c = n->blist ; c ; c = c->bnext){
@@ -1758,6 +2541,70 @@ void scroll_down(ncplane* n){
   }
 }
 
+// the effect of |r| calls to scroll_down(), with a single rotation of the
+// framebuffer, a single move of each bound plane, and a single count of
+// physical scrolls (to be coalesced into one operation at rasterization).
+static void
+scroll_down_rows(ncplane* n, unsigned r){
+  if(r == 0){
+    return;
+  }
+  n->x = 0;
+  // until we reach the last line, scroll_down() only moves the cursor
+  const unsigned descend = n->leny - 1 - n->y;
+  if(r <= descend){
+    n->y += r;
+    return;
+  }
+  n->y = n->leny - 1;
+  r -= descend;
+  if(n->autogrow){
+    ncplane_resize_simple(n, n->leny + r, n->lenx);
+    ncplane_cursor_move_yx(n, n->leny - 1, 0);
+    return;
+  }
+  note_scrolls(n, r);
+  // bound planes move up with each scroll, but only while they intersect us.
+  // determine how far each would travel before they fall off our top.
+  int absy, absx;
+  ncplane_abs_yx(n, &absy, &absx);
+  for(struct ncplane* c = n->blist ; c ; c = c->bnext){
+    if(!c->fixedbound && ncplanes_intersect_p(n, c)){
+      int cy, cx;
+      ncplane_abs_yx(c, &cy, &cx);
+      const int bottom = cy + (int)ncplane_dim_y(c) - 1;
+      const unsigned travel = bottom - absy + 1;
+      ncplane_move_rel(c, -(int)(travel < r ? travel : r), 0);
+    }
+  }
+  // every row scrolled beyond the first leny is lost without ever being seen
+  const unsigned cleared = r < n->leny ? r : n->leny;
+  if(n->history){
+    // history takes the departing rows oldest first, followed by any blank
+    // rows which would have scrolled in and out again
+    for(unsigned y = 0 ; y < cleared ; ++y){
+      nccell* row = n->fb + nfbcellidx(n, y, 0);
+      if(scrollback_push(n, row) == 0){
+        memset(row, 0, sizeof(*row) * n->lenx);
+      }
+    }
+    for(unsigned blanks = r - cleared ; blanks ; --blanks){
+      if(scrollback_push(n, NULL)){
+        break;
+      }
+    }
+  }
+  n->logrow = (n->logrow + r % n->leny) % n->leny;
+  ncplane_damage(n);
+  for(unsigned y = n->leny - cleared ; y < n->leny ; ++y){
+    nccell* row = n->fb + nfbcellidx(n, y, 0);
+    for(unsigned clearx = 0 ; clearx < n->lenx ; ++clearx){
+      nccell_release(n, &row[clearx]);
+    }
+    memset(row, 0, sizeof(*row) * n->lenx);
+  }
+}
+
 int ncplane_scrollup(ncplane* n, int r){
   if(!ncplane_scrolling_p(n)){
     logerror("can't scroll %d on non-scrolling plane", r);
@@ -1767,9 +2614,10 @@ int ncplane_scrollup(ncplane* n, int r){
     logerror("can't scroll %d lines", r);
     return -1;
   }
-  while(r-- > 0){
-    scroll_down(n);
+  if(ncplane_own(n)){
+    return -1;
   }
+  scroll_down_rows(n, r);
   if(n == notcurses_stdplane(ncplane_notcurses(n))){
     notcurses_render(ncplane_notcurses(n));
   }
@@ -1800,6 +2648,9 @@ int ncplane_scrollup_child(ncplane* n, const ncplane* child){
 }
 
 int nccell_load(ncplane* n, nccell* c, const char* gcluster){
+  if(ncplane_own(n)){
+    return -1;
+  }
   int cols;
   int bytes = utf8_egc_len(gcluster, &cols);
   return pool_load_direct(&n->pool, c, gcluster, bytes, cols);
@@ -1817,6 +2668,9 @@ ncplane_put(ncplane* n, int y, int x, const char* egc, int cols,
     logerror("can't write [%s] to sprixelated plane", egc);
     return -1;
   }
+  if(ncplane_own(n)){
+    return -1;
+  }
   // reject any control character for output other than newline (and then only
   // on a scrolling plane) and tab.
   if(is_control_egc((const unsigned char*)egc, bytes)){
@@ -1870,6 +2724,7 @@ ncplane_put(ncplane* n, int y, int x, const char* egc, int cols,
     scroll_down(n);
     scrolled = true;
   }
+  ncplane_damage_rows(n, n->y, 1);
   // A wide character obliterates anything to its immediate right (and marks
   // that cell as wide). Any character placed atop one cell of a wide character
   // obliterates all cells. Note that a two-cell glyph can thus obliterate two
@@ -1956,9 +2811,309 @@ int ncplane_putc_yx(ncplane* n, int y, int x, const nccell* c){
     logerror("couldn't duplicate cell");
     return -1;
   }
-  int r = ncplane_put(n, y, x, egc, cols, c->stylemask, c->channels, strlen(egc));
-  free(egc);
-  return r;
+  int r = ncplane_put(n, y, x, egc, cols, c->stylemask, c->channels, strlen(egc));
+  free(egc);
+  return r;
+}
+
+// can the cell |c| be written by ncplane_put_cells()? fills in its columns.
+static bool
+put_cells_valid_p(const nccell* c, int* cols){
+  *cols = nccell_cols(c);
+  if(cell_simple_p(c)){
+    const char* egc = (const char*)&c->gcluster;
+    // the empty cell has no bytes, and is thus fine, as it is for ncplane_putc()
+    if(is_control_egc((const unsigned char*)egc, strnlen(egc, sizeof(c->gcluster)))){
+      return false;
+    }
+  }
+  return true;
+}
+
+// prepare the |xlen| columns starting at |x| on row |y| for direct writes:
+// release them, and obliterate any wide glyphs straddling either edge.
+static void
+put_cells_clear_span(ncplane* n, unsigned y, unsigned x, unsigned xlen){
+  nccell* row = &n->fb[nfbcellidx(n, y, 0)];
+  unsigned idx = x;
+  while(idx && nccell_wide_right_p(&row[idx])){
+    --idx;
+  }
+  while(idx < x){
+    nccell_obliterate(n, &row[idx++]);
+  }
+  for(unsigned xx = x + xlen ; xx < n->lenx && nccell_wide_right_p(&row[xx]) ; ++xx){
+    nccell_obliterate(n, &row[xx]);
+  }
+  for(unsigned xx = x ; xx < x + xlen ; ++xx){
+    pool_release(&n->pool, &row[xx]);
+  }
+}
+
+// is every cell of this source row a narrow glyph stored directly within the
+// nccell? such rows can simply be copied.
+static bool
+put_cells_direct_row_p(const nccell* src, unsigned xlen){
+  for(unsigned xx = 0 ; xx < xlen ; ++xx){
+    if(!cell_simple_p(&src[xx]) || src[xx].width > 1){
+      return false;
+    }
+  }
+  return true;
+}
+
+int ncplane_put_cells(ncplane* n, int y, int x, unsigned ylen, unsigned xlen,
+                      const nccell* cells, size_t stride){
+  if(n->sprite){
+    logerror("can't write cells to sprixelated plane");
+    return -1;
+  }
+  if(ylen == 0 || xlen == 0){
+    logerror("invalid cell geometry %ux%u", ylen, xlen);
+    return -1;
+  }
+  if(stride == 0){
+    stride = xlen;
+  }else if(stride < xlen){
+    logerror("stride %zu < %u cells", stride, xlen);
+    return -1;
+  }
+  if(y < 0){
+    if(y != -1){
+      logerror("invalid y: %d", y);
+      return -1;
+    }
+    y = n->y;
+  }
+  if(x < 0){
+    if(x != -1){
+      logerror("invalid x: %d", x);
+      return -1;
+    }
+    x = n->x;
+  }
+  if((unsigned)y >= n->leny || ylen > n->leny - y ||
+     (unsigned)x >= n->lenx || xlen > n->lenx - x){
+    logerror("%ux%u cells at %d/%d exceed plane (%ux%u)", ylen, xlen, y, x,
+             n->leny, n->lenx);
+    return -1;
+  }
+  // check everything before writing anything, so that we fail atomically
+  for(unsigned yy = 0 ; yy < ylen ; ++yy){
+    const nccell* src = cells + yy * stride;
+    for(unsigned xx = 0 ; xx < xlen ; ){
+      int cols;
+      if(!put_cells_valid_p(&src[xx], &cols)){
+        logerror("rejecting control character at %u/%u", yy, xx);
+        return -1;
+      }
+      if(cols > (int)(xlen - xx)){
+        logerror("%d-column glyph at %u/%u crosses region", cols, yy, xx);
+        return -1;
+      }
+      xx += cols;
+    }
+  }
+  if(ncplane_own(n)){
+    return -1;
+  }
+  ncplane_damage_rows(n, y, ylen);
+  for(unsigned yy = 0 ; yy < ylen ; ++yy){
+    const nccell* src = cells + yy * stride;
+    put_cells_clear_span(n, y + yy, x, xlen);
+    nccell* dst = &n->fb[nfbcellidx(n, y + yy, x)];
+    if(put_cells_direct_row_p(src, xlen)){
+      memcpy(dst, src, xlen * sizeof(*dst));
+      for(unsigned xx = 0 ; xx < xlen ; ++xx){
+        dst[xx].channels &= ~NC_NOBACKGROUND_MASK;
+        dst[xx].width = 1;
+      }
+      continue;
+    }
+    for(unsigned xx = 0 ; xx < xlen ; ){
+      const nccell* c = &src[xx];
+      nccell* targ = &dst[xx];
+      const int cols = nccell_cols(c);
+      targ->stylemask = c->stylemask;
+      targ->channels = c->channels & ~NC_NOBACKGROUND_MASK;
+      targ->width = cols;
+      if(cell_simple_p(c)){
+        targ->gcluster = c->gcluster;
+      }else{
+        // egcpool_stash() copes with its source living in the pool it grows
+        const char* egc = nccell_extended_gcluster(n, c);
+        if(pool_stash_cell(&n->pool, targ, egc, strlen(egc))){
+          return -1;
+        }
+      }
+      // the right hand columns of a wide glyph, as ncplane_put() marks them
+      for(int i = 1 ; i < cols ; ++i){
+        dst[xx + i].gcluster = 0;
+        dst[xx + i].stylemask = targ->stylemask;
+        dst[xx + i].channels = targ->channels;
+        dst[xx + i].width = cols;
+      }
+      xx += cols;
+    }
+  }
+  return ylen * xlen;
+}
+
+// return the length of the run of printable 7-bit ASCII (0x20--0x7e) at the
+// start of the |len| bytes at |s|, working through 32 bytes at a time with
+// GNU C vector arithmetic where it's available (with an AVX2 clone selected
+// at load time on x86-64 glibc).
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9)
+typedef uint8_t asciilanes __attribute__ ((vector_size (32)));
+
+#if defined(__x86_64__) && defined(__GLIBC__) && !defined(__clang__)
+#define ASCII_CLONES __attribute__ ((target_clones ("avx2", "default")))
+#else
+#define ASCII_CLONES
+#endif
+
+ASCII_CLONES static size_t
+ascii_printable_run(const char* s, size_t len){
+  size_t off = 0;
+  for( ; off + sizeof(asciilanes) <= len ; off += sizeof(asciilanes)){
+    asciilanes v;
+    memcpy(&v, s + off, sizeof(v));
+    // anything below 0x20 wraps around, and joins 0x7f and up
+    const asciilanes bad = (asciilanes)((asciilanes)(v - 0x20u) > 0x5eu);
+    uint64_t w[sizeof(bad) / sizeof(uint64_t)];
+    memcpy(w, &bad, sizeof(w));
+    if(w[0] | w[1] | w[2] | w[3]){
+      break;
+    }
+  }
+  while(off < len && (unsigned char)(s[off] - 0x20) <= 0x5e){
+    ++off;
+  }
+  return off;
+}
+#else
+static size_t
+ascii_printable_run(const char* s, size_t len){
+  size_t off = 0;
+  while(off < len && (unsigned char)(s[off] - 0x20) <= 0x5e){
+    ++off;
+  }
+  return off;
+}
+#endif
+
+size_t utf8_ascii_run(const unsigned char* s, size_t len){
+  size_t off = 0;
+  // 32 bytes at a time, as four words which the compiler is free to OR
+  // together in a vector register
+  uint64_t w[4];
+  for( ; off + sizeof(w) <= len ; off += sizeof(w)){
+    memcpy(w, s + off, sizeof(w));
+    if((w[0] | w[1] | w[2] | w[3]) & 0x8080808080808080ull){
+      break;
+    }
+  }
+  while(off < len && s[off] < 0x80){
+    ++off;
+  }
+  return off;
+}
+
+size_t utf8_valid_prefix(const unsigned char* s, size_t len){
+  size_t off = 0;
+  while(off < len){
+    if((off += utf8_ascii_run(s + off, len - off)) == len){
+      break;
+    }
+    // utf8_codepoint_length() returns 1 for continuation bytes and illegal
+    // initiators (ASCII having been consumed above)
+    const size_t clen = utf8_codepoint_length(s[off]);
+    if(clen == 1 || clen > len - off){
+      break;
+    }
+    uint32_t cp;
+    if(utf8_decode((const char*)s + off, &cp) != (int)clen){
+      break;
+    }
+    off += clen;
+  }
+  return off;
+}
+
+// return the number of leading bytes of |s| (no more than |len|) which are
+// each a complete single-column EGC, i.e. printable ASCII. the last byte of
+// a run is excluded if a non-ASCII byte follows it, since that might be a
+// combining character (or joiner, or variation selector) extending it.
+static size_t
+ascii_egc_prefix(const char* s, size_t len){
+  size_t run = ascii_printable_run(s, len);
+  if(run && run < len && (unsigned char)s[run] >= 0x80){
+    --run;
+  }
+  return run;
+}
+
+// write the |len| printable ASCII characters at |s| to the cursor's row,
+// which must have room for them, using the plane's current styling. this is
+// what ncplane_put() does for each of them, less the per-glyph overhead.
+static void
+ncplane_put_ascii(ncplane* n, const char* s, unsigned len){
+  ncplane_damage_rows(n, n->y, 1);
+  put_cells_clear_span(n, n->y, n->x, len);
+  nccell* targ = &n->fb[nfbcellidx(n, n->y, n->x)];
+  const uint64_t channels = n->channels & ~NC_NOBACKGROUND_MASK;
+  for(unsigned i = 0 ; i < len ; ++i){
+    targ[i].gcluster = htole((uint32_t)(unsigned char)s[i]);
+    targ[i].width = 1;
+    targ[i].stylemask = n->stylemask;
+    targ[i].channels = channels;
+  }
+  n->x += len;
+}
+
+int ncplane_putnstr_yx(ncplane* n, int y, int x, size_t s, const char* gclusters){
+  int ret = 0;
+  size_t offset = 0;
+  while(offset < s && gclusters[offset]){
+    // runs of printable ASCII which fit on the target row needn't be
+    // segmented, nor written one glyph at a time. anything which might
+    // scroll, grow, or fail is left to ncplane_put().
+    if(!n->sprite && y >= -1 && x >= -1 && !ncplane_own(n)){
+      const unsigned ty = y < 0 ? n->y : (unsigned)y;
+      const unsigned tx = x < 0 ? n->x : (unsigned)x;
+      if(ty < n->leny && tx < n->lenx){
+        size_t run = ascii_egc_prefix(gclusters + offset, s - offset);
+        if(run){
+          if(run > n->lenx - tx){
+            run = n->lenx - tx;
+          }
+          n->y = ty;
+          n->x = tx;
+          ncplane_put_ascii(n, gclusters + offset, run);
+          y = -1;
+          x = -1;
+          offset += run;
+          ret += run;
+          continue;
+        }
+      }
+    }
+    size_t wcs;
+    int cols = ncplane_putegc_yx(n, y, x, gclusters + offset, &wcs);
+    if(cols < 0){
+      return -ret;
+    }
+    if(wcs == 0){
+      break;
+    }
+    // after the first iteration, just let the cursor code control where we
+    // print, so that scrolling is taken into account
+    y = -1;
+    x = -1;
+    offset += wcs;
+    ret += cols;
+  }
+  return ret;
 }
 
 int ncplane_putegc_yx(ncplane* n, int y, int x, const char* gclust, size_t* sbytes){
@@ -2362,6 +3517,141 @@ int ncplane_box(ncplane* n, const nccell* ul, const nccell* ur,
   return 0;
 }
 
+int ncboxstyle_init(ncboxstyle* bs, const char* gclusters, uint16_t styles,
+                    uint64_t channels){
+  nccell* cells[] = { &bs->ul, &bs->ur, &bs->ll, &bs->lr, &bs->hl, &bs->vl, };
+  for(size_t i = 0 ; i < sizeof(cells) / sizeof(*cells) ; ++i){
+    int cols;
+    int bytes = utf8_egc_len(gclusters, &cols);
+    if(bytes <= 0 || bytes > 4 || cols != 1 ||
+       is_control_egc((const unsigned char*)gclusters, bytes)){
+      logerror("box glyph %zu isn't a simple single-column EGC", i);
+      return -1;
+    }
+    nccell* c = cells[i];
+    memset(c, 0, sizeof(*c));
+    memcpy(&c->gcluster, gclusters, bytes);
+    c->width = 1;
+    c->stylemask = styles;
+    c->channels = channels & ~NC_NOBACKGROUND_MASK;
+    gclusters += bytes;
+  }
+  return 0;
+}
+
+ncboxstyle* ncboxstyle_create(const char* gclusters, uint16_t styles,
+                              uint64_t channels){
+  ncboxstyle* bs = malloc(sizeof(*bs));
+  if(bs == NULL){
+    return NULL;
+  }
+  if(ncboxstyle_init(bs, gclusters, styles, channels)){
+    free(bs);
+    return NULL;
+  }
+  return bs;
+}
+
+void ncboxstyle_destroy(ncboxstyle* bs){
+  free(bs);
+}
+
+int ncplane_box_span(ncplane* n, unsigned y, unsigned x, unsigned len,
+                     const nccell* c){
+  if(ncplane_own(n)){
+    return -1;
+  }
+  ncplane_damage_rows(n, y, 1);
+  put_cells_clear_span(n, y, x, len);
+  nccell* row = &n->fb[nfbcellidx(n, y, x)];
+  for(unsigned xx = 0 ; xx < len ; ++xx){
+    row[xx] = *c;
+  }
+  return 0;
+}
+
+int ncplane_box_styled(ncplane* n, const ncboxstyle* bs, int y, int x,
+                       unsigned ylen, unsigned xlen, unsigned ctlword){
+  if(n->sprite){
+    logerror("can't draw box on sprixelated plane");
+    return -1;
+  }
+  if(y < 0){
+    if(y != -1){
+      logerror("invalid y: %d", y);
+      return -1;
+    }
+    y = n->y;
+  }
+  if(x < 0){
+    if(x != -1){
+      logerror("invalid x: %d", x);
+      return -1;
+    }
+    x = n->x;
+  }
+  if(ylen < 2 || xlen < 2){
+    logerror("box too small (%ux%u)", ylen, xlen);
+    return -1;
+  }
+  if((unsigned)y >= n->leny || ylen > n->leny - y ||
+     (unsigned)x >= n->lenx || xlen > n->lenx - x){
+    logerror("%ux%u box at %d/%d exceeds plane (%ux%u)", ylen, xlen, y, x,
+             n->leny, n->lenx);
+    return -1;
+  }
+  // gradients interpolate per cell; leave them to the general path
+  if(ctlword & (NCBOXGRAD_TOP | NCBOXGRAD_RIGHT | NCBOXGRAD_BOTTOM | NCBOXGRAD_LEFT)){
+    if(ncplane_cursor_move_yx(n, y, x)){
+      return -1;
+    }
+    return ncplane_box(n, &bs->ul, &bs->ur, &bs->ll, &bs->lr, &bs->hl, &bs->vl,
+                       y + ylen - 1, x + xlen - 1, ctlword);
+  }
+  const bool top = !(ctlword & NCBOXMASK_TOP);
+  const bool right = !(ctlword & NCBOXMASK_RIGHT);
+  const bool bottom = !(ctlword & NCBOXMASK_BOTTOM);
+  const bool left = !(ctlword & NCBOXMASK_LEFT);
+  const unsigned needs = box_corner_needs(ctlword);
+  const unsigned ystop = y + ylen - 1;
+  const unsigned xstop = x + xlen - 1;
+  int ret = 0;
+  if(top + left >= (int)needs){
+    ret |= ncplane_box_span(n, y, x, 1, &bs->ul);
+  }
+  if(top && xlen > 2){
+    ret |= ncplane_box_span(n, y, x + 1, xlen - 2, &bs->hl);
+  }
+  if(top + right >= (int)needs){
+    ret |= ncplane_box_span(n, y, xstop, 1, &bs->ur);
+  }
+  for(unsigned yy = y + 1 ; yy < ystop ; ++yy){
+    if(left){
+      ret |= ncplane_box_span(n, yy, x, 1, &bs->vl);
+    }
+    if(right){
+      ret |= ncplane_box_span(n, yy, xstop, 1, &bs->vl);
+    }
+  }
+  if(bottom + left >= (int)needs){
+    ret |= ncplane_box_span(n, ystop, x, 1, &bs->ll);
+  }
+  if(bottom && xlen > 2){
+    ret |= ncplane_box_span(n, ystop, x + 1, xlen - 2, &bs->hl);
+  }
+  if(bottom + right >= (int)needs){
+    ret |= ncplane_box_span(n, ystop, xstop, 1, &bs->lr);
+  }
+  return ret ? -1 : 0;
+}
+
+void ncplane_damage_family(ncplane* n){
+  ncplane_damage(n);
+  for(ncplane* child = n->blist ; child ; child = child->bnext){
+    ncplane_damage_family(child);
+  }
+}
+
 // takes the head of a list of bound planes. performs a DFS on all planes bound
 // to 'n', and all planes down-list from 'n', moving all *by* 'dy' and 'dx'.
 static void
@@ -2381,6 +3671,13 @@ int ncplane_move_yx(ncplane* n, int y, int x){
   if(n == ncplane_notcurses(n)->stdplane){
     return -1;
   }
+  ncpile* p = ncplane_pile(n);
+  if(p->txdepth && ncpile_tx_list(p, n) == 0){
+    n->txy = y;
+    n->txx = x;
+    n->txmoved = true;
+    return 0;
+  }
   int dy, dx; // amount moved
   if(n->boundto == n){
     dy = y - n->absy;
@@ -2393,14 +3690,20 @@ int ncplane_move_yx(ncplane* n, int y, int x){
     if(n->sprite){
       sprixel_movefrom(n->sprite, n->absy, n->absx);
     }
+    ncplane_damage_family(n);
     n->absx += dx;
     n->absy += dy;
     move_bound_planes(n->blist, dy, dx);
+    ncpile_index_stale(ncplane_pile(n));
+    ncplane_damage_family(n);
   }
   return 0;
 }
 
 int ncplane_y(const ncplane* n){
+  if(n->txmoved){
+    return n->txy;
+  }
   if(n->boundto == n){
     return n->absy;
   }
@@ -2408,12 +3711,140 @@ int ncplane_y(const ncplane* n){
 }
 
 int ncplane_x(const ncplane* n){
+  if(n->txmoved){
+    return n->txx;
+  }
   if(n->boundto == n){
     return n->absx;
   }
   return n->absx - n->boundto->absx;
 }
 
+// apply any move pending for |n|, whose parent has been settled, having
+// moved by |dy|/|dx|. bound planes follow along, unless pending moves of
+// their own place them.
+static void
+tx_settle_family(ncplane* n, int dy, int dx){
+  if(n->txmoved){
+    int y = n->txy;
+    int x = n->txx;
+    if(n->boundto != n){
+      y += n->boundto->absy;
+      x += n->boundto->absx;
+    }
+    dy = y - n->absy;
+    dx = x - n->absx;
+    n->txmoved = false;
+  }
+  if(dy || dx){
+    if(n->sprite){
+      sprixel_movefrom(n->sprite, n->absy, n->absx);
+    }
+    ncplane_damage(n);
+    n->absy += dy;
+    n->absx += dx;
+    ncplane_damage(n);
+  }
+  for(ncplane* child = n->blist ; child ; child = child->bnext){
+    tx_settle_family(child, dy, dx);
+  }
+}
+
+static bool
+tx_ancestor_moved(const ncplane* n){
+  while(n->boundto != n){
+    n = n->boundto;
+    if(n->txmoved){
+      return true;
+    }
+  }
+  return false;
+}
+
+// apply everything recorded by |p|'s transaction: each family containing a
+// moved plane is walked once, from its outermost moved plane, and then each
+// pending resize callback is invoked once. the callbacks run outside the
+// transaction, so whatever they do takes effect immediately.
+static int
+ncpile_tx_apply(ncpile* p){
+  bool moved = false;
+  for(unsigned i = 0 ; i < p->txplaneslen ; ++i){
+    ncplane* n = p->txplanes[i];
+    if(n && n->txmoved && !tx_ancestor_moved(n)){
+      tx_settle_family(n, 0, 0);
+      moved = true;
+    }
+  }
+  if(moved){
+    ncpile_index_stale(p);
+  }
+  int ret = 0;
+  for(unsigned i = 0 ; i < p->txplaneslen ; ++i){
+    ncplane* n = p->txplanes[i];
+    if(n == NULL){
+      continue;
+    }
+    p->txplanes[i] = NULL;
+    n->txlisted = false;
+    if(n->txresize){
+      n->txresize = false;
+      if(n->resizecb){
+        ret |= n->resizecb(n);
+      }
+    }
+  }
+  p->txplaneslen = 0;
+  return ret;
+}
+
+int ncpile_begin_update(ncplane* n){
+  ++ncplane_pile(n)->txdepth;
+  return 0;
+}
+
+int ncpile_commit(ncplane* n){
+  ncpile* p = ncplane_pile(n);
+  if(p->txdepth == 0){
+    logerror("no transaction is open on this pile");
+    return -1;
+  }
+  if(--p->txdepth){
+    return 0;
+  }
+  return ncpile_tx_apply(p);
+}
+
+// |n|'s family is leaving |p| mid-transaction. their moves have been settled
+// (see ncplane_reparent_family()); take them off |p|'s list. any pending
+// resize callbacks go with them, to be picked up by tx_join_family().
+static void
+tx_leave_family(ncpile* p, ncplane* n){
+  if(n->txlisted){
+    ncpile_tx_forget(p, n);
+  }
+  for(ncplane* child = n->blist ; child ; child = child->bnext){
+    tx_leave_family(p, child);
+  }
+}
+
+// |n|'s family has joined a new pile. pending resize callbacks are listed
+// on its transaction, if it has one, and otherwise invoked now.
+static void
+tx_join_family(ncplane* n){
+  if(n->txresize){
+    ncpile* p = ncplane_pile(n);
+    if(p->txdepth == 0 || ncpile_tx_list(p, n)){
+      n->txresize = false;
+      if(n->resizecb){
+        n->resizecb(n);
+      }
+    }
+  }
+  for(ncplane* child = n->blist ; child ; child = child->bnext){
+    tx_join_family(child);
+  }
+}
+
 void ncplane_yx(const ncplane* n, int* y, int* x){
   if(y){
     *y = ncplane_y(n);
@@ -2430,18 +3861,36 @@ void ncplane_erase(ncplane* n){
     sprixel_hide(n->sprite);
     destroy_tam(n);
   }
-  // we must preserve the background, but a pure nccell_duplicate() would be
-  // wiped out by the egcpool_dump(). do a duplication (to get the stylemask
-  // and channels), and then reload.
-  char* egc = nccell_strdup(n, &n->basecell);
-  memset(n->fb, 0, sizeof(*n->fb) * n->leny * n->lenx);
-  egcpool_dump(&n->pool);
-  egcpool_init(&n->pool);
-  // we need to zero out the EGC before handing this off to nccell_load, but
-  // we don't want to lose the channels/attributes, so explicit gcluster load.
-  n->basecell.gcluster = 0;
-  nccell_load(n, &n->basecell, egc);
-  free(egc);
+  if(ncplane_own(n)){
+    return;
+  }
+  // we must preserve the background. a pooled EGC wouldn't survive the
+  // egcpool_reset(), so copy it out, and reload it afterwards. simple and
+  // interned EGCs are unaffected.
+  ncplane_damage(n);
+  const size_t cells = n->leny * n->lenx;
+  char* egc = NULL;
+  if(n->history || n->canvas){
+    // history (or a canvas) survives an erase, and with it the pool holding its EGCs. if
+    // there are no spilled EGCs anywhere, there's nothing to release.
+    if(n->pool.poolused || n->pool.interned){
+      release_cells(n, n->fb, cells);
+    }
+  }else{
+    if(cell_pooled_p(&n->basecell)){
+      egc = nccell_strdup(n, &n->basecell);
+    }
+    ncplane_release_interned(n, false);
+    egcpool_reset(&n->pool);
+  }
+  memset(n->fb, 0, sizeof(*n->fb) * cells);
+  if(egc){
+    // we need to zero out the EGC before handing this off to nccell_load, but
+    // we don't want to lose the channels/attributes, so explicit gcluster load.
+    n->basecell.gcluster = 0;
+    nccell_load(n, &n->basecell, egc);
+    free(egc);
+  }
   n->y = n->x = 0;
 }
 
@@ -2497,11 +3946,23 @@ int ncplane_erase_region(ncplane* n, int ystart, int xstart, int ylen, int xlen)
     return 0;
   }
   loginfo("erasing %d/%d - %d/%d", ystart, xstart, ystart + ylen, xstart + xlen);
+  if(ncplane_own(n)){
+    return -1;
+  }
+  ncplane_damage_rows(n, ystart, ylen);
+  // if the plane has no spilled EGCs, there's nothing to release, and each
+  // row of the region is a single memset().
+  const bool spilled = n->pool.poolused || n->pool.interned;
   for(int y = ystart ; y < ystart + ylen ; ++y){
-    for(int x = xstart ; x < xstart + xlen ; ++x){
-      nccell_release(n, &n->fb[nfbcellidx(n, y, x)]);
-      nccell_init(&n->fb[nfbcellidx(n, y, x)]);
+    nccell* row = n->fb + nfbcellidx(n, y, xstart);
+    if(spilled){
+      release_cells(n, row, xlen);
     }
+    memset(row, 0, sizeof(*row) * xlen);
+  }
+  // with the last pooled EGC gone, start the pool over
+  if(spilled && n->pool.poolused == 0){
+    egcpool_reset(&n->pool);
   }
   return 0;
 }
@@ -2523,12 +3984,27 @@ ncplane* ncplane_above(ncplane* n){
 }
 
 int notcurses_mice_enable(notcurses* n, unsigned eventmask){
+  raster_writer_wait(n->rwriter);
   if(mouse_setup(&n->tcache, eventmask)){
     return -1;
   }
   return 0;
 }
 
+int notcurses_paste_enable(notcurses* n, bool enable){
+  if(n->tcache.ttyfd < 0){
+    logerror("no tty, not emitting paste control");
+    return -1;
+  }
+  raster_writer_wait(n->rwriter);
+  if(tty_emit(enable ? DECSET(SET_BRACKETED_PASTE) : DECRST(SET_BRACKETED_PASTE),
+              n->tcache.ttyfd)){
+    return -1;
+  }
+  n->tcache.bracketedpaste = enable;
+  return 0;
+}
+
 ncpalette* ncpalette_new(notcurses* nc){
   ncpalette* p = malloc(sizeof(*p));
   if(p){
@@ -2804,10 +4280,78 @@ ncplane* ncplane_reparent(ncplane* n, ncplane* newparent){
   return ncplane_reparent_family(n, newparent);
 }
 
+// move any EGCs which 'n' and its descendants have interned in their pile's
+// table into their own egcpools. to be called before leaving the pile.
+static void
+unintern_cell(ncplane* n, nccell* c){
+  if(cell_interned_p(c)){
+    const int idx = cell_egc_idx(c);
+    const char* egc = n->pool.interns->slots[idx].egc;
+    int eoffset = egcpool_stash(&n->pool, egc, strlen(egc));
+    egcintern_release(n->pool.interns, idx);
+    --n->pool.interned;
+    if(eoffset < 0){
+      logerror("couldn't reclaim interned EGC, blanking cell");
+      c->gcluster = 0;
+    }else{
+      set_gcluster_egc(c, eoffset);
+    }
+  }
+}
+
+// unintern_family() rewrites the cells of 'n' and its descendants, so they
+// must first own their framebuffers.
+static int
+own_family(ncplane* n){
+  if(n->pool.interned && ncplane_own(n)){
+    return -1;
+  }
+  for(ncplane* child = n->blist ; child ; child = child->bnext){
+    if(own_family(child)){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void
+unintern_family(ncplane* n){
+  const size_t cells = n->leny * n->lenx;
+  for(size_t i = 0 ; i <= cells && n->pool.interned ; ++i){
+    unintern_cell(n, i < cells ? &n->fb[i] : &n->basecell);
+  }
+  const unsigned hlines = scrollback_count(n);
+  for(unsigned y = 0 ; y < hlines && n->pool.interned ; ++y){
+    nccell* row = scrollback_row(n, y);
+    for(unsigned x = 0 ; x < n->lenx ; ++x){
+      unintern_cell(n, &row[x]);
+    }
+  }
+  const unsigned maxspans = canvas_maxspans(n);
+  if(maxspans && n->pool.interned){
+    // each stored tile is a span; if we can't list them, walk them
+    cellspan* spans = malloc(sizeof(*spans) * maxspans);
+    if(spans){
+      const unsigned nspans = canvas_spans(n, spans);
+      for(unsigned s = 0 ; s < nspans && n->pool.interned ; ++s){
+        for(size_t i = 0 ; i < spans[s].count ; ++i){
+          unintern_cell(n, &spans[s].cells[i]);
+        }
+      }
+      free(spans);
+    }
+  }
+  n->pool.interns = NULL;
+  for(ncplane* child = n->blist ; child ; child = child->bnext){
+    unintern_family(child);
+  }
+}
+
 // unsplice self from the z-axis, and then unsplice all children, recursively.
 // to be called before unbinding 'n' from old pile.
 static void
 unsplice_zaxis_recursive(ncplane* n){
+  ncpile_index_stale(ncplane_pile(n));
   // might already have been unspliced, in which case ->above/->below are NULL
   if(ncplane_pile(n)->top == n){
     ncplane_pile(n)->top = n->below;
@@ -2857,10 +4401,13 @@ unsplice_sprixels_recursive(ncplane* n, sprixel* prev){
 
 // recursively splice 'n' and children into the z-axis, above 'n->boundto'.
 // handles 'n' == 'n->boundto'. to be called after binding 'n' into new pile.
+// sprixels needn't be rescaled here, should the new pile's cell-pixel
+// geometry differ; paint() does so once they're to be seen.
 static void
-splice_zaxis_recursive(ncplane* n, ncpile* p, unsigned ocellpxy, unsigned ocellpxx,
-                       unsigned ncellpxy, unsigned ncellpxx){
+splice_zaxis_recursive(ncplane* n, ncpile* p){
   n->pile = p;
+  n->pool.interns = p->interns;
+  ncpile_index_stale(p);
   if(n != n->boundto){
     if((n->above = n->boundto->above) == NULL){
       n->pile->top = n;
@@ -2870,14 +4417,8 @@ splice_zaxis_recursive(ncplane* n, ncpile* p, unsigned ocellpxy, unsigned ocellp
     n->below = n->boundto;
     n->boundto->above = n;
   }
-  if(n->sprite){
-    if(ocellpxy != ncellpxy || ocellpxx != ncellpxx){
-      sprixel_rescale(n->sprite, ncellpxy, ncellpxx);
-      // FIXME do what on error?
-    }
-  }
   for(ncplane* child = n->blist ; child ; child = child->bnext){
-    splice_zaxis_recursive(child, p, ocellpxy, ocellpxx, ncellpxy, ncellpxx);
+    splice_zaxis_recursive(child, p);
   }
 }
 
@@ -2894,6 +4435,24 @@ ncplane* ncplane_reparent_family(ncplane* n, ncplane* newparent){
   if(ncplane_descendant_p(newparent, n)){
     return NULL;
   }
+  if(n == newparent || ncplane_pile(n) != ncplane_pile(newparent)){
+    if(ncplane_pile(n)->interns && own_family(n)){
+      return NULL;
+    }
+  }
+  // pending moves are relative to our current parent, so settle them now.
+  // a family leaving the pile takes its pending callbacks along.
+  ncpile* txpile = NULL;
+  if(ncplane_pile(n)->txplaneslen){
+    tx_settle_family(n, 0, 0);
+    ncpile_index_stale(ncplane_pile(n));
+    if(n == newparent || ncplane_pile(n) != ncplane_pile(newparent)){
+      txpile = ncplane_pile(n);
+      tx_leave_family(txpile, n);
+    }
+  }
+  ncplane_damage_family(n); // in the pile we might be leaving
+  ncplane_layer_invalidate(n);
 //notcurses_debug(ncplane_notcurses(n), stderr);
   if(n->bprev){ // extract from sibling list
     if( (*n->bprev = n->bnext) ){
@@ -2907,11 +4466,12 @@ ncplane* ncplane_reparent_family(ncplane* n, ncplane* newparent){
   // if leaving a pile, extract n from the old zaxis, and also any sprixel
   sprixel* s = NULL;
   if(n == newparent || ncplane_pile(n) != ncplane_pile(newparent)){
+    if(ncplane_pile(n)->interns){
+      unintern_family(n);
+    }
     unsplice_zaxis_recursive(n);
     s = unsplice_sprixels_recursive(n, NULL);
   }
-  const unsigned ocellpxy = ncplane_pile(n)->cellpxy;
-  const unsigned ocellpxx = ncplane_pile(n)->cellpxx;
   n->boundto = newparent;
   if(n == n->boundto){ // we're a new root plane
     logdebug("reparenting new root plane %p", n);
@@ -2923,11 +4483,9 @@ ncplane* ncplane_reparent_family(ncplane* n, ncplane* newparent){
       ncpile_destroy(ncplane_pile(n));
     }
     make_ncpile(nc, n);
-    unsigned ncellpxy = ncplane_pile(n)->cellpxy;
-    unsigned ncellpxx = ncplane_pile(n)->cellpxx;
     pthread_mutex_unlock(&nc->pilelock);
     if(ncplane_pile(n)){ // FIXME otherwise, we've got a problem...!
-      splice_zaxis_recursive(n, ncplane_pile(n), ocellpxy, ocellpxx, ncellpxy, ncellpxx);
+      splice_zaxis_recursive(n, ncplane_pile(n));
     }
   }else{ // establish ourselves as a sibling of new parent's children
     if( (n->bnext = newparent->blist) ){
@@ -2937,15 +4495,16 @@ ncplane* ncplane_reparent_family(ncplane* n, ncplane* newparent){
     newparent->blist = n;
     // place it immediately above the new binding plane if crossing piles
     if(ncplane_pile(n) != ncplane_pile(n->boundto)){
-      unsigned ncellpxy = ncplane_pile(n->boundto)->cellpxy;
-      unsigned ncellpxx = ncplane_pile(n->boundto)->cellpxx;
       pthread_mutex_lock(&nc->pilelock);
+      // the departing family might include the pile's scrolling plane
+      ncplane_pile(n)->scrollplane = NULL;
+      ncplane_pile(n)->planescrolls = -1;
       if(ncplane_pile(n)->top == NULL){ // did we just empty our pile?
         ncpile_destroy(ncplane_pile(n));
       }
       n->pile = ncplane_pile(n->boundto);
       pthread_mutex_unlock(&nc->pilelock);
-      splice_zaxis_recursive(n, ncplane_pile(n), ocellpxy, ocellpxx, ncellpxy, ncellpxx);
+      splice_zaxis_recursive(n, ncplane_pile(n));
     }
   }
   if(s){ // must be on new plane, with sprixels to donate
@@ -2958,6 +4517,10 @@ ncplane* ncplane_reparent_family(ncplane* n, ncplane* newparent){
     }
     n->pile->sprixelcache = s;
   }
+  ncplane_damage_family(n); // in the pile we've joined
+  if(txpile){
+    tx_join_family(n);
+  }
   return n;
 }
 
@@ -3067,36 +4630,52 @@ int ncdirect_inputready_fd(ncdirect* n){
   return inputready_fd(n->tcache.ictx);
 }
 
-// FIXME speed this up, PoC
-// given an egc, get its index in the blitter's EGC set
+// decode the first codepoint of the UTF-8 |egc|. blitter glyphs are always
+// a single codepoint.
 static int
-get_blitter_egc_idx(const struct blitset* bset, const char* egc){
-  wchar_t wc;
-  mbstate_t mbs = {0};
-  size_t sret = mbrtowc(&wc, egc, strlen(egc), &mbs);
-  if(sret == (size_t)-1 || sret == (size_t)-2){
+egc_codepoint(const char* egc, uint32_t* wc){
+  const unsigned char* s = (const unsigned char*)egc;
+  unsigned len;
+  if(s[0] < 0x80){
+    *wc = s[0];
+    return s[0] ? 0 : -1;
+  }else if(s[0] >= 0xc2 && s[0] <= 0xdf){
+    len = 2;
+    *wc = s[0] & 0x1f;
+  }else if(s[0] >= 0xe0 && s[0] <= 0xef){
+    len = 3;
+    *wc = s[0] & 0x0f;
+  }else if(s[0] >= 0xf0 && s[0] <= 0xf4){
+    len = 4;
+    *wc = s[0] & 0x07;
+  }else{
     return -1;
   }
-  wchar_t* wptr = wcsrchr(bset->egcs, wc);
-  if(wptr == NULL){
-//fprintf(stderr, "FAILED TO FIND [%s] (%lc) in [%ls]\n", egc, wc, bset->egcs);
-    return -1;
+  for(unsigned i = 1 ; i < len ; ++i){
+    if((s[i] & 0xc0) != 0x80){
+      return -1;
+    }
+    *wc = (*wc << 6) | (s[i] & 0x3f);
   }
-//fprintf(stderr, "FOUND [%s] (%lc) in [%ls] (%zu)\n", egc, wc, bset->egcs, wptr - bset->egcs);
-  return wptr - bset->egcs;
+  return 0;
 }
 
-static bool
-is_bg_p(int idx, int py, int px, int width){
-  // bit increases to the right, and down
-  const int bpos = py * width + px; // bit corresponding to pixel, 0..|egcs|-1
-  const unsigned mask = 1u << bpos;
-  if(idx & mask){
-    return false;
+// the pixel for an RGB channel, or transparent if it's not opaque
+static inline uint32_t
+rgba_channel_pixel(uint32_t channel){
+  uint32_t p = 0;
+  if(ncchannel_alpha(channel) == NCALPHA_OPAQUE){
+    ncpixel_set_a(&p, 0xff);
+    ncpixel_set_r(&p, ncchannel_r(channel));
+    ncpixel_set_g(&p, ncchannel_g(channel));
+    ncpixel_set_b(&p, ncchannel_b(channel));
   }
-  return true;
+  return p;
 }
 
+// each cell's glyph is mapped to its bitmask through the blitset's hash (see
+// blitset_egc_mask()), and the cell's |height| rows of |width| pixels are
+// written directly into the output, row by row.
 static inline uint32_t*
 ncplane_as_rgba_internal(const ncplane* nc, ncblitter_e blit,
                          int begy, int begx, unsigned leny, unsigned lenx,
@@ -3119,63 +4698,54 @@ ncplane_as_rgba_internal(const ncplane* nc, ncblitter_e blit,
     logerror("blitter %d invalid in current environment", blit);
     return NULL;
   }
-//fprintf(stderr, "ALLOCATING %u %d %d %p\n", 4u * lenx * leny * 2, leny, lenx, bset);
+  if(bset->egcs == NULL){
+    logerror("blitter %d can't be reversed", blit);
+    return NULL;
+  }
+  if(nc->sprite){
+    logerror("can't convert sprixelated plane");
+    return NULL;
+  }
   if(pxdimy){
     *pxdimy = leny * bset->height;
   }
   if(pxdimx){
     *pxdimx = lenx * bset->width;
   }
-  uint32_t* ret = malloc(sizeof(*ret) * lenx * bset->width * leny * bset->height);
-//fprintf(stderr, "GEOM: %d/%d %d/%d ret: %p\n", bset->height, bset->width, *pxdimy, *pxdimx, ret);
-  if(ret){
-    for(unsigned y = ystart, targy = 0 ; y < ystart + leny ; ++y, targy += bset->height){
-      for(unsigned x = xstart, targx = 0 ; x < xstart + lenx ; ++x, targx += bset->width){
-        uint16_t stylemask;
-        uint64_t channels;
-        char* c = ncplane_at_yx(nc, y, x, &stylemask, &channels);
-        if(c == NULL){
-          free(ret);
-          return NULL;
-        }
-        int idx = get_blitter_egc_idx(bset, c);
-        if(idx < 0){
-          free(ret);
-          free(c);
-          return NULL;
-        }
-        unsigned fr, fg, fb, br, bg, bb, fa, ba;
-        ncchannels_fg_rgb8(channels, &fr, &fb, &fg);
-        fa = ncchannels_fg_alpha(channels);
-        ncchannels_bg_rgb8(channels, &br, &bb, &bg);
-        ba = ncchannels_bg_alpha(channels);
-        // handle each destination pixel from this cell
-        for(unsigned py = 0 ; py < bset->height ; ++py){
-          for(unsigned px = 0 ; px < bset->width ; ++px){
-            uint32_t* p = &ret[(targy + py) * (lenx * bset->width) + (targx + px)];
-            bool background = is_bg_p(idx, py, px, bset->width);
-            if(background){
-              if(ba){
-                *p = 0;
-              }else{
-                ncpixel_set_a(p, 0xff);
-                ncpixel_set_r(p, br);
-                ncpixel_set_g(p, bb);
-                ncpixel_set_b(p, bg);
-              }
-            }else{
-              if(fa){
-                *p = 0;
-              }else{
-                ncpixel_set_a(p, 0xff);
-                ncpixel_set_r(p, fr);
-                ncpixel_set_g(p, fb);
-                ncpixel_set_b(p, fg);
-              }
-            }
-          }
+  const size_t pxrow = (size_t)lenx * bset->width;
+  uint32_t* ret = malloc(sizeof(*ret) * pxrow * leny * bset->height);
+  if(ret == NULL){
+    return NULL;
+  }
+  for(unsigned y = ystart, targy = 0 ; y < ystart + leny ; ++y, targy += bset->height){
+    uint32_t* cellrow = ret + targy * pxrow;
+    for(unsigned x = xstart ; x < xstart + lenx ; ++x, cellrow += bset->width){
+      const nccell* c = &nc->fb[nfbcellidx(nc, y, x)];
+      // like ncplane_at_yx(), the right side of a wide glyph is its left side,
+      // and an empty cell takes the base cell's glyph (but its own channels).
+      const nccell* egcc = c;
+      if(nccell_wide_right_p(c) && x){
+        egcc = c = &nc->fb[nfbcellidx(nc, y, x - 1)];
+      }
+      if(egcc->gcluster == 0){
+        egcc = &nc->basecell;
+      }
+      uint32_t wc;
+      int mask;
+      if(egc_codepoint(nccell_extended_gcluster(nc, egcc), &wc) ||
+         (mask = blitset_egc_mask(bset, wc)) < 0){
+        free(ret);
+        return NULL;
+      }
+      const uint32_t fgp = rgba_channel_pixel(ncchannels_fchannel(c->channels));
+      const uint32_t bgp = rgba_channel_pixel(ncchannels_bchannel(c->channels));
+      // bits increase to the right, and then down
+      uint32_t* p = cellrow;
+      for(unsigned py = 0 ; py < bset->height ; ++py, p += pxrow){
+        for(unsigned px = 0 ; px < bset->width ; ++px){
+          p[px] = (mask & 1) ? fgp : bgp;
+          mask >>= 1;
         }
-        free(c);
       }
     }
   }
@@ -3195,40 +4765,106 @@ uint32_t* ncplane_as_rgba(const ncplane* nc, ncblitter_e blit,
   return ncplane_as_rgba_internal(nc, blit, begy, begx, leny, lenx, pxdimy, pxdimx);
 }
 
-// return a heap-allocated copy of the contents
+// the EGC of the cell at |y|/|x|, and its length. the right halves of wide
+// glyphs have no EGC of their own, and contribute nothing, so each wide EGC
+// is only emitted once.
+static inline const char*
+contents_egc(const ncplane* n, unsigned y, unsigned x, size_t* len){
+  const char* egc = nccell_extended_gcluster(n, &n->fb[nfbcellidx(n, y, x)]);
+  *len = strlen(egc);
+  return egc;
+}
+
+// total bytes of EGC in the region's row |y|
+static size_t
+contents_row_len(const ncplane* n, unsigned y, unsigned xstart, unsigned lenx){
+  size_t len = 0;
+  for(unsigned x = xstart ; x < xstart + lenx ; ++x){
+    size_t clen;
+    contents_egc(n, y, x, &clen);
+    len += clen;
+  }
+  return len;
+}
+
+// write the EGCs of the region's row |y| to |buf|, returning bytes written
+static size_t
+contents_row(const ncplane* n, unsigned y, unsigned xstart, unsigned lenx, char* buf){
+  char* w = buf;
+  for(unsigned x = xstart ; x < xstart + lenx ; ++x){
+    size_t clen;
+    const char* egc = contents_egc(n, y, x, &clen);
+    memcpy(w, egc, clen);
+    w += clen;
+  }
+  return w - buf;
+}
+
+static int
+contents_geometry(const ncplane* n, int begy, int begx, unsigned* leny,
+                  unsigned* lenx, unsigned* ystart, unsigned* xstart){
+  if(n->sprite){
+    logerror("invoked on a sprixel plane");
+    return -1;
+  }
+  return check_geometry_args(n, begy, begx, leny, lenx, ystart, xstart);
+}
+
+// return a heap-allocated copy of the contents. the region is measured
+// first, so that we allocate only once.
 char* ncplane_contents(ncplane* nc, int begy, int begx, unsigned leny, unsigned lenx){
   unsigned ystart, xstart;
-  if(check_geometry_args(nc, begy, begx, &leny, &lenx, &ystart, &xstart)){
+  if(contents_geometry(nc, begy, begx, &leny, &lenx, &ystart, &xstart)){
     return NULL;
   }
-  size_t retlen = 1;
-  char* ret = malloc(retlen);
-  if(ret){
-    for(unsigned y = ystart, targy = 0 ; y < ystart + leny ; ++y, targy += 2){
-      for(unsigned x = xstart, targx = 0 ; x < xstart + lenx ; ++x, ++targx){
-        nccell ncl = NCCELL_TRIVIAL_INITIALIZER;
-        // we need ncplane_at_yx_cell() here instead of ncplane_at_yx(),
-        // because we should only have one copy of each wide EGC.
-        int clen;
-        if((clen = ncplane_at_yx_cell(nc, y, x, &ncl)) < 0){
-          free(ret);
-          return NULL;
-        }
-        const char* c = nccell_extended_gcluster(nc, &ncl);
-        if(clen){
-          char* tmp = realloc(ret, retlen + clen);
-          if(!tmp){
-            free(ret);
-            return NULL;
-          }
-          ret = tmp;
-          memcpy(ret + retlen - 1, c, clen);
-          retlen += clen;
-        }
+  size_t total = 0;
+  for(unsigned y = ystart ; y < ystart + leny ; ++y){
+    total += contents_row_len(nc, y, xstart, lenx);
+  }
+  char* ret = malloc(total + 1);
+  if(ret == NULL){
+    return NULL;
+  }
+  size_t used = 0;
+  for(unsigned y = ystart ; y < ystart + leny ; ++y){
+    used += contents_row(nc, y, xstart, lenx, ret + used);
+  }
+  ret[used] = '\0';
+  return ret;
+}
+
+int ncplane_contents_stream(const ncplane* n, int begy, int begx,
+                            unsigned leny, unsigned lenx,
+                            nccontentscb cb, void* curry){
+  unsigned ystart, xstart;
+  if(contents_geometry(n, begy, begx, &leny, &lenx, &ystart, &xstart)){
+    return -1;
+  }
+  // one buffer serves every row, growing only for a longer row than any yet
+  char* buf = NULL;
+  size_t bufsize = 0;
+  int ret = 0;
+  for(unsigned y = ystart ; y < ystart + leny ; ++y){
+    const size_t len = contents_row_len(n, y, xstart, lenx);
+    if(len > bufsize){
+      size_t newsize = bufsize ? bufsize * 2 : 256;
+      while(newsize < len){
+        newsize *= 2;
       }
+      char* tmp = realloc(buf, newsize);
+      if(tmp == NULL){
+        ret = -1;
+        break;
+      }
+      buf = tmp;
+      bufsize = newsize;
+    }
+    contents_row(n, y, xstart, lenx, buf);
+    if( (ret = cb(buf, len, y, curry)) ){
+      break;
     }
-    ret[retlen - 1] = '\0';
   }
+  free(buf);
   return ret;
 }
 
@@ -3288,7 +4924,16 @@ int ncstrwidth(const char* egcs, int* validbytes, int* validwidth){
     validbytes = &bytes;
   }
   *validbytes = 0;
+  const char* end = egcs + strlen(egcs);
   do{
+    // runs of printable ASCII are a column per byte, and needn't be segmented
+    const size_t run = ascii_egc_prefix(egcs, end - egcs);
+    egcs += run;
+    *validbytes += run;
+    *validwidth += run;
+    if(run && *egcs == '\0'){
+      break;
+    }
     int thesecols, thesebytes;
     thesebytes = utf8_egc_len(egcs, &thesecols);
     if(thesebytes < 0){
@@ -3301,6 +4946,34 @@ int ncstrwidth(const char* egcs, int* validbytes, int* validwidth){
   return *validwidth;
 }
 
+// replacement set with notcurses_set_width_fxn(), or NULL
+static int (*ncwidth_override)(uint32_t);
+
+int ncwidth(uint32_t cp){
+  int (*fxn)(uint32_t) = __atomic_load_n(&ncwidth_override, __ATOMIC_RELAXED);
+  if(fxn){
+    return fxn(cp);
+  }
+  if(cp < 0x7f){
+    return cp >= 0x20 ? 1 : cp ? -1 : 0;
+  }
+  if(cp >= 0x110000){
+    return -1;
+  }
+  const uint8_t* block = ncwidth_stage2[ncwidth_stage1[cp / NCWIDTH_BLOCK]];
+  const unsigned idx = cp % NCWIDTH_BLOCK;
+  const unsigned w = (block[idx / 4] >> ((idx % 4) * 2)) & 0x3u;
+  return w == 3 ? -1 : (int)w;
+}
+
+int notcurses_ucs32_width(uint32_t cp){
+  return ncwidth(cp);
+}
+
+void notcurses_set_width_fxn(int (*fxn)(uint32_t cp)){
+  __atomic_store_n(&ncwidth_override, fxn, __ATOMIC_RELAXED);
+}
+
 void ncplane_pixel_geom(const ncplane* n,
                         unsigned* RESTRICT pxy, unsigned* RESTRICT pxx,
                         unsigned* RESTRICT celldimy, unsigned* RESTRICT celldimx,
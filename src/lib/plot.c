@@ -3,8 +3,26 @@
 #include <limits.h>
 #include <string.h>
 #include <inttypes.h>
+#include <stdatomic.h>
 #include "internal.h"
 
+// samples staged from other threads. there is one entry per slot, indexed by
+// x modulo the slot count. producers add to (or overwrite) the entry for their
+// x without taking a lock, and the redraw drains the entries into the slots.
+// an entry still holding an older x is reclaimed for the newer one; since the
+// two differ by at least a full window, the older x would be discarded anyway.
+#define STAGE_EMPTY   -1
+#define STAGE_CLAIMED -2
+
+typedef struct plotstage {
+  _Atomic int64_t x;     // x staged here, or STAGE_EMPTY/STAGE_CLAIMED
+  _Atomic uint64_t add;  // accumulated additions (bits of a double for ncdplot)
+  _Atomic uint64_t set;  // most recently set value (likewise)
+  atomic_bool hasset;    // set has been written since the last drain
+  atomic_bool pending;   // something has been written since the last drain
+  atomic_uint writers;   // threads accessing the entry on behalf of x
+} plotstage;
+
 // common elements of type-parameterized plots
 typedef struct ncplot {
   ncplane* ncp;
@@ -36,6 +54,21 @@ typedef struct ncplot {
   bool detectdomain; /* is domain detection in effect (stretch the domain)? */
   bool detectonlymax; /* domain detection applies only to max, not min */
   bool printsample; /* print the most recent sample */
+  /* state of the plane as of the last cell-blitted redraw, which allows the
+     next one to shift the columns over rather than starting from scratch. */
+  bool drawn; /* the plane holds a complete redraw */
+  unsigned drawndimy, drawndimx;
+  int64_t drawnslotx; /* slotx when last drawn */
+  int64_t dirtyx; /* oldest x written since the last redraw */
+  unsigned samplecols; /* columns occupied by the printed sample */
+  int titlex; /* column following the title on the top row */
+  /* when decimating, each slot summarizes xper consecutive x values, and
+     the slot ring is indexed by x / xper (as are slotx and dirtyx). the
+     slot holds the selected statistic; the bucket holds all of them. */
+  uint64_t xper;
+  uint64_t decimation; /* NCPLOT_OPTION_DECIMATE_* flag, or 0 */
+  plotstage* stage; /* slotcount entries staged by ncXplot_stage_*() */
+  atomic_bool staged; /* some entry is pending */
 } ncplot;
 
 static inline int
@@ -83,9 +116,17 @@ calculate_gradient_vector(ncplot* p, unsigned pixelp){
 
 #define MAXWIDTH 2
 #define CREATE(T, X) \
+/* every observation falling into a decimated slot */ \
+typedef struct nc##X##bucket { \
+  T min, max, sum; \
+  uint64_t count; \
+} nc##X##bucket; \
+\
 typedef struct nc##X##plot { \
   T* slots; \
+  nc##X##bucket* buckets; /* slotcount of them when decimating, else NULL */ \
   T miny, maxy; \
+  T drawnminy, drawnmaxy; /* domain when last drawn */ \
   ncplot plot; \
 } nc##X##plot; \
 \
@@ -256,14 +297,261 @@ int redraw_pixelplot_##T(nc##X##plot* ncp){ \
   return 0; \
 } \
 \
+/* draw the dependent axis labels and/or the title. returns the column \
+   following the title on the top row, which the plot columns might cover. */ \
+static int draw_labels_##T(nc##X##plot* ncp, unsigned dimy, double interval, size_t states){ \
+  int endx = 0; \
+  ncplane_set_styles(ncp->plot.ncp, ncp->plot.legendstyle); \
+  if(ncp->plot.labelaxisd){ \
+    /* show the *top* of each interval range */ \
+    for(unsigned y = 0 ; y < dimy ; ++y){ \
+      ncplane_set_channels(ncp->plot.ncp, ncp->plot.channels[y]); \
+      char buf[NCPREFIXSTRLEN + 1]; \
+      if(ncp->plot.exponentiali){ \
+        if(y == dimy - 1){ /* we cheat on the top row to exactly match maxy */ \
+          ncqprefix(ncp->maxy * 100, 100, buf, 0); \
+        }else{ \
+          ncqprefix(pow(interval, (y + 1) * states) * 100, 100, buf, 0); \
+        } \
+      }else{ \
+        ncqprefix((ncp->maxy - interval * states * (dimy - y - 1)) * 100, 100, buf, 0); \
+      } \
+      if(y == dimy - 1 && strlen(ncp->plot.title)){ \
+        ncplane_printf_yx(ncp->plot.ncp, dimy - y - 1, NCPREFIXCOLUMNS - strlen(buf), "%s %s", buf, ncp->plot.title); \
+      }else{ \
+        ncplane_printf_yx(ncp->plot.ncp, dimy - y - 1, NCPREFIXCOLUMNS - strlen(buf), "%s", buf); \
+      } \
+    } \
+    endx = ncplane_cursor_x(ncp->plot.ncp); \
+  }else if(strlen(ncp->plot.title)){ \
+    ncplane_set_channels(ncp->plot.ncp, ncp->plot.channels[dimy - 1]); \
+    ncplane_printf_yx(ncp->plot.ncp, 0, NCPREFIXCOLUMNS - strlen(ncp->plot.title), "%s", ncp->plot.title); \
+    endx = ncplane_cursor_x(ncp->plot.ncp); \
+  } \
+  ncplane_set_styles(ncp->plot.ncp, NCSTYLE_NONE); \
+  return endx; \
+} \
+\
+/* draw column x from the |scale| slots ending at idx. only cells with \
+   something to show are written; the column is expected to be clear. \
+   returns the index of the slot preceding those drawn, or -1 on error. */ \
+static int draw_column_##T(nc##X##plot* ncp, int x, int idx, unsigned dimy, \
+                           unsigned scale, size_t states, double interval){ \
+  /* a single column might correspond to more than 1 ('scale', up to \
+     MAXWIDTH) slots' worth of samples. prepare the working gval set. */ \
+  T gvals[MAXWIDTH]; \
+  /* load it retaining the same ordering we have in the actual array */ \
+  for(int i = scale - 1 ; i >= 0 ; --i){ \
+    gvals[i] = ncp->slots[idx]; /* clip the value at the limits of the graph */ \
+    if(gvals[i] < ncp->miny){ \
+      gvals[i] = ncp->miny; \
+    } \
+    if(gvals[i] > ncp->maxy){ \
+      gvals[i] = ncp->maxy; \
+    } \
+    /* FIXME if there are an odd number, only go up through the valid ones... */ \
+    if(--idx < 0){ \
+      idx = ncp->plot.slotcount - 1; \
+    } \
+  } \
+  /* starting from the least-significant row, progress in the more significant \
+     direction, drawing egcs from the grid specification, aborting early if \
+     we can't draw anything in a given cell. */ \
+  T intervalbase = ncp->miny; \
+  const wchar_t* egc = ncp->plot.bset->plotegcs; \
+  bool done = !ncp->plot.bset->fill; \
+  for(unsigned y = 0 ; y < dimy ; ++y){ \
+    ncplane_set_channels(ncp->plot.ncp, ncp->plot.channels[y]); \
+    size_t egcidx = 0, sumidx = 0; \
+    /* if we've got at least one interval's worth on the number of positions \
+      times the number of intervals per position plus the starting offset, \
+      we're going to print *something* */ \
+    for(unsigned i = 0 ; i < scale ; ++i){ \
+      sumidx *= states; \
+      if(intervalbase < gvals[i]){ \
+        if(ncp->plot.exponentiali){ \
+          /* we want the log-base-interval of gvals[i] */ \
+          double scaled = log(gvals[i] - ncp->miny) / log(interval); \
+          double sival = intervalbase ? log(intervalbase) / log(interval) : 0; \
+          egcidx = scaled - sival; \
+        }else{ \
+          egcidx = (gvals[i] - intervalbase) / interval; \
+        } \
+        if(egcidx >= states){ \
+          egcidx = states - 1; \
+          done = false; \
+        } \
+        sumidx += egcidx; \
+      }else{ \
+        egcidx = 0; \
+      } \
+/* printf(stderr, "y: %d i(scale): %d gvals[%d]: %ju egcidx: %zu sumidx: %zu interval: %f intervalbase: %ju\n", y, i, i, gvals[i], egcidx, sumidx, interval, intervalbase); */ \
+    } \
+    /* if we're not UTF8, we can only arrive here via NCBLIT_1x1 (otherwise \
+      we would have errored out during construction). even then, however, \
+      we need handle ASCII differently, since it can't print full block. \
+      in ASCII mode, sumidx != 0 means swap colors and use space. in all \
+      modes, sumidx == 0 means don't do shit, since we erased earlier. */ \
+/* if(sumidx)fprintf(stderr, "dimy: %d y: %d x: %d sumidx: %zu egc[%zu]: %lc\n", dimy, y, x, sumidx, sumidx, egc[sumidx]); */ \
+    if(sumidx){ \
+      uint64_t chan = ncp->plot.channels[y]; \
+      if(notcurses_canutf8(ncplane_notcurses(ncp->plot.ncp))){ \
+        char utf8[MB_LEN_MAX + 1]; \
+        int bytes = wctomb(utf8, egc[sumidx]); \
+        if(bytes < 0){ \
+          return -1; \
+        } \
+        utf8[bytes] = '\0'; \
+        nccell* c = ncplane_cell_ref_yx(ncp->plot.ncp, dimy - y - 1, x); \
+        cell_set_bchannel(c, ncchannels_bchannel(chan)); \
+        cell_set_fchannel(c, ncchannels_fchannel(chan)); \
+        nccell_set_styles(c, NCSTYLE_NONE); \
+        if(pool_blit_direct(&ncp->plot.ncp->pool, c, utf8, bytes, 1) <= 0){ \
+          return -1; \
+        } \
+      }else{ \
+        const uint64_t swapbg = ncchannels_bchannel(chan); \
+        const uint64_t swapfg = ncchannels_fchannel(chan); \
+        ncchannels_set_bchannel(&chan, swapfg); \
+        ncchannels_set_fchannel(&chan, swapbg); \
+        ncplane_set_channels(ncp->plot.ncp, chan); \
+        if(ncplane_putchar_yx(ncp->plot.ncp, dimy - y - 1, x, ' ') <= 0){ \
+          return -1; \
+        } \
+        ncchannels_set_bchannel(&chan, swapbg); \
+        ncchannels_set_fchannel(&chan, swapfg); \
+        ncplane_set_channels(ncp->plot.ncp, chan); \
+      } \
+    } \
+    if(done){ \
+      break; \
+    } \
+    if(ncp->plot.exponentiali){ \
+      intervalbase = ncp->miny + pow(interval, (y + 1) * states - 1); \
+    }else{ \
+      intervalbase += (states * interval); \
+    } \
+  } \
+  return idx; \
+} \
+\
+/* if the domain and geometry are what we last drew, and the window has \
+   advanced by whole columns, shift the existing columns left and draw only \
+   the new ones, along with any older columns having new samples, and the \
+   text which overlaps columns (the title and the printed sample). returns 1 \
+   if a full redraw is required instead. */ \
+static int scroll_plot_##T(nc##X##plot* ncp, unsigned dimy, unsigned dimx, int startx, \
+                           int finalx, unsigned scale, size_t states, double interval, \
+                           const char* sample){ \
+  if(!ncp->plot.drawn || dimy != ncp->plot.drawndimy || dimx != ncp->plot.drawndimx){ \
+    return 1; \
+  } \
+  if(ncp->miny != ncp->drawnminy || ncp->maxy != ncp->drawnmaxy){ \
+    return 1; /* the scale changed, and with it every column and label */ \
+  } \
+  const int cols = finalx - startx + 1; \
+  if(cols <= 0 || cols * scale > ncp->plot.slotcount){ \
+    return 1; /* leftmost columns wrap around to the newest slots */ \
+  } \
+  const int64_t advance = ncp->plot.slotx - ncp->plot.drawnslotx; \
+  if(advance < 0 || advance % scale || advance / scale >= cols){ \
+    return 1; \
+  } \
+  const int shift = advance / scale; \
+  /* text right-aligned over the labels can't be cleaned up column-wise */ \
+  if((int)dimx - (int)ncp->plot.samplecols < startx){ \
+    return 1; \
+  } \
+  if(sample && (int)dimx - (int)strlen(sample) < startx){ \
+    return 1; \
+  } \
+  /* lox is the leftmost column which must be cleared and redrawn: that of the \
+     oldest sample written since we last drew, or of the oldest new sample. */ \
+  int64_t dirtyx = ncp->plot.drawnslotx + 1; \
+  if(ncp->plot.dirtyx < dirtyx){ \
+    dirtyx = ncp->plot.dirtyx; \
+  } \
+  int lox = dimx; \
+  if(dirtyx <= ncp->plot.slotx){ \
+    if(ncp->plot.slotx - dirtyx >= (int64_t)cols * scale){ \
+      lox = startx; \
+    }else{ \
+      lox = finalx - (ncp->plot.slotx - dirtyx) / scale; \
+    } \
+  } \
+  if(ncp->plot.samplecols){ /* the old sample moved left with its columns */ \
+    int oldx = dimx - ncp->plot.samplecols - shift; \
+    if(oldx < startx){ \
+      oldx = startx; \
+    } \
+    if(oldx < lox){ \
+      lox = oldx; \
+    } \
+  } \
+  if(sample && (int)(dimx - strlen(sample)) < lox){ \
+    lox = dimx - strlen(sample); \
+  } \
+  const double colinterval = interval ? interval : 1; \
+  ncplane* n = ncp->plot.ncp; \
+  if(shift){ \
+    for(unsigned y = 0 ; y < dimy ; ++y){ \
+      nccell* row = &n->fb[nfbcellidx(n, y, 0)]; \
+      for(int x = startx ; x < startx + shift ; ++x){ \
+        nccell_release(n, &row[x]); \
+      } \
+      memmove(row + startx, row + startx + shift, (cols - shift) * sizeof(*row)); \
+      /* the vacated cells' EGCs moved left; don't release them */ \
+      memset(row + finalx + 1 - shift, 0, shift * sizeof(*row)); \
+    } \
+  } \
+  ncplane_damage(n); \
+  if(lox < (int)dimx){ \
+    if(ncplane_erase_region(n, 0, lox, dimy, dimx - lox)){ \
+      return -1; \
+    } \
+  } \
+  /* the title was printed before the columns, which cover it where they're \
+     drawn, and it has just been shifted along with them. clear it from the \
+     top row, restore it, and redraw the columns it crosses. */ \
+  int titlex = startx; \
+  if(strlen(ncp->plot.title) && (shift || lox < ncp->plot.titlex)){ \
+    titlex = ncp->plot.titlex < lox ? ncp->plot.titlex : lox; \
+    if(titlex > startx){ \
+      if(ncplane_erase_region(n, 0, startx, 1, titlex - startx)){ \
+        return -1; \
+      } \
+    } \
+    draw_labels_##T(ncp, dimy, interval, states); \
+  } \
+  for(int x = finalx ; x >= startx ; --x){ \
+    if(x < lox && x >= titlex){ \
+      continue; \
+    } \
+    int idx = ((int)ncp->plot.slotstart - (finalx - x) * (int)scale) % (int)ncp->plot.slotcount; \
+    if(idx < 0){ \
+      idx += ncp->plot.slotcount; \
+    } \
+    if(draw_column_##T(ncp, x, idx, dimy, scale, states, colinterval) < 0){ \
+      return -1; \
+    } \
+  } \
+  return 0; \
+} \
+\
+static void drain_##T(nc##X##plot* ncp); \
+\
 int redraw_plot_##T(nc##X##plot* ncp){ \
+  drain_##T(ncp); \
   if(ncp->plot.bset->geom == NCBLIT_PIXEL){ \
+    ncp->plot.drawn = false; \
     return redraw_pixelplot_##T(ncp); \
   } \
   if(calculate_gradient_vector(&ncp->plot, 0)){ \
     return -1; \
   } \
-  ncplane_erase(ncp->plot.ncp); \
+  if(ncplane_own(ncp->plot.ncp)){ \
+    return -1; \
+  } \
   const unsigned scale = ncp->plot.bset->width; \
   unsigned dimy, dimx; \
   ncplane_dim_yx(ncp->plot.ncp, &dimy, &dimx); \
@@ -289,142 +577,53 @@ int redraw_plot_##T(nc##X##plot* ncp){ \
      will be other than the plane's final column. most recent x goes here. */ \
   const unsigned finalx = (ncp->plot.slotcount < scaleddim - 1 - (startx * scale) ? \
                           startx + (ncp->plot.slotcount / scale) - 1 : dimx - 1); \
-  ncplane_set_styles(ncp->plot.ncp, ncp->plot.legendstyle); \
-  if(ncp->plot.labelaxisd){ \
-    /* show the *top* of each interval range */ \
-    for(unsigned y = 0 ; y < dimy ; ++y){ \
-      ncplane_set_channels(ncp->plot.ncp, ncp->plot.channels[y]); \
-      char buf[NCPREFIXSTRLEN + 1]; \
-      if(ncp->plot.exponentiali){ \
-        if(y == dimy - 1){ /* we cheat on the top row to exactly match maxy */ \
-          ncqprefix(ncp->maxy * 100, 100, buf, 0); \
-        }else{ \
-          ncqprefix(pow(interval, (y + 1) * states) * 100, 100, buf, 0); \
-        } \
-      }else{ \
-        ncqprefix((ncp->maxy - interval * states * (dimy - y - 1)) * 100, 100, buf, 0); \
-      } \
-      if(y == dimy - 1 && strlen(ncp->plot.title)){ \
-        ncplane_printf_yx(ncp->plot.ncp, dimy - y - 1, NCPREFIXCOLUMNS - strlen(buf), "%s %s", buf, ncp->plot.title); \
-      }else{ \
-        ncplane_printf_yx(ncp->plot.ncp, dimy - y - 1, NCPREFIXCOLUMNS - strlen(buf), "%s", buf); \
-      } \
+  /* the labels use the true interval; the columns can't divide by zero */ \
+  const double colinterval = interval ? interval : 1; \
+  /* we print the slot preceding the oldest one drawn, and thus get an \
+     immediate count when all slots are visible, changing as we load it. */ \
+  char sample[32]; \
+  bool printsample = ncp->plot.printsample && (int)finalx >= startx; \
+  if(printsample){ \
+    int idx = ((int)ncp->plot.slotstart - ((int)finalx - startx + 1) * (int)scale) % (int)ncp->plot.slotcount; \
+    if(idx < 0){ \
+      idx += ncp->plot.slotcount; \
     } \
-  }else if(strlen(ncp->plot.title)){ \
-    ncplane_set_channels(ncp->plot.ncp, ncp->plot.channels[dimy - 1]); \
-    ncplane_printf_yx(ncp->plot.ncp, 0, NCPREFIXCOLUMNS - strlen(ncp->plot.title), "%s", ncp->plot.title); \
-  } \
-  ncplane_set_styles(ncp->plot.ncp, NCSTYLE_NONE); \
-  if((int)finalx < startx){ /* exit on pathologically narrow planes */ \
-    return 0; \
+    snprintf(sample, sizeof(sample), "%" PRIu64, (uint64_t)ncp->slots[idx]); \
   } \
-  if(!interval){ \
-    interval = 1; \
-  } \
-  int idx = ncp->plot.slotstart; /* idx holds the real slot index; we move backwards */ \
-  for(int x = finalx ; x >= startx ; --x){ \
-    /* a single column might correspond to more than 1 ('scale', up to \
-       MAXWIDTH) slots' worth of samples. prepare the working gval set. */ \
-    T gvals[MAXWIDTH]; \
-    /* load it retaining the same ordering we have in the actual array */ \
-    for(int i = scale - 1 ; i >= 0 ; --i){ \
-      gvals[i] = ncp->slots[idx]; /* clip the value at the limits of the graph */ \
-      if(gvals[i] < ncp->miny){ \
-        gvals[i] = ncp->miny; \
-      } \
-      if(gvals[i] > ncp->maxy){ \
-        gvals[i] = ncp->maxy; \
-      } \
-      /* FIXME if there are an odd number, only go up through the valid ones... */ \
-      if(--idx < 0){ \
-        idx = ncp->plot.slotcount - 1; \
-      } \
+  int r = scroll_plot_##T(ncp, dimy, dimx, startx, finalx, scale, states, \
+                          interval, printsample ? sample : NULL); \
+  if(r < 0){ \
+    ncp->plot.drawn = false; \
+    return -1; \
+  }else if(r){ \
+    ncp->plot.drawn = false; \
+    ncplane_erase(ncp->plot.ncp); \
+    ncp->plot.titlex = draw_labels_##T(ncp, dimy, interval, states); \
+    if((int)finalx < startx){ /* exit on pathologically narrow planes */ \
+      return 0; \
     } \
-    /* starting from the least-significant row, progress in the more significant \
-       direction, drawing egcs from the grid specification, aborting early if \
-       we can't draw anything in a given cell. */ \
-    T intervalbase = ncp->miny; \
-    const wchar_t* egc = ncp->plot.bset->plotegcs; \
-    bool done = !ncp->plot.bset->fill; \
-    for(unsigned y = 0 ; y < dimy ; ++y){ \
-      ncplane_set_channels(ncp->plot.ncp, ncp->plot.channels[y]); \
-      size_t egcidx = 0, sumidx = 0; \
-      /* if we've got at least one interval's worth on the number of positions \
-        times the number of intervals per position plus the starting offset, \
-        we're going to print *something* */ \
-      for(unsigned i = 0 ; i < scale ; ++i){ \
-        sumidx *= states; \
-        if(intervalbase < gvals[i]){ \
-          if(ncp->plot.exponentiali){ \
-            /* we want the log-base-interval of gvals[i] */ \
-            double scaled = log(gvals[i] - ncp->miny) / log(interval); \
-            double sival = intervalbase ? log(intervalbase) / log(interval) : 0; \
-            egcidx = scaled - sival; \
-          }else{ \
-            egcidx = (gvals[i] - intervalbase) / interval; \
-          } \
-          if(egcidx >= states){ \
-            egcidx = states - 1; \
-            done = false; \
-          } \
-          sumidx += egcidx; \
-        }else{ \
-          egcidx = 0; \
-        } \
-/* printf(stderr, "y: %d i(scale): %d gvals[%d]: %ju egcidx: %zu sumidx: %zu interval: %f intervalbase: %ju\n", y, i, i, gvals[i], egcidx, sumidx, interval, intervalbase); */ \
-      } \
-      /* if we're not UTF8, we can only arrive here via NCBLIT_1x1 (otherwise \
-        we would have errored out during construction). even then, however, \
-        we need handle ASCII differently, since it can't print full block. \
-        in ASCII mode, sumidx != 0 means swap colors and use space. in all \
-        modes, sumidx == 0 means don't do shit, since we erased earlier. */ \
-/* if(sumidx)fprintf(stderr, "dimy: %d y: %d x: %d sumidx: %zu egc[%zu]: %lc\n", dimy, y, x, sumidx, sumidx, egc[sumidx]); */ \
-      if(sumidx){ \
-        uint64_t chan = ncp->plot.channels[y]; \
-        if(notcurses_canutf8(ncplane_notcurses(ncp->plot.ncp))){ \
-          char utf8[MB_LEN_MAX + 1]; \
-          int bytes = wctomb(utf8, egc[sumidx]); \
-          if(bytes < 0){ \
-            return -1; \
-          } \
-          utf8[bytes] = '\0'; \
-          nccell* c = ncplane_cell_ref_yx(ncp->plot.ncp, dimy - y - 1, x); \
-          cell_set_bchannel(c, ncchannels_bchannel(chan)); \
-          cell_set_fchannel(c, ncchannels_fchannel(chan)); \
-          nccell_set_styles(c, NCSTYLE_NONE); \
-          if(pool_blit_direct(&ncp->plot.ncp->pool, c, utf8, bytes, 1) <= 0){ \
-            return -1; \
-          } \
-        }else{ \
-          const uint64_t swapbg = ncchannels_bchannel(chan); \
-          const uint64_t swapfg = ncchannels_fchannel(chan); \
-          ncchannels_set_bchannel(&chan, swapfg); \
-          ncchannels_set_fchannel(&chan, swapbg); \
-          ncplane_set_channels(ncp->plot.ncp, chan); \
-          if(ncplane_putchar_yx(ncp->plot.ncp, dimy - y - 1, x, ' ') <= 0){ \
-            return -1; \
-          } \
-          ncchannels_set_bchannel(&chan, swapbg); \
-          ncchannels_set_fchannel(&chan, swapfg); \
-          ncplane_set_channels(ncp->plot.ncp, chan); \
-        } \
-      } \
-      if(done){ \
-        break; \
-      } \
-      if(ncp->plot.exponentiali){ \
-        intervalbase = ncp->miny + pow(interval, (y + 1) * states - 1); \
-      }else{ \
-        intervalbase += (states * interval); \
+    int idx = ncp->plot.slotstart; /* idx holds the real slot index; we move backwards */ \
+    for(int x = finalx ; x >= startx ; --x){ \
+      if((idx = draw_column_##T(ncp, x, idx, dimy, scale, states, colinterval)) < 0){ \
+        return -1; \
       } \
     } \
   } \
-  if(ncp->plot.printsample){ \
+  ncp->plot.samplecols = 0; \
+  if(printsample){ \
     ncplane_set_styles(ncp->plot.ncp, ncp->plot.legendstyle); \
     ncplane_set_channels(ncp->plot.ncp, ncp->plot.maxchannels); \
-    ncplane_printf_aligned(ncp->plot.ncp, 0, NCALIGN_RIGHT, "%" PRIu64, (uint64_t)ncp->slots[idx]); \
+    ncplane_putstr_aligned(ncp->plot.ncp, 0, NCALIGN_RIGHT, sample); \
+    ncp->plot.samplecols = strlen(sample); \
   } \
   ncplane_home(ncp->plot.ncp); \
+  ncp->plot.drawn = true; \
+  ncp->plot.drawndimy = dimy; \
+  ncp->plot.drawndimx = dimx; \
+  ncp->plot.drawnslotx = ncp->plot.slotx; \
+  ncp->plot.dirtyx = INT64_MAX; \
+  ncp->drawnminy = ncp->miny; \
+  ncp->drawnmaxy = ncp->maxy; \
   return 0; \
 } \
 \
@@ -440,9 +639,16 @@ create_##T(nc##X##plot* ncpp, ncplane* n, const ncplot_options* opts, const T mi
   if(!opts){ \
     opts = &zeroed; \
   } \
-  if(opts->flags >= (NCPLOT_OPTION_PRINTSAMPLE << 1u)){ \
+  if(opts->flags >= (NCPLOT_OPTION_DECIMATE_MAX << 1u)){ \
     logwarn("provided unsupported flags %016" PRIx64, opts->flags); \
   } \
+  const uint64_t decimation = opts->flags & (NCPLOT_OPTION_DECIMATE_MEAN | \
+                                             NCPLOT_OPTION_DECIMATE_MIN | \
+                                             NCPLOT_OPTION_DECIMATE_MAX); \
+  if(decimation & (decimation - 1)){ \
+    logerror("supplied multiple decimation statistics"); \
+    return NULL; \
+  } \
   /* if miny == maxy (enabling domain detection), they both must be equal to 0 */ \
   if(miny == maxy && miny){ \
     return NULL; \
@@ -502,6 +708,32 @@ create_##T(nc##X##plot* ncpp, ncplane* n, const ncplot_options* opts, const T mi
     return NULL; \
   } \
   memset(ncpp->slots, 0, slotsize); \
+  /* a requested range wider than the slots is otherwise truncated to the \
+     most recent slotcount x values. when decimating, spread it over them. */ \
+  ncpp->plot.xper = 1; \
+  if( (ncpp->plot.decimation = decimation) ){ \
+    if(ncpp->plot.rangex > ncpp->plot.slotcount){ \
+      ncpp->plot.xper = (ncpp->plot.rangex + ncpp->plot.slotcount - 1) / ncpp->plot.slotcount; \
+    } \
+    size_t bucketsize = sizeof(*ncpp->buckets) * ncpp->plot.slotcount; \
+    if((ncpp->buckets = malloc(bucketsize)) == NULL){ \
+      return NULL; \
+    } \
+    memset(ncpp->buckets, 0, bucketsize); \
+  } \
+  if((ncpp->plot.stage = malloc(sizeof(*ncpp->plot.stage) * ncpp->plot.slotcount)) == NULL){ \
+    return NULL; \
+  } \
+  for(unsigned i = 0 ; i < ncpp->plot.slotcount ; ++i){ \
+    plotstage* st = &ncpp->plot.stage[i]; \
+    atomic_init(&st->x, STAGE_EMPTY); \
+    atomic_init(&st->add, 0); \
+    atomic_init(&st->set, 0); \
+    atomic_init(&st->hasset, false); \
+    atomic_init(&st->pending, false); \
+    atomic_init(&st->writers, 0); \
+  } \
+  atomic_init(&ncpp->plot.staged, false); \
   ncpp->plot.maxchannels = opts->maxchannels; \
   ncpp->plot.minchannels = opts->minchannels; \
   ncpp->plot.bset = bset; \
@@ -521,6 +753,7 @@ create_##T(nc##X##plot* ncpp, ncplane* n, const ncplot_options* opts, const T mi
   ncpp->plot.slotx = 0; \
   ncpp->plot.chancount = 0; \
   ncpp->plot.channels = NULL; \
+  ncpp->plot.dirtyx = INT64_MAX; \
   if(bset->geom == NCBLIT_PIXEL){ \
     if(create_pixelp(&ncpp->plot, n)){ \
       return NULL; \
@@ -532,17 +765,21 @@ create_##T(nc##X##plot* ncpp, ncplane* n, const ncplot_options* opts, const T mi
 /* if x is less than the window, return -1, as the sample will be thrown away. \
    if the x is within the current window, find the proper slot and update it. \
    otherwise, the x is the newest sample. if it is obsoletes all existing slots, \
-   reset them, and write the new sample anywhere. otherwise, write it to the \
-   proper slot based on the current newest slot. */ \
+   reset them, and write the new sample to its slot modulo the slot count, as \
+   sample() expects. otherwise, write it to the proper slot based on the \
+   current newest slot. */ \
 int window_slide_##T(nc##X##plot* ncp, int64_t x){ \
   if(x <= ncp->plot.slotx){ /* x is within window, do nothing */ \
     return 0; \
   } /* x is newest; we might be keeping some, might not */ \
   int64_t xdiff = x - ncp->plot.slotx; /* the raw amount we're advancing */ \
   ncp->plot.slotx = x; \
-  if(xdiff >= ncp->plot.slotcount){ /* we're throwing away all old samples, write to 0 */ \
+  if(xdiff >= ncp->plot.slotcount){ /* we're throwing away all old samples */ \
     memset(ncp->slots, 0, sizeof(*ncp->slots) * ncp->plot.slotcount); \
-    ncp->plot.slotstart = 0; \
+    if(ncp->buckets){ \
+      memset(ncp->buckets, 0, sizeof(*ncp->buckets) * ncp->plot.slotcount); \
+    } \
+    ncp->plot.slotstart = x % ncp->plot.slotcount; \
     return 0; \
   } \
   /* we're throwing away only xdiff slots, which is less than slotcount. \
@@ -554,27 +791,36 @@ int window_slide_##T(nc##X##plot* ncp, int64_t x){ \
   } \
   if(slotsreset){ \
     memset(ncp->slots + ncp->plot.slotstart + 1, 0, slotsreset * sizeof(*ncp->slots)); \
+    if(ncp->buckets){ \
+      memset(ncp->buckets + ncp->plot.slotstart + 1, 0, slotsreset * sizeof(*ncp->buckets)); \
+    } \
   } \
   ncp->plot.slotstart = (ncp->plot.slotstart + xdiff) % ncp->plot.slotcount; \
   xdiff -= slotsreset; \
   if(xdiff){ /* throw away some at the beginning */ \
     memset(ncp->slots, 0, xdiff * sizeof(*ncp->slots)); \
+    if(ncp->buckets){ \
+      memset(ncp->buckets, 0, xdiff * sizeof(*ncp->buckets)); \
+    } \
   } \
   return 0; \
 } \
 \
 static int update_domain_##T(nc##X##plot* ncp, uint64_t x); \
 static void update_sample_##T(nc##X##plot* ncp, int64_t x, T y, bool reset); \
+static void stage_accumulate_##T(plotstage* st, T y); \
 \
 /* Add to or set the value corresponding to this x. If x is beyond the current \
    x window, the x window is advanced to include x, and values passing beyond \
    the window are lost. The first call will place the initial window. The plot \
    will be redrawn, but notcurses_render() is not called. */ \
 int add_sample_##T(nc##X##plot* ncpp, int64_t x, T y){ \
+  x /= (int64_t)ncpp->plot.xper; \
   if(x < ncpp->plot.slotx - (ncpp->plot.slotcount - 1)){ /* x is behind window, won't be counted */ \
     return -1; \
   } \
-  if(y == 0 && x <= ncpp->plot.slotx){ \
+  /* when decimating, a zero is an observation like any other */ \
+  if(y == 0 && x <= ncpp->plot.slotx && !ncpp->buckets){ \
     return 0; /* no need to redraw plot; nothing changed */ \
   } \
   if(window_slide_##T(ncpp, x)){ \
@@ -586,7 +832,130 @@ int add_sample_##T(nc##X##plot* ncpp, int64_t x, T y){ \
   } \
   return redraw_plot_##T(ncpp); \
 } \
+\
+/* fold a staged sample into the slots. failures are those of add_sample, \
+   and similarly lose the sample, but there's nobody to whom we can report. */ \
+static int ingest_sample_##T(nc##X##plot* ncp, int64_t x, T y, bool reset){ \
+  if(x < ncp->plot.slotx - (ncp->plot.slotcount - 1)){ \
+    return -1; \
+  } \
+  if(window_slide_##T(ncp, x)){ \
+    return -1; \
+  } \
+  update_sample_##T(ncp, x, y, reset); \
+  return update_domain_##T(ncp, x); \
+} \
+\
+/* called only from the redraw, which is serialized with the slots' other \
+   users. an entry's values are taken as a writer against its x, so it can't \
+   be reclaimed out from under us. */ \
+static void drain_##T(nc##X##plot* ncp){ \
+  if(!atomic_exchange(&ncp->plot.staged, false)){ \
+    return; \
+  } \
+  for(unsigned i = 0 ; i < ncp->plot.slotcount ; ++i){ \
+    plotstage* st = &ncp->plot.stage[i]; \
+    if(!atomic_load(&st->pending)){ \
+      continue; \
+    } \
+    atomic_fetch_add(&st->writers, 1); \
+    const int64_t x = atomic_load(&st->x); \
+    if(x < 0 || !atomic_exchange(&st->pending, false)){ \
+      atomic_fetch_sub(&st->writers, 1); \
+      continue; \
+    } \
+    const bool hasset = atomic_exchange(&st->hasset, false); \
+    const uint64_t setbits = atomic_load(&st->set); \
+    const uint64_t addbits = atomic_exchange(&st->add, 0); \
+    atomic_fetch_sub(&st->writers, 1); \
+    T y; \
+    if(hasset){ \
+      memcpy(&y, &setbits, sizeof(y)); \
+      ingest_sample_##T(ncp, x, y, true); \
+    } \
+    memcpy(&y, &addbits, sizeof(y)); \
+    ingest_sample_##T(ncp, x, y, false); \
+  } \
+} \
+\
+/* stage a sample from any thread. returns -1 if x is a full window behind \
+   the x staged in its entry, as it would be discarded upon draining. */ \
+static int stage_sample_##T(nc##X##plot* ncp, uint64_t ux, T y, bool reset){ \
+  if(ux > INT64_MAX){ \
+    return -1; \
+  } \
+  if(ncp->buckets){ /* staged sums would lose the observations' extrema */ \
+    logerror("can't stage samples for a decimating plot"); \
+    return -1; \
+  } \
+  const int64_t x = ux; \
+  plotstage* st = &ncp->plot.stage[x % ncp->plot.slotcount]; \
+  for(;;){ \
+    int64_t cur = atomic_load(&st->x); \
+    if(cur == x){ \
+      atomic_fetch_add(&st->writers, 1); \
+      if(atomic_load(&st->x) == x){ /* still ours once we're counted */ \
+        if(reset){ \
+          uint64_t bits; \
+          memcpy(&bits, &y, sizeof(y)); \
+          atomic_store(&st->add, 0); /* supersedes earlier additions */ \
+          atomic_store(&st->set, bits); \
+          atomic_store(&st->hasset, true); \
+        }else{ \
+          stage_accumulate_##T(st, y); \
+        } \
+        atomic_store(&st->pending, true); \
+        atomic_fetch_sub(&st->writers, 1); \
+        atomic_store(&ncp->plot.staged, true); \
+        return 0; \
+      } \
+      atomic_fetch_sub(&st->writers, 1); \
+    }else if(cur > x){ \
+      return -1; \
+    }else if(cur != STAGE_CLAIMED){ /* empty, or an older x: reclaim it */ \
+      if(atomic_compare_exchange_strong(&st->x, &cur, STAGE_CLAIMED)){ \
+        /* wait out those who counted themselves against the old x. they \
+           leave as soon as they've done their few stores. */ \
+        while(atomic_load(&st->writers)){ \
+          ; \
+        } \
+        atomic_store(&st->add, 0); \
+        atomic_store(&st->hasset, false); \
+        atomic_store(&st->pending, false); \
+        atomic_store(&st->x, x); \
+      } \
+    } \
+  } \
+} \
+\
+/* record an observation in the decimated slot idx (replacing any others if \
+   reset), and update the slot to show the selected statistic. */ \
+static void decimate_sample_##T(nc##X##plot* ncp, int idx, T y, bool reset){ \
+  nc##X##bucket* b = &ncp->buckets[idx]; \
+  if(reset || b->count == 0){ \
+    b->min = b->max = b->sum = y; \
+    b->count = 1; \
+  }else{ \
+    if(y < b->min){ \
+      b->min = y; \
+    } \
+    if(y > b->max){ \
+      b->max = y; \
+    } \
+    b->sum += y; \
+    ++b->count; \
+  } \
+  if(ncp->plot.decimation == NCPLOT_OPTION_DECIMATE_MIN){ \
+    ncp->slots[idx] = b->min; \
+  }else if(ncp->plot.decimation == NCPLOT_OPTION_DECIMATE_MAX){ \
+    ncp->slots[idx] = b->max; \
+  }else{ \
+    ncp->slots[idx] = b->sum / b->count; \
+  } \
+} \
+\
 int sample_##T(const nc##X##plot* ncp, int64_t x, T* y){ \
+  x /= (int64_t)ncp->plot.xper; \
   if(x < ncp->plot.slotx - (ncp->plot.slotcount - 1)){ /* x is behind window */ \
     return -1; \
   }else if(x > ncp->plot.slotx){ /* x is ahead of window */ \
@@ -607,6 +976,7 @@ ncplot_destroy(ncplot* n){
   }
   ncplane_destroy(n->pixelp);
   free(n->channels);
+  free(n->stage);
 }
 
 /* if we're doing domain detection, update the domain to reflect the value we
@@ -655,6 +1025,13 @@ static void
 update_sample_uint64_t(ncuplot* ncp, int64_t x, uint64_t y, bool reset){
   const int64_t diff = ncp->plot.slotx - x; /* amount behind */
   const int idx = (ncp->plot.slotstart + ncp->plot.slotcount - diff) % ncp->plot.slotcount;
+  if(x < ncp->plot.dirtyx){
+    ncp->plot.dirtyx = x;
+  }
+  if(ncp->buckets){
+    decimate_sample_uint64_t(ncp, idx, y, reset);
+    return;
+  }
   if(reset){
     ncp->slots[idx] = y;
   }else{
@@ -667,6 +1044,13 @@ static void
 update_sample_double(ncdplot* ncp, int64_t x, double y, bool reset){
   const int64_t diff = ncp->plot.slotx - x; /* amount behind */
   const int idx = (ncp->plot.slotstart + ncp->plot.slotcount - diff) % ncp->plot.slotcount;
+  if(x < ncp->plot.dirtyx){
+    ncp->plot.dirtyx = x;
+  }
+  if(ncp->buckets){
+    decimate_sample_double(ncp, idx, y, reset);
+    return;
+  }
   if(reset){
     ncp->slots[idx] = y;
   }else{
@@ -674,6 +1058,24 @@ update_sample_double(ncdplot* ncp, int64_t x, double y, bool reset){
   }
 }
 
+static void
+stage_accumulate_uint64_t(plotstage* st, uint64_t y){
+  atomic_fetch_add(&st->add, y);
+}
+
+// there's no atomic floating-point addition, so CAS the bits
+static void
+stage_accumulate_double(plotstage* st, double y){
+  uint64_t old = atomic_load(&st->add);
+  uint64_t new;
+  do{
+    double d;
+    memcpy(&d, &old, sizeof(d));
+    d += y;
+    memcpy(&new, &d, sizeof(new));
+  }while(!atomic_compare_exchange_weak(&st->add, &old, new));
+}
+
 // takes ownership of n on all paths
 ncuplot* ncuplot_create(ncplane* n, const ncplot_options* opts, uint64_t miny, uint64_t maxy){
   ncuplot* ret = malloc(sizeof(*ret));
@@ -698,7 +1100,20 @@ int ncuplot_add_sample(ncuplot* n, uint64_t x, uint64_t y){
   return add_sample_uint64_t(n, x, y);
 }
 
+int ncuplot_stage_add(ncuplot* n, uint64_t x, uint64_t y){
+  return stage_sample_uint64_t(n, x, y, false);
+}
+
+int ncuplot_stage_set(ncuplot* n, uint64_t x, uint64_t y){
+  return stage_sample_uint64_t(n, x, y, true);
+}
+
+int ncuplot_flush(ncuplot* n){
+  return redraw_plot_uint64_t(n);
+}
+
 int ncuplot_set_sample(ncuplot* n, uint64_t x, uint64_t y){
+  x /= n->plot.xper;
   if(window_slide_uint64_t(n, x)){
     return -1;
   }
@@ -712,6 +1127,7 @@ int ncuplot_set_sample(ncuplot* n, uint64_t x, uint64_t y){
 void ncuplot_destroy(ncuplot* n){
   if(n){
     ncplot_destroy(&n->plot);
+    free(n->buckets);
     free(n->slots);
     free(n);
   }
@@ -741,7 +1157,20 @@ int ncdplot_add_sample(ncdplot* n, uint64_t x, double y){
   return add_sample_double(n, x, y);
 }
 
+int ncdplot_stage_add(ncdplot* n, uint64_t x, double y){
+  return stage_sample_double(n, x, y, false);
+}
+
+int ncdplot_stage_set(ncdplot* n, uint64_t x, double y){
+  return stage_sample_double(n, x, y, true);
+}
+
+int ncdplot_flush(ncdplot* n){
+  return redraw_plot_double(n);
+}
+
 int ncdplot_set_sample(ncdplot* n, uint64_t x, double y){
+  x /= n->plot.xper;
   if(window_slide_double(n, x)){
     return -1;
   }
@@ -763,6 +1192,7 @@ int ncdplot_sample(const ncdplot* n, uint64_t x, double* y){
 void ncdplot_destroy(ncdplot* n) {
   if(n){
     ncplot_destroy(&n->plot);
+    free(n->buckets);
     free(n->slots);
     free(n);
   }
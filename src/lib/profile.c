@@ -0,0 +1,230 @@
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include "internal.h"
+
+// optional render profiling. when enabled, each phase of rendering and
+// rasterization is timed (see profphase_e), and painting and sprixel costs
+// are charged to the planes which incurred them. live planes carry their own
+// costs; those of destroyed planes are folded into a table keyed by name. the
+// clock is only read while profiling, so the disabled cost is one branch per
+// phase (and per plane painted).
+
+static const char* const phasenames[PROF_PHASES] = {
+  "paint", "postpaint", "sprixel clean", "glyphs 1",
+  "sprixel draw", "glyphs 2", "write",
+};
+
+void prof_phase(notcurses* nc, profphase_e phase, uint64_t* t){
+  if(*t == 0){
+    return;
+  }
+  const uint64_t now = prof_clock(nc);
+  if(now){
+    stats_lock(&nc->stats);
+      nc->profile.phase_ns[phase] += now - *t;
+      ++nc->profile.phase_runs[phase];
+    stats_unlock(&nc->stats);
+  }
+  *t = now;
+}
+
+// find or create the entry for |name|. call with the stats lock held.
+static profplane*
+prof_entry(profplane** table, unsigned* count, unsigned* alloc, const char* name){
+  for(unsigned i = 0 ; i < *count ; ++i){
+    if(strcmp((*table)[i].name, name) == 0){
+      return &(*table)[i];
+    }
+  }
+  if(*count == *alloc){
+    unsigned nalloc = *alloc ? *alloc * 2 : 16;
+    profplane* tmp = realloc(*table, sizeof(*tmp) * nalloc);
+    if(tmp == NULL){
+      return NULL;
+    }
+    *table = tmp;
+    *alloc = nalloc;
+  }
+  profplane* e = &(*table)[*count];
+  memset(e, 0, sizeof(*e));
+  if((e->name = strdup(name)) == NULL){
+    return NULL;
+  }
+  ++*count;
+  return e;
+}
+
+static inline const char*
+prof_name(const ncplane* n){
+  return n->name && *n->name ? n->name : "(unnamed)";
+}
+
+void prof_retire_plane(notcurses* nc, const ncplane* n){
+  if(n->prof_paints == 0 && n->prof_sprixels == 0){
+    return;
+  }
+  stats_lock(&nc->stats);
+    ncprofile* prof = &nc->profile;
+    if(prof->enabled){
+      profplane* e = prof_entry(&prof->retired, &prof->retiredcount,
+                                &prof->retiredalloc, prof_name(n));
+      if(e){
+        e->paint_ns += n->prof_paint_ns;
+        e->paints += n->prof_paints;
+        e->sprixel_ns += n->prof_sprixel_ns;
+        e->sprixels += n->prof_sprixels;
+      }
+    }
+  stats_unlock(&nc->stats);
+}
+
+static void
+prof_free_table(profplane* table, unsigned count){
+  for(unsigned i = 0 ; i < count ; ++i){
+    free(table[i].name);
+  }
+  free(table);
+}
+
+void prof_free(ncprofile* prof){
+  prof_free_table(prof->retired, prof->retiredcount);
+  memset(prof, 0, sizeof(*prof));
+}
+
+// zero the costs carried by every live plane. call with the pilelock held.
+static void
+prof_clear_planes(notcurses* nc){
+  if(nc->stdplane == NULL){
+    return;
+  }
+  ncpile* start = ncplane_pile(nc->stdplane);
+  ncpile* p = start;
+  do{
+    for(ncplane* n = p->top ; n ; n = n->below){
+      n->prof_paint_ns = n->prof_paints = 0;
+      n->prof_sprixel_ns = n->prof_sprixels = 0;
+    }
+    p = p->next;
+  }while(p != start);
+}
+
+int notcurses_profile(notcurses* nc, bool enable){
+  pthread_mutex_lock(&nc->pilelock);
+    prof_clear_planes(nc);
+    stats_lock(&nc->stats);
+      prof_free(&nc->profile);
+      nc->profile.enabled = enable;
+    stats_unlock(&nc->stats);
+  pthread_mutex_unlock(&nc->pilelock);
+  return 0;
+}
+
+static int
+prof_cmp(const void* va, const void* vb){
+  const profplane* a = va;
+  const profplane* b = vb;
+  const uint64_t ca = a->paint_ns + a->sprixel_ns;
+  const uint64_t cb = b->paint_ns + b->sprixel_ns;
+  if(ca != cb){
+    return ca < cb ? 1 : -1;
+  }
+  return strcmp(a->name, b->name);
+}
+
+// average of |ns| over |runs|, formatted with an SI prefix into |buf|
+static const char*
+prof_avg(uint64_t ns, uint64_t runs, char* buf){
+  return ncqprefix(runs ? ns / runs : 0, NANOSECS_IN_SEC, buf, 0);
+}
+
+int notcurses_profile_dump(notcurses* nc, FILE* fp){
+  profplane* table = NULL;
+  unsigned count = 0;
+  unsigned alloc = 0;
+  int ret = 0;
+  // gather the live planes, then fold in those which have been destroyed
+  pthread_mutex_lock(&nc->pilelock);
+    if(nc->stdplane){
+      ncpile* start = ncplane_pile(nc->stdplane);
+      ncpile* p = start;
+      do{
+        for(const ncplane* n = p->top ; n && ret == 0 ; n = n->below){
+          if(n->prof_paints == 0 && n->prof_sprixels == 0){
+            continue;
+          }
+          profplane* e = prof_entry(&table, &count, &alloc, prof_name(n));
+          if(e == NULL){
+            ret = -1;
+            break;
+          }
+          e->paint_ns += n->prof_paint_ns;
+          e->paints += n->prof_paints;
+          e->sprixel_ns += n->prof_sprixel_ns;
+          e->sprixels += n->prof_sprixels;
+        }
+        p = p->next;
+      }while(p != start);
+    }
+  pthread_mutex_unlock(&nc->pilelock);
+  uint64_t phase_ns[PROF_PHASES];
+  uint64_t phase_runs[PROF_PHASES];
+  pthread_mutex_lock(&nc->stats.lock);
+    const bool enabled = nc->profile.enabled;
+    memcpy(phase_ns, nc->profile.phase_ns, sizeof(phase_ns));
+    memcpy(phase_runs, nc->profile.phase_runs, sizeof(phase_runs));
+    for(unsigned i = 0 ; i < nc->profile.retiredcount && ret == 0 ; ++i){
+      const profplane* r = &nc->profile.retired[i];
+      profplane* e = prof_entry(&table, &count, &alloc, r->name);
+      if(e == NULL){
+        ret = -1;
+        break;
+      }
+      e->paint_ns += r->paint_ns;
+      e->paints += r->paints;
+      e->sprixel_ns += r->sprixel_ns;
+      e->sprixels += r->sprixels;
+    }
+  pthread_mutex_unlock(&nc->stats.lock);
+  if(ret){
+    prof_free_table(table, count);
+    return -1;
+  }
+  if(!enabled){
+    logerror("profiling is not enabled");
+    prof_free_table(table, count);
+    return -1;
+  }
+  qsort(table, count, sizeof(*table), prof_cmp);
+  char totbuf[NCPREFIXSTRLEN + 1];
+  char avgbuf[NCPREFIXSTRLEN + 1];
+  char sprbuf[NCPREFIXSTRLEN + 1];
+  if(fprintf(fp, "%-16s %10s %10s %10s\n", "phase", "runs", "total", "avg") < 0){
+    ret = -1;
+  }
+  for(unsigned p = 0 ; p < PROF_PHASES && ret == 0 ; ++p){
+    ncqprefix(phase_ns[p], NANOSECS_IN_SEC, totbuf, 0);
+    prof_avg(phase_ns[p], phase_runs[p], avgbuf);
+    if(fprintf(fp, "%-16s %10" PRIu64 " %9ss %9ss\n", phasenames[p],
+               phase_runs[p], totbuf, avgbuf) < 0){
+      ret = -1;
+    }
+  }
+  if(ret == 0 && fprintf(fp, "%-24s %10s %10s %10s %10s %10s\n", "plane",
+                         "paints", "paint", "avg", "sprixels", "sprixel") < 0){
+    ret = -1;
+  }
+  for(unsigned i = 0 ; i < count && ret == 0 ; ++i){
+    const profplane* e = &table[i];
+    ncqprefix(e->paint_ns, NANOSECS_IN_SEC, totbuf, 0);
+    prof_avg(e->paint_ns, e->paints, avgbuf);
+    ncqprefix(e->sprixel_ns, NANOSECS_IN_SEC, sprbuf, 0);
+    if(fprintf(fp, "%-24.24s %10" PRIu64 " %9ss %9ss %10" PRIu64 " %9ss\n",
+               e->name, e->paints, totbuf, avgbuf, e->sprixels, sprbuf) < 0){
+      ret = -1;
+    }
+  }
+  prof_free_table(table, count);
+  return ret;
+}
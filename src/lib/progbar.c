@@ -21,6 +21,8 @@ ncprogbar* ncprogbar_create(ncplane* n, const ncprogbar_options* opts){
   ret->blchannel = opts->blchannel;
   ret->brchannel = opts->brchannel;
   ret->retrograde = opts->flags & NCPROGBAR_OPTION_RETROGRADE;
+  ret->progress = 0;
+  ret->drawnchunks = -1;
   if(ncplane_set_widget(n, ret, (void(*)(void*))ncprogbar_destroy)){
     ncplane_destroy(n);
     free(ret);
@@ -51,125 +53,217 @@ static const char up_egcs[8][5] = {
   " ", "▁", "▂", "▃", "▄", "▅", "▆", "▇",
 };
 
-static int
-progbar_redraw(ncprogbar* n){
-  struct ncplane* ncp = ncprogbar_plane(n);
-  // get current dimensions; they might have changed
+// how the bar is laid out on its plane. cells are indexed from where the
+// fill begins; cell i lies in row or column start + delt * i.
+typedef struct progbar_geom {
+  bool horizontal;
+  bool utf8;
   unsigned dimy, dimx;
-  ncplane_dim_yx(ncp, &dimy, &dimx);
-  const bool horizontal = dimx > dimy;
-  int range, delt, pos;
+  int range, start, delt;
   const char* egcs;
-  uint32_t ul, ur, bl, br;
-  if(horizontal){
-    range = dimx;
-    delt = 1;
-    pos = 0;
+  uint32_t ul, ur, bl, br;   // corners of the gradient across the plane
+} progbar_geom;
+
+static void
+progbar_geometry(const ncprogbar* n, progbar_geom* g){
+  const ncplane* ncp = n->ncp;
+  // get current dimensions; they might have changed
+  ncplane_dim_yx(ncp, &g->dimy, &g->dimx);
+  g->utf8 = notcurses_canutf8(ncplane_notcurses_const(ncp));
+  g->horizontal = g->dimx > g->dimy;
+  if(g->horizontal){
+    g->range = g->dimx;
+    g->delt = 1;
+    g->start = 0;
     if(n->retrograde){
-      egcs = *right_egcs;
-      ul = n->urchannel; ur = n->brchannel;
-      bl = n->ulchannel; br = n->blchannel;
+      g->egcs = *right_egcs;
+      g->ul = n->urchannel; g->ur = n->brchannel;
+      g->bl = n->ulchannel; g->br = n->blchannel;
     }else{
-      egcs = *left_egcs;
-      ul = n->blchannel; ur = n->ulchannel;
-      bl = n->brchannel; br = n->urchannel;
+      g->egcs = *left_egcs;
+      g->ul = n->blchannel; g->ur = n->ulchannel;
+      g->bl = n->brchannel; g->br = n->urchannel;
     }
   }else{
-    range = dimy;
-    delt = -1;
-    pos = range - 1;
+    g->range = g->dimy;
+    g->delt = -1;
+    g->start = g->range - 1;
     if(n->retrograde){
-      egcs = *down_egcs;
-      ul = n->brchannel; ur = n->blchannel;
-      bl = n->urchannel; br = n->ulchannel;
+      g->egcs = *down_egcs;
+      g->ul = n->brchannel; g->ur = n->blchannel;
+      g->bl = n->urchannel; g->br = n->ulchannel;
     }else{
-      egcs = *up_egcs;
-      ul = n->ulchannel; ur = n->urchannel;
-      bl = n->blchannel; br = n->brchannel;
+      g->egcs = *up_egcs;
+      g->ul = n->ulchannel; g->ur = n->urchannel;
+      g->bl = n->blchannel; g->br = n->brchannel;
     }
   }
-  ncplane_home(ncp);
-  if(notcurses_canutf8(ncplane_notcurses(ncp))){
-    if(ncplane_gradient2x1(ncp, -1, -1, 0, 0, ul, ur, bl, br) <= 0){
+  if(n->retrograde){
+    g->delt *= -1;
+    g->start = g->start ? 0 : g->range - 1;
+  }
+}
+
+// the number of fully-filled cells, and the eighths of the frontier cell.
+static void
+progbar_frontier(const ncprogbar* n, const progbar_geom* g, int* chunks, int* egcidx){
+  double eachcell = (1.0 / g->range); // how much each cell is worth
+  double chunk = n->progress;
+  *chunks = n->progress / eachcell;
+  chunk -= eachcell * *chunks;
+  *egcidx = (int)(chunk / (eachcell / 8));
+  if(*chunks > g->range){
+    *chunks = g->range;
+  }
+}
+
+// write the cell at |y|/|x| as the whole-plane gradient would have, without
+// painting the rest of the plane (see ncplane_gradient2x1()).
+static int
+progbar_gradient_cell(ncplane* ncp, const progbar_geom* g, unsigned y, unsigned x){
+  nccell* c = ncplane_cell_ref_yx(ncp, y, x);
+  c->channels = 0;
+  if(g->utf8){
+    if(pool_blit_direct(&ncp->pool, c, "▀", strlen("▀"), 1) <= 0){
       return -1;
     }
+    if(!ncchannel_default_p(g->ul)){
+      ncchannels_set_fchannel(&c->channels,
+                              calc_gradient_channel(g->ul, g->ur, g->bl, g->br,
+                                                    y * 2, x, g->dimy * 2, g->dimx));
+      ncchannels_set_bchannel(&c->channels,
+                              calc_gradient_channel(g->ul, g->ur, g->bl, g->br,
+                                                    y * 2 + 1, x, g->dimy * 2, g->dimx));
+    }
   }else{
-    if(ncplane_gradient(ncp, -1, -1, 0, 0, " ", 0, ul, ur, bl, br) <= 0){
+    if(cell_load_direct(ncp, c, " ", 1, 1) < 0){
       return -1;
     }
-  }
-  if(n->retrograde){
-    delt *= -1;
-    if(pos){
-      pos = 0;
-    }else{
-      pos = range - 1;
+    c->stylemask = 0;
+    if(!ncchannel_default_p(g->ul)){
+      ncchannels_set_bchannel(&c->channels,
+                              calc_gradient_channel(g->ul, g->ur, g->bl, g->br,
+                                                    y, x, g->dimy, g->dimx));
     }
   }
-  double eachcell = (1.0 / range); // how much each cell is worth
-  double chunk = n->progress;
-  const int chunks = n->progress / eachcell;
-  chunk -= eachcell * chunks;
-  pos += delt * chunks;
-  if(pos >= range){
-    return 0;
-  }
-  if(pos < 0){
-    return 0;
+  return 0;
+}
+
+// cut the gradient cell at |y|/|x| down to the partial block |egc|.
+static int
+progbar_frontier_cell(ncplane* ncp, const progbar_geom* g, unsigned y,
+                      unsigned x, const char* egc){
+  if(g->utf8){
+    nccell* c = ncplane_cell_ref_yx(ncp, y, x);
+    if(pool_blit_direct(&ncp->pool, c, egc, strlen(egc), 1) <= 0){
+      return -1;
+    }
+    cell_set_bchannel(c, 0);
+  }else{
+    if(ncplane_putchar_yx(ncp, y, x, ' ') <= 0){
+      return -1;
+    }
   }
-  // at this point, we have a gradient across the entirety of the progress
-  // bar. we're going to first update the active frontier, which might need
-  // to cut down from a full block to a partial block. we'll then null out
-  // anything beyond the frontier.
-  const int egcidx = (int)(chunk / (eachcell / 8));
-  const char* egc = egcs + egcidx * 5;
-  if(horizontal){
-    for(unsigned freepos = 0 ; freepos < dimy ; ++freepos){
-      if(notcurses_canutf8(ncplane_notcurses(ncp))){
-        nccell* c = ncplane_cell_ref_yx(ncp, freepos, pos);
-        if(pool_blit_direct(&ncp->pool, c, egc, strlen(egc), 1) <= 0){
-          return -1;
-        }
-        cell_set_bchannel(c, 0);
-      }else{
-        if(ncplane_putchar_yx(ncp, freepos, pos, ' ') <= 0){
-          return -1;
-        }
+  return 0;
+}
+
+// draw the line of cells at index |i| from the start of the fill, given
+// |chunks| full cells and a frontier of |egcidx| eighths. if |gradiented|,
+// the line already holds the gradient.
+static int
+progbar_line(ncprogbar* n, const progbar_geom* g, int i, int chunks,
+             int egcidx, bool gradiented){
+  ncplane* ncp = n->ncp;
+  const unsigned pos = g->start + g->delt * i;
+  const unsigned len = g->horizontal ? g->dimy : g->dimx;
+  for(unsigned freepos = 0 ; freepos < len ; ++freepos){
+    const unsigned y = g->horizontal ? freepos : pos;
+    const unsigned x = g->horizontal ? pos : freepos;
+    if(i < chunks || (i == chunks && g->utf8)){
+      if(!gradiented && progbar_gradient_cell(ncp, g, y, x)){
+        return -1;
       }
     }
-  }else{
-    for(unsigned freepos = 0 ; freepos < dimx ; ++freepos){
-      if(notcurses_canutf8(ncplane_notcurses(ncp))){
-        nccell* c = ncplane_cell_ref_yx(ncp, pos, freepos);
-        if(pool_blit_direct(&ncp->pool, c, egc, strlen(egc), 1) <= 0){
-          return -1;
-        }
-        cell_set_bchannel(c, 0);
-      }else{
-        if(ncplane_putchar_yx(ncp, pos, freepos, ' ') <= 0){
-          return -1;
-        }
+    if(i == chunks){
+      if(progbar_frontier_cell(ncp, g, y, x, g->egcs + egcidx * 5)){
+        return -1;
       }
+    }else if(i > chunks){
+      nccell* c = ncplane_cell_ref_yx(ncp, y, x);
+      nccell_release(ncp, c);
+      nccell_init(c);
     }
   }
-  // we now clear out all cells beyond the frontier.
-  pos += delt;
-  while(pos >= 0 && pos < range){
-    if(horizontal){
-      for(unsigned freepos = 0 ; freepos < dimy ; ++freepos){
-        nccell* c = ncplane_cell_ref_yx(ncp, freepos, pos);
-        nccell_release(ncp, c);
-        nccell_init(c);
-      }
+  return 0;
+}
+
+// draw the gradient across the entirety of the progress bar, cut down the
+// active frontier from a full block to a partial block, and null out
+// anything beyond the frontier.
+static int
+progbar_redraw_full(ncprogbar* n, const progbar_geom* g, int chunks, int egcidx){
+  ncplane* ncp = n->ncp;
+  ncplane_home(ncp);
+  if(g->utf8){
+    if(ncplane_gradient2x1(ncp, -1, -1, 0, 0, g->ul, g->ur, g->bl, g->br) <= 0){
+      return -1;
+    }
+  }else{
+    if(ncplane_gradient(ncp, -1, -1, 0, 0, " ", 0, g->ul, g->ur, g->bl, g->br) <= 0){
+      return -1;
+    }
+  }
+  for(int i = chunks ; i < g->range ; ++i){
+    if(progbar_line(n, g, i, chunks, egcidx, true)){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// if the plane still holds exactly what we last drew, only the lines from
+// the old frontier through the new one change; everything else is left be.
+static int
+progbar_redraw(ncprogbar* n){
+  ncplane* ncp = ncprogbar_plane(n);
+  progbar_geom g;
+  progbar_geometry(n, &g);
+  int chunks, egcidx;
+  progbar_frontier(n, &g, &chunks, &egcidx);
+  if(n->drawnchunks < 0 || n->drawnmods != ncp->mods || n->drawny != g.dimy ||
+     n->drawnx != g.dimx || n->drawnutf8 != g.utf8){
+    n->drawnchunks = -1;
+    if(progbar_redraw_full(n, &g, chunks, egcidx)){
+      return -1;
+    }
+  }else if(chunks != n->drawnchunks || egcidx != n->drawnidx){
+    int lo = chunks < n->drawnchunks ? chunks : n->drawnchunks;
+    int hi = chunks < n->drawnchunks ? n->drawnchunks : chunks;
+    if(hi >= g.range){
+      hi = g.range - 1;
+    }
+    if(ncplane_own(ncp)){
+      return -1;
+    }
+    if(g.horizontal){
+      ncplane_damage_rows(ncp, 0, g.dimy);
     }else{
-      for(unsigned freepos = 0 ; freepos < dimx ; ++freepos){
-        nccell* c = ncplane_cell_ref_yx(ncp, pos, freepos);
-        nccell_release(ncp, c);
-        nccell_init(c);
+      const int top = g.start + g.delt * (g.delt > 0 ? lo : hi);
+      ncplane_damage_rows(ncp, top, hi - lo + 1);
+    }
+    n->drawnchunks = -1;
+    for(int i = lo ; i <= hi ; ++i){
+      if(progbar_line(n, &g, i, chunks, egcidx, false)){
+        return -1;
       }
     }
-    pos += delt;
   }
+  n->drawnchunks = chunks;
+  n->drawnidx = egcidx;
+  n->drawny = g.dimy;
+  n->drawnx = g.dimx;
+  n->drawnutf8 = g.utf8;
+  n->drawnmods = ncp->mods;
   return 0;
 }
 
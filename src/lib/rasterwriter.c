@@ -0,0 +1,312 @@
+#include <fcntl.h>
+#include "internal.h"
+#include "unixsig.h"
+
+// the raster writer is a single library-owned thread which writes out
+// rasterized frames on behalf of ncpile_render_async(), so that the caller
+// never blocks on the terminal. it is double-buffered: the writer owns
+// 'writing' while it's busy, and the caller's rasterstate buffer is swapped
+// into 'pending' upon submission. if the writer falls behind, further frames
+// are appended to 'pending', and go out together with the next write. frames
+// can't simply be dropped, since each one is only a diff against its
+// predecessor.
+typedef struct raster_writer {
+  pthread_mutex_t lock;     // guards everything below
+  pthread_cond_t cond;      // signaled on new output or shutdown
+  pthread_cond_t idlecond;  // signaled whenever the writer goes idle
+  pthread_t tid;
+  int fd;                   // destination of our writes
+  int notify[2];            // read end is readable while idle (not windows)
+  bool notified;            // have we readied notify[0] since the last submit?
+  fbuf pending;             // submitted, not yet claimed by the writer
+  fbuf writing;             // being written by the writer while busy
+  bool busy;                // is the writer currently writing 'writing'?
+  bool failed;              // has a write failed since last drained?
+  bool done;
+  uint64_t submissions;     // total frames submitted
+  uint64_t coalesced;       // frames appended to an unclaimed frame
+  uint64_t writestart;      // when the current write began (ns, monotonic)
+  double nsperbyte;         // moving average of write cost, 0 until measured
+} raster_writer;
+
+#ifndef __MINGW32__
+static void
+drain_notify(raster_writer* rw){
+  char c[8];
+  while(read(rw->notify[0], c, sizeof(c)) > 0){
+    ;
+  }
+  rw->notified = false;
+}
+
+static void
+ready_notify(raster_writer* rw){
+  if(!rw->notified){
+    const char c = 1;
+    if(write(rw->notify[1], &c, 1) == 1){
+      rw->notified = true;
+    }
+  }
+}
+
+// only linux and freebsd13+ have eventfd(), so we use pipes, as in.c does.
+static int
+notify_pipes(raster_writer* rw){
+#ifndef __APPLE__
+  if(pipe2(rw->notify, O_CLOEXEC | O_NONBLOCK)){
+    logerror("couldn't get pipes (%s)", strerror(errno));
+    return -1;
+  }
+#else
+  if(pipe(rw->notify)){
+    logerror("couldn't get pipes (%s)", strerror(errno));
+    return -1;
+  }
+  for(int i = 0 ; i < 2 ; ++i){
+    if(fcntl(rw->notify[i], F_SETFD, FD_CLOEXEC) ||
+       set_fd_nonblocking(rw->notify[i], 1, NULL)){
+      logerror("couldn't prep pipe[%d] (%s)", i, strerror(errno));
+      close(rw->notify[0]);
+      close(rw->notify[1]);
+      return -1;
+    }
+  }
+#endif
+  return 0;
+}
+#else
+static void
+drain_notify(raster_writer* rw){
+  rw->notified = false;
+}
+
+static void
+ready_notify(raster_writer* rw){
+  rw->notified = true;
+}
+#endif
+
+// are we entirely caught up? call with the lock held.
+static inline bool
+raster_writer_idle_p(const raster_writer* rw){
+  return !rw->busy && rw->pending.used == 0;
+}
+
+static void*
+raster_writer_thread(void* v){
+  raster_writer* rw = v;
+  nc_thread_setup("raster");
+  // signal handlers ought run on the application's threads; we don't want
+  // one landing in the middle of a frame's escape sequences.
+  sigset_t oldmask;
+  block_signals(&oldmask);
+  pthread_mutex_lock(&rw->lock);
+  for(;;){
+    while(rw->pending.used == 0 && !rw->done){
+      pthread_cond_wait(&rw->cond, &rw->lock);
+    }
+    if(rw->pending.used == 0){ // shutting down, and nothing left to write
+      break;
+    }
+    fbuf tmp = rw->writing;
+    rw->writing = rw->pending;
+    rw->pending = tmp;
+    rw->busy = true;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    rw->writestart = timespec_to_ns(&t0);
+    pthread_mutex_unlock(&rw->lock);
+    const uint64_t tstart = nctrace_begin();
+    int r = blocking_write(rw->fd, rw->writing.buf, rw->writing.used);
+    nctrace_end("frame_write", tstart, "bytes", rw->writing.used);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    pthread_mutex_lock(&rw->lock);
+    nsperbyte_update(&rw->nsperbyte, timespec_to_ns(&t1) - rw->writestart,
+                     rw->writing.used);
+    fbuf_reset(&rw->writing);
+    rw->busy = false;
+    if(r){
+      rw->failed = true;
+    }
+    if(raster_writer_idle_p(rw)){
+      ready_notify(rw);
+      pthread_cond_broadcast(&rw->idlecond);
+    }
+  }
+  pthread_mutex_unlock(&rw->lock);
+  return NULL;
+}
+
+raster_writer* raster_writer_create(int fd){
+  if(fd < 0){
+    logwarn("no file descriptor for the raster writer");
+    return NULL;
+  }
+  raster_writer* rw = malloc(sizeof(*rw));
+  if(rw == NULL){
+    return NULL;
+  }
+  memset(rw, 0, sizeof(*rw));
+  rw->fd = fd;
+  if(fbuf_init(&rw->pending)){
+    free(rw);
+    return NULL;
+  }
+  if(fbuf_init(&rw->writing)){
+    fbuf_free(&rw->pending);
+    free(rw);
+    return NULL;
+  }
+#ifndef __MINGW32__
+  if(notify_pipes(rw)){
+    fbuf_free(&rw->writing);
+    fbuf_free(&rw->pending);
+    free(rw);
+    return NULL;
+  }
+  // we start out idle
+  ready_notify(rw);
+#endif
+  pthread_mutex_init(&rw->lock, NULL);
+  pthread_cond_init(&rw->cond, NULL);
+  pthread_cond_init(&rw->idlecond, NULL);
+  if(pthread_create(&rw->tid, NULL, raster_writer_thread, rw)){
+    logerror("couldn't spin up raster writer");
+    pthread_cond_destroy(&rw->idlecond);
+    pthread_cond_destroy(&rw->cond);
+    pthread_mutex_destroy(&rw->lock);
+#ifndef __MINGW32__
+    close(rw->notify[0]);
+    close(rw->notify[1]);
+#endif
+    fbuf_free(&rw->writing);
+    fbuf_free(&rw->pending);
+    free(rw);
+    return NULL;
+  }
+  loginfo("spun up raster writer on %d", fd);
+  return rw;
+}
+
+int raster_writer_destroy(raster_writer* rw){
+  if(rw == NULL){
+    return 0;
+  }
+  // the thread writes out anything still pending before exiting
+  pthread_mutex_lock(&rw->lock);
+  rw->done = true;
+  pthread_mutex_unlock(&rw->lock);
+  pthread_cond_signal(&rw->cond);
+  pthread_join(rw->tid, NULL);
+  int ret = rw->failed ? -1 : 0;
+  loginfo("raster writer coalesced %" PRIu64 "/%" PRIu64 " frames",
+          rw->coalesced, rw->submissions);
+  pthread_cond_destroy(&rw->idlecond);
+  pthread_cond_destroy(&rw->cond);
+  pthread_mutex_destroy(&rw->lock);
+#ifndef __MINGW32__
+  close(rw->notify[0]);
+  close(rw->notify[1]);
+#endif
+  fbuf_free(&rw->writing);
+  fbuf_free(&rw->pending);
+  free(rw);
+  return ret;
+}
+
+int raster_writer_submit(raster_writer* rw, fbuf* f, size_t offset){
+  if(offset >= f->used){
+    fbuf_reset(f);
+    return 0;
+  }
+  int ret = 0;
+  pthread_mutex_lock(&rw->lock);
+  ++rw->submissions;
+  if(rw->pending.used == 0 && offset == 0){
+    // the common case: the writer has claimed everything we've submitted
+    // (or is idle). trade buffers; no copy is necessary.
+    fbuf tmp = rw->pending;
+    rw->pending = *f;
+    *f = tmp;
+  }else{
+    if(rw->pending.used){
+      ++rw->coalesced;
+    }
+    if(fbuf_putn(&rw->pending, f->buf + offset, f->used - offset) < 0){
+      ret = -1;
+    }
+    fbuf_reset(f);
+  }
+  drain_notify(rw);
+  if(rw->failed){
+    rw->failed = false;
+    ret = -1;
+  }
+  pthread_mutex_unlock(&rw->lock);
+  pthread_cond_signal(&rw->cond);
+  return ret;
+}
+
+void raster_writer_wait(raster_writer* rw){
+  if(rw == NULL){
+    return;
+  }
+  pthread_mutex_lock(&rw->lock);
+  while(!raster_writer_idle_p(rw)){
+    pthread_cond_wait(&rw->idlecond, &rw->lock);
+  }
+  pthread_mutex_unlock(&rw->lock);
+}
+
+int raster_writer_drain(raster_writer* rw){
+  if(rw == NULL){
+    return 0;
+  }
+  pthread_mutex_lock(&rw->lock);
+  while(!raster_writer_idle_p(rw)){
+    pthread_cond_wait(&rw->idlecond, &rw->lock);
+  }
+  int ret = rw->failed ? -1 : 0;
+  rw->failed = false;
+  pthread_mutex_unlock(&rw->lock);
+  return ret;
+}
+
+uint64_t raster_writer_backlog_ns(raster_writer* rw){
+  if(rw == NULL){
+    return 0;
+  }
+  uint64_t ret = 0;
+  pthread_mutex_lock(&rw->lock);
+  if(rw->busy){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const uint64_t elapsed = timespec_to_ns(&now) - rw->writestart;
+    const uint64_t expected = rw->writing.used * rw->nsperbyte;
+    if(expected > elapsed){
+      ret += expected - elapsed;
+    }
+  }
+  ret += rw->pending.used * rw->nsperbyte;
+  pthread_mutex_unlock(&rw->lock);
+  return ret;
+}
+
+double raster_writer_nsperbyte(raster_writer* rw){
+  if(rw == NULL){
+    return 0;
+  }
+  pthread_mutex_lock(&rw->lock);
+  const double ret = rw->nsperbyte;
+  pthread_mutex_unlock(&rw->lock);
+  return ret;
+}
+
+int raster_writer_fd(const raster_writer* rw){
+#ifndef __MINGW32__
+  return rw->notify[0];
+#else
+  (void)rw;
+  return -1;
+#endif
+}
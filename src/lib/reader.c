@@ -1,5 +1,8 @@
 #include "internal.h"
 
+// initial size of the gap buffer, which grows geometrically thereafter
+#define NCREADER_INITIAL_TEXT 64
+
 static void
 ncreader_destroy_internal(ncreader* n){
   if(n){
@@ -9,7 +12,7 @@ ncreader_destroy_internal(ncreader* n){
     if(ncplane_set_widget(n->ncp, NULL, NULL) == 0){
       ncplane_destroy(n->ncp);
     }
-    ncplane_destroy(n->textarea);
+    free(n->text);
     free(n);
   }
 }
@@ -23,6 +26,20 @@ void ncreader_destroy(ncreader* n, char** contents){
   }
 }
 
+// drop all text, leaving the (empty) gap at the start of the buffer.
+static void
+ncreader_reset(ncreader* n){
+  n->gapbeg = 0;
+  n->gapend = n->textend;
+  n->text[n->gapbeg] = '\0';
+  n->linebeg = 0;
+  n->topbeg = 0;
+  n->linecount = 1;
+  n->cury = n->curx = 0;
+  n->yproject = n->xproject = 0;
+  n->projx = UINT_MAX;
+}
+
 ncreader* ncreader_create(ncplane* n, const ncreader_options* opts){
   ncreader_options zeroed = {0};
   if(!opts){
@@ -37,23 +54,16 @@ ncreader* ncreader_create(ncplane* n, const ncreader_options* opts){
     return NULL;
   }
   nr->ncp = n;
-  // do *not* bind it to the visible plane; we always want it offscreen,
-  // to the upper left of the true origin
-  struct ncplane_options nopts = {
-    .y = -ncplane_dim_y(n),
-    .x = -ncplane_dim_x(n),
-    .rows = ncplane_dim_y(n),
-    .cols = ncplane_dim_x(n),
-    .name = "text",
-  };
-  if((nr->textarea = ncplane_create(notcurses_stdplane(ncplane_notcurses(n)), &nopts)) == NULL){
+  if((nr->text = malloc(NCREADER_INITIAL_TEXT)) == NULL){
     ncplane_destroy(nr->ncp);
     free(nr);
     return NULL;
   }
-
+  nr->textend = NCREADER_INITIAL_TEXT - 1;
+  nr->text[nr->textend] = '\0';
+  ncreader_reset(nr);
   nr->horscroll = opts->flags & NCREADER_OPTION_HORSCROLL;
-  nr->xproject = 0;
+  nr->verscroll = opts->flags & NCREADER_OPTION_VERSCROLL;
   nr->tchannels = opts->tchannels;
   nr->tattrs = opts->tattrword;
   nr->no_cmd_keys = opts->flags & NCREADER_OPTION_NOCMDKEYS;
@@ -61,19 +71,18 @@ ncreader* ncreader_create(ncplane* n, const ncreader_options* opts){
   ncplane_set_channels(nr->ncp, opts->tchannels);
   ncplane_set_styles(nr->ncp, opts->tattrword);
   if(ncplane_set_widget(n, nr, (void(*)(void*))ncreader_destroy_internal)){
-    ncplane_destroy(nr->textarea);
     ncplane_destroy(nr->ncp);
+    free(nr->text);
     free(nr);
     return NULL;
   }
   return nr;
 }
 
-// empty both planes of all input, and home the cursors.
+// empty the reader of all input, and home the cursor.
 int ncreader_clear(ncreader* n){
+  ncreader_reset(n);
   ncplane_erase(n->ncp);
-  ncplane_erase(n->textarea);
-  n->xproject = 0;
   return 0;
 }
 
@@ -81,26 +90,208 @@ ncplane* ncreader_plane(ncreader* n){
   return n->ncp;
 }
 
-// copy the viewed area down from the textarea
+// ensure the gap can take 'bytes' more bytes, in addition to its NUL.
+static int
+gap_reserve(ncreader* n, size_t bytes){
+  if(n->gapend - n->gapbeg > bytes){
+    return 0;
+  }
+  const size_t size = n->textend + 1;
+  const size_t grow = size > bytes ? size : bytes + 1;
+  char* tmp = realloc(n->text, size + grow);
+  if(tmp == NULL){
+    logerror("couldn't grow reader text to %zuB", size + grow);
+    return -1;
+  }
+  memmove(tmp + n->gapend + grow, tmp + n->gapend, size - n->gapend);
+  n->text = tmp;
+  n->gapend += grow;
+  n->textend += grow;
+  return 0;
+}
+
+// move the gap (and thus the cursor) left or right by 'bytes'. this is all
+// the work an edit needs to do, and it's proportional only to the distance
+// moved. it is the caller's responsibility to keep the line state correct.
+static void
+gap_left(ncreader* n, size_t bytes){
+  memmove(n->text + n->gapend - bytes, n->text + n->gapbeg - bytes, bytes);
+  n->gapbeg -= bytes;
+  n->gapend -= bytes;
+  n->text[n->gapbeg] = '\0';
+}
+
+static void
+gap_right(ncreader* n, size_t bytes){
+  memmove(n->text + n->gapbeg, n->text + n->gapend, bytes);
+  n->gapbeg += bytes;
+  n->gapend += bytes;
+  n->text[n->gapbeg] = '\0';
+}
+
+// offset of the start of the line containing the byte before 'off', which
+// must precede the gap.
+static size_t
+line_start(const ncreader* n, size_t off){
+  while(off && n->text[off - 1] != '\n'){
+    --off;
+  }
+  return off;
+}
+
+// the newline ending the line containing 's', or NULL if that is the last
+// line. 's' may be on either side of the gap.
+static const char*
+line_end(const ncreader* n, const char* s){
+  const char* gap = n->text + n->gapbeg;
+  if(s <= gap){
+    const char* nl = memchr(s, '\n', gap - s);
+    if(nl){
+      return nl;
+    }
+    s = n->text + n->gapend;
+  }
+  return strchr(s, '\n');
+}
+
+// walk the cursor's line up to the cursor, returning its width in columns.
+// the bytes and columns of the EGC preceding the cursor (zero if the cursor
+// starts its line) are written to '*lastbytes' and '*lastcols'.
+static int
+line_scan(const ncreader* n, int* lastbytes, int* lastcols){
+  int cols = 0;
+  *lastbytes = 0;
+  *lastcols = 0;
+  // the NUL at the start of the gap terminates the walk
+  for(size_t off = n->linebeg ; off < n->gapbeg ; off += *lastbytes){
+    if((*lastbytes = utf8_egc_len(n->text + off, lastcols)) <= 0){
+      return -1;
+    }
+    cols += *lastcols;
+  }
+  return cols;
+}
+
+// bytes and columns of the EGC following the cursor. returns 0 at the end
+// of a line.
+static int
+next_egc(const ncreader* n, int* cols){
+  const char* s = n->text + n->gapend;
+  *cols = 0;
+  if(*s == '\0' || *s == '\n'){
+    return 0;
+  }
+  return utf8_egc_len(s, cols);
+}
+
+// advance along the cursor's line until reaching column 'target', the end
+// of the line, or an EGC which would straddle 'target'.
+static void
+seek_column(ncreader* n, unsigned target){
+  int b, cols;
+  while(n->curx < target && (b = next_egc(n, &cols)) > 0){
+    if(n->curx + cols > target){
+      break;
+    }
+    gap_right(n, b);
+    n->curx += cols;
+  }
+}
+
+// pan the viewport as necessary to contain the cursor. without scrolling,
+// the text is never larger than the viewport (save a cursor following a
+// full line, which we clamp to the last column).
+static void
+ncreader_project(ncreader* n){
+  const unsigned leny = n->ncp->leny;
+  const unsigned lenx = n->ncp->lenx;
+  if(n->cury < n->yproject){
+    n->yproject = n->cury;
+    n->topbeg = n->linebeg;
+  }
+  while(n->cury >= n->yproject + leny){
+    // cury exceeds yproject, so there's a newline between us and the gap
+    n->topbeg = (const char*)memchr(n->text + n->topbeg, '\n', n->gapbeg - n->topbeg)
+                - n->text + 1;
+    ++n->yproject;
+  }
+  if(!n->horscroll){
+    n->xproject = 0;
+  }else if(n->curx < n->xproject){
+    n->xproject = n->curx;
+  }else if(n->curx >= n->xproject + lenx){
+    n->xproject = n->curx - lenx + 1;
+  }
+  // find the cursor line's first visible EGC, so that a long line needn't be
+  // walked from its start on every redraw. edits and moves all happen at the
+  // cursor, which is at or past it, and so don't disturb it. it only moves
+  // forward here; anything else starts it over.
+  if(n->xproject == n->curx){
+    n->projbeg = n->gapbeg;
+    n->projx = n->curx;
+    return;
+  }
+  if(n->projx > n->xproject){
+    n->projbeg = n->linebeg;
+    n->projx = 0;
+  }
+  int b, cols;
+  while(n->projx < n->xproject && (b = utf8_egc_len(n->text + n->projbeg, &cols)) > 0){
+    if(n->projx + cols > n->xproject){
+      break;
+    }
+    n->projbeg += b;
+    n->projx += cols;
+  }
+}
+
+// draw only the viewport's region of the text. lines are skipped a memchr()
+// at a time, so a long text costs nothing beyond what's visible.
 static int
 ncreader_redraw(ncreader* n){
   int ret = 0;
-//fprintf(stderr, "redraw: xproj %d\n", n->xproject);
-//notcurses_debug(n->ncp->nc, stderr);
-  assert(n->xproject >= 0);
-  assert(n->textarea->lenx >= n->ncp->lenx);
-  assert(n->textarea->leny >= n->ncp->leny);
-  for(unsigned y = 0 ; y < n->ncp->leny ; ++y){
-    const unsigned texty = y;
-    for(unsigned x = 0 ; x < n->ncp->lenx ; ++x){
-      const unsigned textx = x + n->xproject;
-      const nccell* src = &n->textarea->fb[nfbcellidx(n->textarea, texty, textx)];
-      nccell* dst = &n->ncp->fb[nfbcellidx(n->ncp, y, x)];
-//fprintf(stderr, "projecting %d/%d [%s] to %d/%d [%s]\n", texty, textx, cell_extended_gcluster(n->textarea, src), y, x, cell_extended_gcluster(n->ncp, dst));
-      if(cellcmp_and_dupfar(&n->ncp->pool, dst, n->textarea, src) < 0){
+  ncreader_project(n);
+  ncplane_erase(n->ncp);
+  const unsigned leny = n->ncp->leny;
+  const unsigned lenx = n->ncp->lenx;
+  const char* s = n->text + n->topbeg;
+  for(unsigned y = 0 ; y < leny && s ; ++y){
+    unsigned col = 0;
+    if(y + n->yproject == n->cury){
+      s = n->text + n->projbeg;
+      col = n->projx;
+    }
+    while(col < n->xproject + lenx){
+      if(s == n->text + n->gapbeg){
+        s = n->text + n->gapend;
+      }
+      if(*s == '\0' || *s == '\n'){
+        break;
+      }
+      int cols;
+      const int b = utf8_egc_len(s, &cols);
+      if(b <= 0){
         ret = -1;
+        break;
       }
+      if(col >= n->xproject && col + cols <= n->xproject + lenx){
+        if(ncplane_putegc_yx(n->ncp, y, col - n->xproject, s, NULL) < 0){
+          ret = -1;
+        }
+      }
+      col += cols;
+      s += b;
     }
+    if((s = line_end(n, s))){
+      ++s;
+    }
+  }
+  unsigned curx = n->curx - n->xproject;
+  if(curx >= lenx){
+    curx = lenx - 1;
+  }
+  if(ncplane_cursor_move_yx(n->ncp, n->cury - n->yproject, curx)){
+    ret = -1;
   }
   if(notcurses_cursor_enable(ncplane_notcurses(n->ncp), n->ncp->absy + n->ncp->y, n->ncp->absx + n->ncp->x)){
     ret = -1;
@@ -108,177 +299,231 @@ ncreader_redraw(ncreader* n){
   return ret;
 }
 
-// try to move left. does not move past the start of the textarea, but will
-// try to move up and to the end of the previous row if not on the top row.
-// if on the left side of the viewarea, but not the left side of the textarea,
-// scrolls left. returns 0 if a move was made.
-int ncreader_move_left(ncreader* n){
-  int viewx = n->ncp->x;
-  int textx = n->textarea->x;
-  int y = n->ncp->y;
-//fprintf(stderr, "moving left: tcurs: %dx%d vcurs: %dx%d xproj: %d\n", y, textx, y, viewx, n->xproject);
-  if(textx == 0){
-    // are we on the first column of the textarea? if so, we must also be on
-    // the first column of the viewarea. try to move up.
-    if(y == 0){
-      return -1; // no move possible
+// step back over one EGC, or over the end of the previous line if we're at
+// the start of our own. returns 0 if a move was made.
+static int
+step_left(ncreader* n){
+  int b, cols;
+  if(line_scan(n, &b, &cols) < 0){
+    return -1;
+  }
+  if(b){
+    gap_left(n, b);
+    n->curx -= cols;
+  }else if(n->gapbeg){
+    gap_left(n, 1);
+    --n->cury;
+    n->linebeg = line_start(n, n->gapbeg);
+    n->projx = UINT_MAX;
+    if((cols = line_scan(n, &b, &b)) < 0){
+      return -1;
     }
-    viewx = n->ncp->lenx - 1; // FIXME find end of particular row
-    --y;
-    textx = n->textarea->lenx - 1;
-    n->xproject = n->textarea->x - n->ncp->x;
+    n->curx = cols;
   }else{
-    // if we're on the first column of the viewarea, but not the first column
-    // of the textarea, we must be able to scroll to the left. do so.
-    // if we're not on the last column anywhere, move cursor right everywhere.
-    if(viewx == 0){
-      --n->xproject;
-    }else{
-      --viewx;
-    }
-    --textx;
+    return -1;
+  }
+  return 0;
+}
+
+// step forward over one EGC, or onto the start of the next line if we're at
+// the end of our own. returns 0 if a move was made.
+static int
+step_right(ncreader* n){
+  int cols;
+  const int b = next_egc(n, &cols);
+  if(b < 0){
+    return -1;
+  }
+  if(b){
+    gap_right(n, b);
+    n->curx += cols;
+  }else if(n->text[n->gapend] == '\n'){
+    gap_right(n, 1);
+    ++n->cury;
+    n->curx = 0;
+    n->linebeg = n->gapbeg;
+    n->projx = UINT_MAX;
+  }else{
+    return -1;
+  }
+  return 0;
+}
+
+// try to move left. does not move past the start of the text, but will move
+// up to the end of the previous line if not on the first line. pans the
+// viewport as necessary. returns 0 if a move was made.
+int ncreader_move_left(ncreader* n){
+  if(step_left(n)){
+    return -1;
   }
-  ncplane_cursor_move_yx(n->textarea, y, textx);
-  ncplane_cursor_move_yx(n->ncp, y, viewx);
-//fprintf(stderr, "moved left: tcurs: %dx%d vcurs: %dx%d xproj: %d\n", y, textx, y, viewx, n->xproject);
   ncreader_redraw(n);
   return 0;
 }
 
-// try to move right. does not move past the end of the textarea, but will
-// try to move down and to the start of the previous row if not on the bottom
-// row. if on the right side of the viewarea, but not the right side of the
-// textarea, pans right. returns 0 if a move was made.
+// try to move right. does not move past the end of the text, but will move
+// down to the start of the next line if not on the last line. pans the
+// viewport as necessary. returns 0 if a move was made.
 int ncreader_move_right(ncreader* n){
-  unsigned textx = n->textarea->x;
-  unsigned y = n->ncp->y;
-  unsigned viewx = n->ncp->x;
-//fprintf(stderr, "moving right: tcurs: %dx%d vcurs: %dx%d xproj: %d\n", y, textx, y, viewx, n->xproject);
-  if(textx >= n->textarea->lenx - 1){
-    // are we on the last column of the textarea? if so, we must also be on
-    // the first column of the viewarea. try to move down.
-    if(y >= n->textarea->leny - 1){
-      return -1; // no move possible
-    }
-    viewx = 0;
-    ++y;
-    textx = viewx;
-    n->xproject = 0;
-  }else{
-    // if we're on the first column of the viewarea, but not the first column
-    // of the textarea, we must be able to scroll to the left. do so.
-    // if we're not on the last column anywhere, move cursor right everywhere.
-    if(viewx >= n->ncp->lenx - 1){
-      ++n->xproject;
-    }else{
-      ++viewx;
-    }
-    ++textx;
+  if(step_right(n)){
+    return -1;
   }
-  ncplane_cursor_move_yx(n->textarea, y, textx);
-  ncplane_cursor_move_yx(n->ncp, y, viewx);
-//fprintf(stderr, "moved right: tcurs: %dx%d vcurs: %dx%d xproj: %d\n", y, textx, y, viewx, n->xproject);
   ncreader_redraw(n);
   return 0;
 }
 
-// try to move up. does not move past the top of the textarea.
+// try to move up, keeping our column if the previous line is long enough.
 // returns 0 if a move was made.
 int ncreader_move_up(ncreader* n){
-  int y = n->ncp->y;
-  if(y == 0){
-    // are we on the last row of the textarea? if so, we can't move.
+  if(n->cury == 0){
     return -1;
   }
-  --y;
-  ncplane_cursor_move_yx(n->textarea, y, -1);
-  ncplane_cursor_move_yx(n->ncp, y, -1);
+  const unsigned target = n->curx;
+  const size_t prev = line_start(n, n->linebeg - 1);
+  gap_left(n, n->gapbeg - prev);
+  n->linebeg = prev;
+  --n->cury;
+  n->curx = 0;
+  n->projx = UINT_MAX;
+  seek_column(n, target);
   ncreader_redraw(n);
   return 0;
 }
 
-// try to move down. does not move past the bottom of the textarea.
+// try to move down, keeping our column if the next line is long enough.
 // returns 0 if a move was made.
 int ncreader_move_down(ncreader* n){
-  unsigned y = n->ncp->y;
-  if(y >= n->textarea->leny - 1){
-    // are we on the last row of the textarea? if so, we can't move.
+  const char* nl = line_end(n, n->text + n->gapend);
+  if(nl == NULL){
     return -1;
   }
-  ++y;
-  ncplane_cursor_move_yx(n->textarea, y, -1);
-  ncplane_cursor_move_yx(n->ncp, y, -1);
+  const unsigned target = n->curx;
+  gap_right(n, nl - (n->text + n->gapend) + 1);
+  n->linebeg = n->gapbeg;
+  ++n->cury;
+  n->curx = 0;
+  n->projx = UINT_MAX;
+  seek_column(n, target);
   ncreader_redraw(n);
   return 0;
 }
 
-// only writing can enlarge the textarea. movement can pan, but not enlarge.
+// insert a line break at the cursor. without vertical scrolling, we can't
+// have more lines than the plane has rows.
+static int
+ncreader_break_line(ncreader* n){
+  if(!n->verscroll && n->linecount >= n->ncp->leny){
+    return -1;
+  }
+  if(gap_reserve(n, 1)){
+    return -1;
+  }
+  n->text[n->gapbeg++] = '\n';
+  n->text[n->gapbeg] = '\0';
+  n->linebeg = n->gapbeg;
+  ++n->linecount;
+  ++n->cury;
+  n->curx = 0;
+  n->projx = UINT_MAX;
+  return 0;
+}
+
+// columns between the cursor and the end of its line
+static int
+rest_of_line_cols(const ncreader* n){
+  int cols = 0;
+  const char* s = n->text + n->gapend;
+  while(*s && *s != '\n'){
+    int c;
+    const int b = utf8_egc_len(s, &c);
+    if(b <= 0){
+      return -1;
+    }
+    cols += c;
+    s += b;
+  }
+  return cols;
+}
+
+// insert at the cursor, and move the cursor past it. only the cursor's line
+// is affected, and that only through the gap: the cost is independent of the
+// size of the text. a lone newline breaks the line.
 int ncreader_write_egc(ncreader* n, const char* egc){
-  const int cols = ncstrwidth(egc, NULL, NULL);
-  if(cols < 0){
+  if(strcmp(egc, "\n") == 0){
+    if(ncreader_break_line(n)){
+      return -1;
+    }
+    ncreader_redraw(n);
+    return 0;
+  }
+  int bytes;
+  const int cols = ncstrwidth(egc, &bytes, NULL);
+  if(cols < 0 || strchr(egc, '\n')){
     logerror("fed illegal UTF-8 [%s]", egc);
     return -1;
   }
-  if(n->textarea->x >= n->textarea->lenx - cols){
-    if(n->horscroll){
-      if(ncplane_resize_simple(n->textarea, n->textarea->leny, n->textarea->lenx + cols)){
-        return -1;
-      }
-      ++n->xproject;
+  if(!n->horscroll){
+    const int rest = rest_of_line_cols(n);
+    if(rest < 0 || n->curx + rest + cols > n->ncp->lenx){
+      return -1;
     }
-  }else if(n->ncp->x >= n->ncp->lenx){
-    ++n->xproject;
   }
-  // use ncplane_putegc on both planes because it'll get cursor movement right
-  if(ncplane_putegc(n->textarea, egc, NULL) < 0){
+  if(gap_reserve(n, bytes)){
     return -1;
   }
-  if(ncplane_putegc(n->ncp, egc, NULL) < 0){
+  memcpy(n->text + n->gapbeg, egc, bytes);
+  n->gapbeg += bytes;
+  n->text[n->gapbeg] = '\0';
+  n->curx += cols;
+  ncreader_redraw(n);
+  return 0;
+}
+
+// delete the EGC preceding the cursor, joining our line to the previous one
+// if we're at the start of it. doesn't redraw.
+static int
+delete_left(ncreader* n){
+  int b, cols;
+  if(line_scan(n, &b, &cols) < 0){
     return -1;
   }
-  if(n->textarea->x >= n->textarea->lenx - cols){
-    if(!n->horscroll){
-      n->textarea->x = n->textarea->lenx - cols;
-    }
+  if(b){
+    n->gapbeg -= b;
+    n->curx -= cols;
+  }else if(n->gapbeg){
+    --n->gapbeg;
+    --n->linecount;
+    --n->cury;
+    n->linebeg = line_start(n, n->gapbeg);
+    n->projx = UINT_MAX;
+  }else{
+    return -1;
   }
-  if(n->ncp->x >= n->ncp->lenx - cols){
-    n->ncp->x = n->ncp->lenx - cols;
+  n->text[n->gapbeg] = '\0';
+  if(!b){
+    if((cols = line_scan(n, &b, &b)) < 0){
+      return -1;
+    }
+    n->curx = cols;
   }
-  ncreader_redraw(n);
   return 0;
 }
 
 static bool
 do_backspace(ncreader* n){
-  int x = n->textarea->x;
-  int y = n->textarea->y;
-  if(n->textarea->x == 0){
-    if(n->textarea->y){
-      y = n->textarea->y - 1;
-      x = n->textarea->lenx - 1;
-    }
-  }else{
-    --x;
-  }
-  ncplane_putegc_yx(n->textarea, y, x, "", NULL);
-  ncplane_cursor_move_yx(n->textarea, y, x);
-  ncplane_cursor_move_yx(n->ncp, n->ncp->y, n->ncp->x - 1);
+  delete_left(n);
   ncreader_redraw(n);
   return true;
 }
 
+// is the EGC following the cursor a word break? the ends of lines are.
 static bool
-is_egc_wordbreak(ncplane* textarea){
-  char* egc = ncplane_at_yx(textarea, textarea->y, textarea->x, NULL, NULL);
-  if(egc == NULL){
+is_egc_wordbreak(const ncreader* n){
+  const char* s = n->text + n->gapend;
+  if(*s == '\0' || *s == '\n'){
     return true;
   }
-  wchar_t w;
-  mbstate_t mbstate;
-  memset(&mbstate, 0, sizeof(mbstate));
-  size_t s = mbrtowc(&w, egc, MB_CUR_MAX, &mbstate);
-  free(egc);
-  if(s == (size_t)-1 || s == (size_t)-2){
+  uint32_t w;
+  if(utf8_decode(s, &w) < 0){
     return true;
   }
   if(iswordbreak(w)){
@@ -297,37 +542,33 @@ ncreader_ctrl_input(ncreader* n, const ncinput* ni){
       ncreader_move_right(n);
       break;
     case 'A': // cursor to beginning of line
-      while(n->textarea->x){
-        if(ncreader_move_left(n)){
-          break;
-        }
-      }
+      gap_left(n, n->gapbeg - n->linebeg);
+      n->curx = 0;
+      ncreader_redraw(n);
       break;
     case 'E': // cursor to end of line
-      while(n->textarea->x < ncplane_dim_x(n->textarea) - 1){
-        if(ncreader_move_right(n)){
-          break;
-        }
-      }
+      seek_column(n, UINT_MAX);
+      ncreader_redraw(n);
       break;
     case 'U': // clear line before cursor
-      while(n->textarea->x){
-        do_backspace(n);
-      }
+      n->gapbeg = n->linebeg;
+      n->text[n->gapbeg] = '\0';
+      n->curx = 0;
+      ncreader_redraw(n);
       break;
     case 'W': // clear word before cursor
-      while(n->textarea->x){
-        if(ncreader_move_left(n)){
+      while(n->curx){
+        if(step_left(n)){
           break;
         }
-        if(is_egc_wordbreak(n->textarea)){
+        const bool wordbreak = is_egc_wordbreak(n);
+        step_right(n);
+        if(wordbreak){
           break;
         }
-        if(ncreader_move_right(n)){
-          break;
-        }
-        do_backspace(n);
+        delete_left(n);
       }
+      ncreader_redraw(n);
       break;
     default:
       return false; // pass on all other ctrls
@@ -337,26 +578,29 @@ ncreader_ctrl_input(ncreader* n, const ncinput* ni){
 
 static bool
 ncreader_alt_input(ncreader* n, const ncinput* ni){
+  int cols;
   switch(ni->id){
     case 'b': // back one word (to first cell), but not to previous line
-      while(n->textarea->x){
-        if(ncreader_move_left(n)){
+      while(n->curx){
+        if(step_left(n)){
           break;
         }
-        if(is_egc_wordbreak(n->textarea)){
+        if(is_egc_wordbreak(n)){
           break;
         }
       }
+      ncreader_redraw(n);
       break;
-    case 'f': // forward one word (past end cell)
-      while(n->textarea->x < ncplane_dim_x(n->textarea) - 1){
-        if(ncreader_move_right(n)){
+    case 'f': // forward one word (past end cell), but not to next line
+      while(next_egc(n, &cols) > 0){
+        if(step_right(n)){
           break;
         }
-        if(is_egc_wordbreak(n->textarea)){
+        if(is_egc_wordbreak(n)){
           break;
         }
       }
+      ncreader_redraw(n);
       break;
     default:
       return false;
@@ -383,8 +627,6 @@ bool ncreader_offer_input(ncreader* n, const ncinput* ni){
   if(ni->id == NCKEY_BACKSPACE){
     return do_backspace(n);
   }
-  // FIXME deal with multicolumn EGCs -- probably extract these and make them
-  // general ncplane_cursor_{left, right, up, down}()
   if(ni->id == NCKEY_LEFT){
     ncreader_move_left(n);
     return true;
@@ -410,6 +652,13 @@ bool ncreader_offer_input(ncreader* n, const ncinput* ni){
   return true;
 }
 
+// the text is the two sides of the gap, each already NUL-terminated.
 char* ncreader_contents(const ncreader* n){
-  return ncplane_contents(n->ncp, 0, 0, 0, 0);
+  const size_t after = n->textend - n->gapend;
+  char* ret = malloc(n->gapbeg + after + 1);
+  if(ret){
+    memcpy(ret, n->text, n->gapbeg);
+    memcpy(ret + n->gapbeg, n->text + n->gapend, after + 1);
+  }
+  return ret;
 }
@@ -0,0 +1,755 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <inttypes.h>
+#include "internal.h"
+#ifdef USE_DEFLATE
+#include <libdeflate.h>
+#else
+#include <zlib.h>
+#endif
+
+// session recordings. each frame is an ncpile_capture() of the pile, either
+// complete (a keyframe) or a delta against the previous frame, compressed
+// with zlib framing (libdeflate and zlib builds read one another's files). all
+// integers are little-endian. the file is:
+//
+//  header (8 bytes): "NCRC", u8 version, u8 reserved, u16 reserved
+//  frames (20 bytes + payload): u8 type (1: key, 2: delta), u8 codec (0:
+//   stored, 1: zlib), u16 reserved, u64 ns since the recording began, u32
+//   length of the capture, u32 length of the payload which follows.
+//  index: "NCRI", u32 keyframe count, then per keyframe u64 ns, u64 offset
+//  trailer (12 bytes): u64 offset of the index, "NCRE"
+//
+// the index and trailer are written when the recorder is destroyed. playback
+// of a file lacking them (say, the recording process died) rebuilds the index
+// by walking the frame headers, and stops at the first truncated frame.
+
+#define RECORD_VERSION 1
+#define RECORD_HEADER_LEN 8
+#define RECORD_FRAME_HEADER_LEN 20
+#define RECORD_TRAILER_LEN 12
+#define RECORD_FRAME_KEY 1
+#define RECORD_FRAME_DELTA 2
+#define RECORD_CODEC_STORED 0
+#define RECORD_CODEC_ZLIB 1
+// captures smaller than this aren't worth compressing
+#define RECORD_COMPRESS_MIN 64
+#define RECORD_DEFAULT_KEYFRAMES 120
+// offset of the flags byte within an ncpile_capture() buffer
+#define CAPTURE_FLAGS_OFFSET 5
+#define CAPTURE_HEADER_LEN 20
+
+typedef struct recframe {
+  struct recframe* next;
+  char* buf;         // the capture
+  size_t len;
+  uint64_t ns;
+  bool key;
+} recframe;
+
+typedef struct reckey {
+  uint64_t ns;
+  uint64_t offset;   // of the frame header
+} reckey;
+
+typedef struct ncrecorder {
+  ncplane* n;
+  FILE* fp;
+  uint64_t start;    // CLOCK_MONOTONIC ns at creation
+  unsigned keyint;   // frames between forced keyframes
+  unsigned sincekey; // frames since the last keyframe
+  bool compress;
+  pthread_t tid;
+  pthread_mutex_t lock; // guards the queue, done, and failed
+  pthread_cond_t cond;
+  recframe* head;
+  recframe** tail;
+  bool done;
+  bool failed;       // the writer hit an error; no further frames are taken
+  // everything below belongs to the writer thread
+  uint64_t offset;   // bytes written so far
+  reckey* keys;
+  unsigned keycount;
+  unsigned keyalloc;
+  unsigned char* cbuf;
+  size_t cbufsize;
+#ifdef USE_DEFLATE
+  struct libdeflate_compressor* cmp;
+#endif
+} ncrecorder;
+
+typedef struct ncplayback {
+  FILE* fp;
+  reckey* keys;
+  unsigned keycount;
+  uint64_t end;      // offset past the last complete frame
+  unsigned char* raw;
+  size_t rawsize;
+  unsigned char* zbuf;
+  size_t zbufsize;
+  unsigned dimy, dimx; // geometry of the last frame applied, 0 if none
+#ifdef USE_DEFLATE
+  struct libdeflate_decompressor* dcmp;
+#endif
+} ncplayback;
+
+static void
+rec_put(unsigned char* b, uint64_t v, unsigned bytes){
+  for(unsigned i = 0 ; i < bytes ; ++i){
+    b[i] = v >> (i * 8);
+  }
+}
+
+static uint64_t
+rec_get(const unsigned char* b, unsigned bytes){
+  uint64_t v = 0;
+  for(unsigned i = 0 ; i < bytes ; ++i){
+    v |= (uint64_t)b[i] << (i * 8);
+  }
+  return v;
+}
+
+static int
+rec_write(ncrecorder* r, const void* buf, size_t len){
+  if(fwrite(buf, 1, len, r->fp) != len){
+    logerror("error writing %zuB of recording", len);
+    return -1;
+  }
+  r->offset += len;
+  return 0;
+}
+
+static int
+rec_keyframe(ncrecorder* r, uint64_t ns){
+  if(r->keycount == r->keyalloc){
+    unsigned nalloc = r->keyalloc ? r->keyalloc * 2 : 64;
+    reckey* tmp = realloc(r->keys, sizeof(*tmp) * nalloc);
+    if(tmp == NULL){
+      return -1;
+    }
+    r->keys = tmp;
+    r->keyalloc = nalloc;
+  }
+  r->keys[r->keycount].ns = ns;
+  r->keys[r->keycount].offset = r->offset;
+  ++r->keycount;
+  return 0;
+}
+
+// compress |f| into r->cbuf, returning the compressed length, or 0 if it
+// didn't compress (or we failed to try; the frame is then stored).
+static size_t
+rec_compress(ncrecorder* r, const recframe* f){
+  if(!r->compress || f->len < RECORD_COMPRESS_MIN){
+    return 0;
+  }
+#ifdef USE_DEFLATE
+  size_t bound = libdeflate_zlib_compress_bound(r->cmp, f->len);
+#else
+  size_t bound = compressBound(f->len);
+#endif
+  if(r->cbufsize < bound){
+    unsigned char* tmp = realloc(r->cbuf, bound);
+    if(tmp == NULL){
+      return 0;
+    }
+    r->cbuf = tmp;
+    r->cbufsize = bound;
+  }
+#ifdef USE_DEFLATE
+  size_t clen = libdeflate_zlib_compress(r->cmp, f->buf, f->len, r->cbuf, bound);
+#else
+  uLongf clen = bound;
+  if(compress2(r->cbuf, &clen, (const Bytef*)f->buf, f->len, 6) != Z_OK){
+    clen = 0;
+  }
+#endif
+  return clen < f->len ? clen : 0;
+}
+
+static int
+rec_write_frame(ncrecorder* r, const recframe* f){
+  if(f->key && rec_keyframe(r, f->ns)){
+    return -1;
+  }
+  const size_t clen = rec_compress(r, f);
+  unsigned char hdr[RECORD_FRAME_HEADER_LEN];
+  hdr[0] = f->key ? RECORD_FRAME_KEY : RECORD_FRAME_DELTA;
+  hdr[1] = clen ? RECORD_CODEC_ZLIB : RECORD_CODEC_STORED;
+  rec_put(hdr + 2, 0, 2);
+  rec_put(hdr + 4, f->ns, 8);
+  rec_put(hdr + 12, f->len, 4);
+  rec_put(hdr + 16, clen ? clen : f->len, 4);
+  if(rec_write(r, hdr, sizeof(hdr))){
+    return -1;
+  }
+  return rec_write(r, clen ? (const void*)r->cbuf : f->buf, clen ? clen : f->len);
+}
+
+static void*
+rec_writer(void* vr){
+  ncrecorder* r = vr;
+  nc_thread_setup("record");
+  pthread_mutex_lock(&r->lock);
+  for( ; ; ){
+    while(r->head == NULL && !r->done){
+      pthread_cond_wait(&r->cond, &r->lock);
+    }
+    recframe* f = r->head;
+    if(f == NULL){ // done, and drained
+      break;
+    }
+    if((r->head = f->next) == NULL){
+      r->tail = &r->head;
+    }
+    const bool failed = r->failed;
+    pthread_mutex_unlock(&r->lock);
+    int ret = failed ? 0 : rec_write_frame(r, f);
+    free(f->buf);
+    free(f);
+    pthread_mutex_lock(&r->lock);
+    if(ret){
+      r->failed = true;
+    }
+  }
+  pthread_mutex_unlock(&r->lock);
+  return NULL;
+}
+
+ncrecorder* ncrecorder_create(ncplane* n, const char* path,
+                              const ncrecorder_options* opts){
+  ncrecorder_options zeroed = {0};
+  if(opts == NULL){
+    opts = &zeroed;
+  }
+  if(opts->flags > NCRECORDER_OPTION_NOCOMPRESS){
+    logwarn("provided unsupported flags %016" PRIx64, opts->flags);
+  }
+  ncrecorder* r = malloc(sizeof(*r));
+  if(r == NULL){
+    return NULL;
+  }
+  memset(r, 0, sizeof(*r));
+  r->n = n;
+  r->keyint = opts->keyframe_interval ? opts->keyframe_interval : RECORD_DEFAULT_KEYFRAMES;
+  r->compress = !(opts->flags & NCRECORDER_OPTION_NOCOMPRESS);
+  r->tail = &r->head;
+#ifdef USE_DEFLATE
+  // recording is off the render path, so we can afford more effort than kitty
+  if((r->cmp = libdeflate_alloc_compressor(6)) == NULL){
+    logerror("couldn't get libdeflate context");
+    free(r);
+    return NULL;
+  }
+#endif
+  if((r->fp = fopen(path, "wb")) == NULL){
+    logerror("couldn't open %s for writing", path);
+    goto err;
+  }
+  unsigned char hdr[RECORD_HEADER_LEN] = { 'N', 'C', 'R', 'C', RECORD_VERSION, };
+  if(rec_write(r, hdr, sizeof(hdr))){
+    goto err;
+  }
+  if(pthread_mutex_init(&r->lock, NULL)){
+    goto err;
+  }
+  if(pthread_cond_init(&r->cond, NULL)){
+    pthread_mutex_destroy(&r->lock);
+    goto err;
+  }
+  if(pthread_create(&r->tid, NULL, rec_writer, r)){
+    logerror("couldn't spawn recording thread");
+    pthread_cond_destroy(&r->cond);
+    pthread_mutex_destroy(&r->lock);
+    goto err;
+  }
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  r->start = timespec_to_ns(&ts);
+  return r;
+
+err:
+  if(r->fp){
+    fclose(r->fp);
+  }
+#ifdef USE_DEFLATE
+  libdeflate_free_compressor(r->cmp);
+#endif
+  free(r);
+  return NULL;
+}
+
+int ncrecorder_frame(ncrecorder* r){
+  recframe* f = malloc(sizeof(*f));
+  if(f == NULL){
+    return -1;
+  }
+  const bool key = r->sincekey == 0;
+  if(ncpile_capture(r->n, !key, &f->buf, &f->len)){
+    free(f);
+    return -1;
+  }
+  // the capture might have been complete despite our asking for a delta
+  f->key = !(f->buf[CAPTURE_FLAGS_OFFSET] & 0x1);
+  f->next = NULL;
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  f->ns = timespec_to_ns(&ts) - r->start;
+  r->sincekey = f->key ? 1 : r->sincekey + 1;
+  if(r->sincekey >= r->keyint){
+    r->sincekey = 0;
+  }
+  pthread_mutex_lock(&r->lock);
+    const bool failed = r->failed;
+    if(!failed){
+      *r->tail = f;
+      r->tail = &f->next;
+      pthread_cond_signal(&r->cond);
+    }
+  pthread_mutex_unlock(&r->lock);
+  if(failed){
+    logerror("recording failed; frame dropped");
+    free(f->buf);
+    free(f);
+    return -1;
+  }
+  return 0;
+}
+
+// write the keyframe index and trailer. called once the writer has exited.
+static int
+rec_write_index(ncrecorder* r){
+  const uint64_t idxoff = r->offset;
+  unsigned char b[16] = { 'N', 'C', 'R', 'I', };
+  rec_put(b + 4, r->keycount, 4);
+  if(rec_write(r, b, 8)){
+    return -1;
+  }
+  for(unsigned i = 0 ; i < r->keycount ; ++i){
+    rec_put(b, r->keys[i].ns, 8);
+    rec_put(b + 8, r->keys[i].offset, 8);
+    if(rec_write(r, b, 16)){
+      return -1;
+    }
+  }
+  rec_put(b, idxoff, 8);
+  memcpy(b + 8, "NCRE", 4);
+  return rec_write(r, b, RECORD_TRAILER_LEN);
+}
+
+int ncrecorder_destroy(ncrecorder* r){
+  int ret = 0;
+  if(r){
+    pthread_mutex_lock(&r->lock);
+      r->done = true;
+      pthread_cond_signal(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+    pthread_join(r->tid, NULL);
+    if(r->failed || rec_write_index(r)){
+      ret = -1;
+    }
+    if(fclose(r->fp)){
+      ret = -1;
+    }
+    pthread_cond_destroy(&r->cond);
+    pthread_mutex_destroy(&r->lock);
+#ifdef USE_DEFLATE
+    libdeflate_free_compressor(r->cmp);
+#endif
+    free(r->keys);
+    free(r->cbuf);
+    free(r);
+  }
+  return ret;
+}
+
+static int
+pb_reserve(unsigned char** buf, size_t* size, size_t len){
+  if(*size < len){
+    unsigned char* tmp = realloc(*buf, len);
+    if(tmp == NULL){
+      return -1;
+    }
+    *buf = tmp;
+    *size = len;
+  }
+  return 0;
+}
+
+static int
+pb_addkey(ncplayback* pb, unsigned* alloc, uint64_t ns, uint64_t offset){
+  if(pb->keycount == *alloc){
+    unsigned nalloc = *alloc ? *alloc * 2 : 64;
+    reckey* tmp = realloc(pb->keys, sizeof(*tmp) * nalloc);
+    if(tmp == NULL){
+      return -1;
+    }
+    pb->keys = tmp;
+    *alloc = nalloc;
+  }
+  pb->keys[pb->keycount].ns = ns;
+  pb->keys[pb->keycount].offset = offset;
+  ++pb->keycount;
+  return 0;
+}
+
+// load the index named by the trailer, if there is one. returns 1 if there's
+// no (valid) trailer, in which case pb->keys is left empty.
+static int
+pb_read_index(ncplayback* pb){
+  unsigned char b[16];
+  if(fseeko(pb->fp, -RECORD_TRAILER_LEN, SEEK_END) ||
+     fread(b, 1, RECORD_TRAILER_LEN, pb->fp) != RECORD_TRAILER_LEN ||
+     memcmp(b + 8, "NCRE", 4)){
+    return 1;
+  }
+  const uint64_t idxoff = rec_get(b, 8);
+  if(fseeko(pb->fp, idxoff, SEEK_SET) || fread(b, 1, 8, pb->fp) != 8 ||
+     memcmp(b, "NCRI", 4)){
+    return 1;
+  }
+  const unsigned count = rec_get(b + 4, 4);
+  unsigned alloc = 0;
+  for(unsigned i = 0 ; i < count ; ++i){
+    if(fread(b, 1, 16, pb->fp) != 16){
+      return 1;
+    }
+    if(pb_addkey(pb, &alloc, rec_get(b, 8), rec_get(b + 8, 8))){
+      return -1;
+    }
+  }
+  pb->end = idxoff;
+  return 0;
+}
+
+// walk the frame headers, indexing keyframes, until we hit the end of the
+// file or a truncated frame.
+static int
+pb_scan(ncplayback* pb){
+  unsigned alloc = 0;
+  uint64_t off = RECORD_HEADER_LEN;
+  unsigned char b[RECORD_FRAME_HEADER_LEN];
+  if(fseeko(pb->fp, 0, SEEK_END)){
+    return -1;
+  }
+  const off_t flen = ftello(pb->fp);
+  while(fseeko(pb->fp, off, SEEK_SET) == 0 &&
+        fread(b, 1, sizeof(b), pb->fp) == sizeof(b)){
+    if(b[0] != RECORD_FRAME_KEY && b[0] != RECORD_FRAME_DELTA){
+      break;
+    }
+    const uint64_t next = off + sizeof(b) + rec_get(b + 16, 4);
+    if(next > (uint64_t)flen){
+      break;
+    }
+    if(b[0] == RECORD_FRAME_KEY && pb_addkey(pb, &alloc, rec_get(b + 4, 8), off)){
+      return -1;
+    }
+    off = next;
+  }
+  pb->end = off;
+  return 0;
+}
+
+ncplayback* ncplayback_open(const char* path){
+  ncplayback* pb = malloc(sizeof(*pb));
+  if(pb == NULL){
+    return NULL;
+  }
+  memset(pb, 0, sizeof(*pb));
+  if((pb->fp = fopen(path, "rb")) == NULL){
+    logerror("couldn't open %s", path);
+    free(pb);
+    return NULL;
+  }
+  unsigned char hdr[RECORD_HEADER_LEN];
+  if(fread(hdr, 1, sizeof(hdr), pb->fp) != sizeof(hdr) || memcmp(hdr, "NCRC", 4)){
+    loginfo("%s is not a recording", path);
+    goto err;
+  }
+  if(hdr[4] != RECORD_VERSION){
+    logerror("unsupported recording version %u", hdr[4]);
+    goto err;
+  }
+#ifdef USE_DEFLATE
+  if((pb->dcmp = libdeflate_alloc_decompressor()) == NULL){
+    logerror("couldn't get libdeflate context");
+    goto err;
+  }
+#endif
+  int r = pb_read_index(pb);
+  if(r > 0){
+    loginfo("no index in %s, scanning", path);
+    free(pb->keys);
+    pb->keys = NULL;
+    pb->keycount = 0;
+    r = pb_scan(pb);
+  }
+  if(r || fseeko(pb->fp, RECORD_HEADER_LEN, SEEK_SET)){
+    goto err;
+  }
+  return pb;
+
+err:
+  ncplayback_close(pb);
+  return NULL;
+}
+
+void ncplayback_close(ncplayback* pb){
+  if(pb){
+    fclose(pb->fp);
+#ifdef USE_DEFLATE
+    if(pb->dcmp){
+      libdeflate_free_decompressor(pb->dcmp);
+    }
+#endif
+    free(pb->keys);
+    free(pb->raw);
+    free(pb->zbuf);
+    free(pb);
+  }
+}
+
+int ncplayback_seek(ncplayback* pb, uint64_t ns){
+  if(pb->keycount == 0){
+    logerror("recording has no keyframes");
+    return -1;
+  }
+  // last keyframe at or before |ns|, or the first if none precede it
+  unsigned lo = 0;
+  unsigned hi = pb->keycount;
+  while(hi - lo > 1){
+    const unsigned mid = lo + (hi - lo) / 2;
+    if(pb->keys[mid].ns <= ns){
+      lo = mid;
+    }else{
+      hi = mid;
+    }
+  }
+  if(fseeko(pb->fp, pb->keys[lo].offset, SEEK_SET)){
+    return -1;
+  }
+  // a delta can't be applied until the keyframe has been
+  pb->dimy = pb->dimx = 0;
+  return 0;
+}
+
+// read the frame at the current position into pb->raw. returns 1 at the end
+// of the recording.
+static int
+pb_read_frame(ncplayback* pb, uint64_t* ns, size_t* rawlen){
+  const off_t off = ftello(pb->fp);
+  if(off < 0){
+    return -1;
+  }
+  if((uint64_t)off >= pb->end){
+    return 1;
+  }
+  unsigned char b[RECORD_FRAME_HEADER_LEN];
+  if(fread(b, 1, sizeof(b), pb->fp) != sizeof(b)){
+    return 1;
+  }
+  *ns = rec_get(b + 4, 8);
+  *rawlen = rec_get(b + 12, 4);
+  const size_t storedlen = rec_get(b + 16, 4);
+  if(pb_reserve(&pb->raw, &pb->rawsize, *rawlen)){
+    return -1;
+  }
+  if(b[1] == RECORD_CODEC_STORED){
+    if(storedlen != *rawlen || fread(pb->raw, 1, storedlen, pb->fp) != storedlen){
+      logerror("truncated frame at %jd", (intmax_t)off);
+      return -1;
+    }
+    return 0;
+  }
+  if(b[1] != RECORD_CODEC_ZLIB){
+    logerror("unknown codec %u at %jd", b[1], (intmax_t)off);
+    return -1;
+  }
+  if(pb_reserve(&pb->zbuf, &pb->zbufsize, storedlen)){
+    return -1;
+  }
+  if(fread(pb->zbuf, 1, storedlen, pb->fp) != storedlen){
+    logerror("truncated frame at %jd", (intmax_t)off);
+    return -1;
+  }
+#ifdef USE_DEFLATE
+  size_t actual;
+  if(libdeflate_zlib_decompress(pb->dcmp, pb->zbuf, storedlen, pb->raw,
+                                *rawlen, &actual) != LIBDEFLATE_SUCCESS ||
+     actual != *rawlen){
+#else
+  uLongf actual = *rawlen;
+  if(uncompress(pb->raw, &actual, pb->zbuf, storedlen) != Z_OK ||
+     actual != *rawlen){
+#endif
+    logerror("couldn't inflate frame at %jd", (intmax_t)off);
+    return -1;
+  }
+  return 0;
+}
+
+// write one captured cell to |n|. right columns of wide glyphs are skipped
+// (writing the glyph fills them in), and cells without a glyph are written
+// as spaces, which render identically.
+static int
+pb_cell(ncplane* n, unsigned idx, unsigned dimx, uint64_t channels,
+        uint16_t stylemask, unsigned width, const unsigned char* egc,
+        size_t egclen){
+  if(width == 0){
+    return 0;
+  }
+  char gcluster[NCCAPTURE_EGC_MAX + 1];
+  if(egclen > NCCAPTURE_EGC_MAX){
+    logerror("EGC of %zuB at %u", egclen, idx);
+    return -1;
+  }
+  if(egclen){
+    memcpy(gcluster, egc, egclen);
+  }else{
+    gcluster[egclen++] = ' ';
+  }
+  gcluster[egclen] = '\0';
+  nccell c = NCCELL_TRIVIAL_INITIALIZER;
+  if(nccell_load(n, &c, gcluster) < 0){
+    return -1;
+  }
+  c.channels = channels;
+  c.stylemask = stylemask;
+  int ret = ncplane_putc_yx(n, idx / dimx, idx % dimx, &c);
+  nccell_release(n, &c);
+  return ret < 0 ? -1 : 0;
+}
+
+// apply the capture of |len| bytes at |r| to |n|. a delta must follow a
+// capture of the same geometry; |*pdimy|/|*pdimx| are those of the last
+// capture applied (0 if none), and are updated on success. captures might
+// arrive from the network, so the header is checked against both the
+// NCCAPTURE_* bounds and |len| before anything is resized.
+static int
+capture_apply(ncplane* n, const unsigned char* r, size_t len,
+              unsigned* pdimy, unsigned* pdimx){
+  if(len < CAPTURE_HEADER_LEN || memcmp(r, "NCAP", 4)){
+    logerror("invalid capture");
+    return -1;
+  }
+  const bool delta = r[CAPTURE_FLAGS_OFFSET] & 0x1;
+  const unsigned dimy = rec_get(r + 8, 4);
+  const unsigned dimx = rec_get(r + 12, 4);
+  const unsigned count = rec_get(r + 16, 4);
+  const size_t cells = (size_t)dimy * dimx;
+  const size_t reclen = (delta ? 4 : 0) + 13;
+  if(dimy > NCCAPTURE_DIM_MAX || dimx > NCCAPTURE_DIM_MAX ||
+     cells > NCCAPTURE_CELLS_MAX){
+    logerror("invalid capture geometry %ux%u", dimy, dimx);
+    return -1;
+  }
+  // a keyframe has a record for every cell; a delta, at most one per cell
+  if(count > cells || (!delta && count != cells)){
+    logerror("%u records for %ux%u", count, dimy, dimx);
+    return -1;
+  }
+  if(count > (len - CAPTURE_HEADER_LEN) / reclen){
+    logerror("truncated capture");
+    return -1;
+  }
+  if(delta){
+    if(*pdimy != dimy || *pdimx != dimx){
+      logerror("delta without its keyframe");
+      return -1;
+    }
+  }else{
+    unsigned ny, nx;
+    ncplane_dim_yx(n, &ny, &nx);
+    if((ny != dimy || nx != dimx) && ncplane_resize_simple(n, dimy, dimx)){
+      return -1;
+    }
+    ncplane_erase(n);
+  }
+  size_t off = CAPTURE_HEADER_LEN;
+  for(unsigned i = 0 ; i < count ; ++i){
+    if(len - off < reclen){
+      logerror("truncated capture");
+      return -1;
+    }
+    unsigned idx = i;
+    if(delta){
+      idx = rec_get(r + off, 4);
+      off += 4;
+    }
+    const uint64_t channels = rec_get(r + off, 8);
+    const uint16_t stylemask = rec_get(r + off + 8, 2);
+    const unsigned width = r[off + 10];
+    const size_t egclen = rec_get(r + off + 11, 2);
+    off += 13;
+    if(len - off < egclen || idx >= cells){
+      logerror("truncated capture");
+      return -1;
+    }
+    if(pb_cell(n, idx, dimx, channels, stylemask, width, r + off, egclen)){
+      return -1;
+    }
+    off += egclen;
+  }
+  *pdimy = dimy;
+  *pdimx = dimx;
+  return 0;
+}
+
+int ncplane_apply_capture(ncplane* n, const char* buf, size_t len){
+  unsigned dimy, dimx;
+  ncplane_dim_yx(n, &dimy, &dimx);
+  return capture_apply(n, (const unsigned char*)buf, len, &dimy, &dimx);
+}
+
+#define REMOTE_FRAME_HEADER_LEN 13 // u32 length, u8 type, i32 y, i32 x
+
+int ncpile_remote_frame(ncplane* n, bool delta, int cury, int curx,
+                        char** buf, size_t* buflen){
+  char* cap;
+  size_t caplen;
+  if(ncpile_capture(n, delta, &cap, &caplen)){
+    return -1;
+  }
+  if(caplen > UINT32_MAX - (REMOTE_FRAME_HEADER_LEN - 4)){
+    logerror("capture too large (%zuB)", caplen);
+    free(cap);
+    return -1;
+  }
+  char* tmp = realloc(cap, caplen + REMOTE_FRAME_HEADER_LEN);
+  if(tmp == NULL){
+    free(cap);
+    return -1;
+  }
+  memmove(tmp + REMOTE_FRAME_HEADER_LEN, tmp, caplen);
+  unsigned char* hdr = (unsigned char*)tmp;
+  rec_put(hdr, caplen + REMOTE_FRAME_HEADER_LEN - 4, 4);
+  hdr[4] = NCREMOTE_MSG_FRAME;
+  rec_put(hdr + 5, (uint32_t)cury, 4);
+  rec_put(hdr + 9, (uint32_t)curx, 4);
+  *buf = tmp;
+  *buflen = caplen + REMOTE_FRAME_HEADER_LEN;
+  return 0;
+}
+
+#undef REMOTE_FRAME_HEADER_LEN
+
+int ncplayback_next(ncplayback* pb, ncplane* n, uint64_t* ns){
+  uint64_t fns;
+  size_t rawlen;
+  int r = pb_read_frame(pb, &fns, &rawlen);
+  if(r){
+    return r;
+  }
+  if(capture_apply(n, pb->raw, rawlen, &pb->dimy, &pb->dimx)){
+    pb->dimy = pb->dimx = 0;
+    return -1;
+  }
+  if(ns){
+    *ns = fns;
+  }
+  return 0;
+}
+
@@ -113,27 +113,25 @@ typedef enum {
 //    * draw through edge
 
 static int
-draw_borders(ncplane* n, unsigned mask, uint64_t channel, direction_e direction){
+draw_borders(ncplane* n, unsigned mask, const ncboxstyle* bs, direction_e direction){
   unsigned lenx, leny;
   ncplane_dim_yx(n, &leny, &lenx);
   int maxx = lenx - 1;
   int maxy = leny - 1;
-  nccell ul, ur, ll, lr, hl, vl;
-  nccell_init(&ul); nccell_init(&ur); nccell_init(&hl);
-  nccell_init(&ll); nccell_init(&lr); nccell_init(&vl);
-  if(nccells_rounded_box(n, 0, channel, &ul, &ur, &ll, &lr, &hl, &vl)){
-    return -1;
-  }
 //fprintf(stderr, "drawing borders %p ->%d/%d, mask: %04x\n", w, maxx, maxy, mask);
   // lenx is the number of columns we have, but drop 2 due to corners. we thus
   // want lenx - 2 horizontal lines in a top or bottom border.
   int y = 0;
+  int ret = 0;
   if(y < maxy || direction == DIRECTION_DOWN || (mask & NCBOXMASK_BOTTOM)){
     if(!(mask & NCBOXMASK_TOP)){
-      ncplane_home(n);
-      ncplane_putc(n, &ul);
-      ncplane_hline(n, &hl, lenx - 2);
-      ncplane_putc(n, &ur);
+      ret |= ncplane_box_span(n, 0, 0, 1, &bs->ul);
+      if(lenx > 2){
+        ret |= ncplane_box_span(n, 0, 1, lenx - 2, &bs->hl);
+      }
+      if(maxx > 0){
+        ret |= ncplane_box_span(n, 0, maxx, 1, &bs->ur);
+      }
       ++y;
     }
   }
@@ -141,28 +139,26 @@ draw_borders(ncplane* n, unsigned mask, uint64_t channel, direction_e direction)
   // we're left following the previous stanza, end based on maxhorizy.
   const bool candrawbottom = y <= maxy || direction == DIRECTION_UP || (mask & NCBOXMASK_TOP);
   const int maxhorizy = maxy - (candrawbottom && !(mask & NCBOXMASK_BOTTOM));
-  int ret = 0;
   while(y <= maxhorizy){
     if(!(mask & NCBOXMASK_LEFT)){
-      ret |= ncplane_cursor_move_yx(n, y, 0);
-      ncplane_putc(n, &vl);
+      ret |= ncplane_box_span(n, y, 0, 1, &bs->vl);
     }
     if(!(mask & NCBOXMASK_RIGHT)){
-      ret |= ncplane_cursor_move_yx(n, y, maxx);
-      ncplane_putc(n, &vl);
+      ret |= ncplane_box_span(n, y, maxx, 1, &bs->vl);
     }
     ++y;
   }
   if(candrawbottom){
     if(!(mask & NCBOXMASK_BOTTOM)){
-      ret |= ncplane_cursor_move_yx(n, maxy, 0);
-      ncplane_putc(n, &ll);
-      ncplane_hline(n, &hl, lenx - 2);
-      ncplane_putc(n, &lr);
+      ret |= ncplane_box_span(n, maxy, 0, 1, &bs->ll);
+      if(lenx > 2){
+        ret |= ncplane_box_span(n, maxy, 1, lenx - 2, &bs->hl);
+      }
+      if(maxx > 0){
+        ret |= ncplane_box_span(n, maxy, maxx, 1, &bs->lr);
+      }
     }
   }
-  nccell_release(n, &ul); nccell_release(n, &ur); nccell_release(n, &hl);
-  nccell_release(n, &ll); nccell_release(n, &lr); nccell_release(n, &vl);
   return ret;
 }
 
@@ -170,7 +166,7 @@ draw_borders(ncplane* n, unsigned mask, uint64_t channel, direction_e direction)
 // any provided restrictions on visible window size.
 static int
 draw_ncreel_borders(const ncreel* nr){
-  return draw_borders(nr->p, nr->ropts.bordermask, nr->ropts.borderchan,
+  return draw_borders(nr->p, nr->ropts.bordermask, &nr->borderstyle,
                       DIRECTION_UP); // direction shouldn't matter for reel
 }
 
@@ -234,33 +230,111 @@ tablet_geom(const ncreel* nr, nctablet* t, int* begx, int* begy,
   return 0;
 }
 
-// kill the planes associated with |t|
+// move the border plane |p| (and with it the data plane) out of sight
+static int
+ncreel_hide(ncreel* nr, ncplane* p){
+  if(nr->sparepile == NULL){
+    struct ncplane_options nopts = {
+      .rows = 1,
+      .cols = 1,
+      .name = "rspr",
+    };
+    if((nr->sparepile = ncpile_create(ncplane_notcurses(p), &nopts)) == NULL){
+      return -1;
+    }
+  }
+  if(ncplane_reparent_family(p, nr->sparepile) == NULL){
+    return -1;
+  }
+  return 0;
+}
+
+// take back the planes of |t|, which is no longer being displayed. they're
+// parked with the tablet if we're retaining planes, and otherwise recycled.
+// if they can't be hidden away, they're destroyed.
 static void
-nctablet_wipeout(nctablet* t){
-  if(t){
-    if(ncplane_set_widget(t->p, NULL, NULL) == 0){
-      ncplane_destroy_family(t->p);
+nctablet_wipeout(ncreel* nr, nctablet* t){
+  if(t == NULL || t->p == NULL){
+    return;
+  }
+  ncplane* p = t->p;
+  ncplane* cbp = t->cbp;
+  t->p = NULL;
+  t->cbp = NULL;
+  if(ncplane_set_widget(p, NULL, NULL)){
+    return; // we're being torn down along with the plane
+  }
+  const bool retain = nr->ropts.flags & NCREEL_OPTION_RETAINPLANES;
+  if(!retain && nr->sparecount == nr->sparealloc){
+    unsigned alloc = nr->sparealloc ? nr->sparealloc * 2 : 8;
+    ncreel_spare* tmp = realloc(nr->spares, sizeof(*tmp) * alloc);
+    if(tmp == NULL){
+      ncplane_destroy_family(p, 0);
+      return;
     }
-    t->p = NULL;
-    t->cbp = NULL;
+    nr->spares = tmp;
+    nr->sparealloc = alloc;
   }
+  if(ncreel_hide(nr, p)){
+    ncplane_destroy_family(p, 0);
+    return;
+  }
+  if(retain){
+    t->parked = p;
+    t->parkedcb = cbp;
+  }else{
+    nr->spares[nr->sparecount].p = p;
+    nr->spares[nr->sparecount].cbp = cbp;
+    ++nr->sparecount;
+  }
+}
+
+// take the planes for |t| from its parking spot, or failing that the spares,
+// and lay them out according to |nopts|. returns NULL if there are none, or
+// they can't be used. *|retained| is set if the planes were |t|'s own.
+static ncplane*
+nctablet_unpark(ncreel* nr, nctablet* t, const struct ncplane_options* nopts,
+                ncplane** cbp, bool* retained){
+  ncplane* p;
+  *retained = false;
+  if(t->parked){
+    p = t->parked;
+    *cbp = t->parkedcb;
+    t->parked = NULL;
+    t->parkedcb = NULL;
+    *retained = true;
+  }else if(nr->sparecount){
+    --nr->sparecount;
+    p = nr->spares[nr->sparecount].p;
+    *cbp = nr->spares[nr->sparecount].cbp;
+  }else{
+    return NULL;
+  }
+  if(ncplane_reparent_family(p, nr->p) == NULL ||
+     ncplane_resize_simple(p, nopts->rows, nopts->cols) ||
+     ncplane_move_yx(p, nopts->y, nopts->x)){
+    ncplane_destroy_family(p, 0);
+    return NULL;
+  }
+  ncplane_erase(p);
+  return p;
 }
 
-// destroy all existing tablet planes pursuant to redraw
+// take back all existing tablet planes pursuant to redraw
 static void
 clean_reel(ncreel* r){
   nctablet* vft = r->vft;
   if(vft){
     for(nctablet* n = vft->next ; n->p && n != vft ; n = n->next){
 //fprintf(stderr, "CLEANING NEXT: %p (%p)\n", n, n->p);
-      nctablet_wipeout(n);
+      nctablet_wipeout(r, n);
     }
     for(nctablet* n = vft->prev ; n->p && n != vft ; n = n->prev){
 //fprintf(stderr, "CLEANING PREV: %p (%p)\n", n, n->p);
-      nctablet_wipeout(n);
+      nctablet_wipeout(r, n);
     }
 //fprintf(stderr, "CLEANING VFT: %p (%p)\n", vft, vft->p);
-    nctablet_wipeout(vft);
+    nctablet_wipeout(r, vft);
     r->vft = NULL;
   }
 }
@@ -276,9 +350,10 @@ nctablet_delete_internal(struct nctablet* t){
   t->next->prev = t->prev;
   if(t->p){
     if(ncplane_set_widget(t->p, NULL, NULL) == 0){
-      ncplane_destroy_family(t->p);
+      ncplane_destroy_family(t->p, 0);
     }
   }
+  ncplane_destroy_family(t->parked, 0);
   free(t);
 }
 
@@ -310,7 +385,7 @@ int ncreel_del(ncreel* nr, struct nctablet* t){
 // everything beyond the frontiers, or the entire reel for the focused tablet).
 // If the callback uses less space, shrinks the plane to that size.
 static int
-ncreel_draw_tablet(const ncreel* nr, nctablet* t, int frontiertop,
+ncreel_draw_tablet(ncreel* nr, nctablet* t, int frontiertop,
                    int frontierbottom, direction_e direction){
   if(t->p || t->cbp){
 //fprintf(stderr, "already drew %p: %p %p\n", t, t->p, t->cbp);
@@ -329,7 +404,13 @@ ncreel_draw_tablet(const ncreel* nr, nctablet* t, int frontiertop,
     .cols = lenx,
     .name = "tab",
   };
-  ncplane* fp = ncplane_create(nr->p, &nopts);
+  ncplane* spcbp = NULL; // recycled data plane, if any
+  bool retained;
+  ncplane* fp = nctablet_unpark(nr, t, &nopts, &spcbp, &retained);
+  if(fp == NULL){
+    spcbp = NULL;
+    fp = ncplane_create(nr->p, &nopts);
+  }
   if((t->p = fp) == NULL){
 //fprintf(stderr, "failure creating border plane %d %d %d %d\n", leny, lenx, begy, begx);
     return -1;
@@ -349,6 +430,10 @@ ncreel_draw_tablet(const ncreel* nr, nctablet* t, int frontiertop,
     --cblenx;
     ++cbx;
   }
+  if(spcbp && cbleny - cby + 1 <= 0){ // no room for a data plane
+    ncplane_destroy_family(spcbp, 0);
+    spcbp = NULL;
+  }
   if(cbleny - cby + 1 > 0){
 //fprintf(stderr, "cbp placement %dx%d @ %dx%d\n", cbleny, cblenx, cby, cbx);
     struct ncplane_options dnopts = {
@@ -358,7 +443,21 @@ ncreel_draw_tablet(const ncreel* nr, nctablet* t, int frontiertop,
       .cols = cblenx,
       .name = "tdat",
     };
-    t->cbp = ncplane_create(t->p, &dnopts);
+    if(spcbp){
+      if(ncplane_resize_simple(spcbp, cbleny, cblenx) ||
+         ncplane_move_yx(spcbp, cby, cbx)){
+        ncplane_destroy_family(spcbp, 0);
+      }else{
+        if(!retained){
+          ncplane_erase(spcbp);
+        }
+        t->cbp = spcbp;
+      }
+      spcbp = NULL;
+    }
+    if(t->cbp == NULL){
+      t->cbp = ncplane_create(t->p, &dnopts);
+    }
     if(t->cbp == NULL){
 //fprintf(stderr, "failure creating data plane %d %d %d %d\n", cbleny, cblenx, cby, cbx);
       ncplane_destroy(t->p);
@@ -379,7 +478,7 @@ ncreel_draw_tablet(const ncreel* nr, nctablet* t, int frontiertop,
       if(ll){ // must be smaller than the space we provided; add back bottom
         ncplane_resize_simple(t->cbp, ll, cblenx);
       }else{
-        ncplane_destroy_family(t->cbp);
+        ncplane_destroy_family(t->cbp, 0);
         t->cbp = NULL;
       }
       // resize the borderplane iff we got smaller
@@ -412,15 +511,15 @@ ncreel_draw_tablet(const ncreel* nr, nctablet* t, int frontiertop,
   if(leny <= cbleny + !(mask & NCBOXMASK_TOP)){
     mask |= NCBOXMASK_BOTTOM;
   }
-  uint64_t channels = nr->tablets == t ? nr->ropts.focusedchan : nr->ropts.tabletchan;
-  draw_borders(fp, mask, channels, direction);
+  const ncboxstyle* bs = nr->tablets == t ? &nr->focusedstyle : &nr->tabletstyle;
+  draw_borders(fp, mask, bs, direction);
   return 0;
 }
 
 // move down below the focused tablet, filling up the reel to the bottom.
 // returns the last tablet drawn.
 static nctablet*
-draw_following_tablets(const ncreel* nr, nctablet* otherend,
+draw_following_tablets(ncreel* nr, nctablet* otherend,
                        int frontiertop, int* frontierbottom){
   const bool botborder = !(nr->ropts.bordermask & NCBOXMASK_BOTTOM);
 //fprintf(stderr, "following otherend: %p ->p: %p %d/%d\n", otherend, otherend->p, frontiertop, *frontierbottom);
@@ -450,7 +549,7 @@ draw_following_tablets(const ncreel* nr, nctablet* otherend,
 // move up above the focused tablet, filling up the reel to the top.
 // returns the last tablet drawn.
 static nctablet*
-draw_previous_tablets(const ncreel* nr, nctablet* otherend,
+draw_previous_tablets(ncreel* nr, nctablet* otherend,
                       int* frontiertop, int frontierbottom){
   const bool topborder = !(nr->ropts.bordermask & NCBOXMASK_TOP);
   nctablet* upworking = nr->tablets->prev;
@@ -491,24 +590,20 @@ trim_reel_overhang(ncreel* r, nctablet* top, nctablet* bottom){
 //fprintf(stderr, "top: %dx%d @ %d, miny: %d\n", ylen, xlen, y, miny);
   if(boty < miny){
 //fprintf(stderr, "NUKING top!\n");
-    ncplane_destroy_family(top->p);
-    top->p = NULL;
-    top->cbp = NULL;
+    nctablet_wipeout(r, top);
     top = top->next;
     return trim_reel_overhang(r, top, bottom);
   }else if(y < miny){
     int ynew = ylen - (miny - y);
     if(ynew <= 0){
-      ncplane_destroy_family(top->p);
-      top->p = NULL;
-      top->cbp = NULL;
+      nctablet_wipeout(r, top);
     }else{
       if(ncplane_resize(top->p, miny - y, 0, ynew, xlen, 0, 0, ynew, xlen)){
         return -1;
       }
       if(top->cbp){
         if(ynew == !(r->ropts.tabletmask & NCBOXMASK_TOP)){
-          ncplane_destroy_family(top->cbp);
+          ncplane_destroy_family(top->cbp, 0);
           top->cbp = NULL;
         }else{
           ncplane_dim_yx(top->cbp, &ylen, &xlen);
@@ -531,19 +626,13 @@ trim_reel_overhang(ncreel* r, nctablet* top, nctablet* bottom){
   //fprintf(stderr, "bot: %dx%d @ %d, maxy: %d\n", ylen, xlen, y, maxy);
     if(maxy < y){
   //fprintf(stderr, "NUKING bottom!\n");
-      if(ncplane_set_widget(bottom->p, NULL, NULL) == 0){
-        ncplane_destroy_family(bottom->p);
-      }
-      bottom->p = NULL;
-      bottom->cbp = NULL;
+      nctablet_wipeout(r, bottom);
       bottom = bottom->prev;
       return trim_reel_overhang(r, top, bottom);
     }if(maxy < boty){
       int ynew = ylen - (boty - maxy);
       if(ynew <= 0){
-        ncplane_destroy_family(bottom->p);
-        bottom->p = NULL;
-        bottom->cbp = NULL;
+        nctablet_wipeout(r, bottom);
       }else{
         if(ncplane_resize(bottom->p, 0, 0, ynew, xlen, 0, 0, ynew, xlen)){
           return -1;
@@ -551,7 +640,7 @@ trim_reel_overhang(ncreel* r, nctablet* top, nctablet* bottom){
   //fprintf(stderr, "TRIMMED bottom %p from %d to %d (%d)\n", bottom->p, ylen, ynew, maxy - boty);
         if(bottom->cbp){
           if(ynew == !(r->ropts.tabletmask & NCBOXMASK_BOTTOM)){
-            ncplane_destroy_family(bottom->cbp);
+            ncplane_destroy_family(bottom->cbp, 0);
             bottom->cbp = NULL;
           }else{
             ncplane_dim_yx(bottom->cbp, &ylen, &xlen);
@@ -771,7 +860,7 @@ validate_ncreel_opts(ncplane* n, const ncreel_options* ropts){
   if(n == NULL){
     return false;
   }
-  if(ropts->flags >= (NCREEL_OPTION_CIRCULAR << 1u)){
+  if(ropts->flags >= (NCREEL_OPTION_RETAINPLANES << 1u)){
     logwarn("provided unsupported flags 0x%016" PRIx64, ropts->flags);
   }
   if(ropts->flags & NCREEL_OPTION_CIRCULAR){
@@ -822,6 +911,18 @@ ncreel* ncreel_create(ncplane* n, const ncreel_options* ropts){
   memcpy(&nr->ropts, ropts, sizeof(*ropts));
   nr->p = n;
   nr->vft = NULL;
+  nr->sparepile = NULL;
+  nr->spares = NULL;
+  nr->sparecount = nr->sparealloc = 0;
+  const char* boxchars = notcurses_canutf8(ncplane_notcurses(n)) ?
+                         NCBOXROUND : NCBOXASCII;
+  if(ncboxstyle_init(&nr->borderstyle, boxchars, 0, ropts->borderchan) ||
+     ncboxstyle_init(&nr->tabletstyle, boxchars, 0, ropts->tabletchan) ||
+     ncboxstyle_init(&nr->focusedstyle, boxchars, 0, ropts->focusedchan)){
+    ncplane_destroy(nr->p);
+    free(nr);
+    return NULL;
+  }
   if(ncplane_set_widget(nr->p, nr, (void(*)(void*))ncreel_destroy)){
     ncplane_destroy(nr->p);
     free(nr);
@@ -873,6 +974,8 @@ nctablet* ncreel_add(ncreel* nr, nctablet* after, nctablet *before,
   ++nr->tabletcount;
   t->p = NULL;
   t->cbp = NULL;
+  t->parked = NULL;
+  t->parkedcb = NULL;
   ncreel_redraw(nr);
   return t;
 }
@@ -885,7 +988,9 @@ void ncreel_destroy(ncreel* nreel){
         ncreel_del(nreel, t);
       }
       ncplane_destroy(nreel->p);
+      ncplane_destroy_family(nreel->sparepile, 0);
     }
+    free(nreel->spares);
     free(nreel);
   }
 }
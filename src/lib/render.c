@@ -1,23 +1,63 @@
+#include <math.h>
 #include <ctype.h>
 #include <limits.h>
 #include <unistd.h>
 #include "internal.h"
 #include "unixsig.h"
+#include "windows.h"
 
 sig_atomic_t sigcont_seen_for_render = 0;
 
+pthread_mutex_t tiparm_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// an ncrasterizer wraps a private notcurses context, holding only what the
+// raster path needs: its own rstate, lastframe (and egcpool), stats, and a
+// terminal description (either a copy of the context's own, or one shared
+// among rasterizers of the same terminal type). rendering is untouched; the
+// bound pile's crender vector is postpainted against the private lastframe,
+// and rasterized into the private rstate.
+typedef struct ncrasterizer {
+  notcurses view;
+  notcurses* nc;        // the real context
+  ncpile* pile;         // bound pile, NULL once destroyed
+  const tinfo* shared;  // shared terminal description, if one was named
+  unsigned rows, cols;  // pile geometry, or 0 to follow the terminal
+} ncrasterizer;
+
+
 // update for a new visual area of |rows|x|cols|, neither of which may be zero.
 // copies that area of the lastframe (damage map) which is shared between the
 // two. new areas are initialized to empty, just like a new plane. lost areas
-// have their egcpool entries purged.
-static nccell*
+// have their egcpool entries purged. if only the height changed, the rows
+// stay where they are, and we merely realloc().
+static int
 restripe_lastframe(notcurses* nc, unsigned rows, unsigned cols){
   assert(rows);
   assert(cols);
   const size_t size = sizeof(*nc->lastframe) * (rows * cols);
+  if(cols == nc->lfdimx && nc->lastframe){
+    for(unsigned y = rows ; y < nc->lfdimy ; ++y){
+      for(unsigned x = 0 ; x < cols ; ++x){
+        pool_release(&nc->pool, &nc->lastframe[fbcellidx(y, cols, x)]);
+      }
+    }
+    nccell* tmp = realloc(nc->lastframe, size);
+    if(tmp == NULL){
+      return -1;
+    }
+    if(rows > nc->lfdimy){
+      memset(&tmp[cols * nc->lfdimy], 0, sizeof(nccell) * cols * (rows - nc->lfdimy));
+    }
+    nc->lastframe = tmp;
+    nc->lfdimy = rows;
+    if(egcpool_compaction_justified(&nc->pool)){
+      egcpool_compact(nc, &nc->pool, nc->lastframe, rows * cols, NULL);
+    }
+    return 0;
+  }
   nccell* tmp = malloc(size);
   if(tmp == NULL){
-    return NULL;
+    return -1;
   }
   size_t copycols = nc->lfdimx > cols ? cols : nc->lfdimx;
   size_t maxlinecopy = sizeof(nccell) * copycols;
@@ -51,6 +91,9 @@ restripe_lastframe(notcurses* nc, unsigned rows, unsigned cols){
   nc->lastframe = tmp;
   nc->lfdimy = rows;
   nc->lfdimx = cols;
+  if(egcpool_compaction_justified(&nc->pool)){
+    egcpool_compact(nc, &nc->pool, nc->lastframe, rows * cols, NULL);
+  }
   return 0;
 }
 
@@ -73,26 +116,39 @@ notcurses_resize_internal(ncplane* pp, unsigned* restrict rows, unsigned* restri
   unsigned oldcols = pile->dimx;
   *rows = oldrows;
   *cols = oldcols;
-  unsigned cgeo_changed;
-  unsigned pgeo_changed;
-  if(update_term_dimensions(rows, cols, &n->tcache, n->margin_b,
-                            &cgeo_changed, &pgeo_changed)){
-    return -1;
-  }
-  n->stats.s.cell_geo_changes += cgeo_changed;
-  n->stats.s.pixel_geo_changes += pgeo_changed;
-  *rows -= n->margin_t + n->margin_b;
-  if(*rows <= 0){
-    *rows = 1;
-  }
-  *cols -= n->margin_l + n->margin_r;
-  if(*cols <= 0){
-    *cols = 1;
+  const ncrasterizer* rast = pile->rasterizer;
+  if(rast && rast->rows){
+    // the pile is sized to its rasterizer's output, not the terminal
+    *rows = rast->rows;
+    *cols = rast->cols;
+  }else if(rast == NULL && n->tcache.ictx && inputlayer_resize_pending(n->tcache.ictx)){
+    // the terminal is still being resized; stick with what we have until
+    // it settles (see notcurses_set_resize_debounce()).
+    return 0;
+  }else{
+    unsigned cgeo_changed;
+    unsigned pgeo_changed;
+    if(update_term_dimensions(rows, cols, &n->tcache, n->margin_b,
+                              &cgeo_changed, &pgeo_changed)){
+      return -1;
+    }
+    n->stats.s.cell_geo_changes += cgeo_changed;
+    n->stats.s.pixel_geo_changes += pgeo_changed;
+    *rows -= n->margin_t + n->margin_b;
+    if(*rows <= 0){
+      *rows = 1;
+    }
+    *cols -= n->margin_l + n->margin_r;
+    if(*cols <= 0){
+      *cols = 1;
+    }
   }
-  if(*rows != n->lfdimy || *cols != n->lfdimx){
+  // a bound pile has no business with the terminal's lastframe
+  if(rast == NULL && (*rows != n->lfdimy || *cols != n->lfdimx)){
     if(restripe_lastframe(n, *rows, *cols)){
       return -1;
     }
+    pile->dmgall = true;
   }
 //fprintf(stderr, "r: %d or: %d c: %d oc: %d\n", *rows, oldrows, *cols, oldcols);
   if(*rows == oldrows && *cols == oldcols){
@@ -100,6 +156,7 @@ notcurses_resize_internal(ncplane* pp, unsigned* restrict rows, unsigned* restri
   }
   pile->dimy = *rows;
   pile->dimx = *cols;
+  pile->dmgall = true;
   int ret = 0;
 //notcurses_debug(n, stderr);
   // if this pile contains the standard plane, it ought be resized to match
@@ -126,11 +183,21 @@ notcurses_resize(notcurses* n, unsigned* restrict rows, unsigned* restrict cols)
 }
 
 void nccell_release(ncplane* n, nccell* c){
+  // if we can't take our own pool, a pooled EGC is merely forgotten, to be
+  // reclaimed along with the shared pool.
+  if(cell_pooled_p(c) && ncplane_own(n)){
+    c->gcluster = 0;
+    return;
+  }
   pool_release(&n->pool, c);
 }
 
 // Duplicate one cell onto another when they share a plane. Convenience wrapper.
 int nccell_duplicate(ncplane* n, nccell* targ, const nccell* c){
+  // simple and interned EGCs never touch our pool, and needn't take it
+  if((cell_pooled_p(targ) || cell_pooled_p(c) || !n->pool.interns) && ncplane_own(n)){
+    return -1;
+  }
   if(cell_duplicate_far(&n->pool, targ, n, c) < 0){
     logerror("failed duplicating cell");
     return -1;
@@ -162,13 +229,15 @@ highcontrast(const tinfo* ti, uint32_t bchannel){
   return conrgb;
 }
 
-// wants coordinates within the sprixel, not absolute
+// wants coordinates within the sprixel, not absolute. |ridx| is the sprixel's
+// entry in the pile's rsprixels, or RSPRIXIDX_UNKNOWN if it has none.
 // FIXME if plane is not wholly on-screen, probably need to toss plane,
 // at least for this rendering cycle
 static void
 paint_sprixel(ncplane* p, struct crender* rvec, int starty, int startx,
-              int offy, int offx, int dstleny, int dstlenx){
+              int offy, int offx, int dstleny, int dstlenx, unsigned ridx){
   const notcurses* nc = ncplane_notcurses_const(p);
+  ncpile* pile = ncplane_pile(p);
   sprixel* s = p->sprite;
   int dimy = s->dimy;
   int dimx = s->dimx;
@@ -189,7 +258,7 @@ paint_sprixel(ncplane* p, struct crender* rvec, int starty, int startx,
       }
       sprixcell_e state = sprixel_state(s, absy, absx);
       struct crender* crender = &rvec[fbcellidx(absy, dstlenx, absx)];
-//fprintf(stderr, "presprixel: %p preid: %d state: %d\n", rvec->sprixel, rvec->sprixel ? rvec->sprixel->id : 0, s->invalidated);
+//fprintf(stderr, "presprixel: %u state: %d\n", crender->s.sprixeled, s->invalidated);
       // if we already have a glyph solved (meaning said glyph is above this
       // sprixel), and we run into a bitmap cell, we need to null that cell out
       // of the bitmap.
@@ -203,10 +272,13 @@ paint_sprixel(ncplane* p, struct crender* rvec, int starty, int startx,
         crender->s.p_beats_sprixel = 1;
       }else if(!crender->p && !crender->s.bgblends){
         // if we are a bitmap, and above a cell that has changed (and
-        // will thus be printed), we'll need redraw the sprixel.
-        if(crender->sprixel == NULL){
-          crender->sprixel = s;
+        // will thus be printed), we'll need redraw the sprixel. the topmost
+        // sprixel over a cell is recorded in the pile's index (see
+        // crender_sprixel()).
+        if(!crender->s.sprixeled && rvec == pile->crender && pile->rsprixidx){
+          pile->rsprixidx[fbcellidx(absy, dstlenx, absx)] = ridx;
         }
+        crender->s.sprixeled = 1;
         if(state == SPRIXCELL_ANNIHILATED || state == SPRIXCELL_ANNIHILATED_TRANS){
 //fprintf(stderr, "REBUILDING AT %d/%d\n", y, x);
           sprite_rebuild(nc, s, y, x);
@@ -217,6 +289,197 @@ paint_sprixel(ncplane* p, struct crender* rvec, int starty, int startx,
   }
 }
 
+// blending a plane's channel into a cell's (see channels_blend()) averages
+// each RGB component with those of the |n| channels already blended in:
+// (c1 * n + c2) / (n + 1). across a row of some translucent plane, those
+// averages are queued up, and computed several components at a time. each
+// division is replaced with a multiplication by a 24-bit reciprocal of
+// n + 1, rounded up, and a shift; for dividends of at most 255 * (n + 1) and
+// n of at most 255 (the blend counts are 8 bits wide), this is exact, and
+// the product fits in 32 bits. a queued channel is otherwise fully set, but
+// for zeroed RGB, until its average is ORed in by blendq_flush().
+#define BLENDQ_CHANNELS 32
+
+// blendrecip[n] is ceil(2^24 / (n + 1))
+static const uint32_t blendrecip[256] = {
+  0x1000000, 0x800000, 0x555556, 0x400000, 0x333334, 0x2aaaab,
+  0x24924a, 0x200000, 0x1c71c8, 0x19999a, 0x1745d2, 0x155556,
+  0x13b13c, 0x124925, 0x111112, 0x100000, 0x0f0f10, 0x0e38e4,
+  0x0d7944, 0x0ccccd, 0x0c30c4, 0x0ba2e9, 0x0b2165, 0x0aaaab,
+  0x0a3d71, 0x09d89e, 0x097b43, 0x092493, 0x08d3dd, 0x088889,
+  0x084211, 0x080000, 0x07c1f1, 0x078788, 0x075076, 0x071c72,
+  0x06eb3f, 0x06bca2, 0x06906a, 0x066667, 0x063e71, 0x061862,
+  0x05f418, 0x05d175, 0x05b05c, 0x0590b3, 0x057263, 0x055556,
+  0x053979, 0x051eb9, 0x050506, 0x04ec4f, 0x04d488, 0x04bda2,
+  0x04a791, 0x04924a, 0x047dc2, 0x0469ef, 0x0456c8, 0x044445,
+  0x04325d, 0x042109, 0x041042, 0x040000, 0x03f040, 0x03e0f9,
+  0x03d227, 0x03c3c4, 0x03b5cd, 0x03a83b, 0x039b0b, 0x038e39,
+  0x0381c1, 0x0375a0, 0x0369d1, 0x035e51, 0x03531e, 0x034835,
+  0x033d92, 0x033334, 0x032917, 0x031f39, 0x031598, 0x030c31,
+  0x030304, 0x02fa0c, 0x02f14a, 0x02e8bb, 0x02e05d, 0x02d82e,
+  0x02d02e, 0x02c85a, 0x02c0b1, 0x02b932, 0x02b1db, 0x02aaab,
+  0x02a3a1, 0x029cbd, 0x0295fb, 0x028f5d, 0x0288e0, 0x028283,
+  0x027c46, 0x027628, 0x027028, 0x026a44, 0x02647d, 0x025ed1,
+  0x025940, 0x0253c9, 0x024e6b, 0x024925, 0x0243f7, 0x023ee1,
+  0x0239e1, 0x0234f8, 0x023024, 0x022b64, 0x0226ba, 0x022223,
+  0x021d9f, 0x02192f, 0x0214d1, 0x021085, 0x020c4a, 0x020821,
+  0x020409, 0x020000, 0x01fc08, 0x01f820, 0x01f447, 0x01f07d,
+  0x01ecc1, 0x01e914, 0x01e574, 0x01e1e2, 0x01de5e, 0x01dae7,
+  0x01d77c, 0x01d41e, 0x01d0cc, 0x01cd86, 0x01ca4c, 0x01c71d,
+  0x01c3f9, 0x01c0e1, 0x01bdd3, 0x01bad0, 0x01b7d7, 0x01b4e9,
+  0x01b204, 0x01af29, 0x01ac58, 0x01a98f, 0x01a6d1, 0x01a41b,
+  0x01a16e, 0x019ec9, 0x019c2e, 0x01999a, 0x01970f, 0x01948c,
+  0x019210, 0x018f9d, 0x018d31, 0x018acc, 0x01886f, 0x018619,
+  0x0183ca, 0x018182, 0x017f41, 0x017d06, 0x017ad3, 0x0178a5,
+  0x01767e, 0x01745e, 0x017243, 0x01702f, 0x016e20, 0x016c17,
+  0x016a14, 0x016817, 0x01661f, 0x01642d, 0x016240, 0x016059,
+  0x015e76, 0x015c99, 0x015ac1, 0x0158ee, 0x01571f, 0x015556,
+  0x015391, 0x0151d1, 0x015016, 0x014e5f, 0x014cac, 0x014afe,
+  0x014954, 0x0147af, 0x01460d, 0x014470, 0x0142d7, 0x014142,
+  0x013fb1, 0x013e23, 0x013c9a, 0x013b14, 0x013992, 0x013814,
+  0x013699, 0x013522, 0x0133af, 0x01323f, 0x0130d2, 0x012f69,
+  0x012e03, 0x012ca0, 0x012b41, 0x0129e5, 0x01288c, 0x012736,
+  0x0125e3, 0x012493, 0x012346, 0x0121fc, 0x0120b5, 0x011f71,
+  0x011e2f, 0x011cf1, 0x011bb5, 0x011a7c, 0x011946, 0x011812,
+  0x0116e1, 0x0115b2, 0x011486, 0x01135d, 0x011236, 0x011112,
+  0x010ff0, 0x010ed0, 0x010db3, 0x010c98, 0x010b7f, 0x010a69,
+  0x010954, 0x010843, 0x010733, 0x010625, 0x01051a, 0x010411,
+  0x01030a, 0x010205, 0x010102, 0x010000,
+};
+
+typedef struct blendq {
+  unsigned count;                       // queued channels
+  uint64_t* chans[BLENDQ_CHANNELS];     // channels into which we OR the result
+  unsigned shifts[BLENDQ_CHANNELS];     // 32 for a foreground, 0 for background
+  // one lane per component: r, g, and b of each queued channel
+  uint32_t c1[BLENDQ_CHANNELS * 3];     // existing component, then the result
+  uint32_t c2[BLENDQ_CHANNELS * 3];     // component being blended in
+  uint32_t n[BLENDQ_CHANNELS * 3];      // channels blended in before this one
+  uint32_t m[BLENDQ_CHANNELS * 3];      // blendrecip[n]
+} blendq;
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BLENDQ_NEON
+
+static unsigned
+blendq_lanes_simd(blendq* bq, unsigned lanes){
+  unsigned l = 0;
+  for( ; l + 4 <= lanes ; l += 4){
+    uint32x4_t x = vmlaq_u32(vld1q_u32(bq->c2 + l), vld1q_u32(bq->c1 + l),
+                             vld1q_u32(bq->n + l));
+    x = vshrq_n_u32(vmulq_u32(x, vld1q_u32(bq->m + l)), 24);
+    vst1q_u32(bq->c1 + l, x);
+  }
+  return l;
+}
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <smmintrin.h>
+#define BLENDQ_SSE41
+
+__attribute__ ((target ("sse4.1"))) static unsigned
+blendq_lanes_simd(blendq* bq, unsigned lanes){
+  unsigned l = 0;
+  for( ; l + 4 <= lanes ; l += 4){
+    __m128i x = _mm_mullo_epi32(_mm_loadu_si128((const __m128i*)(bq->c1 + l)),
+                                _mm_loadu_si128((const __m128i*)(bq->n + l)));
+    x = _mm_add_epi32(x, _mm_loadu_si128((const __m128i*)(bq->c2 + l)));
+    x = _mm_mullo_epi32(x, _mm_loadu_si128((const __m128i*)(bq->m + l)));
+    _mm_storeu_si128((__m128i*)(bq->c1 + l), _mm_srli_epi32(x, 24));
+  }
+  return l;
+}
+
+static inline bool
+blendq_sse41_p(void){
+#ifdef __SSE4_1__
+  return true;
+#else
+  return __builtin_cpu_supports("sse4.1");
+#endif
+}
+#endif
+
+static void
+blendq_flush(blendq* bq){
+  const unsigned lanes = bq->count * 3;
+  unsigned l = 0;
+#if defined(BLENDQ_NEON)
+  l = blendq_lanes_simd(bq, lanes);
+#elif defined(BLENDQ_SSE41)
+  if(blendq_sse41_p()){
+    l = blendq_lanes_simd(bq, lanes);
+  }
+#endif
+  for( ; l < lanes ; ++l){
+    bq->c1[l] = ((bq->c1[l] * bq->n[l] + bq->c2[l]) * bq->m[l]) >> 24;
+  }
+  for(unsigned i = 0 ; i < bq->count ; ++i){
+    const uint64_t rgb = (bq->c1[i * 3] << 16u) | (bq->c1[i * 3 + 1] << 8u) | bq->c1[i * 3 + 2];
+    *bq->chans[i] |= rgb << bq->shifts[i];
+  }
+  bq->count = 0;
+}
+
+// the RGB components of |chan|, resolving default and palette-indexed colors
+static inline void
+blend_components(const notcurses* nc, uint32_t chan, uint32_t defchan, uint32_t* rgb){
+  unsigned r, g, b;
+  if(ncchannel_default_p(chan)){
+    ncchannel_rgb8(defchan, &r, &g, &b);
+  }else if(ncchannel_palindex_p(chan)){
+    ncchannel_rgb8(nc->palette.chans[ncchannel_palindex(chan)], &r, &g, &b);
+  }else{
+    ncchannel_rgb8(chan, &r, &g, &b);
+  }
+  rgb[0] = r;
+  rgb[1] = g;
+  rgb[2] = b;
+}
+
+// blend |chan| into the foreground (|fg|) or background of |c| precisely as
+// cell_blend_fchannel()/cell_blend_bchannel() would, but queue any averaging
+// on |bq|. the cases which don't average are handled by channels_blend().
+static void
+cell_blend_queued(notcurses* nc, blendq* bq, nccell* c, bool fg,
+                  uint32_t chan, unsigned* blends){
+  const uint32_t defchan = fg ? nc->tcache.fg_default : nc->tcache.bg_collides_default;
+  uint32_t c1 = fg ? cell_fchannel(c) : cell_bchannel(c);
+  if(*blends == 0 || ncchannel_alpha(chan) == NCALPHA_TRANSPARENT ||
+     (ncchannel_default_p(c1) && ncchannel_default_p(chan)) ||
+     ((ncchannel_palindex_p(c1) & ncchannel_palindex_p(chan)) &&
+      ncchannel_palindex(c1) == ncchannel_palindex(chan))){
+    c1 = channels_blend(nc, c1, chan, blends, defchan);
+  }else{
+    if(bq->count == BLENDQ_CHANNELS){
+      blendq_flush(bq);
+    }
+    const unsigned i = bq->count++;
+    blend_components(nc, c1, defchan, bq->c1 + i * 3);
+    blend_components(nc, chan, defchan, bq->c2 + i * 3);
+    for(unsigned l = i * 3 ; l < i * 3 + 3 ; ++l){
+      bq->n[l] = *blends;
+      bq->m[l] = blendrecip[*blends];
+    }
+    bq->chans[i] = &c->channels;
+    bq->shifts[i] = fg ? 32 : 0;
+    ncchannel_set_rgb8(&c1, 0, 0, 0);
+    ncchannel_set_alpha(&c1, ncchannel_alpha(chan));
+    ++*blends;
+  }
+  if(fg){
+    cell_set_fchannel(c, c1);
+  }else{
+    cell_set_bchannel(c, c1);
+  }
+}
+
+static inline bool
+crender_solved_p(const struct crender* crender){
+  return crender->p && nccell_fg_alpha(&crender->c) == NCALPHA_OPAQUE &&
+         nccell_bg_alpha(&crender->c) == NCALPHA_OPAQUE;
+}
+
 // Paints a single ncplane 'p' into the provided scratch framebuffer 'fb' (we
 // can't always write directly into lastframe, because we need build state to
 // solve certain cells, and need compare their solved result to the last frame).
@@ -225,17 +488,27 @@ paint_sprixel(ncplane* p, struct crender* rvec, int starty, int startx,
 //  dstlenx: lenx of target rendering area described by rvec
 //  dstabsy: absy of target rendering area (relative to terminal)
 //  dstabsx: absx of target rendering area (relative to terminal)
+//  bandbeg: first row of the target rendering area to be painted
+//  bandend: one past the last row of the target rendering area to be painted
+//  unsolved: per-row counts of cells not yet fully solved, or NULL
 //
-// only those cells where 'p' intersects with the target rendering area are
-// rendered.
+// only those cells where 'p' intersects with the target rendering area (and
+// the band [bandbeg, bandend) therein) are rendered. text painting of one row
+// never touches another, so disjoint bands can be painted concurrently.
+// sprixels ignore the band, and must always be painted in full.
 //
 // the sprixelstack orders sprixels of the plane (so we needn't keep them
 // ordered between renders). each time we meet a sprixel, extract it from
 // the pile's sprixel list, and update the sprixelstack.
+//
+// a cell with a glyph and opaque foreground and background is fully solved;
+// nothing below can affect it. if |unsolved| is provided, rows which have
+// been fully solved by higher planes are skipped outright, so planes covered
+// by opaque planes above them cost only a check per row.
 __attribute__ ((nonnull (1, 2, 7))) static void
 paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
       int dstabsy, int dstabsx, sprixel** sprixelstack,
-      unsigned pgeo_changed){
+      int bandbeg, int bandend, unsigned* unsolved){
   unsigned y, x, dimy, dimx;
   int offy, offx;
   ncplane_dim_yx(p, &dimy, &dimx);
@@ -256,13 +529,36 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
   }
   // if we're a sprixel, we must not register ourselves as the active
   // glyph, but we *do* need to null out any cellregions that we've
-  // scribbled upon.
+  // scribbled upon. kitty placeholder graphics are the exception: the
+  // terminal draws them from glyphs in our cells, which are painted like
+  // any others (after the sprixel bookkeeping), and need no wipes.
   if(p->sprite){
-    if(pgeo_changed){
+    const bool placeholder = ncplane_notcurses_const(p)->tcache.pixel_implementation
+                             == NCPIXEL_KITTY_PLACEHOLDER;
+    // sprixels are rescaled to a new cell-pixel geometry lazily, once they're
+    // to be seen; those offscreen or being hidden can wait (perhaps forever).
+    // placeholder graphics are scaled by the terminal to fit their cells.
+    ncpile* pile = ncplane_pile(p);
+    if((p->sprite->cellpxy != pile->cellpxy || p->sprite->cellpxx != pile->cellpxx) &&
+       !placeholder && p->sprite->invalidated != SPRIXEL_HIDE &&
+       offy < dstleny && offy + (int)dimy > 0 && offx < dstlenx && offx + (int)dimx > 0){
       // do what on failure? FIXME
-      sprixel_rescale(p->sprite, ncplane_pile(p)->cellpxy, ncplane_pile(p)->cellpxx);
+      sprixel_rescale(p->sprite, pile->cellpxy, pile->cellpxx);
+    }
+    // sprixels are painted in order from the top, by the calling thread.
+    // those painted into the pile's own crender vector are appended to its
+    // table, and only those entries are indexed by paint_sprixel().
+    unsigned ridx = RSPRIXIDX_UNKNOWN;
+    if(rvec == pile->crender && p->sprite->invalidated != SPRIXEL_HIDE &&
+       pile->rsprixelslen < pile->rsprixelscap){
+      if(pile->rsprixelslen < RSPRIXIDX_UNKNOWN){
+        ridx = pile->rsprixelslen;
+      }
+      pile->rsprixels[pile->rsprixelslen++] = p->sprite;
+    }
+    if(!placeholder){
+      paint_sprixel(p, rvec, starty, startx, offy, offx, dstleny, dstlenx, ridx);
     }
-    paint_sprixel(p, rvec, starty, startx, offy, offx, dstleny, dstlenx);
     // decouple from the pile's sixel list
     if(p->sprite->next){
       p->sprite->next->prev = p->sprite->prev;
@@ -279,14 +575,31 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
     p->sprite->next = *sprixelstack;
     p->sprite->prev = NULL;
     *sprixelstack = p->sprite;
-    return;
+    if(!placeholder){
+      return;
+    }
   }
+  // skip content above our band
+  if((int)starty + offy < bandbeg){
+    starty = bandbeg - offy;
+  }
+  if(bandend < dstleny){
+    dstleny = bandend;
+  }
+  notcurses* nc = ncplane_notcurses(p);
+  blendq bq;
+  bq.count = 0;
   for(y = starty ; y < dimy ; ++y){
     const int absy = y + offy;
-    // once we've passed the physical screen's bottom, we're done
+    // once we've passed the physical screen's (or band's) bottom, we're done
     if(absy >= dstleny || absy < 0){
       break;
     }
+    if(unsolved && unsolved[absy] == 0){
+      continue;
+    }
+    // the row we're displaying, which might come from scrollback history
+    const nccell* prow = ncplane_visible_row(p, y);
     for(x = startx ; x < dimx ; ++x){ // iteration for each cell
       const int absx = x + offx;
       if(absx >= dstlenx || absx < 0){
@@ -295,12 +608,12 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
       struct crender* crender = &rvec[fbcellidx(absy, dstlenx, absx)];
 //fprintf(stderr, "p: %p damaged: %u %d/%d\n", p, crender->s.damaged, y, x);
       nccell* targc = &crender->c;
-      if(nccell_wide_right_p(targc)){
+      if(nccell_wide_right_p(targc) || crender_solved_p(crender)){
         continue;
       }
 
       if(nccell_fg_alpha(targc) > NCALPHA_OPAQUE){
-        const nccell* vis = &p->fb[nfbcellidx(p, y, x)];
+        const nccell* vis = &prow[x];
         if(nccell_fg_default_p(vis)){
           vis = &p->basecell;
         }
@@ -310,7 +623,7 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
           crender->hcfg = cell_fchannel(targc);
         }
         unsigned fgblends = crender->s.fgblends;
-        cell_blend_fchannel(ncplane_notcurses(p), targc, cell_fchannel(vis), &fgblends);
+        cell_blend_queued(nc, &bq, targc, true, cell_fchannel(vis), &fgblends);
         crender->s.fgblends = fgblends;
         // crender->highcontrast can only be true if we just set it, since we're
         // about to set targc opaque based on crender->highcontrast (and this
@@ -326,7 +639,7 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
       // background channel and balpha.
       // Evaluate the background first, in case we have HIGHCONTRAST fg text.
       if(nccell_bg_alpha(targc) > NCALPHA_OPAQUE){
-        const nccell* vis = &p->fb[nfbcellidx(p, y, x)];
+        const nccell* vis = &prow[x];
         // to be on the blitter stacking path, we need
         //  1) crender->s.blittedquads to be non-zero (we're below semigraphics)
         //  2) cell_blittedquadrants(vis) to be non-zero (we're semigraphics)
@@ -336,14 +649,14 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
             vis = &p->basecell;
           }
           unsigned bgblends = crender->s.bgblends;
-          cell_blend_bchannel(ncplane_notcurses(p), targc, cell_bchannel(vis), &bgblends);
+          cell_blend_queued(nc, &bq, targc, false, cell_bchannel(vis), &bgblends);
           crender->s.bgblends = bgblends;
         }else{ // use the local foreground; we're stacking blittings
           if(nccell_fg_default_p(vis)){
             vis = &p->basecell;
           }
           unsigned bgblends = crender->s.bgblends;
-          cell_blend_bchannel(ncplane_notcurses(p), targc, cell_fchannel(vis), &bgblends);
+          cell_blend_queued(nc, &bq, targc, false, cell_fchannel(vis), &bgblends);
           crender->s.bgblends = bgblends;
           crender->s.blittedquads = 0;
         }
@@ -357,14 +670,15 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
       // still use a character we find here, but its color will come entirely
       // from cells underneath us.
       if(!crender->p){
-        const nccell* vis = &p->fb[nfbcellidx(p, y, x)];
+        const nccell* vis = &prow[x];
         if(vis->gcluster == 0 && !nccell_double_wide_p(vis)){
           vis = &p->basecell;
         }
         // if the following is true, we're a real glyph, and not the right-hand
         // side of a wide glyph (nor the null codepoint).
         if( (targc->gcluster = vis->gcluster) ){ // index copy only
-          if(crender->sprixel && crender->sprixel->invalidated == SPRIXEL_HIDE){
+          const sprixel* s = crender_sprixel(ncplane_pile_const(p), crender, absy, absx);
+          if(s && s->invalidated == SPRIXEL_HIDE){
 //fprintf(stderr, "damaged due to hide %d/%d\n", y, x);
             crender->s.damaged = 1;
           }
@@ -395,8 +709,12 @@ paint(ncplane* p, struct crender* rvec, int dstleny, int dstlenx,
           targc->width = 0;
         }
       }
+      if(unsolved && crender_solved_p(crender)){
+        --unsolved[absy];
+      }
     }
   }
+  blendq_flush(&bq);
 }
 
 // it's not a pure memset(), because NCALPHA_OPAQUE is the zero value, and
@@ -446,14 +764,16 @@ lock_in_highcontrast(notcurses* nc, const tinfo* ti, nccell* targc, struct crend
 // 'lastframe' for any cells which are damaged.
 static inline void
 postpaint_cell(notcurses* nc, const tinfo* ti, nccell* lastframe, unsigned dimx,
-               struct crender* crender, egcpool* pool, unsigned y, unsigned* x){
+               struct crender* crender, const ncpile* p, egcpool* pool,
+               unsigned y, unsigned* x){
   nccell* targc = &crender->c;
   lock_in_highcontrast(nc, ti, targc, crender);
   nccell* prevcell = &lastframe[fbcellidx(y, dimx, *x)];
   if(cellcmp_and_dupfar(pool, prevcell, crender->p, targc) > 0){
 //fprintf(stderr, "damaging due to cmp [%s] %d %d\n", nccell_extended_gcluster(crender->p, &crender->c), y, *x);
-    if(crender->sprixel){
-      sprixcell_e state = sprixel_state(crender->sprixel, y, *x);
+    const sprixel* s = crender_sprixel(p, crender, y, *x);
+    if(s){
+      sprixcell_e state = sprixel_state(s, y, *x);
 //fprintf(stderr, "state under candidate sprixel: %d %d/%d\n", state, y, *x);
       // we don't need to change it when under an opaque cell, because
       // that's always printed on top.
@@ -488,9 +808,11 @@ postpaint_cell(notcurses* nc, const tinfo* ti, nccell* lastframe, unsigned dimx,
 }
 
 
-// iterate over the rendered frame, adjusting the foreground colors for any
-// cells marked NCALPHA_HIGHCONTRAST, and clearing any cell covered by a
-// wide glyph to its left.
+// iterate over columns [begx, endx) of rows [begy, endy) of the rendered
+// frame, adjusting the foreground colors for any cells marked
+// NCALPHA_HIGHCONTRAST, and clearing any cell covered by a wide glyph to its
+// left. if |spans| is not NULL, the span of damaged columns in each row is
+// written to it.
 //
 // FIXME this cannot be performed at render time (we don't yet know the
 //       lastframe, and thus can't compute damage), but we *could* unite it
@@ -499,16 +821,58 @@ postpaint_cell(notcurses* nc, const tinfo* ti, nccell* lastframe, unsigned dimx,
 //       paint()? tried this before and didn't get a win...
 static void
 postpaint(notcurses* nc, const tinfo* ti, nccell* lastframe,
-          unsigned dimy, unsigned dimx, struct crender* rvec, egcpool* pool){
-//fprintf(stderr, "POSTPAINT BEGINS! %zu %p %d/%d\n", sizeof(*rvec), rvec, dimy, dimx);
-  for(unsigned y = 0 ; y < dimy ; ++y){
-    for(unsigned x = 0 ; x < dimx ; ++x){
+          unsigned begy, unsigned endy, unsigned begx, unsigned endx,
+          unsigned dimx, struct crender* rvec, const ncpile* p,
+          egcpool* pool, struct dmgspan* spans){
+//fprintf(stderr, "POSTPAINT BEGINS! %zu %p %d-%d/%d\n", sizeof(*rvec), rvec, begy, endy, dimx);
+  for(unsigned y = begy ; y < endy ; ++y){
+    for(unsigned x = begx ; x < endx ; ++x){
       struct crender* crender = &rvec[fbcellidx(y, dimx, x)];
-      postpaint_cell(nc, ti, lastframe, dimx, crender, pool, y, &x);
+      // the right half of a wide glyph begun left of the region
+      if(x == begx && nccell_wide_right_p(&crender->c)){
+        continue;
+      }
+      const unsigned startx = x;
+      postpaint_cell(nc, ti, lastframe, dimx, crender, p, pool, y, &x);
+      // a damaged multicolumn glyph always damages its leftmost column
+      if(spans && crender->s.damaged){
+        if(spans[y].beg >= spans[y].end){
+          spans[y].beg = startx;
+        }
+        spans[y].end = x + 1;
+      }
     }
   }
 }
 
+// mergedowns are painted in row bands across the render engine, so long as
+// each thread gets at least this many rows.
+#define MIN_MERGE_ROWS 8
+
+struct mergejob {
+  ncplane* src;
+  ncplane* dst;
+  struct crender* rvec;
+};
+
+// initialize and paint one band of a mergedown's rows. each band clears only
+// its own rows of the rvec, so no serial pass over the whole vector is needed.
+static void
+merge_band(void* vjob, unsigned band, unsigned bands){
+  const struct mergejob* job = vjob;
+  const ncplane* dst = job->dst;
+  const unsigned bandbeg = dst->leny * band / bands;
+  const unsigned bandend = dst->leny * (band + 1) / bands;
+  init_rvec(job->rvec + bandbeg * dst->lenx, (bandend - bandbeg) * dst->lenx);
+  sprixel* s = NULL;
+  paint(job->src, job->rvec, dst->leny, dst->lenx, dst->absy, dst->absx, &s,
+        bandbeg, bandend, NULL);
+  assert(NULL == s);
+  paint(job->dst, job->rvec, dst->leny, dst->lenx, dst->absy, dst->absx, &s,
+        bandbeg, bandend, NULL);
+  assert(NULL == s);
+}
+
 // merging one plane down onto another is basically just performing a render
 // using only these two planes, with the result written to the lower plane.
 int ncplane_mergedown(ncplane* restrict src, ncplane* restrict dst,
@@ -579,6 +943,9 @@ int ncplane_mergedown(ncplane* restrict src, ncplane* restrict dst,
     logerror("can't merge sprixel planes");
     return -1;
   }
+  if(ncplane_own(dst)){
+    return -1;
+  }
   const int totalcells = dst->leny * dst->lenx;
   nccell* rendfb = calloc(sizeof(*rendfb), totalcells);
   const size_t crenderlen = sizeof(struct crender) * totalcells;
@@ -589,22 +956,38 @@ int ncplane_mergedown(ncplane* restrict src, ncplane* restrict dst,
     free(rvec);
     return -1;
   }
-  init_rvec(rvec, totalcells);
-  sprixel* s = NULL;
-  paint(src, rvec, dst->leny, dst->lenx, dst->absy, dst->absx, &s, 0);
-  assert(NULL == s);
-  paint(dst, rvec, dst->leny, dst->lenx, dst->absy, dst->absx, &s, 0);
-  assert(NULL == s);
+  struct mergejob job = {
+    .src = src,
+    .dst = dst,
+    .rvec = rvec,
+  };
+  struct render_engine* re = ncplane_notcurses(dst)->rengine;
+  const unsigned threads = render_engine_threads(re);
+  unsigned bands = 1;
+  if(threads > 1 && dst->leny >= threads * MIN_MERGE_ROWS){
+    bands = threads;
+  }
+  int64_t bandmaxns = 0;
+  uint64_t bandns = 0;
+  if(bands == 1 || render_engine_run(re, bands, merge_band, &job, &bandmaxns, &bandns)){
+    merge_band(&job, 0, 1);
+  }
 //fprintf(stderr, "Postpaint start (%dx%d)\n", dst->leny, dst->lenx);
   const struct tinfo* ti = &ncplane_notcurses_const(dst)->tcache;
-  postpaint(ncplane_notcurses(dst), ti, rendfb, dst->leny, dst->lenx, rvec, &dst->pool);
+  postpaint(ncplane_notcurses(dst), ti, rendfb, 0, dst->leny, 0, dst->lenx,
+            dst->lenx, rvec, NULL, &dst->pool, NULL);
 //fprintf(stderr, "Postpaint done (%dx%d)\n", dst->leny, dst->lenx);
   free(dst->fb);
   dst->fb = rendfb;
+  dst->capy = dst->leny;
+  dst->logrow = 0;
+  ncplane_damage(dst);
   free(rvec);
   return 0;
 }
 
+#undef MIN_MERGE_ROWS
+
 int ncplane_mergedown_simple(ncplane* restrict src, ncplane* restrict dst){
   return ncplane_mergedown(src, dst, 0, 0, 0, 0, 0, 0);
 }
@@ -648,24 +1031,47 @@ term_setstyles(fbuf* f, notcurses* nc, const nccell* c){
   return ret;
 }
 
-// u8->str lookup table used in term_esc_rgb below
-static const char* const NUMBERS[] = {
-"0;", "1;", "2;", "3;", "4;", "5;", "6;", "7;", "8;", "9;", "10;", "11;", "12;", "13;", "14;", "15;", "16;",
-"17;", "18;", "19;", "20;", "21;", "22;", "23;", "24;", "25;", "26;", "27;", "28;", "29;", "30;", "31;", "32;",
-"33;", "34;", "35;", "36;", "37;", "38;", "39;", "40;", "41;", "42;", "43;", "44;", "45;", "46;", "47;", "48;",
-"49;", "50;", "51;", "52;", "53;", "54;", "55;", "56;", "57;", "58;", "59;", "60;", "61;", "62;", "63;", "64;",
-"65;", "66;", "67;", "68;", "69;", "70;", "71;", "72;", "73;", "74;", "75;", "76;", "77;", "78;", "79;", "80;",
-"81;", "82;", "83;", "84;", "85;", "86;", "87;", "88;", "89;", "90;", "91;", "92;", "93;", "94;", "95;", "96;",
-"97;", "98;", "99;", "100;", "101;", "102;", "103;", "104;", "105;", "106;", "107;", "108;", "109;", "110;", "111;", "112;",
-"113;", "114;", "115;", "116;", "117;", "118;", "119;", "120;", "121;", "122;", "123;", "124;", "125;", "126;", "127;", "128;",
-"129;", "130;", "131;", "132;", "133;", "134;", "135;", "136;", "137;", "138;", "139;", "140;", "141;", "142;", "143;", "144;",
-"145;", "146;", "147;", "148;", "149;", "150;", "151;", "152;", "153;", "154;", "155;", "156;", "157;", "158;", "159;", "160;",
-"161;", "162;", "163;", "164;", "165;", "166;", "167;", "168;", "169;", "170;", "171;", "172;", "173;", "174;", "175;", "176;",
-"177;", "178;", "179;", "180;", "181;", "182;", "183;", "184;", "185;", "186;", "187;", "188;", "189;", "190;", "191;", "192;",
-"193;", "194;", "195;", "196;", "197;", "198;", "199;", "200;", "201;", "202;", "203;", "204;", "205;", "206;", "207;", "208;",
-"209;", "210;", "211;", "212;", "213;", "214;", "215;", "216;", "217;", "218;", "219;", "220;", "221;", "222;", "223;", "224;",
-"225;", "226;", "227;", "228;", "229;", "230;", "231;", "232;", "233;", "234;", "235;", "236;", "237;", "238;", "239;", "240;",
-"241;", "242;", "243;", "244;", "245;", "246;", "247;", "248;", "249;", "250;", "251;", "252;", "253;", "254;", "255;", };
+// u8->str lookup table used in term_esc_rgb below. each entry is padded to
+// four bytes, so that it can be copied with a single fixed-size memcpy().
+static const char DECIMALS[256][4] = {
+ "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12", "13", "14", "15",
+ "16", "17", "18", "19", "20", "21", "22", "23", "24", "25", "26", "27", "28", "29", "30", "31",
+ "32", "33", "34", "35", "36", "37", "38", "39", "40", "41", "42", "43", "44", "45", "46", "47",
+ "48", "49", "50", "51", "52", "53", "54", "55", "56", "57", "58", "59", "60", "61", "62", "63",
+ "64", "65", "66", "67", "68", "69", "70", "71", "72", "73", "74", "75", "76", "77", "78", "79",
+ "80", "81", "82", "83", "84", "85", "86", "87", "88", "89", "90", "91", "92", "93", "94", "95",
+ "96", "97", "98", "99", "100", "101", "102", "103", "104", "105", "106", "107", "108", "109", "110", "111",
+ "112", "113", "114", "115", "116", "117", "118", "119", "120", "121", "122", "123", "124", "125", "126", "127",
+ "128", "129", "130", "131", "132", "133", "134", "135", "136", "137", "138", "139", "140", "141", "142", "143",
+ "144", "145", "146", "147", "148", "149", "150", "151", "152", "153", "154", "155", "156", "157", "158", "159",
+ "160", "161", "162", "163", "164", "165", "166", "167", "168", "169", "170", "171", "172", "173", "174", "175",
+ "176", "177", "178", "179", "180", "181", "182", "183", "184", "185", "186", "187", "188", "189", "190", "191",
+ "192", "193", "194", "195", "196", "197", "198", "199", "200", "201", "202", "203", "204", "205", "206", "207",
+ "208", "209", "210", "211", "212", "213", "214", "215", "216", "217", "218", "219", "220", "221", "222", "223",
+ "224", "225", "226", "227", "228", "229", "230", "231", "232", "233", "234", "235", "236", "237", "238", "239",
+ "240", "241", "242", "243", "244", "245", "246", "247", "248", "249", "250", "251", "252", "253", "254", "255",
+};
+
+// copy the decimal form of |v| (0..255) to |s|, which must have room for
+// four bytes. returns the position following the last digit.
+static inline char*
+put_u8(char* s, unsigned v){
+  memcpy(s, DECIMALS[v], 4);
+  return s + (v >= 100 ? 3 : v >= 10 ? 2 : 1);
+}
+
+// write "[34]8;2;R;G;B" to |s|, which must have room for 17 bytes.
+static inline char*
+put_rgb_params(char* s, bool foreground, unsigned r, unsigned g, unsigned b){
+  // we'd like to use the proper ITU T.416 colon syntax i.e. "8:2::", but it is
+  // not supported by several terminal emulators :/.
+  memcpy(s, foreground ? "38;2;" : "48;2;", 5);
+  s = put_u8(s + 5, r);
+  *s++ = ';';
+  s = put_u8(s, g);
+  *s++ = ';';
+  return put_u8(s, b);
+}
 
 static inline int
 term_esc_rgb(fbuf* f, bool foreground, unsigned r, unsigned g, unsigned b){
@@ -673,38 +1079,54 @@ term_esc_rgb(fbuf* f, bool foreground, unsigned r, unsigned g, unsigned b){
   // as of terminfo 6.1.20191019) both emits ~3% more bytes for a run of 'rgb'
   // and gives rise to some inaccurate colors (possibly due to special handling
   // of values < 256; I'm not at this time sure). So we just cons up our own.
-  /*if(esc == 4){
-    return fbuf_emit(f, "setab", tiparm(nc->setab, (int)((r << 16u) | (g << 8u) | b)));
-  }else if(esc == 3){
-    return fbuf_emit(f, "setaf", tiparm(nc->setaf, (int)((r << 16u) | (g << 8u) | b)));
-  }else{
+  // fprintf() was sitting atop our profiles, so we put the effort into a fast
+  // solution here: the escape is assembled in place from the lookup table.
+  if(fbuf_grow(f, 24)){ // "\e[38;2;255;255;255m" plus put_u8() overrun
     return -1;
-  }*/
-  #define RGBESC1 "\x1b" "["
-  // we'd like to use the proper ITU T.416 colon syntax i.e. "8:2::", but it is
-  // not supported by several terminal emulators :/.
-  #define RGBESC2 "8;2;"
-  // fprintf() was sitting atop our profiles, so we put the effort into a fast solution
-  // here. assemble a buffer using constants and a lookup table.
-  fbuf_putn(f, RGBESC1, strlen(RGBESC1));
-  fbuf_putc(f, foreground ? '3' : '4');
-  fbuf_putn(f, RGBESC2, strlen(RGBESC2));
-  const char* s = NUMBERS[r];
-  while(*s){
-    fbuf_putc(f, *s++);
-  }
-  s = NUMBERS[g];
-  while(*s){
-    fbuf_putc(f, *s++);
-  }
-  s = NUMBERS[b];
-  while(*s != ';'){
-    fbuf_putc(f, *s++);
-  }
-  fbuf_putc(f, 'm');
+  }
+  char* s = f->buf + f->used;
+  *s++ = '\x1b';
+  *s++ = '[';
+  s = put_rgb_params(s, foreground, r, g, b);
+  *s++ = 'm';
+  f->used = s - f->buf;
+  return 0;
+}
+
+// set both foreground and background in a single SGR. only for use with
+// caps.rgb, where we cons up our own escapes anyway.
+static inline int
+term_esc_rgb2(fbuf* f, unsigned r, unsigned g, unsigned b,
+              unsigned br, unsigned bg, unsigned bb){
+  if(fbuf_grow(f, 40)){ // two sets of parameters plus put_u8() overrun
+    return -1;
+  }
+  char* s = f->buf + f->used;
+  *s++ = '\x1b';
+  *s++ = '[';
+  s = put_rgb_params(s, true, r, g, b);
+  *s++ = ';';
+  s = put_rgb_params(s, false, br, bg, bb);
+  *s++ = 'm';
+  f->used = s - f->buf;
   return 0;
 }
 
+// the human eye has fewer blue cones than red or green. if the background
+// would collide with the terminal's default background, toggle the last bit
+// in the blue component to avoid a collision.
+static inline unsigned
+bg_uncollide(const tinfo* ti, unsigned r, unsigned g, unsigned b){
+  if((ti->bg_collides_default & 0xff000000) == 0x01000000){
+    if((r == ncchannel_r(ti->bg_collides_default)) &&
+       (g == ncchannel_g(ti->bg_collides_default)) &&
+       (b == ncchannel_b(ti->bg_collides_default))){
+      b ^= 0x00000001;
+    }
+  }
+  return b;
+}
+
 static inline int
 term_bg_rgb8(const tinfo* ti, fbuf* f, unsigned r, unsigned g, unsigned b){
   // We typically want to use tputs() and tiperm() to acquire and write the
@@ -713,28 +1135,16 @@ term_bg_rgb8(const tinfo* ti, fbuf* f, unsigned r, unsigned g, unsigned b){
   // we're also in that case working with hopefully more robust terminals.
   // If it doesn't work, eh, it doesn't work. Fuck the world; save yourself.
   if(ti->caps.rgb){
-    if((ti->bg_collides_default & 0xff000000) == 0x01000000){
-      if((r == ncchannel_r(ti->bg_collides_default)) &&
-         (g == ncchannel_g(ti->bg_collides_default)) &&
-         (b == ncchannel_b(ti->bg_collides_default))){
-        // the human eye has fewer blue cones than red or green. toggle
-        // the last bit in the blue component to avoid a collision.
-        b ^= 0x00000001;
-      }
-    }
-    return term_esc_rgb(f, false, r, g, b);
+    return term_esc_rgb(f, false, r, g, bg_uncollide(ti, r, g, b));
   }else{
-    const char* setab = get_escape(ti, ESCAPE_SETAB);
-    if(setab){
-      // For 256-color indexed mode, start constructing a palette based off
-      // the inputs *if we can change the palette*. If more than 256 are used on
-      // a single screen, start... combining close ones? For 8-color mode, simple
-      // interpolation. I have no idea what to do for 88 colors. FIXME
-      if(ti->caps.colors >= 256){
-        return fbuf_emit(f, tiparm(setab, rgb_quantize_256(r, g, b)));
-      }else if(ti->caps.colors >= 8){
-        return fbuf_emit(f, tiparm(setab, rgb_quantize_8(r, g, b)));
-      }
+    // For 256-color indexed mode, quantize onto the xterm cube (see
+    // NCOPTION_ADAPTIVE_PALETTE for programming the palette instead). For
+    // 8-color mode, simple interpolation. I have no idea what to do for 88
+    // colors. FIXME
+    if(ti->caps.colors >= 256){
+      return term_emit_palindex(ti, f, true, rgb_quantize_256(r, g, b));
+    }else if(ti->caps.colors >= 8){
+      return term_emit_palindex(ti, f, true, rgb_quantize_8(r, g, b));
     }
   }
   return 0;
@@ -749,17 +1159,14 @@ int term_fg_rgb8(const tinfo* ti, fbuf* f, unsigned r, unsigned g, unsigned b){
   if(ti->caps.rgb){
     return term_esc_rgb(f, true, r, g, b);
   }else{
-    const char* setaf = get_escape(ti, ESCAPE_SETAF);
-    if(setaf){
-      // For 256-color indexed mode, start constructing a palette based off
-      // the inputs *if we can change the palette*. If more than 256 are used on
-      // a single screen, start... combining close ones? For 8-color mode, simple
-      // interpolation. I have no idea what to do for 88 colors. FIXME
-      if(ti->caps.colors >= 256){
-        return fbuf_emit(f, tiparm(setaf, rgb_quantize_256(r, g, b)));
-      }else if(ti->caps.colors >= 8){
-        return fbuf_emit(f, tiparm(setaf, rgb_quantize_8(r, g, b)));
-      }
+    // For 256-color indexed mode, quantize onto the xterm cube (see
+    // NCOPTION_ADAPTIVE_PALETTE for programming the palette instead). For
+    // 8-color mode, simple interpolation. I have no idea what to do for 88
+    // colors. FIXME
+    if(ti->caps.colors >= 256){
+      return term_emit_palindex(ti, f, false, rgb_quantize_256(r, g, b));
+    }else if(ti->caps.colors >= 8){
+      return term_emit_palindex(ti, f, false, rgb_quantize_8(r, g, b));
     }
   }
   return 0;
@@ -779,7 +1186,7 @@ update_palette(notcurses* nc, fbuf* f){
         r = r * 1000 / 255;
         g = g * 1000 / 255;
         b = b * 1000 / 255;
-        if(fbuf_emit(f, tiparm(initc, damageidx, r, g, b)) < 0){
+        if(fbuf_emit_parm(f, initc, damageidx, r, g, b) < 0){
           return -1;
         }
         nc->palette_damage[damageidx] = false;
@@ -833,6 +1240,78 @@ raster_defaults(notcurses* nc, bool fgdef, bool bgdef, fbuf* f){
   return 0;
 }
 
+// NCOPTION_ADAPTIVE_PALETTE: rather than quantizing onto the fixed xterm
+// cube, program palette entries 16..255 with the colors actually in use, as
+// they're first seen. the palette entry is written to 'f' immediately, ahead
+// of the SGR which uses it. once all are taken, we use the nearest entry.
+static inline bool
+adaptive_palette_p(const notcurses* nc){
+  return (nc->flags & NCOPTION_ADAPTIVE_PALETTE) && !nc->tcache.caps.rgb &&
+         nc->tcache.caps.can_change_colors && nc->tcache.caps.colors >= 256;
+}
+
+// returns the palette index to use for r/g/b, or -1 on error.
+static int
+adaptive_palindex(notcurses* nc, fbuf* f, unsigned r, unsigned g, unsigned b){
+  tinfo* ti = &nc->tcache;
+  if(ti->rgbmap == NULL){
+    if((ti->rgbmap = calloc(1u << 15u, sizeof(*ti->rgbmap))) == NULL){
+      return -1;
+    }
+    ti->palnext = 16;
+  }
+  const unsigned key = ((r >> 3u) << 10u) | ((g >> 3u) << 5u) | (b >> 3u);
+  if(ti->rgbmap[key]){
+    return ti->rgbmap[key];
+  }
+  if(ti->palnext < NCPALETTESIZE){
+    const char* initc = get_escape(ti, ESCAPE_INITC);
+    if(initc == NULL){
+      return rgb_quantize_256(r, g, b);
+    }
+    const unsigned idx = ti->palnext++;
+    if(fbuf_emit_parm(f, initc, idx, r * 1000 / 255, g * 1000 / 255, b * 1000 / 255) < 0){
+      return -1;
+    }
+    ncchannel_set_rgb8(&nc->palette.chans[idx], r, g, b);
+    nc->touched_palette = true;
+    return ti->rgbmap[key] = idx;
+  }
+  unsigned best = 16;
+  unsigned bestdist = UINT_MAX;
+  for(unsigned idx = 16 ; idx < NCPALETTESIZE ; ++idx){
+    unsigned pr, pg, pb;
+    ncchannel_rgb8(nc->palette.chans[idx], &pr, &pg, &pb);
+    const int dr = (int)pr - (int)r;
+    const int dg = (int)pg - (int)g;
+    const int db = (int)pb - (int)b;
+    const unsigned dist = dr * dr + dg * dg + db * db;
+    if(dist < bestdist){
+      bestdist = dist;
+      best = idx;
+    }
+  }
+  return ti->rgbmap[key] = best;
+}
+
+static inline int
+raster_fg_rgb8(notcurses* nc, fbuf* f, unsigned r, unsigned g, unsigned b){
+  if(adaptive_palette_p(nc)){
+    int idx = adaptive_palindex(nc, f, r, g, b);
+    return idx < 0 ? -1 : term_emit_palindex(&nc->tcache, f, false, idx);
+  }
+  return term_fg_rgb8(&nc->tcache, f, r, g, b);
+}
+
+static inline int
+raster_bg_rgb8(notcurses* nc, fbuf* f, unsigned r, unsigned g, unsigned b){
+  if(adaptive_palette_p(nc)){
+    int idx = adaptive_palindex(nc, f, r, g, b);
+    return idx < 0 ? -1 : term_emit_palindex(&nc->tcache, f, true, idx);
+  }
+  return term_bg_rgb8(&nc->tcache, f, r, g, b);
+}
+
 // these are unlikely, so we leave it uninlined
 static int
 emit_fg_palindex(notcurses* nc, fbuf* f, const nccell* srccell){
@@ -865,7 +1344,7 @@ emit_bg_palindex(notcurses* nc, fbuf* f, const nccell* srccell){
     ++nc->stats.s.bgemissions;
     nc->rstate.bgpalelidable = true;
   }
-  nc->rstate.lastr = palbg;
+  nc->rstate.lastbr = palbg;
   nc->rstate.bgdefelidable = false;
   nc->rstate.bgelidable = false;
   return 0;
@@ -883,19 +1362,78 @@ emit_bg_palindex(notcurses* nc, fbuf* f, const nccell* srccell){
 // by the end of this pass, all sixels are *complete*. all kitty graphics
 // are loaded, but old kitty graphics remain visible, and new/updated kitty
 // graphics are not yet visible, and they have not moved.
+//
+// this is the only sprixel pass which visits every sprixel. those left with
+// work to do are queued in p->sprixwork for the later passes, so quiescent
+// sprixels cost nothing further.
+static int
+sprixwork_reserve(ncpile* p, unsigned count){
+  if(count <= p->sprixworkcap){
+    return 0;
+  }
+  unsigned cap = p->sprixworkcap ? p->sprixworkcap * 2 : 16;
+  while(cap < count){
+    cap *= 2;
+  }
+  sprixel** tmp = realloc(p->sprixwork, sizeof(*tmp) * cap);
+  if(tmp == NULL){
+    logerror("couldn't queue %u sprixels", count);
+    return -1;
+  }
+  p->sprixwork = tmp;
+  p->sprixworkcap = cap;
+  return 0;
+}
+
+static int
+sprixwork_cmp(const void* va, const void* vb){
+  const sprixel* a = *(sprixel* const*)va;
+  const sprixel* b = *(sprixel* const*)vb;
+  return a->rasteridx < b->rasteridx ? -1 : a->rasteridx > b->rasteridx;
+}
+
+// forget |s|, about to be freed, as a sprixel painted by the last render.
+// its entry is emptied rather than removed, as rsprixidx refers to the
+// entries by index.
+static void
+rsprixels_drop(ncpile* p, const sprixel* s){
+  for(unsigned i = 0 ; i < p->rsprixelslen ; ++i){
+    if(p->rsprixels[i] == s){
+      p->rsprixels[i] = NULL;
+      return;
+    }
+  }
+}
+
 static int64_t
 clean_sprixels(notcurses* nc, ncpile* p, fbuf* f, int scrolls){
   sprixel* s;
   sprixel** parent = &p->sprixelcache;
   int64_t bytesemitted = 0;
+  unsigned count = 0;
+  p->sprixworklen = 0;
+  // switching piles leaves the last pile's graphics on the screen. kitty can
+  // delete just their placements, keeping the image data resident in the
+  // terminal, so that a graphic whose pile returns is reshown with nothing
+  // but a fresh placement (pixel_commit). other protocols redraw from the
+  // glyphs we've kept, without reencoding.
+  const bool switched = p != nc->last_pile;
+  if(switched && nc->rstate.sprixelsplaced && nc->tcache.pixel_hide_all){
+    if(nc->tcache.pixel_hide_all(f) < 0){
+      return -1;
+    }
+  }
+  nc->rstate.sprixelsplaced = p->sprixelcache != NULL;
   while( (s = *parent) ){
     loginfo("phase 1 sprixel %u state %d loc %d/%d", s->id,
             s->invalidated, s->n ? s->n->absy : -1, s->n ? s->n->absx : -1);
-    if(s->invalidated == SPRIXEL_QUIESCENT){
-      if(p != nc->last_pile){
-        s->invalidated = SPRIXEL_UNSEEN;
-      }
-    }else if(s->invalidated == SPRIXEL_HIDE){
+    s->rasteridx = count;
+    s->queued = false;
+    if(switched && (s->invalidated == SPRIXEL_QUIESCENT ||
+                    s->invalidated == SPRIXEL_MOVED)){
+      s->invalidated = nc->tcache.pixel_commit ? SPRIXEL_LOADED : SPRIXEL_UNSEEN;
+    }
+    if(s->invalidated == SPRIXEL_HIDE){
 //fprintf(stderr, "OUGHT HIDE %d [%dx%d] %p\n", s->id, s->dimy, s->dimx, s);
       int r = sprite_scrub(nc, p, s);
       if(r < 0){
@@ -904,6 +1442,7 @@ clean_sprixels(notcurses* nc, ncpile* p, fbuf* f, int scrolls){
         if( (*parent = s->next) ){
           s->next->prev = s->prev;
         }
+        rsprixels_drop(p, s);
         sprixel_free(s);
         // need to avoid the rest of the iteration, as s is dead
         continue; // don't account as an elision
@@ -916,18 +1455,26 @@ clean_sprixels(notcurses* nc, ncpile* p, fbuf* f, int scrolls){
              s->invalidated == SPRIXEL_INVALIDATED){
 //fprintf(stderr, "1 MOVING BITMAP %d STATE %d AT %d/%d for %p\n", s->id, s->invalidated, y + nc->margin_t, x + nc->margin_l, s->n);
       if(s->invalidated == SPRIXEL_MOVED){
-        if(p != nc->last_pile){
-          s->invalidated = SPRIXEL_UNSEEN;
-        }else{
-          if(s->n->absx == s->movedfromx){
-            if(s->movedfromy - s->n->absy == scrolls){
-              s->invalidated = SPRIXEL_INVALIDATED;
-              continue;
-            }
-          }
+        // kitty and sixel graphics scroll along with the text. if we moved
+        // by exactly the terminal's scroll, the scroll carries us into place.
+        // unless our content changed as well, there's nothing to draw; if it
+        // did, kitty's wipes and rebuilds are edits of the resident image,
+        // and only they are emitted. fbcon scrolls graphics itself.
+        if(s->n->absx == s->movedfromx && s->movedfromy - s->n->absy == scrolls &&
+           scrolls && !nc->tcache.pixel_scroll){
+          s->invalidated = s->movedinvalid ? SPRIXEL_INVALIDATED : SPRIXEL_QUIESCENT;
+          continue;
+        }
+        if(s->n->absx == s->movedfromx && s->movedfromy - s->n->absy == scrolls){
+          s->invalidated = SPRIXEL_INVALIDATED;
+          continue;
+        }
+        // kitty moves by placement alone, which wouldn't draw changed content
+        if(s->movedinvalid && nc->tcache.pixel_move){
+          s->invalidated = SPRIXEL_INVALIDATED;
+          continue;
         }
       }
-      // otherwise it's a new pile, so we couldn't have been on-screen
       int r = sprite_redraw(nc, p, s, f, nc->margin_t, nc->margin_l);
       if(r < 0){
         return -1;
@@ -937,79 +1484,177 @@ clean_sprixels(notcurses* nc, ncpile* p, fbuf* f, int scrolls){
     }else{
       ++nc->stats.s.sprixelelisions;
     }
+    if(s->invalidated != SPRIXEL_QUIESCENT){
+      if(p->sprixworklen == p->sprixworkcap && sprixwork_reserve(p, count + 1)){
+        return -1;
+      }
+      ncpile_queue_sprixel(p, s);
+    }
+    ++count;
     parent = &s->next;
 //fprintf(stderr, "SPRIXEL STATE: %d\n", s->invalidated);
   }
+  // glyph rasterization can invalidate quiescent sprixels, which join the
+  // queue; make sure there's room for all of them.
+  if(sprixwork_reserve(p, count)){
+    return -1;
+  }
   return bytesemitted;
 }
 
-// scroll the lastframe data |rows| up, to reflect scrolling reality.
+// scroll the |height| lastframe rows beginning with |top| up by |rows|, to
+// reflect scrolling reality. the vacated rows at the bottom are zeroed.
 // FIXME we could virtualize this as we do for scrolling planes; this
 // method involves a lot of unnecessary copying.
 static void
-scroll_lastframe(notcurses* nc, unsigned rows){
+scroll_lastframe_region(notcurses* nc, unsigned top, unsigned height,
+                        unsigned rows){
   // the top |rows| rows need be released (though not more than the actual
   // number of rows!)
-  if(rows > nc->lfdimy){
-    rows = nc->lfdimy;
+  if(rows > height){
+    rows = height;
   }
+  nccell* base = &nc->lastframe[top * nc->lfdimx];
   for(unsigned targy = 0 ; targy < rows ; ++targy){
     for(unsigned targx = 0 ; targx < nc->lfdimx ; ++targx){
-      const size_t damageidx = targy * nc->lfdimx + targx;
-      nccell* c = &nc->lastframe[damageidx];
-      pool_release(&nc->pool, c);
+      pool_release(&nc->pool, &base[targy * nc->lfdimx + targx]);
     }
   }
-  // now for all rows subsequent, up through lfdimy - rows, move them back.
+  // now for all rows subsequent, up through height - rows, move them back.
   // if we scrolled all rows, we will not move anything (and we just
   // released everything).
-  for(unsigned targy = 0 ; targy < nc->lfdimy - rows ; ++targy){
-    const size_t dstidx = targy * nc->lfdimx;
-    nccell* dst = &nc->lastframe[dstidx];
-    const size_t srcidx = dstidx + rows * nc->lfdimx;
-    const nccell* src = &nc->lastframe[srcidx];
-    memcpy(dst, src, sizeof(*dst) * nc->lfdimx);
-  }
+  memmove(base, base + rows * nc->lfdimx,
+          sizeof(*base) * (height - rows) * nc->lfdimx);
   // now for the last |rows| rows, initialize them to 0.
-  unsigned targy = nc->lfdimy - rows;
-  while(targy < nc->lfdimy){
-    const size_t dstidx = targy * nc->lfdimx;
-    nccell* dst = &nc->lastframe[dstidx];
-    memset(dst, 0, sizeof(*dst) * nc->lfdimx);
-    ++targy;
+  memset(base + (height - rows) * nc->lfdimx, 0,
+         sizeof(*base) * rows * nc->lfdimx);
+}
+
+static void
+scroll_lastframe(notcurses* nc, unsigned rows){
+  if(rows && nc->lastframe){
+    scroll_lastframe_region(nc, 0, nc->lfdimy, rows);
+  }
+}
+
+// if a single plane other than the standard plane has scrolled since the last
+// render, and it spans the width of the terminal, we can have the terminal
+// scroll its rows with a scrolling region (DECSTBM), rather than redrawing
+// them. the lastframe's rows are shifted to match, so that only the newly
+// exposed material is damaged. planes above it (other than its own bound
+// planes, which largely scroll along with it) would be dragged along, and
+// then have to be redrawn; we don't bother in that case.
+static void
+plan_region_scroll(notcurses* nc, ncpile* p){
+  ncplane* n = p->scrollplane;
+  const int r = p->planescrolls;
+  p->scrollplane = NULL;
+  p->planescrolls = 0;
+  // a previous plan which hasn't yet been rasterized takes precedence
+  if(n == NULL || r <= 0 || p->rgnscrolls){
+    return;
+  }
+  if(p->scrolls || p->sprixelcache || nc->lastframe == NULL || nc->last_pile != p){
+    return;
+  }
+  if(get_escape(&nc->tcache, ESCAPE_CSR) == NULL){
+    return;
+  }
+  if(nc->margin_l || nc->margin_r || p->dimx != nc->lfdimx || p->dimy != nc->lfdimy){
+    return;
+  }
+  int absy, absx;
+  ncplane_abs_yx(n, &absy, &absx);
+  if(absx > 0 || absx + (int)ncplane_dim_x(n) < (int)p->dimx){
+    return;
   }
+  const int top = absy < 0 ? 0 : absy;
+  int bottom = absy + (int)ncplane_dim_y(n); // exclusive
+  if(bottom > (int)p->dimy){
+    bottom = p->dimy;
+  }
+  if(bottom - top <= r){ // nothing would survive the scroll
+    return;
+  }
+  for(const ncplane* a = n->above ; a ; a = a->above){
+    if(!ncplane_descendant_p(a, n) && ncplanes_intersect_p(a, n)){
+      return;
+    }
+  }
+  scroll_lastframe_region(nc, top, bottom - top, r);
+  p->rgntop = top;
+  p->rgnrows = bottom - top;
+  p->rgnscrolls = r;
+  logdebug("scrolling rows %d-%d by %d", top, bottom - 1, r);
+}
+
+// emit the scroll planned by plan_region_scroll(). this must precede any
+// glyphs, as they were damaged against the scrolled lastframe.
+static int
+rasterize_region_scrolls(notcurses* nc, ncpile* p, fbuf* f){
+  if(p->rgnscrolls == 0){
+    return 0;
+  }
+  const char* csr = get_escape(&nc->tcache, ESCAPE_CSR);
+  const int top = p->rgntop + nc->margin_t;
+  const int bottom = top + p->rgnrows - 1;
+  if(fbuf_emit_parm(f, csr, top, bottom, 0, 0) < 0){
+    return -1;
+  }
+  // setting the scrolling region homes the cursor
+  nc->rstate.y = -1;
+  nc->rstate.x = -1;
+  if(goto_location(nc, f, bottom, 0, NULL)){
+    return -1;
+  }
+  // see rasterize_scrolls() regarding bce
+  if(nc->tcache.bce){
+    if(raster_defaults(nc, false, true, f)){
+      return -1;
+    }
+  }
+  if(emit_scrolls(&nc->tcache, p->rgnscrolls, f)){
+    return -1;
+  }
+  if(fbuf_emit_parm(f, csr, 0, nc->tcache.dimy - 1, 0, 0) < 0){
+    return -1;
+  }
+  nc->rstate.y = -1;
+  nc->rstate.x = -1;
+  p->rgnscrolls = 0;
+  return 0;
 }
 
 // "%d tardies to work off, by far the most in the class!\n", p->scrolls
 static int
-rasterize_scrolls(const ncpile* p, fbuf* f){
+rasterize_scrolls(notcurses* nc, const ncpile* p, fbuf* f){
   int scrolls = p->scrolls;
   if(scrolls == 0){
     return 0;
   }
   logdebug("order-%d scroll", scrolls);
-  /*if(p->nc->rstate.logendy >= 0){
-    p->nc->rstate.logendy -= scrolls;
-    if(p->nc->rstate.logendy < 0){
-      p->nc->rstate.logendy = 0;
-      p->nc->rstate.logendx = 0;
+  /*if(nc->rstate.logendy >= 0){
+    nc->rstate.logendy -= scrolls;
+    if(nc->rstate.logendy < 0){
+      nc->rstate.logendy = 0;
+      nc->rstate.logendx = 0;
     }
   }*/
   // FIXME probably need this to take place at the end of cycle...
-  if(p->nc->tcache.pixel_scroll){
-    p->nc->tcache.pixel_scroll(p, &p->nc->tcache, scrolls);
+  if(nc->tcache.pixel_scroll){
+    nc->tcache.pixel_scroll(p, &nc->tcache, scrolls);
   }
-  if(goto_location(p->nc, f, p->dimy, 0, NULL)){
+  if(goto_location(nc, f, p->dimy, 0, NULL)){
     return -1;
   }
   // terminals advertising 'bce' will scroll in the current background color;
   // switch back to the default explicitly.
-  if(p->nc->tcache.bce){
-    if(raster_defaults(p->nc, false, true, f)){
+  if(nc->tcache.bce){
+    if(raster_defaults(nc, false, true, f)){
       return -1;
     }
   }
-  return emit_scrolls_track(p->nc, scrolls, f);
+  return emit_scrolls_track(nc, scrolls, f);
 }
 
 // second sprixel pass in rasterization. by this time, all sixels are handled
@@ -1021,16 +1666,26 @@ rasterize_scrolls(const ncpile* p, fbuf* f){
 // 3) then, make allo LOADED sprixels visible
 //
 // don't account for sprixelemissions here, as they were already counted.
+// only the sprixels queued by clean_sprixels() (and glyph rasterization) are
+// visited; sprixels invalidated by the latter are put back into list order.
 static int64_t
 rasterize_sprixels(notcurses* nc, ncpile* p, fbuf* f){
   int64_t bytesemitted = 0;
-  sprixel* s;
-  sprixel** parent = &p->sprixelcache;
-  while( (s = *parent) ){
+  if(p->sprixworklen == 0){
+    return 0;
+  }
+  qsort(p->sprixwork, p->sprixworklen, sizeof(*p->sprixwork), sprixwork_cmp);
+  for(unsigned i = 0 ; i < p->sprixworklen ; ++i){
+    sprixel* s = p->sprixwork[i];
 //fprintf(stderr, "raster YARR HARR HARR SPIRXLE %u STATE %d\n", s->id, s->invalidated);
     if(s->invalidated == SPRIXEL_INVALIDATED){
 //fprintf(stderr, "3 DRAWING BITMAP %d STATE %d AT %d/%d for %p\n", s->id, s->invalidated, nc->margin_t, nc->margin_l, s->n);
+      const uint64_t proft = prof_clock(nc);
       int r = sprite_draw(&nc->tcache, p, s, f, nc->margin_t, nc->margin_l);
+      if(proft){
+        s->n->prof_sprixel_ns += prof_clock(nc) - proft;
+        ++s->n->prof_sprixels;
+      }
       if(r < 0){
         return -1;
       }else if(r > 0){
@@ -1057,14 +1712,19 @@ rasterize_sprixels(notcurses* nc, ncpile* p, fbuf* f){
         if(nc->tcache.pixel_remove(s->id, f) < 0){
           return -1;
         }
-        if( (*parent = s->next) ){
+        if(s->prev){
+          s->prev->next = s->next;
+        }else{
+          p->sprixelcache = s->next;
+        }
+        if(s->next){
           s->next->prev = s->prev;
         }
+        rsprixels_drop(p, s);
         sprixel_free(s);
-        continue;
+        p->sprixwork[i] = NULL;
       }
     }
-    parent = &s->next;
   }
   return bytesemitted;
 }
@@ -1078,10 +1738,13 @@ rasterize_sprixels_post(notcurses* nc, ncpile* p){
     return 0;
   }
   int64_t bytesemitted = 0;
-  sprixel* s;
-  sprixel** parent = &p->sprixelcache;
-  while( (s = *parent) ){
-//fprintf(stderr, "YARR HARR HARR SPIRXLE %u STATE %d\n", s->id, s->invalidated);
+  bool drew = false;
+  for(unsigned i = 0 ; i < p->sprixworklen ; ++i){
+    sprixel* s = p->sprixwork[i];
+//fprintf(stderr, "YARR HARR HARR SPIRXLE %u STATE %d\n", s ? s->id : 0, s ? s->invalidated : 0);
+    if(s == NULL){ // destroyed by rasterize_sprixels()
+      continue;
+    }
     if(s->invalidated == SPRIXEL_INVALIDATED || s->invalidated == SPRIXEL_UNSEEN){
       int offy, offx;
       ncplane_abs_yx(s->n, &offy, &offx);
@@ -1091,36 +1754,324 @@ rasterize_sprixels_post(notcurses* nc, ncpile* p){
         return -1;
       }
       bytesemitted += r;
+      drew = true;
+    }
+  }
+  if(drew && nc->tcache.pixel_flush){
+    if(nc->tcache.pixel_flush(&nc->tcache) < 0){
+      return -1;
     }
-    parent = &s->next;
   }
   return bytesemitted;
 }
 
-// Producing the frame requires three steps:
-//  * render -- build up a flat framebuffer from a set of ncplanes
-//  * rasterize -- build up a UTF-8/ASCII stream of escapes and EGCs
-//  * refresh -- write the stream to the emulator
+// REP repeats the preceding graphic character, which we can only trust
+// terminals to get right for a single narrow codepoint. returns the length of
+// the inline glyph of |c| if it is such a codepoint, and 0 otherwise.
+static inline unsigned
+rep_glyph_len(const nccell* c){
+  if(!cell_simple_p(c) || c->width != 1){
+    return 0;
+  }
+  const unsigned char* egc = (const unsigned char*)&c->gcluster;
+  if(egc[0] < 0x80){
+    return 1; // ASCII, or 0/'\n', which term_putc() writes as a space
+  }
+  const unsigned len = egc[0] >= 0xf0 ? 4 : egc[0] >= 0xe0 ? 3 : 2;
+  return strnlen((const char*)egc, sizeof(c->gcluster)) == len ? len : 0;
+}
 
-// Takes a rendered frame (a flat framebuffer, where each cell has the desired
-// EGC, attribute, and channels), which has been written to nc->lastframe, and
-// spits out an optimal sequence of terminal-appropriate escapes and EGCs. There
-// should be an rvec entry for each cell, but only the 'damaged' field is used.
-// lastframe has *not yet been written to the screen*, i.e. it's only about to
-// *become* the last frame rasterized.
+// |c| has just been written at absolute column |x| of a row which ends (for
+// our purposes) at |xend|. the damaged cells immediately following it which
+// are identical (and would otherwise be written in this phase) needn't see
+// any color or style changes; they're covered here with whichever of REP,
+// ECH, or the literal glyphs is cheapest. ECH doesn't move the cursor, so we
+// charge it for the hpa needed to get past the run, and only use it for
+// unstyled spaces whose background it will reproduce, short of the row's
+// last column. returns the number of following cells covered, or -1 on error.
 static int
-rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
-  struct crender* rvec = p->crender;
-  // we only need to emit a coordinate if it was damaged. the damagemap is a
-  // bit per coordinate, one per struct crender.
-  for(unsigned y = nc->margin_t; y < p->dimy + nc->margin_t ; ++y){
-    const int innery = y - nc->margin_t;
-    bool saw_linefeed = 0;
-    for(unsigned x = nc->margin_l ; x < p->dimx + nc->margin_l ; ++x){
-      const int innerx = x - nc->margin_l;
-      const size_t damageidx = innery * nc->lfdimx + innerx;
-      unsigned r, g, b, br, bg, bb;
-      nccell* srccell = &nc->lastframe[damageidx];
+raster_run(notcurses* nc, fbuf* f, struct crender* rvec, const nccell* c,
+           size_t idx, unsigned x, unsigned xend, unsigned rowend,
+           unsigned phase){
+  const tinfo* ti = &nc->tcache;
+  if(!ti->ansirep && !ti->ansiech){
+    return 0;
+  }
+  const unsigned glen = rep_glyph_len(c);
+  if(glen == 0){
+    return 0;
+  }
+  const ncplane* srcp = rvec[idx].p;
+  unsigned run = 0;
+  while(x + 1 + run < xend){
+    const size_t i = idx + 1 + run;
+    if(!rvec[i].s.damaged || rvec[i].s.sprixeled || rvec[i].p != srcp){
+      break;
+    }
+    if(phase == 0 && rvec[i].s.p_beats_sprixel){
+      break;
+    }
+    if(memcmp(&nc->lastframe[i], c, sizeof(*c))){
+      break;
+    }
+    ++run;
+  }
+  if(run == 0){
+    return 0;
+  }
+  unsigned cost = run * glen;
+  char final = 0;
+  if(ti->ansirep && 3 + decimal_len(run) < cost){
+    cost = 3 + decimal_len(run);
+    final = 'b';
+  }
+  const bool space = c->gcluster == ' ' || c->gcluster == 0 || c->gcluster == '\n';
+  if(ti->ansiech && space && !c->stylemask &&
+     (ti->bce || nccell_bg_default_p(c)) && x + 1 + run < rowend){
+    // the cursor remains at x + 1, and stepping past the run is relative
+    const unsigned step = move_cost(ti, MOVE_CUF, run, 0);
+    const unsigned echcost = 3 + decimal_len(run) + step;
+    if(step != UINT_MAX && echcost < cost){
+      cost = echcost;
+      final = 'X';
+    }
+  }
+  if(final == 0){
+    return 0; // the literal glyphs are cheapest; write them as usual
+  }
+  if(fbuf_grow(f, 13)){ // CSI, 10 digits, final
+    return -1;
+  }
+  f->buf[f->used++] = '\x1b';
+  f->buf[f->used++] = '[';
+  f->used += fbuf_digits(f->buf + f->used, run);
+  f->buf[f->used++] = final;
+  for(unsigned i = idx + 1 ; i <= idx + run ; ++i){
+    rvec[i].s.damaged = 0;
+    rvec[i].s.p_beats_sprixel = 0;
+  }
+  nc->stats.s.cellemissions += run;
+  if(final == 'b'){ // ECH leaves the cursor where it was
+    nc->rstate.x += run;
+  }
+  return run;
+}
+
+// with a color tolerance, an RGB color within that CIELAB distance (delta E
+// 1976) of the one already set is treated as matching it. sRGB components
+// are linearized through a table built on first use, and the current pen's
+// Lab is cached, so each comparison converts only the new color.
+static float srgb_linear[256];
+static pthread_once_t srgb_linear_once = PTHREAD_ONCE_INIT;
+
+static void
+srgb_linear_build(void){
+  for(unsigned i = 0 ; i < sizeof(srgb_linear) / sizeof(*srgb_linear) ; ++i){
+    const float c = i / 255.0f;
+    srgb_linear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+  }
+}
+
+static inline float
+lab_f(float t){
+  return t > 0.008856f ? cbrtf(t) : 7.787f * t + 16.0f / 116;
+}
+
+// CIELAB (D65 white) of the sRGB color |r|/|g|/|b|
+static void
+rgb_lab(unsigned r, unsigned g, unsigned b, float lab[3]){
+  const float lr = srgb_linear[r], lg = srgb_linear[g], lb = srgb_linear[b];
+  const float fx = lab_f((0.4124f * lr + 0.3576f * lg + 0.1805f * lb) / 0.95047f);
+  const float fy = lab_f(0.2126f * lr + 0.7152f * lg + 0.0722f * lb);
+  const float fz = lab_f((0.0193f * lr + 0.1192f * lg + 0.9505f * lb) / 1.08883f);
+  lab[0] = 116 * fy - 16;
+  lab[1] = 500 * (fx - fy);
+  lab[2] = 200 * (fy - fz);
+}
+
+// the low-bandwidth profile (see lowbw_update()) treats colors within one
+// just-noticeable difference as matching, if no greater tolerance is set.
+#define LOWBW_DELTAE 2.3f
+
+static inline float
+pen_tolerance2(const notcurses* nc){
+  if(nc->rstate.lowbw && nc->colortol2 < LOWBW_DELTAE * LOWBW_DELTAE){
+    return LOWBW_DELTAE * LOWBW_DELTAE;
+  }
+  return nc->colortol2;
+}
+
+// is |r|/|g|/|b| within |tol2| of the pen color |pr|/|pg|/|pb|, whose Lab is
+// cached in |key|/|penlab|?
+static bool
+pen_close_p(float tol2, uint32_t* key, float penlab[3],
+            unsigned pr, unsigned pg, unsigned pb,
+            unsigned r, unsigned g, unsigned b){
+  pthread_once(&srgb_linear_once, srgb_linear_build);
+  const uint32_t pkey = 0x1000000u | (pr << 16u) | (pg << 8u) | pb;
+  if(*key != pkey){
+    rgb_lab(pr, pg, pb, penlab);
+    *key = pkey;
+  }
+  float lab[3];
+  rgb_lab(r, g, b, lab);
+  const float dl = lab[0] - penlab[0];
+  const float da = lab[1] - penlab[1];
+  const float db = lab[2] - penlab[2];
+  return dl * dl + da * da + db * db <= tol2;
+}
+
+int notcurses_set_color_tolerance(notcurses* nc, float deltae){
+  if(!(deltae >= 0 && deltae <= 100)){ // also catches NaN
+    logerror("invalid color tolerance %f", deltae);
+    return -1;
+  }
+  nc->colortol2 = deltae * deltae;
+  return 0;
+}
+
+// would writing the glyph of |c| draw it correctly, given the colors and
+// styles currently set? we only consider printable ASCII (and the nil
+// glyph, written as a space), the width of which we're sure of.
+static inline bool
+rstate_paints_p(const notcurses* nc, const nccell* c){
+  const rasterstate* rs = &nc->rstate;
+  if(!cell_simple_p(c) || c->width != 1){
+    return false;
+  }
+  const bool space = c->gcluster == ' ' || c->gcluster == 0;
+  if(!space && (c->gcluster < 0x20 || c->gcluster >= 0x7f)){
+    return false;
+  }
+  if(rs->curattr != nccell_styles(c)){
+    return false;
+  }
+  unsigned r, g, b;
+  if(!space || nccell_styles(c)){ // an unstyled space shows no foreground
+    if(nccell_fg_default_p(c)){
+      if(!rs->fgdefelidable){
+        return false;
+      }
+    }else if(nccell_fg_palindex_p(c)){
+      if(!rs->fgpalelidable || rs->lastr != nccell_fg_palindex(c)){
+        return false;
+      }
+    }else{
+      nccell_fg_rgb8(c, &r, &g, &b);
+      if(!rs->fgelidable || rs->lastr != r || rs->lastg != g || rs->lastb != b){
+        return false;
+      }
+    }
+  }
+  if(nccell_bg_default_p(c)){
+    return rs->bgdefelidable;
+  }else if(nccell_bg_palindex_p(c)){
+    return false; // palette backgrounds aren't tracked precisely enough
+  }
+  nccell_bg_rgb8(c, &r, &g, &b);
+  return rs->bgelidable && rs->lastbr == r && rs->lastbg == g && rs->lastbb == b;
+}
+
+// we're about to move to |x| on row |y|. if we're already on the row, short
+// of |x|, it can be cheaper to simply write out the undamaged cells in
+// between than to move over them (especially for a gap of a cell or two).
+// that's only possible when the current colors and styles suit each of them.
+static int
+write_through(notcurses* nc, fbuf* f, const struct crender* rvec,
+              int innery, int y, int x, const ncplane* srcp){
+  const int rx = nc->rstate.x;
+  if(nc->rstate.y != y || rx >= x || rx < nc->margin_l){
+    return 0;
+  }
+  if(!nc->rstate.xtrusted || move_forces_absolute(nc, srcp)){
+    return 0;
+  }
+  moveplan mp;
+  plan_move(nc, y, x, false, &mp);
+  const unsigned gap = x - rx;
+  if(gap >= mp.cost){
+    return 0;
+  }
+  const size_t rowidx = innery * nc->lfdimx;
+  for(int col = rx ; col < x ; ++col){
+    const size_t idx = rowidx + col - nc->margin_l;
+    if(rvec[idx].s.damaged || rvec[idx].s.sprixeled ||
+       !rstate_paints_p(nc, &nc->lastframe[idx])){
+      return 0;
+    }
+  }
+  if(fbuf_grow(f, gap)){
+    return -1;
+  }
+  for(int col = rx ; col < x ; ++col){
+    const nccell* c = &nc->lastframe[rowidx + col - nc->margin_l];
+    f->buf[f->used++] = c->gcluster ? *(const char*)&c->gcluster : ' ';
+  }
+  nc->rstate.x = x;
+  return 0;
+}
+
+// Producing the frame requires three steps:
+//  * render -- build up a flat framebuffer from a set of ncplanes
+//  * rasterize -- build up a UTF-8/ASCII stream of escapes and EGCs
+//  * refresh -- write the stream to the emulator
+
+// Takes a rendered frame (a flat framebuffer, where each cell has the desired
+// EGC, attribute, and channels), which has been written to nc->lastframe, and
+// spits out an optimal sequence of terminal-appropriate escapes and EGCs. There
+// should be an rvec entry for each cell, but only the 'damaged' field is used.
+// lastframe has *not yet been written to the screen*, i.e. it's only about to
+// *become* the last frame rasterized.
+//
+// the body is instantiated (see RASTERIZE_CORE below) for each combination
+// of the constant flags, so that the per-cell tests of them fold away:
+//  * rgb: the terminal has direct color (tcache.caps.rgb),
+//  * runs: it has REP and/or ECH, with which raster_run() covers repeats,
+//  * sprixels: the pile's last render included bitmaps.
+__attribute__ ((always_inline)) static inline int
+rasterize_core_body(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase,
+                    const bool rgb, const bool runs, const bool sprixels){
+  struct crender* rvec = p->crender;
+  // the color tolerance can't change mid-frame
+  const float tol2 = pen_tolerance2(nc);
+  // we only need to emit a coordinate if it was damaged. the damagemap is a
+  // bit per coordinate, one per struct crender. if postpaint recorded the
+  // damaged span of each row, we needn't look outside of them, nor at rows
+  // it didn't visit.
+  unsigned begy = nc->margin_t;
+  unsigned endy = p->dimy + nc->margin_t;
+  if(p->spansvalid){
+    const unsigned spanend = p->spanend > p->dimy ? p->dimy : p->spanend;
+    const unsigned spanbeg = p->spanbeg > spanend ? spanend : p->spanbeg;
+    nc->stats.s.cellelisions += (uint64_t)(p->dimy - (spanend - spanbeg)) * p->dimx;
+    begy += spanbeg;
+    endy = spanend + nc->margin_t;
+  }
+  for(unsigned y = begy ; y < endy ; ++y){
+    const int innery = y - nc->margin_t;
+    bool saw_linefeed = 0;
+    unsigned xbeg = nc->margin_l;
+    unsigned xend = p->dimx + nc->margin_l;
+    if(p->spansvalid){
+      const struct dmgspan* span = &p->dmgspans[innery];
+      if(span->beg >= span->end){
+        nc->stats.s.cellelisions += p->dimx;
+        continue;
+      }
+      // start one column early: if that's the undamaged left half of a wide
+      // glyph, the first damaged column might be its right half, which must
+      // be skipped just as it would be when scanning the entire row.
+      const unsigned spanbeg = span->beg ? span->beg - 1 : 0;
+      const unsigned spanend = span->end > p->dimx ? p->dimx : span->end;
+      nc->stats.s.cellelisions += spanbeg + (p->dimx - spanend);
+      xbeg += spanbeg;
+      xend = spanend + nc->margin_l;
+    }
+    for(unsigned x = xbeg ; x < xend ; ++x){
+      const int innerx = x - nc->margin_l;
+      const size_t damageidx = innery * nc->lfdimx + innerx;
+      unsigned r = 0, g = 0, b = 0, br, bg, bb;
+      nccell* srccell = &nc->lastframe[damageidx];
       if(!rvec[damageidx].s.damaged){
         // no need to emit a cell; what we rendered appears to already be
         // here. no updates are performed to elision state nor lastframe.
@@ -1134,6 +2085,9 @@ rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
         // was not above a sprixel (and the cell is damaged). in the second
         // phase, we draw everything that remains damaged.
         ++nc->stats.s.cellemissions;
+        if(write_through(nc, f, rvec, innery, y, x, rvec[damageidx].p)){
+          return -1;
+        }
         if(goto_location(nc, f, y, x, rvec[damageidx].p)){
           return -1;
         }
@@ -1149,6 +2103,9 @@ rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
         //  * we are a no-background glyph, and the previous was default foreground
         bool nobackground = nccell_nobackground_p(srccell);
         bool rgbequal = nccell_rgbequal_p(srccell);
+        // with direct color, an RGB foreground is held back, so that it can
+        // share a single SGR with the background, should that change too.
+        bool fgpending = false;
         if((nccell_fg_default_p(srccell)) || (!nobackground && nccell_bg_default_p(srccell))){
           if(raster_defaults(nc, nccell_fg_default_p(srccell),
                              !nobackground && nccell_bg_default_p(srccell), f)){
@@ -1167,9 +2124,18 @@ rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
           nccell_fg_rgb8(srccell, &r, &g, &b);
           if(nc->rstate.fgelidable && nc->rstate.lastr == r && nc->rstate.lastg == g && nc->rstate.lastb == b){
             ++nc->stats.s.fgelisions;
+          }else if(nc->rstate.fgelidable && tol2 > 0 &&
+                   pen_close_p(tol2, &nc->rstate.fglabkey, nc->rstate.fglab,
+                               nc->rstate.lastr, nc->rstate.lastg, nc->rstate.lastb, r, g, b)){
+            // the terminal keeps what it has, so that's what we track
+            r = nc->rstate.lastr; g = nc->rstate.lastg; b = nc->rstate.lastb;
+            ++nc->stats.s.fgelisions;
+            ++nc->stats.s.approx_elisions;
           }else{
             if(!rgbequal){ // if rgbequal, no need to set fg
-              if(term_fg_rgb8(&nc->tcache, f, r, g, b)){
+              if(rgb){
+                fgpending = true;
+              }else if(raster_fg_rgb8(nc, f, r, g, b)){
                 return -1;
               }
               ++nc->stats.s.fgemissions;
@@ -1196,8 +2162,25 @@ rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
           nccell_bg_rgb8(srccell, &br, &bg, &bb);
           if(nc->rstate.bgelidable && nc->rstate.lastbr == br && nc->rstate.lastbg == bg && nc->rstate.lastbb == bb){
             ++nc->stats.s.bgelisions;
+          }else if(nc->rstate.bgelidable && tol2 > 0 &&
+                   pen_close_p(tol2, &nc->rstate.bglabkey, nc->rstate.bglab,
+                               nc->rstate.lastbr, nc->rstate.lastbg, nc->rstate.lastbb, br, bg, bb)){
+            br = nc->rstate.lastbr; bg = nc->rstate.lastbg; bb = nc->rstate.lastbb;
+            ++nc->stats.s.bgelisions;
+            ++nc->stats.s.approx_elisions;
           }else{
-            if(term_bg_rgb8(&nc->tcache, f, br, bg, bb)){
+            if(fgpending){
+              if(term_esc_rgb2(f, r, g, b, br, bg,
+                               bg_uncollide(&nc->tcache, br, bg, bb))){
+                return -1;
+              }
+              fgpending = false;
+            }else if(rgb){ // what raster_bg_rgb8() would do, sans tests
+              if(term_esc_rgb(f, false, br, bg,
+                              bg_uncollide(&nc->tcache, br, bg, bb))){
+                return -1;
+              }
+            }else if(raster_bg_rgb8(nc, f, br, bg, bb)){
               return -1;
             }
             ++nc->stats.s.bgemissions;
@@ -1213,20 +2196,29 @@ rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
             pool_load_direct(&nc->pool, srccell, " ", 1, 1);
           }
         }
+        if(fgpending){
+          if(term_esc_rgb(f, true, r, g, b)){
+            return -1;
+          }
+        }
 //fprintf(stderr, "RAST %08x [%s] to %d/%d cols: %u %016" PRIx64 "\n", srccell->gcluster, pool_extended_gcluster(&nc->pool, srccell), y, x, srccell->width, srccell->channels);
         // this is used to invalidate the sprixel in the first text round,
         // which is only necessary for sixel, not kitty.
-        if(rvec[damageidx].sprixel){
-          sprixcell_e scstate = sprixel_state(rvec[damageidx].sprixel, y - nc->margin_t, x - nc->margin_l);
+        sprixel* s = sprixels ? crender_sprixel(p, &rvec[damageidx], y - nc->margin_t, x - nc->margin_l) : NULL;
+        if(s){
+          sprixcell_e scstate = sprixel_state(s, y - nc->margin_t, x - nc->margin_l);
           if((scstate == SPRIXCELL_MIXED_SIXEL || scstate == SPRIXCELL_OPAQUE_SIXEL)
              && !rvec[damageidx].s.p_beats_sprixel){
 //fprintf(stderr, "INVALIDATING at %d/%d (%u)\n", y, x, rvec[damageidx].s.p_beats_sprixel);
-            sprixel_invalidate(rvec[damageidx].sprixel, y - nc->margin_t, x - nc->margin_l);
+            sprixel_invalidate(s, y - nc->margin_t, x - nc->margin_l);
           }
         }
         if(term_putc(f, &nc->pool, srccell)){
           return -1;
         }
+        if(!cell_simple_p(srccell) || srccell->gcluster >= 0x80){
+          nc->rstate.xtrusted = false;
+        }
         if(srccell->gcluster == '\n'){
           saw_linefeed = true;
         }
@@ -1238,6 +2230,14 @@ rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
         }else{
           ++nc->rstate.x;
         }
+        if(runs){
+          int run = raster_run(nc, f, rvec, srccell, damageidx, x, xend,
+                               p->dimx + nc->margin_l, phase);
+          if(run < 0){
+            return -1;
+          }
+          x += run;
+        }
         if((int)y > nc->rstate.logendy || ((int)y == nc->rstate.logendy && (int)x > nc->rstate.logendx)){
           if((int)y > nc->rstate.logendy){
 //fprintf(stderr, "**************8NATURAL PLACEMENT AT %u/ %u\n", y, x);
@@ -1267,6 +2267,69 @@ rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
   return 0;
 }
 
+#define RASTERIZE_CORE(RGB, RUNS, SPRIX) \
+static int \
+rasterize_core_##RGB##RUNS##SPRIX(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){ \
+  return rasterize_core_body(nc, p, f, phase, RGB, RUNS, SPRIX); \
+}
+
+RASTERIZE_CORE(0, 0, 0)
+RASTERIZE_CORE(0, 0, 1)
+RASTERIZE_CORE(0, 1, 0)
+RASTERIZE_CORE(0, 1, 1)
+RASTERIZE_CORE(1, 0, 0)
+RASTERIZE_CORE(1, 0, 1)
+RASTERIZE_CORE(1, 1, 0)
+RASTERIZE_CORE(1, 1, 1)
+
+#undef RASTERIZE_CORE
+
+// indexed by raster_profile()
+static int (* const rasterize_cores[])(notcurses*, const ncpile*, fbuf*, unsigned) = {
+  rasterize_core_000, rasterize_core_001, rasterize_core_010, rasterize_core_011,
+  rasterize_core_100, rasterize_core_101, rasterize_core_110, rasterize_core_111,
+};
+
+static inline unsigned
+raster_profile(const notcurses* nc, const ncpile* p){
+  const tinfo* ti = &nc->tcache;
+  return (ti->caps.rgb ? 4u : 0) | (ti->ansirep || ti->ansiech ? 2u : 0) |
+         (p->rsprixelslen ? 1u : 0);
+}
+
+static inline int
+rasterize_core(notcurses* nc, const ncpile* p, fbuf* f, unsigned phase){
+  return rasterize_cores[raster_profile(nc, p)](nc, p, f, phase);
+}
+
+// frames of at least SUMODE_MAX_SIZE bytes always get an application-
+// synchronized update, lest the terminal draw them in pieces. below that, a
+// frame gets one if writing it out is expected to take at least SUMODE_NS,
+// going by the measured cost of our recent writes; on a slow link, even
+// modest frames can be caught mid-write. tiny frames never bother.
+#define SUMODE_MIN_SIZE 256
+#define SUMODE_MAX_SIZE BUFSIZ
+#define SUMODE_NS 500000
+
+static bool
+sumode_wanted_p(notcurses* nc, size_t bytes){
+  if(bytes >= SUMODE_MAX_SIZE){
+    return true;
+  }
+  if(bytes < SUMODE_MIN_SIZE){
+    return false;
+  }
+  double nsperbyte = nc->rstate.nsperbyte;
+  if(nsperbyte == 0){
+    nsperbyte = raster_writer_nsperbyte(nc->rwriter);
+  }
+  return bytes * nsperbyte >= SUMODE_NS;
+}
+
+#undef SUMODE_NS
+#undef SUMODE_MAX_SIZE
+#undef SUMODE_MIN_SIZE
+
 // 'asu' on input is non-0 if application-synchronized updates are permitted
 // (they are not, for instance, when rendering to a non-tty). on output,
 // assuming success, it is non-0 if application-synchronized updates are
@@ -1278,36 +2341,43 @@ notcurses_rasterize_inner(notcurses* nc, ncpile* p, fbuf* f, unsigned* asu){
   // we explicitly move the cursor at the beginning of each output line, so no
   // need to home it expliticly.
   update_palette(nc, f);
+  if(rasterize_region_scrolls(nc, p, f)){
+    return -1;
+  }
   int scrolls = p->scrolls;
+  uint64_t proft = prof_clock(nc);
   logdebug("sprixel phase 1");
   int64_t sprixelbytes = clean_sprixels(nc, p, f, scrolls);
   if(sprixelbytes < 0){
     return -1;
   }
+  prof_phase(nc, PROF_SPRIXEL_CLEAN, &proft);
   logdebug("glyph phase 1");
   if(rasterize_core(nc, p, f, 0)){
     return -1;
   }
+  prof_phase(nc, PROF_CORE0, &proft);
   logdebug("sprixel phase 2");
   int64_t rasprixelbytes = rasterize_sprixels(nc, p, f);
   if(rasprixelbytes < 0){
     return -1;
   }
+  prof_phase(nc, PROF_SPRIXEL_DRAW, &proft);
   sprixelbytes += rasprixelbytes;
-  pthread_mutex_lock(&nc->stats.lock);
+  stats_lock(&nc->stats);
     nc->stats.s.sprixelbytes += sprixelbytes;
-  pthread_mutex_unlock(&nc->stats.lock);
+  stats_unlock(&nc->stats);
   logdebug("glyph phase 2");
-  if(rasterize_scrolls(p, f)){
+  if(rasterize_scrolls(nc, p, f)){
     return -1;
   }
   p->scrolls = 0;
   if(rasterize_core(nc, p, f, 1)){
     return -1;
   }
-#define MIN_SUMODE_SIZE BUFSIZ
+  prof_phase(nc, PROF_CORE1, &proft);
   if(*asu){
-    if(nc->rstate.f.used >= MIN_SUMODE_SIZE){
+    if(sumode_wanted_p(nc, nc->rstate.f.used + nc->rstate.splicebytes)){
       const char* endasu = get_escape(&nc->tcache, ESCAPE_ESUM);
       if(endasu){
         if(fbuf_puts(f, endasu) < 0){
@@ -1320,13 +2390,85 @@ notcurses_rasterize_inner(notcurses* nc, ncpile* p, fbuf* f, unsigned* asu){
       *asu = 0;
     }
   }
-#undef MIN_SUMODE_SIZE
-  return nc->rstate.f.used;
+  return nc->rstate.f.used + nc->rstate.splicebytes;
 }
 
-// rasterize the rendered frame, and blockingly write it out to the terminal.
+// glyphs smaller than this are cheaper to copy than to gather
+#define MIN_SPLICE_SIZE BUFSIZ
+
+int raster_putglyph(notcurses* nc, fbuf* f, const fbuf* g){
+  rasterstate* r = &nc->rstate;
+  if(!r->splicing || f != &r->f || g->used < MIN_SPLICE_SIZE){
+    return fbuf_putn(f, g->buf, g->used) < 0 ? -1 : 0;
+  }
+  if(r->splicecount == r->splicealloc){
+    unsigned na = r->splicealloc ? r->splicealloc * 2 : 8;
+    rsplice* tmp = realloc(r->splices, sizeof(*tmp) * na);
+    if(tmp == NULL){
+      return fbuf_putn(f, g->buf, g->used) < 0 ? -1 : 0;
+    }
+    r->splices = tmp;
+    r->splicealloc = na;
+  }
+  rsplice* sp = &r->splices[r->splicecount++];
+  sp->off = f->used;
+  sp->buf = g->buf;
+  sp->len = g->used;
+  r->splicebytes += g->used;
+  return 0;
+}
+
+#undef MIN_SPLICE_SIZE
+
+// write out the rasterstate buffer, less its first |moffset| bytes, with any
+// spliced glyphs gathered in at their offsets. unless |chunk| is 0, no single
+// write is handed more than |chunk| bytes.
 static int
-raster_and_write(notcurses* nc, ncpile* p, fbuf* f){
+raster_write_spliced(notcurses* nc, size_t moffset, size_t chunk){
+  const rasterstate* r = &nc->rstate;
+  const int fd = fileno(nc->ttyfp);
+#ifndef __MINGW32__
+#define SPLICE_IOVS 64
+  struct iovec iov[SPLICE_IOVS];
+  int iovcnt = 0;
+  size_t off = moffset;
+  for(unsigned i = 0 ; i <= r->splicecount ; ++i){
+    const size_t end = i < r->splicecount ? r->splices[i].off : r->f.used;
+    if(end > off){
+      iov[iovcnt].iov_base = r->f.buf + off;
+      iov[iovcnt].iov_len = end - off;
+      ++iovcnt;
+      off = end;
+    }
+    if(i < r->splicecount){
+      iov[iovcnt].iov_base = (void*)r->splices[i].buf;
+      iov[iovcnt].iov_len = r->splices[i].len;
+      ++iovcnt;
+    }
+    if(iovcnt && (iovcnt > SPLICE_IOVS - 2 || i == r->splicecount)){
+      if(blocking_writev_chunked(fd, iov, iovcnt, chunk)){
+        return -1;
+      }
+      iovcnt = 0;
+    }
+  }
+#undef SPLICE_IOVS
+  return 0;
+#else
+  // we never splice on windows. the frame goes to ConPTY in one piece.
+  (void)chunk;
+  if(fd == fileno(stdout) && nc->tcache.outhandle != INVALID_HANDLE_VALUE){
+    return windows_write(&nc->tcache, r->f.buf + moffset, r->f.used - moffset);
+  }
+  return blocking_write(fd, r->f.buf + moffset, r->f.used - moffset);
+#endif
+}
+
+// rasterize the rendered frame into |f|, following |prefix| (if non-NULL).
+// on success, |*moffset| is set to the number of leading bytes which ought
+// not be written out (a speculative BSU which went unused).
+static int
+raster_frame(notcurses* nc, ncpile* p, fbuf* f, const char* prefix, size_t* moffset){
   fbuf_reset(f);
   // will we be using application-synchronized updates? if this comes back as
   // non-zero, we are, and must emit the header. no SUM without a tty, and we
@@ -1340,41 +2482,99 @@ raster_and_write(notcurses* nc, ncpile* p, fbuf* f){
       return -1;
     }
   }
+  if(prefix){
+    if(fbuf_puts(f, prefix) < 0){
+      return -1;
+    }
+  }
   if(notcurses_rasterize_inner(nc, p, f, &useasu) < 0){
     return -1;
   }
   // if we loaded a BSU into the front, but don't actually want to use it,
   // we start printing after the BSU.
-  size_t moffset = 0;
+  *moffset = 0;
   if(basu){
     if(useasu){
       ++nc->stats.s.appsync_updates;
     }else{
-      moffset = strlen(basu);
+      *moffset = strlen(basu);
     }
   }
-  int ret = 0;
+  return 0;
+}
+
+// a large frame within a synchronized update is written in chunks of this
+// many bytes. the terminal won't show any of it until the end of the update
+// anyway, and no single write(2) then waits on much more than a pty buffer's
+// worth of draining, nor holds the kernel to copying the whole frame.
+#define SUMODE_CHUNK_SIZE 16384
+
+// small writes are dominated by the cost of the syscall, and land in the
+// pty's buffer no matter the link beyond it. only frames of at least this
+// many bytes are taken as evidence of the link's throughput.
+#define LOWBW_SAMPLE_BYTES 8192
+
+// rasterize the rendered frame, and blockingly write it out to the terminal.
+// since the write follows immediately, sprixel glyphs are spliced in place
+// rather than being copied into |f|. the cost of the write is folded into
+// our estimate of the link's speed.
+static int
+raster_and_write(notcurses* nc, ncpile* p, fbuf* f){
+  size_t moffset;
+  nc->rstate.splicecount = 0;
+  nc->rstate.splicebytes = 0;
+#ifndef __MINGW32__
+  nc->rstate.splicing = (f == &nc->rstate.f);
+#endif
+  int ret = raster_frame(nc, p, f, NULL, &moffset);
+  nc->rstate.splicing = false;
+  if(ret){
+    return -1;
+  }
+  const int bytes = nc->rstate.f.used + nc->rstate.splicebytes;
+  const bool synced = moffset == 0 && get_escape(&nc->tcache, ESCAPE_BSUM);
+  const size_t chunk = synced && bytes > SUMODE_CHUNK_SIZE ? SUMODE_CHUNK_SIZE : 0;
   sigset_t oldmask;
+  uint64_t proft = prof_clock(nc);
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  const uint64_t tstart = nctrace_begin();
   block_signals(&oldmask);
-  if(blocking_write(fileno(nc->ttyfp), nc->rstate.f.buf + moffset,
-                    nc->rstate.f.used - moffset)){
+  if(raster_write_spliced(nc, moffset, chunk)){
     ret = -1;
   }
   unblock_signals(&oldmask);
+  nctrace_end("frame_write", tstart, "bytes", bytes - moffset);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  if(ret == 0){
+    nsperbyte_update(&nc->rstate.nsperbyte,
+                     timespec_to_ns(&t1) - timespec_to_ns(&t0), bytes - moffset);
+    if(bytes - moffset >= LOWBW_SAMPLE_BYTES){
+      nsperbyte_update(&nc->rstate.bwnsperbyte,
+                       timespec_to_ns(&t1) - timespec_to_ns(&t0), bytes - moffset);
+    }
+  }
+  prof_phase(nc, PROF_WRITE, &proft);
+  nc->rstate.splicecount = 0;
+  nc->rstate.splicebytes = 0;
   rasterize_sprixels_post(nc, p);
 //fprintf(stderr, "%lu/%lu %lu/%lu %lu/%lu %d\n", nc->stats.defaultelisions, nc->stats.defaultemissions, nc->stats.fgelisions, nc->stats.fgemissions, nc->stats.bgelisions, nc->stats.bgemissions, ret);
   if(ret < 0){
     return ret;
   }
-  return nc->rstate.f.used;
+  return bytes;
 }
 
+#undef SUMODE_CHUNK_SIZE
+
 // if the cursor is enabled, store its location and disable it. then, once done
 // rasterizing, enable it afresh, moving it to the stored location. if left on
 // during rasterization, we'll get grotesque flicker. 'out' is a memstream
 // used to collect a buffer.
 static inline int
 notcurses_rasterize(notcurses* nc, ncpile* p, fbuf* f){
+  // anything handed off by ncpile_render_async() must precede us
+  raster_writer_wait(nc->rwriter);
   const int cursory = nc->cursory;
   const int cursorx = nc->cursorx;
   if(cursory >= 0){ // either both are good, or neither is
@@ -1394,6 +2594,60 @@ notcurses_rasterize(notcurses* nc, ncpile* p, fbuf* f){
   return ret;
 }
 
+// spin up the raster writer if it's not yet running. returns NULL if it
+// can't be started.
+static struct raster_writer*
+notcurses_raster_writer(notcurses* nc){
+  if(nc->rwriter == NULL){
+    nc->rwriter = raster_writer_create(fileno(nc->ttyfp));
+  }
+  return nc->rwriter;
+}
+
+// as notcurses_rasterize(), but the frame (including the cursor dance) is
+// built up in a single buffer and handed to the raster writer, rather than
+// written out here. falls back to a blocking write if there's no writer.
+static int
+notcurses_rasterize_async(notcurses* nc, ncpile* p, fbuf* f){
+  if(notcurses_raster_writer(nc) == NULL){
+    return notcurses_rasterize(nc, p, f);
+  }
+  const int cursory = nc->cursory;
+  const int cursorx = nc->cursorx;
+  const char* cinvis = NULL;
+  if(cursory >= 0){
+    cinvis = get_escape(&nc->tcache, ESCAPE_CIVIS);
+  }
+  size_t moffset;
+  if(raster_frame(nc, p, f, cinvis, &moffset)){
+    return -1;
+  }
+  const int bytes = f->used;
+  int ret = 0;
+  if(cinvis){
+    if(goto_location(nc, f, cursory + nc->margin_t, cursorx + nc->margin_l,
+                     nc->rstate.lastsrcp)){
+      ret = -1;
+    }
+    const char* cnorm = get_escape(&nc->tcache, ESCAPE_CNORM);
+    if(!cnorm || fbuf_puts(f, cnorm) < 0){
+      nc->cursory = -1;
+      nc->cursorx = -1;
+      ret = -1;
+    }
+  }else if(cursory < 0 && nc->rstate.logendy >= 0){
+    if(goto_location(nc, f, nc->rstate.logendy, nc->rstate.logendx, nc->rstate.lastsrcp)){
+      ret = -1;
+    }
+  }
+  rasterize_sprixels_post(nc, p);
+  if(raster_writer_submit(nc->rwriter, f, moffset)){
+    ret = -1;
+  }
+  nc->last_pile = p;
+  return ret < 0 ? ret : bytes;
+}
+
 // get the cursor to the upper-left corner by one means or another, clearing
 // the screen while doing so.
 int clear_and_home(notcurses* nc, tinfo* ti, fbuf* f){
@@ -1415,6 +2669,7 @@ int clear_and_home(notcurses* nc, tinfo* ti, fbuf* f){
 }
 
 int notcurses_refresh(notcurses* nc, unsigned* restrict dimy, unsigned* restrict dimx){
+  raster_writer_wait(nc->rwriter);
   if(notcurses_resize(nc, dimy, dimx)){
     return -1;
   }
@@ -1461,8 +2716,12 @@ int ncpile_render_to_file(ncplane* n, FILE* fp){
   }
   const unsigned count = (nc->lfdimx > p->dimx ? nc->lfdimx : p->dimx) *
                          (nc->lfdimy > p->dimy ? nc->lfdimy : p->dimy);
+  // the pile's own rvec is retained across renders; don't clobber it
+  struct crender* rvec = p->crender;
+  p->spansvalid = false;
   p->crender = malloc(count * sizeof(*p->crender));
   if(p->crender == NULL){
+    p->crender = rvec;
     fbuf_free(&f);
     return -1;
   }
@@ -1472,6 +2731,8 @@ int ncpile_render_to_file(ncplane* n, FILE* fp){
   }
   int ret = raster_and_write(nc, p, &f);
   free(p->crender);
+  p->crender = rvec;
+  p->dmgall = true;
   if(ret > 0){
     if(fwrite(f.buf, f.used, 1, fp) == 1){
       ret = 0;
@@ -1483,75 +2744,706 @@ int ncpile_render_to_file(ncplane* n, FILE* fp){
   return ret;
 }
 
-// We execute the painter's algorithm, starting from our topmost plane. The
-// damagevector should be all zeros on input. On success, it will reflect
-// which cells were changed. We solve for each coordinate's cell by walking
-// down the z-buffer, looking at intersections with ncplanes. This implies
-// locking down the EGC, the attributes, and the channels for each cell.
-// if |pgeo_changed|, the cell-pixel geometry for the pile has changed
-// since the last render, and thus all sprixels need be rescaled.
-static void
-ncpile_render_internal(ncpile* p, unsigned pgeo_changed){
-  struct crender* rvec = p->crender;
-//fprintf(stderr, "rendering %dx%d\n", p->dimy, p->dimx);
-  ncplane* pl = p->top;
-  sprixel* sprixel_list = NULL;
-  while(pl){
-    paint(pl, rvec, p->dimy, p->dimx, 0, 0, &sprixel_list, pgeo_changed);
-    pl = pl->below;
-  }
-  if(sprixel_list){
-    if(p->sprixelcache){
-      sprixel* s = sprixel_list;
-      while(s->next){
-        s = s->next;
-      }
-      if( (s->next = p->sprixelcache) ){
-        p->sprixelcache->prev = s;
-      }
+// a plane family marked with ncplane_set_layercache() is composited into a
+// backing rvec of its own, which is then copied into the pile's rvec in
+// place of painting its members. the backing covers the onscreen part of the
+// family's bounding box. it's reused so long as the family's members, their
+// z-order, their geometries, and their modification counts (see
+// ncplane_damage_rows()) are all unchanged, and the pile's geometry stands.
+//
+// a cell is only copied from the backing if the backing solved it, and
+// nothing above the layer has touched it; painting the members there would
+// have yielded exactly the backing's cell. cells which the layer touched
+// without solving, or which planes above have partially solved, are left
+// to the members themselves, painted directly over just those rows.
+//
+// the layer is painted as a unit at the z-position of its topmost member.
+// any other planes interleaved among its members are painted below it.
+// piles with sprixels don't use cached layers.
+
+// a member of a cached layer, as composited
+struct layerent {
+  ncplane* p;
+  unsigned mods;
+  int absy, absx;
+  unsigned leny, lenx;
+};
+
+typedef struct nclayer {
+  struct crender* rvec;   // backing rvec, leny * lenx
+  int absy, absx;         // origin of backing relative to the pile
+  unsigned leny, lenx;    // geometry of backing
+  unsigned pdimy, pdimx;  // pile geometry when composited
+  struct layerent* ents;  // members as composited, topmost first
+  unsigned entcount, entcap;
+  struct layerent* seen;  // members found at this render, topmost first
+  unsigned seencount, seencap;
+  ncplane* top;           // topmost member at this render, NULL if unseen
+  struct nclayer* nextseen; // next layer seen at this render
+  bool valid;             // does the backing reflect ents?
+  bool broken;            // couldn't be prepared; paint members directly
+} nclayer;
+
+bool ncplane_set_layercache(ncplane* n, unsigned cached){
+  const bool old = n->layer;
+  if(cached && !n->layer){
+    if((n->layer = calloc(1, sizeof(*n->layer))) == NULL){
+      logerror("couldn't allocate layer for %p", n);
+      return old;
     }
-    p->sprixelcache = sprixel_list;
+    __atomic_add_fetch(&ncplane_notcurses(n)->layers, 1, __ATOMIC_RELAXED);
+  }else if(!cached && n->layer){
+    ncplane_layer_free(n);
   }
+  ncplane_damage_family(n);
+  return old;
 }
 
-int ncpile_rasterize(ncplane* n){
-  struct timespec start, rasterdone, writedone;
-  clock_gettime(CLOCK_MONOTONIC, &start);
-  ncpile* pile = ncplane_pile(n);
-  struct notcurses* nc = ncpile_notcurses(pile);
-  const struct tinfo* ti = &ncplane_notcurses_const(n)->tcache;
-  postpaint(nc, ti, nc->lastframe, pile->dimy, pile->dimx, pile->crender, &nc->pool);
-  clock_gettime(CLOCK_MONOTONIC, &rasterdone);
-  int bytes = notcurses_rasterize(nc, pile, &nc->rstate.f);
-  clock_gettime(CLOCK_MONOTONIC, &writedone);
-  pthread_mutex_lock(&nc->stats.lock);
-    // accepts negative |bytes| as an indication of failure
-    update_raster_bytes(&nc->stats.s, bytes);
-    update_raster_stats(&rasterdone, &start, &nc->stats.s);
-    update_write_stats(&writedone, &rasterdone, &nc->stats.s, bytes);
-  pthread_mutex_unlock(&nc->stats.lock);
-  // we want to refresh if the screen geometry changed (or if we were just
-  // woken up from SIGSTOP), but we mustn't do so until after rasterizing
-  // the solved rvec, since this might result in a geometry update.
-  if(sigcont_seen_for_render){
-    sigcont_seen_for_render = 0;
-    notcurses_refresh(ncplane_notcurses(n), NULL, NULL);
+bool ncplane_layercache_p(const ncplane* n){
+  return n->layer;
+}
+
+void ncplane_layer_free(ncplane* n){
+  nclayer* l = n->layer;
+  if(l){
+    free(l->rvec);
+    free(l->ents);
+    free(l->seen);
+    free(l);
+    n->layer = NULL;
+    __atomic_sub_fetch(&ncplane_notcurses(n)->layers, 1, __ATOMIC_RELAXED);
   }
-  if(bytes < 0){
-    return -1;
+}
+
+void ncplane_layer_invalidate(ncplane* n){
+  for(ncplane* a = n->boundto ; ; a = a->boundto){
+    if(a->layer){
+      a->layer->valid = false;
+    }
+    if(a->boundto == a){
+      break;
+    }
   }
-  return 0;
 }
 
-// ensure the crender vector of 'n' is properly sized for 'n'->dimy x 'n'->dimx,
-// and initialize the rvec afresh for a new render.
+// has nothing been painted into this crender?
+static inline bool
+crender_untouched_p(const struct crender* crender){
+  return !crender->p && !crender->s.fgblends && !crender->s.bgblends &&
+         !crender->s.highcontrast && !crender->s.blittedquads &&
+         nccell_fg_alpha(&crender->c) == NCALPHA_TRANSPARENT &&
+         nccell_bg_alpha(&crender->c) == NCALPHA_TRANSPARENT;
+}
+
+static inline bool
+layerent_eq(const struct layerent* a, const struct layerent* b){
+  return a->p == b->p && a->mods == b->mods && a->absy == b->absy &&
+         a->absx == b->absx && a->leny == b->leny && a->lenx == b->lenx;
+}
+
+// composite the members (already in l->ents) into the backing. returns -1
+// if the backing couldn't be allocated.
 static int
-engorge_crender_vector(ncpile* p){
-  if(p->dimy <= 0 || p->dimx <= 0){
-    return -1;
-  }
-  const size_t crenderlen = p->dimy * p->dimx; // desired size
-//fprintf(stderr, "crlen: %d y: %d x:%d\n", crenderlen, dimy, dimx);
+layer_composite(nclayer* l, const ncpile* p){
+  int begy = INT_MAX, begx = INT_MAX, endy = INT_MIN, endx = INT_MIN;
+  for(unsigned i = 0 ; i < l->entcount ; ++i){
+    const struct layerent* e = &l->ents[i];
+    if(e->absy < begy){
+      begy = e->absy;
+    }
+    if(e->absx < begx){
+      begx = e->absx;
+    }
+    if(e->absy + (int)e->leny > endy){
+      endy = e->absy + e->leny;
+    }
+    if(e->absx + (int)e->lenx > endx){
+      endx = e->absx + e->lenx;
+    }
+  }
+  begy = begy < 0 ? 0 : begy;
+  begx = begx < 0 ? 0 : begx;
+  endy = endy > (int)p->dimy ? (int)p->dimy : endy;
+  endx = endx > (int)p->dimx ? (int)p->dimx : endx;
+  if(begy >= endy || begx >= endx){ // entirely offscreen
+    l->leny = l->lenx = 0;
+  }else{
+    const size_t cells = (size_t)(endy - begy) * (endx - begx);
+    if(cells > (size_t)l->leny * l->lenx){
+      struct crender* tmp = realloc(l->rvec, sizeof(*tmp) * cells);
+      if(tmp == NULL){
+        return -1;
+      }
+      l->rvec = tmp;
+    }
+    l->absy = begy;
+    l->absx = begx;
+    l->leny = endy - begy;
+    l->lenx = endx - begx;
+    init_rvec(l->rvec, cells);
+    sprixel* unused = NULL;
+    for(unsigned i = 0 ; i < l->entcount ; ++i){
+      paint(l->ents[i].p, l->rvec, l->leny, l->lenx, l->absy, l->absx,
+            &unused, 0, l->leny, NULL);
+    }
+  }
+  l->pdimy = p->dimy;
+  l->pdimx = p->dimx;
+  l->valid = true;
+  return 0;
+}
+
+static int
+layer_see(nclayer* l, ncplane* pl){
+  if(l->seencount == l->seencap){
+    const unsigned cap = l->seencap ? l->seencap * 2 : 8;
+    struct layerent* tmp = realloc(l->seen, sizeof(*tmp) * cap);
+    if(tmp == NULL){
+      return -1;
+    }
+    l->seen = tmp;
+    l->seencap = cap;
+  }
+  struct layerent* e = &l->seen[l->seencount++];
+  e->p = pl;
+  e->mods = pl->mods;
+  e->absy = pl->absy;
+  e->absx = pl->absx;
+  e->leny = pl->leny;
+  e->lenx = pl->lenx;
+  return 0;
+}
+
+// bring each layer of |p| up to date, and claim its members via ->inlayer.
+// returns the layers seen, linked through ->nextseen, which must be passed
+// to layers_done() once painting is complete.
+static nclayer*
+layers_prep(ncpile* p){
+  nclayer* seen = NULL;
+  bool broken = false;
+  for(ncplane* pl = p->top ; pl ; pl = pl->below){
+    nclayer* l = NULL;
+    if(!p->sprixelcache){
+      for(const ncplane* a = pl ; ; a = a->boundto){
+        if(a->layer){
+          l = a->layer; // keep climbing; the outermost layer wins
+        }
+        if(a->boundto == a){
+          break;
+        }
+      }
+    }
+    if( (pl->inlayer = l) ){
+      if(l->top == NULL){
+        l->top = pl;
+        l->seencount = 0;
+        l->broken = false;
+        l->nextseen = seen;
+        seen = l;
+      }
+      if(!l->broken && layer_see(l, pl)){
+        broken = l->broken = true;
+      }
+    }
+  }
+  for(nclayer* l = seen ; l ; l = l->nextseen){
+    if(l->broken){
+      continue;
+    }
+    bool same = l->valid && l->seencount == l->entcount &&
+                l->pdimy == p->dimy && l->pdimx == p->dimx;
+    for(unsigned i = 0 ; same && i < l->seencount ; ++i){
+      same = layerent_eq(&l->seen[i], &l->ents[i]);
+    }
+    if(!same){
+      struct layerent* tmp = l->ents;
+      unsigned tmpcap = l->entcap;
+      l->ents = l->seen;
+      l->entcap = l->seencap;
+      l->entcount = l->seencount;
+      l->seen = tmp;
+      l->seencap = tmpcap;
+      if(layer_composite(l, p)){
+        l->valid = false;
+        broken = l->broken = true;
+      }
+    }
+  }
+  if(broken){ // members of broken layers are painted as usual
+    logwarn("couldn't prepare cached layers for %p", p);
+    for(ncplane* pl = p->top ; pl ; pl = pl->below){
+      if(pl->inlayer && pl->inlayer->broken){
+        pl->inlayer = NULL;
+      }
+    }
+  }
+  return seen;
+}
+
+static void
+layers_done(nclayer* seen){
+  while(seen){
+    seen->top = NULL;
+    seen = seen->nextseen;
+  }
+}
+
+// paint the members of |l| directly over rows [beg, end).
+static void
+paint_layer_members(const nclayer* l, struct crender* rvec, int dimy, int dimx,
+                    int beg, int end, unsigned* unsolved){
+  sprixel* unused = NULL;
+  for(unsigned i = 0 ; i < l->entcount ; ++i){
+    paint(l->ents[i].p, rvec, dimy, dimx, 0, 0, &unused, beg, end, unsolved);
+  }
+}
+
+// copy the backing of |l| into rows [bandbeg, bandend) of |rvec| where
+// possible, painting its members wherever not (see above).
+static void
+paint_layer(const nclayer* l, struct crender* rvec, int dimy, int dimx,
+            int bandbeg, int bandend, unsigned* unsolved){
+  const int beg = l->absy > bandbeg ? l->absy : bandbeg;
+  int end = l->absy + (int)l->leny;
+  if(end > bandend){
+    end = bandend;
+  }
+  int runbeg = -1; // first row of the current run needing its members painted
+  for(int y = beg ; y < end ; ++y){
+    bool leftover = false;
+    if(unsolved[y]){
+      const struct crender* src = &l->rvec[(y - l->absy) * l->lenx];
+      struct crender* dst = &rvec[fbcellidx(y, dimx, l->absx)];
+      for(unsigned x = 0 ; x < l->lenx ; ++x){
+        if(crender_untouched_p(&src[x])){
+          continue;
+        }
+        struct crender* d = &dst[x];
+        if(!crender_untouched_p(d)){
+          if(!crender_solved_p(d) && !nccell_wide_right_p(&d->c)){
+            leftover = true;
+          }
+          continue;
+        }
+        // a wide glyph is bisected by the screen's edge, or by a plane above
+        if(!crender_solved_p(&src[x]) ||
+           (src[x].c.gcluster && nccell_double_wide_p(&src[x].c) &&
+            (l->absx + (int)x >= dimx - 1 || !crender_untouched_p(&d[1])))){
+          leftover = true;
+          continue;
+        }
+        const unsigned damaged = d->s.damaged;
+        *d = src[x];
+        d->s.damaged = damaged;
+        --unsolved[y];
+      }
+    }
+    if(leftover){
+      if(runbeg < 0){
+        runbeg = y;
+      }
+    }else if(runbeg >= 0){
+      paint_layer_members(l, rvec, dimy, dimx, runbeg, y, unsolved);
+      runbeg = -1;
+    }
+  }
+  if(runbeg >= 0){
+    paint_layer_members(l, rvec, dimy, dimx, runbeg, end, unsolved);
+  }
+}
+
+// a run of sprixel-free planes [top, stop) within a pile, to be painted in
+// row bands (covering rows [begy, endy)) by the render engine. if |layered|,
+// the planes' ->inlayer claims are current (see layers_prep()).
+struct paintjob {
+  ncpile* p;
+  ncplane* top;
+  ncplane* stop;
+  unsigned begy, endy;
+  bool layered;
+};
+
+// does |pl| miss rows [begy, endy) (or all columns) of the pile entirely?
+// such planes needn't be painted. sprixel planes must always be painted, to
+// maintain the pile's sprixel list.
+static inline bool
+plane_culled_p(const ncplane* pl, const ncpile* p, unsigned begy, unsigned endy){
+  if(pl->sprite){
+    return false;
+  }
+  return pl->absy >= (int)endy || pl->absy + (int)pl->leny <= (int)begy ||
+         pl->absx >= (int)p->dimx || pl->absx + (int)pl->lenx <= 0;
+}
+
+static void
+paint_band(void* vjob, unsigned band, unsigned bands){
+  const struct paintjob* job = vjob;
+  const ncpile* p = job->p;
+  const unsigned rows = job->endy - job->begy;
+  const int bandbeg = job->begy + rows * band / bands;
+  const int bandend = job->begy + rows * (band + 1) / bands;
+  sprixel* unused = NULL;
+  for(ncplane* pl = job->top ; pl != job->stop ; pl = pl->below){
+    if(job->layered && pl->inlayer){
+      if(pl == pl->inlayer->top){
+        paint_layer(pl->inlayer, p->crender, p->dimy, p->dimx, bandbeg, bandend,
+                    p->unsolved);
+      }
+    }else if(!plane_culled_p(pl, p, bandbeg, bandend)){
+      paint(pl, p->crender, p->dimy, p->dimx, 0, 0, &unused, bandbeg, bandend,
+            p->unsolved);
+    }
+  }
+}
+
+// we don't bother waking the workers unless each thread gets at least this
+// many rows.
+#define MIN_BAND_ROWS 4
+
+// We execute the painter's algorithm, starting from our topmost plane. The
+// damagevector should be all zeros on input. On success, it will reflect
+// which cells were changed. We solve for each coordinate's cell by walking
+// down the z-buffer, looking at intersections with ncplanes. This implies
+// locking down the EGC, the attributes, and the channels for each cell.
+// only rows [begy, endy) are solved; the rest of the rvec is left untouched.
+//
+// if we have a render engine, runs of sprixel-free planes are painted in
+// row bands across its threads. sprixel planes depend on (and affect) what's
+// been solved above them across whole cells, so they're always painted by
+// us, in order, between such runs. band timings are accumulated into
+// |bandns| and |bandmaxns|. members of cached layers are painted as a unit
+// (see paint_layer()).
+static void
+ncpile_render_internal(ncpile* p, unsigned begy, unsigned endy,
+                       uint64_t* bandns, int64_t* bandmaxns){
+  struct crender* rvec = p->crender;
+  struct render_engine* re = ncpile_notcurses(p)->rengine;
+  const unsigned threads = render_engine_threads(re);
+  const unsigned rows = endy - begy;
+  unsigned bands = 0;
+  // costs can't be charged to planes painted in bands, so profiling paints
+  // serially.
+  const bool profiling = ncpile_notcurses(p)->profile.enabled;
+  if(threads > 1 && rows >= threads * MIN_BAND_ROWS && !profiling){
+    // a few bands per thread helps balance uneven plane distributions
+    bands = threads * 2;
+    if(bands > rows / MIN_BAND_ROWS){
+      bands = rows / MIN_BAND_ROWS;
+    }
+  }
+//fprintf(stderr, "rendering %dx%d\n", p->dimy, p->dimx);
+  nclayer* layers = NULL;
+  const bool layered = __atomic_load_n(&ncpile_notcurses(p)->layers, __ATOMIC_RELAXED);
+  if(layered){
+    layers = layers_prep(p);
+  }
+  ncplane* pl = p->top;
+  sprixel* sprixel_list = NULL;
+  while(pl){
+    if(bands && !pl->sprite){
+      struct paintjob job = {
+        .p = p,
+        .top = pl,
+        .stop = pl,
+        .begy = begy,
+        .endy = endy,
+        .layered = layered,
+      };
+      while(job.stop && !job.stop->sprite){
+        job.stop = job.stop->below;
+      }
+      if(render_engine_run(re, bands, paint_band, &job, bandmaxns, bandns)){
+        paint_band(&job, 0, 1); // engine was busy with another pile
+      }
+      pl = job.stop;
+      continue;
+    }
+    if(layered && pl->inlayer){
+      if(pl == pl->inlayer->top){
+        paint_layer(pl->inlayer, rvec, p->dimy, p->dimx, begy, endy, p->unsolved);
+      }
+      pl = pl->below;
+      continue;
+    }
+    if(plane_culled_p(pl, p, begy, endy)){
+      pl = pl->below;
+      continue;
+    }
+    if(profiling){
+      struct timespec t0, t1;
+      clock_gettime(CLOCK_MONOTONIC, &t0);
+      paint(pl, rvec, p->dimy, p->dimx, 0, 0, &sprixel_list, begy, endy,
+            p->unsolved);
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      pl->prof_paint_ns += timespec_to_ns(&t1) - timespec_to_ns(&t0);
+      ++pl->prof_paints;
+    }else{
+      paint(pl, rvec, p->dimy, p->dimx, 0, 0, &sprixel_list, begy, endy,
+            p->unsolved);
+    }
+    pl = pl->below;
+  }
+  layers_done(layers);
+  if(sprixel_list){
+    if(p->sprixelcache){
+      sprixel* s = sprixel_list;
+      while(s->next){
+        s = s->next;
+      }
+      if( (s->next = p->sprixelcache) ){
+        p->sprixelcache->prev = s;
+      }
+    }
+    p->sprixelcache = sprixel_list;
+  }
+}
+
+#undef MIN_BAND_ROWS
+
+// NCOPTION_ADAPTIVE_BANDWIDTH: we enter the low-bandwidth profile when
+// writes cost more than LOWBW_ENTER_NSPERBYTE (i.e. the link is moving less
+// than ~100KB/s), and leave it once they're down to LOWBW_LEAVE_NSPERBYTE.
+// the gap keeps us from flapping between the two.
+#define LOWBW_ENTER_NSPERBYTE 10000
+#define LOWBW_LEAVE_NSPERBYTE 5000
+
+double notcurses_link_nsperbyte(notcurses* nc){
+  if(nc->rwriter){
+    const double nsperbyte = raster_writer_nsperbyte(nc->rwriter);
+    if(nsperbyte){
+      return nsperbyte;
+    }
+  }
+  return nc->rstate.bwnsperbyte;
+}
+
+static void
+lowbw_update(notcurses* nc, bool async){
+  if(!(nc->flags & NCOPTION_ADAPTIVE_BANDWIDTH)){
+    return;
+  }
+  const double nsperbyte = async && nc->rwriter ?
+    raster_writer_nsperbyte(nc->rwriter) : nc->rstate.bwnsperbyte;
+  if(nsperbyte == 0){
+    return;
+  }
+  if(!nc->rstate.lowbw && nsperbyte >= LOWBW_ENTER_NSPERBYTE){
+    loginfo("entering low-bandwidth profile (%.0f ns/B)", nsperbyte);
+    nc->rstate.lowbw = true;
+  }else if(nc->rstate.lowbw && nsperbyte <= LOWBW_LEAVE_NSPERBYTE){
+    loginfo("leaving low-bandwidth profile (%.0f ns/B)", nsperbyte);
+    nc->rstate.lowbw = false;
+  }
+}
+
+// with a frame budget, ought we skip rasterizing |pile| for now? we do so
+// while the terminal is estimated to be more than the budget behind, so long
+// as the pile has no sprixels (whose state machines expect each render to be
+// rasterized). the solved rows are retained, and the next rasterization emits
+// all damage since the last frame actually written.
+static bool
+raster_defer_p(const notcurses* nc, const ncpile* pile, bool async,
+               const struct timespec* now){
+  if(nc->framebudget == 0 || pile->sprixelcache){
+    return false;
+  }
+  if(async && nc->rwriter){
+    return raster_writer_backlog_ns(nc->rwriter) > nc->framebudget;
+  }
+  return (uint64_t)timespec_to_ns(now) < nc->throttleuntil;
+}
+
+static void mirrors_publish(notcurses* nc, ncpile* p);
+
+// when |async| is set, the frame is handed off to the raster writer, and the
+// write stats reflect only the handoff. unless |force| is set, the frame
+// might instead be deferred under a frame budget.
+static int
+ncpile_rasterize_internal(ncpile* pile, bool async, bool force){
+  struct timespec start, rasterdone, writedone;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  struct notcurses* nc = ncpile_notcurses(pile);
+  if(pile->rasterizer){
+    logerror("pile is bound to an ncrasterizer");
+    return -1;
+  }
+  // a pile last rendered while bound to an ncrasterizer was solved against
+  // that rasterizer's geometry; it must be rendered anew.
+  if(nc->lastframe == NULL || nc->lfdimy != pile->dimy || nc->lfdimx != pile->dimx){
+    logerror("pile wasn't rendered for the terminal (%ux%u vs %ux%u)",
+             pile->dimy, pile->dimx, nc->lfdimy, nc->lfdimx);
+    return -1;
+  }
+  if(!force && raster_defer_p(nc, pile, async, &start)){
+    nc->deferredpile = pile;
+    stats_lock(&nc->stats);
+      ++nc->stats.s.deferred_rasters;
+    stats_unlock(&nc->stats);
+    return 0;
+  }
+  nc->deferredpile = NULL;
+  const uint64_t tstart = nctrace_begin();
+  const struct tinfo* ti = &nc->tcache;
+  // sprixels can damage cells after postpaint, so we can't trust the spans
+  // if any are present.
+  pile->spansvalid = false;
+  if(pile->sprixelcache == NULL){
+    if(pile->dmgspanslen < pile->dimy){
+      struct dmgspan* tmp = realloc(pile->dmgspans, sizeof(*tmp) * pile->dimy);
+      if(tmp){
+        pile->dmgspans = tmp;
+        pile->dmgspanslen = pile->dimy;
+      }
+    }
+    if(pile->dmgspanslen >= pile->dimy){
+      memset(pile->dmgspans, 0, sizeof(*pile->dmgspans) * pile->dimy);
+      pile->spansvalid = true;
+    }
+  }
+  uint64_t proft = prof_clock(nc);
+  postpaint(nc, ti, nc->lastframe, pile->solvedbeg, pile->solvedend,
+            pile->solvedbegx, pile->solvedendx, pile->dimx, pile->crender,
+            pile, &nc->pool, pile->spansvalid ? pile->dmgspans : NULL);
+  prof_phase(nc, PROF_POSTPAINT, &proft);
+  pile->spanbeg = pile->solvedbeg;
+  pile->spanend = pile->solvedend;
+  pile->solvedbeg = pile->solvedend = 0;
+  clock_gettime(CLOCK_MONOTONIC, &rasterdone);
+  int bytes;
+  if(async){
+    bytes = notcurses_rasterize_async(nc, pile, &nc->rstate.f);
+  }else{
+    bytes = notcurses_rasterize(nc, pile, &nc->rstate.f);
+  }
+  if(bytes < 0){
+    // damage flags might have been left behind; start afresh next time
+    pile->dmgall = true;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &writedone);
+  nctrace_end("notcurses_rasterize", tstart, "bytes", bytes);
+  nctrace_counter("raster_bytes", bytes < 0 ? 0 : bytes);
+  pile->spansvalid = false;
+  // a blocking write which blew the budget suggests a congested link; give
+  // it as long again to drain before writing another frame.
+  if(nc->framebudget && !async){
+    const uint64_t writens = timespec_to_ns(&writedone) - timespec_to_ns(&rasterdone);
+    if(writens > nc->framebudget){
+      nc->throttleuntil = timespec_to_ns(&writedone) + writens;
+    }else{
+      nc->throttleuntil = 0;
+    }
+  }
+  stats_lock(&nc->stats);
+    // accepts negative |bytes| as an indication of failure
+    update_raster_bytes(&nc->stats.s, bytes);
+    update_raster_stats(&rasterdone, &start, &nc->stats);
+    update_write_stats(&writedone, &rasterdone, &nc->stats, bytes);
+    if(nc->rstate.lowbw && bytes >= 0){
+      ++nc->stats.s.lowbw_frames;
+    }
+  stats_unlock(&nc->stats);
+  // the profile applies from the next frame
+  lowbw_update(nc, async);
+  // we want to refresh if the screen geometry changed (or if we were just
+  // woken up from SIGSTOP), but we mustn't do so until after rasterizing
+  // the solved rvec, since this might result in a geometry update.
+  if(bytes >= 0){
+    mirrors_publish(nc, pile);
+  }
+  if(sigcont_seen_for_render){
+    sigcont_seen_for_render = 0;
+    notcurses_refresh(nc, NULL, NULL);
+  }
+  if(bytes < 0){
+    return -1;
+  }
+  return 0;
+}
+
+int ncpile_rasterize(ncplane* n){
+  if(settle_async_init(ncplane_notcurses(n))){
+    return -1;
+  }
+  // pick up any failure from an earlier asynchronous write
+  int ret = raster_writer_drain(ncplane_notcurses(n)->rwriter);
+  notcurses* nc = ncplane_notcurses(n);
+  if(ncpile_rasterize_internal(ncplane_pile(n), false, false)){
+    ret = -1;
+  }
+  ncplane_reap(nc);
+  return ret;
+}
+
+int ncpile_render_async(ncplane* n){
+  if(ncpile_render(n)){
+    return -1;
+  }
+  notcurses* nc = ncplane_notcurses(n);
+  int ret = ncpile_rasterize_internal(ncplane_pile(n), true, false);
+  ncplane_reap(nc);
+  return ret;
+}
+
+int notcurses_writedone_fd(notcurses* nc){
+  if(notcurses_raster_writer(nc) == NULL){
+    return -1;
+  }
+  return raster_writer_fd(nc->rwriter);
+}
+
+int notcurses_write_drain(notcurses* nc){
+  int ret = raster_writer_drain(nc->rwriter);
+  // a deferred frame ought go out now, budget notwithstanding
+  if(nc->deferredpile){
+    if(ncpile_rasterize_internal(nc->deferredpile, false, true)){
+      ret = -1;
+    }
+  }
+  return ret;
+}
+
+int notcurses_set_frame_budget(notcurses* nc, uint64_t ns){
+  nc->framebudget = ns;
+  nc->throttleuntil = 0;
+  return 0;
+}
+
+int notcurses_set_resize_debounce(notcurses* nc, uint64_t ns){
+  if(nc->tcache.ictx == NULL){
+    logerror("no input layer to debounce");
+    return -1;
+  }
+  inputlayer_set_resize_debounce(nc->tcache.ictx, ns);
+  return 0;
+}
+
+// ensure the crender vector of 'n' is properly sized for 'n'->dimy x 'n'->dimx,
+// and initialize rows [begy, endy) of the rvec (and their unsolved counts)
+// afresh for a new render. if the vector must be resized, it is initialized
+// in its entirety, and |begy| and |endy| are widened to cover all rows. the
+// sprixel table is emptied, with room reserved for every sprixel of the pile
+// (any sprixel forces a full render, so no older crender refers to it), and
+// if there are any, the per-cell index into it is sized to the vector.
+static int
+engorge_crender_vector(ncpile* p, unsigned* begy, unsigned* endy){
+  if(p->dimy <= 0 || p->dimx <= 0){
+    return -1;
+  }
+  unsigned sprixels = 0;
+  for(const sprixel* s = p->sprixelcache ; s ; s = s->next){
+    ++sprixels;
+  }
+  if(sprixels > p->rsprixelscap){
+    sprixel** tmp = realloc(p->rsprixels, sizeof(*tmp) * sprixels);
+    if(tmp == NULL){
+      return -1;
+    }
+    p->rsprixels = tmp;
+    p->rsprixelscap = sprixels;
+  }
+  p->rsprixelslen = 0;
+  const size_t crenderlen = p->dimy * p->dimx; // desired size
+//fprintf(stderr, "crlen: %d y: %d x:%d\n", crenderlen, dimy, dimx);
   if(crenderlen != p->crenderlen){
     loginfo("resizing rvec (%" PRIuPTR ") for %p to %" PRIuPTR,
             p->crenderlen, p, crenderlen);
@@ -1561,15 +3453,85 @@ engorge_crender_vector(ncpile* p){
     }
     p->crender = tmp;
     p->crenderlen = crenderlen;
+    *begy = 0;
+    *endy = p->dimy;
+  }
+  if(sprixels && p->rsprixidxlen < crenderlen){
+    uint16_t* tmp = realloc(p->rsprixidx, sizeof(*tmp) * crenderlen);
+    if(tmp == NULL){
+      return -1;
+    }
+    p->rsprixidx = tmp;
+    p->rsprixidxlen = crenderlen;
+  }
+  if(p->dimy > p->unsolvedlen){
+    unsigned* tmp = realloc(p->unsolved, sizeof(*tmp) * p->dimy);
+    if(tmp == NULL){
+      return -1;
+    }
+    p->unsolved = tmp;
+    p->unsolvedlen = p->dimy;
+  }
+  init_rvec(p->crender + *begy * p->dimx, (*endy - *begy) * p->dimx);
+  for(unsigned y = *begy ; y < *endy ; ++y){
+    p->unsolved[y] = p->dimx;
   }
-  init_rvec(p->crender, crenderlen);
   return 0;
 }
 
+// must all of |p| be solved anew? anything which invalidates the lastframe
+// (a different pile having been rasterized, geometry changes, scrolling), or
+// any sprixel (which depends on knowing the solution for every cell it
+// covers), requires a full solve.
+static inline bool
+ncpile_solve_all_p(const ncpile* p, unsigned pgeo_changed){
+  const notcurses* nc = ncpile_notcurses_const(p);
+  return p->dmgall || pgeo_changed || p->scrolls || p->sprixelcache ||
+         nc->lastframe == NULL || nc->last_pile != p;
+}
+
+// which rows of |p| need be solved? if nothing beyond plane damage has
+// changed since we last rasterized this pile, only the damaged rows; rows
+// outside of them are known to match the lastframe, and their old crenders
+// can be left in place (they're undamaged, and will be elided).
+static void
+ncpile_render_rows(ncpile* p, unsigned pgeo_changed,
+                   unsigned* begy, unsigned* endy){
+  if(ncpile_solve_all_p(p, pgeo_changed)){
+    *begy = 0;
+    *endy = p->dimy;
+  }else if(p->dmgbeg < p->dmgend){
+    *begy = p->dmgbeg;
+    *endy = p->dmgend > p->dimy ? p->dimy : p->dmgend;
+  }else{
+    *begy = *endy = 0;
+  }
+  // rows solved by a previous render, but not yet rasterized, must not be
+  // postpainted twice. if we're solving anything, cover them as well.
+  if(*begy < *endy && p->solvedbeg < p->solvedend){
+    if(p->solvedbeg < *begy){
+      *begy = p->solvedbeg;
+    }
+    if(p->solvedend > *endy){
+      *endy = p->solvedend;
+    }
+  }
+  p->dmgbeg = p->dmgend = 0;
+  p->dmgall = false;
+}
+
 int ncpile_render(ncplane* n){
-  scroll_lastframe(ncplane_notcurses(n), ncplane_pile(n)->scrolls);
+  if(settle_async_init(ncplane_notcurses(n))){
+    return -1;
+  }
+  // a bound pile's scrolls are applied to its rasterizer's lastframe
+  if(ncplane_pile(n)->rasterizer == NULL){
+    scroll_lastframe(ncplane_notcurses(n), ncplane_pile(n)->scrolls);
+    plan_region_scroll(ncplane_notcurses(n), ncplane_pile(n));
+  }
   struct timespec start, renderdone;
   clock_gettime(CLOCK_MONOTONIC, &start);
+  const uint64_t tstart = nctrace_begin();
   notcurses* nc = ncplane_notcurses(n);
   ncpile* pile = ncplane_pile(n);
   // update our notion of screen geometry, and render against that
@@ -1580,14 +3542,144 @@ int ncpile_render(ncplane* n){
     pile->cellpxx = nc->tcache.cellpxx;
     pgeo_changed = 1;
   }
-  if(engorge_crender_vector(pile)){
+  unsigned begy, endy;
+  ncpile_render_rows(pile, pgeo_changed, &begy, &endy);
+  if(engorge_crender_vector(pile, &begy, &endy)){
+    pile->dmgall = true;
     return -1;
   }
-  ncpile_render_internal(pile, pgeo_changed);
+  uint64_t bandns = 0;
+  int64_t bandmaxns = 0;
+  uint64_t proft = prof_clock(nc);
+  ncpile_render_internal(pile, begy, endy, &bandns, &bandmaxns);
+  prof_phase(nc, PROF_PAINT, &proft);
+  // the solved rows are postpainted at rasterization (they always cover any
+  // rows solved by an earlier, unrasterized render).
+  if(begy < endy){
+    pile->solvedbeg = begy;
+    pile->solvedend = endy;
+    pile->solvedbegx = 0;
+    pile->solvedendx = pile->dimx;
+  }
+  // leftover crenders might refer to sprixels about to be destroyed. make
+  // sure the first render following their departure is a full one.
+  if(pile->sprixelcache){
+    pile->dmgall = true;
+  }
   clock_gettime(CLOCK_MONOTONIC, &renderdone);
-  pthread_mutex_lock(&nc->stats.lock);
-    update_render_stats(&renderdone, &start, &nc->stats.s);
-  pthread_mutex_unlock(&nc->stats.lock);
+  stats_lock(&nc->stats);
+    update_render_stats(&renderdone, &start, &nc->stats);
+    update_render_band_stats(&nc->stats.s, bandns, bandmaxns);
+  stats_unlock(&nc->stats);
+  nctrace_end("ncpile_render", tstart, "rows", endy - begy);
+  return 0;
+}
+
+// solve columns [begx, endx) of rows [begy, endy) of |p| anew, leaving the
+// remainder of its rvec be. the region is solved into the scratch rgnrender
+// (paint() addresses any target area), and copied into place.
+static int
+ncpile_render_patch(ncpile* p, unsigned begy, unsigned endy,
+                    unsigned begx, unsigned endx){
+  const unsigned rows = endy - begy;
+  // a wide glyph in our last column must see the column to its right
+  const unsigned cols = endx - begx + (endx < p->dimx);
+  const size_t cells = (size_t)rows * cols;
+  if(cells > p->rgnrenderlen){
+    struct crender* tmp = realloc(p->rgnrender, sizeof(*tmp) * cells);
+    if(tmp == NULL){
+      return -1;
+    }
+    p->rgnrender = tmp;
+    p->rgnrenderlen = cells;
+  }
+  init_rvec(p->rgnrender, cells);
+  for(unsigned y = 0 ; y < rows ; ++y){
+    p->unsolved[y] = cols;
+  }
+  sprixel* unused = NULL;
+  for(ncplane* pl = p->top ; pl ; pl = pl->below){
+    if(pl->absy >= (int)endy || pl->absy + (int)pl->leny <= (int)begy ||
+       pl->absx >= (int)(begx + cols) || pl->absx + (int)pl->lenx <= (int)begx){
+      continue;
+    }
+    paint(pl, p->rgnrender, rows, cols, begy, begx, &unused, 0, rows,
+          p->unsolved);
+  }
+  for(unsigned y = 0 ; y < rows ; ++y){
+    memcpy(&p->crender[fbcellidx(begy + y, p->dimx, begx)],
+           &p->rgnrender[y * cols], sizeof(*p->rgnrender) * (endx - begx));
+  }
+  return 0;
+}
+
+int ncpile_render_region(ncplane* n, unsigned y, unsigned x,
+                         unsigned leny, unsigned lenx){
+  notcurses* nc = ncplane_notcurses(n);
+  if(settle_async_init(nc)){
+    return -1;
+  }
+  ncpile* pile = ncplane_pile(n);
+  notcurses_resize_internal(n, NULL, NULL);
+  // the previous solution can only be patched under the same conditions
+  // which allow ncpile_render() to solve only damaged rows. a pending
+  // scroll is likewise only applied by a full render.
+  const unsigned pgeo_changed = pile->cellpxy != nc->tcache.cellpxy ||
+                                pile->cellpxx != nc->tcache.cellpxx;
+  if(ncpile_solve_all_p(pile, pgeo_changed) || pile->rasterizer ||
+     pile->planescrolls || pile->rgnscrolls ||
+     pile->crenderlen != (size_t)pile->dimy * pile->dimx ||
+     pile->unsolvedlen < pile->dimy){
+    return ncpile_render(n);
+  }
+  if(y >= pile->dimy || x >= pile->dimx){
+    return 0; // entirely offscreen
+  }
+  if(leny == 0 || leny > pile->dimy - y){
+    leny = pile->dimy - y;
+  }
+  if(lenx == 0 || lenx > pile->dimx - x){
+    lenx = pile->dimx - x;
+  }
+  struct timespec start, renderdone;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  const uint64_t tstart = nctrace_begin();
+  // widen by a column to either side, so that wide glyphs straddling the
+  // region's edges are solved together with it.
+  unsigned begy = y, endy = y + leny;
+  unsigned begx = x ? x - 1 : 0;
+  unsigned endx = x + lenx < pile->dimx ? x + lenx + 1 : pile->dimx;
+  // anything solved but not yet postpainted must be solved again with us
+  if(pile->solvedbeg < pile->solvedend){
+    if(pile->solvedbeg < begy){
+      begy = pile->solvedbeg;
+    }
+    if(pile->solvedend > endy){
+      endy = pile->solvedend;
+    }
+    if(pile->solvedbegx < begx){
+      begx = pile->solvedbegx;
+    }
+    if(pile->solvedendx > endx){
+      endx = pile->solvedendx;
+    }
+  }
+  uint64_t proft = prof_clock(nc);
+  if(ncpile_render_patch(pile, begy, endy, begx, endx)){
+    pile->dmgall = true;
+    return -1;
+  }
+  prof_phase(nc, PROF_PAINT, &proft);
+  pile->solvedbeg = begy;
+  pile->solvedend = endy;
+  pile->solvedbegx = begx;
+  pile->solvedendx = endx;
+  clock_gettime(CLOCK_MONOTONIC, &renderdone);
+  stats_lock(&nc->stats);
+    update_render_stats(&renderdone, &start, &nc->stats);
+  stats_unlock(&nc->stats);
+  nctrace_end("ncpile_render_region", tstart, "cells",
+              (endy - begy) * (endx - begx));
   return 0;
 }
 
@@ -1600,9 +3692,9 @@ int ncpile_render_to_buffer(ncplane* p, char** buf, size_t* buflen){
   unsigned useasu = false; // no SUM with file
   fbuf_reset(&nc->rstate.f);
   int bytes = notcurses_rasterize_inner(nc, ncplane_pile(p), &nc->rstate.f, &useasu);
-  pthread_mutex_lock(&nc->stats.lock);
+  stats_lock(&nc->stats);
     update_raster_bytes(&nc->stats.s, bytes);
-  pthread_mutex_unlock(&nc->stats.lock);
+  stats_unlock(&nc->stats);
   if(bytes < 0){
     return -1;
   }
@@ -1612,6 +3704,728 @@ int ncpile_render_to_buffer(ncplane* p, char** buf, size_t* buflen){
   return 0;
 }
 
+#define CAPTURE_VERSION 1
+#define CAPTURE_FLAG_DELTA 0x1
+#define CAPTURE_COUNT_OFFSET 16
+
+void ncpile_capture_free(ncpile* p){
+  free(p->capframe);
+  p->capframe = NULL;
+  egcpool_dump(&p->cappool);
+  p->capdimy = p->capdimx = 0;
+}
+
+// write the low |bytes| bytes of |v| to |f|, little-endian.
+static int
+capture_put(fbuf* f, uint64_t v, unsigned bytes){
+  char b[8];
+  for(unsigned i = 0 ; i < bytes ; ++i){
+    b[i] = v >> (i * 8);
+  }
+  return fbuf_putn(f, b, bytes) < 0 ? -1 : 0;
+}
+
+// record |c| (whose EGC lives in |src|) at |idx| into the capture frame, and
+// unless we're taking a delta and it hasn't changed, write it out.
+static int
+capture_cell(ncpile* p, fbuf* f, const ncplane* src, const nccell* c,
+             unsigned idx, bool delta, uint32_t* count){
+  if(cellcmp_and_dupfar(&p->cappool, &p->capframe[idx], src, c) == 0 && delta){
+    return 0;
+  }
+  const char* egc = nccell_extended_gcluster(src, c);
+  const size_t egclen = strlen(egc);
+  if(egclen > NCCAPTURE_EGC_MAX){
+    logerror("EGC of %zuB at %u", egclen, idx);
+    return -1;
+  }
+  if(delta && capture_put(f, idx, 4)){
+    return -1;
+  }
+  if(capture_put(f, c->channels, 8) || capture_put(f, c->stylemask, 2) ||
+     capture_put(f, c->width, 1) || capture_put(f, egclen, 2)){
+    return -1;
+  }
+  if(egclen && fbuf_putn(f, egc, egclen) < 0){
+    return -1;
+  }
+  ++*count;
+  return 0;
+}
+
+// the crender vector holds the solved frame for every row: rows solved by the
+// last render await postpaint, so we lock in their highcontrast (on a copy),
+// while earlier rows were already postpainted. wide glyphs' right columns are
+// written as blanks of width 0 in either case. nothing is rasterized, and the
+// lastframe and rstate are left alone.
+int ncpile_capture(ncplane* n, bool delta, char** buf, size_t* buflen){
+  notcurses* nc = ncplane_notcurses(n);
+  ncpile* p = ncplane_pile(n);
+  const unsigned dimy = p->dimy;
+  const unsigned dimx = p->dimx;
+  if(p->crender == NULL || p->crenderlen != (size_t)dimy * dimx){
+    logerror("pile has not been rendered");
+    return -1;
+  }
+  if(dimy > NCCAPTURE_DIM_MAX || dimx > NCCAPTURE_DIM_MAX ||
+     (size_t)dimy * dimx > NCCAPTURE_CELLS_MAX){
+    logerror("pile too large to capture (%ux%u)", dimy, dimx);
+    return -1;
+  }
+  if(p->capframe && (p->capdimy != dimy || p->capdimx != dimx)){
+    ncpile_capture_free(p);
+  }
+  if(p->capframe == NULL){
+    delta = false;
+    if((p->capframe = calloc((size_t)dimy * dimx, sizeof(*p->capframe))) == NULL){
+      return -1;
+    }
+    p->capdimy = dimy;
+    p->capdimx = dimx;
+  }
+  fbuf f = {0};
+  if(fbuf_initgrow(&f, 1)){
+    return -1;
+  }
+  const tinfo* ti = &nc->tcache;
+  uint32_t count = 0;
+  int ret = 0;
+  if(fbuf_putn(&f, "NCAP", 4) < 0 || capture_put(&f, CAPTURE_VERSION, 1) ||
+     capture_put(&f, delta ? CAPTURE_FLAG_DELTA : 0, 1) ||
+     capture_put(&f, 0, 2) || capture_put(&f, dimy, 4) ||
+     capture_put(&f, dimx, 4) || capture_put(&f, 0, 4)){
+    ret = -1;
+  }
+  for(unsigned y = 0 ; y < dimy && ret == 0 ; ++y){
+    const bool solved = y >= p->solvedbeg && y < p->solvedend;
+    for(unsigned x = 0 ; x < dimx && ret == 0 ; ++x){
+      const unsigned idx = y * dimx + x;
+      struct crender* cr = &p->crender[idx];
+      nccell c = cr->c;
+      if(solved && x >= p->solvedbegx && x < p->solvedendx){
+        lock_in_highcontrast(nc, ti, &c, cr);
+      }
+      ret = capture_cell(p, &f, cr->p, &c, idx, delta, &count);
+      nccell right = {
+        .channels = c.channels,
+        .stylemask = c.stylemask,
+      };
+      for(unsigned i = 1 ; i < c.width && x + 1 < dimx && ret == 0 ; ++i){
+        ++x;
+        ret = capture_cell(p, &f, cr->p, &right, idx + i, delta, &count);
+      }
+    }
+  }
+  if(ret){
+    // the capture frame might be partially updated; start afresh next time
+    ncpile_capture_free(p);
+    fbuf_free(&f);
+    return -1;
+  }
+  for(unsigned i = 0 ; i < 4 ; ++i){
+    f.buf[CAPTURE_COUNT_OFFSET + i] = count >> (i * 8);
+  }
+  // the fbuf might be mapped; the caller free()s what we return
+  if((*buf = malloc(f.used)) == NULL){
+    ncpile_capture_free(p);
+    fbuf_free(&f);
+    return -1;
+  }
+  memcpy(*buf, f.buf, f.used);
+  *buflen = f.used;
+  fbuf_free(&f);
+  return 0;
+}
+
+#undef CAPTURE_COUNT_OFFSET
+#undef CAPTURE_FLAG_DELTA
+#undef CAPTURE_VERSION
+
+// set up the private context of |r| (which must be zeroed) for output of
+// type |termtype|, or like that of |nc| if |termtype| is NULL. the terminal
+// description itself is loaded into the view later, under pilelock.
+static int
+rasterizer_init(ncrasterizer* r, notcurses* nc, const char* termtype, bool rgb){
+  notcurses* v = &r->view;
+  if(termtype){
+    r->shared = termdesc_acquire(termtype, rgb, nc->tcache.caps.utf8);
+    if(r->shared == NULL){
+      return -1;
+    }
+  }
+  if(pthread_mutex_init(&v->stats.lock, NULL)){
+    termdesc_release(r->shared);
+    return -1;
+  }
+  // frames are usually small; grow the buffer on demand
+  if(fbuf_initgrow(&v->rstate.f, 1)){
+    pthread_mutex_destroy(&v->stats.lock);
+    termdesc_release(r->shared);
+    return -1;
+  }
+  r->nc = nc;
+  return 0;
+}
+
+// load the terminal description and palette into the view. call with
+// pilelock held.
+static void
+rasterizer_load_tinfo(ncrasterizer* r){
+  notcurses* v = &r->view;
+  v->tcache = r->shared ? *r->shared : r->nc->tcache;
+  v->palette = r->nc->palette;
+  // bitmaps are refused, so the pixel machinery is never wanted
+  v->tcache.pixel_scroll = NULL;
+}
+
+static void
+rasterizer_fini(ncrasterizer* r){
+  notcurses* v = &r->view;
+  fbuf_free(&v->rstate.f);
+  free(v->lastframe);
+  egcpool_dump(&v->pool);
+  pthread_mutex_destroy(&v->stats.lock);
+  termdesc_release(r->shared);
+}
+
+ncrasterizer* ncrasterizer_create(ncplane* n, const ncrasterizer_options* opts){
+  ncrasterizer_options zeroed = {0};
+  if(opts == NULL){
+    opts = &zeroed;
+  }
+  if(opts->flags > NCRASTERIZER_OPTION_RGB){
+    logwarn("provided unsupported flags %016" PRIx64, opts->flags);
+  }
+  if(!opts->rows != !opts->cols){
+    logerror("geometry must be specified in full (%ux%u)", opts->rows, opts->cols);
+    return NULL;
+  }
+  notcurses* nc = ncplane_notcurses(n);
+  ncpile* p = ncplane_pile(n);
+  if(p == ncplane_pile(notcurses_stdplane(nc))){
+    logerror("can't bind the standard pile");
+    return NULL;
+  }
+  ncrasterizer* r = malloc(sizeof(*r));
+  if(r == NULL){
+    return NULL;
+  }
+  memset(r, 0, sizeof(*r));
+  if(rasterizer_init(r, nc, opts->termtype, opts->flags & NCRASTERIZER_OPTION_RGB)){
+    free(r);
+    return NULL;
+  }
+  r->rows = opts->rows;
+  r->cols = opts->cols;
+  pthread_mutex_lock(&nc->pilelock);
+    const bool taken = p->rasterizer != NULL;
+    if(!taken){
+      p->rasterizer = r;
+      p->dmgall = true;
+      r->pile = p;
+      rasterizer_load_tinfo(r);
+    }
+  pthread_mutex_unlock(&nc->pilelock);
+  if(taken){
+    logerror("pile is already bound to a rasterizer");
+    ncrasterizer_destroy(r);
+    return NULL;
+  }
+  return r;
+}
+
+int ncrasterizer_resize(ncrasterizer* r, unsigned rows, unsigned cols){
+  if(!rows != !cols){
+    logerror("geometry must be specified in full (%ux%u)", rows, cols);
+    return -1;
+  }
+  r->rows = rows;
+  r->cols = cols;
+  return 0;
+}
+
+void rasterizer_unbind(ncrasterizer* r){
+  r->pile = NULL;
+  r->view.last_pile = NULL;
+}
+
+void ncrasterizer_destroy(ncrasterizer* r){
+  if(r){
+    pthread_mutex_lock(&r->nc->pilelock);
+      if(r->pile){
+        // the pile's last solution was made against our lastframe, not the
+        // terminal's; discard it, and solve everything at the next render.
+        r->pile->rasterizer = NULL;
+        r->pile->solvedbeg = r->pile->solvedend = 0;
+        r->pile->dmgall = true;
+      }
+    pthread_mutex_unlock(&r->nc->pilelock);
+    rasterizer_fini(r);
+    free(r);
+  }
+}
+
+// damage any palette entries which differ from |pal| since the last frame.
+static void
+rasterizer_sync_palette(ncrasterizer* r, const ncpalette* pal){
+  notcurses* v = &r->view;
+  for(size_t i = 0 ; i < sizeof(pal->chans) / sizeof(*pal->chans) ; ++i){
+    if(v->palette.chans[i] != pal->chans[i]){
+      v->palette.chans[i] = pal->chans[i];
+      v->palette_damage[i] = true;
+    }
+  }
+}
+
+// move the counters accumulated by the private context into the real one.
+static void
+rasterizer_fold_stats(ncrasterizer* r, int bytes, const struct timespec* start,
+                      const struct timespec* done){
+  ncstats* vs = &r->view.stats.s;
+  notcurses* nc = r->nc;
+  stats_lock(&nc->stats);
+    ncstats* s = &nc->stats.s;
+    s->cellelisions += vs->cellelisions;
+    s->cellemissions += vs->cellemissions;
+    s->fgelisions += vs->fgelisions;
+    s->fgemissions += vs->fgemissions;
+    s->bgelisions += vs->bgelisions;
+    s->bgemissions += vs->bgemissions;
+    s->defaultelisions += vs->defaultelisions;
+    s->defaultemissions += vs->defaultemissions;
+    s->hpa_gratuitous += vs->hpa_gratuitous;
+    update_raster_bytes(s, bytes);
+    update_raster_stats(done, start, &nc->stats);
+  stats_unlock(&nc->stats);
+  memset(vs, 0, sizeof(*vs));
+}
+
+// the first frame, and any following a change of geometry, is drawn in its
+// entirety: the lastframe is replaced with a blank one, and every cell is
+// damaged (the blank lastframe would otherwise match blank cells, and we know
+// nothing of what the output currently shows).
+static int
+rasterizer_restripe(ncrasterizer* r, ncpile* p){
+  notcurses* v = &r->view;
+  nccell* lf = calloc((size_t)p->dimy * p->dimx, sizeof(*lf));
+  if(lf == NULL){
+    return -1;
+  }
+  free(v->lastframe);
+  egcpool_dump(&v->pool);
+  v->lastframe = lf;
+  v->lfdimy = p->dimy;
+  v->lfdimx = p->dimx;
+  v->tcache.dimy = p->dimy;
+  v->tcache.dimx = p->dimx;
+  v->rstate.y = -1;
+  v->rstate.x = -1;
+  // scrolling is subsumed by the redraw
+  p->scrolls = 0;
+  p->rgnscrolls = 0;
+  p->scrollplane = NULL;
+  p->planescrolls = 0;
+  return 0;
+}
+
+// rasterize the last render of the bound pile into r's rstate.
+static int
+rasterizer_frame(ncrasterizer* r){
+  struct timespec start, done;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ncpile* p = r->pile;
+  notcurses* v = &r->view;
+  if(p == NULL){
+    logerror("bound pile has been destroyed");
+    return -1;
+  }
+  if(p->sprixelcache){
+    logerror("can't rasterize bitmaps with an ncrasterizer");
+    return -1;
+  }
+  const uint64_t tstart = nctrace_begin();
+  const bool redraw = v->lastframe == NULL || v->lfdimy != p->dimy ||
+                      v->lfdimx != p->dimx;
+  if(redraw){
+    if(rasterizer_restripe(r, p)){
+      return -1;
+    }
+  }else{
+    scroll_lastframe(v, p->scrolls);
+    plan_region_scroll(v, p);
+  }
+  v->last_pile = p;
+  if(v->tcache.caps.can_change_colors){
+    rasterizer_sync_palette(r, &r->nc->palette);
+  }
+  fbuf_reset(&v->rstate.f);
+  p->spansvalid = false;
+  postpaint(v, &v->tcache, v->lastframe, p->solvedbeg, p->solvedend,
+            p->solvedbegx, p->solvedendx, p->dimx, p->crender, p, &v->pool,
+            NULL);
+  p->solvedbeg = p->solvedend = 0;
+  if(redraw){
+    for(size_t i = 0 ; i < (size_t)p->dimy * p->dimx ; ++i){
+      p->crender[i].s.damaged = 1;
+    }
+  }
+  unsigned asu = 0;
+  int bytes = notcurses_rasterize_inner(v, p, &v->rstate.f, &asu);
+  if(bytes < 0){
+    // we no longer know what the output shows
+    free(v->lastframe);
+    v->lastframe = NULL;
+    p->dmgall = true;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &done);
+  nctrace_end("ncrasterizer_frame", tstart, "bytes", bytes);
+  rasterizer_fold_stats(r, bytes, &start, &done);
+  return bytes < 0 ? -1 : 0;
+}
+
+int ncrasterizer_rasterize(ncrasterizer* r, char** buf, size_t* buflen){
+  if(rasterizer_frame(r)){
+    return -1;
+  }
+  // the rstate buffer might be mapped, and is anyway reused; copy it out
+  const fbuf* f = &r->view.rstate.f;
+  if((*buf = malloc(f->used ? f->used : 1)) == NULL){
+    free(r->view.lastframe);
+    r->view.lastframe = NULL;
+    return -1;
+  }
+  memcpy(*buf, f->buf, f->used);
+  *buflen = f->used;
+  return 0;
+}
+
+int ncrasterizer_write(ncrasterizer* r, int fd){
+  if(rasterizer_frame(r)){
+    return -1;
+  }
+  const fbuf* f = &r->view.rstate.f;
+  if(blocking_write(fd, f->buf, f->used)){
+    // we no longer know what the output shows
+    free(r->view.lastframe);
+    r->view.lastframe = NULL;
+    return -1;
+  }
+  return 0;
+}
+
+// a frame published to the mirrors of a pile: a copy of the lastframe (and
+// the EGCs it references) as of a rasterization to the terminal. shared by
+// all the pile's mirrors, and freed once the last is done with it.
+typedef struct mirrorframe {
+  unsigned refs;        // mirrors yet to release us (atomic)
+  unsigned dimy, dimx;
+  nccell* cells;
+  egcpool pool;         // only ->pool is meaningful
+  ncpalette palette;
+} mirrorframe;
+
+// an ncmirror rasterizes published frames on its own thread, using the
+// private context of an ncrasterizer. each frame is loaded into a private
+// pile's crender vector, its EGCs provided by a private plane, and written
+// relative to the mirror's own lastframe. only the latest frame is kept;
+// unlike the raster writer's output, a frame here is complete in itself, so
+// superseded frames can simply be skipped.
+typedef struct ncmirror {
+  ncrasterizer r;        // private raster state; r.pile is &vpile
+  ncpile vpile;          // carries the frame being written
+  ncplane vplane;        // its pool references the frame's EGCs
+  size_t crenderlen;     // crenders allocated in vpile
+  ncpile* pile;          // mirrored pile, NULL once destroyed (pilelock)
+  struct ncmirror* next; // mirrors of the same pile (pilelock)
+  int fd;
+  pthread_t tid;
+  pthread_mutex_t lock;  // guards everything below
+  pthread_cond_t cond;   // signaled on a new frame, or shutdown
+  pthread_cond_t idlecond; // signaled whenever we go idle
+  mirrorframe* pending;  // published, but not yet claimed
+  bool busy;             // are we writing a frame?
+  bool failed;           // has a write failed since the last drain?
+  bool done;
+  uint64_t skipped;      // frames superseded before being written
+} ncmirror;
+
+static void
+mirrorframe_release(mirrorframe* f){
+  if(__atomic_sub_fetch(&f->refs, 1, __ATOMIC_ACQ_REL) == 0){
+    free(f->cells);
+    free(f->pool.pool);
+    free(f);
+  }
+}
+
+// copy the lastframe of |nc|, just rasterized from |p|, for p's mirrors.
+static mirrorframe*
+mirrorframe_create(const notcurses* nc, const ncpile* p, unsigned refs){
+  mirrorframe* f = malloc(sizeof(*f));
+  if(f == NULL){
+    return NULL;
+  }
+  memset(f, 0, sizeof(*f));
+  f->refs = refs;
+  f->dimy = p->dimy;
+  f->dimx = p->dimx;
+  if((f->cells = calloc((size_t)f->dimy * f->dimx, sizeof(*f->cells))) == NULL){
+    free(f);
+    return NULL;
+  }
+  if(nc->pool.poolwrite){
+    if((f->pool.pool = malloc(nc->pool.poolwrite)) == NULL){
+      free(f->cells);
+      free(f);
+      return NULL;
+    }
+    memcpy(f->pool.pool, nc->pool.pool, nc->pool.poolwrite);
+    f->pool.poolsize = f->pool.poolused = f->pool.poolwrite = nc->pool.poolwrite;
+  }
+  const unsigned rows = nc->lfdimy < f->dimy ? nc->lfdimy : f->dimy;
+  const unsigned cols = nc->lfdimx < f->dimx ? nc->lfdimx : f->dimx;
+  for(unsigned y = 0 ; y < rows ; ++y){
+    memcpy(&f->cells[y * f->dimx], &nc->lastframe[y * nc->lfdimx],
+           sizeof(*f->cells) * cols);
+  }
+  f->palette = nc->palette;
+  return f;
+}
+
+// hand the frame just rasterized from |p| to each of its mirrors, replacing
+// any frame they've yet to claim.
+static void
+mirrors_publish(notcurses* nc, ncpile* p){
+  pthread_mutex_lock(&nc->pilelock);
+  unsigned count = 0;
+  for(ncmirror* m = p->mirrors ; m ; m = m->next){
+    ++count;
+  }
+  mirrorframe* f = NULL;
+  if(count && nc->lastframe && (f = mirrorframe_create(nc, p, count)) == NULL){
+    logwarn("couldn't publish frame to %u mirrors", count);
+  }
+  if(f){
+    for(ncmirror* m = p->mirrors ; m ; m = m->next){
+      pthread_mutex_lock(&m->lock);
+      mirrorframe* old = m->pending;
+      m->pending = f;
+      if(old){
+        ++m->skipped;
+      }
+      pthread_mutex_unlock(&m->lock);
+      pthread_cond_signal(&m->cond);
+      if(old){
+        mirrorframe_release(old);
+      }
+    }
+  }
+  pthread_mutex_unlock(&nc->pilelock);
+}
+
+void mirrors_unbind(ncpile* p){
+  while(p->mirrors){
+    ncmirror* m = p->mirrors;
+    p->mirrors = m->next;
+    m->next = NULL;
+    m->pile = NULL;
+  }
+}
+
+// write |f| to the mirror's output, relative to the last frame we wrote.
+static int
+mirror_frame(ncmirror* m, const mirrorframe* f){
+  struct timespec start, done;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ncpile* p = &m->vpile;
+  notcurses* v = &m->r.view;
+  const size_t cells = (size_t)f->dimy * f->dimx;
+  if(cells > m->crenderlen){
+    struct crender* tmp = realloc(p->crender, sizeof(*tmp) * cells);
+    if(tmp == NULL){
+      return -1;
+    }
+    p->crender = tmp;
+    m->crenderlen = cells;
+  }
+  p->dimy = f->dimy;
+  p->dimx = f->dimx;
+  memset(p->crender, 0, sizeof(*p->crender) * cells);
+  for(size_t i = 0 ; i < cells ; ++i){
+    p->crender[i].c = f->cells[i];
+    p->crender[i].p = &m->vplane;
+  }
+  m->vplane.pool.pool = f->pool.pool;
+  const bool redraw = v->lastframe == NULL || v->lfdimy != p->dimy ||
+                      v->lfdimx != p->dimx;
+  if(redraw && rasterizer_restripe(&m->r, p)){
+    return -1;
+  }
+  v->last_pile = p;
+  if(v->tcache.caps.can_change_colors){
+    rasterizer_sync_palette(&m->r, &f->palette);
+  }
+  fbuf_reset(&v->rstate.f);
+  postpaint(v, &v->tcache, v->lastframe, 0, p->dimy, 0, p->dimx, p->dimx,
+            p->crender, p, &v->pool, NULL);
+  if(redraw){
+    for(size_t i = 0 ; i < cells ; ++i){
+      p->crender[i].s.damaged = 1;
+    }
+  }
+  unsigned asu = 0;
+  int bytes = notcurses_rasterize_inner(v, p, &v->rstate.f, &asu);
+  if(bytes >= 0 && blocking_write(m->fd, v->rstate.f.buf, v->rstate.f.used)){
+    bytes = -1;
+  }
+  if(bytes < 0){
+    // we no longer know what the output shows
+    free(v->lastframe);
+    v->lastframe = NULL;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &done);
+  rasterizer_fold_stats(&m->r, bytes, &start, &done);
+  return bytes < 0 ? -1 : 0;
+}
+
+static void*
+mirror_thread(void* vm){
+  ncmirror* m = vm;
+  nc_thread_setup("mirror");
+  sigset_t oldmask;
+  block_signals(&oldmask);
+  pthread_mutex_lock(&m->lock);
+  for(;;){
+    while(m->pending == NULL && !m->done){
+      pthread_cond_wait(&m->cond, &m->lock);
+    }
+    if(m->pending == NULL){ // shutting down, and nothing left to write
+      break;
+    }
+    mirrorframe* f = m->pending;
+    m->pending = NULL;
+    m->busy = true;
+    pthread_mutex_unlock(&m->lock);
+    const int r = mirror_frame(m, f);
+    mirrorframe_release(f);
+    pthread_mutex_lock(&m->lock);
+    m->busy = false;
+    if(r){
+      m->failed = true;
+    }
+    if(m->pending == NULL){
+      pthread_cond_broadcast(&m->idlecond);
+    }
+  }
+  pthread_mutex_unlock(&m->lock);
+  return NULL;
+}
+
+ncmirror* ncmirror_create(ncplane* n, int fd, const ncmirror_options* opts){
+  ncmirror_options zeroed = {0};
+  if(opts == NULL){
+    opts = &zeroed;
+  }
+  if(opts->flags > NCMIRROR_OPTION_RGB){
+    logwarn("provided unsupported flags %016" PRIx64, opts->flags);
+  }
+  if(fd < 0){
+    logerror("invalid file descriptor %d", fd);
+    return NULL;
+  }
+  notcurses* nc = ncplane_notcurses(n);
+  ncmirror* m = malloc(sizeof(*m));
+  if(m == NULL){
+    return NULL;
+  }
+  memset(m, 0, sizeof(*m));
+  if(rasterizer_init(&m->r, nc, opts->termtype, opts->flags & NCMIRROR_OPTION_RGB)){
+    free(m);
+    return NULL;
+  }
+  m->r.pile = &m->vpile;
+  m->vpile.nc = &m->r.view;
+  m->fd = fd;
+  if(pthread_mutex_init(&m->lock, NULL)){
+    rasterizer_fini(&m->r);
+    free(m);
+    return NULL;
+  }
+  if(pthread_cond_init(&m->cond, NULL)){
+    pthread_mutex_destroy(&m->lock);
+    rasterizer_fini(&m->r);
+    free(m);
+    return NULL;
+  }
+  if(pthread_cond_init(&m->idlecond, NULL)){
+    pthread_cond_destroy(&m->cond);
+    pthread_mutex_destroy(&m->lock);
+    rasterizer_fini(&m->r);
+    free(m);
+    return NULL;
+  }
+  pthread_mutex_lock(&nc->pilelock);
+    rasterizer_load_tinfo(&m->r);
+  pthread_mutex_unlock(&nc->pilelock);
+  if(pthread_create(&m->tid, NULL, mirror_thread, m)){
+    logerror("couldn't spin up mirror thread");
+    pthread_cond_destroy(&m->idlecond);
+    pthread_cond_destroy(&m->cond);
+    pthread_mutex_destroy(&m->lock);
+    rasterizer_fini(&m->r);
+    free(m);
+    return NULL;
+  }
+  pthread_mutex_lock(&nc->pilelock);
+    ncpile* p = ncplane_pile(n);
+    m->pile = p;
+    m->next = p->mirrors;
+    p->mirrors = m;
+  pthread_mutex_unlock(&nc->pilelock);
+  loginfo("mirroring pile %p to %d", p, fd);
+  return m;
+}
+
+int ncmirror_drain(ncmirror* m){
+  pthread_mutex_lock(&m->lock);
+  while(m->busy || m->pending){
+    pthread_cond_wait(&m->idlecond, &m->lock);
+  }
+  const int ret = m->failed ? -1 : 0;
+  m->failed = false;
+  pthread_mutex_unlock(&m->lock);
+  return ret;
+}
+
+void ncmirror_destroy(ncmirror* m){
+  if(m == NULL){
+    return;
+  }
+  pthread_mutex_lock(&m->r.nc->pilelock);
+    if(m->pile){
+      ncmirror** prev = &m->pile->mirrors;
+      while(*prev != m){
+        prev = &(*prev)->next;
+      }
+      *prev = m->next;
+    }
+  pthread_mutex_unlock(&m->r.nc->pilelock);
+  // the thread writes out any pending frame before exiting
+  pthread_mutex_lock(&m->lock);
+  m->done = true;
+  pthread_mutex_unlock(&m->lock);
+  pthread_cond_signal(&m->cond);
+  pthread_join(m->tid, NULL);
+  loginfo("mirror to %d skipped %" PRIu64 " frames", m->fd, m->skipped);
+  pthread_cond_destroy(&m->idlecond);
+  pthread_cond_destroy(&m->cond);
+  pthread_mutex_destroy(&m->lock);
+  free(m->vpile.crender);
+  rasterizer_fini(&m->r);
+  free(m);
+}
+
+
 // copy the UTF8-encoded EGC out of the cell, whether simple or complex. the
 // result is not tied to the ncplane, and persists across erases / destruction.
 static inline char*
@@ -1665,6 +4479,9 @@ int ncdirect_set_bg_rgb_f(ncdirect* nc, unsigned rgb, fbuf* f){
 }
 
 int ncdirect_set_bg_rgb(ncdirect* nc, unsigned rgb){
+  if(nc->batch){
+    return ncdirect_set_bg_rgb_f(nc, rgb, nc->batch);
+  }
   fbuf f = {0};
   if(fbuf_init_small(&f)){
     return -1;
@@ -1695,6 +4512,9 @@ int ncdirect_set_fg_rgb_f(ncdirect* nc, unsigned rgb, fbuf* f){
 }
 
 int ncdirect_set_fg_rgb(ncdirect* nc, unsigned rgb){
+  if(nc->batch){
+    return ncdirect_set_fg_rgb_f(nc, rgb, nc->batch);
+  }
   fbuf f = {0};
   if(fbuf_init_small(&f)){
     return -1;
@@ -1745,6 +4565,7 @@ int notcurses_cursor_enable(notcurses* nc, int y, int x){
   if(nc->cursory == y && nc->cursorx == x){
     return 0;
   }
+  raster_writer_wait(nc->rwriter);
   fbuf f = {0};
   if(fbuf_init_small(&f)){
     return -1;
@@ -1774,6 +4595,7 @@ int notcurses_cursor_disable(notcurses* nc){
     logerror("cursor is not enabled");
     return -1;
   }
+  raster_writer_wait(nc->rwriter);
   const char* cinvis = get_escape(&nc->tcache, ESCAPE_CIVIS);
   if(cinvis){
     if(!tty_emit(cinvis, nc->tcache.ttyfd) && !ncflush(nc->ttyfp)){
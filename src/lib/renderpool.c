@@ -0,0 +1,177 @@
+#include "internal.h"
+
+// the render engine is a small pool of worker threads which assist the
+// calling thread in painting disjoint row bands of a pile's crender vector.
+// a job is some number of bands and a function to apply to each. bands are
+// claimed dynamically, so uneven planes don't leave workers idling while one
+// grinds through a dense band. the caller always participates, and only one job can
+// be in flight at a time (piles rendered concurrently from other threads
+// fall back to painting serially).
+typedef struct render_engine {
+  pthread_mutex_t joblock;  // held by the thread submitting the current job
+  pthread_mutex_t lock;     // guards everything below
+  pthread_cond_t cond;      // signaled on new work or shutdown
+  pthread_cond_t donecond;  // signaled when the last band completes
+  pthread_t* tids;
+  unsigned threads;         // worker threads, not counting the caller
+  renderband_fxn fxn;       // applied to each band of the job
+  void* curry;
+  unsigned bands;           // total bands in the current job
+  unsigned nextband;        // next band to be claimed
+  unsigned bandsdone;       // completed bands in the current job
+  int64_t maxns;            // longest single band in the current job
+  uint64_t sumns;           // total band time in the current job
+  bool done;
+} render_engine;
+
+// claim and execute bands until none remain. call with the lock held; it
+// is held again on return. bands are claimed (and the job read) under the
+// lock, so a late-waking worker can never apply one job's function to
+// another job's band.
+static void
+work_bands(render_engine* re){
+  while(re->nextband < re->bands){
+    const unsigned b = re->nextband++;
+    const unsigned bands = re->bands;
+    renderband_fxn fxn = re->fxn;
+    void* curry = re->curry;
+    pthread_mutex_unlock(&re->lock);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    fxn(curry, b, bands);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    const int64_t elapsed = timespec_to_ns(&t1) - timespec_to_ns(&t0);
+    pthread_mutex_lock(&re->lock);
+    re->sumns += elapsed;
+    if(elapsed > re->maxns){
+      re->maxns = elapsed;
+    }
+    if(++re->bandsdone == re->bands){
+      pthread_cond_signal(&re->donecond);
+    }
+  }
+}
+
+static void*
+render_worker(void* v){
+  render_engine* re = v;
+  nc_thread_setup("render");
+  pthread_mutex_lock(&re->lock);
+  while(!re->done){
+    if(re->nextband >= re->bands){
+      pthread_cond_wait(&re->cond, &re->lock);
+      continue;
+    }
+    work_bands(re);
+  }
+  pthread_mutex_unlock(&re->lock);
+  return NULL;
+}
+
+// how many threads ought paint? NOTCURSES_RENDER_THREADS overrides the
+// number of online processors. the result includes the calling thread.
+static unsigned
+render_threads_wanted(void){
+  const char* rt = getenv("NOTCURSES_RENDER_THREADS");
+  if(rt){
+    char* endl;
+    unsigned long l = strtoul(rt, &endl, 10);
+    if(*rt && !*endl && l > 0 && l <= RENDER_ENGINE_MAXTHREADS){
+      loginfo("got %lu render threads from environment", l);
+      return l;
+    }
+    logwarn("ignoring invalid NOTCURSES_RENDER_THREADS: %s", rt);
+  }
+  unsigned cpus = host_cpu_count();
+  if(cpus > RENDER_ENGINE_MAXTHREADS){
+    cpus = RENDER_ENGINE_MAXTHREADS;
+  }
+  return cpus;
+}
+
+render_engine* render_engine_create(void){
+  unsigned wanted = render_threads_wanted();
+  if(wanted <= 1){
+    loginfo("only one render thread, not spinning up engine");
+    return NULL;
+  }
+  render_engine* re = malloc(sizeof(*re));
+  if(re == NULL){
+    return NULL;
+  }
+  memset(re, 0, sizeof(*re));
+  if((re->tids = malloc(sizeof(*re->tids) * (wanted - 1))) == NULL){
+    free(re);
+    return NULL;
+  }
+  pthread_mutex_init(&re->joblock, NULL);
+  pthread_mutex_init(&re->lock, NULL);
+  pthread_cond_init(&re->cond, NULL);
+  pthread_cond_init(&re->donecond, NULL);
+  for(unsigned w = 0 ; w < wanted - 1 ; ++w){
+    if(pthread_create(&re->tids[w], NULL, render_worker, re)){
+      logerror("couldn't spin up render worker %u/%u", w, wanted - 1);
+      break;
+    }
+    ++re->threads;
+  }
+  if(re->threads == 0){
+    render_engine_destroy(re);
+    return NULL;
+  }
+  loginfo("spun up %u render worker%s", re->threads, re->threads == 1 ? "" : "s");
+  return re;
+}
+
+void render_engine_destroy(render_engine* re){
+  if(re == NULL){
+    return;
+  }
+  pthread_mutex_lock(&re->lock);
+  re->done = true;
+  pthread_mutex_unlock(&re->lock);
+  pthread_cond_broadcast(&re->cond);
+  for(unsigned t = 0 ; t < re->threads ; ++t){
+    pthread_join(re->tids[t], NULL);
+  }
+  pthread_cond_destroy(&re->donecond);
+  pthread_cond_destroy(&re->cond);
+  pthread_mutex_destroy(&re->lock);
+  pthread_mutex_destroy(&re->joblock);
+  free(re->tids);
+  free(re);
+}
+
+unsigned render_engine_threads(const render_engine* re){
+  return re ? re->threads + 1 : 1;
+}
+
+int render_engine_run(render_engine* re, unsigned bands, renderband_fxn fxn,
+                      void* curry, int64_t* maxns, uint64_t* sumns){
+  if(re == NULL || bands == 0){
+    return -1;
+  }
+  if(pthread_mutex_trylock(&re->joblock)){
+    return -1; // someone else is using the engine; go it alone
+  }
+  pthread_mutex_lock(&re->lock);
+  re->fxn = fxn;
+  re->curry = curry;
+  re->bands = bands;
+  re->nextband = 0;
+  re->bandsdone = 0;
+  re->maxns = 0;
+  re->sumns = 0;
+  pthread_cond_broadcast(&re->cond);
+  work_bands(re);
+  while(re->bandsdone < re->bands){
+    pthread_cond_wait(&re->donecond, &re->lock);
+  }
+  if(*maxns < re->maxns){
+    *maxns = re->maxns;
+  }
+  *sumns += re->sumns;
+  pthread_mutex_unlock(&re->lock);
+  pthread_mutex_unlock(&re->joblock);
+  return 0;
+}
@@ -0,0 +1,239 @@
+#include "internal.h"
+
+// rows scrolled up and out of a plane can be retained as history. history is
+// a ring of rows, stored as chunks of SCROLLBACK_CHUNK rows apiece. chunks are
+// allocated as the ring's tail enters them, and freed once its head leaves
+// them, so a cap much larger than what has actually scrolled costs only the
+// ring of chunk pointers. retained cells keep their EGCs in the plane's pool
+// (or its pile's intern table); they are released only upon eviction.
+#define SCROLLBACK_CHUNK 64
+
+typedef struct ncscrollback {
+  nccell** chunks;   // ring of chunks, NULL where not currently in use
+  unsigned nchunks;  // chunks in the ring
+  unsigned head;     // ring row of the oldest retained line
+  unsigned count;    // lines retained, never more than maxlines
+  unsigned maxlines; // cap on retained lines
+  unsigned cols;     // cells per row, always the plane's width
+  unsigned view;     // lines of history displayed at top of plane
+} ncscrollback;
+
+static inline unsigned
+scrollback_ringrows(const ncscrollback* h){
+  return h->nchunks * SCROLLBACK_CHUNK;
+}
+
+static inline nccell*
+scrollback_ringrow(const ncscrollback* h, unsigned rr){
+  return h->chunks[rr / SCROLLBACK_CHUNK] + (rr % SCROLLBACK_CHUNK) * h->cols;
+}
+
+nccell* scrollback_row(const ncplane* n, unsigned idx){
+  const ncscrollback* h = n->history;
+  return scrollback_ringrow(h, (h->head + idx) % scrollback_ringrows(h));
+}
+
+unsigned scrollback_count(const ncplane* n){
+  return n->history ? n->history->count : 0;
+}
+
+bool scrollback_viewing_p(const ncplane* n){
+  return n->history && n->history->view;
+}
+
+static ncscrollback*
+scrollback_create(unsigned maxlines, unsigned cols){
+  ncscrollback* h = malloc(sizeof(*h));
+  if(h){
+    // leave room for a partially-used chunk at either end of the ring, so
+    // that the tail never enters the chunk the head is still using
+    h->nchunks = maxlines / SCROLLBACK_CHUNK + 2;
+    if((h->chunks = calloc(h->nchunks, sizeof(*h->chunks))) == NULL){
+      free(h);
+      return NULL;
+    }
+    h->head = 0;
+    h->count = 0;
+    h->maxlines = maxlines;
+    h->cols = cols;
+    h->view = 0;
+  }
+  return h;
+}
+
+// release the oldest line, freeing its chunk if that was the chunk's last.
+static void
+scrollback_evict(ncplane* n, ncscrollback* h){
+  nccell* row = scrollback_ringrow(h, h->head);
+  for(unsigned x = 0 ; x < h->cols ; ++x){
+    nccell_release(n, &row[x]);
+  }
+  const unsigned chunk = h->head / SCROLLBACK_CHUNK;
+  h->head = (h->head + 1) % scrollback_ringrows(h);
+  if(--h->count == 0 || h->head / SCROLLBACK_CHUNK != chunk){
+    free(h->chunks[chunk]);
+    h->chunks[chunk] = NULL;
+    if(h->count == 0){
+      h->head = 0;
+    }
+  }
+}
+
+// append a line to |h|, copying |row| (or a blank line if |row| is NULL). on
+// success, |h| owns any EGCs referenced by |row|.
+static int
+scrollback_append(ncplane* n, ncscrollback* h, const nccell* row){
+  if(h->count == h->maxlines){
+    scrollback_evict(n, h);
+  }
+  const unsigned rr = (h->head + h->count) % scrollback_ringrows(h);
+  nccell** chunk = &h->chunks[rr / SCROLLBACK_CHUNK];
+  if(*chunk == NULL){
+    if((*chunk = malloc(sizeof(**chunk) * SCROLLBACK_CHUNK * h->cols)) == NULL){
+      return -1;
+    }
+  }
+  nccell* dst = scrollback_ringrow(h, rr);
+  if(row){
+    memcpy(dst, row, sizeof(*dst) * h->cols);
+  }else{
+    memset(dst, 0, sizeof(*dst) * h->cols);
+  }
+  ++h->count;
+  // someone looking at history keeps looking at the same lines
+  if(h->view && h->view < h->count){
+    ++h->view;
+  }
+  return 0;
+}
+
+int scrollback_push(ncplane* n, const nccell* row){
+  if(n->history == NULL){
+    return -1;
+  }
+  return scrollback_append(n, n->history, row);
+}
+
+static void
+scrollback_destroy(ncplane* n, ncscrollback* h){
+  while(h->count){
+    scrollback_evict(n, h);
+  }
+  free(h->chunks);
+  free(h);
+}
+
+void scrollback_free(ncplane* n){
+  if(n->history){
+    scrollback_destroy(n, n->history);
+    n->history = NULL;
+    ncplane_damage(n);
+  }
+}
+
+const nccell* scrollback_visible_row(const ncplane* n, unsigned y){
+  const ncscrollback* h = n->history;
+  // virtual row: history lines come first, then the framebuffer
+  const unsigned v = h->count - h->view + y;
+  if(v < h->count){
+    return scrollback_row(n, v);
+  }
+  return &n->fb[nfbcellidx(n, v - h->count, 0)];
+}
+
+unsigned scrollback_spans(const ncplane* n, cellspan* spans){
+  const ncscrollback* h = n->history;
+  unsigned nspans = 0;
+  unsigned idx = 0;
+  while(idx < h->count){
+    const unsigned rr = (h->head + idx) % scrollback_ringrows(h);
+    unsigned run = SCROLLBACK_CHUNK - rr % SCROLLBACK_CHUNK;
+    if(run > h->count - idx){
+      run = h->count - idx;
+    }
+    spans[nspans].cells = scrollback_ringrow(h, rr);
+    spans[nspans].count = (size_t)run * h->cols;
+    ++nspans;
+    idx += run;
+  }
+  return nspans;
+}
+
+size_t scrollback_bytes(const ncplane* n){
+  const ncscrollback* h = n->history;
+  if(h == NULL){
+    return 0;
+  }
+  size_t ret = sizeof(*h) + sizeof(*h->chunks) * h->nchunks;
+  for(unsigned c = 0 ; c < h->nchunks ; ++c){
+    if(h->chunks[c]){
+      ret += sizeof(**h->chunks) * SCROLLBACK_CHUNK * h->cols;
+    }
+  }
+  return ret;
+}
+
+unsigned scrollback_maxspans(const ncplane* n){
+  return n->history ? n->history->nchunks + 1 : 0;
+}
+
+int ncplane_set_scrollback(ncplane* n, unsigned maxlines){
+  if(n->sprite){
+    logerror("won't keep history for a sprixel");
+    return -1;
+  }
+  if(n->canvas && maxlines){
+    logerror("won't keep history for a canvas");
+    return -1;
+  }
+  if(maxlines == 0){
+    scrollback_free(n);
+    return 0;
+  }
+  ncscrollback* old = n->history;
+  if(old && old->maxlines == maxlines){
+    return 0;
+  }
+  ncscrollback* h = scrollback_create(maxlines, n->lenx);
+  if(h == NULL){
+    return -1;
+  }
+  if(old){
+    // carry over the most recent lines, dropping any beyond the new cap
+    while(old->count > maxlines){
+      scrollback_evict(n, old);
+    }
+    for(unsigned i = 0 ; i < old->count ; ++i){
+      if(scrollback_append(n, h, scrollback_row(n, i))){
+        scrollback_destroy(n, h);
+        return -1;
+      }
+      // the row now belongs to |h|, and mustn't be released with |old|
+      memset(scrollback_row(n, i), 0, sizeof(nccell) * old->cols);
+    }
+    h->view = old->view > h->count ? h->count : old->view;
+    scrollback_destroy(n, old);
+  }
+  n->history = h;
+  ncplane_damage(n);
+  return 0;
+}
+
+unsigned ncplane_scrollback_lines(const ncplane* n){
+  return scrollback_count(n);
+}
+
+int ncplane_scrollback_view(ncplane* n, unsigned offset){
+  ncscrollback* h = n->history;
+  if(h == NULL){
+    return 0;
+  }
+  if(offset > h->count){
+    offset = h->count;
+  }
+  if(offset != h->view){
+    h->view = offset;
+    ncplane_damage(n);
+  }
+  return offset;
+}
@@ -14,6 +14,29 @@ struct ncmselector_int {
   bool selected;
 };
 
+// widths of a sourced item, measured when it was last displayed. the cache
+// is direct-mapped on the item's index, and sized for a few screenfuls.
+#define SELECTOR_WIDTHCACHE 256
+
+struct selector_width {
+  unsigned idx;       // index of the item plus one, 0 if the entry is empty
+  unsigned opcols;    // columns occupied by the option
+  unsigned desccols;  // columns occupied by the description
+};
+
+// the prefix filter common to both widgets. items must be in strcmp() order
+// for it to work, so that those passing the filter are contiguous.
+typedef struct selector_filter {
+  char* prefix;       // NULL if no filter is active
+  size_t prefixlen;   // bytes in prefix
+  unsigned base;      // index of the first item passing the filter
+  unsigned count;     // number of items passing the filter
+  unsigned total;     // number of items when the filter was applied
+} selector_filter;
+
+// returns the option of item idx, valid until the next call
+typedef const char* (*selector_option_f)(void* widget, unsigned idx);
+
 typedef struct ncselector {
   ncplane* ncp;                  // backing ncplane
   unsigned selected;             // index of selection
@@ -34,7 +57,15 @@ typedef struct ncselector {
   uint64_t titlechannels;        // title channels
   uint64_t footchannels;         // secondary and footer channels
   uint64_t boxchannels;          // border channels
+  ncboxstyle boxstyle;           // border, resolved from boxchannels
   int uarrowy, darrowy, arrowx;// location of scrollarrows, even if not present
+  ncselector_source src;         // supplies items if src.item is non-NULL
+  char* selopt;                  // copy of the selected option, if sourced
+  struct selector_width* widths; // SELECTOR_WIDTHCACHE entries, if sourced
+  unsigned srctotal;             // source's item count as of the last sync
+  selector_filter filter;        // prefix filter over items
+  unsigned base;                 // index of first offered item
+  unsigned count;                // number of offered items
 } ncselector;
 
 typedef struct ncmultiselector {
@@ -56,9 +87,170 @@ typedef struct ncmultiselector {
   uint64_t titlechannels;         // title channels
   uint64_t footchannels;          // secondary and footer channels
   uint64_t boxchannels;           // border channels
+  ncboxstyle boxstyle;            // border, resolved from boxchannels
   int uarrowy, darrowy, arrowx;   // location of scrollarrows, even if not present
+  ncmselector_source src;         // supplies items if src.item is non-NULL
+  char* curopt;                   // copy of the highlighted option, if sourced
+  struct selector_width* widths;  // SELECTOR_WIDTHCACHE entries, if sourced
+  unsigned srctotal;              // source's item count as of the last sync
+  selector_filter filter;         // prefix filter over items
+  unsigned base;                  // index of first offered item
+  unsigned count;                 // number of offered items
 } ncmultiselector;
 
+// find the first item in [lo, hi) whose option, compared with strncmp()
+// against the filter's prefix, is >= 0 (or > 0, if 'past'). this is a
+// partition point of a sorted list, and is found in O(log(hi - lo)).
+static int
+selector_bound(void* w, selector_option_f getopt, const selector_filter* f,
+               unsigned lo, unsigned hi, bool past, unsigned* bound){
+  while(lo < hi){
+    unsigned mid = lo + (hi - lo) / 2;
+    const char* opt = getopt(w, mid);
+    if(opt == NULL){
+      return -1;
+    }
+    int cmp = strncmp(opt, f->prefix, f->prefixlen);
+    if(cmp < 0 || (past && cmp == 0)){
+      lo = mid + 1;
+    }else{
+      hi = mid;
+    }
+  }
+  *bound = lo;
+  return 0;
+}
+
+// compute the range of items passing the filter. if 'narrowing' (the prefix
+// extends that used last time), and the items are unchanged, only the old
+// range need be searched. on error, no items pass.
+static int
+selector_filter_apply(void* w, selector_option_f getopt, selector_filter* f,
+                      unsigned total, bool narrowing){
+  unsigned lo = 0, hi = total;
+  if(narrowing && f->total == total){
+    lo = f->base;
+    hi = f->base + f->count;
+  }
+  f->total = total;
+  unsigned first, past;
+  if(selector_bound(w, getopt, f, lo, hi, false, &first) ||
+     selector_bound(w, getopt, f, first, hi, true, &past)){
+    f->base = f->count = 0;
+    return -1;
+  }
+  f->base = first;
+  f->count = past - first;
+  return 0;
+}
+
+// install a new prefix (clearing the filter if it's NULL or empty)
+static int
+selector_filter_set(void* w, selector_option_f getopt, selector_filter* f,
+                    unsigned total, const char* prefix){
+  if(prefix == NULL || *prefix == '\0'){
+    free(f->prefix);
+    f->prefix = NULL;
+    return 0;
+  }
+  const bool narrowing = f->prefix && strncmp(prefix, f->prefix, f->prefixlen) == 0;
+  char* dup = strdup(prefix);
+  if(dup == NULL){
+    return -1;
+  }
+  free(f->prefix);
+  f->prefix = dup;
+  f->prefixlen = strlen(dup);
+  return selector_filter_apply(w, getopt, f, total, narrowing);
+}
+
+// look up (or measure and remember) the widths of a sourced item
+static int
+selector_widths(struct selector_width* widths, unsigned idx, const char* opt,
+                const char* desc, unsigned* opcols, unsigned* desccols){
+  struct selector_width* w = &widths[idx % SELECTOR_WIDTHCACHE];
+  if(w->idx != idx + 1){
+    int ocols = ncstrwidth(opt, NULL, NULL);
+    int dcols = ncstrwidth(desc, NULL, NULL);
+    if(ocols < 0 || dcols < 0){
+      return -1;
+    }
+    w->idx = idx + 1;
+    w->opcols = ocols;
+    w->desccols = dcols;
+  }
+  *opcols = w->opcols;
+  *desccols = w->desccols;
+  return 0;
+}
+
+static const char*
+ncselector_option(void* vn, unsigned idx){
+  ncselector* n = vn;
+  if(n->src.item){
+    struct ncselector_item item = {0};
+    if(n->src.item(n->src.curry, idx, &item)){
+      return NULL;
+    }
+    return item.option;
+  }
+  return n->items[idx].option;
+}
+
+// fetch item idx (counting all items, not just those offered) with its
+// widths. a sourced item's strings are good until the source is next called.
+static int
+ncselector_item(ncselector* n, unsigned idx, const char** opt, const char** desc,
+                unsigned* opcols, unsigned* desccols){
+  if(n->src.item == NULL){
+    const struct ncselector_int* i = &n->items[idx];
+    *opt = i->option;
+    *desc = i->desc;
+    *opcols = i->opcolumns;
+    *desccols = i->desccolumns;
+    return 0;
+  }
+  struct ncselector_item item = {0};
+  if(n->src.item(n->src.curry, idx, &item) || item.option == NULL){
+    logerror("couldn't get item %u from source", idx);
+    return -1;
+  }
+  *opt = item.option;
+  *desc = item.desc ? item.desc : "";
+  return selector_widths(n->widths, idx, *opt, *desc, opcols, desccols);
+}
+
+// bring the offered items up to date, reapplying the filter if the items
+// have changed beneath it, and keep the selection among them.
+static void
+ncselector_sync(ncselector* n){
+  unsigned total = n->itemcount;
+  if(n->src.item){
+    total = n->src.count(n->src.curry);
+    if(total != n->srctotal){ // the items have changed; forget their widths
+      memset(n->widths, 0, sizeof(*n->widths) * SELECTOR_WIDTHCACHE);
+      n->srctotal = total;
+    }
+  }
+  if(n->filter.prefix){
+    if(n->filter.total != total){
+      selector_filter_apply(n, ncselector_option, &n->filter, total, false);
+    }
+    n->base = n->filter.base;
+    n->count = n->filter.count;
+  }else{
+    n->base = 0;
+    n->count = total;
+  }
+  if(n->selected >= n->count){
+    n->selected = n->count ? n->count - 1 : 0;
+  }
+  if(n->startdisp >= n->count){
+    n->startdisp = n->selected;
+  }
+}
+
+
 // ideal body width given the ncselector's items and secondary/footer
 static int
 ncselector_body_width(const ncselector* n){
@@ -79,9 +271,57 @@ ncselector_body_width(const ncselector* n){
   return cols;
 }
 
+static void ncselector_dim_yx(const ncselector* n, unsigned* ncdimy, unsigned* ncdimx);
+
+// resize the plane to suit the offered items
+static int
+ncselector_fit(ncselector* n){
+  unsigned dimy, dimx;
+  ncselector_dim_yx(n, &dimy, &dimx);
+  if(dimy != ncplane_dim_y(n->ncp) || dimx != ncplane_dim_x(n->ncp)){
+    return ncplane_resize_simple(n->ncp, dimy, dimx);
+  }
+  return 0;
+}
+
+// measure the sourced items about to be displayed, widening the selector if
+// any of them are wider than those seen before.
+static int
+ncselector_measure(ncselector* n){
+  int rows = (int)ncplane_dim_y(n->ncp) - 4 - (n->title ? 2 : 0);
+  if(n->maxdisplay && (int)n->maxdisplay < rows){
+    rows = n->maxdisplay;
+  }
+  unsigned v = n->startdisp;
+  for(int i = 0 ; i < rows && (unsigned)i < n->count ; ++i){
+    const char* opt;
+    const char* desc;
+    unsigned opcols, desccols;
+    if(ncselector_item(n, n->base + v, &opt, &desc, &opcols, &desccols)){
+      return -1;
+    }
+    if(opcols > n->longop){
+      n->longop = opcols;
+    }
+    if(desccols > n->longdesc){
+      n->longdesc = desccols;
+    }
+    if(++v == n->count){
+      v = 0;
+    }
+  }
+  return ncselector_fit(n);
+}
+
 // redraw the selector widget in its entirety
 static int
 ncselector_draw(ncselector* n){
+  ncselector_sync(n);
+  if(n->src.item){
+    if(ncselector_measure(n)){
+      return -1;
+    }
+  }
   ncplane_erase(n->ncp);
   nccell transchar = NCCELL_TRIVIAL_INITIALIZER;
   nccell_set_fg_alpha(&transchar, NCALPHA_TRANSPARENT);
@@ -97,8 +337,7 @@ ncselector_draw(ncselector* n){
     if(offx){
       ncplane_hline(n->ncp, &transchar, offx);
     }
-    ncplane_cursor_move_yx(n->ncp, 0, offx);
-    ncplane_rounded_box_sized(n->ncp, 0, n->boxchannels, 3, riserwidth, 0);
+    ncplane_box_styled(n->ncp, &n->boxstyle, 0, offx, 3, riserwidth, 0);
     n->ncp->channels = n->titlechannels;
     ncplane_printf_yx(n->ncp, 1, offx + 1, " %s ", n->title);
     yoff += 2;
@@ -117,8 +356,7 @@ ncselector_draw(ncselector* n){
       ncplane_hline(n->ncp, &transchar, xoff);
     }
   }
-  ncplane_cursor_move_yx(n->ncp, yoff, xoff);
-  ncplane_rounded_box_sized(n->ncp, 0, n->boxchannels, dimy - yoff, bodywidth, 0);
+  ncplane_box_styled(n->ncp, &n->boxstyle, yoff, xoff, dimy - yoff, bodywidth, 0);
   if(n->title){
     n->ncp->channels = n->boxchannels;
     if(notcurses_canutf8(ncplane_notcurses(n->ncp))){
@@ -167,7 +405,7 @@ ncselector_draw(ncselector* n){
     ncplane_putc(n->ncp, &transc);
   }
   const int bodyoffset = dimx - bodywidth + 2;
-  if(n->maxdisplay && n->maxdisplay < n->itemcount){
+  if(n->maxdisplay && n->maxdisplay < n->count){
     n->ncp->channels = n->descchannels;
     n->arrowx = bodyoffset + n->longop;
     if(notcurses_canutf8(ncplane_notcurses(n->ncp))){
@@ -185,22 +423,31 @@ ncselector_draw(ncselector* n){
     if(n->maxdisplay && printed == n->maxdisplay){
       break;
     }
+    if(printed == n->count){
+      break;
+    }
     ncplane_cursor_move_yx(n->ncp, yoff, xoff + 1);
     for(int i = xoff + 1 ; i < (int)dimx - 1 ; ++i){
       nccell transc = NCCELL_TRIVIAL_INITIALIZER; // fall back to base cell
       ncplane_putc(n->ncp, &transc);
     }
+    const char* opt;
+    const char* desc;
+    unsigned opcols, desccols;
+    if(ncselector_item(n, n->base + printidx, &opt, &desc, &opcols, &desccols)){
+      return -1;
+    }
     n->ncp->channels = n->opchannels;
     if(printidx == n->selected){
       n->ncp->channels = (uint64_t)ncchannels_bchannel(n->opchannels) << 32u | ncchannels_fchannel(n->opchannels);
     }
-    ncplane_printf_yx(n->ncp, yoff, bodyoffset + (n->longop - n->items[printidx].opcolumns), "%s", n->items[printidx].option);
+    ncplane_printf_yx(n->ncp, yoff, bodyoffset + (n->longop - opcols), "%s", opt);
     n->ncp->channels = n->descchannels;
     if(printidx == n->selected){
       n->ncp->channels = (uint64_t)ncchannels_bchannel(n->descchannels) << 32u | ncchannels_fchannel(n->descchannels);
     }
-    ncplane_printf_yx(n->ncp, yoff, bodyoffset + n->longop, " %s", n->items[printidx].desc);
-    if(++printidx == n->itemcount){
+    ncplane_printf_yx(n->ncp, yoff, bodyoffset + n->longop, " %s", desc);
+    if(++printidx == n->count){
       printidx = 0;
     }
     ++printed;
@@ -211,7 +458,7 @@ ncselector_draw(ncselector* n){
     nccell transc = NCCELL_TRIVIAL_INITIALIZER; // fall back to base cell
     ncplane_putc(n->ncp, &transc);
   }
-  if(n->maxdisplay && n->maxdisplay < n->itemcount){
+  if(n->maxdisplay && n->maxdisplay < n->count){
     n->ncp->channels = n->descchannels;
     if(notcurses_canutf8(ncplane_notcurses(n->ncp))){
       ncplane_putegc_yx(n->ncp, yoff, n->arrowx, "↓", NULL);
@@ -220,6 +467,18 @@ ncselector_draw(ncselector* n){
     }
   }
   n->darrowy = yoff;
+  // a sourced option is only good until the source is next called, so we
+  // keep our own copy of the selected one to hand out.
+  if(n->src.item){
+    free(n->selopt);
+    n->selopt = NULL;
+    if(n->count){
+      const char* opt = ncselector_option(n, n->base + n->selected);
+      if(opt == NULL || (n->selopt = strdup(opt)) == NULL){
+        return -1;
+      }
+    }
+  }
   return 0;
 }
 
@@ -236,7 +495,7 @@ ncselector_dim_yx(const ncselector* n, unsigned* ncdimy, unsigned* ncdimx){
   // we have a top line, a bottom line, two lines of margin, and must be able
   // to display at least one row beyond that, so require five more
   rows += 5;
-  rows += (!n->maxdisplay || n->maxdisplay > n->itemcount ? n->itemcount : n->maxdisplay) - 1; // rows necessary to display all options
+  rows += (!n->maxdisplay || n->maxdisplay > n->count ? n->count : n->maxdisplay) - 1; // rows necessary to display all options
   if(rows > dimy){ // claw excess back
     rows = dimy;
   }
@@ -263,6 +522,9 @@ ncselector_destroy_internal(ncselector* n){
     free(n->title);
     free(n->secondary);
     free(n->footer);
+    free(n->selopt);
+    free(n->widths);
+    free(n->filter.prefix);
     free(n);
   }
 }
@@ -270,14 +532,23 @@ ncselector_destroy_internal(ncselector* n){
 void ncselector_destroy(ncselector* n, char** item){
   if(n){
     if(item){
-      *item = n->items[n->selected].option;
-      n->items[n->selected].option = NULL;
+      if(n->src.item){
+        *item = n->selopt;
+        n->selopt = NULL;
+      }else if(n->count){
+        *item = n->items[n->base + n->selected].option;
+        n->items[n->base + n->selected].option = NULL;
+      }else{
+        *item = NULL;
+      }
     }
     ncselector_destroy_internal(n);
   }
 }
 
-ncselector* ncselector_create(ncplane* n, const ncselector_options* opts){
+static ncselector*
+ncselector_create_internal(ncplane* n, const ncselector_options* opts,
+                           const ncselector_source* source){
   if(n == notcurses_stdplane(ncplane_notcurses(n))){
     logerror("won't use the standard plane"); // would fail later on resize
     return NULL;
@@ -291,6 +562,11 @@ ncselector* ncselector_create(ncplane* n, const ncselector_options* opts){
     logwarn("provided unsupported flags %016" PRIx64, opts->flags);
   }
   if(opts->items){
+    if(source){
+      logerror("items can't be provided with a source");
+      ncplane_destroy(n);
+      return NULL;
+    }
     for(const struct ncselector_item* i = opts->items ; i->option ; ++i){
       ++itemcount;
     }
@@ -300,8 +576,16 @@ ncselector* ncselector_create(ncplane* n, const ncselector_options* opts){
     return NULL;
   }
   memset(ns, 0, sizeof(*ns));
-  if(opts->defidx && opts->defidx >= itemcount){
-    logerror("default index %u too large (%u items)", opts->defidx, itemcount);
+  if(source){
+    ns->src = *source;
+    if(!(ns->widths = calloc(SELECTOR_WIDTHCACHE, sizeof(*ns->widths)))){
+      goto freeitems;
+    }
+    ns->srctotal = ns->src.count(ns->src.curry);
+  }
+  const unsigned total = source ? ns->srctotal : itemcount;
+  if(opts->defidx && opts->defidx >= total){
+    logerror("default index %u too large (%u items)", opts->defidx, total);
     goto freeitems;
   }
   ns->title = opts->title ? strdup(opts->title) : NULL;
@@ -327,7 +611,10 @@ ncselector* ncselector_create(ncplane* n, const ncselector_options* opts){
   ns->descchannels = opts->descchannels;
   ns->titlechannels = opts->titlechannels;
   ns->footchannels = opts->footchannels;
-  ns->boxchannels = opts->boxchannels;
+  if(ncboxstyle_init(&ns->boxstyle, notcurses_canutf8(ncplane_notcurses(n)) ?
+                     NCBOXROUND : NCBOXASCII, 0, ns->boxchannels)){
+    goto freeitems;
+  }
   ns->darrowy = ns->uarrowy = ns->arrowx = -1;
   if(itemcount){
     if(!(ns->items = malloc(sizeof(*ns->items) * itemcount))){
@@ -367,6 +654,7 @@ ncselector* ncselector_create(ncplane* n, const ncselector_options* opts){
   }
   unsigned dimy, dimx;
   ns->ncp = n;
+  ncselector_sync(ns);
   ncselector_dim_yx(ns, &dimy, &dimx);
   if(ncplane_resize_simple(n, dimy, dimx)){
     goto freeitems;
@@ -384,12 +672,46 @@ freeitems:
   }
   free(ns->items);
   free(ns->title); free(ns->secondary); free(ns->footer);
+  free(ns->widths);
   free(ns);
   ncplane_destroy(n);
   return NULL;
 }
 
+ncselector* ncselector_create(ncplane* n, const ncselector_options* opts){
+  return ncselector_create_internal(n, opts, NULL);
+}
+
+ncselector* ncselector_create_source(ncplane* n, const ncselector_options* opts,
+                                     const ncselector_source* src){
+  if(src->count == NULL || src->item == NULL){
+    logerror("source lacks count or item callback");
+    ncplane_destroy(n);
+    return NULL;
+  }
+  return ncselector_create_internal(n, opts, src);
+}
+
+int ncselector_filter(ncselector* n, const char* prefix){
+  ncselector_sync(n);
+  const unsigned total = n->src.item ? n->srctotal : n->itemcount;
+  int ret = selector_filter_set(n, ncselector_option, &n->filter, total, prefix);
+  n->selected = n->startdisp = 0;
+  ncselector_sync(n);
+  if(ncselector_fit(n)){
+    ret = -1;
+  }
+  if(ncselector_draw(n)){
+    ret = -1;
+  }
+  return ret;
+}
+
 int ncselector_additem(ncselector* n, const struct ncselector_item* item){
+  if(n->src.item){
+    logerror("can't add items to a sourced selector");
+    return -1;
+  }
   unsigned origdimy, origdimx;
   ncselector_dim_yx(n, &origdimy, &origdimx);
   size_t newsize = sizeof(*n->items) * (n->itemcount + 1);
@@ -416,6 +738,7 @@ int ncselector_additem(ncselector* n, const struct ncselector_item* item){
     n->longdesc = cols;
   }
   ++n->itemcount;
+  ncselector_sync(n);
   unsigned dimy, dimx;
   ncselector_dim_yx(n, &dimy, &dimx);
   if(origdimx < dimx || origdimy < dimy){ // resize if too small
@@ -425,6 +748,10 @@ int ncselector_additem(ncselector* n, const struct ncselector_item* item){
 }
 
 int ncselector_delitem(ncselector* n, const char* item){
+  if(n->src.item){
+    logerror("can't delete items from a sourced selector");
+    return -1;
+  }
   unsigned origdimy, origdimx;
   ncselector_dim_yx(n, &origdimy, &origdimx);
   bool found = false;
@@ -457,6 +784,7 @@ int ncselector_delitem(ncselector* n, const char* item){
   if(found){
     n->longop = maxop;
     n->longdesc = maxdesc;
+    ncselector_sync(n);
     unsigned dimy, dimx;
     ncselector_dim_yx(n, &dimy, &dimx);
     if(origdimx > dimx || origdimy > dimy){ // resize if too big
@@ -472,52 +800,53 @@ ncplane* ncselector_plane(ncselector* n){
 }
 
 const char* ncselector_selected(const ncselector* n){
-  if(n->itemcount == 0){
+  if(n->count == 0){
     return NULL;
   }
-  return n->items[n->selected].option;
+  if(n->src.item){
+    return n->selopt;
+  }
+  return n->items[n->base + n->selected].option;
 }
 
 const char* ncselector_previtem(ncselector* n){
-  const char* ret = NULL;
-  if(n->itemcount == 0){
-    return ret;
+  ncselector_sync(n);
+  if(n->count == 0){
+    return NULL;
   }
   if(n->selected == n->startdisp){
     if(n->startdisp-- == 0){
-      n->startdisp = n->itemcount - 1;
+      n->startdisp = n->count - 1;
     }
   }
   if(n->selected == 0){
-    n->selected = n->itemcount;
+    n->selected = n->count;
   }
   --n->selected;
-  ret = n->items[n->selected].option;
   ncselector_draw(n);
-  return ret;
+  return ncselector_selected(n);
 }
 
 const char* ncselector_nextitem(ncselector* n){
-  const char* ret = NULL;
-  if(n->itemcount == 0){
+  ncselector_sync(n);
+  if(n->count == 0){
     return NULL;
   }
   unsigned lastdisp = n->startdisp;
-  lastdisp += n->maxdisplay && n->maxdisplay < n->itemcount ? n->maxdisplay : n->itemcount;
+  lastdisp += n->maxdisplay && n->maxdisplay < n->count ? n->maxdisplay : n->count;
   --lastdisp;
-  lastdisp %= n->itemcount;
+  lastdisp %= n->count;
   if(lastdisp == n->selected){
-    if(++n->startdisp == n->itemcount){
+    if(++n->startdisp == n->count){
       n->startdisp = 0;
     }
   }
   ++n->selected;
-  if(n->selected == n->itemcount){
+  if(n->selected == n->count){
     n->selected = 0;
   }
-  ret = n->items[n->selected].option;
   ncselector_draw(n);
-  return ret;
+  return ncselector_selected(n);
 }
 
 bool ncselector_offer_input(ncselector* n, const ncinput* nc){
@@ -539,7 +868,10 @@ bool ncselector_offer_input(ncselector* n, const ncinput* nc){
       // FIXME verify that we're within the body walls!
       // FIXME verify we're on the left of the split?
       // FIXME verify that we're on a visible glyph?
-      int cury = (n->selected + n->itemcount - n->startdisp) % n->itemcount;
+      if(n->count == 0){
+        return true;
+      }
+      int cury = (n->selected + n->count - n->startdisp) % n->count;
       int click = y - n->uarrowy - 1;
       while(click > cury){
         ncselector_nextitem(n);
@@ -607,9 +939,130 @@ ncmultiselector_body_width(const ncmultiselector* n){
   return cols;
 }
 
+static const char*
+ncmultiselector_option(void* vn, unsigned idx){
+  ncmultiselector* n = vn;
+  if(n->src.item){
+    struct ncmselector_item item = {0};
+    if(n->src.item(n->src.curry, idx, &item)){
+      return NULL;
+    }
+    return item.option;
+  }
+  return n->items[idx].option;
+}
+
+// fetch item idx (counting all items, not just those offered) with the
+// columns it occupies. a sourced item's strings are good until the source is
+// next called.
+static int
+ncmultiselector_item(ncmultiselector* n, unsigned idx, const char** opt,
+                     const char** desc, bool* selected, unsigned* cols){
+  if(n->src.item == NULL){
+    const struct ncmselector_int* i = &n->items[idx];
+    *opt = i->option;
+    *desc = i->desc;
+    *selected = i->selected;
+    *cols = 0; // only needed for sourced items
+    return 0;
+  }
+  struct ncmselector_item item = {0};
+  if(n->src.item(n->src.curry, idx, &item) || item.option == NULL){
+    logerror("couldn't get item %u from source", idx);
+    return -1;
+  }
+  *opt = item.option;
+  *desc = item.desc ? item.desc : "";
+  *selected = item.selected;
+  unsigned opcols, desccols;
+  if(selector_widths(n->widths, idx, *opt, *desc, &opcols, &desccols)){
+    return -1;
+  }
+  *cols = opcols + desccols;
+  return 0;
+}
+
+// bring the offered items up to date, reapplying the filter if the items
+// have changed beneath it, and keep the highlight among them.
+static void
+ncmultiselector_sync(ncmultiselector* n){
+  unsigned total = n->itemcount;
+  if(n->src.item){
+    total = n->src.count(n->src.curry);
+    if(total != n->srctotal){ // the items have changed; forget their widths
+      memset(n->widths, 0, sizeof(*n->widths) * SELECTOR_WIDTHCACHE);
+      n->srctotal = total;
+    }
+  }
+  if(n->filter.prefix){
+    if(n->filter.total != total){
+      selector_filter_apply(n, ncmultiselector_option, &n->filter, total, false);
+    }
+    n->base = n->filter.base;
+    n->count = n->filter.count;
+  }else{
+    n->base = 0;
+    n->count = total;
+  }
+  if(n->current >= n->count){
+    n->current = n->count ? n->count - 1 : 0;
+  }
+  if(n->startdisp >= n->count){
+    n->startdisp = n->current;
+  }
+}
+
+static int ncmultiselector_dim_yx(const ncmultiselector* n, unsigned* ncdimy, unsigned* ncdimx);
+
+// resize the plane to suit the offered items
+static int
+ncmultiselector_fit(ncmultiselector* n){
+  unsigned dimy, dimx;
+  if(ncmultiselector_dim_yx(n, &dimy, &dimx)){
+    return -1;
+  }
+  if(dimy != ncplane_dim_y(n->ncp) || dimx != ncplane_dim_x(n->ncp)){
+    return ncplane_resize_simple(n->ncp, dimy, dimx);
+  }
+  return 0;
+}
+
+// measure the sourced items about to be displayed, widening the
+// multiselector if any of them are wider than those seen before.
+static int
+ncmultiselector_measure(ncmultiselector* n){
+  int rows = (int)ncplane_dim_y(n->ncp) - 4 - (n->title ? 2 : 0);
+  if(n->maxdisplay && (int)n->maxdisplay < rows){
+    rows = n->maxdisplay;
+  }
+  unsigned v = n->startdisp;
+  for(int i = 0 ; i < rows && (unsigned)i < n->count ; ++i){
+    const char* opt;
+    const char* desc;
+    bool selected;
+    unsigned cols;
+    if(ncmultiselector_item(n, n->base + v, &opt, &desc, &selected, &cols)){
+      return -1;
+    }
+    if(cols > n->longitem){
+      n->longitem = cols;
+    }
+    if(++v == n->count){
+      v = 0;
+    }
+  }
+  return ncmultiselector_fit(n);
+}
+
 // redraw the multiselector widget in its entirety
 static int
 ncmultiselector_draw(ncmultiselector* n){
+  ncmultiselector_sync(n);
+  if(n->src.item){
+    if(ncmultiselector_measure(n)){
+      return -1;
+    }
+  }
   ncplane_erase(n->ncp);
   nccell transchar = NCCELL_TRIVIAL_INITIALIZER;
   nccell_set_fg_alpha(&transchar, NCALPHA_TRANSPARENT);
@@ -625,7 +1078,7 @@ ncmultiselector_draw(ncmultiselector* n){
     if(offx){
       ncplane_hline(n->ncp, &transchar, offx);
     }
-    ncplane_rounded_box_sized(n->ncp, 0, n->boxchannels, 3, riserwidth, 0);
+    ncplane_box_styled(n->ncp, &n->boxstyle, 0, offx, 3, riserwidth, 0);
     n->ncp->channels = n->titlechannels;
     ncplane_printf_yx(n->ncp, 1, offx + 1, " %s ", n->title);
     yoff += 2;
@@ -644,8 +1097,7 @@ ncmultiselector_draw(ncmultiselector* n){
       ncplane_hline(n->ncp, &transchar, xoff);
     }
   }
-  ncplane_cursor_move_yx(n->ncp, yoff, xoff);
-  ncplane_rounded_box_sized(n->ncp, 0, n->boxchannels, dimy - yoff, bodywidth, 0);
+  ncplane_box_styled(n->ncp, &n->boxstyle, yoff, xoff, dimy - yoff, bodywidth, 0);
   if(n->title){
     n->ncp->channels = n->boxchannels;
     ncplane_putegc_yx(n->ncp, 2, dimx - 1, "┤", NULL);
@@ -682,7 +1134,7 @@ ncmultiselector_draw(ncmultiselector* n){
     ncplane_putc(n->ncp, &transc);
   }
   const int bodyoffset = dimx - bodywidth + 2;
-  if(n->maxdisplay && n->maxdisplay < n->itemcount){
+  if(n->maxdisplay && n->maxdisplay < n->count){
     n->ncp->channels = n->descchannels;
     n->arrowx = bodyoffset + 1;
     ncplane_putegc_yx(n->ncp, yoff, n->arrowx, "↑", NULL);
@@ -694,9 +1146,16 @@ ncmultiselector_draw(ncmultiselector* n){
   unsigned printed = 0;
   // visible option lines
   for(yoff += 1 ; yoff < dimy - 2 ; ++yoff){
-    if(n->maxdisplay && printed == n->maxdisplay){
+    if((n->maxdisplay && printed == n->maxdisplay) || printed == n->count){
       break;
     }
+    const char* opt;
+    const char* desc;
+    bool selected;
+    unsigned cols;
+    if(ncmultiselector_item(n, n->base + printidx, &opt, &desc, &selected, &cols)){
+      return -1;
+    }
     ncplane_cursor_move_yx(n->ncp, yoff, xoff + 1);
     for(unsigned i = xoff + 1 ; i < dimx - 1 ; ++i){
       nccell transc = NCCELL_TRIVIAL_INITIALIZER; // fall back to base cell
@@ -705,23 +1164,31 @@ ncmultiselector_draw(ncmultiselector* n){
     n->ncp->channels = n->descchannels;
     if(printidx == n->current){
       n->ncp->channels = (uint64_t)ncchannels_bchannel(n->descchannels) << 32u | ncchannels_fchannel(n->descchannels);
+      if(n->src.item){
+        char* dup = strdup(opt);
+        if(dup == NULL){
+          return -1;
+        }
+        free(n->curopt);
+        n->curopt = dup;
+      }
     }
     if(notcurses_canutf8(ncplane_notcurses(n->ncp))){
-      ncplane_putegc_yx(n->ncp, yoff, bodyoffset, n->items[printidx].selected ? "☒" : "☐", NULL);
+      ncplane_putegc_yx(n->ncp, yoff, bodyoffset, selected ? "☒" : "☐", NULL);
     }else{
-      ncplane_putchar_yx(n->ncp, yoff, bodyoffset, n->items[printidx].selected ? 'X' : '-');
+      ncplane_putchar_yx(n->ncp, yoff, bodyoffset, selected ? 'X' : '-');
     }
     n->ncp->channels = n->opchannels;
     if(printidx == n->current){
       n->ncp->channels = (uint64_t)ncchannels_bchannel(n->opchannels) << 32u | ncchannels_fchannel(n->opchannels);
     }
-    ncplane_printf(n->ncp, " %s ", n->items[printidx].option);
+    ncplane_printf(n->ncp, " %s ", opt);
     n->ncp->channels = n->descchannels;
     if(printidx == n->current){
       n->ncp->channels = (uint64_t)ncchannels_bchannel(n->descchannels) << 32u | ncchannels_fchannel(n->descchannels);
     }
-    ncplane_printf(n->ncp, "%s", n->items[printidx].desc);
-    if(++printidx == n->itemcount){
+    ncplane_printf(n->ncp, "%s", desc);
+    if(++printidx == n->count){
       printidx = 0;
     }
     ++printed;
@@ -732,7 +1199,7 @@ ncmultiselector_draw(ncmultiselector* n){
     nccell transc = NCCELL_TRIVIAL_INITIALIZER; // fall back to base cell
     ncplane_putc(n->ncp, &transc);
   }
-  if(n->maxdisplay && n->maxdisplay < n->itemcount){
+  if(n->maxdisplay && n->maxdisplay < n->count){
     n->ncp->channels = n->descchannels;
     ncplane_putegc_yx(n->ncp, yoff, n->arrowx, "↓", NULL);
   }
@@ -740,46 +1207,56 @@ ncmultiselector_draw(ncmultiselector* n){
   return 0;
 }
 
+// the highlighted option, NULL if no items are offered
+static const char*
+ncmultiselector_current(const ncmultiselector* n){
+  if(n->count == 0){
+    return NULL;
+  }
+  if(n->src.item){
+    return n->curopt;
+  }
+  return n->items[n->base + n->current].option;
+}
+
 const char* ncmultiselector_previtem(ncmultiselector* n){
-  const char* ret = NULL;
-  if(n->itemcount == 0){
-    return ret;
+  ncmultiselector_sync(n);
+  if(n->count == 0){
+    return NULL;
   }
   if(n->current == n->startdisp){
     if(n->startdisp-- == 0){
-      n->startdisp = n->itemcount - 1;
+      n->startdisp = n->count - 1;
     }
   }
   if(n->current == 0){
-    n->current = n->itemcount;
+    n->current = n->count;
   }
   --n->current;
-  ret = n->items[n->current].option;
   ncmultiselector_draw(n);
-  return ret;
+  return ncmultiselector_current(n);
 }
 
 const char* ncmultiselector_nextitem(ncmultiselector* n){
-  const char* ret = NULL;
-  if(n->itemcount == 0){
+  ncmultiselector_sync(n);
+  if(n->count == 0){
     return NULL;
   }
   unsigned lastdisp = n->startdisp;
-  lastdisp += n->maxdisplay && n->maxdisplay < n->itemcount ? n->maxdisplay : n->itemcount;
+  lastdisp += n->maxdisplay && n->maxdisplay < n->count ? n->maxdisplay : n->count;
   --lastdisp;
-  lastdisp %= n->itemcount;
+  lastdisp %= n->count;
   if(lastdisp == n->current){
-    if(++n->startdisp == n->itemcount){
+    if(++n->startdisp == n->count){
       n->startdisp = 0;
     }
   }
   ++n->current;
-  if(n->current == n->itemcount){
+  if(n->current == n->count){
     n->current = 0;
   }
-  ret = n->items[n->current].option;
   ncmultiselector_draw(n);
-  return ret;
+  return ncmultiselector_current(n);
 }
 
 bool ncmultiselector_offer_input(ncmultiselector* n, const ncinput* nc){
@@ -801,7 +1278,10 @@ bool ncmultiselector_offer_input(ncmultiselector* n, const ncinput* nc){
       // FIXME verify that we're within the body walls!
       // FIXME verify we're on the left of the split?
       // FIXME verify that we're on a visible glyph?
-      int cury = (n->current + n->itemcount - n->startdisp) % n->itemcount;
+      if(n->count == 0){
+        return true;
+      }
+      int cury = (n->current + n->count - n->startdisp) % n->count;
       int click = y - n->uarrowy - 1;
       while(click > cury){
         ncmultiselector_nextitem(n);
@@ -815,7 +1295,21 @@ bool ncmultiselector_offer_input(ncmultiselector* n, const ncinput* nc){
     }
   }else if(nc->evtype != NCTYPE_RELEASE){
     if(nc->id == ' '){
-      n->items[n->current].selected = !n->items[n->current].selected;
+      ncmultiselector_sync(n);
+      if(n->count){
+        const unsigned idx = n->base + n->current;
+        if(n->src.item){
+          const char* opt;
+          const char* desc;
+          bool selected;
+          unsigned cols;
+          if(n->src.select && !ncmultiselector_item(n, idx, &opt, &desc, &selected, &cols)){
+            n->src.select(n->src.curry, idx, !selected);
+          }
+        }else{
+          n->items[idx].selected = !n->items[idx].selected;
+        }
+      }
       ncmultiselector_draw(n);
       return true;
     }else if(nc->id == NCKEY_UP){
@@ -865,7 +1359,7 @@ ncmultiselector_dim_yx(const ncmultiselector* n, unsigned* ncdimy, unsigned* ncd
   if(rows > dimy){ // insufficient height to display selector
     return -1;
   }
-  rows += (!n->maxdisplay || n->maxdisplay > n->itemcount ? n->itemcount : n->maxdisplay) - 1; // rows necessary to display all options
+  rows += (!n->maxdisplay || n->maxdisplay > n->count ? n->count : n->maxdisplay) - 1; // rows necessary to display all options
   if(rows > dimy){ // claw excess back
     rows = dimy;
   }
@@ -882,7 +1376,9 @@ ncmultiselector_dim_yx(const ncmultiselector* n, unsigned* ncdimy, unsigned* ncd
   return 0;
 }
 
-ncmultiselector* ncmultiselector_create(ncplane* n, const ncmultiselector_options* opts){
+static ncmultiselector*
+ncmultiselector_create_internal(ncplane* n, const ncmultiselector_options* opts,
+                                const ncmselector_source* source){
   if(n == notcurses_stdplane(ncplane_notcurses(n))){
     logerror("won't use the standard plane"); // would fail later on resize
     return NULL;
@@ -896,6 +1392,11 @@ ncmultiselector* ncmultiselector_create(ncplane* n, const ncmultiselector_option
   }
   unsigned itemcount = 0;
   if(opts->items){
+    if(source){
+      logerror("items can't be provided with a source");
+      ncplane_destroy(n);
+      return NULL;
+    }
     for(const struct ncmselector_item* i = opts->items ; i->option ; ++i){
       ++itemcount;
     }
@@ -905,6 +1406,13 @@ ncmultiselector* ncmultiselector_create(ncplane* n, const ncmultiselector_option
     return NULL;
   }
   memset(ns, 0, sizeof(*ns));
+  if(source){
+    ns->src = *source;
+    if(!(ns->widths = calloc(SELECTOR_WIDTHCACHE, sizeof(*ns->widths)))){
+      goto freeitems;
+    }
+    ns->srctotal = ns->src.count(ns->src.curry);
+  }
   ns->title = opts->title ? strdup(opts->title) : NULL;
   ns->titlecols = opts->title ? ncstrwidth(opts->title, NULL, NULL) : 0;
   ns->secondary = opts->secondary ? strdup(opts->secondary) : NULL;
@@ -920,7 +1428,10 @@ ncmultiselector* ncmultiselector_create(ncplane* n, const ncmultiselector_option
   ns->descchannels = opts->descchannels;
   ns->titlechannels = opts->titlechannels;
   ns->footchannels = opts->footchannels;
-  ns->boxchannels = opts->boxchannels;
+  if(ncboxstyle_init(&ns->boxstyle, notcurses_canutf8(ncplane_notcurses(n)) ?
+                     NCBOXROUND : NCBOXASCII, 0, ns->boxchannels)){
+    goto freeitems;
+  }
   ns->darrowy = ns->uarrowy = ns->arrowx = -1;
   if(itemcount){
     if(!(ns->items = malloc(sizeof(*ns->items) * itemcount))){
@@ -958,6 +1469,7 @@ ncmultiselector* ncmultiselector_create(ncplane* n, const ncmultiselector_option
   }
   unsigned dimy, dimx;
   ns->ncp = n;
+  ncmultiselector_sync(ns);
   if(ncmultiselector_dim_yx(ns, &dimy, &dimx)){
     goto freeitems;
   }
@@ -977,11 +1489,41 @@ freeitems:
   }
   free(ns->items);
   free(ns->title); free(ns->secondary); free(ns->footer);
+  free(ns->widths);
   free(ns);
   ncplane_destroy(n);
   return NULL;
 }
 
+ncmultiselector* ncmultiselector_create(ncplane* n, const ncmultiselector_options* opts){
+  return ncmultiselector_create_internal(n, opts, NULL);
+}
+
+ncmultiselector* ncmultiselector_create_source(ncplane* n, const ncmultiselector_options* opts,
+                                               const ncmselector_source* src){
+  if(src->count == NULL || src->item == NULL){
+    logerror("source lacks count or item callback");
+    ncplane_destroy(n);
+    return NULL;
+  }
+  return ncmultiselector_create_internal(n, opts, src);
+}
+
+int ncmultiselector_filter(ncmultiselector* n, const char* prefix){
+  ncmultiselector_sync(n);
+  const unsigned total = n->src.item ? n->srctotal : n->itemcount;
+  int ret = selector_filter_set(n, ncmultiselector_option, &n->filter, total, prefix);
+  n->current = n->startdisp = 0;
+  ncmultiselector_sync(n);
+  if(ncmultiselector_fit(n)){
+    ret = -1;
+  }
+  if(ncmultiselector_draw(n)){
+    ret = -1;
+  }
+  return ret;
+}
+
 void ncmultiselector_destroy(ncmultiselector* n){
   if(n){
     while(n->itemcount--){
@@ -995,11 +1537,27 @@ void ncmultiselector_destroy(ncmultiselector* n){
     free(n->title);
     free(n->secondary);
     free(n->footer);
+    free(n->curopt);
+    free(n->widths);
+    free(n->filter.prefix);
     free(n);
   }
 }
 
 int ncmultiselector_selected(ncmultiselector* n, bool* selected, unsigned count){
+  if(n->src.item){
+    if(n->src.count(n->src.curry) != count || count < 1){
+      return -1;
+    }
+    for(unsigned idx = 0 ; idx < count ; ++idx){
+      struct ncmselector_item item = {0};
+      if(n->src.item(n->src.curry, idx, &item)){
+        return -1;
+      }
+      selected[idx] = item.selected;
+    }
+    return 0;
+  }
   if(n->itemcount != count || n->itemcount < 1){
     return -1;
   }
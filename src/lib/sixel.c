@@ -5,12 +5,26 @@
 
 #define RGBSIZE 3
 
-// number of worker threads
-// FIXME fit to local machine, but more than 3 never seems to help
-#define POPULATION 3
-
-// a worker can have up to three qstates enqueued for work
-#define WORKERDEPTH 3
+// upper bound on threads (including the calling thread) building bands
+#define SIXEL_MAXTHREADS 64
+
+// default ceiling on the encoding cache, overridden by NOTCURSES_SIXEL_CACHE
+#define SIXEL_CACHE_DEFAULT_BYTES (8u * 1024 * 1024)
+
+// images of at least this many pixels have their color tables extracted
+// into partial octrees, one per range of cell rows, which are built in
+// parallel and then merged (see extract_color_table()). there are about
+// SIXEL_PARTIAL_PIXELS pixels to a partial, and at most SIXEL_MAXPARTIALS.
+// the partitioning depends only on the image, so the result doesn't vary
+// with the number of threads.
+#define SIXEL_PARALLEL_PIXELS (1u << 18)
+#define SIXEL_PARTIAL_PIXELS (1u << 16)
+#define SIXEL_MAXPARTIALS 16
+
+// with NOTCURSES_SIXEL_SAMPLE=N, images of at least this many pixels insert
+// only every Nth pixel into the octree (see extract_cell_color_table()).
+#define SIXEL_SAMPLE_PIXELS (1u << 20)
+#define SIXEL_MAXSAMPLE 64
 
 // this palette entry is a sentinel for a transparent pixel (and thus caps
 // the palette at 65535 other entries).
@@ -63,6 +77,8 @@ typedef enum {
 typedef struct sixelband {
   int size;     // capacity FIXME if same for all, eliminate this
   char** vecs;  // array of vectors, many of which can be NULL
+  int* lens;    // length of each non-NULL vector, so we needn't strlen()
+  bool dirty;   // changed by a wipe or restore since last written out
 } sixelband;
 
 // across the life of the sixel, we'll need to wipe and restore cells, without
@@ -82,12 +98,49 @@ typedef struct sixelmap {
   int colors;
   int sixelbands;
   sixelband* bands;      // |sixelbands| collections of sixel vectors
+  // the length of each band's vectors, if they were all allocated to their
+  // maximum (so that they can be reused by a subsequent blit), otherwise 0.
+  int veclen;
   sixel_p2_e p2;         // set to SIXEL_P2_TRANS if we have transparent pixels
+  // where each band begins within the encoded payload (relative to the end of
+  // the header), plus where the terminator begins. NULL until the payload has
+  // been written out in full, after which dirty bands can be spliced in.
+  size_t* bandoffs;
+  // once a sprixel has been blitted more than once, we assume it to be
+  // showing video, and keep the source pixels of the current frame, along
+  // with the 8-bit components of its color registers, so that the next
+  // frame can be compared against it (see sixel_stream_blit()).
+  uint32_t* frame;       // |framerows| x |framecols| source pixels, or NULL
+  int framerows, framecols;
+  size_t framealloc;     // pixels allocated at |frame|
+  uint32_t transcolor;   // transcolor in effect when |frame| was blitted
+  int32_t* palette;      // r, g, and b of each color register, padded
+  int palpadded;         // entries in each component array of |palette|
+  int palalloc;          // entries allocated in each component array
+  // if non-empty, the bands which changed from the previously-displayed
+  // frame, to be drawn atop it in lieu of the full glyph.
+  fbuf delta;
 } sixelmap;
 
 typedef struct qstate {
-  int refcount; // initialized to worker count
+  struct qstate* next;    // next job in the engine's queue
+  int refcount;           // workers currently building our bands
   atomic_int bandbuilder; // threads take bands as their work unit
+  // while extracting into partials, threads instead take those as their
+  // work unit. each partial is itself a qstate, with its own octree and a
+  // scratch sixelmap, covering cells [cellbeg, cellend).
+  bool extracting;
+  atomic_int extractor;
+  struct qstate** partials;
+  int partialcount;
+  long cellbeg, cellend;
+  bool failed;            // a partial couldn't be extracted
+  // only every samplemod-th pixel is inserted into the octree, and colors
+  // absent from it are mapped to the nearest color register.
+  int samplemod;
+  // if set, only dirty bands are built, and pixels are mapped to the nearest
+  // of smap's existing color registers rather than looked up in the octree.
+  bool reuse;
   // we always work in terms of quantized colors (quantization is the first
   // step of rendering), using indexes into the derived palette. the actual
   // palette need only be stored during the initial render, since the sixel
@@ -108,59 +161,69 @@ typedef struct qstate {
   int leny, lenx;
 } qstate;
 
-// a work_queue per worker thread. if used == WORKERDEPTH, this thread is
-// backed up, and we cannot enqueue to it. writeto wraps around the array.
-typedef struct work_queue {
-  qstate* qstates[WORKERDEPTH];
-  unsigned writeto;
-  unsigned used;
-  struct sixel_engine* sengine;
-} work_queue;
-
-// we keep a few worker threads (POPULATION) spun up to assist with
-// quantization. each has an array of up to WORKERDEPTH qstates to work on.
+// we keep a pool of worker threads spun up to assist with quantization,
+// sized to the host (see sixel_threads_wanted()). every qstate with bands
+// remaining sits on a single queue; idle workers attach to the oldest job
+// and claim its bands one at a time via bandbuilder, alongside the thread
+// which submitted it. a job leaves the queue once all its bands have been
+// claimed, so workers move on to the next job while stragglers finish up.
 typedef struct sixel_engine {
   pthread_mutex_t lock;
   pthread_cond_t cond;
-  work_queue queues[POPULATION];
-  pthread_t tids[POPULATION];
+  qstate* jobs;     // qstates with unclaimed bands, oldest first
+  pthread_t* tids;
+  unsigned workers; // worker threads, not counting the caller
   bool done;
+  // the encoding cache has its own lock, so lookups needn't contend with
+  // workers picking up bands.
+  pthread_mutex_t cachelock;
+  struct sixelcache* cache; // most recently used first
+  size_t cachebytes;        // approximate bytes held by cache entries
+  size_t cachemax;          // ceiling on cachebytes; 0 disables the cache
+  uint64_t cachehits;
+  uint64_t cachemisses;
+  unsigned samplemod;       // from NOTCURSES_SIXEL_SAMPLE; 1 samples all
 } sixel_engine;
 
-// enqueue |qs| to any workers with available space. the number of workers with
-// a reference will be stored in |qs|->refcount.
+// remove |qs| from the job queue, if it's still there. call with lock held.
+static void
+unlink_job(sixel_engine* eng, qstate* qs){
+  for(qstate** q = &eng->jobs ; *q ; q = &(*q)->next){
+    if(*q == qs){
+      *q = qs->next;
+      qs->next = NULL;
+      break;
+    }
+  }
+}
+
+// make |qs| available to any idle workers. the submitting thread is expected
+// to build bands itself, and then call block_on_workers().
 static void
 enqueue_to_workers(sixel_engine* eng, qstate* qs){
-  if(eng == NULL){
+  qs->refcount = 0;
+  qs->next = NULL;
+  if(eng == NULL || eng->workers == 0){
     return;
   }
-  int usecount = 0;
   pthread_mutex_lock(&eng->lock);
-  for(int i = 0 ; i < POPULATION ; ++i){
-    work_queue* wq = &eng->queues[i];
-    if(wq->used < WORKERDEPTH){
-      wq->qstates[wq->writeto] = qs;
-      ++wq->used;
-      ++usecount;
-      if(++wq->writeto == WORKERDEPTH){
-        wq->writeto = 0;
-      }
-    }
+  qstate** q = &eng->jobs;
+  while(*q){
+    q = &(*q)->next;
   }
-  qs->refcount = usecount;
+  *q = qs;
   pthread_mutex_unlock(&eng->lock);
-  if(usecount){
-    pthread_cond_broadcast(&eng->cond);
-  }
+  pthread_cond_broadcast(&eng->cond);
 }
 
 // block until all workers have finished up with |qs|
 static void
 block_on_workers(sixel_engine* eng, qstate* qs){
-  if(eng == NULL){
+  if(eng == NULL || eng->workers == 0){
     return;
   }
   pthread_mutex_lock(&eng->lock);
+  unlink_job(eng, qs);
   while(qs->refcount){
     pthread_cond_wait(&eng->cond, &eng->lock);
   }
@@ -183,10 +246,9 @@ sixelbandcount(int dimy){
   return sixelcount(dimy, 1);
 }
 
-// whip up a sixelmap sans data for the specified pixel geometry and color
-// register count.
+// whip up a sixelmap sans data for the specified pixel geometry.
 static sixelmap*
-sixelmap_create(int dimy){
+sixelmap_create(int dimy, int dimx){
   sixelmap* ret = malloc(sizeof(*ret));
   if(ret){
     ret->p2 = SIXEL_P2_ALLOPAQUE;
@@ -199,8 +261,19 @@ sixelmap_create(int dimy){
     }
     for(int i = 0 ; i < ret->sixelbands ; ++i){
       ret->bands[i].size = 0;
+      ret->bands[i].vecs = NULL;
+      ret->bands[i].lens = NULL;
+      ret->bands[i].dirty = false;
     }
+    ret->veclen = dimx + 1;
     ret->colors = 0;
+    ret->bandoffs = NULL;
+    ret->frame = NULL;
+    ret->framerows = ret->framecols = 0;
+    ret->framealloc = 0;
+    ret->palette = NULL;
+    ret->palalloc = 0;
+    memset(&ret->delta, 0, sizeof(ret->delta));
   }
   return ret;
 }
@@ -211,6 +284,48 @@ sixelband_free(sixelband* s){
     free(s->vecs[j]);
   }
   free(s->vecs);
+  free(s->lens);
+}
+
+// reset |s| in place for a fresh blit of the specified pixel geometry. if
+// the geometry is unchanged, the bands keep their vectors, to be rewritten
+// by build_sixel_band(); the kept frame, palette, and delta buffers are
+// retained regardless, though their contents are forgotten. video at a
+// steady geometry thus allocates nothing here. frees |s| on failure.
+static sixelmap*
+sixelmap_recycle(sixelmap* s, int dimy, int dimx){
+  const int bands = sixelbandcount(dimy);
+  if(bands != s->sixelbands || s->veclen != dimx + 1){
+    for(int i = 0 ; i < s->sixelbands ; ++i){
+      sixelband_free(&s->bands[i]);
+    }
+    if(bands != s->sixelbands){
+      sixelband* tmp = realloc(s->bands, sizeof(*tmp) * bands);
+      if(tmp == NULL){
+        s->sixelbands = 0;
+        sixelmap_free(s);
+        return NULL;
+      }
+      s->bands = tmp;
+      s->sixelbands = bands;
+    }
+    for(int i = 0 ; i < s->sixelbands ; ++i){
+      s->bands[i].size = 0;
+      s->bands[i].vecs = NULL;
+      s->bands[i].lens = NULL;
+    }
+    s->veclen = dimx + 1;
+  }
+  for(int i = 0 ; i < s->sixelbands ; ++i){
+    s->bands[i].dirty = false;
+  }
+  s->p2 = SIXEL_P2_ALLOPAQUE;
+  s->colors = 0;
+  free(s->bandoffs);
+  s->bandoffs = NULL;
+  s->framerows = s->framecols = 0;
+  fbuf_reset(&s->delta);
+  return s;
 }
 
 void sixelmap_free(sixelmap *s){
@@ -219,15 +334,62 @@ void sixelmap_free(sixelmap *s){
       sixelband_free(&s->bands[i]);
     }
     free(s->bands);
+    free(s->bandoffs);
+    free(s->frame);
+    free(s->palette);
+    fbuf_free(&s->delta);
     free(s);
   }
 }
 
+size_t sixelmap_bytes(const sixelmap* s){
+  if(s == NULL){
+    return 0;
+  }
+  size_t ret = sizeof(*s) + sizeof(*s->bands) * s->sixelbands;
+  for(int i = 0 ; i < s->sixelbands ; ++i){
+    const sixelband* b = &s->bands[i];
+    ret += (sizeof(*b->vecs) + sizeof(*b->lens)) * b->size;
+    for(int j = 0 ; j < b->size ; ++j){
+      if(b->vecs[j]){
+        ret += s->veclen ? s->veclen : b->lens[j] + 1;
+      }
+    }
+  }
+  if(s->bandoffs){
+    ret += sizeof(*s->bandoffs) * (s->sixelbands + 1);
+  }
+  ret += sizeof(*s->frame) * s->framealloc;
+  ret += sizeof(*s->palette) * s->palalloc * 3;
+  ret += s->delta.size;
+  return ret;
+}
+
+// rgb [0..255] scaled to sixel [0..100] and rounded, with 100 taken to 99.
+// this is consulted for every channel of every pixel, so it's precomputed.
+static const unsigned char sixelscale[256] = {
+   0,  0,  1,  1,  2,  2,  2,  3,  3,  4,  4,  4,  5,  5,  5,  6,
+   6,  7,  7,  7,  8,  8,  9,  9,  9, 10, 10, 11, 11, 11, 12, 12,
+  13, 13, 13, 14, 14, 15, 15, 15, 16, 16, 16, 17, 17, 18, 18, 18,
+  19, 19, 20, 20, 20, 21, 21, 22, 22, 22, 23, 23, 24, 24, 24, 25,
+  25, 25, 26, 26, 27, 27, 27, 28, 28, 29, 29, 29, 30, 30, 31, 31,
+  31, 32, 32, 33, 33, 33, 34, 34, 35, 35, 35, 36, 36, 36, 37, 37,
+  38, 38, 38, 39, 39, 40, 40, 40, 41, 41, 42, 42, 42, 43, 43, 44,
+  44, 44, 45, 45, 45, 46, 46, 47, 47, 47, 48, 48, 49, 49, 49, 50,
+  50, 51, 51, 51, 52, 52, 53, 53, 53, 54, 54, 55, 55, 55, 56, 56,
+  56, 57, 57, 58, 58, 58, 59, 59, 60, 60, 60, 61, 61, 62, 62, 62,
+  63, 63, 64, 64, 64, 65, 65, 65, 66, 66, 67, 67, 67, 68, 68, 69,
+  69, 69, 70, 70, 71, 71, 71, 72, 72, 73, 73, 73, 74, 74, 75, 75,
+  75, 76, 76, 76, 77, 77, 78, 78, 78, 79, 79, 80, 80, 80, 81, 81,
+  82, 82, 82, 83, 83, 84, 84, 84, 85, 85, 85, 86, 86, 87, 87, 87,
+  88, 88, 89, 89, 89, 90, 90, 91, 91, 91, 92, 92, 93, 93, 93, 94,
+  94, 95, 95, 95, 96, 96, 96, 97, 97, 98, 98, 98, 99, 99, 99, 99,
+};
+
 // convert rgb [0..255] to sixel [0..99]
 static inline unsigned
 ss(unsigned c){
-  unsigned r = round(c * 100.0 / 255); // use real [0..100] scaling
-  return r > 99 ? 99: r;
+  return sixelscale[c];
 }
 
 // get the keys for an rgb point. the returned value is on [0..999], and maps
@@ -272,22 +434,20 @@ qidx(const qnode* q){
 // octree, flattened into an array; the latter are used as an actual octree.
 // we must have 8 dynnodes available for every onode we create, or we can run
 // into a situation where we don't have an available dynnode
-// (see insert_color()).
+// (see insert_color()). everything comes from the arena, and is reclaimed by
+// the caller's arena_release() (including the table, allocated later).
 static qstate*
 alloc_qstate(unsigned colorregs){
-  qstate* qs = malloc(sizeof(*qs));
+  qstate* qs = arena_alloc(sizeof(*qs));
   if(qs){
     qs->dynnodes_free = colorregs;
     qs->dynnodes_total = qs->dynnodes_free;
-    if((qs->qnodes = malloc((QNODECOUNT + qs->dynnodes_total) * sizeof(qnode))) == NULL){
-      free(qs);
+    if((qs->qnodes = arena_alloc((QNODECOUNT + qs->dynnodes_total) * sizeof(qnode))) == NULL){
       return NULL;
     }
     qs->onodes_free = qs->dynnodes_total / 8;
     qs->onodes_total = qs->onodes_free;
-    if((qs->onodes = malloc(qs->onodes_total * sizeof(*qs->onodes))) == NULL){
-      free(qs->qnodes);
-      free(qs);
+    if((qs->onodes = arena_alloc(qs->onodes_total * sizeof(*qs->onodes))) == NULL){
       return NULL;
     }
     // don't technically need to clear the components, as we could
@@ -296,28 +456,19 @@ alloc_qstate(unsigned colorregs){
     // when we pull a dynamic one that it needs its popcount initialized.
     memset(qs->qnodes, 0, sizeof(qnode) * QNODECOUNT);
     qs->table = NULL;
+    qs->reuse = false;
+    qs->extracting = false;
+    qs->partials = NULL;
+    qs->partialcount = 0;
+    qs->failed = false;
+    qs->samplemod = 1;
   }
   return qs;
 }
 
-// free internals of qstate object
-static void
-free_qstate(qstate *qs){
-  if(qs){
-    loginfo("freeing qstate");
-    free(qs->qnodes);
-    free(qs->onodes);
-    free(qs->table);
-    free(qs);
-  }
-}
-
-// insert a color from the source image into the octree.
+// insert |pop| instances of a color into the octree.
 static inline int
-insert_color(qstate* qs, uint32_t pixel){
-  const unsigned r = ncpixel_r(pixel);
-  const unsigned g = ncpixel_g(pixel);
-  const unsigned b = ncpixel_b(pixel);
+insert_color_pop(qstate* qs, unsigned r, unsigned g, unsigned b, uint32_t pop){
   unsigned skey;
   const unsigned key = qnode_keys(r, g, b, &skey);
   assert(key < QNODECOUNT);
@@ -327,7 +478,7 @@ insert_color(qstate* qs, uint32_t pixel){
     q->q.comps[0] = r;
     q->q.comps[1] = g;
     q->q.comps[2] = b;
-    q->q.pop = 1;
+    q->q.pop = pop;
     ++qs->smap->colors;
     return 0;
   }
@@ -338,7 +489,7 @@ insert_color(qstate* qs, uint32_t pixel){
     unsigned skeynat;
     qnode_keys(q->q.comps[0], q->q.comps[1], q->q.comps[2], &skeynat);
     if(skey == skeynat){
-      ++q->q.pop; // pretty good match
+      q->q.pop += pop; // pretty good match
       return 0;
     }
     // we want to fracture. if we have no onodes, though, we can't.
@@ -347,7 +498,7 @@ insert_color(qstate* qs, uint32_t pixel){
     // it's a symmetry between creation and extension.
     if(qs->dynnodes_free == 0 || qs->onodes_free == 0){
 //fprintf(stderr, "NO FREE ONES %u\n", key);
-      ++q->q.pop; // not a great match, but we're already scattered
+      q->q.pop += pop; // not a great match, but we're already scattered
       return 0;
     }
     // get the next free onode and zorch it out
@@ -370,7 +521,7 @@ insert_color(qstate* qs, uint32_t pixel){
   }
   if(o->q[skey]){
     // our subnode is already present, huzzah. increase its popcount.
-    ++o->q[skey]->q.pop;
+    o->q[skey]->q.pop += pop;
     return 0;
   }
   // we try otherwise to insert ourselves into o. this requires a free dynnode.
@@ -383,7 +534,7 @@ insert_color(qstate* qs, uint32_t pixel){
   // get the next free dynnode and assign it to o, account for dnode
   o->q[skey] = &qs->qnodes[QNODECOUNT + qs->dynnodes_total - qs->dynnodes_free];
   --qs->dynnodes_free;
-  o->q[skey]->q.pop = 1;
+  o->q[skey]->q.pop = pop;
   o->q[skey]->q.comps[0] = r;
   o->q[skey]->q.comps[1] = g;
   o->q[skey]->q.comps[2] = b;
@@ -394,6 +545,63 @@ insert_color(qstate* qs, uint32_t pixel){
   return 0;
 }
 
+// insert a color from the source image into the octree.
+static inline int
+insert_color(qstate* qs, uint32_t pixel){
+  return insert_color_pop(qs, ncpixel_r(pixel), ncpixel_g(pixel),
+                          ncpixel_b(pixel), 1);
+}
+
+// fold the octree of |part| into that of |qs|. each color is inserted with
+// its population, in key order. a node keeps the color of whichever pixel
+// first reached it, so merging the partials in image order mostly yields
+// the representatives a serial extraction would have chosen.
+static int
+merge_partial(qstate* qs, const qstate* part){
+  for(int z = 0 ; z < QNODECOUNT ; ++z){
+    const qnode* q = &part->qnodes[z];
+    if(q->q.pop){
+      if(insert_color_pop(qs, q->q.comps[0], q->q.comps[1], q->q.comps[2], q->q.pop)){
+        return -1;
+      }
+    }else if(q->qlink){
+      const onode* o = &part->onodes[q->qlink - 1];
+      for(int i = 0 ; i < 8 ; ++i){
+        if(o->q[i] && o->q[i]->q.pop){
+          const qsample* s = &o->q[i]->q;
+          if(insert_color_pop(qs, s->comps[0], s->comps[1], s->comps[2], s->pop)){
+            return -1;
+          }
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+// when sampling, a pixel's color might not have made it into the octree.
+// find the nearest color register instead (in sixel space, as that's what
+// the table holds).
+static int
+nearest_table_color(const qstate* qs, unsigned r, unsigned g, unsigned b){
+  const int sr = ss(r);
+  const int sg = ss(g);
+  const int sb = ss(b);
+  int ret = 0;
+  int dist = INT_MAX;
+  for(int c = 0 ; c < qs->smap->colors ; ++c){
+    const int dr = qs->table[RGBSIZE * c + 0] - sr;
+    const int dg = qs->table[RGBSIZE * c + 1] - sg;
+    const int db = qs->table[RGBSIZE * c + 2] - sb;
+    const int d = dr * dr + dg * dg + db * db;
+    if(d < dist){
+      dist = d;
+      ret = c;
+    }
+  }
+  return ret;
+}
+
 // resolve the input color to a color table index following any postprocessing
 // of the octree.
 static inline int
@@ -407,10 +615,14 @@ find_color(const qstate* qs, uint32_t pixel){
   if(q->qlink && q->q.pop == 0){
     if(qs->onodes[q->qlink - 1].q[skey]){
       q = qs->onodes[q->qlink - 1].q[skey];
+    }else if(qs->samplemod > 1){
+      return nearest_table_color(qs, r, g, b);
     }else{
       logpanic("internal error: no color for 0x%016x", pixel);
       return -1;
     }
+  }else if(q->q.pop == 0 && qs->samplemod > 1){
+    return nearest_table_color(qs, r, g, b);
   }
   return qidx(q);
 }
@@ -557,6 +769,7 @@ wipe_color(sixelband* b, int color, int y, int endy, int startx, int endx,
   // are done, and can copy any remaining elements blindly.
   int x = 0;
   int voff = 0;
+  int vlen = 0;
   while(*vec){
     if(isdigit(*vec)){
       rle *= 10;
@@ -605,7 +818,8 @@ wipe_color(sixelband* b, int color, int y, int endy, int startx, int endx,
     }
     ++vec;
     if(x >= endx){
-      strcpy(newvec + voff, vec); // there is always room
+      vlen = strlen(vec);
+      memcpy(newvec + voff, vec, vlen + 1); // there is always room
       break;
     }
   }
@@ -617,6 +831,7 @@ wipe_color(sixelband* b, int color, int y, int endy, int startx, int endx,
     newvec = NULL;
   }
   b->vecs[color] = newvec;
+  b->lens[color] = voff + vlen;
   return wiped;
 }
 
@@ -646,6 +861,9 @@ wipe_band(sixelmap* smap, int band, int startx, int endx,
     wiped += wipe_color(b, i, band * 6, endy, startx, endx, mask,
                         dimx, auxvec, cellpxy, cellpxx);
   }
+  if(wiped){
+    b->dirty = true;
+  }
   return wiped;
 }
 
@@ -654,7 +872,7 @@ wipe_band(sixelmap* smap, int band, int startx, int endx,
 // redrawn, it's redrawn using P2=1.
 int sixel_wipe(sprixel* s, int ycell, int xcell){
 //fprintf(stderr, "WIPING %d/%d\n", ycell, xcell);
-  uint8_t* auxvec = sixel_trans_auxvec(ncplane_pile(s->n));
+  uint8_t* auxvec = sixel_trans_auxvec(s);
   if(auxvec == NULL){
     return -1;
   }
@@ -807,6 +1025,133 @@ get_active_set(qstate* qs, uint32_t colors){
   return act;
 }
 
+// colors which didn't get a color register are mapped to the nearest (by
+// squared euclidean distance over their 8-bit components) color which did.
+// the components of the chosen colors are laid out in their own arrays,
+// padded with unreachable colors to a whole number of vectors, and searched
+// PALETTE_LANES at a time.
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9)
+typedef int32_t palettelanes __attribute__ ((vector_size (32)));
+#define PALETTE_LANES ((int)(sizeof(palettelanes) / sizeof(int32_t)))
+
+#if defined(__x86_64__) && defined(__GLIBC__) && !defined(__clang__)
+#define PALETTE_CLONES __attribute__ ((target_clones ("avx2", "default")))
+#else
+#define PALETTE_CLONES
+#endif
+#else
+#define PALETTE_LANES 8
+#define PALETTE_CLONES
+#endif
+
+#define PALETTE_PAD 0x4000 // far enough from any rgb that it's never nearest
+
+// returns the index of the first of the |padded| colors nearest to r/g/b.
+PALETTE_CLONES static int
+nearest_palette_entry(const int32_t* pr, const int32_t* pg, const int32_t* pb,
+                      int padded, int r, int g, int b){
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9)
+  palettelanes best, bestidx, idx;
+  for(int l = 0 ; l < PALETTE_LANES ; ++l){
+    best[l] = INT32_MAX;
+    bestidx[l] = 0;
+    idx[l] = l;
+  }
+  for(int i = 0 ; i < padded ; i += PALETTE_LANES){
+    palettelanes vr, vg, vb;
+    memcpy(&vr, pr + i, sizeof(vr));
+    memcpy(&vg, pg + i, sizeof(vg));
+    memcpy(&vb, pb + i, sizeof(vb));
+    vr -= r;
+    vg -= g;
+    vb -= b;
+    const palettelanes d = vr * vr + vg * vg + vb * vb;
+    const palettelanes closer = d < best; // all ones where true
+    best = (d & closer) | (best & ~closer);
+    bestidx = (idx & closer) | (bestidx & ~closer);
+    idx += PALETTE_LANES;
+  }
+  // each lane holds its first nearest entry; take the first of the nearest
+  int ret = bestidx[0];
+  int32_t dist = best[0];
+  for(int l = 1 ; l < PALETTE_LANES ; ++l){
+    if(best[l] < dist || (best[l] == dist && bestidx[l] < ret)){
+      dist = best[l];
+      ret = bestidx[l];
+    }
+  }
+  return ret;
+#else
+  int ret = 0;
+  int32_t dist = INT32_MAX;
+  for(int i = 0 ; i < padded ; ++i){
+    const int32_t dr = pr[i] - r;
+    const int32_t dg = pg[i] - g;
+    const int32_t db = pb[i] - b;
+    const int32_t d = dr * dr + dg * dg + db * db;
+    if(d < dist){
+      dist = d;
+      ret = i;
+    }
+  }
+  return ret;
+#endif
+}
+
+// map each color lacking a color register to the nearest chosen one. |chosen|
+// holds the |count| chosen colors, in descending order of color register.
+static int
+map_to_nearest(qstate* qs, const qnode* chosen, int count){
+  const int padded = (count + PALETTE_LANES - 1) / PALETTE_LANES * PALETTE_LANES;
+  int32_t* comps = malloc(sizeof(*comps) * padded * 3);
+  if(comps == NULL){
+    return -1;
+  }
+  int32_t* pr = comps;
+  int32_t* pg = comps + padded;
+  int32_t* pb = comps + padded * 2;
+  for(int c = 0 ; c < padded ; ++c){
+    if(c < count){
+      const qnode* q = &chosen[count - 1 - c];
+      pr[c] = q->q.comps[0];
+      pg[c] = q->q.comps[1];
+      pb[c] = q->q.comps[2];
+    }else{
+      pr[c] = pg[c] = pb[c] = PALETTE_PAD;
+    }
+  }
+  // fractured static nodes have no population, and all dynamic nodes in use
+  // are populated, so this visits each color exactly once.
+  const unsigned total = QNODECOUNT + (qs->dynnodes_total - qs->dynnodes_free);
+  for(unsigned z = 0 ; z < total ; ++z){
+    qnode* q = &qs->qnodes[z];
+    if(q->q.pop && !chosen_p(q)){
+      q->cidx = nearest_palette_entry(pr, pg, pb, padded, q->q.comps[0],
+                                      q->q.comps[1], q->q.comps[2]);
+    }
+  }
+  free(comps);
+  return 0;
+}
+
+// the color register of |smap| nearest to |pixel|, writing the squared
+// distance to it to |dist| if non-NULL.
+static inline int
+reused_color(const sixelmap* smap, uint32_t pixel, int32_t* dist){
+  const int32_t* pr = smap->palette;
+  const int32_t* pg = pr + smap->palpadded;
+  const int32_t* pb = pg + smap->palpadded;
+  const int r = ncpixel_r(pixel);
+  const int g = ncpixel_g(pixel);
+  const int b = ncpixel_b(pixel);
+  const int idx = nearest_palette_entry(pr, pg, pb, smap->palpadded, r, g, b);
+  if(dist){
+    *dist = (pr[idx] - r) * (pr[idx] - r) + (pg[idx] - g) * (pg[idx] - g) +
+            (pb[idx] - b) * (pb[idx] - b);
+  }
+  return idx;
+}
+
 static inline int
 find_next_lowest_chosen(const qstate* qs, int z, int i, const qnode** hq){
 //fprintf(stderr, "FIRST CHOSEN: %u %d\n", z, i);
@@ -887,6 +1232,18 @@ merge_color_table(qstate* qs){
     qs->qnodes[qactive[z].qlink].cidx = make_chosen(cidx);
     ++cidx;
   }
+  if(qs->smap->colors > qs->bargs->u.pixel.colorregs &&
+     !(qs->bargs->flags & NCVISUAL_OPTION_QUANTFAST)){
+    // the chosen colors are the most popular, at the top of qactive
+    const int regs = qs->bargs->u.pixel.colorregs;
+    int r = map_to_nearest(qs, qactive + qs->smap->colors - regs, regs);
+    free(qactive);
+    if(r){
+      return -1;
+    }
+    qs->smap->colors = regs;
+    return 0;
+  }
   free(qactive);
   if(qs->smap->colors > qs->bargs->u.pixel.colorregs){
     // tend to those which couldn't get a color table entry. we start with two
@@ -898,7 +1255,9 @@ merge_color_table(qstate* qs){
     // lowest, hi is reset to -1. otherwise, set hi. once we have the new hi > z,
     // determine which of hi and lo are closer to z, discounting -1 values, and
     // link te closer one to z. a toplevel node is worth 8 in terms of distance;
-    // and lowlevel node is worth 1.
+    // and lowlevel node is worth 1. this is much quicker than finding the
+    // nearest chosen color, but much coarser, and is used only when
+    // NCVISUAL_OPTION_QUANTFAST is provided.
     int lo = -1;
     int hi = -1;
     const qnode* lq = NULL;
@@ -946,19 +1305,45 @@ static inline int
 build_sixel_band(qstate* qs, int bnum){
 //fprintf(stderr, "building band %d\n", bnum);
   sixelband* b = &qs->smap->bands[bnum];
-  b->size = qs->smap->colors;
-  size_t bsize = sizeof(*b->vecs) * b->size;
-  size_t mlen = qs->smap->colors * sizeof(struct band_extender);
-  struct band_extender* meta = malloc(mlen);
-  if(meta == NULL){
-    return -1;
+  const int colors = qs->smap->colors;
+  // a recycled band keeps its vectors (see sixelmap_recycle()), which we
+  // write over from the beginning. those beyond our colors are dropped.
+  if(b->size != colors){
+    for(int i = colors ; i < b->size ; ++i){
+      free(b->vecs[i]);
+    }
+    if(colors == 0){
+      free(b->vecs);
+      free(b->lens);
+      b->vecs = NULL;
+      b->lens = NULL;
+      b->size = 0;
+      return 0;
+    }
+    char** tmp = realloc(b->vecs, sizeof(*b->vecs) * colors);
+    if(tmp == NULL){
+      b->size = b->size < colors ? b->size : colors;
+      return -1;
+    }
+    b->vecs = tmp;
+    int* ltmp = realloc(b->lens, sizeof(*b->lens) * colors);
+    if(ltmp == NULL){
+      b->size = b->size < colors ? b->size : colors;
+      return -1;
+    }
+    b->lens = ltmp;
+    for(int i = b->size ; i < colors ; ++i){
+      b->vecs[i] = NULL;
+    }
+    b->size = colors;
   }
-  b->vecs = malloc(bsize);
-  if(b->vecs == NULL){
-    free(meta);
+  const arenamark mark = arena_mark();
+  size_t mlen = colors * sizeof(struct band_extender);
+  struct band_extender* meta = arena_alloc(mlen);
+  if(meta == NULL){
+    arena_release(mark);
     return -1;
   }
-  memset(b->vecs, 0, bsize);
   memset(meta, 0, mlen);
   const int ystart = qs->bargs->begy + bnum * 6;
   const int endy = (bnum + 1 == qs->smap->sixelbands ?
@@ -968,6 +1353,10 @@ build_sixel_band(qstate* qs, int bnum){
     int rep;   // non-zero representation, 1..63
   } active[6];
   // we're going to advance horizontally through the sixelband
+  // when mapping to existing color registers, remember the last pixel seen
+  // in each row of the band, since runs of a single color are common.
+  uint32_t lastrgb[6];
+  int lastidx[6] = { -1, -1, -1, -1, -1, -1 };
   int x;
   // FIXME we could greatly clean this up by tracking, for each color, the active
   // rep and the number of times we've seen it...but only write it out either (a)
@@ -985,9 +1374,18 @@ build_sixel_band(qstate* qs, int bnum){
       if(rgba_trans_p(*rgb, qs->bargs->transcolor)){
         continue;
       }
-      int cidx = find_color(qs, *rgb);
+      int cidx;
+      if(qs->reuse){
+        if(lastidx[y - ystart] < 0 || lastrgb[y - ystart] != *rgb){
+          lastrgb[y - ystart] = *rgb;
+          lastidx[y - ystart] = reused_color(qs->smap, *rgb, NULL);
+        }
+        cidx = lastidx[y - ystart];
+      }else{
+        cidx = find_color(qs, *rgb);
+      }
       if(cidx < 0){
-        // FIXME free?
+        arena_release(mark);
         return -1;
       }
       int act;
@@ -1012,8 +1410,10 @@ build_sixel_band(qstate* qs, int bnum){
       }else{
         b->vecs[c] = sixelband_extend(b->vecs[c], &meta[c], qs->lenx, x);
         if(b->vecs[c] == NULL){
+          arena_release(mark);
           return -1;
         }
+        b->lens[c] = meta[c].length;
         meta[c].rle = 1;
         meta[c].wrote = x;
         meta[c].rep = active[i].rep;
@@ -1024,13 +1424,16 @@ build_sixel_band(qstate* qs, int bnum){
     if(meta[i].rle){ // color was wholly unused iff rle == 0 at end
       b->vecs[i] = sixelband_extend(b->vecs[i], &meta[i], qs->lenx, x);
       if(b->vecs[i] == NULL){
+        arena_release(mark);
         return -1;
       }
+      b->lens[i] = meta[i].length;
     }else{
+      free(b->vecs[i]);
       b->vecs[i] = NULL;
     }
   }
-  free(meta);
+  arena_release(mark);
   return 0;
 }
 
@@ -1038,6 +1441,9 @@ static int
 bandworker(qstate* qs){
   int b;
   while((b = qs->bandbuilder++) < qs->smap->sixelbands){
+    if(qs->reuse && !qs->smap->bands[b].dirty){
+      continue;
+    }
     if(build_sixel_band(qs, b) < 0){
       return -1;
     }
@@ -1054,13 +1460,13 @@ build_data_table(sixel_engine* sengine, qstate* qs){
     logerror("no sixels");
     return -1;
   }
-  qs->bandbuilder = 0;
-  enqueue_to_workers(sengine, qs);
   size_t tsize = RGBSIZE * smap->colors;
-  qs->table = malloc(tsize);
+  qs->table = arena_alloc(tsize);
   if(qs->table == NULL){
     return -1;
   }
+  qs->bandbuilder = 0;
+  enqueue_to_workers(sengine, qs);
   load_color_table(qs);
   bandworker(qs);
   block_on_workers(sengine, qs);
@@ -1105,11 +1511,11 @@ extract_cell_color_table(qstate* qs, long cellid){
     if(rgba_trans_p(*rgb, qs->bargs->transcolor)){
       update_rmatrix(rmatrix, cellid, tam);
       tam[cellid].state = SPRIXCELL_ANNIHILATED_TRANS;
-      free(tam[cellid].auxvector);
+      auxvec_put(tam[cellid].auxvector);
       tam[cellid].auxvector = NULL;
     }else{
       update_rmatrix(rmatrix, cellid, tam);
-      free(tam[cellid].auxvector);
+      auxvec_put(tam[cellid].auxvector);
       tam[cellid].auxvector = NULL;
     }
   }else{
@@ -1121,6 +1527,9 @@ extract_cell_color_table(qstate* qs, long cellid){
       tam[cellid].state = SPRIXCELL_OPAQUE_SIXEL;
     }
   }
+  // when sampling, the first opaque pixel of each cell is always inserted,
+  // so that any cell with color contributes some.
+  bool sampled = false;
   for(int visy = cstarty ; visy < cendy ; ++visy){   // current abs pixel row
     for(int visx = cstartx ; visx < cendx ; ++visx){ // current abs pixel col
       rgb = (qs->data + (qs->linesize / 4 * visy) + visx);
@@ -1149,6 +1558,11 @@ extract_cell_color_table(qstate* qs, long cellid){
       if(rgba_trans_p(*rgb, qs->bargs->transcolor)){
         continue;
       }
+      // sample along diagonals, which don't alias with rows or columns
+      if(sampled && (visy + visx) % qs->samplemod){
+        continue;
+      }
+      sampled = qs->samplemod > 1;
       if(insert_color(qs, *rgb)){
         return -1;
       }
@@ -1163,11 +1577,79 @@ extract_cell_color_table(qstate* qs, long cellid){
   return 0;
 }
 
+// extract partials until none remain unclaimed. each cell's TAM and rmatrix
+// entries are touched only by the partial containing it.
+static int
+extractworker(qstate* qs){
+  int p;
+  while((p = qs->extractor++) < qs->partialcount){
+    qstate* part = qs->partials[p];
+    for(long cellid = part->cellbeg ; cellid < part->cellend ; ++cellid){
+      if(extract_cell_color_table(part, cellid)){
+        part->failed = true;
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+// split the cell rows among partials, extract them across the workers, and
+// merge their octrees (in order) into that of |qs|. everything comes from
+// the submitter's arena, which is safe since we block on the workers.
+static int
+extract_partials(sixel_engine* sengine, qstate* qs, int crows, int ccols,
+                 int partials){
+  qs->partials = arena_alloc(sizeof(*qs->partials) * partials);
+  if(qs->partials == NULL){
+    return -1;
+  }
+  for(int p = 0 ; p < partials ; ++p){
+    qstate* part = alloc_qstate(qs->bargs->u.pixel.colorregs);
+    sixelmap* psmap = arena_alloc(sizeof(*psmap));
+    if(part == NULL || psmap == NULL){
+      return -1;
+    }
+    memset(psmap, 0, sizeof(*psmap));
+    part->bargs = qs->bargs;
+    part->data = qs->data;
+    part->linesize = qs->linesize;
+    part->leny = qs->leny;
+    part->lenx = qs->lenx;
+    part->samplemod = qs->samplemod;
+    part->smap = psmap;
+    part->cellbeg = (long)crows * p / partials * ccols;
+    part->cellend = (long)crows * (p + 1) / partials * ccols;
+    qs->partials[p] = part;
+  }
+  qs->partialcount = partials;
+  qs->extractor = 0;
+  qs->extracting = true;
+  enqueue_to_workers(sengine, qs);
+  extractworker(qs);
+  block_on_workers(sengine, qs);
+  qs->extracting = false;
+  for(int p = 0 ; p < partials ; ++p){
+    const qstate* part = qs->partials[p];
+    if(part->failed){
+      return -1;
+    }
+    if(merge_partial(qs, part)){
+      return -1;
+    }
+    if(part->smap->p2 == SIXEL_P2_TRANS){
+      qs->smap->p2 = SIXEL_P2_TRANS;
+    }
+  }
+  return 0;
+}
+
 // we have a 4096-element array that takes the 4-5-3 MSBs from the RGB
 // components. once it's complete, we might need to either merge some
 // chunks, or expand them, converging towards the available number of
 // color registers. |ccols| is cell geometry; |leny| and |lenx| are pixel
-// geometry, and *do not* include sixel padding.
+// geometry, and *do not* include sixel padding. large images are extracted
+// in parallel (see extract_partials()).
 static int
 extract_color_table(sixel_engine* sengine, qstate* qs){
   const blitterargs* bargs = qs->bargs;
@@ -1181,16 +1663,34 @@ extract_color_table(sixel_engine* sengine, qstate* qs){
     return -1;
   }
   bargs->u.pixel.spx->needs_refresh = rmatrix;
-  long cellid = 0;
-  for(int y = 0 ; y < crows ; ++y){ // cell row
-    for(int x = 0 ; x < ccols ; ++x){ // cell column
-      if(extract_cell_color_table(qs, cellid)){
-        return -1;
+  const unsigned pixels = (unsigned)qs->leny * qs->lenx;
+  int partials = 1;
+  if(pixels >= SIXEL_PARALLEL_PIXELS){
+    partials = pixels / SIXEL_PARTIAL_PIXELS;
+    if(partials > SIXEL_MAXPARTIALS){
+      partials = SIXEL_MAXPARTIALS;
+    }
+    if(partials > crows){
+      partials = crows;
+    }
+  }
+  if(partials > 1){
+    if(extract_partials(sengine, qs, crows, ccols, partials)){
+      return -1;
+    }
+  }else{
+    long cellid = 0;
+    for(int y = 0 ; y < crows ; ++y){ // cell row
+      for(int x = 0 ; x < ccols ; ++x){ // cell column
+        if(extract_cell_color_table(qs, cellid)){
+          return -1;
+        }
+        ++cellid;
       }
-      ++cellid;
     }
   }
-  loginfo("octree got %"PRIu32" entries", qs->smap->colors);
+  loginfo("octree got %"PRIu32" entries from %d partial%s", qs->smap->colors,
+          partials, partials == 1 ? "" : "s");
   if(merge_color_table(qs)){
     return -1;
   }
@@ -1295,44 +1795,122 @@ write_sixel_header(qstate* qs, fbuf* f, int leny){
   return r;
 }
 
+// a band is its color vectors, each preceded by its color introducer "#N",
+// separated by '$', and terminated by '-'. we know the length of each vector,
+// so the band is reserved in one go (allowing the most digits a register can
+// have), and then copied in directly.
+#define SIXEL_INTRODUCER_MAX 6 // '#' plus the digits of TRANS_PALETTE_ENTRY
+
 static int
-write_sixel_payload(fbuf* f, const sixelmap* map){
-  for(int j = 0 ; j < map->sixelbands ; ++j){
-    int needclosure = 0;
-    const sixelband* band = &map->bands[j];
-    for(int i = 0 ; i < band->size ; ++i){
-      if(band->vecs[i]){
-        if(needclosure){
-          if(fbuf_putc(f, '$') != 1){ // end previous one
-            return -1;
-          }
-        }else{
-          needclosure = 1;
-        }
-        if(fbuf_putc(f, '#') != 1){
-          return -1;
-        }
-        if(fbuf_putint(f, i) < 0){
-          return -1;
-        }
-        if(fbuf_puts(f, band->vecs[i]) < 0){
-          return -1;
-        }
+write_sixel_band(fbuf* f, sixelband* band){
+  size_t len = 1; // terminating '-'
+  for(int i = 0 ; i < band->size ; ++i){
+    if(band->vecs[i]){
+      len += SIXEL_INTRODUCER_MAX + band->lens[i] + 1; // plus '$'
+    }
+  }
+  if(fbuf_grow(f, len)){
+    return -1;
+  }
+  char* dst = f->buf + f->used;
+  for(int i = 0 ; i < band->size ; ++i){
+    if(band->vecs[i]){
+      if(dst != f->buf + f->used){
+        *dst++ = '$'; // end previous one
       }
+      *dst++ = '#';
+      dst += fbuf_digits(dst, i);
+      memcpy(dst, band->vecs[i], band->lens[i]);
+      dst += band->lens[i];
+    }
+  }
+  *dst++ = '-';
+  f->used = dst - f->buf;
+  band->dirty = false;
+  return 0;
+}
+
+// write the payload following the header in |f|, which ends at |base|,
+// recording where each band begins (if we can get room to do so).
+static int
+write_sixel_payload(fbuf* f, size_t base, sixelmap* map){
+  if(map->bandoffs == NULL){
+    map->bandoffs = malloc(sizeof(*map->bandoffs) * (map->sixelbands + 1));
+  }
+  for(int j = 0 ; j < map->sixelbands ; ++j){
+    if(map->bandoffs){
+      map->bandoffs[j] = f->used - base;
     }
-    if(fbuf_putc(f, '-') != 1){
+    if(write_sixel_band(f, &map->bands[j])){
       return -1;
     }
   }
+  if(map->bandoffs){
+    map->bandoffs[map->sixelbands] = f->used - base;
+  }
   if(fbuf_puts(f, "\e\\") < 0){
     return -1;
   }
   return 0;
 }
 
+// rewrite the payload of |s| into a fresh buffer, copying clean runs of bands
+// from the current payload and encoding only the dirty bands. the band
+// offsets are rewritten in place: each old offset is read before its band is
+// reached, and rewritten only afterwards.
+static int
+sixel_splice_bands(sprixel* s){
+  sixelmap* smap = s->smap;
+  size_t* offs = smap->bandoffs;
+  const size_t base = s->parse_start;
+  fbuf f;
+  if(fbufpool_get(s->fpool, &f, s->glyph.used)){
+    return -1;
+  }
+  const char* payload = s->glyph.buf + base;
+  int ret = fbuf_putn(&f, s->glyph.buf, base);
+  int j = 0;
+  while(ret >= 0 && j < smap->sixelbands){
+    if(smap->bands[j].dirty){
+      offs[j] = f.used - base;
+      ret = write_sixel_band(&f, &smap->bands[j]);
+      ++j;
+      continue;
+    }
+    int k = j;
+    while(k < smap->sixelbands && !smap->bands[k].dirty){
+      ++k;
+    }
+    const size_t oldstart = offs[j];
+    const size_t newstart = f.used - base;
+    if((ret = fbuf_putn(&f, payload + oldstart, offs[k] - oldstart)) >= 0){
+      for(int i = j ; i < k ; ++i){
+        offs[i] = offs[i] - oldstart + newstart;
+      }
+    }
+    j = k;
+  }
+  if(ret >= 0){
+    offs[smap->sixelbands] = f.used - base;
+    ret = fbuf_puts(&f, "\e\\");
+  }
+  if(ret < 0){
+    // our offsets are now a mix of old and new; write out in full next time
+    free(smap->bandoffs);
+    smap->bandoffs = NULL;
+    fbufpool_put(s->fpool, &f);
+    return -1;
+  }
+  fbufpool_put(s->fpool, &s->glyph);
+  s->glyph = f;
+  return 0;
+}
+
 // once per render cycle (if needed), make the actual payload match the TAM. we
 // don't do these one at a time due to the complex (expensive) process involved
-// in regenerating a sixel (we can't easily do it in-place). anything newly
+// in regenerating a sixel (we can't easily do it in-place). once the payload
+// has been written in full, only bands touched by wipes and restores are
+// encoded anew; the rest are copied from the existing payload. anything newly
 // ANNIHILATED (state is ANNIHILATED, but no auxvec present) is dropped from
 // the payload, and an auxvec is generated. anything newly restored (state is
 // OPAQUE_SIXEL or MIXED_SIXEL, but an auxvec is present) is restored to the
@@ -1340,8 +1918,16 @@ write_sixel_payload(fbuf* f, const sixelmap* map){
 // is redrawn, and annihilated sprixcells still require a glyph to be emitted.
 static inline int
 sixel_reblit(sprixel* s){
+  if(s->smap->bandoffs && s->glyph.used > (size_t)s->parse_start){
+    if(sixel_splice_bands(s) == 0){
+      change_p2(s->glyph.buf, s->smap->p2);
+      return 0;
+    }
+  }
   fbuf_chop(&s->glyph, s->parse_start);
-  if(write_sixel_payload(&s->glyph, s->smap) < 0){
+  if(write_sixel_payload(&s->glyph, s->parse_start, s->smap) < 0){
+    free(s->smap->bandoffs);
+    s->smap->bandoffs = NULL;
     return -1;
   }
   change_p2(s->glyph.buf, s->smap->p2);
@@ -1351,11 +1937,11 @@ sixel_reblit(sprixel* s){
 // write out the sixel header after having quantized the palette.
 static inline int
 sixel_blit_inner(qstate* qs, sixelmap* smap, const blitterargs* bargs, tament* tam){
+  sprixel* s = bargs->u.pixel.spx;
   fbuf f;
-  if(fbuf_init(&f)){
+  if(fbufpool_get(s->fpool, &f, 0)){
     return -1;
   }
-  sprixel* s = bargs->u.pixel.spx;
   const int cellpxy = bargs->u.pixel.cellpxy;
   const int cellpxx = bargs->u.pixel.cellpxx;
   int outy = qs->leny;
@@ -1365,7 +1951,7 @@ sixel_blit_inner(qstate* qs, sixelmap* smap, const blitterargs* bargs, tament* t
   }
   int parse_start = write_sixel_header(qs, &f, outy);
   if(parse_start < 0){
-    fbuf_free(&f);
+    fbufpool_put(s->fpool, &f);
     return -1;
   }
   // we don't write out the payload yet -- set wipes_outstanding high, and
@@ -1375,29 +1961,584 @@ sixel_blit_inner(qstate* qs, sixelmap* smap, const blitterargs* bargs, tament* t
   scrub_tam_boundaries(tam, outy, qs->lenx, cellpxy, cellpxx);
   // take ownership of buf on success
   if(plane_blit_sixel(s, &f, outy, qs->lenx, parse_start, tam, SPRIXEL_INVALIDATED) < 0){
-    fbuf_free(&f);
+    fbufpool_put(s->fpool, &f);
+    return -1;
+  }
+  s->smap = smap;
+  return 1;
+}
+
+// applications tend to blit the same icons and thumbnails over and over.
+// quantization and encoding dominate a sixel blit, and depend only on the
+// source pixels and the output geometry, so we keep the finished product of
+// recent blits: the header (including the palette), a copy of the sixelmap,
+// and the resulting TAM states. entries are keyed on a hash of the pixels
+// actually consumed, alongside the parameters which affect encoding. the
+// TAM and refresh matrix depend on any preexisting wipes, so blits atop
+// annihilated sprixcells neither consult nor populate the cache.
+typedef struct sixelcache {
+  struct sixelcache* prev;
+  struct sixelcache* next;
+  uint64_t hash;
+  int leny, lenx;           // scaled output geometry, as passed to sixel_blit()
+  int cellpxy, cellpxx;
+  int colorregs;
+  uint32_t transcolor;
+  bool quantfast;           // NCVISUAL_OPTION_QUANTFAST was provided
+  unsigned dimy, dimx;      // sprixel cell geometry
+  int outy;                 // leny padded to a multiple of six
+  char* header;             // |parse_start| bytes of header and palette
+  int parse_start;
+  sixelmap* smap;
+  unsigned char* states;    // |dimy| x |dimx| sprixcell_e values
+  size_t bytes;             // approximate footprint, charged to the engine
+} sixelcache;
+
+// the region consumed by the blitter begins at begy/begx, so that's what
+// we hash. the geometry is checked exactly on lookup.
+static uint64_t
+sixel_cache_hash(const uint32_t* data, int linesize, int begy, int begx,
+                 int leny, int lenx){
+  uint64_t h = 0xcbf29ce484222325ull; // FNV-1a offset basis
+  for(int y = begy ; y < begy + leny ; ++y){
+    const uint32_t* row = data + (linesize / 4) * y + begx;
+    for(int x = 0 ; x < lenx ; ++x){
+      h ^= row[x];
+      h *= 0x100000001b3ull;
+    }
+  }
+  return h;
+}
+
+static void
+sixelcache_free(sixelcache* sc){
+  if(sc){
+    sixelmap_free(sc->smap);
+    free(sc->header);
+    free(sc->states);
+    free(sc);
+  }
+}
+
+// deep copy of |smap|, approximating its footprint in |bytes|
+static sixelmap*
+sixelmap_dup(const sixelmap* smap, size_t* bytes){
+  sixelmap* ret = malloc(sizeof(*ret));
+  if(ret == NULL){
+    return NULL;
+  }
+  memcpy(ret, smap, sizeof(*smap));
+  ret->bandoffs = NULL; // they describe the payload written from |smap|
+  ret->frame = NULL;    // only the sprixel's own map streams
+  ret->framerows = ret->framecols = 0;
+  ret->framealloc = 0;
+  ret->palette = NULL;
+  ret->palalloc = 0;
+  ret->veclen = 0;      // our vectors are only as long as their contents
+  memset(&ret->delta, 0, sizeof(ret->delta));
+  *bytes = sizeof(*ret) + sizeof(*ret->bands) * smap->sixelbands;
+  if((ret->bands = malloc(sizeof(*ret->bands) * smap->sixelbands)) == NULL){
+    free(ret);
+    return NULL;
+  }
+  for(int i = 0 ; i < smap->sixelbands ; ++i){
+    ret->bands[i].size = 0;
+    ret->bands[i].vecs = NULL;
+    ret->bands[i].lens = NULL;
+    ret->bands[i].dirty = false;
+  }
+  for(int i = 0 ; i < smap->sixelbands ; ++i){
+    const sixelband* src = &smap->bands[i];
+    sixelband* dst = &ret->bands[i];
+    if(src->size == 0){
+      continue;
+    }
+    dst->vecs = malloc(sizeof(*dst->vecs) * src->size);
+    dst->lens = malloc(sizeof(*dst->lens) * src->size);
+    if(dst->vecs == NULL || dst->lens == NULL){
+      free(dst->vecs);
+      dst->vecs = NULL;
+      sixelmap_free(ret);
+      return NULL;
+    }
+    dst->size = src->size;
+    memcpy(dst->lens, src->lens, sizeof(*dst->lens) * src->size);
+    *bytes += (sizeof(*dst->vecs) + sizeof(*dst->lens)) * src->size;
+    for(int j = 0 ; j < src->size ; ++j){
+      if(src->vecs[j] == NULL){
+        dst->vecs[j] = NULL;
+      }else if((dst->vecs[j] = malloc(src->lens[j] + 1)) == NULL){
+        while(j < dst->size){ // sixelband_free() wants these initialized
+          dst->vecs[j++] = NULL;
+        }
+        sixelmap_free(ret);
+        return NULL;
+      }else{
+        memcpy(dst->vecs[j], src->vecs[j], src->lens[j] + 1);
+        *bytes += src->lens[j] + 1;
+      }
+    }
+  }
+  return ret;
+}
+
+// blits atop wiped sprixcells are not cacheable; see above.
+static bool
+sixel_cacheable_p(const sixel_engine* eng, const sprixel* s, const tament* tam){
+  if(eng == NULL || eng->cachemax == 0){
+    return false;
+  }
+  for(unsigned i = 0 ; i < s->dimy * s->dimx ; ++i){
+    if(tam[i].state == SPRIXCELL_ANNIHILATED || tam[i].state == SPRIXCELL_ANNIHILATED_TRANS){
+      return false;
+    }
+  }
+  return true;
+}
+
+static inline bool
+sixelcache_match_p(const sixelcache* sc, uint64_t hash, const blitterargs* bargs,
+                   int leny, int lenx){
+  const sprixel* s = bargs->u.pixel.spx;
+  return sc->hash == hash && sc->leny == leny && sc->lenx == lenx &&
+         sc->cellpxy == bargs->u.pixel.cellpxy &&
+         sc->cellpxx == bargs->u.pixel.cellpxx &&
+         sc->colorregs == bargs->u.pixel.colorregs &&
+         sc->transcolor == bargs->transcolor &&
+         sc->quantfast == !!(bargs->flags & NCVISUAL_OPTION_QUANTFAST) &&
+         sc->dimy == s->dimy && sc->dimx == s->dimx;
+}
+
+// unlink |sc| from the LRU list. call with cachelock held.
+static void
+sixelcache_unlink(sixel_engine* eng, sixelcache* sc){
+  if(sc->prev){
+    sc->prev->next = sc->next;
+  }else{
+    eng->cache = sc->next;
+  }
+  if(sc->next){
+    sc->next->prev = sc->prev;
+  }
+  sc->prev = sc->next = NULL;
+}
+
+// push |sc| to the front of the LRU list. call with cachelock held.
+static void
+sixelcache_push(sixel_engine* eng, sixelcache* sc){
+  sc->prev = NULL;
+  sc->next = eng->cache;
+  if(eng->cache){
+    eng->cache->prev = sc;
+  }
+  eng->cache = sc;
+}
+
+// try to satisfy the blit from the cache. returns 1 on a hit (the sprixel
+// has been loaded just as sixel_blit_inner() would have loaded it), 0 on a
+// miss, and -1 on error.
+static int
+sixel_cache_blit(sixel_engine* eng, uint64_t hash, const blitterargs* bargs,
+                 int leny, int lenx, tament* tam){
+  sprixel* s = bargs->u.pixel.spx;
+  const unsigned cells = s->dimy * s->dimx;
+  pthread_mutex_lock(&eng->cachelock);
+  sixelcache* sc;
+  for(sc = eng->cache ; sc ; sc = sc->next){
+    if(sixelcache_match_p(sc, hash, bargs, leny, lenx)){
+      break;
+    }
+  }
+  if(sc == NULL){
+    ++eng->cachemisses;
+    pthread_mutex_unlock(&eng->cachelock);
+    return 0;
+  }
+  ++eng->cachehits;
+  sixelcache_unlink(eng, sc);
+  sixelcache_push(eng, sc);
+  size_t scratch;
+  sixelmap* smap = sixelmap_dup(sc->smap, &scratch);
+  fbuf f;
+  if(smap == NULL || fbufpool_get(s->fpool, &f, 0)){
+    pthread_mutex_unlock(&eng->cachelock);
+    sixelmap_free(smap);
+    return -1;
+  }
+  if(fbuf_putn(&f, sc->header, sc->parse_start) < 0){
+    pthread_mutex_unlock(&eng->cachelock);
+    fbufpool_put(s->fpool, &f);
+    sixelmap_free(smap);
+    return -1;
+  }
+  uint8_t* rmatrix = malloc(sizeof(*rmatrix) * cells);
+  if(rmatrix == NULL){
+    pthread_mutex_unlock(&eng->cachelock);
+    fbufpool_put(s->fpool, &f);
+    sixelmap_free(smap);
+    return -1;
+  }
+  // as in extract_cell_color_table(), the refresh matrix reflects the
+  // state being replaced, and is cleared for newly opaque sprixcells.
+  for(unsigned i = 0 ; i < cells ; ++i){
+    update_rmatrix(rmatrix, i, tam);
+    tam[i].state = sc->states[i];
+    if(tam[i].state == SPRIXCELL_OPAQUE_SIXEL){
+      rmatrix[i] = 0;
+    }
+  }
+  const int outy = sc->outy;
+  const int parse_start = sc->parse_start;
+  pthread_mutex_unlock(&eng->cachelock);
+  s->needs_refresh = rmatrix;
+  if(plane_blit_sixel(s, &f, outy, lenx, parse_start, tam, SPRIXEL_INVALIDATED) < 0){
+    fbufpool_put(s->fpool, &f);
+    sixelmap_free(smap);
     return -1;
   }
   s->smap = smap;
   return 1;
 }
 
+// record the freshly-encoded sprixel |s|, evicting the least recently used
+// entries as necessary to stay under the ceiling. failure is not an error;
+// we simply don't cache.
+static void
+sixel_cache_store(sixel_engine* eng, uint64_t hash, const blitterargs* bargs,
+                  int leny, int lenx, const sprixel* s, const tament* tam){
+  const unsigned cells = s->dimy * s->dimx;
+  sixelcache* sc = malloc(sizeof(*sc));
+  if(sc == NULL){
+    return;
+  }
+  memset(sc, 0, sizeof(*sc));
+  sc->hash = hash;
+  sc->leny = leny;
+  sc->lenx = lenx;
+  sc->cellpxy = bargs->u.pixel.cellpxy;
+  sc->cellpxx = bargs->u.pixel.cellpxx;
+  sc->colorregs = bargs->u.pixel.colorregs;
+  sc->transcolor = bargs->transcolor;
+  sc->quantfast = bargs->flags & NCVISUAL_OPTION_QUANTFAST;
+  sc->dimy = s->dimy;
+  sc->dimx = s->dimx;
+  sc->outy = s->pixy;
+  sc->parse_start = s->parse_start;
+  size_t smapbytes;
+  if((sc->smap = sixelmap_dup(s->smap, &smapbytes)) == NULL){
+    sixelcache_free(sc);
+    return;
+  }
+  if((sc->header = malloc(sc->parse_start)) == NULL){
+    sixelcache_free(sc);
+    return;
+  }
+  memcpy(sc->header, s->glyph.buf, sc->parse_start);
+  if((sc->states = malloc(cells)) == NULL){
+    sixelcache_free(sc);
+    return;
+  }
+  for(unsigned i = 0 ; i < cells ; ++i){
+    sc->states[i] = tam[i].state;
+  }
+  sc->bytes = sizeof(*sc) + smapbytes + sc->parse_start + cells;
+  if(sc->bytes > eng->cachemax){
+    sixelcache_free(sc);
+    return;
+  }
+  pthread_mutex_lock(&eng->cachelock);
+  while(eng->cachebytes + sc->bytes > eng->cachemax){
+    sixelcache* lru = eng->cache;
+    while(lru->next){
+      lru = lru->next;
+    }
+    sixelcache_unlink(eng, lru);
+    eng->cachebytes -= lru->bytes;
+    sixelcache_free(lru);
+  }
+  sixelcache_push(eng, sc);
+  eng->cachebytes += sc->bytes;
+  pthread_mutex_unlock(&eng->cachelock);
+}
+
+// a sprixel which is blitted repeatedly is presumably showing video, whose
+// successive frames tend to differ only in places. keep the pixels consumed
+// by this blit, and the components of the color registers they were reduced
+// to, so that the next frame can be encoded against them. failure is not an
+// error; the next frame will simply be blitted anew.
+static void
+sixel_keep_frame(qstate* qs, sixelmap* smap){
+  const int rows = qs->leny - qs->bargs->begy;
+  const int cols = qs->lenx;
+  const int padded = (smap->colors + PALETTE_LANES - 1) / PALETTE_LANES * PALETTE_LANES;
+  // a recycled sixelmap retains its buffers, which are reused if large enough
+  if(smap->framealloc < (size_t)rows * cols){
+    free(smap->frame);
+    smap->framealloc = (size_t)rows * cols;
+    smap->frame = malloc(sizeof(*smap->frame) * smap->framealloc);
+  }
+  if(smap->palalloc < padded){
+    free(smap->palette);
+    smap->palalloc = padded;
+    smap->palette = malloc(sizeof(*smap->palette) * smap->palalloc * 3);
+  }
+  if(smap->frame == NULL || smap->palette == NULL){
+    free(smap->frame);
+    free(smap->palette);
+    smap->frame = NULL;
+    smap->palette = NULL;
+    smap->framealloc = 0;
+    smap->palalloc = 0;
+    return;
+  }
+  for(int y = 0 ; y < rows ; ++y){
+    memcpy(smap->frame + y * cols,
+           qs->data + (qs->linesize / 4) * (qs->bargs->begy + y) + qs->bargs->begx,
+           sizeof(*smap->frame) * cols);
+  }
+  smap->framerows = rows;
+  smap->framecols = cols;
+  smap->transcolor = qs->bargs->transcolor;
+  smap->palpadded = padded;
+  int32_t* pr = smap->palette;
+  int32_t* pg = pr + padded;
+  int32_t* pb = pg + padded;
+  for(int c = smap->colors ; c < padded ; ++c){
+    pr[c] = pg[c] = pb[c] = PALETTE_PAD;
+  }
+  const int total = QNODECOUNT + (qs->dynnodes_total - qs->dynnodes_free);
+  for(int z = 0 ; z < total ; ++z){
+    const qnode* q = &qs->qnodes[z];
+    if(chosen_p(q)){
+      pr[qidx(q)] = q->q.comps[0];
+      pg[qidx(q)] = q->q.comps[1];
+      pb[qidx(q)] = q->q.comps[2];
+    }
+  }
+}
+
+// the changed bands of the sixel, atop the frame they replace. transparent
+// pixels leave what's already there, and unchanged bands are skipped with
+// graphics newlines. |changed| has an entry for each band.
+static int
+sixel_write_delta(sprixel* s, const bool* changed){
+  sixelmap* smap = s->smap;
+  fbuf* f = &smap->delta;
+  if(f->buf == NULL){
+    if(fbuf_init(f)){
+      return -1;
+    }
+  }
+  fbuf_reset(f);
+  const char* payload = s->glyph.buf + s->parse_start;
+  int ret = fbuf_putn(f, s->glyph.buf, s->parse_start);
+  for(int j = 0 ; ret >= 0 && j < smap->sixelbands ; ++j){
+    if(changed[j]){
+      ret = fbuf_putn(f, payload + smap->bandoffs[j],
+                      smap->bandoffs[j + 1] - smap->bandoffs[j]);
+    }else{
+      ret = fbuf_putc(f, '-');
+    }
+  }
+  if(ret < 0 || fbuf_puts(f, "\e\\") < 0){
+    fbuf_reset(f);
+    return -1;
+  }
+  change_p2(f->buf, SIXEL_P2_TRANS);
+  return 0;
+}
+
+// every STREAM_SAMPLE_STRIDEth pixel of the changed bands is checked against
+// the existing color registers. should the mean squared distance exceed
+// STREAM_MAX_DISTANCE (about a tenth of the range in each component), the
+// palette no longer fits, and the frame is quantized anew.
+#define STREAM_SAMPLE_STRIDE 13
+#define STREAM_MAX_DISTANCE (3 * 24 * 24)
+
+// a frame blitted atop a frame kept by sixel_keep_frame() can skip
+// quantization, so long as both are entirely opaque and of the same
+// geometry. bands which match the kept frame are left alone; the others are
+// encoded anew using the existing color registers, and spliced into the
+// payload. if the previous frame is what's on the screen, only the changed
+// bands need be drawn. an unchanged frame isn't drawn at all. returns 1 if
+// the frame was handled, 0 if it ought be blitted anew, and -1 on error. on
+// success, |smap| is once more the sprixel's sixelmap.
+static int
+sixel_stream_blit(sixel_engine* sengine, sixelmap* smap, int linesize,
+                  const uint32_t* data, int leny, int lenx,
+                  const blitterargs* bargs, const tament* tam){
+  sprixel* s = bargs->u.pixel.spx;
+  const int rows = leny - bargs->begy;
+  // an outstanding wipe means our payload is stale, and that our TAM
+  // doesn't describe the screen.
+  if(smap->frame == NULL || smap->bandoffs == NULL || s->wipes_outstanding){
+    return 0;
+  }
+  if(smap->p2 != SIXEL_P2_ALLOPAQUE || smap->framerows != rows ||
+     smap->framecols != lenx || smap->transcolor != bargs->transcolor ||
+     (int)s->pixy != leny || (int)s->pixx != lenx){
+    return 0;
+  }
+  for(unsigned i = 0 ; i < s->dimy * s->dimx ; ++i){
+    if(tam[i].state != SPRIXCELL_OPAQUE_SIXEL){
+      return 0;
+    }
+  }
+  const arenamark mark = arena_mark();
+  bool* changed = arena_alloc(sizeof(*changed) * smap->sixelbands);
+  if(changed == NULL){
+    arena_release(mark);
+    return -1;
+  }
+  int changes = 0;
+  int64_t dist = 0;
+  int64_t samples = 0;
+  for(int b = 0 ; b < smap->sixelbands ; ++b){
+    const int ystart = b * 6;
+    const int yend = ystart + 6 < rows ? ystart + 6 : rows;
+    changed[b] = false;
+    for(int y = ystart ; y < yend ; ++y){
+      const uint32_t* src = data + (linesize / 4) * (bargs->begy + y) + bargs->begx;
+      if(memcmp(src, smap->frame + y * lenx, sizeof(*src) * lenx)){
+        changed[b] = true;
+        break;
+      }
+    }
+    if(!changed[b]){
+      continue;
+    }
+    ++changes;
+    for(int y = ystart ; y < yend ; ++y){
+      const uint32_t* src = data + (linesize / 4) * (bargs->begy + y) + bargs->begx;
+      for(int x = 0 ; x < lenx ; ++x){
+        if(rgba_trans_p(src[x], bargs->transcolor)){
+          arena_release(mark);
+          return 0;
+        }
+        if((y * lenx + x) % STREAM_SAMPLE_STRIDE == 0){
+          int32_t d;
+          reused_color(smap, src[x], &d);
+          dist += d;
+          ++samples;
+        }
+      }
+    }
+  }
+  if(samples && dist / samples > STREAM_MAX_DISTANCE){
+    loginfo("palette is stale (%"PRId64"), requantizing", dist / samples);
+    arena_release(mark);
+    return 0;
+  }
+  s->smap = smap;
+  if(changes == 0){
+    arena_release(mark);
+    return 1;
+  }
+  // changed bands are rebuilt in place, reusing their vectors if possible
+  for(int b = 0 ; b < smap->sixelbands ; ++b){
+    if(changed[b]){
+      if(smap->veclen != lenx + 1){
+        sixelband_free(&smap->bands[b]);
+        smap->bands[b].size = 0;
+        smap->bands[b].vecs = NULL;
+        smap->bands[b].lens = NULL;
+      }
+      smap->bands[b].dirty = true;
+    }
+  }
+  qstate qs;
+  memset(&qs, 0, sizeof(qs));
+  qs.bargs = bargs;
+  qs.data = data;
+  qs.linesize = linesize;
+  qs.smap = smap;
+  qs.leny = leny;
+  qs.lenx = lenx;
+  qs.reuse = true;
+  qs.bandbuilder = 0;
+  enqueue_to_workers(sengine, &qs);
+  int r = bandworker(&qs);
+  block_on_workers(sengine, &qs);
+  if(r == 0){
+    r = sixel_reblit(s);
+  }
+  if(r){
+    s->smap = NULL;
+    arena_release(mark);
+    return -1;
+  }
+  for(int y = 0 ; y < rows ; ++y){
+    if(changed[y / 6]){
+      memcpy(smap->frame + y * lenx,
+             data + (linesize / 4) * (bargs->begy + y) + bargs->begx,
+             sizeof(*smap->frame) * lenx);
+    }
+  }
+  // a delta is only good atop the frame it was computed against, which must
+  // have been drawn at our current location.
+  fbuf_reset(&smap->delta);
+  if(s->invalidated == SPRIXEL_QUIESCENT){
+    if(smap->bandoffs){
+      sixel_write_delta(s, changed);
+    }
+    s->invalidated = SPRIXEL_INVALIDATED;
+  }
+  arena_release(mark);
+  loginfo("streamed %d/%d bands", changes, smap->sixelbands);
+  return 1;
+}
+
 // |leny| and |lenx| are the scaled output geometry. we take |leny| up to the
 // nearest multiple of six greater than or equal to |leny|.
-int sixel_blit(ncplane* n, int linesize, const void* data, int leny, int lenx,
-               const blitterargs* bargs){
+static int
+sixel_blit_encode(ncplane* n, int linesize, const void* data, int leny, int lenx,
+                  const blitterargs* bargs){
   if(bargs->u.pixel.colorregs >= TRANS_PALETTE_ENTRY){
     logerror("palette too large %d", bargs->u.pixel.colorregs);
     return -1;
   }
-  sixelmap* smap = sixelmap_create(leny - bargs->begy);
+  assert(n->tam);
+  sixel_engine* sengine = ncplane_pile(n) ? ncplane_notcurses(n)->tcache.sixelengine : NULL;
+  // a recycled sprixel retains its sixelmap, which might allow us to
+  // encode this frame against the last one.
+  sixelmap* prev = bargs->u.pixel.spx->smap;
+  const bool recycled = prev;
+  bargs->u.pixel.spx->smap = NULL;
+  sixelmap* smap;
+  if(prev){
+    int r = sixel_stream_blit(sengine, prev, linesize, data, leny, lenx, bargs, n->tam);
+    if(r){
+      if(r < 0){
+        sixelmap_free(prev);
+      }
+      return r;
+    }
+    // rather than freeing the old sixelmap, reset and reuse it
+    smap = sixelmap_recycle(prev, leny - bargs->begy, lenx);
+  }else{
+    smap = sixelmap_create(leny - bargs->begy, lenx);
+  }
   if(smap == NULL){
     return -1;
   }
-  assert(n->tam);
+  const bool cacheable = sixel_cacheable_p(sengine, bargs->u.pixel.spx, n->tam);
+  uint64_t hash = 0;
+  if(cacheable){
+    hash = sixel_cache_hash(data, linesize, bargs->begy, bargs->begx, leny, lenx);
+    int r = sixel_cache_blit(sengine, hash, bargs, leny, lenx, n->tam);
+    if(r){
+      sixelmap_free(smap);
+      if(r > 0){
+        bargs->u.pixel.spx->wipes_outstanding = 1;
+      }
+      return r;
+    }
+  }
+  const arenamark mark = arena_mark();
   qstate* qs;
   if((qs = alloc_qstate(bargs->u.pixel.colorregs)) == NULL){
     logerror("couldn't allocate qstate");
+    arena_release(mark);
     sixelmap_free(smap);
     return -1;
   }
@@ -1407,21 +2548,30 @@ int sixel_blit(ncplane* n, int linesize, const void* data, int leny, int lenx,
   qs->smap = smap;
   qs->leny = leny;
   qs->lenx = lenx;
-  sixel_engine* sengine = ncplane_pile(n) ? ncplane_notcurses(n)->tcache.sixelengine : NULL;
+  if(sengine && (unsigned)leny * lenx >= SIXEL_SAMPLE_PIXELS){
+    qs->samplemod = sengine->samplemod;
+  }
   if(extract_color_table(sengine, qs)){
     free(bargs->u.pixel.spx->needs_refresh);
     bargs->u.pixel.spx->needs_refresh = NULL;
     sixelmap_free(smap);
-    free_qstate(qs);
+    arena_release(mark);
     return -1;
   }
   // takes ownership of sixelmap on success
   int r = sixel_blit_inner(qs, smap, bargs, n->tam);
-  free_qstate(qs);
   if(r < 0){
     sixelmap_free(smap);
     // FIXME free refresh table?
+  }else{
+    if(cacheable){
+      sixel_cache_store(sengine, hash, bargs, leny, lenx, bargs->u.pixel.spx, n->tam);
+    }
+    if(recycled && smap->p2 == SIXEL_P2_ALLOPAQUE){
+      sixel_keep_frame(qs, smap);
+    }
   }
+  arena_release(mark);
   scrub_color_table(bargs->u.pixel.spx);
   // we haven't actually emitted the body of the sixel yet. instead, we'll emit
   // it at sixel_redraw(), thus avoiding a double emission in the case of wipes
@@ -1430,6 +2580,14 @@ int sixel_blit(ncplane* n, int linesize, const void* data, int leny, int lenx,
   return r;
 }
 
+int sixel_blit(ncplane* n, int linesize, const void* data, int leny, int lenx,
+               const blitterargs* bargs){
+  const uint64_t tstart = nctrace_begin();
+  int r = sixel_blit_encode(n, linesize, data, leny, lenx, bargs);
+  nctrace_end("sixel_blit", tstart, "pixels", (int64_t)leny * lenx);
+  return r;
+}
+
 // to destroy a sixel, we damage all cells underneath it. we might not have
 // to, though, if we've got a new sixel ready to go where the old sixel was
 // (though we'll still need to if the new sprixcell not opaque, and the
@@ -1447,7 +2605,10 @@ int sixel_scrub(const ncpile* p, sprixel* s){
         r->s.damaged = 1;
         continue;
       }
-      sprixel* trues = r->sprixel ? r->sprixel : s;
+      sprixel* trues = crender_sprixel(p, r, yy, xx);
+      if(trues == NULL){
+        trues = s;
+      }
       if(yy >= (int)trues->n->leny || yy - trues->n->absy < 0){
         r->s.damaged = 1;
         continue;
@@ -1475,6 +2636,17 @@ int sixel_scrub(const ncpile* p, sprixel* s){
 int sixel_draw(const tinfo* ti, const ncpile* p, sprixel* s, fbuf* f,
                int yoff, int xoff){
   (void)ti;
+  // if the TAM hasn't changed since we were last drawn, it describes what's
+  // on the screen at our old location.
+  const bool tamdisplayed = !s->wipes_outstanding;
+  // a streamed frame atop its predecessor need only draw what changed, so
+  // long as that predecessor is still on the screen (i.e. we haven't since
+  // switched away from its pile and back).
+  const fbuf* out = &s->glyph;
+  if(p && s->smap && s->smap->delta.used && tamdisplayed &&
+     s->invalidated == SPRIXEL_INVALIDATED && p->nc->last_pile == p){
+    out = &s->smap->delta;
+  }
   // if we've wiped or rebuilt any cells, effect those changes now, or else
   // we'll get flicker when we move to the new location.
   if(s->wipes_outstanding){
@@ -1499,80 +2671,169 @@ int sixel_draw(const tinfo* ti, const ncpile* p, sprixel* s, fbuf* f,
             continue;
           }
           struct crender *r = &p->crender[yy * p->dimx + xx];
-          if(!r->sprixel || sprixel_state(r->sprixel, yy, xx) != SPRIXCELL_OPAQUE_SIXEL){
-            r->s.damaged = 1;
+          const sprixel* rs = crender_sprixel(p, r, yy, xx);
+          if(rs && sprixel_state(rs, yy, xx) == SPRIXCELL_OPAQUE_SIXEL){
+            continue; // we're about to draw over it
           }
+          // we drew no pixels into transparent and annihilated cells, so the
+          // glyphs there are already on the screen. only the glyphs we were
+          // covering need be redrawn.
+          if(tamdisplayed){
+            const sprixcell_e was = s->n->tam[(yy - s->movedfromy) * s->dimx + (xx - s->movedfromx)].state;
+            if(was == SPRIXCELL_TRANSPARENT || was == SPRIXCELL_ANNIHILATED ||
+               was == SPRIXCELL_ANNIHILATED_TRANS){
+              continue;
+            }
+          }
+          r->s.damaged = 1;
         }
       }
     }
   }
-  if(fbuf_putn(f, s->glyph.buf, s->glyph.used) < 0){
+  if(p){
+    if(raster_putglyph(p->nc, f, out)){
+      return -1;
+    }
+  }else if(fbuf_putn(f, s->glyph.buf, s->glyph.used) < 0){
     return -1;
   }
+  const int ret = out->used;
+  if(s->smap){
+    fbuf_reset(&s->smap->delta);
+  }
   s->invalidated = SPRIXEL_QUIESCENT;
-  return s->glyph.used;
+  return ret;
+}
+
+// has all of |qs|'s current work (partials or bands) been claimed?
+static inline bool
+qstate_claimed_p(const qstate* qs){
+  if(qs->extracting){
+    return qs->extractor >= qs->partialcount;
+  }
+  return qs->bandbuilder >= qs->smap->sixelbands;
 }
 
-// a quantization worker.
+// a quantization worker. attach to the oldest job with partials or bands
+// remaining, and help with them; jobs whose work has all been claimed are
+// retired.
 static void *
 sixel_worker(void* v){
-  work_queue* wq = v;
-  sixel_engine *sengine = wq->sengine;
-
-  qstate* qs = NULL;
-  unsigned bufpos = 0; // index into worker queue
-  do{
-    pthread_mutex_lock(&sengine->lock);
-    while(wq->used == 0 && !sengine->done){
+  sixel_engine *sengine = v;
+  nc_thread_setup("sixel");
+  pthread_mutex_lock(&sengine->lock);
+  while(!sengine->done){
+    qstate* qs = sengine->jobs;
+    if(qs == NULL){
       pthread_cond_wait(&sengine->cond, &sengine->lock);
+      continue;
     }
-    if(!sengine->done){
-      qs = wq->qstates[bufpos];
-    }else{
-      qs = NULL;
+    if(qstate_claimed_p(qs)){
+      unlink_job(sengine, qs);
+      continue;
     }
+    ++qs->refcount;
     pthread_mutex_unlock(&sengine->lock);
-    if(qs == NULL){
-      break;
+    if(qs->extracting){
+      extractworker(qs);
+    }else{
+      bandworker(qs);
     }
-    bandworker(qs);
-    bool sendsignal = false;
     pthread_mutex_lock(&sengine->lock);
-    --wq->used;
     if(--qs->refcount == 0){
-      sendsignal = true;
-    }
-    pthread_mutex_unlock(&sengine->lock);
-    if(sendsignal){
       pthread_cond_broadcast(&sengine->cond);
     }
-    if(++bufpos == WORKERDEPTH){
-      bufpos = 0;
-    }
-  }while(1);
+  }
+  pthread_mutex_unlock(&sengine->lock);
   return NULL;
 }
 
+// how many threads ought build sixel bands? NOTCURSES_SIXEL_THREADS overrides
+// the number of processors available to us. the result includes the calling
+// thread, so 1 means no workers are spun up.
+static unsigned
+sixel_threads_wanted(void){
+  const char* st = getenv("NOTCURSES_SIXEL_THREADS");
+  if(st){
+    char* endl;
+    unsigned long l = strtoul(st, &endl, 10);
+    if(*st && !*endl && l > 0 && l <= SIXEL_MAXTHREADS){
+      loginfo("got %lu sixel threads from environment", l);
+      return l;
+    }
+    logwarn("ignoring invalid NOTCURSES_SIXEL_THREADS: %s", st);
+  }
+  unsigned cpus = host_cpu_count();
+  if(cpus > SIXEL_MAXTHREADS){
+    cpus = SIXEL_MAXTHREADS;
+  }
+  return cpus;
+}
+
+// NOTCURSES_SIXEL_SAMPLE=N, if set, inserts only every Nth pixel of large
+// images into the octree, trading some palette fidelity for speed.
+static unsigned
+sixel_sample_wanted(void){
+  const char* sm = getenv("NOTCURSES_SIXEL_SAMPLE");
+  if(sm){
+    char* endl;
+    unsigned long l = strtoul(sm, &endl, 10);
+    if(*sm && !*endl && l > 0 && l <= SIXEL_MAXSAMPLE){
+      loginfo("sampling every %lu pixels from environment", l);
+      return l;
+    }
+    logwarn("ignoring invalid NOTCURSES_SIXEL_SAMPLE: %s", sm);
+  }
+  return 1;
+}
+
+// NOTCURSES_SIXEL_CACHE, if set, is the encoding cache's ceiling in bytes.
+// 0 disables the cache.
+static size_t
+sixel_cache_bytes_wanted(void){
+  const char* sc = getenv("NOTCURSES_SIXEL_CACHE");
+  if(sc){
+    char* endl;
+    unsigned long long l = strtoull(sc, &endl, 10);
+    if(*sc && !*endl && l <= SIZE_MAX){
+      loginfo("got %llu byte sixel cache from environment", l);
+      return l;
+    }
+    logwarn("ignoring invalid NOTCURSES_SIXEL_CACHE: %s", sc);
+  }
+  return SIXEL_CACHE_DEFAULT_BYTES;
+}
+
 static int
 sixel_init_core(tinfo* ti, const char* initstr, int fd){
   if((ti->sixelengine = malloc(sizeof(sixel_engine))) == NULL){
     return -1;
   }
   sixel_engine* sengine = ti->sixelengine;
+  memset(sengine, 0, sizeof(*sengine));
+  sengine->cachemax = sixel_cache_bytes_wanted();
+  sengine->samplemod = sixel_sample_wanted();
+  const unsigned workers_wanted = sixel_threads_wanted() - 1;
+  if(workers_wanted){
+    if((sengine->tids = malloc(sizeof(*sengine->tids) * workers_wanted)) == NULL){
+      free(sengine);
+      ti->sixelengine = NULL;
+      return -1;
+    }
+  }
   pthread_mutex_init(&sengine->lock, NULL);
+  pthread_mutex_init(&sengine->cachelock, NULL);
   pthread_cond_init(&sengine->cond, NULL);
-  sengine->done = false;
-  const int workers_wanted = sizeof(sengine->tids) / sizeof(*sengine->tids);
-  for(int w = 0 ; w < workers_wanted ; ++w){
-    sengine->queues[w].sengine = sengine;
-    sengine->queues[w].writeto = 0;
-    sengine->queues[w].used = 0;
-    if(pthread_create(&sengine->tids[w], NULL, sixel_worker, &sengine->queues[w])){
-      logerror("couldn't spin up sixel worker %d/%d", w, workers_wanted);
-      // FIXME kill any created workers
-      return -1;
+  for(unsigned w = 0 ; w < workers_wanted ; ++w){
+    if(pthread_create(&sengine->tids[w], NULL, sixel_worker, sengine)){
+      // we can limp along with whatever workers we got
+      logerror("couldn't spin up sixel worker %u/%u", w, workers_wanted);
+      break;
     }
+    ++sengine->workers;
   }
+  loginfo("spun up %u sixel worker%s", sengine->workers,
+          sengine->workers == 1 ? "" : "s");
   return tty_emit(initstr, fd);
 }
 
@@ -1610,6 +2871,7 @@ restore_vec(sixelband* b, int color, int bit, int xoff, int dimx){
     return -1;
   }
   char* v = NULL;
+  int vlen;
   const char* vec = b->vecs[color]; // might be NULL
   if(vec == NULL){ // write this sixel, and we're done
     struct band_extender bes = {
@@ -1619,10 +2881,12 @@ restore_vec(sixelband* b, int color, int bit, int xoff, int dimx){
     if((v = sixelband_extend(v, &bes, dimx, xoff)) == NULL){
       return -1;
     }
+    vlen = bes.length;
   }else{
     int rle = 0; // the repetition number for this element
     int x = 0;
     int voff = 0;
+    int tail = 0;
     if((v = malloc(dimx + 1)) == NULL){
       return -1;
     }
@@ -1662,13 +2926,16 @@ restore_vec(sixelband* b, int color, int bit, int xoff, int dimx){
       }
       ++vec;
       if(x > xoff){
-        strcpy(v + voff, vec); // there is always room
+        tail = strlen(vec);
+        memcpy(v + voff, vec, tail + 1); // there is always room
         break;
       }
     }
+    vlen = voff + tail;
   }
   free(b->vecs[color]);
   b->vecs[color] = v;
+  b->lens[color] = vlen;
 //fprintf(stderr, "SET NEW VEC (%zu) [%s]\n", strlen(v), v);
   return 0;
 }
@@ -1711,6 +2978,9 @@ restore_band(sixelmap* smap, int band, int startx, int endx,
       }
     }
   }
+  if(restored){
+    b->dirty = true;
+  }
   (void)smap;
   return totalpixels - restored;
 }
@@ -1761,7 +3031,7 @@ int sixel_rebuild(sprixel* s, int ycell, int xcell, uint8_t* auxvec){
 
 void sixel_cleanup(tinfo* ti){
   sixel_engine* sengine = ti->sixelengine;
-  const unsigned tids = POPULATION;
+  const unsigned tids = sengine->workers;
   pthread_mutex_lock(&sengine->lock);
   sengine->done = 1;
   pthread_mutex_unlock(&sengine->lock);
@@ -1772,6 +3042,15 @@ void sixel_cleanup(tinfo* ti){
   }
   pthread_mutex_destroy(&sengine->lock);
   pthread_cond_destroy(&sengine->cond);
+  loginfo("sixel cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIuPTR "B held",
+          sengine->cachehits, sengine->cachemisses, sengine->cachebytes);
+  while(sengine->cache){
+    sixelcache* sc = sengine->cache;
+    sengine->cache = sc->next;
+    sixelcache_free(sc);
+  }
+  pthread_mutex_destroy(&sengine->cachelock);
+  free(sengine->tids);
   free(sengine);
   loginfo("reaped sixel engine");
   ti->sixelengine = NULL;
@@ -1781,9 +3060,10 @@ void sixel_cleanup(tinfo* ti){
 // create an auxiliary vector suitable for a Sixel sprixcell, and zero it out.
 // there are two bytes per pixel in the cell: a palette index of up to 65534,
 // or 65535 to indicate transparency.
-uint8_t* sixel_trans_auxvec(const ncpile* p){
+uint8_t* sixel_trans_auxvec(const sprixel* s){
+  const ncpile* p = ncplane_pile_const(s->n);
   const size_t slen = AUXVECELEMSIZE * p->cellpxy * p->cellpxx;
-  uint8_t* a = malloc(slen);
+  uint8_t* a = auxvec_get(s->apool, slen);
   if(a){
     memset(a, 0xff, slen);
   }
@@ -0,0 +1,127 @@
+#include "internal.h"
+
+void planeindex_free(planeindex* pi){
+  free(pi->offsets);
+  free(pi->planes);
+  pi->offsets = NULL;
+  pi->planes = NULL;
+  pi->offsetslen = pi->planeslen = 0;
+  pi->stale = true;
+}
+
+// the span of grid cells [*g0, *g1] covered by [abs, abs + len), clipped to
+// [0, dim). returns false if nothing remains after clipping.
+static inline bool
+grid_span(int abs, unsigned len, unsigned dim, unsigned* g0, unsigned* g1){
+  int beg = abs < 0 ? 0 : abs;
+  int end = abs + (int)len;
+  if(end > (int)dim){
+    end = dim;
+  }
+  if(beg >= end){
+    return false;
+  }
+  *g0 = beg / PINDEX_CELL;
+  *g1 = (end - 1) / PINDEX_CELL;
+  return true;
+}
+
+// build the index in two passes over the z-axis: count each grid cell's
+// planes, then fill them in. walking from the top leaves each cell's list
+// sorted topmost first.
+static int
+planeindex_build(ncpile* p){
+  planeindex* pi = &p->pindex;
+  const unsigned rows = (p->dimy + PINDEX_CELL - 1) / PINDEX_CELL;
+  const unsigned cols = (p->dimx + PINDEX_CELL - 1) / PINDEX_CELL;
+  const unsigned cells = rows * cols;
+  if(cells + 1 > pi->offsetslen){
+    unsigned* tmp = realloc(pi->offsets, sizeof(*tmp) * (cells + 1));
+    if(tmp == NULL){
+      logerror("couldn't allocate %u-cell plane index", cells);
+      return -1;
+    }
+    pi->offsets = tmp;
+    pi->offsetslen = cells + 1;
+  }
+  memset(pi->offsets, 0, sizeof(*pi->offsets) * (cells + 1));
+  unsigned y0, y1, x0, x1;
+  for(const ncplane* n = p->top ; n ; n = n->below){
+    if(grid_span(n->absy, n->leny, p->dimy, &y0, &y1) &&
+       grid_span(n->absx, n->lenx, p->dimx, &x0, &x1)){
+      for(unsigned gy = y0 ; gy <= y1 ; ++gy){
+        for(unsigned gx = x0 ; gx <= x1 ; ++gx){
+          ++pi->offsets[gy * cols + gx + 1];
+        }
+      }
+    }
+  }
+  for(unsigned c = 0 ; c < cells ; ++c){
+    pi->offsets[c + 1] += pi->offsets[c];
+  }
+  const unsigned total = pi->offsets[cells];
+  if(total > pi->planeslen){
+    ncplane** tmp = realloc(pi->planes, sizeof(*tmp) * total);
+    if(tmp == NULL){
+      logerror("couldn't allocate %u plane index entries", total);
+      return -1;
+    }
+    pi->planes = tmp;
+    pi->planeslen = total;
+  }
+  // each offset serves as its cell's cursor, leaving it at the start of the
+  // next cell; shift them back down afterwards.
+  for(ncplane* n = p->top ; n ; n = n->below){
+    if(grid_span(n->absy, n->leny, p->dimy, &y0, &y1) &&
+       grid_span(n->absx, n->lenx, p->dimx, &x0, &x1)){
+      for(unsigned gy = y0 ; gy <= y1 ; ++gy){
+        for(unsigned gx = x0 ; gx <= x1 ; ++gx){
+          pi->planes[pi->offsets[gy * cols + gx]++] = n;
+        }
+      }
+    }
+  }
+  memmove(pi->offsets + 1, pi->offsets, sizeof(*pi->offsets) * cells);
+  pi->offsets[0] = 0;
+  pi->dimy = p->dimy;
+  pi->dimx = p->dimx;
+  pi->rows = rows;
+  pi->cols = cols;
+  pi->stale = false;
+  return 0;
+}
+
+static inline bool
+plane_contains_p(const ncplane* n, int y, int x){
+  return y >= n->absy && y < n->absy + (int)n->leny &&
+         x >= n->absx && x < n->absx + (int)n->lenx;
+}
+
+ncplane* ncpile_plane_at(ncplane* n, int y, int x){
+  ncpile* p = ncplane_pile(n);
+  planeindex* pi = &p->pindex;
+  if(y >= 0 && x >= 0 && (unsigned)y < p->dimy && (unsigned)x < p->dimx){
+    if(pi->stale || pi->dimy != p->dimy || pi->dimx != p->dimx){
+      if(planeindex_build(p)){
+        pi->stale = true;
+      }
+    }
+    if(!pi->stale){
+      const unsigned c = (y / PINDEX_CELL) * pi->cols + x / PINDEX_CELL;
+      for(unsigned i = pi->offsets[c] ; i < pi->offsets[c + 1] ; ++i){
+        if(plane_contains_p(pi->planes[i], y, x)){
+          return pi->planes[i];
+        }
+      }
+      return NULL;
+    }
+  }
+  // offscreen points aren't indexed (nor is anything, if we couldn't build
+  // the index); walk the z-axis.
+  for(ncplane* cur = p->top ; cur ; cur = cur->below){
+    if(plane_contains_p(cur, y, x)){
+      return cur;
+    }
+  }
+  return NULL;
+}
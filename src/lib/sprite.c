@@ -43,23 +43,131 @@ void sprixel_free(sprixel* s){
     }
     sixelmap_free(s->smap);
     free(s->needs_refresh);
-    fbuf_free(&s->glyph);
+    free(s->frame);
+    free(s->chunkoffs);
+    free(s->fbdamage);
+    fbufpool_put(s->fpool, &s->glyph);
     free(s);
   }
 }
 
-sprixel* sprixel_recycle(ncplane* n){
+// the header preceding each auxvector. it's sixteen bytes, so the auxvector
+// is aligned as malloc() would have it.
+typedef struct auxhdr {
+  auxpool* pool;
+  size_t size;
+} auxhdr;
+
+int auxpool_init(auxpool* pool){
+  memset(pool, 0, sizeof(*pool));
+  if(pthread_mutex_init(&pool->lock, NULL)){
+    return -1;
+  }
+  return 0;
+}
+
+void auxpool_destroy(auxpool* pool){
+  for(unsigned c = 0 ; c < AUXPOOL_CLASSES ; ++c){
+    for(unsigned i = 0 ; i < pool->counts[c] ; ++i){
+      free(pool->vecs[c][i]);
+    }
+    pool->counts[c] = 0;
+  }
+  pthread_mutex_destroy(&pool->lock);
+}
+
+void* auxvec_get(auxpool* pool, size_t size){
+  auxhdr* h = NULL;
+  if(pool){
+    pthread_mutex_lock(&pool->lock);
+    for(unsigned c = 0 ; c < AUXPOOL_CLASSES ; ++c){
+      if(pool->sizes[c] == size && pool->counts[c]){
+        h = pool->vecs[c][--pool->counts[c]];
+        break;
+      }
+    }
+    if(h){
+      ++pool->hits;
+    }else{
+      ++pool->misses;
+    }
+    pthread_mutex_unlock(&pool->lock);
+  }
+  if(h == NULL){
+    if((h = malloc(sizeof(*h) + size)) == NULL){
+      return NULL;
+    }
+    h->pool = pool;
+    h->size = size;
+  }
+  return h + 1;
+}
+
+size_t auxvec_bytes(const void* auxvec){
+  if(auxvec == NULL){
+    return 0;
+  }
+  const auxhdr* h = (const auxhdr*)auxvec - 1;
+  return sizeof(*h) + h->size;
+}
+
+uint64_t auxpool_bytes(auxpool* pool){
+  uint64_t ret = 0;
+  pthread_mutex_lock(&pool->lock);
+    for(unsigned c = 0 ; c < AUXPOOL_CLASSES ; ++c){
+      ret += (sizeof(auxhdr) + pool->sizes[c]) * pool->counts[c];
+    }
+  pthread_mutex_unlock(&pool->lock);
+  return ret;
+}
+
+void auxvec_put(void* auxvec){
+  if(auxvec == NULL){
+    return;
+  }
+  auxhdr* h = (auxhdr*)auxvec - 1;
+  auxpool* pool = h->pool;
+  if(pool){
+    pthread_mutex_lock(&pool->lock);
+    // use the class of this size if there is one. otherwise, take over the
+    // class retaining the fewest auxvectors (e.g. of an old cell-pixel
+    // geometry), first releasing them.
+    unsigned victim = 0;
+    unsigned c;
+    for(c = 0 ; c < AUXPOOL_CLASSES ; ++c){
+      if(pool->sizes[c] == h->size){
+        break;
+      }
+      if(pool->counts[c] < pool->counts[victim]){
+        victim = c;
+      }
+    }
+    if(c == AUXPOOL_CLASSES){
+      c = victim;
+      for(unsigned i = 0 ; i < pool->counts[c] ; ++i){
+        free(pool->vecs[c][i]);
+      }
+      pool->counts[c] = 0;
+      pool->sizes[c] = h->size;
+    }
+    if(pool->counts[c] < AUXPOOL_DEPTH){
+      pool->vecs[c][pool->counts[c]++] = h;
+      h = NULL;
+    }
+    pthread_mutex_unlock(&pool->lock);
+  }
+  free(h);
+}
+
+sprixel* sprixel_recycle(ncplane* n, const blitterargs* bargs, int leny, int lenx){
   assert(n->sprite);
   const notcurses* nc = ncplane_notcurses_const(n);
-  if(nc->tcache.pixel_implementation >= NCPIXEL_KITTY_STATIC){
-    sprixel* hides = n->sprite;
-    int dimy = hides->dimy;
-    int dimx = hides->dimx;
-    sprixel_hide(hides);
-    return sprixel_alloc(n, dimy, dimx);
-  }
-  sixelmap_free(n->sprite->smap);
-  n->sprite->smap = NULL;
+  if((nc->tcache.pixel_implementation >= NCPIXEL_KITTY_STATIC &&
+      nc->tcache.pixel_implementation <= NCPIXEL_KITTY_SELFREF) ||
+     nc->tcache.pixel_implementation == NCPIXEL_KITTY_PLACEHOLDER){
+    return kitty_recycle(n, bargs, leny, lenx);
+  }
+  // the sixelmap is kept, in case the new frame can be encoded against it
   return n->sprite;
 }
 
@@ -73,6 +181,7 @@ void sprixel_movefrom(sprixel* s, int y, int x){
     // what's there--you can't "write transparency"). this is probably
     // best done by conditionally reblitting the sixel(?).
 //fprintf(stderr, "SETTING TO MOVE: %d/%d was: %d\n", y, x, s->invalidated);
+      s->movedinvalid = s->invalidated != SPRIXEL_QUIESCENT;
       s->invalidated = SPRIXEL_MOVED;
       s->movedfromy = y;
       s->movedfromx = x;
@@ -102,14 +211,21 @@ void sprixel_hide(sprixel* s){
 // y and x are absolute coordinates.
 void sprixel_invalidate(sprixel* s, int y, int x){
 //fprintf(stderr, "INVALIDATING AT %d/%d\n", y, x);
-  if(s->invalidated == SPRIXEL_QUIESCENT && s->n){
+  if(s->n && (s->invalidated == SPRIXEL_QUIESCENT || s->fbdamage)){
     int localy = y - s->n->absy;
     int localx = x - s->n->absx;
-//fprintf(stderr, "INVALIDATING AT %d/%d (%d/%d) TAM: %d\n", y, x, localy, localx, s->n->tam[localy * s->dimx + localx].state);
-    if(s->n->tam[localy * s->dimx + localx].state != SPRIXCELL_TRANSPARENT &&
-       s->n->tam[localy * s->dimx + localx].state != SPRIXCELL_ANNIHILATED &&
-       s->n->tam[localy * s->dimx + localx].state != SPRIXCELL_ANNIHILATED_TRANS){
-      s->invalidated = SPRIXEL_INVALIDATED;
+    const int idx = localy * s->dimx + localx;
+//fprintf(stderr, "INVALIDATING AT %d/%d (%d/%d) TAM: %d\n", y, x, localy, localx, s->n->tam[idx].state);
+    if(s->n->tam[idx].state != SPRIXCELL_TRANSPARENT &&
+       s->n->tam[idx].state != SPRIXCELL_ANNIHILATED &&
+       s->n->tam[idx].state != SPRIXCELL_ANNIHILATED_TRANS){
+      if(s->invalidated == SPRIXEL_QUIESCENT){
+        s->invalidated = SPRIXEL_INVALIDATED;
+        ncpile_queue_sprixel(ncplane_pile(s->n), s);
+      }
+      if(s->fbdamage){ // the framebuffer need only redraw this cell
+        s->fbdamage[idx] = 1;
+      }
     }
   }
 }
@@ -120,7 +236,15 @@ sprixel* sprixel_alloc(ncplane* n, int dimy, int dimx){
     return NULL;
   }
   memset(ret, 0, sizeof(*ret));
-  if(fbuf_init(&ret->glyph)){
+  // in rendered mode, glyph buffers are recycled through the context's pool.
+  // the sprixel can outlive its plane, so it keeps its own reference.
+  if(ncplane_pile(n)){
+    ret->fpool = &ncplane_notcurses(n)->fbpool;
+    ret->apool = &ncplane_notcurses(n)->auxpool;
+    ret->cellpxy = ncplane_pile(n)->cellpxy;
+    ret->cellpxx = ncplane_pile(n)->cellpxx;
+  }
+  if(fbufpool_get(ret->fpool, &ret->glyph, 0)){
     free(ret);
     return NULL;
   }
@@ -155,7 +279,7 @@ int sprixel_load(sprixel* spx, fbuf* f, unsigned pixy, unsigned pixx,
                  int parse_start, sprixel_e state){
   assert(spx->n);
   if(&spx->glyph != f){
-    fbuf_free(&spx->glyph);
+    fbufpool_put(spx->fpool, &spx->glyph);
     memcpy(&spx->glyph, f, sizeof(*f));
   }
   spx->invalidated = state;
@@ -176,7 +300,7 @@ int sprite_wipe(const notcurses* nc, sprixel* s, int ycell, int xcell){
     // be entirely 0s coming from pixel_trans_auxvec().
     if(s->n->tam[idx].auxvector == NULL){
       if(nc->tcache.pixel_trans_auxvec){
-        s->n->tam[idx].auxvector = nc->tcache.pixel_trans_auxvec(ncplane_pile(s->n));
+        s->n->tam[idx].auxvector = nc->tcache.pixel_trans_auxvec(s);
         if(s->n->tam[idx].auxvector == NULL){
           return -1;
         }
@@ -192,7 +316,14 @@ int sprite_wipe(const notcurses* nc, sprixel* s, int ycell, int xcell){
     return 0;
   }
   logdebug("wiping %p %d %d/%d", s->n->tam, idx, ycell, xcell);
+  const bool moved = s->invalidated == SPRIXEL_MOVED;
   int r = nc->tcache.pixel_wipe(s, ycell, xcell);
+  // remember the move, lest the terminal having scrolled us into place go
+  // unrecognized (see clean_sprixels())
+  if(moved && s->invalidated != SPRIXEL_MOVED){
+    s->invalidated = SPRIXEL_MOVED;
+    s->movedinvalid = true;
+  }
 //fprintf(stderr, "WIPED %d %d/%d ret=%d\n", s->id, ycell, xcell, r);
   // mark the cell as annihilated whether we actually scrubbed it or not,
   // so that we use this fact should we move to another frame
@@ -237,6 +368,8 @@ int sprixel_rescale(sprixel* spx, unsigned ncellpxy, unsigned ncellpxx){
       sprite_rebuild(ncplane_notcurses(spx->n), spx, y, x);
     }
   }
+  spx->cellpxy = ncellpxy;
+  spx->cellpxx = ncellpxx;
   ncplane* ncopy = spx->n;
   destroy_tam(spx->n);
   // spx->n->tam has been reset, so it will not be resized herein
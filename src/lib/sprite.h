@@ -128,6 +128,39 @@ typedef struct tament {
   void* auxvector; // palette entries for sixel, alphas for kitty
 } tament;
 
+// auxiliary vectors come and go a cell at a time as cells are wiped and
+// rebuilt (and, for kitty animation, with every frame), which for video
+// would churn the heap every frame. they're instead recycled through an
+// auxpool belonging to the context. every auxvector of a given pile and
+// backend has the same size (derived from the cell-pixel geometry), so a few
+// exact-size classes suffice. each auxvector is preceded by a header naming
+// its pool and size, so that it can be released without any context.
+#define AUXPOOL_CLASSES 4
+#define AUXPOOL_DEPTH 128 // auxvectors retained per class
+
+typedef struct auxpool {
+  pthread_mutex_t lock;    // guards everything below
+  size_t sizes[AUXPOOL_CLASSES];  // auxvector size of each class
+  unsigned counts[AUXPOOL_CLASSES];
+  void* vecs[AUXPOOL_CLASSES][AUXPOOL_DEPTH];
+  uint64_t hits;           // gets satisfied from the pool
+  uint64_t misses;         // gets requiring a fresh auxvector
+} auxpool;
+
+int auxpool_init(auxpool* pool);
+// release all retained auxvectors. any still outstanding must have been
+// released first.
+void auxpool_destroy(auxpool* pool);
+// get an auxvector of |size| bytes from |pool| (which may be NULL, in which
+// case it's freshly allocated). its contents are undefined.
+void* auxvec_get(auxpool* pool, size_t size);
+// release |auxvec| (which may be NULL) to the pool whence it came.
+void auxvec_put(void* auxvec);
+// bytes allocated to |auxvec| (which may be NULL), including its header.
+size_t auxvec_bytes(const void* auxvec);
+// bytes currently retained by |pool|.
+uint64_t auxpool_bytes(auxpool* pool);
+
 // a sprixel represents a bitmap, using whatever local protocol is available.
 // there is a list of sprixels per ncpile. there ought never be very many
 // associated with a context (a dozen or so at max). with the kitty protocol,
@@ -136,6 +169,8 @@ typedef struct tament {
 // sprixels per ncpile, to which the pile keeps a head link.
 typedef struct sprixel {
   fbuf glyph;
+  struct fbufpool* fpool; // glyph buffers come from and return here, or NULL
+  auxpool* apool;       // auxvectors likewise, or NULL
   uint32_t id;          // embedded into gcluster field of nccell, 24 bits
   // both the plane and visual can die before the sprixel does. they are
   // responsible in such a case for NULLing out this link themselves.
@@ -144,19 +179,45 @@ typedef struct sprixel {
   struct sprixel* next;
   struct sprixel* prev;
   unsigned dimy, dimx;  // cell geometry
+  // cell-pixel geometry for which dimy and dimx were computed. when it no
+  // longer matches the pile's, we're rescaled the next time we're visible.
+  unsigned cellpxy, cellpxx;
   int pixy, pixx;       // pixel geometry (might be smaller than cell geo)
   // each tacache entry is one of 0 (standard opaque cell), 1 (cell with
   // some transparency), 2 (annihilated, excised)
   int movedfromy;       // for SPRIXEL_MOVED, the starting absolute position,
   int movedfromx;       // so that we can damage old cells when redrawn
+  bool movedinvalid;    // SPRIXEL_MOVED, but the content changed as well
   // only used for kitty-based sprixels
   int parse_start;      // where to start parsing for cell wipes
+  // only used for static kitty sprixels: glyph offset of each chunk's payload,
+  // recorded at encode time so that wipes and rebuilds can go straight to
+  // the pixels of a cell.
+  uint32_t* chunkoffs;
+  int chunkcount;
   int pxoffy, pxoffx;   // X and Y parameters to display command
+  // only used for animated kitty-based sprixels. once a plane's graphic has
+  // been replaced, we assume it to be video, and keep the pixels last sent,
+  // so that the next frame can be sent as edits to them.
+  uint32_t* frame;      // pixels of the root frame as transmitted, or NULL
+  bool keepframe;       // retain the next transmission in |frame|
+  bool framesedited;    // wipes or rebuilds have touched the frames
   // only used for sixel-based sprixels
   unsigned char* needs_refresh; // one per cell, whether new frame needs damage
   struct sixelmap* smap;  // copy of palette indices + transparency bits
   bool wipes_outstanding; // do we need rebuild the sixel next render?
   bool animating;        // do we have an active animation?
+  // position in the pile's sprixel list as of the last clean_sprixels(), and
+  // whether we're on the pile's queue of sprixels with raster work.
+  unsigned rasteridx;
+  bool queued;
+  // only used for linux framebuffer sprixels. one per cell, whether the cell
+  // must be copied at the next draw; NULL if all of them must be. the map is
+  // only good so long as we're drawn where (and when) we last were.
+  unsigned char* fbdamage;
+  int fbdrawny, fbdrawnx; // cell at which we were last drawn
+  int fbdrawnh, fbdrawnw; // pixel geometry drawn there, 0 if never drawn
+  unsigned fbgen;         // framebuffer scroll generation when last drawn
 } sprixel;
 
 static inline tament*
@@ -191,17 +252,24 @@ int sixel_draw(const struct tinfo* ti, const struct ncpile *p, sprixel* s,
 int kitty_draw(const struct tinfo* ti, const struct ncpile *p, sprixel* s,
                fbuf* f, int yoff, int xoff);
 int kitty_move(sprixel* s, fbuf* f, unsigned noscroll, int yoff, int xoff);
+int kitty_move_placeholder(sprixel* s, fbuf* f, unsigned noscroll, int yoff, int xoff);
 int sixel_scrub(const struct ncpile* p, sprixel* s);
 int kitty_scrub(const struct ncpile* p, sprixel* s);
+int kitty_scrub_placeholder(const struct ncpile* p, sprixel* s);
 int fbcon_scrub(const struct ncpile* p, sprixel* s);
 int kitty_remove(int id, fbuf* f);
 int kitty_clear_all(fbuf* f);
+int kitty_hide_all(fbuf* f);
 int sixel_init_forcesdm(struct tinfo* ti, int fd);
 int sixel_init_inverted(struct tinfo* ti, int fd);
 int sixel_init(struct tinfo* ti, int fd);
-uint8_t* sixel_trans_auxvec(const struct ncpile* p);
-uint8_t* kitty_trans_auxvec(const struct ncpile* p);
+int kitty_init(struct tinfo* ti, int fd);
+uint8_t* sixel_trans_auxvec(const sprixel* s);
+uint8_t* kitty_trans_auxvec(const sprixel* s);
 int kitty_commit(fbuf* f, sprixel* s, unsigned noscroll);
+int kitty_commit_placeholder(fbuf* f, sprixel* s, unsigned noscroll);
+sprixel* kitty_recycle(struct ncplane* n, const struct blitterargs* bargs,
+                       int leny, int lenx);
 int sixel_blit(struct ncplane* nc, int linesize, const void* data,
                int leny, int lenx, const struct blitterargs* bargs);
 int kitty_blit(struct ncplane* nc, int linesize, const void* data,
@@ -210,10 +278,21 @@ int kitty_blit_animated(struct ncplane* n, int linesize, const void* data,
                         int leny, int lenx, const struct blitterargs* bargs);
 int kitty_blit_selfref(struct ncplane* nc, int linesize, const void* data,
                        int leny, int lenx, const struct blitterargs* bargs);
+// encodes as kitty_blit_animated(), and then writes placeholder glyphs for
+// each cell of the graphic into the plane.
+int kitty_blit_placeholder(struct ncplane* nc, int linesize, const void* data,
+                           int leny, int lenx, const struct blitterargs* bargs);
 int fbcon_blit(struct ncplane* nc, int linesize, const void* data,
                int leny, int lenx, const struct blitterargs* bargs);
 int fbcon_draw(const struct tinfo* ti, sprixel* s, int yoff, int xoff);
 void fbcon_scroll(const struct ncpile* p, struct tinfo* ti, int rows);
+int fbcon_flush(const struct tinfo* ti);
+int fbcon_init(struct tinfo* ti, int fd);
+void fbcon_cleanup(struct tinfo* ti);
+int drm_flush(const struct tinfo* ti);
+int drm_wipe(sprixel* s, int y, int x);
+int drm_scrub(const struct ncpile* p, sprixel* s);
+void drm_cleanup(struct tinfo* ti);
 void sixel_refresh(const struct ncpile* p, sprixel* s);
 
 // takes ownership of s on success.
@@ -226,6 +305,13 @@ int sprixel_rescale(sprixel* spx, unsigned ncellpixy, unsigned ncellpixx);
 // cleans up the sixel worker threads
 void sixel_cleanup(struct tinfo* ti);
 
+// cleans up the kitty compression contexts and worker threads
+void kitty_cleanup(struct tinfo* ti);
+
+// the terminal rejected a payload sent through shared memory or a file;
+// transmit them directly from now on.
+void kitty_transport_failed(struct tinfo* ti);
+
 #ifdef __cplusplus
 }
 #endif
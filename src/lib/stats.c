@@ -1,12 +1,108 @@
 #include <inttypes.h>
 #include "internal.h"
 
-// update timings for writeout. only call on success. call only under statlock.
+// log-linear histogram buckets: values below 16 get a bucket apiece, and each
+// higher power of two is split into 16 buckets by the four bits below its msb.
+#define HIST_SUBBITS 4
+#define HIST_SUBS (1u << HIST_SUBBITS)
+
+static unsigned
+hist_bucket(uint64_t ns){
+  if(ns < HIST_SUBS){
+    return ns;
+  }
+  const unsigned msb = 63 - __builtin_clzll(ns);
+  const unsigned idx = (msb - HIST_SUBBITS + 1) * HIST_SUBS +
+                       ((ns >> (msb - HIST_SUBBITS)) & (HIST_SUBS - 1));
+  return idx < NCHISTOGRAM_BUCKETS ? idx : NCHISTOGRAM_BUCKETS - 1;
+}
+
+uint64_t nchistogram_bucket_ns(unsigned idx){
+  if(idx >= NCHISTOGRAM_BUCKETS){
+    idx = NCHISTOGRAM_BUCKETS - 1;
+  }
+  if(idx < HIST_SUBS){
+    return idx;
+  }
+  const unsigned msb = idx / HIST_SUBS + HIST_SUBBITS - 1;
+  return (uint64_t)(HIST_SUBS + idx % HIST_SUBS) << (msb - HIST_SUBBITS);
+}
+
+uint64_t nchistogram_percentile(const nchistogram* h, double pct){
+  if(h->count == 0){
+    return 0;
+  }
+  if(pct < 0){
+    pct = 0;
+  }else if(pct > 100){
+    pct = 100;
+  }
+  // the rank of the sample we're after, counting from 1
+  uint64_t rank = (uint64_t)(pct * h->count / 100.0 + 0.999999);
+  if(rank == 0){
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  for(unsigned idx = 0 ; idx < NCHISTOGRAM_BUCKETS ; ++idx){
+    seen += h->buckets[idx];
+    if(seen >= rank){
+      if(idx == NCHISTOGRAM_BUCKETS - 1){
+        return nchistogram_bucket_ns(idx);
+      }
+      return nchistogram_bucket_ns(idx + 1) - 1;
+    }
+  }
+  return nchistogram_bucket_ns(NCHISTOGRAM_BUCKETS - 1);
+}
+
+static inline void
+hist_record(nchistogram* h, uint64_t ns){
+  ++h->buckets[hist_bucket(ns)];
+  ++h->count;
+}
+
+void nchistogram_record(nchistogram* h, uint64_t ns){
+  hist_record(h, ns);
+}
+
+static void
+hist_merge(nchistogram* dst, const nchistogram* src){
+  if(src->count == 0){
+    return;
+  }
+  for(unsigned idx = 0 ; idx < NCHISTOGRAM_BUCKETS ; ++idx){
+    dst->buckets[idx] += src->buckets[idx];
+  }
+  dst->count += src->count;
+}
+
+int notcurses_stats_histogram(notcurses* nc, ncstats_hist_e which, nchistogram* h){
+  if(which < 0 || which >= NCSTATS_HIST_COUNT){
+    logerror("invalid histogram %d", which);
+    return -1;
+  }
+  stats_read(&nc->stats, h, &nc->stats.hists[which], sizeof(*h));
+  return 0;
+}
+
+// update timings for writeout. only call on success. call only under stats_lock().
+// a successful write answers any pending input, closing its input-to-photon
+// interval.
 void update_write_stats(const struct timespec* time1, const struct timespec* time0,
-                        ncstats* stats, int bytes){
+                        ncsharedstats* shared, int bytes){
+  ncstats* stats = &shared->s;
   if(bytes >= 0){
     const int64_t elapsed = timespec_to_ns(time1) - timespec_to_ns(time0);
+    const uint64_t pending = __atomic_exchange_n(&shared->input_pending_ns, 0,
+                                                 __ATOMIC_RELAXED);
+    if(pending){
+      const uint64_t t1 = timespec_to_ns(time1);
+      if(t1 > pending){
+        hist_record(&shared->hists[NCSTATS_HIST_INPUT2PHOTON], t1 - pending);
+      }
+    }
     if(elapsed > 0){ // don't count clearly incorrect information, egads
+      hist_record(&shared->hists[NCSTATS_HIST_WRITEOUT], elapsed);
       ++stats->writeouts;
       stats->writeout_ns += elapsed;
       if(elapsed > stats->writeout_max_ns){
@@ -21,6 +117,45 @@ void update_write_stats(const struct timespec* time1, const struct timespec* tim
   }
 }
 
+// the client has taken |count| events at |ni|. each read from the terminal
+// records how long it waited, and the oldest starts the input-to-photon clock
+// (see update_write_stats()), unless it's already running.
+void update_taken_input_stats(ncsharedstats* shared, const ncinput* ni, int count){
+  uint64_t oldest = 0;
+  uint64_t nowns = 0;
+  for(int i = 0 ; i < count ; ++i){
+    if(ni[i].recvns == 0){
+      continue;
+    }
+    if(nowns == 0){
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      nowns = timespec_to_ns(&now);
+      stats_lock(shared);
+    }
+    hist_record(&shared->hists[NCSTATS_HIST_INPUTWAIT],
+                nowns > ni[i].recvns ? nowns - ni[i].recvns : 0);
+    if(oldest == 0 || ni[i].recvns < oldest){
+      oldest = ni[i].recvns;
+    }
+  }
+  if(nowns){
+    stats_unlock(shared);
+    uint64_t none = 0;
+    __atomic_compare_exchange_n(&shared->input_pending_ns, &none, oldest, false,
+                                __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+  }
+}
+
+// fold the input thread's private latency histogram into the shared one, and
+// clear it. we do this once per burst of input, rather than per event.
+void update_input_stats(ncsharedstats* shared, nchistogram* latencies){
+  stats_lock(shared);
+    hist_merge(&shared->hists[NCSTATS_HIST_INPUT], latencies);
+  stats_unlock(shared);
+  memset(latencies, 0, sizeof(*latencies));
+}
+
 // negative 'bytes' are ignored as failures. call only while holding statlock.
 // we don't increment failed_rasters here because 'bytes' < 0 actually indicates
 // a rasterization failure -- we can't fail in rastering anymore.
@@ -38,11 +173,13 @@ void update_raster_bytes(ncstats* stats, int bytes){
 
 // call only while holding statlock.
 void update_render_stats(const struct timespec* time1, const struct timespec* time0,
-                         ncstats* stats){
+                         ncsharedstats* shared){
+  ncstats* stats = &shared->s;
   const int64_t elapsed = timespec_to_ns(time1) - timespec_to_ns(time0);
   //fprintf(stderr, "Rendering took %ld.%03lds\n", elapsed / NANOSECS_IN_SEC,
   //        (elapsed % NANOSECS_IN_SEC) / 1000000);
   if(elapsed > 0){ // don't count clearly incorrect information, egads
+    hist_record(&shared->hists[NCSTATS_HIST_RENDER], elapsed);
     ++stats->renders;
     stats->render_ns += elapsed;
     if(elapsed > stats->render_max_ns){
@@ -56,11 +193,13 @@ void update_render_stats(const struct timespec* time1, const struct timespec* ti
 
 // call only while holding statlock.
 void update_raster_stats(const struct timespec* time1, const struct timespec* time0,
-                         ncstats* stats){
+                         ncsharedstats* shared){
+  ncstats* stats = &shared->s;
   const int64_t elapsed = timespec_to_ns(time1) - timespec_to_ns(time0);
   //fprintf(stderr, "Rasterizing took %ld.%03lds\n", elapsed / NANOSECS_IN_SEC,
   //        (elapsed % NANOSECS_IN_SEC) / 1000000);
   if(elapsed > 0){ // don't count clearly incorrect information, egads
+    hist_record(&shared->hists[NCSTATS_HIST_RASTER], elapsed);
     stats->raster_ns += elapsed;
     if(elapsed > stats->raster_max_ns){
       stats->raster_max_ns = elapsed;
@@ -71,9 +210,21 @@ void update_raster_stats(const struct timespec* time1, const struct timespec* ti
   }
 }
 
+// call only while holding statlock.
+void update_render_band_stats(ncstats* stats, uint64_t bandns, int64_t bandmaxns){
+  stats->render_band_ns += bandns;
+  if(bandmaxns > stats->render_band_max_ns){
+    stats->render_band_max_ns = bandmaxns;
+  }
+}
+
 void reset_stats(ncstats* stats){
   uint64_t fbbytes = stats->fbbytes;
   unsigned planes = stats->planes;
+  unsigned render_threads = stats->render_threads;
+  unsigned stream_queue_depth = stats->stream_queue_depth;
+  int64_t stream_av_skew_ns = stats->stream_av_skew_ns;
+  uint64_t stream_present_ns = stats->stream_present_ns;
   memset(stats, 0, sizeof(*stats));
   stats->render_min_ns = 1ull << 62u;
   stats->raster_min_bytes = 1ull << 62u;
@@ -81,12 +232,152 @@ void reset_stats(ncstats* stats){
   stats->writeout_min_ns = 1ull << 62u;
   stats->fbbytes = fbbytes;
   stats->planes = planes;
+  stats->render_threads = render_threads;
+  stats->stream_queue_depth = stream_queue_depth;
+  stats->stream_av_skew_ns = stream_av_skew_ns;
+  stats->stream_present_ns = stream_present_ns;
+}
+
+// fragmentation changes with every release, far too often to track under the
+// stats lock, so we total it up across all piles whenever it's requested.
+static uint64_t
+pool_fragmentation(notcurses* nc){
+  uint64_t ret = egcpool_fragmentation(&nc->pool);
+  if(nc->stdplane == NULL){
+    return ret;
+  }
+  pthread_mutex_lock(&nc->pilelock);
+    ncpile* start = ncplane_pile(nc->stdplane);
+    ncpile* p = start;
+    do{
+      for(const ncplane* n = p->top ; n ; n = n->below){
+        ret += egcpool_fragmentation(&n->pool);
+      }
+      p = p->next;
+    }while(p != start);
+  pthread_mutex_unlock(&nc->pilelock);
+  return ret;
 }
 
+// the fbuf pool is used from sprixel code which knows nothing of the stats
+// lock, so it keeps its own counts under its own lock. they're read (and
+// zeroed, if |reset| is set) into |stats|.
+static void
+fbuf_pool_stats(notcurses* nc, ncstats* stats, bool reset){
+  fbufpool* pool = &nc->fbpool;
+  pthread_mutex_lock(&pool->lock);
+    stats->fbuf_pool_hits = pool->hits;
+    stats->fbuf_pool_misses = pool->misses;
+    stats->fbuf_pool_bytes = pool->bytes;
+    if(reset){
+      pool->hits = 0;
+      pool->misses = 0;
+    }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+// the snapshot is taken without the stats lock, so pollers never hold up
+// the render path.
 void notcurses_stats(notcurses* nc, ncstats* stats){
-  pthread_mutex_lock(&nc->stats.lock);
-    memcpy(stats, &nc->stats.s, sizeof(*stats));
-  pthread_mutex_unlock(&nc->stats.lock);
+  const uint64_t fragmented = pool_fragmentation(nc);
+  stats_read(&nc->stats, stats, &nc->stats.s, sizeof(*stats));
+  stats->input_events += __atomic_load_n(&nc->stats.input_events, __ATOMIC_RELAXED);
+  stats->input_errors += __atomic_load_n(&nc->stats.input_errors, __ATOMIC_RELAXED);
+  stats->pool_fragmented = fragmented;
+  fbuf_pool_stats(nc, stats, false);
+}
+
+// charge |n|'s own allocations to |r|. a framebuffer and pool shared with
+// ncplane_dup()s is split among the sharers, so that the total comes out
+// right. call with the pilelock held, or with |n| otherwise quiescent.
+static void
+plane_memory(const ncplane* n, ncmemreport* r){
+  const unsigned sharers = n->fbshare ?
+    __atomic_load_n(&n->fbshare->refs, __ATOMIC_ACQUIRE) : 1;
+  r->fbbytes += sizeof(*n->fb) * n->capy * n->lenx / sharers;
+  r->poolbytes += (unsigned)n->pool.poolsize / sharers;
+  r->historybytes += scrollback_bytes(n) + canvas_bytes(n);
+  if(n->tam){
+    const size_t cells = n->leny * n->lenx;
+    r->tambytes += sizeof(*n->tam) * cells;
+    for(size_t i = 0 ; i < cells ; ++i){
+      r->tambytes += auxvec_bytes(n->tam[i].auxvector);
+    }
+  }
+}
+
+static void
+sprixel_memory(const sprixel* s, ncmemreport* r){
+  r->glyphbytes += s->glyph.size;
+  r->glyphbytes += sizeof(*s->chunkoffs) * s->chunkcount;
+  if(s->frame){
+    r->glyphbytes += sizeof(*s->frame) * s->pixy * s->pixx;
+  }
+  if(s->needs_refresh){
+    r->glyphbytes += s->dimy * s->dimx;
+  }
+  if(s->fbdamage){
+    r->glyphbytes += s->dimy * s->dimx;
+  }
+  r->sixelmapbytes += sixelmap_bytes(s->smap);
+}
+
+static void
+memreport_total(ncmemreport* r){
+  r->totalbytes = r->fbbytes + r->poolbytes + r->historybytes + r->tambytes +
+                  r->glyphbytes + r->sixelmapbytes + r->renderbytes +
+                  r->framebytes + r->rasterbytes + r->cachebytes;
+}
+
+// like pool_fragmentation(), this walks everything whenever it's requested,
+// rather than taxing every allocation with bookkeeping.
+void notcurses_memory_report(notcurses* nc, ncmemreport* r){
+  memset(r, 0, sizeof(*r));
+  pthread_mutex_lock(&nc->pilelock);
+    ncpile* start = ncplane_pile(nc->stdplane);
+    ncpile* p = start;
+    do{
+      for(const ncplane* n = p->top ; n ; n = n->below){
+        plane_memory(n, r);
+      }
+      for(const sprixel* s = p->sprixelcache ; s ; s = s->next){
+        sprixel_memory(s, r);
+      }
+      r->renderbytes += sizeof(*p) + sizeof(*p->crender) * p->crenderlen;
+      r->renderbytes += sizeof(*p->sprixwork) * p->sprixworkcap;
+      r->renderbytes += sizeof(*p->rsprixels) * p->rsprixelscap;
+      r->renderbytes += sizeof(*p->rsprixidx) * p->rsprixidxlen;
+      r->renderbytes += sizeof(*p->unsolved) * p->unsolvedlen;
+      r->renderbytes += sizeof(*p->dmgspans) * p->dmgspanslen;
+      if(p->capframe){
+        r->framebytes += sizeof(*p->capframe) * p->capdimy * p->capdimx;
+      }
+      r->framebytes += p->cappool.poolsize;
+      p = p->next;
+    }while(p != start);
+    for(const ncplane* n = nc->planecache ; n ; n = n->above){
+      r->cachebytes += sizeof(*n) + sizeof(*n->fb) * n->fbcached;
+    }
+  pthread_mutex_unlock(&nc->pilelock);
+  if(nc->lastframe){
+    r->framebytes += sizeof(*nc->lastframe) * nc->lfdimy * nc->lfdimx;
+  }
+  r->framebytes += nc->pool.poolsize;
+  r->rasterbytes += nc->rstate.f.size;
+  r->rasterbytes += sizeof(*nc->rstate.splices) * nc->rstate.splicealloc;
+  ncstats fbstats;
+  fbuf_pool_stats(nc, &fbstats, false);
+  r->cachebytes += fbstats.fbuf_pool_bytes + auxpool_bytes(&nc->auxpool);
+  memreport_total(r);
+}
+
+void ncplane_memory_report(const ncplane* n, ncmemreport* r){
+  memset(r, 0, sizeof(*r));
+  plane_memory(n, r);
+  if(n->sprite){
+    sprixel_memory(n->sprite, r);
+  }
+  memreport_total(r);
 }
 
 ncstats* notcurses_stats_alloc(const notcurses* nc __attribute__ ((unused))){
@@ -98,9 +389,23 @@ ncstats* notcurses_stats_alloc(const notcurses* nc __attribute__ ((unused))){
 }
 
 void notcurses_stats_reset(notcurses* nc, ncstats* stats){
-  pthread_mutex_lock(&nc->stats.lock);
+  // we're called from notcurses_stop() with a NULL |stats| after the planes
+  // are gone, so only walk them if we need to.
+  const uint64_t fragmented = stats ? pool_fragmentation(nc) : 0;
+  ncstats fbstats;
+  fbuf_pool_stats(nc, &fbstats, true);
+  stats_lock(&nc->stats);
+    // fold in the input thread's counts, so that they're reset with the rest
+    nc->stats.s.input_events += __atomic_exchange_n(&nc->stats.input_events, 0,
+                                                    __ATOMIC_RELAXED);
+    nc->stats.s.input_errors += __atomic_exchange_n(&nc->stats.input_errors, 0,
+                                                    __ATOMIC_RELAXED);
     if(stats){
       memcpy(stats, &nc->stats.s, sizeof(*stats));
+      stats->pool_fragmented = fragmented;
+      stats->fbuf_pool_hits = fbstats.fbuf_pool_hits;
+      stats->fbuf_pool_misses = fbstats.fbuf_pool_misses;
+      stats->fbuf_pool_bytes = fbstats.fbuf_pool_bytes;
     }
     // add the stats to the stashed stats, so that we can show true totals on
     // shutdown in the closing banner
@@ -129,6 +434,20 @@ void notcurses_stats_reset(notcurses* nc, ncstats* stats){
     if(nc->stats.s.writeout_max_ns > stash->writeout_max_ns){
       stash->writeout_max_ns = nc->stats.s.writeout_max_ns;
     }
+    if(nc->stats.s.render_band_max_ns > stash->render_band_max_ns){
+      stash->render_band_max_ns = nc->stats.s.render_band_max_ns;
+    }
+    stash->render_band_ns += nc->stats.s.render_band_ns;
+    stash->deferred_rasters += nc->stats.s.deferred_rasters;
+    stash->pool_compactions += nc->stats.s.pool_compactions;
+    stash->pool_reclaimed += nc->stats.s.pool_reclaimed;
+    stash->fbuf_pool_hits += fbstats.fbuf_pool_hits;
+    stash->fbuf_pool_misses += fbstats.fbuf_pool_misses;
+    stash->stream_frames_dropped += nc->stats.s.stream_frames_dropped;
+    stash->stream_frames_held += nc->stats.s.stream_frames_held;
+    stash->lowbw_frames += nc->stats.s.lowbw_frames;
+    stash->approx_elisions += nc->stats.s.approx_elisions;
+    stash->degraded_blits += nc->stats.s.degraded_blits;
     stash->writeout_ns += nc->stats.s.writeout_ns;
     stash->raster_ns += nc->stats.s.raster_ns;
     stash->render_ns += nc->stats.s.render_ns;
@@ -158,8 +477,17 @@ void notcurses_stats_reset(notcurses* nc, ncstats* stats){
 
     stash->fbbytes = nc->stats.s.fbbytes;
     stash->planes = nc->stats.s.planes;
+    stash->render_threads = nc->stats.s.render_threads;
+    stash->stream_queue_depth = nc->stats.s.stream_queue_depth;
+    stash->stream_av_skew_ns = nc->stats.s.stream_av_skew_ns;
+    stash->stream_present_ns = nc->stats.s.stream_present_ns;
+    stash->fbuf_pool_bytes = fbstats.fbuf_pool_bytes;
+    for(unsigned h = 0 ; h < NCSTATS_HIST_COUNT ; ++h){
+      hist_merge(&nc->stashed_hists[h], &nc->stats.hists[h]);
+    }
+    memset(nc->stats.hists, 0, sizeof(nc->stats.hists));
     reset_stats(&nc->stats.s);
-  pthread_mutex_unlock(&nc->stats.lock);
+  stats_unlock(&nc->stats);
 }
 
 // remember, by this time, we no longer have terminal info
@@ -178,6 +506,12 @@ void summarize_stats(notcurses* nc){
             stats->renders, stats->renders == 1 ? "" : "s",
             totalbuf, minbuf, avgbuf, maxbuf);
   }
+  if(stats->render_threads > 1 && stats->render_band_ns){
+    ncqprefix(stats->render_band_ns, NANOSECS_IN_SEC, totalbuf, 0);
+    ncqprefix(stats->render_band_max_ns, NANOSECS_IN_SEC, maxbuf, 0);
+    fprintf(stderr, "%u render threads, %ss in bands (%ss max)" NL,
+            stats->render_threads, totalbuf, maxbuf);
+  }
   if(stats->writeouts || stats->failed_writeouts){
     ncqprefix(stats->raster_ns, NANOSECS_IN_SEC, totalbuf, 0);
     ncqprefix(stats->raster_min_ns, NANOSECS_IN_SEC, minbuf, 0);
@@ -209,6 +543,56 @@ void summarize_stats(notcurses* nc){
             stats->input_events == 1 ? "" : "s",
             stats->hpa_gratuitous);
   }
+  static const char* const histnames[NCSTATS_HIST_COUNT] = {
+    "render", "raster", "write", "input->photon", "input", "input wait",
+  };
+  for(unsigned h = 0 ; h < NCSTATS_HIST_COUNT ; ++h){
+    const nchistogram* hist = &nc->stashed_hists[h];
+    if(hist->count == 0){
+      continue;
+    }
+    char p50[NCPREFIXSTRLEN + 1], p90[NCPREFIXSTRLEN + 1];
+    char p99[NCPREFIXSTRLEN + 1], p999[NCPREFIXSTRLEN + 1];
+    ncqprefix(nchistogram_percentile(hist, 50), NANOSECS_IN_SEC, p50, 0);
+    ncqprefix(nchistogram_percentile(hist, 90), NANOSECS_IN_SEC, p90, 0);
+    ncqprefix(nchistogram_percentile(hist, 99), NANOSECS_IN_SEC, p99, 0);
+    ncqprefix(nchistogram_percentile(hist, 99.9), NANOSECS_IN_SEC, p999, 0);
+    fprintf(stderr, "%s: %ss p50, %ss p90, %ss p99, %ss p999" NL,
+            histnames[h], p50, p90, p99, p999);
+  }
+  if(stats->deferred_rasters){
+    fprintf(stderr, "%"PRIu64" deferred raster%s" NL, stats->deferred_rasters,
+            stats->deferred_rasters == 1 ? "" : "s");
+  }
+  if(stats->pool_compactions){
+    ncbprefix(stats->pool_reclaimed, 1, totalbuf, 1);
+    fprintf(stderr, "%"PRIu64" pool compaction%s, %sB reclaimed" NL,
+            stats->pool_compactions, stats->pool_compactions == 1 ? "" : "s",
+            totalbuf);
+  }
+  if(stats->fbuf_pool_hits || stats->fbuf_pool_misses){
+    fprintf(stderr, "%"PRIu64"/%"PRIu64" glyph buffer%s recycled" NL,
+            stats->fbuf_pool_hits,
+            stats->fbuf_pool_hits + stats->fbuf_pool_misses,
+            stats->fbuf_pool_hits + stats->fbuf_pool_misses == 1 ? "" : "s");
+  }
+  if(stats->stream_frames_dropped){
+    fprintf(stderr, "%"PRIu64" late video frame%s dropped" NL,
+            stats->stream_frames_dropped,
+            stats->stream_frames_dropped == 1 ? "" : "s");
+  }
+  if(stats->stream_frames_held){
+    fprintf(stderr, "%"PRIu64" video frame period%s held over" NL,
+            stats->stream_frames_held,
+            stats->stream_frames_held == 1 ? "" : "s");
+  }
+  if(stats->lowbw_frames){
+    fprintf(stderr, "%"PRIu64" low-bandwidth frame%s, %"PRIu64" approximate"
+                    " elision%s, %"PRIu64" degraded blit%s" NL,
+            stats->lowbw_frames, stats->lowbw_frames == 1 ? "" : "s",
+            stats->approx_elisions, stats->approx_elisions == 1 ? "" : "s",
+            stats->degraded_blits, stats->degraded_blits == 1 ? "" : "s");
+  }
   fprintf(stderr, "%"PRIu64" failed render%s, %"PRIu64" failed raster%s, %"
                   PRIu64" refresh%s, %"PRIu64" input error%s" NL,
           stats->failed_renders, stats->failed_renders == 1 ? "" : "s",
@@ -18,8 +18,25 @@ typedef struct nctabbed {
   int tabcount;          // tab separator (can be NULL)
   int sepcols;           // separator with in columns
   nctabbed_opsint opts;  // copied in nctabbed_create()
+  // the headers as last drawn. unless hdrstale is set (by anything which
+  // changes their layout or colors), a change of selection needs redraw
+  // only the headers of the old and new selections.
+  bool hdrstale;
+  nctab* hdrsel;         // tab drawn as selected
+  unsigned hdrcols;      // width of the header plane
 } nctabbed;
 
+// redraw the header of |t| in place, using |chan|. a header which wasn't
+// drawn (for lack of space) isn't drawn now, either.
+static void
+nctabbed_draw_header(nctabbed* nt, const nctab* t, uint64_t chan){
+  if(t == NULL || t->hdrx < 0){
+    return;
+  }
+  ncplane_set_channels(nt->hp, chan);
+  ncplane_putstr_yx(nt->hp, 0, t->hdrx, t->name);
+}
+
 void nctabbed_redraw(nctabbed* nt){
   nctab* t;
   unsigned drawn_cols = 0;
@@ -27,6 +44,7 @@ void nctabbed_redraw(nctabbed* nt){
   if(nt->tabcount == 0){
     // no tabs = nothing to draw
     ncplane_erase(nt->hp);
+    nt->hdrstale = true;
     return;
   }
   // update sizes for planes
@@ -44,10 +62,23 @@ void nctabbed_redraw(nctabbed* nt){
     nt->selected->cb(nt->selected, nt->p, nt->selected->curry);
   }
   // now we draw the headers
+  if(!nt->hdrstale && nt->hdrcols == cols){
+    if(nt->hdrsel != nt->selected){
+      nctabbed_draw_header(nt, nt->hdrsel, nt->opts.hdrchan);
+      nctabbed_draw_header(nt, nt->selected, nt->opts.selchan);
+      nt->hdrsel = nt->selected;
+    }
+    return;
+  }
   t = nt->leftmost;
+  do{
+    t->hdrx = -1;
+    t = t->next;
+  }while(t != nt->leftmost);
   ncplane_erase(nt->hp);
   ncplane_set_channels(nt->hp, nt->opts.hdrchan);
   do{
+    t->hdrx = drawn_cols;
     if(t == nt->selected){
       ncplane_set_channels(nt->hp, nt->opts.selchan);
       drawn_cols += ncplane_putstr(nt->hp, t->name);
@@ -64,6 +95,9 @@ void nctabbed_redraw(nctabbed* nt){
     }
     t = t->next;
   }while(t != nt->leftmost && drawn_cols < cols);
+  nt->hdrstale = false;
+  nt->hdrsel = nt->selected;
+  nt->hdrcols = cols;
 }
 
 void nctabbed_ensure_selected_header_visible(nctabbed* nt){
@@ -164,6 +198,9 @@ nctabbed* nctabbed_create(ncplane* n, const nctabbed_options* topts){
   nt->leftmost = nt->selected = NULL;
   nt->tabcount = 0;
   nt->sepcols = 0;
+  nt->hdrstale = true;
+  nt->hdrsel = NULL;
+  nt->hdrcols = 0;
   memcpy(&nt->opts, topts, sizeof(*topts));
   nt->opts.separator = NULL;
   nt->opts.selchan = topts->selchan;
@@ -222,7 +259,7 @@ nctabbed* nctabbed_create(ncplane* n, const nctabbed_options* topts){
   return nt;
 
 err:
-  ncplane_destroy_family(n);
+  ncplane_destroy_family(n, 0);
   if(nt){
     free(nt->opts.separator);
     free(nt);
@@ -275,7 +312,9 @@ nctab* nctabbed_add(nctabbed* nt, nctab* after, nctab* before, tabcb cb,
   t->nt = nt;
   t->cb = cb;
   t->curry = opaque;
+  t->hdrx = -1;
   ++nt->tabcount;
+  nt->hdrstale = true;
   return t;
 }
 
@@ -299,6 +338,7 @@ int nctabbed_del(nctabbed* nt, nctab* t){
   free(t->name);
   free(t);
   --nt->tabcount;
+  nt->hdrstale = true;
   return 0;
 }
 
@@ -330,6 +370,7 @@ int nctab_move(nctabbed* nt __attribute__ ((unused)), nctab* t, nctab* after, nc
     before->prev = t;
     t->prev->next = t;
   }
+  t->nt->hdrstale = true;
   return 0;
 }
 
@@ -356,6 +397,7 @@ void nctab_move_left(nctabbed* nt, nctab* t){
 }
 
 void nctabbed_rotate(nctabbed* nt, int amt){
+  nt->hdrstale = true;
   if(amt > 0){
     for(int i = 0 ; i < amt ; ++i){
       nt->leftmost = nt->leftmost->prev;
@@ -429,7 +471,7 @@ void nctabbed_destroy(nctabbed* nt){
       free(t);
       t = tmp;
     }
-    ncplane_destroy_family(nt->ncp);
+    ncplane_destroy_family(nt->ncp, 0);
     free(nt->opts.separator);
     free(nt);
   }
@@ -437,14 +479,17 @@ void nctabbed_destroy(nctabbed* nt){
 
 void nctabbed_set_hdrchan(nctabbed* nt, uint64_t chan){
   nt->opts.hdrchan = chan;
+  nt->hdrstale = true;
 }
 
 void nctabbed_set_selchan(nctabbed* nt, uint64_t chan){
   nt->opts.selchan = chan;
+  nt->hdrstale = true;
 }
 
 void nctabbed_set_sepchan(nctabbed* nt, uint64_t chan){
   nt->opts.sepchan = chan;
+  nt->hdrstale = true;
 }
 
 tabcb nctab_set_cb(nctab* t, tabcb newcb){
@@ -467,6 +512,7 @@ int nctab_set_name(nctab* t, const char* newname){
   }
   free(prevname);
   t->namecols = newnamecols;
+  t->nt->hdrstale = true;
   return 0;
 }
 
@@ -490,5 +536,6 @@ int nctabbed_set_separator(nctabbed* nt, const char* separator){
   }
   free(prevsep);
   nt->sepcols = newsepcols;
+  nt->hdrstale = true;
   return 0;
 }
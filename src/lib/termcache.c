@@ -0,0 +1,398 @@
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "internal.h"
+#include "in.h"
+
+// an opt-in (NOTCURSES_TERMCACHE) on-disk cache of the responses to our
+// initial queries. a cached entry is applied in place of waiting on the
+// terminal, which saves a round trip on every startup. the queries are sent
+// anyway, and their responses are compared against the entry once they
+// arrive (see termcache_verify()); on mismatch, the entry is replaced.
+//
+// entries live under $XDG_CACHE_HOME/notcurses (~/.cache/notcurses), one
+// file per key. the key is built from TERM, TERM_PROGRAM, and
+// TERM_PROGRAM_VERSION, along with our version and the format version. the
+// terminal's XTVERSION reply can't be part of the key (we'd need the round
+// trip to learn it), so it's stored in the entry and verified instead.
+// transient responses (cursor location, palette) aren't cached. the screen
+// geometry is stored as the geometry of a single cell.
+
+#define TERMCACHE_FORMAT 1
+
+bool termcache_enabled(void){
+#ifdef __MINGW32__
+  return false;
+#else
+  const char* tc = getenv("NOTCURSES_TERMCACHE");
+  return tc && *tc && strcmp(tc, "0");
+#endif
+}
+
+// FNV-1a, only used to name the entry; the full key is checked upon load
+static uint64_t
+termcache_hash(const char* s){
+  uint64_t h = 0xcbf29ce484222325ull;
+  while(*s){
+    h ^= (unsigned char)*s++;
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+static char*
+termcache_key(void){
+  const char* vars[] = { "TERM", "TERM_PROGRAM", "TERM_PROGRAM_VERSION", };
+  fbuf f;
+  if(fbuf_init_small(&f)){
+    return NULL;
+  }
+  fbuf_printf(&f, "%d %s", TERMCACHE_FORMAT, notcurses_version());
+  for(size_t i = 0 ; i < sizeof(vars) / sizeof(*vars) ; ++i){
+    const char* v = getenv(vars[i]);
+    fbuf_printf(&f, "\x1f%s", v ? v : "");
+  }
+  // the fbuf's buffer might be mmap()ed, and our callers free() the key
+  char* key = fbuf_putc(&f, '\0') < 0 ? NULL : strdup(f.buf);
+  fbuf_free(&f);
+  return key;
+}
+
+// returns the entry's path, creating the directory if |create| is set
+static char*
+termcache_path(const char* key, bool create){
+  const char* xdg = getenv("XDG_CACHE_HOME");
+  const char* home = getenv("HOME");
+  char* dir;
+  if(xdg && *xdg){
+    if((dir = malloc(strlen(xdg) + strlen("/notcurses") + 1)) == NULL){
+      return NULL;
+    }
+    sprintf(dir, "%s", xdg);
+  }else if(home && *home){
+    if((dir = malloc(strlen(home) + strlen("/.cache/notcurses") + 1)) == NULL){
+      return NULL;
+    }
+    sprintf(dir, "%s/.cache", home);
+  }else{
+    return NULL;
+  }
+  if(create){
+    mkdir(dir, 0700); // errors are caught by mkdir() of our subdirectory
+  }
+  strcat(dir, "/notcurses");
+  if(create && mkdir(dir, 0700) && errno != EEXIST){
+    logwarn("couldn't create %s (%s)", dir, strerror(errno));
+    free(dir);
+    return NULL;
+  }
+  char* path = malloc(strlen(dir) + strlen("/termcache-") + 16 + 1);
+  if(path){
+    sprintf(path, "%s/termcache-%016llx", dir,
+            (unsigned long long)termcache_hash(key));
+  }
+  free(dir);
+  return path;
+}
+
+// strings might contain anything, including newlines and escapes, so they
+// are stored as hex. an absent string is stored as "-".
+static void
+termcache_puthex(FILE* fp, const char* name, const char* s){
+  fprintf(fp, "%s ", name);
+  if(s == NULL){
+    fputc('-', fp);
+  }else{
+    while(*s){
+      fprintf(fp, "%02x", (unsigned char)*s++);
+    }
+  }
+  fputc('\n', fp);
+}
+
+static int
+termcache_gethex(const char* hex, char** s){
+  free(*s);
+  *s = NULL;
+  if(strcmp(hex, "-") == 0){
+    return 0;
+  }
+  size_t len = strlen(hex);
+  if(len % 2){
+    return -1;
+  }
+  if((*s = malloc(len / 2 + 1)) == NULL){
+    return -1;
+  }
+  for(size_t i = 0 ; i < len / 2 ; ++i){
+    unsigned byte;
+    if(sscanf(hex + i * 2, "%2x", &byte) != 1){
+      free(*s);
+      *s = NULL;
+      return -1;
+    }
+    (*s)[i] = byte;
+  }
+  (*s)[len / 2] = '\0';
+  return 0;
+}
+
+static int
+termcache_write(FILE* fp, const char* key, const struct initial_responses* ir){
+  termcache_puthex(fp, "key", key);
+  termcache_puthex(fp, "version", ir->version);
+  termcache_puthex(fp, "hpa", ir->hpa);
+  fprintf(fp, "qterm %d\n", ir->qterm);
+  fprintf(fp, "appsync %u\n", ir->appsync_supported);
+  fprintf(fp, "kitty %u\n", ir->kitty_graphics);
+  fprintf(fp, "kbdlevel %u\n", ir->kbdlevel);
+  fprintf(fp, "bg %d %u\n", ir->got_bg, ir->bg);
+  fprintf(fp, "fg %d %u\n", ir->got_fg, ir->fg);
+  fprintf(fp, "rgb %d\n", ir->rgb);
+  fprintf(fp, "rectedits %d\n", ir->rectangular_edits);
+  fprintf(fp, "pixelmice %d\n", ir->pixelmice);
+  fprintf(fp, "sixel %d %d %d\n", ir->color_registers, ir->sixely, ir->sixelx);
+  if(ir->dimy > 0 && ir->dimx > 0){
+    fprintf(fp, "cell %d %d\n", ir->pixy / ir->dimy, ir->pixx / ir->dimx);
+  }else{
+    fprintf(fp, "cell 0 0\n");
+  }
+  return ferror(fp) ? -1 : 0;
+}
+
+// look up the entry for our current environment. if found, returns a
+// heap-allocated initial_responses as if the terminal had sent them. the
+// screen is assumed to be |rows|x|cols| (if known, otherwise 0).
+struct initial_responses* termcache_load(unsigned rows, unsigned cols){
+  char* key = termcache_key();
+  if(key == NULL){
+    return NULL;
+  }
+  char* path = termcache_path(key, false);
+  if(path == NULL){
+    free(key);
+    return NULL;
+  }
+  FILE* fp = fopen(path, "r");
+  if(fp == NULL){
+    loginfo("no termcache entry at %s", path);
+    free(path);
+    free(key);
+    return NULL;
+  }
+  struct initial_responses* ir = malloc(sizeof(*ir));
+  if(ir == NULL){
+    fclose(fp);
+    free(path);
+    free(key);
+    return NULL;
+  }
+  memset(ir, 0, sizeof(*ir));
+  ir->cursory = -1;
+  ir->cursorx = -1;
+  ir->maxpaletteread = -1;
+  bool keyok = false;
+  int cellpxy = 0, cellpxx = 0;
+  char* storedkey = NULL;
+  char line[BUFSIZ];
+  char name[32];
+  int err = 0;
+  while(!err && fgets(line, sizeof(line), fp)){
+    char* val = strchr(line, ' ');
+    if(val == NULL || (size_t)(val - line) >= sizeof(name)){
+      err = -1;
+      break;
+    }
+    memcpy(name, line, val - line);
+    name[val - line] = '\0';
+    ++val;
+    val[strcspn(val, "\n")] = '\0';
+    int a, b, c;
+    if(strcmp(name, "key") == 0){
+      err = termcache_gethex(val, &storedkey);
+      keyok = storedkey && strcmp(storedkey, key) == 0;
+    }else if(strcmp(name, "version") == 0){
+      err = termcache_gethex(val, &ir->version);
+    }else if(strcmp(name, "hpa") == 0){
+      err = termcache_gethex(val, &ir->hpa);
+    }else if(strcmp(name, "qterm") == 0 && sscanf(val, "%d", &a) == 1){
+      ir->qterm = a;
+    }else if(strcmp(name, "appsync") == 0 && sscanf(val, "%d", &a) == 1){
+      ir->appsync_supported = a;
+    }else if(strcmp(name, "kitty") == 0 && sscanf(val, "%d", &a) == 1){
+      ir->kitty_graphics = a;
+    }else if(strcmp(name, "kbdlevel") == 0 && sscanf(val, "%u", &ir->kbdlevel) == 1){
+      ;
+    }else if(strcmp(name, "bg") == 0 && sscanf(val, "%d %u", &a, &ir->bg) == 2){
+      ir->got_bg = a;
+    }else if(strcmp(name, "fg") == 0 && sscanf(val, "%d %u", &a, &ir->fg) == 2){
+      ir->got_fg = a;
+    }else if(strcmp(name, "rgb") == 0 && sscanf(val, "%d", &a) == 1){
+      ir->rgb = a;
+    }else if(strcmp(name, "rectedits") == 0 && sscanf(val, "%d", &a) == 1){
+      ir->rectangular_edits = a;
+    }else if(strcmp(name, "pixelmice") == 0 && sscanf(val, "%d", &a) == 1){
+      ir->pixelmice = a;
+    }else if(strcmp(name, "sixel") == 0 && sscanf(val, "%d %d %d", &a, &b, &c) == 3){
+      ir->color_registers = a;
+      ir->sixely = b;
+      ir->sixelx = c;
+    }else if(strcmp(name, "cell") == 0 && sscanf(val, "%d %d", &a, &b) == 2){
+      cellpxy = a;
+      cellpxx = b;
+    }else{
+      logwarn("bad termcache line in %s: %s", path, line);
+      err = -1;
+    }
+  }
+  fclose(fp);
+  free(storedkey);
+  free(key);
+  if(err || !keyok){
+    loginfo("ignoring termcache entry %s", path);
+    free(path);
+    free(ir->version);
+    free(ir->hpa);
+    free(ir);
+    return NULL;
+  }
+  if(rows && cols && cellpxy > 0 && cellpxx > 0){
+    ir->dimy = rows;
+    ir->dimx = cols;
+    ir->pixy = cellpxy * rows;
+    ir->pixx = cellpxx * cols;
+  }
+  loginfo("loaded termcache entry %s", path);
+  free(path);
+  return ir;
+}
+
+// a deep copy of |ir|, as handle_responses() consumes the one it's handed
+struct initial_responses* termcache_copy(const struct initial_responses* ir){
+  struct initial_responses* ret = malloc(sizeof(*ret));
+  if(ret == NULL){
+    return NULL;
+  }
+  memcpy(ret, ir, sizeof(*ret));
+  ret->version = ir->version ? strdup(ir->version) : NULL;
+  ret->hpa = ir->hpa ? strdup(ir->hpa) : NULL;
+  if((ir->version && !ret->version) || (ir->hpa && !ret->hpa)){
+    free(ret->version);
+    free(ret->hpa);
+    free(ret);
+    return NULL;
+  }
+  return ret;
+}
+
+// write the entry for our current environment, replacing any extant one.
+int termcache_store(const struct initial_responses* ir){
+  char* key = termcache_key();
+  if(key == NULL){
+    return -1;
+  }
+  char* path = termcache_path(key, true);
+  if(path == NULL){
+    free(key);
+    return -1;
+  }
+  // write to a temporary, and rename it over the entry, so that concurrent
+  // instances never see a partial file.
+  char* tmp = malloc(strlen(path) + 32);
+  if(tmp == NULL){
+    free(path);
+    free(key);
+    return -1;
+  }
+  sprintf(tmp, "%s.%ld", path, (long)getpid());
+  int ret = -1;
+  FILE* fp = fopen(tmp, "w");
+  if(fp){
+    ret = termcache_write(fp, key, ir);
+    if(fclose(fp)){
+      ret = -1;
+    }
+    if(ret == 0 && rename(tmp, path)){
+      ret = -1;
+    }
+    if(ret){
+      unlink(tmp);
+    }
+  }
+  if(ret){
+    logwarn("couldn't write termcache entry %s", path);
+  }else{
+    loginfo("wrote termcache entry %s", path);
+  }
+  free(tmp);
+  free(path);
+  free(key);
+  return ret;
+}
+
+static bool
+termcache_streq(const char* s1, const char* s2){
+  if(s1 == NULL || s2 == NULL){
+    return s1 == s2;
+  }
+  return strcmp(s1, s2) == 0;
+}
+
+// does the entry |cached| (as loaded) still describe the terminal which
+// sent |fresh|? transient responses are ignored.
+static bool
+termcache_matches(const struct initial_responses* cached,
+                  const struct initial_responses* fresh){
+  if(!termcache_streq(cached->version, fresh->version) ||
+     !termcache_streq(cached->hpa, fresh->hpa)){
+    return false;
+  }
+  if(cached->qterm != fresh->qterm ||
+     cached->appsync_supported != fresh->appsync_supported ||
+     cached->kitty_graphics != fresh->kitty_graphics ||
+     cached->kbdlevel != fresh->kbdlevel ||
+     cached->got_bg != fresh->got_bg || cached->bg != fresh->bg ||
+     cached->got_fg != fresh->got_fg || cached->fg != fresh->fg ||
+     cached->rgb != fresh->rgb ||
+     cached->rectangular_edits != fresh->rectangular_edits ||
+     cached->pixelmice != fresh->pixelmice ||
+     cached->color_registers != fresh->color_registers ||
+     cached->sixely != fresh->sixely || cached->sixelx != fresh->sixelx){
+    return false;
+  }
+  if(fresh->dimy > 0 && fresh->dimx > 0){
+    if(cached->dimy <= 0 || cached->dimx <= 0){
+      return fresh->pixy == 0 && fresh->pixx == 0;
+    }
+    if(cached->pixy / cached->dimy != fresh->pixy / fresh->dimy ||
+       cached->pixx / cached->dimx != fresh->pixx / fresh->dimx){
+      return false;
+    }
+  }
+  return true;
+}
+
+// check |cached| against the terminal's actual responses, if they've
+// arrived, replacing the entry on a mismatch. if they haven't arrived, we
+// learn nothing, and the entry stands. frees |cached|.
+void termcache_verify(struct inputctx* ictx, struct initial_responses* cached){
+  struct initial_responses* fresh = inputlayer_poll_responses(ictx);
+  if(fresh == NULL){
+    loginfo("terminal didn't answer in time to verify termcache");
+  }else{
+    if(termcache_matches(cached, fresh)){
+      loginfo("verified termcache entry");
+    }else{
+      logwarn("termcache entry was stale, replacing it");
+      termcache_store(fresh);
+    }
+    free(fresh->version);
+    free(fresh->hpa);
+    free(fresh);
+  }
+  free(cached->version);
+  free(cached->hpa);
+  free(cached);
+}
@@ -8,6 +8,14 @@
 #include "windows.h"
 #include "linux.h"
 
+// note when we hit a milestone of interrogation (see startup_milestone_e)
+static inline void
+startup_stamp(tinfo* ti, startup_milestone_e m){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  ti->startupns[m] = timespec_to_ns(&ts);
+}
+
 // there does not exist any true standard terminal size. with that said, we
 // need assume *something* for the case where we're not actually attached to
 // a terminal (mainly unit tests, but also daemon environments). in preference
@@ -65,11 +73,13 @@ setup_sixel_bitmaps(tinfo* ti, int fd, unsigned forcesdm, unsigned invert80){
   ti->pixel_draw = sixel_draw;
   ti->pixel_refresh = sixel_refresh;
   ti->pixel_draw_late = NULL;
+  ti->pixel_flush = NULL;
   ti->pixel_commit = NULL;
   ti->pixel_move = NULL;
   ti->pixel_scroll = NULL;
   ti->pixel_wipe = sixel_wipe;
   ti->pixel_clear_all = NULL;
+  ti->pixel_hide_all = NULL;
   ti->pixel_rebuild = sixel_rebuild;
   ti->pixel_trans_auxvec = sixel_trans_auxvec;
   ti->sprixel_scale_height = 6;
@@ -79,21 +89,73 @@ setup_sixel_bitmaps(tinfo* ti, int fd, unsigned forcesdm, unsigned invert80){
   sprite_init(ti, fd);
 }
 
+// kitty can read payloads out of POSIX shared memory (t=s) or temporary files
+// (t=t), sparing us the encoding and the tty the bandwidth, but only if it's
+// on our host. we can't know that for certain; we assume it is unless we're
+// in an SSH session. NOTCURSES_KITTY_TRANSPORT ("direct", "shm", or "file")
+// overrides this. the static protocol edits its payload in place, and thus
+// must always be direct. should the terminal reject a payload regardless,
+// kitty_transport_failed() falls back to direct.
+static kittytransport_e
+detect_kitty_transport(ncpixelimpl_e level){
+#ifndef __MINGW32__
+  if(level < NCPIXEL_KITTY_ANIMATED){
+    return KITTY_TRANSPORT_DIRECT;
+  }
+  const char* kt = getenv("NOTCURSES_KITTY_TRANSPORT");
+  if(kt){
+    if(strcmp(kt, "direct") == 0){
+      return KITTY_TRANSPORT_DIRECT;
+    }else if(strcmp(kt, "shm") == 0){
+      return KITTY_TRANSPORT_SHM;
+    }else if(strcmp(kt, "file") == 0){
+      return KITTY_TRANSPORT_FILE;
+    }
+    logwarn("ignoring invalid NOTCURSES_KITTY_TRANSPORT: %s", kt);
+  }
+  if(getenv("SSH_CONNECTION") || getenv("SSH_CLIENT") || getenv("SSH_TTY")){
+    loginfo("remote session; transmitting kitty graphics directly");
+    return KITTY_TRANSPORT_DIRECT;
+  }
+  return KITTY_TRANSPORT_SHM;
+#else
+  (void)level;
+  return KITTY_TRANSPORT_DIRECT;
+#endif
+}
+
 // kitty 0.19.3 didn't have C=1, and thus needs sixel_maxy_pristine. it also
 // lacked animation, and must thus redraw the complete image every time it
-// changes. requires the older interface.
+// changes. requires the older interface. with 0.28.0's Unicode placeholders,
+// the graphic is encoded as with NCPIXEL_KITTY_ANIMATED, but shown through
+// cells of the plane rather than a real placement.
 static inline void
 setup_kitty_bitmaps(tinfo* ti, int fd, ncpixelimpl_e level){
   ti->pixel_scrub = kitty_scrub;
   ti->pixel_remove = kitty_remove;
   ti->pixel_draw = kitty_draw;
   ti->pixel_draw_late = NULL;
+  ti->pixel_flush = NULL;
   ti->pixel_refresh = NULL;
   ti->pixel_commit = kitty_commit;
   ti->pixel_move = kitty_move;
   ti->pixel_scroll = NULL;
   ti->pixel_clear_all = kitty_clear_all;
-  if(level == NCPIXEL_KITTY_STATIC){
+  ti->pixel_hide_all = kitty_hide_all;
+  if(level == NCPIXEL_KITTY_PLACEHOLDER){
+    // placeholder cells are painted as text, so nothing ever wipes or
+    // rebuilds the graphic, nor does it need moving or scrubbing.
+    ti->pixel_wipe = kitty_wipe_animation;
+    ti->pixel_rebuild = kitty_rebuild_animation;
+    ti->pixel_commit = kitty_commit_placeholder;
+    ti->pixel_move = kitty_move_placeholder;
+    ti->pixel_scrub = kitty_scrub_placeholder;
+    // another pile's cells replace the placeholders, hiding the graphic
+    ti->pixel_hide_all = NULL;
+    ti->sixel_maxy_pristine = 0;
+    set_pixel_blitter(kitty_blit_placeholder);
+    ti->pixel_implementation = NCPIXEL_KITTY_PLACEHOLDER;
+  }else if(level == NCPIXEL_KITTY_STATIC){
     ti->pixel_wipe = kitty_wipe;
     ti->pixel_trans_auxvec = kitty_trans_auxvec;
     ti->pixel_rebuild = kitty_rebuild;
@@ -115,6 +177,9 @@ setup_kitty_bitmaps(tinfo* ti, int fd, ncpixelimpl_e level){
       ti->pixel_implementation = NCPIXEL_KITTY_SELFREF;
     }
   }
+  ti->kittytransport = detect_kitty_transport(level);
+  ti->pixel_init = kitty_init;
+  ti->pixel_cleanup = kitty_cleanup;
   sprite_init(ti, fd);
 }
 
@@ -125,18 +190,34 @@ setup_fbcon_bitmaps(tinfo* ti, int fd){
   ti->pixel_remove = NULL;
   ti->pixel_draw = NULL;
   ti->pixel_draw_late = fbcon_draw;
+  ti->pixel_flush = fbcon_flush;
   ti->pixel_commit = NULL;
   ti->pixel_refresh = NULL;
   ti->pixel_move = NULL;
   ti->pixel_scroll = fbcon_scroll;
   ti->pixel_clear_all = NULL;
+  ti->pixel_hide_all = NULL;
   ti->pixel_rebuild = fbcon_rebuild;
   ti->pixel_wipe = fbcon_wipe;
   ti->pixel_trans_auxvec = kitty_trans_auxvec;
+  ti->pixel_init = fbcon_init;
+  ti->pixel_cleanup = fbcon_cleanup;
   set_pixel_blitter(fbcon_blit);
   ti->pixel_implementation = NCPIXEL_LINUXFB;
   sprite_init(ti, fd);
 }
+
+// the DRM overlay shares the framebuffer console's glyphs and drawing,
+// writing to its planes rather than to the console's framebuffer.
+static inline void
+setup_drm_bitmaps(tinfo* ti){
+  setup_fbcon_bitmaps(ti, -1);
+  ti->pixel_flush = drm_flush;
+  ti->pixel_wipe = drm_wipe;
+  ti->pixel_scrub = drm_scrub;
+  ti->pixel_cleanup = drm_cleanup;
+  ti->pixel_implementation = NCPIXEL_LINUXDRM;
+}
 #endif
 
 static bool
@@ -161,6 +242,16 @@ query_rgb(void){
 }
 
 void free_terminfo_cache(tinfo* ti){
+  if(ti->termcache){
+    if(ti->ictx){
+      termcache_verify(ti->ictx, ti->termcache);
+    }else{
+      free(ti->termcache->version);
+      free(ti->termcache->hpa);
+      free(ti->termcache);
+    }
+    ti->termcache = NULL;
+  }
   stop_inputlayer(ti);
   loginfo("brought down input layer");
   if(ti->pixel_cleanup){
@@ -168,6 +259,8 @@ void free_terminfo_cache(tinfo* ti){
   }
   free(ti->termversion);
   free(ti->esctable);
+  free(ti->palescs);
+  free(ti->rgbmap);
 #ifdef __linux__
   if(ti->linux_fb_fd >= 0){
     close(ti->linux_fb_fd);
@@ -710,7 +803,12 @@ apply_kitty_heuristics(tinfo* ti, size_t* tablelen, size_t* tableused){
   /*if(compare_versions(ti->termversion, "0.22.1") >= 0){
     setup_kitty_bitmaps(ti, ti->ttyfd, NCPIXEL_KITTY_SELFREF);
   }else*/ if(compare_versions(ti->termversion, "0.20.0") >= 0){
-    setup_kitty_bitmaps(ti, ti->ttyfd, NCPIXEL_KITTY_ANIMATED);
+    // Unicode placeholders (and U=1 virtual placements) arrived in 0.28.0
+    if(compare_versions(ti->termversion, "0.28.0") >= 0){
+      setup_kitty_bitmaps(ti, ti->ttyfd, NCPIXEL_KITTY_PLACEHOLDER);
+    }else{
+      setup_kitty_bitmaps(ti, ti->ttyfd, NCPIXEL_KITTY_ANIMATED);
+    }
     // XTPOPCOLORS didn't reliably work until a bugfix late in 0.23.1 (see
     // https://github.com/kovidgoyal/kitty/issues/4351), so reprogram the
     // font directly until we exceed that version.
@@ -890,7 +988,10 @@ apply_linux_heuristics(tinfo* ti, unsigned nonewfonts){
   if(uname(&un) == 0){
     ti->termversion = strdup(un.release);
   }
-  if(is_linux_framebuffer(ti)){
+  if(is_linux_drm(ti)){
+    tname = "FBcon";
+    setup_drm_bitmaps(ti);
+  }else if(is_linux_framebuffer(ti)){
     tname = "FBcon";
     setup_fbcon_bitmaps(ti, ti->linux_fb_fd);
   }else{
@@ -899,8 +1000,10 @@ apply_linux_heuristics(tinfo* ti, unsigned nonewfonts){
   ti->caps.halfblocks = false;
   ti->caps.braille = false; // no caps.braille, no caps.sextants in linux console
   if(ti->ttyfd >= 0){
+    startup_stamp(ti, STARTUP_FONTBEGIN);
     reprogram_console_font(ti, nonewfonts, &ti->caps.halfblocks,
                            &ti->caps.quadrants);
+    startup_stamp(ti, STARTUP_FONTEND);
   }
   // assume no useful unicode drawing unless we're positively sure
 #else
@@ -1049,6 +1152,101 @@ build_supported_styles(tinfo* ti){
   }
 }
 
+// moves are emitted for nearly every damaged span, and tiparm() interprets
+// the terminfo string each time. measure each movement once for the cost
+// model, and recognize the standard forms, so that the rasterizer can write
+// them directly (see goto_location()). the same goes for REP and ECH, which
+// we only use when we know exactly what they'll emit.
+static void
+detect_ansi_escapes(tinfo* ti){
+  static const struct {
+    move_e move;
+    escape_e esc;
+    const char* ansi;  // the standard form, with 1-based absolute parameters
+    char final;
+  } moves[] = {
+    { MOVE_CUP, ESCAPE_CUP, "\x1b[%i%p1%d;%p2%dH", 'H', },
+    { MOVE_HPA, ESCAPE_HPA, "\x1b[%i%p1%dG", 'G', },
+    { MOVE_HPA, ESCAPE_HPA, "\x1b[%i%p1%d`", '`', },
+    { MOVE_VPA, ESCAPE_VPA, "\x1b[%i%p1%dd", 'd', },
+    { MOVE_CUF, ESCAPE_CUF, "\x1b[%p1%dC", 'C', },
+    { MOVE_CUB, ESCAPE_CUB, "\x1b[%p1%dD", 'D', },
+    { MOVE_CUD, ESCAPE_CUD, "\x1b[%p1%dB", 'B', },
+    { MOVE_CUU, ESCAPE_CUU, "\x1b[%p1%dA", 'A', },
+  };
+  memset(ti->movelen, 0, sizeof(ti->movelen));
+  memset(ti->movefinal, 0, sizeof(ti->movefinal));
+  for(size_t i = 0 ; i < sizeof(moves) / sizeof(*moves) ; ++i){
+    const char* esc = get_escape(ti, moves[i].esc);
+    if(esc == NULL){
+      continue;
+    }
+    if(strcmp(esc, moves[i].ansi) == 0){
+      ti->movefinal[moves[i].move] = moves[i].final;
+    }
+    if(ti->movelen[moves[i].move] == 0){
+      // absolute moves are measured to 0 (1 with %i), relative moves by 1
+      const int p = moves[i].move <= MOVE_VPA ? 0 : 1;
+      const char* s = tiparm(esc, p, p);
+      size_t len = s ? strlen(s) : 0;
+      ti->movelen[moves[i].move] = len > UCHAR_MAX ? UCHAR_MAX : len;
+    }
+  }
+  const char* rep = get_escape(ti, ESCAPE_REP);
+  ti->ansirep = rep && strcmp(rep, "%p1%c\x1b[%p2%{1}%-%db") == 0;
+  const char* ech = get_escape(ti, ESCAPE_ECH);
+  ti->ansiech = ech && strcmp(ech, "\x1b[%p1%dX") == 0;
+}
+
+// without RGB, colors are emitted as palette indices, once per color change
+// on the raster path. expand setaf/setab for each index up front, so that
+// we needn't take tiparm_lock and reinterpret the terminfo string each time.
+// failure is not fatal; we just go without.
+static void
+build_palette_escapes(tinfo* ti){
+  free(ti->palescs);
+  ti->palescs = NULL;
+  ti->palesccount = 0;
+  const char* setaf = get_escape(ti, ESCAPE_SETAF);
+  const char* setab = get_escape(ti, ESCAPE_SETAB);
+  if(ti->caps.rgb || setaf == NULL || setab == NULL || ti->caps.colors < 8){
+    return;
+  }
+  const unsigned count = ti->caps.colors < NCPALETTESIZE ? ti->caps.colors : NCPALETTESIZE;
+  size_t len = 0;
+  size_t size = 0;
+  char* buf = NULL;
+  for(unsigned i = 0 ; i < count ; ++i){
+    for(unsigned bg = 0 ; bg < 2 ; ++bg){
+      const char* s = tiparm(bg ? setab : setaf, i);
+      if(s == NULL){
+        free(buf);
+        return;
+      }
+      const size_t slen = strlen(s) + 1;
+      if(len + slen > UINT16_MAX){
+        free(buf);
+        return;
+      }
+      if(len + slen > size){
+        size_t nsize = size ? size * 2 : 4096;
+        char* tmp = realloc(buf, nsize);
+        if(tmp == NULL){
+          free(buf);
+          return;
+        }
+        buf = tmp;
+        size = nsize;
+      }
+      memcpy(buf + len, s, slen);
+      ti->paloffs[bg][i] = len;
+      len += slen;
+    }
+  }
+  ti->palescs = buf;
+  ti->palesccount = count;
+}
+
 #ifdef __APPLE__
 // Terminal.App is a wretched piece of shit that can't handle even the most
 // basic of queries, instead bleeding them through to stdout like a great
@@ -1132,6 +1330,9 @@ do_terminfo_lookups(tinfo *ti, size_t* tablelen, size_t* tableused){
     { ESCAPE_OC, "oc", },
     { ESCAPE_RMKX, "rmkx", },
     { ESCAPE_INITC, "initc", },
+    { ESCAPE_REP, "rep", },
+    { ESCAPE_ECH, "ech", },
+    { ESCAPE_CSR, "csr", },
     { ESCAPE_MAX, NULL, },
   };
   for(typeof(*strtdescs)* strtdesc = strtdescs ; strtdesc->esc < ESCAPE_MAX ; ++strtdesc){
@@ -1147,13 +1348,44 @@ do_terminfo_lookups(tinfo *ti, size_t* tablelen, size_t* tableused){
   return 0;
 }
 
+// get the responses to our initial queries, either from the terminal or
+// (if enabled and present) from the termcache. in the latter case, a copy
+// is kept so that free_terminfo_cache() can verify the entry.
+static struct initial_responses*
+get_responses(tinfo* ti){
+  if(termcache_enabled()){
+    struct winsize ws;
+    unsigned rows = 0, cols = 0;
+    if(tiocgwinsz(ti->ttyfd, &ws) == 0){
+      rows = ws.ws_row;
+      cols = ws.ws_col;
+    }
+    struct initial_responses* cached = termcache_load(rows, cols);
+    if(cached){
+      struct initial_responses* iresp = termcache_copy(cached);
+      if(iresp){
+        ti->termcache = cached;
+        return iresp;
+      }
+      free(cached->version);
+      free(cached->hpa);
+      free(cached);
+    }
+  }
+  struct initial_responses* iresp = inputlayer_get_responses(ti->ictx);
+  if(iresp && termcache_enabled()){
+    termcache_store(iresp);
+  }
+  return iresp;
+}
+
 // handle any terminal query responses.
 static int
 handle_responses(tinfo* ti, size_t* tablelen, size_t* tableused,
                  int* cursor_y, int* cursor_x, unsigned draininput,
                  unsigned* kitty_graphics){
   struct initial_responses* iresp;
-  if((iresp = inputlayer_get_responses(ti->ictx)) == NULL){
+  if((iresp = get_responses(ti)) == NULL){
     goto err;
   }
   if(ti->termversion){
@@ -1161,6 +1393,8 @@ handle_responses(tinfo* ti, size_t* tablelen, size_t* tableused,
   }else{
     ti->termversion = iresp->version; // takes ownership
   }
+  memcpy(ti->replies, iresp->replies, sizeof(*iresp->replies) * iresp->replycount);
+  ti->replycount = iresp->replycount;
   if(iresp->appsync_supported){
     if(add_appsync_escapes_sm(ti, tablelen, tableused)){
       free(iresp->hpa);
@@ -1244,6 +1478,84 @@ err:
   return -1;
 }
 
+// release everything acquired by a partial interrogation
+// escapes and properties which follow from those found in terminfo. call
+// following do_terminfo_lookups(), with the terminfo entry loaded.
+static int
+derive_terminfo_escapes(tinfo* ti){
+  if(tigetflag("bce") > 0){
+    ti->bce = true;
+  }
+  if(ti->caps.colors > 1){
+    const char* initc = get_escape(ti, ESCAPE_INITC);
+    if(initc){
+      ti->caps.can_change_colors = true;
+    }
+  }else{ // disable initc if there's no color support
+    ti->escindices[ESCAPE_INITC] = 0;
+  }
+  if(get_escape(ti, ESCAPE_CIVIS) == NULL){
+    char* chts;
+    if(terminfostr(&chts, "chts") == 0){
+      if(grow_esc_table(ti, chts, ESCAPE_CIVIS, &ti->esctablelen, &ti->esctableused)){
+        return -1;
+      }
+    }
+  }
+  if(get_escape(ti, ESCAPE_BOLD)){
+    if(grow_esc_table(ti, "\e[22m", ESCAPE_NOBOLD, &ti->esctablelen, &ti->esctableused)){
+      return -1;
+    }
+  }
+  // if op is defined as ansi 39 + ansi 49, make the split definitions
+  // available. this ought be asserted by extension capability "ax", but
+  // no terminal i've found seems to do so. =[
+  const char* op = get_escape(ti, ESCAPE_OP);
+  if(op && strcmp(op, "\x1b[39;49m") == 0){
+    if(grow_esc_table(ti, "\x1b[39m", ESCAPE_FGOP, &ti->esctablelen, &ti->esctableused) ||
+       grow_esc_table(ti, "\x1b[49m", ESCAPE_BGOP, &ti->esctablelen, &ti->esctableused)){
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void
+interrogation_failed(tinfo* ti){
+  ti->interrogating = false;
+  if(ti->ttyfd >= 0){
+    // if we haven't yet received a reply confirming lack of kitty keyboard
+    // support, it'll be UINT_MAX, and we ought try to pop (in case we died
+    // following the keyboard set, but before confirming support).
+    if(ti->kbdlevel){
+      tty_emit(KKEYBOARD_POP, ti->ttyfd);
+    }
+    tty_emit(RMCUP, ti->ttyfd);
+  }
+  if(ti->tpreserved){
+    (void)tcsetattr(ti->ttyfd, TCSANOW, ti->tpreserved);
+    free(ti->tpreserved);
+    ti->tpreserved = NULL;
+  }
+  if(ti->termcache){
+    free(ti->termcache->version);
+    free(ti->termcache->hpa);
+    free(ti->termcache);
+    ti->termcache = NULL;
+  }
+  stop_inputlayer(ti);
+  free(ti->esctable);
+  ti->esctable = NULL;
+  free(ti->palescs);
+  ti->palescs = NULL;
+  ti->palesccount = 0;
+  free(ti->termversion);
+  ti->termversion = NULL;
+  del_curterm(cur_term);
+  close(ti->ttyfd);
+  ti->ttyfd = -1;
+}
+
 // if |termtype| is not NULL, it is used to look up the terminfo database entry
 // via setupterm(). the value of the TERM environment variable is otherwise
 // (implicitly) used. some details are not exposed via terminfo, and we must
@@ -1253,23 +1565,20 @@ err:
 // Device Attributes, allowing us to get a negative response if our queries
 // aren't supported by the terminal. we fire it off early because we have a
 // full round trip before getting the reply, which is likely to pace init.
-int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
-                         unsigned noaltscreen, unsigned nocbreak, unsigned nonewfonts,
-                         int* cursor_y, int* cursor_x, ncsharedstats* stats,
-                         int lmargin, int tmargin, int rmargin, int bmargin,
-                         unsigned draininput){
+// everything up through the input layer's launch is independent of the
+// replies; the caller can do more such work before calling _finish().
+int interrogate_terminfo_start(tinfo* ti, FILE* out, unsigned utf8,
+                               unsigned noaltscreen, ncsharedstats* stats,
+                               int lmargin, int tmargin, int rmargin, int bmargin,
+                               unsigned draininput, unsigned coalesce){
   // if a specified termtype was provided in the notcurses_options, it was
   // loaded into our environment at TERM.
   const char* termtype = getenv("TERM");
-  int foolcursor_x, foolcursor_y;
-  if(!cursor_x){
-    cursor_x = &foolcursor_x;
-  }
-  if(!cursor_y){
-    cursor_y = &foolcursor_y;
-  }
-  *cursor_x = *cursor_y = -1;
+  memset(ti->startupns, 0, sizeof(ti->startupns));
+  ti->replycount = 0;
+  startup_stamp(ti, STARTUP_BEGIN);
   ti->sixelengine = NULL;
+  ti->kittyengine = NULL;
   ti->bg_collides_default = 0xfe000000;
   ti->fg_default = 0xff000000;
   ti->kbdlevel = UINT_MAX; // see comment in tinfo definition
@@ -1278,16 +1587,15 @@ int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
   // we don't need a controlling tty for everything we do; allow a failure here
   ti->ttyfd = get_tty_fd(out);
   ti->gpmfd = -1;
-  size_t tablelen = 0;
-  size_t tableused = 0;
-  const char* tname = NULL;
+  ti->esctablelen = 0;
+  ti->esctableused = 0;
 #ifdef __APPLE__
   ti->qterm = macos_early_matches();
 #elif defined(__MINGW32__)
   if(termtype){
     logwarn("termtype (%s) ignored on windows", termtype);
   }
-  if(prepare_windows_terminal(ti, &tablelen, &tableused)){
+  if(prepare_windows_terminal(ti, &ti->esctablelen, &ti->esctableused)){
     logpanic("failed opening Windows ConPTY");
     return -1;
   }
@@ -1323,6 +1631,7 @@ int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
     if(send_initial_queries(ti, minimal, noaltscreen, draininput)){
       goto err;
     }
+    startup_stamp(ti, STARTUP_QUERIES);
   }
 #ifndef __MINGW32__
   // windows doesn't really have a concept of terminfo. you might ssh into other
@@ -1333,8 +1642,8 @@ int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
              termerr, termtype ? termtype : "");
     goto err;
   }
-  tname = termname(); // longname() is also available
 #endif
+  startup_stamp(ti, STARTUP_TERMINFO);
   int linesigs_enabled = 1;
   if(ti->tpreserved){
     if(!(ti->tpreserved->c_lflag & ISIG)){
@@ -1342,9 +1651,10 @@ int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
     }
   }
   if(init_inputlayer(ti, stdin, lmargin, tmargin, rmargin, bmargin,
-                     stats, draininput, linesigs_enabled)){
+                     stats, draininput, linesigs_enabled, coalesce)){
     goto err;
   }
+  startup_stamp(ti, STARTUP_INPUT);
   ti->sprixel_scale_height = 1;
   get_default_geometry(ti);
   ti->caps.utf8 = utf8;
@@ -1360,7 +1670,7 @@ int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
     }
     ti->caps.rgb = query_rgb(); // independent of colors
   }
-  if(do_terminfo_lookups(ti, &tablelen, &tableused)){
+  if(do_terminfo_lookups(ti, &ti->esctablelen, &ti->esctableused)){
     goto err;
   }
   if(ti->ttyfd >= 0){
@@ -1373,21 +1683,10 @@ int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
       }
     }
   }
-  if(tigetflag("bce") > 0){
-    ti->bce = true;
-  }
-  if(ti->caps.colors > 1){
-    const char* initc = get_escape(ti, ESCAPE_INITC);
-    if(initc){
-      ti->caps.can_change_colors = true;
-    }
-  }else{ // disable initc if there's no color support
-    ti->escindices[ESCAPE_INITC] = 0;
-  }
   // neither of these is supported on e.g. the "linux" virtual console.
   if(!noaltscreen){
-    if(init_terminfo_esc(ti, "smcup", ESCAPE_SMCUP, &tablelen, &tableused) ||
-       init_terminfo_esc(ti, "rmcup", ESCAPE_RMCUP, &tablelen, &tableused)){
+    if(init_terminfo_esc(ti, "smcup", ESCAPE_SMCUP, &ti->esctablelen, &ti->esctableused) ||
+       init_terminfo_esc(ti, "rmcup", ESCAPE_RMCUP, &ti->esctablelen, &ti->esctableused)){
       goto err;
     }
     const char* smcup = get_escape(ti, ESCAPE_SMCUP);
@@ -1403,35 +1702,43 @@ int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
     ti->escindices[ESCAPE_SMCUP] = 0;
     ti->escindices[ESCAPE_RMCUP] = 0;
   }
-  if(get_escape(ti, ESCAPE_CIVIS) == NULL){
-    char* chts;
-    if(terminfostr(&chts, "chts") == 0){
-      if(grow_esc_table(ti, chts, ESCAPE_CIVIS, &tablelen, &tableused)){
-        goto err;
-      }
-    }
+  if(derive_terminfo_escapes(ti)){
+    goto err;
   }
-  if(get_escape(ti, ESCAPE_BOLD)){
-    if(grow_esc_table(ti, "\e[22m", ESCAPE_NOBOLD, &tablelen, &tableused)){
-      goto err;
-    }
+  startup_stamp(ti, STARTUP_LOOKUPS);
+  ti->interrogating = true;
+  return 0;
+
+err:
+  interrogation_failed(ti);
+  return -1;
+}
+
+// wait on the replies to the queries sent by interrogate_terminfo_start(),
+// and apply them along with our terminal heuristics.
+int interrogate_terminfo_finish(tinfo* ti, unsigned nocbreak, unsigned nonewfonts,
+                                int* cursor_y, int* cursor_x, unsigned draininput){
+  int foolcursor_x, foolcursor_y;
+  if(!cursor_x){
+    cursor_x = &foolcursor_x;
   }
-  // if op is defined as ansi 39 + ansi 49, make the split definitions
-  // available. this ought be asserted by extension capability "ax", but
-  // no terminal i've found seems to do so. =[
-  const char* op = get_escape(ti, ESCAPE_OP);
-  if(op && strcmp(op, "\x1b[39;49m") == 0){
-    if(grow_esc_table(ti, "\x1b[39m", ESCAPE_FGOP, &tablelen, &tableused) ||
-       grow_esc_table(ti, "\x1b[49m", ESCAPE_BGOP, &tablelen, &tableused)){
-      goto err;
-    }
+  if(!cursor_y){
+    cursor_y = &foolcursor_y;
   }
+  *cursor_x = *cursor_y = -1;
+  ti->interrogating = false;
+  startup_stamp(ti, STARTUP_AWAIT);
+  const char* tname = NULL;
+#ifndef __MINGW32__
+  tname = termname(); // longname() is also available
+#endif
   unsigned kitty_graphics = 0;
   if(ti->ttyfd >= 0){
-    if(handle_responses(ti, &tablelen, &tableused, cursor_y, cursor_x,
+    if(handle_responses(ti, &ti->esctablelen, &ti->esctableused, cursor_y, cursor_x,
                         draininput, &kitty_graphics)){
       goto err;
     }
+    startup_stamp(ti, STARTUP_REPLIES);
     if(nocbreak){
       // FIXME do this in input later, upon signaling completion?
       if(tcsetattr(ti->ttyfd, TCSANOW, ti->tpreserved)){
@@ -1443,22 +1750,24 @@ int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
   }
   // now look up any terminfo elements we might not have received via requests
   if(ti->escindices[ESCAPE_HPA] == 0){
-    if(init_terminfo_esc(ti, "hpa", ESCAPE_HPA, &tablelen, &tableused)){
+    if(init_terminfo_esc(ti, "hpa", ESCAPE_HPA, &ti->esctablelen, &ti->esctableused)){
       goto err;
     }
   }
   if(*cursor_x >= 0 && *cursor_y >= 0){
-    if(add_u7_escape(ti, &tablelen, &tableused)){
+    if(add_u7_escape(ti, &ti->esctablelen, &ti->esctableused)){
       goto err;
     }
   }
   bool forcesdm = false;
   bool invertsixel = false;
-  if(apply_term_heuristics(ti, tname, ti->qterm, &tablelen, &tableused,
+  if(apply_term_heuristics(ti, tname, ti->qterm, &ti->esctablelen, &ti->esctableused,
                            &forcesdm, &invertsixel, nonewfonts)){
     goto err;
   }
   build_supported_styles(ti);
+  detect_ansi_escapes(ti);
+  build_palette_escapes(ti);
   if(ti->pixel_draw == NULL && ti->pixel_draw_late == NULL){
     // color_registers was only assigned if kitty_graphics were unavailable
     if(ti->color_registers > 0){
@@ -1468,32 +1777,27 @@ int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
       setup_kitty_bitmaps(ti, ti->ttyfd, NCPIXEL_KITTY_STATIC);
     }
   }
+  startup_stamp(ti, STARTUP_DONE);
   return 0;
 
 err:
-  if(ti->ttyfd >= 0){
-    // if we haven't yet received a reply confirming lack of kitty keyboard
-    // support, it'll be UINT_MAX, and we ought try to pop (in case we died
-    // following the keyboard set, but before confirming support).
-    if(ti->kbdlevel){
-      tty_emit(KKEYBOARD_POP, ti->ttyfd);
-    }
-    tty_emit(RMCUP, ti->ttyfd);
-  }
-  if(ti->tpreserved){
-    (void)tcsetattr(ti->ttyfd, TCSANOW, ti->tpreserved);
-    free(ti->tpreserved);
-    ti->tpreserved = NULL;
-  }
-  stop_inputlayer(ti);
-  free(ti->esctable);
-  free(ti->termversion);
-  del_curterm(cur_term);
-  close(ti->ttyfd);
-  ti->ttyfd = -1;
+  interrogation_failed(ti);
   return -1;
 }
 
+int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
+                         unsigned noaltscreen, unsigned nocbreak, unsigned nonewfonts,
+                         int* cursor_y, int* cursor_x, ncsharedstats* stats,
+                         int lmargin, int tmargin, int rmargin, int bmargin,
+                         unsigned draininput, unsigned coalesce){
+  if(interrogate_terminfo_start(ti, out, utf8, noaltscreen, stats, lmargin,
+                                tmargin, rmargin, bmargin, draininput, coalesce)){
+    return -1;
+  }
+  return interrogate_terminfo_finish(ti, nocbreak, nonewfonts, cursor_y,
+                                     cursor_x, draininput);
+}
+
 char* termdesc_longterm(const tinfo* ti){
   size_t tlen = strlen(ti->termname) + 1;
   size_t slen = tlen;
@@ -1613,3 +1917,130 @@ int putenv_term(const char* tname){
   free(buf);
   return c;
 }
+
+// terminal descriptions built from the terminfo database alone, shared among
+// all ncrasterizers using a given terminal type.
+typedef struct termdesc_entry {
+  struct termdesc_entry* next;
+  char* termtype;
+  bool rgb, utf8;
+  unsigned refs;
+  tinfo ti;
+} termdesc_entry;
+
+static pthread_mutex_t termdesc_lock = PTHREAD_MUTEX_INITIALIZER;
+static termdesc_entry* termdescs;
+
+// describe |termtype| using only its terminfo entry. no terminal is queried,
+// so no heuristics are applied, and there's no bitmap support. loading the
+// entry replaces the context's own (cur_term) until we're done, so tiparm()
+// must not run meanwhile; we hold tiparm_lock throughout.
+static int
+describe_terminfo(tinfo* ti, const char* termtype, bool rgb, bool utf8){
+#ifdef __MINGW32__
+  (void)ti; (void)termtype; (void)rgb; (void)utf8;
+  logerror("terminfo descriptions are unavailable on windows");
+  return -1;
+#else
+  memset(ti, 0, sizeof(*ti));
+  ti->ttyfd = -1;
+  ti->gpmfd = -1;
+#ifdef __linux__
+  ti->linux_fb_fd = -1;
+  ti->linux_fbuffer = MAP_FAILED;
+#endif
+  ti->bg_collides_default = 0xfe000000;
+  ti->fg_default = 0xff000000;
+  ti->maxpaletteread = -1;
+  ti->qterm = TERMINAL_UNKNOWN;
+  ti->sprixel_scale_height = 1;
+  ti->caps.utf8 = utf8;
+  int ret = -1;
+  pthread_mutex_lock(&tiparm_lock);
+  TERMINAL* saved = cur_term;
+  int termerr;
+  if(setupterm(termtype, -1, &termerr) != OK){
+    logerror("terminfo error %d for [%s]", termerr, termtype);
+    set_curterm(saved);
+    pthread_mutex_unlock(&tiparm_lock);
+    return -1;
+  }
+  TERMINAL* mine = cur_term;
+  int colors = tigetnum("colors");
+  ti->caps.colors = colors > 0 ? colors : 1;
+  ti->caps.rgb = rgb || tigetflag("RGB") > 0 || tigetflag("Tc") > 0;
+  if(do_terminfo_lookups(ti, &ti->esctablelen, &ti->esctableused) == 0){
+    if(init_terminfo_esc(ti, "hpa", ESCAPE_HPA, &ti->esctablelen, &ti->esctableused) == 0){
+      if(derive_terminfo_escapes(ti) == 0){
+        build_supported_styles(ti);
+        detect_ansi_escapes(ti);
+        build_palette_escapes(ti);
+        ret = 0;
+      }
+    }
+  }
+  set_curterm(saved);
+  del_curterm(mine);
+  pthread_mutex_unlock(&tiparm_lock);
+  if(ret){
+    free(ti->esctable);
+    ti->esctable = NULL;
+  }
+  return ret;
+#endif
+}
+
+const tinfo* termdesc_acquire(const char* termtype, bool rgb, bool utf8){
+  const tinfo* ret = NULL;
+  pthread_mutex_lock(&termdesc_lock);
+  termdesc_entry* e;
+  for(e = termdescs ; e ; e = e->next){
+    if(e->rgb == rgb && e->utf8 == utf8 && strcmp(e->termtype, termtype) == 0){
+      break;
+    }
+  }
+  if(e == NULL){
+    if((e = malloc(sizeof(*e))) == NULL){
+      goto done;
+    }
+    if((e->termtype = strdup(termtype)) == NULL){
+      free(e);
+      goto done;
+    }
+    if(describe_terminfo(&e->ti, termtype, rgb, utf8)){
+      free(e->termtype);
+      free(e);
+      goto done;
+    }
+    e->rgb = rgb;
+    e->utf8 = utf8;
+    e->refs = 0;
+    e->next = termdescs;
+    termdescs = e;
+    loginfo("described terminal type %s", termtype);
+  }
+  ++e->refs;
+  ret = &e->ti;
+
+done:
+  pthread_mutex_unlock(&termdesc_lock);
+  return ret;
+}
+
+void termdesc_release(const tinfo* ti){
+  pthread_mutex_lock(&termdesc_lock);
+  for(termdesc_entry** pe = &termdescs ; *pe ; pe = &(*pe)->next){
+    termdesc_entry* e = *pe;
+    if(&e->ti == ti){
+      if(--e->refs == 0){
+        *pe = e->next;
+        free(e->ti.esctable);
+        free(e->ti.palescs);
+        free(e->termtype);
+        free(e);
+      }
+      break;
+    }
+  }
+  pthread_mutex_unlock(&termdesc_lock);
+}
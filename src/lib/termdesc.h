@@ -87,9 +87,33 @@ typedef enum {
   ESCAPE_SAVECOLORS,    // XTPUSHCOLORS (push palette/fg/bg)
   ESCAPE_RESTORECOLORS, // XTPOPCOLORS  (pop palette/fg/bg)
   ESCAPE_DECERA,   // rectangular erase
+  ESCAPE_REP,     // "rep" repeat a character n times
+  ESCAPE_ECH,     // "ech" erase n characters
+  ESCAPE_CSR,     // "csr" change the scrolling region
   ESCAPE_MAX
 } escape_e;
 
+// the cursor movements weighed against one another by goto_location().
+// how kitty payloads reach the terminal. direct transmission (base64 within
+// the escape itself) always works; the others require that the terminal be
+// able to see our shared memory or filesystem, i.e. that it's on our host.
+typedef enum {
+  KITTY_TRANSPORT_DIRECT, // t=d
+  KITTY_TRANSPORT_SHM,    // t=s, POSIX shared memory objects
+  KITTY_TRANSPORT_FILE,   // t=t, temporary files deleted by the terminal
+} kittytransport_e;
+
+typedef enum {
+  MOVE_CUP,       // absolute y and x
+  MOVE_HPA,       // absolute x
+  MOVE_VPA,       // absolute y
+  MOVE_CUF,       // n cells right
+  MOVE_CUB,       // n cells left
+  MOVE_CUD,       // n cells down
+  MOVE_CUU,       // n cells up
+  MOVE_MAX
+} move_e;
+
 // when we read a cursor report, we put it on the queue for internal
 // processing. this is necessary since it can be arbitrarily interleaved with
 // other input when stdin is connected to our terminal. these are already
@@ -104,10 +128,31 @@ typedef struct cursorreport {
 // heuristics based off terminal interrogation or the TERM environment
 // variable. some are determined via ioctl(2). treat all of them as if they
 // can change over the program's life (don't cache them locally).
+// milestones of terminal interrogation, recorded as CLOCK_MONOTONIC ns so
+// that notcurses-info can break down the latency of notcurses_init().
+typedef enum {
+  STARTUP_BEGIN,      // interrogate_terminfo_start() entered
+  STARTUP_QUERIES,    // initial queries written to the terminal
+  STARTUP_TERMINFO,   // terminfo database loaded
+  STARTUP_INPUT,      // input layer launched
+  STARTUP_LOOKUPS,    // terminfo lookups complete
+  STARTUP_AWAIT,      // interrogate_terminfo_finish() begins awaiting replies
+  STARTUP_REPLIES,    // replies in hand
+  STARTUP_FONTBEGIN,  // console font reprogramming begun (linux console)
+  STARTUP_FONTEND,    // console font reprogramming done
+  STARTUP_DONE,       // heuristics and bitmap setup applied
+  STARTUP_MAX
+} startup_milestone_e;
+
 typedef struct tinfo {
   uint16_t escindices[ESCAPE_MAX]; // table of 1-biased indices into esctable
   int ttyfd;                       // connected to true terminal, might be -1
   char* esctable;                  // packed table of escape sequences
+  size_t esctablelen;              // bytes allocated for esctable
+  size_t esctableused;             // bytes of esctable in use
+  // set between interrogate_terminfo_start() and _finish(), i.e. while the
+  // responses to our initial queries have yet to be applied.
+  bool interrogating;
   nccapabilities caps;             // exported to the user, when requested
   unsigned pixy;                   // total pixel geometry, height
   unsigned pixx;                   // total pixel geometry, width
@@ -147,16 +192,21 @@ typedef struct tinfo {
   int (*pixel_draw)(const struct tinfo*, const struct ncpile* p,
                     struct sprixel* s, fbuf* f, int y, int x);
   int (*pixel_draw_late)(const struct tinfo*, struct sprixel* s, int yoff, int xoff);
+  // publish everything drawn by pixel_draw_late. only used with fbcon.
+  int (*pixel_flush)(const struct tinfo*);
   // execute move (erase old graphic, place at new location) if non-NULL
   int (*pixel_move)(struct sprixel* s, fbuf* f, unsigned noscroll, int yoff, int xoff);
   int (*pixel_scrub)(const struct ncpile* p, struct sprixel* s);
   int (*pixel_clear_all)(fbuf* f);  // called during context startup
+  // hide all placed graphics, leaving their data resident in the terminal,
+  // whence pixel_commit can reshow them. only used with kitty.
+  int (*pixel_hide_all)(fbuf* f);
   // make a loaded graphic visible. only used with kitty.
   int (*pixel_commit)(fbuf* f, struct sprixel* s, unsigned noscroll);
   // scroll all graphics up. only used with fbcon.
   void (*pixel_scroll)(const struct ncpile* p, struct tinfo*, int rows);
   void (*pixel_cleanup)(struct tinfo*); // called at shutdown
-  uint8_t* (*pixel_trans_auxvec)(const struct ncpile* p); // create tranparent auxvec
+  uint8_t* (*pixel_trans_auxvec)(const struct sprixel* s); // create tranparent auxvec
   // sprixel parameters. there are several different sprixel protocols, of
   // which we support sixel and kitty. the kitty protocol is used based
   // on TERM heuristics. otherwise, we attempt to detect sixel support, and
@@ -173,15 +223,31 @@ typedef struct tinfo {
   unsigned sixel_maxy_pristine; // maximum theoretical sixel height, as queried
   unsigned sprixel_scale_height;// sprixel must be a multiple of this many rows
   void* sixelengine;         // opaque threaded engine used by sixel dispatch
+  void* kittyengine;         // opaque compression engine used by kitty
+  kittytransport_e kittytransport; // detected in setup_kitty_bitmaps()
   const char* termname;      // terminal name from environment variables/init
   char* termversion;         // terminal version (freeform) from query responses
   queried_terminals_e qterm; // detected terminal class
   // we heap-allocate this one (if we use it), as it's not fully defined on Windows
   struct termios *tpreserved;// terminal state upon entry
   struct inputctx* ictx;     // new input layer
+  // the termcache entry applied in place of our initial responses, retained
+  // until it can be verified. NULL if the terminal's responses were used.
+  struct initial_responses* termcache;
   unsigned stdio_blocking_save; // was stdio blocking at entry? restore on stop.
   // ought we issue gratuitous HPAs to work around ambiguous widths?
   unsigned gratuitous_hpa;
+  // the byte length of each movement with single-digit parameters, or 0 if
+  // it's unavailable, from which goto_location() estimates the cheapest move.
+  // the movements are nearly always the ANSI sequences, in which case movefinal
+  // holds their final byte, and we write them directly rather than
+  // interpreting them with tiparm().
+  unsigned char movelen[MOVE_MAX];
+  char movefinal[MOVE_MAX];
+  // likewise, runs of identical cells can be written with REP or ECH if the
+  // terminal offers them in their ANSI forms (see raster_run()).
+  bool ansirep;              // rep is the glyph followed by CSI n-1 b
+  bool ansiech;              // ech is CSI n X
 
   // if we get a reply to our initial \e[18t cell geometry query, it will
   // replace these values. note that LINES/COLUMNS cannot be used to limit
@@ -191,18 +257,37 @@ typedef struct tinfo {
 
   ncpalette originalpalette; // palette as read from initial queries
   int maxpaletteread;        // maximum palette entry read
-  pthread_t gpmthread;       // thread handle for GPM watcher
-  int gpmfd;                 // connection to GPM daemon
+  // without RGB, every color is emitted as setaf/setab of a palette index.
+  // these are expanded once for each index (see build_palette_escapes()),
+  // rather than via tiparm() for each emission.
+  char* palescs;             // packed, NUL-terminated expansions
+  unsigned palesccount;      // indices expanded, 0 if none
+  uint16_t paloffs[2][NCPALETTESIZE]; // offsets of setaf [0] and setab [1]
+  // NCOPTION_ADAPTIVE_PALETTE: RGB555 color to the palette index we've
+  // programmed with it (or its nearest), 0 if none yet. allocated on demand.
+  uint8_t* rgbmap;
+  unsigned palnext;          // next palette index to program
+  int gpmfd;                 // connection to GPM daemon, polled for input
   char mouseproto;           // DECSET level (100x, '0', '2', '3')
+  bool bracketedpaste;       // have we enabled bracketed paste mode?
   bool pixelmice;            // do we support pixel-precision mice?
 #ifdef __linux__
   int linux_fb_fd;           // linux framebuffer device fd
   char* linux_fb_dev;        // device corresponding to linux_fb_dev
   uint8_t* linux_fbuffer;    // mmap()ed framebuffer
   size_t linux_fb_len;       // size of map
+  size_t linux_fb_stride;    // bytes per framebuffer line
+  unsigned linux_fb_bpp;     // bytes per framebuffer pixel (2, 3, or 4)
+  // bit offsets and lengths of each channel within a framebuffer pixel
+  uint8_t linux_fb_roff, linux_fb_goff, linux_fb_boff;
+  uint8_t linux_fb_rlen, linux_fb_glen, linux_fb_blen;
+  unsigned linux_fb_gen;     // bumped with each scroll of the framebuffer
+  struct fbshadow* linux_fb_shadow; // system memory back buffer, see linux.c
+  struct drmoverlay* linux_drm; // DRM/KMS overlay plane, used instead of fbdev
 #elif defined(__MINGW32__)
   HANDLE inhandle;
   HANDLE outhandle;
+  wchar_t hisurrogate;       // high surrogate awaiting its low half, or 0
 #endif
 
   // kitty keyboard protocol level. we initialize this to UINT_MAX, in case we
@@ -217,6 +302,10 @@ typedef struct tinfo {
   bool kittykbdsupport;      // do we support the kitty keyboard protocol?
   bool bce;                  // is the bce property advertised?
   bool in_alt_screen;        // are we in the alternate screen?
+
+  uint64_t startupns[STARTUP_MAX]; // when each milestone was hit, or 0
+  replytime replies[REPLYTIMES_MAX]; // arrivals of replies to initial queries
+  unsigned replycount;       // valid entries of replies
 } tinfo;
 
 // retrieve the terminfo(5)-style escape 'e' from tdesc (NULL if undefined).
@@ -237,19 +326,45 @@ term_supported_styles(const tinfo* ti){
 // prepare |ti| from the terminfo database and other sources. set |utf8| if
 // we've verified UTF8 output encoding. set |noaltscreen| to inhibit alternate
 // screen detection. |stats| may be NULL; either way, it will be handed to the
-// input layer so that its stats can be recorded.
+// input layer so that its stats can be recorded. set |coalesce| to coalesce
+// mouse motion and resize events in the input layer.
 int interrogate_terminfo(tinfo* ti, FILE* out, unsigned utf8,
                          unsigned noaltscreen, unsigned nocbreak,
                          unsigned nonewfonts, int* cursor_y, int* cursor_x,
                          struct ncsharedstats* stats, int lmargin, int tmargin,
-                         int rmargin, int bmargin, unsigned draininput)
+                         int rmargin, int bmargin, unsigned draininput,
+                         unsigned coalesce)
   __attribute__ ((nonnull (1, 2, 9)));
 
+// interrogate_terminfo() in two halves. the first sends our queries and does
+// everything which can be learned without their responses (terminfo, the
+// input layer). the second waits on the responses, and applies them along
+// with any terminal heuristics. work done between the two is overlapped with
+// the round trip to the terminal. if either fails, |ti| has been released.
+int interrogate_terminfo_start(tinfo* ti, FILE* out, unsigned utf8,
+                               unsigned noaltscreen, struct ncsharedstats* stats,
+                               int lmargin, int tmargin, int rmargin, int bmargin,
+                               unsigned draininput, unsigned coalesce)
+  __attribute__ ((nonnull (1, 2)));
+
+int interrogate_terminfo_finish(tinfo* ti, unsigned nocbreak, unsigned nonewfonts,
+                                int* cursor_y, int* cursor_x, unsigned draininput)
+  __attribute__ ((nonnull (1)));
+
 void free_terminfo_cache(tinfo* ti);
 
 // return a heap-allocated copy of termname + termversion
 char* termdesc_longterm(const tinfo* ti);
 
+// get a description of |termtype| built from its terminfo entry alone (no
+// terminal is queried), suitable for rasterization. |rgb| asserts 24-bit
+// color regardless of terminfo. descriptions are shared, and must be
+// released with termdesc_release(). returns NULL on error.
+const tinfo* termdesc_acquire(const char* termtype, bool rgb, bool utf8)
+  __attribute__ ((nonnull (1)));
+
+void termdesc_release(const tinfo* ti);
+
 int locate_cursor(tinfo* ti, unsigned* cursor_y, unsigned* cursor_x);
 
 // tlen -- size of escape table. tused -- used bytes in same.
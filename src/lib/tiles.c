@@ -0,0 +1,355 @@
+#include <string.h>
+#include "visual-details.h"
+#include "internal.h"
+
+// region-of-interest blitting from tiled, multiresolution sources. only the
+// tiles intersecting the requested region are loaded, from the smallest level
+// which still supplies as many pixels as the blitter will draw. decoded tiles
+// are kept in an LRU cache keyed by (level, row, column), so panning and
+// zooming about an image mostly hits memory rather than the decoder.
+
+#define NCTILED_DEFAULT_CACHE (64u * 1024 * 1024)
+
+typedef struct nctile {
+  struct nctile* hnext;        // hash chain
+  struct nctile* prev;         // LRU list, most recently used at the head
+  struct nctile* next;
+  uint64_t key;
+  uint32_t* rgba;              // tilepxy rows of tilepxx pixels
+} nctile;
+
+typedef struct nctiled {
+  nctiled_source src;
+  unsigned* lvly;              // pixel geometry of each level
+  unsigned* lvlx;
+  nctile** buckets;
+  unsigned bucketcount;        // power of 2
+  unsigned tilecount;          // tiles currently cached
+  unsigned maxtiles;           // cache capacity, at least 1
+  nctile* mru;
+  nctile* lru;
+} nctiled;
+
+static inline uint64_t
+tile_key(unsigned level, unsigned ty, unsigned tx){
+  return ((uint64_t)level << 56) | ((uint64_t)(ty & 0xfffffffu) << 28) |
+         (tx & 0xfffffffu);
+}
+
+static inline unsigned
+tile_bucket(const nctiled* t, uint64_t key){
+  return (key * 0x9e3779b97f4a7c15ull) >> 32 & (t->bucketcount - 1);
+}
+
+static void
+tile_unlink(nctiled* t, nctile* tile){
+  if(tile->prev){
+    tile->prev->next = tile->next;
+  }else{
+    t->mru = tile->next;
+  }
+  if(tile->next){
+    tile->next->prev = tile->prev;
+  }else{
+    t->lru = tile->prev;
+  }
+}
+
+static void
+tile_push(nctiled* t, nctile* tile){
+  tile->prev = NULL;
+  tile->next = t->mru;
+  if(t->mru){
+    t->mru->prev = tile;
+  }else{
+    t->lru = tile;
+  }
+  t->mru = tile;
+}
+
+static void
+tile_unhash(nctiled* t, nctile* tile){
+  nctile** pt = &t->buckets[tile_bucket(t, tile->key)];
+  while(*pt != tile){
+    pt = &(*pt)->hnext;
+  }
+  *pt = tile->hnext;
+}
+
+// get the tile, from the cache if possible. the result is only good until
+// the next call, which might evict it.
+static const uint32_t*
+tile_get(nctiled* t, unsigned level, unsigned ty, unsigned tx){
+  const uint64_t key = tile_key(level, ty, tx);
+  const unsigned b = tile_bucket(t, key);
+  for(nctile* tile = t->buckets[b] ; tile ; tile = tile->hnext){
+    if(tile->key == key){
+      if(tile != t->mru){
+        tile_unlink(t, tile);
+        tile_push(t, tile);
+      }
+      return tile->rgba;
+    }
+  }
+  nctile* tile;
+  if(t->tilecount == t->maxtiles){
+    // recycle the least recently used tile, buffer and all
+    tile = t->lru;
+    tile_unlink(t, tile);
+    tile_unhash(t, tile);
+  }else{
+    if((tile = malloc(sizeof(*tile))) == NULL){
+      return NULL;
+    }
+    tile->rgba = malloc(sizeof(*tile->rgba) * t->src.tilepxy * t->src.tilepxx);
+    if(tile->rgba == NULL){
+      free(tile);
+      return NULL;
+    }
+    ++t->tilecount;
+  }
+  memset(tile->rgba, 0, sizeof(*tile->rgba) * t->src.tilepxy * t->src.tilepxx);
+  if(t->src.load_tile(t->src.curry, level, ty, tx, tile->rgba)){
+    logerror("couldn't load tile %u/%u/%u", level, ty, tx);
+    free(tile->rgba);
+    free(tile);
+    --t->tilecount;
+    return NULL;
+  }
+  tile->key = key;
+  tile->hnext = t->buckets[b];
+  t->buckets[b] = tile;
+  tile_push(t, tile);
+  return tile->rgba;
+}
+
+nctiled* nctiled_create(const nctiled_source* src, size_t cachebytes){
+  if(src->levels == 0 || src->levels > 255){
+    logerror("invalid level count %u", src->levels);
+    return NULL;
+  }
+  if(src->tilepxy == 0 || src->tilepxx == 0){
+    logerror("invalid tile geometry %ux%u", src->tilepxy, src->tilepxx);
+    return NULL;
+  }
+  if(src->level_geom == NULL || src->load_tile == NULL){
+    logerror("source lacks callbacks");
+    return NULL;
+  }
+  nctiled* t = malloc(sizeof(*t));
+  if(t == NULL){
+    return NULL;
+  }
+  memset(t, 0, sizeof(*t));
+  t->lvly = malloc(sizeof(*t->lvly) * src->levels);
+  t->lvlx = malloc(sizeof(*t->lvlx) * src->levels);
+  if(t->lvly == NULL || t->lvlx == NULL){
+    goto err;
+  }
+  for(unsigned l = 0 ; l < src->levels ; ++l){
+    if(src->level_geom(src->curry, l, &t->lvly[l], &t->lvlx[l])){
+      logerror("couldn't get geometry of level %u", l);
+      goto err;
+    }
+    if(t->lvly[l] == 0 || t->lvlx[l] == 0){
+      logerror("empty level %u", l);
+      goto err;
+    }
+    if((t->lvly[l] - 1) / src->tilepxy > 0xfffffffu ||
+       (t->lvlx[l] - 1) / src->tilepxx > 0xfffffffu){
+      logerror("too many tiles in level %u", l);
+      goto err;
+    }
+  }
+  if(cachebytes == 0){
+    cachebytes = NCTILED_DEFAULT_CACHE;
+  }
+  const size_t tilebytes = sizeof(uint32_t) * src->tilepxy * src->tilepxx;
+  size_t maxtiles = cachebytes / tilebytes;
+  if(maxtiles == 0){
+    maxtiles = 1;
+  }else if(maxtiles > UINT_MAX / 2){
+    maxtiles = UINT_MAX / 2;
+  }
+  t->maxtiles = maxtiles;
+  t->bucketcount = 1;
+  while(t->bucketcount < t->maxtiles){
+    t->bucketcount <<= 1;
+  }
+  if((t->buckets = malloc(sizeof(*t->buckets) * t->bucketcount)) == NULL){
+    goto err;
+  }
+  memset(t->buckets, 0, sizeof(*t->buckets) * t->bucketcount);
+  memcpy(&t->src, src, sizeof(*src));
+  loginfo("%u levels of %ux%u, %u tiles of %ux%u cached",
+          src->levels, t->lvly[0], t->lvlx[0], t->maxtiles,
+          src->tilepxy, src->tilepxx);
+  return t;
+
+err:
+  free(t->lvly);
+  free(t->lvlx);
+  free(t);
+  return NULL;
+}
+
+nctiled* nctiled_from_file(const char* file, size_t cachebytes){
+  if(!visual_implementation->visual_tiles_open){
+    logerror("multimedia engine can't read tiles");
+    return NULL;
+  }
+  nctiled_source src;
+  memset(&src, 0, sizeof(src));
+  if(visual_implementation->visual_tiles_open(file, &src)){
+    logerror("error opening %s", file);
+    return NULL;
+  }
+  nctiled* t = nctiled_create(&src, cachebytes);
+  if(t == NULL && src.release){
+    src.release(src.curry);
+  }
+  return t;
+}
+
+int nctiled_geom(const nctiled* t, unsigned* pxy, unsigned* pxx){
+  if(pxy){
+    *pxy = t->lvly[0];
+  }
+  if(pxx){
+    *pxx = t->lvlx[0];
+  }
+  return 0;
+}
+
+// copy the part of level 'level' from [by, ey) X [bx, ex) into 'buf', which
+// has 'stride' pixels per row.
+static int
+tiled_assemble(nctiled* t, unsigned level, unsigned by, unsigned ey,
+               unsigned bx, unsigned ex, uint32_t* buf, size_t stride){
+  const unsigned th = t->src.tilepxy;
+  const unsigned tw = t->src.tilepxx;
+  for(unsigned ty = by / th ; ty <= (ey - 1) / th ; ++ty){
+    const unsigned y0 = ty * th > by ? ty * th : by;
+    const unsigned y1 = (ty + 1) * th < ey ? (ty + 1) * th : ey;
+    for(unsigned tx = bx / tw ; tx <= (ex - 1) / tw ; ++tx){
+      const unsigned x0 = tx * tw > bx ? tx * tw : bx;
+      const unsigned x1 = (tx + 1) * tw < ex ? (tx + 1) * tw : ex;
+      const uint32_t* tile = tile_get(t, level, ty, tx);
+      if(tile == NULL){
+        return -1;
+      }
+      for(unsigned y = y0 ; y < y1 ; ++y){
+        memcpy(buf + (y - by) * stride + (x0 - bx),
+               tile + (size_t)(y - ty * th) * tw + (x0 - tx * tw),
+               sizeof(*buf) * (x1 - x0));
+      }
+    }
+  }
+  return 0;
+}
+
+ncplane* nctiled_blit(notcurses* nc, nctiled* t, const struct ncvisual_options* vopts){
+  struct ncvisual_options v;
+  if(vopts){
+    memcpy(&v, vopts, sizeof(v));
+  }else{
+    memset(&v, 0, sizeof(v));
+  }
+  const unsigned pxy = t->lvly[0];
+  const unsigned pxx = t->lvlx[0];
+  if(v.begy >= pxy || v.begx >= pxx){
+    logerror("region origin %ux%u outside %ux%u", v.begy, v.begx, pxy, pxx);
+    return NULL;
+  }
+  const unsigned leny = v.leny ? v.leny : pxy - v.begy;
+  const unsigned lenx = v.lenx ? v.lenx : pxx - v.begx;
+  if(leny > pxy - v.begy || lenx > pxx - v.begx){
+    logerror("region %ux%u+%ux%u exceeds %ux%u", v.begy, v.begx, leny, lenx, pxy, pxx);
+    return NULL;
+  }
+  const unsigned begy = v.begy;
+  const unsigned begx = v.begx;
+  v.begy = v.begx = v.leny = v.lenx = 0;
+  // learn how many pixels the blitter will draw for the region, using a
+  // stand-in visual of the region's geometry. ncvisual_geom() requires only
+  // that data be present, and never reads it.
+  uint32_t nodata = 0;
+  ncvisual proxy;
+  memset(&proxy, 0, sizeof(proxy));
+  proxy.pixy = leny;
+  proxy.pixx = lenx;
+  proxy.data = &nodata;
+  ncvgeom geom;
+  if(ncvisual_geom(nc, &proxy, &v, &geom)){
+    return NULL;
+  }
+  unsigned level = 0;
+  while(level + 1 < t->src.levels){
+    const uint64_t ly = (uint64_t)leny * t->lvly[level + 1] / pxy;
+    const uint64_t lx = (uint64_t)lenx * t->lvlx[level + 1] / pxx;
+    if(ly < geom.rpixy || lx < geom.rpixx){
+      break;
+    }
+    ++level;
+  }
+  const unsigned lpy = t->lvly[level];
+  const unsigned lpx = t->lvlx[level];
+  const unsigned by = (uint64_t)begy * lpy / pxy;
+  const unsigned bx = (uint64_t)begx * lpx / pxx;
+  unsigned ey = ((uint64_t)(begy + leny) * lpy + pxy - 1) / pxy;
+  unsigned ex = ((uint64_t)(begx + lenx) * lpx + pxx - 1) / pxx;
+  if(ey > lpy){
+    ey = lpy;
+  }
+  if(ex > lpx){
+    ex = lpx;
+  }
+  logdebug("region %ux%u+%ux%u from level %u [%u..%u)x[%u..%u)",
+           begy, begx, leny, lenx, level, by, ey, bx, ex);
+  const unsigned rows = ey - by;
+  const unsigned cols = ex - bx;
+  // lay the rows out as the multimedia engine wants them, so that the
+  // borrowed buffer needn't be copied again
+  size_t stride = cols;
+  if(visual_implementation->rowalign){
+    const size_t align = visual_implementation->rowalign / sizeof(uint32_t);
+    stride = (cols + align - 1) / align * align;
+  }
+  uint32_t* buf = malloc(sizeof(*buf) * stride * rows);
+  if(buf == NULL){
+    return NULL;
+  }
+  if(tiled_assemble(t, level, by, ey, bx, ex, buf, stride)){
+    free(buf);
+    return NULL;
+  }
+  ncvisual* ncv = ncvisual_from_rgba_borrowed(buf, rows, stride * sizeof(*buf),
+                                              cols, NULL, NULL);
+  if(ncv == NULL){
+    free(buf);
+    return NULL;
+  }
+  ncplane* n = ncvisual_blit(nc, ncv, &v);
+  ncvisual_destroy(ncv);
+  free(buf);
+  return n;
+}
+
+void nctiled_destroy(nctiled* t){
+  if(t){
+    nctile* tile = t->mru;
+    while(tile){
+      nctile* next = tile->next;
+      free(tile->rgba);
+      free(tile);
+      tile = next;
+    }
+    if(t->src.release){
+      t->src.release(t->src.curry);
+    }
+    free(t->buckets);
+    free(t->lvly);
+    free(t->lvlx);
+    free(t);
+  }
+}
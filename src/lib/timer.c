@@ -0,0 +1,274 @@
+#include <stdlib.h>
+#include <string.h>
+#include "internal.h"
+#include "timer.h"
+
+typedef struct nctimer {
+  struct notcurses* nc;
+  nctimercb cb;           // NULL for a free slab entry
+  void* curry;
+  uint64_t expiryns;      // next expiry (CLOCK_MONOTONIC)
+  uint64_t periodns;      // 0 for a one-shot
+  uint64_t serial;
+  unsigned pending;       // expirations awaiting delivery
+  unsigned slot;          // our slot, valid while armed
+  int next;               // next timer in our slot, or on the freelist
+  int firednext;          // next timer on the fired list
+  bool armed;             // are we on the wheel?
+} nctimer;
+
+static inline uint64_t
+wheel_tick(const ncwheel* w, uint64_t ns){
+  return ns <= w->epochns ? 0 : (ns - w->epochns) / NCWHEEL_TICKNS;
+}
+
+int ncwheel_init(ncwheel* w){
+  memset(w, 0, sizeof(*w));
+  if(pthread_mutex_init(&w->lock, NULL)){
+    return -1;
+  }
+  w->freelist = -1;
+  w->fired = -1;
+  for(unsigned s = 0 ; s < NCWHEEL_SLOTS ; ++s){
+    w->slots[s] = -1;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  w->epochns = timespec_to_ns(&now);
+  return 0;
+}
+
+void ncwheel_destroy(ncwheel* w){
+  pthread_mutex_destroy(&w->lock);
+  free(w->timers);
+  w->timers = NULL;
+  w->tcount = 0;
+}
+
+// a timer whose tick has already been swept goes into the next slot to be
+// swept, so that it isn't left waiting out a revolution.
+static void
+wheel_insert(ncwheel* w, int idx){
+  nctimer* t = &w->timers[idx];
+  uint64_t tick = wheel_tick(w, t->expiryns);
+  if(tick < w->curtick){
+    tick = w->curtick;
+  }
+  t->slot = tick % NCWHEEL_SLOTS;
+  t->next = w->slots[t->slot];
+  w->slots[t->slot] = idx;
+  t->armed = true;
+}
+
+static void
+unlink_index(ncwheel* w, int* head, int idx, bool fired){
+  while(*head != idx){
+    head = fired ? &w->timers[*head].firednext : &w->timers[*head].next;
+  }
+  *head = fired ? w->timers[idx].firednext : w->timers[idx].next;
+}
+
+static void
+timer_cancel(ncwheel* w, int idx){
+  nctimer* t = &w->timers[idx];
+  if(t->armed){
+    unlink_index(w, &w->slots[t->slot], idx, false);
+    t->armed = false;
+  }
+  if(t->pending){
+    unlink_index(w, &w->fired, idx, true);
+    t->pending = 0;
+  }
+  t->cb = NULL;
+  t->next = w->freelist;
+  w->freelist = idx;
+}
+
+// grow the slab, threading the new entries onto the freelist.
+static int
+wheel_grow(ncwheel* w){
+  const unsigned count = w->tcount ? w->tcount * 2 : 8;
+  if(count > INT_MAX){
+    logerror("too many timers (%u)", w->tcount);
+    return -1;
+  }
+  nctimer* tmp = realloc(w->timers, sizeof(*tmp) * count);
+  if(tmp == NULL){
+    logerror("couldn't allocate %u timers", count);
+    return -1;
+  }
+  w->timers = tmp;
+  for(unsigned i = count ; i > w->tcount ; --i){
+    memset(&w->timers[i - 1], 0, sizeof(*w->timers));
+    w->timers[i - 1].next = w->freelist;
+    w->freelist = i - 1;
+  }
+  w->tcount = count;
+  return 0;
+}
+
+int ncwheel_add(ncwheel* w, uint64_t nowns, uint64_t delayns, uint64_t periodns,
+                struct notcurses* nc, nctimercb cb, void* curry){
+  pthread_mutex_lock(&w->lock);
+  if(w->freelist < 0 && wheel_grow(w)){
+    pthread_mutex_unlock(&w->lock);
+    return -1;
+  }
+  const int idx = w->freelist;
+  nctimer* t = &w->timers[idx];
+  w->freelist = t->next;
+  memset(t, 0, sizeof(*t));
+  t->nc = nc;
+  t->cb = cb;
+  t->curry = curry;
+  t->periodns = periodns;
+  t->serial = ++w->serial;
+  if(delayns == 0 && periodns){
+    // align to the period, so that timers of like period share wakeups
+    const uint64_t since = nowns > w->epochns ? nowns - w->epochns : 0;
+    t->expiryns = w->epochns + (since / periodns + 1) * periodns;
+  }else{
+    t->expiryns = nowns + delayns;
+  }
+  wheel_insert(w, idx);
+  pthread_mutex_unlock(&w->lock);
+  return idx + 1;
+}
+
+int ncwheel_del(ncwheel* w, int id){
+  pthread_mutex_lock(&w->lock);
+  if(id <= 0 || (unsigned)id > w->tcount || w->timers[id - 1].cb == NULL){
+    pthread_mutex_unlock(&w->lock);
+    logerror("no timer with id %d", id);
+    return -1;
+  }
+  timer_cancel(w, id - 1);
+  pthread_mutex_unlock(&w->lock);
+  return 0;
+}
+
+// the timer at |idx| is due. mark it as fired, and if it's periodic, put it
+// back on the wheel. a timer which has fallen behind isn't fired once per
+// missed period; they're all folded into this expiry. |horizon| is the end
+// of the tick being expired.
+static unsigned
+timer_fire(ncwheel* w, int idx, uint64_t horizon){
+  nctimer* t = &w->timers[idx];
+  unsigned n = 1;
+  t->armed = false;
+  if(t->periodns){
+    t->expiryns += t->periodns;
+    if(t->expiryns < horizon){
+      const uint64_t behind = (horizon - 1 - t->expiryns) / t->periodns + 1;
+      n += behind;
+      t->expiryns += behind * t->periodns;
+    }
+    wheel_insert(w, idx);
+  }
+  if(t->pending == 0){
+    t->firednext = w->fired;
+    w->fired = idx;
+  }
+  t->pending += n;
+  return n;
+}
+
+unsigned ncwheel_expire(ncwheel* w, uint64_t nowns){
+  unsigned fired = 0;
+  pthread_mutex_lock(&w->lock);
+  const uint64_t nowtick = wheel_tick(w, nowns);
+  if(nowtick >= w->curtick){
+    const uint64_t horizon = w->epochns + (nowtick + 1) * NCWHEEL_TICKNS;
+    // after a long sleep, every slot need only be swept once
+    uint64_t sweeps = nowtick - w->curtick + 1;
+    if(sweeps > NCWHEEL_SLOTS){
+      sweeps = NCWHEEL_SLOTS;
+    }
+    for(uint64_t tick = nowtick + 1 - sweeps ; tick <= nowtick ; ++tick){
+      const unsigned s = tick % NCWHEEL_SLOTS;
+      int idx = w->slots[s];
+      w->slots[s] = -1;
+      while(idx >= 0){
+        nctimer* t = &w->timers[idx];
+        const int next = t->next;
+        if(t->expiryns >= horizon){ // due on a later revolution
+          t->next = w->slots[s];
+          w->slots[s] = idx;
+        }else{
+          fired += timer_fire(w, idx, horizon);
+        }
+        idx = next;
+      }
+    }
+    w->curtick = nowtick + 1;
+  }
+  pthread_mutex_unlock(&w->lock);
+  return fired;
+}
+
+uint64_t ncwheel_next(ncwheel* w, uint64_t nowns){
+  uint64_t best = UINT64_MAX; // earliest tick in which something expires
+  pthread_mutex_lock(&w->lock);
+  // walk forward from the next slot to be swept, stopping at the first
+  // which holds a timer due within this revolution.
+  for(unsigned k = 0 ; k < NCWHEEL_SLOTS && best == UINT64_MAX ; ++k){
+    const uint64_t tick = w->curtick + k;
+    for(int idx = w->slots[tick % NCWHEEL_SLOTS] ; idx >= 0 ; idx = w->timers[idx].next){
+      const uint64_t t = wheel_tick(w, w->timers[idx].expiryns);
+      if(t <= tick && t < best){
+        best = t;
+      }
+    }
+  }
+  // nothing within a revolution; take the earliest of whatever's out there
+  if(best == UINT64_MAX){
+    for(unsigned s = 0 ; s < NCWHEEL_SLOTS ; ++s){
+      for(int idx = w->slots[s] ; idx >= 0 ; idx = w->timers[idx].next){
+        const uint64_t t = wheel_tick(w, w->timers[idx].expiryns);
+        if(t < best){
+          best = t;
+        }
+      }
+    }
+  }
+  const uint64_t epochns = w->epochns;
+  pthread_mutex_unlock(&w->lock);
+  if(best == UINT64_MAX){
+    return UINT64_MAX;
+  }
+  const uint64_t startns = epochns + best * NCWHEEL_TICKNS;
+  return startns > nowns ? startns - nowns : 0;
+}
+
+void ncwheel_run(ncwheel* w){
+  pthread_mutex_lock(&w->lock);
+  // don't chase timers which fire while we're running callbacks; they'll
+  // come with the next NCKEY_TIMER.
+  unsigned budget = 0;
+  for(int idx = w->fired ; idx >= 0 ; idx = w->timers[idx].firednext){
+    ++budget;
+  }
+  while(budget-- && w->fired >= 0){
+    const int idx = w->fired;
+    nctimer* t = &w->timers[idx];
+    w->fired = t->firednext;
+    const unsigned missed = t->pending - 1;
+    t->pending = 0;
+    const nctimercb cb = t->cb;
+    void* curry = t->curry;
+    struct notcurses* nc = t->nc;
+    const uint64_t serial = t->serial;
+    pthread_mutex_unlock(&w->lock);
+    const int r = cb(nc, curry, missed);
+    pthread_mutex_lock(&w->lock);
+    // the callback might have cancelled the timer, and its entry might even
+    // have been reused (the slab might also have moved).
+    t = &w->timers[idx];
+    if(t->cb && t->serial == serial){
+      if(r || (!t->periodns && !t->pending)){
+        timer_cancel(w, idx);
+      }
+    }
+  }
+  pthread_mutex_unlock(&w->lock);
+}
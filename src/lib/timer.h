@@ -0,0 +1,79 @@
+#ifndef NOTCURSES_TIMER
+#define NOTCURSES_TIMER
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// internal header, not installed
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <notcurses/notcurses.h>
+
+// timers registered with notcurses_timer_add() live on a hashed timing wheel
+// of NCWHEEL_SLOTS slots, each covering NCWHEEL_TICKNS. a timer sits in the
+// slot for the tick in which it next expires; timers further out than one
+// revolution share slots with nearer ones, and are skipped until their
+// tick comes around. everything due within a tick expires together, so
+// timers sharing a period (and thus a phase; see ncwheel_add()) share
+// wakeups. the input thread expires timers, marking them as fired. the
+// client runs their callbacks when it takes the NCKEY_TIMER event.
+#define NCWHEEL_SLOTS 256
+#define NCWHEEL_TICKNS 1000000ull
+
+struct nctimer;
+
+typedef struct ncwheel {
+  pthread_mutex_t lock;     // the input thread expires, the client adds/runs
+  struct nctimer* timers;   // slab of timers; a timer's id is its index + 1
+  unsigned tcount;          // entries in the slab
+  int freelist;             // first free slab entry, or -1
+  int slots[NCWHEEL_SLOTS]; // first timer in each slot, or -1
+  int fired;                // first timer with undelivered expirations, or -1
+  uint64_t epochns;         // start of tick 0 (CLOCK_MONOTONIC)
+  uint64_t curtick;         // slots for ticks before this have been swept
+  uint64_t serial;          // distinguishes uses of a slab entry
+} ncwheel;
+
+int ncwheel_init(ncwheel* w)
+  __attribute__ ((nonnull (1)));
+
+void ncwheel_destroy(ncwheel* w)
+  __attribute__ ((nonnull (1)));
+
+// register a timer which first expires |delayns| after |nowns|, and every
+// |periodns| thereafter (0 for a one-shot). with a period but no delay,
+// the first expiry is instead aligned to a multiple of the period from the
+// wheel's epoch. returns the id (> 0), or -1 on error.
+int ncwheel_add(ncwheel* w, uint64_t nowns, uint64_t delayns, uint64_t periodns,
+                struct notcurses* nc, nctimercb cb, void* curry)
+  __attribute__ ((nonnull (1, 6)));
+
+// cancel timer |id|, discarding any undelivered expirations.
+int ncwheel_del(ncwheel* w, int id)
+  __attribute__ ((nonnull (1)));
+
+// called by the input thread. expire everything due within the tick
+// containing |nowns|. returns the number of expirations (a periodic timer
+// which has fallen behind expires once for each period missed).
+unsigned ncwheel_expire(ncwheel* w, uint64_t nowns)
+  __attribute__ ((nonnull (1)));
+
+// ns from |nowns| until the start of the tick in which the earliest timer
+// expires (0 if it's already due), or UINT64_MAX if there are no timers.
+uint64_t ncwheel_next(ncwheel* w, uint64_t nowns)
+  __attribute__ ((nonnull (1)));
+
+// called by the client. run the callback of each fired timer, without
+// holding the lock (callbacks may add and remove timers). a timer whose
+// callback returns non-zero is cancelled, as is a one-shot timer once run.
+void ncwheel_run(ncwheel* w)
+  __attribute__ ((nonnull (1)));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <inttypes.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#include "internal.h"
+
+// events a thread's ring holds before overwriting its oldest
+#define TRACE_RING_EVENTS 8192
+
+typedef struct traceevent {
+  const char* name;
+  const char* argname; // NULL for no argument
+  uint64_t ts;         // ns
+  uint64_t dur;        // ns, spans only
+  int64_t arg;
+  char ph;             // 'X' (complete span) or 'C' (counter)
+} traceevent;
+
+// each thread records into its own ring, so recording takes no locks. rings
+// are linked into a global list when created. a ring whose thread has exited
+// is marked 'dead', and freed once written out; live rings are kept (their
+// threads still hold them), and emptied for the next session.
+typedef struct tracering {
+  struct tracering* next;
+  unsigned tid;
+  bool dead;
+  uint64_t session;    // session in which the ring was last emptied
+  size_t head;         // next slot to be written
+  size_t count;        // valid events, at most TRACE_RING_EVENTS
+  traceevent ev[TRACE_RING_EVENTS];
+} tracering;
+
+static bool nctrace_enabled;
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_key;
+static tracering* rings;
+static unsigned refs;
+static char* tracepath;
+static uint64_t session; // bumped with each traced session
+static __thread tracering* myring;
+
+static void
+ring_orphan(void* vring){
+  tracering* r = vring;
+  pthread_mutex_lock(&trace_lock);
+    r->dead = true;
+  pthread_mutex_unlock(&trace_lock);
+}
+
+static void
+trace_key_create(void){
+  if(pthread_key_create(&trace_key, ring_orphan)){
+    logerror("couldn't create trace key");
+  }
+}
+
+static unsigned
+trace_tid(void){
+#ifdef __linux__
+  return syscall(SYS_gettid);
+#else
+  static unsigned nexttid = 1;
+  return __atomic_fetch_add(&nexttid, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+static tracering*
+trace_ring(void){
+  tracering* r = myring;
+  if(r){
+    // a new session started since we last recorded; drop what's left over
+    const uint64_t s = __atomic_load_n(&session, __ATOMIC_RELAXED);
+    if(r->session != s){
+      r->head = r->count = 0;
+      r->session = s;
+    }
+    return r;
+  }
+  if((r = malloc(sizeof(*r))) == NULL){
+    return NULL;
+  }
+  r->tid = trace_tid();
+  r->dead = false;
+  r->head = r->count = 0;
+  pthread_once(&trace_once, trace_key_create);
+  pthread_setspecific(trace_key, r);
+  pthread_mutex_lock(&trace_lock);
+    r->session = session;
+    r->next = rings;
+    rings = r;
+  pthread_mutex_unlock(&trace_lock);
+  myring = r;
+  return r;
+}
+
+static void
+trace_record(const char* name, char ph, uint64_t ts, uint64_t dur,
+             const char* argname, int64_t arg){
+  tracering* r = trace_ring();
+  if(r == NULL){
+    return;
+  }
+  traceevent* e = &r->ev[r->head];
+  e->name = name;
+  e->argname = argname;
+  e->ts = ts;
+  e->dur = dur;
+  e->arg = arg;
+  e->ph = ph;
+  if(++r->head == TRACE_RING_EVENTS){
+    r->head = 0;
+  }
+  if(r->count < TRACE_RING_EVENTS){
+    ++r->count;
+  }
+}
+
+uint64_t nctrace_begin(void){
+  if(!__atomic_load_n(&nctrace_enabled, __ATOMIC_RELAXED)){
+    return 0;
+  }
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return timespec_to_ns(&ts);
+}
+
+void nctrace_end(const char* name, uint64_t start, const char* argname,
+                 int64_t arg){
+  if(start == 0){
+    return;
+  }
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  const uint64_t now = timespec_to_ns(&ts);
+  trace_record(name, 'X', start, now > start ? now - start : 0, argname, arg);
+}
+
+void nctrace_counter(const char* name, int64_t value){
+  if(!__atomic_load_n(&nctrace_enabled, __ATOMIC_RELAXED)){
+    return;
+  }
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  trace_record(name, 'C', timespec_to_ns(&ts), 0, "value", value);
+}
+
+void nctrace_init(void){
+  pthread_mutex_lock(&trace_lock);
+    if(refs++ == 0){
+      const char* path = getenv("NOTCURSES_TRACE");
+      if(path && *path){
+        if((tracepath = strdup(path))){
+          __atomic_add_fetch(&session, 1, __ATOMIC_RELAXED);
+          __atomic_store_n(&nctrace_enabled, true, __ATOMIC_RELAXED);
+          loginfo("tracing to %s", tracepath);
+        }
+      }
+    }
+  pthread_mutex_unlock(&trace_lock);
+}
+
+static int
+trace_write_ring(FILE* fp, const tracering* r, int pid, bool* first){
+  size_t idx = (r->head + TRACE_RING_EVENTS - r->count) % TRACE_RING_EVENTS;
+  for(size_t i = 0 ; i < r->count ; ++i){
+    const traceevent* e = &r->ev[idx];
+    if(fprintf(fp, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%" PRIu64 ".%03u,",
+               *first ? "" : ",", e->name, e->ph, e->ts / 1000,
+               (unsigned)(e->ts % 1000)) < 0){
+      return -1;
+    }
+    if(e->ph == 'X'){
+      if(fprintf(fp, "\"dur\":%" PRIu64 ".%03u,", e->dur / 1000,
+                 (unsigned)(e->dur % 1000)) < 0){
+        return -1;
+      }
+    }
+    if(fprintf(fp, "\"pid\":%d,\"tid\":%u", pid, r->tid) < 0){
+      return -1;
+    }
+    if(e->argname){
+      if(fprintf(fp, ",\"args\":{\"%s\":%" PRId64 "}", e->argname, e->arg) < 0){
+        return -1;
+      }
+    }
+    if(fputc('}', fp) == EOF){
+      return -1;
+    }
+    *first = false;
+    idx = (idx + 1) % TRACE_RING_EVENTS;
+  }
+  return 0;
+}
+
+int nctrace_fini(void){
+  int ret = 0;
+  pthread_mutex_lock(&trace_lock);
+    if(refs == 0 || --refs){
+      pthread_mutex_unlock(&trace_lock);
+      return 0;
+    }
+    if(tracepath == NULL){
+      pthread_mutex_unlock(&trace_lock);
+      return 0;
+    }
+    __atomic_store_n(&nctrace_enabled, false, __ATOMIC_RELAXED);
+    FILE* fp = fopen(tracepath, "w");
+    if(fp == NULL){
+      logerror("couldn't open trace file %s", tracepath);
+      ret = -1;
+    }else{
+      const int pid = getpid();
+      bool first = true;
+      if(fputs("{\"traceEvents\":[", fp) == EOF){
+        ret = -1;
+      }
+      for(const tracering* r = rings ; r && ret == 0 ; r = r->next){
+        if(r->session == session){
+          ret = trace_write_ring(fp, r, pid, &first);
+        }
+      }
+      if(ret == 0 && fputs("\n],\"displayTimeUnit\":\"ns\"}\n", fp) == EOF){
+        ret = -1;
+      }
+      if(fclose(fp)){
+        ret = -1;
+      }
+    }
+    tracering** pr = &rings;
+    tracering* r;
+    while( (r = *pr) ){
+      if(r->dead){
+        *pr = r->next;
+        free(r);
+      }else{
+        pr = &r->next;
+      }
+    }
+    free(tracepath);
+    tracepath = NULL;
+  pthread_mutex_unlock(&trace_lock);
+  return ret;
+}
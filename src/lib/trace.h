@@ -0,0 +1,39 @@
+#ifndef NOTCURSES_TRACE
+#define NOTCURSES_TRACE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// opt-in event tracing, enabled by naming an output file in NOTCURSES_TRACE.
+// timestamped spans and counters are recorded into per-thread rings (the
+// oldest events are overwritten once a ring fills), and written out as
+// Chrome trace-event JSON, which chrome://tracing and Perfetto both load,
+// when the last notcurses context is stopped. timestamps are taken from
+// CLOCK_MONOTONIC. names (and argument names) must be string literals.
+
+// the start of a span, or 0 if we're not tracing.
+uint64_t nctrace_begin(void);
+
+// record the span 'name' begun at 'start' (from nctrace_begin()), ending now.
+// if 'argname' is not NULL, 'arg' is attached under that name. nothing is
+// recorded if 'start' is 0.
+void nctrace_end(const char* name, uint64_t start, const char* argname,
+                 int64_t arg);
+
+// record 'value' for the counter 'name'.
+void nctrace_counter(const char* name, int64_t value);
+
+// tracing is reference counted across contexts. nctrace_init() checks
+// NOTCURSES_TRACE when the first reference is taken; nctrace_fini() writes
+// the trace when the last is dropped.
+void nctrace_init(void);
+int nctrace_fini(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -4,10 +4,18 @@
 typedef struct nctree_int_item {
   void* curry;
   ncplane* ncp;
-  unsigned subcount;
   struct nctree_int_item* subs;
+  unsigned subcount;
+  bool expanded;            // are subs visible? sourced items start collapsed
+  bool drawn;               // drawn during the current redraw
 } nctree_int_item;
 
+// an item holding a plane, and its distance from the focus when last drawn
+typedef struct nctree_live {
+  nctree_int_item* nii;
+  int distance;
+} nctree_live;
+
 typedef struct nctree {
   int (*cbfxn)(ncplane*, void*, int);
   nctree_int_item items;    // topmost set of items, holds widget plane
@@ -17,6 +25,20 @@ typedef struct nctree {
   int activerow;            // active row -1 <= activerow < dimy
   int indentcols;           // cols to indent per level
   uint64_t bchannels;       // border glyph channels
+  nctree_source src;        // supplies children if src.sub is non-NULL
+  // items holding planes as of the last redraw, and those drawn during the
+  // current one. once a redraw completes, items in the former but not the
+  // latter have been pushed offscreen, and give up their planes. this keeps
+  // the cost of a redraw proportional to the visible rows.
+  nctree_live* live;
+  unsigned livecount, livealloc;
+  nctree_live* drawn;
+  unsigned drawncount, drawnalloc;
+  // planes given up by hidden items, reused for newly-visible ones. they're
+  // bound to a 1x1 plane heading a pile of their own, so they're never seen.
+  ncplane** pool;
+  unsigned poolcount, poolalloc;
+  ncplane* poolpile;
 } nctree;
 
 static void
@@ -83,6 +105,8 @@ dup_tree_items(nctree_int_item* fill, const struct nctree_item* items,
       return -1;
     }
     nii->ncp = NULL;
+    nii->expanded = true;
+    nii->drawn = false;
     if(dup_tree_items(nii, items[c].subs, items[c].subcount, depth + 1, maxdepth)){
       while(c--){
         free_tree_items(&fill->subs[c]);
@@ -97,6 +121,120 @@ dup_tree_items(nctree_int_item* fill, const struct nctree_item* items,
   return 0;
 }
 
+static int
+tree_path_length(const unsigned* path){
+  int len = 0;
+  while(path[len] != UINT_MAX){
+    ++len;
+  }
+  return len;
+}
+
+// fetch the children of |nii| from the tree's source. they start collapsed,
+// and thus their own children are not fetched.
+static int
+fetch_tree_items(nctree* n, nctree_int_item* nii){
+  unsigned count = n->src.subcount(n->src.opaque, nii->curry);
+  nii->subs = NULL;
+  nii->subcount = 0;
+  if(count == 0){
+    return 0;
+  }
+  nctree_int_item* subs = malloc(sizeof(*subs) * count);
+  if(subs == NULL){
+    return -1;
+  }
+  for(unsigned c = 0 ; c < count ; ++c){
+    nctree_int_item* sub = &subs[c];
+    if((sub->curry = n->src.sub(n->src.opaque, nii->curry, c)) == NULL){
+      logerror("couldn't get item %u from source", c);
+      free(subs);
+      return -1;
+    }
+    sub->ncp = NULL;
+    sub->subs = NULL;
+    sub->subcount = 0;
+    sub->expanded = false;
+    sub->drawn = false;
+  }
+  nii->subs = subs;
+  nii->subcount = count;
+  return 0;
+}
+
+static inline unsigned
+visible_subcount(const nctree_int_item* nii){
+  return nii->expanded ? nii->subcount : 0;
+}
+
+// take a pooled plane if one is available, otherwise create one
+static ncplane*
+nctree_get_plane(nctree* n, const struct ncplane_options* nopts){
+  while(n->poolcount){
+    ncplane* ncp = n->pool[--n->poolcount];
+    if(ncplane_reparent(ncp, n->items.ncp) &&
+       !ncplane_resize_simple(ncp, nopts->rows, nopts->cols) &&
+       !ncplane_move_yx(ncp, nopts->y, nopts->x)){
+      nccell c = NCCELL_TRIVIAL_INITIALIZER;
+      ncplane_set_base_cell(ncp, &c);
+      ncplane_set_channels(ncp, 0);
+      ncplane_set_styles(ncp, NCSTYLE_NONE);
+      ncplane_erase(ncp);
+      return ncp;
+    }
+    ncplane_destroy(ncp);
+  }
+  return ncplane_create(n->items.ncp, nopts);
+}
+
+// hide a plane away for later reuse, destroying it if that's not possible
+static void
+nctree_pool_plane(nctree* n, ncplane* ncp){
+  if(n->poolpile == NULL){
+    struct ncplane_options nopts = {
+      .rows = 1,
+      .cols = 1,
+    };
+    n->poolpile = ncpile_create(ncplane_notcurses(ncp), &nopts);
+  }
+  if(n->poolpile && n->poolcount == n->poolalloc){
+    unsigned alloc = n->poolalloc ? n->poolalloc * 2 : 16;
+    ncplane** tmp = realloc(n->pool, sizeof(*tmp) * alloc);
+    if(tmp){
+      n->pool = tmp;
+      n->poolalloc = alloc;
+    }
+  }
+  if(n->poolpile == NULL || n->poolcount == n->poolalloc ||
+     ncplane_reparent(ncp, n->poolpile) == NULL){
+    ncplane_destroy(ncp);
+    return;
+  }
+  n->pool[n->poolcount++] = ncp;
+}
+
+// |nii| has been pushed offscreen; take back its plane, and let the
+// callback know.
+static void
+nctree_release(nctree* n, nctree_int_item* nii, int distance){
+  nctree_pool_plane(n, nii->ncp);
+  nii->ncp = NULL;
+  n->cbfxn(nii->ncp, nii->curry, distance);
+}
+
+// take back all planes. necessary before the items are moved in memory or
+// freed, as the lists of live items point into them.
+static void
+nctree_release_all(nctree* n){
+  for(unsigned i = 0 ; i < n->livecount ; ++i){
+    nctree_int_item* nii = n->live[i].nii;
+    if(nii->ncp){
+      nctree_release(n, nii, n->live[i].distance);
+    }
+  }
+  n->livecount = 0;
+}
+
 static void
 goto_last_item(nctree* n){
   void* prev = NULL;
@@ -135,13 +273,22 @@ prep_initial_path(nctree* n, unsigned maxdepth){
 }
 
 static nctree*
-nctree_inner_create(ncplane* n, const nctree_options* opts){
+nctree_inner_create(ncplane* n, const nctree_options* opts, const nctree_source* src){
   nctree* ret = malloc(sizeof(*ret));
   if(ret){
+    memset(ret, 0, sizeof(*ret));
     ret->cbfxn = opts->nctreecb;
     ret->indentcols = opts->indentcols;
     ret->maxdepth = 0;
-    if(dup_tree_items(&ret->items, opts->items, opts->count, 0, &ret->maxdepth)){
+    ret->items.expanded = true;
+    if(src){
+      ret->src = *src;
+      if(fetch_tree_items(ret, &ret->items)){
+        free(ret);
+        return NULL;
+      }
+      ret->maxdepth = ret->items.subcount ? 1 : 0;
+    }else if(dup_tree_items(&ret->items, opts->items, opts->count, 0, &ret->maxdepth)){
       free(ret);
       return NULL;
     }
@@ -205,6 +352,8 @@ nctree_add_internal(nctree* n, nctree_int_item* nii, const unsigned* spec,
   nii->subs[*p].subcount = 0;
   nii->subs[*p].curry = add->curry;
   nii->subs[*p].ncp = NULL;
+  nii->subs[*p].expanded = true;
+  nii->subs[*p].drawn = false;
   return 0;
 }
 
@@ -222,6 +371,11 @@ int nctree_add(nctree* n, const unsigned* spec, const struct nctree_item* add){
     logerror("invalid subcount %u", add->subcount);
     return -1;
   }
+  if(n->src.sub){
+    logerror("can't add items to a sourced tree");
+    return -1;
+  }
+  nctree_release_all(n); // the items might move
   if(nctree_add_internal(n, &n->items, spec, add)){
     return -1;
   }
@@ -237,6 +391,11 @@ int nctree_add(nctree* n, const unsigned* spec, const struct nctree_item* add){
 }
 
 int nctree_del(nctree* n, const unsigned* spec){
+  if(n->src.sub){
+    logerror("can't delete items from a sourced tree");
+    return -1;
+  }
+  nctree_release_all(n); // the items might move
   nctree_int_item* parent = NULL;
   nctree_int_item* nii = &n->items;
   const unsigned* p = spec;
@@ -265,7 +424,9 @@ int nctree_del(nctree* n, const unsigned* spec){
   return 0;
 }
 
-nctree* nctree_create(ncplane* n, const nctree_options* opts){
+static nctree*
+nctree_create_internal(ncplane* n, const nctree_options* opts,
+                       const nctree_source* src){
   if(opts->flags){
     logwarn("passed invalid flags 0x%016" PRIx64, opts->flags);
   }
@@ -281,7 +442,7 @@ nctree* nctree_create(ncplane* n, const nctree_options* opts){
     logerror("can't indent negative columns");
     goto error;
   }
-  nctree* ret = nctree_inner_create(n, opts);
+  nctree* ret = nctree_inner_create(n, opts, src);
   if(ret == NULL){
     logerror("couldn't prepare nctree");
     goto error;
@@ -293,14 +454,80 @@ error:
   return NULL;
 }
 
+nctree* nctree_create(ncplane* n, const nctree_options* opts){
+  return nctree_create_internal(n, opts, NULL);
+}
+
+nctree* nctree_create_source(ncplane* n, const nctree_options* opts,
+                             const nctree_source* src){
+  if(opts->items || opts->count){
+    logerror("items can't be provided with a source");
+    ncplane_destroy(n);
+    return NULL;
+  }
+  if(src->subcount == NULL || src->sub == NULL){
+    logerror("source lacks subcount or sub callback");
+    ncplane_destroy(n);
+    return NULL;
+  }
+  return nctree_create_internal(n, opts, src);
+}
+
 void nctree_destroy(nctree* n){
   if(n){
     free_tree_items(&n->items);
+    ncplane_destroy_family(n->poolpile, 0);
+    free(n->pool);
+    free(n->live);
+    free(n->drawn);
     free(n->currentpath);
     free(n);
   }
 }
 
+int nctree_expand(nctree* n, bool expand){
+  nctree_int_item* nii = n->curitem;
+  if(nii == NULL){
+    return -1;
+  }
+  if(nii->expanded == expand){
+    return 0;
+  }
+  if(!expand){
+    nctree_release_all(n); // descendants' planes, and maybe their memory
+    nii->expanded = false;
+    if(n->src.sub){
+      for(unsigned c = 0 ; c < nii->subcount ; ++c){
+        free_tree_items(&nii->subs[c]);
+      }
+      free(nii->subs);
+      nii->subs = NULL;
+      nii->subcount = 0;
+    }
+    return 0;
+  }
+  if(n->src.sub){
+    if(fetch_tree_items(n, nii)){
+      return -1;
+    }
+    // the children might be deeper than any item seen thus far
+    unsigned depth = tree_path_length(n->currentpath) + 1;
+    if(nii->subcount && depth > n->maxdepth){
+      unsigned* tmp = realloc(n->currentpath, sizeof(*n->currentpath) * (depth + 2));
+      if(tmp == NULL){
+        free(nii->subs);
+        nii->subs = NULL;
+        nii->subcount = 0;
+        return -1;
+      }
+      n->currentpath = tmp;
+      n->maxdepth = depth;
+    }
+  }
+  nii->expanded = true;
+  return 0;
+}
+
 // Returns the ncplane on which this nctree lives.
 ncplane* nctree_plane(nctree* n){
   return n->items.ncp;
@@ -332,7 +559,7 @@ nctree_prev_internal(nctree* n, unsigned* newpath){
     nii = &wedge->subs[newpath[idx]];
     ++idx;
 //fprintf(stderr, "nii->subcount: %u idx: %d\n", nii->subcount, idx);
-    while(nii->subcount){
+    while(visible_subcount(nii)){
       newpath[idx] = nii->subcount - 1;
       nii = &nii->subs[newpath[idx]];
       ++idx;
@@ -382,7 +609,7 @@ nctree_next_internal(nctree* n, unsigned* newpath){
     nii = &nii->subs[newpath[idx]];
     ++idx;
   }
-  if(nii->subcount){
+  if(visible_subcount(nii)){
     newpath[idx] = 0;
     newpath[idx + 1] = UINT_MAX;
     return &nii->subs[newpath[idx]];
@@ -411,15 +638,6 @@ void* nctree_next(nctree* n){
   return n->curitem->curry;
 }
 
-static int
-tree_path_length(const unsigned* path){
-  int len = 0;
-  while(path[len] != UINT_MAX){
-    ++len;
-  }
-  return len;
-}
-
 // draw the item. if *|frontiert| == *|frontierb|, we're the current item, and
 // can use all the available space. if *|frontiert| < 0, draw down from
 // *|frontierb|. otherwise, draw up from *|frontiert|.
@@ -450,7 +668,7 @@ draw_tree_item(nctree* n, nctree_int_item* nii, const unsigned* path,
       .resizecb = NULL,
       .flags = 0,
     };
-    nii->ncp = ncplane_create(n->items.ncp, &nopts);
+    nii->ncp = nctree_get_plane(n, &nopts);
     if(nii->ncp == NULL){
       return -1;
     }
@@ -462,6 +680,21 @@ draw_tree_item(nctree* n, nctree_int_item* nii, const unsigned* path,
   }else{
     ncplane_move_yx(nii->ncp, *frontierb, ncplane_x(nii->ncp));
   }
+  if(!nii->drawn){
+    if(n->drawncount == n->drawnalloc){
+      unsigned alloc = n->drawnalloc ? n->drawnalloc * 2 : 16;
+      nctree_live* tmp = realloc(n->drawn, sizeof(*tmp) * alloc);
+      if(tmp == NULL){
+        return -1;
+      }
+      n->drawn = tmp;
+      n->drawnalloc = alloc;
+    }
+    n->drawn[n->drawncount].nii = nii;
+    n->drawn[n->drawncount].distance = distance;
+    ++n->drawncount;
+    nii->drawn = true;
+  }
   int ret = n->cbfxn(nii->ncp, nii->curry, distance);
   if(ret < 0){
     return -1;
@@ -477,40 +710,27 @@ draw_tree_item(nctree* n, nctree_int_item* nii, const unsigned* path,
   return 0;
 }
 
-// iterate backwards from tmppath, destroying any ncplanes we find. they've
-// been pushed off-screen. tmppath is changed as we iterate. nii will not be
-// destroyed, only items above nii.
-static int
-destroy_above(nctree* n, nctree_int_item* nii, unsigned* path, int distance){
-  nctree_int_item* tmpnii;
-  while((tmpnii = nctree_prev_internal(n, path)) != nii){
-    nii = tmpnii;
-    --distance;
-    if(nii->ncp){
-      ncplane_destroy(nii->ncp);
-      nii->ncp = NULL;
-      n->cbfxn(nii->ncp, nii->curry, distance);
+// items which held planes as of the last redraw, but weren't drawn during
+// this one, have been pushed offscreen. the items drawn become the live set.
+static void
+nctree_sweep(nctree* n){
+  for(unsigned i = 0 ; i < n->livecount ; ++i){
+    nctree_int_item* nii = n->live[i].nii;
+    if(!nii->drawn && nii->ncp){
+      nctree_release(n, nii, n->live[i].distance);
     }
   }
-  return 0;
-}
-
-// iterate forwards from tmppath, destroying any ncplanes we find. they've
-// been pushed off-screen. tmppath is changed as we iterate. nii will not be
-// destroyed, only items below nii.
-static int
-destroy_below(nctree* n, nctree_int_item* nii, unsigned* path, int distance){
-  nctree_int_item* tmpnii;
-  while((tmpnii = nctree_next_internal(n, path)) != nii){
-    nii = tmpnii;
-    ++distance;
-    if(nii->ncp){
-      ncplane_destroy(nii->ncp);
-      nii->ncp = NULL;
-      n->cbfxn(nii->ncp, nii->curry, distance);
-    }
+  nctree_live* tmp = n->live;
+  unsigned tmpalloc = n->livealloc;
+  n->live = n->drawn;
+  n->livealloc = n->drawnalloc;
+  n->livecount = n->drawncount;
+  n->drawn = tmp;
+  n->drawnalloc = tmpalloc;
+  n->drawncount = 0;
+  for(unsigned i = 0 ; i < n->livecount ; ++i){
+    n->live[i].nii->drawn = false;
   }
-  return 0;
 }
 
 // tmppath ought be initialized with currentpath, but having size sufficient
@@ -528,9 +748,10 @@ nctree_inner_redraw(nctree* n, unsigned* tmppath){
   int frontierb = n->activerow;
   nctree_int_item* nii = n->curitem;
   int distance = 0;
+  int ret = -1;
   // draw the focused item
   if(draw_tree_item(n, nii, tmppath, &frontiert, &frontierb, distance)){
-    return -1;
+    goto done;
   }
   nctree_int_item* tmpnii;
   // draw items above the current one
@@ -541,10 +762,9 @@ nctree_inner_redraw(nctree* n, unsigned* tmppath){
     nii = tmpnii;
     --distance;
     if(draw_tree_item(n, nii, tmppath, &frontiert, &frontierb, distance)){
-      return -1;
+      goto done;
     }
   }
-  destroy_above(n, nii, tmppath, distance);
   // move items up if there is a gap at the top FIXME
   if(frontiert >= 0){
   }
@@ -560,11 +780,16 @@ nctree_inner_redraw(nctree* n, unsigned* tmppath){
     nii = tmpnii;
     ++distance;
     if(draw_tree_item(n, nii, tmppath, &frontiert, &frontierb, distance)){
-      return -1;
+      goto done;
     }
   }
-  destroy_below(n, nii, tmppath, distance);
-  return 0;
+  ret = 0;
+
+done:
+  // on failure, items not drawn will lose their planes. that's no worse than
+  // the state we're already in.
+  nctree_sweep(n);
+  return ret;
 }
 
 int nctree_redraw(nctree* n){
@@ -600,8 +825,13 @@ bool nctree_offer_input(nctree* n, const ncinput* ni){
   }else if(ni->id == NCKEY_END){
     goto_last_item(n);
     return true;
+  }else if(ni->id == NCKEY_RIGHT || ni->id == '+'){
+    nctree_expand(n, true);
+    return true;
+  }else if(ni->id == NCKEY_LEFT || ni->id == '-'){
+    nctree_expand(n, false);
+    return true;
   }
-  // FIXME implement left, right, +, - (expand/collapse)
   return false;
 }
 
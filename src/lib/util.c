@@ -1,5 +1,7 @@
+#include <ctype.h>
 #ifndef __MINGW32__
 #include <pwd.h>
+#include <sched.h>
 #include <unistd.h>
 #if defined(__linux__) || defined(__gnu_hurd__)
 #include <sys/utsname.h>
@@ -8,6 +10,9 @@
 #include <sys/sysctl.h>
 #include <sys/utsname.h>
 #endif
+#ifdef __FreeBSD__
+#include <pthread_np.h>
+#endif
 #else
 #include <winsock2.h>
 #define SECURITY_WIN32
@@ -32,6 +37,166 @@ int set_loglevel_from_env(ncloglevel_e* llptr){
   return 0;
 }
 
+// prefer our affinity mask where we can get it, so that a process pinned to
+// a subset of the machine doesn't oversubscribe its processors.
+unsigned host_cpu_count(void){
+#ifndef __MINGW32__
+#if defined(__linux__)
+  cpu_set_t cset;
+  if(sched_getaffinity(0, sizeof(cset), &cset) == 0){
+    int affine = CPU_COUNT(&cset);
+    if(affine > 0){
+      return affine;
+    }
+  }
+#endif
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  if(cpus < 1){
+    logwarn("couldn't get processor count (%s)", strerror(errno));
+    return 1;
+  }
+  return cpus;
+#else
+  SYSTEM_INFO sinfo;
+  GetSystemInfo(&sinfo);
+  return sinfo.dwNumberOfProcessors ? sinfo.dwNumberOfProcessors : 1;
+#endif
+}
+
+// look up NOTCURSES_<ROLE>_<KNOB>, falling back to NOTCURSES_THREAD_<KNOB>.
+static const char*
+thread_env(const char* role, const char* knob, char* var, size_t varlen){
+  int n = snprintf(var, varlen, "NOTCURSES_%s_%s", role, knob);
+  if(n > 0 && (size_t)n < varlen){
+    for(char* c = var + strlen("NOTCURSES_") ; *c != '_' ; ++c){
+      *c = toupper((unsigned char)*c);
+    }
+    const char* v = getenv(var);
+    if(v){
+      return v;
+    }
+  }
+  snprintf(var, varlen, "NOTCURSES_THREAD_%s", knob);
+  return getenv(var);
+}
+
+#ifndef __MINGW32__
+// apply a scheduling spec: "other", "batch", "idle", "fifo:PRIO", or
+// "rr:PRIO". real-time policies generally require privilege.
+static void
+thread_sched(const char* var, const char* spec){
+  static const struct {
+    const char* name;
+    int policy;
+  } policies[] = {
+    { "other", SCHED_OTHER, },
+    { "fifo", SCHED_FIFO, },
+    { "rr", SCHED_RR, },
+#ifdef SCHED_BATCH
+    { "batch", SCHED_BATCH, },
+#endif
+#ifdef SCHED_IDLE
+    { "idle", SCHED_IDLE, },
+#endif
+  };
+  const char* colon = strchr(spec, ':');
+  const size_t nlen = colon ? (size_t)(colon - spec) : strlen(spec);
+  for(size_t i = 0 ; i < sizeof(policies) / sizeof(*policies) ; ++i){
+    if(strlen(policies[i].name) != nlen || strncmp(spec, policies[i].name, nlen)){
+      continue;
+    }
+    struct sched_param param = { .sched_priority = 0, };
+    if(colon){
+      char* endl;
+      long prio = strtol(colon + 1, &endl, 10);
+      if(!colon[1] || *endl || prio < sched_get_priority_min(policies[i].policy) ||
+         prio > sched_get_priority_max(policies[i].policy)){
+        logwarn("ignoring invalid priority in %s: %s", var, spec);
+        return;
+      }
+      param.sched_priority = prio;
+    }
+    int e = pthread_setschedparam(pthread_self(), policies[i].policy, &param);
+    if(e){
+      logwarn("couldn't apply %s=%s (%s)", var, spec, strerror(e));
+    }
+    return;
+  }
+  logwarn("ignoring invalid %s: %s", var, spec);
+}
+
+// apply a processor list such as "2" or "0,4-7".
+static void
+thread_cpus(const char* var, const char* spec){
+#ifdef __linux__
+  cpu_set_t cset;
+  CPU_ZERO(&cset);
+  const char* c = spec;
+  while(*c){
+    char* endl;
+    unsigned long lo = strtoul(c, &endl, 10);
+    unsigned long hi = lo;
+    if(endl == c){
+      break;
+    }
+    if(*endl == '-'){
+      c = endl + 1;
+      hi = strtoul(c, &endl, 10);
+      if(endl == c){
+        break;
+      }
+    }
+    if(lo > hi || hi >= CPU_SETSIZE){
+      break;
+    }
+    for(unsigned long cpu = lo ; cpu <= hi ; ++cpu){
+      CPU_SET(cpu, &cset);
+    }
+    c = endl;
+    if(*c == ','){
+      ++c;
+    }else if(*c){
+      break;
+    }
+  }
+  if(*c || CPU_COUNT(&cset) == 0){
+    logwarn("ignoring invalid %s: %s", var, spec);
+    return;
+  }
+  int e = pthread_setaffinity_np(pthread_self(), sizeof(cset), &cset);
+  if(e){
+    logwarn("couldn't apply %s=%s (%s)", var, spec, strerror(e));
+  }
+#else
+  logwarn("%s=%s: processor affinity is unsupported here", var, spec);
+#endif
+}
+#endif
+
+void nc_thread_setup(const char* role){
+#ifndef __MINGW32__
+  char name[16]; // linux limits thread names to 15 characters
+  snprintf(name, sizeof(name), "nc-%s", role);
+#if defined(__linux__)
+  pthread_setname_np(pthread_self(), name);
+#elif defined(__APPLE__)
+  pthread_setname_np(name);
+#elif defined(__FreeBSD__)
+  pthread_set_name_np(pthread_self(), name);
+#endif
+  char var[64];
+  const char* spec;
+  if( (spec = thread_env(role, "SCHED", var, sizeof(var))) ){
+    thread_sched(var, spec);
+  }
+  if( (spec = thread_env(role, "CPUS", var, sizeof(var))) ){
+    thread_cpus(var, spec);
+  }
+#else
+  (void)role;
+#endif
+}
+
 char* notcurses_accountname(void){
 #ifndef __MINGW32__
   const char* un;
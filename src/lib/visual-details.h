@@ -26,15 +26,52 @@ typedef struct ncvisual {
   // lines are sometimes padded. this many true bytes per row in data.
   unsigned rowstride;
   bool owndata; // we own data iff owndata == true
+  // data lent to us by ncvisual_from_rgba_borrowed() is handed back through
+  // release() (if provided) once we no longer need it.
+  bool borrowed;
+  void (*release)(void* data, void* curry);
+  void* releasecurry;
+  // the buffer displaced by the last ncvisual_rotate(), kept to receive the
+  // next rotation. |sparelen| is its size in pixels.
+  uint32_t* spare;
+  size_t sparelen;
+  // NCVISUAL_OPTION_ADAPTIVE state (see ncvisual_adapt()). the costs are
+  // those of our most recent NCBLIT_PIXEL blits.
+  uint64_t lastblitns;  // when we were last blitted (CLOCK_MONOTONIC)
+  uint64_t periodns;    // moving average of the time between blits
+  uint64_t pxencodens;  // moving average of the time to encode a bitmap
+  size_t pxbytes;       // size of our last bitmap
+  bool pxdegraded;      // using cells until bitmaps fit in the period again
 } ncvisual;
 
+// give up our current data: free it if it's ours, or return it to the
+// lender if it's borrowed.
 static inline void
-ncvisual_set_data(ncvisual* ncv, void* data, bool owned){
-//fprintf(stderr, "replacing %p with %p (%u -> %u)\n", ncv->data, data, ncv->owndata, owned);
+ncvisual_drop_data(ncvisual* ncv){
   if(ncv->owndata){
-    if(data != ncv->data){
-      free(ncv->data);
+    free(ncv->data);
+  }else if(ncv->borrowed){
+    if(ncv->release){
+      ncv->release(ncv->data, ncv->releasecurry);
     }
+    ncv->borrowed = false;
+    ncv->release = NULL;
+  }
+}
+
+// free the buffer kept by ncvisual_rotate(). call when destroying |ncv|.
+static inline void
+ncvisual_drop_spare(ncvisual* ncv){
+  free(ncv->spare);
+  ncv->spare = NULL;
+  ncv->sparelen = 0;
+}
+
+static inline void
+ncvisual_set_data(ncvisual* ncv, void* data, bool owned){
+//fprintf(stderr, "replacing %p with %p (%u -> %u)\n", ncv->data, data, ncv->owndata, owned);
+  if(data != ncv->data){
+    ncvisual_drop_data(ncv);
   }
   ncv->data = (uint32_t*)data;
   ncv->owndata = owned;
@@ -50,17 +50,51 @@ int ncvisual_decode_loop(ncvisual* nc){
   return visual_implementation->visual_decode_loop(nc);
 }
 
-ncvisual* ncvisual_from_file(const char* filename){
+int ncvisual_set_loopcache(ncvisual* nc, size_t maxbytes){
+  if(!visual_implementation->visual_loopcache){
+    logerror("multimedia engine can't cache loops");
+    return -1;
+  }
+  return visual_implementation->visual_loopcache(nc, maxbytes);
+}
+
+int ncvisual_seek(ncvisual* nc, uint64_t ns, uint64_t flags){
+  if(!visual_implementation->visual_seek){
+    logerror("multimedia engine can't seek");
+    return -1;
+  }
+  return visual_implementation->visual_seek(nc, ns, flags);
+}
+
+int ncvisual_position(const ncvisual* nc, uint64_t* ns){
+  if(!visual_implementation->visual_position){
+    return -1;
+  }
+  return visual_implementation->visual_position(nc, ns);
+}
+
+static ncvisual*
+ncvisual_open(const char* filename, unsigned minpixy, unsigned minpixx){
   if(!visual_implementation->visual_from_file){
     return NULL;
   }
-  ncvisual* n = visual_implementation->visual_from_file(filename);
+  ncvisual* n = visual_implementation->visual_from_file(filename, minpixy, minpixx);
   if(n == NULL){
     logerror("error loading %s", filename);
   }
   return n;
 }
 
+ncvisual* ncvisual_from_file(const char* filename){
+  return ncvisual_open(filename, UINT_MAX, UINT_MAX);
+}
+
+ncvisual* ncvisual_from_file_sized(const char* filename, unsigned minpixy,
+                                   unsigned minpixx){
+  // no bound still requires a pixel
+  return ncvisual_open(filename, minpixy ? minpixy : 1, minpixx ? minpixx : 1);
+}
+
 int ncvisual_stream(notcurses* nc, ncvisual* ncv, float timescale,
                     ncstreamcb streamer, const struct ncvisual_options* vopts,
                     void* curry){
@@ -81,6 +115,169 @@ ncplane* ncvisual_subtitle_plane(ncplane* parent, const ncvisual* ncv){
   return visual_implementation->visual_subtitle(parent, ncv);
 }
 
+int ncvisual_subtitle_update(ncplane* parent, const ncvisual* ncv, ncplane** subp){
+  if(!visual_implementation->visual_subtitle_update){
+    ncplane_destroy(*subp);
+    *subp = ncvisual_subtitle_plane(parent, ncv);
+    return 0;
+  }
+  return visual_implementation->visual_subtitle_update(parent, ncv, subp);
+}
+
+// destination rows are resized in bands of this many, the unit of work when
+// farmed out to the render engine
+#define RESIZE_BAND_ROWS 32
+
+typedef struct resizejob {
+  const uint32_t* src;
+  uint32_t* dst;          // holds only destination rows [dbeg, dend)
+  size_t sstride, dstride; // in pixels
+  int dbeg, dend;
+  bool area;
+  // for each destination row and column, the source row or column it takes
+  // (naive resize), or where its footprint begins (area averaging, in which
+  // case there's one more entry, where the last footprint ends).
+  const int* ymap;
+  const int* xmap;
+  int dcols;
+} resizejob;
+
+// the source index taken by each of |dlen| destination indices in a naive
+// resize. this is exactly the selection/duplication of our original, per-pixel
+// implementation, computed once rather than for every row.
+static void
+resize_nearest_map(int* map, int slen, int dlen){
+  float rat = (float)dlen / slen;
+  int d = 0;
+  for(int s = 0 ; s < slen && d < dlen ; ++s){
+    float targ = (s + 1) * rat;
+    if(targ > dlen){
+      targ = dlen;
+    }
+    while(targ > d){
+      map[d++] = s;
+    }
+  }
+  while(d < dlen){ // guard against float shortfall
+    map[d++] = slen - 1;
+  }
+}
+
+// the start of each destination index's footprint in an area-averaging
+// resize, plus the end of the last.
+static void
+resize_area_map(int* map, int slen, int dlen){
+  for(int d = 0 ; d <= dlen ; ++d){
+    map[d] = (int64_t)d * slen / dlen;
+  }
+}
+
+// the end of footprint |d|. when inflating, a footprint can be empty; such a
+// destination pixel takes its single source pixel.
+static inline int
+resize_area_end(const int* map, int d){
+  return map[d + 1] > map[d] ? map[d + 1] : map[d] + 1;
+}
+
+static void
+resize_band(void* vjob, unsigned band, unsigned bands){
+  const resizejob* j = vjob;
+  const int rows = j->dend - j->dbeg;
+  const int beg = j->dbeg + (int64_t)rows * band / bands;
+  const int end = j->dbeg + (int64_t)rows * (band + 1) / bands;
+  for(int dy = beg ; dy < end ; ++dy){
+    uint32_t* drow = j->dst + (dy - j->dbeg) * j->dstride;
+    if(!j->area){
+      const uint32_t* srow = j->src + j->ymap[dy] * j->sstride;
+      for(int dx = 0 ; dx < j->dcols ; ++dx){
+        drow[dx] = srow[j->xmap[dx]];
+      }
+      continue;
+    }
+    const int y0 = j->ymap[dy];
+    const int y1 = resize_area_end(j->ymap, dy);
+    for(int dx = 0 ; dx < j->dcols ; ++dx){
+      const int x0 = j->xmap[dx];
+      const int x1 = resize_area_end(j->xmap, dx);
+      uint64_t r = 0, g = 0, b = 0, a = 0;
+      for(int y = y0 ; y < y1 ; ++y){
+        const uint32_t* srow = j->src + y * j->sstride;
+        for(int x = x0 ; x < x1 ; ++x){
+          const unsigned pa = ncpixel_a(srow[x]);
+          r += ncpixel_r(srow[x]) * pa;
+          g += ncpixel_g(srow[x]) * pa;
+          b += ncpixel_b(srow[x]) * pa;
+          a += pa;
+        }
+      }
+      if(a == 0){
+        drow[dx] = 0;
+      }else{
+        const unsigned count = (y1 - y0) * (x1 - x0);
+        drow[dx] = ncpixel(r / a, g / a, b / a);
+        ncpixel_set_a(&drow[dx], a / count);
+      }
+    }
+  }
+}
+
+uint32_t* resize_bitmap_rows(const uint32_t* bmap, int srows, int scols,
+                             size_t sstride, int drows, int dcols,
+                             size_t dstride, int dbeg, int dend, bool area,
+                             struct render_engine* re){
+  if(sstride < scols * sizeof(*bmap) || sstride % sizeof(*bmap)){
+    return NULL;
+  }
+  if(dstride < dcols * sizeof(*bmap) || dstride % sizeof(*bmap)){
+    return NULL;
+  }
+  if(srows <= 0 || scols <= 0 || drows <= 0 || dcols <= 0){
+    return NULL;
+  }
+  if(dbeg < 0 || dend > drows || dbeg > dend){
+    return NULL;
+  }
+  uint32_t* ret = malloc((dend - dbeg) * dstride);
+  if(ret == NULL){
+    return NULL;
+  }
+  const arenamark mark = arena_mark();
+  int* ymap = arena_alloc(sizeof(*ymap) * (drows + 1));
+  int* xmap = arena_alloc(sizeof(*xmap) * (dcols + 1));
+  if(ymap == NULL || xmap == NULL){
+    arena_release(mark);
+    free(ret);
+    return NULL;
+  }
+  if(area){
+    resize_area_map(ymap, srows, drows);
+    resize_area_map(xmap, scols, dcols);
+  }else{
+    resize_nearest_map(ymap, srows, drows);
+    resize_nearest_map(xmap, scols, dcols);
+  }
+  resizejob job = {
+    .src = bmap,
+    .dst = ret,
+    .sstride = sstride / sizeof(*bmap),
+    .dstride = dstride / sizeof(*ret),
+    .dbeg = dbeg,
+    .dend = dend,
+    .area = area,
+    .ymap = ymap,
+    .xmap = xmap,
+    .dcols = dcols,
+  };
+  const unsigned bands = (dend - dbeg + RESIZE_BAND_ROWS - 1) / RESIZE_BAND_ROWS;
+  int64_t maxns = 0;
+  uint64_t sumns = 0;
+  if(bands < 2 || render_engine_run(re, bands, resize_band, &job, &maxns, &sumns)){
+    resize_band(&job, 0, 1);
+  }
+  arena_release(mark);
+  return ret;
+}
+
 int ncvisual_blit_internal(const ncvisual* ncv, int rows, int cols, ncplane* n,
                            const struct blitset* bset, const blitterargs* barg){
   if(!(barg->flags & NCVISUAL_OPTION_NOINTERPOLATE)){
@@ -93,8 +290,11 @@ int ncvisual_blit_internal(const ncvisual* ncv, int rows, int cols, ncplane* n,
   }
   // generic implementation
   int stride = 4 * cols;
-  uint32_t* data = resize_bitmap(ncv->data, ncv->pixy, ncv->pixx,
-                                 ncv->rowstride, rows, cols, stride);
+  const bool area = (barg->flags & NCVISUAL_OPTION_SCALEAREA) &&
+                    !(barg->flags & NCVISUAL_OPTION_NOINTERPOLATE);
+  uint32_t* data = resize_bitmap_rows(ncv->data, ncv->pixy, ncv->pixx,
+                                      ncv->rowstride, rows, cols, stride,
+                                      0, rows, area, ncplane_render_engine(n));
   if(data == NULL){
     return -1;
   }
@@ -108,6 +308,53 @@ int ncvisual_blit_internal(const ncvisual* ncv, int rows, int cols, ncplane* n,
   return ret;
 }
 
+// the generic path produces exactly those rows of the full scaling. an engine
+// is handed just the source rows which map onto the band, so its
+// interpolation can differ slightly at band edges from that of a full blit.
+int ncvisual_blit_rows(const ncvisual* ncv, int rows, int cols,
+                       int dbeg, int dend, ncplane* n,
+                       const struct blitset* bset, const blitterargs* barg){
+  if(dbeg < 0 || dend > rows || dbeg >= dend){
+    return -1;
+  }
+  if(!(barg->flags & NCVISUAL_OPTION_NOINTERPOLATE)){
+    if(visual_implementation->visual_blit){
+      int sbeg = (int64_t)dbeg * ncv->pixy / rows;
+      int send = ((int64_t)dend * ncv->pixy + rows - 1) / rows;
+      if(send > (int)ncv->pixy){
+        send = ncv->pixy;
+      }
+      if(send <= sbeg){
+        send = sbeg + 1;
+      }
+      const char* src = (const char*)ncv->data + (size_t)sbeg * ncv->rowstride;
+      ncvisual* band = ncvisual_from_rgba_borrowed(src, send - sbeg, ncv->rowstride,
+                                                   ncv->pixx, NULL, NULL);
+      if(band == NULL){
+        return -1;
+      }
+      int ret = visual_implementation->visual_blit(band, dend - dbeg, cols, n, bset, barg);
+      ncvisual_destroy(band);
+      return ret < 0 ? -1 : 0;
+    }
+  }
+  int stride = 4 * cols;
+  const bool area = (barg->flags & NCVISUAL_OPTION_SCALEAREA) &&
+                    !(barg->flags & NCVISUAL_OPTION_NOINTERPOLATE);
+  uint32_t* data = resize_bitmap_rows(ncv->data, ncv->pixy, ncv->pixx,
+                                      ncv->rowstride, rows, cols, stride,
+                                      dbeg, dend, area, NULL);
+  if(data == NULL){
+    return -1;
+  }
+  int ret = -1;
+  if(rgba_blit_dispatch(n, bset, stride, data, dend - dbeg, cols, barg) >= 0){
+    ret = 0;
+  }
+  free(data);
+  return ret;
+}
+
 // ncv constructors other than ncvisual_from_file() need to set up the
 // AVFrame* 'frame' according to their own data, which is assumed to
 // have been prepared already in 'ncv'.
@@ -221,9 +468,16 @@ int ncvisual_geom_inner(const tinfo* ti, const ncvisual* n,
     vopts = &fakevopts;
   }
   // check basic vopts preconditions
-  if(vopts->flags >= (NCVISUAL_OPTION_NOINTERPOLATE << 1u)){
+  if(vopts->flags >= (NCVISUAL_OPTION_ADAPTIVE << 1u)){
     logwarn("warning: unknown ncvisual options %016" PRIx64, vopts->flags);
   }
+  const uint64_t scalequality = vopts->flags & (NCVISUAL_OPTION_SCALEFAST |
+                                                NCVISUAL_OPTION_SCALEAREA |
+                                                NCVISUAL_OPTION_SCALEFINE);
+  if(scalequality & (scalequality - 1)){
+    logerror("requested multiple scaling qualities");
+    return -1;
+  }
   if((vopts->flags & NCVISUAL_OPTION_CHILDPLANE) && !vopts->n){
     logerror("requested child plane with NULL n");
     return -1;
@@ -258,9 +512,18 @@ int ncvisual_geom_inner(const tinfo* ti, const ncvisual* n,
   const ncpile* p = vopts->n ? ncplane_pile_const(vopts->n) : NULL;
   geom->cdimy = p ? p->cellpxy : ti->cellpxy;
   geom->cdimx = p ? p->cellpxx : ti->cellpxx;
+  // a tiled bitmap (see ncvisual_render_tiles()) is held to the terminal's
+  // maximum bitmap geometry only tile by tile, not as a whole.
+  tinfo tiledti;
   if((geom->blitter = (*bset)->geom) == NCBLIT_PIXEL){
     geom->maxpixely = ti->sixel_maxy;
     geom->maxpixelx = ti->sixel_maxx;
+    if(vopts->flags & NCVISUAL_OPTION_TILED){
+      memcpy(&tiledti, ti, sizeof(tiledti));
+      tiledti.sixel_maxy = 0;
+      tiledti.sixel_maxx = 0;
+      ti = &tiledti;
+    }
   }
   geom->scaley = encoding_y_scale(ti, *bset);
   geom->scalex = encoding_x_scale(ti, *bset);
@@ -458,6 +721,126 @@ int ncvisual_geom(const notcurses* nc, const ncvisual* n,
                              &disppxy, &disppxx, &outy, &outx, &placey, &placex);
 }
 
+// conversions to RGBA are described by a per-pixel byte pattern, naming the
+// source byte for each byte of the output pixel (or PIXZERO for none). the
+// pattern is expanded across four pixels, so that sixteen bytes of output can
+// be shuffled at once where the hardware allows (tbl on aarch64, pshufb on
+// x86 with SSSE3, selected at runtime). alpha is then masked in.
+#define PIXZERO 0x80
+
+static const unsigned char bgra_pattern[4] = { 2, 1, 0, 3 };
+static const unsigned char rgbx_pattern[4] = { 0, 1, 2, 3 };
+static const unsigned char rgb_pattern[4] = { 0, 1, 2, PIXZERO };
+
+typedef struct pixconv {
+  unsigned char shuf[16]; // pattern expanded over four pixels
+  unsigned srcbpp;        // bytes per source pixel, 3 or 4
+  uint32_t amask;         // ANDed into each output pixel
+  uint32_t aval;          // and then ORed in
+} pixconv;
+
+// a negative |alpha| retains the alpha of the source
+static void
+pixconv_init(pixconv* pc, const unsigned char pattern[static 4],
+             unsigned srcbpp, int alpha){
+  for(unsigned p = 0 ; p < 4 ; ++p){
+    for(unsigned b = 0 ; b < 4 ; ++b){
+      pc->shuf[p * 4 + b] = pattern[b] == PIXZERO ? PIXZERO : pattern[b] + p * srcbpp;
+    }
+  }
+  pc->srcbpp = srcbpp;
+  pc->amask = ~0u;
+  pc->aval = 0;
+  if(alpha >= 0){
+    ncpixel_set_a(&pc->amask, 0);
+    ncpixel_set_a(&pc->aval, alpha);
+  }
+}
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PIXCONV_NEON
+
+static int
+pixconv_row_simd(const pixconv* pc, uint32_t* dst, const unsigned char* src, int cols){
+  const uint8x16_t shuf = vld1q_u8(pc->shuf);
+  const uint32x4_t amask = vdupq_n_u32(pc->amask);
+  const uint32x4_t aval = vdupq_n_u32(pc->aval);
+  int x = 0;
+  // each load is sixteen bytes, which mustn't run past the row
+  while((cols - x) * pc->srcbpp >= 16){
+    uint32x4_t v = vreinterpretq_u32_u8(vqtbl1q_u8(vld1q_u8(src + x * pc->srcbpp), shuf));
+    vst1q_u32(dst + x, vorrq_u32(vandq_u32(v, amask), aval));
+    x += 4;
+  }
+  return x;
+}
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <tmmintrin.h>
+#define PIXCONV_SSSE3
+
+__attribute__ ((target ("ssse3"))) static int
+pixconv_row_simd(const pixconv* pc, uint32_t* dst, const unsigned char* src, int cols){
+  const __m128i shuf = _mm_loadu_si128((const __m128i*)pc->shuf);
+  const __m128i amask = _mm_set1_epi32(pc->amask);
+  const __m128i aval = _mm_set1_epi32(pc->aval);
+  int x = 0;
+  // each load is sixteen bytes, which mustn't run past the row
+  while((cols - x) * pc->srcbpp >= 16){
+    __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + x * pc->srcbpp)), shuf);
+    _mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(_mm_and_si128(v, amask), aval));
+    x += 4;
+  }
+  return x;
+}
+
+static inline bool
+pixconv_ssse3_p(void){
+#ifdef __SSSE3__
+  return true;
+#else
+  return __builtin_cpu_supports("ssse3");
+#endif
+}
+#endif
+
+// convert a row of |cols| pixels. |dst| may be |src| if the source has four
+// bytes per pixel, but mustn't otherwise overlap it.
+static void
+pixconv_row(const pixconv* pc, uint32_t* dst, const unsigned char* src, int cols){
+  int x = 0;
+#if defined(PIXCONV_NEON)
+  x = pixconv_row_simd(pc, dst, src, cols);
+#elif defined(PIXCONV_SSSE3)
+  if(pixconv_ssse3_p()){
+    x = pixconv_row_simd(pc, dst, src, cols);
+  }
+#endif
+  for( ; x < cols ; ++x){
+    const unsigned char* s = src + x * pc->srcbpp;
+    unsigned char px[4];
+    for(unsigned b = 0 ; b < 4 ; ++b){
+      px[b] = pc->shuf[b] == PIXZERO ? 0 : s[pc->shuf[b]];
+    }
+    uint32_t v;
+    memcpy(&v, px, sizeof(v));
+    dst[x] = (v & pc->amask) | pc->aval;
+  }
+}
+
+// convert |rows| rows of |cols| pixels into a new, tightly-packed buffer,
+// allocated from the arena
+static uint32_t*
+pixconv_copy(const pixconv* pc, const void* data, int rows, int rowstride, int cols){
+  uint32_t* ret = arena_alloc(4 * (size_t)cols * rows);
+  if(ret){
+    for(int y = 0 ; y < rows ; ++y){
+      pixconv_row(pc, ret + cols * y, (const unsigned char*)data + rowstride * y, cols);
+    }
+  }
+  return ret;
+}
+
 void* rgb_loose_to_rgba(const void* data, int rows, int* rowstride, int cols, int alpha){
   if(*rowstride % 4){ // must be a multiple of 4 bytes
     return NULL;
@@ -465,19 +848,9 @@ void* rgb_loose_to_rgba(const void* data, int rows, int* rowstride, int cols, in
   if(*rowstride < cols * 4){
     return NULL;
   }
-  uint32_t* ret = malloc(4 * cols * rows);
-  if(ret){
-    for(int y = 0 ; y < rows ; ++y){
-      for(int x = 0 ; x < cols ; ++x){
-        const uint32_t* src = (const uint32_t*)data + (*rowstride / 4) * y + x;
-        uint32_t* dst = ret + cols * y + x;
-        ncpixel_set_a(dst, alpha);
-        ncpixel_set_r(dst, ncpixel_r(*src));
-        ncpixel_set_g(dst, ncpixel_g(*src));
-        ncpixel_set_b(dst, ncpixel_b(*src));
-      }
-    }
-  }
+  pixconv pc;
+  pixconv_init(&pc, rgbx_pattern, 4, alpha);
+  uint32_t* ret = pixconv_copy(&pc, data, rows, *rowstride, cols);
   *rowstride = cols * 4;
   return ret;
 }
@@ -486,19 +859,9 @@ void* rgb_packed_to_rgba(const void* data, int rows, int* rowstride, int cols, i
   if(*rowstride < cols * 3){
     return NULL;
   }
-  uint32_t* ret = malloc(4 * cols * rows);
-  if(ret){
-    for(int y = 0 ; y < rows ; ++y){
-      for(int x = 0 ; x < cols ; ++x){
-        const unsigned char* src = (const unsigned char*)data + *rowstride * y + x;
-        uint32_t* dst = ret + cols * y + x;
-        ncpixel_set_a(dst, alpha);
-        ncpixel_set_r(dst, src[0]);
-        ncpixel_set_g(dst, src[1]);
-        ncpixel_set_b(dst, src[2]);
-      }
-    }
-  }
+  pixconv pc;
+  pixconv_init(&pc, rgb_pattern, 3, alpha);
+  uint32_t* ret = pixconv_copy(&pc, data, rows, *rowstride, cols);
   *rowstride = cols * 4;
   return ret;
 }
@@ -510,19 +873,9 @@ void* bgra_to_rgba(const void* data, int rows, int* rowstride, int cols, int alp
   if(*rowstride < cols * 4){
     return NULL;
   }
-  uint32_t* ret = malloc(4 * cols * rows);
-  if(ret){
-    for(int y = 0 ; y < rows ; ++y){
-      for(int x = 0 ; x < cols ; ++x){
-        const uint32_t* src = (const uint32_t*)data + (*rowstride / 4) * y + x;
-        uint32_t* dst = ret + cols * y + x;
-        ncpixel_set_a(dst, alpha);
-        ncpixel_set_r(dst, ncpixel_b(*src));
-        ncpixel_set_g(dst, ncpixel_g(*src));
-        ncpixel_set_b(dst, ncpixel_r(*src));
-      }
-    }
-  }
+  pixconv pc;
+  pixconv_init(&pc, bgra_pattern, 4, alpha);
+  uint32_t* ret = pixconv_copy(&pc, data, rows, *rowstride, cols);
   *rowstride = cols * 4;
   return ret;
 }
@@ -624,16 +977,6 @@ int ncvisual_bounding_box(const ncvisual* ncv, int* leny, int* lenx,
   return *leny * *lenx;
 }
 
-// find the "center" cell of a visual. in the case of even rows/columns, we
-// place the center on the top/left. in such a case there will be one more
-// cell to the bottom/right of the center.
-static inline void
-ncvisual_center(const ncvisual* n, int* RESTRICT y, int* RESTRICT x){
-  *y = n->pixy;
-  *x = n->pixx;
-  center_box(y, x);
-}
-
 // rotate the 0-indexed (origin-indexed) ['y', 'x'] through 'ctheta' and
 // 'stheta' around the centerpoint at ['centy', 'centx']. write the results
 // back to 'y' and 'x'.
@@ -701,14 +1044,80 @@ rotate_bounding_box(double stheta, double ctheta, int* leny, int* lenx,
   return *leny * *lenx;
 }
 
-int ncvisual_rotate(ncvisual* ncv, double rads){
+// source positions are stepped through in 16.16 fixed point while rotating
+#define ROT_FRACBITS 16
+#define ROT_ONE (1ll << ROT_FRACBITS)
+
+// sample |ncv| at the fixed-point source position |fy|, |fx| by bilinear
+// interpolation. taps beyond the visual are transparent. colors are weighted
+// by alpha, lest transparent pixels bleed into their neighbors.
+static inline uint32_t
+rotate_bilinear(const ncvisual* ncv, int64_t fy, int64_t fx){
+  const int64_t y0 = fy >> ROT_FRACBITS;
+  const int64_t x0 = fx >> ROT_FRACBITS;
+  const unsigned wy = (fy >> (ROT_FRACBITS - 8)) & 0xff;
+  const unsigned wx = (fx >> (ROT_FRACBITS - 8)) & 0xff;
+  const unsigned w[4] = {
+    (256 - wy) * (256 - wx), (256 - wy) * wx, wy * (256 - wx), wy * wx,
+  };
+  uint64_t r = 0, g = 0, b = 0, a = 0;
+  for(int t = 0 ; t < 4 ; ++t){
+    const int64_t y = y0 + t / 2;
+    const int64_t x = x0 + t % 2;
+    if(w[t] == 0 || y < 0 || x < 0 || y >= ncv->pixy || x >= ncv->pixx){
+      continue;
+    }
+    const uint32_t p = ncv->data[y * (ncv->rowstride / 4) + x];
+    const uint64_t wa = (uint64_t)w[t] * ncpixel_a(p);
+    r += wa * ncpixel_r(p);
+    g += wa * ncpixel_g(p);
+    b += wa * ncpixel_b(p);
+    a += wa;
+  }
+  if(a == 0){
+    return 0;
+  }
+  uint32_t ret = ncpixel(r / a, g / a, b / a);
+  ncpixel_set_a(&ret, (a + ROT_ONE / 2) >> ROT_FRACBITS);
+  return ret;
+}
+
+// a buffer of at least |pixels| pixels to rotate into. the buffer displaced
+// by the previous rotation is reused if it's large enough, so that repeated
+// rotations of an unchanging bounding box needn't allocate.
+static uint32_t*
+rotation_buffer(ncvisual* ncv, size_t pixels){
+  if(ncv->spare && ncv->sparelen >= pixels){
+    uint32_t* ret = ncv->spare;
+    ncv->spare = NULL;
+    ncv->sparelen = 0;
+    return ret;
+  }
+  ncvisual_drop_spare(ncv);
+  return malloc(pixels * 4);
+}
+
+// rotate the visual 'rads' radians about the center of its real data. each
+// destination pixel is mapped back to its source, so there are no holes.
+// multiples of a right angle are handled exactly; otherwise we step through
+// the source in fixed point, taking either the nearest source pixel, or
+// (if 'bilinear' is set) interpolating among the nearest four.
+static int
+ncvisual_rotate_inner(ncvisual* ncv, double rads, bool bilinear){
   assert(ncv->rowstride / 4 >= ncv->pixx);
   rads = -rads; // we're a left-handed Cartesian
-  int centy, centx;
-  ncvisual_center(ncv, &centy, &centx); // pixel center (center of 'data')
   double stheta, ctheta; // sine, cosine
-  stheta = sin(rads);
-  ctheta = cos(rads);
+  const double quarters = rads / (M_PI / 2);
+  const bool rightangle = fabs(quarters - round(quarters)) < 1e-9;
+  if(rightangle){
+    static const int sines[4] = { 0, 1, 0, -1 };
+    const int q = (((long)round(quarters) % 4) + 4) % 4;
+    stheta = sines[q];
+    ctheta = sines[(q + 1) % 4];
+  }else{
+    stheta = sin(rads);
+    ctheta = cos(rads);
+  }
   // bounding box for real data within the ncvisual. we must only resize to
   // accommodate real data, lest we grow without band as we rotate.
   // see https://github.com/dankamongmen/notcurses/issues/599.
@@ -720,45 +1129,92 @@ int ncvisual_rotate(ncvisual* ncv, double rads){
     logerror("couldn't find a bounding box");
     return -1;
   }
-  int bbarea;
-  bbarea = rotate_bounding_box(stheta, ctheta, &bby, &bbx, &bboffy, &bboffx);
+  // we pivot about the center of the real data
+  int centy = bby;
+  int centx = bbx;
+  center_box(&centy, &centx);
+  centy += bboffy;
+  centx += bboffx;
+  // rotated geometry, and its origin relative to the pivot
+  int rby = bby, rbx = bbx, roffy, roffx;
+  int bbarea = rotate_bounding_box(stheta, ctheta, &rby, &rbx, &roffy, &roffx);
   if(bbarea <= 0){
-    logerror("couldn't rotate the visual (%d, %d, %d, %d)", bby, bbx, bboffy, bboffx);
+    logerror("couldn't rotate the visual (%d, %d, %d, %d)", rby, rbx, roffy, roffx);
     return -1;
   }
-  int bbcentx = bbx, bbcenty = bby;
-  center_box(&bbcenty, &bbcentx);
-//fprintf(stderr, "stride: %d height: %d width: %d\n", ncv->rowstride, ncv->pixy, ncv->pixx);
-  assert(ncv->rowstride / 4 >= ncv->pixx);
-  uint32_t* data = malloc(bbarea * 4);
+  uint32_t* data = rotation_buffer(ncv, bbarea);
   if(data == NULL){
     return -1;
   }
-  memset(data, 0, bbarea * 4);
-//fprintf(stderr, "bbarea: %d bby: %d bbx: %d centy: %d centx: %d bbcenty: %d bbcentx: %d\n", bbarea, bby, bbx, centy, centx, bbcenty, bbcentx);
-  for(unsigned y = 0 ; y < ncv->pixy ; ++y){
-      for(unsigned x = 0 ; x < ncv->pixx ; ++x){
-      int targx = x, targy = y;
-      rotate_point(&targy, &targx, stheta, ctheta, centy, centx);
-      if(targx > bboffx && targy > bboffy){
-        const int deconvx = targx - bboffx;
-        const int deconvy = targy - bboffy;
-        if(deconvy < bby && deconvx < bbx){
-          data[deconvy * bbx + deconvx] = ncv->data[y * (ncv->rowstride / 4) + x];
+  const int sstride = ncv->rowstride / 4;
+  // the destination pixel at (ty, tx) relative to the pivot takes the source
+  // pixel at (-tx * sin + ty * cos, tx * cos + ty * sin), again relative to
+  // the pivot. moving along a destination row steps by (-sin, cos).
+  for(int y = 0 ; y < rby ; ++y){
+    const int ty = y + roffy;
+    uint32_t* drow = data + y * rbx;
+    if(rightangle){
+      const int s = stheta;
+      const int c = ctheta;
+      int sy = -roffx * s + ty * c + centy;
+      int sx = roffx * c + ty * s + centx;
+      for(int x = 0 ; x < rbx ; ++x){
+        if(sy >= 0 && sx >= 0 && sy < (int)ncv->pixy && sx < (int)ncv->pixx){
+          drow[x] = ncv->data[sy * sstride + sx];
+        }else{
+          drow[x] = 0;
+        }
+        sy -= s;
+        sx += c;
+      }
+      continue;
+    }
+    const int64_t dfy = llround(-stheta * ROT_ONE);
+    const int64_t dfx = llround(ctheta * ROT_ONE);
+    int64_t fy = llround((-roffx * stheta + ty * ctheta + centy) * ROT_ONE);
+    int64_t fx = llround((roffx * ctheta + ty * stheta + centx) * ROT_ONE);
+    if(bilinear){
+      for(int x = 0 ; x < rbx ; ++x){
+        drow[x] = rotate_bilinear(ncv, fy, fx);
+        fy += dfy;
+        fx += dfx;
+      }
+    }else{
+      for(int x = 0 ; x < rbx ; ++x){
+        const int64_t sy = (fy + ROT_ONE / 2) >> ROT_FRACBITS;
+        const int64_t sx = (fx + ROT_ONE / 2) >> ROT_FRACBITS;
+        if(sy >= 0 && sx >= 0 && sy < ncv->pixy && sx < ncv->pixx){
+          drow[x] = ncv->data[sy * sstride + sx];
+        }else{
+          drow[x] = 0;
         }
+        fy += dfy;
+        fx += dfx;
       }
-//fprintf(stderr, "CW: %d/%d (%08x) -> %d/%d (stride: %d)\n", y, x, ncv->data[y * (ncv->rowstride / 4) + x], targy, targx, ncv->rowstride);
-//fprintf(stderr, "wrote %08x to %d (%d)\n", data[targy * ncv->pixy + targx], targy * ncv->pixy + targx, (targy * ncv->pixy + targx) * 4);
     }
   }
+  // keep our old buffer to receive the next rotation
+  if(ncv->owndata){
+    ncv->spare = ncv->data;
+    ncv->sparelen = (size_t)sstride * ncv->pixy;
+    ncv->data = NULL;
+  }
   ncvisual_set_data(ncv, data, true);
-  ncv->pixx = bbx;
-  ncv->pixy = bby;
-  ncv->rowstride = bbx * 4;
+  ncv->pixx = rbx;
+  ncv->pixy = rby;
+  ncv->rowstride = rbx * 4;
   ncvisual_details_seed(ncv);
   return 0;
 }
 
+int ncvisual_rotate(ncvisual* ncv, double rads){
+  return ncvisual_rotate_inner(ncv, rads, false);
+}
+
+int ncvisual_rotate_bilinear(ncvisual* ncv, double rads){
+  return ncvisual_rotate_inner(ncv, rads, true);
+}
+
 static inline size_t
 pad_for_image(size_t stride, int cols){
   if(visual_implementation->rowalign == 0){
@@ -773,6 +1229,26 @@ pad_for_image(size_t stride, int cols){
           visual_implementation->rowalign * visual_implementation->rowalign;
 }
 
+// copy |rows| rows of |cols| RGBA pixels, |rowstride| bytes apiece, into a
+// new buffer laid out as the engine wants, and hand it to |ncv|.
+static int
+ncvisual_copy_rgba(ncvisual* ncv, const void* rgba, int rows, int rowstride, int cols){
+  // ffmpeg needs inputs with rows aligned on 192-byte boundaries
+  ncv->rowstride = pad_for_image(rowstride, cols);
+  ncv->pixx = cols;
+  ncv->pixy = rows;
+  uint32_t* data = malloc(ncv->rowstride * ncv->pixy);
+  if(data == NULL){
+    return -1;
+  }
+  for(int y = 0 ; y < rows ; ++y){
+//fprintf(stderr, "ROWS: %d STRIDE: %d (%d) COLS: %d %08x\n", ncv->pixy, ncv->rowstride, rowstride, cols, data[ncv->rowstride * y / 4]);
+    memcpy(data + (ncv->rowstride * y) / 4, (const char*)rgba + rowstride * y, cols * 4);
+  }
+  ncvisual_set_data(ncv, data, true);
+  return 0;
+}
+
 ncvisual* ncvisual_from_rgba(const void* rgba, int rows, int rowstride, int cols){
   if(rowstride % 4){
     logerror("rowstride %d not a multiple of 4", rowstride);
@@ -780,25 +1256,67 @@ ncvisual* ncvisual_from_rgba(const void* rgba, int rows, int rowstride, int cols
   }
   ncvisual* ncv = ncvisual_create();
   if(ncv){
-    // ffmpeg needs inputs with rows aligned on 192-byte boundaries
-    ncv->rowstride = pad_for_image(rowstride, cols);
-    ncv->pixx = cols;
-    ncv->pixy = rows;
-    uint32_t* data = malloc(ncv->rowstride * ncv->pixy);
-    if(data == NULL){
+    if(ncvisual_copy_rgba(ncv, rgba, rows, rowstride, cols)){
       ncvisual_destroy(ncv);
       return NULL;
     }
-    for(int y = 0 ; y < rows ; ++y){
-//fprintf(stderr, "ROWS: %d STRIDE: %d (%d) COLS: %d %08x\n", ncv->pixy, ncv->rowstride, rowstride, cols, data[ncv->rowstride * y / 4]);
-      memcpy(data + (ncv->rowstride * y) / 4, (const char*)rgba + rowstride * y, rowstride);
-    }
-    ncvisual_set_data(ncv, data, true);
     ncvisual_details_seed(ncv);
   }
   return ncv;
 }
 
+ncvisual* ncvisual_from_rgba_borrowed(const void* rgba, int rows, int rowstride,
+                                      int cols, ncvisual_releasecb release,
+                                      void* curry){
+  if(rowstride % 4 || rowstride < cols * 4){
+    logerror("invalid rowstride %d for %d columns", rowstride, cols);
+    return NULL;
+  }
+  ncvisual* ncv = ncvisual_create();
+  if(ncv == NULL){
+    return NULL;
+  }
+  if(pad_for_image(rowstride, cols) != (size_t)rowstride){
+    // the engine can't work with these rows; copy them, and hand the
+    // memory right back.
+    loginfo("copying %d-byte rows (engine alignment %d)", rowstride,
+            visual_implementation->rowalign);
+    if(ncvisual_copy_rgba(ncv, rgba, rows, rowstride, cols)){
+      ncvisual_destroy(ncv);
+      return NULL;
+    }
+    if(release){
+      release((void*)rgba, curry);
+    }
+  }else{
+    ncv->rowstride = rowstride;
+    ncv->pixx = cols;
+    ncv->pixy = rows;
+    ncvisual_set_data(ncv, (void*)rgba, false);
+    ncv->borrowed = true;
+    ncv->release = release;
+    ncv->releasecurry = curry;
+  }
+  ncvisual_details_seed(ncv);
+  return ncv;
+}
+
+// we never write to borrowed memory; take a copy of it first.
+static int
+ncvisual_own_data(ncvisual* ncv){
+  if(!ncv->borrowed){
+    return 0;
+  }
+  uint32_t* data = malloc(ncv->rowstride * ncv->pixy);
+  if(data == NULL){
+    return -1;
+  }
+  memcpy(data, ncv->data, ncv->rowstride * ncv->pixy);
+  ncvisual_set_data(ncv, data, true);
+  ncvisual_details_seed(ncv);
+  return 0;
+}
+
 ncvisual* ncvisual_from_sixel(const char* s, unsigned leny, unsigned lenx){
   uint32_t* rgba = ncsixel_as_rgba(s, leny, lenx);
   if(rgba == NULL){
@@ -810,97 +1328,97 @@ ncvisual* ncvisual_from_sixel(const char* s, unsigned leny, unsigned lenx){
   return ncv;
 }
 
-ncvisual* ncvisual_from_rgb_packed(const void* rgba, int rows, int rowstride,
-                                   int cols, int alpha){
+// allocate an ncvisual of |rows|x|cols|, with rows padded as necessary for
+// the multimedia engine, and fill it from |data| using |pc|.
+static ncvisual*
+ncvisual_from_pixconv(const pixconv* pc, const void* data, int rows,
+                      int rowstride, int cols, size_t padstride){
   ncvisual* ncv = ncvisual_create();
   if(ncv){
-    ncv->rowstride = pad_for_image(cols * 4, cols);
+    ncv->rowstride = padstride;
     ncv->pixx = cols;
     ncv->pixy = rows;
-    uint32_t* data = malloc(ncv->rowstride * ncv->pixy);
-    if(data == NULL){
+    uint32_t* pixels = malloc(ncv->rowstride * ncv->pixy);
+    if(pixels == NULL){
       ncvisual_destroy(ncv);
       return NULL;
     }
-    const unsigned char* src = rgba;
     for(int y = 0 ; y < rows ; ++y){
-//fprintf(stderr, "ROWS: %d STRIDE: %d (%d) COLS: %d %08x\n", ncv->pixy, ncv->rowstride, ncv->rowstride / 4, cols, data[ncv->rowstride * y / 4]);
-      for(int x = 0 ; x < cols ; ++x){
-        unsigned char r, g, b;
-        memcpy(&r, src + rowstride * y + 3 * x, 1);
-        memcpy(&g, src + rowstride * y + 3 * x + 1, 1);
-        memcpy(&b, src + rowstride * y + 3 * x + 2, 1);
-        ncpixel_set_a(&data[y * ncv->rowstride / 4 + x], alpha);
-        ncpixel_set_r(&data[y * ncv->rowstride / 4 + x], r);
-        ncpixel_set_g(&data[y * ncv->rowstride / 4 + x], g);
-        ncpixel_set_b(&data[y * ncv->rowstride / 4 + x], b);
-//fprintf(stderr, "RGBA: 0x%02x 0x%02x 0x%02x 0x%02x\n", r, g, b, alpha);
-      }
+      pixconv_row(pc, pixels + ncv->rowstride * y / 4,
+                  (const unsigned char*)data + rowstride * y, cols);
     }
-    ncvisual_set_data(ncv, data, true);
+    ncvisual_set_data(ncv, pixels, true);
     ncvisual_details_seed(ncv);
   }
   return ncv;
 }
 
+ncvisual* ncvisual_from_rgb_packed(const void* rgba, int rows, int rowstride,
+                                   int cols, int alpha){
+  pixconv pc;
+  pixconv_init(&pc, rgb_pattern, 3, alpha);
+  return ncvisual_from_pixconv(&pc, rgba, rows, rowstride, cols,
+                               pad_for_image(cols * 4, cols));
+}
+
 ncvisual* ncvisual_from_rgb_loose(const void* rgba, int rows, int rowstride,
                                   int cols, int alpha){
   if(rowstride % 4){
     logerror("rowstride %d not a multiple of 4", rowstride);
     return NULL;
   }
-  ncvisual* ncv = ncvisual_create();
-  if(ncv){
-    ncv->rowstride = pad_for_image(cols * 4, cols);
-    ncv->pixx = cols;
-    ncv->pixy = rows;
-    uint32_t* data = malloc(ncv->rowstride * ncv->pixy);
-    if(data == NULL){
-      ncvisual_destroy(ncv);
-      return NULL;
-    }
-    for(int y = 0 ; y < rows ; ++y){
-//fprintf(stderr, "ROWS: %d STRIDE: %d (%d) COLS: %d %08x\n", ncv->pixy, ncv->rowstride, ncv->rowstride / 4, cols, data[ncv->rowstride * y / 4]);
-      memcpy(data + (ncv->rowstride * y) / 4, (const char*)rgba + rowstride * y, rowstride);
-      for(int x = 0 ; x < cols ; ++x){
-        ncpixel_set_a(&data[y * ncv->rowstride / 4 + x], alpha);
-      }
-    }
-    ncvisual_set_data(ncv, data, true);
-    ncvisual_details_seed(ncv);
-  }
-  return ncv;
+  pixconv pc;
+  pixconv_init(&pc, rgbx_pattern, 4, alpha);
+  return ncvisual_from_pixconv(&pc, rgba, rows, rowstride, cols,
+                               pad_for_image(cols * 4, cols));
 }
 
 ncvisual* ncvisual_from_bgra(const void* bgra, int rows, int rowstride, int cols){
   if(rowstride % 4){
     return NULL;
   }
+  pixconv pc;
+  pixconv_init(&pc, bgra_pattern, 4, -1);
+  return ncvisual_from_pixconv(&pc, bgra, rows, rowstride, cols,
+                               pad_for_image(rowstride, cols));
+}
+
+ncvisual* ncvisual_from_bgra_owned(void* bgra, int rows, int rowstride, int cols){
+  if(rowstride % 4 || rowstride < cols * 4){
+    logerror("invalid rowstride %d for %d columns", rowstride, cols);
+    return NULL;
+  }
   ncvisual* ncv = ncvisual_create();
-  if(ncv){
-    ncv->rowstride = pad_for_image(rowstride, cols);
-    ncv->pixx = cols;
-    ncv->pixy = rows;
-    uint32_t* data = malloc(ncv->rowstride * ncv->pixy);
-    if(data == NULL){
+  if(ncv == NULL){
+    return NULL;
+  }
+  // the buffer is converted where it lies, unless the engine wants rows
+  // aligned differently. rows are then moved into place before conversion:
+  // front to back to compact them, or back to front (following a realloc,
+  // the last point of possible failure) to spread them out.
+  const size_t padstride = pad_for_image(rowstride, cols);
+  unsigned char* pixels = bgra;
+  if(padstride > (size_t)rowstride){
+    if((pixels = realloc(bgra, padstride * rows)) == NULL){
       ncvisual_destroy(ncv);
       return NULL;
     }
-    for(int y = 0 ; y < rows ; ++y){
-      for(int x = 0 ; x < cols ; ++x){
-        uint32_t src;
-        memcpy(&src, (const char*)bgra + y * rowstride + x * 4, 4);
-        uint32_t* dst = &data[ncv->rowstride * y / 4 + x];
-        ncpixel_set_a(dst, ncpixel_a(src));
-        ncpixel_set_r(dst, ncpixel_b(src));
-        ncpixel_set_g(dst, ncpixel_g(src));
-        ncpixel_set_b(dst, ncpixel_r(src));
-//fprintf(stderr, "BGRA PIXEL: %02x%02x%02x%02x RGBA result: %02x%02x%02x%02x\n", ((const char*)&src)[0], ((const char*)&src)[1], ((const char*)&src)[2], ((const char*)&src)[3], ((const char*)dst)[0], ((const char*)dst)[1], ((const char*)dst)[2], ((const char*)dst)[3]);
-      }
+  }
+  pixconv pc;
+  pixconv_init(&pc, bgra_pattern, 4, -1);
+  for(int i = 0 ; i < rows ; ++i){
+    const int y = padstride > (size_t)rowstride ? rows - 1 - i : i;
+    unsigned char* row = pixels + padstride * y;
+    if(padstride != (size_t)rowstride){
+      memmove(row, pixels + (size_t)rowstride * y, cols * 4);
     }
-    ncvisual_set_data(ncv, data, true);
-    ncvisual_details_seed(ncv);
+    pixconv_row(&pc, (uint32_t*)row, row, cols);
   }
+  ncv->rowstride = padstride;
+  ncv->pixx = cols;
+  ncv->pixy = rows;
+  ncvisual_set_data(ncv, pixels, true);
+  ncvisual_details_seed(ncv);
   return ncv;
 }
 
@@ -915,6 +1433,19 @@ ncvisual* ncvisual_from_palidx(const void* pdata, int rows, int rowstride,
     logerror("palettes size (%d) is unsupported", palsize);
     return NULL;
   }
+  // resolve each palette entry once, rather than for every pixel
+  uint32_t lut[256];
+  for(int palidx = 0 ; palidx < palsize ; ++palidx){
+    uint32_t* dst = &lut[palidx];
+    *dst = 0;
+    if(ncchannel_default_p(palette[palidx])){
+      // FIXME use default color as detected, or just 0xffffff
+      ncpixel_set_a(dst, 255 - palidx);
+      ncpixel_set_r(dst, palidx);
+      ncpixel_set_g(dst, 220 - (palidx / 2));
+      ncpixel_set_b(dst, palidx);
+    }
+  }
   ncvisual* ncv = ncvisual_create();
   if(ncv){
     ncv->rowstride = pad_for_image(rowstride, cols);
@@ -926,26 +1457,17 @@ ncvisual* ncvisual_from_palidx(const void* pdata, int rows, int rowstride,
       return NULL;
     }
     for(int y = 0 ; y < rows ; ++y){
+      const unsigned char* src = (const unsigned char*)pdata + y * rowstride;
+      uint32_t* dst = &data[ncv->rowstride * y / 4];
       for(int x = 0 ; x < cols ; ++x){
-        int palidx = ((const unsigned char*)pdata)[y * rowstride + x * pstride];
+        int palidx = src[x * pstride];
         if(palidx >= palsize){
           free(data);
           ncvisual_destroy(ncv);
           logerror("invalid palette idx %d >= %d", palidx, palsize);
           return NULL;
         }
-        uint32_t src = palette[palidx];
-        uint32_t* dst = &data[ncv->rowstride * y / 4 + x];
-        if(ncchannel_default_p(src)){
-          // FIXME use default color as detected, or just 0xffffff
-          ncpixel_set_a(dst, 255 - palidx);
-          ncpixel_set_r(dst, palidx);
-          ncpixel_set_g(dst, 220 - (palidx / 2));
-          ncpixel_set_b(dst, palidx);
-        }else{
-          *dst = 0;
-        }
-//fprintf(stderr, "BGRA PIXEL: %02x%02x%02x%02x RGBA result: %02x%02x%02x%02x\n", ((const char*)&src)[0], ((const char*)&src)[1], ((const char*)&src)[2], ((const char*)&src)[3], ((const char*)dst)[0], ((const char*)dst)[1], ((const char*)dst)[2], ((const char*)dst)[3]);
+        dst[x] = lut[palidx];
       }
     }
     ncvisual_set_data(ncv, data, true);
@@ -954,20 +1476,12 @@ ncvisual* ncvisual_from_palidx(const void* pdata, int rows, int rowstride,
   return ncv;
 }
 
-int ncvisual_resize(ncvisual* n, int rows, int cols){
-  if(!visual_implementation->visual_resize){
-    return ncvisual_resize_noninterpolative(n, rows, cols);
-  }
-  if(visual_implementation->visual_resize(n, rows, cols)){
-    return -1;
-  }
-  return 0;
-}
-
-int ncvisual_resize_noninterpolative(ncvisual* n, int rows, int cols){
+// resize without the multimedia engine, naively or by averaging areas
+static int
+ncvisual_resize_generic(ncvisual* n, int rows, int cols, bool area){
   size_t dstride = pad_for_image(cols * 4, cols);
-  uint32_t* r = resize_bitmap(n->data, n->pixy, n->pixx, n->rowstride,
-                              rows, cols, dstride);
+  uint32_t* r = resize_bitmap_rows(n->data, n->pixy, n->pixx, n->rowstride,
+                                   rows, cols, dstride, 0, rows, area, NULL);
   if(r == NULL){
     return -1;
   }
@@ -979,6 +1493,21 @@ int ncvisual_resize_noninterpolative(ncvisual* n, int rows, int cols){
   return 0;
 }
 
+int ncvisual_resize(ncvisual* n, int rows, int cols){
+  if(!visual_implementation->visual_resize){
+    // the best we can do on our own is to average areas
+    return ncvisual_resize_generic(n, rows, cols, true);
+  }
+  if(visual_implementation->visual_resize(n, rows, cols)){
+    return -1;
+  }
+  return 0;
+}
+
+int ncvisual_resize_noninterpolative(ncvisual* n, int rows, int cols){
+  return ncvisual_resize_generic(n, rows, cols, false);
+}
+
 // by the end, disprows/dispcols refer to the number of source rows/cols (in
 // pixels), which will be mapped to a region of cells scaled by the encodings).
 // the blit will begin at placey/placex (in terms of cells). begy/begx define
@@ -1049,10 +1578,13 @@ ncplane* ncvisual_render_pixels(notcurses* nc, ncvisual* ncv, const struct blits
       return NULL;;
     }
   }else{
-    n->sprite = sprixel_recycle(n);
+    if((n->sprite = sprixel_recycle(n, &bargs, geom->rpixy, geom->rpixx)) == NULL){
+      return NULL;
+    }
+    // at a fixed geometry (e.g. video), the TAM is carried from frame to
+    // frame, as are the auxvectors of any cells which remain wiped.
     if(n->sprite->dimy != geom->rcelly || n->sprite->dimx != geom->rcellx){
-      destroy_tam(n);
-      if((n->tam = create_tam(geom->rcelly, geom->rcellx)) == NULL){
+      if((n->tam = reset_tam(n, geom->rcelly, geom->rcellx)) == NULL){
         return NULL;
       }
     }
@@ -1108,6 +1640,205 @@ ncplane* ncvisual_render_pixels(notcurses* nc, ncvisual* ncv, const struct blits
   return n;
 }
 
+// with NCVISUAL_OPTION_TILED, a bitmap is broken up into a grid of sprixels,
+// each on its own plane bound to the plane we return. tiles are no larger
+// than the terminal's maximum bitmap geometry, nor NCVISUAL_TILE_CELLS cells
+// on a side, so that wipes, rebuilds, and damage remain local to a tile.
+#define NCVISUAL_TILE_CELLS 32
+
+typedef struct tilejob {
+  const struct blitset* bset;
+  const uint32_t* data; // selected region, scaled to the output geometry
+  size_t stride;        // bytes per row of data
+  unsigned cdimy, cdimx;
+  unsigned count;       // number of tiles
+  ncplane** tiles;
+  blitterargs* bargs;   // one per tile
+  int* rets;            // one per tile
+} tilejob;
+
+// encode tiles [count * band / bands, count * (band + 1) / bands). each tile
+// has its own plane, sprixel, and TAM, and the bitmap encoders lock anything
+// they share, so tiles can be encoded concurrently.
+static void
+tile_band(void* vjob, unsigned band, unsigned bands){
+  const tilejob* j = vjob;
+  const unsigned beg = (uint64_t)j->count * band / bands;
+  const unsigned end = (uint64_t)j->count * (band + 1) / bands;
+  for(unsigned t = beg ; t < end ; ++t){
+    const ncplane* tn = j->tiles[t];
+    const uint32_t* data = j->data + (j->stride / sizeof(*data)) * (ncplane_y(tn) * j->cdimy)
+                           + ncplane_x(tn) * j->cdimx;
+    j->rets[t] = j->bset->blit(j->tiles[t], j->stride, data, j->bargs[t].leny,
+                               j->bargs[t].lenx, &j->bargs[t]);
+  }
+}
+
+// the sprixels are allocated and bound to their planes here, but encoded on
+// the pile's render engine. |n| is the (blank) plane we created to hold them.
+static ncplane*
+ncvisual_render_tiles(notcurses* nc, const ncvisual* ncv, const struct blitset* bset,
+                      const ncvgeom* geom, ncplane* n, uint64_t flags,
+                      uint32_t transcolor){
+  const tinfo* ti = &nc->tcache;
+  unsigned tcelly = ti->sixel_maxy ? ti->sixel_maxy / geom->cdimy : 0;
+  unsigned tcellx = ti->sixel_maxx ? ti->sixel_maxx / geom->cdimx : 0;
+  if(tcelly == 0 || tcelly > NCVISUAL_TILE_CELLS){
+    tcelly = NCVISUAL_TILE_CELLS;
+  }
+  if(tcellx == 0 || tcellx > NCVISUAL_TILE_CELLS){
+    tcellx = NCVISUAL_TILE_CELLS;
+  }
+  // all but the last row of tiles must be a multiple of the sprixel scale
+  // height, lest their padding spill into the row of tiles below.
+  unsigned step = 1;
+  while((step * geom->cdimy) % ti->sprixel_scale_height){
+    ++step;
+  }
+  if(tcelly > step){
+    tcelly -= tcelly % step;
+  }else{
+    tcelly = step;
+  }
+  const unsigned tilepxy = tcelly * geom->cdimy;
+  const unsigned tilepxx = tcellx * geom->cdimx;
+  const unsigned tilesy = (geom->rpixy + tilepxy - 1) / tilepxy;
+  const unsigned tilesx = (geom->rpixx + tilepxx - 1) / tilepxx;
+  tilejob job = {
+    .bset = bset,
+    .cdimy = geom->cdimy,
+    .cdimx = geom->cdimx,
+    .count = 0,
+  };
+  // scale the selected region once, rather than once per tile
+  uint32_t* scaled = NULL;
+  if(geom->rpixy != geom->leny || geom->rpixx != geom->lenx){
+    const bool area = !(flags & NCVISUAL_OPTION_NOINTERPOLATE);
+    job.stride = geom->rpixx * sizeof(*scaled);
+    scaled = resize_bitmap_rows(ncv->data + (ncv->rowstride / sizeof(*ncv->data)) * geom->begy + geom->begx,
+                                geom->leny, geom->lenx, ncv->rowstride,
+                                geom->rpixy, geom->rpixx, job.stride,
+                                0, geom->rpixy, area, ncplane_render_engine(n));
+    if(scaled == NULL){
+      return NULL;
+    }
+    job.data = scaled;
+  }else{
+    job.stride = ncv->rowstride;
+    job.data = ncv->data + (ncv->rowstride / sizeof(*ncv->data)) * geom->begy + geom->begx;
+  }
+  job.tiles = malloc(sizeof(*job.tiles) * tilesy * tilesx);
+  job.bargs = malloc(sizeof(*job.bargs) * tilesy * tilesx);
+  job.rets = malloc(sizeof(*job.rets) * tilesy * tilesx);
+  if(job.tiles == NULL || job.bargs == NULL || job.rets == NULL){
+    goto err;
+  }
+  for(unsigned ty = 0 ; ty < tilesy ; ++ty){
+    const unsigned pxy = ty + 1 < tilesy ? tilepxy : geom->rpixy - ty * tilepxy;
+    unsigned outy = pxy;
+    if(outy % ti->sprixel_scale_height){
+      outy += ti->sprixel_scale_height - outy % ti->sprixel_scale_height;
+    }
+    for(unsigned tx = 0 ; tx < tilesx ; ++tx){
+      const unsigned pxx = tx + 1 < tilesx ? tilepxx : geom->rpixx - tx * tilepxx;
+      struct ncplane_options nopts = {
+        .y = ty * tcelly,
+        .x = tx * tcellx,
+        .rows = (outy + geom->cdimy - 1) / geom->cdimy,
+        .cols = (pxx + geom->cdimx - 1) / geom->cdimx,
+        .name = "tile",
+      };
+      ncplane* tn = ncplane_create(n, &nopts);
+      if(tn == NULL){
+        goto err;
+      }
+      job.tiles[job.count++] = tn;
+      if((tn->sprite = sprixel_alloc(tn, nopts.rows, nopts.cols)) == NULL){
+        goto err;
+      }
+      if((tn->tam = create_tam(nopts.rows, nopts.cols)) == NULL){
+        goto err;
+      }
+      ncplane_damage(tn);
+      blitterargs* bargs = &job.bargs[job.count - 1];
+      memset(bargs, 0, sizeof(*bargs));
+      bargs->transcolor = transcolor;
+      bargs->leny = pxy;
+      bargs->lenx = pxx;
+      bargs->flags = flags;
+      bargs->u.pixel.colorregs = ti->color_registers;
+      bargs->u.pixel.cellpxy = geom->cdimy;
+      bargs->u.pixel.cellpxx = geom->cdimx;
+      bargs->u.pixel.spx = tn->sprite;
+    }
+  }
+  int64_t maxns = 0;
+  uint64_t sumns = 0;
+  if(job.count < 2 || render_engine_run(ncplane_render_engine(n), job.count,
+                                        tile_band, &job, &maxns, &sumns)){
+    tile_band(&job, 0, 1);
+  }
+  for(unsigned t = 0 ; t < job.count ; ++t){
+    if(job.rets[t] < 0){
+      logerror("couldn't encode tile %u/%u", t, job.count);
+      goto err;
+    }
+  }
+  free(job.rets);
+  free(job.bargs);
+  free(job.tiles);
+  free(scaled);
+  return n;
+
+err:
+  if(job.tiles){
+    for(unsigned t = 0 ; t < job.count ; ++t){
+      ncplane_destroy(job.tiles[t]);
+    }
+  }
+  free(job.rets);
+  free(job.bargs);
+  free(job.tiles);
+  free(scaled);
+  return NULL;
+}
+
+// blits further apart than this aren't considered part of an animation, and
+// impose no budget.
+#define ADAPT_MAX_PERIODNS 1000000000ull
+
+// with NCVISUAL_OPTION_ADAPTIVE, is a bitmap of |ncv| expected to take longer
+// to encode and transmit than the time between its blits? we degrade once it
+// does, and only return to bitmaps once one would take less than half the
+// period, so that we don't flap between the two.
+static bool
+ncvisual_adapt(notcurses* nc, ncvisual* ncv, uint64_t nowns){
+  if(ncv->lastblitns){
+    const uint64_t gap = nowns - ncv->lastblitns;
+    if(gap >= ADAPT_MAX_PERIODNS){
+      ncv->periodns = 0;
+    }else if(ncv->periodns == 0){
+      ncv->periodns = gap;
+    }else{
+      ncv->periodns = (ncv->periodns * 7 + gap) / 8;
+    }
+  }
+  ncv->lastblitns = nowns;
+  if(ncv->periodns == 0 || ncv->pxencodens == 0){
+    ncv->pxdegraded = false; // not animating, or no bitmap cost yet known
+    return false;
+  }
+  const uint64_t costns = ncv->pxencodens + ncv->pxbytes * notcurses_link_nsperbyte(nc);
+  if(!ncv->pxdegraded && costns > ncv->periodns){
+    loginfo("bitmap costs %" PRIu64 "ns per %" PRIu64 "ns, using cells", costns, ncv->periodns);
+    ncv->pxdegraded = true;
+  }else if(ncv->pxdegraded && costns * 2 < ncv->periodns){
+    loginfo("bitmap costs %" PRIu64 "ns per %" PRIu64 "ns, using bitmaps", costns, ncv->periodns);
+    ncv->pxdegraded = false;
+  }
+  return ncv->pxdegraded;
+}
+
 ncplane* ncvisual_blit(notcurses* nc, ncvisual* ncv, const struct ncvisual_options* vopts){
 //fprintf(stderr, "%p tacache: %p\n", n, n->tacache);
   struct ncvisual_options fakevopts;
@@ -1117,6 +1848,36 @@ ncplane* ncvisual_blit(notcurses* nc, ncvisual* ncv, const struct ncvisual_optio
   }
   loginfo("inblit %dx%d %d@%d %dx%d @ %dx%d %p", ncv->pixy, ncv->pixx, vopts->y, vopts->x,
           vopts->leny, vopts->lenx, vopts->begy, vopts->begx, vopts->n);
+  if(settle_async_init(nc)){
+    return NULL;
+  }
+  // over a slow link (see NCOPTION_ADAPTIVE_BANDWIDTH), or when bitmaps of
+  // this visual can't keep up with its blits (see NCVISUAL_OPTION_ADAPTIVE),
+  // bitmaps are blitted as cells, unless they're going to a plane which
+  // already has one.
+  const bool adaptive = vopts->blitter == NCBLIT_PIXEL &&
+                        (vopts->flags & NCVISUAL_OPTION_ADAPTIVE) &&
+                        !(vopts->flags & NCVISUAL_OPTION_NODEGRADE);
+  uint64_t blitns = 0;
+  if(adaptive){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    blitns = timespec_to_ns(&ts);
+  }
+  if(vopts->blitter == NCBLIT_PIXEL && !(vopts->flags & NCVISUAL_OPTION_NODEGRADE) &&
+     ((adaptive && ncvisual_adapt(nc, ncv, blitns)) || nc->rstate.lowbw)){
+    if(vopts->n == NULL || (vopts->flags & NCVISUAL_OPTION_CHILDPLANE) ||
+       vopts->n->sprite == NULL){
+      if(vopts != &fakevopts){
+        memcpy(&fakevopts, vopts, sizeof(fakevopts));
+        vopts = &fakevopts;
+      }
+      fakevopts.blitter = NCBLIT_3x2;
+      stats_lock(&nc->stats);
+        ++nc->stats.s.degraded_blits;
+      stats_unlock(&nc->stats);
+    }
+  }
   ncvgeom geom;
   const struct blitset* bset;
   unsigned disppxy, disppxx, outy, outx;
@@ -1127,6 +1888,18 @@ ncplane* ncvisual_blit(notcurses* nc, ncvisual* ncv, const struct ncvisual_optio
     // ncvisual_blitset_geom() emits its own diagnostics, no need for an error here
     return NULL;
   }
+  const bool tiled = geom.blitter == NCBLIT_PIXEL &&
+                     (vopts->flags & NCVISUAL_OPTION_TILED);
+  if(tiled){
+    if(vopts->n && !(vopts->flags & NCVISUAL_OPTION_CHILDPLANE)){
+      logerror("tiled bitmaps require a new plane");
+      return NULL;
+    }
+    if(vopts->pxoffy || vopts->pxoffx){
+      logerror("pixel offsets cannot be used with tiled bitmaps");
+      return NULL;
+    }
+  }
   ncplane* n = vopts->n;
   uint32_t transcolor = 0;
   if(vopts->flags & NCVISUAL_OPTION_ADDALPHA){
@@ -1140,7 +1913,7 @@ ncplane* ncvisual_blit(notcurses* nc, ncvisual* ncv, const struct ncvisual_optio
       .rows = geom.rcelly,
       .cols = geom.rcellx,
       .userptr = NULL,
-      .name = geom.blitter == NCBLIT_PIXEL ? "bmap" : "cvis",
+      .name = tiled ? "tiles" : geom.blitter == NCBLIT_PIXEL ? "bmap" : "cvis",
       .resizecb = NULL,
       .flags = 0,
     };
@@ -1168,11 +1941,24 @@ ncplane* ncvisual_blit(notcurses* nc, ncvisual* ncv, const struct ncvisual_optio
   if(geom.blitter != NCBLIT_PIXEL){
     n = ncvisual_render_cells(ncv, bset, placey, placex,
                               &geom, n, vopts->flags, transcolor);
+  }else if(tiled){
+    n = ncvisual_render_tiles(nc, ncv, bset, &geom, n, vopts->flags, transcolor);
   }else{
     n = ncvisual_render_pixels(nc, ncv, bset, placey, placex,
                                &geom, n,
                                vopts->flags, transcolor,
                                vopts->pxoffy, vopts->pxoffx);
+    if(adaptive && n && n->sprite){
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      const uint64_t encodens = timespec_to_ns(&ts) - blitns;
+      if(ncv->pxencodens == 0){
+        ncv->pxencodens = encodens;
+      }else{
+        ncv->pxencodens = (ncv->pxencodens * 7 + encodens) / 8;
+      }
+      ncv->pxbytes = n->sprite->glyph.used;
+    }
   }
   if(n == NULL){
     ncplane_destroy(createdn);
@@ -1180,6 +1966,76 @@ ncplane* ncvisual_blit(notcurses* nc, ncvisual* ncv, const struct ncvisual_optio
   return n;
 }
 
+// a prepared blit is the fully-encoded plane (and any sprixel) produced by
+// ncvisual_blit(), held as the root of its own pile until it is attached.
+// distinct piles can be worked on concurrently, so the preparation can
+// happen on any thread, and attachment is just a reparenting.
+typedef struct ncprepared {
+  ncplane* n;       // root of a private pile
+  int y, x;         // placement (or alignment) relative to the eventual parent
+  uint64_t flags;   // NCVISUAL_OPTION_{HOR,VER}ALIGNED from the request
+} ncprepared;
+
+ncprepared* ncvisual_prepare(notcurses* nc, ncvisual* ncv,
+                             const struct ncvisual_options* vopts){
+  struct ncvisual_options popts;
+  if(vopts == NULL){
+    memset(&popts, 0, sizeof(popts));
+  }else{
+    if(vopts->n){
+      logerror("prepared blits must create their own plane");
+      return NULL;
+    }
+    memcpy(&popts, vopts, sizeof(popts));
+  }
+  ncprepared* ret = malloc(sizeof(*ret));
+  if(ret == NULL){
+    return NULL;
+  }
+  ret->y = popts.y;
+  ret->x = popts.x;
+  ret->flags = popts.flags & (NCVISUAL_OPTION_HORALIGNED | NCVISUAL_OPTION_VERALIGNED);
+  // a pile root has nothing to align against; placement is resolved against
+  // the real parent in ncplane_attach_prepared().
+  popts.flags &= ~(NCVISUAL_OPTION_HORALIGNED | NCVISUAL_OPTION_VERALIGNED |
+                   NCVISUAL_OPTION_CHILDPLANE);
+  popts.y = 0;
+  popts.x = 0;
+  if((ret->n = ncvisual_blit(nc, ncv, &popts)) == NULL){
+    free(ret);
+    return NULL;
+  }
+  return ret;
+}
+
+ncplane* ncplane_attach_prepared(ncplane* n, ncprepared* prep){
+  ncplane* p = prep->n;
+  if(ncplane_reparent_family(p, n) == NULL){
+    logerror("couldn't attach prepared blit to %p", n);
+    return NULL;
+  }
+  int y = prep->y;
+  int x = prep->x;
+  if(prep->flags & NCVISUAL_OPTION_HORALIGNED){
+    x = ncplane_halign(n, prep->x, ncplane_dim_x(p));
+    p->halign = prep->x;
+  }
+  if(prep->flags & NCVISUAL_OPTION_VERALIGNED){
+    y = ncplane_valign(n, prep->y, ncplane_dim_y(p));
+    p->valign = prep->y;
+  }
+  ncplane_move_yx(p, y, x);
+  free(prep);
+  return p;
+}
+
+void ncprepared_destroy(ncprepared* prep){
+  if(prep){
+    ncplane_destroy(prep->n);
+    free(prep);
+  }
+}
+
 ncvisual* ncvisual_from_plane(const ncplane* n, ncblitter_e blit,
                               int begy, int begx,
                               unsigned leny, unsigned lenx){
@@ -1197,12 +2053,19 @@ ncvisual* ncvisual_from_plane(const ncplane* n, ncblitter_e blit,
   return ncv;
 }
 
+uint64_t ncvisual_memory(const ncvisual* ncv){
+  uint64_t ret = sizeof(*ncv->spare) * ncv->sparelen;
+  if(ncv->data){
+    ret += (uint64_t)ncv->rowstride * ncv->pixy;
+  }
+  return ret;
+}
+
 void ncvisual_destroy(ncvisual* ncv){
   if(ncv){
     if(visual_implementation->visual_destroy == NULL){
-      if(ncv->owndata){
-        free(ncv->data);
-      }
+      ncvisual_drop_data(ncv);
+      ncvisual_drop_spare(ncv);
       free(ncv);
     }else{
       visual_implementation->visual_destroy(ncv);
@@ -1240,6 +2103,10 @@ int ncvisual_set_yx(const struct ncvisual* n, unsigned y, unsigned x, uint32_t p
     logerror("invalid coordinates %u/%u", y, x);
     return -1;
   }
+  // ncvisuals are never actually const, and the pixels belong to them
+  if(ncvisual_own_data((ncvisual*)n)){
+    return -1;
+  }
   n->data[y * (n->rowstride / 4) + x] = pixel;
   return 0;
 }
@@ -1258,62 +2125,63 @@ int ncvisual_at_yx(const ncvisual* n, unsigned y, unsigned x, uint32_t* pixel){
 }
 
 // originally i wrote this recursively, at which point it promptly began
-// exploding once i multithreaded the [yield] demo. hence the clumsy stack
-// and hand-rolled iteration. alas, poor yorick!
+// exploding once i multithreaded the [yield] demo. hence the hand-rolled
+// stack of seeds, from which we fill spans (see polyfill_stack).
 static int
 ncvisual_polyfill_core(ncvisual* n, unsigned y, unsigned x, uint32_t rgba, uint32_t match){
-  struct topolyfill* stack = malloc(sizeof(*stack));
-  if(stack == NULL){
+  if(match == rgba){
+    return 0;
+  }
+  polyfill_stack ps;
+  polyfill_init(&ps);
+  if(polyfill_push(&ps, y, x)){
+    polyfill_free(&ps);
     return -1;
   }
-  stack->y = y;
-  stack->x = x;
-  stack->next = NULL;
   int ret = 0;
-  struct topolyfill* s;
-  do{
-    s = stack;
-    stack = s->next;
-    y = s->y;
-    x = s->x;
-    uint32_t* pixel = &n->data[y * (n->rowstride / 4) + x];
-    if(*pixel == match && *pixel != rgba){
-      ++ret;
-    // fprintf(stderr, "%d/%d: setting %08x to %08x\n", y, x, *pixel, rgba);
-      *pixel = rgba;
-      if(y){
-        if(create_polyfill_op(y - 1, x, &stack) == NULL){
-          goto err;
-        }
-      }
-      if(y + 1 < n->pixy){
-        if(create_polyfill_op(y + 1, x, &stack) == NULL){
-          goto err;
-        }
-      }
-      if(x){
-        if(create_polyfill_op(y, x - 1, &stack) == NULL){
-          goto err;
-        }
+  while(ps.used){
+    const polyfill_seed s = ps.seeds[--ps.used];
+    uint32_t* row = &n->data[s.y * (n->rowstride / 4)];
+    if(row[s.x] != match){
+      continue;
+    }
+    unsigned xl = s.x;
+    while(xl && row[xl - 1] == match){
+      --xl;
+    }
+    unsigned xr = s.x;
+    while(xr + 1 < n->pixx && row[xr + 1] == match){
+      ++xr;
+    }
+    for(unsigned xx = xl ; xx <= xr ; ++xx){
+      row[xx] = rgba;
+    }
+    ret += xr - xl + 1;
+    // seed each run of matches directly above and below the span
+    for(int dy = -1 ; dy <= 1 ; dy += 2){
+      if((dy < 0 && s.y == 0) || (dy > 0 && s.y + 1 >= n->pixy)){
+        continue;
       }
-      if(x + 1 < n->pixx){
-        if(create_polyfill_op(y, x + 1, &stack) == NULL){
-          goto err;
+      const unsigned ny = s.y + dy;
+      const uint32_t* nrow = &n->data[ny * (n->rowstride / 4)];
+      bool inrun = false;
+      for(unsigned xx = xl ; xx <= xr ; ++xx){
+        if(nrow[xx] == match){
+          if(!inrun){
+            if(polyfill_push(&ps, ny, xx)){
+              polyfill_free(&ps);
+              return -1;
+            }
+            inrun = true;
+          }
+        }else{
+          inrun = false;
         }
       }
     }
-    free(s);
-  }while(stack);
-  return ret;
-
-err:
-  free(s);
-  while(stack){
-    s = stack->next;
-    free(stack);
-    stack = s;
   }
-  return -1;
+  polyfill_free(&ps);
+  return ret;
 }
 
 int ncvisual_polyfill_yx(ncvisual* n, unsigned y, unsigned x, uint32_t rgba){
@@ -1325,6 +2193,9 @@ int ncvisual_polyfill_yx(ncvisual* n, unsigned y, unsigned x, uint32_t rgba){
     logerror("invalid coordinates %u/%u", y, x);
     return -1;
   }
+  if(ncvisual_own_data(n)){
+    return -1;
+  }
   uint32_t* pixel = &n->data[y * (n->rowstride / 4) + x];
   return ncvisual_polyfill_core(n, y, x, rgba, *pixel);
 }
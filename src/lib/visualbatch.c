@@ -0,0 +1,342 @@
+#include <fcntl.h>
+#include "internal.h"
+#include "unixsig.h"
+#include "visual-details.h"
+
+// a visual batch loads many files at once on a small pool of library-owned
+// threads, for e.g. populating a gallery of thumbnails. files are claimed in
+// order, so earlier files tend to complete first, but results are delivered
+// in order of completion. each result is either handed to the caller's
+// callback from the loading thread, or queued for ncvisual_batch_next().
+
+// we never spin up more loaders than this, no matter how many processors
+// are online. each decoder might well run threads of its own.
+#define BATCH_MAXTHREADS 16
+
+typedef struct batchresult {
+  unsigned idx;             // index of the file in the original request
+  ncvisual* ncv;            // NULL if the file couldn't be loaded
+} batchresult;
+
+typedef struct ncvisual_batch {
+  pthread_mutex_t lock;     // guards everything below
+  pthread_cond_t cond;      // signaled on each queued result, and completion
+  pthread_t* tids;
+  unsigned threads;         // loader threads successfully spun up
+  char** files;             // our own copies of the requested paths
+  unsigned count;           // files in the batch
+  unsigned next;            // next file to be claimed by a loader
+  unsigned finished;        // files which have been delivered or queued
+  batchresult* results;     // at most 'count' results, queued in order
+  unsigned qhead;           // next result to be returned
+  unsigned qtail;           // next free result slot
+  unsigned pixy, pixx;      // bounding box for each visual, 0 for unbounded
+  ncvisual_batchcb cb;      // if non-NULL, results are handed here
+  void* curry;
+  int notify[2];            // read end is readable while results await
+  bool notified;            // have we readied notify[0] since last drained?
+  bool done;                // stop claiming files, we're being destroyed
+} ncvisual_batch;
+
+#ifndef __MINGW32__
+static void
+drain_notify(ncvisual_batch* b){
+  char c[8];
+  while(read(b->notify[0], c, sizeof(c)) > 0){
+    ;
+  }
+  b->notified = false;
+}
+
+static void
+ready_notify(ncvisual_batch* b){
+  if(!b->notified){
+    const char c = 1;
+    if(write(b->notify[1], &c, 1) == 1){
+      b->notified = true;
+    }
+  }
+}
+
+static int
+notify_pipes(ncvisual_batch* b){
+#ifndef __APPLE__
+  if(pipe2(b->notify, O_CLOEXEC | O_NONBLOCK)){
+    logerror("couldn't get pipes (%s)", strerror(errno));
+    return -1;
+  }
+#else
+  if(pipe(b->notify)){
+    logerror("couldn't get pipes (%s)", strerror(errno));
+    return -1;
+  }
+  for(int i = 0 ; i < 2 ; ++i){
+    if(fcntl(b->notify[i], F_SETFD, FD_CLOEXEC) ||
+       set_fd_nonblocking(b->notify[i], 1, NULL)){
+      logerror("couldn't prep pipe[%d] (%s)", i, strerror(errno));
+      close(b->notify[0]);
+      close(b->notify[1]);
+      return -1;
+    }
+  }
+#endif
+  return 0;
+}
+
+static void
+close_notify(ncvisual_batch* b){
+  close(b->notify[0]);
+  close(b->notify[1]);
+}
+#else
+static void
+drain_notify(ncvisual_batch* b){
+  b->notified = false;
+}
+
+static void
+ready_notify(ncvisual_batch* b){
+  b->notified = true;
+}
+
+static int
+notify_pipes(ncvisual_batch* b){
+  (void)b;
+  return 0;
+}
+
+static void
+close_notify(ncvisual_batch* b){
+  (void)b;
+}
+#endif
+
+// shrink |ncv| to fit within |pixy|x|pixx|, preserving its aspect ratio. a
+// visual which already fits is left alone; the blitter can always enlarge it.
+static int
+batch_fit(ncvisual* ncv, unsigned pixy, unsigned pixx){
+  double scale = 1;
+  if(pixy && ncv->pixy > pixy){
+    scale = (double)pixy / ncv->pixy;
+  }
+  if(pixx && ncv->pixx * scale > pixx){
+    scale = (double)pixx / ncv->pixx;
+  }
+  if(scale >= 1){
+    return 0;
+  }
+  int rows = ncv->pixy * scale;
+  int cols = ncv->pixx * scale;
+  return ncvisual_resize(ncv, rows ? rows : 1, cols ? cols : 1);
+}
+
+// the decoder is told it may reduce the image so long as it still covers
+// the bounding box; we don't know the aspect ratio until it's opened.
+static ncvisual*
+batch_load(const ncvisual_batch* b, const char* file){
+  ncvisual* ncv;
+  if(b->pixy || b->pixx){
+    ncv = ncvisual_from_file_sized(file, b->pixy, b->pixx);
+  }else{
+    ncv = ncvisual_from_file(file);
+  }
+  if(ncv && batch_fit(ncv, b->pixy, b->pixx)){
+    logerror("couldn't scale %s", file);
+    ncvisual_destroy(ncv);
+    ncv = NULL;
+  }
+  return ncv;
+}
+
+static void*
+batch_worker(void* v){
+  ncvisual_batch* b = v;
+  nc_thread_setup("batch");
+  // signals ought be handled on the application's threads
+  sigset_t oldmask;
+  block_signals(&oldmask);
+  pthread_mutex_lock(&b->lock);
+  while(!b->done && b->next < b->count){
+    const unsigned idx = b->next++;
+    pthread_mutex_unlock(&b->lock);
+    ncvisual* ncv = batch_load(b, b->files[idx]);
+    if(b->cb){
+      b->cb(idx, ncv, b->curry);
+    }
+    pthread_mutex_lock(&b->lock);
+    if(!b->cb){
+      b->results[b->qtail].idx = idx;
+      b->results[b->qtail].ncv = ncv;
+      ++b->qtail;
+    }
+    // with a callback, there's nothing to wake anyone for until the end
+    if(++b->finished == b->count || !b->cb){
+      ready_notify(b);
+      pthread_cond_broadcast(&b->cond);
+    }
+  }
+  pthread_mutex_unlock(&b->lock);
+  return NULL;
+}
+
+static unsigned
+batch_threads_wanted(const struct ncvisual_batch_options* opts, unsigned count){
+  unsigned threads = opts->threads;
+  if(threads == 0){
+    threads = host_cpu_count();
+  }
+  if(threads > BATCH_MAXTHREADS){
+    threads = BATCH_MAXTHREADS;
+  }
+  if(threads > count){
+    threads = count;
+  }
+  return threads;
+}
+
+static void
+batch_free(ncvisual_batch* b){
+  if(b->files){
+    for(unsigned i = 0 ; i < b->count ; ++i){
+      free(b->files[i]);
+    }
+    free(b->files);
+  }
+  free(b->results);
+  free(b->tids);
+  free(b);
+}
+
+ncvisual_batch* ncvisual_from_files_async(const char* const* files, unsigned count,
+                                          const struct ncvisual_batch_options* opts){
+  struct ncvisual_batch_options zeroed = {0};
+  if(opts == NULL){
+    opts = &zeroed;
+  }
+  if(opts->flags > 0){
+    logwarn("provided unsupported flags %016" PRIx64, opts->flags);
+  }
+  if(count == 0){
+    logerror("won't load an empty batch");
+    return NULL;
+  }
+  ncvisual_batch* b = malloc(sizeof(*b));
+  if(b == NULL){
+    return NULL;
+  }
+  memset(b, 0, sizeof(*b));
+  b->count = count;
+  b->pixy = opts->pixy;
+  b->pixx = opts->pixx;
+  b->cb = opts->cb;
+  b->curry = opts->curry;
+  const unsigned wanted = batch_threads_wanted(opts, count);
+  if((b->files = calloc(count, sizeof(*b->files))) == NULL ||
+     (b->tids = malloc(sizeof(*b->tids) * wanted)) == NULL){
+    batch_free(b);
+    return NULL;
+  }
+  if(b->cb == NULL){
+    if((b->results = malloc(sizeof(*b->results) * count)) == NULL){
+      batch_free(b);
+      return NULL;
+    }
+  }
+  for(unsigned i = 0 ; i < count ; ++i){
+    if((b->files[i] = strdup(files[i])) == NULL){
+      batch_free(b);
+      return NULL;
+    }
+  }
+  if(notify_pipes(b)){
+    batch_free(b);
+    return NULL;
+  }
+  pthread_mutex_init(&b->lock, NULL);
+  pthread_cond_init(&b->cond, NULL);
+  pthread_mutex_lock(&b->lock);
+  for(unsigned t = 0 ; t < wanted ; ++t){
+    if(pthread_create(&b->tids[t], NULL, batch_worker, b)){
+      logerror("couldn't spin up loader %u/%u", t, wanted);
+      break;
+    }
+    ++b->threads;
+  }
+  pthread_mutex_unlock(&b->lock);
+  if(b->threads == 0){
+    pthread_cond_destroy(&b->cond);
+    pthread_mutex_destroy(&b->lock);
+    close_notify(b);
+    batch_free(b);
+    return NULL;
+  }
+  loginfo("loading %u file%s on %u thread%s", count, count == 1 ? "" : "s",
+          b->threads, b->threads == 1 ? "" : "s");
+  return b;
+}
+
+int ncvisual_batch_fd(const ncvisual_batch* b){
+#ifndef __MINGW32__
+  return b->notify[0];
+#else
+  (void)b;
+  return -1;
+#endif
+}
+
+int ncvisual_batch_next(ncvisual_batch* b, unsigned* idx, ncvisual** ncv,
+                        bool blocking){
+  int ret;
+  pthread_mutex_lock(&b->lock);
+  for(;;){
+    if(b->qhead < b->qtail){
+      if(idx){
+        *idx = b->results[b->qhead].idx;
+      }
+      if(ncv){
+        *ncv = b->results[b->qhead].ncv;
+      }else{
+        ncvisual_destroy(b->results[b->qhead].ncv);
+      }
+      ++b->qhead;
+      ret = 1;
+      break;
+    }
+    if(b->finished == b->count){
+      ret = -1;
+      break;
+    }
+    if(!blocking){
+      ret = 0;
+      break;
+    }
+    pthread_cond_wait(&b->cond, &b->lock);
+  }
+  // the fd remains readable once the batch is complete, so that a poller
+  // learns of it; it's only drained while results are yet to come.
+  if(b->qhead == b->qtail && b->finished < b->count){
+    drain_notify(b);
+  }
+  pthread_mutex_unlock(&b->lock);
+  return ret;
+}
+
+void ncvisual_batch_destroy(ncvisual_batch* b){
+  if(b == NULL){
+    return;
+  }
+  // files already being loaded are allowed to finish
+  pthread_mutex_lock(&b->lock);
+  b->done = true;
+  pthread_mutex_unlock(&b->lock);
+  for(unsigned t = 0 ; t < b->threads ; ++t){
+    pthread_join(b->tids[t], NULL);
+  }
+  while(b->qhead < b->qtail){
+    ncvisual_destroy(b->results[b->qhead++].ncv);
+  }
+  pthread_cond_destroy(&b->cond);
+  pthread_mutex_destroy(&b->lock);
+  close_notify(b);
+  batch_free(b);
+}
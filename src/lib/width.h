@@ -0,0 +1,47 @@
+#ifndef NOTCURSES_WIDTH
+#define NOTCURSES_WIDTH
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// internal header, not installed
+
+#ifndef API
+#define NCWIDTH_UNDEF_API
+#ifndef __MINGW32__
+#define API __attribute__((visibility("default")))
+#else
+#define API __declspec(dllexport)
+#endif
+#endif
+
+// Codepoint widths, from a two-stage table generated by
+// tools/gen_widthtable.py (see widthtable.c). This replaces wcwidth(3),
+// which is slow (it goes through the locale), varies among libcs, and is
+// unusable with a 16-bit wchar_t. Each codepoint has two bits in a block of
+// NCWIDTH_BLOCK; stage1 maps the high bits of the codepoint to its block.
+
+#define NCWIDTH_BLOCK 256
+#define NCWIDTH_STAGE1 (0x110000 / NCWIDTH_BLOCK)
+
+extern const uint8_t ncwidth_stage1[NCWIDTH_STAGE1];
+extern const uint8_t ncwidth_stage2[][NCWIDTH_BLOCK / 4];
+
+// columns occupied by 'cp', as wcwidth() would have it: -1 for control
+// characters, 0 for zero-width codepoints, otherwise 1 or 2. honors any
+// replacement set with notcurses_set_width_fxn().
+API int ncwidth(uint32_t cp);
+
+#ifdef NCWIDTH_UNDEF_API
+#undef NCWIDTH_UNDEF_API
+#undef API
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -108,4 +108,99 @@ int prepare_windows_terminal(tinfo* ti, size_t* tablelen, size_t* tableused){
   ti->qterm = TERMINAL_MSTERMINAL;
   return 0;
 }
+
+// ConPTY handles each write as its own unit of work, parsing and repainting
+// for every one, so a frame split across many writes renders at a fraction
+// of the speed of the same frame delivered whole. go straight to WriteFile()
+// with the entire buffer, bypassing the CRT's fd layer (which can chop it
+// into small chunks).
+int windows_write(const tinfo* ti, const char* buf, size_t len){
+  while(len){
+    DWORD chunk = len > 0x40000000u ? 0x40000000u : (DWORD)len;
+    DWORD written;
+    if(!WriteFile(ti->outhandle, buf, chunk, &written, NULL)){
+      logerror("error writing %lu to console (%lu)", (unsigned long)chunk,
+               (unsigned long)GetLastError());
+      return -1;
+    }
+    buf += written;
+    len -= written;
+  }
+  return 0;
+}
+
+// with ENABLE_VIRTUAL_TERMINAL_INPUT, keyboard input (including any escape
+// sequences) arrives as the characters of KEY_EVENT records. pull as many
+// records as are waiting in a single ReadConsoleInputW(), and translate the
+// characters of key presses into UTF-8 at |buf|. other records (focus, menu,
+// and buffer size events) would otherwise leave the handle signaled with
+// nothing for read(2) to return; they're consumed here, with a buffer size
+// event setting |*resized|. returns the number of bytes written to |buf|.
+int windows_read_input(tinfo* ti, unsigned char* buf, size_t buflen, bool* resized){
+  // each UTF-16 unit becomes at most three bytes of UTF-8 (a surrogate pair
+  // becomes four, for two units).
+  INPUT_RECORD recs[128];
+  DWORD avail;
+  if(!GetNumberOfConsoleInputEvents(ti->inhandle, &avail)){
+    logerror("couldn't count console input (%lu)", (unsigned long)GetLastError());
+    return -1;
+  }
+  DWORD want = buflen / 4;
+  if(want > sizeof(recs) / sizeof(*recs)){
+    want = sizeof(recs) / sizeof(*recs);
+  }
+  if(avail < want){
+    want = avail;
+  }
+  if(want == 0){
+    return 0;
+  }
+  DWORD got;
+  if(!ReadConsoleInputW(ti->inhandle, recs, want, &got)){
+    logerror("couldn't read console input (%lu)", (unsigned long)GetLastError());
+    return -1;
+  }
+  size_t used = 0;
+  for(DWORD i = 0 ; i < got ; ++i){
+    if(recs[i].EventType == WINDOW_BUFFER_SIZE_EVENT){
+      *resized = true;
+      continue;
+    }
+    if(recs[i].EventType != KEY_EVENT){
+      continue;
+    }
+    const KEY_EVENT_RECORD* k = &recs[i].Event.KeyEvent;
+    wchar_t w[2];
+    int wlen = 0;
+    if(!k->bKeyDown || k->uChar.UnicodeChar == 0){
+      continue;
+    }
+    if(IS_HIGH_SURROGATE(k->uChar.UnicodeChar)){
+      ti->hisurrogate = k->uChar.UnicodeChar;
+      continue;
+    }
+    if(IS_LOW_SURROGATE(k->uChar.UnicodeChar)){
+      if(ti->hisurrogate == 0){
+        continue;
+      }
+      w[wlen++] = ti->hisurrogate;
+    }
+    ti->hisurrogate = 0;
+    w[wlen++] = k->uChar.UnicodeChar;
+    char u8[4];
+    int u8len = WideCharToMultiByte(CP_UTF8, 0, w, wlen, u8, sizeof(u8), NULL, NULL);
+    if(u8len <= 0){
+      continue;
+    }
+    for(WORD r = k->wRepeatCount ? k->wRepeatCount : 1 ; r ; --r){
+      if(used + u8len > buflen){
+        logwarn("dropping %u repeats of console input", r);
+        break;
+      }
+      memcpy(buf + used, u8, u8len);
+      used += u8len;
+    }
+  }
+  return used;
+}
 #endif
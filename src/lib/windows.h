@@ -1,6 +1,9 @@
 #ifndef NOTCURSES_WINDOWS
 #define NOTCURSES_WINDOWS
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -11,6 +14,15 @@ struct tinfo;
 int prepare_windows_terminal(struct tinfo* ti, size_t* tablelen,
                              size_t* tableused);
 
+// write all of |buf| to the console with as few WriteFile()s as possible.
+int windows_write(const struct tinfo* ti, const char* buf, size_t len);
+
+// read whatever console input records are waiting, without blocking, writing
+// the UTF-8 of any key presses to |buf|. sets |*resized| upon a buffer size
+// event. returns the number of bytes written, or -1 on error.
+int windows_read_input(struct tinfo* ti, unsigned char* buf, size_t buflen,
+                       bool* resized);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,4 +6,6 @@ ncsubproc_options Subproc::default_options = {
 	nullptr, // curry
 	0,			 // restart_period
 	0,			 // flags
+	0,			 // bufsize
+	0,			 // coalesce_ms
 };
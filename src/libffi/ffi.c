@@ -88,11 +88,14 @@ int nccells_heavy_box(struct ncplane* n, uint16_t attr, uint64_t channels,
                   nccell* ul, nccell* ur, nccell* ll, nccell* lr, nccell* hl, nccell* vl);
 int nccells_light_box(struct ncplane* n, uint16_t attr, uint64_t channels,
                   nccell* ul, nccell* ur, nccell* ll, nccell* lr, nccell* hl, nccell* vl);
+int nccells_load(struct ncplane* n, nccell* c, size_t count, const char* egcs);
 int nccells_load_box(struct ncplane* n, uint16_t styles, uint64_t channels,
                  nccell* ul, nccell* ur, nccell* ll, nccell* lr,
                  nccell* hl, nccell* vl, const char* gclusters);
 int nccells_rounded_box(struct ncplane* n, uint16_t attr, uint64_t channels,
                     nccell* ul, nccell* ur, nccell* ll, nccell* lr, nccell* hl, nccell* vl);
+int nccells_set_bg_rgb(nccell* c, const uint32_t* rgb, size_t count);
+int nccells_set_fg_rgb(nccell* c, const uint32_t* rgb, size_t count);
 int ncchannel_set(uint32_t* channel, uint32_t rgb);
 int ncchannel_set_alpha(uint32_t* channel, unsigned alpha);
 int ncchannel_set_palindex(uint32_t* channel, unsigned idx);
@@ -155,7 +158,6 @@ int ncplane_putchar(struct ncplane* n, char c);
 int ncplane_putchar_yx(struct ncplane* n, int y, int x, char c);
 int ncplane_putegc(struct ncplane* n, const char* gclust, size_t* sbytes);
 int ncplane_putnstr(struct ncplane* n, size_t s, const char* gclustarr);
-int ncplane_putnstr_yx(struct ncplane* n, int y, int x, size_t s, const char* gclusters);
 int ncplane_putstr(struct ncplane* n, const char* gclustarr);
 int ncplane_putstr_aligned(struct ncplane* n, int y, ncalign_e align, const char* s);
 int ncplane_putstr_stained(struct ncplane* n, const char* gclusters);
@@ -263,11 +265,18 @@ void nccell_set_bg_rgb8_clipped(nccell* cl, int r, int g, int b);
 void nccell_set_fg_default(nccell* c);
 void nccell_set_fg_rgb8_clipped(nccell* cl, int r, int g, int b);
 void nccell_set_styles(nccell* c, unsigned stylebits);
+void nccells_channels(const nccell* c, uint64_t* channels, size_t count);
+void nccells_set_channels(nccell* c, const uint64_t* channels, size_t count);
 void ncchannel_set_rgb8_clipped(uint32_t* channel, int r, int g, int b);
+void ncchannels_pack(uint64_t* channels, const uint32_t* fchans,
+                const uint32_t* bchans, size_t count);
 void ncchannels_set_bg_rgb8_clipped(uint64_t* channels, int r, int g, int b);
 void ncchannels_set_fg_rgb8_clipped(uint64_t* channels, int r, int g, int b);
+void ncchannels_unpack(const uint64_t* channels, uint32_t* fchans,
+                  uint32_t* bchans, size_t count);
 void ncplane_move_bottom(struct ncplane* n);
 void ncplane_move_family_bottom(struct ncplane* n);
 void ncplane_move_family_top(struct ncplane* n);
 void ncplane_move_top(struct ncplane* n);
+void ncxform_greyscale(ncxform* op);
 void notcurses_term_dim_yx(const struct notcurses* n, unsigned* restrict rows, unsigned* restrict cols);
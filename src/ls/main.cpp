@@ -1,5 +1,6 @@
 #define NCPP_EXCEPTIONS_PLEASE
-#include <queue>
+#include <deque>
+#include <memory>
 #include <thread>
 #include <vector>
 #include <atomic>
@@ -33,15 +34,6 @@ void usage(std::ostream& os, const char* name, int code){
   exit(code);
 }
 
-struct job {
-  // FIXME ought be a const std::string, but Mojave and maybe other
-  // platforms (any prior to C++17 for sure) are lamely lacking
-  // std::filesystem. alas.
-  // FIXME ideally we'd be handing off a dirfd, not a path.
-  std::string dir;
-  std::string p;
-};
-
 // FIXME see above; we ought have std::filesystem
 auto path_join(const std::string& dir, const std::string& p) -> std::string {
   if(dir.empty()){
@@ -50,11 +42,49 @@ auto path_join(const std::string& dir, const std::string& p) -> std::string {
   return dir + path_separator() + p;
 }
 
-static pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
+// each path we list gets a slot, and slots are emitted in the order a serial
+// walk would have visited them, no matter which thread fills them in. a
+// directory's slot holds the slots of its entries, and is complete once the
+// directory has been read.
+struct slot {
+  // FIXME ought be a const std::string, but Mojave and maybe other
+  // platforms (any prior to C++17 for sure) are lamely lacking
+  // std::filesystem. alas.
+  std::string dir;
+  std::string p;
+  bool isdir;       // entries are listed in |children|
+  bool islink;      // print the path, but don't try to decode it
+  bool ready;       // leaf has been decoded, or directory has been read
+  struct ncplane* ncp;
+  std::vector<std::unique_ptr<slot>> children;
+};
+
+// a unit of work: read the directory of |s|, or decode and blit its file.
+struct task {
+  slot* s;
+};
+
+// each worker owns a deque. it pushes and pops at the back; idle workers
+// steal from the front of others' deques, taking the oldest (and typically
+// largest) pieces of the walk.
+struct workdeque {
+  pthread_mutex_t lock;
+  std::deque<task> tasks;
+};
+
+static std::vector<workdeque> deques;
+static thread_local int myqueue = -1; // index into deques, -1 off-worker
+static std::atomic<unsigned> nextqueue; // round-robin for the main thread
+static std::atomic<unsigned> queued;    // tasks sitting in deques
+static std::atomic<unsigned> pending;   // tasks not yet completed
+static bool submitted;  // all command line paths have been walked
+static pthread_mutex_t idlemtx = PTHREAD_MUTEX_INITIALIZER; // guards submitted
+static pthread_cond_t idlecond = PTHREAD_COND_INITIALIZER;
+
 static pthread_mutex_t outmtx = PTHREAD_MUTEX_INITIALIZER; // guards standard out
-static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
-std::queue<job> work;  // jobs available for workers
-bool keep_working;     // set false when we're done so threads die
+static slot root;       // holds the command line paths
+// where we are in the output walk: slots, and the next child of each.
+static std::vector<std::pair<slot*, size_t>> outstack;
 
 // context as configured on the command line
 struct lsContext {
@@ -72,70 +102,185 @@ struct lsContext {
   ncscale_e scaling;
 };
 
-int handle_path(int dirfd, const std::string& dir, const char* p, const lsContext& ctx, bool toplevel);
+static void push_task(slot* s){
+  ++pending;
+  unsigned q = myqueue >= 0 ? myqueue : nextqueue++ % deques.size();
+  pthread_mutex_lock(&deques[q].lock);
+  deques[q].tasks.push_back(task{s});
+  pthread_mutex_unlock(&deques[q].lock);
+  ++queued;
+  pthread_mutex_lock(&idlemtx);
+  pthread_cond_signal(&idlecond);
+  pthread_mutex_unlock(&idlemtx);
+}
+
+// pop from the back of our own deque, or steal from the front of another's.
+static bool get_task(task* t){
+  const unsigned count = deques.size();
+  for(unsigned i = 0 ; i < count ; ++i){
+    const unsigned q = (myqueue + i) % count;
+    workdeque& d = deques[q];
+    pthread_mutex_lock(&d.lock);
+    if(!d.tasks.empty()){
+      if(i == 0){
+        *t = d.tasks.back();
+        d.tasks.pop_back();
+      }else{
+        *t = d.tasks.front();
+        d.tasks.pop_front();
+      }
+      pthread_mutex_unlock(&d.lock);
+      --queued;
+      return true;
+    }
+    pthread_mutex_unlock(&d.lock);
+  }
+  return false;
+}
+
+static void finish_task(void){
+  if(--pending == 0){
+    pthread_mutex_lock(&idlemtx);
+    pthread_cond_broadcast(&idlecond);
+    pthread_mutex_unlock(&idlemtx);
+  }
+}
+
+static void emit_slot(const lsContext& ctx, ncplane* stdn, const slot* s){
+  if(s->islink){
+    std::cout << path_join(s->dir, s->p) << '\n';
+    return;
+  }
+  ncplane_printf(stdn, "%s\n", s->p.c_str());
+  ncplane* ncp = s->ncp;
+  if(ncp){
+    ncplane_reparent(ncp, stdn);
+    ncplane_move_yx(ncp, ncplane_cursor_y(stdn), ncplane_cursor_x(stdn));
+    ncplane_scrollup_child(stdn, ncp);
+    notcurses_render(ctx.nc);
+    ncplane_cursor_move_yx(stdn, ncplane_dim_y(ncp) + ncplane_y(ncp), 0);
+    ncplane_putchar(stdn, '\n');
+    notcurses_render(ctx.nc);
+  }
+  // FIXME don't delete plane right now, or we wipe it, but we can't keep
+  // them all open forevermore! free *any we have scrolled off*.
+}
+
+// emit every slot which is ready and has no unready slot ahead of it,
+// releasing slots behind us. call with outmtx held.
+static void flush_output(const lsContext& ctx){
+  ncplane* stdn = notcurses_stdplane(ctx.nc);
+  while(!outstack.empty()){
+    slot* s = outstack.back().first;
+    size_t idx = outstack.back().second;
+    if(!s->ready){
+      return;
+    }
+    if(idx == s->children.size()){
+      s->children.clear();
+      outstack.pop_back();
+      continue;
+    }
+    slot* c = s->children[idx].get();
+    if(c->isdir){
+      ++outstack.back().second;
+      outstack.emplace_back(c, 0);
+      continue;
+    }
+    if(!c->ready){
+      return;
+    }
+    emit_slot(ctx, stdn, c);
+    s->children[idx].reset();
+    ++outstack.back().second;
+  }
+}
+
+static void complete_slot(const lsContext& ctx, slot* s, ncplane* ncp,
+                          std::vector<std::unique_ptr<slot>>* kids){
+  pthread_mutex_lock(&outmtx);
+  s->ncp = ncp;
+  if(kids){
+    s->children = std::move(*kids);
+  }
+  s->ready = true;
+  flush_output(ctx);
+  pthread_mutex_unlock(&outmtx);
+}
+
+int handle_path(int dirfd, const std::string& dir, const char* p, const lsContext& ctx,
+                bool toplevel, std::vector<std::unique_ptr<slot>>& kids);
+
+static slot* add_slot(std::vector<std::unique_ptr<slot>>& kids,
+                      const std::string& dir, const char* p, bool isdir){
+  kids.emplace_back(new slot{dir, p, isdir, false, false, nullptr, {}});
+  return kids.back().get();
+}
 
 // handle a single inode of arbitrary type
-int handle_inode(const std::string& dir, const char* p){
-  pthread_mutex_lock(&mtx);
-  work.emplace(job{dir, p});
-  pthread_mutex_unlock(&mtx);
-  pthread_cond_signal(&cond);
+int handle_inode(const std::string& dir, const char* p,
+                 std::vector<std::unique_ptr<slot>>& kids){
+  push_task(add_slot(kids, dir, p, false));
   return 0;
 }
 
 // if |ctx->directories| is true, only print details of |p|, and return.
 // otherwise, if |ctx->recursedirs| or |toplevel| is set, we will recurse,
 // passing false for toplevel (but preserving |ctx|).
-int handle_dir(int dirfd, const std::string& pdir, const char* p,
-               const lsContext& ctx, bool toplevel){
+int handle_dir(const std::string& pdir, const char* p, const lsContext& ctx,
+               bool toplevel, std::vector<std::unique_ptr<slot>>& kids){
   if(ctx.directories){
-    return handle_inode(pdir, p);
+    return handle_inode(pdir, p, kids);
   }
   if(!ctx.recursedirs && !toplevel){
-    return handle_inode(pdir, p);
+    return handle_inode(pdir, p, kids);
   }
   if((strcmp(p, ".") == 0 || strcmp(p, "..") == 0) && !toplevel){
     return 0;
   }
+  push_task(add_slot(kids, pdir, p, true));
+  return 0;
+}
+
+// read the directory of |s|, creating slots (and tasks) for its entries.
+static void read_dir(slot* s, const lsContext& ctx){
+  std::vector<std::unique_ptr<slot>> kids;
+  const std::string path = path_join(s->dir, s->p);
+  const char* p = s->p.c_str();
   int newdir = -1;
 #ifndef __MINGW32__
-  newdir = openat(dirfd, p, O_DIRECTORY | O_CLOEXEC);
+  newdir = open(path.c_str(), O_DIRECTORY | O_CLOEXEC);
   if(newdir < 0){
     std::cerr << "Error opening " << p << ": " << strerror(errno) << std::endl;
-    return -1;
+    complete_slot(ctx, s, nullptr, &kids);
+    return;
   }
   DIR* dir = fdopendir(newdir);
 #else
-  (void)dirfd;
-  DIR* dir = opendir(path_join(pdir, p).c_str());
+  DIR* dir = opendir(path.c_str());
 #endif
   if(dir == nullptr){
     std::cerr << "Error opening " << p << ": " << strerror(errno) << std::endl;
     close(newdir);
-    return -1;
+    complete_slot(ctx, s, nullptr, &kids);
+    return;
   }
   struct dirent* dent;
-  int r = 0;
   while(errno = 0, (dent = readdir(dir))){
-    r |= handle_path(newdir, path_join(pdir, p), dent->d_name, ctx, false);
+    handle_path(newdir, path, dent->d_name, ctx, false, kids);
   }
   if(errno){
     std::cerr << "Error reading from " << p << ": " << strerror(errno) << std::endl;
-    closedir(dir);
-    close(newdir);
-    return -1;
   }
   closedir(dir);
-  if(newdir >= 0){
-    close(newdir);
-  }
-  return r;
+  complete_slot(ctx, s, nullptr, &kids);
 }
 
 // handle some path |p|, either absolute or relative to |dirfd|. |toplevel| is
 // true iff the path was directly listed on the command line. we rely on lstat()
 // and fstatat() to resolve symbolic links for us.
-int handle_path(int dirfd, const std::string& pdir, const char* p, const lsContext& ctx, bool toplevel){
+int handle_path(int dirfd, const std::string& pdir, const char* p, const lsContext& ctx,
+                bool toplevel, std::vector<std::unique_ptr<slot>>& kids){
   struct stat st;
 #ifndef __MINGW32__
   int flags = AT_NO_AUTOMOUNT;
@@ -147,68 +292,68 @@ int handle_path(int dirfd, const std::string& pdir, const char* p, const lsConte
     return -1;
   }
 #else
+  (void)dirfd;
   if(stat(path_join(pdir, p).c_str(), &st)){
     std::cerr << "Error running stat(" << p << "): " << strerror(errno) << std::endl;
     return -1;
   }
 #endif
   if((st.st_mode & S_IFMT) == S_IFDIR){
-    return handle_dir(dirfd, pdir, p, ctx, toplevel);
+    return handle_dir(pdir, p, ctx, toplevel, kids);
   }else if((st.st_mode & S_IFMT) == S_IFLNK){
-    pthread_mutex_lock(&outmtx);
-    std::cout << path_join(pdir, p) << '\n';
-    pthread_mutex_unlock(&outmtx);
+    slot* s = add_slot(kids, pdir, p, false);
+    s->islink = true;
+    s->ready = true;
     return 0;
   }
-  return handle_inode(pdir, p);
+  return handle_inode(pdir, p, kids);
 }
 
-// return long-term return code
-void ncls_thread(const lsContext* ctx) {
+// decode and blit the file of |s|. this happens in parallel; only emission
+// of the finished slot is serialized.
+static void decode_file(slot* s, const lsContext& ctx, unsigned dimy, unsigned dimx){
+  auto path = path_join(s->dir, s->p);
+  auto ncv = ncvisual_from_file(path.c_str());
+  struct ncplane* ncp = nullptr;
+  if(ncv){
+    struct ncvisual_options vopts{};
+    vopts.blitter = ctx.blitter;
+    vopts.scaling = ctx.scaling;
+    if(ctx.default_scaling){
+      struct ncvgeom geom;
+      ncvisual_geom(ctx.nc, ncv, &vopts, &geom);
+      if(geom.rcellx > dimx || geom.rcelly > dimy){
+        vopts.scaling = NCSCALE_SCALE_HIRES;
+      }
+    }
+    ncp = ncvisual_blit(ctx.nc, ncv, &vopts);
+  }
+  ncvisual_destroy(ncv);
+  complete_slot(ctx, s, ncp, nullptr);
+}
+
+void ncls_thread(const lsContext* ctx, int id) {
+  myqueue = id;
   unsigned dimy, dimx;
-  ncplane* stdn = notcurses_stddim_yx(ctx->nc, &dimy, &dimx);
+  notcurses_stddim_yx(ctx->nc, &dimy, &dimx);
   while(true){
-    pthread_mutex_lock(&mtx);
-    while(work.empty() && keep_working){
-      pthread_cond_wait(&cond, &mtx);
-    }
-    if(!work.empty()){
-      job j = work.front();
-      work.pop();
-      pthread_mutex_unlock(&mtx);
-      auto s = path_join(j.dir, j.p);
-      auto ncv = ncvisual_from_file(s.c_str());
-      struct ncplane* ncp = nullptr;
-      if(ncv){
-        struct ncvisual_options vopts{};
-        vopts.blitter = ctx->blitter;
-        vopts.scaling = ctx->scaling;
-        if(ctx->default_scaling){
-          struct ncvgeom geom;
-          ncvisual_geom(ctx->nc, ncv, &vopts, &geom);
-          if(geom.rcellx > dimx || geom.rcelly > dimy){
-            vopts.scaling = NCSCALE_SCALE_HIRES;
-          }
-        }
-        ncp = ncvisual_blit(ctx->nc, ncv, &vopts);
+    task t;
+    if(get_task(&t)){
+      if(t.s->isdir){
+        read_dir(t.s, *ctx);
+      }else{
+        decode_file(t.s, *ctx, dimy, dimx);
       }
-      ncvisual_destroy(ncv);
-      pthread_mutex_lock(&outmtx);
-      ncplane_printf(stdn, "%s\n", j.p.c_str());
-      if(ncp){
-        ncplane_reparent(ncp, stdn);
-        ncplane_move_yx(ncp, ncplane_cursor_y(stdn), ncplane_cursor_x(stdn));
-        ncplane_scrollup_child(stdn, ncp);
-        notcurses_render(ctx->nc);
-        ncplane_cursor_move_yx(stdn, ncplane_dim_y(ncp) + ncplane_y(ncp), 0);
-        ncplane_putchar(stdn, '\n');
-        notcurses_render(ctx->nc);
-      }
-      pthread_mutex_unlock(&outmtx);
-      // FIXME don't delete plane right now, or we wipe it, but we can't keep
-      // them all open forevermore! free *any we have scrolled off*.
-    }else if(!keep_working){
-      pthread_mutex_unlock(&mtx);
+      finish_task();
+      continue;
+    }
+    pthread_mutex_lock(&idlemtx);
+    while(queued == 0 && !(submitted && pending == 0)){
+      pthread_cond_wait(&idlecond, &idlemtx);
+    }
+    const bool done = queued == 0 && submitted && pending == 0;
+    pthread_mutex_unlock(&idlemtx);
+    if(done){
       return;
     }
   }
@@ -222,12 +367,14 @@ int list_paths(const char* const * argv, const lsContext& ctx){
     std::cerr << "Error opening current directory: " << strerror(errno) << std::endl;
     return -1;
   }
+  std::vector<std::unique_ptr<slot>> kids;
   int ret = 0;
   while(*argv){
-    ret |= handle_path(dirfd, "", *argv, ctx, true);
+    ret |= handle_path(dirfd, "", *argv, ctx, true, kids);
     ++argv;
   }
   close(dirfd);
+  complete_slot(ctx, &root, nullptr, &kids);
   return ret;
 }
 
@@ -327,14 +474,20 @@ int main(int argc, char* const * argv){
   if((ctx.nc = notcurses_init(&nopts, nullptr)) == nullptr){
     return EXIT_FAILURE;
   }
-  keep_working = true;
+  deques = std::vector<workdeque>(procs);
+  for(auto& d : deques){
+    pthread_mutex_init(&d.lock, nullptr);
+  }
+  outstack.emplace_back(&root, 0);
   for(auto s = 0u ; s < procs ; ++s){
-    threads.emplace_back(std::thread(ncls_thread, &ctx));
+    threads.emplace_back(std::thread(ncls_thread, &ctx, s));
   }
   static const char* const default_args[] = { ".", nullptr };
   list_paths(argv[optind] ? argv + optind : default_args, ctx);
-  keep_working = false;
-  pthread_cond_broadcast(&cond);
+  pthread_mutex_lock(&idlemtx);
+  submitted = true;
+  pthread_cond_broadcast(&idlecond);
+  pthread_mutex_unlock(&idlemtx);
   for(auto &t : threads){
 //std::cerr << "Waiting on thread " << procs << std::endl;
     t.join();
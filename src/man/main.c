@@ -385,28 +385,57 @@ draw_domnode(struct ncplane* p, const pagedom* dom, const pagenode* n,
       fprintf(stderr, "unhandled ltype %d\n", n->ttype->ltype);
       return 0; // FIXME
   }
-  for(unsigned z = 0 ; z < n->subcount ; ++z){
-    if(draw_domnode(p, dom, &n->subs[z], wrotetext, insubsec)){
+  return 0;
+}
+
+// how many bytes of troff we lex at a time
+#define PARSE_CHUNK 16384
+
+static inline bool
+layout_complete(const pagedom* dom){
+  return dom->parser.done && dom->laidout == dom->ordercount;
+}
+
+// lay out nodes in document order until the page plane's cursor has reached
+// row |y|, resuming the parse as necessary (the most recent node might still
+// gain text, so we don't draw it until the parse has moved past it). the
+// plane grows as we go. returns 1 once the entire document has been laid
+// out, 0 if there remains work, and -1 on error.
+static int
+layout_to(struct ncplane* p, pagedom* dom, unsigned y){
+  while(!layout_complete(dom)){
+    if(ncplane_cursor_y(p) >= y){
+      return 0;
+    }
+    if(!dom->parser.done && dom->laidout + 1 >= dom->ordercount){
+      if(troff_parse(dom, PARSE_CHUNK)){
+        return -1;
+      }
+      continue;
+    }
+    const pagenode* n = dom->order[dom->laidout++];
+    if(draw_domnode(p, dom, n, &dom->wrotetext, &dom->insubsec)){
       return -1;
     }
   }
-  return 0;
+  return 1;
 }
 
-// for now, we draw the entire thing, resizing as necessary, and we'll
-// scroll the entire plane. higher memory cost, longer initial latency,
-// very fast moves.
+// we draw only as far as a screen past the bottom of the visible area,
+// growing the plane as the user moves down (and while they're idle). moves
+// within what's been drawn are just moves of the plane.
 static int
 draw_content(struct ncplane* stdn, struct ncplane* p){
   pagedom* dom = ncplane_userptr(p);
-  unsigned wrotetext = 0; // unused by us
-  unsigned insubsec = 0;
+  dom->laidout = 0;
+  dom->wrotetext = 0;
+  dom->insubsec = 0;
   docstructure_free(dom->ds);
   dom->ds = docstructure_create(stdn);
   if(dom->ds == NULL){
     return -1;
   }
-  return draw_domnode(p, dom, dom->root, &wrotetext, &insubsec);
+  return layout_to(p, dom, ncplane_dim_y(stdn) * 2) < 0 ? -1 : 0;
 }
 
 static int
@@ -421,17 +450,15 @@ resize_pman(struct ncplane* pman){
   return r;
 }
 
-// we create a plane sized appropriately for the troff data. all we do
-// after that is move the plane up and down.
+// we create a plane sized to the screen, and lay out only the top of the
+// troff data. it grows as further content is laid out; otherwise, all we do
+// is move the plane up and down.
 static struct ncplane*
 render_troff(struct notcurses* nc, const unsigned char* map, size_t mlen,
              pagedom* dom){
   unsigned dimy, dimx;
   struct ncplane* stdn = notcurses_stddim_yx(nc, &dimy, &dimx);
-  // this is just an estimate
-  if(troff_parse(map, mlen, dom)){
-    return NULL;
-  }
+  troff_parse_start(dom, map, mlen);
   // this is just an estimate
   struct ncplane_options popts = {
     .rows = dimy - 2,
@@ -453,6 +480,9 @@ render_troff(struct notcurses* nc, const unsigned char* map, size_t mlen,
   return pman;
 }
 
+// rows laid out per idle pass
+#define IDLE_ROWS 256
+
 static const char USAGE_TEXT[] = "⎥h←s→l⎢⎥b⇞k↑↓j⇟f⎢ (q)uit";
 static const char USAGE_TEXT_ASCII[] = "(hsl) (bkjf) (q)uit";
 
@@ -492,7 +522,8 @@ domnode_destroy(pagenode* node){
   if(node){
     free(node->text);
     for(unsigned z = 0 ; z < node->subcount ; ++z){
-      domnode_destroy(&node->subs[z]);
+      domnode_destroy(node->subs[z]);
+      free(node->subs[z]);
     }
     free(node->subs);
   }
@@ -503,6 +534,7 @@ pagedom_destroy(pagedom* dom){
   destroy_trofftrie(dom->trie);
   domnode_destroy(dom->root);
   free(dom->root);
+  free(dom->order);
   free(dom->title);
   free(dom->version);
   free(dom->section);
@@ -578,7 +610,22 @@ manloop(struct notcurses* nc, const char* arg, unsigned noui){
     bool movedown = false;
     int newy = ncplane_y(page);
     ncinput ni;
-    key = notcurses_get(nc, NULL, &ni);
+    if(layout_complete(&dom)){
+      key = notcurses_get(nc, NULL, &ni);
+    }else{
+      // while there's nothing to do, lay out more of the page (and thus
+      // learn more of its structure).
+      struct timespec ts = {0};
+      if((key = notcurses_get(nc, &ts, &ni)) == 0){
+        if(layout_to(page, &dom, ncplane_cursor_y(page) + IDLE_ROWS) < 0){
+          goto done;
+        }
+        if(notcurses_render(nc)){
+          goto done;
+        }
+        continue;
+      }
+    }
     if(ni.evtype == NCTYPE_RELEASE){
       continue;
     }
@@ -595,6 +642,12 @@ manloop(struct notcurses* nc, const char* arg, unsigned noui){
         newy = docstructure_prev(dom.ds);
         break;
       case 'l': case NCKEY_RIGHT:
+        // we might not yet have reached the next section
+        while(docstructure_atend(dom.ds) && !layout_complete(&dom)){
+          if(layout_to(page, &dom, ncplane_cursor_y(page) + IDLE_ROWS) < 0){
+            goto done;
+          }
+        }
         newy = docstructure_next(dom.ds);
         movedown = true;
         break;
@@ -623,6 +676,10 @@ manloop(struct notcurses* nc, const char* arg, unsigned noui){
     if(newy > 1){
       newy = 1;
     }
+    // keep a screen laid out beyond the bottom of the visible area
+    if(movedown && layout_to(page, &dom, 1 - newy + 2 * ncplane_dim_y(stdn)) < 0){
+      goto done;
+    }
     if(newy + (int)ncplane_dim_y(page) < (int)ncplane_dim_y(stdn)){
       newy += (int)ncplane_dim_y(stdn) - (newy + (int)ncplane_dim_y(page)) - 1;
     }
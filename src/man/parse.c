@@ -192,17 +192,37 @@ lex_title(pagedom* dom){
   return 0;
 }
 
+// record |n| as the latest node in document order.
+static int
+add_order(pagedom* dom, pagenode* n){
+  pagenode** tmporder = realloc(dom->order, sizeof(*dom->order) * (dom->ordercount + 1));
+  if(tmporder == NULL){
+    return -1;
+  }
+  dom->order = tmporder;
+  dom->order[dom->ordercount++] = n;
+  return 0;
+}
+
 static pagenode*
-add_node(pagenode* pnode, char* text){
+add_node(pagedom* dom, pagenode* pnode, char* text){
   unsigned ncount = pnode->subcount + 1;
-  pagenode* tmpsubs = realloc(pnode->subs, sizeof(*pnode->subs) * ncount);
+  pagenode** tmpsubs = realloc(pnode->subs, sizeof(*pnode->subs) * ncount);
   if(tmpsubs == NULL){
     return NULL;
   }
   pnode->subs = tmpsubs;
-  pagenode* r = pnode->subs + pnode->subcount;
-  pnode->subcount = ncount;
+  pagenode* r = malloc(sizeof(*r));
+  if(r == NULL){
+    return NULL;
+  }
   memset(r, 0, sizeof(*r));
+  if(add_order(dom, r)){
+    free(r);
+    return NULL;
+  }
+  pnode->subs[pnode->subcount] = r;
+  pnode->subcount = ncount;
   r->text = text;
 //fprintf(stderr, "ADDED SECTION %s %u\n", text, pnode->subcount);
   return r;
@@ -233,16 +253,30 @@ augment_text(pagenode* pnode, const unsigned char* ws, const unsigned char* feol
   return pnode->text;
 }
 
+void troff_parse_start(pagedom* dom, const unsigned char* map, size_t mlen){
+  memset(&dom->parser, 0, sizeof(dom->parser));
+  dom->parser.map = map;
+  dom->parser.mlen = mlen;
+}
+
 // extract the page structure.
 // FIXME we need to fuzz this, hard
-int troff_parse(const unsigned char* map, size_t mlen, pagedom* dom){
+int troff_parse(pagedom* dom, size_t budget){
   const struct troffnode* trie = dom->trie;
-  const unsigned char* line = map;
-  pagenode* current_section = NULL;
-  pagenode* current_subsection = NULL;
-  pagenode* current_para = NULL;
-  bool preformatted = false;
-  for(size_t off = 0 ; off < mlen ; ++off){
+  troffparser* tp = &dom->parser;
+  const unsigned char* map = tp->map;
+  const size_t mlen = tp->mlen;
+  const size_t startoff = tp->off;
+  const unsigned char* line = map + startoff;
+  pagenode* current_section = tp->section;
+  pagenode* current_subsection = tp->subsection;
+  pagenode* current_para = tp->para;
+  bool preformatted = tp->preformatted;
+  size_t off;
+  for(off = startoff ; off < mlen ; ++off){
+    if(off - startoff >= budget){
+      break;
+    }
     const unsigned char* ws = line;
     size_t left = mlen - off;
     const trofftype* node = get_type(trie, &ws, left);
@@ -290,6 +324,9 @@ int troff_parse(const unsigned char* map, size_t mlen, pagedom* dom){
       memset(dom->root, 0, sizeof(*dom->root));
       dom->root->ttype = node;
       dom->root->text = et;
+      if(add_order(dom, dom->root)){
+        return -1;
+      }
       if(lex_title(dom)){
         return -1;
       }
@@ -303,7 +340,7 @@ int troff_parse(const unsigned char* map, size_t mlen, pagedom* dom){
       if(et == NULL){
         return -1;
       }
-      if((current_section = add_node(dom->root, et)) == NULL){
+      if((current_section = add_node(dom, dom->root, et)) == NULL){
         free(et);
         return -1;
       }
@@ -320,7 +357,7 @@ int troff_parse(const unsigned char* map, size_t mlen, pagedom* dom){
         free(et);
         return -1;
       }
-      if((current_subsection = add_node(current_section, et)) == NULL){
+      if((current_subsection = add_node(dom, current_section, et)) == NULL){
         free(et);
         return -1;
       }
@@ -331,7 +368,7 @@ int troff_parse(const unsigned char* map, size_t mlen, pagedom* dom){
         fprintf(stderr, "paragraph transcends structure\n");
         return -1;
       }
-      if((current_para = add_node(current_para, NULL)) == NULL){
+      if((current_para = add_node(dom, current_para, NULL)) == NULL){
         return -1;
       }
       current_para->ttype = node;
@@ -340,7 +377,7 @@ int troff_parse(const unsigned char* map, size_t mlen, pagedom* dom){
         fprintf(stderr, "tagged paragraph transcends structure\n");
         return -1;
       }
-      if((current_para = add_node(current_para, NULL)) == NULL){
+      if((current_para = add_node(dom, current_para, NULL)) == NULL){
         return -1;
       }
       current_para->ttype = node;
@@ -348,9 +385,17 @@ int troff_parse(const unsigned char* map, size_t mlen, pagedom* dom){
     off += eol - line;
     line = eol + 1;
   }
-  if(dom_get_title(dom) == NULL){
-    fprintf(stderr, "no title found\n");
-    return -1;
+  tp->off = off;
+  tp->section = current_section;
+  tp->subsection = current_subsection;
+  tp->para = current_para;
+  tp->preformatted = preformatted;
+  if(off >= mlen){
+    tp->done = true;
+    if(dom_get_title(dom) == NULL){
+      fprintf(stderr, "no title found\n");
+      return -1;
+    }
   }
   return 0;
 }
@@ -7,6 +7,7 @@ extern "C" {
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef enum {
   LINE_UNKNOWN,
@@ -46,13 +47,28 @@ struct troffnode {
   const trofftype *ttype;
 };
 
+// nodes are individually allocated, so that pointers to them remain valid
+// as the document grows.
 typedef struct pagenode {
   char* text;
   const trofftype* ttype;
-  struct pagenode* subs;
+  struct pagenode** subs;
   unsigned subcount;
 } pagenode;
 
+// the parse can be resumed, so that we needn't have seen the entire map
+// before drawing the top of the page.
+typedef struct troffparser {
+  const unsigned char* map;
+  size_t mlen;
+  size_t off;             // start of the next line to be lexed
+  struct pagenode* section;
+  struct pagenode* subsection;
+  struct pagenode* para;  // most recently added node, which text augments
+  bool preformatted;
+  bool done;              // we've reached the end of the map
+} troffparser;
+
 typedef struct pagedom {
   struct pagenode* root;
   struct troffnode* trie;
@@ -62,6 +78,15 @@ typedef struct pagedom {
   char* footer;
   char* header;
   struct docstructure* ds;
+  // every node, in document order (which is the order of their creation).
+  // a node is complete only once another follows it, or the parse is done.
+  struct pagenode** order;
+  unsigned ordercount;
+  troffparser parser;
+  // layout state. nodes before |laidout| have been drawn.
+  unsigned laidout;
+  unsigned wrotetext;
+  unsigned insubsec;
 } pagedom;
 
 static inline const char*
@@ -74,7 +99,14 @@ get_type(const struct troffnode* trie, const unsigned char** ws, size_t len);
 
 struct troffnode* trofftrie(void);
 
-int troff_parse(const unsigned char* map, size_t mlen, pagedom* dom);
+// begin a parse of the |mlen| bytes at |map|, which must remain valid until
+// the parse is done (or abandoned).
+void troff_parse_start(pagedom* dom, const unsigned char* map, size_t mlen);
+
+// resume the parse, lexing whole lines until at least |budget| bytes have
+// been consumed, or the map is exhausted (at which point dom->parser.done is
+// set). returns -1 on a malformed page.
+int troff_parse(pagedom* dom, size_t budget);
 
 void destroy_trofftrie(struct troffnode* root);
 
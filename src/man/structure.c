@@ -148,6 +148,10 @@ int docstructure_add(docstructure* ds, const char* title, int y){
   return 0;
 }
 
+unsigned docstructure_atend(const docstructure* ds){
+  return ds->curnode + 1 >= ds->count;
+}
+
 // returns corresponding y
 int docstructure_prev(docstructure* ds){
   if(ds->curnode){
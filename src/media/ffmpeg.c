@@ -1,10 +1,12 @@
 #include "builddef.h"
 #ifdef USE_FFMPEG
+#include <libavutil/cpu.h>
 #include <libavutil/error.h>
 #include <libavutil/frame.h>
 #include <libavutil/pixdesc.h>
 #include <libavutil/version.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/hwcontext.h>
 #include <libavcodec/avcodec.h>
 #include <libavutil/rational.h>
 #include <libswscale/swscale.h>
@@ -15,6 +17,10 @@
 #include "lib/visual-details.h"
 #include "lib/internal.h"
 
+// <term.h> defines the terminfo capability device_type, which we need as
+// a member of AVCodecHWConfig.
+#undef device_type
+
 struct AVFormatContext;
 struct AVCodecContext;
 struct AVFrame;
@@ -22,6 +28,37 @@ struct AVCodec;
 struct AVCodecParameters;
 struct AVPacket;
 
+// a frame of a looping visual held by ncvisual_set_loopcache(), along with
+// its scaling for the most recent blit geometry.
+typedef struct loopframe {
+  uint8_t* rgba;           // RGBA, |stride| bytes per row
+  int stride, rows, cols;
+  uint8_t* scaled;         // NULL if never scaled
+  size_t scaledbytes;
+  int scaledstride, scaledrows, scaledcols; // scaledrows is 0 while invalid
+  int scaledleny, scaledlenx, scaledflags;  // source region and sws flags
+} loopframe;
+
+// a frame held by ncvisual_seek()'s scrub cache, along with its timing.
+typedef struct scrubframe {
+  uint8_t* rgba;           // RGBA, |stride| bytes per row
+  int stride, rows, cols;
+  int64_t pts;             // best-effort presentation time (stream time_base)
+  int64_t duration;        // pkt_duration, 0 if unknown
+} scrubframe;
+
+// the scrub cache holds at most this many frames, and this many bytes.
+#define SCRUB_MAXFRAMES 64
+#define SCRUB_MAXBYTES (256ul << 20u)
+
+typedef enum {
+  LOOPCACHE_OFF,
+  LOOPCACHE_ARMED,         // waiting for the next pass to begin
+  LOOPCACHE_RECORDING,     // the current pass is being kept
+  LOOPCACHE_REPLAYING,     // the pass was kept, and the decoder is idle
+  LOOPCACHE_FAILED,        // the pass didn't fit
+} loopcache_e;
+
 typedef struct ncvisual_details {
   struct AVFormatContext* fmtctx;
   struct AVCodecContext* codecctx;     // video codec context
@@ -32,10 +69,52 @@ typedef struct ncvisual_details {
   struct AVPacket* packet;
   struct SwsContext* swsctx;
   struct SwsContext* rgbactx;
+  uint8_t* scaled;         // scaling destination, kept across blits
+  int scaledstride;
+  int scaledrows, scaledcols;
   AVSubtitle subtitle;
   int stream_index;        // match against this following av_read_frame()
   int sub_stream_index;    // subtitle stream index, can be < 0 if no subtitles
   bool packet_outstanding;
+  bool draining;           // end of input reached, flushing the decoder
+  // hardware decoding (see NOTCURSES_HWACCEL)
+  struct AVBufferRef* hwdevctx; // NULL if decoding in software
+  struct AVFrame* hwframe; // frame as decoded into device memory
+  enum AVPixelFormat hwpixfmt;
+  enum AVPixelFormat dlformat; // format in which frames are downloaded
+  bool dlprobed;           // dlformat has been chosen
+  unsigned frameno;        // frames decoded since opening or rewinding
+  // ncvisual_set_loopcache() state. while replaying, |frame| is |replay|,
+  // describing the cached frame, and our own frame is kept in |stash|.
+  loopcache_e loopstate;
+  loopframe* loopframes;
+  unsigned loopcount, loopsize;
+  unsigned loopidx;        // frame being replayed
+  size_t loopbytes, loopmax;
+  struct AVFrame* replay;
+  struct AVFrame* stash;
+  // ncvisual_subtitle_update() state. |subserial| advances with each new
+  // subtitle; |subwritten| is the one last written to |subplane|, which
+  // belongs to the caller (we never dereference it).
+  unsigned subserial, subwritten;
+  const struct ncplane* subplane;
+  unsigned subparenty, subparentx;
+  // ncvisual_seek() state. |keypts| holds the presentation time of each
+  // keyframe, sorted, indexed upon the first seek. once it exists, frames
+  // are kept in |scrub| as they're decoded: a consecutive run, the last of
+  // which is the decoder's position (|lastpts|). |scrubidx| is that being
+  // presented; while it's not the last, |frame| is |replay| (describing the
+  // cached frame) and our own frame is kept in |stash|, as when replaying
+  // the loop cache. the two caches are never used together.
+  int64_t* keypts;
+  unsigned keycount;
+  scrubframe* scrub;
+  unsigned scrubcount, scrubidx;
+  size_t scrubbytes;
+  bool scrubshown;         // a cached frame is being presented
+  int64_t lastpts;         // pts of the frame last decoded
+  int64_t curpts;          // pts of the frame being presented
+  int64_t curduration;     // pkt_duration of the frame being presented
 } ncvisual_details;
 
 #define IMGALLOCALIGN 64
@@ -115,29 +194,53 @@ deass(const char* ass){
   return dup;
 }
 
-static struct ncplane*
-subtitle_plane_from_text(ncplane* parent, const char* text){
+// place |*subp| as a child of |parent| with the geometry |rows|x|cols|, just
+// above its bottom row. an existing plane is reused if it is of the right
+// kind (bitmap or text); otherwise, it's replaced.
+static int
+subtitle_plane_place(ncplane* parent, ncplane** subp, bool bitmap,
+                     int rows, int cols, const char* name){
+  const int y = ncplane_dim_y(parent) - (rows + 1);
+  if(*subp && (ncplane_parent_const(*subp) != parent || !!(*subp)->sprite != bitmap)){
+    ncplane_destroy(*subp);
+    *subp = NULL;
+  }
+  if(*subp){
+    if(ncplane_resize_simple(*subp, rows, cols) || ncplane_move_yx(*subp, y, 0)){
+      return -1;
+    }
+    return 0;
+  }
+  struct ncplane_options nopts = {
+    .y = y,
+    .rows = rows,
+    .cols = cols,
+    .name = name,
+  };
+  if((*subp = ncplane_create(parent, &nopts)) == NULL){
+//logerror("error creating subtitle plane\n");
+    return -1;
+  }
+  return 0;
+}
+
+static int
+subtitle_plane_from_text(ncplane* parent, const char* text, ncplane** subp){
   if(parent == NULL){
 //logerror("need a parent plane\n");
-    return NULL;
+    return -1;
   }
   int width = ncstrwidth(text, NULL, NULL);
   if(width <= 0){
 //logwarn("couldn't extract subtitle from %s\n", text);
-    return NULL;
+    return 1;
   }
   int rows = (width + ncplane_dim_x(parent) - 1) / ncplane_dim_x(parent);
-  struct ncplane_options nopts = {
-    .y = ncplane_dim_y(parent) - (rows + 1),
-    .rows = rows,
-    .cols = ncplane_dim_x(parent),
-    .name = "subt",
-  };
-  struct ncplane* n = ncplane_create(parent, &nopts);
-  if(n == NULL){
-//logerror("error creating subtitle plane\n");
-    return NULL;
+  if(subtitle_plane_place(parent, subp, false, rows, ncplane_dim_x(parent), "subt")){
+    return -1;
   }
+  struct ncplane* n = *subp;
+  ncplane_erase(n);
   uint64_t channels = 0;
   ncchannels_set_fg_alpha(&channels, NCALPHA_HIGHCONTRAST);
   ncchannels_set_fg_rgb8(&channels, 0x88, 0x88, 0x88);
@@ -146,26 +249,63 @@ subtitle_plane_from_text(ncplane* parent, const char* text){
   ncplane_puttext(n, 0, NCALIGN_LEFT, text, NULL);
   ncchannels_set_bg_alpha(&channels, NCALPHA_TRANSPARENT);
   ncplane_set_base(n, " ", 0, channels);
-  return n;
+  return 0;
 }
 
 static uint32_t palette[NCPALETTESIZE];
 
-struct ncplane* ffmpeg_subtitle(ncplane* parent, const ncvisual* ncv){
+static int
+subtitle_plane_from_bitmap(ncplane* parent, const AVSubtitleRect* rect, ncplane** subp){
+  struct notcurses* nc = ncplane_notcurses(parent);
+  const unsigned cellpxy = ncplane_pile_const(parent)->cellpxy;
+  const unsigned cellpxx = ncplane_pile_const(parent)->cellpxx;
+  if(cellpxy <= 0 || cellpxx <= 0){
+    return 1;
+  }
+  struct ncvisual* v = ncvisual_from_palidx(rect->data[0], rect->h,
+                                            rect->w, rect->w,
+                                            NCPALETTESIZE, 1, palette);
+  if(v == NULL){
+    return -1;
+  }
+  int rows = (rect->h + cellpxx - 1) / cellpxy;
+  if(subtitle_plane_place(parent, subp, true, rows,
+                          (rect->w + cellpxx - 1) / cellpxx, "t1st")){
+    ncvisual_destroy(v);
+    return -1;
+  }
+  // blitting onto the plane's existing sprixel reuses it
+  struct ncvisual_options vopts = {
+    .n = *subp,
+    .blitter = NCBLIT_PIXEL,
+    .scaling = NCSCALE_STRETCH,
+  };
+  if(ncvisual_blit(nc, v, &vopts) == NULL){
+    ncvisual_destroy(v);
+    return -1;
+  }
+  ncvisual_destroy(v);
+  return 0;
+}
+
+// write the current subtitle to |*subp|, creating it if necessary. returns
+// 1 if there is no subtitle we can show.
+static int
+subtitle_write(ncplane* parent, const ncvisual* ncv, ncplane** subp){
   for(unsigned i = 0 ; i < ncv->details->subtitle.num_rects ; ++i){
     // it is possible that there are more than one subtitle rects present,
     // but we only bother dealing with the first one we find FIXME?
     const AVSubtitleRect* rect = ncv->details->subtitle.rects[i];
     if(rect->type == SUBTITLE_ASS){
       char* ass = deass(rect->ass);
-      struct ncplane* n = NULL;
+      int r = 1;
       if(ass){
-        n = subtitle_plane_from_text(parent, ass);
+        r = subtitle_plane_from_text(parent, ass, subp);
       }
       free(ass);
-      return n;
+      return r;
     }else if(rect->type == SUBTITLE_TEXT){;
-      return subtitle_plane_from_text(parent, rect->text);
+      return subtitle_plane_from_text(parent, rect->text, subp);
     }else if(rect->type == SUBTITLE_BITMAP){
       // there are technically up to AV_NUM_DATA_POINTERS planes, but we
       // only try to work with the first FIXME?
@@ -173,45 +313,46 @@ struct ncplane* ffmpeg_subtitle(ncplane* parent, const ncvisual* ncv){
 //logwarn("bitmap subtitle size %d != width %d\n", rect->linesize[0], rect->w);
         continue;
       }
-      struct notcurses* nc = ncplane_notcurses(parent);
-      const unsigned cellpxy = ncplane_pile_const(parent)->cellpxy;
-      const unsigned cellpxx = ncplane_pile_const(parent)->cellpxx;
-      if(cellpxy <= 0 || cellpxx <= 0){
-        continue;
-      }
-      struct ncvisual* v = ncvisual_from_palidx(rect->data[0], rect->h,
-                                                rect->w, rect->w,
-                                                NCPALETTESIZE, 1, palette);
-      if(v == NULL){
-        return NULL;
+      int r = subtitle_plane_from_bitmap(parent, rect, subp);
+      if(r <= 0){
+        return r;
       }
-      int rows = (rect->h + cellpxx - 1) / cellpxy;
-      struct ncplane_options nopts = {
-        .rows = rows,
-        .cols = (rect->w + cellpxx - 1) / cellpxx,
-        .y = ncplane_dim_y(parent) - rows - 1,
-        .name = "t1st",
-      };
-      struct ncplane* vn = ncplane_create(parent, &nopts);
-      if(vn == NULL){
-        ncvisual_destroy(v);
-        return NULL;
-      }
-      struct ncvisual_options vopts = {
-        .n = vn,
-        .blitter = NCBLIT_PIXEL,
-        .scaling = NCSCALE_STRETCH,
-      };
-      if(ncvisual_blit(nc, v, &vopts) == NULL){
-        ncplane_destroy(vn);
-        ncvisual_destroy(v);
-        return NULL;
-      }
-      ncvisual_destroy(v);
-      return vn;
     }
   }
-  return NULL;
+  return 1;
+}
+
+struct ncplane* ffmpeg_subtitle(ncplane* parent, const ncvisual* ncv){
+  ncplane* n = NULL;
+  if(subtitle_write(parent, ncv, &n)){
+    ncplane_destroy(n);
+    return NULL;
+  }
+  return n;
+}
+
+// |*subp| is only rewritten if the subtitle has changed since we last wrote
+// it, or the parent has been resized (text is wrapped to its width).
+static int
+ffmpeg_subtitle_update(ncplane* parent, const ncvisual* ncv, ncplane** subp){
+  ncvisual_details* deets = ncv->details;
+  unsigned dimy, dimx;
+  ncplane_dim_yx(parent, &dimy, &dimx);
+  if(*subp && *subp == deets->subplane && deets->subwritten == deets->subserial &&
+     ncplane_parent_const(*subp) == parent &&
+     dimy == deets->subparenty && dimx == deets->subparentx){
+    return 0;
+  }
+  int r = subtitle_write(parent, ncv, subp);
+  if(r){ // nothing to show, or an error
+    ncplane_destroy(*subp);
+    *subp = NULL;
+  }
+  deets->subplane = *subp;
+  deets->subwritten = deets->subserial;
+  deets->subparenty = dimy;
+  deets->subparentx = dimx;
+  return r < 0 ? -1 : 0;
 }
 
 static int
@@ -290,76 +431,174 @@ force_rgba(ncvisual* n){
   return 0;
 }
 
-// turn arbitrary input packets into RGBA frames. reads packets until it gets
-// a visual frame. a packet might contain several frames (this is typically
+// turn arbitrary input packets into frames. reads packets until it gets a
+// visual frame. a packet might contain several frames (this is typically
 // true only of audio), and a frame might be carried across several packets.
 // * avcodec_receive_frame() returns EAGAIN if it needs more packets.
 // * avcodec_send_packet() returns EAGAIN if avcodec_receive_frame() needs
 //    be called to extract further frames; in this case, the packet ought
 //    be resubmitted once the existing frames are cleared.
+// subtitles encountered along the way are decoded into |subtitle|, and
+// |subtitled| (if not NULL) is set whenever that happens.
+// copy a frame out of device memory. where the device supports it, we
+// download directly to RGBA, and no conversion is necessary.
 static int
-ffmpeg_decode(ncvisual* n){
-  if(n->details->fmtctx == NULL){ // not a file-backed ncvisual
-    return -1;
+ffmpeg_download(ncvisual_details* deets, AVFrame* dst, AVFrame* src){
+  if(!deets->dlprobed){
+    deets->dlprobed = true;
+    deets->dlformat = AV_PIX_FMT_NONE; // device's preferred format
+    enum AVPixelFormat* fmts;
+    if(av_hwframe_transfer_get_formats(src->hw_frames_ctx,
+                                       AV_HWFRAME_TRANSFER_DIRECTION_FROM,
+                                       &fmts, 0) >= 0){
+      for(const enum AVPixelFormat* f = fmts ; *f != AV_PIX_FMT_NONE ; ++f){
+        if(*f == AV_PIX_FMT_RGBA){
+          deets->dlformat = AV_PIX_FMT_RGBA;
+          break;
+        }
+      }
+      av_free(fmts);
+    }
   }
+  av_frame_unref(dst);
+  dst->format = deets->dlformat;
+  int averr = av_hwframe_transfer_data(dst, src, 0);
+  if(averr >= 0){
+    averr = av_frame_copy_props(dst, src);
+  }
+  av_frame_unref(src);
+  return averr < 0 ? -1 : 0;
+}
+
+static int
+ffmpeg_decode_frame(ncvisual_details* deets, AVFrame* frame,
+                    AVSubtitle* subtitle, bool* subtitled){
+  // with hardware decoding, we decode into hwframe, and download to frame
+  AVFrame* recv = deets->hwframe ? deets->hwframe : frame;
   bool have_frame = false;
   bool unref = false;
   // note that there are two loops here; once we're out of the external one,
   // we've either returned a failure, or we have a frame. averr2ncerr()
   // translates AVERROR_EOF into a return of 1.
   do{
-    if(!n->details->packet_outstanding){
+    if(!deets->packet_outstanding && !deets->draining){
+      bool eof = false;
       do{
         if(unref){
-          av_packet_unref(n->details->packet);
+          av_packet_unref(deets->packet);
         }
         int averr;
-        if((averr = av_read_frame(n->details->fmtctx, n->details->packet)) < 0){
-          /*if(averr != AVERROR_EOF){
-            fprintf(stderr, "Error reading frame info (%s)\n", av_err2str(averr));
-          }*/
-          return averr2ncerr(averr);
+        if((averr = av_read_frame(deets->fmtctx, deets->packet)) < 0){
+          if(averr != AVERROR_EOF){
+            //fprintf(stderr, "Error reading frame info (%s)\n", av_err2str(averr));
+            return averr2ncerr(averr);
+          }
+          eof = true;
+          break;
         }
         unref = true;
-        if(n->details->packet->stream_index == n->details->sub_stream_index){
+        if(deets->packet->stream_index == deets->sub_stream_index){
           int result = 0, ret;
-          avsubtitle_free(&n->details->subtitle);
-          ret = avcodec_decode_subtitle2(n->details->subtcodecctx, &n->details->subtitle, &result, n->details->packet);
+          avsubtitle_free(subtitle);
+          ret = avcodec_decode_subtitle2(deets->subtcodecctx, subtitle, &result, deets->packet);
           if(ret >= 0 && result){
             // FIXME?
           }
+          if(subtitled){
+            *subtitled = true;
+          }
         }
-      }while(n->details->packet->stream_index != n->details->stream_index);
-      n->details->packet_outstanding = true;
-      int averr = avcodec_send_packet(n->details->codecctx, n->details->packet);
+      }while(deets->packet->stream_index != deets->stream_index);
+      int averr;
+      if(eof){
+        // the decoder can be holding frames back (several, when frame
+        // threading). a NULL packet puts it into draining mode, from which
+        // we receive those frames, and then AVERROR_EOF.
+        deets->draining = true;
+        averr = avcodec_send_packet(deets->codecctx, NULL);
+      }else{
+        deets->packet_outstanding = true;
+        averr = avcodec_send_packet(deets->codecctx, deets->packet);
+      }
       if(averr < 0){
-        n->details->packet_outstanding = false;
-        av_packet_unref(n->details->packet);
+        deets->packet_outstanding = false;
+        av_packet_unref(deets->packet);
   //fprintf(stderr, "Error processing AVPacket\n");
         return averr2ncerr(averr);
       }
     }
-    int averr = avcodec_receive_frame(n->details->codecctx, n->details->frame);
+    int averr = avcodec_receive_frame(deets->codecctx, recv);
     if(averr >= 0){
       have_frame = true;
     }else if(averr < 0){
-      av_packet_unref(n->details->packet);
+      av_packet_unref(deets->packet);
       have_frame = false;
-      n->details->packet_outstanding = false;
+      deets->packet_outstanding = false;
+      if(deets->draining){ // nothing more is coming
+        return averr2ncerr(averr == AVERROR(EAGAIN) ? AVERROR_EOF : averr);
+      }
       if(averr != AVERROR(EAGAIN)){
         return averr2ncerr(averr);
       }
     }
 //fprintf(stderr, "Error decoding AVPacket\n");
   }while(!have_frame);
+  if(recv != frame){
+    if(recv->hw_frames_ctx){
+      if(ffmpeg_download(deets, frame, recv)){
+        return -1;
+      }
+    }else{
+      // the decoder fell back to software for this stream
+      av_frame_unref(frame);
+      av_frame_move_ref(frame, recv);
+    }
+  }
+  deets->lastpts = frame->best_effort_timestamp;
+  return 0;
+}
+
+static int scrub_next(ncvisual* ncv);
+static void scrub_record(ncvisual* ncv);
+
+// decode the next frame into the ncvisual, converting it to RGBA.
+static int
+ffmpeg_decode(ncvisual* n){
+  if(n->details->fmtctx == NULL){ // not a file-backed ncvisual
+    return -1;
+  }
+  if(n->details->scrubshown){
+    int r = scrub_next(n);
+    if(r <= 0){
+      return r;
+    }
+  }
+  const uint64_t tstart = nctrace_begin();
+  bool subtitled = false;
+  int r = ffmpeg_decode_frame(n->details, n->details->frame,
+                              &n->details->subtitle, &subtitled);
+  if(subtitled){
+    ++n->details->subserial;
+  }
+  if(r){
+    nctrace_end("ffmpeg_decode", tstart, NULL, 0);
+    return r;
+  }
 //print_frame_summary(n->details->codecctx, n->details->frame);
   const AVFrame* f = n->details->frame;
+  n->details->curpts = f->best_effort_timestamp;
+  n->details->curduration = f->pkt_duration;
   n->rowstride = f->linesize[0];
   n->pixx = n->details->frame->width;
   n->pixy = n->details->frame->height;
 //fprintf(stderr, "good decode! %d/%d %d %p\n", n->details->frame->height, n->details->frame->width, n->rowstride, f->data);
   ncvisual_set_data(n, f->data[0], false);
   force_rgba(n);
+  ++n->details->frameno;
+  if(n->details->keypts){
+    scrub_record(n);
+  }
+  nctrace_end("ffmpeg_decode", tstart, "pixels", (int64_t)n->pixy * n->pixx);
   return 0;
 }
 
@@ -370,6 +609,8 @@ ffmpeg_details_init(void){
     memset(deets, 0, sizeof(*deets));
     deets->stream_index = -1;
     deets->sub_stream_index = -1;
+    deets->lastpts = AV_NOPTS_VALUE;
+    deets->curpts = AV_NOPTS_VALUE;
     if((deets->frame = av_frame_alloc()) == NULL){
       free(deets);
       return NULL;
@@ -391,8 +632,118 @@ ffmpeg_create(){
   return nc;
 }
 
+// NOTCURSES_DECODE_THREADS overrides the number of processors available to
+// us. decoders use frame and slice threading, as they're able.
+#define DECODE_MAXTHREADS 16
+
+static void
+ffmpeg_threads(AVCodecContext* cctx){
+  unsigned threads = 0;
+  const char* dt = getenv("NOTCURSES_DECODE_THREADS");
+  if(dt){
+    char* endl;
+    unsigned long l = strtoul(dt, &endl, 10);
+    if(*dt && !*endl && l > 0 && l <= DECODE_MAXTHREADS){
+      threads = l;
+    }
+  }
+  if(threads == 0){
+    threads = av_cpu_count();
+    if(threads > DECODE_MAXTHREADS){
+      threads = DECODE_MAXTHREADS;
+    }
+  }
+  cctx->thread_count = threads;
+  cctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+}
+
+static enum AVPixelFormat
+ffmpeg_get_format(AVCodecContext* cctx, const enum AVPixelFormat* fmts){
+  const ncvisual_details* deets = cctx->opaque;
+  for(const enum AVPixelFormat* f = fmts ; *f != AV_PIX_FMT_NONE ; ++f){
+    if(*f == deets->hwpixfmt){
+      return *f;
+    }
+  }
+  // the device can't handle this stream; decode it in software
+  return avcodec_default_get_format(cctx, fmts);
+}
+
+// set up decoding on a device of the specified type, if the codec supports it.
+static int
+ffmpeg_hwdevice(ncvisual_details* deets, enum AVHWDeviceType type){
+  const AVCodecHWConfig* cfg;
+  for(int i = 0 ; (cfg = avcodec_get_hw_config(deets->codec, i)) ; ++i){
+    if(!(cfg->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX)){
+      continue;
+    }
+    if(cfg->device_type != type){
+      continue;
+    }
+    if(av_hwdevice_ctx_create(&deets->hwdevctx, type, NULL, NULL, 0) < 0){
+      return -1;
+    }
+    if((deets->codecctx->hw_device_ctx = av_buffer_ref(deets->hwdevctx)) == NULL){
+      av_buffer_unref(&deets->hwdevctx);
+      return -1;
+    }
+    if((deets->hwframe = av_frame_alloc()) == NULL){
+      av_buffer_unref(&deets->codecctx->hw_device_ctx);
+      av_buffer_unref(&deets->hwdevctx);
+      return -1;
+    }
+    deets->hwpixfmt = cfg->pix_fmt;
+    deets->codecctx->opaque = deets;
+    deets->codecctx->get_format = ffmpeg_get_format;
+    return 0;
+  }
+  return -1;
+}
+
+// NOTCURSES_HWACCEL, if set, names an FFmpeg hardware device type ("vaapi",
+// "vdpau", "videotoolbox", "d3d11va", etc.), or "auto" to try each type
+// known to FFmpeg in turn. we fall back to software decoding on any failure.
+static void
+ffmpeg_hwaccel(ncvisual_details* deets){
+  const char* hw = getenv("NOTCURSES_HWACCEL");
+  if(hw == NULL || !*hw){
+    return;
+  }
+  if(strcmp(hw, "auto")){
+    enum AVHWDeviceType type = av_hwdevice_find_type_by_name(hw);
+    if(type != AV_HWDEVICE_TYPE_NONE){
+      ffmpeg_hwdevice(deets, type);
+    }
+    return;
+  }
+  enum AVHWDeviceType type = AV_HWDEVICE_TYPE_NONE;
+  while((type = av_hwdevice_iterate_types(type)) != AV_HWDEVICE_TYPE_NONE){
+    if(ffmpeg_hwdevice(deets, type) == 0){
+      return;
+    }
+  }
+}
+
+// decode at 1/2, 1/4, or 1/8 scale (JPEG DCT scaling, for instance) if the
+// codec supports it, and the result needn't be any larger.
+static void
+ffmpeg_lowres(AVCodecContext* cctx, const AVCodec* codec,
+              unsigned minpixy, unsigned minpixx){
+  int lowres = 0;
+  while(lowres < codec->max_lowres){
+    if((unsigned)(cctx->width >> (lowres + 1)) < minpixx){
+      break;
+    }
+    if((unsigned)(cctx->height >> (lowres + 1)) < minpixy){
+      break;
+    }
+    ++lowres;
+  }
+  cctx->lowres = lowres;
+}
+
 static ncvisual*
-ffmpeg_from_file(const char* filename){
+ffmpeg_from_file(const char* filename, unsigned minpixy, unsigned minpixx){
   ncvisual* ncv = ffmpeg_create();
   if(ncv == NULL){
     // fprintf(stderr, "Couldn't create %s (%s)\n", filename, strerror(errno));
@@ -456,6 +807,12 @@ ffmpeg_from_file(const char* filename){
   if(avcodec_parameters_to_context(ncv->details->codecctx, st->codecpar) < 0){
     goto err;
   }
+  ffmpeg_threads(ncv->details->codecctx);
+  ffmpeg_lowres(ncv->details->codecctx, ncv->details->codec, minpixy, minpixx);
+  // hardware decoders don't implement lowres
+  if(ncv->details->codecctx->lowres == 0){
+    ffmpeg_hwaccel(ncv->details);
+  }
   if(avcodec_open2(ncv->details->codecctx, ncv->details->codec, NULL) < 0){
     //fprintf(stderr, "Couldn't open codec for %s (%s)\n", filename, av_err2str(*averr));
     goto err;
@@ -473,6 +830,415 @@ err:
   return NULL;
 }
 
+// choose the swscale algorithm. cell blitters throw away most of the detail
+// (there are only a few pixels per cell), so unless the caller asks for
+// something specific, they get bilinear, and bitmaps get Lanczos.
+static int
+ffmpeg_sws_flags(ncblitter_e blitter, uint64_t flags){
+  if(flags & NCVISUAL_OPTION_SCALEFAST){
+    return SWS_FAST_BILINEAR;
+  }else if(flags & NCVISUAL_OPTION_SCALEAREA){
+    return SWS_AREA;
+  }else if(flags & NCVISUAL_OPTION_SCALEFINE){
+    return SWS_LANCZOS;
+  }
+  return blitter == NCBLIT_PIXEL ? SWS_LANCZOS : SWS_BILINEAR;
+}
+
+// with NCVISUAL_OPTION_PIPELINE, ffmpeg_stream() hands reading, decoding and
+// scaling to a decoder thread, which fills a small ring of RGBA frames scaled
+// to the geometry of the most recent blit. the streaming thread need only
+// blit and render them, and a slow decode needn't delay a presentation.
+#define STREAM_QUEUE_DEPTH 4
+
+typedef struct streamslot {
+  uint8_t* data;         // scaled RGBA, from av_image_alloc()
+  int linesize;
+  int rows, cols;        // geometry of data (pixels)
+  int64_t duration;      // pkt_duration of the source frame
+  int64_t pts;           // best-effort presentation time of the source frame
+  AVSubtitle subtitle;   // subtitle decoded ahead of this frame
+  bool subtitled;        // subtitle replaces the current one
+} streamslot;
+
+typedef struct streamqueue {
+  pthread_mutex_t lock;  // guards everything through |done|
+  pthread_cond_t cond;   // signaled by both producer and consumer
+  // slots [head, head + count) are ready for presentation. the slot before
+  // |head| is presented through the ncvisual, and mustn't be touched.
+  streamslot slots[STREAM_QUEUE_DEPTH];
+  unsigned head;
+  unsigned count;
+  int rows, cols;        // geometry to which new frames are scaled
+  int swsflags;          // scaling algorithm, from ffmpeg_sws_flags()
+  bool stop;             // consumer's request that the decoder exit
+  bool done;             // decoder has exited, with |status|
+  int status;            // 1 at end of stream, -1 on error
+  // everything below is the decoder thread's alone
+  notcurses* nc;
+  ncvisual_details* deets;
+  AVFrame* frame;        // decoded, unscaled frame
+  AVSubtitle subtitle;   // subtitle not yet attached to a frame
+  bool subtitled;
+  struct SwsContext* swsctx;
+  pthread_t tid;
+} streamqueue;
+
+static void ffmpeg_details_seed(ncvisual* ncv);
+static int scrub_leave(ncvisual* ncv);
+static void scrub_free(ncvisual_details* deets);
+
+// call only while holding the queue lock.
+static void
+stream_update_depth(streamqueue* q){
+  stats_lock(&q->nc->stats);
+    q->nc->stats.s.stream_queue_depth = q->count;
+  stats_unlock(&q->nc->stats);
+}
+
+// scale the decoded frame into |s|, reusing its buffer if the geometry holds.
+static int
+stream_scale(streamqueue* q, streamslot* s, int rows, int cols){
+  const AVFrame* f = q->frame;
+  const int targformat = AV_PIX_FMT_RGBA;
+  q->swsctx = sws_getCachedContext(q->swsctx, f->width, f->height, f->format,
+                                   cols, rows, targformat,
+                                   q->swsflags, NULL, NULL, NULL);
+  if(q->swsctx == NULL){
+    return -1;
+  }
+  uint8_t* dptrs[4] = { s->data, };
+  int dlinesizes[4] = { s->linesize, };
+  if(s->data == NULL || s->rows != rows || s->cols != cols){
+    av_freep(&s->data);
+    if(av_image_alloc(dptrs, dlinesizes, cols, rows, targformat, IMGALLOCALIGN) < 0){
+      return -1;
+    }
+    s->data = dptrs[0];
+    s->linesize = dlinesizes[0];
+    s->rows = rows;
+    s->cols = cols;
+  }
+  if(sws_scale(q->swsctx, (const uint8_t* const*)f->data, f->linesize,
+               0, f->height, dptrs, dlinesizes) < 0){
+    return -1;
+  }
+  s->duration = f->pkt_duration;
+  s->pts = f->best_effort_timestamp;
+  return 0;
+}
+
+static void*
+stream_decoder(void* vq){
+  streamqueue* q = vq;
+  nc_thread_setup("decode");
+  int r;
+  for(;;){
+    pthread_mutex_lock(&q->lock);
+    while(!q->stop && q->count == STREAM_QUEUE_DEPTH - 1){
+      pthread_cond_wait(&q->cond, &q->lock);
+    }
+    const bool stop = q->stop;
+    streamslot* s = &q->slots[(q->head + q->count) % STREAM_QUEUE_DEPTH];
+    const int rows = q->rows;
+    const int cols = q->cols;
+    pthread_mutex_unlock(&q->lock);
+    if(stop){
+      r = 0;
+      break;
+    }
+    if((r = ffmpeg_decode_frame(q->deets, q->frame, &q->subtitle, &q->subtitled))){
+      break;
+    }
+    if(stream_scale(q, s, rows, cols)){
+      r = -1;
+      break;
+    }
+    if(q->subtitled){
+      avsubtitle_free(&s->subtitle);
+      s->subtitle = q->subtitle;
+      memset(&q->subtitle, 0, sizeof(q->subtitle));
+      s->subtitled = true;
+      q->subtitled = false;
+    }
+    pthread_mutex_lock(&q->lock);
+    ++q->count;
+    stream_update_depth(q);
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+  }
+  pthread_mutex_lock(&q->lock);
+  q->status = r;
+  q->done = true;
+  pthread_cond_broadcast(&q->cond);
+  pthread_mutex_unlock(&q->lock);
+  return NULL;
+}
+
+// frames are scaled before anything of the blit is known but its geometry,
+// so regions of the source (specified in its own pixels) can't be honored,
+// nor can NCVISUAL_OPTION_NOINTERPOLATE.
+static bool
+stream_pipelinable(const ncvisual* ncv, const struct ncvisual_options* vopts){
+  if(!(vopts->flags & NCVISUAL_OPTION_PIPELINE)){
+    return false;
+  }
+  if(vopts->flags & NCVISUAL_OPTION_NOINTERPOLATE){
+    return false;
+  }
+  if(vopts->begy || vopts->begx || vopts->leny || vopts->lenx){
+    return false;
+  }
+  return ncv->details->fmtctx != NULL;
+}
+
+// start decoding ahead of the current frame, scaling to |rows|x|cols|.
+// returns NULL on failure, in which case we ought decode inline.
+static streamqueue*
+stream_start(notcurses* nc, ncvisual* ncv, int rows, int cols, int swsflags){
+  if(rows <= 0 || cols <= 0){
+    return NULL;
+  }
+  // the decoder is about to move without the scrub cache
+  if(scrub_leave(ncv)){
+    return NULL;
+  }
+  scrub_free(ncv->details);
+  streamqueue* q = malloc(sizeof(*q));
+  if(q == NULL){
+    return NULL;
+  }
+  memset(q, 0, sizeof(*q));
+  q->nc = nc;
+  q->deets = ncv->details;
+  q->rows = rows;
+  q->cols = cols;
+  q->swsflags = swsflags;
+  if((q->frame = av_frame_alloc()) == NULL){
+    free(q);
+    return NULL;
+  }
+  if(pthread_mutex_init(&q->lock, NULL)){
+    av_frame_free(&q->frame);
+    free(q);
+    return NULL;
+  }
+  if(pthread_cond_init(&q->cond, NULL)){
+    pthread_mutex_destroy(&q->lock);
+    av_frame_free(&q->frame);
+    free(q);
+    return NULL;
+  }
+  if(pthread_create(&q->tid, NULL, stream_decoder, q)){
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    av_frame_free(&q->frame);
+    free(q);
+    return NULL;
+  }
+  return q;
+}
+
+// scale subsequent frames to the geometry with which we're now blitting.
+static void
+stream_retarget(streamqueue* q, int rows, int cols){
+  if(rows <= 0 || cols <= 0){
+    return;
+  }
+  pthread_mutex_lock(&q->lock);
+  q->rows = rows;
+  q->cols = cols;
+  pthread_mutex_unlock(&q->lock);
+}
+
+// codecctx seems to be off by a factor of 2 regularly. instead, go with
+// the time_base from the avformatctx. except ts isn't properly reset for
+// all media when we loop =[. we seem to be accurate enough now with the
+// tbase/ppd. see https://github.com/dankamongmen/notcurses/issues/1352.
+static double
+ffmpeg_timebase(const ncvisual* ncv){
+  double tbase = av_q2d(ncv->details->fmtctx->streams[ncv->details->stream_index]->time_base);
+  if(isnan(tbase)){
+    tbase = 0;
+  }
+  return tbase;
+}
+
+// take the next frame from the queue, waiting upon the decoder if it's empty.
+// a frame which can't be written (at the predicted |cost|) before its
+// presentation time has passed is dropped, so long as another is ready to
+// take its place; its duration still counts against the schedule in
+// |sum_duration|. returns 1 at the end of the stream.
+static int
+stream_next(notcurses* nc, streamqueue* q, ncvisual* ncv, uint64_t nsbegin,
+            float timescale, uint64_t cost, uint64_t* sum_duration){
+  const double tbase = ffmpeg_timebase(ncv);
+  uint64_t dropped = 0;
+  streamslot* s;
+  pthread_mutex_lock(&q->lock);
+  for(;;){
+    while(q->count == 0 && !q->done){
+      pthread_cond_wait(&q->cond, &q->lock);
+    }
+    if(q->count == 0){
+      pthread_mutex_unlock(&q->lock);
+      return q->status;
+    }
+    s = &q->slots[q->head];
+    q->head = (q->head + 1) % STREAM_QUEUE_DEPTH;
+    --q->count;
+    // carry subtitles forward, even from frames we drop
+    if(s->subtitled){
+      avsubtitle_free(&ncv->details->subtitle);
+      ncv->details->subtitle = s->subtitle;
+      memset(&s->subtitle, 0, sizeof(s->subtitle));
+      ++ncv->details->subserial;
+      s->subtitled = false;
+    }
+    if(q->count == 0){
+      break;
+    }
+    const uint64_t duration = s->duration * tbase * NANOSECS_IN_SEC * timescale;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if(timespec_to_ns(&now) + cost <= nsbegin + *sum_duration + duration){
+      break;
+    }
+    *sum_duration += duration;
+    ++dropped;
+  }
+  stream_update_depth(q);
+  pthread_cond_broadcast(&q->cond);
+  pthread_mutex_unlock(&q->lock);
+  if(dropped){
+    stats_lock(&nc->stats);
+      nc->stats.s.stream_frames_dropped += dropped;
+    stats_unlock(&nc->stats);
+  }
+  // we now hold |s| until the next call, and present it through the ncvisual
+  ncv->pixy = s->rows;
+  ncv->pixx = s->cols;
+  ncv->rowstride = s->linesize;
+  ncvisual_set_data(ncv, s->data, false);
+  ffmpeg_details_seed(ncv);
+  ncv->details->frame->pkt_duration = s->duration;
+  ncv->details->curpts = s->pts;
+  ncv->details->curduration = s->duration;
+  return 0;
+}
+
+// stop the decoder, and release the queue. if the ncvisual is presenting one
+// of our frames, it takes ownership of that frame's buffer.
+static void
+stream_stop(streamqueue* q, ncvisual* ncv){
+  if(q == NULL){
+    return;
+  }
+  pthread_mutex_lock(&q->lock);
+  q->stop = true;
+  pthread_cond_broadcast(&q->cond);
+  pthread_mutex_unlock(&q->lock);
+  pthread_join(q->tid, NULL);
+  for(unsigned i = 0 ; i < STREAM_QUEUE_DEPTH ; ++i){
+    streamslot* s = &q->slots[i];
+    if(s->data && (uint32_t*)s->data == ncv->data){
+      ncvisual_set_data(ncv, s->data, true);
+    }else{
+      av_freep(&s->data);
+    }
+    avsubtitle_free(&s->subtitle);
+  }
+  stats_lock(&q->nc->stats);
+    q->nc->stats.s.stream_queue_depth = 0;
+  stats_unlock(&q->nc->stats);
+  avsubtitle_free(&q->subtitle);
+  av_frame_free(&q->frame);
+  sws_freeContext(q->swsctx);
+  pthread_cond_destroy(&q->cond);
+  pthread_mutex_destroy(&q->lock);
+  free(q);
+}
+
+// ffmpeg_stream() schedules each frame against the start of the stream. we
+// predict what it costs to get a frame onto the terminal (decoding and
+// blitting ahead of the streamer, plus the rendering, rasterizing, and
+// writing which the stats record within it), and hand the streamer a
+// deadline that much ahead of the next frame's slot, so that the next frame
+// lands on time. frames which couldn't land before their slot ends are
+// dropped; the schedule is never moved, so we stay in sync with the audio.
+typedef struct presentclock {
+  uint64_t cost;      // predicted ns to present a frame (moving average)
+  uint64_t writeouts; // stats.writeouts as of the last sample
+  uint64_t outputns;  // stats render_ns + raster_ns + writeout_ns, ditto
+} presentclock;
+
+static void
+pclock_outputs(notcurses* nc, uint64_t* writeouts, uint64_t* outputns){
+  ncstats st;
+  stats_read(&nc->stats, &st, &nc->stats.s, sizeof(st));
+  *writeouts = st.writeouts;
+  *outputns = st.render_ns + st.raster_ns + st.writeout_ns;
+}
+
+static inline uint64_t
+pclock_now(void){
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return timespec_to_ns(&now);
+}
+
+// fold the presentation just made into our prediction. |prepns| was spent
+// decoding and blitting; the streamer began at |cbstart|. |slotbeg| is when
+// the frame ought have appeared, and |duration| how long it ought stay.
+static void
+pclock_sample(notcurses* nc, presentclock* pc, uint64_t prepns, uint64_t cbstart,
+              uint64_t slotbeg, uint64_t duration){
+  uint64_t writeouts, outputns;
+  pclock_outputs(nc, &writeouts, &outputns);
+  uint64_t outns = 0;
+  // the stats might have been reset out from under us
+  if(writeouts > pc->writeouts && outputns >= pc->outputns){
+    outns = (outputns - pc->outputns) / (writeouts - pc->writeouts);
+  }
+  pc->writeouts = writeouts;
+  pc->outputns = outputns;
+  const uint64_t sample = prepns + outns;
+  pc->cost = pc->cost ? (pc->cost * 7 + sample) / 8 : sample;
+  // the streamer renders before waiting, so the frame was written about here
+  const int64_t skew = (int64_t)(cbstart + outns) - (int64_t)slotbeg;
+  // a frame a whole slot (or more) late left its predecessor up in its place
+  const uint64_t held = duration && skew > 0 ? (uint64_t)skew / duration : 0;
+  stats_lock(&nc->stats);
+    nc->stats.s.stream_frames_held += held;
+    nc->stats.s.stream_av_skew_ns = skew;
+    nc->stats.s.stream_present_ns = pc->cost;
+  stats_unlock(&nc->stats);
+}
+
+// decode the next frame inline, dropping those which couldn't be written
+// (at the predicted cost) before their slots end, as does stream_next().
+static int
+ffmpeg_decode_paced(notcurses* nc, ncvisual* ncv, uint64_t nsbegin,
+                    float timescale, uint64_t cost, uint64_t* sum_duration){
+  uint64_t dropped = 0;
+  int r;
+  while((r = ffmpeg_decode(ncv)) == 0){
+    const uint64_t duration = ncv->details->frame->pkt_duration *
+                              ffmpeg_timebase(ncv) * NANOSECS_IN_SEC * timescale;
+    if(duration == 0 || pclock_now() + cost <= nsbegin + *sum_duration + duration){
+      break;
+    }
+    *sum_duration += duration;
+    ++dropped;
+  }
+  if(dropped){
+    stats_lock(&nc->stats);
+      nc->stats.s.stream_frames_dropped += dropped;
+    stats_unlock(&nc->stats);
+  }
+  return r;
+}
+
 // iterate over the decoded frames, calling streamer() with curry for each.
 // frames carry a presentation time relative to the beginning, so we get an
 // initial timestamp, and check each frame against the elapsed time to sync
@@ -492,26 +1258,36 @@ ffmpeg_stream(notcurses* nc, ncvisual* ncv, float timescale,
   ncplane* newn = NULL;
   struct ncvisual_options activevopts;
   memcpy(&activevopts, vopts, sizeof(*vopts));
+  // the first frame is already decoded; the pipeline starts decoding the
+  // second once we know the geometry with which the first is blitted.
+  bool pipeline = stream_pipelinable(ncv, vopts);
+  streamqueue* q = NULL;
+  presentclock pc = {0};
+  pclock_outputs(nc, &pc.writeouts, &pc.outputns);
+  uint64_t prepstart = nsbegin; // when we began readying the current frame
   int ncerr;
   do{
-    // codecctx seems to be off by a factor of 2 regularly. instead, go with
-    // the time_base from the avformatctx. except ts isn't properly reset for
-    // all media when we loop =[. we seem to be accurate enough now with the
-    // tbase/ppd. see https://github.com/dankamongmen/notcurses/issues/1352.
-    double tbase = av_q2d(ncv->details->fmtctx->streams[ncv->details->stream_index]->time_base);
-    if(isnan(tbase)){
-      tbase = 0;
-    }
-    if(activevopts.n){
-      ncplane_erase(activevopts.n); // new frame could be partially transparent
-    }
+    const double tbase = ffmpeg_timebase(ncv);
     // decay the blitter explicitly, so that the callback knows the blitter it
     // was actually rendered with. basically just need rgba_blitter(), but
     // that's not exported.
     ncvgeom geom;
     ncvisual_geom(nc, ncv, &activevopts, &geom);
     activevopts.blitter = geom.blitter;
+    if(q){
+      stream_retarget(q, geom.rpixy, geom.rpixx);
+    }else if(pipeline){
+      pipeline = false;
+      q = stream_start(nc, ncv, geom.rpixy, geom.rpixx,
+                       ffmpeg_sws_flags(geom.blitter, activevopts.flags));
+    }
+    // new frame could be partially transparent. a sprixel copes with that
+    // itself when reblitted, and might be able to build upon its last frame.
+    if(activevopts.n && !(geom.blitter == NCBLIT_PIXEL && activevopts.n->sprite)){
+      ncplane_erase(activevopts.n);
+    }
     if((newn = ncvisual_blit(nc, ncv, &activevopts)) == NULL){
+      stream_stop(q, ncv);
       if(activevopts.n != vopts->n){
         ncplane_destroy(activevopts.n);
       }
@@ -522,11 +1298,14 @@ ffmpeg_stream(notcurses* nc, ncvisual* ncv, float timescale,
     }
     ++frame;
     uint64_t duration = ncv->details->frame->pkt_duration * tbase * NANOSECS_IN_SEC;
-    double schedns = nsbegin;
+    const uint64_t slotbeg = nsbegin + sum_duration;
     sum_duration += (duration * timescale);
-    schedns += sum_duration;
+    // return early enough that the next frame lands as this one's slot ends
+    uint64_t schedns = nsbegin + sum_duration;
+    schedns = schedns > pc.cost ? schedns - pc.cost : 0;
     struct timespec abstime;
     ns_to_timespec(schedns, &abstime);
+    const uint64_t cbstart = pclock_now();
     int r;
     if(streamer){
       r = streamer(ncv, &activevopts, &abstime, curry);
@@ -534,12 +1313,19 @@ ffmpeg_stream(notcurses* nc, ncvisual* ncv, float timescale,
       r = ncvisual_simple_streamer(ncv, &activevopts, &abstime, curry);
     }
     if(r){
+      stream_stop(q, ncv);
       if(activevopts.n != vopts->n){
         ncplane_destroy(activevopts.n);
       }
       return r;
     }
-  }while((ncerr = ffmpeg_decode(ncv)) == 0);
+    pclock_sample(nc, &pc, cbstart - prepstart, cbstart, slotbeg,
+                  duration * timescale);
+    prepstart = pclock_now();
+    ncerr = q ? stream_next(nc, q, ncv, nsbegin, timescale, pc.cost, &sum_duration)
+              : ffmpeg_decode_paced(nc, ncv, nsbegin, timescale, pc.cost, &sum_duration);
+  }while(ncerr == 0);
+  stream_stop(q, ncv);
   if(activevopts.n != vopts->n){
     ncplane_destroy(activevopts.n);
   }
@@ -549,17 +1335,512 @@ ffmpeg_stream(notcurses* nc, ncvisual* ncv, float timescale,
   return ncerr;
 }
 
+static void
+loopcache_free(ncvisual_details* deets){
+  for(unsigned i = 0 ; i < deets->loopcount ; ++i){
+    av_free(deets->loopframes[i].rgba);
+    av_free(deets->loopframes[i].scaled);
+  }
+  free(deets->loopframes);
+  deets->loopframes = NULL;
+  deets->loopcount = 0;
+  deets->loopsize = 0;
+  deets->loopbytes = 0;
+}
+
+// keep the frame just decoded. returns -1 if it's not RGBA, or doesn't fit.
+static int
+loopcache_record(ncvisual* ncv){
+  ncvisual_details* deets = ncv->details;
+  if(deets->frame->format != AV_PIX_FMT_RGBA){
+    return -1;
+  }
+  const size_t bytes = (size_t)ncv->rowstride * ncv->pixy;
+  if(deets->loopbytes + bytes > deets->loopmax){
+    return -1;
+  }
+  if(deets->loopcount == deets->loopsize){
+    unsigned ns = deets->loopsize ? deets->loopsize * 2 : 16;
+    loopframe* tmp = realloc(deets->loopframes, sizeof(*tmp) * ns);
+    if(tmp == NULL){
+      return -1;
+    }
+    deets->loopframes = tmp;
+    deets->loopsize = ns;
+  }
+  uint8_t* rgba = av_malloc(bytes);
+  if(rgba == NULL){
+    return -1;
+  }
+  memcpy(rgba, ncv->data, bytes);
+  loopframe* lf = &deets->loopframes[deets->loopcount++];
+  memset(lf, 0, sizeof(*lf));
+  lf->rgba = rgba;
+  lf->stride = ncv->rowstride;
+  lf->rows = ncv->pixy;
+  lf->cols = ncv->pixx;
+  deets->loopbytes += bytes;
+  return 0;
+}
+
+static void
+loopcache_record_or_fail(ncvisual* ncv){
+  if(loopcache_record(ncv)){
+    loopcache_free(ncv->details);
+    ncv->details->loopstate = LOOPCACHE_FAILED;
+  }
+}
+
+// point the ncvisual (and |replay|, which must be |frame|) at a cached RGBA
+// frame. the cache retains ownership.
+static void
+replay_install(ncvisual* ncv, uint8_t* rgba, int stride, int rows, int cols){
+  AVFrame* f = ncv->details->replay;
+  f->format = AV_PIX_FMT_RGBA;
+  f->width = cols;
+  f->height = rows;
+  f->linesize[0] = stride;
+  f->data[0] = rgba;
+  ncv->rowstride = stride;
+  ncv->pixx = cols;
+  ncv->pixy = rows;
+  ncvisual_set_data(ncv, rgba, false);
+}
+
+// stop presenting a cached frame, copying it into our own frame (restored
+// from |stash|), so that the cache can be released.
+static int
+replay_adopt(ncvisual* ncv, const uint8_t* rgba, int stride, int rows, int cols){
+  ncvisual_details* deets = ncv->details;
+  AVFrame* f = deets->stash;
+  av_frame_unref(f);
+  if(av_image_alloc(f->data, f->linesize, cols, rows,
+                    AV_PIX_FMT_RGBA, IMGALLOCALIGN) < 0){
+    return -1;
+  }
+  av_image_copy_plane(f->data[0], f->linesize[0], rgba, stride, cols * 4, rows);
+  f->format = AV_PIX_FMT_RGBA;
+  f->width = cols;
+  f->height = rows;
+  deets->frame = f;
+  deets->stash = NULL;
+  ncv->rowstride = f->linesize[0];
+  ncv->pixx = cols;
+  ncv->pixy = rows;
+  ncvisual_set_data(ncv, f->data[0], true);
+  return 0;
+}
+
+// point the ncvisual (and |replay|) at cached frame |loopidx|.
+static void
+loopcache_install(ncvisual* ncv){
+  loopframe* lf = &ncv->details->loopframes[ncv->details->loopidx];
+  replay_install(ncv, lf->rgba, lf->stride, lf->rows, lf->cols);
+}
+
+// drop the cache. if we were replaying, the current frame is copied into
+// our own frame, and decoding resumes (from the first frame) at the end of
+// the pass, the decoder having been left drained.
+static int
+loopcache_drop(ncvisual* ncv){
+  ncvisual_details* deets = ncv->details;
+  if(deets->stash){
+    const loopframe* lf = &deets->loopframes[deets->loopidx];
+    if(replay_adopt(ncv, lf->rgba, lf->stride, lf->rows, lf->cols)){
+      return -1;
+    }
+  }
+  loopcache_free(deets);
+  deets->loopstate = LOOPCACHE_OFF;
+  return 0;
+}
+
+static int
+ffmpeg_loopcache(ncvisual* ncv, size_t maxbytes){
+  ncvisual_details* deets = ncv->details;
+  if(deets->fmtctx == NULL){
+    logerror("not a file-backed visual");
+    return -1;
+  }
+  if(maxbytes < deets->loopbytes || maxbytes == 0){
+    if(loopcache_drop(ncv)){
+      return -1;
+    }
+  }
+  deets->loopmax = maxbytes;
+  if(maxbytes && (deets->loopstate == LOOPCACHE_OFF || deets->loopstate == LOOPCACHE_FAILED)){
+    deets->loopstate = LOOPCACHE_ARMED;
+    if(deets->frameno == 1){ // we're on the first frame; start with it
+      deets->loopstate = LOOPCACHE_RECORDING;
+      loopcache_record_or_fail(ncv);
+    }
+  }
+  return 0;
+}
+
+static void
+scrub_free(ncvisual_details* deets){
+  for(unsigned i = 0 ; i < deets->scrubcount ; ++i){
+    av_free(deets->scrub[i].rgba);
+  }
+  free(deets->scrub);
+  deets->scrub = NULL;
+  deets->scrubcount = 0;
+  deets->scrubidx = 0;
+  deets->scrubbytes = 0;
+}
+
+// present cached frame |scrubidx|.
+static int
+scrub_install(ncvisual* ncv){
+  ncvisual_details* deets = ncv->details;
+  if(!deets->scrubshown){
+    if(deets->replay == NULL && (deets->replay = av_frame_alloc()) == NULL){
+      return -1;
+    }
+    deets->stash = deets->frame;
+    deets->frame = deets->replay;
+    deets->scrubshown = true;
+  }
+  scrubframe* sf = &deets->scrub[deets->scrubidx];
+  replay_install(ncv, sf->rgba, sf->stride, sf->rows, sf->cols);
+  deets->curpts = sf->pts;
+  deets->curduration = sf->duration;
+  return 0;
+}
+
+// stop presenting a cached frame, so that the cache can be changed.
+static int
+scrub_leave(ncvisual* ncv){
+  ncvisual_details* deets = ncv->details;
+  if(deets->scrubshown){
+    const scrubframe* sf = &deets->scrub[deets->scrubidx];
+    if(replay_adopt(ncv, sf->rgba, sf->stride, sf->rows, sf->cols)){
+      return -1;
+    }
+    deets->scrubshown = false;
+  }
+  return 0;
+}
+
+// while a cached frame is presented, ffmpeg_decode() presents the next one.
+// once we're at the end of the cache, we must decode; returns 1 if so.
+static int
+scrub_next(ncvisual* ncv){
+  ncvisual_details* deets = ncv->details;
+  if(deets->scrubidx + 1 < deets->scrubcount){
+    ++deets->scrubidx;
+    if(scrub_install(ncv)){
+      return -1;
+    }
+    ++deets->frameno;
+    return 0;
+  }
+  return scrub_leave(ncv) ? -1 : 1;
+}
+
+// keep the frame just decoded, evicting the oldest frames as necessary. if
+// it can't be kept, the cache is dropped.
+static void
+scrub_record(ncvisual* ncv){
+  ncvisual_details* deets = ncv->details;
+  const size_t bytes = (size_t)ncv->rowstride * ncv->pixy;
+  if(deets->frame->format != AV_PIX_FMT_RGBA || bytes > SCRUB_MAXBYTES){
+    scrub_free(deets);
+    return;
+  }
+  if(deets->scrub == NULL){
+    if((deets->scrub = malloc(sizeof(*deets->scrub) * SCRUB_MAXFRAMES)) == NULL){
+      return;
+    }
+  }
+  unsigned evict = 0;
+  size_t evicted = 0;
+  while(deets->scrubcount - evict == SCRUB_MAXFRAMES ||
+        deets->scrubbytes - evicted + bytes > SCRUB_MAXBYTES){
+    const scrubframe* sf = &deets->scrub[evict++];
+    evicted += (size_t)sf->stride * sf->rows;
+    av_free(sf->rgba);
+  }
+  if(evict){
+    memmove(deets->scrub, deets->scrub + evict,
+            sizeof(*deets->scrub) * (deets->scrubcount - evict));
+    deets->scrubcount -= evict;
+    deets->scrubbytes -= evicted;
+  }
+  uint8_t* rgba = av_malloc(bytes);
+  if(rgba == NULL){
+    scrub_free(deets);
+    return;
+  }
+  memcpy(rgba, ncv->data, bytes);
+  scrubframe* sf = &deets->scrub[deets->scrubcount];
+  sf->rgba = rgba;
+  sf->stride = ncv->rowstride;
+  sf->rows = ncv->pixy;
+  sf->cols = ncv->pixx;
+  sf->pts = deets->curpts;
+  sf->duration = deets->curduration;
+  deets->scrubidx = deets->scrubcount++;
+  deets->scrubbytes += bytes;
+}
+
+static int
+keypts_cmp(const void* va, const void* vb){
+  const int64_t a = *(const int64_t*)va;
+  const int64_t b = *(const int64_t*)vb;
+  return a < b ? -1 : a > b;
+}
+
+static int
+keypts_add(ncvisual_details* deets, unsigned* size, int64_t pts){
+  if(deets->keycount == *size){
+    unsigned ns = *size ? *size * 2 : 64;
+    int64_t* tmp = realloc(deets->keypts, sizeof(*tmp) * ns);
+    if(tmp == NULL){
+      return -1;
+    }
+    deets->keypts = tmp;
+    *size = ns;
+  }
+  deets->keypts[deets->keycount++] = pts;
+  return 0;
+}
+
+// index the keyframes of the video stream. containers carrying an index
+// (MP4, Matroska, etc.) have already provided one to the demuxer; otherwise,
+// we read through the file's packets (without decoding them). the latter
+// leaves the demuxer at the end of the file.
+static int
+seek_index(ncvisual_details* deets){
+  if(deets->keypts){
+    return 0;
+  }
+  AVStream* st = deets->fmtctx->streams[deets->stream_index];
+  const int64_t start = st->start_time == AV_NOPTS_VALUE ? 0 : st->start_time;
+  unsigned size = 0;
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100)
+  const int entries = avformat_index_get_entries_count(st);
+  for(int i = 0 ; i < entries ; ++i){
+    const AVIndexEntry* e = avformat_index_get_entry(st, i);
+    if(e && (e->flags & AVINDEX_KEYFRAME)){
+      if(keypts_add(deets, &size, e->timestamp)){
+        goto err;
+      }
+    }
+  }
+#endif
+  if(deets->keycount == 0){
+    AVPacket* pkt = av_packet_alloc();
+    if(pkt == NULL){
+      goto err;
+    }
+    if(av_seek_frame(deets->fmtctx, deets->stream_index, start, AVSEEK_FLAG_BACKWARD) >= 0){
+      while(av_read_frame(deets->fmtctx, pkt) >= 0){
+        if(pkt->stream_index == deets->stream_index && (pkt->flags & AV_PKT_FLAG_KEY)){
+          const int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+          if(ts != AV_NOPTS_VALUE && keypts_add(deets, &size, ts)){
+            av_packet_free(&pkt);
+            goto err;
+          }
+        }
+        av_packet_unref(pkt);
+      }
+    }
+    av_packet_free(&pkt);
+  }
+  // failing all else, we can always start over
+  if(deets->keycount == 0 && keypts_add(deets, &size, start)){
+    goto err;
+  }
+  qsort(deets->keypts, deets->keycount, sizeof(*deets->keypts), keypts_cmp);
+  loginfo("indexed %u keyframe%s", deets->keycount, deets->keycount == 1 ? "" : "s");
+  return 0;
+
+err:
+  free(deets->keypts);
+  deets->keypts = NULL;
+  deets->keycount = 0;
+  return -1;
+}
+
+// the last keyframe at or before |pts|, or the first keyframe.
+static int64_t
+seek_keyframe(const ncvisual_details* deets, int64_t pts){
+  unsigned lo = 0, hi = deets->keycount;
+  while(hi - lo > 1){
+    const unsigned mid = lo + (hi - lo) / 2;
+    if(deets->keypts[mid] <= pts){
+      lo = mid;
+    }else{
+      hi = mid;
+    }
+  }
+  return deets->keypts[lo];
+}
+
+// is the frame being presented the one to show at |pts|?
+static bool
+seek_reached(const ncvisual_details* deets, int64_t pts){
+  if(deets->curpts == AV_NOPTS_VALUE || deets->curpts >= pts){
+    return true;
+  }
+  return deets->curduration > 0 && deets->curpts + deets->curduration > pts;
+}
+
+// cached frames run up through the decoder's position, unless the decoder
+// has since moved without us (i.e. a pipelined ffmpeg_stream()).
+static bool
+scrub_valid(const ncvisual_details* deets){
+  return deets->scrubcount && deets->scrub[deets->scrubcount - 1].pts == deets->lastpts;
+}
+
+// seeking to a frame in the cache needs no decoding. a frame ahead of the
+// cache (or the decoder's position) is decoded onwards to, so long as no
+// keyframe intervenes; otherwise, we seek to the keyframe, and decode from
+// there, keeping the frames along the way.
+static int
+ffmpeg_seek(ncvisual* ncv, uint64_t ns, uint64_t flags){
+  ncvisual_details* deets = ncv->details;
+  if(deets->fmtctx == NULL){
+    logerror("not a file-backed visual");
+    return -1;
+  }
+  if(flags >= (NCVISUAL_SEEK_KEYFRAME << 1u)){
+    logwarn("provided unsupported flags 0x%016" PRIx64, flags);
+  }
+  const AVStream* st = deets->fmtctx->streams[deets->stream_index];
+  int64_t target = av_rescale_q(ns, (AVRational){1, NANOSECS_IN_SEC}, st->time_base);
+  if(st->start_time != AV_NOPTS_VALUE){
+    target += st->start_time;
+  }
+  // a seek breaks any pass being kept by the loop cache
+  if(deets->loopstate != LOOPCACHE_OFF && deets->loopstate != LOOPCACHE_FAILED){
+    if(loopcache_drop(ncv)){
+      return -1;
+    }
+    if(deets->loopmax){
+      deets->loopstate = LOOPCACHE_ARMED;
+    }
+  }
+  const bool indexed = deets->keypts != NULL;
+  if(seek_index(deets)){
+    logerror("couldn't index keyframes");
+    return -1;
+  }
+  const int64_t key = seek_keyframe(deets, target);
+  if(flags & NCVISUAL_SEEK_KEYFRAME){
+    target = key;
+  }
+  bool onwards = false;
+  if(indexed && scrub_valid(deets)){
+    const scrubframe* last = &deets->scrub[deets->scrubcount - 1];
+    if(deets->scrub[0].pts <= target && (target < last->pts + last->duration || last->pts >= target)){
+      unsigned idx = deets->scrubcount - 1;
+      while(deets->scrub[idx].pts > target){
+        --idx;
+      }
+      deets->scrubidx = idx;
+      return scrub_install(ncv);
+    }
+  }
+  if(indexed && !deets->draining && deets->lastpts != AV_NOPTS_VALUE){
+    onwards = key <= deets->lastpts && deets->lastpts < target;
+  }
+  if(!onwards){
+    if(scrub_leave(ncv)){
+      return -1;
+    }
+    scrub_free(deets);
+    if(av_seek_frame(deets->fmtctx, deets->stream_index, key, AVSEEK_FLAG_BACKWARD) < 0){
+      logerror("couldn't seek to %" PRId64, key);
+      return -1;
+    }
+    avcodec_flush_buffers(deets->codecctx);
+    av_packet_unref(deets->packet);
+    deets->packet_outstanding = false;
+    deets->draining = false;
+    deets->lastpts = AV_NOPTS_VALUE;
+  }else if(!scrub_valid(deets)){
+    if(scrub_leave(ncv)){
+      return -1;
+    }
+    scrub_free(deets);
+  }
+  int r;
+  while((r = ffmpeg_decode(ncv)) == 0){
+    if(seek_reached(deets, target)){
+      break;
+    }
+  }
+  // at the end of the stream, the last frame remains
+  return r < 0 ? -1 : 0;
+}
+
+static int
+ffmpeg_position(const ncvisual* ncv, uint64_t* ns){
+  const ncvisual_details* deets = ncv->details;
+  if(deets->fmtctx == NULL || deets->curpts == AV_NOPTS_VALUE){
+    return -1;
+  }
+  const AVStream* st = deets->fmtctx->streams[deets->stream_index];
+  int64_t pts = deets->curpts;
+  if(st->start_time != AV_NOPTS_VALUE){
+    pts -= st->start_time;
+  }
+  *ns = pts > 0 ? av_rescale_q(pts, st->time_base, (AVRational){1, NANOSECS_IN_SEC}) : 0;
+  return 0;
+}
+
+// with a loop cache, the first full pass is kept, and thereafter replayed
+// from memory: the decoder (and RGBA conversion) sit idle, and each frame
+// keeps its scaling for the last geometry at which it was blitted.
 static int
 ffmpeg_decode_loop(ncvisual* ncv){
+  ncvisual_details* deets = ncv->details;
+  if(deets->loopstate == LOOPCACHE_REPLAYING){
+    int r = 0;
+    if(++deets->loopidx == deets->loopcount){
+      deets->loopidx = 0;
+      r = 1;
+    }
+    loopcache_install(ncv);
+    return r;
+  }
   int r = ffmpeg_decode(ncv);
-  if(r == 1){
+  if(r == 0){
+    if(deets->loopstate == LOOPCACHE_RECORDING){
+      loopcache_record_or_fail(ncv);
+    }
+  }else if(r == 1){
+    if(deets->loopstate == LOOPCACHE_RECORDING && deets->loopcount){
+      if(deets->replay || (deets->replay = av_frame_alloc())){
+        deets->stash = deets->frame;
+        deets->frame = deets->replay;
+        deets->loopstate = LOOPCACHE_REPLAYING;
+        deets->loopidx = 0;
+        loopcache_install(ncv);
+        return r;
+      }
+      loopcache_free(deets);
+      deets->loopstate = LOOPCACHE_FAILED;
+    }
     if(av_seek_frame(ncv->details->fmtctx, ncv->details->stream_index, 0, AVSEEK_FLAG_FRAME) < 0){
       // FIXME log error
       return -1;
     }
+    // the decoder was drained at the end of the stream, and must be reset
+    avcodec_flush_buffers(ncv->details->codecctx);
+    ncv->details->draining = false;
+    deets->frameno = 0;
+    scrub_free(deets);
     if(ffmpeg_decode(ncv) < 0){
       return -1;
     }
+    if(deets->loopstate == LOOPCACHE_ARMED){
+      deets->loopstate = LOOPCACHE_RECORDING;
+      loopcache_record_or_fail(ncv);
+    }
   }
   return r;
 }
@@ -567,11 +1848,14 @@ ffmpeg_decode_loop(ncvisual* ncv){
 // do a resize *without* updating the ncvisual structure. if the target
 // parameters are already matched, the existing data will be returned.
 // otherwise, a scaled copy will be returned. they can be differentiated by
-// comparing the result against ncv->data.
+// comparing the result against ncv->data. if |keep| is set, the copy is
+// made into (and remains owned by) the details' persistent buffer, which is
+// reused so long as the geometry holds; the caller mustn't free it.
 static uint32_t*
 ffmpeg_resize_internal(const ncvisual* ncv, int rows, int* stride, int cols,
-                       const blitterargs* bargs){
-  const AVFrame* inframe = ncv->details->frame;
+                       const blitterargs* bargs, int swsflags, bool keep){
+  ncvisual_details* deets = ncv->details;
+  const AVFrame* inframe = deets->frame;
 //print_frame_summary(NULL, inframe);
   const int targformat = AV_PIX_FMT_RGBA;
 //fprintf(stderr, "got format: %d (%d/%d) want format: %d (%d/%d)\n", inframe->format, inframe->height, inframe->width, targformat, rows, cols);
@@ -583,34 +1867,80 @@ ffmpeg_resize_internal(const ncvisual* ncv, int rows, int* stride, int cols,
   }
   const int srclenx = bargs->lenx ? bargs->lenx : inframe->width;
   const int srcleny = bargs->leny ? bargs->leny : inframe->height;
-//fprintf(stderr, "src %d/%d -> targ %d/%d ctx: %p\n", srcleny, srclenx, rows, cols, ncv->details->swsctx);
-  ncv->details->swsctx = sws_getCachedContext(ncv->details->swsctx,
-                                              srclenx, srcleny,
-                                              inframe->format,
-                                              cols, rows, targformat,
-                                              SWS_LANCZOS, NULL, NULL, NULL);
-  if(ncv->details->swsctx == NULL){
+  // a replayed frame keeps its own scaling, if it fits in the loop cache
+  loopframe* lf = NULL;
+  if(keep && deets->loopstate == LOOPCACHE_REPLAYING){
+    lf = &deets->loopframes[deets->loopidx];
+    if(lf->scaledrows == rows && lf->scaledcols == cols && lf->scaledflags == swsflags &&
+       lf->scaledleny == srcleny && lf->scaledlenx == srclenx){
+      *stride = lf->scaledstride;
+      return (uint32_t*)lf->scaled;
+    }
+    const size_t bytes = av_image_get_buffer_size(targformat, cols, rows, IMGALLOCALIGN);
+    if(deets->loopbytes - lf->scaledbytes + bytes > deets->loopmax){
+      lf = NULL;
+    }
+  }
+//fprintf(stderr, "src %d/%d -> targ %d/%d ctx: %p\n", srcleny, srclenx, rows, cols, deets->swsctx);
+  deets->swsctx = sws_getCachedContext(deets->swsctx,
+                                       srclenx, srcleny,
+                                       inframe->format,
+                                       cols, rows, targformat,
+                                       swsflags, NULL, NULL, NULL);
+  if(deets->swsctx == NULL){
 //fprintf(stderr, "Error retrieving details->swsctx\n");
     return NULL;
   }
   // necessitated by ffmpeg AVPicture API
-  uint8_t* dptrs[4];
-  int dlinesizes[4];
-  int size = av_image_alloc(dptrs, dlinesizes, cols, rows, targformat, IMGALLOCALIGN);
-  if(size < 0){
+  uint8_t* dptrs[4] = { NULL, };
+  int dlinesizes[4] = { 0, };
+  if(lf){
+    int size = av_image_alloc(dptrs, dlinesizes, cols, rows, targformat, IMGALLOCALIGN);
+    if(size < 0){
+      return NULL;
+    }
+    deets->loopbytes += size - lf->scaledbytes;
+    av_free(lf->scaled);
+    lf->scaled = dptrs[0];
+    lf->scaledbytes = size;
+    lf->scaledstride = dlinesizes[0];
+    lf->scaledrows = 0;
+  }else if(keep && deets->scaled && deets->scaledrows == rows && deets->scaledcols == cols){
+    dptrs[0] = deets->scaled;
+    dlinesizes[0] = deets->scaledstride;
+  }else{
+    int size = av_image_alloc(dptrs, dlinesizes, cols, rows, targformat, IMGALLOCALIGN);
+    if(size < 0){
 //fprintf(stderr, "Error allocating visual data (%d X %d)\n", sframe->height, sframe->width);
-    return NULL;
+      return NULL;
+    }
+    if(keep){
+      av_freep(&deets->scaled);
+      deets->scaled = dptrs[0];
+      deets->scaledstride = dlinesizes[0];
+      deets->scaledrows = rows;
+      deets->scaledcols = cols;
+    }
   }
-//fprintf(stderr, "INFRAME DAA: %p SDATA: %p FDATA: %p to %d/%d\n", inframe->data[0], sframe->data[0], ncv->details->frame->data[0], sframe->height, sframe->width);
+//fprintf(stderr, "INFRAME DAA: %p SDATA: %p FDATA: %p to %d/%d\n", inframe->data[0], sframe->data[0], deets->frame->data[0], sframe->height, sframe->width);
   const uint8_t* data[4] = { (uint8_t*)ncv->data, };
-  int height = sws_scale(ncv->details->swsctx, data,
+  int height = sws_scale(deets->swsctx, data,
                          inframe->linesize, 0, srcleny, dptrs, dlinesizes);
   if(height < 0){
 //fprintf(stderr, "Error applying scaling (%d X %d)\n", inframe->height, inframe->width);
-    av_freep(&dptrs[0]);
+    if(!keep){
+      av_freep(&dptrs[0]);
+    }
     return NULL;
   }
 //fprintf(stderr, "scaled %d/%d to %d/%d\n", ncv->pixy, ncv->pixx, rows, cols);
+  if(lf){
+    lf->scaledrows = rows;
+    lf->scaledcols = cols;
+    lf->scaledleny = srcleny;
+    lf->scaledlenx = srclenx;
+    lf->scaledflags = swsflags;
+  }
   *stride = dlinesizes[0]; // FIXME check for others?
   return (uint32_t*)dptrs[0];
 }
@@ -620,7 +1950,8 @@ static int
 ffmpeg_resize(ncvisual* n, unsigned rows, unsigned cols){
   struct blitterargs bargs = {0};
   int stride;
-  void* data = ffmpeg_resize_internal(n, rows, &stride, cols, &bargs);
+  void* data = ffmpeg_resize_internal(n, rows, &stride, cols, &bargs,
+                                      SWS_LANCZOS, false);
   if(data == n->data){ // no change, return
     return 0;
   }
@@ -646,19 +1977,16 @@ ffmpeg_blit(const ncvisual* ncv, unsigned rows, unsigned cols, ncplane* n,
             const struct blitset* bset, const blitterargs* bargs){
   void* data;
   int stride = 0;
-  data = ffmpeg_resize_internal(ncv, rows, &stride, cols, bargs);
+  data = ffmpeg_resize_internal(ncv, rows, &stride, cols, bargs,
+                                ffmpeg_sws_flags(bset->geom, bargs->flags), true);
   if(data == NULL){
     return -1;
   }
 //fprintf(stderr, "WHN NCV: bargslen: %d/%d targ: %d/%d\n", bargs->leny, bargs->lenx, rows, cols);
-  int ret = 0;
   if(rgba_blit_dispatch(n, bset, stride, data, rows, cols, bargs) < 0){
-    ret = -1;
-  }
-  if(data != ncv->data){
-    av_freep(&data); // &dptrs[0]
+    return -1;
   }
-  return ret;
+  return 0;
 }
 
 static void
@@ -712,7 +2040,17 @@ ffmpeg_details_destroy(ncvisual_details* deets){
   avcodec_close(deets->codecctx);
   avcodec_free_context(&deets->subtcodecctx);
   avcodec_free_context(&deets->codecctx);
+  if(deets->stash){ // |frame| is |replay|
+    deets->frame = deets->stash;
+  }
+  av_frame_free(&deets->replay);
+  loopcache_free(deets);
+  scrub_free(deets);
+  free(deets->keypts);
   av_frame_free(&deets->frame);
+  av_frame_free(&deets->hwframe);
+  av_freep(&deets->scaled);
+  av_buffer_unref(&deets->hwdevctx);
   sws_freeContext(deets->rgbactx);
   sws_freeContext(deets->swsctx);
   av_packet_free(&deets->packet);
@@ -725,9 +2063,8 @@ static void
 ffmpeg_destroy(ncvisual* ncv){
   if(ncv){
     ffmpeg_details_destroy(ncv->details);
-    if(ncv->owndata){
-      free(ncv->data);
-    }
+    ncvisual_drop_data(ncv);
+    ncvisual_drop_spare(ncv);
     free(ncv);
   }
 }
@@ -741,8 +2078,12 @@ ncvisual_implementation local_visual_implementation = {
   .visual_details_seed = ffmpeg_details_seed,
   .visual_decode = ffmpeg_decode,
   .visual_decode_loop = ffmpeg_decode_loop,
+  .visual_loopcache = ffmpeg_loopcache,
+  .visual_seek = ffmpeg_seek,
+  .visual_position = ffmpeg_position,
   .visual_stream = ffmpeg_stream,
   .visual_subtitle = ffmpeg_subtitle,
+  .visual_subtitle_update = ffmpeg_subtitle_update,
   .visual_resize = ffmpeg_resize,
   .visual_destroy = ffmpeg_destroy,
   .rowalign = 64, // ffmpeg wants multiples of IMGALIGN (64)
@@ -0,0 +1,296 @@
+#include "builddef.h"
+#ifdef USE_NATIVE
+#include <stdio.h>
+#include <setjmp.h>
+#include <png.h>
+#include <jpeglib.h>
+#include "lib/visual-details.h"
+#include "lib/internal.h"
+
+// the native engine decodes PNG (via libpng) and JPEG (via libjpeg, ideally
+// libjpeg-turbo) stills itself, for programs which want images without the
+// startup cost and footprint of a full multimedia stack. it has no video.
+// scaling is done here: shrinking averages each target pixel's footprint,
+// weighting colors by alpha, while enlarging duplicates pixels.
+
+static ncvisual*
+native_create(void){
+  ncvisual* ncv = malloc(sizeof(*ncv));
+  if(ncv){
+    memset(ncv, 0, sizeof(*ncv));
+  }
+  return ncv;
+}
+
+static void
+native_destroy(ncvisual* ncv){
+  if(ncv){
+    ncvisual_drop_data(ncv);
+    ncvisual_drop_spare(ncv);
+    free(ncv);
+  }
+}
+
+static int
+native_png(ncvisual* ncv, FILE* fp){
+  png_image img;
+  memset(&img, 0, sizeof(img));
+  img.version = PNG_IMAGE_VERSION;
+  if(!png_image_begin_read_from_stdio(&img, fp)){
+    logerror("couldn't read png header (%s)", img.message);
+    return -1;
+  }
+  img.format = PNG_FORMAT_RGBA;
+  if(img.width > INT_MAX / 4 || img.height > INT_MAX / (img.width * 4)){
+    logerror("png too large (%ux%u)", img.height, img.width);
+    png_image_free(&img);
+    return -1;
+  }
+  uint32_t* data = malloc(PNG_IMAGE_SIZE(img));
+  if(data == NULL){
+    png_image_free(&img);
+    return -1;
+  }
+  if(!png_image_finish_read(&img, NULL, data, 0, NULL)){
+    logerror("couldn't decode png (%s)", img.message);
+    png_image_free(&img);
+    free(data);
+    return -1;
+  }
+  ncv->pixy = img.height;
+  ncv->pixx = img.width;
+  ncv->rowstride = img.width * 4;
+  ncvisual_set_data(ncv, data, true);
+  return 0;
+}
+
+typedef struct jpegerr {
+  struct jpeg_error_mgr pub;
+  jmp_buf env;
+} jpegerr;
+
+static void
+native_jpeg_error(j_common_ptr cinfo){
+  char buf[JMSG_LENGTH_MAX];
+  cinfo->err->format_message(cinfo, buf);
+  logerror("couldn't decode jpeg (%s)", buf);
+  longjmp(((jpegerr*)cinfo->err)->env, 1);
+}
+
+// libjpeg would otherwise write warnings to stderr
+static void
+native_jpeg_message(j_common_ptr cinfo){
+  char buf[JMSG_LENGTH_MAX];
+  cinfo->err->format_message(cinfo, buf);
+  logwarn("%s", buf);
+}
+
+// the largest power of two by which we can divide |dim| (up to 8, the most
+// the DCT can do for us), staying at or above |mindim|.
+static unsigned
+native_jpeg_denom(unsigned dim, unsigned mindim){
+  unsigned denom = 1;
+  while(denom < 8 && (dim + denom * 2 - 1) / (denom * 2) >= mindim){
+    denom *= 2;
+  }
+  return denom;
+}
+
+static int
+native_jpeg(ncvisual* ncv, FILE* fp, unsigned minpixy, unsigned minpixx){
+  struct jpeg_decompress_struct cinfo;
+  jpegerr jerr;
+  unsigned char* volatile data = NULL;
+  cinfo.err = jpeg_std_error(&jerr.pub);
+  jerr.pub.error_exit = native_jpeg_error;
+  jerr.pub.output_message = native_jpeg_message;
+  if(setjmp(jerr.env)){
+    jpeg_destroy_decompress(&cinfo);
+    free(data);
+    return -1;
+  }
+  jpeg_create_decompress(&cinfo);
+  jpeg_stdio_src(&cinfo, fp);
+  jpeg_read_header(&cinfo, TRUE);
+  // reduce in the DCT domain when that leaves enough pixels
+  unsigned denom = native_jpeg_denom(cinfo.image_height, minpixy);
+  unsigned xdenom = native_jpeg_denom(cinfo.image_width, minpixx);
+  if(xdenom < denom){
+    denom = xdenom;
+  }
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = denom;
+#ifdef JCS_EXTENSIONS
+  cinfo.out_color_space = JCS_EXT_RGBA;
+#else
+  cinfo.out_color_space = JCS_RGB;
+#endif
+  jpeg_start_decompress(&cinfo);
+  const size_t rowstride = cinfo.output_width * 4;
+  if((data = malloc(rowstride * cinfo.output_height)) == NULL){
+    jpeg_destroy_decompress(&cinfo);
+    return -1;
+  }
+  while(cinfo.output_scanline < cinfo.output_height){
+    JSAMPROW row = data + rowstride * cinfo.output_scanline;
+    jpeg_read_scanlines(&cinfo, &row, 1);
+#ifndef JCS_EXTENSIONS
+    // expand RGB to RGBA, back to front so as not to overrun ourselves
+    for(unsigned x = cinfo.output_width ; x-- ; ){
+      row[x * 4 + 3] = 0xff;
+      row[x * 4 + 2] = row[x * 3 + 2];
+      row[x * 4 + 1] = row[x * 3 + 1];
+      row[x * 4] = row[x * 3];
+    }
+#endif
+  }
+  loginfo("decoded %ux%u jpeg at 1/%u", cinfo.image_height, cinfo.image_width, denom);
+  ncv->pixy = cinfo.output_height;
+  ncv->pixx = cinfo.output_width;
+  ncv->rowstride = rowstride;
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  ncvisual_set_data(ncv, data, true);
+  return 0;
+}
+
+static ncvisual*
+native_from_file(const char* filename, unsigned minpixy, unsigned minpixx){
+  FILE* fp = fopen(filename, "rb");
+  if(fp == NULL){
+    logerror("couldn't open %s (%s)", filename, strerror(errno));
+    return NULL;
+  }
+  unsigned char magic[8];
+  const size_t got = fread(magic, 1, sizeof(magic), fp);
+  rewind(fp);
+  ncvisual* ncv = native_create();
+  if(ncv == NULL){
+    fclose(fp);
+    return NULL;
+  }
+  int r;
+  if(got == sizeof(magic) && png_sig_cmp(magic, 0, sizeof(magic)) == 0){
+    r = native_png(ncv, fp);
+  }else if(got >= 3 && magic[0] == 0xff && magic[1] == 0xd8 && magic[2] == 0xff){
+    r = native_jpeg(ncv, fp, minpixy, minpixx);
+  }else{
+    logerror("%s is neither png nor jpeg", filename);
+    r = -1;
+  }
+  fclose(fp);
+  if(r){
+    native_destroy(ncv);
+    return NULL;
+  }
+  return ncv;
+}
+
+// shrinking averages the source footprint of each target pixel
+static uint32_t*
+native_scale(const ncvisual* ncv, unsigned rows, unsigned cols, size_t dstride,
+             struct render_engine* re){
+  const bool area = rows <= ncv->pixy && cols <= ncv->pixx;
+  return resize_bitmap_rows(ncv->data, ncv->pixy, ncv->pixx, ncv->rowstride,
+                            rows, cols, dstride, 0, rows, area, re);
+}
+
+static int
+native_blit(const ncvisual* ncv, unsigned rows, unsigned cols, ncplane* n,
+            const struct blitset* bset, const blitterargs* bargs){
+  if(rows == ncv->pixy && cols == ncv->pixx){
+    return rgba_blit_dispatch(n, bset, ncv->rowstride, ncv->data, rows, cols, bargs) < 0 ? -1 : 0;
+  }
+  const size_t stride = cols * 4;
+  uint32_t* data = native_scale(ncv, rows, cols, stride, ncplane_render_engine(n));
+  if(data == NULL){
+    return -1;
+  }
+  int ret = rgba_blit_dispatch(n, bset, stride, data, rows, cols, bargs) < 0 ? -1 : 0;
+  free(data);
+  return ret;
+}
+
+static int
+native_resize(ncvisual* ncv, unsigned rows, unsigned cols){
+  if(rows == ncv->pixy && cols == ncv->pixx){
+    return 0;
+  }
+  const size_t stride = cols * 4;
+  uint32_t* data = native_scale(ncv, rows, cols, stride, NULL);
+  if(data == NULL){
+    return -1;
+  }
+  ncvisual_set_data(ncv, data, true);
+  ncv->rowstride = stride;
+  ncv->pixy = rows;
+  ncv->pixx = cols;
+  return 0;
+}
+
+// stills have but the one frame, decoded when the file was opened
+static int
+native_decode(ncvisual* ncv){
+  (void)ncv;
+  return 1;
+}
+
+static int
+native_stream(notcurses* nc, ncvisual* ncv, float timescale,
+              ncstreamcb streamer, const struct ncvisual_options* vopts,
+              void* curry){
+  (void)timescale;
+  struct ncvisual_options activevopts;
+  memcpy(&activevopts, vopts, sizeof(*vopts));
+  // decay the blitter explicitly, so that the callback knows the blitter it
+  // was actually rendered with
+  ncvgeom geom;
+  if(ncvisual_geom(nc, ncv, &activevopts, &geom)){
+    return -1;
+  }
+  activevopts.blitter = geom.blitter;
+  if((activevopts.n = ncvisual_blit(nc, ncv, &activevopts)) == NULL){
+    return -1;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  int r;
+  if(streamer){
+    r = streamer(ncv, &activevopts, &now, curry);
+  }else{
+    r = ncvisual_simple_streamer(ncv, &activevopts, &now, curry);
+  }
+  if(activevopts.n != vopts->n){
+    ncplane_destroy(activevopts.n);
+  }
+  return r;
+}
+
+static void
+native_printbanner(fbuf* f){
+  fbuf_printf(f, "libpng %s, ", png_get_libpng_ver(NULL));
+#ifdef LIBJPEG_TURBO_VERSION_NUMBER
+  fbuf_printf(f, "libjpeg-turbo %d.%d.%d (images only)" NL,
+              LIBJPEG_TURBO_VERSION_NUMBER / 1000000,
+              LIBJPEG_TURBO_VERSION_NUMBER / 1000 % 1000,
+              LIBJPEG_TURBO_VERSION_NUMBER % 1000);
+#else
+  fbuf_printf(f, "libjpeg %d (images only)" NL, JPEG_LIB_VERSION);
+#endif
+}
+
+ncvisual_implementation local_visual_implementation = {
+  .visual_printbanner = native_printbanner,
+  .visual_blit = native_blit,
+  .visual_create = native_create,
+  .visual_from_file = native_from_file,
+  .visual_decode = native_decode,
+  .visual_decode_loop = native_decode,
+  .visual_stream = native_stream,
+  .visual_resize = native_resize,
+  .visual_destroy = native_destroy,
+  .canopen_images = true,
+  .canopen_videos = false,
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "builddef.h"
 #ifndef USE_OIIO
 #ifndef USE_FFMPEG
+#ifndef USE_NATIVE
 #include "lib/internal.h"
 
 static void
@@ -14,3 +15,4 @@ ncvisual_implementation local_visual_implementation = {
 
 #endif
 #endif
+#endif
@@ -25,9 +25,6 @@ int oiio_stream(struct notcurses* nc, ncvisual* ncv, float timescale,
   memcpy(&activevopts, vopts, sizeof(*vopts));
   int ncerr;
   do{
-    if(activevopts.n){
-      ncplane_erase(activevopts.n); // new frame could be partially transparent
-    }
     // decay the blitter explicitly, so that the callback knows the blitter it
     // was actually rendered with
     ncvgeom geom;
@@ -38,6 +35,11 @@ int oiio_stream(struct notcurses* nc, ncvisual* ncv, float timescale,
       return -1;
     }
     activevopts.blitter = geom.blitter;
+    // new frame could be partially transparent. a sprixel copes with that
+    // itself when reblitted, and might be able to build upon its last frame.
+    if(activevopts.n && !(geom.blitter == NCBLIT_PIXEL && activevopts.n->sprite)){
+      ncplane_erase(activevopts.n);
+    }
     if((newn = ncvisual_blit(nc, ncv, &activevopts)) == NULL){
       if(activevopts.n != vopts->n){
         ncplane_destroy(activevopts.n);
@@ -86,6 +88,7 @@ ncvisual_implementation local_visual_implementation = {
   .visual_stream = oiio_stream,
   .visual_resize = oiio_resize,
   .visual_destroy = oiio_destroy,
+  .visual_tiles_open = oiio_tiles_open,
   .canopen_images = true,
   .canopen_videos = false,
 };
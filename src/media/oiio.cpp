@@ -13,6 +13,7 @@ typedef struct ncvisual_details {
   std::unique_ptr<uint32_t[]> frame;
   std::unique_ptr<OIIO::ImageBuf> ibuf;
   uint64_t framenum;
+  unsigned minpixy, minpixx; // smallest acceptable MIP level geometry
 } ncvisual_details;
 
 auto oiio_details_init(void) -> ncvisual_details* {
@@ -43,9 +44,29 @@ auto oiio_create() -> ncvisual* {
   return nc;
 }
 
+// the smallest MIP level of the subimage which is still large enough. files
+// without MIP maps only have level 0.
+static int
+oiio_miplevel(const ncvisual_details* deets, int subimage){
+  int miplevel = 0;
+  for(;;){
+    const auto s = deets->image->spec_dimensions(subimage, miplevel + 1);
+    if(s.width <= 0 || s.height <= 0){
+      break;
+    }
+    if(static_cast<unsigned>(s.width) < deets->minpixx ||
+       static_cast<unsigned>(s.height) < deets->minpixy){
+      break;
+    }
+    ++miplevel;
+  }
+  return miplevel;
+}
+
 int oiio_decode(ncvisual* nc) {
 //fprintf(stderr, "current subimage: %d frame: %p\n", nc->details->image->current_subimage(), nc->details->frame.get());
-  const auto &spec = nc->details->image->spec_dimensions(nc->details->framenum);
+  const int miplevel = oiio_miplevel(nc->details, nc->details->framenum);
+  const auto &spec = nc->details->image->spec_dimensions(nc->details->framenum, miplevel);
   if(nc->details->frame){
 //fprintf(stderr, "seeking subimage: %d\n", nc->details->image->current_subimage() + 1);
     OIIO::ImageSpec newspec;
@@ -64,7 +85,7 @@ int oiio_decode(ncvisual* nc) {
     std::fill(nc->details->frame.get(), nc->details->frame.get() + pixels, 0xfffffffful);
   }
 //fprintf(stderr, "READING: %d %ju\n", nc->details->image->current_subimage(), nc->details->framenum);
-  if(!nc->details->image->read_image(nc->details->framenum++, 0, 0, spec.nchannels, OIIO::TypeDesc(OIIO::TypeDesc::UINT8), nc->details->frame.get(), 4)){
+  if(!nc->details->image->read_image(nc->details->framenum++, miplevel, 0, spec.nchannels, OIIO::TypeDesc(OIIO::TypeDesc::UINT8), nc->details->frame.get(), 4)){
     return -1;
   }
 //fprintf(stderr, "READ: %d %ju\n", nc->details->image->current_subimage(), nc->details->framenum);
@@ -89,11 +110,13 @@ int oiio_decode(ncvisual* nc) {
   return 0;
 }
 
-ncvisual* oiio_from_file(const char* filename) {
+ncvisual* oiio_from_file(const char* filename, unsigned minpixy, unsigned minpixx) {
   ncvisual* ncv = oiio_create();
   if(ncv == nullptr){
     return nullptr;
   }
+  ncv->details->minpixy = minpixy;
+  ncv->details->minpixx = minpixx;
   ncv->details->image = OIIO::ImageInput::open(filename);
   if(!ncv->details->image){
     // fprintf(stderr, "Couldn't create %s (%s)\n", filename, strerror(errno));
@@ -110,6 +133,98 @@ spec.width << "@" << spec.nchannels << " (" << spec.format << ")" << std::endl;*
   return ncv;
 }
 
+// piecewise reading for nctiled_from_file(). tiled files are read a file tile
+// at a time; scanline files in bands of full-width rows.
+typedef struct oiio_tiles {
+  std::unique_ptr<OIIO::ImageInput> image;
+  bool tiled;
+} oiio_tiles;
+
+static int
+oiio_tile_geom(void* curry, unsigned level, unsigned* pxy, unsigned* pxx){
+  auto ot = static_cast<oiio_tiles*>(curry);
+  const auto s = ot->image->spec_dimensions(0, level);
+  if(s.width <= 0 || s.height <= 0){
+    return -1;
+  }
+  *pxy = s.height;
+  *pxx = s.width;
+  return 0;
+}
+
+static int
+oiio_load_tile(void* curry, unsigned level, unsigned tiley, unsigned tilex,
+               uint32_t* rgba){
+  auto ot = static_cast<oiio_tiles*>(curry);
+  const auto &spec0 = ot->image->spec();
+  const int tw = ot->tiled ? spec0.tile_width : spec0.width;
+  const int th = ot->tiled ? spec0.tile_height : 64;
+  const auto s = ot->image->spec_dimensions(0, level);
+  const int yb = tiley * th;
+  const int xb = tilex * tw;
+  const int ye = std::min(yb + th, s.height);
+  const int xe = std::min(xb + tw, s.width);
+  if(yb >= ye || xb >= xe){
+    return -1;
+  }
+  const int nch = s.nchannels;
+  if(nch < 3 || nch > 4){
+    return -1;
+  }
+  // 3-channel sources leave the alpha byte alone, so start fully opaque
+  if(nch == 3){
+    std::fill(rgba, rgba + static_cast<size_t>(th) * tw, 0xfffffffful);
+  }
+  const auto u8 = OIIO::TypeDesc(OIIO::TypeDesc::UINT8);
+  const OIIO::stride_t ystride = static_cast<OIIO::stride_t>(tw) * 4;
+  if(ot->tiled){
+    if(!ot->image->read_tiles(0, level, xb, xe, yb, ye, 0, 1, 0, nch, u8,
+                              rgba, 4, ystride)){
+      return -1;
+    }
+    return 0;
+  }
+  // scanline files span the full width in a single tile column
+  if(!ot->image->read_scanlines(0, level, yb, ye, 0, 0, nch, u8, rgba, 4, ystride)){
+    return -1;
+  }
+  return 0;
+}
+
+static void
+oiio_tiles_release(void* curry){
+  auto ot = static_cast<oiio_tiles*>(curry);
+  ot->image->close();
+  delete ot;
+}
+
+int oiio_tiles_open(const char* filename, nctiled_source* src){
+  auto ot = new oiio_tiles{};
+  ot->image = OIIO::ImageInput::open(filename);
+  if(!ot->image){
+    delete ot;
+    return -1;
+  }
+  const auto &spec = ot->image->spec();
+  ot->tiled = spec.tile_width > 0 && spec.tile_height > 0;
+  unsigned levels = 1;
+  while(levels < 255){
+    const auto s = ot->image->spec_dimensions(0, levels);
+    if(s.width <= 0 || s.height <= 0){
+      break;
+    }
+    ++levels;
+  }
+  src->levels = levels;
+  src->tilepxy = ot->tiled ? spec.tile_height : 64;
+  src->tilepxx = ot->tiled ? spec.tile_width : spec.width;
+  src->level_geom = oiio_tile_geom;
+  src->load_tile = oiio_load_tile;
+  src->release = oiio_tiles_release;
+  src->curry = ot;
+  return 0;
+}
+
 int oiio_decode_loop(ncvisual* ncv){
   int r = oiio_decode(ncv);
   if(r == 1){
@@ -191,9 +306,8 @@ auto ncvisual_rotate(ncvisual* ncv, double rads) -> int {
 auto oiio_destroy(ncvisual* ncv) -> void {
   if(ncv){
     oiio_details_destroy(ncv->details);
-    if(ncv->owndata){
-      free(ncv->data);
-    }
+    ncvisual_drop_data(ncv);
+    ncvisual_drop_spare(ncv);
     delete ncv;
   }
 }
@@ -14,7 +14,7 @@ void oiio_details_seed(struct ncvisual* ncv);
 int oiio_blit(const ncvisual* ncv, unsigned rows, unsigned cols,
               struct ncplane* n, const struct blitset* bset,
               const blitterargs* bargs);
-ncvisual* oiio_from_file(const char* filename);
+ncvisual* oiio_from_file(const char* filename, unsigned minpixy, unsigned minpixx);
 int oiio_decode_loop(ncvisual* ncv);
 int oiio_resize(ncvisual* nc, unsigned rows, unsigned cols);
 ncvisual* oiio_create(void);
@@ -23,6 +23,7 @@ int oiio_blit_dispatch(struct ncplane* nc, const struct blitset* bset,
                        int linesize, const void* data,
                        int leny, int lenx, const blitterargs* bargs);
 int oiio_init(int logl);
+int oiio_tiles_open(const char* filename, nctiled_source* src);
 
 extern ncvisual_implementation local_visual_implementation;
 
@@ -1,14 +1,143 @@
+#include "builddef.h"
 #include "notcurses/direct.h"
 #include "lib/internal.h"
 
+#ifdef NOTCURSES_MEDIA_MODULE
+#include <dlfcn.h>
+#include <libgen.h>
+#include <pthread.h>
+#include "lib/visual-details.h"
+
+// the shared libnotcurses doesn't link against its multimedia engine. the
+// engine is built as a module, installed alongside us, and loaded the first
+// time something asks for a visual (or the engine's banner). programs which
+// never use a visual thus never pay to relocate and initialize ffmpeg et al.
+// every ncvisual comes from visual_create() or visual_from_file(), so once
+// we've swapped in the real implementation, the rest of it is reached
+// directly through visual_implementation.
+
+static pthread_once_t media_once = PTHREAD_ONCE_INIT;
+static int media_loglevel;
+static ncvisual_implementation* media_implementation;
+
+// used if the module can't be loaded, so that we behave like "none"
+static ncvisual_implementation failed_visual_implementation = {0};
+
+static char*
+media_path(void){
+  Dl_info dli;
+  if(!dladdr((void*)media_path, &dli) || dli.dli_fname == NULL){
+    return strdup(NOTCURSES_MEDIA_MODULE);
+  }
+  char* self = strdup(dli.dli_fname);
+  if(self == NULL){
+    return NULL;
+  }
+  const char* dir = dirname(self);
+  char* path = malloc(strlen(dir) + strlen(NOTCURSES_MEDIA_MODULE) + 2);
+  if(path){
+    sprintf(path, "%s/%s", dir, NOTCURSES_MEDIA_MODULE);
+  }
+  free(self);
+  return path;
+}
+
+static void
+load_media(void){
+  ncvisual_implementation* impl = &failed_visual_implementation;
+  char* path = media_path();
+  void* handle = path ? dlopen(path, RTLD_NOW | RTLD_LOCAL) : NULL;
+  if(handle == NULL){
+    logerror("couldn't load multimedia engine %s (%s)", path ? path : "", dlerror());
+  }else{
+    ncvisual_implementation* loaded = dlsym(handle, "local_visual_implementation");
+    if(loaded == NULL){
+      logerror("%s has no multimedia engine", path);
+      dlclose(handle);
+    }else if(loaded->visual_init && loaded->visual_init(media_loglevel)){
+      logerror("couldn't initialize multimedia engine");
+      dlclose(handle);
+    }else{
+      loginfo("loaded multimedia engine from %s", path);
+      impl = loaded;
+    }
+  }
+  free(path);
+  media_implementation = impl;
+}
+
+// a later notcurses_init() will have put the lazy implementation back, so
+// swap in the loaded one each time we're called.
+static inline const ncvisual_implementation*
+media(void){
+  pthread_once(&media_once, load_media);
+  visual_implementation = media_implementation;
+  return media_implementation;
+}
+
+// called from notcurses_core_init(); just remember the loglevel for later
+static int
+lazy_init(int loglevel){
+  media_loglevel = loglevel;
+  return 0;
+}
+
+static void
+lazy_printbanner(fbuf* f){
+  const ncvisual_implementation* impl = media();
+  if(impl->visual_printbanner){
+    impl->visual_printbanner(f);
+  }else{
+    fbuf_puts(f, "couldn't load multimedia engine" NL);
+  }
+}
+
+static ncvisual*
+lazy_create(void){
+  const ncvisual_implementation* impl = media();
+  if(impl->visual_create){
+    return impl->visual_create();
+  }
+  ncvisual* ret = malloc(sizeof(*ret));
+  if(ret){
+    memset(ret, 0, sizeof(*ret));
+  }
+  return ret;
+}
+
+static ncvisual*
+lazy_from_file(const char* fname, unsigned minpixy, unsigned minpixx){
+  const ncvisual_implementation* impl = media();
+  if(impl->visual_from_file == NULL){
+    return NULL;
+  }
+  return impl->visual_from_file(fname, minpixy, minpixx);
+}
+
+static ncvisual_implementation lazy_visual_implementation = {
+  .visual_init = lazy_init,
+  .visual_printbanner = lazy_printbanner,
+  .visual_create = lazy_create,
+  .visual_from_file = lazy_from_file,
+  // reported before loading; the engine decides once it's up
+  .canopen_images = true,
+#ifdef USE_FFMPEG
+  .canopen_videos = true,
+#endif
+};
+
+static ncvisual_implementation* const engine = &lazy_visual_implementation;
+#else
 extern ncvisual_implementation local_visual_implementation;
+static ncvisual_implementation* const engine = &local_visual_implementation;
+#endif
 
 ncdirect* ncdirect_init(const char* termtype, FILE* outfp, uint64_t flags){
-  visual_implementation = &local_visual_implementation;
+  visual_implementation = engine;
   return ncdirect_core_init(termtype, outfp, flags);
 }
 
 notcurses* notcurses_init(const notcurses_options* opts, FILE* outfp){
-  visual_implementation = &local_visual_implementation;
+  visual_implementation = engine;
   return notcurses_core_init(opts, outfp);
 }
@@ -21,7 +21,7 @@ static void usage(std::ostream& os, const char* name, int exitcode)
   __attribute__ ((noreturn));
 
 void usage(std::ostream& o, const char* name, int exitcode){
-  o << "usage: " << name << " [ -h ] [ -q ] [ -m margins ] [ -l loglevel ] [ -d mult ] [ -s scaletype ] [ -k ] [ -L ] [ -t seconds ] [ -n ] [ -a color ] files" << '\n';
+  o << "usage: " << name << " [ -h ] [ -q ] [ -m margins ] [ -l loglevel ] [ -d mult ] [ -s scaletype ] [ -k ] [ -L ] [ -t seconds ] [ -n ] [ -a color ] [ --stats ] files" << '\n';
   o << " -h: display help and exit with success\n";
   o << " -V: print program name and version\n";
   o << " -q: be quiet (no frame/timing information along top of screen)\n";
@@ -34,7 +34,8 @@ void usage(std::ostream& o, const char* name, int exitcode){
   o << " -m margins: margin, or 4 comma-separated margins\n";
   o << " -a color: replace color with a transparent channel\n";
   o << " -n: force non-interpolative scaling\n";
-  o << " -d mult: non-negative floating point scale for frame time" << std::endl;
+  o << " -d mult: non-negative floating point scale for frame time\n";
+  o << " --stats: overlay dropped frames and presentation latency" << std::endl;
   exit(exitcode);
 }
 
@@ -42,8 +43,19 @@ struct marshal {
   int framecount;
   bool quiet;
   ncblitter_e blitter; // can be changed while streaming, must propagate out
+  ncstats* stats;      // non-null iff we're showing the stats overlay
+  struct ncplane* subp; // subtitle plane, kept across frames
+  int64_t seekns;      // seek requested by the streamer (returning 2)
+  uint64_t seekflags;
 };
 
+// ask the outer loop to seek by |ns| from the current frame.
+static auto request_seek(struct marshal* marsh, int64_t ns, uint64_t flags) -> int {
+  marsh->seekns = ns;
+  marsh->seekflags = flags;
+  return 2;
+}
+
 // frame count is in the curry. original time is kept in n's userptr.
 auto perframe(struct ncvisual* ncv, struct ncvisual_options* vopts,
               const struct timespec* abstime, void* vmarshal) -> int {
@@ -75,7 +87,7 @@ auto perframe(struct ncvisual* ncv, struct ncvisual_options* vopts,
     stdn->printf(0, NCAlign::Left, "frame %06d (%s)", marsh->framecount,
                  notcurses_str_blitter(vopts->blitter));
   }
-  struct ncplane* subp = ncvisual_subtitle_plane(*stdn, ncv);
+  ncvisual_subtitle_update(*stdn, ncv, &marsh->subp);
   const int64_t h = ns / (60 * 60 * NANOSECS_IN_SEC);
   ns -= h * (60 * 60 * NANOSECS_IN_SEC);
   const int64_t m = ns / (60 * NANOSECS_IN_SEC);
@@ -86,6 +98,16 @@ auto perframe(struct ncvisual* ncv, struct ncvisual_options* vopts,
     stdn->printf(0, NCAlign::Right, "%02" PRId64 ":%02" PRId64 ":%02" PRId64 ".%04" PRId64,
                  h, m, s, ns / 1000000);
   }
+  if(marsh->stats){
+    nc.get_stats(marsh->stats);
+    stdn->printf(1, NCAlign::Left, "dropped %6" PRIu64 " held %6" PRIu64
+                 " skew %+8.1fms cost %7.1fms queue %u",
+                 marsh->stats->stream_frames_dropped,
+                 marsh->stats->stream_frames_held,
+                 marsh->stats->stream_av_skew_ns / 1000000.0,
+                 marsh->stats->stream_present_ns / 1000000.0,
+                 marsh->stats->stream_queue_depth);
+  }
   if(!nc.render()){
     return -1;
   }
@@ -116,7 +138,6 @@ auto perframe(struct ncvisual* ncv, struct ncvisual_options* vopts,
     if(keyp == ' '){
       do{
         if((keyp = nc.get(true, &ni)) == (uint32_t)-1){
-          ncplane_destroy(subp);
           return -1;
         }
       }while(ni.id != 'q' && (ni.evtype == EvType::Release || ni.id != ' '));
@@ -136,24 +157,18 @@ auto perframe(struct ncvisual* ncv, struct ncvisual_options* vopts,
     }else if(keyp >= '7' && keyp <= '9' && !ncinput_alt_p(&ni) && !ncinput_ctrl_p(&ni)){
       continue; // don't error out
     }else if(keyp == NCKey::Up){
-      // FIXME move backwards significantly
-      continue;
+      return request_seek(marsh, -60 * (int64_t)NANOSECS_IN_SEC, NCVISUAL_SEEK_KEYFRAME);
     }else if(keyp == NCKey::Down){
-      // FIXME move forwards significantly
-      continue;
+      return request_seek(marsh, 60 * (int64_t)NANOSECS_IN_SEC, NCVISUAL_SEEK_KEYFRAME);
     }else if(keyp == NCKey::Right){
-      // FIXME move forwards
-      continue;
+      return request_seek(marsh, 5 * (int64_t)NANOSECS_IN_SEC, 0);
     }else if(keyp == NCKey::Left){
-      // FIXME move backwards
-      continue;
+      return request_seek(marsh, -5 * (int64_t)NANOSECS_IN_SEC, 0);
     }else if(keyp != 'q'){
       continue;
     }
-    ncplane_destroy(subp);
     return 1;
   }
-  ncplane_destroy(subp);
   return 0;
 }
 
@@ -161,14 +176,23 @@ auto perframe(struct ncvisual* ncv, struct ncvisual_options* vopts,
 auto handle_opts(int argc, char** argv, notcurses_options& opts, bool* quiet,
                  float* timescale, ncscale_e* scalemode, ncblitter_e* blitter,
                  float* displaytime, bool* loop, bool* noninterp,
-                 uint32_t* transcolor, bool* climode)
+                 uint32_t* transcolor, bool* climode, bool* showstats)
                  -> int {
   *timescale = 1.0;
   *scalemode = NCSCALE_STRETCH;
   *displaytime = -1;
-  int c;
-  while((c = getopt(argc, argv, "Vhql:d:s:b:t:m:kLa:n")) != -1){
+  const struct option longopts[] = {
+    { "help", 0, nullptr, 'h' },
+    { "version", 0, nullptr, 'V' },
+    { "stats", 0, nullptr, 'S' },
+    { nullptr, 0, nullptr, 0 },
+  };
+  int c, lidx;
+  while((c = getopt_long(argc, argv, "Vhql:d:s:b:t:m:kLa:n", longopts, &lidx)) != -1){
     switch(c){
+      case 'S':
+        *showstats = true;
+        break;
       case 'h':
         usage(std::cout, argv[0], EXIT_SUCCESS);
         break;
@@ -297,12 +321,95 @@ auto handle_opts(int argc, char** argv, notcurses_options& opts, bool* quiet,
   return optind;
 }
 
+// seek |ncv| by |ns| from the frame last presented, clamping at the start.
+static auto seek_visual(ncvisual* ncv, int64_t ns, uint64_t flags) -> int {
+  uint64_t pos;
+  if(ncvisual_position(ncv, &pos)){
+    pos = 0;
+  }
+  if(ns < 0 && static_cast<uint64_t>(-ns) > pos){
+    pos = 0;
+  }else{
+    pos += ns;
+  }
+  return ncvisual_seek(ncv, pos, flags);
+}
+
+// replay a recording made with ncrecorder_create() into |n|, honoring its
+// timing. left and right seek back and forth by five seconds (from the
+// nearest keyframe). returns 1 if the user quit.
+static auto replay_recording(NotCurses& nc, ncplane* n, ncplayback* pb,
+                             double timescale, bool loop) -> int {
+  const uint64_t seekns = 5 * NANOSECS_IN_SEC;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  uint64_t base = timespec_to_ns(&now); // when the recording's time 0 was shown
+  for( ; ; ){
+    uint64_t ns;
+    int r = ncplayback_next(pb, n, &ns);
+    if(r < 0){
+      return -1;
+    }else if(r > 0){
+      if(!loop){
+        return 0;
+      }
+      if(ncplayback_seek(pb, 0)){
+        return -1;
+      }
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      base = timespec_to_ns(&now);
+      continue;
+    }
+    const uint64_t deadline = base + ns * timescale;
+    bool seeked = false;
+    for( ; ; ){
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      const uint64_t nsnow = timespec_to_ns(&now);
+      ncinput ni;
+      uint32_t keyp;
+      if(deadline > nsnow){
+        struct timespec interval;
+        ns_to_timespec(deadline - nsnow, &interval);
+        keyp = nc.get(&interval, &ni);
+      }else{
+        keyp = nc.get(false, &ni);
+      }
+      if(keyp == 0){
+        break;
+      }else if(keyp == (uint32_t)-1){
+        return -1;
+      }else if(ni.evtype == EvType::Release){
+        continue;
+      }else if(keyp == 'q'){
+        return 1;
+      }else if(keyp == NCKey::Left || keyp == NCKey::Right){
+        uint64_t target = ns;
+        if(keyp == NCKey::Right){
+          target += seekns;
+        }else{
+          target = target > seekns ? target - seekns : 0;
+        }
+        if(ncplayback_seek(pb, target)){
+          return -1;
+        }
+        // frames preceding the target are applied without delay
+        base = nsnow - target * timescale;
+        seeked = true;
+        break;
+      }
+    }
+    if(!seeked && !nc.render()){
+      return -1;
+    }
+  }
+}
+
 int rendered_mode_player_inner(NotCurses& nc, int argc, char** argv,
                                ncscale_e scalemode, ncblitter_e blitter,
                                bool quiet, bool loop,
                                double timescale, double displaytime,
                                bool noninterp, uint32_t transcolor,
-                               bool climode){
+                               bool climode, bool showstats){
   unsigned dimy, dimx;
   std::unique_ptr<Plane> stdn(nc.get_stdplane(&dimy, &dimx));
   if(climode){
@@ -318,7 +425,25 @@ int rendered_mode_player_inner(NotCurses& nc, int argc, char** argv,
   nopts.flags = NCPLANE_OPTION_MARGINALIZED;
   ncplane* n = nullptr;
   ncplane* clin = nullptr;
+  std::unique_ptr<ncstats, decltype(&free)> stats(nullptr, free);
+  if(showstats){
+    stats.reset(nc.stats_alloc());
+  }
   for(auto i = 0 ; i < argc ; ++i){
+    if(ncplayback* pb = ncplayback_open(argv[i])){
+      struct ncplane_options ropts{};
+      ropts.rows = ropts.cols = 1; // the first keyframe sizes it
+      ropts.name = "rply";
+      ncplane* rn = ncplane_create(*stdn, &ropts);
+      int r = rn ? replay_recording(nc, rn, pb, timescale, loop) : -1;
+      ncplayback_close(pb);
+      ncplane_destroy(rn);
+      if(r < 0){
+        std::cerr << "Error while playing " << argv[i] << std::endl;
+        return -1;
+      }
+      continue;
+    }
     std::unique_ptr<Visual> ncv;
     ncv = std::make_unique<Visual>(argv[i]);
     if((n = ncplane_create(*stdn, &nopts)) == nullptr){
@@ -364,10 +489,27 @@ int rendered_mode_player_inner(NotCurses& nc, int argc, char** argv,
         .framecount = 0,
         .quiet = quiet,
         .blitter = vopts.blitter,
+        .stats = stats.get(),
+        .subp = nullptr,
+        .seekns = 0,
+        .seekflags = 0,
       };
-      r = ncv->stream(&vopts, timescale, perframe, &marsh);
-      free(stdn->get_userptr());
-      stdn->set_userptr(nullptr);
+      for( ; ; ){
+        r = ncv->stream(&vopts, timescale, perframe, &marsh);
+        ncplane_destroy(marsh.subp);
+        marsh.subp = nullptr;
+        free(stdn->get_userptr());
+        stdn->set_userptr(nullptr);
+        if(r != 2){
+          break;
+        }
+        // the streamer asked for a seek; resume streaming from there
+        vopts.blitter = marsh.blitter;
+        if(seek_visual(*ncv, marsh.seekns, marsh.seekflags)){
+          r = -1;
+          break;
+        }
+      }
       if(r == 0){
         vopts.blitter = marsh.blitter;
         if(!loop){
@@ -435,7 +577,7 @@ int rendered_mode_player(int argc, char** argv, ncscale_e scalemode,
                          bool quiet, bool loop,
                          double timescale, double displaytime,
                          bool noninterp, uint32_t transcolor,
-                         bool climode){
+                         bool climode, bool showstats){
   // no -k, we're using full rendered mode (and the alternate screen).
   ncopts.flags |= NCOPTION_INHIBIT_SETLOCALE;
   if(quiet){
@@ -451,7 +593,7 @@ int rendered_mode_player(int argc, char** argv, ncscale_e scalemode,
     }
     r = rendered_mode_player_inner(nc, argc, argv, scalemode, blitter,
                                    quiet, loop, timescale, displaytime,
-                                   noninterp, transcolor, climode);
+                                   noninterp, transcolor, climode, showstats);
     if(!nc.stop()){
       return -1;
     }
@@ -479,14 +621,15 @@ auto main(int argc, char** argv) -> int {
   bool loop = false;
   bool noninterp = false;
   bool climode = false;
+  bool showstats = false;
   auto nonopt = handle_opts(argc, argv, ncopts, &quiet, &timescale, &scalemode,
                             &blitter, &displaytime, &loop, &noninterp, &transcolor,
-                            &climode);
+                            &climode, &showstats);
   // if -k was provided, we use CLI mode rather than simply not using the
   // alternate screen, so that output is inline with the shell.
   if(rendered_mode_player(argc - nonopt, argv + nonopt, scalemode, blitter, ncopts,
                           quiet, loop, timescale, displaytime, noninterp,
-                          transcolor, climode)){
+                          transcolor, climode, showstats)){
     return EXIT_FAILURE;
   }
   return EXIT_SUCCESS;
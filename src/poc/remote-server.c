@@ -0,0 +1,169 @@
+#include <time.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <notcurses/notcurses.h>
+#ifndef __MINGW32__
+#include <poll.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// a minimal server for notcurses-remote(1): accepts one client on the port
+// given as the only argument, and serves it an offscreen pile showing the
+// time and whatever the client types. a frame is sent after each render.
+
+static int
+write_all(int fd, const char* buf, size_t len){
+  while(len){
+    ssize_t w = write(fd, buf, len);
+    if(w < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      return -1;
+    }
+    buf += w;
+    len -= w;
+  }
+  return 0;
+}
+
+static int
+accept_client(const char* port){
+  int lfd = socket(AF_INET6, SOCK_STREAM, 0);
+  if(lfd < 0){
+    return -1;
+  }
+  int one = 1;
+  setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  union {
+    struct sockaddr sa;
+    struct sockaddr_in6 sin6;
+  } addr = {
+    .sin6 = {
+      .sin6_family = AF_INET6,
+      .sin6_port = htons(atoi(port)),
+      .sin6_addr = IN6ADDR_ANY_INIT,
+    },
+  };
+  if(bind(lfd, &addr.sa, sizeof(addr.sin6)) || listen(lfd, 1)){
+    close(lfd);
+    return -1;
+  }
+  int fd = accept(lfd, NULL, NULL);
+  close(lfd);
+  return fd;
+}
+
+// send the pile as a frame; the first is complete, the rest deltas.
+static int
+send_frame(struct ncplane* p, int fd, bool* first){
+  if(ncpile_render(p)){
+    return -1;
+  }
+  unsigned y, x;
+  ncplane_cursor_yx(p, &y, &x);
+  char* buf;
+  size_t len;
+  if(ncpile_remote_frame(p, !*first, y, x, &buf, &len)){
+    return -1;
+  }
+  int ret = write_all(fd, buf, len);
+  free(buf);
+  *first = false;
+  return ret;
+}
+
+// handle all complete input messages, writing their text to |p|. returns 1
+// if the client hung up.
+static int
+read_client(struct ncplane* p, int fd, unsigned char* buf, size_t* used,
+            size_t size){
+  ssize_t got = read(fd, buf + *used, size - *used);
+  if(got <= 0){
+    return got == 0 ? 1 : errno == EINTR ? 0 : -1;
+  }
+  *used += got;
+  size_t off = 0;
+  while(*used - off >= 4){
+    const unsigned char* m = buf + off;
+    uint32_t mlen = m[0] | (m[1] << 8u) | (m[2] << 16u) | ((uint32_t)m[3] << 24u);
+    if(mlen == 0 || mlen > size - 4){
+      return -1;
+    }
+    if(*used - off - 4 < mlen){
+      break;
+    }
+    if(m[4] == NCREMOTE_MSG_INPUT && mlen >= 10){
+      char utf8[5] = {0};
+      memcpy(utf8, m + 14, mlen - 10 < 4 ? mlen - 10 : 4);
+      uint32_t id = m[5] | (m[6] << 8u) | (m[7] << 16u) | ((uint32_t)m[8] << 24u);
+      if(id == NCKEY_ENTER){
+        ncplane_putchar(p, '\n');
+      }else if(utf8[0] && (unsigned char)utf8[0] >= 0x20){
+        ncplane_putstr(p, utf8);
+      }
+    }
+    off += 4 + mlen;
+  }
+  memmove(buf, buf + off, *used - off);
+  *used -= off;
+  return 0;
+}
+
+int main(int argc, char** argv){
+  if(argc != 2){
+    fprintf(stderr, "usage: %s port\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  struct notcurses_options nopts = {
+    .flags = NCOPTION_SUPPRESS_BANNERS,
+  };
+  struct notcurses* nc = notcurses_core_init(&nopts, NULL);
+  if(nc == NULL){
+    return EXIT_FAILURE;
+  }
+  ncplane_printf(notcurses_stdplane(nc), "waiting on port %s...", argv[1]);
+  notcurses_render(nc);
+  int fd = accept_client(argv[1]);
+  struct ncplane_options popts = {
+    .rows = 24,
+    .cols = 80,
+  };
+  struct ncplane* p = ncpile_create(nc, &popts);
+  if(fd < 0 || p == NULL){
+    notcurses_stop(nc);
+    return EXIT_FAILURE;
+  }
+  ncplane_set_scrolling(p, true);
+  ncplane_putstr_yx(p, 1, 0, "type away:\n");
+  unsigned char buf[BUFSIZ];
+  size_t used = 0;
+  bool first = true;
+  int ret = 0;
+  while(ret == 0){
+    time_t t = time(NULL);
+    unsigned y, x;
+    ncplane_cursor_yx(p, &y, &x);
+    ncplane_printf_yx(p, 0, 0, "%s", ctime(&t));
+    ncplane_cursor_move_yx(p, y, x);
+    if(send_frame(p, fd, &first)){
+      ret = -1;
+      break;
+    }
+    struct pollfd pfd = { .fd = fd, .events = POLLIN, };
+    if(poll(&pfd, 1, 1000) > 0){
+      ret = read_client(p, fd, buf, &used, sizeof(buf));
+    }
+  }
+  close(fd);
+  return notcurses_stop(nc) || ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#else
+int main(void){
+  fprintf(stderr, "This program requires POSIX sockets\n");
+  return EXIT_FAILURE;
+}
+#endif
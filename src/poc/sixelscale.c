@@ -0,0 +1,113 @@
+#include <time.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <notcurses/notcurses.h>
+
+// blit a busy synthetic image via NCBLIT_PIXEL with 1 through N sixel
+// threads (N defaults to the number of processors, or the first argument),
+// and report the mean time per blit. only meaningful on Sixel terminals.
+
+#define ITERATIONS 20
+
+static uint32_t*
+synth_rgba(unsigned dimy, unsigned dimx){
+  uint32_t* rgba = malloc(sizeof(*rgba) * dimy * dimx);
+  if(rgba == NULL){
+    return NULL;
+  }
+  for(unsigned y = 0 ; y < dimy ; ++y){
+    for(unsigned x = 0 ; x < dimx ; ++x){
+      uint32_t px = 0xff000000ul;
+      ncpixel_set_r(&px, (x * 7 + y) % 256);
+      ncpixel_set_g(&px, (y * 3) % 256);
+      ncpixel_set_b(&px, (x ^ y) % 256);
+      rgba[y * dimx + x] = px;
+    }
+  }
+  return rgba;
+}
+
+static uint64_t
+ns_now(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// returns mean nanoseconds per blit+render, or 0 on failure
+static uint64_t
+bench(unsigned threads){
+  char tstr[16];
+  snprintf(tstr, sizeof(tstr), "%u", threads);
+  setenv("NOTCURSES_SIXEL_THREADS", tstr, 1);
+  struct notcurses_options opts = {
+    .flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_DRAIN_INPUT,
+  };
+  struct notcurses* nc = notcurses_init(&opts, NULL);
+  if(nc == NULL){
+    return 0;
+  }
+  if(notcurses_check_pixel_support(nc) != NCPIXEL_SIXEL){
+    notcurses_stop(nc);
+    return 0;
+  }
+  unsigned pxy, pxx;
+  ncplane_pixel_geom(notcurses_stdplane(nc), &pxy, &pxx, NULL, NULL, NULL, NULL);
+  uint32_t* rgba = synth_rgba(pxy, pxx);
+  struct ncvisual* ncv = rgba ? ncvisual_from_rgba(rgba, pxy, pxx * 4, pxx) : NULL;
+  free(rgba);
+  if(ncv == NULL){
+    notcurses_stop(nc);
+    return 0;
+  }
+  uint64_t total = 0;
+  for(int i = 0 ; i < ITERATIONS ; ++i){
+    struct ncvisual_options vopts = {
+      .n = notcurses_stdplane(nc),
+      .blitter = NCBLIT_PIXEL,
+      .flags = NCVISUAL_OPTION_CHILDPLANE | NCVISUAL_OPTION_NODEGRADE,
+    };
+    uint64_t t0 = ns_now();
+    struct ncplane* n = ncvisual_blit(nc, ncv, &vopts);
+    if(n == NULL){
+      total = 0;
+      break;
+    }
+    notcurses_render(nc);
+    total += ns_now() - t0;
+    ncplane_destroy(n);
+  }
+  ncvisual_destroy(ncv);
+  notcurses_stop(nc);
+  return total / ITERATIONS;
+}
+
+int main(int argc, char** argv){
+  unsigned maxthreads = 0;
+  if(argc > 1){
+    maxthreads = strtoul(argv[1], NULL, 10);
+  }
+  if(maxthreads == 0){
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    maxthreads = cpus > 0 ? cpus : 1;
+  }
+  uint64_t* results = calloc(maxthreads, sizeof(*results));
+  if(results == NULL){
+    return EXIT_FAILURE;
+  }
+  for(unsigned t = 1 ; t <= maxthreads ; ++t){
+    if((results[t - 1] = bench(t)) == 0){
+      fprintf(stderr, "couldn't benchmark %u threads (need Sixel support)\n", t);
+      free(results);
+      return EXIT_FAILURE;
+    }
+  }
+  // print only once the terminal has been restored
+  for(unsigned t = 1 ; t <= maxthreads ; ++t){
+    printf("%2u thread%s: %8.3fms/frame (%.2fx)\n", t, t == 1 ? " " : "s",
+           results[t - 1] / 1000000.0, (double)results[0] / results[t - 1]);
+  }
+  free(results);
+  return EXIT_SUCCESS;
+}
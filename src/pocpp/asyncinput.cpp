@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <cstdlib>
+#include <clocale>
+#include <notcurses/notcurses.h>
+#include <ncpp/Async.hh>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+using namespace ncpp::async;
+
+// echo input events until 'q', with all waiting done by the reactor
+static detached
+ui(notcurses* nc, poll_reactor& r, bool& failed){
+  ncplane* stdn = notcurses_stdplane(nc);
+  ncplane_set_scrolling(stdn, true);
+  ncplane_putstr(stdn, "press keys ('q' quits)\n");
+  for(;;){
+    if(co_await render_async(stdn, r)){
+      failed = true;
+      break;
+    }
+    ncinput ni;
+    const uint32_t id = co_await next_input(nc, r, &ni);
+    if(id == (uint32_t)-1){
+      failed = true;
+      break;
+    }
+    if(id == 'q'){
+      break;
+    }
+    if(ni.evtype != NCTYPE_RELEASE){
+      ncplane_printf(stdn, "got %s (0x%x)\n", ni.utf8[0] ? ni.utf8 : "?", id);
+    }
+  }
+}
+
+int main(void){
+  setlocale(LC_ALL, "");
+  notcurses_options opts{};
+  opts.flags = NCOPTION_INHIBIT_SETLOCALE;
+  notcurses* nc = notcurses_init(&opts, nullptr);
+  if(nc == nullptr){
+    return EXIT_FAILURE;
+  }
+  poll_reactor r;
+  bool failed = false;
+  ui(nc, r, failed);
+  r.run();
+  if(notcurses_stop(nc) || failed){
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+#else
+int main(void){
+  fprintf(stderr, "built without C++20 coroutine support\n");
+  return EXIT_SUCCESS;
+}
+#endif
@@ -16,6 +16,7 @@
 #include <ncpp/Selector.hh>
 #include <ncpp/Visual.hh>
 #include <ncpp/Direct.hh>
+#include <ncpp/Fast.hh>
 #include <ncpp/Plot.hh>
 #include <ncpp/FDPlane.hh>
 #include <ncpp/Subproc.hh>
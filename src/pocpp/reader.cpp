@@ -55,13 +55,11 @@ auto main(int argc, const char** argv) -> int {
     return EXIT_FAILURE;
   }
   ncinput ni;
-  unsigned tgeomy, tgeomx, vgeomy, vgeomx;
+  unsigned vgeomy, vgeomx;
   struct ncplane* ncp = ncreader_plane(nr);
-  struct ncplane* tplane = ncplane_above(ncp);
-  ncplane_dim_yx(tplane, &tgeomy, &tgeomx);
   ncplane_dim_yx(ncp, &vgeomy, &vgeomx);
-  (*n)->printf(0, 0, "Scroll: %c Cursor: 000/000 Viewgeom: %03u/%03u Textgeom: %03u/%03u",
-               horscroll ? '+' : '-', vgeomy, vgeomx, tgeomy, tgeomx);
+  (*n)->printf(0, 0, "Scroll: %c Cursor: 000/000 Viewgeom: %03u/%03u",
+               horscroll ? '+' : '-', vgeomy, vgeomx);
   nc.render();
   while(nc.get(true, &ni) != (char32_t)-1){
     if(ni.evtype == EvType::Release){
@@ -74,10 +72,9 @@ auto main(int argc, const char** argv) -> int {
     }else if(ncreader_offer_input(nr, &ni)){
       unsigned ncpy, ncpx;
       ncplane_cursor_yx(ncp, &ncpy, &ncpx);
-      ncplane_dim_yx(tplane, &tgeomy, &tgeomx);
       ncplane_dim_yx(ncp, &vgeomy, &vgeomx);
-      (*n)->printf(0, 0, "Scroll: %c Cursor: %03u/%03u Viewgeom: %03u/%03u Textgeom: %03u/%03u",
-                   horscroll ? '+' : '-', ncpy, ncpx, vgeomy, vgeomx, tgeomy, tgeomx);
+      (*n)->printf(0, 0, "Scroll: %c Cursor: %03u/%03u Viewgeom: %03u/%03u",
+                   horscroll ? '+' : '-', ncpy, ncpx, vgeomy, vgeomx);
       nc.render();
     }
   }
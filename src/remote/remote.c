@@ -0,0 +1,401 @@
+#include <time.h>
+#include <netdb.h>
+#include <poll.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <notcurses/notcurses.h>
+
+// messages in either direction are a u32 length (of everything following
+// it), a u8 type (NCREMOTE_MSG_*), and a body. all integers are little-endian.
+// frames are written by ncpile_remote_frame(), and applied with
+// ncplane_apply_capture(), which validates the capture's header.
+#define MSG_MAX (64u << 20) // refuse anything larger than this
+
+// predictions not confirmed (by the server moving its cursor) within this
+// long are withdrawn; the server probably isn't echoing.
+#define PREDICT_NS 1000000000ull
+
+typedef struct remote {
+  struct notcurses* nc;
+  struct ncplane* screen;   // frames from the server are applied here
+  struct ncplane* predict;  // our predicted echo of typed input
+  int fd;
+  unsigned char* buf;       // downstream bytes not yet handled
+  size_t used, size;
+  int cury, curx;           // server cursor as of the last frame, -1 if hidden
+  unsigned predicted;       // columns of predicted echo following the cursor
+  uint64_t predictns;       // when the oldest outstanding prediction was made
+  bool predicting;          // -n disables prediction
+} remote;
+
+static void
+usage(const char* argv0, FILE* o){
+  fprintf(o, "usage: %s [ -hVn ] host port\n", argv0);
+  fprintf(o, " -h: print help and return success\n");
+  fprintf(o, " -V: print version and return success\n");
+  fprintf(o, " -n: don't predict the echo of typed input\n");
+}
+
+static int
+parse_args(int argc, char** argv, bool* predicting){
+  const char* argv0 = *argv;
+  int longindex;
+  int c;
+  struct option longopts[] = {
+    { .name = "help", .has_arg = 0, .flag = NULL, .val = 'h', },
+    { .name = NULL, .has_arg = 0, .flag = NULL, .val = 0, }
+  };
+  while((c = getopt_long(argc, argv, "hVn", longopts, &longindex)) != -1){
+    switch(c){
+      case 'h': usage(argv0, stdout);
+                exit(EXIT_SUCCESS);
+                break;
+      case 'V': fprintf(stderr, "%s version %s\n", argv[0], notcurses_version());
+                exit(EXIT_SUCCESS);
+                break;
+      case 'n': *predicting = false;
+                break;
+      default: usage(argv0, stderr);
+               return -1;
+               break;
+    }
+  }
+  if(argc - optind != 2){
+    usage(argv0, stderr);
+    return -1;
+  }
+  return optind;
+}
+
+static uint64_t
+nowns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int
+connect_to(const char* host, const char* port){
+  struct addrinfo hints = {
+    .ai_family = AF_UNSPEC,
+    .ai_socktype = SOCK_STREAM,
+  };
+  struct addrinfo* res;
+  int r = getaddrinfo(host, port, &hints, &res);
+  if(r){
+    fprintf(stderr, "couldn't resolve %s:%s (%s)\n", host, port, gai_strerror(r));
+    return -1;
+  }
+  int fd = -1;
+  for(const struct addrinfo* ai = res ; ai ; ai = ai->ai_next){
+    if((fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) < 0){
+      continue;
+    }
+    if(connect(fd, ai->ai_addr, ai->ai_addrlen) == 0){
+      break;
+    }
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if(fd < 0){
+    fprintf(stderr, "couldn't connect to %s:%s (%s)\n", host, port, strerror(errno));
+  }
+  return fd;
+}
+
+static uint32_t
+get32(const unsigned char* b){
+  return b[0] | (b[1] << 8u) | (b[2] << 16u) | ((uint32_t)b[3] << 24u);
+}
+
+static void
+put32(unsigned char* b, uint32_t v){
+  b[0] = v;
+  b[1] = v >> 8u;
+  b[2] = v >> 16u;
+  b[3] = v >> 24u;
+}
+
+static int
+write_all(int fd, const unsigned char* buf, size_t len){
+  while(len){
+    ssize_t w = write(fd, buf, len);
+    if(w < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      return -1;
+    }
+    buf += w;
+    len -= w;
+  }
+  return 0;
+}
+
+static int
+send_input(remote* r, const ncinput* ni){
+  unsigned char msg[4 + 1 + 4 + 4 + 1 + sizeof(ni->utf8)];
+  size_t tlen = strnlen(ni->utf8, sizeof(ni->utf8));
+  put32(msg, 1 + 4 + 4 + 1 + tlen);
+  msg[4] = NCREMOTE_MSG_INPUT;
+  put32(msg + 5, ni->id);
+  put32(msg + 9, ni->modifiers);
+  msg[13] = ni->evtype;
+  memcpy(msg + 14, ni->utf8, tlen);
+  return write_all(r->fd, msg, 14 + tlen);
+}
+
+// place the terminal cursor where the server has it, past any prediction.
+static void
+place_cursor(remote* r){
+  if(r->cury < 0){
+    notcurses_cursor_disable(r->nc);
+    return;
+  }
+  unsigned dimx = ncplane_dim_x(r->screen);
+  unsigned x = r->curx + r->predicted;
+  if(x >= dimx){
+    x = dimx ? dimx - 1 : 0;
+  }
+  notcurses_cursor_enable(r->nc, r->cury, x);
+}
+
+static void
+withdraw_predictions(remote* r){
+  if(r->predicted){
+    ncplane_erase(r->predict);
+    r->predicted = 0;
+  }
+}
+
+// echo printable input locally, underlined, after the server's cursor. we
+// don't try to model the application beyond that; anything else withdraws
+// our predictions, as does the server moving its cursor.
+static void
+predict(remote* r, const ncinput* ni){
+  if(!r->predicting || r->cury < 0){
+    return;
+  }
+  if(ni->id == NCKEY_BACKSPACE && r->predicted){
+    --r->predicted;
+    ncplane_erase_region(r->predict, r->cury, r->curx + r->predicted, 1, 1);
+    return;
+  }
+  if(nckey_synthesized_p(ni->id) || ni->id < 0x20 || ni->id == 0x7f
+     || ncinput_ctrl_p(ni) || ncinput_alt_p(ni) || !ni->utf8[0]){
+    withdraw_predictions(r);
+    return;
+  }
+  int cols = ncstrwidth(ni->utf8, NULL, NULL);
+  if(cols <= 0 || r->curx + r->predicted + cols > ncplane_dim_x(r->screen)){
+    return;
+  }
+  if(r->predicted == 0){
+    r->predictns = nowns();
+  }
+  if(ncplane_putstr_yx(r->predict, r->cury, r->curx + r->predicted, ni->utf8) > 0){
+    r->predicted += cols;
+  }
+}
+
+static int
+handle_frame(remote* r, const unsigned char* body, size_t len){
+  if(len < 8){
+    fprintf(stderr, "short frame (%zu bytes)\n", len);
+    return -1;
+  }
+  int y = (int32_t)get32(body);
+  int x = (int32_t)get32(body + 4);
+  if(ncplane_apply_capture(r->screen, (const char*)body + 8, len - 8)){
+    fprintf(stderr, "couldn't apply frame\n");
+    return -1;
+  }
+  if(y != r->cury || x != r->curx){
+    withdraw_predictions(r);
+  }
+  r->cury = y;
+  r->curx = x;
+  return 0;
+}
+
+// handle all complete messages in the buffer. returns -1 on error, 1 if
+// the server hung up, and 0 otherwise.
+static int
+read_server(remote* r){
+  if(r->size - r->used < BUFSIZ){
+    size_t ns = r->size ? r->size * 2 : BUFSIZ * 4;
+    unsigned char* tmp = realloc(r->buf, ns);
+    if(tmp == NULL){
+      return -1;
+    }
+    r->buf = tmp;
+    r->size = ns;
+  }
+  ssize_t got = read(r->fd, r->buf + r->used, r->size - r->used);
+  if(got < 0){
+    return errno == EINTR || errno == EAGAIN ? 0 : -1;
+  }else if(got == 0){
+    return 1;
+  }
+  r->used += got;
+  size_t off = 0;
+  while(r->used - off >= 4){
+    uint32_t mlen = get32(r->buf + off);
+    if(mlen == 0 || mlen > MSG_MAX){
+      fprintf(stderr, "invalid message length %u\n", mlen);
+      return -1;
+    }
+    if(r->used - off - 4 < mlen){
+      if(r->size < mlen + 4){ // grow to hold it on the next read
+        unsigned char* tmp = realloc(r->buf, mlen + 4 + BUFSIZ);
+        if(tmp == NULL){
+          return -1;
+        }
+        r->buf = tmp;
+        r->size = mlen + 4 + BUFSIZ;
+      }
+      break;
+    }
+    const unsigned char* msg = r->buf + off + 4;
+    if(msg[0] == NCREMOTE_MSG_FRAME){
+      if(handle_frame(r, msg + 1, mlen - 1)){
+        return -1;
+      }
+    } // other types are reserved, and skipped
+    off += 4 + mlen;
+  }
+  memmove(r->buf, r->buf + off, r->used - off);
+  r->used -= off;
+  return 0;
+}
+
+// returns 1 when the user asks to leave (Ctrl+]).
+static int
+read_input(remote* r){
+  ncinput ni;
+  uint32_t id;
+  while((id = notcurses_get_nblock(r->nc, &ni)) != 0){
+    if(id == (uint32_t)-1){
+      return -1;
+    }
+    if(ni.evtype == NCTYPE_RELEASE){
+      continue;
+    }
+    if(id == ']' && ncinput_ctrl_p(&ni)){
+      return 1;
+    }
+    if(id == NCKEY_RESIZE){
+      continue;
+    }
+    if(send_input(r, &ni)){
+      fprintf(stderr, "error writing to server (%s)\n", strerror(errno));
+      return -1;
+    }
+    predict(r, &ni);
+  }
+  return 0;
+}
+
+static int
+remote_loop(remote* r){
+  struct pollfd pfds[2] = {
+    { .fd = r->fd, .events = POLLIN, },
+    { .fd = notcurses_inputready_fd(r->nc), .events = POLLIN, },
+  };
+  for(;;){
+    int timeout = -1;
+    if(r->predicted){
+      uint64_t elapsed = nowns() - r->predictns;
+      timeout = elapsed >= PREDICT_NS ? 0 : (PREDICT_NS - elapsed) / 1000000 + 1;
+    }
+    if(poll(pfds, 2, timeout) < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      return -1;
+    }
+    if(pfds[0].revents){
+      int ret = read_server(r);
+      if(ret){
+        return ret < 0 ? -1 : 0;
+      }
+    }
+    if(pfds[1].revents){
+      int ret = read_input(r);
+      if(ret){
+        return ret < 0 ? -1 : 0;
+      }
+    }
+    if(r->predicted && nowns() - r->predictns >= PREDICT_NS){
+      withdraw_predictions(r);
+    }
+    place_cursor(r);
+    if(notcurses_render(r->nc)){
+      return -1;
+    }
+  }
+}
+
+// both planes are kept the size of the terminal. the screen plane is
+// resized by each keyframe to the server's geometry.
+static int
+remote_planes(remote* r){
+  struct ncplane* std = notcurses_stdplane(r->nc);
+  struct ncplane_options nopts = {
+    .rows = ncplane_dim_y(std),
+    .cols = ncplane_dim_x(std),
+    .name = "scrn",
+  };
+  if((r->screen = ncplane_create(std, &nopts)) == NULL){
+    return -1;
+  }
+  nopts.name = "pred";
+  nopts.resizecb = ncplane_resize_maximize;
+  if((r->predict = ncplane_create(std, &nopts)) == NULL){
+    return -1;
+  }
+  uint64_t channels = 0;
+  ncchannels_set_fg_alpha(&channels, NCALPHA_TRANSPARENT);
+  ncchannels_set_bg_alpha(&channels, NCALPHA_TRANSPARENT);
+  ncplane_set_base(r->predict, "", 0, channels);
+  ncplane_set_styles(r->predict, NCSTYLE_UNDERLINE);
+  return 0;
+}
+
+int main(int argc, char** argv){
+  remote r = {
+    .fd = -1,
+    .cury = -1,
+    .curx = -1,
+    .predicting = true,
+  };
+  int nonopt = parse_args(argc, argv, &r.predicting);
+  if(nonopt <= 0){
+    return EXIT_FAILURE;
+  }
+  if((r.fd = connect_to(argv[nonopt], argv[nonopt + 1])) < 0){
+    return EXIT_FAILURE;
+  }
+  struct notcurses_options nopts = {
+    .flags = NCOPTION_SUPPRESS_BANNERS,
+  };
+  if((r.nc = notcurses_core_init(&nopts, NULL)) == NULL){
+    close(r.fd);
+    return EXIT_FAILURE;
+  }
+  int ret = -1;
+  if(remote_planes(&r) == 0){
+    notcurses_cursor_disable(r.nc);
+    ret = remote_loop(&r);
+  }
+  free(r.buf);
+  close(r.fd);
+  return notcurses_stop(r.nc) || ret ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,5 +1,6 @@
 #include "main.h"
 #include "ncpp/Visual.hh"
+#include "ncpp/Fast.hh"
 
 using namespace ncpp;
 
@@ -100,4 +101,45 @@ TEST_CASE("Ncpp"
     CHECK(nc.stop());
   }
 
+  SUBCASE("Fast") {
+    auto ctx = fast::context::init(nopts);
+    REQUIRE(ctx);
+    {
+      ncplane_options popts{};
+      popts.rows = 2;
+      popts.cols = 4;
+      auto created = fast::plane::create(ctx.value().stdplane().get(), popts);
+      REQUIRE(created);
+      fast::plane p = std::move(created).value();
+      CHECK(4 == p.dim_x());
+      // moving transfers ownership
+      fast::plane q = std::move(p);
+      CHECK(!p);
+      REQUIRE(q);
+      CHECK(4 == q.putstr_yx(0, 0, "fast").value_or(-1));
+      CHECK(!q.putstr_yx(5, 0, "x"));
+      uint64_t channels[8];
+      for(auto& c : channels){
+        c = NCCHANNELS_INITIALIZER(0xff, 0, 0, 0, 0, 0xff);
+      }
+      auto painted = q.paint(0, 0, 2, 4, channels);
+      REQUIRE(painted);
+      CHECK(8 == painted.value());
+      CHECK(!q.paint(0, 0, 2, 8, channels));
+      uint64_t chan;
+      free(ncplane_at_yx(q.get(), 1, 3, nullptr, &chan));
+      CHECK(channels[7] == chan);
+      const uint32_t rgba[4] = { htole(0xffffffff), htole(0xff0000ff),
+                                 htole(0xff00ff00), htole(0xffff0000) };
+      ncvisual_options vopts{};
+      vopts.blitter = NCBLIT_1x1;
+      auto blitted = q.blit_rgba(rgba, 2, 2, vopts);
+      REQUIRE(blitted);
+      CHECK(q.get() == blitted.value());
+      CHECK(ctx.value().render());
+    }
+    CHECK(ctx.value().stop());
+    CHECK(!ctx.value());
+  }
+
 }
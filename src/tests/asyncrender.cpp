@@ -0,0 +1,77 @@
+#include "main.h"
+#include <poll.h>
+
+// check that the rendered glyph at |y|/|x| is |egc|
+static void
+check_frame_egc(struct notcurses* nc, unsigned y, unsigned x, const char* egc){
+  auto rendered = notcurses_at_yx(nc, y, x, nullptr, nullptr);
+  REQUIRE(nullptr != rendered);
+  CHECK(0 == strcmp(egc, rendered));
+  free(rendered);
+}
+
+TEST_CASE("AsyncRender") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(nullptr != n_);
+
+  SUBCASE("RenderAndDrain") {
+    CHECK(1 == ncplane_putchar_yx(n_, 0, 0, 'a'));
+    CHECK(0 == ncpile_render_async(n_));
+    // the pile may be modified while the writer works
+    CHECK(1 == ncplane_putchar_yx(n_, 0, 1, 'b'));
+    CHECK(0 == ncpile_render_async(n_));
+    CHECK(0 == notcurses_write_drain(nc_));
+    check_frame_egc(nc_, 0, 0, "a");
+    check_frame_egc(nc_, 0, 1, "b");
+  }
+
+  // the completion descriptor is readable once the writer has caught up
+  SUBCASE("WritedoneFd") {
+    int fd = notcurses_writedone_fd(nc_);
+    if(fd >= 0){
+      CHECK(1 == ncplane_putchar_yx(n_, 1, 0, 'c'));
+      CHECK(0 == ncpile_render_async(n_));
+      struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0, };
+      CHECK(1 == poll(&pfd, 1, -1));
+      CHECK(0 != (pfd.revents & POLLIN));
+      check_frame_egc(nc_, 1, 0, "c");
+    }
+  }
+
+  // synchronous rasterization must follow anything already submitted
+  SUBCASE("MixedWithBlocking") {
+    for(int i = 0 ; i < 20 ; ++i){
+      CHECK(1 == ncplane_putchar_yx(n_, 2, i, 'x'));
+      CHECK(0 == ncpile_render_async(n_));
+    }
+    CHECK(1 == ncplane_putchar_yx(n_, 2, 0, 'y'));
+    CHECK(0 == notcurses_render(nc_));
+    check_frame_egc(nc_, 2, 0, "y");
+    check_frame_egc(nc_, 2, 19, "x");
+  }
+
+  // however many frames are skipped under a budget, nothing is lost once
+  // the deferred frame has been forced out
+  SUBCASE("FrameBudget") {
+    CHECK(0 == notcurses_set_frame_budget(nc_, 1));
+    for(int i = 0 ; i < 20 ; ++i){
+      CHECK(1 == ncplane_putchar_yx(n_, 3, i, 'a' + i));
+      CHECK(0 == notcurses_render(nc_));
+      CHECK(1 == ncplane_putchar_yx(n_, 4, i, 'a' + i));
+      CHECK(0 == ncpile_render_async(n_));
+    }
+    CHECK(0 == notcurses_write_drain(nc_));
+    for(int i = 0 ; i < 20 ; ++i){
+      char egc[2] = { (char)('a' + i), '\0' };
+      check_frame_egc(nc_, 3, i, egc);
+      check_frame_egc(nc_, 4, i, egc);
+    }
+    CHECK(0 == notcurses_set_frame_budget(nc_, 0));
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
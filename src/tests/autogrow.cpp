@@ -46,6 +46,41 @@ TEST_CASE("Autogrow") {
     CHECK(0 == ncplane_destroy(np));
   }
 
+  // many lines of output grow the plane a line at a time, and it must look
+  // the same as having been created at that size
+  SUBCASE("AutogrowManyLines") {
+    struct ncplane_options nopts{};
+    nopts.rows = 2;
+    nopts.cols = 8;
+    nopts.flags = NCPLANE_OPTION_AUTOGROW | NCPLANE_OPTION_VSCROLL;
+    auto np = ncplane_create(n_, &nopts);
+    REQUIRE(np);
+    const unsigned total = 1000;
+    for(unsigned i = 0 ; i < total ; ++i){
+      CHECK(0 < ncplane_printf(np, "%s%04u", i ? "\n" : "", i));
+    }
+    CHECK(total == ncplane_dim_y(np));
+    for(unsigned y = 0 ; y < total ; y += 111){
+      char* egc = ncplane_contents(np, y, 0, 1, 0);
+      REQUIRE(egc);
+      char expect[5];
+      snprintf(expect, sizeof(expect), "%04u", y);
+      CHECK(0 == strcmp(egc, expect));
+      free(egc);
+    }
+    // rows regained after shrinking must come back empty
+    CHECK(0 == ncplane_resize_simple(np, 5, 8));
+    CHECK(0 == ncplane_resize_simple(np, 10, 8));
+    for(unsigned y = 0 ; y < 10 ; ++y){
+      char* egc = ncplane_contents(np, y, 0, 1, 0);
+      REQUIRE(egc);
+      CHECK((y < 5 ? 4u : 0u) == strlen(egc));
+      free(egc);
+    }
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_destroy(np));
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
@@ -139,6 +139,40 @@ TEST_CASE("Bitmaps") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // a tiled bitmap larger than a tile ought be split across child planes,
+  // each with its own sprixel, covering the returned (blank) plane
+  SUBCASE("BitmapTiled") {
+    auto y = nc_->tcache.cellpxy * 40;
+    auto x = nc_->tcache.cellpxx * 40;
+    std::vector<uint32_t> v(x * y, htole(0xe61c28ff));
+    auto ncv = ncvisual_from_rgba(v.data(), y, sizeof(decltype(v)::value_type) * x, x);
+    REQUIRE(nullptr != ncv);
+    struct ncvisual_options vopts{};
+    vopts.n = n_;
+    vopts.blitter = NCBLIT_PIXEL;
+    vopts.flags = NCVISUAL_OPTION_NODEGRADE | NCVISUAL_OPTION_CHILDPLANE |
+                  NCVISUAL_OPTION_TILED;
+    auto n = ncvisual_blit(nc_, ncv, &vopts);
+    REQUIRE(nullptr != n);
+    CHECK(nullptr == n->sprite);
+    unsigned tiles = 0;
+    for(auto t = ncpile_top(n) ; t ; t = ncplane_below(t)){
+      if(t != n && ncplane_parent(t) == n){
+        CHECK(nullptr != t->sprite);
+        ++tiles;
+      }
+    }
+    CHECK(1 < tiles);
+    CHECK(0 == notcurses_render(nc_));
+    vopts.n = nullptr;
+    vopts.flags &= ~NCVISUAL_OPTION_CHILDPLANE;
+    vopts.pxoffy = 1;
+    CHECK(nullptr == ncvisual_blit(nc_, ncv, &vopts));
+    ncvisual_destroy(ncv);
+    CHECK(0 == ncplane_destroy_family(n, 0));
+    CHECK(0 == notcurses_render(nc_));
+  }
+
   SUBCASE("BitmapStack") {
     auto y = nc_->tcache.cellpxy * 10;
     auto x = nc_->tcache.cellpxx * 10;
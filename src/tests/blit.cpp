@@ -150,6 +150,38 @@ TEST_CASE("Blit") {
     }
   }
 
+  // the sextant solver chooses among 2-partitions of a 3x2 sample; check one
+  // that wants an interpolated trio in each color. the vectorized and scalar
+  // solvers must agree on these exact results.
+  SUBCASE("SextantSolver") {
+    if(notcurses_cansextant(nc_)){
+      const uint32_t p3x2[6] = {
+        htole(0xff302010), htole(0xff312212),
+        htole(0xff808080), htole(0xff838284),
+        htole(0xff807f82), htole(0xff2f2111),
+      };
+      auto ncv = ncvisual_from_rgba(p3x2, 3, 8, 2);
+      REQUIRE(nullptr != ncv);
+      struct ncvisual_options vopts{};
+      vopts.blitter = NCBLIT_3x2;
+      vopts.n = n_;
+      vopts.flags = NCVISUAL_OPTION_CHILDPLANE;
+      auto ncp = ncvisual_blit(nc_, ncv, &vopts);
+      ncvisual_destroy(ncv);
+      REQUIRE(nullptr != ncp);
+      CHECK(0 == notcurses_render(nc_));
+      ncplane_destroy(ncp);
+      uint64_t channels;
+      uint16_t stylemask;
+      auto egc = notcurses_at_yx(nc_, 0, 0, &stylemask, &channels);
+      REQUIRE(nullptr != egc);
+      CHECK(0 == strcmp(egc, "🬡"));
+      CHECK(0 == stylemask);
+      CHECK(0x4011213040828181 == channels);
+      free(egc);
+    }
+  }
+
   // put a visual through the ascii blitter, read it back, and check equality
   SUBCASE("AsciiRoundtrip") {
     const uint32_t data[2] = {
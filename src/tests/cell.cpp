@@ -399,6 +399,45 @@ TEST_CASE("Cell") {
     CHECK(nccell_rgbequal_p(&c));
   }
 
+  // the array helpers must agree with their single-value counterparts
+  SUBCASE("CellBulkHelpers") {
+    nccell cells[3] = { NCCELL_TRIVIAL_INITIALIZER, NCCELL_TRIVIAL_INITIALIZER,
+                        NCCELL_TRIVIAL_INITIALIZER, };
+    const uint32_t fgs[3] = { 0x000000, 0x123456, 0xffffff, };
+    const uint32_t bad[3] = { 0x000000, 0x1000000, 0x111111, };
+    CHECK(0 == nccells_set_fg_rgb(cells, fgs, 3));
+    CHECK(0 > nccells_set_bg_rgb(cells, bad, 3));
+    CHECK(0 == nccells_set_bg_rgb(cells, fgs, 2));
+    uint64_t chans[3];
+    nccells_channels(cells, chans, 3);
+    for(int i = 0 ; i < 3 ; ++i){
+      CHECK(chans[i] == cells[i].channels);
+      CHECK(fgs[i] == nccell_fg_rgb(&cells[i]));
+    }
+    CHECK(0x123456 == nccell_bg_rgb(&cells[1]));
+    CHECK(nccell_bg_default_p(&cells[2]));
+    uint32_t f[3], b[3];
+    ncchannels_unpack(chans, f, b, 3);
+    uint64_t packed[3];
+    ncchannels_pack(packed, f, b, 3);
+    for(int i = 0 ; i < 3 ; ++i){
+      CHECK(f[i] == ncchannels_fchannel(chans[i]));
+      CHECK(b[i] == ncchannels_bchannel(chans[i]));
+      CHECK(packed[i] == chans[i]);
+    }
+    ncchannels_unpack(chans, nullptr, b, 3);
+    nccells_set_channels(cells, packed + 1, 2);
+    CHECK(cells[0].channels == chans[1]);
+    CHECK(cells[1].channels == chans[2]);
+    CHECK(2 == nccells_load(n_, cells, 3, "a\u00e9"));
+    CHECK(1 == nccells_load(n_, cells, 1, "xyz"));
+    CHECK(0 == strcmp("x", nccell_extended_gcluster(n_, &cells[0])));
+    CHECK(0 == strcmp("\u00e9", nccell_extended_gcluster(n_, &cells[1])));
+    for(auto& c : cells){
+      nccell_release(n_, &c);
+    }
+  }
+
   // common teardown
   CHECK(0 == notcurses_stop(nc_));
 }
@@ -0,0 +1,198 @@
+#include "main.h"
+
+// check that the rendered glyph at |y|/|x| is |egc|. an empty cell is
+// reported as the empty string.
+static void
+check_frame_egc(struct notcurses* nc, unsigned y, unsigned x, const char* egc){
+  auto rendered = notcurses_at_yx(nc, y, x, nullptr, nullptr);
+  REQUIRE(nullptr != rendered);
+  CHECK(0 == strcmp(egc, rendered));
+  free(rendered);
+}
+
+// planes record the rows they've touched against their pile, so that only
+// those rows need be solved at the next render.
+TEST_CASE("Damage") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  unsigned dimy, dimx;
+  struct ncplane* n_ = notcurses_stddim_yx(nc_, &dimy, &dimx);
+  REQUIRE(nullptr != n_);
+  auto pile = ncplane_pile(n_);
+  // get the full first render out of the way
+  CHECK(0 == notcurses_render(nc_));
+  CHECK(!pile->dmgall);
+  CHECK(pile->dmgbeg >= pile->dmgend);
+
+  SUBCASE("PutcDamagesRow") {
+    CHECK(1 == ncplane_putchar_yx(n_, 2, 1, 'x'));
+    CHECK(2 == pile->dmgbeg);
+    CHECK(3 == pile->dmgend);
+    CHECK(1 == ncplane_putchar_yx(n_, 4, 0, 'y'));
+    CHECK(2 == pile->dmgbeg);
+    CHECK(5 == pile->dmgend);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(pile->dmgbeg >= pile->dmgend);
+    check_frame_egc(nc_, 2, 1, "x");
+    check_frame_egc(nc_, 4, 0, "y");
+  }
+
+  SUBCASE("EraseRegionDamagesRows") {
+    CHECK(1 == ncplane_putchar_yx(n_, 1, 1, 'x'));
+    CHECK(1 == ncplane_putchar_yx(n_, 3, 1, 'y'));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_erase_region(n_, 3, 0, 1, 0));
+    CHECK(3 == pile->dmgbeg);
+    CHECK(4 == pile->dmgend);
+    CHECK(0 == notcurses_render(nc_));
+    check_frame_egc(nc_, 1, 1, "x");
+    check_frame_egc(nc_, 3, 1, "");
+  }
+
+  // moving a plane must damage both where it was, and where it now is
+  SUBCASE("MoveDamagesBothExtents") {
+    struct ncplane_options nopts{};
+    nopts.y = 1;
+    nopts.rows = 2;
+    nopts.cols = 2;
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    CHECK(0 < ncplane_putstr_yx(n, 0, 0, "ab"));
+    CHECK(0 == notcurses_render(nc_));
+    check_frame_egc(nc_, 1, 0, "a");
+    CHECK(0 == ncplane_move_yx(n, 4, 0));
+    CHECK(1 == pile->dmgbeg);
+    CHECK(6 == pile->dmgend);
+    CHECK(0 == notcurses_render(nc_));
+    check_frame_egc(nc_, 1, 0, "");
+    check_frame_egc(nc_, 4, 0, "a");
+    CHECK(0 == ncplane_destroy(n));
+    CHECK(0 == notcurses_render(nc_));
+    check_frame_egc(nc_, 4, 0, "");
+  }
+
+  SUBCASE("ZAxisMoveDamages") {
+    struct ncplane_options nopts{};
+    nopts.rows = 1;
+    nopts.cols = 1;
+    auto bot = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != bot);
+    CHECK(1 == ncplane_putchar(bot, 'b'));
+    auto top = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != top);
+    CHECK(1 == ncplane_putchar(top, 't'));
+    CHECK(0 == notcurses_render(nc_));
+    check_frame_egc(nc_, 0, 0, "t");
+    ncplane_move_top(bot);
+    CHECK(0 == pile->dmgbeg);
+    CHECK(1 == pile->dmgend);
+    CHECK(0 == notcurses_render(nc_));
+    check_frame_egc(nc_, 0, 0, "b");
+    CHECK(0 == ncplane_destroy(top));
+    CHECK(0 == ncplane_destroy(bot));
+  }
+
+  // a region render solves only its region; damage elsewhere awaits the
+  // next full render.
+  SUBCASE("RenderRegion") {
+    CHECK(1 == ncplane_putchar_yx(n_, 2, 1, 'x'));
+    CHECK(1 == ncplane_putchar_yx(n_, 5, 3, 'y'));
+    CHECK(0 == ncpile_render_region(n_, 2, 1, 1, 1));
+    CHECK(2 == pile->solvedbeg);
+    CHECK(3 == pile->solvedend);
+    CHECK(0 == pile->solvedbegx);
+    CHECK(3 == pile->solvedendx);
+    CHECK(0 == ncpile_rasterize(n_));
+    check_frame_egc(nc_, 2, 1, "x");
+    check_frame_egc(nc_, 5, 3, "");
+    CHECK(2 == pile->dmgbeg);
+    CHECK(6 == pile->dmgend);
+    CHECK(0 == notcurses_render(nc_));
+    check_frame_egc(nc_, 2, 1, "x");
+    check_frame_egc(nc_, 5, 3, "y");
+  }
+
+  // a render without a rasterization must not lose its solved rows
+  SUBCASE("RenderWithoutRaster") {
+    CHECK(1 == ncplane_putchar_yx(n_, 1, 0, 'x'));
+    CHECK(0 == ncpile_render(n_));
+    CHECK(1 == ncplane_putchar_yx(n_, 5, 0, 'y'));
+    CHECK(0 == ncpile_render(n_));
+    CHECK(1 == pile->solvedbeg);
+    CHECK(6 == pile->solvedend);
+    CHECK(0 == ncpile_rasterize(n_));
+    check_frame_egc(nc_, 1, 0, "x");
+    check_frame_egc(nc_, 5, 0, "y");
+  }
+
+  SUBCASE("CellCompare") {
+    nccell dam = NCCELL_CHAR_INITIALIZER('a');
+    nccell src = NCCELL_CHAR_INITIALIZER('a');
+    CHECK(0 == cellcmp_and_dupfar(&n_->pool, &dam, n_, &src));
+    CHECK(0 == nccell_set_fg_rgb(&src, 0x00ff00));
+    CHECK(0 < cellcmp_and_dupfar(&n_->pool, &dam, n_, &src));
+    CHECK(dam.channels == src.channels);
+    CHECK(0 == cellcmp_and_dupfar(&n_->pool, &dam, n_, &src));
+    // equal EGCs from distinct pools must compare equal
+    nccell pooled = NCCELL_TRIVIAL_INITIALIZER;
+    CHECK(0 < nccell_load(n_, &pooled, "👨‍🔬"));
+    nccell pdam = NCCELL_TRIVIAL_INITIALIZER;
+    CHECK(0 < cellcmp_and_dupfar(&ncplane_notcurses(n_)->pool, &pdam, n_, &pooled));
+    CHECK(0 == cellcmp_and_dupfar(&ncplane_notcurses(n_)->pool, &pdam, n_, &pooled));
+    nccell_release(n_, &pooled);
+    pool_release(&ncplane_notcurses(n_)->pool, &pdam);
+  }
+
+  // damage deep within a row, behind a wide glyph, must still be emitted
+  SUBCASE("DamagedSpanAfterWide") {
+    if(notcurses_canutf8(nc_)){
+      CHECK(0 < ncplane_putstr_yx(n_, 0, 0, "全a"));
+      CHECK(0 == notcurses_render(nc_));
+      CHECK(0 < ncplane_putstr_yx(n_, 0, 6, "bc"));
+      CHECK(0 == notcurses_render(nc_));
+      check_frame_egc(nc_, 0, 0, "全");
+      check_frame_egc(nc_, 0, 2, "a");
+      check_frame_egc(nc_, 0, 6, "b");
+      check_frame_egc(nc_, 0, 7, "c");
+    }
+  }
+
+  // a cached layer must be recomposited whenever any of its planes change,
+  // and must still reveal what lies beneath its glyphless cells
+  SUBCASE("CachedLayer") {
+    CHECK(1 == ncplane_putchar_yx(n_, 1, 3, 'z'));
+    struct ncplane_options nopts{};
+    nopts.rows = 3;
+    nopts.cols = 6;
+    auto root = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != root);
+    CHECK(0 < ncplane_putstr_yx(root, 0, 0, "aaaaaa"));
+    nopts.rows = 1;
+    nopts.cols = 2;
+    auto kid = ncplane_create(root, &nopts);
+    REQUIRE(nullptr != kid);
+    CHECK(0 < ncplane_putstr_yx(kid, 0, 0, "bc"));
+    CHECK(!ncplane_set_layercache(root, true));
+    CHECK(ncplane_layercache_p(root));
+    CHECK(0 == notcurses_render(nc_));
+    check_frame_egc(nc_, 0, 0, "b");
+    check_frame_egc(nc_, 0, 2, "a");
+    check_frame_egc(nc_, 1, 3, "z");
+    CHECK(0 < ncplane_putstr_yx(kid, 0, 0, "de"));
+    CHECK(0 == notcurses_render(nc_));
+    check_frame_egc(nc_, 0, 1, "e");
+    CHECK(0 == ncplane_move_yx(root, 2, 0));
+    CHECK(0 == notcurses_render(nc_));
+    check_frame_egc(nc_, 0, 0, "");
+    check_frame_egc(nc_, 2, 0, "d");
+    CHECK(0 == ncplane_destroy(kid));
+    CHECK(0 == notcurses_render(nc_));
+    check_frame_egc(nc_, 2, 0, "a");
+    CHECK(ncplane_set_layercache(root, false));
+    CHECK(0 == ncplane_destroy(root));
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
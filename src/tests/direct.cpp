@@ -1,4 +1,5 @@
 #include "main.h"
+#include <sys/stat.h>
 #include <notcurses/direct.h>
 
 TEST_CASE("Direct") {
@@ -88,6 +89,13 @@ TEST_CASE("Direct") {
     CHECK(0 == ncdirect_render_image(nc_, find_data("worldmap.png").get(), NCALIGN_RIGHT, NCBLIT_1x1, NCSCALE_SCALE));
   }
 
+  // a tall image spans several bands with every cell blitter
+  SUBCASE("StreamBands") {
+    for(auto b : { NCBLIT_1x1, NCBLIT_2x1, NCBLIT_2x2, NCBLIT_3x2 }){
+      CHECK(0 == ncdirect_render_image(nc_, find_data("changes.jpg").get(), NCALIGN_CENTER, b, NCSCALE_NONE));
+    }
+  }
+
   SUBCASE("LoadSprixel") {
     if(ncdirect_check_pixel_support(nc_) > 0){
       CHECK(0 == ncdirect_render_image(nc_, find_data("changes.jpg").get(), NCALIGN_LEFT, NCBLIT_PIXEL, NCSCALE_STRETCH));
@@ -177,9 +185,54 @@ TEST_CASE("Direct") {
   // make sure that we can pass undefined flags and still create the ncdirect.
   // we don't pass all 1s, or we turn on all logging, and run into trouble!
   SUBCASE("FutureFlags") {
-    auto fnc = ncdirect_init(NULL, stdout, NCDIRECT_OPTION_VERY_VERBOSE << 1u);
+    auto fnc = ncdirect_init(NULL, stdout, NCDIRECT_OPTION_SHADOW_CURSOR << 1u);
     REQUIRE(nullptr != fnc);
     CHECK(0 == ncdirect_stop(fnc));
   }
 
+  // the tracked cursor ought agree with the terminal's report
+  SUBCASE("ShadowCursor") {
+    auto snc = ncdirect_init(NULL, stdout, NCDIRECT_OPTION_SHADOW_CURSOR);
+    REQUIRE(nullptr != snc);
+    if(ncdirect_canget_cursor(snc)){
+      CHECK(0 <= ncdirect_putstr(snc, 0, "\nshadow\n"));
+      CHECK(0 == ncdirect_cursor_right(snc, 2));
+      unsigned sy, sx, y, x;
+      CHECK(0 == ncdirect_cursor_yx(snc, &sy, &sx));
+      CHECK(0 == ncdirect_cursor_resync(snc));
+      CHECK(0 == ncdirect_cursor_yx(snc, &y, &x));
+      CHECK(y == sy);
+      CHECK(x == sx);
+    }
+    CHECK(0 == ncdirect_stop(snc));
+  }
+
+}
+
+// batched output is held until ncdirect_flush(), and redundant color changes
+// are elided. this writes to its own file, and thus wants its own context.
+TEST_CASE("DirectBatch") {
+  FILE* fp = tmpfile();
+  REQUIRE(nullptr != fp);
+  auto bnc = ncdirect_init(NULL, fp, 0);
+  REQUIRE(nullptr != bnc);
+  CHECK(0 == ncdirect_flush(bnc));
+  struct stat st;
+  REQUIRE(0 == fstat(fileno(fp), &st));
+  const off_t before = st.st_size;
+  CHECK(0 == ncdirect_begin_batch(bnc));
+  uint64_t chans = NCCHANNELS_INITIALIZER(0xff, 0, 0xff, 0, 0, 0);
+  for(int i = 0 ; i < 100 ; ++i){
+    CHECK(0 <= ncdirect_putstr(bnc, chans, "x"));
+  }
+  fflush(fp);
+  REQUIRE(0 == fstat(fileno(fp), &st));
+  CHECK(before == st.st_size);
+  CHECK(0 == ncdirect_flush(bnc));
+  REQUIRE(0 == fstat(fileno(fp), &st));
+  CHECK(before + 100 <= st.st_size);
+  CHECK(before + 100 + 64 > st.st_size);
+  CHECK(0 == ncdirect_end_batch(bnc));
+  CHECK(0 == ncdirect_stop(bnc));
+  fclose(fp);
 }
@@ -1,3 +1,4 @@
+#include <string>
 #include <vector>
 #include "main.h"
 #include "lib/egcpool.h"
@@ -10,6 +11,8 @@ TEST_CASE("EGCpool") {
     CHECK(!pool_.poolsize);
     CHECK(!pool_.poolwrite);
     CHECK(!pool_.poolused);
+    CHECK(!pool_.poolfree);
+    CHECK(!pool_.freelists);
   }
 
   auto nc_ = testing_notcurses();
@@ -22,6 +25,35 @@ TEST_CASE("EGCpool") {
   }
   auto n_ = notcurses_stdplane(nc_);
 
+  // UTF-8 must be validated the same on either side of the 32-byte stride
+  // over ASCII runs
+  SUBCASE("UTF8StrideBoundaries") {
+    std::string ascii(70, 'x');
+    int vbytes;
+    CHECK(70 == ncstrwidth(ascii.c_str(), &vbytes, NULL));
+    CHECK(70 == vbytes);
+    for(size_t pos : { 0, 5, 31, 32, 33, 64 }){
+      std::string s = ascii;
+      s.insert(pos, "\u00e0\U0001F600");
+      CHECK(0 < ncstrwidth(s.c_str(), &vbytes, NULL));
+      CHECK(s.size() == (size_t)vbytes);
+      CHECK(0 > ncstrwidth(s.substr(0, pos + 2 + 3).c_str(), &vbytes, NULL)); // truncated
+      CHECK(pos + 2 >= (size_t)vbytes);
+      std::string bad = ascii;
+      bad.insert(pos, "\xc0\xaf"); // overlong '/'
+      CHECK(0 > ncstrwidth(bad.c_str(), &vbytes, NULL));
+      CHECK(pos >= (size_t)vbytes);
+      bad = ascii;
+      bad.insert(pos, "\xed\xa0\x80"); // surrogate
+      CHECK(0 > ncstrwidth(bad.c_str(), &vbytes, NULL));
+      CHECK(pos >= (size_t)vbytes);
+      bad = ascii;
+      bad.insert(pos, "\x80");
+      CHECK(0 > ncstrwidth(bad.c_str(), &vbytes, NULL));
+      CHECK(pos >= (size_t)vbytes);
+    }
+  }
+
   SUBCASE("UTF8EGC") {
     int c = ncstrwidth("☢", NULL, NULL);
     CHECK(0 < c);
@@ -112,6 +144,247 @@ TEST_CASE("EGCpool") {
     CHECK(0 < pool_.poolwrite);
   }
 
+  // a released block is reused by the next EGC of its length, and only by an
+  // EGC of its length.
+  SUBCASE("ReuseByLength") {
+    int o1 = egcpool_stash(&pool_, "abcdef", 6);
+    int o2 = egcpool_stash(&pool_, "ghijkl", 6);
+    REQUIRE(0 <= o1);
+    REQUIRE(o1 < o2);
+    egcpool_release(&pool_, o1);
+    CHECK(7 == pool_.poolfree);
+    CHECK(7 == egcpool_fragmentation(&pool_));
+    const int hwm = pool_.poolwrite;
+    CHECK(hwm == egcpool_stash(&pool_, "mnopq", 5));
+    CHECK(o1 == egcpool_stash(&pool_, "rstuvw", 6));
+    CHECK(0 == pool_.poolfree);
+    CHECK(0 == egcpool_fragmentation(&pool_));
+    CHECK(!strcmp(pool_.pool + o1, "rstuvw"));
+    CHECK(!strcmp(pool_.pool + o2, "ghijkl"));
+  }
+
+  SUBCASE("InternTable") {
+    auto t = egcintern_create();
+    REQUIRE(nullptr != t);
+    int i1 = egcintern_acquire(t, "abcdefgh", 8);
+    REQUIRE(0 <= i1);
+    CHECK(i1 == egcintern_acquire(t, "abcdefghij", 8)); // only 8 bytes count
+    CHECK(2 == t->slots[i1].refs);
+    CHECK(1 == t->used);
+    CHECK(1 == t->hits);
+    // enough distinct EGCs to force both slot growth and rehashing
+    std::vector<int> idxs;
+    for(int i = 0 ; i < 1000 ; ++i){
+      auto egc = std::to_string(100000 + i);
+      idxs.push_back(egcintern_acquire(t, egc.c_str(), egc.size()));
+      REQUIRE(0 <= idxs.back());
+    }
+    CHECK(1001 == t->used);
+    CHECK(EGCINTERN_MINIMUM_BUCKETS < t->bucketcount);
+    for(int i = 0 ; i < 1000 ; ++i){
+      CHECK(std::to_string(100000 + i) == t->slots[idxs[i]].egc);
+      egcintern_release(t, idxs[i]);
+    }
+    CHECK(1 == t->used);
+    egcintern_release(t, i1);
+    CHECK(0 == strcmp("abcdefgh", t->slots[i1].egc));
+    egcintern_release(t, i1);
+    CHECK(0 == t->used);
+    CHECK(nullptr == t->slots[i1].egc);
+    // freed slots are reused
+    CHECK(0 <= egcintern_acquire(t, "abcdefgh", 8));
+    CHECK(t->slotcount >= 1001);
+    egcintern_destroy(t);
+  }
+
+  // planes of an interning pile share one copy of each spilled EGC
+  SUBCASE("InternedPile") {
+    const char* egc = "a\u0300\u0301";
+    struct ncplane_options nopts{};
+    nopts.rows = 4;
+    nopts.cols = 4;
+    auto root = ncpile_create(nc_, &nopts);
+    REQUIRE(nullptr != root);
+    CHECK(0 == ncpile_intern_egcs(root));
+    auto child = ncplane_create(root, &nopts);
+    REQUIRE(nullptr != child);
+    for(unsigned y = 0 ; y < nopts.rows ; ++y){
+      for(unsigned x = 0 ; x < nopts.cols ; ++x){
+        CHECK(0 < ncplane_putegc_yx(root, y, x, egc, nullptr));
+        CHECK(0 < ncplane_putegc_yx(child, y, x, egc, nullptr));
+      }
+    }
+    auto t = ncplane_pile(root)->interns;
+    REQUIRE(nullptr != t);
+    CHECK(t == child->pool.interns);
+    CHECK(1 == t->used);
+    CHECK(0 == root->pool.poolused);
+    CHECK(0 == child->pool.poolused);
+    auto c = ncplane_cell_ref_yx(child, 0, 0);
+    REQUIRE(cell_interned_p(c));
+    const auto idx = cell_egc_idx(c);
+    CHECK(32 == t->slots[idx].refs);
+    // a duplicate takes its own references
+    auto dup = ncplane_dup(child, nullptr);
+    REQUIRE(nullptr != dup);
+    CHECK(48 == t->slots[idx].refs);
+    CHECK(0 == ncplane_destroy(dup));
+    CHECK(32 == t->slots[idx].refs);
+    CHECK(1 == ncplane_putchar_yx(root, 0, 0, 'x'));
+    CHECK(31 == t->slots[idx].refs);
+    // leaving the pile takes a private copy
+    CHECK(child == ncplane_reparent(child, n_));
+    CHECK(15 == t->slots[idx].refs);
+    CHECK(nullptr == child->pool.interns);
+    CHECK(cell_pooled_p(ncplane_cell_ref_yx(child, 0, 0)));
+    auto s = ncplane_at_yx(child, 0, 0, nullptr, nullptr);
+    REQUIRE(nullptr != s);
+    CHECK(0 == strcmp(egc, s));
+    free(s);
+    CHECK(0 == ncplane_destroy(child));
+    CHECK(0 == ncplane_destroy(root));
+  }
+
+  // a duplicate shares the framebuffer and pool until either plane writes
+  SUBCASE("SharedDup") {
+    const char* egc = "a\u0300\u0301"; // a with combining grave and acute
+    struct ncplane_options nopts{};
+    nopts.rows = 4;
+    nopts.cols = 8;
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    CHECK(0 < ncplane_putegc_yx(n, 0, 0, egc, nullptr));
+    auto dup = ncplane_dup(n, nullptr);
+    REQUIRE(nullptr != dup);
+    CHECK(n->fb == dup->fb);
+    CHECK(n->pool.pool == dup->pool.pool);
+    REQUIRE(nullptr != n->fbshare);
+    CHECK(n->fbshare == dup->fbshare);
+    CHECK(2 == n->fbshare->refs);
+    // writing to the duplicate leaves the original untouched
+    CHECK(1 == ncplane_putchar_yx(dup, 0, 1, 'x'));
+    CHECK(nullptr == dup->fbshare);
+    CHECK(n->fb != dup->fb);
+    CHECK(n->pool.pool != dup->pool.pool);
+    CHECK(1 == n->fbshare->refs);
+    auto s = ncplane_at_yx(n, 0, 1, nullptr, nullptr);
+    REQUIRE(nullptr != s);
+    CHECK(0 == strcmp("", s));
+    free(s);
+    for(auto p : { n, dup }){
+      s = ncplane_at_yx(p, 0, 0, nullptr, nullptr);
+      REQUIRE(nullptr != s);
+      CHECK(0 == strcmp(egc, s));
+      free(s);
+    }
+    // the last sharer writes in place
+    nccell* fb = n->fb;
+    CHECK(1 == ncplane_putchar_yx(n, 0, 2, 'y'));
+    CHECK(nullptr == n->fbshare);
+    CHECK(fb == n->fb);
+    CHECK(0 == ncplane_destroy(dup));
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  // erasing keeps the pool's storage, but starts it over
+  SUBCASE("EraseResetsPool") {
+    const char* egc = "a\u0300\u0301"; // a with combining grave and acute
+    struct ncplane_options nopts{};
+    nopts.rows = 2;
+    nopts.cols = 8;
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    CHECK(0 < ncplane_set_base(n, egc, 0, 0));
+    for(unsigned x = 0 ; x < nopts.cols ; ++x){
+      CHECK(0 < ncplane_putegc_yx(n, 0, x, egc, nullptr));
+    }
+    const char* storage = n->pool.pool;
+    REQUIRE(nullptr != storage);
+    ncplane_erase(n);
+    CHECK(storage == n->pool.pool);
+    const int len = strlen(egc) + 1;
+    CHECK(len == n->pool.poolused); // only the base cell's
+    CHECK(len == n->pool.poolwrite);
+    auto s = ncplane_at_yx(n, 0, 0, nullptr, nullptr);
+    REQUIRE(nullptr != s);
+    CHECK(0 == strcmp(egc, s)); // the base cell shows through
+    free(s);
+    CHECK(0 < ncplane_set_base(n, " ", 0, 0));
+    CHECK(0 < ncplane_putegc_yx(n, 1, 2, egc, nullptr));
+    CHECK(0 < ncplane_putegc_yx(n, 1, 3, egc, nullptr));
+    CHECK(0 == ncplane_erase_region(n, 1, 2, 1, 2));
+    CHECK(0 == n->pool.poolused);
+    CHECK(0 == n->pool.poolwrite);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  // compaction must retain exactly those EGCs still referenced by the plane
+  SUBCASE("CompactPlane") {
+    const char* egc = "a\u0300\u0301"; // a with combining grave and acute
+    struct ncplane_options nopts{};
+    nopts.rows = 8;
+    nopts.cols = 8;
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    for(unsigned y = 0 ; y < nopts.rows ; ++y){
+      for(unsigned x = 0 ; x < nopts.cols ; ++x){
+        CHECK(0 < ncplane_putegc_yx(n, y, x, egc, nullptr));
+      }
+    }
+    const int len = strlen(egc) + 1;
+    CHECK(64 * len == n->pool.poolused);
+    for(unsigned y = 0 ; y < nopts.rows - 1 ; ++y){
+      for(unsigned x = 0 ; x < nopts.cols ; ++x){
+        CHECK(1 == ncplane_putchar_yx(n, y, x, 'x'));
+      }
+    }
+    CHECK(56 * len == egcpool_fragmentation(&n->pool));
+    ncstats stats;
+    notcurses_stats(nc_, &stats);
+    const auto compactions = stats.pool_compactions;
+    CHECK(56 * len <= stats.pool_fragmented);
+    const unsigned generation = n->pool.generation;
+    CHECK(56 * len == ncplane_compact_pool(n));
+    CHECK(generation != n->pool.generation);
+    CHECK(0 == egcpool_fragmentation(&n->pool));
+    CHECK(8 * len == n->pool.poolwrite);
+    for(unsigned x = 0 ; x < nopts.cols ; ++x){
+      auto s = ncplane_at_yx(n, nopts.rows - 1, x, nullptr, nullptr);
+      REQUIRE(nullptr != s);
+      CHECK(0 == strcmp(egc, s));
+      free(s);
+    }
+    notcurses_stats(nc_, &stats);
+    CHECK(compactions + 1 == stats.pool_compactions);
+    // nothing left to reclaim
+    CHECK(0 == ncplane_compact_pool(n));
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  // resizing a badly fragmented plane compacts its pool
+  SUBCASE("CompactOnResize") {
+    const char* egc = "a\u0300\u0301";
+    struct ncplane_options nopts{};
+    nopts.rows = 40;
+    nopts.cols = 40;
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    for(unsigned y = 0 ; y < nopts.rows ; ++y){
+      for(unsigned x = 0 ; x < nopts.cols ; ++x){
+        CHECK(0 < ncplane_putegc_yx(n, y, x, egc, nullptr));
+      }
+    }
+    CHECK(0 == ncplane_erase_region(n, 0, 0, nopts.rows - 1, 0));
+    CHECK(egcpool_compaction_justified(&n->pool));
+    CHECK(0 == ncplane_resize_simple(n, nopts.rows + 1, nopts.cols));
+    CHECK(0 == egcpool_fragmentation(&n->pool));
+    auto s = ncplane_at_yx(n, nopts.rows - 1, 0, nullptr, nullptr);
+    REQUIRE(nullptr != s);
+    CHECK(0 == strcmp(egc, s));
+    free(s);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
   // POOL_MINIMUM_ALLOC is the minimum size of an egcpool once it goes active.
   // add EGCs to it past this boundary, and verify that they're all still
   // accurate.
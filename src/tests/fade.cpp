@@ -140,6 +140,72 @@ TEST_CASE("Fade") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // a single iteration scales each component by the same ratio
+  SUBCASE("FadeIterationScales") {
+    nccell orig = NCCELL_TRIVIAL_INITIALIZER;
+    REQUIRE(0 < ncplane_at_yx_cell(n_, 1, 1, &orig));
+    auto nctx = ncfadectx_setup(n_);
+    REQUIRE(nctx);
+    auto maxiter = ncfadectx_iterations(nctx);
+    const int iter = maxiter / 2;
+    CHECK(0 < ncplane_fadeout_iteration(n_, nctx, iter, fadeaborter, nullptr));
+    nccell faded = NCCELL_TRIVIAL_INITIALIZER;
+    REQUIRE(0 < ncplane_at_yx_cell(n_, 1, 1, &faded));
+    unsigned r, g, b, fr, fg, fb;
+    nccell_fg_rgb8(&orig, &r, &g, &b);
+    nccell_fg_rgb8(&faded, &fr, &fg, &fb);
+    CHECK(r * (maxiter - iter) / maxiter == fr);
+    CHECK(g * (maxiter - iter) / maxiter == fg);
+    CHECK(b * (maxiter - iter) / maxiter == fb);
+    nccell_bg_rgb8(&orig, &r, &g, &b);
+    nccell_bg_rgb8(&faded, &fr, &fg, &fb);
+    CHECK(r * (maxiter - iter) / maxiter == fr);
+    CHECK(g * (maxiter - iter) / maxiter == fg);
+    CHECK(b * (maxiter - iter) / maxiter == fb);
+    CHECK(orig.gcluster == faded.gcluster);
+    nccell_release(n_, &orig);
+    nccell_release(n_, &faded);
+    ncfadectx_free(nctx);
+    CHECK(0 == notcurses_render(nc_));
+  }
+
+  // palette-indexed planes are faded by rewriting the palette
+  SUBCASE("FadePalette") {
+    if(notcurses_canchangecolor(nc_)){
+      auto pal = ncpalette_new(nc_);
+      REQUIRE(nullptr != pal);
+      CHECK(0 == ncpalette_set(pal, 7, 0x804020));
+      CHECK(0 == ncpalette_use(nc_, pal));
+      ncpalette_free(pal);
+      struct ncplane_options nopts{};
+      nopts.rows = 2;
+      nopts.cols = 2;
+      auto p = ncplane_create(n_, &nopts);
+      REQUIRE(nullptr != p);
+      CHECK(0 == ncplane_set_fg_palindex(p, 7));
+      CHECK(0 < ncplane_putstr(p, "ab"));
+      nccell orig = NCCELL_TRIVIAL_INITIALIZER;
+      REQUIRE(0 < ncplane_at_yx_cell(p, 0, 0, &orig));
+      auto nctx = ncfadectx_setup(p);
+      REQUIRE(nctx);
+      auto maxiter = ncfadectx_iterations(nctx);
+      CHECK(0x80 == maxiter);
+      CHECK(0 < ncplane_fadeout_iteration(p, nctx, maxiter / 2, fadeaborter, nullptr));
+      nccell faded = NCCELL_TRIVIAL_INITIALIZER;
+      REQUIRE(0 < ncplane_at_yx_cell(p, 0, 0, &faded));
+      CHECK(orig.channels == faded.channels);
+      CHECK(0x402010 == ncchannel_rgb(nc_->palette.chans[7]));
+      CHECK(nc_->palette_damage[7]);
+      CHECK(0 < ncplane_fadein_iteration(p, nctx, maxiter, fadeaborter, nullptr));
+      CHECK(0x804020 == ncchannel_rgb(nc_->palette.chans[7]));
+      nccell_release(p, &orig);
+      nccell_release(p, &faded);
+      ncfadectx_free(nctx);
+      CHECK(0 == ncplane_destroy(p));
+      CHECK(0 == notcurses_render(nc_));
+    }
+  }
+
   SUBCASE("FadeInFlexibleAbort") {
     auto nctx = ncfadectx_setup(n_);
     REQUIRE(nctx);
@@ -152,6 +218,39 @@ TEST_CASE("Fade") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // effects are only advanced from within notcurses_get(), so here we just
+  // check registration, replacement, and cancellation
+  SUBCASE("Animate") {
+    struct ncplane_options nopts{};
+    nopts.rows = 2;
+    nopts.cols = 4;
+    auto p = ncplane_create(n_, &nopts);
+    REQUIRE(p);
+    ncanim_options aopts{};
+    aopts.durationns = 500000000ull;
+    aopts.y = 1;
+    aopts.x = 1;
+    CHECK(0 == ncplane_animate(p, NCANIM_MOVE, &aopts));
+    CHECK(0 == ncplane_animate(p, NCANIM_MOVE, &aopts)); // replaces the first
+    aopts.channels = NCCHANNELS_INITIALIZER(0xff, 0, 0, 0, 0, 0xff);
+    CHECK(0 == ncplane_animate(p, NCANIM_TWEEN, &aopts));
+    CHECK(0 == ncplane_animate(p, NCANIM_PULSE, &aopts));
+    CHECK(0 == ncplane_animate(p, NCANIM_FADEOUT, &aopts)); // replaces the pulse
+    CHECK(3 == ncplane_animate_cancel(p));
+    CHECK(0 == ncplane_animate_cancel(p));
+    aopts.rows = 0;
+    CHECK(0 > ncplane_animate(p, NCANIM_RESIZE, &aopts));
+    CHECK(0 > ncplane_animate(n_, NCANIM_MOVE, &aopts));
+    aopts.durationns = 0;
+    CHECK(0 > ncplane_animate(p, NCANIM_PULSE, &aopts));
+    CHECK(0 > notcurses_set_animation_fps(nc_, 0));
+    CHECK(0 == notcurses_set_animation_fps(nc_, 30));
+    // effects go away along with their plane
+    CHECK(0 == ncplane_animate(p, NCANIM_FADEIN, &aopts));
+    CHECK(0 == ncplane_destroy(p));
+    CHECK(0 == notcurses_render(nc_));
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
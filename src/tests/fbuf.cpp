@@ -1,5 +1,7 @@
 #include "main.h"
 #include "lib/fbuf.h"
+#include <string>
+#include <climits>
 
 TEST_CASE("Fbuf") {
   auto nc_ = testing_notcurses();
@@ -80,5 +82,153 @@ TEST_CASE("Fbuf") {
     fbuf_free(&f);
   }
 
+#ifndef __MINGW32__
+  // gather several buffers through a pipe, and read them back in order
+  SUBCASE("BlockingWritev") {
+    int fds[2];
+    REQUIRE(0 == pipe(fds));
+    char a[] = "abc", b[] = "", c[] = "defgh";
+    struct iovec iov[3] = {
+      { a, strlen(a) }, { b, strlen(b) }, { c, strlen(c) },
+    };
+    CHECK(0 == blocking_writev(fds[1], iov, 3));
+    char out[16] = {};
+    CHECK(8 == read(fds[0], out, sizeof(out)));
+    CHECK(0 == strcmp("abcdefgh", out));
+    close(fds[0]);
+    close(fds[1]);
+  }
+
+  // chunked writes split iovecs across writev(2)s, preserving order
+  SUBCASE("BlockingWritevChunked") {
+    int fds[2];
+    REQUIRE(0 == pipe(fds));
+    char a[] = "abcde", b[] = "", c[] = "fghijklm";
+    struct iovec iov[3] = {
+      { a, strlen(a) }, { b, strlen(b) }, { c, strlen(c) },
+    };
+    CHECK(0 == blocking_writev_chunked(fds[1], iov, 3, 3));
+    char out[16] = {};
+    CHECK(13 == read(fds[0], out, sizeof(out)));
+    CHECK(0 == strcmp("abcdefghijklm", out));
+    close(fds[0]);
+    close(fds[1]);
+  }
+
+  // large glyphs are referenced rather than copied while splicing
+  SUBCASE("RasterSplice") {
+    fbuf g{};
+    CHECK(0 == fbuf_init(&g));
+    std::string big(BUFSIZ * 2, 'x');
+    CHECK(0 <= fbuf_putn(&g, big.data(), big.size()));
+    auto r = &nc_->rstate;
+    fbuf_reset(&r->f);
+    r->splicecount = 0;
+    r->splicebytes = 0;
+    r->splicing = true;
+    CHECK(0 <= fbuf_puts(&r->f, "ab"));
+    CHECK(0 == raster_putglyph(nc_, &r->f, &g));
+    CHECK(2 == r->f.used);
+    CHECK(1 == r->splicecount);
+    CHECK(2 == r->splices[0].off);
+    CHECK(g.buf == r->splices[0].buf);
+    CHECK(big.size() == r->splicebytes);
+    // small glyphs, and other buffers, are always copied
+    fbuf small{};
+    CHECK(0 == fbuf_init(&small));
+    CHECK(0 <= fbuf_puts(&small, "cd"));
+    CHECK(0 == raster_putglyph(nc_, &r->f, &small));
+    CHECK(4 == r->f.used);
+    CHECK(1 == r->splicecount);
+    r->splicing = false;
+    CHECK(0 == raster_putglyph(nc_, &r->f, &g));
+    CHECK(4 + big.size() == r->f.used);
+    r->splicecount = 0;
+    r->splicebytes = 0;
+    fbuf_reset(&r->f);
+    fbuf_free(&small);
+    fbuf_free(&g);
+  }
+#endif
+
+  // integers are formatted without snprintf(); check the edges
+  SUBCASE("FbufPutInts") {
+    fbuf f{};
+    CHECK(0 == fbuf_init_small(&f));
+    CHECK(1 == fbuf_putint(&f, 0));
+    CHECK(2 == fbuf_putint(&f, -7));
+    CHECK(10 == fbuf_putint(&f, INT_MAX));
+    CHECK(11 == fbuf_putint(&f, INT_MIN));
+    CHECK(10 == fbuf_putuint(&f, -1));
+    CHECK(3 == fbuf_putuint(&f, 100));
+    std::string s(f.buf, f.used);
+    CHECK("0-72147483647-21474836484294967295100" == s);
+    fbuf_free(&f);
+  }
+
+  // freed large buffers are recycled by size class
+  SUBCASE("FbufPoolRecycle") {
+    fbufpool pool;
+    REQUIRE(0 == fbufpool_init(&pool));
+    fbuf f{};
+    CHECK(0 == fbufpool_get(&pool, &f, 0));
+    CHECK(1 == pool.misses);
+    CHECK(0 < fbuf_puts(&f, "recycle me"));
+    auto buf = f.buf;
+    auto size = f.size;
+    fbufpool_put(&pool, &f);
+    CHECK(nullptr == f.buf);
+    CHECK(0 == f.size);
+    CHECK(size == pool.bytes);
+    CHECK(0 == fbufpool_get(&pool, &f, 0));
+    CHECK(1 == pool.hits);
+    CHECK(buf == f.buf);
+    CHECK(size == f.size);
+    CHECK(0 == f.used);
+    CHECK(0 == pool.bytes);
+    // a retained buffer smaller than the hint isn't handed out
+    fbufpool_put(&pool, &f);
+    fbuf g{};
+    CHECK(0 == fbufpool_get(&pool, &g, size + 1));
+    CHECK(2 == pool.misses);
+    CHECK(size < g.size);
+    CHECK(size == pool.bytes);
+    auto gsize = g.size; // put() empties g
+    fbufpool_put(&pool, &g);
+    CHECK(size + gsize == pool.bytes);
+    // small buffers aren't pooled
+    fbuf small{};
+    CHECK(0 == fbuf_init_small(&small));
+    fbufpool_put(&pool, &small);
+    CHECK(nullptr == small.buf);
+    CHECK(size + gsize == pool.bytes);
+    // taking the larger buffer back debits exactly its size
+    CHECK(0 == fbufpool_get(&pool, &g, size + 1));
+    CHECK(gsize == g.size);
+    CHECK(size == pool.bytes);
+    fbufpool_put(&pool, &g);
+    // nor is anything, absent a pool
+    CHECK(0 == fbufpool_get(nullptr, &f, 0));
+    CHECK(nullptr != f.buf);
+    fbufpool_put(nullptr, &f);
+    CHECK(nullptr == f.buf);
+    fbufpool_destroy(&pool);
+  }
+
+  // lone SGRs are merged into one; anything else goes out as it stands
+  SUBCASE("MergedStyles") {
+    fbuf f{};
+    REQUIRE(0 == fbuf_init(&f));
+    const char* one[] = { "\x1b[22m", };
+    CHECK(0 == term_emit_styles(&f, one, 1));
+    const char* three[] = { "\x1b[22m", "\x1b[3m", "\x1b[4:3m", };
+    CHECK(0 == term_emit_styles(&f, three, 3));
+    const char* mixed[] = { "\x1b[1m", "\x1b(0", "\x1b[29m", };
+    CHECK(0 == term_emit_styles(&f, mixed, 3));
+    CHECK(std::string("\x1b[22m\x1b[22;3;4:3m\x1b(0\x1b[1;29m") ==
+          std::string(f.buf, f.used));
+    fbuf_free(&f);
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 }
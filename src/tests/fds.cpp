@@ -1,8 +1,10 @@
 #include "main.h"
 #include <cerrno>
 #include <mutex>
+#include <string>
 #include <cstring>
 #include <fcntl.h>
+#include <dirent.h>
 #include <unistd.h>
 #include <condition_variable>
 
@@ -45,6 +47,54 @@ auto testfdeofdestroys(struct ncfdplane* n, int fderrno, void* curry) -> int {
   return ret;
 }
 
+struct fdtally {
+  size_t bytes;
+  size_t maxchunk;
+  bool done;
+};
+
+auto tallyfdcb(struct ncfdplane* ncfd, const void* buf, size_t s, void* curry) -> int {
+  auto tally = static_cast<fdtally*>(curry);
+  pthread_mutex_lock(&lock);
+  tally->bytes += s;
+  if(s > tally->maxchunk){
+    tally->maxchunk = s;
+  }
+  pthread_mutex_unlock(&lock);
+  (void)ncfd;
+  (void)buf;
+  return 0;
+}
+
+auto tallyfdeof(struct ncfdplane* n, int fderrno, void* curry) -> int {
+  auto tally = static_cast<fdtally*>(curry);
+  pthread_mutex_lock(&lock);
+  tally->done = true;
+  pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&lock);
+  (void)n;
+  (void)fderrno;
+  return 0;
+}
+
+#ifdef __linux__
+static auto
+thread_count() -> int {
+  int count = 0;
+  DIR* d = opendir("/proc/self/task");
+  if(d){
+    struct dirent* de;
+    while( (de = readdir(d)) ){
+      if(de->d_name[0] != '.'){
+        ++count;
+      }
+    }
+    closedir(d);
+  }
+  return count;
+}
+#endif
+
 // test ncfdplanes and ncsubprocs
 TEST_CASE("FdsAndSubprocs"
           * doctest::description("Fdplanes and subprocedures")) {
@@ -95,6 +145,97 @@ TEST_CASE("FdsAndSubprocs"
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // a regular file delivered from a mapping, in chunks no larger than bufsize
+  SUBCASE("FdPlaneMappedFile") {
+    char tmpl[] = "/tmp/notcurses-fdplane-XXXXXX";
+    int fd = mkstemp(tmpl);
+    REQUIRE(0 <= fd);
+    unlink(tmpl);
+    std::string data(100000, 'x');
+    REQUIRE(static_cast<ssize_t>(data.size()) == write(fd, data.data(), data.size()));
+    REQUIRE(0 == lseek(fd, 0, SEEK_SET));
+    fdtally tally{};
+    ncfdplane_options opts{};
+    opts.curry = &tally;
+    opts.flags = NCFDPLANE_OPTION_MAPFILE;
+    opts.bufsize = 4096;
+    auto ncfdp = ncfdplane_create(n_, &opts, fd, tallyfdcb, tallyfdeof);
+    REQUIRE(ncfdp);
+    pthread_mutex_lock(&lock);
+    while(!tally.done){
+      pthread_cond_wait(&cond, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+    CHECK(data.size() == tally.bytes);
+    CHECK(4096 >= tally.maxchunk);
+    CHECK(0 == ncfdplane_destroy(ncfdp));
+  }
+
+  // many small writes to a pipe ought be batched by coalescing
+  SUBCASE("FdPlaneCoalesced") {
+    int pipes[2];
+    REQUIRE(0 == pipe(pipes));
+    fdtally tally{};
+    ncfdplane_options opts{};
+    opts.curry = &tally;
+    opts.coalesce_ms = 50;
+    auto ncfdp = ncfdplane_create(n_, &opts, pipes[0], tallyfdcb, tallyfdeof);
+    REQUIRE(ncfdp);
+    for(int i = 0 ; i < 100 ; ++i){
+      CHECK(4 == write(pipes[1], "line", 4));
+    }
+    close(pipes[1]);
+    pthread_mutex_lock(&lock);
+    while(!tally.done){
+      pthread_cond_wait(&cond, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+    CHECK(400 == tally.bytes);
+    CHECK(4 < tally.maxchunk);
+    CHECK(0 == ncfdplane_destroy(ncfdp));
+  }
+
+  // every ncfdplane is serviced by the same thread
+  SUBCASE("FdPlanesShareThread") {
+    constexpr int COUNT = 32;
+    int pipes[COUNT][2];
+    fdtally tallies[COUNT]{};
+    struct ncfdplane* ncfdps[COUNT];
+    for(int i = 0 ; i < COUNT ; ++i){
+      REQUIRE(0 == pipe(pipes[i]));
+    }
+#ifdef __linux__
+    int threads = 0;
+#endif
+    for(int i = 0 ; i < COUNT ; ++i){
+      ncfdplane_options opts{};
+      opts.curry = &tallies[i];
+      ncfdps[i] = ncfdplane_create(n_, &opts, pipes[i][0], tallyfdcb, tallyfdeof);
+      REQUIRE(ncfdps[i]);
+#ifdef __linux__
+      if(i == 0){
+        threads = thread_count();
+      }
+#endif
+    }
+#ifdef __linux__
+    CHECK(threads == thread_count());
+#endif
+    for(int i = 0 ; i < COUNT ; ++i){
+      CHECK(i + 1 == write(pipes[i][1], "0123456789012345678901234567890123", i + 1));
+      close(pipes[i][1]);
+    }
+    for(int i = 0 ; i < COUNT ; ++i){
+      pthread_mutex_lock(&lock);
+      while(!tallies[i].done){
+        pthread_cond_wait(&cond, &lock);
+      }
+      pthread_mutex_unlock(&lock);
+      CHECK(static_cast<size_t>(i + 1) == tallies[i].bytes);
+      CHECK(0 == ncfdplane_destroy(ncfdps[i]));
+    }
+  }
+
   /*
   SUBCASE("SubprocDestroyCmdExecFails") {
     char * const argv[] = { "/should-not-exist", nullptr, };
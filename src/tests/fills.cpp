@@ -112,6 +112,77 @@ TEST_CASE("Fills") {
     CHECK(0 == ncplane_destroy(pfn));
   }
 
+  // a span fill must find its way back up into concave regions
+  SUBCASE("PolyfillConcave") {
+    nccell c = NCCELL_CHAR_INITIALIZER('+');
+    struct ncplane_options nopts = {
+      .y = 0,
+      .x = 0,
+      .rows = 5,
+      .cols = 5,
+      .userptr = nullptr,
+      .name = nullptr,
+      .resizecb = nullptr,
+      .flags = 0,
+      .margin_b = 0, .margin_r = 0,
+    };
+    struct ncplane* pfn = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != pfn);
+    const char* walls[] = {
+      " # # ",
+      " # # ",
+      " # # ",
+      "   # ",
+      "#### ",
+    };
+    for(unsigned y = 0 ; y < 5 ; ++y){
+      CHECK(5 == ncplane_putstr_yx(pfn, y, 0, walls[y]));
+    }
+    CHECK(9 == ncplane_polyfill_yx(pfn, 0, 0, &c));
+    char* egc = ncplane_at_yx(pfn, 0, 2, nullptr, nullptr);
+    CHECK(0 == strcmp(egc, "+"));
+    free(egc);
+    egc = ncplane_at_yx(pfn, 0, 4, nullptr, nullptr);
+    CHECK(0 == strcmp(egc, " "));
+    free(egc);
+    CHECK(5 == ncplane_polyfill_yx(pfn, 0, 4, &c));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_destroy(pfn));
+  }
+
+  // targets and fills spilled to the egcpool (narrow, but more than 4 bytes)
+  SUBCASE("PolyfillPooledEGCs") {
+    const char* egc1 = "e\xcc\x81\xcc\x81";
+    const char* egc2 = "a\xcc\x8a\xcc\x8a";
+    struct ncplane_options nopts = {
+      .y = 0,
+      .x = 0,
+      .rows = 4,
+      .cols = 8,
+      .userptr = nullptr,
+      .name = nullptr,
+      .resizecb = nullptr,
+      .flags = 0,
+      .margin_b = 0, .margin_r = 0,
+    };
+    struct ncplane* pfn = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != pfn);
+    nccell c = NCCELL_TRIVIAL_INITIALIZER;
+    REQUIRE(0 < nccell_load(pfn, &c, egc1));
+    CHECK(32 == ncplane_polyfill_yx(pfn, 0, 0, &c));
+    nccell d = NCCELL_TRIVIAL_INITIALIZER;
+    REQUIRE(0 < nccell_load(pfn, &d, egc2));
+    CHECK(32 == ncplane_polyfill_yx(pfn, 3, 7, &d));
+    CHECK(0 == ncplane_polyfill_yx(pfn, 3, 7, &d));
+    char* egc = ncplane_at_yx(pfn, 2, 3, nullptr, nullptr);
+    CHECK(0 == strcmp(egc, egc2));
+    free(egc);
+    nccell_release(pfn, &c);
+    nccell_release(pfn, &d);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_destroy(pfn));
+  }
+
   SUBCASE("GradientMonochromatic") {
     uint64_t c = 0;
     ncchannels_set_fg_rgb(&c, 0x40f040);
@@ -282,6 +353,109 @@ TEST_CASE("Fills") {
     }
   }
 
+  // matrix, lut, and alpha transforms, which leave default and
+  // palette-indexed channels alone
+  SUBCASE("TransformChannels") {
+    // a plane of exactly 20 cells, so that whole-plane transforms count 20
+    struct ncplane_options nopts{};
+    nopts.rows = 1;
+    nopts.cols = 20;
+    auto p = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != p);
+    for(unsigned x = 0 ; x < 20 ; ++x){
+      CHECK(0 == ncplane_set_fg_rgb(p, 0x204080));
+      CHECK(0 == ncplane_set_bg_rgb(p, 0x102030));
+      if(x == 19){
+        ncplane_set_fg_default(p);
+        CHECK(0 == ncplane_set_bg_palindex(p, 3));
+      }
+      CHECK(1 == ncplane_putegc_yx(p, 0, x, "A", nullptr));
+    }
+    ncxform op{};
+    op.op = NCXFORM_MATRIX;
+    op.channels = NCXFORM_FG;
+    // swap red and blue, and add 16 to green
+    op.u.matrix[0][2] = 1;
+    op.u.matrix[1][1] = 1;
+    op.u.matrix[1][3] = 16;
+    op.u.matrix[2][0] = 1;
+    CHECK(20 == ncplane_transform_channels(p, 0, 0, 1, 20, &op));
+    nccell d = NCCELL_TRIVIAL_INITIALIZER;
+    for(unsigned x = 0 ; x < 19 ; ++x){
+      CHECK(1 == ncplane_at_yx_cell(p, 0, x, &d));
+      CHECK(0x805020 == nccell_fg_rgb(&d));
+      CHECK(0x102030 == nccell_bg_rgb(&d));
+      CHECK(htole('A') == d.gcluster);
+    }
+    CHECK(1 == ncplane_at_yx_cell(p, 0, 19, &d));
+    CHECK(nccell_fg_default_p(&d));
+    CHECK(nccell_bg_palindex_p(&d));
+    op.op = NCXFORM_LUT;
+    op.channels = 0;
+    for(unsigned i = 0 ; i < 256 ; ++i){
+      op.u.lut.r[i] = op.u.lut.g[i] = op.u.lut.b[i] = 255 - i;
+    }
+    CHECK(20 == ncplane_transform_channels(p, 0, 0, 0, 0, &op));
+    CHECK(1 == ncplane_at_yx_cell(p, 0, 0, &d));
+    CHECK(0x7fafdf == nccell_fg_rgb(&d));
+    CHECK(0xefdfcf == nccell_bg_rgb(&d));
+    op.op = NCXFORM_ALPHA;
+    op.channels = NCXFORM_BG;
+    op.u.alpha = NCALPHA_TRANSPARENT;
+    CHECK(20 == ncplane_transform_channels(p, 0, 0, 0, 0, &op));
+    CHECK(1 == ncplane_at_yx_cell(p, 0, 0, &d));
+    CHECK(NCALPHA_TRANSPARENT == nccell_bg_alpha(&d));
+    CHECK(NCALPHA_OPAQUE == nccell_fg_alpha(&d));
+    CHECK(0xefdfcf == nccell_bg_rgb(&d));
+    op.u.alpha = NCALPHA_HIGHCONTRAST;
+    CHECK(0 > ncplane_transform_channels(p, 0, 0, 0, 0, &op));
+    ncxform_greyscale(&op);
+    op.u.matrix[0][0] = 65;
+    CHECK(0 > ncplane_transform_channels(p, 0, 0, 0, 0, &op));
+    ncxform_greyscale(&op);
+    CHECK(20 == ncplane_transform_channels(p, 0, 0, 0, 0, &op));
+    CHECK(1 == ncplane_at_yx_cell(p, 0, 0, &d));
+    unsigned r, g, b;
+    nccell_fg_rgb8(&d, &r, &g, &b);
+    CHECK(r == g);
+    CHECK(g == b);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_destroy(p));
+  }
+
+  // per-cell channels and styles from arrays, with a wider stride
+  SUBCASE("Paint") {
+    for(unsigned y = 0 ; y < 4 ; ++y){
+      for(unsigned x = 0 ; x < 4 ; ++x){
+        CHECK(1 == ncplane_putegc_yx(n_, y, x, "A", nullptr));
+      }
+    }
+    uint64_t channels[3 * 4];
+    uint16_t styles[3 * 4];
+    for(unsigned i = 0 ; i < 3 * 4 ; ++i){
+      channels[i] = 0;
+      ncchannels_set_fg_rgb(&channels[i], i);
+      ncchannels_set_bg_rgb(&channels[i], 0x10000 * i);
+      styles[i] = i % 2 ? NCSTYLE_BOLD : NCSTYLE_ITALIC;
+    }
+    CHECK(6 == ncplane_paint(n_, 1, 1, 2, 3, channels, styles, 4));
+    CHECK(6 == ncplane_paint(n_, 1, 1, 2, 3, nullptr, nullptr, 0));
+    CHECK(-1 == ncplane_paint(n_, 1, 1, 0, 3, channels, nullptr, 0));
+    CHECK(-1 == ncplane_paint(n_, 1, 1, 2, 3, channels, nullptr, 2));
+    nccell d = NCCELL_TRIVIAL_INITIALIZER;
+    for(unsigned y = 0 ; y < 2 ; ++y){
+      for(unsigned x = 0 ; x < 3 ; ++x){
+        CHECK(1 == ncplane_at_yx_cell(n_, y + 1, x + 1, &d));
+        CHECK(channels[y * 4 + x] == d.channels);
+        CHECK(styles[y * 4 + x] == d.stylemask);
+        CHECK(htole('A') == d.gcluster);
+      }
+    }
+    CHECK(1 == ncplane_at_yx_cell(n_, 0, 0, &d));
+    CHECK(0 == d.stylemask);
+    CHECK(0 == notcurses_render(nc_));
+  }
+
   // test the single-cell (1x1) special case
   SUBCASE("GradientSingleCell") {
     CHECK(0 == ncplane_set_fg_rgb(n_, 0x444444));
@@ -324,6 +498,58 @@ TEST_CASE("Fills") {
     CHECK(chan2 == d.channels);
   }
 
+  // gradients are walked row by row; they must match the per-cell lerp
+  SUBCASE("GradientMatchesLerp") {
+    uint64_t ul = 0, ur = 0, bl = 0, br = 0;
+    ncchannels_set_fg_rgb(&ul, 0xff0000);
+    ncchannels_set_bg_rgb(&ul, 0x000000);
+    ncchannels_set_fg_rgb(&ur, 0x00ff00);
+    ncchannels_set_bg_rgb(&ur, 0x123456);
+    ncchannels_set_fg_rgb(&bl, 0x0000ff);
+    ncchannels_set_bg_rgb(&bl, 0xfedcba);
+    ncchannels_set_fg_rgb(&br, 0x7f7f7f);
+    ncchannels_set_bg_rgb(&br, 0xffffff);
+    const unsigned geoms[][2] = { { 2, 7 }, { 7, 2 }, { 5, 13 }, { 1, 9 }, { 9, 1 }, };
+    for(const auto& geom : geoms){
+      const unsigned ylen = geom[0], xlen = geom[1];
+      // single rows (columns) mustn't vary vertically (horizontally)
+      const uint64_t cur = xlen == 1 ? ul : ur;
+      const uint64_t cbl = ylen == 1 ? ul : bl;
+      const uint64_t cbr = ylen == 1 ? cur : xlen == 1 ? bl : br;
+      const int area = ylen * xlen;
+      CHECK(area == ncplane_gradient(n_, 0, 0, ylen, xlen, "x", 0,
+                                     ul, cur, cbl, cbr));
+      for(unsigned y = 0 ; y < ylen ; ++y){
+        for(unsigned x = 0 ; x < xlen ; ++x){
+          uint64_t expected = 0;
+          calc_gradient_channels(&expected, ul, cur, cbl, cbr, y, x, ylen, xlen);
+          CHECK(expected == ncplane_cell_ref_yx(n_, y, x)->channels);
+        }
+      }
+      CHECK(area == ncplane_stain(n_, 0, 0, ylen, xlen, cbr, cbl, cur, ul));
+      for(unsigned y = 0 ; y < ylen ; ++y){
+        for(unsigned x = 0 ; x < xlen ; ++x){
+          uint64_t expected = 0;
+          calc_gradient_channels(&expected, cbr, cbl, cur, ul, y, x, ylen, xlen);
+          CHECK(expected == ncplane_cell_ref_yx(n_, y, x)->channels);
+        }
+      }
+    }
+    if(notcurses_canutf8(nc_)){
+      const uint32_t hul = ncchannels_fchannel(ul), hur = ncchannels_fchannel(ur);
+      const uint32_t hll = ncchannels_fchannel(bl), hlr = ncchannels_fchannel(br);
+      CHECK(3 * 11 == ncplane_gradient2x1(n_, 0, 0, 3, 11, hul, hur, hll, hlr));
+      for(unsigned y = 0 ; y < 3 ; ++y){
+        for(unsigned x = 0 ; x < 11 ; ++x){
+          const nccell* c = ncplane_cell_ref_yx(n_, y, x);
+          CHECK(calc_gradient_channel(hul, hur, hll, hlr, y * 2, x, 6, 11) == nccell_fchannel(c));
+          CHECK(calc_gradient_channel(hul, hur, hll, hlr, y * 2 + 1, x, 6, 11) == nccell_bchannel(c));
+        }
+      }
+    }
+    CHECK(0 == notcurses_render(nc_));
+  }
+
   // Unlike a typical gradient, a high gradient ought be able to do a vertical
   // change in a single row (though not a single column).
   SUBCASE("HighGradient2Colors1Row") {
@@ -578,6 +804,29 @@ TEST_CASE("Fills") {
     CHECK(0 < ncplane_qrcode(n_, &sdimy, &sdimx, qr, strlen(qr)));
     CHECK(0 == notcurses_render(nc_));
   }
+
+  // a compiled QR code can be blitted repeatedly without reencoding
+  SUBCASE("QRCodeVisual") {
+    const char* qr = "a very simple qr code";
+    unsigned ver = 0;
+    auto ncv = ncvisual_from_qrcode(qr, strlen(qr), 40, 0xffffff, &ver);
+    REQUIRE(nullptr != ncv);
+    CHECK(0 < ver);
+    ncvgeom geom{};
+    CHECK(0 == ncvisual_geom(nullptr, ncv, nullptr, &geom));
+    CHECK(17 + 4 * ver == geom.pixy);
+    CHECK(17 + 4 * ver == geom.pixx);
+    for(int i = 0 ; i < 2 ; ++i){
+      struct ncvisual_options vopts{};
+      vopts.n = n_;
+      vopts.blitter = NCBLIT_2x1;
+      CHECK(n_ == ncvisual_blit(nc_, ncv, &vopts));
+      CHECK(0 == notcurses_render(nc_));
+    }
+    // too much data for the maximum version
+    CHECK(nullptr == ncvisual_from_qrcode(qr, strlen(qr), 1, 0xffffff, nullptr));
+    ncvisual_destroy(ncv);
+  }
 #endif
 
   CHECK(0 == notcurses_stop(nc_));
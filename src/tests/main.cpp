@@ -10,6 +10,9 @@
 
 const char* datadir = notcurses_data_dir();
 
+// render throughput baseline (see perf.cpp); perf tests are skipped if NULL
+const char* perf_baseline;
+
 // we define loglevel for any use of logging in internal header files.
 // note that this has no bearing on the library's true inner loglevel!
 ncloglevel_e loglevel;
@@ -50,13 +53,15 @@ handle_opts(const char** argv){
   // now that we've spun up one testing framework, switch to _SILENT unless
   // something else has been provided on the command line.
   loglevel = NCLOGLEVEL_SILENT;
-  bool inarg = false;
+  const char** inarg = nullptr;
   while(*argv){
     if(inarg){
-      datadir = strdup(*argv);
-      inarg = false;
+      *inarg = strdup(*argv);
+      inarg = nullptr;
     }else if(strcmp(*argv, "-p") == 0){
-      inarg = true;
+      inarg = &datadir;
+    }else if(strcmp(*argv, "-P") == 0){
+      inarg = &perf_baseline;
     }else if(strncmp(*argv, "-l", 2) == 0){ // just require -l
       char* eol;
       long ll = strtol(*argv + 2, &eol, 0);
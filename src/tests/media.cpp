@@ -54,6 +54,60 @@ TEST_CASE("Media") {
     ncvisual_destroy(ncv);
   }
 
+  // a reduced decode never drops below the requested bounds, nor exceeds
+  // the full-resolution decode
+  SUBCASE("LoadImageSized") {
+    auto full = ncvisual_from_file(find_data("changes.jpg").get());
+    REQUIRE(nullptr != full);
+    ncvgeom fg{}, sg{};
+    CHECK(0 == ncvisual_geom(nc_, full, nullptr, &fg));
+    auto sized = ncvisual_from_file_sized(find_data("changes.jpg").get(),
+                                          fg.pixy / 3, fg.pixx / 3);
+    REQUIRE(nullptr != sized);
+    CHECK(0 == ncvisual_geom(nc_, sized, nullptr, &sg));
+    CHECK(sg.pixy <= fg.pixy);
+    CHECK(sg.pixx <= fg.pixx);
+    CHECK(sg.pixy >= fg.pixy / 3);
+    CHECK(sg.pixx >= fg.pixx / 3);
+    ncvisual_destroy(sized);
+    ncvisual_destroy(full);
+  }
+
+  // every file is delivered exactly once, failures included
+  SUBCASE("LoadBatch") {
+    auto jpg = find_data("changes.jpg");
+    std::vector<const char*> files(8, jpg.get());
+    files[5] = "/dev/nonexistent.jpg";
+    struct ncvisual_batch_options bopts{};
+    bopts.pixy = 32;
+    bopts.pixx = 32;
+    auto b = ncvisual_from_files_async(files.data(), files.size(), &bopts);
+    REQUIRE(nullptr != b);
+    std::vector<int> seen(files.size());
+    unsigned idx;
+    ncvisual* ncv;
+    int r;
+    while((r = ncvisual_batch_next(b, &idx, &ncv, true)) == 1){
+      REQUIRE(idx < files.size());
+      ++seen[idx];
+      if(idx == 5){
+        CHECK(nullptr == ncv);
+      }else{
+        REQUIRE(nullptr != ncv);
+        ncvgeom geom{};
+        CHECK(0 == ncvisual_geom(nc_, ncv, nullptr, &geom));
+        CHECK(geom.pixy <= 32);
+        CHECK(geom.pixx <= 32);
+        ncvisual_destroy(ncv);
+      }
+    }
+    CHECK(-1 == r);
+    for(auto s : seen){
+      CHECK(1 == s);
+    }
+    ncvisual_batch_destroy(b);
+  }
+
   SUBCASE("LoadImageCreatePlane") {
     unsigned dimy, dimx;
     ncplane_dim_yx(ncp_, &dimy, &dimx);
@@ -90,6 +144,72 @@ TEST_CASE("Media") {
     ncvisual_destroy(ncv);
   }
 
+  // a single-frame loop is replayed from the cache on each wrap
+  SUBCASE("LoopCache") {
+    if(notcurses_canopen_videos(nc_)){
+      auto ncv = ncvisual_from_file(find_data("changes.jpg").get());
+      REQUIRE(ncv);
+      const unsigned pixy = ncv->pixy;
+      const unsigned pixx = ncv->pixx;
+      CHECK(0 == ncvisual_set_loopcache(ncv, 64u << 20u));
+      struct ncvisual_options opts{};
+      opts.scaling = NCSCALE_STRETCH;
+      opts.n = ncp_;
+      for(int i = 0 ; i < 3 ; ++i){
+        CHECK(1 == ncvisual_decode_loop(ncv));
+        CHECK(pixy == ncv->pixy);
+        CHECK(pixx == ncv->pixx);
+        CHECK(ncvisual_blit(nc_, ncv, &opts));
+        CHECK(0 == notcurses_render(nc_));
+      }
+      // releasing the cache returns us to decoding
+      CHECK(0 == ncvisual_set_loopcache(ncv, 0));
+      CHECK(ncvisual_blit(nc_, ncv, &opts));
+      CHECK(1 == ncvisual_decode_loop(ncv));
+      CHECK(pixy == ncv->pixy);
+      CHECK(ncvisual_blit(nc_, ncv, &opts));
+      CHECK(0 == notcurses_render(nc_));
+      ncvisual_destroy(ncv);
+    }
+  }
+
+  // seeking, both accurately and to keyframes, and back among cached frames
+  SUBCASE("SeekVideo") {
+    if(notcurses_canopen_videos(nc_)){
+      auto ncv = ncvisual_from_file(find_data("notcursesIII.mov").get());
+      REQUIRE(ncv);
+      struct ncvisual_options opts{};
+      opts.scaling = NCSCALE_STRETCH;
+      opts.n = ncp_;
+      uint64_t pos;
+      CHECK(0 == ncvisual_position(ncv, &pos));
+      CHECK(0 == ncvisual_seek(ncv, NANOSECS_IN_SEC, 0));
+      CHECK(0 == ncvisual_position(ncv, &pos));
+      CHECK(pos <= NANOSECS_IN_SEC);
+      CHECK(pos > NANOSECS_IN_SEC / 2);
+      CHECK(ncvisual_blit(nc_, ncv, &opts));
+      CHECK(0 == notcurses_render(nc_));
+      // back a little, probably served from the cache
+      CHECK(0 == ncvisual_seek(ncv, NANOSECS_IN_SEC * 3 / 4, 0));
+      uint64_t back;
+      CHECK(0 == ncvisual_position(ncv, &back));
+      CHECK(back < pos);
+      CHECK(ncvisual_blit(nc_, ncv, &opts));
+      CHECK(0 == notcurses_render(nc_));
+      // decoding continues from the frame sought
+      CHECK(0 == ncvisual_decode(ncv));
+      uint64_t next;
+      CHECK(0 == ncvisual_position(ncv, &next));
+      CHECK(next > back);
+      CHECK(0 == ncvisual_seek(ncv, NANOSECS_IN_SEC, NCVISUAL_SEEK_KEYFRAME));
+      CHECK(0 == ncvisual_position(ncv, &pos));
+      CHECK(pos <= NANOSECS_IN_SEC);
+      CHECK(ncvisual_blit(nc_, ncv, &opts));
+      CHECK(0 == notcurses_render(nc_));
+      ncvisual_destroy(ncv);
+    }
+  }
+
   SUBCASE("InflateImage") {
     unsigned dimy, dimx;
     ncplane_dim_yx(ncp_, &dimy, &dimx);
@@ -456,6 +456,22 @@ TEST_CASE("Metric") {
     CHECK(0 == notcurses_stop(nc_));
   }
 
+  // output neither depends upon nor changes the floating point environment,
+  // and rounds as %.2f would have (8.005 is just above it as a double, 1.115
+  // just below).
+  SUBCASE("RoundingMode") {
+    char buf[BUFSIZE];
+    REQUIRE(0 == fesetround(FE_UPWARD));
+    impericize_ncmetric(1001, 1000, buf, 0, 1000, '\0');
+    CHECK(FE_UPWARD == fegetround());
+    REQUIRE(0 == fesetround(FE_TONEAREST));
+    CHECK(!strcmp("1.00", buf));
+    impericize_ncmetric(8005, 1000, buf, 0, 1000, '\0');
+    CHECK(!strcmp("8.01", buf));
+    impericize_ncmetric(1115, 1000, buf, 0, 1000, '\0');
+    CHECK(!strcmp("1.11", buf));
+  }
+
   // inspired by #929
   SUBCASE("BigMult") {
     char qbuf[NCIPREFIXSTRLEN + 1];
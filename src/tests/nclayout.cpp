@@ -0,0 +1,102 @@
+#include "main.h"
+
+static std::string
+layout_row(struct ncplane* n, int y){
+  char* line = ncplane_contents(n, y, 0, 1, 0);
+  REQUIRE(line);
+  std::string s(line);
+  free(line);
+  return s;
+}
+
+// retained, incrementally rewrapped text
+TEST_CASE("NCLayout") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(n_);
+
+  const char str[] = "the quick brown fox jumps over the lazy dog\n\nsupercalifragilistic";
+
+  SUBCASE("Rows") {
+    auto l = nclayout_create(str);
+    REQUIRE(l);
+    CHECK(-1 == nclayout_rows(l, 0));
+    CHECK(8 == nclayout_rows(l, 10));
+    CHECK(5 == nclayout_rows(l, 20));
+    CHECK(8 == nclayout_rows(l, 10));
+    CHECK(3 == nclayout_rows(l, 80));
+    nclayout_destroy(l);
+  }
+
+  SUBCASE("Invalid") {
+    CHECK(nullptr == nclayout_create("bad \xff utf8"));
+    auto l = nclayout_create(nullptr);
+    REQUIRE(l);
+    CHECK(0 == nclayout_rows(l, 10));
+    CHECK(0 == nclayout_append(l, "fine"));
+    CHECK(0 > nclayout_append(l, " \xff"));
+    CHECK(1 == nclayout_rows(l, 10));
+    nclayout_destroy(l);
+  }
+
+  // appending continues the final paragraph, and wraps as if all at once
+  SUBCASE("Append") {
+    auto l = nclayout_create("the quick brown");
+    REQUIRE(l);
+    CHECK(2 == nclayout_rows(l, 10));
+    CHECK(0 == nclayout_append(l, " fox jumps over the lazy dog\n"));
+    CHECK(0 == nclayout_append(l, "\nsupercalifragilistic"));
+    auto whole = nclayout_create(str);
+    REQUIRE(whole);
+    for(unsigned cols = 1 ; cols < 50 ; ++cols){
+      CHECK(nclayout_rows(whole, cols) == nclayout_rows(l, cols));
+    }
+    nclayout_destroy(whole);
+    nclayout_destroy(l);
+  }
+
+  SUBCASE("Render") {
+    struct ncplane_options nopts{};
+    nopts.rows = 4;
+    nopts.cols = 10;
+    auto sp = ncplane_create(n_, &nopts);
+    REQUIRE(sp);
+    auto l = nclayout_create(str);
+    REQUIRE(l);
+    CHECK(4 == nclayout_render(l, sp, 0, 0, NCALIGN_LEFT));
+    CHECK("the quick" == layout_row(sp, 0));
+    CHECK("brown fox" == layout_row(sp, 1));
+    CHECK("jumps over" == layout_row(sp, 2));
+    CHECK("the lazy" == layout_row(sp, 3));
+    // scroll the viewport; rows past the end of the text are erased
+    CHECK(4 == nclayout_render(l, sp, 0, 4, NCALIGN_RIGHT));
+    CHECK("dog" == layout_row(sp, 0));
+    CHECK("" == layout_row(sp, 1));
+    CHECK("supercalif" == layout_row(sp, 2));
+    CHECK("ragilistic" == layout_row(sp, 3));
+    char* egc = ncplane_at_yx(sp, 0, 7, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "d"));
+    free(egc);
+    CHECK(2 == nclayout_render(l, sp, 0, 6, NCALIGN_LEFT));
+    CHECK("supercalif" == layout_row(sp, 0));
+    CHECK("ragilistic" == layout_row(sp, 1));
+    CHECK("" == layout_row(sp, 2));
+    CHECK("" == layout_row(sp, 3));
+    // resizing the plane rewraps
+    CHECK(0 == ncplane_resize_simple(sp, 4, 20));
+    CHECK(4 == nclayout_render(l, sp, 0, 0, NCALIGN_LEFT));
+    CHECK("the quick brown fox" == layout_row(sp, 0));
+    CHECK("jumps over the lazy" == layout_row(sp, 1));
+    CHECK("dog" == layout_row(sp, 2));
+    CHECK("" == layout_row(sp, 3));
+    CHECK(0 == notcurses_render(nc_));
+    nclayout_destroy(l);
+    CHECK(0 == ncplane_destroy(sp));
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
@@ -1,6 +1,8 @@
 #include <string>
 #include <cstdlib>
 #include <iostream>
+#include <atomic>
+#include <thread>
 #include "main.h"
 
 TEST_CASE("NotcursesBase") {
@@ -133,6 +135,170 @@ TEST_CASE("NotcursesBase") {
     CHECK(0 == stats.renders);
   }
 
+  // near-identical colors aren't emitted once a tolerance is set
+  SUBCASE("ColorTolerance"){
+    CHECK(0 > notcurses_set_color_tolerance(nc_, -1));
+    CHECK(0 > notcurses_set_color_tolerance(nc_, 101));
+    CHECK(0 == notcurses_set_color_tolerance(nc_, 2.3));
+    struct ncplane* n = notcurses_stdplane(nc_);
+    for(unsigned x = 0 ; x < 16 ; ++x){
+      CHECK(0 == ncplane_set_fg_rgb(n, x % 2 ? 0x818181 : 0x808080));
+      CHECK(1 == ncplane_putchar_yx(n, 0, x, 'x'));
+    }
+    CHECK(0 == notcurses_render(nc_));
+    struct ncstats stats;
+    notcurses_stats(nc_, &stats);
+    // each 0x818181 is approximated by the 0x808080 already set, which then
+    // remains set, so the 0x808080s which follow are exact matches
+    CHECK(8 == stats.approx_elisions);
+    CHECK(15 <= stats.fgelisions);
+    CHECK(0 == notcurses_set_color_tolerance(nc_, 0));
+  }
+
+  // snapshots taken while rendering proceeds are consistent, and don't
+  // go backwards
+  SUBCASE("StatsConcurrent"){
+    notcurses_stats_reset(nc_, nullptr);
+    std::atomic<bool> done{false};
+    bool sane = true;
+    std::thread poller([&]{
+      struct ncstats s;
+      uint64_t last = 0;
+      while(!done){
+        notcurses_stats(nc_, &s);
+        if(s.renders < last || s.render_ns < s.renders){
+          sane = false;
+        }
+        last = s.renders;
+      }
+    });
+    for(int i = 0 ; i < 50 ; ++i){
+      CHECK(0 == notcurses_render(nc_));
+    }
+    done = true;
+    poller.join();
+    CHECK(sane);
+    struct ncstats stats;
+    notcurses_stats(nc_, &stats);
+    CHECK(50 == stats.renders);
+  }
+
+  SUBCASE("StatsHistogram"){
+    notcurses_stats_reset(nc_, nullptr);
+    for(int i = 0 ; i < 10 ; ++i){
+      CHECK(0 == notcurses_render(nc_));
+    }
+    nchistogram h;
+    CHECK(0 == notcurses_stats_histogram(nc_, NCSTATS_HIST_RENDER, &h));
+    struct ncstats stats;
+    notcurses_stats(nc_, &stats);
+    CHECK(stats.renders == h.count);
+    if(h.count){
+      auto p50 = nchistogram_percentile(&h, 50);
+      auto p99 = nchistogram_percentile(&h, 99);
+      CHECK(p50 <= p99);
+      // buckets hold values within 1/16 of one another
+      CHECK(p99 + 1 >= (uint64_t)stats.render_max_ns);
+      CHECK(p99 <= (uint64_t)stats.render_max_ns + stats.render_max_ns / 16);
+    }
+    CHECK(0 == notcurses_stats_histogram(nc_, NCSTATS_HIST_INPUTWAIT, &h));
+    CHECK(0 > notcurses_stats_histogram(nc_, NCSTATS_HIST_COUNT, &h));
+    notcurses_stats_reset(nc_, nullptr);
+    CHECK(0 == notcurses_stats_histogram(nc_, NCSTATS_HIST_RENDER, &h));
+    CHECK(0 == h.count);
+  }
+
+  // a plane's memory shows up in its own report and in the context's
+  SUBCASE("MemoryReport"){
+    CHECK(0 == notcurses_render(nc_));
+    ncmemreport before;
+    notcurses_memory_report(nc_, &before);
+    CHECK(0 < before.fbbytes);
+    CHECK(0 < before.renderbytes);
+    CHECK(before.totalbytes >= before.fbbytes + before.renderbytes);
+    struct ncplane_options nopts{};
+    nopts.rows = 20;
+    nopts.cols = 40;
+    auto n = ncplane_create(notcurses_stdplane(nc_), &nopts);
+    REQUIRE(nullptr != n);
+    ncmemreport plane;
+    ncplane_memory_report(n, &plane);
+    CHECK(20 * 40 * sizeof(nccell) <= plane.fbbytes);
+    CHECK(0 == plane.renderbytes);
+    CHECK(plane.totalbytes == plane.fbbytes + plane.poolbytes);
+    ncmemreport after;
+    notcurses_memory_report(nc_, &after);
+    CHECK(after.fbbytes == before.fbbytes + plane.fbbytes);
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  SUBCASE("Profile"){
+    auto fp = tmpfile();
+    REQUIRE(nullptr != fp);
+    CHECK(0 > notcurses_profile_dump(nc_, fp));
+    CHECK(0 == notcurses_profile(nc_, true));
+    struct ncplane_options nopts{};
+    nopts.rows = 2;
+    nopts.cols = 2;
+    nopts.name = "profiled";
+    auto n = ncplane_create(notcurses_stdplane(nc_), &nopts);
+    REQUIRE(nullptr != n);
+    CHECK(0 < ncplane_putstr(n, "hi"));
+    CHECK(0 == notcurses_render(nc_));
+    nopts.name = "retired";
+    auto r = ncplane_create(notcurses_stdplane(nc_), &nopts);
+    REQUIRE(nullptr != r);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_destroy(r));
+    CHECK(0 == notcurses_profile_dump(nc_, fp));
+    rewind(fp);
+    std::string dump;
+    char buf[BUFSIZ];
+    size_t got;
+    while((got = fread(buf, 1, sizeof(buf), fp)) > 0){
+      dump.append(buf, got);
+    }
+    CHECK(std::string::npos != dump.find("postpaint"));
+    CHECK(std::string::npos != dump.find("profiled"));
+    CHECK(std::string::npos != dump.find("retired"));
+    CHECK(0 == notcurses_profile(nc_, false));
+    CHECK(0 == ncplane_destroy(n));
+    fclose(fp);
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+
+}
+
+// with NCOPTION_ASYNC_INIT, the terminal's replies are applied upon the first
+// render, which ought arrive at the capabilities of a synchronous init.
+TEST_CASE("AsyncInit") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  const nccapabilities sync = *notcurses_capabilities(nc_);
+  auto syncpixel = notcurses_check_pixel_support(nc_);
   CHECK(0 == notcurses_stop(nc_));
+  notcurses_options nopts{};
+  nopts.loglevel = loglevel;
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS
+                | NCOPTION_NO_ALTERNATE_SCREEN
+                | NCOPTION_DRAIN_INPUT
+                | NCOPTION_ASYNC_INIT;
+  auto nc = notcurses_init(&nopts, nullptr);
+  REQUIRE(nullptr != nc);
+  CHECK(0 < ncplane_putstr_yx(notcurses_stdplane(nc), 0, 0, "async"));
+  CHECK(0 == notcurses_render(nc));
+  const nccapabilities* async = notcurses_capabilities(nc);
+  CHECK(sync.rgb == async->rgb);
+  CHECK(sync.colors == async->colors);
+  CHECK(sync.can_change_colors == async->can_change_colors);
+  CHECK(syncpixel == notcurses_check_pixel_support(nc));
+  CHECK(0 == notcurses_stop(nc));
 
+  // stopping without ever rendering must still collect the replies
+  nc = notcurses_init(&nopts, nullptr);
+  REQUIRE(nullptr != nc);
+  CHECK(0 == notcurses_stop(nc));
 }
@@ -106,3 +106,27 @@ TEST_CASE("Palette") {
   // common teardown
   CHECK(0 == notcurses_stop(nc_));
 }
+
+// NCOPTION_ADAPTIVE_PALETTE only changes anything without RGB, but ought be
+// accepted (and render more colors than there are palette entries) anywhere.
+TEST_CASE("AdaptivePalette") {
+  notcurses_options nopts{};
+  nopts.loglevel = loglevel;
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS
+                | NCOPTION_NO_ALTERNATE_SCREEN
+                | NCOPTION_DRAIN_INPUT
+                | NCOPTION_ADAPTIVE_PALETTE;
+  auto nc = notcurses_init(&nopts, nullptr);
+  if(!nc){
+    return;
+  }
+  auto n = notcurses_stdplane(nc);
+  unsigned dimy, dimx;
+  ncplane_dim_yx(n, &dimy, &dimx);
+  for(unsigned i = 0 ; i < 512 && i / dimx < dimy ; ++i){
+    CHECK(0 == ncplane_set_bg_rgb8(n, i % 256, (i * 7) % 256, 255 - i % 256));
+    CHECK(0 < ncplane_putchar_yx(n, i / dimx, i % dimx, ' '));
+  }
+  CHECK(0 == notcurses_render(nc));
+  CHECK(0 == notcurses_stop(nc));
+}
@@ -0,0 +1,409 @@
+#include "main.h"
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// Render throughput regression tests. These only run when a baseline file
+// has been supplied with -P. A scenario missing from the baseline has its
+// results appended to it; otherwise, a scenario fails if it has gotten more
+// than PERF_NS_SLACK slower per frame, or emits more than PERF_BYTES_SLACK
+// more bytes per frame. Baselines are specific to a machine and TERM.
+
+extern const char* perf_baseline;
+
+static constexpr double PERF_NS_SLACK = 1.5;
+static constexpr double PERF_BYTES_SLACK = 1.1;
+static constexpr uint64_t PERF_NS_FLOOR = 20000; // ignore per-frame noise below 20us
+static constexpr int PERF_FRAMES = 120;
+static constexpr int PERF_REPEATS = 3;
+
+struct perf_result {
+  uint64_t render_ns;    // per frame
+  uint64_t raster_ns;    // per frame
+  uint64_t raster_bytes; // per frame
+};
+
+// open a memory-backed (where possible) output, so that timings reflect
+// rendering and rasterization, and not the terminal.
+static auto
+perf_output() -> FILE* {
+#ifdef __linux__
+  int fd = memfd_create("notcurses-perf", MFD_CLOEXEC);
+  if(fd >= 0){
+    FILE* fp = fdopen(fd, "w");
+    if(fp){
+      return fp;
+    }
+    close(fd);
+  }
+#endif
+  return tmpfile();
+}
+
+static auto
+perf_notcurses(FILE* fp, uint64_t flags) -> struct notcurses* {
+  notcurses_options nopts{};
+  nopts.loglevel = NCLOGLEVEL_SILENT;
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS
+                | NCOPTION_NO_ALTERNATE_SCREEN
+                | NCOPTION_NO_QUIT_SIGHANDLERS
+                | NCOPTION_DRAIN_INPUT
+                | flags;
+  return notcurses_init(&nopts, fp);
+}
+
+// run 'frames' frames of 'step' atop a fresh context, PERF_REPEATS times,
+// keeping the best per-frame figures of any run.
+static auto
+perf_run(uint64_t flags, const std::function<int(struct notcurses*, int)>& setup,
+         const std::function<int(struct notcurses*, int)>& step) -> perf_result {
+  perf_result best{UINT64_MAX, UINT64_MAX, UINT64_MAX};
+  for(int r = 0 ; r < PERF_REPEATS ; ++r){
+    FILE* fp = perf_output();
+    REQUIRE(fp);
+    auto nc = perf_notcurses(fp, flags);
+    REQUIRE(nc);
+    REQUIRE(0 == setup(nc, 0));
+    CHECK(0 == notcurses_render(nc));
+    notcurses_stats_reset(nc, nullptr);
+    for(int f = 0 ; f < PERF_FRAMES ; ++f){
+      REQUIRE(0 == step(nc, f));
+    }
+    ncstats stats;
+    notcurses_stats(nc, &stats);
+    CHECK(0 == stats.failed_renders);
+    CHECK(0 == stats.failed_writeouts);
+    CHECK(0 == notcurses_stop(nc));
+    fclose(fp);
+    REQUIRE(stats.renders);
+    best.render_ns = std::min(best.render_ns, stats.render_ns / stats.renders);
+    if(stats.writeouts){
+      best.raster_ns = std::min(best.raster_ns, stats.raster_ns / stats.writeouts);
+      best.raster_bytes = std::min(best.raster_bytes, stats.raster_bytes / stats.writeouts);
+    }else{
+      best.raster_ns = best.raster_bytes = 0;
+    }
+  }
+  return best;
+}
+
+static std::mutex perf_lock;
+
+// compare 'res' against the baseline entry for 'name', or record it there
+static void
+perf_check(const std::string& name, const perf_result& res) {
+  std::lock_guard<std::mutex> lock(perf_lock);
+  MESSAGE(name << ": render " << res.render_ns << "ns raster " << res.raster_ns
+          << "ns " << res.raster_bytes << "B per frame");
+  std::map<std::string, perf_result> base;
+  std::ifstream in(perf_baseline);
+  std::string line;
+  while(std::getline(in, line)){
+    std::istringstream ss(line);
+    std::string n;
+    perf_result p;
+    if(line.empty() || line[0] == '#'){
+      continue;
+    }
+    if(ss >> n >> p.render_ns >> p.raster_ns >> p.raster_bytes){
+      base[n] = p;
+    }
+  }
+  in.close();
+  auto b = base.find(name);
+  if(b == base.end()){
+    std::ofstream out(perf_baseline, std::ios::app);
+    REQUIRE(out);
+    if(base.empty()){
+      out << "# scenario render_ns raster_ns raster_bytes (per frame)\n";
+    }
+    out << name << ' ' << res.render_ns << ' ' << res.raster_ns << ' '
+        << res.raster_bytes << '\n';
+    MESSAGE("recorded baseline for " << name);
+    return;
+  }
+  auto nslimit = [](uint64_t was){
+    return std::max<uint64_t>(was * PERF_NS_SLACK, was + PERF_NS_FLOOR);
+  };
+  CHECK(res.render_ns <= nslimit(b->second.render_ns));
+  CHECK(res.raster_ns <= nslimit(b->second.raster_ns));
+  CHECK(res.raster_bytes <= b->second.raster_bytes * PERF_BYTES_SLACK + 64);
+}
+
+// a full-plane gradient whose corners rotate with each frame
+static int
+perf_fill(struct ncplane* n, int f) {
+  uint64_t ul = NCCHANNELS_INITIALIZER(0xff, (f * 7) % 256, 0, (f * 3) % 256, 0x20, 0x40);
+  uint64_t ur = NCCHANNELS_INITIALIZER(0, 0xff, (f * 5) % 256, 0x40, (f * 11) % 256, 0);
+  uint64_t ll = NCCHANNELS_INITIALIZER((f * 13) % 256, 0, 0xff, 0, 0x80, (f * 2) % 256);
+  uint64_t lr = NCCHANNELS_INITIALIZER(0x80, 0x80, (f * 17) % 256, (f * 19) % 256, 0, 0x80);
+  ncplane_home(n);
+  return ncplane_gradient(n, -1, -1, 0, 0, "▄", 0, ul, ur, ll, lr) < 0 ? -1 : 0;
+}
+
+TEST_CASE("Perf" * doctest::test_suite("perf")) {
+  if(!perf_baseline){
+    return;
+  }
+
+  // fills of the entire standard plane, rendered as a single band
+  SUBCASE("Fills") {
+    auto res = perf_run(0,
+      [](struct notcurses*, int){ return 0; },
+      [](struct notcurses* nc, int f){
+        if(perf_fill(notcurses_stdplane(nc), f)){
+          return -1;
+        }
+        return notcurses_render(nc);
+      });
+    perf_check("fills", res);
+  }
+
+  // the same fills, painted in parallel bands
+  SUBCASE("FillsThreaded") {
+    auto res = perf_run(NCOPTION_THREADED_RENDER,
+      [](struct notcurses*, int){ return 0; },
+      [](struct notcurses* nc, int f){
+        if(perf_fill(notcurses_stdplane(nc), f)){
+          return -1;
+        }
+        return notcurses_render(nc);
+      });
+    perf_check("fills-threaded", res);
+  }
+
+  // several piles rendered concurrently, one thread apiece, each then
+  // rasterized in turn
+  SUBCASE("ParallelPiles") {
+    static std::vector<struct ncplane*> piles;
+    auto res = perf_run(0,
+      [](struct notcurses* nc, int){
+        piles.clear();
+        unsigned dimy, dimx;
+        notcurses_stddim_yx(nc, &dimy, &dimx);
+        unsigned count = std::max(2u, std::min(8u, std::thread::hardware_concurrency()));
+        for(unsigned i = 0 ; i < count ; ++i){
+          struct ncplane_options nopts{};
+          nopts.rows = dimy;
+          nopts.cols = dimx;
+          auto p = ncpile_create(nc, &nopts);
+          if(!p){
+            return -1;
+          }
+          piles.push_back(p);
+        }
+        return 0;
+      },
+      [](struct notcurses*, int f){
+        std::vector<std::thread> threads;
+        std::vector<int> rets(piles.size());
+        for(size_t i = 0 ; i < piles.size() ; ++i){
+          threads.emplace_back([f, i, &rets](){
+            rets[i] = perf_fill(piles[i], f + static_cast<int>(i)) ? -1 : ncpile_render(piles[i]);
+          });
+        }
+        for(auto& t : threads){
+          t.join();
+        }
+        for(size_t i = 0 ; i < piles.size() ; ++i){
+          if(rets[i] || ncpile_rasterize(piles[i])){
+            return -1;
+          }
+        }
+        return 0;
+      });
+    perf_check("parallel-piles", res);
+  }
+
+  // wide glyphs repeatedly stomped by narrow ones and vice versa, both on
+  // the plane and across plane boundaries
+  SUBCASE("WideStomps") {
+    static struct ncplane* top;
+    auto res = perf_run(0,
+      [](struct notcurses* nc, int){
+        struct ncplane_options nopts{};
+        nopts.rows = 8;
+        nopts.cols = 16;
+        top = ncplane_create(notcurses_stdplane(nc), &nopts);
+        return top ? 0 : -1;
+      },
+      [](struct notcurses* nc, int f){
+        auto n = notcurses_stdplane(nc);
+        unsigned dimy, dimx;
+        ncplane_dim_yx(n, &dimy, &dimx);
+        for(unsigned y = 0 ; y < dimy ; ++y){
+          // offset odd frames by a column, so each wide glyph is stomped
+          ncplane_cursor_move_yx(n, y, f % 2);
+          while(ncplane_putstr(n, (y + f) % 2 ? "\U0001F40D" : "全") > 0){
+          }
+          ncplane_putchar_yx(n, y, (f * 3 + y) % dimx, 'x');
+        }
+        ncplane_move_yx(top, (f * 2) % (dimy - 8), (f * 3) % (dimx - 16));
+        return notcurses_render(nc);
+      });
+    perf_check("wide-stomps", res);
+  }
+
+  // a scrolling plane filled one line per frame
+  SUBCASE("Scrolling") {
+    auto res = perf_run(0,
+      [](struct notcurses* nc, int){
+        ncplane_set_scrolling(notcurses_stdplane(nc), true);
+        return 0;
+      },
+      [](struct notcurses* nc, int f){
+        auto n = notcurses_stdplane(nc);
+        ncplane_set_fg_rgb8(n, (f * 7) % 256, 0x80, (f * 13) % 256);
+        if(ncplane_printf(n, "%06d the quick brown fox jumps over the lazy dog %x\n",
+                          f, f * 0x9e3779b9u) < 0){
+          return -1;
+        }
+        return notcurses_render(nc);
+      });
+    perf_check("scrolling", res);
+  }
+
+  // fills beneath a stack of translucent full-screen planes, so that each
+  // cell is blended through every plane; this is bound by how much of the
+  // crender vector the paint loop must stream through.
+  SUBCASE("TranslucentStack") {
+    auto res = perf_run(0,
+      [](struct notcurses* nc, int){
+        unsigned dimy, dimx;
+        notcurses_stddim_yx(nc, &dimy, &dimx);
+        for(int i = 0 ; i < 6 ; ++i){
+          struct ncplane_options nopts{};
+          nopts.rows = dimy;
+          nopts.cols = dimx;
+          auto n = ncplane_create(notcurses_stdplane(nc), &nopts);
+          if(!n){
+            return -1;
+          }
+          uint64_t channels = 0;
+          ncchannels_set_bg_rgb8(&channels, 0x20 * i, 0x10, 0xff - 0x20 * i);
+          ncchannels_set_bg_alpha(&channels, NCALPHA_BLEND);
+          ncchannels_set_fg_alpha(&channels, NCALPHA_TRANSPARENT);
+          if(ncplane_set_base(n, "", 0, channels) < 0){
+            return -1;
+          }
+        }
+        return 0;
+      },
+      [](struct notcurses* nc, int f){
+        if(perf_fill(notcurses_stdplane(nc), f)){
+          return -1;
+        }
+        return notcurses_render(nc);
+      });
+    perf_check("translucent-stack", res);
+  }
+
+  // a bitmap repeatedly wiped and restored by a plane sliding across it.
+  // without pixel support, the best cell blitter stands in.
+  SUBCASE("BitmapWipes") {
+    static struct ncplane* bmap;
+    static struct ncplane* slider;
+    static bool pixel;
+    auto res = perf_run(0,
+      [](struct notcurses* nc, int){
+        const int y = 240;
+        const int x = 320;
+        std::vector<uint32_t> v(x * y);
+        for(int i = 0 ; i < y * x ; ++i){
+          v[i] = htole(0xff000000u | ((i % x) * 0xffu / x) << 8 | (i / x) * 0xffu / y);
+        }
+        auto ncv = ncvisual_from_rgba(v.data(), y, sizeof(decltype(v)::value_type) * x, x);
+        if(!ncv){
+          return -1;
+        }
+        struct ncvisual_options vopts{};
+        vopts.n = notcurses_stdplane(nc);
+        pixel = notcurses_canpixel(nc);
+        vopts.blitter = pixel ? NCBLIT_PIXEL : NCBLIT_DEFAULT;
+        vopts.scaling = NCSCALE_STRETCH;
+        vopts.flags = NCVISUAL_OPTION_CHILDPLANE;
+        bmap = ncvisual_blit(nc, ncv, &vopts);
+        ncvisual_destroy(ncv);
+        if(!bmap){
+          return -1;
+        }
+        struct ncplane_options nopts{};
+        nopts.rows = 4;
+        nopts.cols = 10;
+        slider = ncplane_create(notcurses_stdplane(nc), &nopts);
+        if(!slider){
+          return -1;
+        }
+        uint64_t channels = NCCHANNELS_INITIALIZER(0xff, 0xff, 0xff, 0x20, 0x20, 0x20);
+        return ncplane_set_base(slider, " ", 0, channels) < 0 ? -1 : 0;
+      },
+      [](struct notcurses* nc, int f){
+        unsigned dimy, dimx;
+        ncplane_dim_yx(bmap, &dimy, &dimx);
+        ncplane_move_yx(slider, (f / 2) % (dimy > 4 ? dimy - 4 : 1),
+                        (f * 3) % (dimx > 10 ? dimx - 10 : 1));
+        return notcurses_render(nc);
+      });
+    perf_check(pixel ? "bitmap-wipes-pixel" : "bitmap-wipes", res);
+  }
+
+  // the screen tiled with small bitmaps over a changing fill, so that most
+  // cells lie beneath one of many sprixels, and are looked up while
+  // postpainting and rasterizing. without pixel support, the best cell
+  // blitter stands in.
+  SUBCASE("SprixelTiles") {
+    static bool pixel;
+    auto res = perf_run(0,
+      [](struct notcurses* nc, int){
+        const int y = 32;
+        const int x = 32;
+        std::vector<uint32_t> v(x * y);
+        for(int i = 0 ; i < y * x ; ++i){
+          // every other pixel transparent, so the fill beneath shows through
+          v[i] = i % 2 ? 0 : htole(0xff000000u | (i % x) * 8 << 16 | (i / x) * 8);
+        }
+        auto ncv = ncvisual_from_rgba(v.data(), y, sizeof(decltype(v)::value_type) * x, x);
+        if(!ncv){
+          return -1;
+        }
+        pixel = notcurses_canpixel(nc);
+        unsigned dimy, dimx;
+        ncplane_dim_yx(notcurses_stdplane(nc), &dimy, &dimx);
+        for(unsigned ty = 0 ; ty + 4 <= dimy ; ty += 4){
+          for(unsigned tx = 0 ; tx + 8 <= dimx ; tx += 8){
+            struct ncplane_options nopts{};
+            nopts.y = ty;
+            nopts.x = tx;
+            nopts.rows = 4;
+            nopts.cols = 8;
+            struct ncvisual_options vopts{};
+            vopts.n = ncplane_create(notcurses_stdplane(nc), &nopts);
+            vopts.blitter = pixel ? NCBLIT_PIXEL : NCBLIT_DEFAULT;
+            vopts.scaling = NCSCALE_STRETCH;
+            if(!vopts.n || !ncvisual_blit(nc, ncv, &vopts)){
+              ncvisual_destroy(ncv);
+              return -1;
+            }
+          }
+        }
+        ncvisual_destroy(ncv);
+        return 0;
+      },
+      [](struct notcurses* nc, int f){
+        if(perf_fill(notcurses_stdplane(nc), f)){
+          return -1;
+        }
+        return notcurses_render(nc);
+      });
+    perf_check(pixel ? "sprixel-tiles-pixel" : "sprixel-tiles", res);
+  }
+}
@@ -1,4 +1,6 @@
 #include "main.h"
+#include <thread>
+#include <string>
 
 TEST_CASE("Piles") {
   auto nc_ = testing_notcurses();
@@ -304,6 +306,367 @@ TEST_CASE("Piles") {
     ncplane_destroy(gen3);
   }
 
+  // two piles, each bound to its own rasterizer, rasterized concurrently.
+  // an unchanged pile ought produce a much smaller second frame.
+  // moves and resize callbacks within a transaction are applied at commit
+  SUBCASE("Transaction") {
+    struct ncplane_options nopts = {
+      .y = 10,
+      .x = 10,
+      .rows = 2,
+      .cols = 2,
+      .userptr = nullptr, .name = nullptr, .resizecb = nullptr, .flags = 0,
+      .margin_b = 0, .margin_r = 0,
+    };
+    auto gen1 = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != gen1);
+    static int resizes;
+    resizes = 0;
+    nopts.resizecb = [](ncplane*) -> int { ++resizes; return 0; };
+    auto gen2 = ncplane_create(gen1, &nopts);
+    REQUIRE(nullptr != gen2);
+    CHECK(0 == ncpile_begin_update(gen1));
+    CHECK(0 == ncplane_move_yx(gen1, 5, 5));
+    CHECK(0 == ncplane_move_yx(gen2, 1, 1));
+    for(unsigned i = 0 ; i < 3 ; ++i){
+      CHECK(0 == ncplane_resize_simple(gen1, 3 + i, 3 + i));
+    }
+    // positions are reported as requested, but not yet applied
+    CHECK(5 == ncplane_y(gen1));
+    CHECK(1 == ncplane_x(gen2));
+    CHECK(10 == ncplane_abs_y(gen1));
+    CHECK(20 == ncplane_abs_y(gen2));
+    CHECK(0 == resizes);
+    // nested transactions apply only at the outermost commit
+    CHECK(0 == ncpile_begin_update(n_));
+    CHECK(0 == ncpile_commit(n_));
+    CHECK(10 == ncplane_abs_y(gen1));
+    CHECK(0 == ncpile_commit(gen2));
+    CHECK(1 == resizes);
+    CHECK(5 == ncplane_abs_y(gen1));
+    CHECK(5 == ncplane_abs_x(gen1));
+    CHECK(6 == ncplane_abs_y(gen2));
+    CHECK(6 == ncplane_abs_x(gen2));
+    CHECK(1 == ncplane_y(gen2));
+    CHECK(-1 == ncpile_commit(n_));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_destroy(gen2));
+    CHECK(0 == ncplane_destroy(gen1));
+  }
+
+  SUBCASE("ParallelRasterizers") {
+    struct ncplane_options nopts{};
+    nopts.rows = dimy;
+    nopts.cols = dimx;
+    struct ncplane* piles[2];
+    struct ncrasterizer* rs[2];
+    for(int i = 0 ; i < 2 ; ++i){
+      piles[i] = ncpile_create(nc_, &nopts);
+      REQUIRE(nullptr != piles[i]);
+      CHECK(0 < ncplane_putstr_yx(piles[i], 0, 0, i ? "second" : "first"));
+      CHECK(0 == ncplane_set_fg_rgb(piles[i], 0x40 * (i + 1)));
+      CHECK(0 < ncplane_putstr_yx(piles[i], 1, 1, "pile"));
+      rs[i] = ncrasterizer_create(piles[i], nullptr);
+      REQUIRE(nullptr != rs[i]);
+    }
+    std::string frames[2][2];
+    auto worker = [&](int i){
+      for(int f = 0 ; f < 2 ; ++f){
+        char* buf;
+        size_t len;
+        CHECK(0 == ncpile_render(piles[i]));
+        CHECK(0 == ncrasterizer_rasterize(rs[i], &buf, &len));
+        frames[i][f] = std::string(buf, len);
+        free(buf);
+      }
+    };
+    std::thread t0(worker, 0);
+    std::thread t1(worker, 1);
+    t0.join();
+    t1.join();
+    for(int i = 0 ; i < 2 ; ++i){
+      CHECK(std::string::npos != frames[i][0].find(i ? "second" : "first"));
+      CHECK(std::string::npos == frames[i][0].find(i ? "first" : "second"));
+      CHECK(frames[i][1].size() < frames[i][0].size());
+    }
+    // a bound pile can't be written to the terminal, nor bound to another
+    // rasterizer, until its rasterizer is destroyed, and must then be
+    // rendered anew before it is written
+    CHECK(0 == ncpile_render(piles[0]));
+    CHECK(0 != ncpile_rasterize(piles[0]));
+    CHECK(nullptr == ncrasterizer_create(piles[0], nullptr));
+    CHECK(nullptr == ncrasterizer_create(n_, nullptr));
+    ncrasterizer_destroy(rs[0]);
+    CHECK(0 == ncpile_render(piles[0]));
+    CHECK(0 == ncpile_rasterize(piles[0]));
+    ncrasterizer_destroy(rs[1]);
+    CHECK(0 == ncplane_destroy(piles[0]));
+    CHECK(0 == ncplane_destroy(piles[1]));
+  }
+
+  // a rasterizer with its own geometry and terminal type sizes its pile
+  SUBCASE("RasterizerGeometry") {
+    const char* term = getenv("TERM");
+    if(term == nullptr){
+      return;
+    }
+    struct ncplane_options nopts{};
+    nopts.rows = 2;
+    nopts.cols = 2;
+    nopts.resizecb = ncplane_resize_maximize;
+    auto np = ncpile_create(nc_, &nopts);
+    REQUIRE(nullptr != np);
+    ncrasterizer_options ropts{};
+    ropts.termtype = term;
+    ropts.rows = 5;
+    ropts.cols = 10;
+    auto r = ncrasterizer_create(np, &ropts);
+    REQUIRE(nullptr != r);
+    CHECK(0 == ncpile_render(np));
+    CHECK(5 == ncplane_dim_y(np));
+    CHECK(10 == ncplane_dim_x(np));
+    char* buf;
+    size_t len;
+    CHECK(0 == ncrasterizer_rasterize(r, &buf, &len));
+    CHECK(0 < len);
+    free(buf);
+    CHECK(0 == ncrasterizer_resize(r, 7, 12));
+    CHECK(0 == ncpile_render(np));
+    CHECK(7 == ncplane_dim_y(np));
+    CHECK(12 == ncplane_dim_x(np));
+    CHECK(0 == ncrasterizer_rasterize(r, &buf, &len));
+    free(buf);
+    ncrasterizer_destroy(r);
+    CHECK(0 == ncplane_destroy(np));
+  }
+
+  // mirrors write the terminal's frames to their own outputs, the first in
+  // its entirety, and later ones as changes
+  SUBCASE("Mirror") {
+    int fds[2];
+    REQUIRE(0 == pipe(fds));
+    std::string out;
+    std::thread reader([&](){
+      char buf[BUFSIZ];
+      ssize_t r;
+      while((r = read(fds[0], buf, sizeof(buf))) > 0){
+        out.append(buf, r);
+      }
+    });
+    auto m = ncmirror_create(n_, fds[1], nullptr);
+    REQUIRE(nullptr != m);
+    CHECK(0 < ncplane_putstr_yx(n_, 0, 0, "mirrored"));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncmirror_drain(m));
+    CHECK(0 < ncplane_putstr_yx(n_, 1, 0, "again"));
+    CHECK(0 == notcurses_render(nc_));
+    ncmirror_destroy(m);
+    close(fds[1]);
+    reader.join();
+    close(fds[0]);
+    CHECK(std::string::npos != out.find("mirrored"));
+    CHECK(std::string::npos != out.find("again"));
+  }
+
+  // a capture holds every cell, and a delta capture only those which changed
+  SUBCASE("CaptureDelta") {
+    struct ncplane_options nopts{};
+    nopts.rows = 2;
+    nopts.cols = 4;
+    auto np = ncpile_create(nc_, &nopts);
+    REQUIRE(nullptr != np);
+    char* buf;
+    size_t len;
+    CHECK(0 != ncpile_capture(np, true, &buf, &len)); // not yet rendered
+    CHECK(0 < ncplane_putstr_yx(np, 0, 0, "abcd"));
+    CHECK(0 == ncpile_render(np));
+    REQUIRE(0 == ncpile_capture(np, true, &buf, &len));
+    REQUIRE(20 <= len);
+    CHECK(0 == memcmp(buf, "NCAP", 4));
+    CHECK(0 == (buf[5] & 0x1)); // the first capture is never a delta
+    // the pile covers the screen, not merely our plane
+    uint32_t rows, cols, count;
+    memcpy(&rows, buf + 8, sizeof(rows));
+    memcpy(&cols, buf + 12, sizeof(cols));
+    memcpy(&count, buf + 16, sizeof(count));
+    CHECK(rows * cols == count);
+    const char* rec = buf + 20;
+    CHECK(1 == rec[10]); // width of 'a'
+    CHECK(1 == rec[11]);
+    CHECK('a' == rec[13]);
+    free(buf);
+    CHECK(0 < ncplane_putstr_yx(np, 1, 2, "z"));
+    CHECK(0 == ncpile_render(np));
+    REQUIRE(0 == ncpile_capture(np, true, &buf, &len));
+    CHECK(0x1 == (buf[5] & 0x1));
+    memcpy(&count, buf + 16, sizeof(count));
+    CHECK(1 == count);
+    uint32_t idx;
+    memcpy(&idx, buf + 20, sizeof(idx));
+    CHECK(cols + 2 == idx);
+    CHECK('z' == buf[20 + 4 + 13]);
+    free(buf);
+    // nothing changed; the delta is empty
+    CHECK(0 == ncpile_render(np));
+    REQUIRE(0 == ncpile_capture(np, true, &buf, &len));
+    memcpy(&count, buf + 16, sizeof(count));
+    CHECK(0 == count);
+    CHECK(20 == len);
+    free(buf);
+    CHECK(0 == ncplane_destroy(np));
+  }
+
+  // captures can be replayed onto a plane in some other pile
+  SUBCASE("ApplyCapture") {
+    struct ncplane_options nopts{};
+    nopts.rows = 2;
+    nopts.cols = 4;
+    auto np = ncpile_create(nc_, &nopts);
+    REQUIRE(nullptr != np);
+    auto dst = ncpile_create(nc_, &nopts);
+    REQUIRE(nullptr != dst);
+    char* buf;
+    size_t len;
+    CHECK(0 < ncplane_putstr_yx(np, 0, 0, "abcd"));
+    CHECK(0 == ncpile_render(np));
+    REQUIRE(0 == ncpile_capture(np, true, &buf, &len));
+    CHECK(0 == ncplane_apply_capture(dst, buf, len));
+    uint32_t rows, cols;
+    memcpy(&rows, buf + 8, sizeof(rows));
+    memcpy(&cols, buf + 12, sizeof(cols));
+    free(buf);
+    CHECK(rows == ncplane_dim_y(dst));
+    CHECK(cols == ncplane_dim_x(dst));
+    char* egc = ncplane_at_yx(dst, 0, 0, nullptr, nullptr);
+    REQUIRE(nullptr != egc);
+    CHECK(0 == strcmp(egc, "a"));
+    free(egc);
+    CHECK(0 < ncplane_putstr_yx(np, 1, 2, "z"));
+    CHECK(0 == ncpile_render(np));
+    REQUIRE(0 == ncpile_capture(np, true, &buf, &len));
+    CHECK(0 == ncplane_apply_capture(dst, buf, len));
+    egc = ncplane_at_yx(dst, 1, 2, nullptr, nullptr);
+    REQUIRE(nullptr != egc);
+    CHECK(0 == strcmp(egc, "z"));
+    free(egc);
+    // a delta is refused by a plane of some other geometry
+    CHECK(0 == ncplane_resize_simple(dst, 1, 1));
+    CHECK(0 != ncplane_apply_capture(dst, buf, len));
+    free(buf);
+    // hostile headers are refused without resizing
+    unsigned char hdr[20 + 13] = { 'N', 'C', 'A', 'P', 1, 0, };
+    uint32_t v = 0x10000;
+    memcpy(hdr + 8, &v, sizeof(v));
+    memcpy(hdr + 12, &v, sizeof(v));
+    v = 1;
+    memcpy(hdr + 16, &v, sizeof(v));
+    CHECK(0 != ncplane_apply_capture(dst, (const char*)hdr, sizeof(hdr)));
+    v = 4; // claims a 4x4 keyframe, but holds only one record
+    memcpy(hdr + 8, &v, sizeof(v));
+    memcpy(hdr + 12, &v, sizeof(v));
+    v = 16;
+    memcpy(hdr + 16, &v, sizeof(v));
+    CHECK(0 != ncplane_apply_capture(dst, (const char*)hdr, sizeof(hdr)));
+    CHECK(1 == ncplane_dim_y(dst));
+    CHECK(1 == ncplane_dim_x(dst));
+    v = 1; // a 1x1 keyframe with an oversized EGC
+    memcpy(hdr + 8, &v, sizeof(v));
+    memcpy(hdr + 12, &v, sizeof(v));
+    memcpy(hdr + 16, &v, sizeof(v));
+    hdr[20 + 10] = 1;
+    hdr[20 + 11] = 0xff;
+    hdr[20 + 12] = 0xff;
+    CHECK(0 != ncplane_apply_capture(dst, (const char*)hdr, sizeof(hdr)));
+    CHECK(0 == ncplane_destroy(dst));
+    CHECK(0 == ncplane_destroy(np));
+  }
+
+  // remote frames wrap a capture with framing and the cursor
+  SUBCASE("RemoteFrame") {
+    struct ncplane_options nopts{};
+    nopts.rows = 2;
+    nopts.cols = 4;
+    auto np = ncpile_create(nc_, &nopts);
+    REQUIRE(nullptr != np);
+    auto dst = ncpile_create(nc_, &nopts);
+    REQUIRE(nullptr != dst);
+    CHECK(0 < ncplane_putstr_yx(np, 1, 1, "xy"));
+    CHECK(0 == ncpile_render(np));
+    char* buf;
+    size_t len;
+    REQUIRE(0 == ncpile_remote_frame(np, false, 1, 3, &buf, &len));
+    REQUIRE(13 + 20 < len);
+    uint32_t mlen;
+    int32_t cury, curx;
+    memcpy(&mlen, buf, sizeof(mlen));
+    memcpy(&cury, buf + 5, sizeof(cury));
+    memcpy(&curx, buf + 9, sizeof(curx));
+    CHECK(len - 4 == mlen);
+    CHECK(NCREMOTE_MSG_FRAME == buf[4]);
+    CHECK(1 == cury);
+    CHECK(3 == curx);
+    CHECK(0 == memcmp(buf + 13, "NCAP", 4));
+    CHECK(0 == ncplane_apply_capture(dst, buf + 13, len - 13));
+    free(buf);
+    char* egc = ncplane_at_yx(dst, 1, 2, nullptr, nullptr);
+    REQUIRE(nullptr != egc);
+    CHECK(0 == strcmp(egc, "y"));
+    free(egc);
+    CHECK(0 == ncplane_destroy(dst));
+    CHECK(0 == ncplane_destroy(np));
+  }
+
+  SUBCASE("RecordReplay") {
+    struct ncplane_options nopts{};
+    nopts.rows = 2;
+    nopts.cols = 4;
+    auto np = ncpile_create(nc_, &nopts);
+    REQUIRE(nullptr != np);
+    char path[] = "/tmp/ncrecordXXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(0 <= fd);
+    close(fd);
+    ncrecorder_options ropts{};
+    ropts.keyframe_interval = 2;
+    auto rec = ncrecorder_create(np, path, &ropts);
+    REQUIRE(nullptr != rec);
+    const char* frames[] = { "abcd", "bbcd", "cbcd", "dbcd", };
+    for(auto f : frames){
+      CHECK(0 < ncplane_putstr_yx(np, 0, 0, f));
+      CHECK(0 == ncpile_render(np));
+      CHECK(0 == ncrecorder_frame(rec));
+    }
+    CHECK(0 == ncrecorder_destroy(rec));
+    auto pb = ncplayback_open(path);
+    REQUIRE(nullptr != pb);
+    nopts.rows = nopts.cols = 1;
+    auto dst = ncpile_create(nc_, &nopts);
+    REQUIRE(nullptr != dst);
+    uint64_t ns, lastns = 0;
+    for(auto f : frames){
+      REQUIRE(0 == ncplayback_next(pb, dst, &ns));
+      CHECK(lastns <= ns);
+      lastns = ns;
+      char* egc = ncplane_at_yx(dst, 0, 0, nullptr, nullptr);
+      REQUIRE(nullptr != egc);
+      CHECK(f[0] == egc[0]);
+      free(egc);
+    }
+    CHECK(1 == ncplayback_next(pb, dst, &ns));
+    // the third frame is a keyframe; seeking to it replays from there
+    CHECK(0 == ncplayback_seek(pb, lastns));
+    REQUIRE(0 == ncplayback_next(pb, dst, &ns));
+    char* egc = ncplane_at_yx(dst, 0, 0, nullptr, nullptr);
+    REQUIRE(nullptr != egc);
+    CHECK('c' == egc[0]);
+    free(egc);
+    ncplayback_close(pb);
+    CHECK(nullptr == ncplayback_open("/dev/null"));
+    unlink(path);
+    CHECK(0 == ncplane_destroy(dst));
+    CHECK(0 == ncplane_destroy(np));
+  }
+
   // common teardown
   CHECK(0 == notcurses_stop(nc_));
 }
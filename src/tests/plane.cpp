@@ -1,4 +1,6 @@
 #include <cstdlib>
+#include <string>
+#include <vector>
 #include "main.h"
 
 void BoxPermutationsRounded(struct notcurses* nc, struct ncplane* n, unsigned edges) {
@@ -113,6 +115,68 @@ TEST_CASE("Plane") {
     CHECK(0 == ncplane_destroy(n));
   }
 
+  // destroyed planes (and small framebuffers) are recycled; a recycled
+  // plane must come back blank, and at its new size
+  SUBCASE("RecycledPlanes") {
+    struct ncplane_options nopts{};
+    nopts.rows = 2;
+    nopts.cols = 8;
+    for(int i = 0 ; i < 200 ; ++i){
+      auto n = ncplane_create(n_, &nopts);
+      REQUIRE(nullptr != n);
+      CHECK(nopts.rows == ncplane_dim_y(n));
+      CHECK(nopts.cols == ncplane_dim_x(n));
+      for(unsigned y = 0 ; y < nopts.rows ; ++y){
+        for(unsigned x = 0 ; x < nopts.cols ; ++x){
+          uint16_t stylemask;
+          uint64_t channels;
+          char* egc = ncplane_at_yx(n, y, x, &stylemask, &channels);
+          REQUIRE(nullptr != egc);
+          CHECK(0 == strcmp(egc, ""));
+          CHECK(0 == stylemask);
+          CHECK(0 == channels);
+          free(egc);
+        }
+      }
+      CHECK(0 < ncplane_putstr(n, "xxxxxxxx"));
+      CHECK(0 == ncplane_destroy(n));
+      nopts.cols = 8 + (i % 7) * 3;
+      nopts.rows = 1 + i % 5;
+    }
+    CHECK(0 == notcurses_render(nc_));
+  }
+
+  // destroying a family takes every descendant with it, leaving the rest of
+  // the z-axis and the parent's other children intact
+  SUBCASE("DestroyFamily") {
+    for(uint64_t flags : { 0ull, NCPLANE_DESTROY_DEFERRED }){
+      struct ncplane_options nopts{};
+      nopts.rows = 2;
+      nopts.cols = 2;
+      auto sibling = ncplane_create(n_, &nopts);
+      REQUIRE(nullptr != sibling);
+      auto root = ncplane_create(n_, &nopts);
+      REQUIRE(nullptr != root);
+      for(int i = 0 ; i < 50 ; ++i){
+        auto child = ncplane_create(root, &nopts);
+        REQUIRE(nullptr != child);
+        for(int j = 0 ; j < 4 ; ++j){
+          REQUIRE(nullptr != ncplane_create(child, &nopts));
+        }
+      }
+      CHECK(0 == notcurses_render(nc_));
+      CHECK(0 == ncplane_destroy_family(root, flags));
+      CHECK(sibling == ncpile_top(n_));
+      CHECK(n_ == ncplane_below(sibling));
+      CHECK(nullptr == ncplane_below(n_));
+      CHECK(sibling == n_->blist);
+      CHECK(nullptr == sibling->bnext);
+      CHECK(0 == notcurses_render(nc_));
+      CHECK(0 == ncplane_destroy(sibling));
+    }
+    CHECK(0 > ncplane_destroy_family(n_, 0));
+  }
+
   // Verify we can emit a NUL character, and it advances the cursor after
   // wiping out whatever we printed it atop.
   SUBCASE("EmitNULCell") {
@@ -211,6 +275,92 @@ TEST_CASE("Plane") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // streamed rows concatenate to ncplane_contents(), with wide EGCs once
+  SUBCASE("ContentsStream") {
+    CHECK(3 == ncplane_putstr_yx(n_, 0, 0, "abc"));
+    CHECK(0 < ncplane_putstr_yx(n_, 1, 1, notcurses_canutf8(nc_) ? "全d" : "xd"));
+    CHECK(2 == ncplane_putstr_yx(n_, 2, 0, "ef"));
+    std::vector<std::pair<unsigned, std::string>> rows;
+    auto cb = [](const char* row, size_t len, unsigned y, void* curry){
+      auto r = static_cast<std::vector<std::pair<unsigned, std::string>>*>(curry);
+      r->emplace_back(y, std::string(row, len));
+      return 0;
+    };
+    CHECK(0 == ncplane_contents_stream(n_, 0, 0, 3, 4, cb, &rows));
+    REQUIRE(3 == rows.size());
+    std::string all;
+    for(unsigned y = 0 ; y < 3 ; ++y){
+      CHECK(y == rows[y].first);
+      char* line = ncplane_contents(n_, y, 0, 1, 4);
+      REQUIRE(line);
+      CHECK(rows[y].second == line);
+      free(line);
+      all += rows[y].second;
+    }
+    char* contents = ncplane_contents(n_, 0, 0, 3, 4);
+    REQUIRE(contents);
+    CHECK(all == contents);
+    free(contents);
+    // a non-zero return from the callback stops the stream, and is returned
+    auto stop = [](const char*, size_t, unsigned, void*){ return 7; };
+    CHECK(7 == ncplane_contents_stream(n_, 0, 0, 0, 0, stop, nullptr));
+    CHECK(0 > ncplane_contents_stream(n_, -2, 0, 0, 0, cb, &rows));
+  }
+
+  // runs of printable ASCII are written without segmentation; verify they
+  // still yield to combining characters, control characters, and wide glyphs
+  SUBCASE("EmitASCIIRuns") {
+    const char s[] = "the quick brown fox jumps over the lazy dog, jumps!";
+    CHECK(ncstrwidth(s, NULL, NULL) == (int)strlen(s));
+    CHECK(0 == ncplane_cursor_move_yx(n_, 0, 0));
+    CHECK((int)strlen(s) == ncplane_putstr(n_, s));
+    char* contents = ncplane_contents(n_, 0, 0, 1, strlen(s));
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, s));
+    free(contents);
+    unsigned y, x;
+    ncplane_cursor_yx(n_, &y, &x);
+    CHECK(0 == y);
+    CHECK(strlen(s) == x);
+    // the final 'e' must take the combining acute accent along with it
+    if(notcurses_canutf8(nc_)){
+      const char comb[] = "resume\xcc\x81 of the case";
+      CHECK(18 == ncstrwidth(comb, NULL, NULL));
+      CHECK(18 == ncplane_putstr_yx(n_, 1, 0, comb));
+      char* egc = ncplane_at_yx(n_, 1, 5, nullptr, nullptr);
+      REQUIRE(egc);
+      CHECK(0 == strcmp(egc, "e\xcc\x81"));
+      free(egc);
+      // ASCII atop the right half of a wide glyph destroys the left half
+      CHECK(2 == ncplane_putstr_yx(n_, 2, 0, "全"));
+      CHECK(3 == ncplane_putstr_yx(n_, 2, 1, "abc"));
+      egc = ncplane_at_yx(n_, 2, 0, nullptr, nullptr);
+      REQUIRE(egc);
+      CHECK(0 == strcmp(egc, ""));
+      free(egc);
+    }
+    // output stops at a control character
+    CHECK(0 >= ncplane_putstr_yx(n_, 3, 0, "abc\x01" "def"));
+    contents = ncplane_contents(n_, 3, 0, 1, 6);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "abc"));
+    free(contents);
+    // an ASCII run too long for its row fails at the edge without scrolling,
+    // and continues onto the next row with it
+    unsigned dimy, dimx;
+    ncplane_dim_yx(n_, &dimy, &dimx);
+    CHECK(0 >= ncplane_putstr_yx(n_, 4, dimx - 3, "abcdef"));
+    ncplane_cursor_yx(n_, &y, &x);
+    CHECK(4 == y);
+    CHECK(dimx == x);
+    CHECK(!ncplane_set_scrolling(n_, true));
+    CHECK(6 == ncplane_putstr_yx(n_, 5, dimx - 3, "abcdef"));
+    ncplane_cursor_yx(n_, &y, &x);
+    CHECK(6 == y);
+    CHECK(3 == x);
+    CHECK(0 == notcurses_render(nc_));
+  }
+
   SUBCASE("HorizontalLines") {
     unsigned x, y;
     ncplane_dim_yx(n_, &y, &x);
@@ -322,6 +472,58 @@ TEST_CASE("Plane") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // a styled box must be cell-for-cell what ncplane_box() draws
+  SUBCASE("BoxStyledMatchesBox") {
+    auto bs = ncboxstyle_create(NCBOXROUND, NCSTYLE_BOLD, NCCHANNELS_INITIALIZER(0xff, 0, 0, 0, 0, 0xff));
+    REQUIRE(bs);
+    struct ncplane_options nopts{};
+    nopts.rows = 5;
+    nopts.cols = 8;
+    auto a = ncplane_create(n_, &nopts);
+    REQUIRE(a);
+    auto b = ncplane_create(n_, &nopts);
+    REQUIRE(b);
+    nccell ul = NCCELL_TRIVIAL_INITIALIZER, ur = NCCELL_TRIVIAL_INITIALIZER;
+    nccell ll = NCCELL_TRIVIAL_INITIALIZER, lr = NCCELL_TRIVIAL_INITIALIZER;
+    nccell hl = NCCELL_TRIVIAL_INITIALIZER, vl = NCCELL_TRIVIAL_INITIALIZER;
+    REQUIRE(0 == nccells_load_box(a, NCSTYLE_BOLD, NCCHANNELS_INITIALIZER(0xff, 0, 0, 0, 0, 0xff),
+                                  &ul, &ur, &ll, &lr, &hl, &vl, NCBOXROUND));
+    const unsigned ctlword = NCBOXMASK_RIGHT | (1u << NCBOXCORNER_SHIFT);
+    CHECK(0 == ncplane_cursor_move_yx(a, 1, 1));
+    CHECK(0 == ncplane_box_sized(a, &ul, &ur, &ll, &lr, &hl, &vl, 4, 6, ctlword));
+    CHECK(0 == ncplane_box_styled(b, bs, 1, 1, 4, 6, ctlword));
+    unsigned y, x;
+    ncplane_cursor_yx(b, &y, &x);
+    CHECK(0 == y);
+    CHECK(0 == x);
+    for(unsigned yy = 0 ; yy < 5 ; ++yy){
+      for(unsigned xx = 0 ; xx < 8 ; ++xx){
+        uint16_t sa, sb;
+        uint64_t ca, cb;
+        char* ea = ncplane_at_yx(a, yy, xx, &sa, &ca);
+        char* eb = ncplane_at_yx(b, yy, xx, &sb, &cb);
+        REQUIRE(ea);
+        REQUIRE(eb);
+        CHECK(0 == strcmp(ea, eb));
+        CHECK(sa == sb);
+        CHECK(ca == cb);
+        free(ea);
+        free(eb);
+      }
+    }
+    // boxes must be at least 2x2, and lie within the plane
+    CHECK(0 > ncplane_box_styled(b, bs, 0, 0, 1, 6, 0));
+    CHECK(0 > ncplane_box_styled(b, bs, 2, 4, 4, 4, 0));
+    nccell_release(a, &ul); nccell_release(a, &ur);
+    nccell_release(a, &ll); nccell_release(a, &lr);
+    nccell_release(a, &hl); nccell_release(a, &vl);
+    ncboxstyle_destroy(bs);
+    CHECK(0 == ncplane_destroy(a));
+    CHECK(0 == ncplane_destroy(b));
+    // glyphs must be simple and a single column
+    CHECK(nullptr == ncboxstyle_create("\u2500\u2500\u2500\u2500\u2500\u6f22", 0, 0));
+  }
+
   SUBCASE("PerimeterDoubleBox") {
     unsigned x, y;
     ncplane_dim_yx(n_, &y, &x);
@@ -1118,6 +1320,58 @@ TEST_CASE("Plane") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // cells written to a sparse canvas survive being panned out of view and
+  // back, whether written through the plane or directly to the canvas
+  SUBCASE("SparseCanvas") {
+    struct ncplane_options nopts{};
+    nopts.rows = 4;
+    nopts.cols = 8;
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(n);
+    CHECK(0 > ncplane_canvas_pan(n, 1, 1));
+    CHECK(0 > ncplane_set_canvas(n, 2, 2000));
+    CHECK(0 == ncplane_set_canvas(n, 20000, 20000));
+    unsigned rows, cols;
+    CHECK(0 == ncplane_canvas_dim_yx(n, &rows, &cols));
+    CHECK(20000 == rows);
+    CHECK(20000 == cols);
+    CHECK(0 < ncplane_putstr_yx(n, 0, 0, "origin"));
+    nccell c = NCCELL_TRIVIAL_INITIALIZER;
+    CHECK(0 < nccell_load(n, &c, "X"));
+    CHECK(1 == ncplane_canvas_putc_yx(n, 15000, 17000, &c));
+    nccell_release(n, &c);
+    char* egc = ncplane_canvas_at_yx(n, 15000, 17000, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "X"));
+    free(egc);
+    CHECK(0 == ncplane_canvas_pan(n, 14998, 16996));
+    unsigned y, x;
+    CHECK(0 == ncplane_canvas_origin(n, &y, &x));
+    CHECK(14998 == y);
+    CHECK(16996 == x);
+    egc = ncplane_at_yx(n, 2, 4, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "X"));
+    free(egc);
+    egc = ncplane_canvas_at_yx(n, 0, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "o"));
+    free(egc);
+    CHECK(0 == notcurses_render(nc_));
+    // panning is clamped to the canvas
+    CHECK(0 == ncplane_canvas_pan(n, 30000, 30000));
+    CHECK(0 == ncplane_canvas_origin(n, &y, &x));
+    CHECK(20000 - nopts.rows == y);
+    CHECK(20000 - nopts.cols == x);
+    CHECK(0 == ncplane_canvas_pan(n, 0, 0));
+    egc = ncplane_at_yx(n, 0, 5, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "n"));
+    free(egc);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_destroy(n));
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
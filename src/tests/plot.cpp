@@ -1,6 +1,8 @@
 #include "main.h"
 #include <cstring>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 TEST_CASE("Plot") {
   auto nc_ = testing_notcurses();
@@ -283,5 +285,134 @@ TEST_CASE("Plot") {
     ncuplot_destroy(p);
   }
 
+  // redraws shift the plot left, and must leave it as a full redraw would
+  SUBCASE("ScrollMatchesFullRedraw") {
+    ncplane_options nopts = {
+      .y = 1, .x = 1, .rows = 1, .cols = 12,
+      .userptr = nullptr, .name = "plot", .resizecb = nullptr, .flags = 0,
+      .margin_b = 0, .margin_r = 0,
+    };
+    auto ncp = ncplane_create(n_, &nopts);
+    REQUIRE(ncp);
+    ncplot_options popts{};
+    popts.gridtype = NCBLIT_1x1;
+    popts.title = "ab"; // drawn at columns 5 and 6, beneath the plot
+    auto p = ncuplot_create(ncp, &popts, 0, 1);
+    REQUIRE(p);
+    uint64_t vals[40] = {};
+    for(int x = 0 ; x < 40 ; ++x){
+      vals[x] = x % 3 == 0;
+      CHECK(0 == ncuplot_add_sample(p, x, vals[x]));
+      if(x % 5 == 4){ // rewrite a sample within the window
+        vals[x - 4] = !vals[x - 4];
+        CHECK(0 == ncuplot_set_sample(p, x - 4, vals[x - 4]));
+      }
+      for(int c = 0 ; c < 12 ; ++c){
+        const int sx = x - (11 - c);
+        const char* expected = "";
+        if(sx >= 0 && vals[sx]){
+          expected = "█";
+        }else if(c == 5){
+          expected = "a";
+        }else if(c == 6){
+          expected = "b";
+        }
+        char* egc = ncplane_at_yx(ncp, 0, c, nullptr, nullptr);
+        REQUIRE(egc);
+        CHECK(0 == strcmp(expected, egc));
+        free(egc);
+      }
+    }
+    CHECK(0 == notcurses_render(nc_));
+    ncuplot_destroy(p);
+  }
+
+  // many producers staging at once must lose nothing
+  SUBCASE("StagedSamples") {
+    ncplot_options popts{};
+    popts.rangex = 10;
+    auto p = ncuplot_create(n_, &popts, 0, 0);
+    REQUIRE(p);
+    const int threads = 8;
+    const int iters = 1000;
+    std::vector<std::thread> producers;
+    for(int t = 0 ; t < threads ; ++t){
+      producers.emplace_back([p](){
+        for(int i = 0 ; i < iters ; ++i){
+          for(uint64_t x = 0 ; x < 10 ; ++x){
+            ncuplot_stage_add(p, x, x + 1);
+          }
+        }
+      });
+    }
+    for(auto& t : producers){
+      t.join();
+    }
+    CHECK(0 == ncuplot_flush(p));
+    for(uint64_t x = 0 ; x < 10 ; ++x){
+      uint64_t y;
+      CHECK(0 == ncuplot_sample(p, x, &y));
+      CHECK((x + 1) * threads * iters == y);
+    }
+    // a replacement supersedes the additions staged before it
+    CHECK(0 == ncuplot_stage_add(p, 9, 5));
+    CHECK(0 == ncuplot_stage_set(p, 9, 3));
+    CHECK(0 == ncuplot_stage_add(p, 9, 1));
+    CHECK(0 == ncuplot_flush(p));
+    uint64_t y;
+    CHECK(0 == ncuplot_sample(p, 9, &y));
+    CHECK(4 == y);
+    // staging a full window behind a staged x is refused
+    CHECK(0 == ncuplot_stage_add(p, 25, 1));
+    CHECK(-1 == ncuplot_stage_add(p, 15, 1));
+    CHECK(0 == ncuplot_flush(p));
+    CHECK(0 == ncuplot_sample(p, 25, &y));
+    CHECK(1 == y);
+    ncuplot_destroy(p);
+  }
+
+  // a range ten times the plane's width puts ten x values in each slot
+  SUBCASE("Decimate") {
+    ncplane_options nopts = {
+      .y = 1, .x = 1, .rows = 1, .cols = 10,
+      .userptr = nullptr, .name = "plot", .resizecb = nullptr, .flags = 0,
+      .margin_b = 0, .margin_r = 0,
+    };
+    auto ncp = ncplane_create(n_, &nopts);
+    REQUIRE(ncp);
+    ncplot_options popts{};
+    popts.gridtype = NCBLIT_1x1;
+    popts.rangex = 100;
+    popts.flags = NCPLOT_OPTION_DECIMATE_MEAN | NCPLOT_OPTION_DECIMATE_MAX;
+    CHECK(nullptr == ncuplot_create(ncp, &popts, 0, 0));
+    ncp = ncplane_create(n_, &nopts);
+    REQUIRE(ncp);
+    popts.flags = NCPLOT_OPTION_DECIMATE_MEAN;
+    auto p = ncuplot_create(ncp, &popts, 0, 0);
+    REQUIRE(p);
+    for(uint64_t x = 0 ; x < 100 ; ++x){
+      CHECK(0 == ncuplot_add_sample(p, x, x));
+    }
+    for(uint64_t x = 0 ; x < 100 ; ++x){
+      uint64_t y;
+      CHECK(0 == ncuplot_sample(p, x, &y));
+      CHECK(x / 10 * 10 + 4 == y); // mean of x / 10 * 10 .. x / 10 * 10 + 9
+    }
+    // a replacement discards the slot's other observations
+    CHECK(0 == ncuplot_set_sample(p, 95, 1));
+    uint64_t y;
+    CHECK(0 == ncuplot_sample(p, 90, &y));
+    CHECK(1 == y);
+    // the window advances a slot at a time
+    CHECK(0 == ncuplot_add_sample(p, 100, 7));
+    CHECK(-1 == ncuplot_sample(p, 9, &y));
+    CHECK(0 == ncuplot_sample(p, 10, &y));
+    CHECK(14 == y);
+    CHECK(0 == ncuplot_sample(p, 109, &y));
+    CHECK(7 == y);
+    CHECK(-1 == ncuplot_stage_add(p, 100, 1));
+    ncuplot_destroy(p);
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 }
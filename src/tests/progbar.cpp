@@ -290,5 +290,55 @@ TEST_CASE("ProgressBar") {
     ncprogbar_destroy(ncp);
   }
 
+  // updates redraw only the cells between the old and new frontiers. the
+  // result must be indistinguishable from a bar drawn afresh.
+  SUBCASE("IncrementalMatchesFull") {
+    struct ncplane_options nopts = {
+      .y = 0,
+      .x = 0,
+      .rows = 2,
+      .cols = 23,
+      .userptr = nullptr,
+      .name = "pbar",
+      .resizecb = nullptr,
+      .flags = 0,
+      .margin_b = 0, .margin_r = 0,
+    };
+    struct ncprogbar_options popts{};
+    ncchannel_set_rgb8(&popts.ulchannel, 0x80, 0xcc, 0xcc);
+    ncchannel_set_rgb8(&popts.urchannel, 0xcc, 0xcc, 0x80);
+    ncchannel_set_rgb8(&popts.blchannel, 0xcc, 0x80, 0xcc);
+    ncchannel_set_rgb8(&popts.brchannel, 0x80, 0xcc, 0xcc);
+    auto n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    auto pbar = ncprogbar_create(n, &popts);
+    REQUIRE(nullptr != pbar);
+    const double ps[] = { 0.3, 0.31, 0.7, 0.1, 0.95, 0.5, 1.0, 0, 0.42, };
+    for(auto p : ps){
+      CHECK(0 == ncprogbar_set_progress(pbar, p));
+      auto fresh = ncplane_create(n_, &nopts);
+      REQUIRE(nullptr != fresh);
+      auto fbar = ncprogbar_create(fresh, &popts);
+      REQUIRE(nullptr != fbar);
+      CHECK(0 == ncprogbar_set_progress(fbar, p));
+      for(unsigned y = 0 ; y < nopts.rows ; ++y){
+        for(unsigned x = 0 ; x < nopts.cols ; ++x){
+          uint16_t smask, fsmask;
+          uint64_t channels, fchannels;
+          char* egc = ncplane_at_yx(n, y, x, &smask, &channels);
+          char* fegc = ncplane_at_yx(fresh, y, x, &fsmask, &fchannels);
+          REQUIRE(nullptr != egc);
+          REQUIRE(nullptr != fegc);
+          CHECK(0 == strcmp(egc, fegc));
+          CHECK(channels == fchannels);
+          free(egc);
+          free(fegc);
+        }
+      }
+      ncprogbar_destroy(fbar);
+    }
+    ncprogbar_destroy(pbar);
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 }
@@ -0,0 +1,126 @@
+#include "main.h"
+
+// ncplane_put_cells() writes a block of cells directly into the framebuffer
+TEST_CASE("PutCells") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  struct ncplane* n_ = notcurses_stdplane(nc_);
+  REQUIRE(nullptr != n_);
+
+  SUBCASE("ASCIIBlock") {
+    nccell cells[3][4];
+    for(unsigned y = 0 ; y < 3 ; ++y){
+      for(unsigned x = 0 ; x < 4 ; ++x){
+        nccell_init(&cells[y][x]);
+        CHECK(1 == nccell_load_char(n_, &cells[y][x], 'a' + y * 4 + x));
+        CHECK(0 == nccell_set_fg_rgb(&cells[y][x], 0x010203 * (x + 1)));
+        cells[y][x].stylemask = NCSTYLE_BOLD;
+      }
+    }
+    CHECK(12 == ncplane_put_cells(n_, 1, 2, 3, 4, &cells[0][0], 0));
+    for(unsigned y = 0 ; y < 3 ; ++y){
+      for(unsigned x = 0 ; x < 4 ; ++x){
+        nccell c = NCCELL_TRIVIAL_INITIALIZER;
+        CHECK(1 == ncplane_at_yx_cell(n_, y + 1, x + 2, &c));
+        CHECK(htole((uint32_t)('a' + y * 4 + x)) == c.gcluster);
+        CHECK(0x010203 * (x + 1) == nccell_fg_rgb(&c));
+        CHECK(NCSTYLE_BOLD == c.stylemask);
+        nccell_release(n_, &c);
+      }
+    }
+    // the cursor doesn't move
+    unsigned y, x;
+    ncplane_cursor_yx(n_, &y, &x);
+    CHECK(0 == y);
+    CHECK(0 == x);
+    CHECK(0 == notcurses_render(nc_));
+  }
+
+  // write the middle of a larger array
+  SUBCASE("Stride") {
+    nccell cells[2][5];
+    for(unsigned y = 0 ; y < 2 ; ++y){
+      for(unsigned x = 0 ; x < 5 ; ++x){
+        nccell_init(&cells[y][x]);
+        CHECK(1 == nccell_load_char(n_, &cells[y][x], '0' + x));
+      }
+    }
+    CHECK(0 > ncplane_put_cells(n_, 0, 0, 2, 3, &cells[0][1], 2));
+    CHECK(6 == ncplane_put_cells(n_, 0, 0, 2, 3, &cells[0][1], 5));
+    for(unsigned y = 0 ; y < 2 ; ++y){
+      char* egc = ncplane_at_yx(n_, y, 0, nullptr, nullptr);
+      REQUIRE(nullptr != egc);
+      CHECK(0 == strcmp(egc, "1"));
+      free(egc);
+      egc = ncplane_at_yx(n_, y, 2, nullptr, nullptr);
+      REQUIRE(nullptr != egc);
+      CHECK(0 == strcmp(egc, "3"));
+      free(egc);
+    }
+    CHECK(0 == notcurses_render(nc_));
+  }
+
+  SUBCASE("InvalidBlocks") {
+    unsigned dimy, dimx;
+    ncplane_dim_yx(n_, &dimy, &dimx);
+    nccell cells[2] = { NCCELL_CHAR_INITIALIZER('x'), NCCELL_CHAR_INITIALIZER('\x01') };
+    CHECK(0 > ncplane_put_cells(n_, 0, dimx - 1, 1, 2, cells, 0));
+    CHECK(0 > ncplane_put_cells(n_, dimy, 0, 1, 1, cells, 0));
+    CHECK(0 > ncplane_put_cells(n_, 0, 0, 0, 1, cells, 0));
+    // the control character spoils the whole block
+    CHECK(0 > ncplane_put_cells(n_, 0, 0, 1, 2, cells, 0));
+    char* egc = ncplane_at_yx(n_, 0, 0, nullptr, nullptr);
+    REQUIRE(nullptr != egc);
+    CHECK(0 != strcmp(egc, "x"));
+    free(egc);
+  }
+
+  SUBCASE("WideAndPooled") {
+    if(notcurses_canutf8(nc_)){
+      nccell cells[4];
+      for(auto& c : cells){
+        nccell_init(&c);
+      }
+      CHECK(0 < nccell_load(n_, &cells[0], "全"));
+      CHECK(0 < nccell_load(n_, &cells[2], "e\xcc\x81\xcc\x81"));
+      CHECK(1 == nccell_load_char(n_, &cells[3], 'z'));
+      CHECK(4 == ncplane_put_cells(n_, 0, 0, 1, 4, cells, 0));
+      char* egc = ncplane_at_yx(n_, 0, 0, nullptr, nullptr);
+      REQUIRE(nullptr != egc);
+      CHECK(0 == strcmp(egc, "全"));
+      free(egc);
+      nccell c = NCCELL_TRIVIAL_INITIALIZER;
+      // the right half of a wide glyph has no EGC of its own
+      CHECK(0 == ncplane_at_yx_cell(n_, 0, 1, &c));
+      CHECK(nccell_wide_right_p(&c));
+      nccell_release(n_, &c);
+      egc = ncplane_at_yx(n_, 0, 2, nullptr, nullptr);
+      REQUIRE(nullptr != egc);
+      CHECK(0 == strcmp(egc, "e\xcc\x81\xcc\x81"));
+      free(egc);
+      // a wide glyph mustn't run off the block
+      CHECK(0 > ncplane_put_cells(n_, 1, 0, 1, 1, cells, 0));
+      // overwriting the right half of a wide glyph destroys its left half
+      CHECK(1 == ncplane_put_cells(n_, 0, 1, 1, 1, &cells[3], 0));
+      egc = ncplane_at_yx(n_, 0, 0, nullptr, nullptr);
+      REQUIRE(nullptr != egc);
+      CHECK(0 == strcmp(egc, ""));
+      free(egc);
+      // overwriting the left half of a wide glyph destroys its right half
+      CHECK(2 == ncplane_put_cells(n_, 2, 0, 1, 2, cells, 0));
+      CHECK(1 == ncplane_put_cells(n_, 2, 0, 1, 1, &cells[3], 0));
+      CHECK(0 == ncplane_at_yx_cell(n_, 2, 1, &c));
+      CHECK(!nccell_wide_right_p(&c));
+      CHECK(0 == strcmp(nccell_extended_gcluster(n_, &c), ""));
+      nccell_release(n_, &c);
+      for(auto& cell : cells){
+        nccell_release(n_, &cell);
+      }
+      CHECK(0 == notcurses_render(nc_));
+    }
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
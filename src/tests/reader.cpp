@@ -38,5 +38,94 @@ TEST_CASE("Readers") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // text is inserted at the cursor, and lines are joined with newlines
+  SUBCASE("ReaderInsert") {
+    ncreader_options opts{};
+    opts.flags = NCREADER_OPTION_HORSCROLL | NCREADER_OPTION_VERSCROLL;
+    struct ncplane_options nopts = {
+      .y = 0,
+      .x = 0,
+      .rows = 2,
+      .cols = 4,
+      .userptr = nullptr,
+      .name = nullptr,
+      .resizecb = nullptr,
+      .flags = 0,
+      .margin_b = 0, .margin_r = 0,
+    };
+    auto ncp = ncplane_create(notcurses_stdplane(nc_), &nopts);
+    auto nr = ncreader_create(ncp, &opts);
+    REQUIRE(nullptr != nr);
+    for(const char* s = "abcdefgh" ; *s ; ++s){
+      const char egc[2] = { *s, '\0' };
+      CHECK(0 == ncreader_write_egc(nr, egc));
+    }
+    // the viewport has panned to keep the cursor visible
+    char* egc = ncplane_at_yx(ncp, 0, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "f"));
+    free(egc);
+    for(int i = 0 ; i < 4 ; ++i){
+      CHECK(0 == ncreader_move_left(nr));
+    }
+    CHECK(0 == ncreader_write_egc(nr, "X"));
+    CHECK(0 == ncreader_write_egc(nr, "\n"));
+    CHECK(0 == ncreader_write_egc(nr, "\n"));
+    CHECK(0 == ncreader_write_egc(nr, "Y"));
+    char* contents = ncreader_contents(nr);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "abcdX\n\nYefgh"));
+    free(contents);
+    // up keeps the column where it can; down again, then back through the
+    // join of the first two lines
+    CHECK(0 == ncreader_move_up(nr));
+    CHECK(0 == ncreader_move_up(nr));
+    CHECK(0 != ncreader_move_up(nr));
+    CHECK(0 == ncreader_move_down(nr));
+    ncinput ni{};
+    ni.id = NCKEY_BACKSPACE;
+    CHECK(ncreader_offer_input(nr, &ni));
+    CHECK(0 == ncreader_write_egc(nr, "Z"));
+    contents = ncreader_contents(nr);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "abcdXZ\nYefgh"));
+    free(contents);
+    CHECK(0 == ncreader_clear(nr));
+    contents = ncreader_contents(nr);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, ""));
+    free(contents);
+    ncreader_destroy(nr, nullptr);
+    CHECK(0 == notcurses_render(nc_));
+  }
+
+  // without scrolling, the text can't outgrow the plane
+  SUBCASE("ReaderBounded") {
+    struct ncplane_options nopts = {
+      .y = 0,
+      .x = 0,
+      .rows = 1,
+      .cols = 3,
+      .userptr = nullptr,
+      .name = nullptr,
+      .resizecb = nullptr,
+      .flags = 0,
+      .margin_b = 0, .margin_r = 0,
+    };
+    auto ncp = ncplane_create(notcurses_stdplane(nc_), &nopts);
+    auto nr = ncreader_create(ncp, nullptr);
+    REQUIRE(nullptr != nr);
+    CHECK(0 == ncreader_write_egc(nr, "a"));
+    CHECK(0 == ncreader_write_egc(nr, "b"));
+    CHECK(0 == ncreader_write_egc(nr, "c"));
+    CHECK(0 > ncreader_write_egc(nr, "d"));
+    CHECK(0 > ncreader_write_egc(nr, "\n"));
+    char* contents = nullptr;
+    ncreader_destroy(nr, &contents);
+    REQUIRE(contents);
+    CHECK(0 == strcmp(contents, "abc"));
+    free(contents);
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 }
@@ -118,6 +118,22 @@ int check_norborders(nctablet* t, bool drawfromtop) {
   return 1;
 }
 
+// marks the tablet, counting draws, and draws which found an earlier mark
+int check_retained(nctablet* t, bool drawfromtop) {
+  (void)drawfromtop;
+  auto counts = static_cast<int*>(nctablet_userptr(t));
+  auto ncp = nctablet_plane(t);
+  REQUIRE(ncp);
+  ++counts[0];
+  char* egc = ncplane_at_yx(ncp, 0, 0, nullptr, nullptr);
+  if(egc && *egc){
+    ++counts[1];
+  }
+  free(egc);
+  CHECK(0 < ncplane_putchar_yx(ncp, 0, 0, 'x'));
+  return 2;
+}
+
 TEST_CASE("Reels") {
   auto nc_ = testing_notcurses();
   if(!nc_){
@@ -563,5 +579,31 @@ TEST_CASE("Reels") {
     ncreel_destroy(nr);
   }
 
+  // tablets leaving the screen give up their planes to be reused, empty, by
+  // others, unless NCREEL_OPTION_RETAINPLANES is used, in which case they get
+  // them back (with their contents) when they're next drawn.
+  SUBCASE("RecycledPlanes") {
+    auto scroll = [&](uint64_t flags) -> int {
+      int counts[2] = {0, 0};
+      ncreel_options r{};
+      r.flags = flags;
+      struct ncreel* nr = ncreel_create(n_, &r);
+      REQUIRE(nr);
+      for(int i = 0 ; i < 40 ; ++i){
+        REQUIRE(nullptr != ncreel_add(nr, nullptr, nullptr, check_retained, counts));
+      }
+      for(int i = 0 ; i < 80 ; ++i){
+        CHECK(nullptr != ncreel_next(nr));
+        CHECK(ncreel_validate(nr));
+      }
+      CHECK_EQ(0, notcurses_render(nc_));
+      ncreel_destroy(nr);
+      CHECK(80 < counts[0]);
+      return counts[1];
+    };
+    CHECK(0 == scroll(0));
+    CHECK(0 < scroll(NCREEL_OPTION_RETAINPLANES));
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 }
@@ -70,6 +70,71 @@ TEST_CASE("Resize") {
     CHECK(0 == ncplane_destroy(testn));
   }
 
+  // a plane which is only moved mustn't bother its children
+  SUBCASE("MoveSkipsChildCallbacks") {
+    static int calls;
+    calls = 0;
+    struct ncplane_options nopts{};
+    nopts.rows = 4;
+    nopts.cols = 4;
+    struct ncplane* parent = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != parent);
+    nopts.rows = 2;
+    nopts.cols = 2;
+    nopts.resizecb = [](struct ncplane*){ ++calls; return 0; };
+    struct ncplane* child = ncplane_create(parent, &nopts);
+    REQUIRE(nullptr != child);
+    CHECK(0 == ncplane_resize(parent, 0, 0, 4, 4, 1, 1, 4, 4));
+    CHECK(0 == calls);
+    CHECK(0 == ncplane_resize(parent, 0, 0, 4, 4, 0, 0, 5, 5));
+    CHECK(1 == calls);
+    CHECK(0 == ncplane_destroy(parent));
+  }
+
+  // a scrolled plane is unrolled, and shrinks within its own framebuffer
+  SUBCASE("ResizeScrolledInPlace") {
+    struct ncplane_options nopts{};
+    nopts.rows = 4;
+    nopts.cols = 6;
+    nopts.flags = NCPLANE_OPTION_VSCROLL;
+    struct ncplane* n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    CHECK(0 < ncplane_putstr(n, "a\nb\nc\nd\ne\nf"));
+    CHECK(0 != n->logrow);
+    auto check_rows = [n](const char* want){
+      for(unsigned y = 0 ; y < ncplane_dim_y(n) ; ++y){
+        char* egc = ncplane_at_yx(n, y, 0, nullptr, nullptr);
+        REQUIRE(nullptr != egc);
+        const char expect[2] = { want[y] == ' ' ? '\0' : want[y], '\0' };
+        CHECK(0 == strcmp(expect, egc));
+        free(egc);
+      }
+    };
+    check_rows("cdef");
+    const nccell* fb = n->fb;
+    CHECK(0 == ncplane_resize(n, 1, 0, 3, 6, 0, 0, 3, 6));
+    CHECK(fb == n->fb);
+    CHECK(0 == n->logrow);
+    check_rows("def");
+    CHECK(0 == ncplane_resize(n, 0, 0, 3, 3, 0, 0, 3, 3));
+    CHECK(fb == n->fb);
+    check_rows("def");
+    CHECK(0 == ncplane_resize(n, 0, 0, 3, 3, 0, 0, 4, 3));
+    check_rows("def ");
+    CHECK(0 == ncplane_destroy(n));
+  }
+
+  SUBCASE("ResizeDebounce") {
+    CHECK(0 == notcurses_set_resize_debounce(nc_, 50000000ull));
+    unsigned y, x;
+    notcurses_stddim_yx(nc_, &y, &x);
+    CHECK(0 == notcurses_render(nc_));
+    notcurses_stddim_yx(nc_, &y, &x);
+    CHECK(dimy == y);
+    CHECK(dimx == x);
+    CHECK(0 == notcurses_set_resize_debounce(nc_, 0));
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
@@ -290,6 +290,65 @@ TEST_CASE("Rotate") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // four quarter turns ought restore the original exactly
+  SUBCASE("RotateVisualQuarterTurns") {
+    std::vector<uint32_t> rgba(15);
+    for(unsigned i = 0 ; i < rgba.size() ; ++i){
+      rgba[i] = htole(0xff000000ul + i);
+    }
+    auto ncv = ncvisual_from_rgba(rgba.data(), 3, 5 * 4, 5);
+    REQUIRE(ncv);
+    for(int i = 0 ; i < 4 ; ++i){
+      CHECK(0 == ncvisual_rotate(ncv, M_PI / 2));
+      ncvgeom geom{};
+      CHECK(0 == ncvisual_geom(nc_, ncv, nullptr, &geom));
+      CHECK((i % 2 ? 3 : 5) == geom.pixy);
+      CHECK((i % 2 ? 5 : 3) == geom.pixx);
+    }
+    for(unsigned y = 0 ; y < 3 ; ++y){
+      for(unsigned x = 0 ; x < 5 ; ++x){
+        uint32_t px;
+        CHECK(0 == ncvisual_at_yx(ncv, y, x, &px));
+        CHECK(rgba[y * 5 + x] == px);
+      }
+    }
+    ncvisual_destroy(ncv);
+  }
+
+  // an arbitrary rotation of an opaque square leaves no holes
+  SUBCASE("RotateVisualArbitrary") {
+    std::vector<uint32_t> rgba(20 * 20, htole(0xff204080));
+    for(int bilinear = 0 ; bilinear < 2 ; ++bilinear){
+      auto ncv = ncvisual_from_rgba(rgba.data(), 20, 20 * 4, 20);
+      REQUIRE(ncv);
+      CHECK(0 == (bilinear ? ncvisual_rotate_bilinear(ncv, M_PI / 4)
+                           : ncvisual_rotate(ncv, M_PI / 4)));
+      ncvgeom geom{};
+      CHECK(0 == ncvisual_geom(nc_, ncv, nullptr, &geom));
+      CHECK(geom.pixy > 20);
+      CHECK(geom.pixx > 20);
+      for(unsigned y = 0 ; y < geom.pixy ; ++y){
+        unsigned opaque = 0; // 0: before, 1: within, 2: after the square
+        for(unsigned x = 0 ; x < geom.pixx ; ++x){
+          uint32_t px;
+          CHECK(0 == ncvisual_at_yx(ncv, y, x, &px));
+          const bool o = ncpixel_a(px);
+          if(opaque == 0 && o){
+            opaque = 1;
+          }else if(opaque == 1 && !o){
+            opaque = 2;
+          }else if(opaque == 2){
+            CHECK(!o);
+          }
+        }
+      }
+      uint32_t px;
+      CHECK(0 == ncvisual_at_yx(ncv, geom.pixy / 2, geom.pixx / 2, &px));
+      CHECK(htole(0xff204080) == px);
+      ncvisual_destroy(ncv);
+    }
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
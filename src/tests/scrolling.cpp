@@ -309,6 +309,152 @@ TEST_CASE("Scrolling") {
     CHECK(0 == ncplane_destroy(np));
   }
 
+  // scrolling many rows at once must be equivalent to scrolling them singly
+  SUBCASE("BulkScrollMatchesSingle") {
+    struct ncplane_options nopts{};
+    nopts.y = 1;
+    nopts.rows = 8;
+    nopts.cols = 10;
+    nopts.flags = NCPLANE_OPTION_VSCROLL;
+    ncplane* planes[2];
+    ncplane* kids[2];
+    for(unsigned i = 0 ; i < 2 ; ++i){
+      planes[i] = ncplane_create(n_, &nopts);
+      REQUIRE(nullptr != planes[i]);
+      for(unsigned y = 0 ; y < nopts.rows ; ++y){
+        CHECK(3 == ncplane_printf_yx(planes[i], y, 0, "%c%c%c", 'a' + y, 'a' + y, 'a' + y));
+      }
+      struct ncplane_options kopts{};
+      kopts.y = 3;
+      kopts.x = 2;
+      kopts.rows = 2;
+      kopts.cols = 4;
+      kids[i] = ncplane_create(planes[i], &kopts);
+      REQUIRE(nullptr != kids[i]);
+    }
+    for(unsigned r : {3u, 4u, 20u}){
+      CHECK(0 == ncplane_scrollup(planes[0], r));
+      for(unsigned s = 0 ; s < r ; ++s){
+        CHECK(0 == ncplane_scrollup(planes[1], 1));
+      }
+      for(unsigned y = 0 ; y < nopts.rows ; ++y){
+        char* c0 = ncplane_contents(planes[0], y, 0, 1, 0);
+        char* c1 = ncplane_contents(planes[1], y, 0, 1, 0);
+        REQUIRE(c0);
+        REQUIRE(c1);
+        CHECK(0 == strcmp(c0, c1));
+        free(c0);
+        free(c1);
+      }
+      CHECK(ncplane_y(kids[0]) == ncplane_y(kids[1]));
+      unsigned y0, x0, y1, x1;
+      ncplane_cursor_yx(planes[0], &y0, &x0);
+      ncplane_cursor_yx(planes[1], &y1, &x1);
+      CHECK(y0 == y1);
+      CHECK(x0 == x1);
+    }
+    // the kid stopped once it no longer intersected its parent
+    CHECK(-2 == ncplane_y(kids[0]));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_destroy(planes[0]));
+    CHECK(0 == ncplane_destroy(planes[1]));
+  }
+
+  // a full-width scrolling plane beneath a header might be scrolled by the
+  // terminal itself; what was rendered must be the same either way
+  SUBCASE("FullWidthPlaneScrolls") {
+    unsigned dimy, dimx;
+    ncplane_dim_yx(n_, &dimy, &dimx);
+    REQUIRE(6 <= dimy);
+    CHECK(0 < ncplane_putstr_yx(n_, 0, 0, "header"));
+    struct ncplane_options nopts{};
+    nopts.y = 1;
+    nopts.rows = dimy - 2;
+    nopts.cols = dimx;
+    nopts.flags = NCPLANE_OPTION_VSCROLL;
+    auto np = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != np);
+    CHECK(0 < ncplane_putstr_yx(n_, dimy - 1, 0, "footer"));
+    for(unsigned i = 0 ; i < nopts.rows ; ++i){
+      CHECK(0 < ncplane_printf(np, "%s%03u", i ? "\n" : "", i));
+    }
+    CHECK(0 == notcurses_render(nc_));
+    for(unsigned i = nopts.rows ; i < nopts.rows + 3 ; ++i){
+      CHECK(0 < ncplane_printf(np, "\n%03u", i));
+      CHECK(0 == notcurses_render(nc_));
+      for(unsigned y = 0 ; y < nopts.rows ; ++y){
+        char* egc = notcurses_at_yx(nc_, y + 1, 2, nullptr, nullptr);
+        REQUIRE(egc);
+        CHECK(egc[0] == '0' + (i - nopts.rows + 1 + y) % 10);
+        free(egc);
+      }
+    }
+    char* egc = notcurses_at_yx(nc_, 0, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "h"));
+    free(egc);
+    egc = notcurses_at_yx(nc_, dimy - 1, 0, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "f"));
+    free(egc);
+    CHECK(0 == ncplane_destroy(np));
+  }
+
+  // rows scrolled out are retained up to the cap, and can be brought back
+  // into view without disturbing the live plane
+  SUBCASE("Scrollback") {
+    struct ncplane_options nopts{};
+    nopts.y = 1;
+    nopts.rows = 3;
+    nopts.cols = 10;
+    nopts.flags = NCPLANE_OPTION_VSCROLL;
+    auto np = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != np);
+    CHECK(0 == ncplane_scrollback_lines(np));
+    CHECK(0 == ncplane_scrollback_view(np, 3));
+    CHECK(0 == ncplane_set_scrollback(np, 5));
+    for(unsigned i = 0 ; i < 10 ; ++i){
+      CHECK(0 < ncplane_printf(np, "%sl%u", i ? "\n" : "", i));
+    }
+    CHECK(5 == ncplane_scrollback_lines(np));
+    auto shown = [&](const char* expect){
+      CHECK(0 == notcurses_render(nc_));
+      for(unsigned y = 0 ; y < nopts.rows ; ++y){
+        char* egc = notcurses_at_yx(nc_, y + 1, 1, nullptr, nullptr);
+        REQUIRE(egc);
+        CHECK(egc[0] == expect[y]);
+        free(egc);
+      }
+    };
+    shown("789");
+    CHECK(2 == ncplane_scrollback_view(np, 2));
+    shown("567");
+    CHECK(5 == ncplane_scrollback_view(np, 100));
+    shown("234");
+    // the live plane is unaffected
+    char* egc = ncplane_at_yx(np, 0, 1, nullptr, nullptr);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "7"));
+    free(egc);
+    // output evicts the oldest row; the view stays with what remains
+    CHECK(0 < ncplane_putstr(np, "\nla"));
+    CHECK(5 == ncplane_scrollback_lines(np));
+    shown("345");
+    CHECK(0 == ncplane_scrollback_view(np, 0));
+    shown("89a");
+    // the live rows scroll into history, where they can be viewed
+    CHECK(0 == ncplane_scrollup(np, 2));
+    CHECK(3 == ncplane_scrollback_view(np, 3));
+    shown("789");
+    // shrinking the cap keeps the most recent rows
+    CHECK(0 == ncplane_set_scrollback(np, 2));
+    CHECK(2 == ncplane_scrollback_lines(np));
+    shown("89a");
+    CHECK(0 == ncplane_set_scrollback(np, 0));
+    CHECK(0 == ncplane_scrollback_lines(np));
+    CHECK(0 == ncplane_destroy(np));
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
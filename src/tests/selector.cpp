@@ -314,5 +314,62 @@ TEST_CASE("Selectors") {
     ncselector_destroy(ncs, nullptr);
   }
 
+  // a source of 100k sorted items, of which only those displayed (and those
+  // probed by the filter's binary search) ought be fetched
+  SUBCASE("SourcedSelector") {
+    struct bigsource {
+      unsigned fetched;
+      char opt[16];
+    } bs{};
+    ncselector_source src{};
+    src.count = [](void*) -> unsigned { return 100000; };
+    src.item = [](void* curry, unsigned idx, ncselector_item* item) -> int {
+      auto b = static_cast<bigsource*>(curry);
+      ++b->fetched;
+      snprintf(b->opt, sizeof(b->opt), "item%06u", idx);
+      item->option = b->opt;
+      item->desc = "sourced";
+      return 0;
+    };
+    src.curry = &bs;
+    struct ncselector_options opts{};
+    opts.maxdisplay = 4;
+    struct ncplane_options nopts{};
+    nopts.rows = 1;
+    nopts.cols = 1;
+    struct ncplane* n = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != n);
+    struct ncselector* ncs = ncselector_create_source(n, &opts, &src);
+    REQUIRE(nullptr != ncs);
+    CHECK(0 == notcurses_render(nc_));
+    auto sel = ncselector_selected(ncs);
+    REQUIRE(nullptr != sel);
+    CHECK(0 == strcmp(sel, "item000000"));
+    sel = ncselector_previtem(ncs);
+    REQUIRE(nullptr != sel);
+    CHECK(0 == strcmp(sel, "item099999"));
+    CHECK(0 == ncselector_filter(ncs, "item0123"));
+    sel = ncselector_selected(ncs);
+    REQUIRE(nullptr != sel);
+    CHECK(0 == strcmp(sel, "item012300"));
+    CHECK(0 == ncselector_filter(ncs, "item01234"));
+    sel = ncselector_previtem(ncs);
+    REQUIRE(nullptr != sel);
+    CHECK(0 == strcmp(sel, "item012349"));
+    CHECK(0 == ncselector_filter(ncs, "nothing"));
+    CHECK(nullptr == ncselector_selected(ncs));
+    CHECK(0 == ncselector_filter(ncs, nullptr));
+    sel = ncselector_selected(ncs);
+    REQUIRE(nullptr != sel);
+    CHECK(0 == strcmp(sel, "item000000"));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(1000 > bs.fetched);
+    char* item = nullptr;
+    ncselector_destroy(ncs, &item);
+    REQUIRE(nullptr != item);
+    CHECK(0 == strcmp(item, "item000000"));
+    free(item);
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 }
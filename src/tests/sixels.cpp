@@ -45,6 +45,36 @@ TEST_CASE("Sixels") {
     return;
   }
 
+  // a repeated blit is served from the encoding cache, and must be
+  // indistinguishable from the original
+  SUBCASE("SixelCacheRepeat") {
+    std::vector<uint32_t> v(48 * 48);
+    for(unsigned i = 0 ; i < v.size() ; ++i){
+      v[i] = htole(0xff000000ul | (i * 0x010305ul));
+    }
+    auto ncv = ncvisual_from_rgba(v.data(), 48, 48 * 4, 48);
+    REQUIRE(ncv);
+    struct ncvisual_options vopts{};
+    vopts.n = n_;
+    vopts.blitter = NCBLIT_PIXEL;
+    vopts.flags = NCVISUAL_OPTION_NODEGRADE | NCVISUAL_OPTION_CHILDPLANE;
+    auto n1 = ncvisual_blit(nc_, ncv, &vopts);
+    REQUIRE(nullptr != n1);
+    vopts.y = ncplane_dim_y(n1); // stack them without overlap
+    auto n2 = ncvisual_blit(nc_, ncv, &vopts);
+    REQUIRE(nullptr != n2);
+    CHECK(0 == notcurses_render(nc_));
+    REQUIRE(n1->sprite->glyph.used == n2->sprite->glyph.used);
+    CHECK(0 == memcmp(n1->sprite->glyph.buf, n2->sprite->glyph.buf, n1->sprite->glyph.used));
+    unsigned cells = n1->sprite->dimy * n1->sprite->dimx;
+    for(unsigned i = 0 ; i < cells ; ++i){
+      CHECK(n1->tam[i].state == n2->tam[i].state);
+    }
+    CHECK(0 == ncplane_destroy(n1));
+    CHECK(0 == ncplane_destroy(n2));
+    ncvisual_destroy(ncv);
+  }
+
 #ifdef NOTCURSES_USE_MULTIMEDIA
   SUBCASE("SixelRoundtrip") {
     CHECK(1 == ncplane_set_base(n_, "&", 0, 0));
@@ -1,4 +1,5 @@
 #include "main.h"
+#include <vector>
 
 // These tests address cases where box characters on two overlapping planes
 // interact in non-trivial ways. A simple example is a U2580 UPPER HALF BLOCK
@@ -255,6 +256,59 @@ TEST_CASE("Stacking") {
     }
   }
 
+  // translucent planes stacked atop one another must be averaged exactly as
+  // channels_blend() would, however many cells are blended at once
+  SUBCASE("BlendedRow") {
+    ncplane_erase(n_);
+    CHECK(0 == ncplane_set_bg_rgb(n_, 0x102030));
+    for(unsigned x = 0 ; x < dimx ; ++x){
+      CHECK(1 == ncplane_putchar_yx(n_, 0, x, ' '));
+    }
+    auto rgbfor = [](unsigned i, unsigned x){
+      return (((x * 37 + i * 71) % 256) << 16u) + (((x * 13 + i * 29) % 256) << 8u) +
+             ((x * 101 + i * 7) % 256);
+    };
+    const unsigned count = 5;
+    std::vector<ncplane*> planes;
+    for(unsigned i = 0 ; i < count ; ++i){
+      struct ncplane_options opts = {
+        0, 0, 1, dimx, nullptr, "blend", nullptr, 0, 0, 0,
+      };
+      auto p = ncplane_create(n_, &opts);
+      REQUIRE(nullptr != p);
+      for(unsigned x = 0 ; x < dimx ; ++x){
+        nccell c = NCCELL_CHAR_INITIALIZER(' ');
+        CHECK(0 == nccell_set_bg_rgb(&c, rgbfor(i, x)));
+        CHECK(0 == nccell_set_bg_alpha(&c, NCALPHA_BLEND));
+        CHECK(0 < ncplane_putc_yx(p, 0, x, &c));
+      }
+      planes.push_back(p);
+    }
+    CHECK(0 == notcurses_render(nc_));
+    for(unsigned x = 0 ; x < dimx ; ++x){
+      uint32_t expect = 0;
+      ncchannel_set_alpha(&expect, NCALPHA_TRANSPARENT);
+      unsigned blends = 0;
+      for(unsigned i = count ; i-- ; ){ // most recently created is on top
+        uint32_t c = 0;
+        ncchannel_set(&c, rgbfor(i, x));
+        ncchannel_set_alpha(&c, NCALPHA_BLEND);
+        expect = channels_blend(nc_, expect, c, &blends, nc_->tcache.bg_collides_default);
+      }
+      uint32_t c = 0;
+      ncchannel_set(&c, 0x102030);
+      expect = channels_blend(nc_, expect, c, &blends, nc_->tcache.bg_collides_default);
+      uint64_t channels;
+      auto egc = notcurses_at_yx(nc_, 0, x, nullptr, &channels);
+      REQUIRE(nullptr != egc);
+      free(egc);
+      CHECK(ncchannel_rgb(expect) == ncchannels_bg_rgb(channels));
+    }
+    for(auto p : planes){
+      CHECK(0 == ncplane_destroy(p));
+    }
+  }
+
   // common teardown
   CHECK(0 == notcurses_stop(nc_));
 }
@@ -337,6 +337,59 @@ TEST_CASE("Tabbed") {
     nctabbed_destroy(nt);
   }
 
+  // a change of selection redraws only the affected headers; the result
+  // must match a full redraw
+  SUBCASE("RedrawSelection") {
+    struct ncplane_options nopts = {
+      .y = 1, .x = 2, .rows = ncplane_dim_y(n_) - 2, .cols = ncplane_dim_x(n_) - 4,
+      .userptr = nullptr, .name = nullptr, .resizecb = nullptr, .flags = 0,
+      .margin_b = 0, .margin_r = 0,
+    };
+    struct nctabbed_options opts = {
+      .selchan = NCCHANNELS_INITIALIZER(0, 255, 0, 0, 0, 0),
+      .hdrchan = NCCHANNELS_INITIALIZER(255, 0, 0, 0, 0, 0),
+      .sepchan = NCCHANNELS_INITIALIZER(0, 0, 255, 0, 0, 0),
+      .separator = const_cast<char*>("|"),
+      .flags = 0,
+    };
+    auto ncp = ncplane_create(n_, &nopts);
+    auto nt = nctabbed_create(ncp, &opts);
+    REQUIRE(nullptr != nt);
+    auto t1 = nctabbed_add(nt, nullptr, nullptr, tabbedcb, "tab1", nullptr);
+    auto t2 = nctabbed_add(nt, t1, nullptr, tabbedcb, "tab2", nullptr);
+    auto t3 = nctabbed_add(nt, t2, nullptr, tabbedcb, "tab3", nullptr);
+    REQUIRE(nullptr != t3);
+    // each header is 4 columns plus a 1-column separator
+    auto hdrfg = [&](int idx){
+      uint16_t stylemask;
+      uint64_t channels;
+      char* egc = notcurses_at_yx(nc_, 1, 2 + idx * 5, &stylemask, &channels);
+      REQUIRE(nullptr != egc);
+      CHECK(0 == strcmp(egc, "t"));
+      free(egc);
+      return ncchannels_fg_rgb(channels);
+    };
+    nctabbed_redraw(nt);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0x00ff00 == hdrfg(0));
+    CHECK(0xff0000 == hdrfg(1));
+    CHECK(0xff0000 == hdrfg(2));
+    nctabbed_select(nt, t3);
+    nctabbed_redraw(nt);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0xff0000 == hdrfg(0));
+    CHECK(0xff0000 == hdrfg(1));
+    CHECK(0x00ff00 == hdrfg(2));
+    CHECK(t2 == nctabbed_prev(nt));
+    nctabbed_set_hdrchan(nt, NCCHANNELS_INITIALIZER(0, 0, 255, 0, 0, 0));
+    nctabbed_redraw(nt);
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0x0000ff == hdrfg(0));
+    CHECK(0x00ff00 == hdrfg(1));
+    CHECK(0x0000ff == hdrfg(2));
+    nctabbed_destroy(nt);
+  }
+
   SUBCASE("NextPrev") {
     struct ncplane_options nopts = {
       .y = 1, .x = 2, .rows = ncplane_dim_y(n_) - 2, .cols = ncplane_dim_x(n_) - 4,
@@ -0,0 +1,90 @@
+#include "main.h"
+#include <string>
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+
+// remove the termcache entries (and directories) created beneath |dir|
+static void
+remove_cachedir(const std::string& dir){
+  std::string sub = dir + "/notcurses";
+  DIR* d = opendir(sub.c_str());
+  if(d){
+    struct dirent* de;
+    while( (de = readdir(d)) ){
+      if(strncmp(de->d_name, "termcache-", 10) == 0){
+        unlink((sub + "/" + de->d_name).c_str());
+      }
+    }
+    closedir(d);
+  }
+  rmdir(sub.c_str());
+  rmdir(dir.c_str());
+}
+
+TEST_CASE("TermCache") {
+  char tmpl[] = "/tmp/notcurses-termcache-XXXXXX";
+  REQUIRE(nullptr != mkdtemp(tmpl));
+  std::string dir = tmpl;
+  setenv("XDG_CACHE_HOME", dir.c_str(), 1);
+  setenv("NOTCURSES_TERMCACHE", "1", 1);
+  auto nc = testing_notcurses();
+  if(!nc){
+    remove_cachedir(dir);
+    unsetenv("NOTCURSES_TERMCACHE");
+    unsetenv("XDG_CACHE_HOME");
+    return;
+  }
+  const nccapabilities fresh = *notcurses_capabilities(nc);
+  auto freshpixel = notcurses_check_pixel_support(nc);
+  uint32_t freshbg = 0;
+  int freshbgret = notcurses_default_background(nc, &freshbg);
+  CHECK(0 == notcurses_stop(nc));
+
+  // the second run is served from the entry written by the first, and must
+  // arrive at the same capabilities.
+  SUBCASE("CachedMatchesFresh") {
+    nc = testing_notcurses();
+    REQUIRE(nullptr != nc);
+    const nccapabilities* cached = notcurses_capabilities(nc);
+    CHECK(fresh.rgb == cached->rgb);
+    CHECK(fresh.colors == cached->colors);
+    CHECK(fresh.utf8 == cached->utf8);
+    CHECK(fresh.can_change_colors == cached->can_change_colors);
+    CHECK(freshpixel == notcurses_check_pixel_support(nc));
+    uint32_t bg = 0;
+    CHECK(freshbgret == notcurses_default_background(nc, &bg));
+    if(freshbgret == 0){
+      CHECK(freshbg == bg);
+    }
+    CHECK(0 == notcurses_render(nc));
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  // garbage in the entry must be ignored, not trusted
+  SUBCASE("CorruptEntryIgnored") {
+    std::string sub = dir + "/notcurses";
+    DIR* d = opendir(sub.c_str());
+    if(d){
+      struct dirent* de;
+      while( (de = readdir(d)) ){
+        if(strncmp(de->d_name, "termcache-", 10) == 0){
+          FILE* fp = fopen((sub + "/" + de->d_name).c_str(), "w");
+          REQUIRE(nullptr != fp);
+          fprintf(fp, "this is not a termcache entry\n");
+          fclose(fp);
+        }
+      }
+      closedir(d);
+    }
+    nc = testing_notcurses();
+    REQUIRE(nullptr != nc);
+    CHECK(fresh.rgb == notcurses_capabilities(nc)->rgb);
+    CHECK(freshpixel == notcurses_check_pixel_support(nc));
+    CHECK(0 == notcurses_stop(nc));
+  }
+
+  remove_cachedir(dir);
+  unsetenv("NOTCURSES_TERMCACHE");
+  unsetenv("XDG_CACHE_HOME");
+}
@@ -0,0 +1,78 @@
+#include "main.h"
+#include <vector>
+#include <string>
+
+// paint a stack of overlapping, partially transparent planes, render, and
+// return the contents of the last frame.
+static auto
+render_stack(struct notcurses* nc) -> std::vector<std::string> {
+  unsigned dimy, dimx;
+  auto n = notcurses_stddim_yx(nc, &dimy, &dimx);
+  std::vector<struct ncplane*> planes;
+  for(unsigned i = 0 ; i < 16 ; ++i){
+    struct ncplane_options nopts{};
+    nopts.y = i % dimy;
+    nopts.x = (i * 3) % dimx;
+    nopts.rows = dimy / 2 + 1;
+    nopts.cols = dimx / 2 + 1;
+    auto p = ncplane_create(n, &nopts);
+    REQUIRE(nullptr != p);
+    uint64_t channels = NCCHANNELS_INITIALIZER(0x10 * i, 0x80, 0xff - 0x10 * i,
+                                               0x20, 0x10 * i, 0x40);
+    if(i % 2){
+      ncchannels_set_bg_alpha(&channels, NCALPHA_BLEND);
+    }
+    CHECK(0 <= ncplane_set_base(p, i % 3 ? "" : "x", 0, channels));
+    for(unsigned y = 0 ; y < ncplane_dim_y(p) ; y += 2){
+      CHECK(0 < ncplane_putstr_yx(p, y, i % 4, "threads"));
+    }
+    planes.push_back(p);
+  }
+  CHECK(0 == notcurses_render(nc));
+  std::vector<std::string> frame;
+  for(unsigned y = 0 ; y < dimy ; ++y){
+    for(unsigned x = 0 ; x < dimx ; ++x){
+      uint16_t stylemask;
+      uint64_t channels;
+      auto egc = notcurses_at_yx(nc, y, x, &stylemask, &channels);
+      REQUIRE(nullptr != egc);
+      frame.push_back(std::string(egc) + std::to_string(channels));
+      free(egc);
+    }
+  }
+  for(auto p : planes){
+    CHECK(0 == ncplane_destroy(p));
+  }
+  return frame;
+}
+
+TEST_CASE("ThreadedRender") {
+  auto nc_ = testing_notcurses();
+  if(!nc_){
+    return;
+  }
+  ncstats stats;
+  notcurses_stats(nc_, &stats);
+  CHECK(1 == stats.render_threads);
+  auto serial = render_stack(nc_);
+  CHECK(0 == notcurses_stop(nc_));
+
+  // band-parallel painting must produce exactly the same frame
+  SUBCASE("MatchesSerial") {
+    setenv("NOTCURSES_RENDER_THREADS", "4", 1);
+    notcurses_options nopts{};
+    nopts.loglevel = loglevel;
+    nopts.flags = NCOPTION_SUPPRESS_BANNERS
+                  | NCOPTION_NO_ALTERNATE_SCREEN
+                  | NCOPTION_DRAIN_INPUT
+                  | NCOPTION_THREADED_RENDER;
+    auto nc = notcurses_init(&nopts, nullptr);
+    REQUIRE(nullptr != nc);
+    notcurses_stats(nc, &stats);
+    CHECK(4 == stats.render_threads);
+    auto threaded = render_stack(nc);
+    CHECK(serial == threaded);
+    CHECK(0 == notcurses_stop(nc));
+    unsetenv("NOTCURSES_RENDER_THREADS");
+  }
+}
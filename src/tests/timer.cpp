@@ -0,0 +1,122 @@
+#include "main.h"
+#include <time.h>
+
+namespace {
+
+struct ticks {
+  int calls;
+  unsigned missed;
+  int ret;
+};
+
+int tickcb(struct notcurses*, void* curry, unsigned missed){
+  auto t = static_cast<ticks*>(curry);
+  ++t->calls;
+  t->missed += missed;
+  return t->ret;
+}
+
+// read input until an NCKEY_TIMER arrives, or |ms| milliseconds pass.
+// returns true if we got the timer event, which is written to |ni|.
+bool await_timer(struct notcurses* nc, unsigned ms, ncinput* ni){
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  deadline.tv_sec += ms / 1000;
+  deadline.tv_nsec += (ms % 1000) * 1000000l;
+  if(deadline.tv_nsec >= 1000000000l){
+    ++deadline.tv_sec;
+    deadline.tv_nsec -= 1000000000l;
+  }
+  uint32_t id;
+  while((id = notcurses_get(nc, &deadline, ni)) != 0 && id != (uint32_t)-1){
+    if(id == NCKEY_TIMER){
+      return true;
+    }
+  }
+  return false;
+}
+
+}
+
+// timers are delivered as NCKEY_TIMER events, which a draining context
+// discards, so we make our own.
+TEST_CASE("Timers") {
+  notcurses_options nopts{};
+  nopts.loglevel = loglevel;
+  nopts.flags = NCOPTION_SUPPRESS_BANNERS | NCOPTION_NO_ALTERNATE_SCREEN;
+  auto nc_ = notcurses_init(&nopts, nullptr);
+  if(!nc_){
+    return;
+  }
+  const uint64_t ms = 1000000ull;
+  ncinput ni;
+
+  // a one-shot timer fires once, and is then gone
+  SUBCASE("OneShot") {
+    ticks t{};
+    int id = notcurses_timer_add(nc_, 5 * ms, 0, tickcb, &t);
+    CHECK(0 < id);
+    CHECK(await_timer(nc_, 1000, &ni));
+    CHECK(1 == t.calls);
+    CHECK(0 == t.missed);
+    CHECK(0 == ni.recvns);
+    CHECK(0 > notcurses_timer_del(nc_, id));
+    CHECK(!await_timer(nc_, 30, &ni));
+    CHECK(1 == t.calls);
+  }
+
+  // timers sharing a period are aligned to it, and fire together
+  SUBCASE("Coalesced") {
+    ticks a{}, b{};
+    int ida = notcurses_timer_add(nc_, 0, 20 * ms, tickcb, &a);
+    int idb = notcurses_timer_add(nc_, 0, 20 * ms, tickcb, &b);
+    CHECK(0 < ida);
+    CHECK(0 < idb);
+    CHECK(ida != idb);
+    CHECK(await_timer(nc_, 1000, &ni));
+    CHECK(0 < a.calls);
+    CHECK(a.calls == b.calls);
+    CHECK(0 == notcurses_timer_del(nc_, ida));
+    CHECK(0 == notcurses_timer_del(nc_, idb));
+  }
+
+  // a periodic timer which falls behind is called once for the lot
+  SUBCASE("Behind") {
+    ticks t{};
+    int id = notcurses_timer_add(nc_, 2 * ms, 2 * ms, tickcb, &t);
+    CHECK(0 < id);
+    struct timespec nap = { 0, 50000000l };
+    nanosleep(&nap, nullptr);
+    CHECK(await_timer(nc_, 1000, &ni));
+    CHECK(1 == t.calls);
+    CHECK(0 < t.missed);
+    CHECK(t.missed == ni.coalesced);
+    CHECK(0 == notcurses_timer_del(nc_, id));
+  }
+
+  // a callback returning non-zero cancels its timer
+  SUBCASE("Cancel") {
+    ticks t{};
+    t.ret = 1;
+    int id = notcurses_timer_add(nc_, 0, 5 * ms, tickcb, &t);
+    CHECK(0 < id);
+    CHECK(await_timer(nc_, 1000, &ni));
+    CHECK(1 == t.calls);
+    CHECK(0 > notcurses_timer_del(nc_, id));
+    CHECK(!await_timer(nc_, 30, &ni));
+    CHECK(1 == t.calls);
+  }
+
+  // deleting a timer discards its expirations
+  SUBCASE("Delete") {
+    ticks t{};
+    int id = notcurses_timer_add(nc_, 5 * ms, 0, tickcb, &t);
+    CHECK(0 < id);
+    CHECK(0 == notcurses_timer_del(nc_, id));
+    CHECK(0 > notcurses_timer_del(nc_, id));
+    CHECK(!await_timer(nc_, 30, &ni));
+    CHECK(0 == t.calls);
+  }
+
+  CHECK(0 == notcurses_stop(nc_));
+}
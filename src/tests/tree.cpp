@@ -565,5 +565,69 @@ TEST_CASE("Tree") {
     nctree_destroy(tree);
   }
 
+  // 1000 top-level items of 200 children apiece, supplied by a source. only
+  // the top level ought be fetched until an item is expanded.
+  SUBCASE("SourcedTree") {
+    struct treesource {
+      unsigned fetches;
+    } ts{};
+    struct ncplane_options nopts{};
+    nopts.rows = 7;
+    nopts.cols = 20;
+    auto p = ncplane_create(n_, &nopts);
+    REQUIRE(p);
+    struct nctree_options topts{};
+    topts.nctreecb = [](struct ncplane* n, void* curry, int) -> int {
+      if(n){
+        ncplane_printf_yx(n, 0, 0, "%lu", static_cast<unsigned long>(reinterpret_cast<uintptr_t>(curry)));
+        ncplane_resize_simple(n, 1, ncplane_dim_x(n));
+      }
+      return 0;
+    };
+    topts.indentcols = 2;
+    nctree_source src{};
+    src.subcount = [](void* opaque, void* item) -> unsigned {
+      ++static_cast<treesource*>(opaque)->fetches;
+      if(item == nullptr){
+        return 1000;
+      }
+      return reinterpret_cast<uintptr_t>(item) < (1u << 20) ? 200 : 0;
+    };
+    src.sub = [](void*, void* item, unsigned idx) -> void* {
+      uintptr_t parent = reinterpret_cast<uintptr_t>(item);
+      return reinterpret_cast<void*>((parent << 20) + idx + 1);
+    };
+    src.opaque = &ts;
+    struct nctree* tree = nctree_create_source(p, &topts, &src);
+    REQUIRE(nullptr != tree);
+    CHECK(1 == ts.fetches);
+    CHECK(0 == notcurses_render(nc_));
+    auto item0 = nctree_focused(tree);
+    CHECK(1 == reinterpret_cast<uintptr_t>(item0));
+    // collapsed, so we move to the next top-level item
+    CHECK(2 == reinterpret_cast<uintptr_t>(nctree_next(tree)));
+    CHECK(item0 == nctree_prev(tree));
+    CHECK(0 == nctree_expand(tree, true));
+    CHECK(2 == ts.fetches);
+    CHECK(((1u << 20) + 1) == reinterpret_cast<uintptr_t>(nctree_next(tree)));
+    for(int i = 0 ; i < 50 ; ++i){
+      nctree_next(tree);
+      CHECK(0 == nctree_redraw(tree));
+    }
+    CHECK(0 == notcurses_render(nc_));
+    // nothing but the expanded item's children ought have been fetched
+    CHECK(2 == ts.fetches);
+    const unsigned path[] = { 0, UINT_MAX };
+    CHECK(-1 == nctree_del(tree, path));
+    while(nctree_focused(tree) != item0){
+      nctree_prev(tree);
+    }
+    CHECK(0 == nctree_expand(tree, false));
+    CHECK(2 == reinterpret_cast<uintptr_t>(nctree_next(tree)));
+    CHECK(0 == nctree_redraw(tree));
+    CHECK(0 == notcurses_render(nc_));
+    nctree_destroy(tree);
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 }
@@ -1,6 +1,7 @@
 #include "main.h"
 #include "lib/visual-details.h"
 #include <vector>
+#include <thread>
 #include <cmath>
 
 // verify results for extrinsic geometries with NULL or default vopts
@@ -220,6 +221,99 @@ TEST_CASE("Visual") {
     ncvisual_destroy(ncv);
   }
 
+  // wide enough to exercise both the vectorized conversion and its tail
+  SUBCASE("VisualFromRGBPackedWide") {
+    constexpr int COLS = 37;
+    constexpr int ROWS = 3;
+    unsigned char rgb[ROWS * COLS * 3];
+    for(size_t i = 0 ; i < sizeof(rgb) ; ++i){
+      rgb[i] = i * 7;
+    }
+    unsigned char alpha = 0x80;
+    auto ncv = ncvisual_from_rgb_packed(rgb, ROWS, COLS * 3, COLS, alpha);
+    REQUIRE(nullptr != ncv);
+    for(int y = 0 ; y < ROWS ; ++y){
+      for(int x = 0 ; x < COLS ; ++x){
+        uint32_t p;
+        CHECK(0 == ncvisual_at_yx(ncv, y, x, &p));
+        CHECK(ncpixel_r(p) == rgb[y * COLS * 3 + x * 3]);
+        CHECK(ncpixel_g(p) == rgb[y * COLS * 3 + x * 3 + 1]);
+        CHECK(ncpixel_b(p) == rgb[y * COLS * 3 + x * 3 + 2]);
+        CHECK(ncpixel_a(p) == alpha);
+      }
+    }
+    ncvisual_destroy(ncv);
+  }
+
+  // an owned BGRA buffer converted in place matches a copied one
+  SUBCASE("VisualFromBGRAOwned") {
+    constexpr int COLS = 37;
+    constexpr int ROWS = 5;
+    constexpr int STRIDE = COLS * 4 + 8;
+    auto bgra = static_cast<unsigned char*>(malloc(ROWS * STRIDE));
+    REQUIRE(nullptr != bgra);
+    for(int i = 0 ; i < ROWS * STRIDE ; ++i){
+      bgra[i] = i * 13;
+    }
+    auto copied = ncvisual_from_bgra(bgra, ROWS, STRIDE, COLS);
+    REQUIRE(nullptr != copied);
+    CHECK(nullptr == ncvisual_from_bgra_owned(bgra, ROWS, COLS * 4 - 4, COLS));
+    auto owned = ncvisual_from_bgra_owned(bgra, ROWS, STRIDE, COLS);
+    REQUIRE(nullptr != owned);
+    for(int y = 0 ; y < ROWS ; ++y){
+      for(int x = 0 ; x < COLS ; ++x){
+        uint32_t p, q;
+        CHECK(0 == ncvisual_at_yx(copied, y, x, &p));
+        CHECK(0 == ncvisual_at_yx(owned, y, x, &q));
+        CHECK(p == q);
+        CHECK(ncpixel_b(q) == (unsigned char)((y * STRIDE + x * 4) * 13));
+      }
+    }
+    ncvisual_destroy(owned);
+    ncvisual_destroy(copied);
+  }
+
+  // borrowed memory is read in place, never written, and handed back once
+  SUBCASE("VisualFromRGBABorrowed") {
+    constexpr int COLS = 16;
+    constexpr int ROWS = 8;
+    std::vector<uint32_t> rgba(COLS * ROWS, htole(0xff336699));
+    struct lent {
+      void* data;
+      int releases;
+    } l = { nullptr, 0 };
+    auto release = [](void* data, void* curry){
+      auto lp = static_cast<lent*>(curry);
+      lp->data = data;
+      ++lp->releases;
+    };
+    auto ncv = ncvisual_from_rgba_borrowed(rgba.data(), ROWS, COLS * 4, COLS,
+                                           release, &l);
+    REQUIRE(nullptr != ncv);
+    uint32_t p;
+    CHECK(0 == ncvisual_at_yx(ncv, 1, 1, &p));
+    CHECK(htole(0xff336699) == p);
+    // changes to the lent pixels are visible
+    rgba[COLS + 1] = htole(0xff000000);
+    CHECK(0 == ncvisual_at_yx(ncv, 1, 1, &p));
+    CHECK(htole(0xff000000) == p);
+    struct ncvisual_options vopts{};
+    vopts.n = n_;
+    vopts.blitter = NCBLIT_1x1;
+    CHECK(nullptr != ncvisual_blit(nc_, ncv, &vopts));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == l.releases);
+    // writing through the visual copies, and returns the loan
+    CHECK(0 == ncvisual_set_yx(ncv, 0, 0, htole(0xffffffff)));
+    CHECK(1 == l.releases);
+    CHECK(rgba.data() == l.data);
+    CHECK(htole(0xff336699) == rgba[0]);
+    CHECK(0 == ncvisual_at_yx(ncv, 0, 0, &p));
+    CHECK(htole(0xffffffff) == p);
+    ncvisual_destroy(ncv);
+    CHECK(1 == l.releases);
+  }
+
   // resize followed by rotate, see #1800
   SUBCASE("ResizeThenRotateFromMemory") {
     unsigned char rgb[90];
@@ -435,6 +529,46 @@ TEST_CASE("Visual") {
     CHECK(0 == notcurses_render(nc_));
   }
 
+  // at most one scaling quality may be requested
+  SUBCASE("ScaleQualities") {
+    std::vector<uint32_t> rgba(16 * 16, htole(0xff88bbccull));
+    auto ncv = ncvisual_from_rgba(rgba.data(), 16, 16 * 4, 16);
+    REQUIRE(ncv);
+    struct ncvisual_options opts{};
+    opts.blitter = NCBLIT_1x1;
+    opts.scaling = NCSCALE_STRETCH;
+    opts.n = ncp_;
+    opts.flags = NCVISUAL_OPTION_SCALEFAST | NCVISUAL_OPTION_SCALEFINE;
+    CHECK(nullptr == ncvisual_blit(nc_, ncv, &opts));
+    for(auto q : { NCVISUAL_OPTION_SCALEFAST, NCVISUAL_OPTION_SCALEAREA,
+                   NCVISUAL_OPTION_SCALEFINE }){
+      opts.flags = q;
+      CHECK(ncp_ == ncvisual_blit(nc_, ncv, &opts));
+    }
+    ncvisual_destroy(ncv);
+    CHECK(0 == notcurses_render(nc_));
+  }
+
+  // adaptive blits always succeed, whether made as bitmaps or cells, and
+  // the flag is meaningless to cell blitters
+  SUBCASE("AdaptiveBlits") {
+    std::vector<uint32_t> rgba(64 * 64, htole(0xff88bbccull));
+    auto ncv = ncvisual_from_rgba(rgba.data(), 64, 64 * 4, 64);
+    REQUIRE(ncv);
+    struct ncvisual_options opts{};
+    opts.n = ncp_;
+    opts.flags = NCVISUAL_OPTION_ADAPTIVE | NCVISUAL_OPTION_CHILDPLANE;
+    opts.blitter = notcurses_check_pixel_support(nc_) > 0 ? NCBLIT_PIXEL : NCBLIT_2x1;
+    for(int i = 0 ; i < 8 ; ++i){
+      auto n = ncvisual_blit(nc_, ncv, &opts);
+      REQUIRE(n);
+      CHECK(0 == notcurses_render(nc_));
+      CHECK(0 == ncplane_destroy(n));
+    }
+    ncvisual_destroy(ncv);
+    CHECK(0 == notcurses_render(nc_));
+  }
+
   SUBCASE("LoadBGRAFromMemory") {
     unsigned dimy, dimx;
     ncplane_dim_yx(ncp_, &dimy, &dimx);
@@ -955,5 +1089,120 @@ TEST_CASE("Visual") {
     CHECK(0 == ncplane_destroy(child));
   }
 
+  // a blit prepared on another thread lives in its own pile until it is
+  // attached, whereupon it is aligned against its new parent
+  SUBCASE("PreparedAttach") {
+    struct ncplane_options opts{};
+    opts.rows = 5;
+    opts.cols = 5;
+    auto parent = ncplane_create(n_, &opts);
+    REQUIRE(parent);
+    struct ncvisual_options vopts{};
+    vopts.y = NCALIGN_CENTER;
+    vopts.x = 1;
+    vopts.blitter = NCBLIT_1x1;
+    vopts.flags = NCVISUAL_OPTION_VERALIGNED;
+    const uint32_t pixels[1] = { htole(0xffffffff) };
+    auto ncv = ncvisual_from_rgba(pixels, 1, 4, 1);
+    REQUIRE(ncv);
+    struct ncprepared* prep = nullptr;
+    std::thread t([&]{ prep = ncvisual_prepare(nc_, ncv, &vopts); });
+    t.join();
+    REQUIRE(prep);
+    auto child = ncplane_attach_prepared(parent, prep);
+    REQUIRE(child);
+    CHECK(ncplane_pile(child) == ncplane_pile(parent));
+    CHECK(parent == ncplane_parent(child));
+    CHECK(1 == ncplane_dim_y(child));
+    CHECK(1 == ncplane_dim_x(child));
+    CHECK(2 == ncplane_y(child));
+    CHECK(1 == ncplane_x(child));
+    CHECK(0 == notcurses_render(nc_));
+    // an existing target plane is refused, and discards are clean
+    vopts.n = parent;
+    CHECK(nullptr == ncvisual_prepare(nc_, ncv, &vopts));
+    vopts.n = nullptr;
+    prep = ncvisual_prepare(nc_, ncv, &vopts);
+    REQUIRE(prep);
+    ncprepared_destroy(prep);
+    ncvisual_destroy(ncv);
+    CHECK(0 == ncplane_destroy(child));
+    CHECK(0 == ncplane_destroy(parent));
+  }
+
+  // only the tiles under the region are loaded, from the smallest level
+  // which still covers the rendered pixels, and reblits hit the cache
+  SUBCASE("TiledRegion") {
+    struct tilesrc {
+      int loads;
+      unsigned lastlevel;
+    } ts = { 0, 0 };
+    nctiled_source src{};
+    src.levels = 2;
+    src.tilepxy = 8;
+    src.tilepxx = 8;
+    src.level_geom = [](void*, unsigned level, unsigned* pxy, unsigned* pxx){
+      *pxy = *pxx = 64 >> level;
+      return 0;
+    };
+    src.load_tile = [](void* curry, unsigned level, unsigned, unsigned, uint32_t* rgba){
+      auto t = static_cast<tilesrc*>(curry);
+      ++t->loads;
+      t->lastlevel = level;
+      std::fill(rgba, rgba + 64, level ? htole(0xff00ff00) : htole(0xff0000ff));
+      return 0;
+    };
+    src.curry = &ts;
+    auto tiled = nctiled_create(&src, 0);
+    REQUIRE(nullptr != tiled);
+    unsigned pxy, pxx;
+    CHECK(0 == nctiled_geom(tiled, &pxy, &pxx));
+    CHECK(64 == pxy);
+    CHECK(64 == pxx);
+    struct ncvisual_options vopts{};
+    vopts.n = n_;
+    vopts.blitter = NCBLIT_1x1;
+    vopts.flags = NCVISUAL_OPTION_CHILDPLANE;
+    vopts.begy = 8;
+    vopts.begx = 8;
+    vopts.leny = 16;
+    vopts.lenx = 16;
+    auto n = nctiled_blit(nc_, tiled, &vopts);
+    REQUIRE(nullptr != n);
+    CHECK(4 == ts.loads);
+    CHECK(0 == ts.lastlevel);
+    CHECK(16 == ncplane_dim_y(n));
+    CHECK(16 == ncplane_dim_x(n));
+    uint64_t channels;
+    auto c = ncplane_at_yx(n, 0, 0, nullptr, &channels);
+    free(c);
+    CHECK(0xff0000 == ncchannels_bg_rgb(channels));
+    CHECK(0 == ncplane_destroy(n));
+    n = nctiled_blit(nc_, tiled, &vopts);
+    REQUIRE(nullptr != n);
+    CHECK(4 == ts.loads);
+    CHECK(0 == ncplane_destroy(n));
+    // stretched into 8x8 cells, level 1 (32x32) suffices
+    struct ncplane_options nopts{};
+    nopts.rows = 8;
+    nopts.cols = 8;
+    auto parent = ncplane_create(n_, &nopts);
+    REQUIRE(nullptr != parent);
+    vopts.n = parent;
+    vopts.scaling = NCSCALE_STRETCH;
+    vopts.begy = vopts.begx = vopts.leny = vopts.lenx = 0;
+    n = nctiled_blit(nc_, tiled, &vopts);
+    REQUIRE(nullptr != n);
+    CHECK(1 == ts.lastlevel);
+    CHECK(4 + 16 == ts.loads);
+    c = ncplane_at_yx(n, 0, 0, nullptr, &channels);
+    free(c);
+    CHECK(0x00ff00 == ncchannels_bg_rgb(channels));
+    CHECK(0 == notcurses_render(nc_));
+    CHECK(0 == ncplane_destroy(n));
+    CHECK(0 == ncplane_destroy(parent));
+    nctiled_destroy(tiled);
+  }
+
   CHECK(!notcurses_stop(nc_));
 }
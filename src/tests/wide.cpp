@@ -90,7 +90,7 @@ TEST_CASE("Wide") {
       CHECK(0 == testcell.stylemask);
       wchar_t w;
       CHECK(0 < mbtowc(&w, nccell_extended_gcluster(n_, &tcell), MB_CUR_MAX));
-      if(wcwidth(w) == 2){
+      if(notcurses_ucs32_width(w) == 2){
         CHECK(2 == testcell.width);
         ++x;
       }else{
@@ -1042,6 +1042,33 @@ TEST_CASE("Wide") {
     free(egc);
   }
 
+  // widths come from our own table, not the libc's wcwidth()
+  SUBCASE("WidthTable") {
+    CHECK(0 == notcurses_ucs32_width(0));
+    CHECK(-1 == notcurses_ucs32_width('\n'));
+    CHECK(-1 == notcurses_ucs32_width(0x85)); // NEL
+    CHECK(1 == notcurses_ucs32_width('a'));
+    CHECK(0 == notcurses_ucs32_width(0x301)); // COMBINING ACUTE ACCENT
+    CHECK(2 == notcurses_ucs32_width(0x5168));
+    CHECK(2 == notcurses_ucs32_width(0x1f40d)); // SNAKE
+    CHECK(2 == notcurses_ucs32_width(0x1fae8)); // SHAKING FACE (Unicode 15)
+    CHECK(1 == notcurses_ucs32_width(0x1fb38)); // sextant
+    CHECK(-1 == notcurses_ucs32_width(0x110000));
+    int cols;
+    CHECK(4 == utf8_egc_len(SNAKE, &cols));
+    CHECK(2 == cols);
+  }
+
+  // the table can be replaced, e.g. to match a terminal's idea of widths
+  SUBCASE("WidthOverride") {
+    notcurses_set_width_fxn([](uint32_t cp) -> int { return cp == 0x5168 ? 1 : 2; });
+    CHECK(1 == notcurses_ucs32_width(0x5168));
+    CHECK(2 == ncstrwidth("ab", nullptr, nullptr)); // ASCII never consults it
+    CHECK(2 == ncstrwidth(SCORPION, nullptr, nullptr));
+    notcurses_set_width_fxn(nullptr);
+    CHECK(2 == notcurses_ucs32_width(0x5168));
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
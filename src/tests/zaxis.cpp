@@ -250,6 +250,84 @@ TEST_CASE("ZAxis") {
     ncplane_destroy(n);
   }
 
+  // hit-testing follows moves, restacking, resizes, and destruction
+  SUBCASE("PlaneAt") {
+    CHECK(n_ == ncpile_plane_at(n_, 0, 0));
+    ncplane_options nopts{};
+    nopts.y = 1;
+    nopts.x = 1;
+    nopts.rows = 2;
+    nopts.cols = 20;
+    struct ncplane* a = ncplane_create(n_, &nopts);
+    REQUIRE(a);
+    nopts.x = 18;
+    struct ncplane* b = ncplane_create(n_, &nopts);
+    REQUIRE(b);
+    CHECK(n_ == ncpile_plane_at(n_, 0, 0));
+    CHECK(a == ncpile_plane_at(n_, 1, 1));
+    CHECK(b == ncpile_plane_at(n_, 2, 18));
+    CHECK(b == ncpile_plane_at(n_, 2, 20));
+    CHECK(a == ncpile_plane_at(n_, 2, 17));
+    ncplane_move_top(a);
+    CHECK(a == ncpile_plane_at(n_, 2, 18));
+    CHECK(0 == ncplane_move_yx(b, 3, 30));
+    CHECK(b == ncpile_plane_at(n_, 4, 49));
+    CHECK(n_ == ncpile_plane_at(n_, 2, 37));
+    CHECK(0 == ncplane_resize_simple(a, 1, 1));
+    CHECK(n_ == ncpile_plane_at(n_, 2, 18));
+    CHECK(a == ncpile_plane_at(n_, 1, 1));
+    // offscreen points are still found
+    CHECK(0 == ncplane_move_yx(a, -5, -5));
+    CHECK(a == ncpile_plane_at(n_, -5, -5));
+    CHECK(nullptr == ncpile_plane_at(n_, -6, -6));
+    CHECK(0 == ncplane_destroy(b));
+    CHECK(n_ == ncpile_plane_at(n_, 4, 49));
+    CHECK(0 == ncplane_destroy(a));
+  }
+
+  // planes beneath fully solved cells are skipped during paint, but must
+  // show through wherever the plane above doesn't cover them
+  SUBCASE("OccludedRows") {
+    ncplane_options nopts{};
+    nopts.rows = 2;
+    nopts.cols = 4;
+    struct ncplane* a = ncplane_create(n_, &nopts);
+    REQUIRE(a);
+    CHECK(4 == ncplane_putstr_yx(a, 0, 0, "abcd"));
+    CHECK(4 == ncplane_putstr_yx(a, 1, 0, "efgh"));
+    nopts.rows = 1;
+    struct ncplane* b = ncplane_create(n_, &nopts);
+    REQUIRE(b);
+    CHECK(0 < ncplane_set_base(b, " ", 0, 0));
+    CHECK(0 == notcurses_render(nc_));
+    uint16_t stylemask;
+    uint64_t channels;
+    char* egc = notcurses_at_yx(nc_, 0, 0, &stylemask, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, " "));
+    free(egc);
+    egc = notcurses_at_yx(nc_, 1, 0, &stylemask, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "e"));
+    free(egc);
+    CHECK(0 == ncplane_move_yx(b, 1, 2));
+    CHECK(0 == notcurses_render(nc_));
+    egc = notcurses_at_yx(nc_, 0, 0, &stylemask, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "a"));
+    free(egc);
+    egc = notcurses_at_yx(nc_, 1, 1, &stylemask, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, "f"));
+    free(egc);
+    egc = notcurses_at_yx(nc_, 1, 2, &stylemask, &channels);
+    REQUIRE(egc);
+    CHECK(0 == strcmp(egc, " "));
+    free(egc);
+    CHECK(0 == ncplane_destroy(b));
+    CHECK(0 == ncplane_destroy(a));
+  }
+
   CHECK(0 == notcurses_stop(nc_));
 
 }
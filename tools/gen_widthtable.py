@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+# Generate src/lib/widthtable.c, the two-stage codepoint width table used by
+# ncwidth() (see src/lib/width.h). The East Asian Width (W and F, which since
+# Unicode 9 cover default emoji presentation) and zero-width data come from
+# the 'wcwidth' Python package, pinned to a single Unicode version:
+#
+#   pip install wcwidth
+#   python3 tools/gen_widthtable.py 15.0.0 > src/lib/widthtable.c
+#
+# Each codepoint gets two bits: 0, 1, or 2 columns, or 3 for -1 (control
+# characters and line/paragraph separators, as wcwidth(3) would have it).
+# Codepoints are split into blocks of 256; identical blocks are shared.
+import sys
+import unicodedata
+
+from wcwidth.table_wide import WIDE_EASTASIAN
+from wcwidth.table_zero import ZERO_WIDTH
+
+MAXCP = 0x110000
+BLOCK = 256
+
+
+def widths(version):
+    w = bytearray([1]) * MAXCP
+    # the package counts spacing marks (Mc), emoji modifiers (Sk), and the
+    # prepended concatenation marks as zero-width. wcwidth(3) and terminals
+    # generally give them columns, so we do too.
+    prepended = set(range(0x600, 0x606)) | {0x6dd, 0x70f, 0x890, 0x891, 0x8e2, 0x110bd, 0x110cd}
+    for lo, hi in ZERO_WIDTH[version]:
+        for cp in range(lo, hi + 1):
+            if cp not in prepended and unicodedata.category(chr(cp)) not in ("Mc", "Sk"):
+                w[cp] = 0
+    for lo, hi in WIDE_EASTASIAN[version]:
+        for cp in range(lo, hi + 1):
+            w[cp] = 2
+    # those restored above which are nonetheless East Asian Wide
+    for cp in range(MAXCP):
+        if w[cp] == 1 and unicodedata.east_asian_width(chr(cp)) in ("W", "F"):
+            w[cp] = 2
+    # Hangul Jamo medial vowels and final consonants combine with the
+    # preceding initial consonant.
+    for cp in list(range(0x1160, 0x1200)) + list(range(0xd7b0, 0xd800)):
+        w[cp] = 0
+    for cp in list(range(0x01, 0x20)) + list(range(0x7f, 0xa0)) + [0x2028, 0x2029]:
+        w[cp] = 3
+    w[0] = 0
+    return w
+
+
+def main():
+    if len(sys.argv) != 2 or sys.argv[1] not in WIDE_EASTASIAN:
+        print("usage: %s unicode-version" % sys.argv[0], file=sys.stderr)
+        return 1
+    version = sys.argv[1]
+    w = widths(version)
+    blocks = []
+    index = {}
+    stage1 = []
+    for b in range(MAXCP // BLOCK):
+        packed = bytearray(BLOCK // 4)
+        for i in range(BLOCK):
+            packed[i // 4] |= w[b * BLOCK + i] << ((i % 4) * 2)
+        packed = bytes(packed)
+        if packed not in index:
+            index[packed] = len(blocks)
+            blocks.append(packed)
+        stage1.append(index[packed])
+    if len(blocks) > 256:
+        print("too many distinct blocks (%d)" % len(blocks), file=sys.stderr)
+        return 1
+    out = sys.stdout
+    out.write("// generated by tools/gen_widthtable.py from Unicode %s; do not edit\n" % version)
+    out.write('#include "width.h"\n\n')
+    out.write("const uint8_t ncwidth_stage1[NCWIDTH_STAGE1] = {\n")
+    for i in range(0, len(stage1), 16):
+        out.write("  " + " ".join("%d," % s for s in stage1[i:i + 16]) + "\n")
+    out.write("};\n\n")
+    out.write("const uint8_t ncwidth_stage2[][NCWIDTH_BLOCK / 4] = {\n")
+    for blk in blocks:
+        out.write("  {\n")
+        for i in range(0, len(blk), 16):
+            out.write("    " + " ".join("0x%02x," % c for c in blk[i:i + 16]) + "\n")
+        out.write("  },\n")
+    out.write("};\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())